@@ -6,13 +6,98 @@
  */
 
 #include "eden/fs/benchharness/Bench.h"
+#include <folly/Conv.h>
+#include <folly/json.h>
+#include <folly/synchronization/test/Barrier.h>
 #include <inttypes.h>
 #include <stdio.h>
 #include <time.h>
+#include <cmath>
+#include <mutex>
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 namespace facebook {
 namespace eden {
 
+namespace {
+
+void pinToCpu(size_t cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  // Best effort: the CPU may be excluded by the process's affinity mask.
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)cpu;
+#endif
+}
+
+ScalingResult runOnThreads(
+    size_t threadCount,
+    uint64_t iterations,
+    folly::FunctionRef<void(size_t)> operation) {
+  auto cpus = std::max(std::thread::hardware_concurrency(), 1u);
+  folly::test::Barrier gate{threadCount + 1};
+  std::mutex resultMutex;
+  StatAccumulator latency;
+
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads.emplace_back([&, i] {
+      pinToCpu(i % cpus);
+      StatAccumulator accum;
+      gate.wait();
+      for (uint64_t j = 0; j < iterations; ++j) {
+        auto start = getTime();
+        operation(i);
+        accum.add(getTime() - start);
+      }
+      std::lock_guard guard{resultMutex};
+      latency.combine(accum);
+    });
+  }
+
+  auto start = getTime();
+  gate.wait();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return ScalingResult{threadCount, getTime() - start, latency};
+}
+
+} // namespace
+
+uint64_t StatAccumulator::getPercentile(double p) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  auto rank = static_cast<uint64_t>(std::ceil(p * count_));
+  rank = std::clamp<uint64_t>(rank, 1, count_);
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < kBucketCount; ++bucket) {
+    seen += buckets_[bucket];
+    if (seen < rank) {
+      continue;
+    }
+    if (bucket < 2 * kSubBuckets) {
+      return bucket;
+    }
+    // Report the middle of the bucket, which bounds the error to half of its
+    // width.
+    size_t shift = bucket / kSubBuckets - 1;
+    uint64_t lower = (kSubBuckets + bucket % kSubBuckets) << shift;
+    uint64_t middle = lower + ((uint64_t{1} << shift) >> 1);
+    return std::clamp(middle, minimum_, maximum_);
+  }
+  return maximum_;
+}
+
 uint64_t getTime() noexcept {
   timespec ts;
   // CLOCK_MONOTONIC is subject in NTP adjustments. CLOCK_MONOTONIC_RAW would be
@@ -38,5 +123,66 @@ StatAccumulator measureClockOverhead() noexcept {
   return accum;
 }
 
+std::vector<ScalingResult> runScalingSweep(
+    size_t maxThreads,
+    uint64_t iterations,
+    folly::FunctionRef<void(size_t)> operation) {
+  std::vector<ScalingResult> results;
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    results.push_back(runOnThreads(threads, iterations, operation));
+  }
+  if (results.empty() || results.back().threads != maxThreads) {
+    results.push_back(runOnThreads(maxThreads, iterations, operation));
+  }
+  return results;
+}
+
+void printScalingTable(const std::vector<ScalingResult>& results) {
+  if (results.empty()) {
+    return;
+  }
+  auto singleThreadThroughput = results.front().getThroughput();
+  printf(
+      "%8s %14s %10s %10s %10s %10s %10s\n",
+      "threads",
+      "ops/s",
+      "efficiency",
+      "p50 ns",
+      "p99 ns",
+      "p99.9 ns",
+      "max ns");
+  for (const auto& result : results) {
+    auto efficiency = singleThreadThroughput
+        ? result.getThroughput() / (singleThreadThroughput * result.threads)
+        : 0;
+    printf(
+        "%8zu %14.0f %9.0f%% %10" PRIu64 " %10" PRIu64 " %10" PRIu64
+        " %10" PRIu64 "\n",
+        result.threads,
+        result.getThroughput(),
+        efficiency * 100,
+        result.latency.getPercentile(0.5),
+        result.latency.getPercentile(0.99),
+        result.latency.getPercentile(0.999),
+        result.latency.getMaximum());
+  }
+}
+
+std::string scalingResultsToJson(
+    folly::StringPiece name,
+    const std::vector<ScalingResult>& results) {
+  auto byThreads = folly::dynamic::object;
+  for (const auto& result : results) {
+    byThreads[folly::to<std::string>(result.threads)] = folly::dynamic::object(
+        "ops_per_second", result.getThroughput())(
+        "p50_ns", result.latency.getPercentile(0.5))(
+        "p99_ns", result.latency.getPercentile(0.99))(
+        "p999_ns", result.latency.getPercentile(0.999))(
+        "max_ns", result.latency.getMaximum());
+  }
+  return folly::toPrettyJson(
+      folly::dynamic::object("name", name)("threads", std::move(byThreads)));
+}
+
 } // namespace eden
 } // namespace facebook
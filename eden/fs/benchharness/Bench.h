@@ -8,15 +8,26 @@
 #pragma once
 
 #include <benchmark/benchmark.h>
+#include <folly/Function.h>
+#include <folly/Range.h>
 #include <folly/init/Init.h>
+#include <folly/lang/Bits.h>
 #include <stdint.h>
 #include <algorithm>
+#include <array>
 #include <limits>
+#include <string>
+#include <vector>
 
 namespace facebook::eden {
 
 /**
- * Accumulates data points, tracking their average and minimum.
+ * Accumulates data points, tracking their minimum, average, maximum and a
+ * histogram from which percentiles can be read.
+ *
+ * The histogram has 16 linear buckets per power of two, so values below 32
+ * are exact and percentiles of larger values are within about 3% of the
+ * true value.
  *
  * This type is a monoid.
  */
@@ -24,28 +35,63 @@ class StatAccumulator {
  public:
   void add(uint64_t value) {
     minimum_ = std::min(minimum_, value);
+    maximum_ = std::max(maximum_, value);
     total_ += value;
     ++count_;
+    ++buckets_[getBucket(value)];
   }
 
-  void combine(StatAccumulator other) {
+  void combine(const StatAccumulator& other) {
     minimum_ = std::min(minimum_, other.minimum_);
+    maximum_ = std::max(maximum_, other.maximum_);
     total_ += other.total_;
     count_ += other.count_;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+      buckets_[i] += other.buckets_[i];
+    }
+  }
+
+  uint64_t getCount() const {
+    return count_;
   }
 
   uint64_t getMinimum() const {
     return minimum_;
   }
 
+  uint64_t getMaximum() const {
+    return maximum_;
+  }
+
   uint64_t getAverage() const {
     return count_ ? total_ / count_ : 0;
   }
 
+  /**
+   * Returns the value below which a fraction `p` of the data points fall,
+   * e.g. 0.99 for p99. Returns 0 if there are no data points.
+   */
+  uint64_t getPercentile(double p) const;
+
  private:
+  static constexpr size_t kSubBucketBits = 4;
+  static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+  static constexpr size_t kBucketCount = (65 - kSubBucketBits) * kSubBuckets;
+
+  static size_t getBucket(uint64_t value) {
+    if (value < 2 * kSubBuckets) {
+      return value;
+    }
+    size_t exponent = folly::findLastSet(value) - 1;
+    size_t shift = exponent - kSubBucketBits;
+    return (shift + 1) * kSubBuckets + ((value >> shift) - kSubBuckets);
+  }
+
   uint64_t minimum_{std::numeric_limits<uint64_t>::max()};
+  uint64_t maximum_{0};
   uint64_t total_{0};
   uint64_t count_{0};
+  std::array<uint64_t, kBucketCount> buckets_{};
 };
 
 /**
@@ -62,6 +108,49 @@ uint64_t getTime() noexcept;
  */
 StatAccumulator measureClockOverhead() noexcept;
 
+/**
+ * The result of running a benchmark body on a given number of threads.
+ */
+struct ScalingResult {
+  size_t threads;
+  uint64_t elapsedNs;
+  /** The latency of every operation, from all threads. */
+  StatAccumulator latency;
+
+  double getThroughput() const {
+    return elapsedNs ? latency.getCount() * 1e9 / elapsedNs : 0;
+  }
+};
+
+/**
+ * Runs `operation` `iterations` times on each of 1, 2, 4, ... threads up to
+ * `maxThreads`, and on maxThreads itself if it is not a power of two. Thread
+ * i is pinned to CPU i modulo the number of CPUs where the platform allows,
+ * and all threads start together.
+ *
+ * `operation` is given the index of the thread running it, and is timed
+ * individually, so operations much faster than the clock overhead reported
+ * by measureClockOverhead() should be batched.
+ */
+std::vector<ScalingResult> runScalingSweep(
+    size_t maxThreads,
+    uint64_t iterations,
+    folly::FunctionRef<void(size_t)> operation);
+
+/**
+ * Prints one line per thread count with the throughput, the scaling
+ * efficiency relative to a single thread, and the latency percentiles.
+ */
+void printScalingTable(const std::vector<ScalingResult>& results);
+
+/**
+ * Returns the results as a JSON object keyed by thread count, suitable for
+ * tracking regressions across runs.
+ */
+std::string scalingResultsToJson(
+    folly::StringPiece name,
+    const std::vector<ScalingResult>& results);
+
 } // namespace facebook::eden
 
 #define EDEN_BENCHMARK_MAIN()                                 \
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/TreeCache.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kBlobCount = 100000;
+
+/**
+ * An ObjectStore whose metadata cache holds the metadata of kBlobCount
+ * blobs, so that lookups measure the in-memory cache alone.
+ */
+struct WarmObjectStore {
+  explicit WarmObjectStore(size_t shardCount) {
+    std::shared_ptr<EdenConfig> config{EdenConfig::createTestEdenConfig()};
+    config->blobMetadataCacheShards.setValue(
+        shardCount, ConfigSource::Default, true);
+    auto backingStore = std::make_shared<FakeBackingStore>();
+    objectStore = ObjectStore::create(
+        std::make_shared<MemoryLocalStore>(),
+        backingStore,
+        TreeCache::create(std::make_shared<ReloadableConfig>(
+            config, ConfigReloadBehavior::NoReload)),
+        std::make_shared<EdenStats>(),
+        &folly::QueuedImmediateExecutor::instance(),
+        std::make_shared<ProcessNameCache>(),
+        std::make_shared<NullStructuredLogger>(),
+        config);
+
+    for (size_t i = 0; i < kBlobCount; ++i) {
+      auto* blob = backingStore->putBlob(fmt::format("blob {}", i));
+      blob->setReady();
+      ids.push_back(blob->get().getHash());
+      auto& context = ObjectFetchContext::getNullContext();
+      objectStore->getBlobSize(ids.back(), context).get();
+    }
+  }
+
+  std::shared_ptr<ObjectStore> objectStore;
+  std::vector<ObjectId> ids;
+};
+
+/**
+ * The stores are shared by all the threads of a benchmark run, and built
+ * before the timed loop by the first thread to get there.
+ */
+WarmObjectStore& getWarmObjectStore(size_t shardCount) {
+  static std::mutex mutex;
+  static std::map<size_t, std::unique_ptr<WarmObjectStore>> stores;
+  std::lock_guard<std::mutex> lock{mutex};
+  auto& store = stores[shardCount];
+  if (!store) {
+    store = std::make_unique<WarmObjectStore>(shardCount);
+  }
+  return *store;
+}
+
+/**
+ * Looks up the size of blobs from many threads, as stat of files that are
+ * not materialized does, with the metadata cache split into state.range(0)
+ * shards.
+ */
+void get_blob_size(benchmark::State& state) {
+  auto& store = getWarmObjectStore(state.range(0));
+  auto& context = ObjectFetchContext::getNullContext();
+
+  // Walk the blobs with a stride coprime to their count, from a different
+  // starting point on each thread, so that threads rarely hit the same entry
+  // at the same time.
+  static std::atomic<size_t> nextStart{0};
+  size_t index = nextStart.fetch_add(7919) % kBlobCount;
+  for (auto _ : state) {
+    auto size = store.objectStore->getBlobSize(store.ids[index], context).get();
+    benchmark::DoNotOptimize(size);
+    index = (index + 104729) % kBlobCount;
+  }
+}
+
+BENCHMARK(get_blob_size)
+    ->ArgName("shards")
+    ->Arg(1)
+    ->Arg(16)
+    ->Threads(1)
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8)
+    ->Threads(16)
+    ->Threads(32);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
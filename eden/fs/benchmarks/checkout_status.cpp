@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <sys/resource.h>
+#include <array>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/store/Diff.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/SyntheticRepo.h"
+#include "eden/fs/testharness/TestMount.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+/**
+ * Around 9000 files of 4 KB median size spread over 585 directories.
+ */
+SyntheticRepo::Options repoOptions() {
+  SyntheticRepo::Options options;
+  options.depth = 3;
+  options.fanout = 8;
+  options.filesPerDirectory = 16;
+  return options;
+}
+
+/**
+ * Records the peak resident set size of the process. It only ever grows, so
+ * it is the high-water mark of the largest benchmark run so far.
+ */
+void recordPeakMemory(benchmark::State& state) {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  auto bytes = static_cast<double>(usage.ru_maxrss);
+#else
+  auto bytes = static_cast<double>(usage.ru_maxrss) * 1024;
+#endif
+  state.counters["peak_rss_mb"] = bytes / (1024 * 1024);
+}
+
+/**
+ * Adds a child commit of the mounted commit in which `modified` files
+ * differ, and returns its id.
+ */
+RootId addModifiedCommit(
+    SyntheticRepo& repo,
+    TestMount& mount,
+    size_t modified) {
+  auto builder = repo.makeModifiedCommit(modified);
+  builder.finalize(mount.getBackingStore(), true);
+  RootId commit{"2"};
+  mount.getBackingStore()->putCommit(commit, builder)->setReady();
+  return commit;
+}
+
+/**
+ * Checks out back and forth between two commits that differ in
+ * state.range(0) files.
+ */
+void checkout(benchmark::State& state) {
+  SyntheticRepo repo{repoOptions()};
+  TestMount mount{repo.getBuilder()};
+  auto executor = mount.getServerExecutor().get();
+  auto commits = std::array<RootId, 2>{
+      mount.getEdenMount()->getParentCommit(),
+      addModifiedCommit(repo, mount, state.range(0))};
+
+  size_t next = 1;
+  for (auto _ : state) {
+    auto result = mount.getEdenMount()
+                      ->checkout(commits[next], std::nullopt, __func__)
+                      .waitVia(executor)
+                      .get();
+    benchmark::DoNotOptimize(result);
+    next = 1 - next;
+  }
+  recordPeakMemory(state);
+}
+
+/**
+ * Computes the status of a working copy with state.range(0) modified files
+ * and state.range(1) percent of its files materialized without changes.
+ */
+void status(benchmark::State& state) {
+  SyntheticRepo repo{repoOptions()};
+  TestMount mount{repo.getBuilder()};
+  auto executor = mount.getServerExecutor().get();
+  repo.materializeFiles(mount, repo.getFiles().size() * state.range(1) / 100);
+  repo.modifyFiles(mount, state.range(0));
+  auto commit = mount.getEdenMount()->getParentCommit();
+
+  for (auto _ : state) {
+    auto result = mount.getEdenMount()->diff(commit).waitVia(executor).get();
+    benchmark::DoNotOptimize(result);
+  }
+  recordPeakMemory(state);
+}
+
+/**
+ * Diffs two commits that differ in state.range(0) files, as
+ * getScmStatusBetweenRevisions does. The trees are cached by the ObjectStore
+ * after the first iteration, so this measures the diff itself rather than
+ * the fetching of the trees.
+ */
+void status_between_revisions(benchmark::State& state) {
+  SyntheticRepo repo{repoOptions()};
+  TestMount mount{repo.getBuilder()};
+  auto executor = mount.getServerExecutor().get();
+  auto parent = mount.getEdenMount()->getParentCommit();
+  auto child = addModifiedCommit(repo, mount, state.range(0));
+  auto* objectStore = mount.getEdenMount()->getObjectStore();
+
+  for (auto _ : state) {
+    auto result = diffCommitsForStatus(objectStore, parent, child)
+                      .waitVia(executor)
+                      .get();
+    benchmark::DoNotOptimize(result);
+  }
+  recordPeakMemory(state);
+}
+
+BENCHMARK(checkout)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000);
+
+BENCHMARK(status)
+    ->Unit(benchmark::kMillisecond)
+    ->Args({10, 0})
+    ->Args({1000, 0})
+    ->Args({10, 10})
+    ->Args({10, 50});
+
+BENCHMARK(status_between_revisions)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <fmt/core.h>
+#include <folly/Conv.h>
+#include <folly/String.h>
+#include <folly/init/Init.h>
+#include <folly/synchronization/test/Barrier.h>
+#include <gflags/gflags.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "eden/fs/benchharness/Bench.h"
+
+DEFINE_string(
+    trace,
+    "",
+    "Trace to replay, as written by `eden trace fs --replay-output`");
+DEFINE_string(root, "", "Checkout the trace's paths are relative to");
+DEFINE_uint64(iterations, 1, "Number of times each stream replays its trace");
+
+using namespace facebook::eden;
+
+namespace {
+
+/**
+ * A trace is a text file with one "<stream> <operation> <path>" line per
+ * filesystem request, where path is relative to the checkout and "." is its
+ * root. Each stream, the requesting pid in captured traces, is replayed by its
+ * own thread, in order, and all streams run concurrently, which approximates
+ * the concurrency of the traced workload.
+ *
+ * The operations are:
+ *   stat     lstat
+ *   read     open, read the whole file, close
+ *   readdir  opendir, read every entry, closedir
+ *   readlink readlink
+ */
+enum class Operation { Stat, Read, Readdir, Readlink, kCount };
+
+constexpr std::array<folly::StringPiece, size_t(Operation::kCount)>
+    kOperationNames{"stat", "read", "readdir", "readlink"};
+
+struct Request {
+  Operation operation;
+  std::string path;
+};
+
+std::map<std::string, std::vector<Request>> loadTrace(
+    const std::string& tracePath) {
+  std::ifstream trace{tracePath};
+  if (!trace) {
+    throw std::runtime_error(fmt::format("unable to open {}", tracePath));
+  }
+
+  std::map<std::string, std::vector<Request>> streams;
+  std::string line;
+  size_t lineNumber = 0;
+  while (std::getline(trace, line)) {
+    ++lineNumber;
+    if (line.empty()) {
+      continue;
+    }
+    std::vector<folly::StringPiece> fields;
+    folly::split(' ', line, fields);
+    if (fields.size() < 3) {
+      throw std::runtime_error(
+          fmt::format("{}:{}: malformed line", tracePath, lineNumber));
+    }
+    auto name = std::find(
+        kOperationNames.begin(), kOperationNames.end(), fields[1]);
+    if (name == kOperationNames.end()) {
+      throw std::runtime_error(fmt::format(
+          "{}:{}: unknown operation {}", tracePath, lineNumber, fields[1]));
+    }
+    // Paths may contain spaces.
+    auto pathStart = fields[2].begin() - line.data();
+    streams[fields[0].str()].push_back(Request{
+        Operation(name - kOperationNames.begin()), line.substr(pathStart)});
+  }
+  return streams;
+}
+
+/**
+ * Returns false if the request failed, which is expected when the checkout
+ * is not at the traced commit.
+ */
+bool replay(const Request& request, const std::string& root) {
+  auto path = request.path == "." ? root : root + "/" + request.path;
+  switch (request.operation) {
+    case Operation::Stat: {
+      struct stat st;
+      return ::lstat(path.c_str(), &st) == 0;
+    }
+    case Operation::Read: {
+      int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd == -1) {
+        return false;
+      }
+      std::array<char, 64 * 1024> buffer;
+      ssize_t result;
+      while ((result = ::read(fd, buffer.data(), buffer.size())) > 0) {
+      }
+      ::close(fd);
+      return result == 0;
+    }
+    case Operation::Readdir: {
+      DIR* dir = ::opendir(path.c_str());
+      if (!dir) {
+        return false;
+      }
+      while (::readdir(dir)) {
+      }
+      ::closedir(dir);
+      return true;
+    }
+    case Operation::Readlink: {
+      std::array<char, 4096> buffer;
+      return ::readlink(path.c_str(), buffer.data(), buffer.size()) != -1;
+    }
+    case Operation::kCount:
+      break;
+  }
+  return false;
+}
+
+struct StreamResult {
+  // Nanoseconds, indexed by Operation.
+  std::array<std::vector<uint64_t>, size_t(Operation::kCount)> latencies;
+  size_t failures = 0;
+};
+
+void printLatencies(folly::StringPiece name, std::vector<uint64_t>& latencies) {
+  if (latencies.empty()) {
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    auto index = static_cast<size_t>(p * (latencies.size() - 1));
+    return double(latencies[index]) / 1000.0;
+  };
+  fmt::print(
+      "{:>8} {:>10} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}\n",
+      name,
+      latencies.size(),
+      percentile(0.5),
+      percentile(0.9),
+      percentile(0.99),
+      percentile(0.999),
+      double(latencies.back()) / 1000.0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+
+  if (FLAGS_trace.empty() || FLAGS_root.empty()) {
+    fprintf(stderr, "Both --trace and --root must be specified.\n");
+    return 1;
+  }
+
+  auto streams = loadTrace(FLAGS_trace);
+  if (streams.empty()) {
+    fprintf(stderr, "The trace is empty.\n");
+    return 1;
+  }
+
+  folly::test::Barrier gate{streams.size() + 1};
+  std::vector<StreamResult> results(streams.size());
+  std::vector<std::thread> threads;
+  threads.reserve(streams.size());
+  size_t index = 0;
+  for (const auto& [stream, requests] : streams) {
+    threads.emplace_back([&, &requests = requests, &result = results[index]] {
+      gate.wait();
+      for (uint64_t i = 0; i < FLAGS_iterations; ++i) {
+        for (const auto& request : requests) {
+          auto start = getTime();
+          if (!replay(request, FLAGS_root)) {
+            ++result.failures;
+          }
+          result.latencies[size_t(request.operation)].push_back(
+              getTime() - start);
+        }
+      }
+    });
+    ++index;
+  }
+
+  auto start = getTime();
+  gate.wait();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto elapsed = getTime() - start;
+
+  std::array<std::vector<uint64_t>, size_t(Operation::kCount)> latencies;
+  std::vector<uint64_t> all;
+  size_t failures = 0;
+  for (auto& result : results) {
+    for (size_t op = 0; op < latencies.size(); ++op) {
+      auto& from = result.latencies[op];
+      latencies[op].insert(latencies[op].end(), from.begin(), from.end());
+      all.insert(all.end(), from.begin(), from.end());
+    }
+    failures += result.failures;
+  }
+
+  fmt::print(
+      "Replayed {} requests from {} streams in {:.3f} s: {:.0f} requests/s, "
+      "{} failed\n",
+      all.size(),
+      streams.size(),
+      double(elapsed) / 1e9,
+      all.size() / (double(elapsed) / 1e9),
+      failures);
+  fmt::print(
+      "{:>8} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+      "",
+      "count",
+      "p50 us",
+      "p90 us",
+      "p99 us",
+      "p99.9 us",
+      "max us");
+  for (size_t op = 0; op < latencies.size(); ++op) {
+    printLatencies(kOperationNames[op], latencies[op]);
+  }
+  printLatencies("all", all);
+  return 0;
+}
@@ -5,8 +5,11 @@
  * GNU General Public License version 2.
  */
 
+#include <folly/synchronization/Baton.h>
+#include <atomic>
 #include "eden/fs/benchharness/Bench.h"
 #include "eden/fs/utils/ImmediateFuture.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 namespace {
 
@@ -44,9 +47,53 @@ void folly_future(benchmark::State& state) {
   state.SetItemsProcessed(std::move(fut).get());
 }
 
+/**
+ * Fans out like a diff of a wide tree: one task queues state.range(0) tasks,
+ * which each queue state.range(0) trivial continuations, all from the worker
+ * threads.
+ */
+void executor_fan_out(
+    benchmark::State& state,
+    UnboundedQueueExecutor::Scheduling scheduling) {
+  UnboundedQueueExecutor executor{8, "BenchThread", scheduling};
+  const auto fanOut = static_cast<size_t>(state.range(0));
+  const auto leaves = fanOut * fanOut;
+
+  for (auto _ : state) {
+    std::atomic<size_t> remaining{leaves};
+    folly::Baton<> done;
+    auto leaf = [&] {
+      if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        done.post();
+      }
+    };
+    executor.add([&] {
+      for (size_t i = 0; i < fanOut; ++i) {
+        executor.add([&] {
+          for (size_t j = 0; j < fanOut; ++j) {
+            executor.add(leaf);
+          }
+        });
+      }
+    });
+    done.wait();
+  }
+  state.SetItemsProcessed(state.iterations() * leaves);
+}
+
+void shared_queue_fan_out(benchmark::State& state) {
+  executor_fan_out(state, UnboundedQueueExecutor::Scheduling::SharedQueue);
+}
+
+void work_stealing_fan_out(benchmark::State& state) {
+  executor_fan_out(state, UnboundedQueueExecutor::Scheduling::WorkStealing);
+}
+
 BENCHMARK(immediate_future);
 BENCHMARK(immediate_future_exc);
 BENCHMARK(folly_future);
+BENCHMARK(shared_queue_fan_out)->Arg(16)->Arg(256)->UseRealTime();
+BENCHMARK(work_stealing_fan_out)->Arg(16)->Arg(256)->UseRealTime();
 } // namespace
 
 EDEN_BENCHMARK_MAIN();
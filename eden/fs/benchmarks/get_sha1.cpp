@@ -34,6 +34,11 @@ using namespace boost::filesystem;
 
 DEFINE_int64(threads, 1, "The number of concurrent Thrift client threads");
 DEFINE_string(repo, "", "Path to Eden repository");
+DEFINE_int64(
+    batch_size,
+    1,
+    "The number of files requested by each getSHA1 call, as build tools do. "
+    "Only applies to the thrift interface.");
 DEFINE_string(
     interface,
     "",
@@ -51,11 +56,11 @@ bool shouldRecordFilesystemSamples(std::string& interface) {
 }
 
 /**
- * Record a sample in `samples` of how long it takes to read a file's sha1 from
- * EdenFS's thrift interface.
+ * Record a sample in `samples` of how long it takes to read the sha1s of a
+ * batch of files from EdenFS's thrift interface.
  */
 void recordThriftSample(
-    std::string& file,
+    const std::vector<std::string>& files,
     boost::filesystem::path& repo_path,
     std::unique_ptr<EdenServiceAsyncClient>& client,
     uint64_t& sample) {
@@ -63,19 +68,20 @@ void recordThriftSample(
   std::vector<SHA1Result> res;
   // see notes in recordFilesystemSample about these DoNotOptimize protecting
   // ordering here
-  benchmark::DoNotOptimize(file);
-  client->sync_getSHA1(res, repo_path.native(), {file});
+  benchmark::DoNotOptimize(files);
+  client->sync_getSHA1(res, repo_path.native(), files);
   benchmark::DoNotOptimize(res);
   auto duration = std::chrono::nanoseconds(getTime() - start);
   sample =
       std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
 
-  if (UNLIKELY(res.empty())) {
-    throw std::runtime_error("No results!");
+  if (UNLIKELY(res.size() != files.size())) {
+    throw std::runtime_error("Wrong number of results!");
   }
-  if (UNLIKELY(
-          res.size() != 1 || res.at(0).getType() == SHA1Result::Type::error)) {
-    throw res.at(0).get_error();
+  for (const auto& result : res) {
+    if (UNLIKELY(result.getType() == SHA1Result::Type::error)) {
+      throw result.get_error();
+    }
   }
 }
 
@@ -139,6 +145,10 @@ void calculateStats(
 int main(int argc, char** argv) {
   folly::init(&argc, &argv);
 
+  if (FLAGS_batch_size < 1) {
+    std::cerr << "The batch size must be at least 1" << std::endl;
+    return 1;
+  }
   if (!FLAGS_threads) {
     std::cerr << "Must specify nonzero number of threads" << std::endl;
     gflags::ShowUsageWithFlags(argv[0]);
@@ -239,11 +249,13 @@ int main(int argc, char** argv) {
         auto files_index = j * thread_number % thrift_files.size();
         auto samples_index = thread_number * samples_per_thread + j;
         if (shouldRecordThriftSamples(interface)) {
+          std::vector<std::string> batch;
+          for (int64_t k = 0; k < FLAGS_batch_size; ++k) {
+            batch.push_back(
+                thrift_files[(files_index + k) % thrift_files.size()]);
+          }
           recordThriftSample(
-              thrift_files[files_index],
-              repo_path,
-              client,
-              thrift_samples[samples_index]);
+              batch, repo_path, client, thrift_samples[samples_index]);
         }
 
         if (shouldRecordFilesystemSamples(interface)) {
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Random.h>
+#include <folly/String.h>
+#include <string>
+#include <vector>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/model/Hash.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+/**
+ * Hashes are rendered and parsed in batches, e.g. for the entries of a tree
+ * or the results of a Thrift call, so measure a batch of them.
+ */
+constexpr size_t kBatchSize = 1024;
+
+std::vector<Hash20> makeHashes() {
+  std::vector<Hash20> hashes;
+  hashes.reserve(kBatchSize);
+  for (size_t i = 0; i < kBatchSize; ++i) {
+    Hash20 hash;
+    folly::Random::secureRandom(
+        hash.mutableBytes().data(), hash.mutableBytes().size());
+    hashes.push_back(hash);
+  }
+  return hashes;
+}
+
+std::vector<std::string> makeHexes() {
+  auto hashes = makeHashes();
+  return toHexStrings(HashRange{hashes.data(), hashes.size()});
+}
+
+void hash_to_string_hexlify(benchmark::State& state) {
+  auto hashes = makeHashes();
+  for (auto _ : state) {
+    for (const auto& hash : hashes) {
+      std::string hex;
+      folly::hexlify(hash.getBytes(), hex);
+      benchmark::DoNotOptimize(hex);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(hash_to_string_hexlify);
+
+void hash_to_string(benchmark::State& state) {
+  auto hashes = makeHashes();
+  for (auto _ : state) {
+    for (const auto& hash : hashes) {
+      benchmark::DoNotOptimize(hash.toString());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(hash_to_string);
+
+void hash_to_hex_strings(benchmark::State& state) {
+  auto hashes = makeHashes();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        toHexStrings(HashRange{hashes.data(), hashes.size()}));
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(hash_to_hex_strings);
+
+void hash_from_hex_unhexlify(benchmark::State& state) {
+  auto hexes = makeHexes();
+  for (auto _ : state) {
+    for (const auto& hex : hexes) {
+      std::string bytes;
+      folly::unhexlify(hex, bytes);
+      auto range = folly::ByteRange{folly::StringPiece{bytes}};
+      benchmark::DoNotOptimize(Hash20{range});
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(hash_from_hex_unhexlify);
+
+void hash_from_hex(benchmark::State& state) {
+  auto hexes = makeHexes();
+  for (auto _ : state) {
+    for (const auto& hex : hexes) {
+      benchmark::DoNotOptimize(Hash20{hex});
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(hash_from_hex);
+
+void object_id_from_hex(benchmark::State& state) {
+  auto hexes = makeHexes();
+  for (auto _ : state) {
+    for (const auto& hex : hexes) {
+      benchmark::DoNotOptimize(ObjectId::fromHex(hex));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(object_id_from_hex);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/inodes/InodeMap.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+std::unique_ptr<TestMount> mount;
+InodeNumber hotInode;
+
+/**
+ * Looks up the same loaded inode from every thread and drops the reference
+ * right away, as FUSE requests on a hot inode do. Each drop to zero goes
+ * through InodeMap::onInodeUnreferenced(), which must not stall the lookups
+ * of the other threads.
+ */
+void lookup_loaded_inode(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    FakeTreeBuilder builder;
+    builder.setFile("dir/file.txt", "contents\n");
+    mount = std::make_unique<TestMount>(builder);
+    hotInode = mount->getFileInode("dir/file.txt")->getNodeId();
+  }
+
+  for (auto _ : state) {
+    auto* inodeMap = mount->getEdenMount()->getInodeMap();
+    benchmark::DoNotOptimize(inodeMap->lookupLoadedInode(hotInode));
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    mount.reset();
+  }
+}
+
+BENCHMARK(lookup_loaded_inode)
+    ->Threads(1)
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8)
+    ->Threads(16)
+    ->UseRealTime();
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Conv.h>
+#include <atomic>
+#include <vector>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/journal/Journal.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+std::unique_ptr<Journal> journal;
+
+/**
+ * Makes count paths below a directory of thread's own, so that the threads of
+ * a benchmark don't compact each other's changes.
+ */
+std::vector<RelativePath> makePaths(size_t count, int thread) {
+  std::vector<RelativePath> paths;
+  paths.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    paths.emplace_back(
+        folly::to<std::string>("dir", thread, "/sub", i % 16, "/file", i));
+  }
+  return paths;
+}
+
+void resetJournal() {
+  journal = std::make_unique<Journal>(std::make_shared<EdenStats>());
+}
+
+void reportDeltasPerRecord(benchmark::State& state) {
+  auto stats = journal->getStats();
+  auto records = static_cast<double>(state.iterations()) * state.threads();
+  state.counters["deltas_per_record"] =
+      stats && records ? stats->entryCount / records : 0;
+}
+
+/**
+ * Each thread records changes to state.range(0) paths in turn. Consecutive
+ * changes to the same path are compacted into a single delta, so with one
+ * path per thread the journal barely grows, while with many paths every
+ * change is a delta. deltas_per_record reports how well compaction did.
+ */
+void record_changed(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    resetJournal();
+  }
+  auto paths = makePaths(state.range(0), state.thread_index());
+
+  size_t i = 0;
+  for (auto _ : state) {
+    journal->recordChanged(paths[i++ % paths.size()]);
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    reportDeltasPerRecord(state);
+    journal.reset();
+  }
+}
+
+BENCHMARK(record_changed)
+    ->Arg(1)
+    ->Arg(1024)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(8)
+    ->UseRealTime();
+
+/**
+ * Each thread creates new files, which are never compacted.
+ */
+void record_created(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    resetJournal();
+  }
+  auto paths = makePaths(4096, state.thread_index());
+
+  size_t i = 0;
+  for (auto _ : state) {
+    journal->recordCreated(paths[i++ % paths.size()]);
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    reportDeltasPerRecord(state);
+    journal.reset();
+  }
+}
+
+BENCHMARK(record_created)->Threads(1)->Threads(4)->Threads(8)->UseRealTime();
+
+/**
+ * Sums the last state.range(1) percent of a history of state.range(0)
+ * changes to distinct paths, as a watchman query since a recent clock does
+ * when the range is small and a fresh query does when it is 100.
+ */
+void accumulate_range(benchmark::State& state) {
+  resetJournal();
+  auto historySize = static_cast<size_t>(state.range(0));
+  auto paths = makePaths(historySize, 0);
+  for (const auto& path : paths) {
+    journal->recordChanged(path);
+  }
+  auto latest = journal->getLatestSequenceNumber();
+  auto limit = latest - historySize * state.range(1) / 100 + 1;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(journal->accumulateRange(limit));
+  }
+  state.SetItemsProcessed(state.iterations() * (latest - limit + 1));
+  journal.reset();
+}
+
+BENCHMARK(accumulate_range)
+    ->Args({1000, 1})
+    ->Args({1000, 100})
+    ->Args({100000, 1})
+    ->Args({100000, 100})
+    ->Args({1000000, 1})
+    ->Args({1000000, 100})
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * Records a change that state.range(0) subscribers are notified of, then
+ * observes it, as a watchman subscription does, so that the next change
+ * notifies them again.
+ */
+void notify_subscribers(benchmark::State& state) {
+  resetJournal();
+  std::atomic<size_t> notifications{0};
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    journal->registerSubscriber(
+        [&] { notifications.fetch_add(1, std::memory_order_relaxed); });
+  }
+  auto paths = makePaths(1024, 0);
+
+  size_t i = 0;
+  for (auto _ : state) {
+    journal->recordChanged(paths[i++ % paths.size()]);
+    benchmark::DoNotOptimize(journal->getLatest());
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["notifications"] = notifications.load();
+
+  journal->cancelAllSubscribers();
+  journal.reset();
+}
+
+BENCHMARK(notify_subscribers)->Arg(0)->Arg(1)->Arg(16)->Arg(128);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/futures/Future.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/nfs/rpc/Server.h"
+#include "eden/fs/nfs/rpc/StreamClient.h"
+
+namespace {
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+constexpr uint32_t kProgNumber = 100003;
+constexpr uint32_t kProgVersion = 3;
+
+/**
+ * Processor that answers every call with an empty successful reply after a
+ * fixed delay, standing in for a backing store fetch.
+ */
+class DelayedProcessor : public RpcServerProcessor {
+ public:
+  ImmediateFuture<folly::Unit> dispatchRpc(
+      folly::io::Cursor /*deser*/,
+      folly::io::QueueAppender ser,
+      uint32_t xid,
+      uint32_t /*progNumber*/,
+      uint32_t /*progVersion*/,
+      uint32_t /*procNumber*/) override {
+    return folly::futures::sleep(1ms).deferValue(
+        [ser = std::move(ser), xid](folly::Unit) mutable {
+          serializeReply(ser, accept_stat::SUCCESS, xid);
+        });
+  }
+};
+
+void pipelined_rpcs(benchmark::State& state) {
+  auto depth = static_cast<size_t>(state.range(0));
+
+  folly::ScopedEventBaseThread evbThread;
+  auto* evb = evbThread.getEventBase();
+  auto threadPool = std::make_shared<folly::CPUThreadPoolExecutor>(4);
+
+  std::unique_ptr<RpcServer> server;
+  evb->runInEventBaseThreadAndWait([&] {
+    server = std::make_unique<RpcServer>(
+        std::make_shared<DelayedProcessor>(), evb, threadPool, depth);
+    server->initialize(folly::SocketAddress("127.0.0.1", 0));
+  });
+
+  StreamClient client{server->getAddr()};
+  client.connect();
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < depth; ++i) {
+      client.serializeCall(kProgNumber, kProgVersion, 0, uint32_t{0});
+    }
+    // Replies come back in completion order, which is not necessarily the
+    // order the calls were sent in.
+    for (size_t i = 0; i < depth; ++i) {
+      client.receiveChunk();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * depth);
+
+  evb->runInEventBaseThreadAndWait([&] { server.reset(); });
+}
+
+BENCHMARK(pipelined_rpcs)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
+
+#else
+
+int main() {
+  return 0;
+}
+
+#endif
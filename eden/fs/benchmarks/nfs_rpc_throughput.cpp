@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/nfs/rpc/Server.h"
+#include "eden/fs/nfs/rpc/StreamClient.h"
+#include "eden/fs/testharness/TempFile.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr uint32_t kProgNumber = 100003;
+constexpr uint32_t kProgVersion = 3;
+
+/**
+ * Processor that answers every call with as many bytes as the call asked
+ * for, like an NFS READ of a file whose content is in memory.
+ */
+class ReadProcessor : public RpcServerProcessor {
+ public:
+  ImmediateFuture<folly::Unit> dispatchRpc(
+      folly::io::Cursor deser,
+      folly::io::QueueAppender ser,
+      uint32_t xid,
+      uint32_t /*progNumber*/,
+      uint32_t /*progVersion*/,
+      uint32_t /*procNumber*/) override {
+    auto size = XdrTrait<uint32_t>::deserialize(deser);
+    auto data = folly::IOBuf::create(size);
+    data->append(size);
+    serializeReply(ser, accept_stat::SUCCESS, xid);
+    XdrTrait<std::unique_ptr<folly::IOBuf>>::serialize(ser, data);
+    return folly::unit;
+  }
+};
+
+/**
+ * Reads of state.range(1) bytes over loopback TCP when state.range(0) is 0,
+ * and over a unix domain socket otherwise.
+ */
+void rpc_read_throughput(benchmark::State& state) {
+  bool useUnixSocket = state.range(0) != 0;
+  auto size = static_cast<uint32_t>(state.range(1));
+
+  auto tempDir = makeTempDir("eden_nfs_rpc_throughput");
+  auto addr = useUnixSocket
+      ? folly::SocketAddress::makeFromPath(
+            (tempDir.path() / "nfsd.socket").string())
+      : folly::SocketAddress("127.0.0.1", 0);
+
+  folly::ScopedEventBaseThread evbThread;
+  auto* evb = evbThread.getEventBase();
+  auto threadPool = std::make_shared<folly::CPUThreadPoolExecutor>(4);
+
+  std::unique_ptr<RpcServer> server;
+  evb->runInEventBaseThreadAndWait([&] {
+    server = std::make_unique<RpcServer>(
+        std::make_shared<ReadProcessor>(), evb, threadPool, 1);
+    server->initialize(addr);
+  });
+
+  StreamClient client{server->getAddr()};
+  client.connect();
+
+  for (auto _ : state) {
+    client.serializeCall(kProgNumber, kProgVersion, 0, size);
+    client.receiveChunk();
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+
+  evb->runInEventBaseThreadAndWait([&] { server.reset(); });
+}
+
+BENCHMARK(rpc_read_throughput)
+    ->ArgNames({"uds", "size"})
+    ->ArgsProduct({{0, 1}, {4 * 1024, 128 * 1024, 1024 * 1024}});
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
+
+#else
+
+int main() {
+  return 0;
+}
+
+#endif
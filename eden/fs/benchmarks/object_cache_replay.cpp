@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/core.h>
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/config/FieldConverter.h"
+#include "eden/fs/store/ObjectCache.h"
+#include "eden/fs/store/ObjectCacheTrace.h"
+
+DEFINE_string(
+    trace,
+    "",
+    "Trace to replay, as written with blobcache:trace-capacity or "
+    "treecache:trace-capacity set");
+DEFINE_string(
+    policies,
+    "LRU,SLRU,TinyLFU",
+    "Comma separated eviction policies to replay the trace against");
+DEFINE_string(
+    sizes,
+    "",
+    "Comma separated cache sizes in bytes. Defaults to 1/64 of the trace's "
+    "working set through all of it, doubling each time");
+DEFINE_uint64(shards, 1, "Number of shards of the replayed caches");
+DEFINE_uint64(min_entries, 0, "Minimum entry count of the replayed caches");
+
+using namespace facebook::eden;
+
+namespace {
+
+/**
+ * Stands in for the traced blob or tree, of which only the hashed id and the
+ * size are known.
+ */
+class TraceObject {
+ public:
+  TraceObject(uint64_t id, size_t size)
+      : hash_{folly::ByteRange{
+            reinterpret_cast<const uint8_t*>(&id),
+            sizeof(id)}},
+        size_{size} {}
+
+  const ObjectId& getHash() const {
+    return hash_;
+  }
+
+  size_t getSizeBytes() const {
+    return size_;
+  }
+
+ private:
+  ObjectId hash_;
+  size_t size_;
+};
+
+using ReplayCache = ObjectCache<TraceObject, ObjectCacheFlavor::Simple>;
+
+struct Object {
+  std::shared_ptr<const TraceObject> object;
+  /** Whether any event told the size of the object. */
+  bool sized = false;
+  /** Set while the replay inserted it on a miss that the trace inserts. */
+  bool pendingFill = false;
+};
+
+struct Access {
+  Object* object;
+  bool lookup;
+};
+
+struct Trace {
+  std::unordered_map<uint64_t, Object> objects;
+  std::vector<Access> accesses;
+  uint64_t recordedHits = 0;
+  uint64_t recordedMisses = 0;
+  size_t workingSetBytes = 0;
+};
+
+Trace loadTrace(const std::string& path) {
+  std::string contents;
+  if (!folly::readFile(path.c_str(), contents)) {
+    throw std::runtime_error(fmt::format("unable to read {}", path));
+  }
+  auto events = ObjectCacheTrace::parse(contents);
+
+  // Misses don't know the size of the object, so find it first.
+  std::unordered_map<uint64_t, size_t> sizes;
+  for (const auto& event : events) {
+    if (event.operation != ObjectCacheTrace::Operation::Miss) {
+      auto& size = sizes[event.id];
+      size = std::max<size_t>(size, event.sizeBytes);
+    }
+  }
+
+  Trace trace;
+  trace.accesses.reserve(events.size());
+  for (const auto& event : events) {
+    auto [it, inserted] = trace.objects.try_emplace(event.id);
+    auto& object = it->second;
+    if (inserted) {
+      auto size = sizes.find(event.id);
+      object.sized = size != sizes.end();
+      object.object = std::make_shared<TraceObject>(
+          event.id, object.sized ? size->second : 0);
+      trace.workingSetBytes += object.object->getSizeBytes();
+    }
+    switch (event.operation) {
+      case ObjectCacheTrace::Operation::Hit:
+        ++trace.recordedHits;
+        break;
+      case ObjectCacheTrace::Operation::Miss:
+        ++trace.recordedMisses;
+        break;
+      case ObjectCacheTrace::Operation::Insert:
+        break;
+    }
+    auto lookup = event.operation != ObjectCacheTrace::Operation::Insert;
+    trace.accesses.push_back(Access{&object, lookup});
+  }
+  return trace;
+}
+
+struct Result {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t hitBytes = 0;
+  uint64_t missBytes = 0;
+  ReplayCache::Stats stats;
+  uint64_t elapsedNs = 0;
+};
+
+/**
+ * Lookups that miss insert the object right away, as ObjectStore does once
+ * it is fetched, unless no event told its size. The trace's own insert of
+ * that object is then skipped, while inserts that no miss led to, like
+ * prefetches, are replayed as they are.
+ */
+Result replay(Trace& trace, CacheEvictionPolicy policy, size_t size) {
+  for (auto& [id, object] : trace.objects) {
+    object.pendingFill = false;
+  }
+  auto cache =
+      ReplayCache::create(size, FLAGS_min_entries, FLAGS_shards, policy);
+
+  Result result;
+  auto start = getTime();
+  for (const auto& access : trace.accesses) {
+    auto& object = *access.object;
+    const auto& hash = object.object->getHash();
+    auto bytes = object.object->getSizeBytes();
+    if (!access.lookup) {
+      if (!std::exchange(object.pendingFill, false)) {
+        cache->insertSimple(object.object);
+      }
+    } else if (cache->getSimple(hash)) {
+      ++result.hits;
+      result.hitBytes += bytes;
+    } else {
+      ++result.misses;
+      result.missBytes += bytes;
+      if (object.sized) {
+        cache->insertSimple(object.object);
+        object.pendingFill = true;
+      }
+    }
+  }
+  result.elapsedNs = getTime() - start;
+  result.stats = cache->getStats();
+  return result;
+}
+
+std::vector<CacheEvictionPolicy> parsePolicies(const std::string& policies) {
+  std::vector<folly::StringPiece> names;
+  folly::split(',', policies, names, true);
+  std::vector<CacheEvictionPolicy> result;
+  for (auto name : names) {
+    result.push_back(
+        FieldConverter<CacheEvictionPolicy>{}.fromString(name, {}).value());
+  }
+  return result;
+}
+
+std::vector<size_t> parseSizes(const std::string& sizes, const Trace& trace) {
+  std::vector<size_t> result;
+  if (sizes.empty()) {
+    for (size_t fraction = 64; fraction >= 1; fraction /= 2) {
+      result.push_back(std::max<size_t>(trace.workingSetBytes / fraction, 1));
+    }
+    return result;
+  }
+  folly::split(',', sizes, result, true);
+  return result;
+}
+
+double percent(uint64_t part, uint64_t whole) {
+  return whole ? 100.0 * part / whole : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+
+  if (FLAGS_trace.empty()) {
+    fprintf(stderr, "--trace must be specified.\n");
+    return 1;
+  }
+
+  auto trace = loadTrace(FLAGS_trace);
+  if (trace.accesses.empty()) {
+    fprintf(stderr, "The trace is empty.\n");
+    return 1;
+  }
+  auto policies = parsePolicies(FLAGS_policies);
+  auto sizes = parseSizes(FLAGS_sizes, trace);
+
+  fmt::print(
+      "Replaying {} events on {} objects, {:.1f} MB working set, recorded "
+      "hit rate {:.2f}%\n",
+      trace.accesses.size(),
+      trace.objects.size(),
+      trace.workingSetBytes / 1e6,
+      percent(trace.recordedHits, trace.recordedHits + trace.recordedMisses));
+  fmt::print(
+      "{:>8} {:>12} {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+      "policy",
+      "size MB",
+      "hit %",
+      "byte hit %",
+      "evictions",
+      "rejected",
+      "Mevents/s");
+  for (auto policy : policies) {
+    for (auto size : sizes) {
+      auto result = replay(trace, policy, size);
+      fmt::print(
+          "{:>8} {:>12.1f} {:>10.2f} {:>10.2f} {:>10} {:>10} {:>10.2f}\n",
+          FieldConverter<CacheEvictionPolicy>{}.toDebugString(policy),
+          size / 1e6,
+          percent(result.hits, result.hits + result.misses),
+          percent(result.hitBytes, result.hitBytes + result.missBytes),
+          result.stats.evictionCount,
+          result.stats.admissionRejectCount,
+          trace.accesses.size() * 1e3 / std::max<uint64_t>(
+                                            result.elapsedNs, 1));
+    }
+  }
+  return 0;
+}
@@ -7,6 +7,7 @@
 
 #include <fcntl.h>
 #include <folly/Exception.h>
+#include <folly/FileUtil.h>
 #include <folly/Likely.h>
 #include <folly/init/Init.h>
 #include <folly/synchronization/test/Barrier.h>
@@ -22,6 +23,12 @@
 
 DEFINE_uint64(threads, 1, "The number of concurrent open/close threads");
 DEFINE_uint64(iterations, 100000, "Number of open/close iterations per thread");
+DEFINE_bool(
+    sweep,
+    false,
+    "Run on 1, 2, 4, ... up to --threads threads and print how throughput "
+    "scales");
+DEFINE_string(json, "", "With --sweep, also write the results to this file");
 
 using namespace facebook::eden;
 
@@ -54,6 +61,28 @@ int main(int argc, char** argv) {
     ::close(fd);
   }
 
+  if (FLAGS_sweep) {
+    auto results = runScalingSweep(
+        FLAGS_threads, FLAGS_iterations, [&](size_t thread) {
+          // Spread the threads over the files rather than having them all
+          // open the same one at once.
+          static thread_local int file_index = 0;
+          const char* filename = argv[1 + (thread + file_index) % (argc - 1)];
+          ++file_index;
+          int fd = ::open(filename, O_RDONLY);
+          if (UNLIKELY(-1 == fd)) {
+            folly::throwSystemError("Failed to open '", filename, "'");
+          }
+          ::close(fd);
+        });
+    printScalingTable(results);
+    if (!FLAGS_json.empty()) {
+      folly::writeFileAtomic(
+          FLAGS_json, scalingResultsToJson("open_close_parallel", results));
+    }
+    return 0;
+  }
+
   folly::test::Barrier gate{FLAGS_threads};
 
   std::mutex result_mutex;
@@ -102,12 +131,19 @@ int main(int argc, char** argv) {
     thread.join();
   }
 
-  printf(
-      "open()\n  minimum: %" PRIu64 " ns\n  average: %" PRIu64 " ns\n",
-      combined_open.getMinimum(),
-      combined_open.getAverage());
-  printf(
-      "close()\n  minimum: %" PRIu64 " ns\n  average: %" PRIu64 " ns\n",
-      combined_close.getMinimum(),
-      combined_close.getAverage());
+  auto print = [](const char* name, const StatAccumulator& accum) {
+    printf(
+        "%s\n  minimum: %" PRIu64 " ns\n  average: %" PRIu64
+        " ns\n  p50: %" PRIu64 " ns\n  p99: %" PRIu64 " ns\n  p99.9: %" PRIu64
+        " ns\n  maximum: %" PRIu64 " ns\n",
+        name,
+        accum.getMinimum(),
+        accum.getAverage(),
+        accum.getPercentile(0.5),
+        accum.getPercentile(0.99),
+        accum.getPercentile(0.999),
+        accum.getMaximum());
+  };
+  print("open()", combined_open);
+  print("close()", combined_close);
 }
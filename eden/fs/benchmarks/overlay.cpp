@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <sys/stat.h>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/inodes/DirEntry.h"
+#include "eden/fs/inodes/Overlay.h"
+#include "eden/fs/inodes/overlay/FsOverlay.h"
+#include "eden/fs/inodes/sqliteoverlay/SqliteOverlay.h"
+#include "eden/fs/inodes/treeoverlay/TreeOverlay.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/TempFile.h"
+
+namespace {
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+/**
+ * The storage behind an Overlay. SqliteOverlay is only used by Overlay on
+ * Windows, so it is only compared through the IOverlay interface.
+ */
+enum class Backend {
+  Fs,
+  Tree,
+  TreeSynchronousOff,
+  TreeCheckpointed,
+  Sqlite,
+};
+
+// The directories each thread rewrites in turn, so that the backends see
+// more than one key.
+constexpr uint64_t kDirsPerThread = 64;
+// The first inode number after the root.
+constexpr uint64_t kFirstDir = 2;
+
+std::unique_ptr<IOverlay> makeBackend(Backend backend, AbsolutePathPiece dir) {
+  switch (backend) {
+    case Backend::Fs:
+      return std::make_unique<FsOverlay>(dir);
+    case Backend::Tree:
+      return std::make_unique<TreeOverlay>(dir);
+    case Backend::TreeSynchronousOff:
+      return std::make_unique<TreeOverlay>(
+          dir, TreeOverlayStore::SynchronousMode::Off);
+    case Backend::TreeCheckpointed:
+      return std::make_unique<TreeOverlay>(
+          dir,
+          TreeOverlayStore::SynchronousMode::Normal,
+          TreeOverlay::WriteBatching{0ms, 1024, 1s});
+    case Backend::Sqlite:
+      return std::make_unique<SqliteOverlay>(dir);
+  }
+  throw std::invalid_argument{"unknown overlay backend"};
+}
+
+/**
+ * A directory of unmaterialized files, as checkout writes them.
+ */
+overlay::OverlayDir makeOverlayDir(size_t entries, uint64_t firstChild) {
+  overlay::OverlayDir dir;
+  for (size_t i = 0; i < entries; ++i) {
+    overlay::OverlayEntry entry;
+    entry.mode_ref() = S_IFREG | 0644;
+    entry.inodeNumber_ref() = static_cast<int64_t>(firstChild + i);
+    entry.hash_ref() = std::string(20, static_cast<char>(i));
+    dir.entries_ref()->emplace(
+        folly::to<std::string>("file", i), std::move(entry));
+  }
+  return dir;
+}
+
+InodeNumber dirOfIteration(const benchmark::State& state, uint64_t iteration) {
+  return InodeNumber{
+      kFirstDir + state.thread_index() * kDirsPerThread +
+      iteration % kDirsPerThread};
+}
+
+struct BackendFixture {
+  explicit BackendFixture(Backend backend)
+      : tempDir{makeTempDir("eden_overlay_bench")},
+        overlay{makeBackend(backend, AbsolutePath{tempDir.path().string()})} {
+    overlay->initOverlay(true);
+  }
+
+  ~BackendFixture() {
+    overlay->close(InodeNumber{kFirstDir + 1024 * kDirsPerThread});
+  }
+
+  folly::test::TemporaryDirectory tempDir;
+  std::unique_ptr<IOverlay> overlay;
+};
+
+std::unique_ptr<BackendFixture> backendFixture;
+
+/**
+ * Saves directories of state.range(0) entries, each thread rewriting its own
+ * set of directories.
+ */
+void save_overlay_dir(benchmark::State& state, Backend backend) {
+  if (state.thread_index() == 0) {
+    backendFixture = std::make_unique<BackendFixture>(backend);
+  }
+  auto dir = makeOverlayDir(state.range(0), 1u << 20);
+
+  uint64_t iteration = 0;
+  for (auto _ : state) {
+    backendFixture->overlay->saveOverlayDir(
+        dirOfIteration(state, iteration++), dir);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(folly::to<std::string>(state.range(0), " entries"));
+
+  if (state.thread_index() == 0) {
+    backendFixture.reset();
+  }
+}
+
+/**
+ * Loads directories of state.range(0) entries, each thread reading its own
+ * set of directories.
+ */
+void load_overlay_dir(benchmark::State& state, Backend backend) {
+  if (state.thread_index() == 0) {
+    backendFixture = std::make_unique<BackendFixture>(backend);
+    auto dir = makeOverlayDir(state.range(0), 1u << 20);
+    for (int thread = 0; thread < state.threads(); ++thread) {
+      for (uint64_t i = 0; i < kDirsPerThread; ++i) {
+        backendFixture->overlay->saveOverlayDir(
+            InodeNumber{kFirstDir + thread * kDirsPerThread + i}, dir);
+      }
+    }
+  }
+
+  uint64_t iteration = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(backendFixture->overlay->loadOverlayDir(
+        dirOfIteration(state, iteration++)));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(folly::to<std::string>(state.range(0), " entries"));
+
+  if (state.thread_index() == 0) {
+    backendFixture.reset();
+  }
+}
+
+void dirSizesAndThreads(benchmark::internal::Benchmark* benchmark) {
+  benchmark->Arg(8)->Arg(128)->Arg(2048)->Threads(1)->Threads(4)->UseRealTime();
+}
+
+BENCHMARK_CAPTURE(save_overlay_dir, fs, Backend::Fs)->Apply(dirSizesAndThreads);
+BENCHMARK_CAPTURE(save_overlay_dir, tree, Backend::Tree)
+    ->Apply(dirSizesAndThreads);
+BENCHMARK_CAPTURE(
+    save_overlay_dir,
+    tree_synchronous_off,
+    Backend::TreeSynchronousOff)
+    ->Apply(dirSizesAndThreads);
+BENCHMARK_CAPTURE(
+    save_overlay_dir,
+    tree_checkpointed,
+    Backend::TreeCheckpointed)
+    ->Apply(dirSizesAndThreads);
+BENCHMARK_CAPTURE(save_overlay_dir, sqlite, Backend::Sqlite)
+    ->Apply(dirSizesAndThreads);
+
+BENCHMARK_CAPTURE(load_overlay_dir, fs, Backend::Fs)->Apply(dirSizesAndThreads);
+BENCHMARK_CAPTURE(load_overlay_dir, tree, Backend::Tree)
+    ->Apply(dirSizesAndThreads);
+BENCHMARK_CAPTURE(
+    load_overlay_dir,
+    tree_synchronous_off,
+    Backend::TreeSynchronousOff)
+    ->Apply(dirSizesAndThreads);
+BENCHMARK_CAPTURE(
+    load_overlay_dir,
+    tree_checkpointed,
+    Backend::TreeCheckpointed)
+    ->Apply(dirSizesAndThreads);
+BENCHMARK_CAPTURE(load_overlay_dir, sqlite, Backend::Sqlite)
+    ->Apply(dirSizesAndThreads);
+
+std::shared_ptr<Overlay> openOverlay(
+    AbsolutePathPiece dir,
+    Overlay::OverlayType type) {
+  auto overlay = Overlay::create(
+      dir,
+      kPathMapDefaultCaseSensitive,
+      type,
+      std::make_shared<NullStructuredLogger>());
+  overlay->initialize().get();
+  return overlay;
+}
+
+struct OverlayFixture {
+  explicit OverlayFixture(Overlay::OverlayType type)
+      : tempDir{makeTempDir("eden_overlay_bench")},
+        path{tempDir.path().string()},
+        overlay{openOverlay(path, type)} {}
+
+  folly::test::TemporaryDirectory tempDir;
+  AbsolutePath path;
+  std::shared_ptr<Overlay> overlay;
+};
+
+std::unique_ptr<OverlayFixture> overlayFixture;
+
+void allocate_inode_number(
+    benchmark::State& state,
+    Overlay::OverlayType type) {
+  if (state.thread_index() == 0) {
+    overlayFixture = std::make_unique<OverlayFixture>(type);
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(overlayFixture->overlay->allocateInodeNumber());
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    overlayFixture.reset();
+  }
+}
+
+/**
+ * Saves a directory of width directories of width files each, and returns
+ * its inode number.
+ */
+InodeNumber saveTree(Overlay& overlay, size_t width) {
+  auto top = overlay.allocateInodeNumber();
+  DirContents topDir(kPathMapDefaultCaseSensitive);
+  for (size_t i = 0; i < width; ++i) {
+    auto child = overlay.allocateInodeNumber();
+    DirContents childDir(kPathMapDefaultCaseSensitive);
+    for (size_t j = 0; j < width; ++j) {
+      childDir.emplace(
+          PathComponent{folly::to<std::string>("file", j)},
+          S_IFREG | 0644,
+          overlay.allocateInodeNumber());
+    }
+    overlay.saveOverlayDir(child, childDir);
+    topDir.emplace(
+        PathComponent{folly::to<std::string>("dir", i)},
+        S_IFDIR | 0755,
+        child);
+  }
+  overlay.saveOverlayDir(top, topDir);
+  return top;
+}
+
+/**
+ * Removes trees of state.range(0) directories of state.range(0) files, as
+ * checkout does when it replaces a materialized directory.
+ */
+void recursively_remove_overlay_data(
+    benchmark::State& state,
+    Overlay::OverlayType type) {
+  OverlayFixture fixture{type};
+  auto width = static_cast<size_t>(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto top = saveTree(*fixture.overlay, width);
+    state.ResumeTiming();
+
+    fixture.overlay->recursivelyRemoveOverlayData(top);
+    fixture.overlay->flushPendingAsync().get();
+  }
+  state.SetItemsProcessed(state.iterations() * width * (width + 1));
+}
+
+/**
+ * Opens an overlay holding a tree of state.range(0) directories of
+ * state.range(0) files. After a crash, the legacy overlay has no saved next
+ * inode number, and scans all of its data with the OverlayChecker before it
+ * can be used; the tree overlays always read their counters from the
+ * database.
+ */
+void open_overlay(
+    benchmark::State& state,
+    Overlay::OverlayType type,
+    bool afterCrash) {
+  OverlayFixture fixture{type};
+  saveTree(*fixture.overlay, static_cast<size_t>(state.range(0)));
+  fixture.overlay.reset();
+
+  for (auto _ : state) {
+    if (afterCrash) {
+      state.PauseTiming();
+      ::unlink((fixture.path + "next-inode-number"_pc).c_str());
+      state.ResumeTiming();
+    }
+    auto overlay = openOverlay(fixture.path, type);
+    overlay->close();
+  }
+}
+
+BENCHMARK_CAPTURE(allocate_inode_number, fs, Overlay::OverlayType::Legacy)
+    ->Threads(1)
+    ->Threads(4)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(allocate_inode_number, tree, Overlay::OverlayType::Tree)
+    ->Threads(1)
+    ->Threads(4)
+    ->UseRealTime();
+
+BENCHMARK_CAPTURE(
+    recursively_remove_overlay_data,
+    fs,
+    Overlay::OverlayType::Legacy)
+    ->Arg(8)
+    ->Arg(64)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(
+    recursively_remove_overlay_data,
+    tree,
+    Overlay::OverlayType::Tree)
+    ->Arg(8)
+    ->Arg(64)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(
+    recursively_remove_overlay_data,
+    tree_synchronous_off,
+    Overlay::OverlayType::TreeSynchronousOff)
+    ->Arg(8)
+    ->Arg(64)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(open_overlay, fs, Overlay::OverlayType::Legacy, false)
+    ->Arg(64)
+    ->Arg(256)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(
+    open_overlay,
+    fs_after_crash,
+    Overlay::OverlayType::Legacy,
+    true)
+    ->Arg(64)
+    ->Arg(256)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(open_overlay, tree, Overlay::OverlayType::Tree, false)
+    ->Arg(64)
+    ->Arg(256)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(
+    open_overlay,
+    tree_checkpointed,
+    Overlay::OverlayType::TreeCheckpointed,
+    false)
+    ->Arg(64)
+    ->Arg(256)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
+
+#endif
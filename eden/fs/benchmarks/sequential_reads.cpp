@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <gflags/gflags.h>
+#include <vector>
+#include "eden/fs/benchharness/Bench.h"
+
+namespace {
+
+DEFINE_string(
+    filename,
+    "",
+    "Path of the file to read, typically a large file in an EdenFS mount");
+
+/**
+ * Reads the file from start to end in reads of state.range(0) bytes, as `cat`
+ * or a compiler reading its inputs do, starting over at the end of the file.
+ *
+ * Drop the page cache of the overlay between runs to measure cold reads of
+ * materialized files.
+ */
+void sequential_reads(benchmark::State& state) {
+  if (FLAGS_filename.empty()) {
+    state.SkipWithError("--filename must be set");
+    return;
+  }
+  folly::File file{FLAGS_filename, O_RDONLY | O_CLOEXEC};
+  std::vector<char> buffer(state.range(0));
+
+  off_t offset = 0;
+  size_t bytesRead = 0;
+  for (auto _ : state) {
+    auto ret =
+        folly::preadNoInt(file.fd(), buffer.data(), buffer.size(), offset);
+    folly::checkUnixError(ret, "pread");
+    if (ret == 0) {
+      offset = 0;
+      continue;
+    }
+    offset += ret;
+    bytesRead += ret;
+  }
+  state.SetBytesProcessed(bytesRead);
+}
+
+BENCHMARK(sequential_reads)
+    ->ArgName("read_size")
+    ->Arg(4 * 1024)
+    ->Arg(64 * 1024)
+    ->Arg(128 * 1024)
+    ->Arg(1024 * 1024);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
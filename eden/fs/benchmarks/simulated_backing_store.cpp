@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/futures/Future.h>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/SimulatedBackingStore.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kBlobCount = 256;
+constexpr size_t kBlobSize = 16 * 1024;
+
+/**
+ * A store with a long tailed 2 ms round trip over a 100 MB/s link, which is
+ * roughly what fetching from a nearby server looks like.
+ */
+struct SimulatedStore {
+  SimulatedStore() {
+    for (size_t i = 0; i < kBlobCount; ++i) {
+      auto contents = std::string(kBlobSize, 'a') + std::to_string(i);
+      auto* blob = fakeStore->putBlob(contents);
+      blob->setReady();
+      ids.push_back(blob->get().getHash());
+    }
+    SimulatedBackingStore::Options options;
+    options.latency = std::chrono::milliseconds{2};
+    options.latencySigma = 0.5;
+    options.bandwidth = 100 * 1000 * 1000;
+    store = std::make_unique<SimulatedBackingStore>(fakeStore, options);
+  }
+
+  std::shared_ptr<FakeBackingStore> fakeStore =
+      std::make_shared<FakeBackingStore>();
+  std::unique_ptr<SimulatedBackingStore> store;
+  std::vector<ObjectId> ids;
+};
+
+/**
+ * Fetches every blob at once with individual requests.
+ */
+void concurrent_get_blob(benchmark::State& state) {
+  SimulatedStore simulated;
+  auto& context = ObjectFetchContext::getNullContext();
+  for (auto _ : state) {
+    std::vector<folly::SemiFuture<BackingStore::GetBlobRes>> futures;
+    futures.reserve(simulated.ids.size());
+    for (const auto& id : simulated.ids) {
+      futures.push_back(simulated.store->getBlob(id, context));
+    }
+    folly::collectAll(std::move(futures)).get();
+  }
+  state.SetItemsProcessed(state.iterations() * simulated.ids.size());
+}
+
+/**
+ * Fetches every blob at once in batches of state.range(0).
+ */
+void batched_prefetch(benchmark::State& state) {
+  SimulatedStore simulated;
+  auto& context = ObjectFetchContext::getNullContext();
+  auto batchSize = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    std::vector<folly::SemiFuture<folly::Unit>> futures;
+    for (size_t start = 0; start < simulated.ids.size(); start += batchSize) {
+      auto end = std::min(start + batchSize, simulated.ids.size());
+      futures.push_back(simulated.store->prefetchBlobs(
+          ObjectIdRange{&simulated.ids[start], &simulated.ids[0] + end},
+          context));
+    }
+    folly::collectAll(std::move(futures)).get();
+  }
+  state.SetItemsProcessed(state.iterations() * simulated.ids.size());
+}
+
+BENCHMARK(concurrent_get_blob)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(batched_prefetch)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(32)
+    ->Arg(256);
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -16,8 +16,9 @@ import stat
 import subprocess
 import sys
 from pathlib import Path
-from typing import Dict, Iterable, Optional
+from typing import Dict, Iterable, List, Optional
 
+from facebook.eden.ttypes import BindMount
 from thrift.Thrift import TApplicationException
 
 from . import cmd_util, mtab, subcmd as subcmd_mod, tabulate
@@ -294,31 +295,35 @@ class Redirection:
         # This will unmount/detach both disk images and apfs volumes
         run_cmd_quietly(["diskutil", "unmount", "force", mount_path])
 
+    def _prepare_bind_mount_linux(
+        self, client, checkout_path: Path, target: Path
+    ) -> None:
+        abs_mount_path_in_repo = checkout_path / self.repo_path
+        if abs_mount_path_in_repo.exists():
+            try:
+                # To deal with the case where someone has manually unmounted
+                # a bind mount and left the privhelper confused about the
+                # list of bind mounts, we first speculatively try asking the
+                # eden daemon to unmount it first, ignoring any error that
+                # might raise.
+                client.removeBindMount(
+                    os.fsencode(checkout_path), os.fsencode(self.repo_path)
+                )
+            except TApplicationException as exc:
+                if exc.type == TApplicationException.UNKNOWN_METHOD:
+                    print(PLEASE_RESTART, file=sys.stderr)
+                log.debug("removeBindMount failed; ignoring error", exc_info=True)
+
+        # Ensure that the client directory exists before we try
+        # to mount over it
+        abs_mount_path_in_repo.mkdir(exist_ok=True, parents=True)
+        target.mkdir(exist_ok=True, parents=True)
+
     def _bind_mount_linux(
         self, instance: EdenInstance, checkout_path: Path, target: Path
     ) -> None:
-        abs_mount_path_in_repo = checkout_path / self.repo_path
         with instance.get_thrift_client_legacy() as client:
-            if abs_mount_path_in_repo.exists():
-                try:
-                    # To deal with the case where someone has manually unmounted
-                    # a bind mount and left the privhelper confused about the
-                    # list of bind mounts, we first speculatively try asking the
-                    # eden daemon to unmount it first, ignoring any error that
-                    # might raise.
-                    client.removeBindMount(
-                        os.fsencode(checkout_path), os.fsencode(self.repo_path)
-                    )
-                except TApplicationException as exc:
-                    if exc.type == TApplicationException.UNKNOWN_METHOD:
-                        print(PLEASE_RESTART, file=sys.stderr)
-                    log.debug("removeBindMount failed; ignoring error", exc_info=True)
-
-            # Ensure that the client directory exists before we try
-            # to mount over it
-            abs_mount_path_in_repo.mkdir(exist_ok=True, parents=True)
-            target.mkdir(exist_ok=True, parents=True)
-
+            self._prepare_bind_mount_linux(client, checkout_path, target)
             try:
                 client.addBindMount(
                     os.fsencode(checkout_path),
@@ -418,6 +423,19 @@ class Redirection:
 
     def apply(self, checkout: EdenCheckout) -> None:
         disposition = self.remove_existing(checkout)
+        self._check_disposition(disposition)
+        if self.type == RedirectionType.BIND:
+            target = self.expand_target_abspath(checkout)
+            assert target is not None
+            self._bind_mount(checkout.instance, checkout.path, target)
+        elif self.type == RedirectionType.SYMLINK:
+            target = self.expand_target_abspath(checkout)
+            assert target is not None
+            self._apply_symlink(checkout.path, target)
+        else:
+            raise Exception(f"Unsupported redirection type {self.type}")
+
+    def _check_disposition(self, disposition: RepoPathDisposition) -> None:
         if disposition == RepoPathDisposition.IS_NON_EMPTY_DIR and (
             self.type == RedirectionType.SYMLINK
             or (self.type == RedirectionType.BIND and sys.platform == "win32")
@@ -434,16 +452,47 @@ class Redirection:
             )
         if disposition == RepoPathDisposition.IS_FILE:
             raise Exception(f"Cannot redirect {self.repo_path} because it is a file")
-        if self.type == RedirectionType.BIND:
-            target = self.expand_target_abspath(checkout)
-            assert target is not None
-            self._bind_mount(checkout.instance, checkout.path, target)
-        elif self.type == RedirectionType.SYMLINK:
-            target = self.expand_target_abspath(checkout)
+
+
+def apply_bind_mounts_linux(checkout: EdenCheckout, redirs: List[Redirection]) -> None:
+    """Apply several bind mount redirections with a single addBindMounts
+    request, which EdenFS performs concurrently.  This is much faster than
+    applying them one at a time when a checkout has many of them.
+    Failures are reported, and leave their redirection in need of fixing."""
+    with checkout.instance.get_thrift_client_legacy() as client:
+        bind_mounts = []
+        for redir in redirs:
+            redir._check_disposition(redir.remove_existing(checkout))
+            target = redir.expand_target_abspath(checkout)
             assert target is not None
-            self._apply_symlink(checkout.path, target)
-        else:
-            raise Exception(f"Unsupported redirection type {self.type}")
+            redir._prepare_bind_mount_linux(client, checkout.path, target)
+            bind_mounts.append(
+                BindMount(
+                    repoPath=os.fsencode(redir.repo_path),
+                    targetPath=os.fsencode(target),
+                )
+            )
+
+        try:
+            results = client.addBindMounts(os.fsencode(checkout.path), bind_mounts)
+        except TApplicationException as exc:
+            if exc.type != TApplicationException.UNKNOWN_METHOD:
+                raise
+            # An older EdenFS: fall back on one request per bind mount.
+            for bind_mount in bind_mounts:
+                client.addBindMount(
+                    os.fsencode(checkout.path),
+                    bind_mount.repoPath,
+                    bind_mount.targetPath,
+                )
+            return
+
+        for redir, result in zip(redirs, results):
+            if result.error is not None:
+                print(
+                    f"Failed to bind mount {redir.repo_path}: {result.error.message}",
+                    file=sys.stderr,
+                )
 
 
 def load_redirection_profile(path: Path) -> Dict[str, RedirectionType]:
@@ -800,6 +849,8 @@ class FixupCmd(Subcmd):
         mount_table = mtab.new()
         redirs = get_effective_redirections(checkout, mount_table)
 
+        # On Linux, bind mounts are batched into a single request to EdenFS.
+        bind_mounts: List[Redirection] = []
         for redir in redirs.values():
             if redir.state == RedirectionState.MATCHES_CONFIGURATION and not (
                 args.force_remount_bind_mounts and redir.type == RedirectionType.BIND
@@ -810,8 +861,14 @@ class FixupCmd(Subcmd):
             redir.remove_existing(checkout)
             if redir.type == RedirectionType.UNKNOWN:
                 continue
+            if redir.type == RedirectionType.BIND and "linux" in sys.platform:
+                bind_mounts.append(redir)
+                continue
             redir.apply(checkout)
 
+        if bind_mounts:
+            apply_bind_mounts_linux(checkout, bind_mounts)
+
         # recompute and display the current state
         redirs = get_effective_redirections(checkout, mount_table)
         ok = True
@@ -416,6 +416,7 @@ class LocalStoreCmd(Subcmd):
         # TODO: Retrieve this data via Thrift.
         column_families = [
             ("blob", True),
+            ("blobcontent", True),
             ("blobmeta", True),
             ("tree", True),
             ("treemeta", True),
@@ -6,11 +6,15 @@
  */
 
 #include <fmt/core.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
 #include <folly/init/Init.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <thrift/lib/cpp2/async/RocketClientChannel.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
+#include <optional>
+#include <unordered_map>
 
 #include "eden/fs/service/gen-cpp2/StreamingEdenService.h"
 #include "eden/fs/service/gen-cpp2/streamingeden_constants.h"
@@ -23,6 +27,11 @@ DEFINE_string(mountRoot, "", "Root of the EdenFS mount");
 DEFINE_string(trace, "", "Trace mode");
 DEFINE_bool(writes, false, "Limit trace to write operations");
 DEFINE_bool(reads, false, "Limit trace to write operations");
+DEFINE_string(
+    replayOutput,
+    "",
+    "Also write the FUSE requests of an fs trace to this file, in the format "
+    "replayed by eden/fs/benchmarks/fs_trace_replay");
 
 namespace {
 constexpr auto kTimeout = std::chrono::seconds{1};
@@ -77,6 +86,70 @@ std::string formatNfsCall(
       arguments);
 }
 
+/**
+ * Writes the FUSE requests of a trace as the path-based operations that
+ * fs_trace_replay replays: one "<pid> <operation> <path>" line per request.
+ *
+ * Paths are learned from the lookups seen during the trace, so requests on
+ * inodes that were looked up before the trace started are skipped.
+ */
+class ReplayRecorder {
+ public:
+  explicit ReplayRecorder(const std::string& path)
+      : file_{path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC} {}
+
+  void record(const FsEvent& start, const FsEvent& finish) {
+    const FuseCall* call = finish.get_fuseRequest();
+    if (!call) {
+      return;
+    }
+    const auto& opcode = call->get_opcodeName();
+    auto nodeid = static_cast<uint64_t>(call->get_nodeid());
+    auto pid = call->get_pid();
+    if (opcode == "FUSE_LOOKUP") {
+      auto parent = paths_.find(nodeid);
+      auto* result = finish.get_result();
+      if (parent == paths_.end() || !result || *result <= 0) {
+        return;
+      }
+      const auto& name = start.get_arguments();
+      auto path =
+          parent->second.empty() ? name : parent->second + "/" + name;
+      emit(pid, "stat", path);
+      paths_[static_cast<uint64_t>(*result)] = std::move(path);
+    } else if (opcode == "FUSE_GETATTR") {
+      emit(pid, "stat", nodeid);
+    } else if (opcode == "FUSE_OPEN") {
+      emit(pid, "read", nodeid);
+    } else if (opcode == "FUSE_OPENDIR") {
+      emit(pid, "readdir", nodeid);
+    } else if (opcode == "FUSE_READLINK") {
+      emit(pid, "readlink", nodeid);
+    }
+  }
+
+ private:
+  void emit(int32_t pid, folly::StringPiece operation, uint64_t nodeid) {
+    auto it = paths_.find(nodeid);
+    if (it != paths_.end()) {
+      emit(pid, operation, it->second);
+    }
+  }
+
+  void emit(
+      int32_t pid,
+      folly::StringPiece operation,
+      folly::StringPiece path) {
+    auto line = fmt::format(
+        "{} {} {}\n", pid, operation, path.empty() ? "." : path);
+    folly::writeFull(file_.fd(), line.data(), line.size());
+  }
+
+  folly::File file_;
+  // The mount's root is always FUSE_ROOT_ID.
+  std::unordered_map<uint64_t, std::string> paths_{{1, ""}};
+};
+
 int trace_hg(
     folly::ScopedEventBaseThread& evbThread,
     const AbsolutePath& mountRoot,
@@ -248,6 +321,10 @@ int trace_fs(
   folly::collectAll(outstandingCallFutures).wait(kTimeout);
 
   std::unordered_map<uint64_t, FsEvent> activeRequests;
+  std::optional<ReplayRecorder> replayRecorder;
+  if (!FLAGS_replayOutput.empty()) {
+    replayRecorder.emplace(FLAGS_replayOutput);
+  }
 
   std::move(traceFsStream).subscribeInline([&](folly::Try<FsEvent>&& event) {
     if (event.hasException()) {
@@ -297,6 +374,9 @@ int trace_fs(
               "- {} in {}\n",
               formatted_call,
               fmt::format("{:.3f} \u03BCs", double(elapsedTime) / 1000.0));
+          if (replayRecorder) {
+            replayRecorder->record(record, evt);
+          }
           activeRequests.erase(unique);
         } else {
           fmt::print("- {}\n", formatted_call);
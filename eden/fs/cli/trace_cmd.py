@@ -67,6 +67,12 @@ class TraceFsCommand(Subcmd):
             default=False,
             help="Limit trace to write operations",
         )
+        parser.add_argument(
+            "--replay-output",
+            default="",
+            help="Also write the traced requests to this file, for replaying "
+            "with the fs_trace_replay benchmark",
+        )
 
     async def run(self, args: argparse.Namespace) -> int:
         if sys.platform == "win32":
@@ -83,4 +89,6 @@ class TraceFsCommand(Subcmd):
             b"--trace=fs",
             f"--reads={'true' if args.reads else 'false'}".encode(),
             f"--writes={'true' if args.writes else 'false'}".encode(),
+            b"--replayOutput",
+            os.fsencode(args.replay_output),
         )
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+namespace facebook::eden {
+
+/**
+ * Eviction policy used by the in-memory object caches.
+ */
+enum class CacheEvictionPolicy {
+  /**
+   * Plain least-recently-used eviction.
+   */
+  LRU,
+
+  /**
+   * Segmented LRU: new entries land in a probationary segment and are only
+   * promoted to the protected segment when they are accessed again. One-shot
+   * objects are evicted from the probationary segment first.
+   */
+  SLRU,
+
+  /**
+   * Segmented LRU with a TinyLFU admission filter: a frequency sketch of
+   * recent accesses decides whether a new entry is worth evicting the current
+   * eviction candidate for.
+   */
+  TinyLFU,
+};
+
+} // namespace facebook::eden
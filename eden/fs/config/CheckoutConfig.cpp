@@ -53,6 +53,7 @@ constexpr folly::StringPiece kMountProtocolDefault{kMountProtocolFuse};
 // Files of interest in the client directory.
 const facebook::eden::RelativePathPiece kSnapshotFile{"SNAPSHOT"};
 const facebook::eden::RelativePathPiece kOverlayDir{"local"};
+const facebook::eden::RelativePathPiece kSavedJournalFile{"journal"};
 
 // File holding mapping of client directories.
 const facebook::eden::RelativePathPiece kClientDirectoryMap{"config.json"};
@@ -180,6 +181,10 @@ AbsolutePath CheckoutConfig::getOverlayPath() const {
   return clientDirectory_ + kOverlayDir;
 }
 
+AbsolutePath CheckoutConfig::getSavedJournalPath() const {
+  return clientDirectory_ + kSavedJournalFile;
+}
+
 std::unique_ptr<CheckoutConfig> CheckoutConfig::loadFromClientDirectory(
     AbsolutePathPiece mountPath,
     AbsolutePathPiece clientDirectory) {
@@ -101,6 +101,9 @@ class CheckoutConfig {
   /** Path to the file where the current commit ID is stored */
   AbsolutePath getSnapshotPath() const;
 
+  /** Path to the file where the journal is saved while unmounted */
+  AbsolutePath getSavedJournalPath() const;
+
   /** Path to the client directory */
   const AbsolutePath& getClientDirectory() const;
 
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <chrono>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -18,11 +19,13 @@
 #include <folly/portability/Unistd.h>
 
 #include "common/rust/shed/hostcaps/hostcaps.h"
+#include "eden/fs/config/CacheEvictionPolicy.h"
 #include "eden/fs/config/ConfigSetting.h"
 #include "eden/fs/config/FileChangeMonitor.h"
 #include "eden/fs/config/MountProtocol.h"
 #include "eden/fs/eden-config.h"
 #include "eden/fs/model/Hash.h"
+#include "eden/fs/utils/CpuAffinity.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
@@ -222,6 +225,15 @@ class EdenConfig : private ConfigSettingManager {
       std::chrono::minutes(5),
       this};
 
+  /**
+   * The maximum number of checkouts that are remounted at the same time when
+   * EdenFS starts.
+   */
+  ConfigSetting<size_t> maxConcurrentStartupMounts{
+      "core:max-concurrent-startup-mounts",
+      8,
+      this};
+
   // [config]
 
   /**
@@ -248,6 +260,34 @@ class EdenConfig : private ConfigSettingManager {
       true,
       this};
 
+  /**
+   * The calls of each expensive Thrift method (globFiles, getSHA1,
+   * getScmStatusV2) that a client process may have in flight at once. Calls
+   * over the limit fail with an OVERLOADED EdenError. 0 is unbounded.
+   */
+  ConfigSetting<uint32_t> thriftMaxConcurrentExpensiveCalls{
+      "thrift:max-concurrent-expensive-calls",
+      32,
+      this};
+
+  /**
+   * The steady rate at which a client process may call each expensive Thrift
+   * method. 0 is unbounded.
+   */
+  ConfigSetting<double> thriftExpensiveCallsPerSecond{
+      "thrift:expensive-calls-per-second",
+      0,
+      this};
+
+  /**
+   * The calls of each expensive Thrift method that a client process may make
+   * at once above thrift:expensive-calls-per-second.
+   */
+  ConfigSetting<double> thriftExpensiveCallBurst{
+      "thrift:expensive-call-burst",
+      100,
+      this};
+
   // [ssl]
 
   ConfigSetting<AbsolutePath> clientCertificate{
@@ -324,6 +364,101 @@ class EdenConfig : private ConfigSettingManager {
       20'000'000,
       this};
 
+  /*
+   * The following settings tune how the RocksDB local store opens its column
+   * families. They are only read when the store is opened.
+   */
+
+  /**
+   * Size in megabytes of the block cache shared by all column families other
+   * than blob. Blob data gets its own, smaller cache so that reading file
+   * contents does not evict the trees and metadata it was found through.
+   */
+  ConfigSetting<uint64_t> rocksDbBlockCacheSizeMB{
+      "store:rocksdb-block-cache-size-mb",
+      64,
+      this};
+
+  ConfigSetting<uint64_t> rocksDbBlobBlockCacheSizeMB{
+      "store:rocksdb-blob-block-cache-size-mb",
+      8,
+      this};
+
+  /**
+   * Compression used by the blob column family, and by all the others. One of
+   * "none", "snappy", "lz4" or "zstd"; empty uses RocksDB's default.
+   */
+  ConfigSetting<std::string> rocksDbBlobCompression{
+      "store:rocksdb-blob-compression",
+      "",
+      this};
+
+  ConfigSetting<std::string> rocksDbCompression{
+      "store:rocksdb-compression",
+      "",
+      this};
+
+  /**
+   * When non-zero, the blob column family trains a compression dictionary of
+   * up to this many bytes from each SST file it writes, which compresses
+   * small source files much better than compressing them one block at a
+   * time. It takes effect with "zstd" as store:rocksdb-blob-compression, and
+   * as files are rewritten by compactions.
+   */
+  ConfigSetting<uint32_t> rocksDbBlobCompressionDictionarySize{
+      "store:rocksdb-blob-compression-dictionary-size",
+      0,
+      this};
+
+  /**
+   * Whether to keep a bloom filter over the keys in each memtable, which
+   * saves searching the memtables on a miss.
+   */
+  ConfigSetting<bool> rocksDbMemtableBloomFilter{
+      "store:rocksdb-memtable-bloom-filter",
+      false,
+      this};
+
+  /**
+   * Whether to open the RocksDB local store in the background at startup, so
+   * that replaying a large write-ahead log doesn't hold back the mounts.
+   * Until it is open, the cached objects are fetched from the backing store.
+   */
+  ConfigSetting<bool> rocksDbOpenInBackground{
+      "store:rocksdb-open-in-background",
+      false,
+      this};
+
+  /**
+   * When non-zero, writes of ephemeral data, like imported trees and blobs,
+   * are queued and committed to RocksDB in one write batch this often, rather
+   * than each on its own. Persistent data is always written right away.
+   */
+  ConfigSetting<std::chrono::nanoseconds> rocksDbWriteBehindInterval{
+      "store:rocksdb-write-behind-interval",
+      std::chrono::nanoseconds{0},
+      this};
+
+  /**
+   * Bytes of queued writes that trigger a commit before the interval ends.
+   * Writers wait while this much is queued behind a slow commit.
+   */
+  ConfigSetting<uint64_t> rocksDbWriteBehindMaxBytes{
+      "store:rocksdb-write-behind-max-bytes",
+      64 * 1024 * 1024,
+      this};
+
+  /**
+   * When non-zero, lookups in ephemeral key spaces first check an in-memory
+   * filter of the stored keys, which answers most misses without reading
+   * RocksDB. Each filter is rebuilt from a scan of its key space this often,
+   * or sooner once it holds more keys than it was sized for.
+   */
+  ConfigSetting<std::chrono::nanoseconds> rocksDbNegativeLookupFilterInterval{
+      "store:rocksdb-negative-lookup-filter-interval",
+      std::chrono::nanoseconds{0},
+      this};
+
   ConfigSetting<bool> useEdenNativePrefetch{
       "store:use-eden-native-prefetch",
       false,
@@ -339,14 +474,25 @@ class EdenConfig : private ConfigSettingManager {
       this};
 
   /**
-   * If the number of fetching requests of a process reaches this number,
-   * a FetchHeavy event will be sent to Scuba.
+   * Each time the number of fetching requests of a process reaches a multiple
+   * of this number, a FetchHeavy event will be sent to Scuba.
    */
   ConfigSetting<uint32_t> fetchHeavyThreshold{
       "store:fetch-heavy-threshold",
       2000,
       this};
 
+  /**
+   * The fetches of a process are deprioritized by one step for each multiple
+   * of this cost its backing store fetches reached over the last minute, one
+   * unit per fetch plus one per MiB fetched, up to four steps. 0 disables
+   * deprioritization.
+   */
+  ConfigSetting<uint32_t> fetchHeavyRateThreshold{
+      "store:fetch-heavy-rate-threshold",
+      2000,
+      this};
+
   /**
    * The maximum number of tree prefetch operations to allow in parallel for any
    * checkout.  Setting this to 0 will disable prefetch operations.
@@ -356,6 +502,310 @@ class EdenConfig : private ConfigSettingManager {
       5,
       this};
 
+  /**
+   * Whether to learn which trees are loaded after which in each checkout,
+   * and fetch the trees expected to be loaded next at low priority.
+   * Speculative fetches share the store:max-tree-prefetches limit, counted
+   * separately from directory prefetches.
+   */
+  ConfigSetting<bool> speculativeTreePrefetch{
+      "store:speculative-tree-prefetch",
+      false,
+      this};
+
+  /**
+   * How many times a tree must have been loaded after another one before it
+   * is speculatively prefetched.
+   */
+  ConfigSetting<uint32_t> speculativeTreePrefetchMinCount{
+      "store:speculative-tree-prefetch-min-count",
+      2,
+      this};
+
+  /**
+   * The number of trees whose successors are remembered, per checkout. Only
+   * read when the checkout is mounted.
+   */
+  ConfigSetting<uint64_t> speculativeTreePrefetchModelSize{
+      "store:speculative-tree-prefetch-model-size",
+      100000,
+      this};
+
+  /**
+   * Whether to rank the directories of each checkout by how often and how
+   * recently they are loaded, and fetch the trees of the top ranked ones at
+   * low priority after every checkout. Profile fetches share the
+   * store:max-tree-prefetches limit, counted separately from the others.
+   */
+  ConfigSetting<bool> profilePrefetch{"store:profile-prefetch", false, this};
+
+  /**
+   * The number of top ranked directories prefetched after a checkout.
+   */
+  ConfigSetting<uint64_t> profilePrefetchCount{
+      "store:profile-prefetch-count",
+      1000,
+      this};
+
+  /**
+   * How long it takes for a directory load to count for half as much in the
+   * ranking of store:profile-prefetch. Only read when the checkout is
+   * mounted.
+   */
+  ConfigSetting<std::chrono::nanoseconds> profilePrefetchHalfLife{
+      "store:profile-prefetch-half-life",
+      std::chrono::hours(7 * 24),
+      this};
+
+  /**
+   * The number of directories ranked by store:profile-prefetch, per
+   * checkout. Only read when the checkout is mounted.
+   */
+  ConfigSetting<uint64_t> profilePrefetchModelSize{
+      "store:profile-prefetch-model-size",
+      100000,
+      this};
+
+  /**
+   * The total number of result paths kept in each checkout's cache of recent
+   * glob results. Globs are served from the cache when they were already
+   * evaluated against the same tree, or against the working copy with no
+   * change recorded in the journal since. 0 disables the cache. Only read
+   * when the checkout is mounted.
+   */
+  ConfigSetting<uint64_t> globResultCacheMaxPaths{
+      "store:glob-result-cache-max-paths",
+      1000000,
+      this};
+
+  /**
+   * The number of blobs matched by a prefetching glob that are fetched
+   * together. Batches are fetched as soon as they are full, while the glob
+   * is still walking the tree.
+   */
+  ConfigSetting<uint64_t> globPrefetchBatchSize{
+      "store:glob-prefetch-batch-size",
+      2048,
+      this};
+
+  /**
+   * The maximum number of batches of store:glob-prefetch-batch-size blobs
+   * that each prefetching glob fetches at a time.
+   */
+  ConfigSetting<uint64_t> globPrefetchMaxInFlightBatches{
+      "store:glob-prefetch-max-in-flight-batches",
+      8,
+      this};
+
+  /**
+   * The number of parsed .gitignore files kept in memory, so that status
+   * operations do not parse the same ignore files each time. The cache is
+   * shared by all the checkouts. 0 disables the cache. Only read at startup.
+   */
+  ConfigSetting<uint64_t> gitIgnoreCacheSize{
+      "store:gitignore-cache-size",
+      4096,
+      this};
+
+  /**
+   * The maximum number of directory comparisons of a single status
+   * operation that are queued or running on the server thread pool at once.
+   * Beyond that, directories are compared inline. 0 compares every
+   * directory on the thread that reached it.
+   */
+  ConfigSetting<uint64_t> maxParallelDiffs{
+      "store:max-parallel-diffs",
+      8,
+      this};
+
+  /**
+   * Whether status results are cached per commit and brought up to date by
+   * re-checking only the paths recorded in the journal since, instead of
+   * diffing the whole working copy on every call.
+   */
+  ConfigSetting<bool> incrementalStatus{
+      "store:incremental-status",
+      false,
+      this};
+
+  /**
+   * The number of directory pairs, and of file pairs, whose objects are
+   * requested together when diffing two commits. This bounds the number of
+   * trees held in memory by each such diff.
+   */
+  ConfigSetting<uint64_t> commitDiffBatchSize{
+      "store:commit-diff-batch-size",
+      1024,
+      this};
+
+  /**
+   * The maximum number of directory updates of a single checkout that are
+   * queued or running on the server thread pool at once. Beyond that,
+   * directories are updated inline. 0 updates every directory on the thread
+   * that reached it.
+   */
+  ConfigSetting<uint64_t> maxParallelCheckoutActions{
+      "store:max-parallel-checkout-actions",
+      8,
+      this};
+
+  /**
+   * The number of directories whose trees a checkout fetches together ahead
+   * of updating them. 0 disables fetching ahead, in which case the trees of
+   * a directory are only fetched once its parent has been updated.
+   */
+  ConfigSetting<uint64_t> checkoutTreePrefetchBatchSize{
+      "store:checkout-tree-prefetch-batch-size",
+      1024,
+      this};
+
+  /**
+   * The estimated memory, in bytes, of the trees that a single diff or
+   * checkout keeps referenced until it completes, so that the trees it
+   * requests several times are only fetched once, even if the tree cache
+   * evicted them in between. 0 disables pinning trees.
+   */
+  ConfigSetting<size_t> operationTreePinBudget{
+      "store:operation-tree-pin-budget",
+      64 * 1024 * 1024,
+      this};
+
+  // [inodes]
+
+  /**
+   * An approximate bound, in bytes, on the memory used by the loaded inodes
+   * of all mounts. When it is exceeded, inodes that have not been looked up
+   * recently are unloaded until the estimate falls back under it. 0 disables
+   * the bound.
+   */
+  ConfigSetting<uint64_t> inodeMemoryBudget{"inodes:memory-budget", 0, this};
+
+  /**
+   * How often the memory used by loaded inodes is checked against
+   * inodes:memory-budget.
+   */
+  ConfigSetting<std::chrono::nanoseconds> inodeMemoryBudgetCheckInterval{
+      "inodes:memory-budget-check-interval",
+      std::chrono::minutes(1),
+      this};
+
+  // [memory]
+
+  /**
+   * How often the memory pressure of the machine, and of the cgroup EdenFS
+   * runs in, is checked. When memory is under pressure, the caches and the
+   * inodes listed in memory:shrink-order are shrunk. 0 disables the check.
+   * Pressure is currently only detected on Linux.
+   */
+  ConfigSetting<std::chrono::nanoseconds> memoryPressureCheckInterval{
+      "memory:pressure-check-interval",
+      std::chrono::nanoseconds{0},
+      this};
+
+  /**
+   * Memory is under pressure when tasks were stalled waiting for memory for
+   * more than this percentage of the last 10 seconds, according to
+   * /proc/pressure/memory.
+   */
+  ConfigSetting<double> memoryPressureStallThreshold{
+      "memory:pressure-stall-threshold",
+      10.0,
+      this};
+
+  /**
+   * Memory is under pressure when the cgroup EdenFS runs in uses more than
+   * this fraction of its memory limit.
+   */
+  ConfigSetting<double> memoryPressureCgroupThreshold{
+      "memory:pressure-cgroup-threshold",
+      0.9,
+      this};
+
+  /**
+   * The fraction of the memory used by the shrinkable consumers that is
+   * freed each time memory is found under pressure.
+   */
+  ConfigSetting<double> memoryPressureShrinkFraction{
+      "memory:pressure-shrink-fraction",
+      0.25,
+      this};
+
+  /**
+   * The memory consumers to shrink under memory pressure, in order. The next
+   * one is only shrunk if the previous ones didn't free enough. Valid names
+   * are "blob-cache", "tree-cache" and "inodes".
+   */
+  ConfigSetting<std::vector<std::string>> memoryShrinkOrder{
+      "memory:shrink-order",
+      std::vector<std::string>{"blob-cache", "tree-cache", "inodes"},
+      this};
+
+  // [maintenance]
+
+  /**
+   * How long local store management, backing store refreshes and inode
+   * unloading may be held back while the foreground is busy. Once they have
+   * waited for this long they run regardless. 0 disables deferral, and the
+   * load is then not sampled.
+   */
+  ConfigSetting<std::chrono::nanoseconds> maintenanceMaxDeferral{
+      "maintenance:max-deferral",
+      std::chrono::minutes(5),
+      this};
+
+  /**
+   * The foreground is busy while the average number of FUSE and NFS requests
+   * in flight on all mounts is above this.
+   */
+  ConfigSetting<double> maintenanceBusyFsRequests{
+      "maintenance:busy-fs-requests",
+      8,
+      this};
+
+  /**
+   * The foreground is busy while the average number of imports waiting in
+   * the queues of the backing stores is above this.
+   */
+  ConfigSetting<double> maintenanceBusyPendingImports{
+      "maintenance:busy-pending-imports",
+      32,
+      this};
+
+  // [journal]
+
+  /**
+   * Whether each checkout's journal is saved when it is unmounted, including
+   * during graceful restart, and restored when it is mounted again. A
+   * restored journal keeps its mount generation and sequence numbers, so
+   * clients can continue their journal queries instead of recrawling. Only
+   * read when the checkout is mounted and unmounted.
+   */
+  ConfigSetting<bool> persistJournal{"journal:persist", false, this};
+
+  /**
+   * The minimum time between two notifications sent to a journal
+   * subscription stream, such as watchman's. Changes recorded sooner are
+   * reported together once the interval has passed, while the first change
+   * after an idle period is reported right away. 0 sends a notification for
+   * every change the subscriber has not been told about yet. Only read when
+   * the subscription is created.
+   */
+  ConfigSetting<std::chrono::nanoseconds> journalSubscriberMinInterval{
+      "journal:subscriber-min-interval",
+      std::chrono::nanoseconds{0},
+      this};
+
+  /**
+   * How often the journals fold the changes recorded before the previous
+   * compaction into one delta per path between two commit transitions. This
+   * lets a journal remember a much longer history within its memory limit
+   * when the same files keep being rewritten. 0 disables the compaction.
+   */
+  ConfigSetting<std::chrono::nanoseconds> journalCompactionInterval{
+      "journal:compaction-interval",
+      std::chrono::minutes(5),
+      this};
+
   // [fuse]
 
   /**
@@ -370,6 +820,105 @@ class EdenConfig : private ConfigSettingManager {
       1000,
       this};
 
+  /**
+   * Whether large read replies for materialized files are spliced from the
+   * overlay file to the FUSE device instead of being copied through EdenFS.
+   *
+   * Takes effect for new mounts.
+   */
+  ConfigSetting<bool> fuseSpliceReadReplies{
+      "fuse:splice-read-replies",
+      false,
+      this};
+
+  /**
+   * Whether the kernel is asked to use FUSE_READDIRPLUS, which returns the
+   * attributes of directory entries along with their names. This saves a
+   * lookup per entry when a directory is listed with `ls -l` or walked by a
+   * build tool, at the cost of loading the inodes of every entry listed.
+   *
+   * Takes effect for new mounts.
+   */
+  ConfigSetting<bool> fuseReaddirPlus{"fuse:readdirplus", false, this};
+
+  /**
+   * Whether the kernel may cache writes to files in the page cache and send
+   * them to EdenFS later, in large chunks, instead of sending each write(2)
+   * through EdenFS as it happens. This makes many small writes, such as those
+   * of build outputs, close to native speed.
+   *
+   * The kernel then owns the size and modification time of files it has
+   * buffered writes for, and writes are only seen by EdenFS once they are
+   * flushed: a checkout racing with writes that have not been flushed yet may
+   * be overwritten by them.
+   *
+   * Takes effect for new mounts.
+   */
+  ConfigSetting<bool> fuseWritebackCache{"fuse:writeback-cache", false, this};
+
+  /**
+   * Whether the objects fetched by FUSE reads are imported at a lower
+   * priority than those fetched by other FUSE requests. A burst of reads of
+   * unfetched files then doesn't delay the lookups, getattrs and readdirs
+   * issued alongside them, which are usually cheap once their trees are
+   * fetched. Aging in the import queue still bounds how long reads wait.
+   *
+   * Takes effect for new mounts.
+   */
+  ConfigSetting<bool> fusePrioritizeMetadataRequests{
+      "fuse:prioritize-metadata-requests",
+      false,
+      this};
+
+  /**
+   * How long the kernel may cache the attributes and directory entries of
+   * materialized inodes. Unmaterialized inodes only change on checkout, which
+   * invalidates them in the kernel, so they are cached for as long as
+   * possible. Materialized inodes are only modified through the mount as
+   * well, so this defaults to the same; lower it if the overlay may be
+   * modified behind EdenFS's back, at the cost of more getattr and lookup
+   * requests for the files being worked on.
+   *
+   * Takes effect for new mounts.
+   */
+  ConfigSetting<std::chrono::nanoseconds> fuseMaterializedAttrTimeout{
+      "fuse:materialized-attr-timeout",
+      std::chrono::seconds{std::numeric_limits<int32_t>::max()},
+      this};
+
+  /**
+   * Whether FUSE open() and release() are handled so that the blob of a file
+   * stays in memory while it is open, even if the blob cache evicts it. This
+   * avoids fetching a blob repeatedly while it is read in small chunks, at
+   * the cost of a round trip to EdenFS on every open and close.
+   *
+   * Takes effect for new mounts.
+   */
+  ConfigSetting<bool> fusePinBlobsWhileOpen{
+      "fuse:pin-blobs-while-open",
+      false,
+      this};
+
+  /**
+   * Whether FUSE worker threads use io_uring to read requests and batch
+   * replies instead of blocking read() and writev() calls. Falls back to the
+   * latter if the kernel does not support io_uring.
+   *
+   * Takes effect for new mounts.
+   */
+  ConfigSetting<bool> fuseUseIoUring{"fuse:use-io-uring", false, this};
+
+  /**
+   * Where the FUSE worker threads of a mount run: "none", "pin",
+   * "node-local" or "spread". See CpuAffinityPolicy.
+   *
+   * Takes effect for new mounts.
+   */
+  ConfigSetting<CpuAffinityPolicy> fuseWorkerAffinity{
+      "fuse:worker-affinity",
+      CpuAffinityPolicy::None,
+      this};
+
   /**
    * The maximum time duration allowed for a fuse request. If a request exceeds
    * this amount of time, an ETIMEDOUT error will be returned to the kernel to
@@ -428,6 +977,15 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<uint64_t> numNfsThreads{"nfs:num-servicing-threads", 8, this};
 
+  /**
+   * Where the threads that service the NFS requests run. See
+   * fuse:worker-affinity. Only read at startup.
+   */
+  ConfigSetting<CpuAffinityPolicy> nfsThreadAffinity{
+      "nfs:servicing-thread-affinity",
+      CpuAffinityPolicy::None,
+      this};
+
   /**
    * Maximum number of pending NFS requests. If more requests are inflight, the
    * NFS code will block.
@@ -437,6 +995,16 @@ class EdenConfig : private ConfigSettingManager {
       1000,
       this};
 
+  /**
+   * Maximum number of NFS requests in flight on a single connection. Once
+   * reached, no more requests are read from that connection until one
+   * completes, which keeps one mount from filling the request queue above.
+   */
+  ConfigSetting<uint64_t> maxNfsInflightRequestsPerConnection{
+      "nfs:max-inflight-requests-per-connection",
+      256,
+      this};
+
   /**
    * Buffer size for read and writes requests. Default to 1 MiB.
    */
@@ -469,6 +1037,30 @@ class EdenConfig : private ConfigSettingManager {
       std::chrono::seconds{10},
       this};
 
+  /**
+   * Whether NFS mounts should let the client use READDIRPLUS, which returns
+   * the attributes of all the entries along with the directory listing. This
+   * avoids a GETATTR per entry for `ls -l` and Finder on large directories.
+   */
+  ConfigSetting<bool> nfsUseReaddirplus{"nfs:use-readdirplus", false, this};
+
+  /**
+   * Number of inodes whose attributes are cached to answer GETATTR without
+   * looking the inode up. The macOS client sends a GETATTR on every open.
+   * 0 disables the cache. Takes effect for new mounts.
+   */
+  ConfigSetting<uint64_t> nfsAttrCacheSize{"nfs:attr-cache-size", 0, this};
+
+  /**
+   * Maximum memory, in bytes, held by the listings of the directories that
+   * NFS clients page through with READDIR. Without one, each page lists the
+   * directory again. 0 disables the cache. Takes effect for new mounts.
+   */
+  ConfigSetting<size_t> nfsReaddirSnapshotCacheSize{
+      "nfs:readdir-snapshot-cache-size",
+      32 * 1024 * 1024,
+      this};
+
   // [prjfs]
 
   /**
@@ -492,6 +1084,28 @@ class EdenConfig : private ConfigSettingManager {
       true,
       this};
 
+  /**
+   * The number of directories whose entries are kept in memory after being
+   * enumerated, so that enumerating them again does not need to recompute
+   * them. Only directories that are not materialized are cached.
+   * Only applicable on Windows
+   */
+  ConfigSetting<size_t> prjfsDirEntriesCacheSize{
+      "prjfs:dir-entries-cache-size",
+      4096,
+      this};
+
+  /**
+   * The number of threads removing files cached by ProjectedFS during
+   * checkout. Each removal is a round trip to the kernel, and the ones of a
+   * directory are issued concurrently. 0 or 1 removes them one at a time.
+   * Only applicable on Windows
+   */
+  ConfigSetting<size_t> prjfsInvalidationThreads{
+      "prjfs:invalidation-threads",
+      8,
+      this};
+
   // [hg]
 
   /**
@@ -506,6 +1120,17 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<bool> directObjectId{"hg:use-direct-object-id", false, this};
 
+  /**
+   * If this config is set, embed both the HgId and the path into ObjectId, so
+   * that importing objects neither reads nor writes proxy hashes. ObjectIds
+   * previously imported with proxy hashes keep working. Takes precedence over
+   * hg:use-direct-object-id.
+   */
+  ConfigSetting<bool> directObjectIdWithPath{
+      "hg:use-direct-object-id-with-path",
+      false,
+      this};
+
   /**
    * Controls the number of blob or prefetch import requests we batch in
    * HgBackingStore
@@ -520,6 +1145,69 @@ class EdenConfig : private ConfigSettingManager {
       1,
       this};
 
+  /**
+   * When enabled, a batch of tree imports may carry a batch of blob imports
+   * along, and vice versa, so that both are fetched in one backing store
+   * round trip.
+   */
+  ConfigSetting<bool> importBatchMixed{"hg:import-batch-mixed", false, this};
+
+  /**
+   * When enabled, the blob and tree import batch sizes adapt to the depth of
+   * the import queue and to the latency of previous batches. The
+   * import-batch-size* settings are then used as the minimum batch sizes.
+   */
+  ConfigSetting<bool> importBatchAdaptive{
+      "hg:import-batch-adaptive",
+      false,
+      this};
+
+  /**
+   * Upper bound for adaptive blob import batches.
+   */
+  ConfigSetting<uint32_t> importBatchSizeMax{
+      "hg:import-batch-size-max",
+      256,
+      this};
+
+  /**
+   * Upper bound for adaptive tree import batches.
+   */
+  ConfigSetting<uint32_t> importBatchSizeTreeMax{
+      "hg:import-batch-size-tree-max",
+      64,
+      this};
+
+  /**
+   * Adaptive batches shrink when a batch takes longer than this to import,
+   * and grow while full batches complete faster.
+   */
+  ConfigSetting<std::chrono::nanoseconds> importBatchTargetLatency{
+      "hg:import-batch-target-latency",
+      std::chrono::milliseconds{500},
+      this};
+
+  /**
+   * Import requests of a priority kind that has not been served for this long
+   * are scheduled as if they were one kind higher, for every interval waited.
+   * This prevents low priority imports from being starved. Zero disables
+   * aging.
+   */
+  ConfigSetting<std::chrono::nanoseconds> importQueueAgingInterval{
+      "hg:import-queue-aging-interval",
+      std::chrono::seconds{1},
+      this};
+
+  /**
+   * When enabled, tree imports also import the size and SHA-1 of the files
+   * in the trees, so that stat and SHA-1 queries on these files don't need
+   * to import their content.
+   */
+  ConfigSetting<bool> importTreeAuxData{
+      "hg:import-tree-aux-data",
+      false,
+      this};
+
   // [backingstore]
 
   /**
@@ -530,6 +1218,46 @@ class EdenConfig : private ConfigSettingManager {
       32,
       this};
 
+  /**
+   * Where the threads that pull backingstore requests off the queue run. See
+   * fuse:worker-affinity. Takes effect for new backing stores.
+   */
+  ConfigSetting<CpuAffinityPolicy> backingstoreThreadAffinity{
+      "backingstore:servicing-thread-affinity",
+      CpuAffinityPolicy::None,
+      this};
+
+  /**
+   * The number of import batches that may be in flight in the backing store
+   * at once. When non-zero, the servicing threads hand the batches they
+   * dequeue to a pool of this many threads and go back to the queue, instead
+   * of waiting for each batch to complete. 0 imports each batch on the
+   * servicing thread that dequeued it. Takes effect for new backing stores.
+   */
+  ConfigSetting<uint32_t> maxInFlightImportBatches{
+      "backingstore:max-inflight-batches",
+      0,
+      this};
+
+  /**
+   * The number of import requests that may be in flight in the backing store
+   * at once, over all the batches. 0 is unbounded.
+   */
+  ConfigSetting<uint64_t> maxInFlightImportRequests{
+      "backingstore:max-inflight-requests",
+      4096,
+      this};
+
+  /**
+   * The bytes that the blobs in flight in the backing store may add up to,
+   * estimated from the average size of the blobs imported so far. 0 is
+   * unbounded.
+   */
+  ConfigSetting<uint64_t> maxInFlightImportBytes{
+      "backingstore:max-inflight-bytes",
+      512 * 1024 * 1024,
+      this};
+
   // [telemetry]
 
   /**
@@ -619,6 +1347,26 @@ class EdenConfig : private ConfigSettingManager {
       false,
       this};
 
+  /**
+   * Controls whether EdenFS stores and keeps in memory the blobs with
+   * identical contents once, keyed by the SHA-1 of their contents, rather
+   * than once per blob ID.
+   */
+  ConfigSetting<bool> enableBlobDeduplication{
+      "experimental:enable-blob-deduplication",
+      false,
+      this};
+
+  /**
+   * Controls whether EdenFS stores trees in the local store as PackedTree,
+   * whose entries are read back without parsing, rather than as git tree
+   * objects. Trees stored in either format can always be read.
+   */
+  ConfigSetting<bool> enablePackedTrees{
+      "experimental:enable-packed-trees",
+      false,
+      this};
+
   /**
    * Controls whether EdenFS uses EdenApi to import data from remote.
    */
@@ -659,6 +1407,120 @@ class EdenConfig : private ConfigSettingManager {
       16,
       this};
 
+  /**
+   * Number of independently locked shards the tree cache is split into. The
+   * cache size and minimum element count are divided evenly between shards.
+   */
+  ConfigSetting<size_t> inMemoryTreeCacheShards{
+      "treecache:num-shards",
+      1,
+      this};
+
+  /**
+   * Number of independently locked shards the in-memory blob metadata cache
+   * of each ObjectStore is split into. The entries are divided evenly between
+   * shards.
+   */
+  ConfigSetting<size_t> blobMetadataCacheShards{
+      "store:metadata-cache-shards",
+      16,
+      this};
+
+  /**
+   * Eviction policy of the tree cache. One of "LRU", "SLRU" or "TinyLFU".
+   */
+  ConfigSetting<CacheEvictionPolicy> inMemoryTreeCacheEvictionPolicy{
+      "treecache:eviction-policy",
+      CacheEvictionPolicy::LRU,
+      this};
+
+  /**
+   * Controls whether the contents of the tree cache are saved to disk at
+   * shutdown and memory-mapped as a second cache tier at startup.
+   */
+  ConfigSetting<bool> enablePersistentTreeCache{
+      "treecache:enable-persistent-cache",
+      false,
+      this};
+
+  /**
+   * Number of tree cache accesses to record, see blobcache:trace-capacity.
+   * The trace is written to storage/tree-cache-trace at shutdown.
+   */
+  ConfigSetting<size_t> inMemoryTreeCacheTraceCapacity{
+      "treecache:trace-capacity",
+      0,
+      this};
+
+  /**
+   * Controls whether the contents of the blob cache are handed to the new
+   * process during a graceful restart, so that it starts with a warm cache.
+   * Both processes must enable it.
+   */
+  ConfigSetting<bool> enableTakeoverCacheHandoff{
+      "takeover:enable-cache-handoff",
+      false,
+      this};
+
+  /**
+   * The most blob bytes handed to the new process during a graceful restart,
+   * most recently used first.
+   */
+  ConfigSetting<uint64_t> takeoverCacheHandoffMaxBytes{
+      "takeover:cache-handoff-max-bytes",
+      1024 * 1024 * 1024,
+      this};
+
+  // [blobcache]
+
+  /**
+   * Eviction policy of the blob cache. One of "LRU", "SLRU" or "TinyLFU".
+   */
+  ConfigSetting<CacheEvictionPolicy> blobCacheEvictionPolicy{
+      "blobcache:eviction-policy",
+      CacheEvictionPolicy::LRU,
+      this};
+
+  /**
+   * Blobs larger than this many bytes are not inserted in the blob cache, but
+   * in a separate large blob tier of blobcache:large-blob-cache-size bytes.
+   * 0 admits blobs of any size in the blob cache.
+   */
+  ConfigSetting<size_t> blobCacheLargeBlobThreshold{
+      "blobcache:large-blob-threshold",
+      0,
+      this};
+
+  /**
+   * Number of bytes worth of large blobs to keep in memory, see
+   * blobcache:large-blob-threshold. The most recently used large blob is
+   * always kept. 0 disables caching of large blobs.
+   */
+  ConfigSetting<size_t> blobCacheLargeBlobCacheSize{
+      "blobcache:large-blob-cache-size",
+      0,
+      this};
+
+  /**
+   * Number of bytes worth of LZ4-compressed blobs to keep in memory once they
+   * are evicted from the blob cache. 0 disables the compressed tier.
+   */
+  ConfigSetting<size_t> blobCacheCompressedCacheSize{
+      "blobcache:compressed-cache-size",
+      0,
+      this};
+
+  /**
+   * Number of the most recent blob cache hits, misses and inserts to record,
+   * 24 bytes each, for replay by the object_cache_replay benchmark. The trace
+   * is written to storage/blob-cache-trace at shutdown. 0 disables tracing.
+   * Only read at startup.
+   */
+  ConfigSetting<size_t> blobCacheTraceCapacity{
+      "blobcache:trace-capacity",
+      0,
+      this};
+
   // [notifications]
 
   /**
@@ -762,6 +1624,18 @@ class EdenConfig : private ConfigSettingManager {
       false,
       this};
 
+  /**
+   * When non-zero, and the tree overlay is enabled, the directories of the
+   * overlay are kept in memory and written to disk at this interval, when the
+   * checkout is unmounted, and on graceful restart. Changes made since the
+   * last checkpoint are lost if EdenFS crashes, which suits disposable
+   * checkouts like those of CI jobs. Takes effect on the next mount.
+   */
+  ConfigSetting<std::chrono::nanoseconds> overlayCheckpointInterval{
+      "overlay:checkpoint-interval",
+      std::chrono::nanoseconds{0},
+      this};
+
   /**
    * The synchronous mode used when using tree overlay. Currently it only
    * supports "off" or "normal". Setting this to off may cause data loss.
@@ -771,6 +1645,58 @@ class EdenConfig : private ConfigSettingManager {
       "normal",
       this};
 
+  /**
+   * How long the tree overlay may buffer a directory write in memory so that
+   * it can be committed in the same transaction as others. Buffered writes
+   * are lost if EdenFS crashes before committing them. 0 commits every write
+   * immediately.
+   */
+  ConfigSetting<std::chrono::nanoseconds> overlayBufferedWriteMaxDelay{
+      "overlay:buffered-write-max-delay",
+      std::chrono::milliseconds(0),
+      this};
+
+  /**
+   * The number of buffered tree overlay writes that are committed without
+   * waiting for overlay:buffered-write-max-delay.
+   */
+  ConfigSetting<uint64_t> overlayBufferedWriteMaxPending{
+      "overlay:buffered-write-max-pending",
+      1024,
+      this};
+
+  /**
+   * The number of threads of each mount that remove the overlay data of
+   * removed directory trees, each handling one directory at a time. Takes
+   * effect the next time the mount is mounted.
+   */
+  ConfigSetting<uint64_t> overlayGCThreadCount{
+      "overlay:gc-thread-count",
+      4,
+      this};
+
+  /**
+   * When non-zero, the large blobs materialized in a checkout are also kept in
+   * files next to its overlay, up to this many bytes, and the overlay files
+   * of the inodes materialized from them afterwards are created as
+   * copy-on-write clones of these files. Only useful on filesystems that
+   * support cloning files (btrfs, XFS, APFS); the store disables itself
+   * elsewhere.
+   */
+  ConfigSetting<uint64_t> overlayBlobFileStoreSize{
+      "overlay:blob-file-store-size",
+      0,
+      this};
+
+  /**
+   * The size, in bytes, below which blobs are written to the overlay instead
+   * of being kept in the blob file store.
+   */
+  ConfigSetting<uint64_t> overlayBlobFileMinSize{
+      "overlay:blob-file-min-size",
+      1024 * 1024,
+      this};
+
   // [clone]
 
   /**
@@ -148,4 +148,52 @@ std::string FieldConverter<MountProtocol>::toDebugString(
   return mountProtocolStr[folly::to_underlying(value)].str();
 }
 
+namespace {
+
+constexpr auto cacheEvictionPolicyStr = [] {
+  std::array<folly::StringPiece, 3> mapping{};
+  mapping[folly::to_underlying(CacheEvictionPolicy::LRU)] = "LRU";
+  mapping[folly::to_underlying(CacheEvictionPolicy::SLRU)] = "SLRU";
+  mapping[folly::to_underlying(CacheEvictionPolicy::TinyLFU)] = "TinyLFU";
+  return mapping;
+}();
+
+}
+
+folly::Expected<CacheEvictionPolicy, std::string>
+FieldConverter<CacheEvictionPolicy>::fromString(
+    folly::StringPiece value,
+    const std::map<std::string, std::string>& /*unused*/) const {
+  for (auto policy = 0ul; policy < cacheEvictionPolicyStr.size(); policy++) {
+    if (value.equals(
+            cacheEvictionPolicyStr[policy], folly::AsciiCaseInsensitive())) {
+      return static_cast<CacheEvictionPolicy>(policy);
+    }
+  }
+
+  return folly::makeUnexpected(fmt::format(
+      "Failed to convert value '{}' to a CacheEvictionPolicy.", value));
+}
+
+std::string FieldConverter<CacheEvictionPolicy>::toDebugString(
+    CacheEvictionPolicy value) const {
+  return cacheEvictionPolicyStr[folly::to_underlying(value)].str();
+}
+
+folly::Expected<CpuAffinityPolicy, std::string>
+FieldConverter<CpuAffinityPolicy>::fromString(
+    folly::StringPiece value,
+    const std::map<std::string, std::string>& /*unused*/) const {
+  if (auto policy = parseCpuAffinityPolicy(value)) {
+    return *policy;
+  }
+  return folly::makeUnexpected(fmt::format(
+      "Failed to convert value '{}' to a CpuAffinityPolicy.", value));
+}
+
+std::string FieldConverter<CpuAffinityPolicy>::toDebugString(
+    CpuAffinityPolicy value) const {
+  return toString(value).str();
+}
+
 } // namespace facebook::eden
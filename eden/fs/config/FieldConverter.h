@@ -21,7 +21,9 @@
 #include <folly/Range.h>
 #include <folly/String.h>
 
+#include "eden/fs/config/CacheEvictionPolicy.h"
 #include "eden/fs/config/MountProtocol.h"
+#include "eden/fs/utils/CpuAffinity.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
@@ -205,4 +207,24 @@ class FieldConverter<MountProtocol> {
   std::string toDebugString(MountProtocol value) const;
 };
 
+template <>
+class FieldConverter<CacheEvictionPolicy> {
+ public:
+  folly::Expected<CacheEvictionPolicy, std::string> fromString(
+      folly::StringPiece value,
+      const std::map<std::string, std::string>& convData) const;
+
+  std::string toDebugString(CacheEvictionPolicy value) const;
+};
+
+template <>
+class FieldConverter<CpuAffinityPolicy> {
+ public:
+  folly::Expected<CpuAffinityPolicy, std::string> fromString(
+      folly::StringPiece value,
+      const std::map<std::string, std::string>& convData) const;
+
+  std::string toDebugString(CpuAffinityPolicy value) const;
+};
+
 } // namespace facebook::eden
@@ -11,6 +11,7 @@
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/EnumValue.h"
 
+#include <folly/chrono/Clock.h>
 #include <folly/logging/xlog.h>
 
 namespace {
@@ -22,18 +23,17 @@ constexpr std::chrono::seconds kEdenConfigMinimumPollDuration{5};
 namespace facebook::eden {
 
 ReloadableConfig::ReloadableConfig(std::shared_ptr<const EdenConfig> config)
-    : state_{ConfigState{config}} {}
+    : config_{*folly::rcu_default_domain(), std::move(config)} {}
 ReloadableConfig::ReloadableConfig(
     std::shared_ptr<const EdenConfig> config,
     ConfigReloadBehavior reloadBehavior)
-    : state_{ConfigState{config}}, reloadBehavior_{reloadBehavior} {}
+    : config_{*folly::rcu_default_domain(), std::move(config)},
+      reloadBehavior_{reloadBehavior} {}
 
 ReloadableConfig::~ReloadableConfig() {}
 
 std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
     ConfigReloadBehavior reload) {
-  auto now = std::chrono::steady_clock::now();
-
   // TODO: Update this monitoring code to use FileChangeMonitor.
   bool shouldReload;
   if (reloadBehavior_.has_value()) {
@@ -47,8 +47,11 @@ std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
       shouldReload = true;
       break;
     case ConfigReloadBehavior::AutoReload: {
-      auto lastCheck = std::chrono::steady_clock::time_point{
-          std::chrono::steady_clock::duration{
+      // The coarse clock is read from the vDSO without a hardware timer read,
+      // and is more than precise enough for a throttle in seconds.
+      auto now = folly::chrono::coarse_steady_clock::now();
+      auto lastCheck = folly::chrono::coarse_steady_clock::time_point{
+          folly::chrono::coarse_steady_clock::duration{
               lastCheck_.load(std::memory_order_acquire)}};
       shouldReload = now - lastCheck >= kEdenConfigMinimumPollDuration;
       break;
@@ -58,15 +61,22 @@ std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
   }
 
   if (!shouldReload) {
-    return state_.rlock()->config;
+    return *config_.rlock();
   }
+  return reloadIfChanged();
+}
 
-  auto state = state_.wlock();
+std::shared_ptr<const EdenConfig> ReloadableConfig::reloadIfChanged() {
+  std::lock_guard<std::mutex> guard{reloadMutex_};
 
   // Throttle the updates when using ConfigReloadBehavior::AutoReload
-  lastCheck_.store(now.time_since_epoch().count(), std::memory_order_release);
+  lastCheck_.store(
+      folly::chrono::coarse_steady_clock::now().time_since_epoch().count(),
+      std::memory_order_release);
 
-  auto& config = state->config;
+  // Only reloads replace the published config, and they are serialized by
+  // reloadMutex_.
+  auto config = *config_.rlock();
 
   auto userConfigChanged = config->hasUserConfigFileChanged();
   auto systemConfigChanged = config->hasSystemConfigFileChanged();
@@ -82,9 +92,10 @@ std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
                  << systemConfigChanged.str();
       newConfig->loadSystemConfig();
     }
-    state->config = std::move(newConfig);
+    config = std::move(newConfig);
+    config_.update(config);
   }
-  return state->config;
+  return config;
 }
 
 } // namespace facebook::eden
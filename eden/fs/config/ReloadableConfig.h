@@ -7,12 +7,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <memory>
-
-#include <folly/Synchronized.h>
+#include <mutex>
+#include <optional>
 
 #include "eden/fs/config/gen-cpp2/eden_config_types.h"
+#include "eden/fs/utils/Rcu.h"
 
 namespace facebook::eden {
 
@@ -21,6 +23,11 @@ class EdenConfig;
 /**
  * An interface that defines how to obtain a possibly reloaded EdenConfig
  * instance.
+ *
+ * getEdenConfig() is called for nearly every request, so the current config
+ * is published through an RcuPtr: reading it takes no lock, and
+ * AutoReload's throttling only reads a coarse clock. Reloads are serialized
+ * by a mutex that readers never take.
  */
 class ReloadableConfig {
  public:
@@ -40,14 +47,16 @@ class ReloadableConfig {
       ConfigReloadBehavior reload = ConfigReloadBehavior::AutoReload);
 
  private:
-  struct ConfigState {
-    explicit ConfigState(const std::shared_ptr<const EdenConfig>& config)
-        : config{config} {}
-    std::shared_ptr<const EdenConfig> config;
-  };
-
-  folly::Synchronized<ConfigState> state_;
-  std::atomic<std::chrono::steady_clock::time_point::rep> lastCheck_{};
+  /**
+   * Reloads the config files that changed on disk, publishes the resulting
+   * config, and returns it.
+   */
+  std::shared_ptr<const EdenConfig> reloadIfChanged();
+
+  RcuPtr<std::shared_ptr<const EdenConfig>> config_;
+  std::mutex reloadMutex_;
+  // In folly::chrono::coarse_steady_clock ticks.
+  std::atomic<int64_t> lastCheck_{};
 
   // Reload behavior, when set this overrides reload behavior passed to methods
   // This is used in tests where we want to set the manually set the EdenConfig
@@ -11,13 +11,16 @@
 
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/utils/FsChannelTypes.h"
+#include "eden/fs/utils/IOBufPool.h"
 
 using folly::StringPiece;
 
 namespace facebook::eden {
 
 FuseDirList::FuseDirList(size_t maxSize)
-    : buf_(new char[maxSize]), end_(buf_.get() + maxSize), cur_(buf_.get()) {}
+    : buf_(IOBufPool::getReplyPool().allocate(maxSize)),
+      end_(bufStart() + maxSize),
+      cur_(bufStart()) {}
 
 bool FuseDirList::add(StringPiece name, ino_t inode, dtype_t type, off_t off) {
   const size_t avail = end_ - cur_;
@@ -44,13 +47,13 @@ bool FuseDirList::add(StringPiece name, ino_t inode, dtype_t type, off_t off) {
 }
 
 StringPiece FuseDirList::getBuf() const {
-  return StringPiece(buf_.get(), cur_ - buf_.get());
+  return StringPiece(bufStart(), cur_ - bufStart());
 }
 
 std::vector<FuseDirList::ExtractedEntry> FuseDirList::extract() const {
   std::vector<FuseDirList::ExtractedEntry> result;
 
-  char* p = buf_.get();
+  char* p = bufStart();
   while (p != cur_) {
     auto entry = reinterpret_cast<fuse_dirent*>(p);
     result.emplace_back(ExtractedEntry{
@@ -64,6 +67,78 @@ std::vector<FuseDirList::ExtractedEntry> FuseDirList::extract() const {
   return result;
 }
 
+#ifdef __linux__
+FuseDirPlusList::FuseDirPlusList(size_t maxSize)
+    : buf_(IOBufPool::getReplyPool().allocate(maxSize)),
+      end_(bufStart() + maxSize),
+      cur_(bufStart()) {}
+
+bool FuseDirPlusList::add(
+    StringPiece name,
+    ino_t inode,
+    dtype_t type,
+    off_t off) {
+  const size_t avail = end_ - cur_;
+  const auto entLength = FUSE_NAME_OFFSET_DIRENTPLUS + name.size();
+  const auto fullSize = FUSE_DIRENT_ALIGN(entLength);
+  if (fullSize > avail) {
+    return false;
+  }
+
+  fuse_direntplus* const direntplus = reinterpret_cast<fuse_direntplus*>(cur_);
+  memset(&direntplus->entry_out, 0, sizeof(direntplus->entry_out));
+  auto& dirent = direntplus->dirent;
+  dirent.ino = inode;
+  dirent.off = off;
+  dirent.namelen = name.size();
+  dirent.type = static_cast<decltype(dirent.type)>(type);
+  memcpy(dirent.name, name.data(), name.size());
+  if (fullSize > entLength) {
+    // 0 out any padding
+    memset(cur_ + entLength, 0, fullSize - entLength);
+  }
+
+  entries_.push_back(cur_ - bufStart());
+  cur_ += fullSize;
+  XDCHECK_LE(cur_, end_);
+  return true;
+}
+
+StringPiece FuseDirPlusList::getName(size_t index) const {
+  auto& dirent =
+      reinterpret_cast<const fuse_direntplus*>(bufStart() + entries_[index])
+          ->dirent;
+  return StringPiece{dirent.name, dirent.namelen};
+}
+
+void FuseDirPlusList::setEntryParam(size_t index, const fuse_entry_out& entry) {
+  reinterpret_cast<fuse_direntplus*>(bufStart() + entries_[index])->entry_out =
+      entry;
+}
+
+StringPiece FuseDirPlusList::getBuf() const {
+  return StringPiece(bufStart(), cur_ - bufStart());
+}
+
+std::vector<std::pair<FuseDirList::ExtractedEntry, fuse_entry_out>>
+FuseDirPlusList::extract() const {
+  std::vector<std::pair<FuseDirList::ExtractedEntry, fuse_entry_out>> result;
+
+  for (auto offset : entries_) {
+    auto entry = reinterpret_cast<const fuse_direntplus*>(bufStart() + offset);
+    auto& dirent = entry->dirent;
+    result.emplace_back(
+        FuseDirList::ExtractedEntry{
+            std::string{dirent.name, dirent.name + dirent.namelen},
+            dirent.ino,
+            static_cast<dtype_t>(dirent.type),
+            static_cast<off_t>(dirent.off)},
+        entry->entry_out);
+  }
+  return result;
+}
+#endif // __linux__
+
 } // namespace facebook::eden
 
 #endif
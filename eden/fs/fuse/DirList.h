@@ -7,9 +7,12 @@
 
 #pragma once
 #include <folly/Range.h>
+#include <folly/io/IOBuf.h>
 #include <sys/stat.h>
 #include <memory>
+#include <vector>
 #include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/FsChannelTypes.h"
 
 namespace facebook::eden {
 
@@ -17,10 +20,15 @@ namespace facebook::eden {
  * Helper for populating directory listings.
  */
 class FuseDirList {
-  std::unique_ptr<char[]> buf_;
+  // From IOBufPool::getReplyPool(), see bufStart().
+  std::unique_ptr<folly::IOBuf> buf_;
   char* end_;
   char* cur_;
 
+  char* bufStart() const {
+    return reinterpret_cast<char*>(buf_->writableData());
+  }
+
  public:
   struct ExtractedEntry {
     std::string name;
@@ -51,4 +59,63 @@ class FuseDirList {
   std::vector<ExtractedEntry> extract() const;
 };
 
+#ifdef __linux__
+/**
+ * Helper for populating FUSE_READDIRPLUS replies.
+ *
+ * Each entry carries a fuse_entry_out in addition to its dirent. add() leaves
+ * it zeroed, which the kernel takes as "no attributes for this entry", and
+ * setEntryParam() fills it in once the entry's inode has been looked up.
+ * Every entry sent with a nonzero nodeid counts as a lookup of that inode.
+ */
+class FuseDirPlusList {
+  // From IOBufPool::getReplyPool(), see bufStart().
+  std::unique_ptr<folly::IOBuf> buf_;
+  char* end_;
+  char* cur_;
+
+  char* bufStart() const {
+    return reinterpret_cast<char*>(buf_->writableData());
+  }
+  // Offset in buf_ of each entry, in the order they were added.
+  std::vector<size_t> entries_;
+
+ public:
+  explicit FuseDirPlusList(size_t maxSize);
+
+  FuseDirPlusList(const FuseDirPlusList&) = delete;
+  FuseDirPlusList& operator=(const FuseDirPlusList&) = delete;
+  FuseDirPlusList(FuseDirPlusList&&) = default;
+  FuseDirPlusList& operator=(FuseDirPlusList&&) = default;
+
+  /**
+   * Add a new entry to the list.
+   * Returns true on success or false if the list is full.
+   */
+  bool add(folly::StringPiece name, ino_t inode, dtype_t type, off_t off);
+
+  /** Number of entries added so far. */
+  size_t size() const {
+    return entries_.size();
+  }
+
+  /**
+   * Name of the index-th entry. It points into this list's buffer, which is
+   * not moved when the list is.
+   */
+  folly::StringPiece getName(size_t index) const;
+
+  void setEntryParam(size_t index, const fuse_entry_out& entry);
+
+  folly::StringPiece getBuf() const;
+
+  /**
+   * Parses the accumulated buffer back into its entries, along with the
+   * fuse_entry_out of each.
+   */
+  std::vector<std::pair<FuseDirList::ExtractedEntry, fuse_entry_out>>
+  extract() const;
+};
+#endif // __linux__
+
 } // namespace facebook::eden
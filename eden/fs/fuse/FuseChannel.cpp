@@ -11,19 +11,35 @@
 
 #include <boost/cast.hpp>
 #include <fmt/core.h>
+#include <fcntl.h>
+#include <folly/FileUtil.h>
+#include <folly/ScopeGuard.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
 #include <signal.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#endif
 #include <chrono>
+#include <limits>
+#include <set>
 #include <type_traits>
+#include <unordered_set>
 #include "eden/fs/fuse/DirList.h"
 #include "eden/fs/fuse/FuseDispatcher.h"
 #include "eden/fs/fuse/FuseRequestContext.h"
+#include "eden/fs/fuse/IoUring.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/FsEventLogger.h"
+#include "eden/fs/telemetry/SamplingProfiler.h"
+#include "eden/fs/telemetry/SlowRequestLog.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/IDGen.h"
+#include "eden/fs/utils/IOBufPool.h"
+#include "eden/fs/utils/Pipe.h"
 #include "eden/fs/utils/Synchronized.h"
 #include "eden/fs/utils/SystemError.h"
 #include "eden/fs/utils/Thread.h"
@@ -177,6 +193,7 @@ std::string readdir(FuseArg arg) {
   return format("offset={}", in.offset);
 }
 
+constexpr RenderFn readdirplus = readdir;
 constexpr RenderFn releasedir = default_render;
 constexpr RenderFn fsyncdir = default_render;
 
@@ -214,6 +231,16 @@ static_assert(sizeof(FuseTraceEvent) >= 72);
 static_assert(sizeof(FuseTraceEvent) <= 72);
 static_assert(kTraceBusCapacity * sizeof(FuseTraceEvent) == 1800000);
 
+// The trace bus drops events rather than blocking FUSE requests when its
+// subscribers fall behind, so a request whose FINISH event was dropped stays
+// in the outstanding requests forever. The kernel never has nearly this many
+// requests in flight, so past this many they are all assumed to be stale.
+constexpr size_t kMaxTrackedRequests = 10000;
+
+// The flight recorder keeps this many past events, and as many again in its
+// snapshot. Around 700 KB per mount.
+constexpr size_t kFlightRecorderCapacity = 5000;
+
 // This is the minimum size used by libfuse so we use it too!
 constexpr size_t MIN_BUFSIZE = 0x21000;
 
@@ -485,7 +512,12 @@ constexpr auto kFuseHandlers = [] {
       &ChannelThreadStats::fallocate,
       Write};
 #ifdef __linux__
-  handlers[FUSE_READDIRPLUS] = {"FUSE_READDIRPLUS", Read};
+  handlers[FUSE_READDIRPLUS] = {
+      "FUSE_READDIRPLUS",
+      &FuseChannel::fuseReadDirPlus,
+      &argrender::readdirplus,
+      &ChannelThreadStats::readdirplus,
+      Read};
   handlers[FUSE_RENAME2] = {"FUSE_RENAME2", Write};
   handlers[FUSE_LSEEK] = {"FUSE_LSEEK"};
   handlers[FUSE_COPY_FILE_RANGE] = {"FUSE_COPY_FILE_RANGE", Write};
@@ -601,6 +633,237 @@ void installSignalHandler() {
       sigaction(SIGUSR2, &action, &oldAction), "failed to set SIGUSR2 handler");
 }
 
+#ifdef __linux__
+/**
+ * A pipe through which a thread assembles spliced replies. The kernel
+ * requires a reply to be spliced to the FUSE device in a single call, so the
+ * pipe must be able to hold the header and the whole payload.
+ */
+struct SplicePipe {
+  Pipe pipe{/*nonBlocking=*/true};
+  size_t capacity{0};
+};
+
+thread_local std::unique_ptr<SplicePipe> splicePipe;
+
+/**
+ * Returns the current thread's splice pipe, grown to hold at least size
+ * bytes, or nullptr if it cannot be made that large.
+ */
+SplicePipe* getSplicePipe(size_t size) {
+  if (!splicePipe) {
+    splicePipe = std::make_unique<SplicePipe>();
+  }
+  if (size > splicePipe->capacity) {
+    auto res = fcntl(splicePipe->pipe.write.fd(), F_SETPIPE_SZ, size);
+    if (res < 0) {
+      XLOG(DBG3) << "unable to grow splice pipe to " << size
+                 << " bytes: " << folly::errnoStr(errno);
+      return nullptr;
+    }
+    splicePipe->capacity = res;
+  }
+  return splicePipe.get();
+}
+
+/**
+ * Discards the current thread's splice pipe after a failed splice left part
+ * of a reply in it.
+ */
+void resetSplicePipe() {
+  splicePipe.reset();
+}
+#endif
+
+#ifdef EDEN_HAVE_IO_URING
+class FuseUringWorker;
+
+/**
+ * The io_uring worker running on the current thread, if any.
+ */
+thread_local FuseUringWorker* currentUringWorker = nullptr;
+
+/**
+ * The ring and read buffers of one FUSE worker thread using io_uring.
+ *
+ * Completions are tagged with their user_data: reads carry the index of
+ * their buffer, a few small constants identify control operations, and
+ * replies carry a pointer to the heap copy of their data.
+ */
+class FuseUringWorker {
+ public:
+  static constexpr size_t kNumReads = 4;
+  static constexpr unsigned kRingEntries = 64;
+
+  static constexpr uint64_t kStopPollTag = kNumReads;
+  static constexpr uint64_t kCancelTag = kNumReads + 1;
+  static constexpr uint64_t kTimeoutTag = kNumReads + 2;
+
+  FuseUringWorker(const FuseChannel* channel, size_t bufferSize)
+      : channel{channel}, ring_{kRingEntries} {
+    if (!(ring_.getFeatures() & IORING_FEAT_NODROP)) {
+      // Cancellation and timeouts arrived with the same kernel release.
+      folly::throwSystemErrorExplicit(
+          ENOSYS, "io_uring is too old for the FUSE channel");
+    }
+    buffers_.reserve(kNumReads);
+    for (size_t i = 0; i < kNumReads; ++i) {
+      // Page-aligned, so that registering them pins as few pages as
+      // possible.
+      buffers_.push_back(IOBufPool::getReplyPool().allocate(bufferSize));
+      iovs_.push_back(iovec{buffers_.back()->writableData(), bufferSize});
+    }
+    registered_ = ring_.registerBuffers(iovs_.data(), iovs_.size());
+    if (!registered_) {
+      XLOG(DBG2) << "unable to register FUSE read buffers with io_uring: "
+                 << folly::errnoStr(errno);
+    }
+  }
+
+  IoUring& ring() {
+    return ring_;
+  }
+
+  folly::ByteRange getBuffer(size_t index, size_t length) const {
+    return folly::ByteRange{buffers_[index]->data(), length};
+  }
+
+  bool queueRead(int fd, size_t index) {
+    auto* sqe = getSqe();
+    if (!sqe) {
+      return false;
+    }
+    sqe->fd = fd;
+    if (registered_) {
+      sqe->opcode = IORING_OP_READ_FIXED;
+      sqe->addr = reinterpret_cast<uint64_t>(iovs_[index].iov_base);
+      sqe->len = iovs_[index].iov_len;
+      sqe->buf_index = index;
+    } else {
+      sqe->opcode = IORING_OP_READV;
+      sqe->addr = reinterpret_cast<uint64_t>(&iovs_[index]);
+      sqe->len = 1;
+    }
+    sqe->user_data = index;
+    return true;
+  }
+
+  bool queuePoll(int fd, uint64_t tag) {
+    auto* sqe = getSqe();
+    if (!sqe) {
+      return false;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll_events = POLLIN;
+    sqe->user_data = tag;
+    return true;
+  }
+
+  bool queueCancel(uint64_t target) {
+    auto* sqe = getSqe();
+    if (!sqe) {
+      return false;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = target;
+    sqe->user_data = kCancelTag;
+    return true;
+  }
+
+  bool queueTimeout(std::chrono::nanoseconds timeout) {
+    auto* sqe = getSqe();
+    if (!sqe) {
+      return false;
+    }
+    auto secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    timeout_.tv_sec = secs.count();
+    timeout_.tv_nsec = (timeout - secs).count();
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uint64_t>(&timeout_);
+    sqe->len = 1;
+    sqe->user_data = kTimeoutTag;
+    return true;
+  }
+
+  /**
+   * Copy a reply and queue it for writing. Returns false if the ring has no
+   * room, in which case the caller writes it synchronously.
+   */
+  bool queueReply(int fd, const iovec* iov, size_t count) {
+    auto* sqe = getSqe();
+    if (!sqe) {
+      return false;
+    }
+    auto reply = std::make_unique<Reply>();
+    for (size_t i = 0; i < count; ++i) {
+      reply->data.append(
+          static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+    reply->iov.iov_base = reply->data.data();
+    reply->iov.iov_len = reply->data.size();
+
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&reply->iov);
+    sqe->len = 1;
+    sqe->user_data = reinterpret_cast<uint64_t>(reply.get());
+    pendingReplies_.emplace(sqe->user_data, std::move(reply));
+    return true;
+  }
+
+  bool isReply(uint64_t tag) const {
+    return tag > kTimeoutTag;
+  }
+
+  /**
+   * Release a reply once its write has completed. Returns the number of
+   * bytes the reply should have written.
+   */
+  size_t completeReply(uint64_t tag) {
+    auto it = pendingReplies_.find(tag);
+    XCHECK(it != pendingReplies_.end()) << "unknown io_uring reply " << tag;
+    auto size = it->second->data.size();
+    pendingReplies_.erase(it);
+    return size;
+  }
+
+  size_t getNumPendingReplies() const {
+    return pendingReplies_.size();
+  }
+
+  const FuseChannel* const channel;
+
+ private:
+  struct Reply {
+    std::string data;
+    iovec iov;
+  };
+
+  io_uring_sqe* getSqe() {
+    auto* sqe = ring_.getSqe();
+    if (!sqe) {
+      // Make room by handing what we have to the kernel.
+      ring_.submit();
+      sqe = ring_.getSqe();
+    }
+    return sqe;
+  }
+
+  // Declared before ring_ so that buffers the kernel may still reference
+  // outlive the ring.
+  std::vector<std::unique_ptr<folly::IOBuf>> buffers_;
+  std::vector<iovec> iovs_;
+  __kernel_timespec timeout_{};
+  std::unordered_map<uint64_t, std::unique_ptr<Reply>> pendingReplies_;
+
+  IoUring ring_;
+  bool registered_{false};
+};
+#endif
+
 template <typename T>
 iovec make_iovec(const T& t) {
   static_assert(std::is_standard_layout_v<T>);
@@ -634,8 +897,12 @@ FuseChannel::DataRange::DataRange(int64_t off, int64_t len)
 
 FuseChannel::InvalidationEntry::InvalidationEntry(
     InodeNumber num,
-    PathComponentPiece n)
-    : type(InvalidationType::DIR_ENTRY), inode(num), name(n) {}
+    PathComponentPiece n,
+    InodeNumber childNum)
+    : type(InvalidationType::DIR_ENTRY),
+      inode(num),
+      child(childNum),
+      name(n) {}
 
 FuseChannel::InvalidationEntry::InvalidationEntry(
     InodeNumber num,
@@ -666,7 +933,7 @@ FuseChannel::InvalidationEntry::~InvalidationEntry() {
 
 FuseChannel::InvalidationEntry::InvalidationEntry(
     InvalidationEntry&& other) noexcept
-    : type(other.type), inode(other.inode) {
+    : type(other.type), inode(other.inode), child(other.child) {
   // For simplicity we just declare the InvalidationEntry move constructor as
   // unconditionally noexcept in FuseChannel.h
   // Assert that this is actually true.
@@ -755,6 +1022,87 @@ void FuseChannel::sendReply(
   sendRawReply(vec.data(), vec.size());
 }
 
+void FuseChannel::sendReply(const fuse_in_header& request, BufVec&& buf)
+    const {
+  if (buf.isFile()) {
+#ifdef __linux__
+    if (spliceReadReplies_ && trySpliceReply(request, buf)) {
+      return;
+    }
+#endif
+    sendReply(request, *std::move(buf).toIOBuf());
+    return;
+  }
+  sendReply(request, *buf);
+}
+
+#ifdef __linux__
+bool FuseChannel::trySpliceReply(
+    const fuse_in_header& request,
+    const BufVec& buf) const {
+  fuse_out_header out;
+  out.unique = request.unique;
+  out.error = 0;
+  out.len = sizeof(out) + buf.size();
+
+  auto* splice = getSplicePipe(out.len);
+  if (!splice) {
+    return false;
+  }
+  auto& pipe = splice->pipe;
+
+  if (folly::writeNoInt(pipe.write.fd(), &out, sizeof(out)) !=
+      static_cast<ssize_t>(sizeof(out))) {
+    resetSplicePipe();
+    return false;
+  }
+
+  loff_t offset = buf.getFileOffset();
+  size_t remaining = buf.size();
+  while (remaining > 0) {
+    auto res = ::splice(
+        buf.getFile().fd(),
+        &offset,
+        pipe.write.fd(),
+        nullptr,
+        remaining,
+        SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      // Either an error or the file was truncated since the reply size was
+      // computed. The header is already in the pipe, so throw the pipe away
+      // and let the caller copy whatever the file holds now.
+      XLOG(DBG3) << "splice from file failed, falling back to copying: "
+                 << (res < 0 ? folly::errnoStr(errno) : "unexpected EOF");
+      resetSplicePipe();
+      return false;
+    }
+    remaining -= res;
+  }
+
+  auto res = ::splice(
+      pipe.read.fd(),
+      nullptr,
+      fuseDevice_.fd(),
+      nullptr,
+      out.len,
+      SPLICE_F_MOVE);
+  const int err = errno;
+  XLOG(DBG7) << "trySpliceReply: unique=" << out.unique
+             << " header->len=" << out.len << " wrote=" << res;
+  if (res != static_cast<ssize_t>(out.len)) {
+    resetSplicePipe();
+    if (res < 0) {
+      throwWriteError(err);
+    }
+    throw std::runtime_error("unexpected short splice to FUSE device");
+  }
+  return true;
+}
+#endif
+
 void FuseChannel::sendReply(
     const fuse_in_header& request,
     folly::ByteRange bytes) const {
@@ -780,21 +1128,38 @@ void FuseChannel::sendRawReply(const iovec iov[], size_t count) const {
     header->len += iov[i].iov_len;
   }
 
+#ifdef EDEN_HAVE_IO_URING
+  // Replies sent from an io_uring worker are batched with its next
+  // submission rather than written immediately.
+  if (currentUringWorker && currentUringWorker->channel == this &&
+      currentUringWorker->queueReply(fuseDevice_.fd(), iov, count)) {
+    return;
+  }
+#endif
+
   const auto res = writev(fuseDevice_.fd(), iov, count);
   const int err = errno;
   XLOG(DBG7) << "sendRawReply: unique=" << header->unique
              << " header->len=" << header->len << " wrote=" << res;
 
   if (res < 0) {
-    if (err == ENOENT) {
-      // Interrupted by a signal.  We don't need to log this,
-      // but will propagate it back to our caller.
-    } else if (!isFuseDeviceValid(state_.rlock()->stopReason)) {
-      XLOG(INFO) << "error writing to fuse device: session closed";
-    } else {
-      XLOG(WARNING) << "error writing to fuse device: " << folly::errnoStr(err);
-    }
-    throwSystemErrorExplicit(err, "error writing to fuse device");
+    throwWriteError(err);
+  }
+}
+
+void FuseChannel::throwWriteError(int err) const {
+  logWriteError(err);
+  throwSystemErrorExplicit(err, "error writing to fuse device");
+}
+
+void FuseChannel::logWriteError(int err) const {
+  if (err == ENOENT) {
+    // Interrupted by a signal.  We don't need to log this,
+    // but will propagate it back to our caller.
+  } else if (!isFuseDeviceValid(state_.rlock()->stopReason)) {
+    XLOG(INFO) << "error writing to fuse device: session closed";
+  } else {
+    XLOG(WARNING) << "error writing to fuse device: " << folly::errnoStr(err);
   }
 }
 
@@ -810,7 +1175,13 @@ FuseChannel::FuseChannel(
     Notifications* notifications,
     CaseSensitivity caseSensitive,
     bool requireUtf8Path,
-    int32_t maximumBackgroundRequests)
+    int32_t maximumBackgroundRequests,
+    bool spliceReadReplies,
+    bool readdirPlus,
+    bool writebackCache,
+    bool prioritizeMetadataRequests,
+    bool useIoUring,
+    CpuAffinityPolicy workerAffinity)
     : bufferSize_(std::max(size_t(getpagesize()) + 0x1000, MIN_BUFSIZE)),
       numThreads_(numThreads),
       dispatcher_(std::move(dispatcher)),
@@ -821,29 +1192,52 @@ FuseChannel::FuseChannel(
       caseSensitive_{caseSensitive},
       requireUtf8Path_{requireUtf8Path},
       maximumBackgroundRequests_{maximumBackgroundRequests},
+      spliceReadReplies_{spliceReadReplies},
+      readdirPlus_{readdirPlus},
+      writebackCache_{writebackCache},
+      prioritizeMetadataRequests_{prioritizeMetadataRequests},
+      useIoUring_{useIoUring},
+      workerAffinity_{workerAffinity},
+      homeNode_{getCurrentNumaNode()},
       fuseDevice_(std::move(fuseDevice)),
       processAccessLog_(std::move(processNameCache)),
+      flightRecorder_{kFlightRecorderCapacity},
       traceDetailedArguments_(std::make_shared<std::atomic<size_t>>(0)),
       traceBus_(TraceBus<FuseTraceEvent>::create(
           "FuseTrace" + mountPath.stringPiece().str(),
-          kTraceBusCapacity)) {
+          kTraceBusCapacity,
+          TraceBusOverflow::Drop)) {
   XCHECK_GE(numThreads_, 1ul);
   installSignalHandler();
 
+#ifdef EDEN_HAVE_IO_URING
+  if (useIoUring_) {
+    auto fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    folly::checkUnixError(fd, "unable to create FUSE stop eventfd");
+    stopEvent_ = folly::File{fd, /*ownsFd=*/true};
+  }
+#endif
+
   traceSubscriptionHandles_.push_back(traceBus_->subscribeFunction(
       "FuseChannel request tracking",
       [this,
        fsEventLogger = std::move(fsEventLogger)](const FuseTraceEvent& event) {
+        flightRecorder_.record(FuseTraceRecord{event});
         switch (event.getType()) {
           case FuseTraceEvent::START: {
             auto state = telemetryState_.wlock();
-            auto [iter, inserted] = state->requests.emplace(
+            if (state->requests.size() >= kMaxTrackedRequests) {
+              XLOG(WARN) << "forgetting " << state->requests.size()
+                         << " outstanding FUSE requests, whose FINISH trace "
+                         << "events were probably dropped";
+              state->requests.clear();
+            }
+            state->requests.insert_or_assign(
                 event.getUnique(),
                 OutstandingRequest{
                     event.getUnique(),
                     event.getRequest(),
                     event.monotonicTime});
-            XCHECK(inserted) << "duplicate fuse start event";
             break;
           }
           case FuseTraceEvent::FINISH: {
@@ -851,13 +1245,19 @@ FuseChannel::FuseChannel(
             {
               auto state = telemetryState_.wlock();
               auto it = state->requests.find(event.getUnique());
-              XCHECK(it != state->requests.end())
-                  << "duplicate fuse finish event";
+              if (it == state->requests.end()) {
+                // The START event was dropped.
+                break;
+              }
               durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
                   event.monotonicTime - it->second.requestStartTime);
               state->requests.erase(it);
             }
 
+            if (durationNs >= SlowRequestLog::kThreshold) {
+              flightRecorder_.snapshot();
+            }
+
             if (fsEventLogger) {
               auto opcode = event.getRequest().opcode;
               fsEventLogger->log({
@@ -970,10 +1370,14 @@ void FuseChannel::invalidateInode(InodeNumber ino, off_t off, off_t len) {
   invalidationCV_.notify_one();
 }
 
-void FuseChannel::invalidateEntry(InodeNumber parent, PathComponentPiece name) {
+void FuseChannel::invalidateEntry(
+    InodeNumber parent,
+    PathComponentPiece name,
+    std::optional<InodeNumber> child) {
   // Add the entry to invalidationQueue_ and wake up the invalidation thread to
   // send it.
-  invalidationQueue_.lock()->queue.emplace_back(parent, name);
+  invalidationQueue_.lock()->queue.emplace_back(
+      parent, name, child.value_or(InodeNumber{}));
   invalidationCV_.notify_one();
 }
 
@@ -1000,6 +1404,118 @@ folly::Future<folly::Unit> FuseChannel::flushInvalidations() {
   return result;
 }
 
+/**
+ * Coalesce a batch of entries taken from the invalidation queue, in place.
+ * Returns the number of invalidations that no longer need to be sent.
+ *
+ * Entries are only coalesced with others between the same two FLUSH
+ * entries, so that a flush still completes after everything queued before
+ * it has been sent.  Within such a segment:
+ *
+ * - The INODE entries for an inode are replaced by its merged data ranges,
+ *   sent where the first of them was.  A data invalidation also drops the
+ *   inode's attributes, so attribute-only entries are only kept when there
+ *   is no data range to send.
+ * - DIR_ENTRY duplicates are dropped, as are entries inside the subtree of
+ *   another invalidated entry, since the kernel invalidates the whole
+ *   subtree below a dentry.
+ *
+ * This method always runs in the invalidation thread.
+ */
+size_t FuseChannel::coalesceInvalidations(
+    std::vector<InvalidationEntry>& entries) {
+  // A data range as the half-open interval [first, second).
+  using Interval = std::pair<int64_t, int64_t>;
+  constexpr auto kEndOfFile = std::numeric_limits<int64_t>::max();
+
+  std::vector<InvalidationEntry> result;
+  result.reserve(entries.size());
+
+  auto coalesceSegment = [&](size_t begin, size_t end) {
+    std::unordered_map<InodeNumber, std::vector<Interval>> inodeRanges;
+    std::unordered_set<InodeNumber> invalidatedDirs;
+    std::set<std::pair<InodeNumber, PathComponentPiece>> dirEntries;
+    std::vector<bool> keep(end - begin, true);
+
+    for (size_t i = begin; i < end; ++i) {
+      auto& entry = entries[i];
+      if (entry.type == InvalidationType::INODE) {
+        auto& ranges = inodeRanges[entry.inode];
+        auto offset = entry.range.offset;
+        auto length = entry.range.length;
+        if (offset >= 0) {
+          auto rangeEnd = (length <= 0 || length > kEndOfFile - offset)
+              ? kEndOfFile
+              : offset + length;
+          ranges.emplace_back(offset, rangeEnd);
+        }
+      } else if (entry.type == InvalidationType::DIR_ENTRY) {
+        if (!dirEntries.emplace(entry.inode, entry.name).second) {
+          keep[i - begin] = false;
+        } else if (entry.child.hasValue()) {
+          invalidatedDirs.insert(entry.child);
+        }
+      }
+    }
+
+    std::unordered_set<InodeNumber> emittedInodes;
+    for (size_t i = begin; i < end; ++i) {
+      auto& entry = entries[i];
+      if (entry.type == InvalidationType::DIR_ENTRY) {
+        if (keep[i - begin] && invalidatedDirs.count(entry.inode) == 0) {
+          result.push_back(std::move(entry));
+        }
+        continue;
+      }
+      if (entry.type != InvalidationType::INODE) {
+        result.push_back(std::move(entry));
+        continue;
+      }
+      if (!emittedInodes.insert(entry.inode).second) {
+        continue;
+      }
+
+      auto& ranges = inodeRanges[entry.inode];
+      if (ranges.empty()) {
+        // Only attributes were invalidated.
+        result.push_back(std::move(entry));
+        continue;
+      }
+      std::sort(ranges.begin(), ranges.end());
+      auto current = ranges.front();
+      auto emit = [&](const Interval& interval) {
+        auto length = interval.second == kEndOfFile
+            ? 0
+            : interval.second - interval.first;
+        result.emplace_back(entry.inode, interval.first, length);
+      };
+      for (const auto& interval : ranges) {
+        if (interval.first <= current.second) {
+          current.second = std::max(current.second, interval.second);
+        } else {
+          emit(current);
+          current = interval;
+        }
+      }
+      emit(current);
+    }
+  };
+
+  size_t segmentBegin = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (entries[i].type == InvalidationType::FLUSH) {
+      coalesceSegment(segmentBegin, i);
+      result.push_back(std::move(entries[i]));
+      segmentBegin = i + 1;
+    }
+  }
+  coalesceSegment(segmentBegin, entries.size());
+
+  auto dropped = entries.size() - result.size();
+  entries.swap(result);
+  return dropped;
+}
+
 /**
  * Send an element from the invalidation queue.
  *
@@ -1198,6 +1714,13 @@ void FuseChannel::requestSessionExit(
   // Update stop_ so that worker threads will break out of their loop.
   stop_.store(true, std::memory_order_relaxed);
 
+#ifdef EDEN_HAVE_IO_URING
+  // io_uring workers wait for this rather than for the signal below.
+  if (stopEvent_) {
+    eventfd_write(stopEvent_.fd(), 1);
+  }
+#endif
+
   // Send a signal to knock our workers out of their blocking read() syscalls
   // TODO: This code is slightly racy, since threads could receive the signal
   // immediately before entering read().  In the long run it would be nicer to
@@ -1252,6 +1775,12 @@ void FuseChannel::fuseWorkerThread() noexcept {
   disablePthreadCancellation();
   setThreadName(to<std::string>("fuse", mountPath_.basename()));
   setThreadSigmask();
+  // Bound before the thread allocates its buffers and thread-local state, so
+  // that they live on its node.
+  bindCurrentThread(
+      workerAffinity_,
+      nextWorkerIndex_.fetch_add(1, std::memory_order_relaxed),
+      homeNode_);
   *(liveRequestWatches_.get()) =
       std::make_shared<RequestMetricsScope::LockedRequestWatchList>();
 
@@ -1317,11 +1846,21 @@ void FuseChannel::invalidationThread() noexcept {
       lockedQueue->queue.swap(entries);
     }
 
-    // Process all of the entries we found
+    // Process all of the entries we found, skipping the ones made redundant
+    // by other entries in the same batch.
+    auto dropped = coalesceInvalidations(entries);
+    size_t sent = 0;
     for (auto& entry : entries) {
+      if (entry.type != InvalidationType::FLUSH) {
+        ++sent;
+      }
       sendInvalidation(entry);
     }
     entries.clear();
+
+    auto& stats = dispatcher_->getStats()->getChannelStatsForCurrentThread();
+    stats.fuseInvalidationsSent.addValue(sent);
+    stats.fuseInvalidationsDropped.addValue(dropped);
   }
 }
 
@@ -1437,10 +1976,6 @@ void FuseChannel::readInitPacket() {
   const auto capable = init.init.flags;
   auto& want = connInfo.flags;
 
-  // TODO: follow up and look at the new flags; particularly
-  // FUSE_DO_READDIRPLUS, FUSE_READDIRPLUS_AUTO. FUSE_SPLICE_XXX are interesting
-  // too, but may not directly benefit eden today.
-  //
   // FUSE_ATOMIC_O_TRUNC is a nice optimization when the kernel supports it
   // and the FUSE daemon requires handling open/release for stateful file
   // handles. But FUSE_NO_OPEN_SUPPORT is superior, so edenfs has no need for
@@ -1463,6 +1998,25 @@ void FuseChannel::readInitPacket() {
   want |= FUSE_CACHE_SYMLINKS;
   // We can handle almost any request in parallel.
   want |= FUSE_PARALLEL_DIROPS;
+  if (spliceReadReplies_) {
+    // Read replies for materialized files may be spliced from the overlay.
+    want |= FUSE_SPLICE_WRITE | FUSE_SPLICE_MOVE;
+  }
+  if (readdirPlus_) {
+    // Return the attributes of directory entries along with them, so that
+    // listing a directory and stat()ing its entries doesn't cost one lookup
+    // per entry. With READDIRPLUS_AUTO, the kernel only asks for them when
+    // the entries of a directory are being looked up after a readdir.
+    want |= FUSE_DO_READDIRPLUS | FUSE_READDIRPLUS_AUTO;
+  }
+  if (writebackCache_) {
+    // Let the kernel buffer writes in the page cache and send them to us in
+    // large chunks, instead of sending every write(2) through EdenFS.
+    want |= FUSE_WRITEBACK_CACHE;
+  }
+#else
+  (void)readdirPlus_;
+  (void)writebackCache_;
 #endif
 #ifdef FUSE_NO_OPEN_SUPPORT
   // File handles are stateless so the kernel does not need to send open() and
@@ -1542,286 +2096,428 @@ void FuseChannel::readInitPacket() {
 }
 
 void FuseChannel::processSession() {
-  std::vector<char> buf(bufferSize_);
+#ifdef EDEN_HAVE_IO_URING
+  if (useIoUring_ && processSessionWithIoUring()) {
+    return;
+  }
+#else
+  (void)useIoUring_;
+#endif
+
+  auto buf = IOBufPool::getReplyPool().allocate(bufferSize_);
   // Save this for the sanity check later in the loop to avoid
   // additional syscalls on each loop iteration.
   auto myPid = getpid();
 
   while (!stop_.load(std::memory_order_relaxed)) {
-    // TODO: FUSE_SPLICE_READ allows using splice(2) here if we enable it.
-    // We can look at turning this on once the main plumbing is complete.
-    auto res = read(fuseDevice_.fd(), buf.data(), buf.size());
+    // FUSE_SPLICE_READ would allow using splice(2) here, but every request
+    // is parsed from memory and write payloads are copied into the overlay
+    // with pwritev, so it would only add a syscall per request.
+    auto res = read(fuseDevice_.fd(), buf->writableData(), bufferSize_);
     if (UNLIKELY(res < 0)) {
-      int error = errno;
-      if (stop_.load(std::memory_order_relaxed)) {
-        break;
-      }
-
-      if (error == EINTR || error == EAGAIN) {
-        // If we got interrupted by a signal while reading the next
-        // fuse command, we will simply retry and read the next thing.
-        continue;
-      } else if (error == ENOENT) {
-        // According to comments in the libfuse code:
-        // ENOENT means the operation was interrupted; it's safe to restart
+      if (handleReadError(errno)) {
         continue;
-      } else if (error == ENODEV) {
-        // ENODEV means the filesystem was unmounted
-        folly::call_once(unmountLogFlag_, [this] {
-          XLOG(DBG3) << "received unmount event ENODEV on mount " << mountPath_;
-        });
-        requestSessionExit(StopReason::UNMOUNTED);
-        break;
-      } else {
-        XLOG(WARNING) << "error reading from fuse channel: "
-                      << folly::errnoStr(error);
-        requestSessionExit(StopReason::FUSE_READ_ERROR);
-        break;
       }
+      break;
     }
 
-    const auto arg_size = static_cast<size_t>(res);
-    if (arg_size < sizeof(struct fuse_in_header)) {
-      if (arg_size == 0) {
-        // This code path is hit when a fake FUSE channel is closed in our unit
-        // tests.  On real FUSE channels we should get ENODEV to indicate that
-        // the FUSE channel was shut down.  However, in our unit tests that use
-        // fake FUSE connections we cannot send an ENODEV error, and so we just
-        // close the channel instead.
-        requestSessionExit(StopReason::UNMOUNTED);
-      } else {
-        // We got a partial FUSE header.  This shouldn't ever happen unless
-        // there is a bug in the FUSE kernel code.
-        XLOG(ERR) << "read truncated message from kernel fuse device: len="
-                  << arg_size;
-        requestSessionExit(StopReason::FUSE_TRUNCATED_REQUEST);
-      }
+    if (!processRequest(
+            ByteRange{buf->data(), static_cast<size_t>(res)},
+            myPid)) {
       return;
     }
+  }
+}
+
+#ifdef EDEN_HAVE_IO_URING
+bool FuseChannel::processSessionWithIoUring() {
+  std::optional<FuseUringWorker> worker;
+  try {
+    worker.emplace(this, bufferSize_);
+  } catch (const std::exception& ex) {
+    XLOG_EVERY_MS(WARN, 60000)
+        << "unable to use io_uring for FUSE on mount " << mountPath_
+        << ", falling back to blocking reads: " << exceptionStr(ex);
+    return false;
+  }
+
+  const auto fd = fuseDevice_.fd();
+  auto myPid = getpid();
+
+  std::array<bool, FuseUringWorker::kNumReads> inFlight{};
+  size_t numInFlight = 0;
+  auto startRead = [&](size_t index) {
+    if (worker->queueRead(fd, index)) {
+      inFlight[index] = true;
+      ++numInFlight;
+    }
+  };
+
+  for (size_t i = 0; i < FuseUringWorker::kNumReads; ++i) {
+    startRead(i);
+  }
+  worker->queuePoll(stopEvent_.fd(), FuseUringWorker::kStopPollTag);
+
+  currentUringWorker = &*worker;
+  SCOPE_EXIT {
+    currentUringWorker = nullptr;
+  };
 
-    const auto* header = reinterpret_cast<fuse_in_header*>(buf.data());
-    const ByteRange arg{
-        reinterpret_cast<const uint8_t*>(header + 1),
-        arg_size - sizeof(fuse_in_header)};
-
-    XLOG(DBG7) << "fuse request opcode=" << header->opcode << " "
-               << fuseOpcodeName(header->opcode) << " unique=" << header->unique
-               << " len=" << header->len << " nodeid=" << header->nodeid
-               << " uid=" << header->uid << " gid=" << header->gid
-               << " pid=" << header->pid;
-
-    // On Linux, if security caps are enabled and the FUSE filesystem implements
-    // xattr support, every FUSE_WRITE opcode is preceded by FUSE_GETXATTR for
-    // "security.capability". Until we discover a way to tell the kernel that
-    // they will always return nothing in an Eden mount, short-circuit that path
-    // as efficiently and as early as possible.
-    //
-    // On some systems, the kernel also frequently requests
-    // POSIX ACL xattrs, so fast track those too, if only to make strace
-    // logs easier to follow.
-    if (header->opcode == FUSE_GETXATTR) {
-      const auto getxattr =
-          reinterpret_cast<const fuse_getxattr_in*>(arg.data());
-
-      // Evaluate strlen before the comparison loop below.
-      const StringPiece namePiece{reinterpret_cast<const char*>(getxattr + 1)};
-      static constexpr StringPiece kFastTracks[] = {
-          "security.capability",
-          "system.posix_acl_access",
-          "system.posix_acl_default"};
-
-      // Unclear whether one strlen and matching compares is better than
-      // strcmps, but it's probably in the noise.
-      bool matched = false;
-      for (auto fastTrack : kFastTracks) {
-        if (namePiece == fastTrack) {
-          replyError(*header, ENODATA);
-          matched = true;
-          break;
+  bool stopping = false;
+  bool cancelled = false;
+  bool timedOut = false;
+  while (true) {
+    stopping = stopping || stop_.load(std::memory_order_relaxed);
+    if (stopping && !cancelled) {
+      // Reads that already picked up a request still complete and are
+      // processed below, so no request is lost when the channel is handed
+      // over during a graceful restart.
+      for (size_t i = 0; i < inFlight.size(); ++i) {
+        if (inFlight[i]) {
+          worker->queueCancel(i);
         }
       }
-      if (matched) {
-        continue;
-      }
+      worker->queueTimeout(std::chrono::seconds{1});
+      cancelled = true;
+    }
+    if (stopping &&
+        ((numInFlight == 0 && worker->getNumPendingReplies() == 0) ||
+         timedOut)) {
+      break;
     }
 
-    // Sanity check to ensure that the request wasn't from ourself.
-    //
-    // We should never make requests to ourself via normal filesytem
-    // operations going through the kernel.  Otherwise we risk deadlocks if the
-    // kernel calls us while holding an inode lock, and we then end up making a
-    // filesystem call that need the same inode lock.  We will then not be able
-    // to resolve this deadlock on kernel inode locks without rebooting the
-    // system.
-    if (UNLIKELY(static_cast<pid_t>(header->pid) == myPid)) {
-      replyError(*header, EIO);
-      XLOG(CRITICAL) << "Received FUSE request from our own pid: opcode="
-                     << header->opcode << " nodeid=" << header->nodeid
-                     << " pid=" << header->pid;
-      continue;
+    auto res = worker->ring().submit(1);
+    if (res < 0 && res != -EINTR && res != -EAGAIN && res != -EBUSY) {
+      XLOG(ERR) << "io_uring_enter failed on FUSE mount " << mountPath_ << ": "
+                << folly::errnoStr(-res);
+      requestSessionExit(StopReason::FUSE_READ_ERROR);
+      break;
     }
 
-    auto* handlerEntry = lookupFuseHandlerEntry(header->opcode);
-    processAccessLog_.recordAccess(
-        header->pid,
-        handlerEntry ? handlerEntry->accessType : AccessType::FsChannelOther);
-
-    switch (header->opcode) {
-      case FUSE_INIT:
-        replyError(*header, EPROTO);
-        throw std::runtime_error(
-            "received FUSE_INIT after we have been initialized!?");
-
-      case FUSE_GETLK:
-      case FUSE_SETLK:
-      case FUSE_SETLKW:
-        // Deliberately not handling locking; this causes
-        // the kernel to do it for us
-        XLOG(DBG7) << fuseOpcodeName(header->opcode);
-        replyError(*header, ENOSYS);
-        break;
+    worker->ring().reapCompletions([&](const io_uring_cqe& cqe) {
+      auto tag = cqe.user_data;
+      if (worker->isReply(tag)) {
+        auto expected = worker->completeReply(tag);
+        if (cqe.res < 0) {
+          logWriteError(-cqe.res);
+        } else if (static_cast<size_t>(cqe.res) != expected) {
+          XLOG(ERR) << "unexpected short write to FUSE device";
+        }
+        return;
+      }
 
-#ifdef __linux__
-      case FUSE_LSEEK:
-        // We only support stateless file handles, so lseek() is meaningless
-        // for us.  Returning ENOSYS causes the kernel to implement it for us,
-        // and will cause it to stop sending subsequent FUSE_LSEEK requests.
-        XLOG(DBG7) << "FUSE_LSEEK";
-        replyError(*header, ENOSYS);
-        break;
-#endif
+      switch (tag) {
+        case FuseUringWorker::kStopPollTag:
+          stopping = true;
+          return;
+        case FuseUringWorker::kCancelTag:
+          return;
+        case FuseUringWorker::kTimeoutTag:
+          if (numInFlight > 0 || worker->getNumPendingReplies() > 0) {
+            XLOG(WARN) << "abandoning " << numInFlight << " FUSE reads and "
+                       << worker->getNumPendingReplies()
+                       << " replies still in flight on " << mountPath_;
+          }
+          timedOut = true;
+          return;
+      }
 
-      case FUSE_POLL:
-        // We do not currently implement FUSE_POLL.
-        XLOG(DBG7) << "FUSE_POLL";
-        replyError(*header, ENOSYS);
-        break;
+      auto index = static_cast<size_t>(tag);
+      inFlight[index] = false;
+      --numInFlight;
+      if (cqe.res < 0) {
+        if (cqe.res == -ECANCELED || !handleReadError(-cqe.res)) {
+          stopping = true;
+        } else if (!stopping) {
+          startRead(index);
+        }
+        return;
+      }
 
-      case FUSE_INTERRUPT: {
-        // no reply is required
-        XLOG(DBG7) << "FUSE_INTERRUPT";
-        // Ignore it: we don't have a reliable way to guarantee
-        // that interrupting functions correctly.
-        // In addition, the kernel (certainly on macOS) may recycle
-        // ids too quickly for us to safely track by `unique` id.
-        break;
+      if (!processRequest(worker->getBuffer(index, cqe.res), myPid)) {
+        stopping = true;
+      } else if (!stopping) {
+        startRead(index);
       }
+    });
+  }
 
-      case FUSE_DESTROY:
-        XLOG(DBG7) << "FUSE_DESTROY";
-        dispatcher_->destroy();
-        // FUSE on linux doesn't care whether we reply to FUSE_DESTROY
-        // but the macOS implementation blocks the unmount syscall until
-        // we have responded, which in turn blocks our attempt to gracefully
-        // unmount, so we respond here.  It doesn't hurt Linux to respond
-        // so we do it for both platforms.
-        replyError(*header, 0);
-        break;
+  return true;
+}
+#endif
 
-      case FUSE_NOTIFY_REPLY:
-        XLOG(DBG7) << "FUSE_NOTIFY_REPLY";
-        // Don't strictly need to do anything here, but may want to
-        // turn the kernel notifications in Futures and use this as
-        // a way to fulfil the promise
-        break;
+bool FuseChannel::handleReadError(int error) {
+  if (stop_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+
+  if (error == EINTR || error == EAGAIN) {
+    // If we got interrupted by a signal while reading the next
+    // fuse command, we will simply retry and read the next thing.
+    return true;
+  } else if (error == ENOENT) {
+    // According to comments in the libfuse code:
+    // ENOENT means the operation was interrupted; it's safe to restart
+    return true;
+  } else if (error == ENODEV) {
+    // ENODEV means the filesystem was unmounted
+    folly::call_once(unmountLogFlag_, [this] {
+      XLOG(DBG3) << "received unmount event ENODEV on mount " << mountPath_;
+    });
+    requestSessionExit(StopReason::UNMOUNTED);
+    return false;
+  } else {
+    XLOG(WARNING) << "error reading from fuse channel: "
+                  << folly::errnoStr(error);
+    requestSessionExit(StopReason::FUSE_READ_ERROR);
+    return false;
+  }
+}
 
-      case FUSE_IOCTL:
-        // Rather than the default ENOSYS, we need to return ENOTTY
-        // to indicate that the requested ioctl is not supported
-        replyError(*header, ENOTTY);
+bool FuseChannel::processRequest(ByteRange request, pid_t myPid) {
+  const auto arg_size = request.size();
+  if (arg_size < sizeof(struct fuse_in_header)) {
+    if (arg_size == 0) {
+      // This code path is hit when a fake FUSE channel is closed in our unit
+      // tests.  On real FUSE channels we should get ENODEV to indicate that
+      // the FUSE channel was shut down.  However, in our unit tests that use
+      // fake FUSE connections we cannot send an ENODEV error, and so we just
+      // close the channel instead.
+      requestSessionExit(StopReason::UNMOUNTED);
+    } else {
+      // We got a partial FUSE header.  This shouldn't ever happen unless
+      // there is a bug in the FUSE kernel code.
+      XLOG(ERR) << "read truncated message from kernel fuse device: len="
+                << arg_size;
+      requestSessionExit(StopReason::FUSE_TRUNCATED_REQUEST);
+    }
+    return false;
+  }
+
+  const auto* header = reinterpret_cast<const fuse_in_header*>(request.data());
+  const ByteRange arg{
+      reinterpret_cast<const uint8_t*>(header + 1),
+      arg_size - sizeof(fuse_in_header)};
+
+  XLOG(DBG7) << "fuse request opcode=" << header->opcode << " "
+             << fuseOpcodeName(header->opcode) << " unique=" << header->unique
+             << " len=" << header->len << " nodeid=" << header->nodeid
+             << " uid=" << header->uid << " gid=" << header->gid
+             << " pid=" << header->pid;
+
+  // On Linux, if security caps are enabled and the FUSE filesystem implements
+  // xattr support, every FUSE_WRITE opcode is preceded by FUSE_GETXATTR for
+  // "security.capability". Until we discover a way to tell the kernel that
+  // they will always return nothing in an Eden mount, short-circuit that path
+  // as efficiently and as early as possible.
+  //
+  // On some systems, the kernel also frequently requests
+  // POSIX ACL xattrs, so fast track those too, if only to make strace
+  // logs easier to follow.
+  if (header->opcode == FUSE_GETXATTR) {
+    const auto getxattr =
+        reinterpret_cast<const fuse_getxattr_in*>(arg.data());
+
+    // Evaluate strlen before the comparison loop below.
+    const StringPiece namePiece{reinterpret_cast<const char*>(getxattr + 1)};
+    static constexpr StringPiece kFastTracks[] = {
+        "security.capability",
+        "system.posix_acl_access",
+        "system.posix_acl_default"};
+
+    // Unclear whether one strlen and matching compares is better than
+    // strcmps, but it's probably in the noise.
+    bool matched = false;
+    for (auto fastTrack : kFastTracks) {
+      if (namePiece == fastTrack) {
+        replyError(*header, ENODATA);
+        matched = true;
         break;
+      }
+    }
+    if (matched) {
+      return true;
+    }
+  }
 
-      default: {
-        if (handlerEntry && handlerEntry->handler) {
-          auto requestId = generateUniqueID();
-          if (handlerEntry->argRenderer &&
-              traceDetailedArguments_->load(std::memory_order_acquire)) {
-            traceBus_->publish(FuseTraceEvent::start(
-                requestId, *header, handlerEntry->argRenderer(arg)));
-          } else {
-            traceBus_->publish(FuseTraceEvent::start(requestId, *header));
-          }
+  // Sanity check to ensure that the request wasn't from ourself.
+  //
+  // We should never make requests to ourself via normal filesytem
+  // operations going through the kernel.  Otherwise we risk deadlocks if the
+  // kernel calls us while holding an inode lock, and we then end up making a
+  // filesystem call that need the same inode lock.  We will then not be able
+  // to resolve this deadlock on kernel inode locks without rebooting the
+  // system.
+  if (UNLIKELY(static_cast<pid_t>(header->pid) == myPid)) {
+    replyError(*header, EIO);
+    XLOG(CRITICAL) << "Received FUSE request from our own pid: opcode="
+                   << header->opcode << " nodeid=" << header->nodeid
+                   << " pid=" << header->pid;
+    return true;
+  }
 
-          // This is a shared_ptr because, due to timeouts, the internal request
-          // lifetime may not match the FUSE request lifetime, so we capture it
-          // in both. I'm sure this could be improved with some cleverness.
-          auto request = std::make_shared<FuseRequestContext>(this, *header);
+  auto* handlerEntry = lookupFuseHandlerEntry(header->opcode);
+  processAccessLog_.recordAccess(
+      header->pid,
+      handlerEntry ? handlerEntry->accessType : AccessType::FsChannelOther);
+
+  switch (header->opcode) {
+    case FUSE_INIT:
+      replyError(*header, EPROTO);
+      throw std::runtime_error(
+          "received FUSE_INIT after we have been initialized!?");
+
+    case FUSE_GETLK:
+    case FUSE_SETLK:
+    case FUSE_SETLKW:
+      // Deliberately not handling locking; this causes
+      // the kernel to do it for us
+      XLOG(DBG7) << fuseOpcodeName(header->opcode);
+      replyError(*header, ENOSYS);
+      break;
 
-          ++state_.wlock()->pendingRequests;
+#ifdef __linux__
+    case FUSE_LSEEK:
+      // We only support stateless file handles, so lseek() is meaningless
+      // for us.  Returning ENOSYS causes the kernel to implement it for us,
+      // and will cause it to stop sending subsequent FUSE_LSEEK requests.
+      XLOG(DBG7) << "FUSE_LSEEK";
+      replyError(*header, ENOSYS);
+      break;
+#endif
 
-          auto headerCopy = *header;
+    case FUSE_POLL:
+      // We do not currently implement FUSE_POLL.
+      XLOG(DBG7) << "FUSE_POLL";
+      replyError(*header, ENOSYS);
+      break;
+
+    case FUSE_INTERRUPT: {
+      // no reply is required
+      XLOG(DBG7) << "FUSE_INTERRUPT";
+      // Ignore it: we don't have a reliable way to guarantee
+      // that interrupting functions correctly.
+      // In addition, the kernel (certainly on macOS) may recycle
+      // ids too quickly for us to safely track by `unique` id.
+      break;
+    }
 
-          FB_LOG(*straceLogger_, DBG7, ([&]() -> std::string {
-            std::string rendered;
-            if (handlerEntry->argRenderer) {
-              rendered = handlerEntry->argRenderer(arg);
-            }
-            return fmt::format(
-                "{}({}{}{})",
-                handlerEntry->getShortName(),
-                headerCopy.nodeid,
-                rendered.empty() ? "" : ", ",
-                rendered);
-          })());
-
-          request
-              ->catchErrors(
-                  folly::makeFutureWith([&] {
-                    request->startRequest(
-                        dispatcher_->getStats(),
-                        handlerEntry->stat,
-                        *(liveRequestWatches_.get()));
-                    return (this->*handlerEntry->handler)(
-                               *request, request->getReq(), arg)
-                        .semi()
-                        .via(&folly::QueuedImmediateExecutor::instance());
-                  }).ensure([request] {
-                    }).within(requestTimeout_),
-                  notifications_)
-              .ensure([this, request, requestId, headerCopy] {
-                traceBus_->publish(FuseTraceEvent::finish(
-                    requestId, headerCopy, request->getResult()));
-
-                // We may be complete; check to see if all requests are
-                // done and whether there are any threads remaining.
-                auto state = state_.wlock();
-                XCHECK_NE(state->pendingRequests, 0u)
-                    << "pendingRequests double decrement";
-                if (--state->pendingRequests == 0 &&
-                    state->stoppedThreads == numThreads_) {
-                  sessionComplete(std::move(state));
-                }
-              });
-          break;
+    case FUSE_DESTROY:
+      XLOG(DBG7) << "FUSE_DESTROY";
+      dispatcher_->destroy();
+      // FUSE on linux doesn't care whether we reply to FUSE_DESTROY
+      // but the macOS implementation blocks the unmount syscall until
+      // we have responded, which in turn blocks our attempt to gracefully
+      // unmount, so we respond here.  It doesn't hurt Linux to respond
+      // so we do it for both platforms.
+      replyError(*header, 0);
+      break;
+
+    case FUSE_NOTIFY_REPLY:
+      XLOG(DBG7) << "FUSE_NOTIFY_REPLY";
+      // Don't strictly need to do anything here, but may want to
+      // turn the kernel notifications in Futures and use this as
+      // a way to fulfil the promise
+      break;
+
+    case FUSE_IOCTL:
+      // Rather than the default ENOSYS, we need to return ENOTTY
+      // to indicate that the requested ioctl is not supported
+      replyError(*header, ENOTTY);
+      break;
+
+    default: {
+      if (handlerEntry && handlerEntry->handler) {
+        auto requestId = generateUniqueID();
+        if (handlerEntry->argRenderer &&
+            traceDetailedArguments_->load(std::memory_order_acquire)) {
+          traceBus_->publish(FuseTraceEvent::start(
+              requestId, *header, handlerEntry->argRenderer(arg)));
+        } else {
+          traceBus_->publish(FuseTraceEvent::start(requestId, *header));
         }
 
-        const auto opcode = header->opcode;
-        tryRlockCheckBeforeUpdate<folly::Unit>(
-            unhandledOpcodes_,
-            [&](const auto& unhandledOpcodes) -> std::optional<folly::Unit> {
-              if (unhandledOpcodes.find(opcode) != unhandledOpcodes.end()) {
-                return folly::unit;
+        // This is a shared_ptr because, due to timeouts, the internal request
+        // lifetime may not match the FUSE request lifetime, so we capture it
+        // in both. I'm sure this could be improved with some cleverness.
+        auto request = std::make_shared<FuseRequestContext>(this, *header);
+
+        ++state_.wlock()->pendingRequests;
+
+        auto headerCopy = *header;
+
+        FB_LOG(*straceLogger_, DBG7, ([&]() -> std::string {
+          std::string rendered;
+          if (handlerEntry->argRenderer) {
+            rendered = handlerEntry->argRenderer(arg);
+          }
+          return fmt::format(
+              "{}({}{}{})",
+              handlerEntry->getShortName(),
+              headerCopy.nodeid,
+              rendered.empty() ? "" : ", ",
+              rendered);
+        })());
+
+        request
+            ->catchErrors(
+                folly::makeFutureWith([&] {
+                  ProfilerLabel profilerLabel{handlerEntry->name.data()};
+                  request->startRequest(
+                      dispatcher_->getStats(),
+                      handlerEntry->stat,
+                      *(liveRequestWatches_.get()));
+                  return (this->*handlerEntry->handler)(
+                             *request, request->getReq(), arg)
+                      .semi()
+                      .via(&folly::QueuedImmediateExecutor::instance());
+                }).ensure([request] {
+                  }).within(requestTimeout_),
+                notifications_)
+            .ensure([this, request, requestId, headerCopy] {
+              traceBus_->publish(FuseTraceEvent::finish(
+                  requestId, headerCopy, request->getResult()));
+
+              // We may be complete; check to see if all requests are
+              // done and whether there are any threads remaining.
+              auto state = state_.wlock();
+              XCHECK_NE(state->pendingRequests, 0u)
+                  << "pendingRequests double decrement";
+              if (--state->pendingRequests == 0 &&
+                  state->stoppedThreads == numThreads_) {
+                sessionComplete(std::move(state));
               }
-              return std::nullopt;
-            },
-            [&](auto& unhandledOpcodes) -> folly::Unit {
-              XLOG(WARN) << "unhandled fuse opcode " << opcode << "("
-                         << fuseOpcodeName(opcode) << ")";
-              unhandledOpcodes->insert(opcode);
-              return folly::unit;
             });
-
-        try {
-          replyError(*header, ENOSYS);
-        } catch (const std::system_error& exc) {
-          XLOG(ERR) << "Failed to write error response to fuse: " << exc.what();
-          requestSessionExit(StopReason::FUSE_WRITE_ERROR);
-          return;
-        }
         break;
       }
+
+      const auto opcode = header->opcode;
+      tryRlockCheckBeforeUpdate<folly::Unit>(
+          unhandledOpcodes_,
+          [&](const auto& unhandledOpcodes) -> std::optional<folly::Unit> {
+            if (unhandledOpcodes.find(opcode) != unhandledOpcodes.end()) {
+              return folly::unit;
+            }
+            return std::nullopt;
+          },
+          [&](auto& unhandledOpcodes) -> folly::Unit {
+            XLOG(WARN) << "unhandled fuse opcode " << opcode << "("
+                       << fuseOpcodeName(opcode) << ")";
+            unhandledOpcodes->insert(opcode);
+            return folly::unit;
+          });
+
+      try {
+        replyError(*header, ENOSYS);
+      } catch (const std::system_error& exc) {
+        XLOG(ERR) << "Failed to write error response to fuse: " << exc.what();
+        requestSessionExit(StopReason::FUSE_WRITE_ERROR);
+        return false;
+      }
+      break;
     }
   }
+  return true;
 }
 
 void FuseChannel::sessionComplete(folly::Synchronized<State>::LockedPtr state) {
@@ -1863,8 +2559,19 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseRead(
   XLOG(DBG7) << "FUSE_READ";
 
   auto ino = InodeNumber{header.nodeid};
-  return dispatcher_->read(ino, read->size, read->offset, request)
-      .thenValue([&request](BufVec&& buf) { request.sendReply(*buf); });
+  // Only ask for a file reference if the kernel agreed to splicing, as
+  // otherwise it would just be copied into memory again.
+#ifdef __linux__
+  bool allowFileReference =
+      spliceReadReplies_ && (connInfo_->flags & FUSE_SPLICE_WRITE);
+#else
+  bool allowFileReference = false;
+#endif
+  return dispatcher_
+      ->read(ino, read->size, read->offset, allowFileReference, request)
+      .thenValue([&request](BufVec&& buf) {
+        request.sendReply(std::move(buf));
+      });
 }
 
 ImmediateFuture<folly::Unit> FuseChannel::fuseWrite(
@@ -2132,6 +2839,15 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseLink(
       });
 }
 
+ImportPriority FuseChannel::getRequestPriority(uint32_t opcode) const {
+  if (prioritizeMetadataRequests_ && opcode == FUSE_READ) {
+    // Reads of unfetched files are slow and come in bulk, while most other
+    // requests only need trees, which are fetched once for many requests.
+    return ImportPriority::kNormal();
+  }
+  return ImportPriority::kHigh();
+}
+
 ImmediateFuture<folly::Unit> FuseChannel::fuseOpen(
     FuseRequestContext& request,
     const fuse_in_header& header,
@@ -2327,6 +3043,24 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseReadDir(
       });
 }
 
+#ifdef __linux__
+ImmediateFuture<folly::Unit> FuseChannel::fuseReadDirPlus(
+    FuseRequestContext& request,
+    const fuse_in_header& header,
+    ByteRange arg) {
+  auto read = reinterpret_cast<const fuse_read_in*>(arg.data());
+  XLOG(DBG7) << "FUSE_READDIRPLUS";
+  auto ino = InodeNumber{header.nodeid};
+  return dispatcher_
+      ->readdirplus(
+          ino, FuseDirPlusList{read->size}, read->offset, read->fh, request)
+      .thenValue([&request](FuseDirPlusList&& list) {
+        const auto buf = list.getBuf();
+        request.sendReply(StringPiece{buf});
+      });
+}
+#endif
+
 ImmediateFuture<folly::Unit> FuseChannel::fuseReleaseDir(
     FuseRequestContext& request,
     const fuse_in_header& header,
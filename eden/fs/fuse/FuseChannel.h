@@ -27,9 +27,13 @@
 
 #include "eden/fs/fuse/FuseDispatcher.h"
 #include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/store/ImportPriority.h"
+#include "eden/fs/telemetry/FlightRecorder.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/telemetry/TraceBus.h"
+#include "eden/fs/utils/BufVec.h"
 #include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/CpuAffinity.h"
 #include "eden/fs/utils/FsChannelTypes.h"
 #include "eden/fs/utils/PathFuncs.h"
 #include "eden/fs/utils/ProcessAccessLog.h"
@@ -158,6 +162,27 @@ struct FuseTraceEvent : TraceEventBase {
   Details details_;
 };
 
+/**
+ * What the FuseChannel's flight recorder keeps of a FuseTraceEvent. Detailed
+ * arguments are dropped so records stay cheap to copy.
+ */
+struct FuseTraceRecord : TraceEventBase {
+  explicit FuseTraceRecord(const FuseTraceEvent& event)
+      : TraceEventBase{event},
+        unique{event.getUnique()},
+        request{event.getRequest()},
+        type{event.getType()} {
+    if (type == FuseTraceEvent::FINISH) {
+      result = event.getResponseCode();
+    }
+  }
+
+  uint64_t unique;
+  FuseTraceEvent::RequestHeader request;
+  FuseTraceEvent::Type type;
+  std::optional<int64_t> result;
+};
+
 class FuseChannel {
  public:
   enum class StopReason {
@@ -232,7 +257,13 @@ class FuseChannel {
       Notifications* FOLLY_NULLABLE notifications,
       CaseSensitivity caseSensitive,
       bool requireUtf8Path,
-      int32_t maximumBackgroundRequests);
+      int32_t maximumBackgroundRequests,
+      bool spliceReadReplies,
+      bool readdirPlus,
+      bool writebackCache,
+      bool prioritizeMetadataRequests,
+      bool useIoUring,
+      CpuAffinityPolicy workerAffinity);
 
   /**
    * Destroy the FuseChannel.
@@ -328,8 +359,15 @@ class FuseChannel {
    *
    * @param parent inode number
    * @param name file name
+   * @param child the inode number the entry refers to, if known.  The kernel
+   *              drops the cached entries of the whole subtree below the
+   *              entry, so queued invalidations of entries inside child can
+   *              be skipped.
    */
-  void invalidateEntry(InodeNumber parent, PathComponentPiece name);
+  void invalidateEntry(
+      InodeNumber parent,
+      PathComponentPiece name,
+      std::optional<InodeNumber> child = std::nullopt);
 
   /*
    * Request that the kernel invalidate its cached data for the specified
@@ -350,6 +388,10 @@ class FuseChannel {
    * scheduled before this flushInvalidations() call have finished.  This
    * future will normally be completed in the FuseChannel's invalidation
    * thread.
+   *
+   * Invalidations queued between two flushes may be coalesced before they
+   * are sent: overlapping data ranges of an inode are merged, and duplicate
+   * or subsumed directory entry invalidations are dropped.
    */
   FOLLY_NODISCARD folly::Future<folly::Unit> flushInvalidations();
 
@@ -376,6 +418,22 @@ class FuseChannel {
    */
   void sendRawReply(const iovec iov[], size_t count) const;
 
+#ifdef __linux__
+  /**
+   * Attempts to splice a reply whose payload is a file range. Returns false
+   * if splicing is not possible and the reply must be sent by copying.
+   *
+   * throws system_error if the final write to the FUSE device fails.
+   */
+  bool trySpliceReply(const fuse_in_header& request, const BufVec& buf) const;
+#endif
+
+  /**
+   * Logs and throws an error from writing a reply to the FUSE device.
+   */
+  [[noreturn]] void throwWriteError(int err) const;
+  void logWriteError(int err) const;
+
   /**
    * Sends a range of contiguous bytes as a reply to the kernel.
    * request holds the context of the request to which we are replying.
@@ -413,6 +471,16 @@ class FuseChannel {
    */
   void sendReply(const fuse_in_header& request, const folly::IOBuf& buf) const;
 
+  /**
+   * Sends a read reply. If the data refers to a file range and splicing was
+   * negotiated with the kernel, it is spliced from the file to the FUSE
+   * device through a pipe without being copied into userspace. Otherwise it
+   * is read into memory and sent like any other reply.
+   *
+   * throws system_error if the write fails.
+   */
+  void sendReply(const fuse_in_header& request, BufVec&& buf) const;
+
   /**
    * Sends a reply to the kernel.
    * The payload parameter is typically a fuse_out_XXX struct as defined
@@ -451,10 +519,24 @@ class FuseChannel {
     return *traceBus_;
   }
 
+  /**
+   * Always records the most recent FuseTraceEvents, and snapshots them when a
+   * request takes longer than SlowRequestLog::kThreshold.
+   */
+  const FlightRecorder<FuseTraceRecord>& getFlightRecorder() const {
+    return flightRecorder_;
+  }
+
   ProcessAccessLog& getProcessAccessLog() {
     return processAccessLog_;
   }
 
+  /**
+   * The priority with which the object fetches of a request of this opcode
+   * are imported, see EdenConfig::fusePrioritizeMetadataRequests.
+   */
+  ImportPriority getRequestPriority(uint32_t opcode) const;
+
   Notifications* FOLLY_NULLABLE getNotifications() const {
     return notifications_;
   }
@@ -522,13 +604,18 @@ class FuseChannel {
   };
   struct InvalidationEntry {
     InvalidationEntry(InodeNumber inode, int64_t offset, int64_t length);
-    InvalidationEntry(InodeNumber inode, PathComponentPiece name);
+    InvalidationEntry(
+        InodeNumber inode,
+        PathComponentPiece name,
+        InodeNumber child);
     explicit InvalidationEntry(folly::Promise<folly::Unit> promise);
     InvalidationEntry(InvalidationEntry&& other) noexcept;
     ~InvalidationEntry();
 
     InvalidationType type;
     InodeNumber inode;
+    // For DIR_ENTRY, the inode the entry refers to, or 0 if unknown.
+    InodeNumber child;
     union {
       PathComponent name;
       DataRange range;
@@ -656,6 +743,12 @@ class FuseChannel {
       FuseRequestContext& request,
       const fuse_in_header& header,
       folly::ByteRange arg);
+#ifdef __linux__
+  ImmediateFuture<folly::Unit> fuseReadDirPlus(
+      FuseRequestContext& request,
+      const fuse_in_header& header,
+      folly::ByteRange arg);
+#endif
   ImmediateFuture<folly::Unit> fuseReleaseDir(
       FuseRequestContext& request,
       const fuse_in_header& header,
@@ -692,6 +785,7 @@ class FuseChannel {
   void invalidationThread() noexcept;
   void stopInvalidationThread();
   void sendInvalidation(InvalidationEntry& entry);
+  static size_t coalesceInvalidations(std::vector<InvalidationEntry>& entries);
   void sendInvalidateInode(InodeNumber ino, int64_t off, int64_t len);
   void sendInvalidateEntry(InodeNumber parent, PathComponentPiece name);
   void readInitPacket();
@@ -726,6 +820,27 @@ class FuseChannel {
    */
   void processSession();
 
+  /**
+   * The io_uring flavor of processSession(). Each worker keeps several reads
+   * of the FUSE device in flight in registered buffers, and replies sent
+   * from the worker thread are batched into the same ring. Returns false
+   * without processing anything if a ring could not be set up, in which case
+   * the caller should fall back to blocking reads.
+   */
+  bool processSessionWithIoUring();
+
+  /**
+   * Handles a single request read from the FUSE device. Returns false if the
+   * worker should stop processing requests.
+   */
+  bool processRequest(folly::ByteRange request, pid_t myPid);
+
+  /**
+   * Handles an error reading from the FUSE device. Returns true if the read
+   * should be retried and false if the worker should stop.
+   */
+  bool handleReadError(int error);
+
   /**
    * Requests that the worker threads terminate their processing loop.
    */
@@ -747,6 +862,17 @@ class FuseChannel {
   CaseSensitivity caseSensitive_;
   bool requireUtf8Path_;
   int32_t maximumBackgroundRequests_;
+  const bool spliceReadReplies_;
+  const bool readdirPlus_;
+  const bool writebackCache_;
+  const bool prioritizeMetadataRequests_;
+  const bool useIoUring_;
+  const CpuAffinityPolicy workerAffinity_;
+  /**
+   * The node the channel was created on, that NodeLocal worker threads are
+   * bound to.
+   */
+  const size_t homeNode_;
 
   /*
    * connInfo_ is modified during the initialization process,
@@ -778,6 +904,16 @@ class FuseChannel {
    */
   std::atomic<bool> stop_{false};
   folly::once_flag unmountLogFlag_;
+  /**
+   * The index of the next worker thread to start, for workerAffinity_.
+   */
+  std::atomic<size_t> nextWorkerIndex_{0};
+
+  /*
+   * An eventfd that becomes readable once stop_ is set. io_uring workers
+   * poll it so they wake up reliably for shutdown. Only open if useIoUring_.
+   */
+  folly::File stopEvent_;
   folly::Synchronized<State> state_;
   folly::Promise<StopFuture> initPromise_;
   folly::Promise<StopData> sessionCompletePromise_;
@@ -810,6 +946,9 @@ class FuseChannel {
   std::vector<TraceSubscriptionHandle<FuseTraceEvent>>
       traceSubscriptionHandles_;
 
+  // Written by the request tracking subscriber.
+  FlightRecorder<FuseTraceRecord> flightRecorder_;
+
   /*
    * TraceBus subscribers can indicate they would like detailed argument strings
    * for FUSE requests. These are relatively expensive to compute, so argument
@@ -171,6 +171,7 @@ ImmediateFuture<BufVec> FuseDispatcher::read(
     InodeNumber /*ino*/,
     size_t /*size*/,
     off_t /*off*/,
+    bool /*allowFileReference*/,
     ObjectFetchContext& /*context*/) {
   FUSELL_NOT_IMPL();
 }
@@ -212,6 +213,17 @@ ImmediateFuture<FuseDirList> FuseDispatcher::readdir(
   FUSELL_NOT_IMPL();
 }
 
+#ifdef __linux__
+ImmediateFuture<FuseDirPlusList> FuseDispatcher::readdirplus(
+    InodeNumber,
+    FuseDirPlusList&&,
+    off_t,
+    uint64_t,
+    ObjectFetchContext&) {
+  FUSELL_NOT_IMPL();
+}
+#endif
+
 ImmediateFuture<struct fuse_kstatfs> FuseDispatcher::statfs(
     InodeNumber /*ino*/) {
   struct fuse_kstatfs info = {};
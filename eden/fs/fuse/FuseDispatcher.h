@@ -26,6 +26,7 @@ namespace facebook::eden {
   } while (0)
 
 class FuseDirList;
+class FuseDirPlusList;
 class EdenStats;
 
 class FuseDispatcher {
@@ -298,9 +299,15 @@ class FuseDispatcher {
    *
    * @param size number of bytes to read
    * @param off offset to read from
+   * @param allowFileReference whether the result may refer to a range of a
+   *        file instead of holding the data, so that it can be spliced
    */
-  virtual ImmediateFuture<BufVec>
-  read(InodeNumber ino, size_t size, off_t off, ObjectFetchContext& context);
+  virtual ImmediateFuture<BufVec> read(
+      InodeNumber ino,
+      size_t size,
+      off_t off,
+      bool allowFileReference,
+      ObjectFetchContext& context);
 
   /**
    * Write data
@@ -386,6 +393,23 @@ class FuseDispatcher {
       uint64_t fh,
       ObjectFetchContext& context);
 
+#ifdef __linux__
+  /**
+   * Read directory, along with the attributes of its entries.
+   *
+   * Send a FuseDirPlusList filled using FuseDirPlusList::add(), with the
+   * entry parameters of the entries that were looked up set. Each one with a
+   * nonzero nodeid counts as a lookup() of that inode and must be matched by
+   * a forget().
+   */
+  virtual ImmediateFuture<FuseDirPlusList> readdirplus(
+      InodeNumber ino,
+      FuseDirPlusList&& dirList,
+      off_t offset,
+      uint64_t fh,
+      ObjectFetchContext& context);
+#endif
+
   /**
    * Get file system statistics
    *
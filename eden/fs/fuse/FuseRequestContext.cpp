@@ -22,7 +22,9 @@ namespace facebook::eden {
 FuseRequestContext::FuseRequestContext(
     FuseChannel* channel,
     const fuse_in_header& fuseHeader)
-    : RequestContext(channel->getProcessAccessLog()),
+    : RequestContext(
+          channel->getProcessAccessLog(),
+          channel->getRequestPriority(fuseHeader.opcode)),
       channel_(channel),
       fuseHeader_(fuseHeader) {}
 
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/fuse/IoUring.h"
+
+#ifdef EDEN_HAVE_IO_URING
+
+#include <folly/Exception.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace facebook::eden {
+
+namespace {
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(
+    int fd,
+    unsigned toSubmit,
+    unsigned minComplete,
+    unsigned flags) {
+  return static_cast<int>(syscall(
+      __NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, const void* arg, unsigned count) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+template <typename T>
+T* ringPointer(void* ring, unsigned offset) {
+  return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+}
+} // namespace
+
+IoUring::IoUring(unsigned entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  fd_ = ioUringSetup(entries, &params);
+  folly::checkUnixError(fd_, "io_uring_setup failed");
+  features_ = params.features;
+
+  sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (singleMmap) {
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+  }
+
+  auto map = [this](size_t size, off_t offset) {
+    auto* ptr = mmap(
+        nullptr,
+        size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        fd_,
+        offset);
+    folly::checkUnixError(
+        ptr == MAP_FAILED ? -1 : 0, "unable to map io_uring");
+    return ptr;
+  };
+
+  try {
+    sqRing_ = map(sqRingSize_, IORING_OFF_SQ_RING);
+    if (singleMmap) {
+      cqRing_ = sqRing_;
+    } else {
+      cqRing_ = map(cqRingSize_, IORING_OFF_CQ_RING);
+    }
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(map(sqesSize_, IORING_OFF_SQES));
+  } catch (...) {
+    unmapAndClose();
+    throw;
+  }
+
+  sqHead_ = ringPointer<unsigned>(sqRing_, params.sq_off.head);
+  sqTail_ = ringPointer<unsigned>(sqRing_, params.sq_off.tail);
+  sqMask_ = *ringPointer<unsigned>(sqRing_, params.sq_off.ring_mask);
+  sqEntries_ = *ringPointer<unsigned>(sqRing_, params.sq_off.ring_entries);
+  sqArray_ = ringPointer<unsigned>(sqRing_, params.sq_off.array);
+  sqeTail_ = *sqTail_;
+
+  cqHead_ = ringPointer<unsigned>(cqRing_, params.cq_off.head);
+  cqTail_ = ringPointer<unsigned>(cqRing_, params.cq_off.tail);
+  cqMask_ = *ringPointer<unsigned>(cqRing_, params.cq_off.ring_mask);
+  cqes_ = ringPointer<io_uring_cqe>(cqRing_, params.cq_off.cqes);
+}
+
+IoUring::~IoUring() {
+  unmapAndClose();
+}
+
+void IoUring::unmapAndClose() {
+  if (sqes_) {
+    munmap(sqes_, sqesSize_);
+    sqes_ = nullptr;
+  }
+  if (cqRing_ && cqRing_ != sqRing_) {
+    munmap(cqRing_, cqRingSize_);
+  }
+  cqRing_ = nullptr;
+  if (sqRing_) {
+    munmap(sqRing_, sqRingSize_);
+    sqRing_ = nullptr;
+  }
+  if (fd_ >= 0) {
+    // Closing the ring cancels any requests that are still in flight.
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+bool IoUring::registerBuffers(const iovec* iovs, unsigned count) {
+  return ioUringRegister(fd_, IORING_REGISTER_BUFFERS, iovs, count) == 0;
+}
+
+io_uring_sqe* IoUring::getSqe() {
+  auto head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+  if (sqeTail_ - head >= sqEntries_) {
+    return nullptr;
+  }
+  auto index = sqeTail_ & sqMask_;
+  sqArray_[index] = index;
+  ++sqeTail_;
+
+  auto* sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+unsigned IoUring::getPendingSubmissions() const {
+  return sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+}
+
+int IoUring::submit(unsigned waitFor) {
+  // Entries the kernel has not consumed yet, including any left over from a
+  // previous io_uring_enter that was interrupted.
+  auto toSubmit = getPendingSubmissions();
+  __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+  if (toSubmit == 0 && waitFor == 0) {
+    return 0;
+  }
+
+  auto res = ioUringEnter(
+      fd_, toSubmit, waitFor, waitFor > 0 ? IORING_ENTER_GETEVENTS : 0);
+  return res < 0 ? -errno : res;
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifdef __linux__
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(IORING_FEAT_NODROP)
+#define EDEN_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+#ifdef EDEN_HAVE_IO_URING
+
+#include <sys/uio.h>
+#include <cstddef>
+
+namespace facebook::eden {
+
+/**
+ * A minimal io_uring instance driven through the raw syscalls.
+ *
+ * This is not thread safe: each ring is meant to be owned by a single FUSE
+ * worker thread, which prepares submissions, submits them in batches and
+ * reaps their completions.
+ */
+class IoUring {
+ public:
+  /**
+   * Create a ring with room for at least the given number of submissions.
+   *
+   * Throws std::system_error if the kernel does not support io_uring or the
+   * ring cannot be created.
+   */
+  explicit IoUring(unsigned entries);
+  ~IoUring();
+
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  /**
+   * The IORING_FEAT_* flags supported by the kernel.
+   */
+  unsigned getFeatures() const {
+    return features_;
+  }
+
+  /**
+   * Register buffers for use with IORING_OP_READ_FIXED. Returns false if the
+   * kernel refused, e.g. because of RLIMIT_MEMLOCK, in which case callers
+   * should use unregistered reads.
+   */
+  bool registerBuffers(const iovec* iovs, unsigned count);
+
+  /**
+   * Returns a zeroed submission to fill in, or nullptr if the submission
+   * queue is full. The entry is submitted by the next submit() call.
+   */
+  io_uring_sqe* getSqe();
+
+  /**
+   * The number of prepared submissions not yet consumed by the kernel.
+   */
+  unsigned getPendingSubmissions() const;
+
+  /**
+   * Submit all prepared entries and wait until at least waitFor completions
+   * are available. Returns the number of entries submitted, or -errno.
+   * EINTR is returned as-is so callers can check for shutdown.
+   */
+  int submit(unsigned waitFor = 0);
+
+  /**
+   * Call fn(const io_uring_cqe&) for each available completion, consuming
+   * them. Returns the number of completions seen.
+   */
+  template <typename Fn>
+  unsigned reapCompletions(Fn&& fn) {
+    unsigned head = *cqHead_;
+    unsigned count = 0;
+    while (head != __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+      fn(cqes_[head & cqMask_]);
+      ++head;
+      ++count;
+      // Release the entry as soon as it has been handled, so that the kernel
+      // can reuse it even if fn() submits more work.
+      __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    }
+    return count;
+  }
+
+ private:
+  void unmapAndClose();
+
+  int fd_{-1};
+  unsigned features_{0};
+
+  void* sqRing_{nullptr};
+  size_t sqRingSize_{0};
+  void* cqRing_{nullptr};
+  size_t cqRingSize_{0};
+  io_uring_sqe* sqes_{nullptr};
+  size_t sqesSize_{0};
+
+  unsigned* sqHead_{nullptr};
+  unsigned* sqTail_{nullptr};
+  unsigned sqMask_{0};
+  unsigned sqEntries_{0};
+  unsigned* sqArray_{nullptr};
+  // Entries handed out by getSqe() are published to the kernel up to
+  // sqeTail_ by submit().
+  unsigned sqeTail_{0};
+
+  unsigned* cqHead_{nullptr};
+  unsigned* cqTail_{nullptr};
+  unsigned cqMask_{0};
+  io_uring_cqe* cqes_{nullptr};
+};
+
+} // namespace facebook::eden
+
+#endif
@@ -13,12 +13,17 @@
 #include <sys/types.h>
 #include <chrono>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace folly {
 class EventBase;
 class File;
 template <typename T>
 class Future;
+template <typename T>
+class Try;
 struct Unit;
 } // namespace folly
 
@@ -73,7 +78,8 @@ class PrivHelper {
       folly::SocketAddress mountdAddr,
       folly::SocketAddress nfsdAddr,
       bool readOnly,
-      uint32_t iosize) = 0;
+      uint32_t iosize,
+      bool useReaddirplus) = 0;
 
   /**
    * Ask the privileged helper process to perform a fuse unmount.
@@ -94,6 +100,19 @@ class PrivHelper {
       folly::StringPiece clientPath,
       folly::StringPiece mountPath) = 0;
 
+  /**
+   * Perform several bind mounts with a single request, given as
+   * (clientPath, mountPath) pairs. The privhelper process performs them
+   * concurrently, except that a mountPath nested under another one of the
+   * batch is only mounted once that one is.
+   *
+   * Returns the result of each bind mount, in the same order. The future
+   * itself only fails if the whole request does.
+   */
+  FOLLY_NODISCARD virtual folly::Future<std::vector<folly::Try<folly::Unit>>>
+  bindMounts(
+      const std::vector<std::pair<std::string, std::string>>& bindMounts) = 0;
+
   FOLLY_NODISCARD virtual folly::Future<folly::Unit> bindUnMount(
       folly::StringPiece mountPath) = 0;
 
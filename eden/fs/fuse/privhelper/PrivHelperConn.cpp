@@ -171,7 +171,8 @@ UnixSocket::Message PrivHelperConn::serializeMountNfsRequest(
     folly::SocketAddress mountdAddr,
     folly::SocketAddress nfsdAddr,
     bool readOnly,
-    uint32_t iosize) {
+    uint32_t iosize,
+    bool useReaddirplus) {
   auto msg = serializeHeader(xid, REQ_MOUNT_NFS);
   Appender appender(&msg.data, kDefaultBufferSize);
 
@@ -180,6 +181,7 @@ UnixSocket::Message PrivHelperConn::serializeMountNfsRequest(
   serializeSocketAddress(appender, nfsdAddr);
   serializeBool(appender, readOnly);
   serializeUint32(appender, iosize);
+  serializeBool(appender, useReaddirplus);
   return msg;
 }
 
@@ -189,12 +191,14 @@ void PrivHelperConn::parseMountNfsRequest(
     folly::SocketAddress& mountdAddr,
     folly::SocketAddress& nfsdAddr,
     bool& readOnly,
-    uint32_t& iosize) {
+    uint32_t& iosize,
+    bool& useReaddirplus) {
   mountPoint = deserializeString(cursor);
   mountdAddr = deserializeSocketAddress(cursor);
   nfsdAddr = deserializeSocketAddress(cursor);
   readOnly = deserializeBool(cursor);
   iosize = deserializeUint32(cursor);
+  useReaddirplus = deserializeBool(cursor);
   checkAtEnd(cursor, "mount nfs request");
 }
 
@@ -278,6 +282,10 @@ void PrivHelperConn::parseEmptyResponse(
     MsgType reqType,
     const UnixSocket::Message& msg) {
   Cursor cursor(&msg.data);
+  parseResponseHeader(reqType, cursor);
+}
+
+void PrivHelperConn::parseResponseHeader(MsgType reqType, Cursor& cursor) {
   auto xid = cursor.readBE<uint32_t>();
   auto msgType = static_cast<MsgType>(cursor.readBE<uint32_t>());
 
@@ -315,6 +323,75 @@ void PrivHelperConn::parseBindMountRequest(
   checkAtEnd(cursor, "bind mount request");
 }
 
+UnixSocket::Message PrivHelperConn::serializeBindMountBatchRequest(
+    uint32_t xid,
+    const std::vector<std::pair<std::string, std::string>>& bindMounts) {
+  auto msg = serializeHeader(xid, REQ_MOUNT_BIND_BATCH);
+  Appender appender(&msg.data, kDefaultBufferSize);
+
+  appender.writeBE<uint32_t>(bindMounts.size());
+  for (const auto& [clientPath, mountPath] : bindMounts) {
+    serializeString(appender, mountPath);
+    serializeString(appender, clientPath);
+  }
+  return msg;
+}
+
+void PrivHelperConn::parseBindMountBatchRequest(
+    Cursor& cursor,
+    std::vector<std::pair<std::string, std::string>>& bindMounts) {
+  auto n = cursor.readBE<uint32_t>();
+  while (n-- != 0) {
+    auto mountPath = deserializeString(cursor);
+    auto clientPath = deserializeString(cursor);
+    bindMounts.emplace_back(std::move(clientPath), std::move(mountPath));
+  }
+  checkAtEnd(cursor, "bind mount batch request");
+}
+
+void PrivHelperConn::serializeBindMountBatchResponse(
+    Appender& appender,
+    const std::vector<std::exception_ptr>& results) {
+  appender.writeBE<uint32_t>(results.size());
+  for (const auto& result : results) {
+    serializeBool(appender, !result);
+    if (!result) {
+      continue;
+    }
+    try {
+      std::rethrow_exception(result);
+    } catch (const std::exception& ex) {
+      serializeErrorResponse(appender, ex);
+    } catch (...) {
+      serializeErrorResponse(appender, "unknown error");
+    }
+  }
+}
+
+std::vector<folly::Try<folly::Unit>>
+PrivHelperConn::parseBindMountBatchResponse(const UnixSocket::Message& msg) {
+  Cursor cursor(&msg.data);
+  parseResponseHeader(REQ_MOUNT_BIND_BATCH, cursor);
+
+  std::vector<folly::Try<folly::Unit>> results;
+  auto n = cursor.readBE<uint32_t>();
+  results.reserve(n);
+  while (n-- != 0) {
+    if (deserializeBool(cursor)) {
+      results.emplace_back(folly::unit);
+      continue;
+    }
+    try {
+      rethrowErrorResponse(cursor);
+    } catch (const std::exception&) {
+      results.emplace_back(
+          folly::exception_wrapper{std::current_exception()});
+    }
+  }
+  checkAtEnd(cursor, "bind mount batch response");
+  return results;
+}
+
 UnixSocket::Message PrivHelperConn::serializeSetDaemonTimeoutRequest(
     uint32_t xid,
     std::chrono::nanoseconds duration) {
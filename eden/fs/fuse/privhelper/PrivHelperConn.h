@@ -8,8 +8,13 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/Try.h>
 #include <cinttypes>
+#include <exception>
 #include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 #include "eden/fs/utils/UnixSocket.h"
 
 namespace folly {
@@ -47,6 +52,7 @@ class PrivHelperConn {
     REQ_SET_USE_EDENFS = 10,
     REQ_MOUNT_NFS = 11,
     REQ_UNMOUNT_NFS = 12,
+    REQ_MOUNT_BIND_BATCH = 13,
   };
 
   /**
@@ -85,14 +91,16 @@ class PrivHelperConn {
       folly::SocketAddress mountdAddr,
       folly::SocketAddress nfsdAddr,
       bool readOnly,
-      uint32_t iosize);
+      uint32_t iosize,
+      bool useReaddirplus);
   static void parseMountNfsRequest(
       folly::io::Cursor& cursor,
       std::string& mountPoint,
       folly::SocketAddress& mountdAddr,
       folly::SocketAddress& nfsdAddr,
       bool& readOnly,
-      uint32_t& iosize);
+      uint32_t& iosize,
+      bool& useReaddirplus);
 
   static UnixSocket::Message serializeUnmountRequest(
       uint32_t xid,
@@ -117,6 +125,24 @@ class PrivHelperConn {
       std::string& clientPath,
       std::string& mountPath);
 
+  /**
+   * A batch of bind mounts, each a (clientPath, mountPath) pair.
+   *
+   * Its response has the result of each bind mount, in the same order:
+   * either success, or the same error data as a RESP_ERROR response.
+   */
+  static UnixSocket::Message serializeBindMountBatchRequest(
+      uint32_t xid,
+      const std::vector<std::pair<std::string, std::string>>& bindMounts);
+  static void parseBindMountBatchRequest(
+      folly::io::Cursor& cursor,
+      std::vector<std::pair<std::string, std::string>>& bindMounts);
+  static void serializeBindMountBatchResponse(
+      folly::io::Appender& appender,
+      const std::vector<std::exception_ptr>& results);
+  static std::vector<folly::Try<folly::Unit>> parseBindMountBatchResponse(
+      const UnixSocket::Message& msg);
+
   static UnixSocket::Message serializeBindUnMountRequest(
       uint32_t xid,
       folly::StringPiece mountPath);
@@ -169,6 +195,11 @@ class PrivHelperConn {
   static void parseEmptyResponse(
       MsgType reqType,
       const UnixSocket::Message& msg);
+  /**
+   * Read the header of a response, throwing like parseEmptyResponse(). The
+   * cursor is then at the start of its body.
+   */
+  static void parseResponseHeader(MsgType reqType, folly::io::Cursor& cursor);
 
   static void serializeErrorResponse(
       folly::io::Appender& appender,
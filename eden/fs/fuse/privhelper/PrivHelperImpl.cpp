@@ -109,11 +109,14 @@ class PrivHelperClientImpl : public PrivHelper,
       folly::SocketAddress mountdAddr,
       folly::SocketAddress nfsdAddr,
       bool readOnly,
-      uint32_t iosize) override;
+      uint32_t iosize,
+      bool useReaddirplus) override;
   Future<Unit> fuseUnmount(StringPiece mountPath) override;
   Future<Unit> nfsUnmount(StringPiece mountPath) override;
   Future<Unit> bindMount(StringPiece clientPath, StringPiece mountPath)
       override;
+  Future<vector<folly::Try<Unit>>> bindMounts(
+      const vector<std::pair<string, string>>& bindMounts) override;
   folly::Future<folly::Unit> bindUnMount(folly::StringPiece mountPath) override;
   Future<Unit> takeoverShutdown(StringPiece mountPath) override;
   Future<Unit> takeoverStartup(
@@ -391,10 +394,11 @@ Future<Unit> PrivHelperClientImpl::nfsMount(
     folly::SocketAddress mountdAddr,
     folly::SocketAddress nfsdAddr,
     bool readOnly,
-    uint32_t iosize) {
+    uint32_t iosize,
+    bool useReaddirplus) {
   auto xid = getNextXid();
   auto request = PrivHelperConn::serializeMountNfsRequest(
-      xid, mountPath, mountdAddr, nfsdAddr, readOnly, iosize);
+      xid, mountPath, mountdAddr, nfsdAddr, readOnly, iosize, useReaddirplus);
   return sendAndRecv(xid, std::move(request))
       .thenValue([](UnixSocket::Message&& response) {
         PrivHelperConn::parseEmptyResponse(
@@ -436,6 +440,18 @@ Future<Unit> PrivHelperClientImpl::bindMount(
       });
 }
 
+Future<vector<folly::Try<Unit>>> PrivHelperClientImpl::bindMounts(
+    const vector<std::pair<string, string>>& bindMounts) {
+  auto xid = getNextXid();
+  auto request =
+      PrivHelperConn::serializeBindMountBatchRequest(xid, bindMounts);
+
+  return sendAndRecv(xid, std::move(request))
+      .thenValue([](UnixSocket::Message&& response) {
+        return PrivHelperConn::parseBindMountBatchResponse(response);
+      });
+}
+
 folly::Future<folly::Unit> PrivHelperClientImpl::bindUnMount(
     folly::StringPiece mountPath) {
   auto xid = getNextXid();
@@ -32,8 +32,13 @@
 #include <sys/statvfs.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <exception>
 #include <set>
+#include <thread>
+#include <vector>
 #include "eden/fs/fuse/privhelper/NfsMountRpc.h"
 #include "eden/fs/fuse/privhelper/PrivHelperConn.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -564,7 +569,8 @@ void PrivHelperServer::nfsMount(
     folly::SocketAddress mountdAddr,
     folly::SocketAddress nfsdAddr,
     bool readOnly,
-    uint32_t iosize) {
+    uint32_t iosize,
+    bool useReaddirplus) {
 #ifdef __APPLE__
   // Hold the attribute list set below.
   auto attrsBuf = folly::IOBufQueue{folly::IOBufQueue::cacheChainLength()};
@@ -575,16 +581,16 @@ void PrivHelperServer::nfsMount(
   // must follow the increasing order of their associated flags.
   uint32_t mattrFlags = 0;
 
-  // Make the client use any source port, disable rdirplus, soft but make the
-  // mount interruptible. While in theory we would want the mount to be soft,
-  // macOS force a maximum timeout of 60s, which in some case is too short for
-  // files to be fetched, thus disable it.
+  // Make the client use any source port, only use rdirplus when asked to, soft
+  // but make the mount interruptible. While in theory we would want the mount
+  // to be soft, macOS force a maximum timeout of 60s, which in some case is
+  // too short for files to be fetched, thus disable it.
   mattrFlags |= NFS_MATTR_FLAGS;
   nfs_mattr_flags flags{
       NFS_MATTR_BITMAP_LEN,
       NFS_MFLAG_RESVPORT | NFS_MFLAG_RDIRPLUS | NFS_MFLAG_SOFT | NFS_MFLAG_INTR,
       NFS_MATTR_BITMAP_LEN,
-      NFS_MFLAG_INTR};
+      NFS_MFLAG_INTR | (useReaddirplus ? NFS_MFLAG_RDIRPLUS : 0)};
   XdrTrait<nfs_mattr_flags>::serialize(attrSer, flags);
 
   mattrFlags |= NFS_MATTR_NFS_VERSION;
@@ -733,13 +739,13 @@ void PrivHelperServer::nfsMount(
   // Prepare the flags and options to pass to mount(2).
   // Since each mount point will have its own NFS server, we need to manually
   // specify it.
-  // TODO(xavierd): remove nordirplus as this will likely improve performance.
   auto mountOpts = fmt::format(
       "addr={},vers=3,proto=tcp,port={},mountvers=3,mountproto=tcp,mountport={},"
-      "noresvport,nolock,nordirplus,soft,retrans=0,rsize={},wsize={}",
+      "noresvport,nolock,{},soft,retrans=0,rsize={},wsize={}",
       nfsdAddr.getAddressStr(),
       nfsdAddr.getPort(),
       mountdAddr.getPort(),
+      useReaddirplus ? "rdirplus" : "nordirplus",
       iosize,
       iosize);
 
@@ -849,13 +855,20 @@ UnixSocket::Message PrivHelperServer::processMountNfsMsg(Cursor& cursor) {
   folly::SocketAddress mountdAddr, nfsdAddr;
   bool readOnly;
   uint32_t iosize;
+  bool useReaddirplus;
   PrivHelperConn::parseMountNfsRequest(
-      cursor, mountPath, mountdAddr, nfsdAddr, readOnly, iosize);
+      cursor,
+      mountPath,
+      mountdAddr,
+      nfsdAddr,
+      readOnly,
+      iosize,
+      useReaddirplus);
   XLOG(DBG3) << "mount.nfs \"" << mountPath << "\"";
 
   sanityCheckMountPoint(mountPath);
 
-  nfsMount(mountPath, mountdAddr, nfsdAddr, readOnly, iosize);
+  nfsMount(mountPath, mountdAddr, nfsdAddr, readOnly, iosize, useReaddirplus);
   mountPoints_.insert(mountPath);
 
   return makeResponse();
@@ -933,6 +946,83 @@ UnixSocket::Message PrivHelperServer::processBindMountMsg(Cursor& cursor) {
   return makeResponse();
 }
 
+UnixSocket::Message PrivHelperServer::processBindMountBatchMsg(
+    Cursor& cursor) {
+  std::vector<std::pair<string, string>> bindMounts;
+  PrivHelperConn::parseBindMountBatchRequest(cursor, bindMounts);
+  XLOG(DBG3) << "bind mount batch of " << bindMounts.size();
+
+  // As in processBindMountMsg, refuse mountPaths outside of our mounts.
+  std::vector<std::exception_ptr> results(bindMounts.size());
+  std::vector<size_t> allowed;
+  for (size_t i = 0; i < bindMounts.size(); ++i) {
+    try {
+      findMatchingMountPrefix(bindMounts[i].second);
+      allowed.push_back(i);
+    } catch (const std::exception&) {
+      results[i] = std::current_exception();
+    }
+  }
+
+  // A nested mount has to be mounted after its parent, otherwise it ends up
+  // hidden under it. Group the mounts by how many of their ancestors are in
+  // the batch: each group only starts once the previous one is mounted.
+  auto isAncestor = [](folly::StringPiece parent, folly::StringPiece child) {
+    while (parent.endsWith('/')) {
+      parent.pop_back();
+    }
+    return child.size() > parent.size() && child.startsWith(parent) &&
+        child[parent.size()] == '/';
+  };
+  std::vector<std::vector<size_t>> waves;
+  for (auto i : allowed) {
+    size_t depth = 0;
+    for (auto j : allowed) {
+      if (isAncestor(bindMounts[j].second, bindMounts[i].second)) {
+        ++depth;
+      }
+    }
+    if (waves.size() <= depth) {
+      waves.resize(depth + 1);
+    }
+    waves[depth].push_back(i);
+  }
+
+  // Each bind mount is a handful of syscalls that mostly wait on the kernel,
+  // so a checkout with many redirections mounts the ones of a wave
+  // concurrently rather than one after the other.
+  constexpr size_t kMaxBindMountThreads = 8;
+  for (const auto& wave : waves) {
+    std::atomic<size_t> next{0};
+    auto runBindMounts = [&] {
+      for (auto n = next++; n < wave.size(); n = next++) {
+        auto i = wave[n];
+        XLOG(DBG3) << "bind mount \"" << bindMounts[i].second << "\"";
+        try {
+          bindMount(
+              bindMounts[i].first.c_str(), bindMounts[i].second.c_str());
+        } catch (const std::exception&) {
+          results[i] = std::current_exception();
+        }
+      }
+    };
+    std::vector<std::thread> threads;
+    auto numThreads = std::min(wave.size(), kMaxBindMountThreads);
+    for (size_t i = 1; i < numThreads; ++i) {
+      threads.emplace_back(runBindMounts);
+    }
+    runBindMounts();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  auto response = makeResponse();
+  Appender appender(&response.data, 1024);
+  PrivHelperConn::serializeBindMountBatchResponse(appender, results);
+  return response;
+}
+
 UnixSocket::Message PrivHelperServer::processBindUnMountMsg(Cursor& cursor) {
   string mountPath;
   PrivHelperConn::parseBindUnMountRequest(cursor, mountPath);
@@ -1154,6 +1244,8 @@ UnixSocket::Message PrivHelperServer::processMessage(
       return processMountNfsMsg(cursor);
     case PrivHelperConn::REQ_MOUNT_BIND:
       return processBindMountMsg(cursor);
+    case PrivHelperConn::REQ_MOUNT_BIND_BATCH:
+      return processBindMountBatchMsg(cursor);
     case PrivHelperConn::REQ_UNMOUNT_FUSE:
       return processUnmountMsg(cursor);
     case PrivHelperConn::REQ_UNMOUNT_NFS:
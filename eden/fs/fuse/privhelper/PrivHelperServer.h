@@ -83,6 +83,7 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
   UnixSocket::Message processUnmountMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processNfsUnmountMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processBindMountMsg(folly::io::Cursor& cursor);
+  UnixSocket::Message processBindMountBatchMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processBindUnMountMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processTakeoverShutdownMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processTakeoverStartupMsg(folly::io::Cursor& cursor);
@@ -114,9 +115,12 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
       folly::SocketAddress mountdPort,
       folly::SocketAddress nfsdPort,
       bool readOnly,
-      uint32_t iosize);
+      uint32_t iosize,
+      bool useReaddirplus);
   virtual void unmount(const char* mountPath);
   // Both clientPath and mountPath must be existing directories.
+  // This may be called from several threads at once when processing a batch
+  // of bind mounts.
   virtual void bindMount(const char* clientPath, const char* mountPath);
   virtual void bindUnmount(const char* mountPath);
   virtual void setLogFile(folly::File&& logFile);
@@ -16,7 +16,9 @@
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <algorithm>
 #include <chrono>
+#include <thread>
 #include <unordered_map>
 
 #include "eden/fs/fuse/privhelper/PrivHelper.h"
@@ -83,6 +85,14 @@ class PrivHelperThreadedTestServer : public PrivHelperServer {
     return getUnusedResults(data_.rlock()->bindUnmountResults);
   }
 
+  /**
+   * "mounting <path>" and "mounted <path>" for each bind mount, in the order
+   * they happened.
+   */
+  std::vector<string> getBindMountEvents() {
+    return data_.rlock()->bindMountEvents;
+  }
+
   std::vector<File> getLogFileRequests() {
     auto data = data_.wlock();
     return std::move(data->logFiles);
@@ -94,6 +104,7 @@ class PrivHelperThreadedTestServer : public PrivHelperServer {
     std::unordered_map<string, Future<Unit>> fuseUnmountResults;
     std::unordered_map<string, Future<Unit>> bindMountResults;
     std::unordered_map<string, Future<Unit>> bindUnmountResults;
+    std::vector<string> bindMountEvents;
     std::vector<File> logFiles;
   };
 
@@ -148,8 +159,15 @@ class PrivHelperThreadedTestServer : public PrivHelperServer {
   }
 
   void bindMount(const char* /* clientPath */, const char* mountPath) override {
-    auto future = getResultFuture(data_.wlock()->bindMountResults, mountPath);
+    auto future = [&] {
+      auto data = data_.wlock();
+      data->bindMountEvents.push_back(
+          folly::to<string>("mounting ", mountPath));
+      return getResultFuture(data->bindMountResults, mountPath);
+    }();
     std::move(future).get(1s);
+    data_.wlock()->bindMountEvents.push_back(
+        folly::to<string>("mounted ", mountPath));
   }
 
   void bindUnmount(const char* mountPath) override {
@@ -391,6 +409,95 @@ TEST_F(PrivHelperTest, bindMounts) {
       UnorderedElementsAre("/bind/never/actually/mounted"));
 }
 
+TEST_F(PrivHelperTest, bindMountBatch) {
+  auto abcMountPoint = makeTempDir("abc");
+  auto abcPath = abcMountPoint.path().string();
+  TemporaryFile tempFile;
+
+  server_.setFuseMountResult(abcPath).setValue(File(tempFile.fd(), false));
+  server_.setBindMountResult(abcPath + "/buck-out").setValue();
+  server_.setBindMountResult(abcPath + "/foo/buck-out")
+      .setException(std::runtime_error("bind mount failed"));
+  server_.setBindMountResult(abcPath + "/bar/buck-out").setValue();
+  server_.setFuseUnmountResult(abcPath).setValue();
+
+  client_->fuseMount(abcPath, false).get(1s);
+  auto results = client_
+                     ->bindMounts({
+                         {"/bind/mount/source", abcPath + "/buck-out"},
+                         {"/bind/mount/source", abcPath + "/foo/buck-out"},
+                         {"/bind/mount/source", "/not/a/mount/buck-out"},
+                         {"/bind/mount/source", abcPath + "/bar/buck-out"},
+                     })
+                     .get(1s);
+
+  // Each bind mount succeeds or fails independently of the others.
+  ASSERT_EQ(4, results.size());
+  EXPECT_TRUE(results[0].hasValue());
+  EXPECT_THROW_RE(results[1].value(), std::exception, "bind mount failed");
+  EXPECT_THROW_RE(
+      results[2].value(),
+      std::exception,
+      "No FUSE mount found for /not/a/mount/buck-out");
+  EXPECT_TRUE(results[3].hasValue());
+
+  cleanup();
+  EXPECT_THAT(server_.getUnusedFuseUnmountResults(), UnorderedElementsAre());
+}
+
+TEST_F(PrivHelperTest, bindMountBatchMountsParentsFirst) {
+  auto abcMountPoint = makeTempDir("abc");
+  auto abcPath = abcMountPoint.path().string();
+  TemporaryFile tempFile;
+
+  server_.setFuseMountResult(abcPath).setValue(File(tempFile.fd(), false));
+  auto parentResult = server_.setBindMountResult(abcPath + "/a");
+  server_.setBindMountResult(abcPath + "/a/b").setValue();
+  server_.setBindMountResult(abcPath + "/a/b/c").setValue();
+  server_.setBindMountResult(abcPath + "/a-d").setValue();
+  server_.setFuseUnmountResult(abcPath).setValue();
+
+  client_->fuseMount(abcPath, false).get(1s);
+  // Leave time for a nested mount to start, if it wrongly could.
+  std::thread finishParent{[&] {
+    std::this_thread::sleep_for(100ms);
+    parentResult.setValue();
+  }};
+  auto results = client_
+                     ->bindMounts({
+                         {"/bind/mount/source", abcPath + "/a/b/c"},
+                         {"/bind/mount/source", abcPath + "/a/b"},
+                         {"/bind/mount/source", abcPath + "/a"},
+                         {"/bind/mount/source", abcPath + "/a-d"},
+                     })
+                     .get(1s);
+  finishParent.join();
+  ASSERT_EQ(4, results.size());
+  for (const auto& result : results) {
+    EXPECT_TRUE(result.hasValue());
+  }
+
+  auto events = server_.getBindMountEvents();
+  auto position = [&](const string& event) {
+    auto it = std::find(events.begin(), events.end(), event);
+    EXPECT_NE(events.end(), it) << event;
+    return it - events.begin();
+  };
+  EXPECT_LT(
+      position("mounted " + abcPath + "/a"),
+      position("mounting " + abcPath + "/a/b"));
+  EXPECT_LT(
+      position("mounted " + abcPath + "/a/b"),
+      position("mounting " + abcPath + "/a/b/c"));
+  // a-d is not under a, so it does not wait for it.
+  EXPECT_LT(
+      position("mounting " + abcPath + "/a-d"),
+      position("mounted " + abcPath + "/a"));
+
+  cleanup();
+  EXPECT_THAT(server_.getUnusedFuseUnmountResults(), UnorderedElementsAre());
+}
+
 TEST_F(PrivHelperTest, takeoverShutdown) {
   auto abcMountPoint = makeTempDir("abc");
   auto abcPath = abcMountPoint.path().string();
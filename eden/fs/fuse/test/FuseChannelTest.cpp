@@ -66,7 +66,8 @@ fuse_entry_out genRandomLookupResponse(uint64_t nodeid) {
 class FuseChannelTest : public ::testing::Test {
  protected:
   unique_ptr<FuseChannel, FuseChannelDeleter> createChannel(
-      size_t numThreads = 2) {
+      size_t numThreads = 2,
+      bool useIoUring = false) {
     auto testDispatcher = std::make_unique<TestDispatcher>(&stats_);
     dispatcher_ = testDispatcher.get();
     return unique_ptr<FuseChannel, FuseChannelDeleter>(new FuseChannel(
@@ -81,7 +82,13 @@ class FuseChannelTest : public ::testing::Test {
         /*notifications=*/nullptr,
         CaseSensitivity::Sensitive,
         /*requireUtf8Path=*/true,
-        /*maximumBackgroundRequests=*/12));
+        /*maximumBackgroundRequests=*/12,
+        /*spliceReadReplies=*/false,
+        /*readdirPlus=*/false,
+        /*writebackCache=*/false,
+        /*prioritizeMetadataRequests=*/false,
+        useIoUring,
+        /*workerAffinity=*/CpuAffinityPolicy::None));
   }
 
   FuseChannel::StopFuture performInit(
@@ -373,3 +380,70 @@ TEST_F(FuseChannelTest, interruptLookups) {
     EXPECT_EQ(requestId, received.header.unique);
   }
 }
+
+TEST_F(FuseChannelTest, ioUringLookups) {
+  // Falls back to blocking reads if io_uring is unavailable, in which case
+  // this exercises the same paths as the other tests.
+  auto channel = createChannel(2, /*useIoUring=*/true);
+  auto completeFuture = performInit(channel.get());
+
+  for (int i = 0; i < 100; ++i) {
+    auto requestId = fuse_.sendLookup(FUSE_ROOT_ID, "foo");
+    auto req = dispatcher_->waitForLookup(requestId);
+
+    auto response = genRandomLookupResponse(5 + i);
+    req.promise.setValue(response);
+
+    auto received = fuse_.recvResponse();
+    EXPECT_EQ(requestId, received.header.unique);
+    EXPECT_EQ(0, received.header.error);
+    EXPECT_EQ(
+        sizeof(fuse_out_header) + sizeof(fuse_entry_out),
+        received.header.len);
+  }
+
+  channel->takeoverStop();
+  auto stopData = std::move(completeFuture).get(kTimeout);
+  EXPECT_EQ(stopData.reason, FuseChannel::StopReason::TAKEOVER);
+  EXPECT_TRUE(stopData.fuseDevice);
+}
+
+TEST_F(FuseChannelTest, ioUringUnmount) {
+  auto channel = createChannel(2, /*useIoUring=*/true);
+  auto completeFuture = performInit(channel.get());
+
+  fuse_.close();
+
+  auto stopData = std::move(completeFuture).get(kTimeout);
+  EXPECT_EQ(stopData.reason, FuseChannel::StopReason::UNMOUNTED);
+  EXPECT_FALSE(stopData.fuseDevice);
+}
+
+TEST_F(FuseChannelTest, duplicateInodeInvalidationsAreCoalesced) {
+  auto channel = createChannel();
+  auto completeFuture = performInit(channel.get());
+
+  // invalidateInodes() queues all of these at once, so they end up in the
+  // same batch and only one invalidation per inode should be sent.
+  std::vector<InodeNumber> inodes{
+      InodeNumber{5}, InodeNumber{7}, InodeNumber{5}, InodeNumber{7}};
+  channel->invalidateInodes(folly::range(inodes));
+  auto flushFuture = channel->flushInvalidations();
+
+  for (auto expected : {5, 7}) {
+    auto received = fuse_.recvResponse();
+    EXPECT_EQ(0, received.header.unique);
+    EXPECT_EQ(FUSE_NOTIFY_INVAL_INODE, received.header.error);
+    ASSERT_EQ(sizeof(fuse_notify_inval_inode_out), received.body.size());
+    fuse_notify_inval_inode_out notify;
+    memcpy(&notify, received.body.data(), sizeof(notify));
+    EXPECT_EQ(expected, notify.ino);
+    EXPECT_EQ(0, notify.off);
+    EXPECT_EQ(0, notify.len);
+  }
+  std::move(flushFuture).get(kTimeout);
+
+  channel->takeoverStop();
+  auto stopData = std::move(completeFuture).get(kTimeout);
+  EXPECT_EQ(stopData.reason, FuseChannel::StopReason::TAKEOVER);
+}
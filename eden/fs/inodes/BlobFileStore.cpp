@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/inodes/BlobFileStore.h"
+
+#include <boost/filesystem.hpp>
+#include <fcntl.h>
+#include <folly/Conv.h>
+#include <folly/Exception.h>
+#include <folly/FBVector.h>
+#include <folly/FileUtil.h>
+#include <folly/ScopeGuard.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <unistd.h>
+
+#include "eden/fs/inodes/overlay/FsOverlay.h"
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Hash.h"
+
+namespace facebook {
+namespace eden {
+
+namespace {
+constexpr folly::StringPiece kTmpSuffix{".tmp"};
+}
+
+BlobFileStore::BlobFileStore(
+    AbsolutePathPiece directory,
+    uint64_t maxBytes,
+    uint64_t minBlobSize)
+    : directory_{directory}, maxBytes_{maxBytes}, minBlobSize_{minBlobSize} {
+  try {
+    ensureDirectoryExists(directory_);
+    loadExistingFiles();
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "unable to use the blob file store in " << directory_ << ": "
+               << folly::exceptionStr(ex);
+    disable();
+  }
+}
+
+void BlobFileStore::loadExistingFiles() {
+  uint64_t totalBytes = 0;
+  for (const auto& entry :
+       boost::filesystem::directory_iterator(directory_.as_boost())) {
+    auto name = entry.path().filename().string();
+    if (folly::StringPiece{name}.endsWith(kTmpSuffix)) {
+      // Left behind by a crash while the file was being written.
+      boost::system::error_code error;
+      boost::filesystem::remove(entry.path(), error);
+      continue;
+    }
+    totalBytes += boost::filesystem::file_size(entry.path());
+  }
+  totalBytes_.store(totalBytes, std::memory_order_relaxed);
+}
+
+void BlobFileStore::disable() {
+  disabled_.store(true, std::memory_order_relaxed);
+}
+
+std::optional<folly::File> BlobFileStore::getFile(const Blob& blob) {
+  if (!isEnabled() || blob.getSize() < minBlobSize_) {
+    return std::nullopt;
+  }
+
+  auto path = directory_ +
+      PathComponent{Hash20::sha1(blob.getHash().getBytes()).toString()};
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+  if (fd != -1) {
+    return folly::File{fd, /* ownsFd */ true};
+  }
+  if (errno != ENOENT) {
+    XLOG(DBG2) << "unable to open blob file " << path << ": "
+               << folly::errnoStr(errno);
+    return std::nullopt;
+  }
+
+  uint64_t fileSize = FsOverlay::kHeaderLength + blob.getSize();
+  if (totalBytes_.fetch_add(fileSize, std::memory_order_relaxed) + fileSize >
+      maxBytes_) {
+    totalBytes_.fetch_sub(fileSize, std::memory_order_relaxed);
+    return std::nullopt;
+  }
+
+  try {
+    writeFile(blob, path);
+  } catch (const std::exception& ex) {
+    totalBytes_.fetch_sub(fileSize, std::memory_order_relaxed);
+    XLOG(WARN) << "unable to write blob file " << path << ": "
+               << folly::exceptionStr(ex);
+    return std::nullopt;
+  }
+
+  fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+  if (fd == -1) {
+    return std::nullopt;
+  }
+  return folly::File{fd, /* ownsFd */ true};
+}
+
+void BlobFileStore::writeFile(const Blob& blob, AbsolutePathPiece path) {
+  // Concurrent materializations of the same blob each write their own
+  // temporary file. The first one to link it in place wins and the others'
+  // bytes are given back.
+  auto tmpPath = folly::to<std::string>(
+      path.stringPiece(),
+      '.',
+      nextTmpId_.fetch_add(1, std::memory_order_relaxed),
+      kTmpSuffix);
+  folly::File file{
+      tmpPath, O_CREAT | O_WRONLY | O_CLOEXEC | O_NOFOLLOW | O_TRUNC, 0400};
+  SCOPE_EXIT {
+    unlink(tmpPath.c_str());
+  };
+
+  auto header = FsOverlay::createHeader(
+      FsOverlay::kHeaderIdentifierFile, FsOverlay::kHeaderVersion);
+  folly::fbvector<struct iovec> iov;
+  iov.resize(1);
+  iov[0].iov_base = header.data();
+  iov[0].iov_len = header.size();
+  blob.getContents().appendToIov(&iov);
+  folly::checkUnixError(
+      folly::writevFull(file.fd(), iov.data(), iov.size()),
+      "error writing ",
+      tmpPath);
+
+  if (link(tmpPath.c_str(), path.c_str()) != 0) {
+    if (errno != EEXIST) {
+      folly::throwSystemError("error linking ", path);
+    }
+    totalBytes_.fetch_sub(
+        FsOverlay::kHeaderLength + blob.getSize(), std::memory_order_relaxed);
+  }
+}
+
+} // namespace eden
+} // namespace facebook
+
+#endif // !_WIN32
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <atomic>
+#include <optional>
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook {
+namespace eden {
+
+class Blob;
+
+/**
+ * A directory of files holding the contents of the large blobs materialized
+ * in a checkout, each laid out exactly like an overlay file, header included.
+ *
+ * On filesystems that support copy-on-write clones (btrfs, XFS and APFS), the
+ * overlay file of an inode materialized from one of these blobs is created as
+ * a clone of its blob file, which costs the same regardless of the size of
+ * the blob and shares the data blocks on disk until the inode is modified.
+ * The first materialization of a blob still writes it in full, to the blob
+ * file; the ones that follow, for other inodes with the same contents or for
+ * the same file after a checkout away and back, don't.
+ *
+ * Blob files are named after the SHA-1 of the blob ID and never change once
+ * written. No more than maxBytes of them are written, after which blobs are
+ * written directly to the overlay again.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class BlobFileStore {
+ public:
+  /**
+   * The directory must be on the same filesystem as the overlay for clones
+   * to work. It is created if it doesn't exist.
+   */
+  BlobFileStore(
+      AbsolutePathPiece directory,
+      uint64_t maxBytes,
+      uint64_t minBlobSize);
+
+  BlobFileStore(const BlobFileStore&) = delete;
+  BlobFileStore& operator=(const BlobFileStore&) = delete;
+
+  /**
+   * Returns the blob file of the given blob, opened read-only, writing it
+   * first if needed.
+   *
+   * Returns std::nullopt if the blob is smaller than minBlobSize, if the
+   * store is full or disabled, or if the file couldn't be written.
+   */
+  std::optional<folly::File> getFile(const Blob& blob);
+
+  /**
+   * Stops handing out and writing blob files, because the overlay can't
+   * clone them. The files already written are kept.
+   */
+  void disable();
+
+  bool isEnabled() const {
+    return !disabled_.load(std::memory_order_relaxed);
+  }
+
+  /** Total size of the blob files, in bytes. */
+  uint64_t getTotalBytes() const {
+    return totalBytes_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  void loadExistingFiles();
+  void writeFile(const Blob& blob, AbsolutePathPiece path);
+
+  const AbsolutePath directory_;
+  const uint64_t maxBytes_;
+  const uint64_t minBlobSize_;
+  std::atomic<uint64_t> totalBytes_{0};
+  std::atomic<bool> disabled_{false};
+  std::atomic<uint64_t> nextTmpId_{0};
+};
+
+} // namespace eden
+} // namespace facebook
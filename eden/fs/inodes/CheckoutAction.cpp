@@ -120,7 +120,7 @@ Future<InvalidationRequired> CheckoutAction::run(
     // Load the Blob or Tree for the old TreeEntry.
     if (oldScmEntry_.has_value()) {
       if (oldScmEntry_.value().isTree()) {
-        store->getTree(oldScmEntry_.value().getHash(), ctx->getFetchContext())
+        ctx->getTree(oldScmEntry_.value().getHash())
             .thenValue([rc = LoadingRefcount(this)](
                            std::shared_ptr<const Tree> oldTree) {
               rc->setOldTree(std::move(oldTree));
@@ -151,7 +151,7 @@ Future<InvalidationRequired> CheckoutAction::run(
     if (newScmEntry_.has_value()) {
       const auto& newEntry = newScmEntry_.value();
       if (newEntry.isTree()) {
-        store->getTree(newEntry.getHash(), ctx->getFetchContext())
+        ctx->getTree(newEntry.getHash())
             .thenValue([rc = LoadingRefcount(this)](
                            std::shared_ptr<const Tree> newTree) {
               rc->setNewTree(std::move(newTree));
@@ -7,13 +7,17 @@
 
 #include "eden/fs/inodes/CheckoutContext.h"
 
+#include <folly/ScopeGuard.h>
 #include <folly/logging/xlog.h>
 #include <optional>
 
 #include "eden/fs/config/CheckoutConfig.h"
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/InodePtr.h"
+#include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/store/ObjectStore.h"
 
 using folly::Future;
 using std::vector;
@@ -33,7 +37,14 @@ CheckoutContext::CheckoutContext(
       fetchContext_{
           clientPid,
           ObjectFetchContext::Cause::Thrift,
-          thriftMethodName} {}
+          thriftMethodName},
+      treePins_{mount->getServerState()
+                    ->getEdenConfig()
+                    ->operationTreePinBudget.getValue()},
+      executor_{folly::getKeepAliveToken(mount->getServerThreadPool().get())},
+      maxParallelActions_{mount->getServerState()
+                              ->getEdenConfig()
+                              ->maxParallelCheckoutActions.getValue()} {}
 
 CheckoutContext::CheckoutContext(
     EdenMount* mount,
@@ -46,10 +57,40 @@ CheckoutContext::CheckoutContext(
       fetchContext_{
           clientPid,
           ObjectFetchContext::Cause::Thrift,
-          thriftMethodName} {}
+          thriftMethodName},
+      treePins_{mount->getServerState()
+                    ->getEdenConfig()
+                    ->operationTreePinBudget.getValue()},
+      executor_{folly::getKeepAliveToken(mount->getServerThreadPool().get())},
+      maxParallelActions_{mount->getServerState()
+                              ->getEdenConfig()
+                              ->maxParallelCheckoutActions.getValue()} {}
 
 CheckoutContext::~CheckoutContext() {}
 
+folly::Future<InvalidationRequired> CheckoutContext::runInParallel(
+    folly::Function<folly::Future<InvalidationRequired>()> fn) {
+  if (parallelActions_.fetch_add(1, std::memory_order_relaxed) >=
+      maxParallelActions_) {
+    parallelActions_.fetch_sub(1, std::memory_order_relaxed);
+    return fn();
+  }
+
+  return folly::via(executor_.get(), [this, fn = std::move(fn)]() mutable {
+    // As in DiffContext::runInParallel, the slot is released once fn has
+    // handed off its asynchronous work.
+    SCOPE_EXIT {
+      parallelActions_.fetch_sub(1, std::memory_order_relaxed);
+    };
+    return fn();
+  });
+}
+
+ImmediateFuture<std::shared_ptr<const Tree>> CheckoutContext::getTree(
+    const ObjectId& treeId) {
+  return treePins_.getTree(treeId, *mount_->getObjectStore(), fetchContext_);
+}
+
 void CheckoutContext::start(RenameLock&& renameLock) {
   renameLock_ = std::move(renameLock);
 }
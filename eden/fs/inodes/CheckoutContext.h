@@ -7,16 +7,22 @@
 
 #pragma once
 
+#include <atomic>
 #include <vector>
 
+#include <folly/Executor.h>
+#include <folly/Function.h>
 #include <folly/Range.h>
 #include <folly/Synchronized.h>
 #include <folly/stop_watch.h>
 
+#include "eden/fs/fuse/Invalidation.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/InodePtrFwd.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/store/StatsFetchContext.h"
+#include "eden/fs/store/TreePinSet.h"
+#include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace folly {
@@ -118,12 +124,40 @@ class CheckoutContext {
     return fetchContext_;
   }
 
+  /**
+   * The trees fetched by this checkout, which it keeps referenced until it
+   * completes, within store:operation-tree-pin-budget.
+   */
+  TreePinSet& getTreePins() {
+    return treePins_;
+  }
+
+  /**
+   * Fetches the tree treeId, or returns it from getTreePins() if this
+   * checkout already fetched it.
+   */
+  ImmediateFuture<std::shared_ptr<const Tree>> getTree(const ObjectId& treeId);
+
+  /**
+   * Run a part of the checkout, typically one CheckoutAction.
+   *
+   * While fewer than store:max-parallel-checkout-actions parts are queued or
+   * running on the server thread pool, fn is run there so that independent
+   * directories are updated on several threads. Otherwise fn is run inline.
+   */
+  folly::Future<InvalidationRequired> runInParallel(
+      folly::Function<folly::Future<InvalidationRequired>()> fn);
+
  private:
   CheckoutMode checkoutMode_;
   EdenMount* const mount_;
   folly::Synchronized<RootId>::LockedPtr parentLock_;
   RenameLock renameLock_;
   StatsFetchContext fetchContext_;
+  TreePinSet treePins_;
+  folly::Executor::KeepAlive<folly::Executor> executor_;
+  const size_t maxParallelActions_;
+  std::atomic<size_t> parallelActions_{0};
 
   // The checkout processing may occur across many threads,
   // if some data load operations complete asynchronously on other threads.
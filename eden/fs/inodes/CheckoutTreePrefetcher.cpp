@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/CheckoutTreePrefetcher.h"
+
+#include <algorithm>
+#include <deque>
+#include <optional>
+#include <vector>
+
+#include "eden/fs/config/CheckoutConfig.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/TreePinSet.h"
+
+namespace facebook::eden {
+
+namespace {
+class CheckoutTreePrefetcher {
+ public:
+  CheckoutTreePrefetcher(
+      ObjectStore* store,
+      ObjectFetchContext& context,
+      TreePinSet& treePins,
+      CaseSensitivity caseSensitive,
+      size_t maxBatchSize)
+      : store_{store},
+        context_{context},
+        treePins_{treePins},
+        caseSensitive_{caseSensitive},
+        maxBatchSize_{std::max<size_t>(maxBatchSize, 1)} {}
+
+  static ImmediateFuture<folly::Unit> run(
+      std::shared_ptr<CheckoutTreePrefetcher> prefetcher,
+      TreeInode& root,
+      const Tree* fromTree,
+      const Tree* toTree) {
+    prefetcher->examine(root, fromTree, toTree);
+    return processQueue(std::move(prefetcher));
+  }
+
+ private:
+  struct Directory {
+    /**
+     * Null when the inode is not loaded: checkout() will load it, but until
+     * then its children are unknown and are not examined.
+     */
+    TreeInodePtr inode;
+    std::optional<ObjectId> fromTree;
+    std::optional<ObjectId> toTree;
+  };
+
+  static ImmediateFuture<folly::Unit> processQueue(
+      std::shared_ptr<CheckoutTreePrefetcher> prefetcher) {
+    while (!prefetcher->pending_.empty()) {
+      auto batch = prefetcher->processBatch();
+      if (!batch.isReady()) {
+        return std::move(batch).thenValue(
+            [prefetcher = std::move(prefetcher)](auto&&) mutable {
+              return processQueue(std::move(prefetcher));
+            });
+      }
+      std::move(batch).get();
+    }
+    return folly::unit;
+  }
+
+  ImmediateFuture<folly::Unit> processBatch() {
+    std::vector<Directory> directories;
+    while (!pending_.empty() && directories.size() < maxBatchSize_) {
+      directories.push_back(std::move(pending_.front()));
+      pending_.pop_front();
+    }
+
+    std::vector<ImmediateFuture<std::shared_ptr<const Tree>>> futures;
+    futures.reserve(directories.size() * 2);
+    for (const auto& directory : directories) {
+      futures.push_back(getTree(directory.fromTree));
+      futures.push_back(getTree(directory.toTree));
+    }
+
+    return collectAll(std::move(futures))
+        .thenValue(
+            [this, directories = std::move(directories)](
+                std::vector<folly::Try<std::shared_ptr<const Tree>>> trees) {
+              for (size_t i = 0; i < directories.size(); ++i) {
+                const auto& fromTree = trees[2 * i];
+                const auto& toTree = trees[2 * i + 1];
+                if (!directories[i].inode || fromTree.hasException() ||
+                    toTree.hasException()) {
+                  continue;
+                }
+                examine(*directories[i].inode, fromTree->get(), toTree->get());
+              }
+            });
+  }
+
+  ImmediateFuture<std::shared_ptr<const Tree>> getTree(
+      const std::optional<ObjectId>& id) {
+    if (!id) {
+      return std::shared_ptr<const Tree>{};
+    }
+    return treePins_.getTree(*id, *store_, context_);
+  }
+
+  /**
+   * Queue the children of inode that checkout() will descend into.
+   */
+  void examine(TreeInode& inode, const Tree* fromTree, const Tree* toTree) {
+    static const std::vector<TreeEntry> kNoEntries;
+    const auto& fromEntries =
+        fromTree ? fromTree->getTreeEntries() : kNoEntries;
+    const auto& toEntries = toTree ? toTree->getTreeEntries() : kNoEntries;
+
+    auto contents = inode.getContents().rlock();
+    size_t fromIdx = 0;
+    size_t toIdx = 0;
+    while (fromIdx < fromEntries.size() || toIdx < toEntries.size()) {
+      const TreeEntry* fromEntry = nullptr;
+      const TreeEntry* toEntry = nullptr;
+      if (fromIdx >= fromEntries.size()) {
+        toEntry = &toEntries[toIdx++];
+      } else if (toIdx >= toEntries.size()) {
+        fromEntry = &fromEntries[fromIdx++];
+      } else {
+        auto compare = comparePathComponent(
+            fromEntries[fromIdx].getName(),
+            toEntries[toIdx].getName(),
+            caseSensitive_);
+        if (compare == CompareResult::BEFORE) {
+          fromEntry = &fromEntries[fromIdx++];
+        } else if (compare == CompareResult::AFTER) {
+          toEntry = &toEntries[toIdx++];
+        } else {
+          fromEntry = &fromEntries[fromIdx++];
+          toEntry = &toEntries[toIdx++];
+        }
+      }
+
+      std::optional<ObjectId> fromId;
+      if (fromEntry && fromEntry->isTree()) {
+        fromId = fromEntry->getHash();
+      }
+      std::optional<ObjectId> toId;
+      if (toEntry && toEntry->isTree()) {
+        toId = toEntry->getHash();
+      }
+      if (!fromId && !toId) {
+        continue;
+      }
+      if (fromEntry && toEntry && fromEntry->getType() == toEntry->getType() &&
+          fromEntry->getHash() == toEntry->getHash()) {
+        continue;
+      }
+
+      // Without a local entry, checkout() simply adds the new one.
+      auto it = contents->entries.find(
+          fromEntry ? fromEntry->getName() : toEntry->getName());
+      if (it == contents->entries.end()) {
+        continue;
+      }
+      const auto& entry = it->second;
+      if (auto child = entry.getInodePtr()) {
+        pending_.push_back(Directory{child.asTreePtrOrNull(), fromId, toId});
+      } else if (
+          entry.isMaterialized() ||
+          (entry.isDirectory() &&
+           (!fromEntry || entry.getHash() != fromEntry->getHash()))) {
+        pending_.push_back(Directory{TreeInodePtr{}, fromId, toId});
+      }
+    }
+  }
+
+  ObjectStore* const store_;
+  ObjectFetchContext& context_;
+  TreePinSet& treePins_;
+  const CaseSensitivity caseSensitive_;
+  const size_t maxBatchSize_;
+  std::deque<Directory> pending_;
+};
+} // namespace
+
+ImmediateFuture<folly::Unit> prefetchCheckoutTrees(
+    ObjectStore* store,
+    ObjectFetchContext& context,
+    TreePinSet& treePins,
+    TreeInodePtr root,
+    std::shared_ptr<const Tree> fromTree,
+    std::shared_ptr<const Tree> toTree,
+    size_t maxBatchSize) {
+  auto prefetcher = std::make_shared<CheckoutTreePrefetcher>(
+      store,
+      context,
+      treePins,
+      root->getMount()->getCheckoutConfig()->getCaseSensitive(),
+      maxBatchSize);
+  return CheckoutTreePrefetcher::run(
+             std::move(prefetcher), *root, fromTree.get(), toTree.get())
+      .ensure([root = std::move(root),
+               fromTree = std::move(fromTree),
+               toTree = std::move(toTree)] {});
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "eden/fs/inodes/InodePtr.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+class ObjectFetchContext;
+class ObjectStore;
+class Tree;
+class TreePinSet;
+
+/**
+ * Fetch the source control trees that a checkout from fromTree to toTree
+ * starting at root is going to need, ahead of the checkout itself.
+ *
+ * TreeInode::checkout() only fetches the trees of a directory once it has
+ * processed the directory's parent, so a deep checkout waits for one round
+ * of fetches per level. This instead walks the trees breadth first,
+ * requesting up to maxBatchSize pairs of trees at once, and only descends
+ * where checkout() will: into directories whose trees differ and whose
+ * inodes are loaded, or materialized or modified and therefore loaded by
+ * checkout(). Unloaded, unmodified directories are replaced without looking
+ * at their contents, so their trees are not fetched.
+ *
+ * The fetched trees are pinned in treePins, so that checkout() finds them
+ * there rather than fetching them again if the TreeCache evicted them.
+ *
+ * Errors are ignored, checkout() will report them when it fetches the same
+ * trees.
+ *
+ * The caller must keep store, context and treePins alive until the returned
+ * future completes.
+ */
+ImmediateFuture<folly::Unit> prefetchCheckoutTrees(
+    ObjectStore* store,
+    ObjectFetchContext& context,
+    TreePinSet& treePins,
+    TreeInodePtr root,
+    std::shared_ptr<const Tree> fromTree,
+    std::shared_ptr<const Tree> toTree,
+    size_t maxBatchSize);
+
+} // namespace facebook::eden
@@ -188,8 +188,7 @@ class ModifiedDiffEntry : public DeferredDiffEntry {
     }
 
     // Possibly modified directory.  Load the Tree in question.
-    return context_->store
-        ->getTree(scmEntry_.getHash(), context_->getFetchContext())
+    return context_->getTree(scmEntry_.getHash())
         .semi()
         .via(&folly::QueuedImmediateExecutor::instance())
         .thenValue([this, treeInode = std::move(treeInode)](
@@ -212,6 +211,11 @@ class ModifiedDiffEntry : public DeferredDiffEntry {
       if (isIgnored_ && !context_->listIgnored) {
         return makeFuture();
       }
+      if (!isIgnored_ && context_->summarizeUntrackedDirectories) {
+        XLOG(DBG6) << "file --> untracked directory: " << getPath();
+        context_->callback->addedDirectory(getPath());
+        return makeFuture();
+      }
       return treeInode->diff(context_, getPath(), nullptr, ignore_, isIgnored_);
     }
 
@@ -101,6 +101,16 @@ class DirEntry {
     hash_ = hash;
   }
 
+  /**
+   * Point an entry that is neither loaded nor materialized at another source
+   * control object of the same type, keeping its inode number.
+   */
+  void setUnloadedHash(ObjectId hash) {
+    XDCHECK(!hasInodePointer_);
+    XDCHECK(hasHash_);
+    hash_ = hash;
+  }
+
   /**
    * Returns the mode specified when this inode was created (whether from source
    * control or via mkdir/mknod/creat).
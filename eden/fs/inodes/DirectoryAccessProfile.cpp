@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/DirectoryAccessProfile.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace facebook::eden {
+
+DirectoryAccessProfile::DirectoryAccessProfile(
+    size_t capacity,
+    Clock::duration halfLife)
+    : halfLife_{std::max(halfLife, Clock::duration{1})},
+      entries_{std::max<size_t>(capacity, 1)} {}
+
+double DirectoryAccessProfile::decayedScore(
+    const Entry& entry,
+    Clock::time_point now) const {
+  if (now <= entry.lastLoad) {
+    return entry.score;
+  }
+  auto halfLives = std::chrono::duration<double>{now - entry.lastLoad} /
+      std::chrono::duration<double>{halfLife_};
+  return entry.score * std::exp2(-halfLives);
+}
+
+bool DirectoryAccessProfile::recordLoad(
+    RelativePathPiece path,
+    Clock::time_point now) {
+  auto it = entries_.find(path.copy());
+  if (it == entries_.end()) {
+    entries_.set(path.copy(), Entry{1.0, now});
+  } else {
+    it->second.score = decayedScore(it->second, now) + 1.0;
+    it->second.lastLoad = std::max(it->second.lastLoad, now);
+  }
+  return outstanding_.erase(path.copy()) != 0;
+}
+
+DirectoryAccessProfile::Selection DirectoryAccessProfile::selectForPrefetch(
+    size_t count,
+    Clock::time_point now) {
+  Selection selection;
+  selection.wasted = outstanding_.size();
+  outstanding_.clear();
+
+  std::vector<std::pair<double, const RelativePath*>> ranked;
+  ranked.reserve(entries_.size());
+  for (const auto& [path, entry] : entries_) {
+    ranked.emplace_back(decayedScore(entry, now), &path);
+  }
+  count = std::min(count, ranked.size());
+  std::partial_sort(
+      ranked.begin(),
+      ranked.begin() + count,
+      ranked.end(),
+      [](const auto& a, const auto& b) { return a.first > b.first; });
+
+  selection.paths.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    selection.paths.push_back(*ranked[i].second);
+    outstanding_.insert(*ranked[i].second);
+  }
+  return selection;
+}
+
+double DirectoryAccessProfile::getScore(
+    RelativePathPiece path,
+    Clock::time_point now) const {
+  auto it = entries_.findWithoutPromotion(path.copy());
+  return it == entries_.end() ? 0.0 : decayedScore(it->second, now);
+}
+
+} // namespace facebook::eden
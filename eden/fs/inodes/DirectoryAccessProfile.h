@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/container/EvictingCacheMap.h>
+#include <chrono>
+#include <unordered_set>
+#include <vector>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * Ranks the directories of a checkout by how often, and how recently, they
+ * are loaded on demand, to pick the ones worth prefetching after a checkout.
+ *
+ * Each directory has a score that is incremented on every load and decays
+ * exponentially with the given half-life, so that a directory used heavily
+ * last month ranks below one used a few times today. Directories are
+ * identified by path, so that the profile carries over checkouts.
+ *
+ * The profile also keeps track of the directories selected by the last
+ * prefetch, to report how many were useful (later loaded on demand) and how
+ * many were wasted.
+ *
+ * This class is not thread safe; callers must provide their own locking.
+ */
+class DirectoryAccessProfile {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * capacity bounds the number of directories remembered. The least
+   * recently loaded ones are forgotten first.
+   */
+  DirectoryAccessProfile(size_t capacity, Clock::duration halfLife);
+
+  DirectoryAccessProfile(const DirectoryAccessProfile&) = delete;
+  DirectoryAccessProfile& operator=(const DirectoryAccessProfile&) = delete;
+
+  /**
+   * Record that the given directory is being loaded on demand. Returns
+   * whether it was selected by the last prefetch and not loaded since.
+   */
+  bool recordLoad(RelativePathPiece path, Clock::time_point now);
+
+  struct Selection {
+    /**
+     * Directories to prefetch, highest score first.
+     */
+    std::vector<RelativePath> paths;
+
+    /**
+     * Number of directories selected by the previous prefetch that were
+     * never loaded.
+     */
+    size_t wasted{0};
+  };
+
+  /**
+   * Returns the count highest ranked directories, and remembers them as
+   * prefetched until the next call.
+   */
+  Selection selectForPrefetch(size_t count, Clock::time_point now);
+
+  double getScore(RelativePathPiece path, Clock::time_point now) const;
+
+ private:
+  struct Entry {
+    double score;
+    Clock::time_point lastLoad;
+  };
+
+  double decayedScore(const Entry& entry, Clock::time_point now) const;
+
+  const Clock::duration halfLife_;
+  folly::EvictingCacheMap<RelativePath, Entry> entries_;
+  std::unordered_set<RelativePath> outstanding_;
+};
+
+} // namespace facebook::eden
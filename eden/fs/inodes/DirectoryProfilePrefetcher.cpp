@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/DirectoryProfilePrefetcher.h"
+
+#include <folly/logging/xlog.h>
+#include <utility>
+#include <vector>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/ServerState.h"
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/PathLoader.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook::eden {
+
+namespace {
+class ProfilePrefetchContext : public ObjectFetchContext {
+ public:
+  ImportPriority getPriority() const override {
+    return ImportPriority::kLow();
+  }
+  ObjectFetchContext::Cause getCause() const override {
+    return ObjectFetchContext::Cause::Fs;
+  }
+};
+} // namespace
+
+DirectoryProfilePrefetcher::DirectoryProfilePrefetcher(
+    std::shared_ptr<ObjectStore> objectStore,
+    std::shared_ptr<ServerState> serverState)
+    : objectStore_{std::move(objectStore)},
+      serverState_{std::move(serverState)},
+      context_{std::make_unique<ProfilePrefetchContext>()},
+      profile_{
+          folly::in_place,
+          serverState_->getEdenConfig()->profilePrefetchModelSize.getValue(),
+          std::chrono::duration_cast<DirectoryAccessProfile::Clock::duration>(
+              serverState_->getEdenConfig()
+                  ->profilePrefetchHalfLife.getValue())} {}
+
+DirectoryProfilePrefetcher::~DirectoryProfilePrefetcher() = default;
+
+bool DirectoryProfilePrefetcher::isEnabled() const {
+  return serverState_->getEdenConfig(ConfigReloadBehavior::NoReload)
+      ->profilePrefetch.getValue();
+}
+
+void DirectoryProfilePrefetcher::directoryLoadStarted(RelativePathPiece path) {
+  auto wasPrefetched = profile_.lock()->recordLoad(
+      path, DirectoryAccessProfile::Clock::now());
+  if (wasPrefetched) {
+    serverState_->getStats()
+        .getObjectStoreStatsForCurrentThread()
+        .profilePrefetchHit.addValue(1);
+  }
+}
+
+void DirectoryProfilePrefetcher::checkoutCompleted(const RootId& rootId) {
+  auto config = serverState_->getEdenConfig(ConfigReloadBehavior::NoReload);
+  if (!config->profilePrefetch.getValue()) {
+    return;
+  }
+
+  auto selection = profile_.lock()->selectForPrefetch(
+      config->profilePrefetchCount.getValue(),
+      DirectoryAccessProfile::Clock::now());
+  if (selection.wasted) {
+    serverState_->getStats()
+        .getObjectStoreStatsForCurrentThread()
+        .profilePrefetchWasted.addValue(selection.wasted);
+  }
+  if (selection.paths.empty()) {
+    return;
+  }
+
+  XLOG(DBG3) << "prefetching the trees of " << selection.paths.size()
+             << " frequently used directories of " << rootId;
+  objectStore_->getRootTree(rootId, *context_)
+      .thenValue([self = shared_from_this(),
+                  paths = std::move(selection.paths)](
+                     std::shared_ptr<const Tree> rootTree) mutable {
+        {
+          auto queue = self->queue_.lock();
+          queue->rootTree = std::move(rootTree);
+          queue->paths.assign(
+              std::make_move_iterator(paths.begin()),
+              std::make_move_iterator(paths.end()));
+        }
+        self->fetchQueued();
+      })
+      .thenError([rootId](const folly::exception_wrapper& ew) {
+        XLOG(DBG3) << "not prefetching frequently used directories of "
+                   << rootId << ": " << ew.what();
+      });
+}
+
+void DirectoryProfilePrefetcher::fetchQueued() {
+  auto config = serverState_->getEdenConfig(ConfigReloadBehavior::NoReload);
+  auto maxInProgress = config->maxTreePrefetches.getValue();
+
+  std::shared_ptr<const Tree> rootTree;
+  std::vector<RelativePath> paths;
+  {
+    auto queue = queue_.lock();
+    rootTree = queue->rootTree;
+    while (queue->numInProgress < maxInProgress && !queue->paths.empty()) {
+      paths.push_back(std::move(queue->paths.front()));
+      queue->paths.pop_front();
+      ++queue->numInProgress;
+    }
+  }
+
+  auto& stats = serverState_->getStats().getObjectStoreStatsForCurrentThread();
+  for (auto& path : paths) {
+    XLOG(DBG4) << "prefetching frequently used directory " << path;
+    stats.profilePrefetchIssued.addValue(1);
+    // Errors are ignored: the directory may not exist in this commit, and
+    // the fetch will be retried on demand anyway.
+    resolveTree(*objectStore_, *context_, rootTree, path)
+        .thenTry([self = shared_from_this()](auto&&) {
+          self->queue_.lock()->numInProgress--;
+          self->fetchQueued();
+        });
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "eden/fs/inodes/DirectoryAccessProfile.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class ObjectFetchContext;
+class ObjectStore;
+class RootId;
+class ServerState;
+class Tree;
+
+/**
+ * Fetches the trees of the directories a DirectoryAccessProfile ranks
+ * highest after each checkout, at low priority, so that they are already
+ * cached when they are needed again.
+ *
+ * There is one DirectoryProfilePrefetcher per EdenMount. It is enabled by
+ * `store:profile-prefetch`. The number of fetches in flight is bounded by
+ * `store:max-tree-prefetches`, counted separately from directory and
+ * speculative prefetches; the remaining directories wait in a queue, which
+ * a newer checkout replaces.
+ */
+class DirectoryProfilePrefetcher
+    : public std::enable_shared_from_this<DirectoryProfilePrefetcher> {
+ public:
+  DirectoryProfilePrefetcher(
+      std::shared_ptr<ObjectStore> objectStore,
+      std::shared_ptr<ServerState> serverState);
+  ~DirectoryProfilePrefetcher();
+
+  /**
+   * Recording a load needs the path of the directory, which callers should
+   * only compute when this returns true.
+   */
+  bool isEnabled() const;
+
+  /**
+   * Called when a directory is about to be loaded on demand.
+   */
+  void directoryLoadStarted(RelativePathPiece path);
+
+  /**
+   * Called once a checkout to rootId has completed. Starts fetching the
+   * trees of the top ranked directories of rootId in the background.
+   */
+  void checkoutCompleted(const RootId& rootId);
+
+ private:
+  DirectoryProfilePrefetcher(const DirectoryProfilePrefetcher&) = delete;
+  DirectoryProfilePrefetcher& operator=(const DirectoryProfilePrefetcher&) =
+      delete;
+
+  struct Queue {
+    std::shared_ptr<const Tree> rootTree;
+    std::deque<RelativePath> paths;
+    size_t numInProgress{0};
+  };
+
+  /**
+   * Starts fetching queued directories until the in-flight limit is reached.
+   */
+  void fetchQueued();
+
+  std::shared_ptr<ObjectStore> objectStore_;
+  std::shared_ptr<ServerState> serverState_;
+  std::unique_ptr<ObjectFetchContext> context_;
+  folly::Synchronized<DirectoryAccessProfile, std::mutex> profile_;
+  folly::Synchronized<Queue, std::mutex> queue_;
+};
+
+} // namespace facebook::eden
@@ -19,14 +19,22 @@
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
 #include <gflags/gflags.h>
+#include <algorithm>
+#include <map>
+#include <unordered_set>
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/inodes/CheckoutContext.h"
+#include "eden/fs/inodes/CheckoutTreePrefetcher.h"
+#include "eden/fs/inodes/DirectoryProfilePrefetcher.h"
 #include "eden/fs/inodes/EdenDispatcherFactory.h"
 #include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/inodes/GlobResultCache.h"
 #include "eden/fs/inodes/InodeError.h"
 #include "eden/fs/inodes/InodeMap.h"
+#include "eden/fs/inodes/ScmStatusCache.h"
 #include "eden/fs/inodes/ServerState.h"
+#include "eden/fs/inodes/SpeculativeTreePrefetcher.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/inodes/TreePrefetchLease.h"
 #include "eden/fs/model/Hash.h"
@@ -51,6 +59,7 @@
 #include "eden/fs/utils/NfsSocket.h"
 #include "eden/fs/utils/PathFuncs.h"
 #include "eden/fs/utils/SpawnedProcess.h"
+#include "eden/fs/utils/SystemError.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 #ifdef _WIN32
@@ -165,10 +174,9 @@ constexpr int EdenMount::kMaxSymlinkChainDepth;
 static constexpr folly::StringPiece kEdenStracePrefix = "eden.strace.";
 
 // We compute this when the process is initialized, but stash a copy
-// in each EdenMount.  We may in the future manage to propagate enough
-// state across upgrades or restarts that we can preserve this, but
-// as implemented today, a process restart will invalidate any cached
-// mountGeneration that a client may be holding on to.
+// in each EdenMount.  Unless the journal is persisted across restarts (see
+// EdenMount::restoreSavedJournal()), a process restart will invalidate any
+// cached mountGeneration that a client may be holding on to.
 // We take the bottom 16-bits of the pid and 32-bits of the current
 // time and shift them up, leaving 16 bits for a mount point generation
 // number.
@@ -218,16 +226,33 @@ EdenMount::EdenMount(
           checkoutConfig_->getOverlayPath(),
           checkoutConfig_->getCaseSensitive(),
           getOverlayType(),
-          serverState_->getStructuredLogger())},
+          serverState_->getStructuredLogger(),
+          TreeOverlay::WriteBatching{
+              std::chrono::duration_cast<std::chrono::milliseconds>(
+                  getEdenConfig()->overlayBufferedWriteMaxDelay.getValue()),
+              getEdenConfig()->overlayBufferedWriteMaxPending.getValue(),
+              std::chrono::duration_cast<std::chrono::milliseconds>(
+                  getEdenConfig()->overlayCheckpointInterval.getValue())},
+          getEdenConfig()->overlayGCThreadCount.getValue())},
 #ifndef _WIN32
-      overlayFileAccess_{overlay_.get()},
+      overlayFileAccess_{overlay_.get(), makeBlobFileStore()},
 #endif
       journal_{std::move(journal)},
-      mountGeneration_{globalProcessGeneration | ++mountGeneration},
+      mountGeneration_{restoreSavedJournal()},
       straceLogger_{
           kEdenStracePrefix.str() + checkoutConfig_->getMountPath().value()},
       lastCheckoutTime_{EdenTimestamp{serverState_->getClock()->getRealtime()}},
       owner_{Owner{getuid(), getgid()}},
+      speculativeTreePrefetcher_{std::make_shared<SpeculativeTreePrefetcher>(
+          objectStore_,
+          serverState_)},
+      directoryProfilePrefetcher_{
+          std::make_shared<DirectoryProfilePrefetcher>(
+              objectStore_,
+              serverState_)},
+      globResultCache_{std::make_unique<GlobResultCache>(
+          serverState_->getEdenConfig()->globResultCacheMaxPaths.getValue())},
+      statusCache_{std::make_unique<ScmStatusCache>()},
       clock_{serverState_->getClock()} {
 }
 
@@ -236,6 +261,9 @@ Overlay::OverlayType EdenMount::getOverlayType() {
     if (getEdenConfig()->unsafeInMemoryOverlay.getValue()) {
       return Overlay::OverlayType::TreeInMemory;
     }
+    if (getEdenConfig()->overlayCheckpointInterval.getValue().count() > 0) {
+      return Overlay::OverlayType::TreeCheckpointed;
+    }
     if (getEdenConfig()->overlaySynchronousMode.getValue() == "off") {
       return Overlay::OverlayType::TreeSynchronousOff;
     }
@@ -245,6 +273,19 @@ Overlay::OverlayType EdenMount::getOverlayType() {
   }
 }
 
+#ifndef _WIN32
+std::unique_ptr<BlobFileStore> EdenMount::makeBlobFileStore() {
+  auto maxBytes = getEdenConfig()->overlayBlobFileStoreSize.getValue();
+  if (maxBytes == 0 || getOverlayType() != Overlay::OverlayType::Legacy) {
+    return nullptr;
+  }
+  return std::make_unique<BlobFileStore>(
+      checkoutConfig_->getClientDirectory() + "blobs"_pc,
+      maxBytes,
+      getEdenConfig()->overlayBlobFileMinSize.getValue());
+}
+#endif
+
 FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::initialize(
     OverlayChecker::ProgressCallback&& progressCallback,
     const std::optional<SerializedInodeMap>& takeover) {
@@ -260,8 +301,11 @@ FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::initialize(
 
         // Record the transition from no snapshot to the current snapshot in
         // the journal.  This also sets things up so that we can carry the
-        // snapshot id forward through subsequent journal entries.
-        journal_->recordHashUpdate(parent);
+        // snapshot id forward through subsequent journal entries. A restored
+        // journal is already on this snapshot.
+        if (journal_->getLatestSequenceNumber() == 0) {
+          journal_->recordHashUpdate(parent);
+        }
 
         // Initialize the overlay.
         // This must be performed before we do any operations that may
@@ -271,9 +315,10 @@ FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::initialize(
       })
       .thenValue(
           [this](RootId parent) { return createRootInode(std::move(parent)); })
-      .thenValue([this, takeover](TreeInodePtr initTreeNode) {
+      .thenValue([this, takeover](TreeInodePtr initTreeNode) mutable {
         if (takeover) {
-          inodeMap_->initializeFromTakeover(std::move(initTreeNode), *takeover);
+          inodeMap_->initializeFromTakeover(
+              std::move(initTreeNode), std::move(*takeover));
         } else if (isWorkingCopyPersistent()) {
           inodeMap_->initializeFromOverlay(std::move(initTreeNode), *overlay_);
         } else {
@@ -475,6 +520,57 @@ FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::addBindMount(
       });
 }
 
+FOLLY_NODISCARD folly::Future<std::vector<folly::Try<folly::Unit>>>
+EdenMount::addBindMounts(
+    std::vector<std::pair<RelativePath, AbsolutePath>> bindMounts,
+    ObjectFetchContext& context) {
+  std::vector<ImmediateFuture<TreeInodePtr>> directories;
+  directories.reserve(bindMounts.size());
+  for (const auto& bindMount : bindMounts) {
+    directories.push_back(ensureDirectoryExists(bindMount.first, context));
+  }
+
+  return collectAll(std::move(directories))
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance())
+      .thenValue([this, bindMounts = std::move(bindMounts)](
+                     std::vector<folly::Try<TreeInodePtr>> directories) {
+        std::vector<folly::Try<Unit>> results(bindMounts.size());
+        std::vector<std::pair<std::string, std::string>> requests;
+        std::vector<size_t> requestIndices;
+        for (size_t i = 0; i < bindMounts.size(); ++i) {
+          if (directories[i].hasException()) {
+            results[i] = folly::Try<Unit>{directories[i].exception()};
+            continue;
+          }
+          const auto& [repoPath, target] = bindMounts[i];
+          requests.emplace_back(target.value(), (getPath() + repoPath).value());
+          requestIndices.push_back(i);
+        }
+        if (requests.empty()) {
+          return folly::makeFuture(std::move(results));
+        }
+
+        return serverState_->getPrivHelper()->bindMounts(requests).thenValue(
+            [results = std::move(results),
+             requestIndices = std::move(requestIndices)](
+                std::vector<folly::Try<Unit>> mounted) mutable {
+              if (mounted.size() != requestIndices.size()) {
+                throw std::runtime_error(folly::to<std::string>(
+                    "privhelper returned ",
+                    mounted.size(),
+                    " bind mount results for ",
+                    requestIndices.size(),
+                    " requests"));
+              }
+              for (size_t i = 0; i < mounted.size(); ++i) {
+                results[requestIndices[i]] = std::move(mounted[i]);
+              }
+              return std::move(results);
+            });
+      });
+}
+
 FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::removeBindMount(
     RelativePathPiece repoPath) {
   auto absRepoPath = getPath() + repoPath;
@@ -615,6 +711,30 @@ TreeEntryType toEdenTreeEntryType(facebook::eden::ObjectType objectType) {
   throw std::runtime_error("unsupported root type");
 }
 
+/**
+ * Build the tree checked out for the blobs of a directory. Tree entries must
+ * be sorted by name, and when a name is set more than once, the last one
+ * wins, as if the blobs were set one after the other.
+ */
+std::shared_ptr<const Tree> makeBlobsTree(
+    std::vector<std::shared_ptr<TreeEntry>> entries) {
+  std::stable_sort(
+      entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs->getName() < rhs->getName();
+      });
+  std::vector<TreeEntry> treeEntries;
+  treeEntries.reserve(entries.size());
+  for (const auto& entry : entries) {
+    if (!treeEntries.empty() &&
+        treeEntries.back().getName() == entry->getName()) {
+      treeEntries.back() = *entry;
+    } else {
+      treeEntries.push_back(*entry);
+    }
+  }
+  return std::make_shared<const Tree>(std::move(treeEntries));
+}
+
 } // namespace
 
 folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathObjectId(
@@ -623,8 +743,62 @@ folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathObjectId(
     FOLLY_MAYBE_UNUSED ObjectType objectType,
     FOLLY_MAYBE_UNUSED CheckoutMode checkoutMode,
     FOLLY_MAYBE_UNUSED ObjectFetchContext& context) {
-  if (objectType == facebook::eden::ObjectType::SYMLINK) {
-    throw std::runtime_error("setPathObjectId does not support symlink type");
+  std::vector<SetPathObjectIdObjectAndPath> objects;
+  objects.push_back(
+      SetPathObjectIdObjectAndPath{path.copy(), rootId, objectType});
+  return setPathsToObjectIds(std::move(objects), checkoutMode, context);
+}
+
+folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathsToObjectIds(
+    std::vector<SetPathObjectIdObjectAndPath> objects,
+    CheckoutMode checkoutMode,
+    ObjectFetchContext& /*context*/) {
+  if (objects.empty()) {
+    return folly::makeFuture(SetPathObjectIdResultAndTimes{});
+  }
+
+  // Group the objects by the directory that is checked out: a tree is
+  // grafted on top of the directory at its path, while a blob is added to
+  // its parent directory.
+  struct Group {
+    std::vector<const SetPathObjectIdObjectAndPath*> trees;
+    std::vector<const SetPathObjectIdObjectAndPath*> blobs;
+  };
+  std::map<RelativePath, Group, std::less<>> groups;
+  std::unordered_set<RelativePathPiece> blobPaths;
+  for (const auto& object : objects) {
+    if (object.type == facebook::eden::ObjectType::SYMLINK) {
+      throw std::runtime_error("setPathObjectId does not support symlink type");
+    }
+    if (object.type == facebook::eden::ObjectType::TREE) {
+      groups[object.path].trees.push_back(&object);
+    } else {
+      groups[object.path.dirname().copy()].blobs.push_back(&object);
+      blobPaths.insert(object.path);
+    }
+  }
+  for (const auto& [target, group] : groups) {
+    for (auto dir : target.allPaths()) {
+      auto it = groups.find(dir);
+      if (dir != target && it != groups.end() && !it->second.trees.empty()) {
+        throw newEdenError(
+            EINVAL,
+            EdenErrorType::ARGUMENT_ERROR,
+            "cannot set ",
+            target,
+            " in the same call as its parent directory ",
+            dir);
+      }
+      if (blobPaths.count(dir)) {
+        throw newEdenError(
+            EINVAL,
+            EdenErrorType::ARGUMENT_ERROR,
+            "cannot set ",
+            target,
+            " in the same call as the file ",
+            dir);
+      }
+    }
   }
 
   const folly::stop_watch<> stopWatch;
@@ -637,8 +811,9 @@ folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathObjectId(
    */
   auto oldParent = parentCommit_.rlock();
   setPathObjectIdTime->didAcquireParentsLock = stopWatch.elapsed();
-  XLOG(DBG3) << "adding " << rootId << " to Eedn mount " << this->getPath()
-             << " at path" << path << " on top of " << *oldParent;
+  XLOG(DBG3) << "adding " << objects.size() << " objects in " << groups.size()
+             << " directories to Eden mount " << this->getPath()
+             << " on top of " << *oldParent;
 
   auto ctx = std::make_shared<CheckoutContext>(
       this, checkoutMode, std::nullopt, "setPathObjectId");
@@ -649,42 +824,83 @@ folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathObjectId(
    * partial node so only affects its children.
    */
   setLastCheckoutTime(EdenTimestamp{clock_->getRealtime()});
-  bool isTree = (objectType == facebook::eden::ObjectType::TREE);
-
-  auto getTargetTreeInodeFuture =
-      ensureDirectoryExists(
-          isTree ? path : path.dirname(), ctx->getFetchContext())
-          .semi()
-          .via(&folly::QueuedImmediateExecutor::instance());
-
-  auto getRootTreeFuture = isTree
-      ? objectStore_->getRootTree(rootId, ctx->getFetchContext())
-      : objectStore_
-            ->getTreeEntryForRootId(
-                rootId,
-                toEdenTreeEntryType(objectType),
-                path.basename(),
-                ctx->getFetchContext())
-            .thenValue([](std::shared_ptr<TreeEntry> treeEntry) {
-              return std::make_shared<Tree>(std::vector<TreeEntry>{*treeEntry});
-            });
 
-  return collectSafe(getTargetTreeInodeFuture, getRootTreeFuture)
+  std::vector<folly::Future<TreeInodePtr>> targetFutures;
+  std::vector<folly::Future<std::vector<shared_ptr<const Tree>>>>
+      incomingFutures;
+  targetFutures.reserve(groups.size());
+  incomingFutures.reserve(groups.size());
+  for (const auto& [target, group] : groups) {
+    targetFutures.push_back(
+        ensureDirectoryExists(target, ctx->getFetchContext())
+            .semi()
+            .via(&folly::QueuedImmediateExecutor::instance()));
+
+    // Trees grafted on the same directory are checked out in the order they
+    // were given, and all the blobs of the directory last, as one tree.
+    std::vector<folly::Future<shared_ptr<const Tree>>> trees;
+    for (const auto* object : group.trees) {
+      trees.push_back(
+          objectStore_->getRootTree(object->id, ctx->getFetchContext()));
+    }
+    if (!group.blobs.empty()) {
+      std::vector<folly::Future<std::shared_ptr<TreeEntry>>> entries;
+      entries.reserve(group.blobs.size());
+      for (const auto* object : group.blobs) {
+        entries.push_back(objectStore_->getTreeEntryForRootId(
+            object->id,
+            toEdenTreeEntryType(object->type),
+            object->path.basename(),
+            ctx->getFetchContext()));
+      }
+      trees.push_back(
+          collectSafe(std::move(entries)).thenValue(&makeBlobsTree));
+    }
+    incomingFutures.push_back(collectSafe(std::move(trees)));
+  }
+
+  auto newParent = objects.back().id;
+  return collectSafe(
+             collectSafe(std::move(targetFutures)),
+             collectSafe(std::move(incomingFutures)))
       .thenValue([this, ctx, setPathObjectIdTime, stopWatch](
-                     std::tuple<TreeInodePtr, shared_ptr<const Tree>> results) {
+                     std::tuple<
+                         std::vector<TreeInodePtr>,
+                         std::vector<std::vector<shared_ptr<const Tree>>>>
+                         results) {
         setPathObjectIdTime->didLookupTreesOrGetInodeByPath =
             stopWatch.elapsed();
-        auto [targetTreeInode, incomingTree] = results;
-        targetTreeInode->unloadChildrenUnreferencedByFs();
+        auto& [targetTreeInodes, incomingTrees] = results;
+        for (const auto& targetTreeInode : targetTreeInodes) {
+          targetTreeInode->unloadChildrenUnreferencedByFs();
+        }
         // TODO(@yipu): Remove rename lock
         ctx->start(this->acquireRenameLock());
         setPathObjectIdTime->didAcquireRenameLock = stopWatch.elapsed();
-        return targetTreeInode->checkout(ctx.get(), nullptr, incomingTree);
+
+        // The directories don't overlap, so they can be checked out
+        // concurrently, like the children of a directory during a checkout.
+        std::vector<folly::Future<folly::Unit>> checkoutFutures;
+        checkoutFutures.reserve(targetTreeInodes.size());
+        for (size_t i = 0; i < targetTreeInodes.size(); ++i) {
+          auto future = makeFuture();
+          for (auto& incomingTree : incomingTrees[i]) {
+            future = std::move(future).thenValue(
+                [ctx,
+                 targetTreeInode = targetTreeInodes[i],
+                 incomingTree = std::move(incomingTree)](auto&&) {
+                  return targetTreeInode->checkout(
+                      ctx.get(), nullptr, incomingTree);
+                });
+          }
+          checkoutFutures.push_back(std::move(future));
+        }
+        return folly::collect(std::move(checkoutFutures)).unit();
       })
-      .thenValue([ctx, setPathObjectIdTime, stopWatch, rootId](auto&&) {
+      .thenValue([ctx, setPathObjectIdTime, stopWatch, newParent](auto&&) {
         setPathObjectIdTime->didCheckout = stopWatch.elapsed();
         // Complete and save the new snapshot
-        return ctx->finish(rootId);
+        return ctx->finish(newParent);
       })
       .thenValue([ctx, setPathObjectIdTime, stopWatch](
                      std::vector<CheckoutConflict>&& conflicts) {
@@ -696,14 +912,14 @@ folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathObjectId(
         resultAndTimes.result = std::move(result);
         return resultAndTimes;
       })
-      .thenTry([this, ctx, oldParent = *oldParent, rootId](
+      .thenTry([this, ctx, oldParent = *oldParent, newParent](
                    Try<SetPathObjectIdResultAndTimes>&& resultAndTimes) {
         auto fetchStats = ctx->getFetchContext().computeStatistics();
         logStats(
             resultAndTimes.hasValue(),
             this->getPath(),
             oldParent,
-            rootId,
+            newParent,
             fetchStats,
             "setPathObjectId");
         return std::move(resultAndTimes);
@@ -774,6 +990,47 @@ folly::SemiFuture<SerializedInodeMap> EdenMount::shutdown(
   return shutdownImpl(doTakeover);
 }
 
+uint64_t EdenMount::restoreSavedJournal() {
+  auto path = checkoutConfig_->getSavedJournalPath();
+  std::optional<uint64_t> savedGeneration;
+  if (getEdenConfig()->persistJournal.getValue()) {
+    try {
+      savedGeneration = journal_->loadFromFile(
+          path, checkoutConfig_->getParentCommit());
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "unable to restore the journal for " << getPath() << ": "
+                 << folly::exceptionStr(ex);
+    }
+  }
+  boost::system::error_code error;
+  boost::filesystem::remove(boost::filesystem::path{path.value()}, error);
+  if (error) {
+    XLOG(WARN) << "unable to remove saved journal " << path << ": "
+               << error.message();
+  }
+
+  if (savedGeneration) {
+    XLOG(INFO) << "restored the journal for " << getPath() << " at sequence "
+               << journal_->getLatestSequenceNumber();
+    return *savedGeneration;
+  }
+  return globalProcessGeneration | ++mountGeneration;
+}
+
+void EdenMount::saveJournal() {
+  if (!getEdenConfig()->persistJournal.getValue()) {
+    return;
+  }
+  try {
+    journal_->saveToFile(
+        checkoutConfig_->getSavedJournalPath(), mountGeneration_);
+    XLOG(DBG1) << "saved the journal for " << getPath();
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "unable to save the journal for " << getPath() << ": "
+               << folly::exceptionStr(ex);
+  }
+}
+
 folly::SemiFuture<SerializedInodeMap> EdenMount::shutdownImpl(bool doTakeover) {
   journal_->cancelAllSubscribers();
   XLOG(DBG1) << "beginning shutdown for EdenMount " << getPath();
@@ -781,6 +1038,8 @@ folly::SemiFuture<SerializedInodeMap> EdenMount::shutdownImpl(bool doTakeover) {
   return inodeMap_->shutdown(doTakeover)
       .thenValue([this](SerializedInodeMap inodeMap) {
         XLOG(DBG1) << "shutdown complete for EdenMount " << getPath();
+        // Every inode is unloaded, so nothing can be journaled anymore.
+        saveJournal();
         // Close the Overlay object to make sure we have released its lock.
         // This is important during graceful restart to ensure that we have
         // released the lock before the new edenfs process begins to take over
@@ -1235,6 +1494,7 @@ folly::Future<CheckoutResult> EdenMount::checkout(
   return serverState_->getFaultInjector()
       .checkAsync("checkout", getPath().stringPiece())
       .via(getServerThreadPool().get())
+      .thenValue([this](auto&&) { return waitForPendingNotifications(); })
       .thenValue([this, ctx, parent1Hash = oldParent, snapshotHash](auto&&) {
         auto fromTreeFuture =
             objectStore_->getRootTree(parent1Hash, ctx->getFetchContext());
@@ -1297,7 +1557,29 @@ folly::Future<CheckoutResult> EdenMount::checkout(
         // these.
         this->getRootInode()->unloadChildrenUnreferencedByFs();
 
+        // Fetch the trees the checkout will need ahead of it, so that it
+        // does not wait for a round of fetches at each level of the tree.
+        // The checkout waits for this to finish before completing, as the
+        // prefetch uses its fetch context.
         auto rootInode = getRootInode();
+        ImmediateFuture<folly::Unit> prefetchFuture{folly::unit};
+        auto prefetchBatchSize = serverState_->getEdenConfig()
+                                     ->checkoutTreePrefetchBatchSize.getValue();
+        if (prefetchBatchSize != 0 && !ctx->isDryRun()) {
+          prefetchFuture =
+              prefetchCheckoutTrees(
+                  objectStore_.get(),
+                  ctx->getFetchContext(),
+                  ctx->getTreePins(),
+                  rootInode,
+                  std::get<0>(treeResults),
+                  std::get<1>(treeResults),
+                  prefetchBatchSize)
+                  .thenTry([checkoutTimes, stopWatch](auto&&) {
+                    checkoutTimes->didPrefetchTrees = stopWatch.elapsed();
+                  });
+        }
+
         return serverState_->getFaultInjector()
             .checkAsync("inodeCheckout", getPath().stringPiece())
             .via(getServerThreadPool().get())
@@ -1306,6 +1588,14 @@ folly::Future<CheckoutResult> EdenMount::checkout(
                         rootInode = std::move(rootInode)](auto&&) mutable {
               auto& [fromTree, toTree] = treeResults;
               return rootInode->checkout(ctx.get(), fromTree, toTree);
+            })
+            .thenTry([prefetchFuture = std::move(prefetchFuture)](
+                         Try<Unit>&& result) mutable {
+              return std::move(prefetchFuture)
+                  .thenValue([result = std::move(result)](auto&&) mutable {
+                    return std::move(result).value();
+                  })
+                  .semi();
             });
       })
       .thenValue([ctx, checkoutTimes, stopWatch, snapshotHash](auto&&) {
@@ -1348,6 +1638,8 @@ folly::Future<CheckoutResult> EdenMount::checkout(
             journal_->recordUncleanPaths(
                 oldParent, snapshotHash, std::move(uncleanPaths));
 
+            directoryProfilePrefetcher_->checkoutCompleted(snapshotHash);
+
             return result;
           })
       .thenTry([this, ctx, stopWatch, oldParent, snapshotHash, checkoutMode](
@@ -1421,7 +1713,8 @@ file.
 std::unique_ptr<DiffContext> EdenMount::createDiffContext(
     DiffCallback* callback,
     bool listIgnored,
-    ResponseChannelRequest* request) const {
+    ResponseChannelRequest* request,
+    bool summarizeUntrackedDirectories) const {
   // We hold a reference to the root inode to ensure that
   // the EdenMount cannot be destroyed while the DiffContext
   // is still using it.
@@ -1438,11 +1731,25 @@ std::unique_ptr<DiffContext> EdenMount::createDiffContext(
       getObjectStore(),
       serverState_->getTopLevelIgnores(),
       std::move(loadContents),
-      request);
+      request,
+      folly::getKeepAliveToken(getServerThreadPool().get()),
+      serverState_->getEdenConfig()->maxParallelDiffs.getValue(),
+      &serverState_->getGitIgnoreCache(),
+      summarizeUntrackedDirectories,
+      serverState_->getEdenConfig()->operationTreePinBudget.getValue());
 }
 
 Future<Unit> EdenMount::diff(DiffContext* ctxPtr, const RootId& commitHash)
     const {
+  auto pending = waitForPendingNotifications();
+  if (!pending.isReady()) {
+    return std::move(pending)
+        .via(getServerThreadPool().get())
+        .thenValue([this, ctxPtr, commitHash](auto&&) {
+          return diff(ctxPtr, commitHash);
+        });
+  }
+
   auto rootInode = getRootInode();
   return objectStore_->getRootTree(commitHash, ctxPtr->getFetchContext())
       .thenValue([ctxPtr, rootInode = std::move(rootInode)](
@@ -1456,43 +1763,63 @@ Future<Unit> EdenMount::diff(DiffContext* ctxPtr, const RootId& commitHash)
       });
 }
 
+folly::SemiFuture<folly::Unit> EdenMount::waitForPendingNotifications()
+    const {
+#ifdef _WIN32
+  if (auto* channel = getPrjfsChannel()) {
+    return channel->waitForPendingNotifications();
+  }
+#endif
+  return folly::unit;
+}
+
+folly::exception_wrapper EdenMount::checkStatusParent(
+    const RootId& commitHash) const {
+  auto parentInfo = parentCommit_.rlock(std::chrono::milliseconds{500});
+
+  if (!parentInfo) {
+    // We failed to get the lock, which generally means a checkout is in
+    // progress.
+    return newEdenError(
+        EdenErrorType::CHECKOUT_IN_PROGRESS,
+        "cannot compute status while a checkout is currently in progress");
+  }
+
+  if (*parentInfo != commitHash) {
+    // Log this occurrence to Scuba
+    getServerState()->getStructuredLogger()->logEvent(
+        ParentMismatch{commitHash.value(), parentInfo->value()});
+    return newEdenError(
+        EdenErrorType::OUT_OF_DATE_PARENT,
+        "error computing status: requested parent commit is out-of-date: requested ",
+        commitHash,
+        ", but current parent commit is ",
+        *parentInfo,
+        ".\nTry running `eden doctor` to remediate");
+  }
+
+  // TODO: Should we perhaps hold the parentInfo read-lock for the duration
+  // of the status operation?  This would block new checkout operations from
+  // starting until we have finished computing this status call.
+  return folly::exception_wrapper{};
+}
+
 Future<Unit> EdenMount::diff(
     DiffCallback* callback,
     const RootId& commitHash,
     bool listIgnored,
     bool enforceCurrentParent,
-    ResponseChannelRequest* request) const {
+    ResponseChannelRequest* request,
+    bool summarizeUntrackedDirectories) const {
   if (enforceCurrentParent) {
-    auto parentInfo = parentCommit_.rlock(std::chrono::milliseconds{500});
-
-    if (!parentInfo) {
-      // We failed to get the lock, which generally means a checkout is in
-      // progress.
-      return makeFuture<Unit>(newEdenError(
-          EdenErrorType::CHECKOUT_IN_PROGRESS,
-          "cannot compute status while a checkout is currently in progress"));
-    }
-
-    if (*parentInfo != commitHash) {
-      // Log this occurrence to Scuba
-      getServerState()->getStructuredLogger()->logEvent(
-          ParentMismatch{commitHash.value(), parentInfo->value()});
-      return makeFuture<Unit>(newEdenError(
-          EdenErrorType::OUT_OF_DATE_PARENT,
-          "error computing status: requested parent commit is out-of-date: requested ",
-          commitHash,
-          ", but current parent commit is ",
-          *parentInfo,
-          ".\nTry running `eden doctor` to remediate"));
+    if (auto error = checkStatusParent(commitHash)) {
+      return makeFuture<Unit>(std::move(error));
     }
-
-    // TODO: Should we perhaps hold the parentInfo read-lock for the duration
-    // of the status operation?  This would block new checkout operations from
-    // starting until we have finished computing this status call.
   }
 
   // Create a DiffContext object for this diff operation.
-  auto context = createDiffContext(callback, listIgnored, request);
+  auto context = createDiffContext(
+      callback, listIgnored, request, summarizeUntrackedDirectories);
   DiffContext* ctxPtr = context.get();
 
   // stateHolder() exists to ensure that the DiffContext and GitIgnoreStack
@@ -1506,14 +1833,291 @@ folly::Future<std::unique_ptr<ScmStatus>> EdenMount::diff(
     const RootId& commitHash,
     bool listIgnored,
     bool enforceCurrentParent,
+    ResponseChannelRequest* request,
+    bool summarizeUntrackedDirectories) {
+  // The journal position read below must include the pending changes.
+  auto pending = waitForPendingNotifications();
+  if (!pending.isReady()) {
+    return std::move(pending)
+        .via(getServerThreadPool().get())
+        .thenValue([this,
+                    commitHash,
+                    listIgnored,
+                    enforceCurrentParent,
+                    request,
+                    summarizeUntrackedDirectories](auto&&) {
+          return diff(
+              commitHash,
+              listIgnored,
+              enforceCurrentParent,
+              request,
+              summarizeUntrackedDirectories);
+        });
+  }
+
+  auto config = serverState_->getEdenConfig(ConfigReloadBehavior::NoReload);
+  if (!config->incrementalStatus.getValue() || summarizeUntrackedDirectories) {
+    auto callback = std::make_unique<ScmStatusDiffCallback>();
+    auto callbackPtr = callback.get();
+    return this
+        ->diff(
+            callbackPtr,
+            commitHash,
+            listIgnored,
+            enforceCurrentParent,
+            request,
+            summarizeUntrackedDirectories)
+        .thenValue([callback = std::move(callback)](auto&&) {
+          return std::make_unique<ScmStatus>(callback->extractStatus());
+        });
+  }
+
+  if (enforceCurrentParent) {
+    if (auto error = checkStatusParent(commitHash)) {
+      return makeFuture<std::unique_ptr<ScmStatus>>(std::move(error));
+    }
+  }
+
+  // The journal position is read before looking at the working copy, so
+  // that changes made while the status is computed are replayed next time.
+  auto sequence = journal_->getLatestSequenceNumber();
+  auto cached = statusCache_->get(commitHash, listIgnored);
+  if (!cached) {
+    return computeAndCacheStatus(commitHash, listIgnored, sequence, request);
+  }
+  if (cached->sequence == sequence) {
+    return std::make_unique<ScmStatus>(*cached->status);
+  }
+
+  auto range = journal_->accumulateRange(cached->sequence + 1);
+  if (!range) {
+    return computeAndCacheStatus(commitHash, listIgnored, sequence, request);
+  }
+  sequence = range->toSequence;
+  return updateCachedStatus(cached->status, commitHash, *range)
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance())
+      .thenValue([self = shared_from_this(),
+                  commitHash,
+                  listIgnored,
+                  sequence,
+                  request](std::shared_ptr<const ScmStatus> status) {
+        if (!status) {
+          return self->computeAndCacheStatus(
+              commitHash, listIgnored, sequence, request);
+        }
+        self->statusCache_->insert(commitHash, listIgnored, sequence, status);
+        return makeFuture(std::make_unique<ScmStatus>(*status));
+      });
+}
+
+folly::Future<std::unique_ptr<ScmStatus>> EdenMount::computeAndCacheStatus(
+    const RootId& commitHash,
+    bool listIgnored,
+    JournalDelta::SequenceNumber sequence,
     ResponseChannelRequest* request) {
   auto callback = std::make_unique<ScmStatusDiffCallback>();
   auto callbackPtr = callback.get();
+  // The parent commit was already checked by our caller.
   return this
       ->diff(
-          callbackPtr, commitHash, listIgnored, enforceCurrentParent, request)
-      .thenValue([callback = std::move(callback)](auto&&) {
-        return std::make_unique<ScmStatus>(callback->extractStatus());
+          callbackPtr,
+          commitHash,
+          listIgnored,
+          /*enforceCurrentParent=*/false,
+          request)
+      .thenValue([self = shared_from_this(),
+                  callback = std::move(callback),
+                  commitHash,
+                  listIgnored,
+                  sequence](auto&&) {
+        auto status = std::make_unique<ScmStatus>(callback->extractStatus());
+        // Errors may be transient, so don't let them stick around.
+        if (status->errors_ref()->empty()) {
+          self->statusCache_->insert(
+              commitHash,
+              listIgnored,
+              sequence,
+              std::make_shared<const ScmStatus>(*status));
+        }
+        return status;
+      });
+}
+
+namespace {
+/**
+ * The status of a single path, as re-checked by updateCachedStatus.
+ */
+struct PathStatus {
+  /**
+   * The path could not be re-checked on its own, for example because it is
+   * a directory, and a full diff is needed.
+   */
+  bool needsFullDiff{false};
+  std::optional<ScmFileStatus> status;
+};
+
+/**
+ * Look up the source control entry at path below tree, or std::nullopt if
+ * there is none.
+ */
+ImmediateFuture<std::optional<TreeEntry>> lookupScmEntry(
+    const ObjectStore* store,
+    std::shared_ptr<const Tree> tree,
+    RelativePath path,
+    ObjectFetchContext& context) {
+  auto pathStr = path.stringPiece();
+  auto slash = pathStr.find('/');
+  auto* entry =
+      tree->getEntryPtr(PathComponentPiece{pathStr.subpiece(0, slash)});
+  if (!entry) {
+    return std::optional<TreeEntry>{};
+  }
+  if (slash == folly::StringPiece::npos) {
+    return std::optional<TreeEntry>{*entry};
+  }
+  if (!entry->isTree()) {
+    return std::optional<TreeEntry>{};
+  }
+  return store->getTree(entry->getHash(), context)
+      .thenValue([store,
+                  rest = RelativePath{pathStr.subpiece(slash + 1)},
+                  &context](std::shared_ptr<const Tree> child) mutable {
+        return lookupScmEntry(
+            store, std::move(child), std::move(rest), context);
+      });
+}
+
+/**
+ * Look up the inode at path in the working copy, or nullptr if there is
+ * none.
+ */
+ImmediateFuture<InodePtr> lookupInode(
+    EdenMount& mount,
+    RelativePathPiece path,
+    ObjectFetchContext& context) {
+  return mount.getInode(path, context)
+      .thenTry([](folly::Try<InodePtr> inode) -> folly::Try<InodePtr> {
+        if (inode.hasException()) {
+          auto* err = inode.exception().get_exception<std::system_error>();
+          if (err && (isEnoent(*err) || err->code().value() == ENOTDIR)) {
+            return folly::Try<InodePtr>{InodePtr{}};
+          }
+        }
+        return inode;
+      });
+}
+
+ImmediateFuture<PathStatus> getPathStatus(
+    const std::shared_ptr<EdenMount>& mount,
+    std::shared_ptr<const Tree> rootTree,
+    RelativePath path,
+    std::optional<ScmFileStatus> previous,
+    ObjectFetchContext& context) {
+  auto scmEntry = lookupScmEntry(
+      mount->getObjectStore(), std::move(rootTree), path.copy(), context);
+  auto inode = lookupInode(*mount, path, context);
+  return collectAllSafe(std::move(scmEntry), std::move(inode))
+      .thenValue([previous, &context](
+                     std::tuple<std::optional<TreeEntry>, InodePtr>&& entries)
+                     -> ImmediateFuture<PathStatus> {
+        auto& [scmEntry, inode] = entries;
+        if ((scmEntry && scmEntry->isTree()) ||
+            (inode && inode.asTreePtrOrNull())) {
+          // Everything under a directory may have changed.
+          return PathStatus{true, std::nullopt};
+        }
+        if (!inode) {
+          return PathStatus{
+              false,
+              scmEntry ? std::make_optional(ScmFileStatus::REMOVED)
+                       : std::nullopt};
+        }
+        if (!scmEntry) {
+          // An untracked file keeps its status while it exists. Deciding
+          // whether a new one is ignored requires the full ignore rules.
+          if (previous == ScmFileStatus::ADDED ||
+              previous == ScmFileStatus::IGNORED) {
+            return PathStatus{false, previous};
+          }
+          return PathStatus{true, std::nullopt};
+        }
+        return inode.asFilePtr()
+            ->isSameAs(scmEntry->getHash(), scmEntry->getType(), context)
+            .thenValue([](bool isSame) {
+              return PathStatus{
+                  false,
+                  isSame ? std::nullopt
+                         : std::make_optional(ScmFileStatus::MODIFIED)};
+            });
+      });
+}
+
+/**
+ * Above this many changed paths, a full diff is likely to be cheaper than
+ * re-checking each of them.
+ */
+constexpr size_t kMaxIncrementalStatusPaths = 1000;
+} // namespace
+
+ImmediateFuture<std::shared_ptr<const ScmStatus>> EdenMount::updateCachedStatus(
+    std::shared_ptr<const ScmStatus> status,
+    const RootId& commitHash,
+    const JournalDeltaRange& range) {
+  // Checkouts and resets change files without journaling each of them.
+  if (range.isTruncated || range.snapshotTransitions.size() > 1 ||
+      !range.uncleanPaths.empty() ||
+      range.changedFilesInOverlay.size() > kMaxIncrementalStatusPaths ||
+      getCheckoutConfig()->getCaseSensitive() !=
+          CaseSensitivity::Sensitive) {
+    return std::shared_ptr<const ScmStatus>{};
+  }
+
+  std::vector<RelativePath> paths;
+  paths.reserve(range.changedFilesInOverlay.size());
+  for (const auto& [path, info] : range.changedFilesInOverlay) {
+    if (path.basename() == PathComponentPiece{".gitignore"}) {
+      return std::shared_ptr<const ScmStatus>{};
+    }
+    paths.push_back(path);
+  }
+
+  auto& context = ObjectFetchContext::getNullContext();
+  return ImmediateFuture<std::shared_ptr<const Tree>>{
+      objectStore_->getRootTree(commitHash, context).semi()}
+      .thenValue([self = shared_from_this(),
+                  status = std::move(status),
+                  paths = std::move(paths),
+                  &context](std::shared_ptr<const Tree> rootTree) mutable {
+        std::vector<ImmediateFuture<PathStatus>> futures;
+        futures.reserve(paths.size());
+        const auto& entries = *status->entries_ref();
+        for (const auto& path : paths) {
+          auto it = entries.find(path.stringPiece().str());
+          auto previous = it == entries.end()
+              ? std::nullopt
+              : std::make_optional(it->second);
+          futures.push_back(
+              getPathStatus(self, rootTree, path.copy(), previous, context));
+        }
+        return collectAll(std::move(futures))
+            .thenValue([status = std::move(status), paths = std::move(paths)](
+                           std::vector<folly::Try<PathStatus>> results) {
+              auto updated = std::make_shared<ScmStatus>(*status);
+              auto& entries = *updated->entries_ref();
+              for (size_t i = 0; i < paths.size(); ++i) {
+                if (results[i].hasException() || results[i]->needsFullDiff) {
+                  return std::shared_ptr<const ScmStatus>{};
+                }
+                auto key = paths[i].stringPiece().str();
+                if (results[i]->status) {
+                  entries[key] = *results[i]->status;
+                } else {
+                  entries.erase(key);
+                }
+              }
+              return std::shared_ptr<const ScmStatus>{std::move(updated)};
+            });
       });
 }
 
@@ -1572,6 +2176,17 @@ std::string EdenMount::getCounterName(CounterName name) {
     case CounterName::PERIODIC_UNLINKED_INODE_UNLOAD:
       return folly::to<std::string>(
           "inodemap.", base, ".unloaded_unlinked_inodes");
+    case CounterName::INODEMAP_MEMORY_ESTIMATE:
+      return folly::to<std::string>("inodemap.", base, ".memory_estimate");
+    case CounterName::MEMORY_PRESSURE_INODE_UNLOAD:
+      return folly::to<std::string>(
+          "inodemap.", base, ".unloaded_for_memory_pressure");
+    case CounterName::OVERLAY_GC_QUEUE_DEPTH:
+      return folly::to<std::string>("overlay_gc.", base, ".queue_depth");
+    case CounterName::OVERLAY_GC_REMOVED_DIRECTORIES:
+      return folly::to<std::string>("overlay_gc.", base, ".removed_dirs");
+    case CounterName::OVERLAY_GC_REMOVED_FILES:
+      return folly::to<std::string>("overlay_gc.", base, ".removed_files");
   }
   EDEN_BUG() << "unknown counter name "
              << static_cast<std::underlying_type_t<CounterName>>(name);
@@ -1600,7 +2215,13 @@ std::unique_ptr<FuseChannel, FuseChannelDeleter> makeFuseChannel(
       mount->getServerState()->getNotifications(),
       mount->getCheckoutConfig()->getCaseSensitive(),
       mount->getCheckoutConfig()->getRequireUtf8Path(),
-      edenConfig->fuseMaximumRequests.getValue())};
+      edenConfig->fuseMaximumRequests.getValue(),
+      edenConfig->fuseSpliceReadReplies.getValue(),
+      edenConfig->fuseReaddirPlus.getValue(),
+      edenConfig->fuseWritebackCache.getValue(),
+      edenConfig->fusePrioritizeMetadataRequests.getValue(),
+      edenConfig->fuseUseIoUring.getValue(),
+      edenConfig->fuseWorkerAffinity.getValue())};
 }
 } // namespace
 #endif
@@ -1623,7 +2244,8 @@ folly::Future<folly::Unit> EdenMount::channelMount(bool readOnly) {
                      getCheckoutConfig()->getRepoGuid());
                  channel->start(
                      readOnly,
-                     edenConfig->prjfsUseNegativePathCaching.getValue());
+                     edenConfig->prjfsUseNegativePathCaching.getValue(),
+                     edenConfig->prjfsInvalidationThreads.getValue());
                  return channel;
                })
             .thenTry([this, mountPromise](
@@ -1662,7 +2284,8 @@ folly::Future<folly::Unit> EdenMount::channelMount(bool readOnly) {
                             edenConfig->nfsRequestTimeout.getValue()),
                         serverState_->getNotifications(),
                         checkoutConfig_->getCaseSensitive(),
-                        iosize);
+                        iosize,
+                        edenConfig->nfsAttrCacheSize.getValue());
                   });
           return std::move(fut).thenValue(
               [this,
@@ -1687,7 +2310,9 @@ folly::Future<folly::Unit> EdenMount::channelMount(bool readOnly) {
                         mountdAddr,
                         channel->getAddr(),
                         readOnly,
-                        iosize)
+                        iosize,
+                        serverState_->getEdenConfig()
+                            ->nfsUseReaddirplus.getValue())
                     .thenTry([this,
                               mountPromise = std::move(mountPromise),
                               channel = std::move(channel)](
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <folly/ExceptionWrapper.h>
 #include <folly/Portability.h>
 #include <folly/SharedMutex.h>
 #include <folly/Synchronized.h>
@@ -69,6 +70,7 @@ class CheckoutConfig;
 class CheckoutConflict;
 class Clock;
 class DiffContext;
+class DirectoryProfilePrefetcher;
 class EdenConfig;
 class FuseChannel;
 class FuseDeviceUnmountedDuringInitialization;
@@ -82,7 +84,10 @@ using InodeMetadataTable = InodeTable<InodeMetadata>;
 class ObjectStore;
 class Overlay;
 class OverlayFileAccess;
+class GlobResultCache;
+class ScmStatusCache;
 class ServerState;
+class SpeculativeTreePrefetcher;
 class Tree;
 class TreePrefetchLease;
 class UnboundedQueueExecutor;
@@ -134,7 +139,32 @@ enum class CounterName {
    * unlinked inode unloading. This is used on NFS mounts to clean up old
    * inodes.
    */
-  PERIODIC_UNLINKED_INODE_UNLOAD
+  PERIODIC_UNLINKED_INODE_UNLOAD,
+
+  /**
+   * Represents the estimated memory, in bytes, used by the loaded inodes of
+   * this mount.
+   */
+  INODEMAP_MEMORY_ESTIMATE,
+
+  /**
+   * Represents the number of inodes unloaded for this mount because the
+   * loaded inodes of all mounts exceeded inodes:memory-budget.
+   */
+  MEMORY_PRESSURE_INODE_UNLOAD,
+
+  /**
+   * Represents the number of removed directories whose overlay data is
+   * waiting to be removed by the overlay GC threads.
+   */
+  OVERLAY_GC_QUEUE_DEPTH,
+
+  /**
+   * Represents the number of directories, and of files, whose overlay data
+   * was removed by the overlay GC threads. Their rate is the GC throughput.
+   */
+  OVERLAY_GC_REMOVED_DIRECTORIES,
+  OVERLAY_GC_REMOVED_FILES
 
 };
 
@@ -155,6 +185,12 @@ struct CheckoutTimes {
   duration didLookupTrees{};
   duration didDiff{};
   duration didAcquireRenameLock{};
+  /**
+   * When fetching the trees needed by the checkout ahead of it finished.
+   * This happens concurrently with the checkout itself, and is left at zero
+   * when no trees are fetched ahead.
+   */
+  duration didPrefetchTrees{};
   duration didCheckout{};
   duration didFinish{};
 };
@@ -181,6 +217,15 @@ struct SetPathObjectIdResultAndTimes {
   SetPathObjectIdTimes times;
 };
 
+/**
+ * A tree or blob to graft at a path with EdenMount::setPathsToObjectIds.
+ */
+struct SetPathObjectIdObjectAndPath {
+  RelativePath path;
+  RootId id;
+  ObjectType type;
+};
+
 /**
  * EdenMount contains all of the data about a specific eden mount point.
  *
@@ -572,6 +617,16 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    * @param request This ResposeChannelRequest is passed from the ServiceHandler
    *     and is used to check if the request is still active, because if the
    *     request is no longer active we will cancel this diff operation.
+   * @param summarizeUntrackedDirectories Whether directories that are neither
+   *     tracked nor ignored are reported as a single ADDED entry, whose path
+   *     ends with a '/', instead of walking them. See DiffContext.
+   *
+   * When store:incremental-status is enabled, the last status computed for
+   * each commit and listIgnored value is remembered along with the journal
+   * position. It is returned as-is if nothing was journaled since, and
+   * otherwise updated by re-checking only the paths the journal recorded.
+   * Summarized statuses are computed in full each time, as the journal
+   * records the files of untracked directories rather than the directories.
    *
    * @return Returns a folly::Future that will be fulfilled when the diff
    *     operation is complete.  This is marked FOLLY_NODISCARD to
@@ -581,7 +636,8 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       const RootId& commitHash,
       bool listIgnored = false,
       bool enforceCurrentParent = true,
-      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request = nullptr);
+      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request = nullptr,
+      bool summarizeUntrackedDirectories = false);
 
   /**
    * This version of diff is primarily intended for testing.
@@ -723,6 +779,20 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       RelativePathPiece repoPath,
       AbsolutePathPiece targetPath,
       ObjectFetchContext& context);
+  /**
+   * Establish several bind mounts, given as (repoPath, targetPath) pairs,
+   * with a single privhelper request whose bind mounts are performed
+   * concurrently. A repoPath nested under another one of the batch is only
+   * mounted once that one is. The mount point directories are all created
+   * up front, which is safe to do concurrently.
+   *
+   * Returns the result of each bind mount, in the same order: one failing
+   * doesn't prevent the others.
+   */
+  FOLLY_NODISCARD folly::Future<std::vector<folly::Try<folly::Unit>>>
+  addBindMounts(
+      std::vector<std::pair<RelativePath, AbsolutePath>> bindMounts,
+      ObjectFetchContext& context);
   FOLLY_NODISCARD folly::Future<folly::Unit> removeBindMount(
       RelativePathPiece repoPath);
 
@@ -749,6 +819,29 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       TreeInodePtr treeInode,
       ObjectFetchContext& context);
 
+  /**
+   * Returns the prefetcher that learns the order in which this mount loads
+   * trees.
+   */
+  SpeculativeTreePrefetcher& getSpeculativeTreePrefetcher() const {
+    return *speculativeTreePrefetcher_;
+  }
+
+  /**
+   * Returns the prefetcher that ranks this mount's directories by use, and
+   * fetches the top ones after each checkout.
+   */
+  DirectoryProfilePrefetcher& getDirectoryProfilePrefetcher() const {
+    return *directoryProfilePrefetcher_;
+  }
+
+  /**
+   * Returns the cache of recent glob results in this mount.
+   */
+  GlobResultCache& getGlobResultCache() const {
+    return *globResultCache_;
+  }
+
   /**
    * Get a weak_ptr to this EdenMount object. EdenMounts are stored as shared
    * pointers inside of EdenServer's MountList.
@@ -776,6 +869,23 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       CheckoutMode checkoutMode,
       ObjectFetchContext& context);
 
+  /**
+   * Graft many trees and blobs at once, as if setPathObjectId was called for
+   * each of them in order, but in a single checkout: the rename lock is
+   * acquired once, inode invalidations are flushed once, and the parent
+   * commit is updated once, to the id of the last object.
+   *
+   * Blobs that go in the same directory are checked out together as a single
+   * tree. Objects whose directory is replaced by another object of the batch
+   * are rejected, since the order in which they would be applied is
+   * ambiguous.
+   */
+  FOLLY_NODISCARD folly::Future<SetPathObjectIdResultAndTimes>
+  setPathsToObjectIds(
+      std::vector<SetPathObjectIdObjectAndPath> objects,
+      CheckoutMode checkoutMode,
+      ObjectFetchContext& context);
+
   /**
    * Should only be called by the mount contructor. We decide wether this
    * mount should use nfs at construction time and do not change the decision.
@@ -859,6 +969,15 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   Overlay::OverlayType getOverlayType();
 
+#ifndef _WIN32
+  /**
+   * Returns the blob file store of the checkout, or nullptr if
+   * overlay:blob-file-store-size disables it or the overlay can't clone
+   * files.
+   */
+  std::unique_ptr<BlobFileStore> makeBlobFileStore();
+#endif
+
   EdenMount(
       std::unique_ptr<CheckoutConfig> checkoutConfig,
       std::shared_ptr<ObjectStore> objectStore,
@@ -876,6 +995,22 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
 
   folly::SemiFuture<SerializedInodeMap> shutdownImpl(bool doTakeover);
 
+  /**
+   * Restores the journal saved when this checkout was last unmounted, if
+   * journal:persist is set, and returns the mount generation to use: the
+   * saved one if the journal was restored, and a new one otherwise.
+   *
+   * The saved journal is removed either way, so that it can't be restored
+   * after changes it did not record.
+   */
+  uint64_t restoreSavedJournal();
+
+  /**
+   * Saves the journal for restoreSavedJournal(), if journal:persist is set.
+   * Must only be called once nothing can be recorded in the journal anymore.
+   */
+  void saveJournal();
+
   /**
    * Create a DiffContext to be passed through the TreeInode diff codepath. This
    * will be used to record differences through the callback (in which
@@ -886,8 +1021,8 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
   std::unique_ptr<DiffContext> createDiffContext(
       DiffCallback* callback,
       bool listIgnored = false,
-      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request =
-          nullptr) const;
+      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request = nullptr,
+      bool summarizeUntrackedDirectories = false) const;
 
   /**
    * This accepts a callback which will be invoked as differences are found.
@@ -901,7 +1036,43 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       const RootId& commitHash,
       bool listIgnored,
       bool enforceCurrentParent,
-      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request) const;
+      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request,
+      bool summarizeUntrackedDirectories = false) const;
+
+  /**
+   * Returns the error to report instead of a status against commitHash when
+   * a checkout is in progress or commitHash is not the current parent, and
+   * an empty exception_wrapper otherwise.
+   */
+  folly::exception_wrapper checkStatusParent(const RootId& commitHash) const;
+
+  /**
+   * On Windows, changes made to the working copy are applied to the inodes
+   * asynchronously. Returns a future that completes once the changes made so
+   * far have been, so that the inodes can be compared with source control.
+   * The future is always ready on other platforms.
+   */
+  folly::SemiFuture<folly::Unit> waitForPendingNotifications() const;
+
+  /**
+   * Compute a full status, and remember it in statusCache_ as reflecting
+   * the journal up to sequence.
+   */
+  folly::Future<std::unique_ptr<ScmStatus>> computeAndCacheStatus(
+      const RootId& commitHash,
+      bool listIgnored,
+      JournalDelta::SequenceNumber sequence,
+      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request);
+
+  /**
+   * Bring a cached status up to date with the changes in range, by
+   * re-checking only the paths they touched. Returns nullptr if the changes
+   * cannot be applied incrementally and a full diff is needed.
+   */
+  ImmediateFuture<std::shared_ptr<const ScmStatus>> updateCachedStatus(
+      std::shared_ptr<const ScmStatus> status,
+      const RootId& commitHash,
+      const JournalDeltaRange& range);
 
   /**
    * Signal to unmount() that fuseMount() or takeoverFuse() has started.
@@ -1015,7 +1186,8 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
 
   /**
    * A number to uniquely identify this particular incarnation of this mount.
-   * We use bits from the process id and the time at which we were mounted.
+   * We use bits from the process id and the time at which we were mounted,
+   * unless the journal of the previous incarnation was restored.
    */
   const uint64_t mountGeneration_;
 
@@ -1100,6 +1272,22 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   std::atomic<uint64_t> numPrefetchesInProgress_{0};
 
+  /**
+   * Shared with the speculative fetches it has in flight, which may outlive
+   * this mount.
+   */
+  std::shared_ptr<SpeculativeTreePrefetcher> speculativeTreePrefetcher_;
+
+  /**
+   * Shared with the profile fetches it has in flight, which may outlive this
+   * mount.
+   */
+  std::shared_ptr<DirectoryProfilePrefetcher> directoryProfilePrefetcher_;
+
+  std::unique_ptr<GlobResultCache> globResultCache_;
+
+  std::unique_ptr<ScmStatusCache> statusCache_;
+
 #ifdef _WIN32
   /**
    * This is the channel between ProjectedFS and rest of Eden.
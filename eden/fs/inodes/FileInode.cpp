@@ -124,6 +124,12 @@ std::shared_ptr<const Blob> FileInode::LockedState::getCachedBlob(
   XCHECK(!ptr_->isMaterialized())
       << "getCachedBlob can only be called when not materialized";
 
+#ifndef _WIN32
+  if (ptr_->pinnedBlob) {
+    return ptr_->pinnedBlob;
+  }
+#endif
+
   // Is the previous handle still valid? If so, return it.
   if (auto blob = ptr_->interestHandle.getObject()) {
     return blob;
@@ -160,6 +166,7 @@ void FileInode::LockedState::setMaterialized() {
 
 #ifndef _WIN32
   ptr_->readByteRanges.clear();
+  ptr_->pinnedBlob.reset();
 #endif
 }
 
@@ -407,6 +414,7 @@ void FileInodeState::checkInvariants() {
       XCHECK(!blobLoadingPromise);
 #ifndef _WIN32
       XCHECK(readByteRanges.empty());
+      XCHECK(!pinnedBlob);
 #endif
       return;
   }
@@ -418,6 +426,27 @@ void FileInodeState::checkInvariants() {
  * FileInode methods
  ********************************************************************/
 
+namespace {
+SlabAllocator& getFileInodeAllocator() {
+  // Leaked, as inodes may still be destroyed during static destruction.
+  static auto* allocator = new SlabAllocator{sizeof(FileInode), 256};
+  return *allocator;
+}
+} // namespace
+
+void* FileInode::operator new(size_t size) {
+  XDCHECK_EQ(sizeof(FileInode), size);
+  return getFileInodeAllocator().allocate();
+}
+
+void FileInode::operator delete(void* ptr) noexcept {
+  getFileInodeAllocator().deallocate(ptr);
+}
+
+SlabAllocator::Stats FileInode::getAllocatorStats() {
+  return getFileInodeAllocator().getStats();
+}
+
 // The FileInode is in NOT_LOADED or MATERIALIZED_IN_OVERLAY state.
 FileInode::FileInode(
     InodeNumber ino,
@@ -702,6 +731,32 @@ ImmediateFuture<Hash20> FileInode::getSha1(ObjectFetchContext& fetchContext) {
   XLOG(FATAL) << "FileInode in illegal state: " << state->tag;
 }
 
+ImmediateFuture<Blake3Hash> FileInode::getBlake3(
+    ObjectFetchContext& fetchContext) {
+  auto state = LockedState{this};
+
+  logAccess(fetchContext);
+  switch (state->tag) {
+    case State::BLOB_NOT_LOADING:
+    case State::BLOB_LOADING:
+      return getObjectStore()->getBlobBlake3(
+          state->nonMaterializedState->hash, fetchContext);
+    case State::MATERIALIZED_IN_OVERLAY:
+#ifdef _WIN32
+      state.unlock();
+      return readAll(fetchContext, CacheHint::NotNeededAgain)
+          .thenValue([](std::string contents) {
+            return Blake3::hash(folly::ByteRange{folly::StringPiece{contents}});
+          })
+          .semi();
+#else
+      return getOverlayFileAccess(state)->getBlake3(*this);
+#endif // _WIN32
+  }
+
+  XLOG(FATAL) << "FileInode in illegal state: " << state->tag;
+}
+
 ImmediateFuture<struct stat> FileInode::stat(ObjectFetchContext& context) {
   auto st = getMount()->initStatData();
   st.st_nlink = 1; // Eden does not support hard links yet.
@@ -859,10 +914,43 @@ void FileInode::materialize() {
   materializeInParent();
   updateJournal();
 }
+
+Future<std::unique_ptr<folly::IOBuf>> FileInode::readContents(
+    ObjectFetchContext& fetchContext) {
+  return runWhileDataLoaded<Future<std::unique_ptr<folly::IOBuf>>>(
+      LockedState{this},
+      BlobCache::Interest::WantHandle,
+      fetchContext,
+      nullptr,
+      [self = inodePtrFromThis()](
+          LockedState&& state,
+          std::shared_ptr<const Blob> blob) -> std::unique_ptr<folly::IOBuf> {
+        std::unique_ptr<folly::IOBuf> result;
+        switch (state->tag) {
+          case State::MATERIALIZED_IN_OVERLAY:
+            result = folly::IOBuf::fromString(
+                readFile(self->getMaterializedFilePath()).value());
+            break;
+          case State::BLOB_NOT_LOADING:
+            // The clone shares the blob's buffer, which it keeps alive.
+            result = blob->getContents().clone();
+            break;
+          default:
+            EDEN_BUG() << "neither materialized nor loaded during "
+                          "runWhileDataLoaded() call";
+        }
+
+        self->updateAtimeLocked(*state);
+        return result;
+      });
+}
 #else
 
-Future<std::tuple<BufVec, bool>>
-FileInode::read(size_t size, off_t off, ObjectFetchContext& context) {
+Future<std::tuple<BufVec, bool>> FileInode::read(
+    size_t size,
+    off_t off,
+    ObjectFetchContext& context,
+    bool allowFileReference) {
   XDCHECK_GE(off, 0);
   return runWhileDataLoaded<Future<std::tuple<BufVec, bool>>>(
       LockedState{this},
@@ -870,7 +958,7 @@ FileInode::read(size_t size, off_t off, ObjectFetchContext& context) {
       // This function is only called by FUSE.
       context,
       nullptr,
-      [size, off, self = inodePtrFromThis()](
+      [size, off, allowFileReference, self = inodePtrFromThis()](
           LockedState&& state,
           std::shared_ptr<const Blob> blob) -> std::tuple<BufVec, bool> {
         SCOPE_SUCCESS {
@@ -883,8 +971,9 @@ FileInode::read(size_t size, off_t off, ObjectFetchContext& context) {
           // returned no bytes. This will force some FS Channel (like NFS) to
           // issue at least 2 read calls: one for reading the entire file, and
           // the second one to get the EOF bit.
-          auto buf = self->getOverlayFileAccess(state)->read(*self, size, off);
-          auto eof = size != 0 && buf->empty();
+          auto buf = self->getOverlayFileAccess(state)->read(
+              *self, size, off, allowFileReference);
+          auto eof = size != 0 && buf.empty();
           return {std::move(buf), eof};
         }
 
@@ -893,6 +982,10 @@ FileInode::read(size_t size, off_t off, ObjectFetchContext& context) {
         XDCHECK_EQ(state->tag, State::BLOB_NOT_LOADING);
         XDCHECK(blob) << "blob missing after load completed";
 
+        if (state->openHandleCount > 0 && !state->pinnedBlob) {
+          state->pinnedBlob = blob;
+        }
+
         state->readByteRanges.add(off, off + size);
         if (state->readByteRanges.covers(0, blob->getSize())) {
           XLOG(DBG4) << "Inode " << self->getNodeId()
@@ -919,6 +1012,19 @@ FileInode::read(size_t size, off_t off, ObjectFetchContext& context) {
       });
 }
 
+void FileInode::fileHandleOpened() {
+  auto state = LockedState{this};
+  ++state->openHandleCount;
+}
+
+void FileInode::fileHandleReleased() {
+  auto state = LockedState{this};
+  // The count is lost if the inode was unloaded while the file was open.
+  if (state->openHandleCount > 0 && --state->openHandleCount == 0) {
+    state->pinnedBlob.reset();
+  }
+}
+
 size_t FileInode::writeImpl(
     LockedState& state,
     const struct iovec* iov,
@@ -937,17 +1043,37 @@ size_t FileInode::writeImpl(
   return xfer;
 }
 
+bool FileInode::writeReplacesContents(
+    const LockedState& state,
+    size_t length,
+    off_t off) {
+  if (state->tag == State::MATERIALIZED_IN_OVERLAY || off != 0) {
+    return false;
+  }
+  // The size is only known once it has been looked up, which the kernel
+  // usually does before it starts writing.
+  auto size = state->nonMaterializedState->size;
+  return size != State::NonMaterializedState::kUnknownSize && length >= size;
+}
+
 folly::Future<size_t>
 FileInode::write(BufVec&& buf, off_t off, ObjectFetchContext& fetchContext) {
+  auto state = LockedState{this};
+  auto length = buf.size();
+  auto writeFn = [buf = std::move(buf), off, self = inodePtrFromThis()](
+                     LockedState&& stateLock) {
+    auto vec = buf->getIov();
+    return self->writeImpl(stateLock, vec.data(), vec.size(), off);
+  };
+
+  // Nothing of the blob would survive this write, so skip fetching it and
+  // copying it into the overlay.
+  if (writeReplacesContents(state, length, off)) {
+    return truncateAndRun(std::move(state), std::move(writeFn));
+  }
+
   return runWhileMaterialized(
-      LockedState{this},
-      nullptr,
-      [buf = std::move(buf), off, self = inodePtrFromThis()](
-          LockedState&& state) {
-        auto vec = buf->getIov();
-        return self->writeImpl(state, vec.data(), vec.size(), off);
-      },
-      fetchContext);
+      std::move(state), nullptr, std::move(writeFn), fetchContext);
 }
 
 folly::Future<size_t> FileInode::write(
@@ -964,17 +1090,22 @@ folly::Future<size_t> FileInode::write(
     return writeImpl(state, &iov, 1, off);
   }
 
+  auto writeFn = [data = data.str(), off, self = inodePtrFromThis()](
+                     LockedState&& stateLock) {
+    struct iovec iov;
+    iov.iov_base = const_cast<char*>(data.data());
+    iov.iov_len = data.size();
+    return self->writeImpl(stateLock, &iov, 1, off);
+  };
+
+  // Nothing of the blob would survive this write, so skip fetching it and
+  // copying it into the overlay.
+  if (writeReplacesContents(state, data.size(), off)) {
+    return truncateAndRun(std::move(state), std::move(writeFn));
+  }
+
   return runWhileMaterialized(
-      std::move(state),
-      nullptr,
-      [data = data.str(), off, self = inodePtrFromThis()](
-          LockedState&& stateLock) {
-        struct iovec iov;
-        iov.iov_base = const_cast<char*>(data.data());
-        iov.iov_len = data.size();
-        return self->writeImpl(stateLock, &iov, 1, off);
-      },
-      fetchContext);
+      std::move(state), nullptr, std::move(writeFn), fetchContext);
 }
 #endif
 
@@ -13,11 +13,13 @@
 #include <optional>
 #include "eden/fs/inodes/CacheHint.h"
 #include "eden/fs/inodes/InodeBase.h"
+#include "eden/fs/model/Blake3.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/store/BlobCache.h"
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/utils/BufVec.h"
+#include "eden/fs/utils/SlabAllocator.h"
 #ifndef _WIN32
 #include "eden/fs/utils/CoverageSet.h"
 #endif
@@ -129,6 +131,19 @@ struct FileInodeState {
    * Records the ranges that have been read() when not materialized.
    */
   CoverageSet readByteRanges;
+
+  /**
+   * Number of FUSE file handles currently open on this inode through
+   * FileInode::fileHandleOpened().
+   */
+  size_t openHandleCount{0};
+
+  /**
+   * While openHandleCount is non-zero, the blob once it has been read. The
+   * BlobCache may still evict it when over budget, but a file read in small
+   * chunks won't have to fetch it again before it is closed.
+   */
+  std::shared_ptr<const Blob> pinnedBlob;
 #endif
 };
 
@@ -161,6 +176,19 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
       mode_t initialMode,
       const InodeTimestamps& initialTimestamps);
 
+  /**
+   * FileInodes, including their FileInodeState, are allocated from a pool
+   * shared by all mounts, so that unloading them gives whole slabs of memory
+   * back.
+   */
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr) noexcept;
+
+  /**
+   * Returns the memory usage of the pool FileInodes are allocated from.
+   */
+  static SlabAllocator::Stats getAllocatorStats();
+
 #ifndef _WIN32
   folly::Future<struct stat> setattr(
       const DesiredMetadata& desired,
@@ -179,6 +207,13 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
 
   ImmediateFuture<Hash20> getSha1(ObjectFetchContext& fetchContext);
 
+  /**
+   * Returns the BLAKE3 hash of the file contents. It is cached with the blob
+   * metadata for files that are not materialized, and computed from the
+   * contents every time for materialized files.
+   */
+  ImmediateFuture<Blake3Hash> getBlake3(ObjectFetchContext& fetchContext);
+
   /**
    * Check to see if the file has the same contents as the specified blob
    * and the same tree entry type.
@@ -250,6 +285,17 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
   // Windows only function. On POSIX systems the write() functions mark a file
   // as Materialized.
   void materialize();
+
+  /**
+   * Returns the entire file contents.
+   *
+   * Unlike readAll(), for files that are not materialized the returned IOBuf
+   * shares the memory of the loaded blob rather than copying it, so that
+   * ProjectedFS can hydrate a range of a large file without a copy of the
+   * whole file.
+   */
+  FOLLY_NODISCARD folly::Future<std::unique_ptr<folly::IOBuf>> readContents(
+      ObjectFetchContext& fetchContext);
 #else
   /**
    * Read up to size bytes from the file at the specified offset.
@@ -262,10 +308,16 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
    * that the end of the file was reached, the boolean should be checked for
    * this.
    *
+   * If allowFileReference is true, reads of materialized files may return a
+   * BufVec referring to the overlay file rather than holding the data.
+   *
    * May throw exceptions on error.
    */
-  folly::Future<std::tuple<BufVec, bool>>
-  read(size_t size, off_t off, ObjectFetchContext& context);
+  folly::Future<std::tuple<BufVec, bool>> read(
+      size_t size,
+      off_t off,
+      ObjectFetchContext& context,
+      bool allowFileReference = false);
 
   folly::Future<size_t>
   write(BufVec&& buf, off_t off, ObjectFetchContext& fetchContext);
@@ -274,6 +326,14 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
 
   void fsync(bool datasync);
 
+  /**
+   * Record that a file handle was opened on, or released from, this inode.
+   * While any handle is open, the blob read through it is kept in memory
+   * instead of relying on the BlobCache to retain it between reads.
+   */
+  void fileHandleOpened();
+  void fileHandleReleased();
+
   FOLLY_NODISCARD folly::Future<folly::Unit>
   fallocate(uint64_t offset, uint64_t length, ObjectFetchContext& fetchContext);
 
@@ -281,6 +341,11 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
 
   ImmediateFuture<struct stat> stat(ObjectFetchContext& context) override;
 
+  /**
+   * Update the st_blocks field in a stat structure based on the st_size value.
+   */
+  static void updateBlockCount(struct stat& st);
+
  private:
   using State = FileInodeState;
   class LockedState;
@@ -450,12 +515,15 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
       const struct iovec* iov,
       size_t numIovecs,
       off_t off);
-#endif // !_WIN32
 
   /**
-   * Update the st_blocks field in a stat structure based on the st_size value.
+   * Whether writing length bytes at off overwrites every byte of this file's
+   * blob, in which case the file can be materialized empty instead of from
+   * the blob.
    */
-  static void updateBlockCount(struct stat& st);
+  static bool
+  writeReplacesContents(const LockedState& state, size_t length, off_t off);
+#endif // !_WIN32
 
 #ifdef _WIN32
   /**
@@ -9,6 +9,9 @@
 
 #include "eden/fs/inodes/FuseDispatcherImpl.h"
 #include <folly/logging/xlog.h>
+#include <algorithm>
+#include <chrono>
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/fuse/DirList.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -45,27 +48,62 @@ fuse_entry_out computeEntryParam(const FuseDispatcher::Attr& attr) {
 
 constexpr int64_t kBrokenInodeCacheSeconds = 5;
 
+// The file handle returned by open() when it was counted on the FileInode, so
+// that release() only uncounts those.
+constexpr uint64_t kCountedFileHandle = 1;
+
 FuseDispatcher::Attr attrForInodeWithCorruptOverlay(InodeNumber ino) noexcept {
   struct stat st = {};
   st.st_ino = ino.get();
   st.st_mode = S_IFREG;
   return FuseDispatcher::Attr{st, kBrokenInodeCacheSeconds};
 }
+
+bool isMaterialized(const InodePtr& inode) {
+  if (auto file = inode.asFilePtrOrNull()) {
+    return !file->getBlobHash().has_value();
+  }
+  return inode.asTreePtr()->getContents().rlock()->isMaterialized();
+}
+
+uint64_t attrTimeoutSeconds(std::chrono::nanoseconds timeout) {
+  // See FuseDispatcher::Attr for why timeouts are limited to int32_t.
+  auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  return std::clamp<int64_t>(
+      seconds.count(), 0, std::numeric_limits<int32_t>::max());
+}
 } // namespace
 
 FuseDispatcherImpl::FuseDispatcherImpl(EdenMount* mount)
     : FuseDispatcher(mount->getStats()),
       mount_(mount),
-      inodeMap_(mount_->getInodeMap()) {}
+      inodeMap_(mount_->getInodeMap()),
+      pinBlobsWhileOpen_(
+          mount_->getEdenConfig()->fusePinBlobsWhileOpen.getValue()),
+      materializedAttrTimeout_(attrTimeoutSeconds(
+          mount_->getEdenConfig()->fuseMaterializedAttrTimeout.getValue())) {}
+
+FuseDispatcher::Attr FuseDispatcherImpl::attrForInode(
+    const InodePtr& inode,
+    const struct stat& st) const {
+  if (isMaterialized(inode)) {
+    return FuseDispatcher::Attr{st, materializedAttrTimeout_};
+  }
+  // Unmaterialized inodes only change on checkout, which invalidates them in
+  // the kernel.
+  return FuseDispatcher::Attr{st};
+}
 
 ImmediateFuture<FuseDispatcher::Attr> FuseDispatcherImpl::getattr(
     InodeNumber ino,
     ObjectFetchContext& context) {
-  return inodeMap_->lookupInode(ino)
-      .thenValue(
-          [&context](const InodePtr& inode) { return inode->stat(context); })
-      .thenValue(
-          [](const struct stat& st) { return FuseDispatcher::Attr{st}; });
+  return inodeMap_->lookupInode(ino).thenValue(
+      [this, &context](const InodePtr& inode) {
+        return inode->stat(context).thenValue(
+            [this, inode](const struct stat& st) {
+              return attrForInode(inode, st);
+            });
+      });
 }
 
 ImmediateFuture<uint64_t> FuseDispatcherImpl::opendir(
@@ -99,13 +137,13 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::lookup(
                   &context](const TreeInodePtr& tree) {
         return tree->getOrLoadChild(name, context);
       })
-      .thenValue([&context](const InodePtr& inode) {
+      .thenValue([this, &context](const InodePtr& inode) {
         return makeImmediateFutureWith([&]() { return inode->stat(context); })
-            .thenTry([inode](folly::Try<struct stat> maybeStat) {
+            .thenTry([this, inode](folly::Try<struct stat> maybeStat) {
               if (maybeStat.hasValue()) {
                 inode->incFsRefcount();
                 return computeEntryParam(
-                    FuseDispatcher::Attr{maybeStat.value()});
+                    attrForInode(inode, maybeStat.value()));
               } else {
                 // The most common case for stat() failing is if this file is
                 // materialized but the data for it in the overlay is missing
@@ -196,10 +234,11 @@ ImmediateFuture<FuseDispatcher::Attr> FuseDispatcherImpl::setattr(
           desired.mtime = now;
         }
 
-        return inode->setattr(desired, context).semi();
-      })
-      .thenValue([](struct stat&& stat) {
-        return FuseDispatcher::Attr{std::move(stat)};
+        return ImmediateFuture<struct stat>{
+            inode->setattr(desired, context).semi()}
+            .thenValue([this, inode](struct stat&& stat) {
+              return attrForInode(inode, stat);
+            });
       });
 }
 
@@ -208,8 +247,15 @@ void FuseDispatcherImpl::forget(InodeNumber ino, unsigned long nlookup) {
 }
 
 ImmediateFuture<uint64_t> FuseDispatcherImpl::open(
-    InodeNumber /*ino*/,
+    InodeNumber ino,
     int /*flags*/) {
+  if (pinBlobsWhileOpen_) {
+    return inodeMap_->lookupFileInode(ino).thenValue(
+        [](const FileInodePtr& inode) {
+          inode->fileHandleOpened();
+          return kCountedFileHandle;
+        });
+  }
 #ifdef FUSE_NO_OPEN_SUPPORT
   if (getConnInfo().flags & FUSE_NO_OPEN_SUPPORT) {
     // If the kernel understands FUSE_NO_OPEN_SUPPORT, then returning ENOSYS
@@ -221,6 +267,17 @@ ImmediateFuture<uint64_t> FuseDispatcherImpl::open(
   return 0;
 }
 
+ImmediateFuture<folly::Unit> FuseDispatcherImpl::release(
+    InodeNumber ino,
+    uint64_t fh) {
+  if (fh != kCountedFileHandle) {
+    // Opened by create(), or before pinning was enabled.
+    return folly::unit;
+  }
+  return inodeMap_->lookupFileInode(ino).thenValue(
+      [](const FileInodePtr& inode) { inode->fileHandleReleased(); });
+}
+
 ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::create(
     InodeNumber parent,
     PathComponentPiece name,
@@ -231,13 +288,15 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::create(
   // (and thus can be zero)
   mode = S_IFREG | (07777 & mode);
   return inodeMap_->lookupTreeInode(parent).thenValue(
-      [mode, childName = PathComponent{name}, &context](
-          const TreeInodePtr& inode) {
+      [mode,
+       childName = PathComponent{name},
+       timeout = materializedAttrTimeout_,
+       &context](const TreeInodePtr& inode) {
         auto child = inode->mknod(childName, mode, 0, InvalidationRequired::No);
         return child->stat(context).thenValue(
-            [child](struct stat st) -> fuse_entry_out {
+            [child, timeout](struct stat st) -> fuse_entry_out {
               child->incFsRefcount();
-              return computeEntryParam(FuseDispatcher::Attr{st});
+              return computeEntryParam(FuseDispatcher::Attr{st, timeout});
             });
       });
 }
@@ -246,10 +305,11 @@ ImmediateFuture<BufVec> FuseDispatcherImpl::read(
     InodeNumber ino,
     size_t size,
     off_t off,
+    bool allowFileReference,
     ObjectFetchContext& context) {
   return inodeMap_->lookupFileInode(ino).thenValue(
-      [&context, size, off](FileInodePtr&& inode) {
-        return inode->read(size, off, context)
+      [&context, size, off, allowFileReference](FileInodePtr&& inode) {
+        return inode->read(size, off, context, allowFileReference)
             .thenValue([](std::tuple<BufVec, bool>&& readRes) {
               return std::get<BufVec>(std::move(readRes));
             })
@@ -335,6 +395,84 @@ ImmediateFuture<FuseDirList> FuseDispatcherImpl::readdir(
       });
 }
 
+#ifdef __linux__
+ImmediateFuture<FuseDirPlusList> FuseDispatcherImpl::readdirplus(
+    InodeNumber ino,
+    FuseDirPlusList&& dirList,
+    off_t offset,
+    uint64_t /*fh*/,
+    ObjectFetchContext& context) {
+  return inodeMap_->lookupTreeInode(ino).thenValue(
+      [this, dirList = std::move(dirList), offset, &context](
+          TreeInodePtr inode) mutable {
+        auto list =
+            inode->fuseReaddirPlus(std::move(dirList), offset, context);
+
+        // The kernel doesn't link . and .., leave their nodeid 0 so they
+        // are not counted as lookups.
+        std::vector<PathComponentPiece> names;
+        std::vector<size_t> indices;
+        for (size_t index = 0; index < list.size(); ++index) {
+          auto name = list.getName(index);
+          if (name == "." || name == "..") {
+            continue;
+          }
+          names.emplace_back(name);
+          indices.push_back(index);
+        }
+
+        // Load the whole page at once instead of waiting for the kernel to
+        // send one lookup() per entry.
+        auto children = inode->getOrLoadChildren(names, context);
+        return std::move(children).thenValue(
+            [this,
+             list = std::move(list),
+             indices = std::move(indices),
+             &context](std::vector<folly::Try<InodePtr>> children) mutable {
+              std::vector<ImmediateFuture<fuse_entry_out>> entries;
+              entries.reserve(children.size());
+              for (auto& child : children) {
+                if (child.hasException()) {
+                  // Without a nodeid, the kernel will look this entry up
+                  // itself if it is needed.
+                  XLOG(DBG3) << "readdirplus: failed to load child: "
+                             << child.exception().what();
+                  entries.emplace_back(fuse_entry_out{});
+                  continue;
+                }
+                auto inode = std::move(child).value();
+                auto stat = makeImmediateFutureWith(
+                    [&] { return inode->stat(context); });
+                entries.push_back(std::move(stat).thenTry(
+                    [this, inode](folly::Try<struct stat> maybeStat) {
+                      // As in lookup(), an inode whose attributes can't be
+                      // read is still returned.
+                      inode->incFsRefcount();
+                      if (maybeStat.hasValue()) {
+                        return computeEntryParam(
+                            attrForInode(inode, maybeStat.value()));
+                      }
+                      return computeEntryParam(
+                          attrForInodeWithCorruptOverlay(inode->getNodeId()));
+                    }));
+              }
+              return collectAll(std::move(entries))
+                  .thenValue([list = std::move(list),
+                              indices = std::move(indices)](
+                                 std::vector<folly::Try<fuse_entry_out>>
+                                     entries) mutable {
+                    for (size_t n = 0; n < entries.size(); ++n) {
+                      if (entries[n].hasValue()) {
+                        list.setEntryParam(indices[n], entries[n].value());
+                      }
+                    }
+                    return std::move(list);
+                  });
+            });
+      });
+}
+#endif
+
 ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::mknod(
     InodeNumber parent,
     PathComponentPiece name,
@@ -342,14 +480,17 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::mknod(
     dev_t rdev,
     ObjectFetchContext& context) {
   return inodeMap_->lookupTreeInode(parent).thenValue(
-      [childName = PathComponent{name}, mode, rdev, &context](
-          const TreeInodePtr& inode) {
+      [childName = PathComponent{name},
+       mode,
+       rdev,
+       timeout = materializedAttrTimeout_,
+       &context](const TreeInodePtr& inode) {
         auto child =
             inode->mknod(childName, mode, rdev, InvalidationRequired::No);
         return child->stat(context).thenValue(
-            [child](struct stat st) -> fuse_entry_out {
+            [child, timeout](struct stat st) -> fuse_entry_out {
               child->incFsRefcount();
-              return computeEntryParam(FuseDispatcher::Attr{st});
+              return computeEntryParam(FuseDispatcher::Attr{st, timeout});
             });
       });
 }
@@ -360,12 +501,14 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::mkdir(
     mode_t mode,
     ObjectFetchContext& context) {
   return inodeMap_->lookupTreeInode(parent).thenValue(
-      [childName = PathComponent{name}, mode, &context](
-          const TreeInodePtr& inode) {
+      [childName = PathComponent{name},
+       mode,
+       timeout = materializedAttrTimeout_,
+       &context](const TreeInodePtr& inode) {
         auto child = inode->mkdir(childName, mode, InvalidationRequired::No);
-        return child->stat(context).thenValue([child](struct stat st) {
+        return child->stat(context).thenValue([child, timeout](struct stat st) {
           child->incFsRefcount();
-          return computeEntryParam(FuseDispatcher::Attr{st});
+          return computeEntryParam(FuseDispatcher::Attr{st, timeout});
         });
       });
 }
@@ -398,14 +541,16 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::symlink(
     StringPiece link,
     ObjectFetchContext& context) {
   return inodeMap_->lookupTreeInode(parent).thenValue(
-      [linkContents = link.str(), childName = PathComponent{name}, &context](
-          const TreeInodePtr& inode) {
+      [linkContents = link.str(),
+       childName = PathComponent{name},
+       timeout = materializedAttrTimeout_,
+       &context](const TreeInodePtr& inode) {
         auto symlinkInode =
             inode->symlink(childName, linkContents, InvalidationRequired::No);
         symlinkInode->incFsRefcount();
         return symlinkInode->stat(context).thenValue(
-            [symlinkInode](struct stat st) {
-              return computeEntryParam(FuseDispatcher::Attr{st});
+            [symlinkInode, timeout](struct stat st) {
+              return computeEntryParam(FuseDispatcher::Attr{st, timeout});
             });
       });
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "eden/fs/fuse/FuseDispatcher.h"
+#include "eden/fs/inodes/InodePtrFwd.h"
 
 namespace facebook::eden {
 
@@ -42,6 +43,8 @@ class FuseDispatcherImpl : public FuseDispatcher {
 
   void forget(InodeNumber ino, unsigned long nlookup) override;
   ImmediateFuture<uint64_t> open(InodeNumber ino, int flags) override;
+  ImmediateFuture<folly::Unit> release(InodeNumber ino, uint64_t fh)
+      override;
   ImmediateFuture<std::string> readlink(
       InodeNumber ino,
       bool kernelCachesReadlink,
@@ -93,6 +96,7 @@ class FuseDispatcherImpl : public FuseDispatcher {
       InodeNumber ino,
       size_t size,
       off_t off,
+      bool allowFileReference,
       ObjectFetchContext& context) override;
   ImmediateFuture<size_t> write(
       InodeNumber ino,
@@ -117,6 +121,14 @@ class FuseDispatcherImpl : public FuseDispatcher {
       off_t offset,
       uint64_t fh,
       ObjectFetchContext& context) override;
+#ifdef __linux__
+  ImmediateFuture<FuseDirPlusList> readdirplus(
+      InodeNumber ino,
+      FuseDirPlusList&& dirList,
+      off_t offset,
+      uint64_t fh,
+      ObjectFetchContext& context) override;
+#endif
 
   ImmediateFuture<std::string> getxattr(
       InodeNumber ino,
@@ -125,6 +137,14 @@ class FuseDispatcherImpl : public FuseDispatcher {
   ImmediateFuture<std::vector<std::string>> listxattr(InodeNumber ino) override;
 
  private:
+  /**
+   * Attributes of inode to return to the kernel, valid for a time depending
+   * on whether it is materialized.
+   */
+  FuseDispatcher::Attr attrForInode(
+      const InodePtr& inode,
+      const struct stat& st) const;
+
   // The EdenMount associated with this dispatcher.
   EdenMount* const mount_;
 
@@ -133,6 +153,14 @@ class FuseDispatcherImpl : public FuseDispatcher {
   // every FUSE request, and having it locally avoids having to dereference
   // mount_ first.
   InodeMap* const inodeMap_;
+
+  // Whether open() and release() track open file handles on FileInodes, see
+  // EdenConfig::fusePinBlobsWhileOpen.
+  const bool pinBlobsWhileOpen_;
+
+  // Attribute and entry timeout, in seconds, of materialized inodes. See
+  // EdenConfig::fuseMaterializedAttrTimeout.
+  const uint64_t materializedAttrTimeout_;
 };
 
 } // namespace facebook::eden
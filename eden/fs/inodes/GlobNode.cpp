@@ -8,6 +8,7 @@
 #include "GlobNode.h"
 #include <iomanip>
 #include <iostream>
+#include "eden/fs/inodes/InodeError.h"
 #include "eden/fs/inodes/TreeInode.h"
 
 using folly::StringPiece;
@@ -38,7 +39,7 @@ struct TreeInodePtrRoot {
   explicit TreeInodePtrRoot(TreeInodePtr root) : root(std::move(root)) {}
 
   /** Return an object that holds a lock over the children */
-  folly::Synchronized<TreeInodeState>::RLockedPtr lockContents() {
+  SynchronizedTreeInodeState::RLockedPtr lockContents() {
     return root->getContents().rlock();
   }
 
@@ -61,17 +62,33 @@ struct TreeInodePtrRoot {
    * The returned iterator yields ENTRY elements that can be
    * used with the entryXXX methods below. */
   const DirContents& iterate(
-      const folly::Synchronized<TreeInodeState>::RLockedPtr& contents) const {
+      const SynchronizedTreeInodeState::RLockedPtr& contents) const {
     return contents->entries;
   }
 
-  /** Arrange to load a child TreeInode */
-  ImmediateFuture<TreeInodePtr> getOrLoadChildTree(
-      PathComponentPiece name,
+  /** Arrange to load child TreeInodes, all at once.  The results are in
+   * the same order as names. */
+  ImmediateFuture<vector<folly::Try<TreeInodePtr>>> getOrLoadChildTrees(
+      const vector<PathComponentPiece>& names,
       ObjectFetchContext& context) {
-    return root->getOrLoadChildTree(name, context);
+    return root->getOrLoadChildren(names, context)
+        .thenValue([](vector<folly::Try<InodePtr>> children) {
+          vector<folly::Try<TreeInodePtr>> trees;
+          trees.reserve(children.size());
+          for (auto& child : children) {
+            if (child.hasException()) {
+              trees.emplace_back(std::move(child.exception()));
+            } else if (auto tree = child.value().asTreePtrOrNull()) {
+              trees.emplace_back(std::move(tree));
+            } else {
+              trees.emplace_back(folly::exception_wrapper{
+                  InodeError(ENOTDIR, child.value())});
+            }
+          }
+          return trees;
+        });
   }
-  /** Returns true if we should call getOrLoadChildTree() for the given
+  /** Returns true if we should call getOrLoadChildTrees() for the given
    * ENTRY.  We only do this if the child is already materialized */
   template <typename ENTRY>
   bool entryShouldLoadChildTree(const ENTRY& entry) {
@@ -162,8 +179,8 @@ struct TreeRoot {
   /** We can never load a TreeInodePtr from a raw Tree, so this always
    * fails.  We never call this method because entryShouldLoadChildTree()
    * always returns false. */
-  ImmediateFuture<TreeInodePtr> getOrLoadChildTree(
-      PathComponentPiece,
+  ImmediateFuture<vector<folly::Try<TreeInodePtr>>> getOrLoadChildTrees(
+      const vector<PathComponentPiece>&,
       ObjectFetchContext&) {
     throw std::runtime_error("impossible to get here");
   }
@@ -366,7 +383,7 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
                 root.entryToResult(rootPath + name, entry, originRootId));
 
             if (fileBlobsToPrefetch && root.entryShouldPrefetch(entry)) {
-              fileBlobsToPrefetch->wlock()->emplace_back(root.entryHash(entry));
+              fileBlobsToPrefetch->add(root.entryHash(entry));
             }
           }
 
@@ -382,8 +399,7 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
               globResult.wlock()->emplace_back(
                   root.entryToResult(rootPath + name, entry, originRootId));
               if (fileBlobsToPrefetch && root.entryShouldPrefetch(entry)) {
-                fileBlobsToPrefetch->wlock()->emplace_back(
-                    root.entryHash(entry));
+                fileBlobsToPrefetch->add(root.entryHash(entry));
               }
             }
             // Not the leaf of a pattern; if this is a dir, we need to
@@ -396,25 +412,49 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
   }
 
   // Recursively load child inodes and evaluate matches
-
-  for (auto& item : recurse) {
-    futures.emplace_back(root.getOrLoadChildTree(item.first, context)
-                             .thenValue([store,
-                                         &context,
-                                         candidateName = rootPath + item.first,
-                                         node = item.second,
-                                         fileBlobsToPrefetch,
-                                         &globResult,
-                                         &originRootId](TreeInodePtr dir) {
-                               return node->evaluateImpl(
-                                   store,
-                                   context,
-                                   candidateName,
-                                   TreeInodePtrRoot(std::move(dir)),
-                                   fileBlobsToPrefetch,
-                                   globResult,
-                                   originRootId);
-                             }));
+  if (!recurse.empty()) {
+    vector<PathComponentPiece> names;
+    vector<std::pair<RelativePath, GlobNode*>> candidates;
+    names.reserve(recurse.size());
+    candidates.reserve(recurse.size());
+    for (auto& item : recurse) {
+      names.push_back(item.first);
+      candidates.emplace_back(rootPath + item.first, item.second);
+    }
+    futures.emplace_back(
+        root.getOrLoadChildTrees(names, context)
+            .thenValue([store,
+                        &context,
+                        candidates = std::move(candidates),
+                        fileBlobsToPrefetch,
+                        &globResult,
+                        &originRootId](
+                           vector<folly::Try<TreeInodePtr>>&& dirs) {
+              vector<ImmediateFuture<folly::Unit>> futures;
+              futures.reserve(dirs.size());
+              for (size_t n = 0; n < dirs.size(); ++n) {
+                if (dirs[n].hasException()) {
+                  futures.emplace_back(
+                      folly::Try<folly::Unit>{std::move(dirs[n].exception())});
+                  continue;
+                }
+                futures.emplace_back(candidates[n].second->evaluateImpl(
+                    store,
+                    context,
+                    candidates[n].first,
+                    TreeInodePtrRoot(std::move(dirs[n]).value()),
+                    fileBlobsToPrefetch,
+                    globResult,
+                    originRootId));
+              }
+              return collectAll(std::move(futures))
+                  .thenValue([](vector<folly::Try<folly::Unit>>&& results) {
+                    for (auto& result : results) {
+                      result.throwUnlessValue();
+                    }
+                    return folly::unit;
+                  });
+            }));
   }
 
   // Note: we use collectAll() rather than collect() here to make sure that
@@ -527,7 +567,7 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
           globResult.wlock()->emplace_back(root.entryToResult(
               rootPath + candidateName.copy(), entry, originRootId));
           if (fileBlobsToPrefetch && root.entryShouldPrefetch(entry)) {
-            fileBlobsToPrefetch->wlock()->emplace_back(root.entryHash(entry));
+            fileBlobsToPrefetch->add(root.entryHash(entry));
           }
           // No sense running multiple matches for this same file.
           break;
@@ -566,28 +606,50 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
   }
 
   // Recursively load child inodes and evaluate matches
-  for (auto& candidateName : subDirNames) {
-    auto childTreeFuture =
-        root.getOrLoadChildTree(candidateName.basename(), context);
+  if (!subDirNames.empty()) {
+    vector<PathComponentPiece> names;
+    names.reserve(subDirNames.size());
+    for (auto& candidateName : subDirNames) {
+      names.push_back(candidateName.basename());
+    }
+    // names points into subDirNames, so load before moving it.
+    auto childTreesFuture = root.getOrLoadChildTrees(names, context);
     futures.emplace_back(
-        std::move(childTreeFuture)
-            .thenValue([candidateName = std::move(candidateName),
+        std::move(childTreesFuture)
+            .thenValue([subDirNames = std::move(subDirNames),
                         rootPath = rootPath.copy(),
                         store,
                         &context,
                         this,
                         fileBlobsToPrefetch,
                         &globResult,
-                        &originRootId](TreeInodePtr dir) {
-              return evaluateRecursiveComponentImpl(
-                  store,
-                  context,
-                  rootPath,
-                  candidateName,
-                  TreeInodePtrRoot(std::move(dir)),
-                  fileBlobsToPrefetch,
-                  globResult,
-                  originRootId);
+                        &originRootId](
+                           vector<folly::Try<TreeInodePtr>>&& dirs) {
+              vector<ImmediateFuture<folly::Unit>> futures;
+              futures.reserve(dirs.size());
+              for (size_t n = 0; n < dirs.size(); ++n) {
+                if (dirs[n].hasException()) {
+                  futures.emplace_back(
+                      folly::Try<folly::Unit>{std::move(dirs[n].exception())});
+                  continue;
+                }
+                futures.emplace_back(evaluateRecursiveComponentImpl(
+                    store,
+                    context,
+                    rootPath,
+                    subDirNames[n],
+                    TreeInodePtrRoot(std::move(dirs[n]).value()),
+                    fileBlobsToPrefetch,
+                    globResult,
+                    originRootId));
+              }
+              return collectAll(std::move(futures))
+                  .thenValue([](vector<folly::Try<folly::Unit>>&& results) {
+                    for (auto& result : results) {
+                      result.throwUnlessValue();
+                    }
+                    return folly::unit;
+                  });
             }));
   }
 
@@ -34,7 +34,16 @@ class GlobNode {
   // globs that will be parsed into the overall glob tree.
   explicit GlobNode(bool includeDotfiles) : includeDotfiles_(includeDotfiles) {}
 
-  using PrefetchList = folly::Synchronized<std::vector<ObjectId>>;
+  /**
+   * Receives the blob IDs of the files matched by a glob, as they are
+   * matched, so that they can be prefetched. add() may be called
+   * concurrently from several threads, and with the same ID several times.
+   */
+  class PrefetchList {
+   public:
+    virtual ~PrefetchList() = default;
+    virtual void add(const ObjectId& id) = 0;
+  };
 
   GlobNode(folly::StringPiece pattern, bool includeDotfiles, bool hasSpecials);
 
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/GlobPrefetcher.h"
+
+#include <folly/logging/xlog.h>
+#include <algorithm>
+
+namespace facebook {
+namespace eden {
+
+std::shared_ptr<GlobPrefetcher> GlobPrefetcher::create(
+    FetchBatch fetchBatch,
+    size_t batchSize,
+    size_t maxInFlightBatches,
+    std::function<bool()> isCancelled) {
+  return std::shared_ptr<GlobPrefetcher>{new GlobPrefetcher{
+      std::move(fetchBatch),
+      batchSize,
+      maxInFlightBatches,
+      std::move(isCancelled)}};
+}
+
+GlobPrefetcher::GlobPrefetcher(
+    FetchBatch fetchBatch,
+    size_t batchSize,
+    size_t maxInFlightBatches,
+    std::function<bool()> isCancelled)
+    : fetchBatch_{std::move(fetchBatch)},
+      batchSize_{std::max<size_t>(batchSize, 1)},
+      maxInFlightBatches_{std::max<size_t>(maxInFlightBatches, 1)},
+      isCancelled_{std::move(isCancelled)} {}
+
+void GlobPrefetcher::add(const ObjectId& id) {
+  std::vector<std::vector<ObjectId>> batches;
+  std::optional<folly::Promise<folly::Unit>> promise;
+  {
+    auto state = state_.wlock();
+    if (state->cancelled || !state->seen.insert(id).second) {
+      return;
+    }
+    state->pending.push_back(id);
+    if (state->pending.size() < batchSize_) {
+      return;
+    }
+    state->queued.push_back(std::exchange(state->pending, {}));
+    takeBatchesLocked(*state, batches, promise);
+  }
+  fetch(std::move(batches), std::move(promise));
+}
+
+folly::Future<folly::Unit> GlobPrefetcher::finish() {
+  std::vector<std::vector<ObjectId>> batches;
+  std::optional<folly::Promise<folly::Unit>> promise;
+  folly::Future<folly::Unit> future = folly::Future<folly::Unit>::makeEmpty();
+  {
+    auto state = state_.wlock();
+    XCHECK(!state->finishing) << "GlobPrefetcher::finish called twice";
+    state->finishing = true;
+    future = state->done->getFuture();
+    if (state->cancelled) {
+      state->droppedBatches += state->pending.empty() ? 0 : 1;
+      state->pending.clear();
+    } else if (!state->pending.empty()) {
+      state->queued.push_back(std::exchange(state->pending, {}));
+    }
+    takeBatchesLocked(*state, batches, promise);
+  }
+  fetch(std::move(batches), std::move(promise));
+  return future;
+}
+
+size_t GlobPrefetcher::getIdCount() const {
+  return state_.rlock()->seen.size();
+}
+
+size_t GlobPrefetcher::getDroppedBatchCount() const {
+  return state_.rlock()->droppedBatches;
+}
+
+void GlobPrefetcher::takeBatchesLocked(
+    State& state,
+    std::vector<std::vector<ObjectId>>& batchesToFetch,
+    std::optional<folly::Promise<folly::Unit>>& promiseToFulfill) {
+  if (!state.cancelled && !state.queued.empty() &&
+      state.inFlight < maxInFlightBatches_ && isCancelled_ && isCancelled_()) {
+    state.cancelled = true;
+    state.droppedBatches += state.queued.size();
+    state.queued.clear();
+    XLOG(DBG3) << "glob prefetch cancelled, dropped " << state.droppedBatches
+               << " batches";
+  }
+  while (!state.queued.empty() && state.inFlight < maxInFlightBatches_) {
+    batchesToFetch.push_back(std::move(state.queued.front()));
+    state.queued.pop_front();
+    ++state.inFlight;
+  }
+  if (state.finishing && state.inFlight == 0 && state.done) {
+    promiseToFulfill = std::exchange(state.done, std::nullopt);
+  }
+}
+
+void GlobPrefetcher::fetch(
+    std::vector<std::vector<ObjectId>> batches,
+    std::optional<folly::Promise<folly::Unit>> promiseToFulfill) {
+  for (auto& batch : batches) {
+    folly::makeFutureWith([&] { return fetchBatch_(std::move(batch)); })
+        .thenTry([self = shared_from_this()](folly::Try<folly::Unit>&& result) {
+          self->onBatchDone(std::move(result));
+        });
+  }
+  if (promiseToFulfill) {
+    auto error = state_.rlock()->error;
+    if (error) {
+      promiseToFulfill->setException(std::move(error));
+    } else {
+      promiseToFulfill->setValue();
+    }
+  }
+}
+
+void GlobPrefetcher::onBatchDone(folly::Try<folly::Unit>&& result) {
+  std::vector<std::vector<ObjectId>> batches;
+  std::optional<folly::Promise<folly::Unit>> promise;
+  {
+    auto state = state_.wlock();
+    --state->inFlight;
+    if (result.hasException() && !state->error) {
+      state->error = std::move(result.exception());
+    }
+    takeBatchesLocked(*state, batches, promise);
+  }
+  fetch(std::move(batches), std::move(promise));
+}
+
+} // namespace eden
+} // namespace facebook
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Set.h>
+#include <folly/futures/Future.h>
+#include <folly/futures/Promise.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "eden/fs/inodes/GlobNode.h"
+
+namespace facebook {
+namespace eden {
+
+/**
+ * Prefetches the blobs matched by a glob while the glob is still walking the
+ * tree.
+ *
+ * Matched IDs are deduplicated and grouped in batches of batchSize, and each
+ * full batch is handed to fetchBatch right away, rather than waiting for the
+ * end of the walk. At most maxInFlightBatches batches are fetched at a time;
+ * the others are queued, so that a glob matching millions of files doesn't
+ * flood the backing store.
+ *
+ * isCancelled is checked before each batch is fetched. Once it returns true,
+ * typically because the Thrift request was cancelled or timed out, queued
+ * and future batches are dropped; batches already being fetched are left to
+ * complete.
+ */
+class GlobPrefetcher : public GlobNode::PrefetchList,
+                       public std::enable_shared_from_this<GlobPrefetcher> {
+ public:
+  using FetchBatch =
+      std::function<folly::Future<folly::Unit>(std::vector<ObjectId> ids)>;
+
+  static std::shared_ptr<GlobPrefetcher> create(
+      FetchBatch fetchBatch,
+      size_t batchSize,
+      size_t maxInFlightBatches,
+      std::function<bool()> isCancelled = nullptr);
+
+  void add(const ObjectId& id) override;
+
+  /**
+   * Fetches the last, partial batch. Must be called once, when the walk is
+   * done. The returned future completes once every batch has been fetched or
+   * dropped, with the first error encountered, if any.
+   */
+  folly::Future<folly::Unit> finish();
+
+  /** Number of distinct IDs added, whether or not they were fetched. */
+  size_t getIdCount() const;
+
+  /** Number of batches dropped because the prefetch was cancelled. */
+  size_t getDroppedBatchCount() const;
+
+ private:
+  GlobPrefetcher(
+      FetchBatch fetchBatch,
+      size_t batchSize,
+      size_t maxInFlightBatches,
+      std::function<bool()> isCancelled);
+
+  struct State {
+    folly::F14FastSet<ObjectId> seen;
+    std::vector<ObjectId> pending;
+    std::deque<std::vector<ObjectId>> queued;
+    size_t inFlight = 0;
+    size_t droppedBatches = 0;
+    bool cancelled = false;
+    bool finishing = false;
+    folly::exception_wrapper error;
+    std::optional<folly::Promise<folly::Unit>> done{std::in_place};
+  };
+
+  /**
+   * Moves as many queued batches as the concurrency limit allows into
+   * batchesToFetch. If the walk is done and nothing is left to fetch, the
+   * done promise is moved into promiseToFulfill.
+   */
+  void takeBatchesLocked(
+      State& state,
+      std::vector<std::vector<ObjectId>>& batchesToFetch,
+      std::optional<folly::Promise<folly::Unit>>& promiseToFulfill);
+
+  void fetch(
+      std::vector<std::vector<ObjectId>> batches,
+      std::optional<folly::Promise<folly::Unit>> promiseToFulfill);
+
+  void onBatchDone(folly::Try<folly::Unit>&& result);
+
+  const FetchBatch fetchBatch_;
+  const size_t batchSize_;
+  const size_t maxInFlightBatches_;
+  const std::function<bool()> isCancelled_;
+
+  folly::Synchronized<State> state_;
+};
+
+} // namespace eden
+} // namespace facebook
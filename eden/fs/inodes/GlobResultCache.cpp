@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/GlobResultCache.h"
+
+#include <folly/Conv.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+std::string makeKeyPrefix(
+    std::vector<std::string> globs,
+    bool includeDotfiles,
+    char rootKind) {
+  std::sort(globs.begin(), globs.end());
+  globs.erase(std::unique(globs.begin(), globs.end()), globs.end());
+
+  // Patterns cannot contain NUL bytes, which makes them safe separators.
+  std::string key;
+  key.push_back(rootKind);
+  key.push_back(includeDotfiles ? '1' : '0');
+  for (const auto& glob : globs) {
+    key.push_back('\0');
+    key.append(glob);
+  }
+  key.push_back('\0');
+  key.push_back('\0');
+  return key;
+}
+} // namespace
+
+GlobResultCache::GlobResultCache(size_t maxPaths) : maxPaths_{maxPaths} {}
+
+std::string GlobResultCache::makeKey(
+    std::vector<std::string> globs,
+    bool includeDotfiles,
+    const ObjectId& treeId) {
+  auto key = makeKeyPrefix(std::move(globs), includeDotfiles, 't');
+  auto bytes = treeId.getBytes();
+  key.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  return key;
+}
+
+std::string GlobResultCache::makeKey(
+    std::vector<std::string> globs,
+    bool includeDotfiles,
+    RelativePathPiece searchRoot,
+    uint64_t journalSequence) {
+  auto key = makeKeyPrefix(std::move(globs), includeDotfiles, 'w');
+  folly::toAppend(journalSequence, &key);
+  key.push_back('\0');
+  key.append(searchRoot.stringPiece().data(), searchRoot.stringPiece().size());
+  return key;
+}
+
+std::shared_ptr<const GlobResultCache::Entries> GlobResultCache::get(
+    const std::string& key) {
+  if (!isEnabled()) {
+    return nullptr;
+  }
+  auto state = state_.wlock();
+  auto it = state->entries.find(key);
+  if (it == state->entries.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void GlobResultCache::insert(
+    std::string key,
+    std::shared_ptr<const Entries> entries) {
+  // Count every entry as at least one path so that empty results are bounded
+  // too.
+  auto paths = std::max<size_t>(entries->size(), 1);
+  if (paths > maxPaths_) {
+    return;
+  }
+
+  auto state = state_.wlock();
+  auto it = state->entries.findWithoutPromotion(key);
+  if (it != state->entries.end()) {
+    state->totalPaths -= std::max<size_t>(it->second->size(), 1);
+    state->entries.erase(key);
+  }
+
+  while (state->totalPaths + paths > maxPaths_) {
+    auto lru = state->entries.rbegin();
+    state->totalPaths -= std::max<size_t>(lru->second->size(), 1);
+    auto lruKey = lru->first;
+    state->entries.erase(lruKey);
+  }
+
+  state->entries.set(std::move(key), std::move(entries));
+  state->totalPaths += paths;
+}
+
+} // namespace facebook::eden
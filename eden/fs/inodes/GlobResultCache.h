@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * Remembers the results of recent glob evaluations, so that build tools
+ * issuing the same globs over and over do not walk the same trees each time.
+ *
+ * Results are keyed on the set of patterns and on what they were evaluated
+ * against:
+ * - For source control trees, the ObjectId of the tree the walk started at.
+ *   Trees are immutable, so these entries never go stale.
+ * - For the working copy, the search root and the Journal sequence number
+ *   at the time of the walk. Any change to the working copy is journaled and
+ *   bumps the sequence number, so entries for older sequence numbers are
+ *   simply never looked up again and age out.
+ *
+ * The cache is bounded by the total number of result paths it holds; the
+ * least recently used entries are evicted first.
+ *
+ * This class is thread safe.
+ */
+class GlobResultCache {
+ public:
+  struct Entry {
+    RelativePath name;
+    dtype_t dtype;
+  };
+  using Entries = std::vector<Entry>;
+
+  /**
+   * A cache holding at most maxPaths result paths. A maxPaths of 0 disables
+   * the cache.
+   */
+  explicit GlobResultCache(size_t maxPaths);
+
+  GlobResultCache(const GlobResultCache&) = delete;
+  GlobResultCache& operator=(const GlobResultCache&) = delete;
+
+  bool isEnabled() const {
+    return maxPaths_ != 0;
+  }
+
+  /**
+   * Key for globs evaluated against the source control tree treeId.
+   *
+   * The order of globs, and any duplicates, do not matter.
+   */
+  static std::string makeKey(
+      std::vector<std::string> globs,
+      bool includeDotfiles,
+      const ObjectId& treeId);
+
+  /**
+   * Key for globs evaluated against the working copy directory searchRoot,
+   * when the Journal was at journalSequence.
+   */
+  static std::string makeKey(
+      std::vector<std::string> globs,
+      bool includeDotfiles,
+      RelativePathPiece searchRoot,
+      uint64_t journalSequence);
+
+  /**
+   * Returns the cached results for key, or nullptr if there are none.
+   */
+  std::shared_ptr<const Entries> get(const std::string& key);
+
+  /**
+   * Cache the results for key. Results larger than the whole cache are not
+   * cached.
+   */
+  void insert(std::string key, std::shared_ptr<const Entries> entries);
+
+ private:
+  struct State {
+    State() : entries{0} {}
+
+    folly::EvictingCacheMap<std::string, std::shared_ptr<const Entries>>
+        entries;
+    size_t totalPaths{0};
+  };
+
+  const size_t maxPaths_;
+  folly::Synchronized<State> state_;
+};
+
+} // namespace facebook::eden
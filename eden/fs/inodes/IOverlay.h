@@ -121,6 +121,18 @@ class IOverlay {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) = 0;
 
+  /**
+   * Creates the overlay file of a new FileInode as a copy-on-write clone of
+   * source, a complete overlay file, header included, stored on the same
+   * filesystem as the overlay.
+   *
+   * Returns std::nullopt if the overlay doesn't support cloning files, in
+   * which case the caller should write the contents with createOverlayFile.
+   */
+  virtual std::optional<folly::File> cloneOverlayFile(
+      InodeNumber inodeNumber,
+      const folly::File& source) = 0;
+
   /**
    * Helper function that opens an existing overlay file,
    * checks if the file has valid header, and returns the file.
@@ -270,7 +270,7 @@ void InodeBase::onPtrRefZero() const {
 }
 
 ParentInodeInfo InodeBase::getParentInfo() const {
-  using ParentContentsPtr = folly::Synchronized<TreeInodeState>::LockedPtr;
+  using ParentContentsPtr = SynchronizedTreeInodeState::LockedPtr;
 
   // Grab our parent's contents_ lock.
   //
@@ -285,6 +285,29 @@ class InodeBase {
     return ptrAcquireCount_.fetch_sub(1, std::memory_order_acq_rel);
   }
 
+  /**
+   * Record that this inode was looked up. Background unloading uses this to
+   * keep recently used inodes loaded.
+   *
+   * This is called on every lookup, so it avoids writing to the flag when it
+   * is already set.
+   */
+  void markRecentlyAccessed() const {
+    if (!recentlyAccessed_.load(std::memory_order_relaxed)) {
+      recentlyAccessed_.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Clear the recently accessed flag, returning whether it was set.
+   *
+   * This gives the inode a second chance: an inode is only unloaded for
+   * memory pressure if it has not been looked up since the previous sweep.
+   */
+  bool clearRecentlyAccessed() const {
+    return recentlyAccessed_.exchange(false, std::memory_order_relaxed);
+  }
+
   /**
    * Get the channel reference count.
    *
@@ -605,6 +628,13 @@ class InodeBase {
    */
   mutable std::atomic<uint32_t> ptrAcquireCount_{0};
 
+  /**
+   * Set whenever the inode is looked up, and cleared by each memory pressure
+   * unload sweep. Inodes start out as recently accessed, since they were just
+   * loaded for a reason.
+   */
+  mutable std::atomic<bool> recentlyAccessed_{true};
+
   /**
    * Information about this Inode's location in the file system path.
    * Eden does not support hard links, so each Inode has exactly one location.
@@ -11,6 +11,7 @@
 #include <folly/MapUtil.h>
 #include <folly/functional/Invoke.h>
 #include <folly/futures/Future.h>
+#include "eden/fs/inodes/InodeError.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/store/ObjectFetchContext.h"
@@ -67,38 +68,56 @@ class InodeLoader {
       promise.setValue(inodeTry);
     }
 
-    auto tree = inodeTry.hasValue() ? inodeTry->asTreePtrOrNull() : nullptr;
+    if (children_.empty()) {
+      return;
+    }
 
-    for (auto& entry : children_) {
-      if (inodeTry.hasException()) {
-        // The attempt failed, so propagate the failure to our children
+    if (inodeTry.hasException()) {
+      // The attempt failed, so propagate the failure to our children
+      for (auto& entry : children_) {
         entry.second->loaded(inodeTry, fetchContext);
-      } else {
-        // otherwise schedule the next level of lookup
-        auto& childName = entry.first;
-        auto& childLoader = entry.second;
-
-        if (!tree) {
-          // This inode is not a tree but we're trying to load
-          // children; generate failures for these
-          childLoader->loaded(
-              folly::Try<InodePtr>(
-                  folly::make_exception_wrapper<std::system_error>(
-                      ENOENT, std::generic_category())),
-              fetchContext);
-          continue;
-        }
-
-        makeImmediateFutureWith(
-            [&] { return tree->getOrLoadChild(childName, fetchContext); })
-            .thenTry([loader = std::move(childLoader),
-                      &fetchContext](folly::Try<InodePtr>&& inode) {
-              loader->loaded(inode, fetchContext);
-            })
-            .semi()
-            .via(&folly::QueuedImmediateExecutor::instance());
       }
+      return;
+    }
+
+    auto tree = inodeTry->asTreePtrOrNull();
+    if (!tree) {
+      // This inode is not a tree but we're trying to load
+      // children; generate failures for these
+      folly::Try<InodePtr> failure{InodeError(ENOTDIR, *inodeTry)};
+      for (auto& entry : children_) {
+        entry.second->loaded(failure, fetchContext);
+      }
+      return;
     }
+
+    // Schedule the next level of lookup. All the children are looked up
+    // together, so that the contents lock of this directory is taken once
+    // however many of them were requested.
+    std::vector<PathComponentPiece> names;
+    std::vector<std::unique_ptr<InodeLoader>> loaders;
+    names.reserve(children_.size());
+    loaders.reserve(children_.size());
+    for (auto& entry : children_) {
+      names.push_back(entry.first);
+      loaders.push_back(std::move(entry.second));
+    }
+
+    makeImmediateFutureWith(
+        [&] { return tree->getOrLoadChildren(names, fetchContext); })
+        .thenTry([loaders = std::move(loaders), &fetchContext](
+                     folly::Try<std::vector<folly::Try<InodePtr>>>&&
+                         children) {
+          for (size_t n = 0; n < loaders.size(); ++n) {
+            loaders[n]->loaded(
+                children.hasException()
+                    ? folly::Try<InodePtr>{children.exception()}
+                    : std::move((*children)[n]),
+                fetchContext);
+          }
+        })
+        .semi()
+        .via(&folly::QueuedImmediateExecutor::instance());
   }
 
  private:
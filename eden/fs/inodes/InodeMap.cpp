@@ -13,6 +13,8 @@
 #include <folly/Likely.h>
 #include <folly/chrono/Conv.h>
 #include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
+#include <algorithm>
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/config/ReloadableConfig.h"
@@ -123,7 +125,7 @@ InodeMap::~InodeMap() {
 }
 
 inline void InodeMap::insertLoadedInode(
-    const folly::Synchronized<Members>::LockedPtr& data,
+    const SynchronizedMembers::LockedPtr& data,
     InodeBase* inode) {
   auto ret = data->loadedInodes_.emplace(inode->getNodeId(), inode);
   XCHECK(ret.second);
@@ -135,7 +137,7 @@ inline void InodeMap::insertLoadedInode(
 }
 
 void InodeMap::initializeRoot(
-    const folly::Synchronized<Members>::LockedPtr& data,
+    const SynchronizedMembers::LockedPtr& data,
     TreeInodePtr root) {
   XCHECK_EQ(data->loadedInodes_.size(), 0ul)
       << "cannot load InodeMap data over a populated instance";
@@ -155,11 +157,12 @@ void InodeMap::initialize(TreeInodePtr root) {
 
 template <class... Args>
 void InodeMap::initializeUnloadedInode(
-    const folly::Synchronized<Members>::LockedPtr& data,
+    const SynchronizedMembers::LockedPtr& data,
     InodeNumber parentIno,
     InodeNumber ino,
     Args&&... args) {
   auto unloadedEntry = UnloadedInode(parentIno, std::forward<Args>(args)...);
+  noteUnloadedInodeChanged(*data, ino);
   auto result = data->unloadedInodes_.emplace(ino, std::move(unloadedEntry));
   if (!result.second) {
     auto message = fmt::format(
@@ -172,11 +175,12 @@ void InodeMap::initializeUnloadedInode(
 
 void InodeMap::initializeFromTakeover(
     TreeInodePtr root,
-    const SerializedInodeMap& takeover) {
-  auto data = data_.wlock();
-  initializeRoot(data, std::move(root));
-
-  for (const auto& entry : *takeover.unloadedInodes_ref()) {
+    SerializedInodeMap takeover) {
+  auto& entries = *takeover.unloadedInodes_ref();
+  std::vector<std::pair<uint64_t, size_t>> index;
+  index.reserve(entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const auto& entry = entries[i];
     if (*entry.numFsReferences_ref() < 0) {
       auto message = folly::to<std::string>(
           "inode number ",
@@ -185,25 +189,101 @@ void InodeMap::initializeFromTakeover(
       XLOG(ERR) << message;
       throw std::runtime_error(message);
     }
+    index.emplace_back(*entry.inodeNumber_ref(), i);
+  }
 
-    initializeUnloadedInode(
-        data,
-        InodeNumber::fromThrift(*entry.parentInode_ref()),
-        InodeNumber::fromThrift(*entry.inodeNumber_ref()),
-        PathComponentPiece{*entry.name_ref()},
-        *entry.isUnlinked_ref(),
-        *entry.mode_ref(),
-        entry.hash_ref()->empty() ? std::nullopt
-                                  : std::optional<ObjectId>{folly::ByteRange{
-                                        folly::StringPiece{*entry.hash_ref()}}},
-        folly::to<uint32_t>(*entry.numFsReferences_ref()));
+  std::sort(index.begin(), index.end());
+  auto duplicate = std::adjacent_find(
+      index.begin(), index.end(), [](const auto& a, const auto& b) {
+        return a.first == b.first;
+      });
+  if (duplicate != index.end()) {
+    auto message = fmt::format(
+        "failed to emplace inode number {}; is it already present in the InodeMap?",
+        duplicate->first);
+    XLOG(ERR) << message;
+    throw std::runtime_error(message);
   }
 
+  auto data = data_.wlock();
+  initializeRoot(data, std::move(root));
+  data->numTakeoverInodes_ = entries.size();
+  data->takeoverInodeMaterialized_.assign(entries.size(), false);
+  data->takeoverInodeIndex_ = std::move(index);
+  data->takeoverInodes_ = std::move(entries);
+
   XLOG(DBG2) << "InodeMap initialized mount " << mount_->getPath()
-             << " from takeover, " << data->unloadedInodes_.size()
+             << " from takeover, " << data->numTakeoverInodes_
              << " inodes registered";
 }
 
+std::optional<size_t> InodeMap::findTakeoverInode(
+    const Members& data,
+    InodeNumber number) {
+  if (data.numTakeoverInodes_ == 0) {
+    return std::nullopt;
+  }
+  const auto& index = data.takeoverInodeIndex_;
+  auto it = std::lower_bound(
+      index.begin(),
+      index.end(),
+      number.get(),
+      [](const auto& entry, uint64_t value) { return entry.first < value; });
+  if (it == index.end() || it->first != number.get() ||
+      data.takeoverInodeMaterialized_[it->second]) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void InodeMap::materializeTakeoverInode(Members& data, InodeNumber number) {
+  auto index = findTakeoverInode(data, number);
+  if (!index.has_value()) {
+    return;
+  }
+
+  auto entry = std::move(data.takeoverInodes_[*index]);
+  auto ret = data.unloadedInodes_.emplace(
+      number,
+      UnloadedInode(
+          InodeNumber::fromThrift(*entry.parentInode_ref()),
+          PathComponentPiece{*entry.name_ref()},
+          *entry.isUnlinked_ref(),
+          *entry.mode_ref(),
+          entry.hash_ref()->empty()
+              ? std::nullopt
+              : std::optional<ObjectId>{folly::ByteRange{
+                    folly::StringPiece{*entry.hash_ref()}}},
+          folly::to<uint32_t>(*entry.numFsReferences_ref())));
+  XDCHECK(ret.second);
+
+  data.takeoverInodeMaterialized_[*index] = true;
+  if (--data.numTakeoverInodes_ == 0) {
+    data.takeoverInodes_ = {};
+    data.takeoverInodeIndex_ = {};
+    data.takeoverInodeMaterialized_ = {};
+  }
+}
+
+void InodeMap::materializeAllTakeoverInodes(Members& data) {
+  if (data.numTakeoverInodes_ == 0) {
+    return;
+  }
+  // Materializing the last entry releases the index, so check the count
+  // before each access.
+  for (size_t i = 0; data.numTakeoverInodes_ > 0; ++i) {
+    auto number = data.takeoverInodeIndex_[i].first;
+    materializeTakeoverInode(data, InodeNumber::fromThrift(number));
+  }
+}
+
+bool InodeMap::isUnloadedInodeRemembered(
+    const Members& data,
+    InodeNumber number) {
+  return data.unloadedInodes_.count(number) > 0 ||
+      findTakeoverInode(data, number).has_value();
+}
+
 namespace {
 #ifdef _WIN32
 /**
@@ -290,10 +370,12 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
   // Check to see if this Inode is already loaded
   auto loadedIter = data->loadedInodes_.find(number);
   if (loadedIter != data->loadedInodes_.end()) {
+    loadedIter->second->markRecentlyAccessed();
     return loadedIter->second.getPtr();
   }
 
   // Look up the data in the unloadedInodes_ map.
+  materializeTakeoverInode(*data, number);
   auto unloadedIter = data->unloadedInodes_.find(number);
   if (UNLIKELY(unloadedIter == data->unloadedInodes_.end())) {
     if (throwEstaleIfInodeIsMissing_) {
@@ -364,6 +446,7 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
     }
 
     // Look up the parent in unloadedInodes_
+    materializeTakeoverInode(*data, unloadedData->parent);
     unloadedIter = data->unloadedInodes_.find(unloadedData->parent);
     if (UNLIKELY(unloadedIter == data->unloadedInodes_.end())) {
       // This shouldn't happen.  We must know about the parent inode number if
@@ -464,6 +547,7 @@ InodeMap::PromiseVector InodeMap::inodeLoadComplete(InodeBase* inode) {
   PromiseVector promises;
   try {
     auto data = data_.wlock();
+    materializeTakeoverInode(*data, number);
     auto it = data->unloadedInodes_.find(number);
     XCHECK(it != data->unloadedInodes_.end())
         << "failed to find unloaded inode data when finishing load of inode "
@@ -474,6 +558,7 @@ InodeMap::PromiseVector InodeMap::inodeLoadComplete(InodeBase* inode) {
 
     // Insert the entry into loadedInodes_, and remove it from unloadedInodes_
     insertLoadedInode(data, inode);
+    noteUnloadedInodeChanged(*data, number);
     data->unloadedInodes_.erase(it);
     return promises;
   } catch (const std::exception& ex) {
@@ -502,6 +587,7 @@ InodeMap::PromiseVector InodeMap::extractPendingPromises(InodeNumber number) {
   PromiseVector promises;
   {
     auto data = data_.wlock();
+    materializeTakeoverInode(*data, number);
     auto it = data->unloadedInodes_.find(number);
     XCHECK(it != data->unloadedInodes_.end())
         << "failed to find unloaded inode data when finishing load of inode "
@@ -527,6 +613,7 @@ InodePtr InodeMap::lookupLoadedInode(InodeNumber number) {
   if (it == data->loadedInodes_.end()) {
     return nullptr;
   }
+  it->second->markRecentlyAccessed();
   return it->second.getPtr();
 }
 
@@ -553,34 +640,47 @@ std::optional<RelativePath> InodeMap::getPathForInode(InodeNumber inodeNumber) {
 
 std::optional<RelativePath> InodeMap::getPathForInodeHelper(
     InodeNumber inodeNumber,
-    const folly::Synchronized<Members>::RLockedPtr& data) {
+    const SynchronizedMembers::RLockedPtr& data) {
   auto loadedIt = data->loadedInodes_.find(inodeNumber);
   if (loadedIt != data->loadedInodes_.cend()) {
     // If the inode is loaded, return its RelativePath
     return loadedIt->second->getPath();
+  }
+
+  // This runs with the lock held in shared mode, so entries received during
+  // takeover are read in place rather than materialized.
+  InodeNumber parent;
+  PathComponentPiece name;
+  bool isUnlinked{false};
+  auto unloadedIt = data->unloadedInodes_.find(inodeNumber);
+  if (unloadedIt != data->unloadedInodes_.cend()) {
+    parent = unloadedIt->second.parent;
+    name = unloadedIt->second.name;
+    isUnlinked = unloadedIt->second.isUnlinked;
+  } else if (auto index = findTakeoverInode(*data, inodeNumber)) {
+    const auto& entry = data->takeoverInodes_[*index];
+    parent = InodeNumber::fromThrift(*entry.parentInode_ref());
+    name = PathComponentPiece{*entry.name_ref()};
+    isUnlinked = *entry.isUnlinked_ref();
   } else {
-    auto unloadedIt = data->unloadedInodes_.find(inodeNumber);
-    if (unloadedIt != data->unloadedInodes_.cend()) {
-      if (unloadedIt->second.isUnlinked) {
-        return std::nullopt;
-      }
-      // If the inode is not loaded, return its parent's path as long as it's
-      // parent isn't the root
-      auto parent = unloadedIt->second.parent;
-      if (parent == kRootNodeId) {
-        // The parent is the Eden mount root, just return its name (base case)
-        return RelativePath(unloadedIt->second.name);
-      }
-      auto dir = getPathForInodeHelper(parent, data);
-      if (!dir) {
-        EDEN_BUG() << "unlinked parent inode " << parent
-                   << "appears to contain non-unlinked child " << inodeNumber;
-      }
-      return *dir + unloadedIt->second.name;
-    } else {
-      throwSystemErrorExplicit(EINVAL, "unknown inode number ", inodeNumber);
-    }
+    throwSystemErrorExplicit(EINVAL, "unknown inode number ", inodeNumber);
+  }
+
+  if (isUnlinked) {
+    return std::nullopt;
+  }
+  // If the inode is not loaded, return its parent's path as long as it's
+  // parent isn't the root
+  if (parent == kRootNodeId) {
+    // The parent is the Eden mount root, just return its name (base case)
+    return RelativePath(name);
   }
+  auto dir = getPathForInodeHelper(parent, data);
+  if (!dir) {
+    EDEN_BUG() << "unlinked parent inode " << parent
+               << "appears to contain non-unlinked child " << inodeNumber;
+  }
+  return *dir + name;
 }
 void InodeMap::decFsRefcount(InodeNumber number, uint32_t count) {
   InodePtr inodePtr;
@@ -596,7 +696,7 @@ void InodeMap::decFsRefcount(InodeNumber number, uint32_t count) {
 }
 
 InodePtr InodeMap::decFsRefcountHelper(
-    folly::Synchronized<Members>::LockedPtr& data,
+    SynchronizedMembers::LockedPtr& data,
     InodeNumber number,
     uint32_t count,
     bool clearRefCount) {
@@ -617,6 +717,7 @@ InodePtr InodeMap::decFsRefcountHelper(
   }
 
   // If it wasn't loaded, it should be in the unloaded map
+  materializeTakeoverInode(*data, number);
   auto unloadedIter = data->unloadedInodes_.find(number);
   if (UNLIKELY(unloadedIter == data->unloadedInodes_.end())) {
     EDEN_BUG() << "InodeMap::decFsRefcount() called on unknown inode number "
@@ -624,6 +725,7 @@ InodePtr InodeMap::decFsRefcountHelper(
   }
 
   // Decrement the reference count in the unloaded entry
+  noteUnloadedInodeChanged(*data, number);
   auto& unloadedEntry = unloadedIter->second;
   if (clearRefCount) {
     unloadedEntry.numFsReferences = 0;
@@ -670,6 +772,7 @@ void InodeMap::forgetStaleInodes() {
 
   {
     auto data = data_.wlock();
+    materializeAllTakeoverInodes(*data);
 
     for (auto& inode : data->unloadedInodes_) {
       XLOG(DBG9) << "Considering forgetting unloaded inode " << inode.first;
@@ -748,6 +851,63 @@ void InodeMap::setUnmounted() {
   data->isUnmounted_ = true;
 }
 
+void InodeMap::prepareTakeover() {
+  folly::stop_watch<std::chrono::milliseconds> timer;
+
+  // Start recording changes in the same critical section that captures the
+  // set of unloaded inodes, so that every entry either is read below
+  // or is recorded as changed.
+  std::vector<InodeNumber> inodeNumbers;
+  {
+    auto data = data_.wlock();
+    if (data->shutdownPromise.has_value() ||
+        data->takeoverChangedInodes_.has_value()) {
+      return;
+    }
+    data->takeoverChangedInodes_.emplace();
+    inodeNumbers.reserve(
+        data->unloadedInodes_.size() + data->numTakeoverInodes_);
+    for (const auto& entry : data->unloadedInodes_) {
+      inodeNumbers.push_back(entry.first);
+    }
+    if (data->numTakeoverInodes_ > 0) {
+      for (const auto& [number, index] : data->takeoverInodeIndex_) {
+        if (!data->takeoverInodeMaterialized_[index]) {
+          inodeNumbers.push_back(InodeNumber::fromThrift(number));
+        }
+      }
+    }
+  }
+
+  // Serialize the entries in batches, releasing the lock between batches so
+  // that FS requests can make progress. An entry that is modified or erased
+  // between batches is in takeoverChangedInodes_, and is serialized again by
+  // shutdown().
+  constexpr size_t kBatchSize = 10000;
+  takeoverSnapshot_.clear();
+  takeoverSnapshot_.reserve(inodeNumbers.size());
+  for (size_t begin = 0; begin < inodeNumbers.size(); begin += kBatchSize) {
+    auto end = std::min(inodeNumbers.size(), begin + kBatchSize);
+    auto data = data_.rlock();
+    for (size_t index = begin; index < end; ++index) {
+      auto it = data->unloadedInodes_.find(inodeNumbers[index]);
+      if (it != data->unloadedInodes_.end()) {
+        takeoverSnapshot_.emplace_back(
+            serializeUnloadedInode(it->first, it->second));
+      } else if (
+          auto takeoverIndex = findTakeoverInode(*data, inodeNumbers[index])) {
+        // Materializing an entry does not change it, so entries that are
+        // still in their serialized form can be copied as they are.
+        takeoverSnapshot_.push_back(data->takeoverInodes_[*takeoverIndex]);
+      }
+    }
+  }
+
+  XLOG(INFO) << "serialized " << takeoverSnapshot_.size()
+             << " unloaded inodes of " << mount_->getPath()
+             << " ahead of takeover in " << timer.elapsed().count() << "ms";
+}
+
 Future<SerializedInodeMap> InodeMap::shutdown(
     FOLLY_MAYBE_UNUSED bool doTakeover) {
   // Record that we are in the process of shutting down.
@@ -832,13 +992,16 @@ Future<SerializedInodeMap> InodeMap::shutdown(
     // from here.
     return SerializedInodeMap{};
 #else
+    auto data = data_.wlock();
+    auto changedInodes = std::exchange(data->takeoverChangedInodes_, {});
+    auto snapshot = std::exchange(takeoverSnapshot_, {});
+
     // TODO: This check could occur after the loadedInodes_ assertion below to
     // maximize coverage of any invariants that are broken during shutdown.
     if (!doTakeover) {
       return SerializedInodeMap{};
     }
 
-    auto data = data_.wlock();
     XLOG(DBG3)
         << "InodeMap::shutdown after releasing inodesToClear: loadedCount="
         << data->loadedInodes_.size()
@@ -851,32 +1014,82 @@ Future<SerializedInodeMap> InodeMap::shutdown(
                  << "have been unloaded for this to succeed!";
     }
 
+    folly::stop_watch<std::chrono::milliseconds> timer;
     SerializedInodeMap result;
-    result.unloadedInodes_ref()->reserve(data->unloadedInodes_.size());
-    for (const auto& [inodeNumber, entry] : data->unloadedInodes_) {
-      SerializedInodeMapEntry serializedEntry;
-
-      XLOG(DBG5) << "  serializing unloaded inode " << inodeNumber
-                 << " parent=" << entry.parent.get() << " name=" << entry.name;
+    auto& entries = *result.unloadedInodes_ref();
+    auto unloadedCount =
+        data->unloadedInodes_.size() + data->numTakeoverInodes_;
+    entries.reserve(unloadedCount);
+    if (changedInodes.has_value()) {
+      // Entries for inodes that did not change since prepareTakeover() are
+      // still accurate, and are guaranteed to still be unloaded.
+      for (auto& serializedEntry : snapshot) {
+        auto inodeNumber =
+            InodeNumber::fromThrift(*serializedEntry.inodeNumber_ref());
+        if (changedInodes->count(inodeNumber) == 0) {
+          entries.emplace_back(std::move(serializedEntry));
+        }
+      }
+      auto reusedCount = entries.size();
+      for (auto inodeNumber : *changedInodes) {
+        auto it = data->unloadedInodes_.find(inodeNumber);
+        if (it != data->unloadedInodes_.end()) {
+          entries.emplace_back(serializeUnloadedInode(it->first, it->second));
+        }
+      }
 
-      serializedEntry.inodeNumber_ref() = inodeNumber.get();
-      serializedEntry.parentInode_ref() = entry.parent.get();
-      serializedEntry.name_ref() = entry.name.stringPiece().str();
-      serializedEntry.isUnlinked_ref() = entry.isUnlinked;
-      serializedEntry.numFsReferences_ref() = entry.numFsReferences;
-      serializedEntry.hash_ref() = thriftHash(entry.hash);
-      serializedEntry.mode_ref() = entry.mode;
+      if (entries.size() == unloadedCount) {
+        XLOG(INFO) << "serialized " << entries.size()
+                   << " unloaded inodes for takeover of " << mount_->getPath()
+                   << " in " << timer.elapsed().count() << "ms, "
+                   << reusedCount << " of them before the takeover began";
+        return result;
+      }
+      XLOG(ERR) << "takeover snapshot of " << mount_->getPath() << " has "
+                << entries.size() << " inodes rather than " << unloadedCount
+                << "; serializing all unloaded inodes again";
+      entries.clear();
+    }
 
-      result.unloadedInodes_ref()->emplace_back(std::move(serializedEntry));
+    for (const auto& [inodeNumber, entry] : data->unloadedInodes_) {
+      entries.emplace_back(serializeUnloadedInode(inodeNumber, entry));
     }
+    // The entries that were received during takeover and never used can be
+    // handed over as they are.
+    if (data->numTakeoverInodes_ > 0) {
+      for (size_t i = 0; i < data->takeoverInodes_.size(); ++i) {
+        if (!data->takeoverInodeMaterialized_[i]) {
+          entries.emplace_back(std::move(data->takeoverInodes_[i]));
+        }
+      }
+    }
+    XLOG(INFO) << "serialized " << entries.size()
+               << " unloaded inodes for takeover of " << mount_->getPath()
+               << " in " << timer.elapsed().count() << "ms";
 
     return result;
 #endif
   });
 }
 
-void InodeMap::shutdownComplete(
-    folly::Synchronized<Members>::LockedPtr&& data) {
+SerializedInodeMapEntry InodeMap::serializeUnloadedInode(
+    InodeNumber number,
+    const UnloadedInode& entry) {
+  XLOG(DBG5) << "  serializing unloaded inode " << number
+             << " parent=" << entry.parent.get() << " name=" << entry.name;
+
+  SerializedInodeMapEntry serializedEntry;
+  serializedEntry.inodeNumber_ref() = number.get();
+  serializedEntry.parentInode_ref() = entry.parent.get();
+  serializedEntry.name_ref() = entry.name.stringPiece().str();
+  serializedEntry.isUnlinked_ref() = entry.isUnlinked;
+  serializedEntry.numFsReferences_ref() = entry.numFsReferences;
+  serializedEntry.hash_ref() = thriftHash(entry.hash);
+  serializedEntry.mode_ref() = entry.mode;
+  return serializedEntry;
+}
+
+void InodeMap::shutdownComplete(SynchronizedMembers::LockedPtr&& data) {
   // We manually dropped our reference count to the root inode in
   // beginShutdown().  Destroy it now, and call resetNoDecRef() on our pointer
   // to make sure it doesn't try to decrement the reference count again when
@@ -893,7 +1106,7 @@ void InodeMap::shutdownComplete(
 }
 
 bool InodeMap::isInodeRemembered(InodeNumber ino) const {
-  return data_.rlock()->unloadedInodes_.count(ino) > 0;
+  return isUnloadedInodeRemembered(*data_.rlock(), ino);
 }
 
 void InodeMap::onInodeUnreferenced(
@@ -901,8 +1114,11 @@ void InodeMap::onInodeUnreferenced(
     ParentInodeInfo&& parentInfo) {
   XLOG(DBG8) << "inode " << inode->getNodeId()
              << " unreferenced: " << inode->getLogPath();
-  // Acquire our lock.
-  auto data = data_.wlock();
+  // Acquire our lock. This happens every time an InodePtr reference count
+  // drops to zero, yet usually ends up keeping the inode loaded, so only take
+  // an upgrade lock: it keeps out other writers but lets lookups, which only
+  // need a read lock, proceed concurrently.
+  auto ulock = data_.ulock();
 
   // Decrement the Inode's acquire count
   auto acquireCount = inode->decPtrAcquireCount();
@@ -914,16 +1130,9 @@ void InodeMap::onInodeUnreferenced(
 
   // Decide if we should unload the inode now, or wait until later.
   bool unloadNow = false;
-  bool shuttingDown = data->shutdownPromise.has_value();
+  bool shuttingDown = ulock->shutdownPromise.has_value();
   XDCHECK(shuttingDown || inode != root_.get());
   if (shuttingDown) {
-    // Check to see if this was the root inode that got unloaded.
-    // This indicates that the shutdown is complete.
-    if (inode == root_.get()) {
-      shutdownComplete(std::move(data));
-      return;
-    }
-
     // Always unload Inode objects immediately when shutting down.
     // We can't destroy the EdenMount until all inodes get unloaded.
     unloadNow = true;
@@ -937,32 +1146,44 @@ void InodeMap::onInodeUnreferenced(
     // - Otherwise, we have the option to unload it or not.
     //   For now we choose to always keep it loaded.
   }
+  if (!unloadNow) {
+    return;
+  }
 
-  if (unloadNow) {
-    unloadInode(
-        inode,
-        parentInfo.getParent().get(),
-        parentInfo.getName(),
-        parentInfo.isUnlinked(),
-        data);
-    if (!parentInfo.isUnlinked()) {
-      const auto& parentContents = parentInfo.getParentContents();
-      auto it = parentContents->entries.find(parentInfo.getName());
-      XCHECK(it != parentContents->entries.end());
-      auto released = it->second.clearInode();
-      XCHECK_EQ(inode, released);
-    }
+  auto data = ulock.moveFromUpgradeToWrite();
+  if (!inode->isPtrAcquireCountZero()) {
+    // A lookup holding the read lock re-acquired a reference to this inode
+    // before we upgraded. Whoever releases that reference will call us again.
+    return;
+  }
+
+  // Check to see if this was the root inode that got unloaded.
+  // This indicates that the shutdown is complete.
+  if (inode == root_.get()) {
+    shutdownComplete(std::move(data));
+    return;
+  }
+
+  unloadInode(
+      inode,
+      parentInfo.getParent().get(),
+      parentInfo.getName(),
+      parentInfo.isUnlinked(),
+      data);
+  if (!parentInfo.isUnlinked()) {
+    const auto& parentContents = parentInfo.getParentContents();
+    auto it = parentContents->entries.find(parentInfo.getName());
+    XCHECK(it != parentContents->entries.end());
+    auto released = it->second.clearInode();
+    XCHECK_EQ(inode, released);
   }
 
-  // If we unloaded the inode, only delete it after we release our locks.
-  // Deleting it may cause its parent TreeInode to become unreferenced, causing
-  // another recursive call to onInodeUnreferenced(), which will need to
-  // reacquire the lock.
+  // Only delete the inode after we release our locks. Deleting it may cause
+  // its parent TreeInode to become unreferenced, causing another recursive
+  // call to onInodeUnreferenced(), which will need to reacquire the lock.
   data.unlock();
   parentInfo.reset();
-  if (unloadNow) {
-    delete inode;
-  }
+  delete inode;
 }
 
 InodeMapLock InodeMap::lockForUnload() {
@@ -983,7 +1204,7 @@ void InodeMap::unloadInode(
     TreeInode* parent,
     PathComponentPiece name,
     bool isUnlinked,
-    const folly::Synchronized<Members>::LockedPtr& data) {
+    const SynchronizedMembers::LockedPtr& data) {
   // Call updateOverlayForUnload() to update the overlay and compute
   // if we need to remember an UnloadedInode entry.
   auto unloadedEntry =
@@ -992,6 +1213,7 @@ void InodeMap::unloadInode(
     // Insert the unloaded entry
     XLOG(DBG7) << "inserting unloaded map entry for inode "
                << inode->getNodeId();
+    noteUnloadedInodeChanged(*data, inode->getNodeId());
     auto ret = data->unloadedInodes_.emplace(
         inode->getNodeId(), std::move(unloadedEntry.value()));
     XCHECK(ret.second);
@@ -1012,7 +1234,7 @@ optional<InodeMap::UnloadedInode> InodeMap::updateOverlayForUnload(
     TreeInode* parent,
     PathComponentPiece name,
     bool isUnlinked,
-    const folly::Synchronized<Members>::LockedPtr& data) {
+    const SynchronizedMembers::LockedPtr& data) {
   auto fsCount = inode->getFsRefcount();
   if (isUnlinked && (data->isUnmounted_ || fsCount == 0)) {
     try {
@@ -1074,7 +1296,7 @@ optional<InodeMap::UnloadedInode> InodeMap::updateOverlayForUnload(
     for (const auto& pair : treeContents.entries) {
       const auto& childName = pair.first;
       const auto& entry = pair.second;
-      if (data->unloadedInodes_.count(entry.getInodeNumber())) {
+      if (isUnloadedInodeRemembered(*data, entry.getInodeNumber())) {
         XLOG(DBG5) << "remembering inode " << asTree->getNodeId() << " ("
                    << asTree->getLogPath() << ") because its child "
                    << childName << " was remembered";
@@ -1105,13 +1327,38 @@ bool InodeMap::shouldLoadChild(
     InodeNumber childInode,
     folly::Promise<InodePtr> promise) {
   auto data = data_.wlock();
+  return shouldLoadChildLocked(
+      *data, parent->getNodeId(), name, childInode, std::move(promise));
+}
+
+std::vector<bool> InodeMap::shouldLoadChildren(
+    const TreeInode* parent,
+    std::vector<ChildLoad>& loads) {
+  std::vector<bool> results;
+  results.reserve(loads.size());
+  auto parentNumber = parent->getNodeId();
+  auto data = data_.wlock();
+  for (auto& load : loads) {
+    results.push_back(shouldLoadChildLocked(
+        *data, parentNumber, load.name, load.number, std::move(load.promise)));
+  }
+  return results;
+}
+
+bool InodeMap::shouldLoadChildLocked(
+    Members& data,
+    InodeNumber parentNumber,
+    PathComponentPiece name,
+    InodeNumber childInode,
+    folly::Promise<InodePtr> promise) {
   UnloadedInode* unloadedData{nullptr};
-  auto iter = data->unloadedInodes_.find(childInode);
-  if (iter == data->unloadedInodes_.end()) {
-    InodeNumber parentNumber = parent->getNodeId();
+  materializeTakeoverInode(data, childInode);
+  auto iter = data.unloadedInodes_.find(childInode);
+  if (iter == data.unloadedInodes_.end()) {
     auto newUnloadedData = UnloadedInode(parentNumber, name);
+    noteUnloadedInodeChanged(data, childInode);
     auto ret =
-        data->unloadedInodes_.emplace(childInode, std::move(newUnloadedData));
+        data.unloadedInodes_.emplace(childInode, std::move(newUnloadedData));
     XDCHECK(ret.second);
     unloadedData = &ret.first->second;
   } else {
@@ -1141,6 +1388,22 @@ void InodeMap::recordPeriodicInodeUnload(size_t numInodesToUnload) {
       numInodesToUnload, std::memory_order_relaxed);
 }
 
+void InodeMap::recordMemoryPressureInodeUnload(size_t numInodesUnloaded) {
+  numMemoryPressureUnloadedInodes_.fetch_add(
+      numInodesUnloaded, std::memory_order_relaxed);
+}
+
+size_t InodeMap::getEstimatedMemoryUsage() const {
+  // Most source control directories hold a few dozen entries.
+  constexpr size_t kTypicalTreeEntries = 32;
+  constexpr size_t kTreeInodeSize = sizeof(TreeInode) +
+      kTypicalTreeEntries * (sizeof(PathComponent) + sizeof(DirEntry));
+
+  auto counts = getInodeCounts();
+  return counts.treeCount * kTreeInodeSize +
+      counts.fileCount * sizeof(FileInode);
+}
+
 InodeMap::InodeCounts InodeMap::getInodeCounts() const {
   InodeCounts counts;
   auto data = data_.rlock();
@@ -1148,11 +1411,14 @@ InodeMap::InodeCounts InodeMap::getInodeCounts() const {
       data->numTreeInodes_ + data->numFileInodes_, data->loadedInodes_.size());
   counts.treeCount = data->numTreeInodes_;
   counts.fileCount = data->numFileInodes_;
-  counts.unloadedInodeCount = data->unloadedInodes_.size();
+  counts.unloadedInodeCount =
+      data->unloadedInodes_.size() + data->numTakeoverInodes_;
   counts.periodicUnlinkedUnloadInodeCount =
       numPeriodicallyUnloadedUnlinkedInodes_.load(std::memory_order_relaxed);
   counts.periodicLinkedUnloadInodeCount =
       numPeriodicallyUnloadedLinkedInodes_.load(std::memory_order_relaxed);
+  counts.memoryPressureUnloadInodeCount =
+      numMemoryPressureUnloadedInodes_.load(std::memory_order_relaxed);
   return counts;
 }
 
@@ -1172,6 +1438,16 @@ std::vector<InodeNumber> InodeMap::getReferencedInodes() const {
         inodes.push_back(ino);
       }
     }
+
+    if (data->numTakeoverInodes_ > 0) {
+      for (const auto& [number, index] : data->takeoverInodeIndex_) {
+        const auto& entry = data->takeoverInodes_[index];
+        if (!data->takeoverInodeMaterialized_[index] &&
+            *entry.numFsReferences_ref() > 0) {
+          inodes.push_back(InodeNumber::fromThrift(number));
+        }
+      }
+    }
   }
 
   return inodes;
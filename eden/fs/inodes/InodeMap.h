@@ -7,17 +7,21 @@
 
 #pragma once
 
+#include <folly/SharedMutex.h>
 #include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
 #include <list>
 #include <memory>
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/model/Hash.h"
+#include "eden/fs/telemetry/InstrumentedMutex.h"
 #include "eden/fs/takeover/gen-cpp2/takeover_types.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -126,11 +130,14 @@ class InodeMap {
    * Initialize the InodeMap from data handed over from a process being taken
    * over.
    *
+   * The unloaded inodes are kept in their serialized form and only turned
+   * into UnloadedInode entries the first time they are accessed, so that
+   * the mount can start serving requests without first rebuilding every
+   * entry.
+   *
    * This method has the same constraints and concerns as initialize().
    */
-  void initializeFromTakeover(
-      TreeInodePtr root,
-      const SerializedInodeMap& takeover);
+  void initializeFromTakeover(TreeInodePtr root, SerializedInodeMap takeover);
 
   /**
    * Initialize the InodeMap from the content of the overlay.
@@ -253,6 +260,21 @@ class InodeMap {
    */
   void setUnmounted();
 
+  /**
+   * Serialize the unloaded inodes ahead of a graceful takeover, while the
+   * mount is still serving requests.
+   *
+   * From this point on the InodeMap records which unloaded inodes change, so
+   * that shutdown(true) only has to serialize those and the inodes it unloads
+   * itself, rather than every unloaded inode, while FS requests are paused.
+   * The lock is only held briefly at a time, so this does not stall FS
+   * requests for the duration of the serialization.
+   *
+   * Calling this more than once, or after shutdown() has started, does
+   * nothing.
+   */
+  void prepareTakeover();
+
   /**
    * Shutdown the InodeMap.
    *
@@ -356,6 +378,26 @@ class InodeMap {
       InodeNumber childInode,
       folly::Promise<InodePtr> promise);
 
+  struct ChildLoad {
+    PathComponentPiece name;
+    InodeNumber number;
+    folly::Promise<InodePtr> promise;
+  };
+
+  /**
+   * shouldLoadChildren() should only be called by TreeInode.
+   *
+   * This behaves like calling shouldLoadChild() for each element of loads, in
+   * order, but only acquires the InodeMap lock once. The promises are moved
+   * out of loads.
+   *
+   * Returns, for each element of loads, whether the TreeInode should start
+   * loading that child.
+   */
+  std::vector<bool> shouldLoadChildren(
+      const TreeInode* parent,
+      std::vector<ChildLoad>& loads);
+
   /**
    * inodeLoadComplete() should only be called by TreeInode.
    *
@@ -388,6 +430,7 @@ class InodeMap {
     size_t unloadedInodeCount = 0;
     size_t periodicUnlinkedUnloadInodeCount = 0;
     size_t periodicLinkedUnloadInodeCount = 0;
+    size_t memoryPressureUnloadInodeCount = 0;
   };
 
   /**
@@ -397,6 +440,21 @@ class InodeMap {
   InodeCounts getInodeCounts() const;
 
   void recordPeriodicInodeUnload(size_t numInodesToUnload);
+
+  /**
+   * Record inodes unloaded because the loaded inodes of all mounts exceeded
+   * their memory budget.
+   */
+  void recordMemoryPressureInodeUnload(size_t numInodesUnloaded);
+
+  /**
+   * A rough estimate, in bytes, of the memory used by the loaded inodes.
+   *
+   * This counts the inode objects and the entries of a typically sized
+   * directory for each loaded TreeInode. It is meant to be cheap enough to
+   * compute regularly, not to be precise.
+   */
+  size_t getEstimatedMemoryUsage() const;
   /*
    * Return all referenced inodes (loaded and unloaded inodes whose
    * fs references is greater than zero).
@@ -554,12 +612,87 @@ class InodeMap {
      * so we have to wrap it in a std::optional.
      */
     std::optional<folly::Promise<folly::Unit>> shutdownPromise;
+
+    /**
+     * The inode numbers whose unloadedInodes_ entries were inserted, modified
+     * or erased since prepareTakeover() was called.
+     *
+     * This is std::nullopt unless a takeover is being prepared.
+     */
+    std::optional<std::unordered_set<InodeNumber>> takeoverChangedInodes_;
+
+    /**
+     * The unloaded inodes received from the previous process by
+     * initializeFromTakeover() that have not been moved into unloadedInodes_
+     * yet. Every unloaded inode is in exactly one of the two.
+     *
+     * takeoverInodeIndex_ holds the inode number and takeoverInodes_ index of
+     * every entry, sorted by inode number, and takeoverInodeMaterialized_
+     * which of them were already moved. All three are released once
+     * numTakeoverInodes_, the number of entries left to move, drops to 0.
+     */
+    std::vector<SerializedInodeMapEntry> takeoverInodes_;
+    std::vector<std::pair<uint64_t, size_t>> takeoverInodeIndex_;
+    std::vector<bool> takeoverInodeMaterialized_;
+    size_t numTakeoverInodes_{0};
+  };
+
+  struct MembersLockName {
+    static const char* name() {
+      return "inode_map";
+    }
   };
+  using SynchronizedMembers = folly::Synchronized<
+      Members,
+      InstrumentedMutex<folly::SharedMutex, MembersLockName>>;
 
   InodeMap(InodeMap const&) = delete;
   InodeMap& operator=(InodeMap const&) = delete;
 
-  void shutdownComplete(folly::Synchronized<Members>::LockedPtr&& data);
+  void shutdownComplete(SynchronizedMembers::LockedPtr&& data);
+
+  static SerializedInodeMapEntry serializeUnloadedInode(
+      InodeNumber number,
+      const UnloadedInode& entry);
+
+  /**
+   * Returns the takeoverInodes_ index of the given inode if it is one of the
+   * unloaded inodes received during takeover that was not materialized yet.
+   */
+  static std::optional<size_t> findTakeoverInode(
+      const Members& data,
+      InodeNumber number);
+
+  /**
+   * Move the given inode from takeoverInodes_ into unloadedInodes_ if it is
+   * there. This must be called before using the unloadedInodes_ entry of an
+   * inode.
+   */
+  static void materializeTakeoverInode(Members& data, InodeNumber number);
+
+  /**
+   * Move every entry of takeoverInodes_ into unloadedInodes_, for the callers
+   * that walk all of unloadedInodes_.
+   */
+  static void materializeAllTakeoverInodes(Members& data);
+
+  /**
+   * Returns true if the given inode is unloaded but remembered, whether or not
+   * it was materialized.
+   */
+  static bool isUnloadedInodeRemembered(
+      const Members& data,
+      InodeNumber number);
+
+  /**
+   * Record that the unloadedInodes_ entry for the given inode number is about
+   * to be inserted, modified or erased, if a takeover is being prepared.
+   */
+  static void noteUnloadedInodeChanged(Members& data, InodeNumber number) {
+    if (data.takeoverChangedInodes_.has_value()) {
+      data.takeoverChangedInodes_->insert(number);
+    }
+  }
 
   void setupParentLookupPromise(
       folly::Promise<InodePtr>& promise,
@@ -585,9 +718,16 @@ class InodeMap {
    */
   PromiseVector extractPendingPromises(InodeNumber number);
 
+  bool shouldLoadChildLocked(
+      Members& data,
+      InodeNumber parentNumber,
+      PathComponentPiece name,
+      InodeNumber childInode,
+      folly::Promise<InodePtr> promise);
+
   std::optional<RelativePath> getPathForInodeHelper(
       InodeNumber inodeNumber,
-      const folly::Synchronized<Members>::RLockedPtr& data);
+      const SynchronizedMembers::RLockedPtr& data);
 
   /**
    * Unload an inode
@@ -603,7 +743,7 @@ class InodeMap {
       TreeInode* parent,
       PathComponentPiece name,
       bool isUnlinked,
-      const folly::Synchronized<Members>::LockedPtr& lock);
+      const SynchronizedMembers::LockedPtr& lock);
 
   /**
    * Update the overlay data for an inode before unloading it.
@@ -617,17 +757,17 @@ class InodeMap {
       TreeInode* parent,
       PathComponentPiece name,
       bool isUnlinked,
-      const folly::Synchronized<Members>::LockedPtr& lock);
+      const SynchronizedMembers::LockedPtr& lock);
 
   void insertLoadedInode(
-      const folly::Synchronized<Members>::LockedPtr& data,
+      const SynchronizedMembers::LockedPtr& data,
       InodeBase* inode);
 
   /**
    * Verify the InodeMap precondition and initialize the root_ member.
    */
   void initializeRoot(
-      const folly::Synchronized<Members>::LockedPtr& data,
+      const SynchronizedMembers::LockedPtr& data,
       TreeInodePtr root);
 
   /**
@@ -641,7 +781,7 @@ class InodeMap {
    */
   template <class... Args>
   void initializeUnloadedInode(
-      const folly::Synchronized<Members>::LockedPtr& data,
+      const SynchronizedMembers::LockedPtr& data,
       InodeNumber parentIno,
       InodeNumber ino,
       Args&&... args);
@@ -654,7 +794,7 @@ class InodeMap {
    * WARNING: The returned inodePtr must be destroyed OUTSIDE of the data lock!
    */
   InodePtr decFsRefcountHelper(
-      folly::Synchronized<Members>::LockedPtr& data,
+      SynchronizedMembers::LockedPtr& data,
       InodeNumber number,
       uint32_t count = 0,
       bool clearRefCount = false);
@@ -684,7 +824,16 @@ class InodeMap {
    * internal lock.  (This makes it safe for InodeBase to perform operations on
    * the InodeMap while holding their own lock.)
    */
-  folly::Synchronized<Members> data_;
+  SynchronizedMembers data_;
+
+  /**
+   * The unloaded inodes serialized by prepareTakeover().
+   *
+   * This is only accessed by prepareTakeover() and by shutdown(), which the
+   * takeover sequence runs one after the other, and so is not locked.
+   * Entries for the inodes in takeoverChangedInodes_ are stale.
+   */
+  std::vector<SerializedInodeMapEntry> takeoverSnapshot_;
 
   /**
    * This boolean controls EdenFS's response to receiving a request for an
@@ -712,6 +861,14 @@ class InodeMap {
    * This number will only increase for the life time of this inode map.
    */
   std::atomic<size_t> numPeriodicallyUnloadedLinkedInodes_{0};
+
+  /**
+   * The number of inodes that we have unloaded to bring the memory used by
+   * loaded inodes back under budget.
+   *
+   * This number will only increase for the life time of this inode map.
+   */
+  std::atomic<size_t> numMemoryPressureUnloadedInodes_{0};
 };
 
 /**
@@ -723,8 +880,7 @@ class InodeMap {
  */
 class InodeMapLock {
  public:
-  explicit InodeMapLock(
-      folly::Synchronized<InodeMap::Members>::LockedPtr&& data)
+  explicit InodeMapLock(InodeMap::SynchronizedMembers::LockedPtr&& data)
       : data_(std::move(data)) {}
 
   void unlock() {
@@ -733,7 +889,7 @@ class InodeMapLock {
 
  private:
   friend class InodeMap;
-  folly::Synchronized<InodeMap::Members>::LockedPtr data_;
+  InodeMap::SynchronizedMembers::LockedPtr data_;
 };
 } // namespace eden
 } // namespace facebook
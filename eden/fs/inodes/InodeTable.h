@@ -7,7 +7,11 @@
 
 #pragma once
 
+#include <folly/Range.h>
+#include <array>
+#include <memory>
 #include <optional>
+#include <vector>
 #include "eden/fs/inodes/InodeMetadata.h"
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/utils/Bug.h"
@@ -40,6 +44,105 @@ struct InodeTableEntry {
   // corrupted entries?
   Record record;
 };
+
+/**
+ * Maps inode numbers to the index of their record in the storage.
+ *
+ * Inode numbers are allocated sequentially, so instead of hashing them, the
+ * high bits of an inode number select a chunk of slots, and the low bits a
+ * slot within it. Chunks are allocated when the first of their inodes is
+ * inserted and freed once all of them are erased. A lookup is thus two
+ * dependent loads, and an entry costs 8 bytes instead of a hash table node.
+ */
+class InodeTableIndex {
+ public:
+  std::optional<size_t> find(InodeNumber ino) const {
+    auto* chunk = getChunk(ino);
+    if (!chunk) {
+      return std::nullopt;
+    }
+    auto slot = chunk->slots[ino.get() & kChunkMask];
+    if (slot == 0) {
+      return std::nullopt;
+    }
+    return slot - 1;
+  }
+
+  /**
+   * Inode numbers are allocated sequentially, larger ones can only come from
+   * a corrupted table and would make the chunk array absurdly large.
+   */
+  static constexpr uint64_t kMaxInodeNumber = uint64_t{1} << 40;
+
+  /**
+   * Returns false, leaving the index unchanged, if ino is already present.
+   */
+  bool insert(InodeNumber ino, size_t index) {
+    XCHECK_LT(ino.get(), kMaxInodeNumber);
+    auto chunkIndex = ino.get() >> kChunkBits;
+    if (chunkIndex >= chunks_.size()) {
+      chunks_.resize(chunkIndex + 1);
+    }
+    auto& chunk = chunks_[chunkIndex];
+    if (!chunk) {
+      chunk = std::make_unique<Chunk>();
+    }
+    auto& slot = chunk->slots[ino.get() & kChunkMask];
+    if (slot != 0) {
+      return false;
+    }
+    slot = index + 1;
+    chunk->count++;
+    return true;
+  }
+
+  /**
+   * Change the index of an inode that is present.
+   */
+  void update(InodeNumber ino, size_t index) {
+    auto* chunk = getChunk(ino);
+    XCHECK(chunk);
+    auto& slot = chunk->slots[ino.get() & kChunkMask];
+    XCHECK_NE(0u, slot);
+    slot = index + 1;
+  }
+
+  void erase(InodeNumber ino) {
+    auto chunkIndex = ino.get() >> kChunkBits;
+    auto* chunk = getChunk(ino);
+    if (!chunk) {
+      return;
+    }
+    auto& slot = chunk->slots[ino.get() & kChunkMask];
+    if (slot == 0) {
+      return;
+    }
+    slot = 0;
+    if (--chunk->count == 0) {
+      chunks_[chunkIndex].reset();
+    }
+  }
+
+ private:
+  static constexpr size_t kChunkBits = 12;
+  static constexpr uint64_t kChunkMask = (uint64_t{1} << kChunkBits) - 1;
+
+  struct Chunk {
+    // Index of the record plus one, 0 when the inode isn't present.
+    std::array<uint64_t, size_t{1} << kChunkBits> slots{};
+    size_t count{0};
+  };
+
+  Chunk* getChunk(InodeNumber ino) const {
+    auto chunkIndex = ino.get() >> kChunkBits;
+    if (chunkIndex >= chunks_.size()) {
+      return nullptr;
+    }
+    return chunks_[chunkIndex].get();
+  }
+
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+};
 } // namespace detail
 
 /**
@@ -59,6 +162,8 @@ struct InodeTableEntry {
  * The storage remains dense - rather than using a free list, upon removal of an
  * entry, the last entry is moved to the removed entry's index.
  *
+ * The index from inode number to record index is a detail::InodeTableIndex.
+ *
  * The locking strategy is as follows:
  *
  * The index from inode number to record index is wrapped in a SharedMutex.
@@ -155,13 +260,12 @@ class InodeTable {
    */
   std::optional<Record> getOptional(InodeNumber ino) {
     return state_.withRLock([&](const auto& state) -> std::optional<Record> {
-      auto iter = state.indices.find(ino);
-      if (iter == state.indices.end()) {
+      auto index = state.indices.find(ino);
+      if (!index) {
         return std::nullopt;
       } else {
-        auto index = iter->second;
-        XCHECK_LT(index, state.storage.size());
-        return state.storage[index].record;
+        XCHECK_LT(*index, state.storage.size());
+        return state.storage[*index].record;
       }
     });
   }
@@ -176,48 +280,54 @@ class InodeTable {
   template <typename ModFn>
   Record modifyOrThrow(InodeNumber ino, ModFn&& fn) {
     return state_.withRLock([&](auto& state) {
-      auto iter = state.indices.find(ino);
-      if (iter == state.indices.end()) {
+      auto index = state.indices.find(ino);
+      if (!index) {
         throw std::out_of_range(
             folly::to<std::string>("no entry in InodeTable for inode ", ino));
       }
-      auto index = iter->second;
-      XCHECK_LT(index, state.storage.size());
-      fn(state.storage[index].record);
+      XCHECK_LT(*index, state.storage.size());
+      fn(state.storage[*index].record);
       // TODO: maybe trigger a background msync
-      return state.storage[index].record;
+      return state.storage[*index].record;
     });
   }
 
-  // TODO: replace with freeInodes - it's much more efficient to free a bunch
-  // at once.
   void freeInode(InodeNumber ino) {
+    freeInodes(folly::Range<const InodeNumber*>{&ino, 1});
+  }
+
+  /**
+   * Free the entries of all the given inodes, taking the lock only once.
+   */
+  void freeInodes(folly::Range<const InodeNumber*> inodes) {
     state_.withWLock([&](auto& state) {
       auto& storage = state.storage;
       auto& indices = state.indices;
 
-      auto iter = indices.find(ino);
-      if (iter == indices.end()) {
-        // While transitioning metadata from the overlay to the
-        // InodeMetadataTable, it is common for there to be no metadata for an
-        // inode whose number is known. The Overlay calls freeInode()
-        // unconditionally, so simply do nothing.
-        return;
-      }
+      for (auto ino : inodes) {
+        auto index = indices.find(ino);
+        if (!index) {
+          // While transitioning metadata from the overlay to the
+          // InodeMetadataTable, it is common for there to be no metadata for
+          // an inode whose number is known. The Overlay calls freeInode()
+          // unconditionally, so simply do nothing.
+          continue;
+        }
 
-      size_t indexToDelete = iter->second;
-      indices.erase(iter);
+        size_t indexToDelete = *index;
+        indices.erase(ino);
 
-      XDCHECK_GT(storage.size(), 0ul);
-      size_t lastIndex = storage.size() - 1;
+        XDCHECK_GT(storage.size(), 0ul);
+        size_t lastIndex = storage.size() - 1;
 
-      if (lastIndex != indexToDelete) {
-        auto lastInode = storage[lastIndex].inode;
-        storage[indexToDelete] = storage[lastIndex];
-        indices[lastInode] = indexToDelete;
-      }
+        if (lastIndex != indexToDelete) {
+          auto lastInode = storage[lastIndex].inode;
+          storage[indexToDelete] = storage[lastIndex];
+          indices.update(lastInode, indexToDelete);
+        }
 
-      storage.pop_back();
+        storage.pop_back();
+      }
     });
   }
 
@@ -230,11 +340,14 @@ class InodeTable {
   template <typename ModifyFn>
   void forEachModify(ModifyFn&& fn) {
     auto state = state_.wlock();
-    for (auto& entry : state->indices) {
-      const auto& inode = entry.first;
-      auto index = entry.second;
-      auto& record = state->storage[index].record;
-      fn(inode, record);
+    for (size_t i = 0; i < state->storage.size(); ++i) {
+      auto& entry = state->storage[i];
+      // Skip the zeroed and duplicate records that were not indexed on load.
+      if (state->indices.find(entry.inode) != i) {
+        continue;
+      }
+      const auto& inode = entry.inode;
+      fn(inode, entry.record);
     }
   }
 
@@ -271,10 +384,9 @@ class InodeTable {
     // modify immediately.
     {
       auto state = state_.rlock();
-      auto iter = state->indices.find(ino);
-      if (LIKELY(iter != state->indices.end())) {
-        auto index = iter->second;
-        return modify(state->storage[index].record);
+      auto index = state->indices.find(ino);
+      if (LIKELY(index.has_value())) {
+        return modify(state->storage[*index].record);
       }
     }
 
@@ -284,15 +396,13 @@ class InodeTable {
 
     auto state = state_.wlock();
     // Check again - something may have raced between the locks.
-    auto iter = state->indices.find(ino);
-    if (UNLIKELY(iter != state->indices.end())) {
-      auto index = iter->second;
-      return modify(state->storage[index].record);
+    if (auto index = state->indices.find(ino); UNLIKELY(index.has_value())) {
+      return modify(state->storage[*index].record);
     }
 
     size_t index = state->storage.size();
     state->storage.emplace_back(ino, record);
-    state->indices.emplace(ino, index);
+    state->indices.insert(ino, index);
     return result(state->storage[index].record);
   }
 
@@ -305,10 +415,14 @@ class InodeTable {
           // zeroes. Don't pretend this entry is valid.
           continue;
         }
-        auto ret = indices.insert({entry.inode, i});
-        if (!ret.second) {
+        if (entry.inode.get() >= detail::InodeTableIndex::kMaxInodeNumber) {
+          XLOG(WARNING) << "Ignoring record for corrupted inode number "
+                        << entry.inode << " at index " << i;
+          continue;
+        }
+        if (!indices.insert(entry.inode, i)) {
           XLOG(WARNING) << "Duplicate records for the same inode: indices "
-                        << indices[entry.inode] << " and " << i;
+                        << *indices.find(entry.inode) << " and " << i;
           continue;
         }
       }
@@ -326,7 +440,7 @@ class InodeTable {
     mutable MappedDiskVector<Entry> storage;
 
     /// Maintains an index from inode number to index in storage_.
-    std::unordered_map<InodeNumber, size_t> indices;
+    detail::InodeTableIndex indices;
   };
 
   folly::Synchronized<State> state_;
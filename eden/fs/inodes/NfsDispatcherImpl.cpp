@@ -18,10 +18,65 @@
 
 namespace facebook::eden {
 
+namespace {
+/**
+ * Fill list with the entries of inode after offset, slicing the snapshot
+ * named by cookieverf when it is still current. Returns the list, whether it
+ * reached the end of the directory, and the cookie verifier for the next
+ * page.
+ *
+ * A verifier that is unknown, or whose directory was modified since, isn't
+ * an error: cookies are inode numbers, so the continuation is served from a
+ * fresh listing instead.
+ */
+template <typename List, typename LiveFn>
+std::tuple<List, bool, uint64_t> readdirFromSnapshot(
+    NfsReaddirSnapshotCache& snapshots,
+    const TreeInodePtr& inode,
+    List list,
+    off_t offset,
+    uint64_t cookieverf,
+    ObjectFetchContext& context,
+    LiveFn&& live) {
+  auto addTo = [&list](folly::StringPiece name, InodeNumber ino, uint64_t off) {
+    return list.add(name, ino, off);
+  };
+
+  if (auto snapshot = snapshots.get(cookieverf, inode->getNodeId())) {
+    if (snapshot->version == inode->getEntriesVersion()) {
+      bool isEof = snapshot->addEntries(offset, addTo);
+      if (isEof) {
+        snapshots.erase(cookieverf);
+        cookieverf = 0;
+      }
+      return {std::move(list), isEof, cookieverf};
+    }
+    snapshots.erase(cookieverf);
+  }
+
+  if (offset == 0 || !snapshots.isEnabled()) {
+    // Most directories fit in a single reply, only snapshot the others.
+    auto [entries, isEof] = live(std::move(list), offset);
+    uint64_t verifier = 0;
+    if (!isEof && snapshots.isEnabled()) {
+      verifier = snapshots.insert(inode->nfsReaddirSnapshot(context));
+    }
+    return {std::move(entries), isEof, verifier};
+  }
+
+  auto snapshot = inode->nfsReaddirSnapshot(context);
+  bool isEof = snapshot->addEntries(offset, addTo);
+  uint64_t verifier = isEof ? 0 : snapshots.insert(std::move(snapshot));
+  return {std::move(list), isEof, verifier};
+}
+} // namespace
+
 NfsDispatcherImpl::NfsDispatcherImpl(EdenMount* mount)
     : NfsDispatcher(mount->getStats(), mount->getClock()),
       mount_(mount),
-      inodeMap_(mount_->getInodeMap()) {}
+      inodeMap_(mount_->getInodeMap()),
+      readdirSnapshots_(
+          mount->getEdenConfig()->nfsReaddirSnapshotCacheSize.getValue()) {}
 
 ImmediateFuture<struct stat> NfsDispatcherImpl::getattr(
     InodeNumber ino,
@@ -90,11 +145,10 @@ ImmediateFuture<NfsDispatcher::ReadRes> NfsDispatcherImpl::read(
   return inodeMap_->lookupFileInode(ino).thenValue(
       [&context, size, offset](const FileInodePtr& inode) {
         return inode->read(size, offset, context)
-            .thenValue(
-                [](std::tuple<std::unique_ptr<folly::IOBuf>, bool>&& res) {
-                  auto [data, isEof] = std::move(res);
-                  return ReadRes{std::move(data), isEof};
-                })
+            .thenValue([](std::tuple<BufVec, bool>&& res) {
+              auto [data, isEof] = std::move(res);
+              return ReadRes{std::move(data).toIOBuf(), isEof};
+            })
             .semi();
       });
 }
@@ -278,13 +332,89 @@ ImmediateFuture<NfsDispatcher::RenameRes> NfsDispatcherImpl::rename(
 ImmediateFuture<NfsDispatcher::ReaddirRes> NfsDispatcherImpl::readdir(
     InodeNumber dir,
     off_t offset,
+    uint64_t cookieverf,
     uint32_t count,
     ObjectFetchContext& context) {
   return inodeMap_->lookupTreeInode(dir).thenValue(
-      [&context, offset, count](const TreeInodePtr& inode) {
-        auto [dirList, isEof] =
-            inode->nfsReaddir(NfsDirList{count}, offset, context);
-        return ReaddirRes{std::move(dirList), isEof};
+      [this, &context, offset, cookieverf, count](const TreeInodePtr& inode) {
+        auto [dirList, isEof, verifier] = readdirFromSnapshot(
+            readdirSnapshots_,
+            inode,
+            NfsDirList{count},
+            offset,
+            cookieverf,
+            context,
+            [&](NfsDirList&& list, off_t off) {
+              return inode->nfsReaddir(std::move(list), off, context);
+            });
+        return ReaddirRes{std::move(dirList), isEof, verifier};
+      });
+}
+
+ImmediateFuture<NfsDispatcher::ReaddirPlusRes> NfsDispatcherImpl::readdirplus(
+    InodeNumber dir,
+    off_t offset,
+    uint64_t cookieverf,
+    uint32_t dircount,
+    uint32_t maxcount,
+    ObjectFetchContext& context) {
+  return inodeMap_->lookupTreeInode(dir).thenValue(
+      [this, &context, offset, cookieverf, dircount, maxcount](
+          const TreeInodePtr& inode) {
+        auto [dirList, isEof, verifier] = readdirFromSnapshot(
+            readdirSnapshots_,
+            inode,
+            NfsDirPlusList{dircount, maxcount},
+            offset,
+            cookieverf,
+            context,
+            [&](NfsDirPlusList&& list, off_t off) {
+              return inode->nfsReaddirPlus(std::move(list), off, context);
+            });
+
+        // "." and ".." always come first and are not children of the
+        // directory, so they are stat'ed on their own.
+        std::vector<ImmediateFuture<struct stat>> dotStats;
+        std::vector<PathComponentPiece> names;
+        for (const auto& entry : dirList.getEntries()) {
+          if (entry.name == ".") {
+            dotStats.push_back(inode->stat(context));
+          } else if (entry.name == "..") {
+            auto parent = inode->getParentRacy();
+            dotStats.push_back((parent ? parent : inode)->stat(context));
+          } else {
+            names.emplace_back(entry.name);
+          }
+        }
+
+        auto childStats = inode->statChildren(names, context);
+        return collectAllSafe(
+                   collectAll(std::move(dotStats)), std::move(childStats))
+            .thenValue([dirList = std::move(dirList),
+                        isEof = isEof,
+                        verifier = verifier](auto&& stats) mutable {
+              auto& [attributes, childAttributes] = stats;
+              attributes.insert(
+                  attributes.end(),
+                  std::make_move_iterator(childAttributes.begin()),
+                  std::make_move_iterator(childAttributes.end()));
+              return ReaddirPlusRes{
+                  std::move(dirList), std::move(attributes), isEof, verifier};
+            });
+      });
+}
+
+ImmediateFuture<NfsDispatcher::CommitRes> NfsDispatcherImpl::commit(
+    InodeNumber ino,
+    ObjectFetchContext& context) {
+  return inodeMap_->lookupFileInode(ino).thenValue(
+      [&context](const FileInodePtr& inode) {
+        // Only the data needs to be stable, the COMMIT3resok doesn't promise
+        // anything about the metadata.
+        inode->fsync(/*datasync=*/true);
+        return inode->stat(context).thenValue([](struct stat st) {
+          return CommitRes{std::nullopt, st};
+        });
       });
 }
 
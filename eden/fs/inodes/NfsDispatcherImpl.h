@@ -9,6 +9,7 @@
 
 #ifndef _WIN32
 
+#include "eden/fs/inodes/NfsReaddirSnapshotCache.h"
 #include "eden/fs/nfs/NfsDispatcher.h"
 
 namespace facebook::eden {
@@ -98,9 +99,22 @@ class NfsDispatcherImpl : public NfsDispatcher {
   ImmediateFuture<NfsDispatcher::ReaddirRes> readdir(
       InodeNumber dir,
       off_t offset,
+      uint64_t cookieverf,
       uint32_t count,
       ObjectFetchContext& context) override;
 
+  ImmediateFuture<NfsDispatcher::ReaddirPlusRes> readdirplus(
+      InodeNumber dir,
+      off_t offset,
+      uint64_t cookieverf,
+      uint32_t dircount,
+      uint32_t maxcount,
+      ObjectFetchContext& context) override;
+
+  ImmediateFuture<NfsDispatcher::CommitRes> commit(
+      InodeNumber ino,
+      ObjectFetchContext& context) override;
+
   ImmediateFuture<struct statfs> statfs(
       InodeNumber ino,
       ObjectFetchContext& context) override;
@@ -109,6 +123,8 @@ class NfsDispatcherImpl : public NfsDispatcher {
   // The EdenMount associated with this dispatcher.
   EdenMount* const mount_;
   InodeMap* const inodeMap_;
+  // The listings of the directories being paged through by READDIR.
+  NfsReaddirSnapshotCache readdirSnapshots_;
 };
 } // namespace facebook::eden
 
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/NfsReaddirSnapshotCache.h"
+
+#include "eden/fs/utils/IDGen.h"
+
+namespace facebook::eden {
+
+size_t NfsReaddirSnapshot::getSizeBytes() const {
+  size_t bytes = sizeof(*this) + entries.capacity() * sizeof(Entry);
+  for (const auto& entry : entries) {
+    // Short names are stored inline in the std::string.
+    if (entry.name.capacity() >= sizeof(std::string)) {
+      bytes += entry.name.capacity() + 1;
+    }
+  }
+  return bytes;
+}
+
+NfsReaddirSnapshotCache::NfsReaddirSnapshotCache(size_t maxBytes)
+    : maxBytes_{maxBytes} {}
+
+std::shared_ptr<const NfsReaddirSnapshot> NfsReaddirSnapshotCache::get(
+    uint64_t verifier,
+    InodeNumber dir) {
+  if (verifier == 0) {
+    return nullptr;
+  }
+  auto state = state_.wlock();
+  auto it = state->snapshots.find(verifier);
+  if (it == state->snapshots.end() || it->second->dir != dir) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+uint64_t NfsReaddirSnapshotCache::insert(
+    std::shared_ptr<const NfsReaddirSnapshot> snapshot) {
+  auto bytes = snapshot->getSizeBytes();
+  if (bytes > maxBytes_) {
+    return 0;
+  }
+  auto verifier = generateUniqueID();
+
+  auto state = state_.wlock();
+  while (state->totalBytes + bytes > maxBytes_) {
+    eraseLocked(*state, state->snapshots.rbegin()->first);
+  }
+  state->snapshots.set(verifier, std::move(snapshot));
+  state->totalBytes += bytes;
+  return verifier;
+}
+
+void NfsReaddirSnapshotCache::erase(uint64_t verifier) {
+  eraseLocked(*state_.wlock(), verifier);
+}
+
+size_t NfsReaddirSnapshotCache::getTotalBytes() const {
+  return state_.rlock()->totalBytes;
+}
+
+void NfsReaddirSnapshotCache::eraseLocked(State& state, uint64_t verifier) {
+  auto it = state.snapshots.findWithoutPromotion(verifier);
+  if (it == state.snapshots.end()) {
+    return;
+  }
+  state.totalBytes -= it->second->getSizeBytes();
+  state.snapshots.erase(verifier);
+}
+
+} // namespace facebook::eden
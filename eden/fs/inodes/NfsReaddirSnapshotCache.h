@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eden/fs/inodes/InodeNumber.h"
+
+namespace facebook::eden {
+
+/**
+ * The whole listing of a directory, as NFS READDIR pages through it.
+ */
+struct NfsReaddirSnapshot {
+  struct Entry {
+    std::string name;
+    InodeNumber ino;
+    /** The READDIR cookie of the entry: continuations start after it. */
+    uint64_t cookie;
+  };
+
+  InodeNumber dir;
+  /**
+   * The TreeInode::getEntriesVersion() the listing was taken at. The
+   * snapshot is stale once the directory's version differs.
+   */
+  uint64_t version{0};
+  /** Sorted by cookie, starting with "." and "..". */
+  std::vector<Entry> entries;
+
+  /**
+   * Calls add(name, ino, cookie) on the entries after cookie, in order,
+   * until it returns false. Returns true if it was called on every entry.
+   */
+  template <typename Fn>
+  bool addEntries(uint64_t cookie, Fn&& add) const;
+
+  /** An estimate of the memory held by the snapshot. */
+  size_t getSizeBytes() const;
+};
+
+/**
+ * Remembers the listings of the directories that NFS clients are paging
+ * through with READDIR or READDIRPLUS.
+ *
+ * Without them, each continuation lists the directory again to find the
+ * entries after its cookie, which costs O(n^2) over a large directory read
+ * a page at a time. Once a listing doesn't fit in a single reply, its
+ * snapshot is cached and its id is returned to the client as the cookie
+ * verifier, which the client sends back with each continuation. These then
+ * only slice the snapshot.
+ *
+ * Snapshots are dropped once their directory is modified, which its entries
+ * version tells. Cookies are inode numbers, which stay valid, so a client
+ * whose snapshot is gone simply continues from a fresh listing.
+ *
+ * The cache is bounded by the estimated memory of its snapshots; the least
+ * recently used ones are evicted first.
+ *
+ * This class is thread safe.
+ */
+class NfsReaddirSnapshotCache {
+ public:
+  /**
+   * A cache holding at most maxBytes worth of snapshots. A maxBytes of 0
+   * disables the cache.
+   */
+  explicit NfsReaddirSnapshotCache(size_t maxBytes);
+
+  NfsReaddirSnapshotCache(const NfsReaddirSnapshotCache&) = delete;
+  NfsReaddirSnapshotCache& operator=(const NfsReaddirSnapshotCache&) = delete;
+
+  /**
+   * Returns the snapshot of dir with the given verifier, or nullptr if there
+   * is none.
+   */
+  std::shared_ptr<const NfsReaddirSnapshot> get(
+      uint64_t verifier,
+      InodeNumber dir);
+
+  /**
+   * Cache the snapshot and return its verifier, which is never 0. Returns 0
+   * if the snapshot is larger than the whole cache and was not cached.
+   */
+  uint64_t insert(std::shared_ptr<const NfsReaddirSnapshot> snapshot);
+
+  void erase(uint64_t verifier);
+
+  size_t getTotalBytes() const;
+
+  bool isEnabled() const {
+    return maxBytes_ != 0;
+  }
+
+ private:
+  struct State {
+    State() : snapshots{0} {}
+
+    using SnapshotPtr = std::shared_ptr<const NfsReaddirSnapshot>;
+    folly::EvictingCacheMap<uint64_t, SnapshotPtr> snapshots;
+    size_t totalBytes{0};
+  };
+
+  static void eraseLocked(State& state, uint64_t verifier);
+
+  const size_t maxBytes_;
+  folly::Synchronized<State> state_;
+};
+
+template <typename Fn>
+bool NfsReaddirSnapshot::addEntries(uint64_t cookie, Fn&& add) const {
+  auto it = std::upper_bound(
+      entries.begin(),
+      entries.end(),
+      cookie,
+      [](uint64_t c, const Entry& entry) { return c < entry.cookie; });
+  for (; it != entries.end(); ++it) {
+    if (!add(it->name, it->ino, it->cookie)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace facebook::eden
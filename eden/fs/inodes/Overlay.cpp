@@ -41,16 +41,32 @@ constexpr uint64_t ioClosedMask = 1ull << 63;
 
 std::unique_ptr<IOverlay> makeOverlay(
     AbsolutePathPiece localDir,
-    Overlay::OverlayType overlayType) {
+    Overlay::OverlayType overlayType,
+    TreeOverlay::WriteBatching treeOverlayBatching) {
+  if (overlayType != Overlay::OverlayType::TreeCheckpointed) {
+    treeOverlayBatching.checkpointInterval = std::chrono::milliseconds{0};
+  }
   if (overlayType == Overlay::OverlayType::Tree) {
-    return std::make_unique<TreeOverlay>(localDir);
+    return std::make_unique<TreeOverlay>(
+        localDir,
+        TreeOverlayStore::SynchronousMode::Normal,
+        treeOverlayBatching);
   } else if (overlayType == Overlay::OverlayType::TreeInMemory) {
     XLOG(WARN) << "In-memory overlay requested. This will cause data loss.";
     return std::make_unique<TreeOverlay>(
-        std::make_unique<SqliteDatabase>(SqliteDatabase::inMemory));
+        std::make_unique<SqliteDatabase>(SqliteDatabase::inMemory),
+        treeOverlayBatching);
   } else if (overlayType == Overlay::OverlayType::TreeSynchronousOff) {
     return std::make_unique<TreeOverlay>(
-        localDir, TreeOverlayStore::SynchronousMode::Off);
+        localDir, TreeOverlayStore::SynchronousMode::Off, treeOverlayBatching);
+  } else if (overlayType == Overlay::OverlayType::TreeCheckpointed) {
+    XLOG(INFO) << "Checkpointed overlay requested. Changes made in the last "
+               << treeOverlayBatching.checkpointInterval.count()
+               << "ms are lost if EdenFS crashes.";
+    return std::make_unique<TreeOverlay>(
+        localDir,
+        TreeOverlayStore::SynchronousMode::Normal,
+        treeOverlayBatching);
   }
 #ifdef _WIN32
   return std::make_unique<SqliteOverlay>(localDir);
@@ -67,28 +83,46 @@ std::shared_ptr<Overlay> Overlay::create(
     AbsolutePathPiece localDir,
     CaseSensitivity caseSensitive,
     OverlayType overlayType,
-    std::shared_ptr<StructuredLogger> logger) {
+    std::shared_ptr<StructuredLogger> logger,
+    TreeOverlay::WriteBatching treeOverlayBatching,
+    size_t gcThreadCount) {
   // This allows us to access the private constructor.
   struct MakeSharedEnabler : public Overlay {
     explicit MakeSharedEnabler(
         AbsolutePathPiece localDir,
         CaseSensitivity caseSensitive,
         OverlayType overlayType,
-        std::shared_ptr<StructuredLogger> logger)
-        : Overlay(localDir, caseSensitive, overlayType, logger) {}
+        std::shared_ptr<StructuredLogger> logger,
+        TreeOverlay::WriteBatching treeOverlayBatching,
+        size_t gcThreadCount)
+        : Overlay(
+              localDir,
+              caseSensitive,
+              overlayType,
+              logger,
+              treeOverlayBatching,
+              gcThreadCount) {}
   };
   return std::make_shared<MakeSharedEnabler>(
-      localDir, caseSensitive, overlayType, logger);
+      localDir,
+      caseSensitive,
+      overlayType,
+      logger,
+      treeOverlayBatching,
+      gcThreadCount);
 }
 
 Overlay::Overlay(
     AbsolutePathPiece localDir,
     CaseSensitivity caseSensitive,
     OverlayType overlayType,
-    std::shared_ptr<StructuredLogger> logger)
-    : backingOverlay_{makeOverlay(localDir, overlayType)},
+    std::shared_ptr<StructuredLogger> logger,
+    TreeOverlay::WriteBatching treeOverlayBatching,
+    size_t gcThreadCount)
+    : backingOverlay_{makeOverlay(localDir, overlayType, treeOverlayBatching)},
       supportsSemanticOperations_{
           backingOverlay_->supportsSemanticOperations()},
+      gcThreadCount_{std::max<size_t>(gcThreadCount, 1)},
       caseSensitive_{caseSensitive},
       structuredLogger_{logger} {}
 
@@ -100,10 +134,15 @@ void Overlay::close() {
   XCHECK_NE(std::this_thread::get_id(), gcThread_.get_id());
 
   gcQueue_.lock()->stop = true;
-  gcCondVar_.notify_one();
+  gcCondVar_.notify_all();
   if (gcThread_.joinable()) {
     gcThread_.join();
   }
+  // gcThread_ started the workers, so they are only known once it is joined.
+  for (auto& worker : gcWorkers_) {
+    worker.join();
+  }
+  gcWorkers_.clear();
 
   // Make sure everything is shut down in reverse of construction order.
   // Cleanup is not necessary if overlay was not initialized
@@ -166,6 +205,9 @@ folly::SemiFuture<Unit> Overlay::initialize(
     }
     promise.setValue();
 
+    for (size_t i = 1; i < gcThreadCount_; ++i) {
+      gcWorkers_.emplace_back([this] { gcThread(); });
+    }
     gcThread();
   });
   return std::move(initFuture);
@@ -191,8 +233,12 @@ void Overlay::initOverlay(
 
     // TODO(zeyi): `OverlayCheck` should be associated with the specific
     // Overlay implementation. `reinterpret_cast` is a temporary workaround.
+    auto* fsOverlay = reinterpret_cast<FsOverlay*>(backingOverlay_.get());
+    // Only the shards that were being modified when edenfs stopped need to be
+    // checked, if the overlay recorded which ones they were.
+    auto dirtyShards = fsOverlay->loadDirtyShards();
     OverlayChecker checker(
-        reinterpret_cast<FsOverlay*>(backingOverlay_.get()), std::nullopt);
+        fsOverlay, std::nullopt, dirtyShards ? &*dirtyShards : nullptr);
     folly::stop_watch<> fsckRuntime;
     checker.scanForErrors(progressCallback);
     auto result = checker.repairErrors();
@@ -210,6 +256,11 @@ void Overlay::initOverlay(
     }
 
     optNextInodeNumber = checker.getNextInodeNumber();
+    // Leave the markers in place if some problems remain, so that they are
+    // looked at again after the next unclean shutdown.
+    if (!result || result->totalErrors == result->fixedErrors) {
+      fsOverlay->clearDirtyShards(*optNextInodeNumber);
+    }
 #else
     // SqliteOverlay will always return the value of next Inode number, if we
     // end up here - it's a bug.
@@ -272,6 +323,7 @@ DirContents Overlay::loadOverlayDir(InodeNumber inodeNumber) {
     return result;
   }
   const auto& dir = dirData.value();
+  result.reserve(dir.entries_ref()->size());
 
   bool shouldMigrateToNewFormat = false;
 
@@ -360,12 +412,37 @@ void Overlay::removeOverlayData(InodeNumber inodeNumber) {
   IORequest req{this};
 
 #ifndef _WIN32
-  // TODO: batch request during GC
   getInodeMetadataTable()->freeInode(inodeNumber);
 #endif // !_WIN32
   backingOverlay_->removeOverlayData(inodeNumber);
 }
 
+size_t Overlay::removeOverlayDataBatch(
+    folly::Range<const InodeNumber*> inodes) {
+  if (inodes.empty()) {
+    return 0;
+  }
+  IORequest req{this};
+
+#ifndef _WIN32
+  try {
+    getInodeMetadataTable()->freeInodes(inodes);
+  } catch (const std::exception& e) {
+    XLOG(ERR) << "Failed to free the metadata of " << inodes.size()
+              << " inodes: " << e.what();
+  }
+#endif // !_WIN32
+  for (auto inodeNumber : inodes) {
+    try {
+      backingOverlay_->removeOverlayData(inodeNumber);
+    } catch (const std::exception& e) {
+      XLOG(ERR) << "Failed to remove overlay data for inode " << inodeNumber
+                << ": " << e.what();
+    }
+  }
+  return inodes.size();
+}
+
 void Overlay::recursivelyRemoveOverlayData(InodeNumber inodeNumber) {
   IORequest req{this};
 
@@ -386,12 +463,27 @@ void Overlay::recursivelyRemoveOverlayData(InodeNumber inodeNumber) {
 folly::Future<folly::Unit> Overlay::flushPendingAsync() {
   folly::Promise<folly::Unit> promise;
   auto future = promise.getFuture();
-  gcQueue_.lock()->queue.emplace_back(std::move(promise));
-  gcCondVar_.notify_one();
+  {
+    auto gcQueue = gcQueue_.lock();
+    if (!gcQueue->queue.empty() || gcQueue->busyThreads > 0) {
+      gcQueue->flushes.push_back(std::move(promise));
+      return future;
+    }
+  }
+  promise.setValue();
   return future;
 }
 #endif // !_WIN32
 
+Overlay::GCStats Overlay::getGCStats() const {
+  auto gcQueue = gcQueue_.lock();
+  GCStats stats;
+  stats.queuedDirectories = gcQueue->queue.size();
+  stats.removedDirectories = gcQueue->removedDirectories;
+  stats.removedFiles = gcQueue->removedFiles;
+  return stats;
+}
+
 bool Overlay::hasOverlayData(InodeNumber inodeNumber) {
   IORequest req{this};
   return backingOverlay_->hasOverlayData(inodeNumber);
@@ -436,6 +528,19 @@ OverlayFile Overlay::createOverlayFile(
       weak_from_this());
 }
 
+std::optional<OverlayFile> Overlay::cloneOverlayFile(
+    InodeNumber inodeNumber,
+    const folly::File& source) {
+  IORequest req{this};
+  XCHECK_LT(inodeNumber.get(), nextInodeNumber_.load(std::memory_order_relaxed))
+      << "cloneOverlayFile called with unallocated inode number";
+  auto file = backingOverlay_->cloneOverlayFile(inodeNumber, source);
+  if (!file) {
+    return std::nullopt;
+  }
+  return OverlayFile(std::move(*file), weak_from_this());
+}
+
 #endif // !_WIN32
 
 InodeNumber Overlay::getMaxInodeNumber() {
@@ -492,99 +597,111 @@ void Overlay::closeAndWaitForOutstandingIO() {
 
 void Overlay::gcThread() noexcept {
   for (;;) {
-    std::vector<GCRequest> requests;
+    GCRequest request;
     {
       auto lock = gcQueue_.lock();
       while (lock->queue.empty()) {
+        // Exiting is fine even if another thread is still busy: that thread
+        // handles whatever its request adds to the queue.
         if (lock->stop) {
           return;
         }
         gcCondVar_.wait(lock.as_lock());
-        continue;
       }
 
-      requests = std::move(lock->queue);
+      request = std::move(lock->queue.front());
+      lock->queue.pop_front();
+      ++lock->busyThreads;
     }
 
-    for (auto& request : requests) {
-      try {
-        handleGCRequest(request);
-      } catch (const std::exception& e) {
-        XLOG(ERR) << "handleGCRequest should never throw, but it did: "
-                  << e.what();
-      }
-    }
-  }
-}
-
-void Overlay::handleGCRequest(GCRequest& request) {
-  IORequest req{this};
-  if (request.flush) {
-    request.flush->setValue();
-    return;
-  }
-
-  // Should only include inode numbers for trees.
-  std::queue<InodeNumber> queue;
-
-  // TODO: For better throughput on large tree collections, it might make
-  // sense to split this into two threads: one for traversing the tree and
-  // another that makes the actual unlink calls.
-  auto safeRemoveOverlayData = [&](InodeNumber inodeNumber) {
+    GCResult result;
     try {
-      removeOverlayData(inodeNumber);
+      result = handleGCRequest(request);
     } catch (const std::exception& e) {
-      XLOG(ERR) << "Failed to remove overlay data for inode " << inodeNumber
-                << ": " << e.what();
+      XLOG(ERR) << "handleGCRequest should never throw, but it did: "
+                << e.what();
     }
-  };
 
-  auto processDir = [&](const overlay::OverlayDir& dir) {
-    for (const auto& entry : *dir.entries_ref()) {
-      const auto& value = entry.second;
-      if (!(*value.inodeNumber_ref())) {
-        // Legacy-only.  All new Overlay trees have inode numbers for all
-        // children.
-        continue;
-      }
-      auto ino = InodeNumber::fromThrift(*value.inodeNumber_ref());
-
-      if (S_ISDIR(*value.mode_ref())) {
-        queue.push(ino);
-      } else {
-        // No need to recurse, but delete any file at this inode.  Note that,
-        // under normal operation, there should be nothing at this path
-        // because files are only written into the overlay if they're
-        // materialized.
-        safeRemoveOverlayData(ino);
+    std::vector<folly::Promise<folly::Unit>> flushes;
+    {
+      auto lock = gcQueue_.lock();
+      --lock->busyThreads;
+      lock->removedDirectories += result.removedDirectories;
+      lock->removedFiles += result.removedFiles;
+      if (lock->queue.empty() && lock->busyThreads == 0) {
+        flushes.swap(lock->flushes);
       }
     }
-  };
-
-  processDir(request.dir);
+    for (auto& flush : flushes) {
+      flush.setValue();
+    }
+  }
+}
 
-  while (!queue.empty()) {
-    auto ino = queue.front();
-    queue.pop();
+Overlay::GCResult Overlay::handleGCRequest(GCRequest& request) {
+  IORequest req{this};
+  GCResult result;
 
-    overlay::OverlayDir dir;
+  if (request.inode) {
+    auto ino = *request.inode;
     try {
       auto dirData = backingOverlay_->loadOverlayDir(ino);
       if (!dirData.has_value()) {
         XLOG(DBG7) << "no dir data for inode " << ino;
-        continue;
-      } else {
-        dir = std::move(*dirData);
+        return result;
       }
+      request.dir = std::move(*dirData);
     } catch (const std::exception& e) {
       XLOG(ERR) << "While collecting, failed to load tree data for inode "
                 << ino << ": " << e.what();
+      return result;
+    }
+    result.removedDirectories += removeOverlayDataBatch({&ino, 1});
+  } else {
+    // The top-level directory was removed by recursivelyRemoveOverlayData.
+    ++result.removedDirectories;
+  }
+
+  std::vector<InodeNumber> files;
+  std::vector<GCRequest> subdirs;
+  for (const auto& entry : *request.dir.entries_ref()) {
+    const auto& value = entry.second;
+    if (!(*value.inodeNumber_ref())) {
+      // Legacy-only.  All new Overlay trees have inode numbers for all
+      // children.
       continue;
     }
+    auto ino = InodeNumber::fromThrift(*value.inodeNumber_ref());
 
-    safeRemoveOverlayData(ino);
-    processDir(dir);
+    if (S_ISDIR(*value.mode_ref())) {
+      subdirs.emplace_back(ino);
+    } else {
+      // No need to recurse, but delete any file at this inode.  Note that,
+      // under normal operation, there should be nothing at this path
+      // because files are only written into the overlay if they're
+      // materialized.
+      files.push_back(ino);
+    }
   }
+
+  // Hand the subdirectories to the other GC threads before removing the
+  // files, so that they don't wait on this directory's unlink calls.
+  if (!subdirs.empty()) {
+    {
+      auto lock = gcQueue_.lock();
+      for (auto& subdir : subdirs) {
+        lock->queue.push_back(std::move(subdir));
+      }
+    }
+    if (subdirs.size() == 1) {
+      gcCondVar_.notify_one();
+    } else {
+      gcCondVar_.notify_all();
+    }
+  }
+
+  result.removedFiles += removeOverlayDataBatch(files);
+  return result;
 }
 
 void Overlay::addChild(
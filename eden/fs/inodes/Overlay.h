@@ -14,12 +14,14 @@
 #include <array>
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <optional>
 #include <thread>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/OverlayChecker.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/inodes/sqliteoverlay/SqliteOverlay.h"
+#include "eden/fs/inodes/treeoverlay/TreeOverlay.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/DirType.h"
@@ -75,6 +77,7 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
     Tree = 1,
     TreeInMemory = 2,
     TreeSynchronousOff = 3,
+    TreeCheckpointed = 4,
   };
 
   /**
@@ -82,12 +85,20 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
    *
    * The caller must call initialize() after creating the Overlay and wait for
    * it to succeed before using any other methods.
+   *
+   * treeOverlayBatching only applies to the tree overlay types, and its
+   * checkpointInterval only to TreeCheckpointed.
+   *
+   * gcThreadCount is the number of threads that remove the data of the trees
+   * passed to recursivelyRemoveOverlayData() in the background.
    */
   static std::shared_ptr<Overlay> create(
       AbsolutePathPiece localDir,
       CaseSensitivity caseSensitive,
       OverlayType overlayType,
-      std::shared_ptr<StructuredLogger> logger);
+      std::shared_ptr<StructuredLogger> logger,
+      TreeOverlay::WriteBatching treeOverlayBatching = {},
+      size_t gcThreadCount = 1);
 
   ~Overlay();
 
@@ -200,6 +211,17 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
    */
   folly::Future<folly::Unit> flushPendingAsync();
 
+  struct GCStats {
+    /** Directories waiting to be removed by the GC threads. */
+    size_t queuedDirectories = 0;
+    /** Directories removed by the GC threads since the overlay was opened. */
+    uint64_t removedDirectories = 0;
+    /** Files removed by the GC threads since the overlay was opened. */
+    uint64_t removedFiles = 0;
+  };
+
+  GCStats getGCStats() const;
+
   bool hasOverlayData(InodeNumber inodeNumber);
 
 #ifndef _WIN32
@@ -229,6 +251,14 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents);
 
+  /**
+   * Creates the overlay file of a new FileInode as a clone of source. Returns
+   * std::nullopt if the backing overlay can't clone it.
+   */
+  std::optional<OverlayFile> cloneOverlayFile(
+      InodeNumber inodeNumber,
+      const folly::File& source);
+
   /**
    * call statfs(2) on the filesystem in which the overlay is located
    */
@@ -258,39 +288,57 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
       AbsolutePathPiece localDir,
       CaseSensitivity caseSensitive,
       OverlayType overlayType,
-      std::shared_ptr<StructuredLogger> logger);
+      std::shared_ptr<StructuredLogger> logger,
+      TreeOverlay::WriteBatching treeOverlayBatching,
+      size_t gcThreadCount);
 
   /**
-   * A request for the background GC thread.  There are two types of requests:
-   * recursively forget data underneath an given directory, or complete a
-   * promise.  The latter is used for synchronization with the GC thread,
-   * primarily in unit tests.
-   *
-   * If additional request types are added in the future, consider renaming to
-   * AsyncRequest.  However, recursive collection of forgotten inode numbers
-   * is the only operation that can be made async while preserving our
+   * A directory for the background GC threads to forget, along with
+   * everything beneath it. Recursive collection of forgotten inode numbers is
+   * the only operation that can be made async while preserving our
    * durability goals.
+   *
+   * The subdirectories of a collected directory are queued as requests of
+   * their own, so that the GC threads remove a large tree in parallel.
    */
   struct GCRequest {
     GCRequest() {}
     explicit GCRequest(overlay::OverlayDir&& d) : dir{std::move(d)} {}
-    explicit GCRequest(folly::Promise<folly::Unit> p) : flush{std::move(p)} {}
+    explicit GCRequest(InodeNumber i) : inode{i} {}
 
+    // Iff set, the directory's data is still in the overlay, and dir is
+    // loaded from there. Otherwise dir was already removed from it.
+    std::optional<InodeNumber> inode;
     overlay::OverlayDir dir;
-    // Iff set, this is a flush request.
-    std::optional<folly::Promise<folly::Unit>> flush;
   };
 
   struct GCQueue {
     bool stop = false;
-    std::vector<GCRequest> queue;
+    std::deque<GCRequest> queue;
+    // The number of GC threads currently handling a request.
+    size_t busyThreads = 0;
+    // Completed once the queue is empty and no thread is busy.
+    std::vector<folly::Promise<folly::Unit>> flushes;
+    uint64_t removedDirectories = 0;
+    uint64_t removedFiles = 0;
+  };
+
+  struct GCResult {
+    uint64_t removedDirectories = 0;
+    uint64_t removedFiles = 0;
   };
 
   void initOverlay(
       std::optional<AbsolutePath> mountPath,
       const OverlayChecker::ProgressCallback& progressCallback = [](auto) {});
   void gcThread() noexcept;
-  void handleGCRequest(GCRequest& request);
+  GCResult handleGCRequest(GCRequest& request);
+
+  /**
+   * Remove the data of many inodes, taking the IO and metadata table locks
+   * only once. Errors are logged. Returns the number of inodes processed.
+   */
+  size_t removeOverlayDataBatch(folly::Range<const InodeNumber*> inodes);
 
   // Serialize EdenFS overlay data structure into Thrift data structure
   overlay::OverlayEntry serializeOverlayEntry(const DirEntry& entry);
@@ -331,10 +379,13 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
 #endif // !_WIN32
 
   /**
-   * Thread which recursively removes entries from the overlay underneath the
-   * trees added to gcQueue_.
+   * Threads which recursively remove entries from the overlay underneath the
+   * trees added to gcQueue_. gcThread_ initializes the overlay first, then
+   * starts the others.
    */
+  const size_t gcThreadCount_;
   std::thread gcThread_;
+  std::vector<std::thread> gcWorkers_;
   folly::Synchronized<GCQueue, std::mutex> gcQueue_;
   std::condition_variable gcCondVar_;
 
@@ -9,7 +9,9 @@
 
 #include "eden/fs/inodes/OverlayFile.h"
 
+#include <fcntl.h>
 #include <folly/FileUtil.h>
+#include <folly/Utility.h>
 
 #include "eden/fs/inodes/Overlay.h"
 
@@ -128,6 +130,38 @@ folly::Expected<int, int> OverlayFile::fallocate(off_t offset, off_t length)
 #endif
 }
 
+folly::Expected<int, int> OverlayFile::readahead(off_t offset, off_t length)
+    const {
+#if defined(__linux__) || defined(__APPLE__)
+  std::shared_ptr<Overlay> overlay = overlay_.lock();
+  if (!overlay) {
+    return folly::makeUnexpected(EIO);
+  }
+  IORequest req{overlay.get()};
+
+#ifdef __linux__
+  // Unlike most calls, posix_fadvise returns the error code.
+  auto ret = ::posix_fadvise(file_.fd(), offset, length, POSIX_FADV_WILLNEED);
+  if (ret != 0) {
+    return folly::makeUnexpected(ret);
+  }
+#else
+  struct radvisory advisory;
+  advisory.ra_offset = offset;
+  advisory.ra_count = folly::to_narrow(length);
+  auto ret = ::fcntl(file_.fd(), F_RDADVISE, &advisory);
+  if (ret == -1) {
+    return folly::makeUnexpected(errno);
+  }
+#endif
+  return folly::makeExpected<int>(ret);
+#else
+  (void)offset;
+  (void)length;
+  return folly::makeUnexpected(ENOSYS);
+#endif
+}
+
 folly::Expected<int, int> OverlayFile::fdatasync() const {
 #ifndef __APPLE__
   std::shared_ptr<Overlay> overlay = overlay_.lock();
@@ -160,6 +194,19 @@ folly::Expected<std::string, int> OverlayFile::readFile() const {
   return folly::makeExpected<int>(std::move(out));
 }
 
+folly::Expected<folly::File, int> OverlayFile::dup() const {
+  std::shared_ptr<Overlay> overlay = overlay_.lock();
+  if (!overlay) {
+    return folly::makeUnexpected(EIO);
+  }
+
+  auto fd = ::fcntl(file_.fd(), F_DUPFD_CLOEXEC, 0);
+  if (fd == -1) {
+    return folly::makeUnexpected(errno);
+  }
+  return folly::File{fd, /*ownsFd=*/true};
+}
+
 } // namespace eden
 } // namespace facebook
 
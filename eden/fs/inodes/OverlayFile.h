@@ -37,9 +37,20 @@ class OverlayFile {
   folly::Expected<int, int> ftruncate(off_t length) const;
   folly::Expected<int, int> fsync() const;
   folly::Expected<int, int> fallocate(off_t offset, off_t length) const;
+  /**
+   * Asks the kernel to start reading the given range of the file into the
+   * page cache, without waiting for it to be read.
+   */
+  folly::Expected<int, int> readahead(off_t offset, off_t length) const;
   folly::Expected<int, int> fdatasync() const;
   folly::Expected<std::string, int> readFile() const;
 
+  /**
+   * Returns a new descriptor for the same open file, for callers that need
+   * the data to outlive this OverlayFile, such as a spliced FUSE read reply.
+   */
+  folly::Expected<folly::File, int> dup() const;
+
  private:
   OverlayFile(const OverlayFile&) = delete;
   OverlayFile& operator=(const OverlayFile&) = delete;
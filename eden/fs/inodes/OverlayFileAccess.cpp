@@ -9,11 +9,18 @@
 
 #include "eden/fs/inodes/OverlayFileAccess.h"
 
+#include <folly/Conv.h>
 #include <folly/Expected.h>
 #include <folly/Range.h>
+#include <folly/String.h>
+#include <folly/Utility.h>
+#include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
 #include <gflags/gflags.h>
 #include <openssl/sha.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
 
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/InodeError.h"
@@ -36,6 +43,22 @@ namespace eden {
 
 DEFINE_uint64(overlayFileCacheSize, 100, "");
 
+namespace {
+/**
+ * Below this size, copying the data is cheaper than the extra syscalls needed
+ * to hand out and splice a file reference.
+ */
+constexpr size_t kMinFileReferenceSize = 32 * 1024;
+
+/**
+ * How far ahead of a sequential reader its file is read into the page cache.
+ * FUSE read requests are at most 128KB, much less than what the kernel reads
+ * ahead of a reader on its own when it can tell that reads are sequential,
+ * but the overlay file is shared by all the readers of the inode.
+ */
+constexpr off_t kReadAheadSize = 2 * 1024 * 1024;
+} // namespace
+
 void OverlayFileAccess::Entry::Info::invalidateMetadata() {
   ++version;
   size = std::nullopt;
@@ -48,8 +71,12 @@ OverlayFileAccess::State::State(size_t cacheSize) : entries{cacheSize} {
   }
 }
 
-OverlayFileAccess::OverlayFileAccess(Overlay* overlay)
-    : overlay_{overlay}, state_{folly::in_place, FLAGS_overlayFileCacheSize} {}
+OverlayFileAccess::OverlayFileAccess(
+    Overlay* overlay,
+    std::unique_ptr<BlobFileStore> blobFiles)
+    : overlay_{overlay},
+      blobFiles_{std::move(blobFiles)},
+      state_{folly::in_place, FLAGS_overlayFileCacheSize} {}
 
 OverlayFileAccess::~OverlayFileAccess() = default;
 
@@ -66,12 +93,35 @@ void OverlayFileAccess::createFile(
     InodeNumber ino,
     const Blob& blob,
     const std::optional<Hash20>& sha1) {
-  auto file = overlay_->createOverlayFile(ino, blob.getContents());
+  std::optional<OverlayFile> clone;
+  if (blobFiles_) {
+    if (auto source = blobFiles_->getFile(blob)) {
+      clone = overlay_->cloneOverlayFile(ino, *source);
+      if (!clone && blobFiles_->isEnabled()) {
+        XLOG(INFO) << "the overlay can't clone blob files, disabling the blob "
+                   << "file store";
+        blobFiles_->disable();
+      }
+    }
+  }
+  auto file = clone ? std::move(*clone)
+                    : overlay_->createOverlayFile(ino, blob.getContents());
+  std::optional<Sha1Record> headerSha1;
+  if (sha1.has_value()) {
+    headerSha1 = Sha1Record{blob.getSize(), *sha1};
+    auto ret = writeHeaderSha1(file, headerSha1);
+    if (ret.hasError()) {
+      XLOG(DBG2) << "unable to store the SHA-1 of overlay file " << ino << ": "
+                 << folly::errnoStr(ret.error());
+    }
+  }
   auto state = state_.wlock();
   XCHECK(!state->entries.exists(ino))
       << "Cannot create overlay file " << ino << " when it's already open!";
   state->entries.set(
-      ino, std::make_shared<Entry>(std::move(file), blob.getSize(), sha1));
+      ino,
+      std::make_shared<Entry>(
+          std::move(file), blob.getSize(), sha1, headerSha1));
 }
 
 off_t OverlayFileAccess::getFileSize(FileInode& inode) {
@@ -124,12 +174,24 @@ off_t OverlayFileAccess::getFileSize(InodeNumber ino, InodeBase* inode) {
 Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
   auto entry = getEntryForInode(inode.getNodeId());
   uint64_t version;
+  std::optional<Sha1Record> headerSha1;
   {
     auto info = entry->info.rlock();
     if (info->sha1.has_value()) {
       return *info->sha1;
     }
     version = info->version;
+    headerSha1 = info->headerSha1;
+  }
+
+  // The header may hold the SHA-1 computed before the file was last closed.
+  if (headerSha1.has_value() &&
+      headerSha1->size == static_cast<uint64_t>(getFileSize(inode))) {
+    auto info = entry->info.wlock();
+    if (version == info->version) {
+      info->sha1 = headerSha1->sha1;
+    }
+    return headerSha1->sha1;
   }
 
   // SHA-1 is not known, so recompute it. Do so while the lock is not held to
@@ -137,7 +199,43 @@ Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
 
   SHA_CTX ctx;
   SHA1_Init(&ctx);
+  auto size = readContents(*entry, inode, "SHA-1", [&](folly::ByteRange buf) {
+    SHA1_Update(&ctx, buf.data(), buf.size());
+  });
+
+  static_assert(Hash20::RAW_SIZE == SHA_DIGEST_LENGTH);
+  Hash20 sha1;
+  SHA1_Final(sha1.mutableBytes().begin(), &ctx);
+
+  // Update the cache if the version still matches. The header is written with
+  // the lock held so that it cannot race with invalidateMetadata.
+  auto info = entry->info.wlock();
+  if (version == info->version) {
+    info->sha1 = sha1;
+    info->headerSha1 = Sha1Record{size, sha1};
+    auto ret = writeHeaderSha1(entry->file, info->headerSha1);
+    if (ret.hasError()) {
+      XLOG(DBG2) << "unable to store the SHA-1 of overlay file "
+                 << inode.getNodeId() << ": " << folly::errnoStr(ret.error());
+    }
+  }
+  return sha1;
+}
 
+Blake3Hash OverlayFileAccess::getBlake3(FileInode& inode) {
+  auto entry = getEntryForInode(inode.getNodeId());
+  Blake3 hasher;
+  readContents(*entry, inode, "BLAKE3", [&](folly::ByteRange buf) {
+    hasher.update(buf);
+  });
+  return hasher.finalize();
+}
+
+uint64_t OverlayFileAccess::readContents(
+    const Entry& entry,
+    FileInode& inode,
+    folly::StringPiece purpose,
+    folly::FunctionRef<void(folly::ByteRange)> consume) {
   off_t off = FsOverlay::kHeaderLength;
   while (true) {
     // Using pread here so that we don't move the file position;
@@ -146,31 +244,22 @@ Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
     // like a good property of this function to avoid changing that
     // state.
     uint8_t buf[8192];
-    auto ret = entry->file.preadNoInt(&buf, sizeof(buf), off);
+    auto ret = entry.file.preadNoInt(&buf, sizeof(buf), off);
     if (ret.hasError()) {
       throw InodeError(
           ret.error(),
           inode.inodePtrFromThis(),
-          "pread failed during SHA-1 calculation");
+          folly::to<std::string>(
+              "pread failed during ", purpose, " calculation"));
     }
     auto len = ret.value();
     if (len == 0) {
       break;
     }
-    SHA1_Update(&ctx, buf, len);
+    consume(folly::ByteRange{buf, static_cast<size_t>(len)});
     off += len;
   }
-
-  static_assert(Hash20::RAW_SIZE == SHA_DIGEST_LENGTH);
-  Hash20 sha1;
-  SHA1_Final(sha1.mutableBytes().begin(), &ctx);
-
-  // Update the cache if the version still matches.
-  auto info = entry->info.wlock();
-  if (version == info->version) {
-    info->sha1 = sha1;
-  }
-  return sha1;
+  return static_cast<uint64_t>(off) - FsOverlay::kHeaderLength;
 }
 
 std::string OverlayFileAccess::readAllContents(FileInode& inode) {
@@ -205,7 +294,30 @@ std::string OverlayFileAccess::readAllContents(FileInode& inode) {
   return result.value();
 }
 
-BufVec OverlayFileAccess::read(FileInode& inode, size_t size, off_t off) {
+BufVec OverlayFileAccess::read(
+    FileInode& inode,
+    size_t size,
+    off_t off,
+    bool allowFileReference) {
+  if (allowFileReference && size >= kMinFileReferenceSize) {
+    // The reference must describe exactly the bytes that a pread would
+    // return, so clamp it to the current size of the file.
+    auto fileSize = getFileSize(inode);
+    auto length =
+        off < fileSize ? std::min<size_t>(size, fileSize - off) : size_t{0};
+    if (length >= kMinFileReferenceSize) {
+      auto entry = getEntryForInode(inode.getNodeId());
+      readAheadIfSequential(*entry, off, length);
+      auto file = entry->file.dup();
+      if (file.hasValue()) {
+        return BufVec::fromFile(
+            std::move(file).value(), off + FsOverlay::kHeaderLength, length);
+      }
+      XLOG(DBG3) << "unable to dup overlay file for inode "
+                 << inode.getNodeId() << ": " << folly::errnoStr(file.error());
+    }
+  }
+
   auto entry = getEntryForInode(inode.getNodeId());
 
   auto buf = folly::IOBuf::createCombined(size);
@@ -220,15 +332,45 @@ BufVec OverlayFileAccess::read(FileInode& inode, size_t size, off_t off) {
   }
 
   buf->append(res.value());
+  readAheadIfSequential(*entry, off, res.value());
   return BufVec{std::move(buf)};
 }
 
+void OverlayFileAccess::readAheadIfSequential(
+    Entry& entry,
+    off_t off,
+    size_t size) {
+  off_t end = off + folly::to_signed(size);
+  auto previousEnd = entry.lastReadEnd.exchange(end);
+  if (off == 0 || off != previousEnd || size == 0) {
+    // Start over once the file is read from elsewhere.
+    entry.readAheadEnd.store(0);
+    return;
+  }
+
+  // Only issue a new request once half of the previous one was consumed.
+  auto readAheadEnd = entry.readAheadEnd.load();
+  if (readAheadEnd >= end + kReadAheadSize / 2) {
+    return;
+  }
+  auto start = std::max(end, readAheadEnd);
+  entry.readAheadEnd.store(end + kReadAheadSize);
+
+  auto res = entry.file.readahead(
+      start + FsOverlay::kHeaderLength, end + kReadAheadSize - start);
+  if (res.hasError()) {
+    XLOG(DBG5) << "unable to read ahead overlay file: "
+               << folly::errnoStr(res.error());
+  }
+}
+
 size_t OverlayFileAccess::write(
     FileInode& inode,
     const struct iovec* iov,
     size_t iovcnt,
     off_t off) {
   auto entry = getEntryForInode(inode.getNodeId());
+  invalidateMetadata(*entry, inode);
 
   auto xfer = entry->file.pwritev(iov, iovcnt, off + FsOverlay::kHeaderLength);
   if (xfer.hasError()) {
@@ -237,14 +379,14 @@ size_t OverlayFileAccess::write(
         inode.inodePtrFromThis(),
         "pwritev failed during file write");
   }
-  auto info = entry->info.wlock();
-  info->invalidateMetadata();
+  invalidateMetadata(*entry, inode);
 
   return xfer.value();
 }
 
 void OverlayFileAccess::truncate(FileInode& inode, off_t size) {
   auto entry = getEntryForInode(inode.getNodeId());
+  invalidateMetadata(*entry, inode);
   auto result = entry->file.ftruncate(size + FsOverlay::kHeaderLength);
   if (result.hasError()) {
     throw InodeError(
@@ -252,9 +394,7 @@ void OverlayFileAccess::truncate(FileInode& inode, off_t size) {
         inode.inodePtrFromThis(),
         "unable to ftruncate overlay file");
   }
-
-  auto info = entry->info.wlock();
-  info->invalidateMetadata();
+  invalidateMetadata(*entry, inode);
 }
 
 void OverlayFileAccess::fsync(FileInode& inode, bool datasync) {
@@ -276,6 +416,7 @@ void OverlayFileAccess::fallocate(
     uint64_t offset,
     uint64_t length) {
   auto entry = getEntryForInode(inode.getNodeId());
+  invalidateMetadata(*entry, inode);
   auto result =
       entry->file.fallocate(offset, length + FsOverlay::kHeaderLength);
   if (result.hasError()) {
@@ -284,6 +425,8 @@ void OverlayFileAccess::fallocate(
         inode.inodePtrFromThis(),
         "unable to fallocate overlay file");
   }
+  // fallocate may extend the file, which changes its size.
+  invalidateMetadata(*entry, inode);
 }
 
 OverlayFileAccess::EntryPtr OverlayFileAccess::getEntryForInode(
@@ -297,11 +440,10 @@ OverlayFileAccess::EntryPtr OverlayFileAccess::getEntryForInode(
   }
 
   // No entry found. Open one while the lock is not held.
-  // TODO: A possible future optimization here is, if a SHA-1 is known when
-  // the blob is evicted, write it into an xattr when the blob is closed. When
-  // reopened, if the xattr exists, read it back out (and clear).
+  auto file = overlay_->openFileNoVerify(ino);
+  auto headerSha1 = readHeaderSha1(file);
   auto entry = std::make_shared<Entry>(
-      overlay_->openFileNoVerify(ino), std::nullopt, std::nullopt);
+      std::move(file), std::nullopt, std::nullopt, headerSha1);
 
   {
     auto state = state_.wlock();
@@ -311,6 +453,64 @@ OverlayFileAccess::EntryPtr OverlayFileAccess::getEntryForInode(
   return entry;
 }
 
+void OverlayFileAccess::invalidateMetadata(Entry& entry, FileInode& inode) {
+  auto info = entry.info.wlock();
+  info->invalidateMetadata();
+  if (info->headerSha1.has_value()) {
+    auto ret = writeHeaderSha1(entry.file, std::nullopt);
+    if (ret.hasError()) {
+      throw InodeError(
+          ret.error(),
+          inode.inodePtrFromThis(),
+          "unable to clear the SHA-1 in the overlay file header");
+    }
+    info->headerSha1 = std::nullopt;
+  }
+}
+
+std::optional<OverlayFileAccess::Sha1Record>
+OverlayFileAccess::readHeaderSha1(const OverlayFile& file) {
+  std::array<uint8_t, FsOverlay::kHeaderSha1Length> record;
+  auto ret = file.preadNoInt(
+      record.data(), record.size(), FsOverlay::kHeaderSha1Offset);
+  if (ret.hasError() || static_cast<size_t>(ret.value()) != record.size()) {
+    return std::nullopt;
+  }
+
+  auto* bytes = record.data();
+  const auto& tag = FsOverlay::kHeaderSha1Tag;
+  if (memcmp(bytes, tag.data(), tag.size()) != 0) {
+    return std::nullopt;
+  }
+  bytes += tag.size();
+  auto size = folly::Endian::big(folly::loadUnaligned<uint64_t>(bytes));
+  bytes += sizeof(uint64_t);
+  return Sha1Record{size, Hash20{folly::ByteRange{bytes, Hash20::RAW_SIZE}}};
+}
+
+folly::Expected<ssize_t, int> OverlayFileAccess::writeHeaderSha1(
+    const OverlayFile& file,
+    const std::optional<Sha1Record>& record) {
+  static_assert(
+      FsOverlay::kHeaderSha1Length ==
+      FsOverlay::kHeaderSha1Tag.size() + sizeof(uint64_t) + Hash20::RAW_SIZE);
+  std::array<uint8_t, FsOverlay::kHeaderSha1Length> bytes{};
+  if (record.has_value()) {
+    auto* out = bytes.data();
+    const auto& tag = FsOverlay::kHeaderSha1Tag;
+    memcpy(out, tag.data(), tag.size());
+    out += tag.size();
+    folly::storeUnaligned(out, folly::Endian::big(record->size));
+    out += sizeof(uint64_t);
+    memcpy(out, record->sha1.getBytes().data(), Hash20::RAW_SIZE);
+  }
+
+  iovec iov;
+  iov.iov_base = bytes.data();
+  iov.iov_len = bytes.size();
+  return file.pwritev(&iov, 1, FsOverlay::kHeaderSha1Offset);
+}
+
 } // namespace eden
 } // namespace facebook
 
@@ -7,13 +7,18 @@
 
 #pragma once
 
+#include <folly/Expected.h>
 #include <folly/File.h>
+#include <folly/Function.h>
 #include <folly/Synchronized.h>
 #include <folly/container/EvictingCacheMap.h>
+#include <atomic>
 #include <memory>
+#include "eden/fs/inodes/BlobFileStore.h"
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/OverlayFile.h"
+#include "eden/fs/model/Blake3.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/utils/BufVec.h"
 
@@ -31,7 +36,13 @@ class Overlay;
  */
 class OverlayFileAccess {
  public:
-  explicit OverlayFileAccess(Overlay* overlay);
+  /**
+   * When blobFiles is given, files created from large blobs are cloned from
+   * its blob files instead of written, as long as the overlay supports it.
+   */
+  explicit OverlayFileAccess(
+      Overlay* overlay,
+      std::unique_ptr<BlobFileStore> blobFiles = nullptr);
   ~OverlayFileAccess();
 
   /**
@@ -45,7 +56,8 @@ class OverlayFileAccess {
 
   /**
    * Creates a new file in the overlay populated with the contents of the given
-   * blob. If a sha1 is given, it is cached in memory.
+   * blob. If a sha1 is given, it is cached in memory and in the overlay file
+   * header.
    *
    * The caller must verify the overlay file does not already exist. Calls to
    * any other OverlayFileAccess functions for this inode must occur after
@@ -68,9 +80,18 @@ class OverlayFileAccess {
 
   /**
    * Returns the SHA-1 hash of the file contents for the given inode number.
+   *
+   * Computed hashes are also stored in the overlay file header, so that they
+   * survive the eviction of the file from the cache and remounts.
    */
   Hash20 getSha1(FileInode& inode);
 
+  /**
+   * Returns the BLAKE3 hash of the file contents for the given inode number.
+   * Unlike the SHA-1, it is recomputed on every call.
+   */
+  Blake3Hash getBlake3(FileInode& inode);
+
   /**
    * Reads the entire file's contents into memory and returns it.
    */
@@ -79,8 +100,15 @@ class OverlayFileAccess {
   /**
    * Reads a range from the file. At EOF, may return a BufVec smaller than the
    * requested size.
+   *
+   * If allowFileReference is true, large reads may return a BufVec that
+   * refers to the range of the overlay file instead of holding its contents.
    */
-  BufVec read(FileInode& inode, size_t size, off_t off);
+  BufVec read(
+      FileInode& inode,
+      size_t size,
+      off_t off,
+      bool allowFileReference = false);
 
   /**
    * Writes data into the file at the specified offset. Returns the number of
@@ -123,28 +151,62 @@ class OverlayFileAccess {
    * concurrent with write or truncate, a version number is incremented on every
    * modification to an entry's file, and checked before writing the cached
    * value back.
+   *
+   * The SHA-1 is also persisted in the overlay file header. It is written and
+   * cleared with the entry's lock held, and modifications clear it both before
+   * and after changing the file, so that the header never keeps a hash of
+   * contents the file no longer has. The header records the size the hash was
+   * computed for, which catches most modifications lost by an unclean
+   * shutdown.
    */
 
+  struct Sha1Record {
+    uint64_t size;
+    Hash20 sha1;
+  };
+
   struct Entry {
     Entry(
         OverlayFile f,
         std::optional<size_t> s,
-        const std::optional<Hash20>& h)
-        : file{std::move(f)}, info{folly::in_place, s, h} {}
+        const std::optional<Hash20>& h,
+        const std::optional<Sha1Record>& r = std::nullopt)
+        : file{std::move(f)}, info{folly::in_place, s, h, r} {}
 
     struct Info {
-      Info(std::optional<size_t> s, const std::optional<Hash20>& h)
-          : size{s}, sha1{h} {}
+      Info(
+          std::optional<size_t> s,
+          const std::optional<Hash20>& h,
+          const std::optional<Sha1Record>& r)
+          : size{s}, sha1{h}, headerSha1{r} {}
 
+      /**
+       * Clears the in-memory size and SHA-1, but not headerSha1: the overlay
+       * file header must be cleared first.
+       */
       void invalidateMetadata();
 
       std::optional<size_t> size;
       std::optional<Hash20> sha1;
       uint64_t version{0};
+      /**
+       * Set if the overlay file header may hold a SHA-1 record. The record is
+       * only trusted if its size matches the size of the file.
+       */
+      std::optional<Sha1Record> headerSha1;
     };
 
     const OverlayFile file;
     folly::Synchronized<Info> info;
+
+    /**
+     * Where the last read of the file ended, and how far ahead of it the
+     * file has been read ahead, to detect sequential reads. Concurrent
+     * readers of the same file may race on these, which only makes the
+     * detection less precise.
+     */
+    std::atomic<off_t> lastReadEnd{0};
+    std::atomic<off_t> readAheadEnd{0};
   };
 
   using EntryPtr = std::shared_ptr<Entry>;
@@ -163,7 +225,45 @@ class OverlayFileAccess {
    */
   EntryPtr getEntryForInode(InodeNumber);
 
+  /**
+   * Reads the contents of the entry's file in chunks, passing each to
+   * consume, and returns the number of bytes read. purpose describes the
+   * reason for reading in errors.
+   */
+  static uint64_t readContents(
+      const Entry& entry,
+      FileInode& inode,
+      folly::StringPiece purpose,
+      folly::FunctionRef<void(folly::ByteRange)> consume);
+
+  /**
+   * If the read of size bytes at off continues the previous read of the
+   * entry's file, asks the kernel to read the file further ahead.
+   */
+  static void readAheadIfSequential(Entry& entry, off_t off, size_t size);
+
+  /**
+   * Invalidates the cached size and SHA-1 of the entry, and clears the SHA-1
+   * stored in the overlay file header.
+   */
+  void invalidateMetadata(Entry& entry, FileInode& inode);
+
+  /**
+   * Returns the SHA-1 record stored in the header of the given overlay file,
+   * if any.
+   */
+  static std::optional<Sha1Record> readHeaderSha1(const OverlayFile& file);
+
+  /**
+   * Stores the given SHA-1 record in the header of the given overlay file, or
+   * clears it if record is std::nullopt.
+   */
+  static folly::Expected<ssize_t, int> writeHeaderSha1(
+      const OverlayFile& file,
+      const std::optional<Sha1Record>& record);
+
   Overlay* overlay_ = nullptr;
+  std::unique_ptr<BlobFileStore> blobFiles_;
   folly::Synchronized<State> state_;
 };
 
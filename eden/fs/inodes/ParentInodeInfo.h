@@ -35,7 +35,7 @@ class ParentInodeInfo {
       PathComponentPiece name,
       TreeInodePtr parent,
       bool isUnlinked,
-      folly::Synchronized<TreeInodeState>::LockedPtr contents)
+      SynchronizedTreeInodeState::LockedPtr contents)
       : name_(name),
         parent_(std::move(parent)),
         isUnlinked_(isUnlinked),
@@ -78,8 +78,7 @@ class ParentInodeInfo {
    * This returns a null pointer if this is the root inode, or if this inode is
    * unlinked.
    */
-  const folly::Synchronized<TreeInodeState>::LockedPtr& getParentContents()
-      const {
+  const SynchronizedTreeInodeState::LockedPtr& getParentContents() const {
     return parentContents_;
   }
 
@@ -93,7 +92,7 @@ class ParentInodeInfo {
   PathComponent name_;
   TreeInodePtr parent_;
   bool isUnlinked_;
-  folly::Synchronized<TreeInodeState>::LockedPtr parentContents_;
+  SynchronizedTreeInodeState::LockedPtr parentContents_;
 };
 } // namespace eden
 } // namespace facebook
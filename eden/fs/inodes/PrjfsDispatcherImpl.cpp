@@ -9,6 +9,7 @@
 
 #include "eden/fs/inodes/PrjfsDispatcherImpl.h"
 #include <cpptoml.h>
+#include <algorithm>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/logging/xlog.h>
 #include "eden/fs/config/CheckoutConfig.h"
@@ -53,15 +54,73 @@ std::string makeDotEdenConfig(EdenMount& mount) {
 PrjfsDispatcherImpl::PrjfsDispatcherImpl(EdenMount* mount)
     : PrjfsDispatcher(mount->getStats()),
       mount_{mount},
-      dotEdenConfig_{makeDotEdenConfig(*mount)} {}
+      dotEdenConfig_{makeDotEdenConfig(*mount)},
+      dirEntriesCache_{std::make_shared<DirEntriesCache>(
+          std::in_place,
+          std::max<size_t>(
+              mount->getServerState()
+                  ->getEdenConfig()
+                  ->prjfsDirEntriesCacheSize.getValue(),
+              1))} {}
 
 ImmediateFuture<std::vector<PrjfsDirEntry>> PrjfsDispatcherImpl::opendir(
     RelativePath path,
     ObjectFetchContext& context) {
-  return mount_->getInode(path, context).thenValue([](const InodePtr inode) {
-    auto treePtr = inode.asTreePtr();
-    return treePtr->readdir();
-  });
+  return mount_->getInode(path, context).thenValue(
+      [this](const InodePtr inode) {
+        auto treePtr = inode.asTreePtr();
+        auto treeHash = treePtr->getContents().rlock()->treeHash;
+        if (treeHash) {
+          std::shared_ptr<const DirEntries> cached;
+          {
+            auto cache = dirEntriesCache_->wlock();
+            auto it = cache->find(*treeHash);
+            if (it != cache->end()) {
+              cached = it->second;
+            }
+          }
+          if (cached) {
+            return DirEntries{*cached};
+          }
+        }
+
+        auto entries = treePtr->readdir();
+        // The directory may have been materialized since its hash was read,
+        // in which case the entries are not cached: they may not be the
+        // tree's anymore.
+        if (treeHash && treePtr->getContents().rlock()->treeHash == treeHash) {
+          cacheDirEntries(*treeHash, entries);
+        }
+        return entries;
+      });
+}
+
+void PrjfsDispatcherImpl::cacheDirEntries(
+    ObjectId treeHash,
+    DirEntries entries) {
+  // Only cache the entries once the size of every file is known, so that a
+  // failure to fetch one is not remembered.
+  std::vector<ImmediateFuture<PrjfsDirEntry::Ready>> sizes;
+  sizes.reserve(entries.size());
+  for (auto& entry : entries) {
+    sizes.push_back(entry.getFuture());
+  }
+  collectAll(std::move(sizes))
+      .thenValue([cache = dirEntriesCache_,
+                  treeHash = std::move(treeHash),
+                  entries = std::move(entries)](
+                     std::vector<folly::Try<PrjfsDirEntry::Ready>>
+                         results) mutable {
+        for (const auto& result : results) {
+          if (result.hasException()) {
+            return;
+          }
+        }
+        cache->wlock()->set(
+            treeHash, std::make_shared<const DirEntries>(std::move(entries)));
+      })
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance());
 }
 
 ImmediateFuture<std::optional<LookupResult>> PrjfsDispatcherImpl::lookup(
@@ -126,18 +185,20 @@ ImmediateFuture<bool> PrjfsDispatcherImpl::access(
       });
 }
 
-ImmediateFuture<std::string> PrjfsDispatcherImpl::read(
+ImmediateFuture<std::unique_ptr<folly::IOBuf>> PrjfsDispatcherImpl::read(
     RelativePath path,
     ObjectFetchContext& context) {
   return mount_->getInode(path, context)
       .thenValue([&context](const InodePtr inode) {
         auto fileInode = inode.asFilePtr();
-        return fileInode->readAll(context).semi();
+        return fileInode->readContents(context).semi();
       })
-      .thenTry([path = std::move(path), this](folly::Try<std::string> result) {
+      .thenTry([path = std::move(path),
+                this](folly::Try<std::unique_ptr<folly::IOBuf>> result) {
         if (auto* exc = result.tryGetExceptionObject<std::system_error>()) {
           if (isEnoent(*exc) && path == kDotEdenConfigPath) {
-            return folly::Try<std::string>{std::string(dotEdenConfig_)};
+            return folly::Try<std::unique_ptr<folly::IOBuf>>{
+                folly::IOBuf::copyBuffer(dotEdenConfig_)};
           }
         }
         return result;
@@ -7,6 +7,10 @@
 
 #pragma once
 
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <memory>
+#include "eden/fs/model/ObjectId.h"
 #include "eden/fs/prjfs/PrjfsDispatcher.h"
 
 namespace facebook::eden {
@@ -28,7 +32,7 @@ class PrjfsDispatcherImpl : public PrjfsDispatcher {
   ImmediateFuture<bool> access(RelativePath path, ObjectFetchContext& context)
       override;
 
-  ImmediateFuture<std::string> read(
+  ImmediateFuture<std::unique_ptr<folly::IOBuf>> read(
       RelativePath path,
       ObjectFetchContext& context) override;
 
@@ -58,10 +62,33 @@ class PrjfsDispatcherImpl : public PrjfsDispatcher {
       ObjectFetchContext& context) override;
 
  private:
+  using DirEntries = std::vector<PrjfsDirEntry>;
+  using DirEntriesCache = folly::Synchronized<
+      folly::EvictingCacheMap<ObjectId, std::shared_ptr<const DirEntries>>>;
+
+  /**
+   * Cache the entries of a directory that is not materialized, once the sizes
+   * of all of them are known.
+   */
+  void cacheDirEntries(ObjectId treeHash, DirEntries entries);
+
   // The EdenMount associated with this dispatcher.
   EdenMount* const mount_;
 
   const std::string dotEdenConfig_;
+
+  /**
+   * The entries of recently enumerated directories that are not
+   * materialized, keyed by the hash of their source control tree.
+   *
+   * Tools on Windows enumerate the same directories over and over. A
+   * directory that is not materialized has exactly the entries of its tree,
+   * so they can be reused without going through TreeInode::readdir and
+   * fetching the size of every file again.
+   *
+   * Shared with the callbacks that fill it, which may outlive the dispatcher.
+   */
+  std::shared_ptr<DirEntriesCache> dirEntriesCache_;
 };
 
 } // namespace facebook::eden
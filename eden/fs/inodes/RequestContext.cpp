@@ -11,18 +11,30 @@
 
 #include "eden/fs/notifications/Notifications.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
+#include "eden/fs/telemetry/SlowRequestLog.h"
+#include "eden/fs/utils/IDGen.h"
 #include "eden/fs/utils/SystemError.h"
 
 using namespace std::chrono;
 
 namespace facebook::eden {
 
+namespace {
+constexpr ChannelThreadStats::StatPtr
+    kFetchStageStats[ObjectFetchContext::kFetchStageEnumMax] = {
+        &ChannelThreadStats::fetchStageLocalStore,
+        &ChannelThreadStats::fetchStageImportQueue,
+        &ChannelThreadStats::fetchStageBackingStoreFetch,
+};
+} // namespace
+
 void RequestContext::startRequest(
     EdenStats* stats,
     ChannelThreadStats::StatPtr stat,
     std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>&
         requestWatches) {
   startTime_ = steady_clock::now();
+  requestId_ = generateUniqueID();
   XDCHECK(latencyStat_ == nullptr);
   latencyStat_ = stat;
   stats_ = stats;
@@ -39,11 +51,35 @@ void RequestContext::finishRequest() {
   const auto diff_us = duration_cast<microseconds>(diff);
   const auto diff_ns = duration_cast<nanoseconds>(diff);
 
-  stats_->getChannelStatsForCurrentThread().recordLatency(
-      latencyStat_, diff_us);
+  auto& channelStats = stats_->getChannelStatsForCurrentThread();
+  channelStats.recordLatency(latencyStat_, diff_us);
   latencyStat_ = nullptr;
   stats_ = nullptr;
 
+  std::array<nanoseconds, kFetchStageEnumMax> stages;
+  for (size_t stage = 0; stage < kFetchStageEnumMax; ++stage) {
+    stages[stage] = nanoseconds{
+        stageDurations_[stage].load(std::memory_order_relaxed)};
+    // Only record the stages the request went through.
+    if (stages[stage].count() > 0) {
+      channelStats.recordLatency(
+          kFetchStageStats[stage], duration_cast<microseconds>(stages[stage]));
+    }
+  }
+
+  if (diff >= SlowRequestLog::kThreshold) {
+    auto operation = getCauseDetail();
+    SlowRequestLog::get().add(SlowRequestRecord{
+        requestId_,
+        operation ? operation->str() : std::string{},
+        getClientPid(),
+        system_clock::now(),
+        diff_ns,
+        stages[LocalStore],
+        stages[ImportQueue],
+        stages[BackingStoreFetch]});
+  }
+
   if (channelThreadLocalStats_) {
     { auto temp = std::move(requestMetricsScope_); }
     channelThreadLocalStats_.reset();
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/futures/Future.h>
+#include <array>
 #include <atomic>
 #include <utility>
 
@@ -53,6 +54,16 @@ class RequestContext : public ObjectFetchContext {
   std::atomic<ImportPriority> priority_{
       ImportPriority(ImportPriorityKind::High)};
 
+  /**
+   * Identifies this request in the slow request log.
+   */
+  uint64_t requestId_{0};
+
+  /**
+   * Nanoseconds spent in each FetchStage by the fetches of this request.
+   */
+  std::array<std::atomic<uint64_t>, kFetchStageEnumMax> stageDurations_{};
+
  public:
   RequestContext(const RequestContext&) = delete;
   RequestContext& operator=(const RequestContext&) = delete;
@@ -60,6 +71,8 @@ class RequestContext : public ObjectFetchContext {
   RequestContext& operator=(RequestContext&&) = delete;
 
   explicit RequestContext(ProcessAccessLog& pal) : pal_(pal) {}
+  RequestContext(ProcessAccessLog& pal, ImportPriority priority)
+      : pal_(pal), priority_(priority) {}
 
   /**
    * Override of `ObjectFetchContext`
@@ -72,6 +85,17 @@ class RequestContext : public ObjectFetchContext {
     edenTopStats_.setFetchOrigin(origin);
   }
 
+  /**
+   * Override of `ObjectFetchContext`
+   *
+   * Like didFetch, this may be called concurrently by arbitrary threads.
+   */
+  void didFinishStage(FetchStage stage, std::chrono::nanoseconds duration)
+      override {
+    stageDurations_[stage].fetch_add(
+        duration.count(), std::memory_order_relaxed);
+  }
+
   // Override of `getPriority`
   ImportPriority getPriority() const override {
     return priority_;
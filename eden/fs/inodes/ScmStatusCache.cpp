@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/ScmStatusCache.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+std::optional<ScmStatusCache::Entry> ScmStatusCache::get(
+    const RootId& commit,
+    bool listIgnored) const {
+  auto items = items_.rlock();
+  for (const auto& item : *items) {
+    if (item.listIgnored == listIgnored && item.commit == commit) {
+      return item.entry;
+    }
+  }
+  return std::nullopt;
+}
+
+void ScmStatusCache::insert(
+    const RootId& commit,
+    bool listIgnored,
+    JournalDelta::SequenceNumber sequence,
+    std::shared_ptr<const ScmStatus> status) {
+  auto items = items_.wlock();
+  for (auto& item : *items) {
+    if (item.listIgnored == listIgnored && item.commit == commit) {
+      // Concurrent status calls may finish out of order; keep the newest.
+      if (item.entry.sequence <= sequence) {
+        item.entry = Entry{sequence, std::move(status)};
+      }
+      return;
+    }
+  }
+
+  if (items->size() >= kMaxEntries) {
+    auto oldest = std::min_element(
+        items->begin(), items->end(), [](const Item& a, const Item& b) {
+          return a.entry.sequence < b.entry.sequence;
+        });
+    items->erase(oldest);
+  }
+  items->push_back(
+      Item{commit, listIgnored, Entry{sequence, std::move(status)}});
+}
+
+void ScmStatusCache::clear() {
+  items_.wlock()->clear();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+
+namespace facebook::eden {
+
+/**
+ * Remembers the most recent ScmStatus computed for a mount, per commit and
+ * listIgnored value, together with the Journal sequence number it reflects.
+ *
+ * A status can be reused as-is while the journal has not moved, and
+ * otherwise updated by re-checking only the paths the journal recorded since.
+ *
+ * This class is thread safe.
+ */
+class ScmStatusCache {
+ public:
+  struct Entry {
+    /**
+     * The status reflects every journal delta up to and including this one.
+     */
+    JournalDelta::SequenceNumber sequence;
+    std::shared_ptr<const ScmStatus> status;
+  };
+
+  /**
+   * The number of statuses kept. Callers typically alternate between at
+   * most a couple of commits and listIgnored values.
+   */
+  static constexpr size_t kMaxEntries = 4;
+
+  ScmStatusCache() = default;
+
+  ScmStatusCache(const ScmStatusCache&) = delete;
+  ScmStatusCache& operator=(const ScmStatusCache&) = delete;
+
+  std::optional<Entry> get(const RootId& commit, bool listIgnored) const;
+
+  /**
+   * Remember status for commit and listIgnored, unless a status reflecting a
+   * later sequence number is already cached. Evicts the status with the
+   * lowest sequence number when full.
+   */
+  void insert(
+      const RootId& commit,
+      bool listIgnored,
+      JournalDelta::SequenceNumber sequence,
+      std::shared_ptr<const ScmStatus> status);
+
+  void clear();
+
+ private:
+  struct Item {
+    RootId commit;
+    bool listIgnored;
+    Entry entry;
+  };
+
+  folly::Synchronized<std::vector<Item>> items_;
+};
+
+} // namespace facebook::eden
@@ -11,6 +11,7 @@
 #include <gflags/gflags.h>
 
 #include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/model/git/GitIgnoreCache.h"
 #include "eden/fs/model/git/TopLevelIgnores.h"
 #include "eden/fs/telemetry/FsEventLogger.h"
 #include "eden/fs/utils/Clock.h"
@@ -67,6 +68,8 @@ ServerState::ServerState(
       systemIgnoreFileMonitor_{CachedParsedFileMonitor<GitIgnoreFileParser>{
           edenConfig->systemIgnoreFile.getValue(),
           kSystemIgnoreMinPollSeconds}},
+      gitIgnoreCache_{std::make_unique<GitIgnoreCache>(
+          edenConfig->gitIgnoreCacheSize.getValue())},
       notifications_(config_),
       fsEventLogger_{
           (kHasHiveLogger && edenConfig->requestSamplesPerMinute.getValue())
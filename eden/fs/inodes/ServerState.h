@@ -26,6 +26,7 @@ namespace eden {
 class Clock;
 class EdenConfig;
 class FaultInjector;
+class GitIgnoreCache;
 class IHiveLogger;
 class FsEventLogger;
 class ProcessNameCache;
@@ -105,6 +106,14 @@ class ServerState {
    */
   std::unique_ptr<TopLevelIgnores> getTopLevelIgnores();
 
+  /**
+   * Get the cache of parsed .gitignore files, shared by the status operations
+   * of every mount.
+   */
+  GitIgnoreCache& getGitIgnoreCache() const {
+    return *gitIgnoreCache_;
+  }
+
   /**
    * Get the UserInfo object describing the user running this edenfs process.
    */
@@ -203,6 +212,7 @@ class ServerState {
       userIgnoreFileMonitor_;
   folly::Synchronized<CachedParsedFileMonitor<GitIgnoreFileParser>>
       systemIgnoreFileMonitor_;
+  std::unique_ptr<GitIgnoreCache> gitIgnoreCache_;
   Notifications notifications_;
   std::shared_ptr<FsEventLogger> fsEventLogger_;
 };
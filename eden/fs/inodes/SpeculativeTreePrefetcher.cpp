@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/SpeculativeTreePrefetcher.h"
+
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/ServerState.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook::eden {
+
+namespace {
+class SpeculativeTreePrefetchContext : public ObjectFetchContext {
+ public:
+  ImportPriority getPriority() const override {
+    return ImportPriority::kLow();
+  }
+  ObjectFetchContext::Cause getCause() const override {
+    return ObjectFetchContext::Cause::Fs;
+  }
+};
+} // namespace
+
+SpeculativeTreePrefetcher::SpeculativeTreePrefetcher(
+    std::shared_ptr<ObjectStore> objectStore,
+    std::shared_ptr<ServerState> serverState)
+    : objectStore_{std::move(objectStore)},
+      serverState_{std::move(serverState)},
+      context_{std::make_unique<SpeculativeTreePrefetchContext>()},
+      predictor_{
+          folly::in_place,
+          serverState_->getEdenConfig()
+              ->speculativeTreePrefetchModelSize.getValue()} {}
+
+SpeculativeTreePrefetcher::~SpeculativeTreePrefetcher() = default;
+
+void SpeculativeTreePrefetcher::treeLoadStarted(const ObjectId& treeId) {
+  auto config = serverState_->getEdenConfig(ConfigReloadBehavior::NoReload);
+  if (!config->speculativeTreePrefetch.getValue()) {
+    return;
+  }
+
+  auto maxInProgress = config->maxTreePrefetches.getValue();
+  auto numInProgress = numInProgress_.load(std::memory_order_acquire);
+  auto available =
+      numInProgress < maxInProgress ? maxInProgress - numInProgress : 0;
+
+  auto prediction = predictor_.lock()->recordLoad(
+      treeId,
+      config->speculativeTreePrefetchMinCount.getValue(),
+      available);
+
+  auto& stats = serverState_->getStats().getObjectStoreStatsForCurrentThread();
+  if (prediction.wasPredicted) {
+    stats.speculativeTreePrefetchHit.addValue(1);
+  }
+  if (prediction.wasted) {
+    stats.speculativeTreePrefetchWasted.addValue(prediction.wasted);
+  }
+
+  for (const auto& id : prediction.trees) {
+    XLOG(DBG4) << "speculatively prefetching tree " << id << " after "
+               << treeId;
+    stats.speculativeTreePrefetchIssued.addValue(1);
+    numInProgress_.fetch_add(1, std::memory_order_acq_rel);
+    objectStore_->getTree(id, *context_)
+        .semi()
+        .via(&folly::QueuedImmediateExecutor::instance())
+        .thenTry([self = shared_from_this()](auto&&) {
+          self->numInProgress_.fetch_sub(1, std::memory_order_acq_rel);
+        });
+  }
+}
+
+} // namespace facebook::eden
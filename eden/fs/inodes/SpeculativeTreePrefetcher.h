@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <atomic>
+#include <memory>
+
+#include "eden/fs/inodes/TreeAccessPredictor.h"
+
+namespace facebook::eden {
+
+class ObjectFetchContext;
+class ObjectStore;
+class ServerState;
+
+/**
+ * Fetches the trees that a TreeAccessPredictor expects to be loaded next, at
+ * low priority, so that they are already cached when they are needed.
+ *
+ * There is one SpeculativeTreePrefetcher per EdenMount. It is enabled by
+ * `store:speculative-tree-prefetch`, and the number of speculative fetches in
+ * flight is bounded by `store:max-tree-prefetches`, like directory
+ * prefetches.
+ */
+class SpeculativeTreePrefetcher
+    : public std::enable_shared_from_this<SpeculativeTreePrefetcher> {
+ public:
+  SpeculativeTreePrefetcher(
+      std::shared_ptr<ObjectStore> objectStore,
+      std::shared_ptr<ServerState> serverState);
+  ~SpeculativeTreePrefetcher();
+
+  /**
+   * Called when a tree is about to be loaded on demand. Records the load and
+   * starts fetching the trees predicted to follow it.
+   */
+  void treeLoadStarted(const ObjectId& treeId);
+
+ private:
+  SpeculativeTreePrefetcher(const SpeculativeTreePrefetcher&) = delete;
+  SpeculativeTreePrefetcher& operator=(const SpeculativeTreePrefetcher&) =
+      delete;
+
+  std::shared_ptr<ObjectStore> objectStore_;
+  std::shared_ptr<ServerState> serverState_;
+  std::unique_ptr<ObjectFetchContext> context_;
+  folly::Synchronized<TreeAccessPredictor> predictor_;
+  std::atomic<uint64_t> numInProgress_{0};
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/TreeAccessPredictor.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+TreeAccessPredictor::TreeAccessPredictor(size_t capacity)
+    : successors_{capacity}, outstanding_{capacity} {
+  outstanding_.setPruneHook(
+      [this](const ObjectId&, folly::Unit&&) { ++wasted_; });
+}
+
+void TreeAccessPredictor::addSuccessor(
+    const ObjectId& treeId,
+    const ObjectId& successor) {
+  auto it = successors_.find(treeId);
+  if (it == successors_.end()) {
+    successors_.set(treeId, Successors{{successor, 1}});
+    return;
+  }
+
+  auto& successors = it->second;
+  for (auto& [id, count] : successors) {
+    if (id == successor) {
+      ++count;
+      return;
+    }
+  }
+
+  if (successors.size() < kMaxSuccessors) {
+    successors.emplace_back(successor, 1);
+    return;
+  }
+
+  // Replace the least frequently seen successor. Counts are halved so that
+  // successors that stopped showing up eventually lose their spot.
+  auto weakest = std::min_element(
+      successors.begin(), successors.end(), [](const auto& a, const auto& b) {
+        return a.second < b.second;
+      });
+  *weakest = {successor, 1};
+  for (auto& entry : successors) {
+    entry.second = std::max<uint32_t>(1, entry.second / 2);
+  }
+}
+
+TreeAccessPredictor::Prediction TreeAccessPredictor::recordLoad(
+    const ObjectId& treeId,
+    uint32_t minCount,
+    size_t maxPredictions) {
+  Prediction prediction;
+  prediction.wasPredicted = outstanding_.erase(treeId);
+
+  for (const auto& predecessor : history_) {
+    if (predecessor != treeId) {
+      addSuccessor(predecessor, treeId);
+    }
+  }
+  history_.push_back(treeId);
+  if (history_.size() > kHistoryWindow) {
+    history_.pop_front();
+  }
+
+  if (auto it = successors_.find(treeId); it != successors_.end()) {
+    auto candidates = it->second;
+    std::sort(
+        candidates.begin(),
+        candidates.end(),
+        [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    for (const auto& [id, count] : candidates) {
+      if (prediction.trees.size() >= maxPredictions || count < minCount) {
+        break;
+      }
+      if (outstanding_.exists(id)) {
+        continue;
+      }
+      outstanding_.set(id, folly::unit);
+      prediction.trees.push_back(id);
+    }
+  }
+
+  prediction.wasted = std::exchange(wasted_, 0);
+  return prediction;
+}
+
+} // namespace facebook::eden
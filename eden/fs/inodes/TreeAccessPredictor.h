@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Unit.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "eden/fs/model/Hash.h"
+
+namespace facebook::eden {
+
+/**
+ * Learns which trees tend to be loaded shortly after a given tree, and
+ * predicts them.
+ *
+ * Builds and other tree walks load directories in very repeatable orders.
+ * Every time a tree is loaded on demand, it is recorded as a successor of the
+ * trees loaded just before it. Once a successor has been seen often enough,
+ * it is predicted the next time its predecessor is loaded, so that it can be
+ * fetched ahead of demand.
+ *
+ * Trees are identified by ObjectId rather than path: the relation is learned
+ * from the content, survives a checkout as long as the trees do not change,
+ * and naturally forgets about trees that were modified.
+ *
+ * The predictor also keeps track of the outstanding predictions, to report
+ * how many were useful (later loaded on demand) and how many were wasted.
+ *
+ * This class is not thread safe; callers must provide their own locking.
+ */
+class TreeAccessPredictor {
+ public:
+  /**
+   * capacity bounds both the number of trees whose successors are remembered
+   * and the number of outstanding predictions.
+   */
+  explicit TreeAccessPredictor(size_t capacity);
+
+  TreeAccessPredictor(const TreeAccessPredictor&) = delete;
+  TreeAccessPredictor& operator=(const TreeAccessPredictor&) = delete;
+
+  struct Prediction {
+    /**
+     * Trees that should be prefetched now.
+     */
+    std::vector<ObjectId> trees;
+
+    /**
+     * Whether the recorded tree had been predicted.
+     */
+    bool wasPredicted{false};
+
+    /**
+     * Number of predictions that were forgotten without ever being loaded
+     * since the previous call.
+     */
+    size_t wasted{0};
+  };
+
+  /**
+   * Record that the given tree is being loaded on demand, and return the
+   * trees expected to be loaded after it. Only the successors that were
+   * seen at least minCount times are predicted, and at most maxPredictions
+   * of them.
+   */
+  Prediction
+  recordLoad(const ObjectId& treeId, uint32_t minCount, size_t maxPredictions);
+
+  /**
+   * The maximum number of successors remembered per tree.
+   */
+  static constexpr size_t kMaxSuccessors = 8;
+
+  /**
+   * A tree is recorded as a successor of the kHistoryWindow trees loaded
+   * before it.
+   */
+  static constexpr size_t kHistoryWindow = 4;
+
+ private:
+  using Successors = std::vector<std::pair<ObjectId, uint32_t>>;
+
+  void addSuccessor(const ObjectId& treeId, const ObjectId& successor);
+
+  folly::EvictingCacheMap<ObjectId, Successors> successors_;
+  folly::EvictingCacheMap<ObjectId, folly::Unit> outstanding_;
+  std::deque<ObjectId> history_;
+  size_t wasted_{0};
+};
+
+} // namespace facebook::eden
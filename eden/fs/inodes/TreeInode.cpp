@@ -12,19 +12,23 @@
 #include <folly/futures/Future.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/logging/xlog.h>
+#include <algorithm>
 #include <vector>
 
 #include "eden/fs/config/CheckoutConfig.h"
 #include "eden/fs/inodes/CheckoutAction.h"
 #include "eden/fs/inodes/CheckoutContext.h"
 #include "eden/fs/inodes/DeferredDiffEntry.h"
+#include "eden/fs/inodes/DirectoryProfilePrefetcher.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/InodeError.h"
 #include "eden/fs/inodes/InodeMap.h"
+#include "eden/fs/inodes/NfsReaddirSnapshotCache.h"
 #include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/inodes/OverlayFile.h"
 #include "eden/fs/inodes/ServerState.h"
+#include "eden/fs/inodes/SpeculativeTreePrefetcher.h"
 #include "eden/fs/inodes/TreePrefetchLease.h"
 #include "eden/fs/journal/JournalDelta.h"
 #include "eden/fs/model/Tree.h"
@@ -71,6 +75,12 @@ namespace eden {
 namespace {
 static constexpr PathComponentPiece kIgnoreFilename{".gitignore"};
 
+/**
+ * Smaller directories are read by one or two readdir calls: sorting their
+ * entries each time is cheaper than keeping them sorted in a readdirIndex.
+ */
+constexpr size_t kReaddirIndexMinimumEntries = 128;
+
 /**
  * For case insensitive system, we need to use the casing of the file as
  * present in the SCM rather than the one used for lookup.
@@ -183,6 +193,27 @@ TreeInode::TreeInode(
 
 TreeInode::~TreeInode() {}
 
+namespace {
+SlabAllocator& getTreeInodeAllocator() {
+  // Leaked, as inodes may still be destroyed during static destruction.
+  static auto* allocator = new SlabAllocator{sizeof(TreeInode), 256};
+  return *allocator;
+}
+} // namespace
+
+void* TreeInode::operator new(size_t size) {
+  XDCHECK_EQ(sizeof(TreeInode), size);
+  return getTreeInodeAllocator().allocate();
+}
+
+void TreeInode::operator delete(void* ptr) noexcept {
+  getTreeInodeAllocator().deallocate(ptr);
+}
+
+SlabAllocator::Stats TreeInode::getAllocatorStats() {
+  return getTreeInodeAllocator().getStats();
+}
+
 ImmediateFuture<struct stat> TreeInode::stat(ObjectFetchContext& /*context*/) {
   auto st = getMount()->initStatData();
   st.st_ino = folly::to_narrow(getNodeId().get());
@@ -237,7 +268,8 @@ ImmediateFuture<InodePtr> TreeInode::getOrLoadChild(
 
                // Check to see if the entry is already loaded
                const auto& entry = iter->second;
-               if (entry.getInode()) {
+               if (auto* child = entry.getInode()) {
+                 child->markRecentlyAccessed();
                  return ImmediateFuture<InodePtr>{entry.getInodePtr()};
                }
                return std::nullopt;
@@ -307,6 +339,74 @@ ImmediateFuture<TreeInodePtr> TreeInode::getOrLoadChildTree(
   });
 }
 
+ImmediateFuture<std::vector<folly::Try<InodePtr>>>
+TreeInode::getOrLoadChildren(
+    const std::vector<PathComponentPiece>& names,
+    ObjectFetchContext& context) {
+  TraceBlock block("getOrLoadChildren");
+
+  std::vector<ImmediateFuture<InodePtr>> futures;
+  futures.reserve(names.size());
+  std::vector<IncompleteInodeLoad> pendingLoads;
+  std::vector<size_t> dotEdenIndices;
+  {
+    auto contents = contents_.wlock();
+    std::vector<InodeMap::ChildLoad> loads;
+    std::vector<DirEntry*> loadEntries;
+    for (size_t n = 0; n < names.size(); ++n) {
+      auto name = names[n];
+#ifndef _WIN32
+      if (name == kDotEdenName && getNodeId() != kRootNodeId) {
+        // Resolved once the contents lock is released, see getOrLoadChild().
+        dotEdenIndices.push_back(n);
+        futures.emplace_back();
+        continue;
+      }
+#endif // !_WIN32
+
+      auto iter = contents->entries.find(name);
+      if (iter == contents->entries.end()) {
+        futures.emplace_back(folly::Try<InodePtr>{
+            InodeError(ENOENT, inodePtrFromThis(), name)});
+        continue;
+      }
+      auto& entry = iter->second;
+      if (auto child = entry.getInodePtr()) {
+        child->markRecentlyAccessed();
+        futures.emplace_back(std::move(child));
+        continue;
+      }
+
+      folly::Promise<InodePtr> promise;
+      futures.emplace_back(promise.getSemiFuture());
+      loads.push_back(InodeMap::ChildLoad{
+          iter->first, entry.getInodeNumber(), std::move(promise)});
+      loadEntries.push_back(&entry);
+    }
+
+    auto startLoads = getInodeMap()->shouldLoadChildren(this, loads);
+    for (size_t n = 0; n < loads.size(); ++n) {
+      if (startLoads[n]) {
+        pendingLoads.emplace_back(
+            this,
+            startLoadingInodeNoThrow(*loadEntries[n], loads[n].name, context),
+            loads[n].name,
+            loads[n].number);
+      }
+    }
+  }
+
+  for (auto& load : pendingLoads) {
+    load.finish();
+  }
+  for (auto n : dotEdenIndices) {
+    futures[n] = getMount()->getInode(".eden/this-dir"_relpath, context);
+  }
+
+  return collectAll(std::move(futures))
+      .ensure([b = std::move(block)]() mutable { b.close(); });
+}
+
 namespace {
 /**
  * A helper class for performing a recursive path lookup.
@@ -627,7 +727,16 @@ Future<unique_ptr<InodeBase>> TreeInode::startLoadingInode(
         entry.getOptionalHash());
   }
 
+  auto& profilePrefetcher = getMount()->getDirectoryProfilePrefetcher();
+  if (profilePrefetcher.isEnabled()) {
+    if (auto path = getPath()) {
+      profilePrefetcher.directoryLoadStarted(*path + name);
+    }
+  }
+
   if (!entry.isMaterialized()) {
+    getMount()->getSpeculativeTreePrefetcher().treeLoadStarted(
+        entry.getHash());
     return getStore()
         ->getTree(entry.getHash(), fetchContext)
         .semi()
@@ -872,8 +981,10 @@ DirContents TreeInode::buildDirFromTree(
   // of atomic operations from N to 1, though if the atomic is issued with the
   // other work this loop is doing it may not matter much.
 
+  // Tree entries are sorted, so every emplace appends to the reserved storage
+  // and the directory holds no more memory than its entries need.
   DirContents dir(caseSensitive);
-  // TODO: O(N^2)
+  dir.reserve(tree->getTreeEntries().size());
   for (const auto& treeEntry : tree->getTreeEntries()) {
     dir.emplace(
         treeEntry.getName(),
@@ -885,7 +996,7 @@ DirContents TreeInode::buildDirFromTree(
 }
 
 FileInodePtr TreeInode::createImpl(
-    folly::Synchronized<TreeInodeState>::LockedPtr contents,
+    SynchronizedTreeInodeState::LockedPtr contents,
     PathComponentPiece name,
     mode_t mode,
     FOLLY_MAYBE_UNUSED ByteRange fileContents,
@@ -952,6 +1063,7 @@ FileInodePtr TreeInode::createImpl(
     auto insertion = contents->entries.emplace(name, mode, childNumber);
     XCHECK(insertion.second)
         << "we already confirmed that this entry did not exist above";
+    ++contents->entriesVersion;
     auto& entry = insertion.first->second;
 
     inode = FileInodePtr::makeNew(
@@ -1092,6 +1204,7 @@ TreeInodePtr TreeInode::mkdir(
     auto emplaceResult = contents->entries.emplace(name, mode, childNumber);
     XCHECK(emplaceResult.second)
         << "directory contents should not have changed since the check above";
+    ++contents->entriesVersion;
     auto& entry = emplaceResult.first->second;
 
     // Update timeStamps of newly created directory and current directory.
@@ -1314,6 +1427,7 @@ int TreeInode::tryRemoveChild(
 
     // Remove it from our entries list
     contents->entries.erase(entIter);
+    ++contents->entriesVersion;
 
     // We want to update mtime and ctime of parent directory after removing the
     // child.
@@ -1429,9 +1543,9 @@ class TreeInode::TreeRenameLocks {
    * always both set, so that destContents_ can be used regardless of wether
    * the source and destination are both the same directory or not.
    */
-  folly::Synchronized<TreeInodeState>::LockedPtr srcContentsLock_;
-  folly::Synchronized<TreeInodeState>::LockedPtr destContentsLock_;
-  folly::Synchronized<TreeInodeState>::LockedPtr destChildContentsLock_;
+  SynchronizedTreeInodeState::LockedPtr srcContentsLock_;
+  SynchronizedTreeInodeState::LockedPtr destContentsLock_;
+  SynchronizedTreeInodeState::LockedPtr destChildContentsLock_;
 
   /**
    * Pointers to the source and destination directory contents.
@@ -1687,6 +1801,10 @@ ImmediateFuture<Unit> TreeInode::doRename(
 
   // Now remove the source information
   locks.srcContents()->erase(srcIter);
+  ++locks.srcInodeState().entriesVersion;
+  if (destParent.get() != this) {
+    ++locks.dstInodeState().entriesVersion;
+  }
 
   auto now = getNow();
   updateMtimeAndCtimeLocked(*locks.srcContents(), now);
@@ -1883,8 +2001,61 @@ bool TreeInode::readdirImpl(off_t off, ObjectFetchContext& context, Fn add) {
     }
   }
 
-  auto dir = contents_.rlock();
-  auto& entries = dir->entries;
+  {
+    auto dir = contents_.rlock();
+    if (dir->isMaterialized() || dir->readdirIndex ||
+        dir->entries.size() < kReaddirIndexMinimumEntries) {
+      return addReaddirEntries(*dir, off, add);
+    }
+  }
+
+  auto dir = contents_.wlock();
+  if (!dir->isMaterialized() && !dir->readdirIndex) {
+    TreeInodeState::ReaddirIndex index;
+    index.reserve(dir->entries.size());
+    size_t position = 0;
+    for (auto& entry : dir->entries) {
+      index.emplace_back(entry.second.getInodeNumber(), position++);
+    }
+    std::sort(index.begin(), index.end());
+    dir->readdirIndex =
+        std::make_unique<const TreeInodeState::ReaddirIndex>(std::move(index));
+  }
+  return addReaddirEntries(*dir, off, add);
+}
+
+template <typename Fn>
+bool TreeInode::addReaddirEntries(
+    const TreeInodeState& dir,
+    off_t off,
+    Fn& add) {
+  auto& entries = dir.entries;
+
+  if (dir.readdirIndex && dir.readdirIndex->size() == entries.size()) {
+    auto& readdirIndex = *dir.readdirIndex;
+    auto it = std::upper_bound(
+        readdirIndex.begin(),
+        readdirIndex.end(),
+        off,
+        [](off_t offset, const auto& item) {
+          return offset < static_cast<off_t>(item.first.get() + 2);
+        });
+    for (; it != readdirIndex.end(); ++it) {
+      auto& [name, entry] = entries.begin()[it->second];
+      if (entry.getInodeNumber() != it->first) {
+        // The entries were modified before the directory was marked
+        // materialized. Sort them again for the rest of this call.
+        break;
+      }
+      if (!add(name.stringPiece(), entry, entry.getInodeNumber().get() + 2)) {
+        return false;
+      }
+      off = entry.getInodeNumber().get() + 2;
+    }
+    if (it == readdirIndex.end()) {
+      return true;
+    }
+  }
 
   // Compute an index into the PathMap by InodeNumber, only including the
   // entries that are greater than the given offset.
@@ -1929,6 +2100,23 @@ FuseDirList TreeInode::fuseReaddir(
   return std::move(list);
 }
 
+#ifdef __linux__
+FuseDirPlusList TreeInode::fuseReaddirPlus(
+    FuseDirPlusList&& list,
+    off_t off,
+    ObjectFetchContext& context) {
+  readdirImpl(
+      off,
+      context,
+      [&list](StringPiece name, const DirEntry& entry, uint64_t offset) {
+        return list.add(
+            name, entry.getInodeNumber().get(), entry.getDtype(), offset);
+      });
+
+  return std::move(list);
+}
+#endif
+
 std::tuple<NfsDirList, bool> TreeInode::nfsReaddir(
     NfsDirList&& list,
     off_t off,
@@ -1944,6 +2132,128 @@ std::tuple<NfsDirList, bool> TreeInode::nfsReaddir(
   return {std::move(list), isEof};
 }
 
+std::tuple<NfsDirPlusList, bool> TreeInode::nfsReaddirPlus(
+    NfsDirPlusList&& list,
+    off_t off,
+    ObjectFetchContext& context) {
+  bool isEof = readdirImpl(
+      off,
+      context,
+      [&list](StringPiece name, const DirEntry& entry, uint64_t offset) {
+        return list.add(name, entry.getInodeNumber(), offset);
+      });
+
+  return {std::move(list), isEof};
+}
+
+std::shared_ptr<NfsReaddirSnapshot> TreeInode::nfsReaddirSnapshot(
+    ObjectFetchContext& context) {
+  auto snapshot = std::make_shared<NfsReaddirSnapshot>();
+  snapshot->dir = getNodeId();
+  // Read before listing: a concurrent modification then makes the snapshot
+  // look stale rather than current.
+  snapshot->version = getEntriesVersion();
+  readdirImpl(
+      0,
+      context,
+      [&snapshot](StringPiece name, const DirEntry& entry, uint64_t offset) {
+        snapshot->entries.push_back(
+            {name.str(), entry.getInodeNumber(), offset});
+        return true;
+      });
+  return snapshot;
+}
+
+uint64_t TreeInode::getEntriesVersion() const {
+  return contents_.rlock()->entriesVersion;
+}
+
+ImmediateFuture<std::vector<folly::Try<struct stat>>> TreeInode::statChildren(
+    const std::vector<PathComponentPiece>& names,
+    ObjectFetchContext& context) {
+  // What we know about each child after a single pass over the directory.
+  // Children are only stat'ed once the contents lock has been released, as
+  // stat() on a loaded child acquires its own locks and may block.
+  struct Child {
+    InodePtr loaded;
+    InodeNumber ino;
+    mode_t mode{0};
+    std::optional<ObjectId> hash;
+    bool exists{false};
+  };
+  std::vector<Child> children;
+  children.reserve(names.size());
+  {
+    auto contents = contents_.rlock();
+    for (auto name : names) {
+      auto& child = children.emplace_back();
+      auto iter = contents->entries.find(name);
+      if (iter == contents->entries.end()) {
+        continue;
+      }
+      const auto& entry = iter->second;
+      child.exists = true;
+      child.loaded = entry.getInodePtr();
+      child.ino = entry.getInodeNumber();
+      child.mode = entry.getInitialMode();
+      child.hash = entry.getOptionalHash();
+    }
+  }
+
+  auto* mount = getMount();
+  std::vector<ImmediateFuture<struct stat>> futures;
+  futures.reserve(children.size());
+  for (size_t i = 0; i < children.size(); ++i) {
+    auto& child = children[i];
+    if (!child.exists) {
+      futures.emplace_back(folly::Try<struct stat>{
+          InodeError(ENOENT, inodePtrFromThis(), names[i])});
+      continue;
+    }
+    if (child.loaded) {
+      futures.push_back(child.loaded->stat(context));
+      continue;
+    }
+    if (!child.hash) {
+      // The size of a materialized child is only known to the overlay, load
+      // it to get it.
+      futures.push_back(getOrLoadChild(names[i], context)
+                            .thenValue([&context](InodePtr&& inode) {
+                              return inode->stat(context);
+                            }));
+      continue;
+    }
+
+    auto st = mount->initStatData();
+    st.st_ino = child.ino.get();
+    auto metadata = mount->getInodeMetadataTable()->getOptional(child.ino);
+    metadata.value_or(mount->getInitialInodeMetadata(child.mode))
+        .applyToStat(st);
+
+    if (dtype_t::Dir == mode_to_dtype(child.mode)) {
+      // As in stat(), nlink counts the entries plus "." and "..".
+      futures.push_back(
+          getStore()
+              ->getTree(*child.hash, context)
+              .thenValue([st](std::shared_ptr<const Tree>&& tree) mutable {
+                st.st_nlink = tree->getTreeEntries().size() + 2;
+                return st;
+              }));
+    } else {
+      st.st_nlink = 1;
+      futures.push_back(getStore()
+                            ->getBlobSize(*child.hash, context)
+                            .thenValue([st](uint64_t size) mutable {
+                              st.st_size = size;
+                              FileInode::updateBlockCount(st);
+                              return st;
+                            }));
+    }
+  }
+
+  return collectAll(std::move(futures));
+}
+
 #else
 
 std::vector<PrjfsDirEntry> TreeInode::readdir() {
@@ -2083,6 +2393,46 @@ Future<Unit> TreeInode::diff(
           isIgnored);
     }
 
+    // A .gitignore file that is not materialized is read straight from the
+    // object store, and parsed once per blob through the GitIgnoreCache.
+    auto gitignoreHash = gitignoreEntry->getOptionalHash();
+    if (gitignoreHash && gitignoreEntry->getDtype() == dtype_t::Regular) {
+      if (auto ignore = context->getCachedGitIgnore(*gitignoreHash)) {
+        return computeDiff(
+            std::move(contents),
+            context,
+            currentPath,
+            std::move(tree),
+            make_unique<GitIgnoreStack>(parentIgnore, std::move(ignore)),
+            isIgnored);
+      }
+
+      XLOG(DBG7) << "Loading ignore file blob for " << getLogPath();
+      contents.unlock();
+      return context->loadGitIgnore(*gitignoreHash)
+          .thenError([](const folly::exception_wrapper& ex) {
+            XLOG(WARN) << "error reading ignore file: "
+                       << folly::exceptionStr(ex);
+            return std::shared_ptr<const GitIgnore>{
+                std::make_shared<GitIgnore>()};
+          })
+          .thenValue([self = inodePtrFromThis(),
+                      context,
+                      currentPath = RelativePath{currentPath},
+                      tree = std::move(tree),
+                      parentIgnore,
+                      isIgnored](
+                         std::shared_ptr<const GitIgnore> ignore) mutable {
+            return self->computeDiff(
+                self->contents_.wlock(),
+                context,
+                currentPath,
+                std::move(tree),
+                make_unique<GitIgnoreStack>(parentIgnore, std::move(ignore)),
+                isIgnored);
+          });
+    }
+
     XLOG(DBG7) << "Loading ignore file for " << getLogPath();
     inode = gitignoreEntry->getInodePtr();
     if (!inode) {
@@ -2183,7 +2533,7 @@ due to the fact that we do not need to worry about recursive lock holding since
 the only time a lock is held in this path is when we load gitignore files.
 */
 Future<Unit> TreeInode::computeDiff(
-    folly::Synchronized<TreeInodeState>::LockedPtr contentsLock,
+    SynchronizedTreeInodeState::LockedPtr contentsLock,
     DiffContext* context,
     RelativePathPiece currentPath,
     shared_ptr<const Tree> tree,
@@ -2243,7 +2593,10 @@ Future<Unit> TreeInode::computeDiff(
       }
 
       if (inodeEntry->isDirectory()) {
-        if (!entryIgnored || context->listIgnored) {
+        if (!entryIgnored && context->summarizeUntrackedDirectories) {
+          XLOG(DBG8) << "diff: untracked directory: " << entryPath;
+          context->callback->addedDirectory(entryPath);
+        } else if (!entryIgnored || context->listIgnored) {
           if (auto childPtr = inodeEntry->getInodePtr()) {
             deferredEntries.emplace_back(
                 DeferredDiffEntry::createUntrackedEntryFromInodeFuture(
@@ -2311,6 +2664,23 @@ Future<Unit> TreeInode::computeDiff(
       // We only need to know the ignored status if this is a directory.
       // If this is a regular file on disk and in source control, then it
       // is always included since it is already tracked in source control.
+      //
+      // Unchanged entries are by far the most common, so check for them
+      // before building the path of the entry.
+      //
+      // Eventually the mode will come from inode metadata storage, not from
+      // the directory entry.  However, any source-control-visible metadata
+      // changes will cause the inode to be materialized.
+      if (!inodeEntry->getInode() && !inodeEntry->isMaterialized() &&
+          treeEntryTypeFromMode(inodeEntry->getInitialMode()) ==
+              scmEntry.getType() &&
+          inodeEntry->getHash() == scmEntry.getHash()) {
+        // This file or directory is unchanged.  We can skip it.
+        XLOG(DBG9) << "diff: unchanged unloaded file: "
+                   << currentPath + scmEntry.getName();
+        return;
+      }
+
       bool entryIgnored = isIgnored;
       auto entryPath = currentPath + scmEntry.getName();
       if (!isIgnored && (inodeEntry->isDirectory() || scmEntry.isTree())) {
@@ -2356,16 +2726,6 @@ Future<Unit> TreeInode::computeDiff(
                 std::move(inodeFuture),
                 ignore.get(),
                 entryIgnored));
-      } else if (
-          // Eventually the mode will come from inode metadata storage,
-          // not from the directory entry.  However, any source-control-visible
-          // metadata changes will cause the inode to be materialized, and
-          // the previous path will be taken.
-          treeEntryTypeFromMode(inodeEntry->getInitialMode()) ==
-              scmEntry.getType() &&
-          inodeEntry->getHash() == scmEntry.getHash()) {
-        // This file or directory is unchanged.  We can skip it.
-        XLOG(DBG9) << "diff: unchanged unloaded file: " << entryPath;
       } else if (inodeEntry->isDirectory()) {
         // This is a modified directory. Since it is not materialized we can
         // directly compare the source control objects.
@@ -2477,10 +2837,18 @@ Future<Unit> TreeInode::computeDiff(
     load.finish();
   }
 
-  // Now process all of the deferred work.
+  // Now process all of the deferred work. Entries can recurse into whole
+  // subdirectories, so they are spread over the diff executor, except for
+  // the last one which this thread takes on itself.
   vector<Future<Unit>> deferredFutures;
-  for (auto& entry : deferredEntries) {
-    deferredFutures.push_back(entry->run());
+  for (size_t n = 0; n < deferredEntries.size(); ++n) {
+    auto* entry = deferredEntries[n].get();
+    if (n + 1 == deferredEntries.size()) {
+      deferredFutures.push_back(entry->run());
+    } else {
+      deferredFutures.push_back(
+          context->runInParallel([entry] { return entry->run(); }));
+    }
   }
 
   // Wait on all of the deferred entries to complete.
@@ -2526,6 +2894,7 @@ Future<Unit> TreeInode::checkout(
 
   vector<unique_ptr<CheckoutAction>> actions;
   vector<IncompleteInodeLoad> pendingLoads;
+  vector<UnloadedTreeConflictCheck> treeConflictChecks;
   bool wasDirectoryListModified = false;
 
   computeCheckoutActions(
@@ -2534,6 +2903,7 @@ Future<Unit> TreeInode::checkout(
       toTree.get(),
       actions,
       pendingLoads,
+      treeConflictChecks,
       wasDirectoryListModified);
 
   // Wire up the callbacks for any pending inode loads we started
@@ -2541,10 +2911,23 @@ Future<Unit> TreeInode::checkout(
     load.finish();
   }
 
-  // Now start all of the checkout actions
+  auto treeConflictsFuture =
+      checkUnloadedTreeConflicts(ctx, std::move(treeConflictChecks));
+
+  // Now start all of the checkout actions. Actions can recurse into whole
+  // subdirectories, so they are spread over the server thread pool, except
+  // for the last one which this thread takes on itself.
   vector<Future<InvalidationRequired>> actionFutures;
-  for (const auto& action : actions) {
-    actionFutures.emplace_back(action->run(ctx, getStore()));
+  for (size_t n = 0; n < actions.size(); ++n) {
+    auto* action = actions[n].get();
+    if (n + 1 == actions.size()) {
+      actionFutures.emplace_back(action->run(ctx, getStore()));
+    } else {
+      actionFutures.emplace_back(
+          ctx->runInParallel([ctx, action, store = getStore()] {
+            return action->run(ctx, store);
+          }));
+    }
   }
   // Wait for all of the actions, and record any errors.
   return folly::collectAll(actionFutures)
@@ -2592,7 +2975,167 @@ Future<Unit> TreeInode::checkout(
 
             XLOG(DBG4) << "checkout: finished update of " << self->getLogPath()
                        << ": " << numErrors << " errors";
-          });
+          })
+      .thenValue(
+          [treeConflictsFuture = std::move(treeConflictsFuture)](
+              auto&&) mutable { return std::move(treeConflictsFuture); });
+}
+
+Future<Unit> TreeInode::checkUnloadedTreeConflicts(
+    CheckoutContext* ctx,
+    vector<UnloadedTreeConflictCheck> checks) {
+  if (checks.empty()) {
+    return makeFuture();
+  }
+
+  auto path = getUnsafePath();
+  vector<ImmediateFuture<Unit>> futures;
+  futures.reserve(checks.size());
+  for (const auto& check : checks) {
+    futures.push_back(findUnloadedTreeConflicts(
+        ctx,
+        getStore(),
+        path + check.name,
+        check.localTreeHash,
+        check.oldScmEntry,
+        check.newScmEntry));
+  }
+  return collectAll(std::move(futures))
+      .thenValue([ctx, self = inodePtrFromThis(), checks = std::move(checks)](
+                     vector<folly::Try<Unit>> results) {
+        for (size_t n = 0; n < results.size(); ++n) {
+          if (results[n].hasException()) {
+            ctx->addError(self.get(), checks[n].name, results[n].exception());
+          }
+        }
+      })
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance());
+}
+
+ImmediateFuture<Unit> TreeInode::findUnloadedTreeConflicts(
+    CheckoutContext* ctx,
+    ObjectStore* store,
+    RelativePath path,
+    ObjectId localTreeHash,
+    std::optional<TreeEntry> oldScmEntry,
+    std::optional<TreeEntry> newScmEntry) {
+  if (oldScmEntry && !oldScmEntry->isTree()) {
+    // A file was replaced by a directory locally; checkoutUpdateEntry()
+    // reports this without looking inside the directory.
+    ctx->addConflict(ConflictType::MODIFIED_MODIFIED, path);
+    return folly::unit;
+  }
+
+  auto getTree = [&](const std::optional<TreeEntry>& entry)
+      -> ImmediateFuture<shared_ptr<const Tree>> {
+    if (!entry || !entry->isTree()) {
+      return shared_ptr<const Tree>{};
+    }
+    return ctx->getTree(entry->getHash());
+  };
+  auto localTreeFuture = ctx->getTree(localTreeHash);
+  auto fromTreeFuture = getTree(oldScmEntry);
+  auto toTreeFuture = getTree(newScmEntry);
+  return collectAllSafe(
+             std::move(localTreeFuture),
+             std::move(fromTreeFuture),
+             std::move(toTreeFuture))
+      .thenValue([ctx, store, path = std::move(path)](auto&& trees) {
+        auto& [localTree, fromTree, toTree] = trees;
+        // In a dry run, a directory being removed is never actually emptied,
+        // so checkoutUpdateEntry() always reports it as not empty.
+        bool removed = !toTree;
+        return findUnloadedTreeConflicts(
+                   ctx, store, path, *localTree, fromTree.get(), toTree.get())
+            .thenValue([ctx, path, removed](auto&&) {
+              if (removed) {
+                ctx->addConflict(ConflictType::DIRECTORY_NOT_EMPTY, path);
+              }
+            });
+      });
+}
+
+ImmediateFuture<Unit> TreeInode::findUnloadedTreeConflicts(
+    CheckoutContext* ctx,
+    ObjectStore* store,
+    RelativePathPiece path,
+    const Tree& localTree,
+    const Tree* fromTree,
+    const Tree* toTree) {
+  XDCHECK(ctx->isDryRun());
+  if (canShortCircuitCheckout(ctx, localTree.getHash(), fromTree, toTree)) {
+    return folly::unit;
+  }
+
+  vector<ImmediateFuture<Unit>> futures;
+  auto processEntry = [&](const TreeEntry* oldScmEntry,
+                          const TreeEntry* newScmEntry) {
+    if (oldScmEntry && newScmEntry &&
+        oldScmEntry->getType() == newScmEntry->getType() &&
+        oldScmEntry->getHash() == newScmEntry->getHash()) {
+      return;
+    }
+
+    const auto& name =
+        oldScmEntry ? oldScmEntry->getName() : newScmEntry->getName();
+    auto entryPath = path + name;
+    auto* localEntry = localTree.getEntryPtr(name);
+    if (!localEntry) {
+      if (oldScmEntry) {
+        ctx->addConflict(
+            newScmEntry ? ConflictType::REMOVED_MODIFIED
+                        : ConflictType::MISSING_REMOVED,
+            entryPath);
+      }
+      return;
+    }
+
+    if (oldScmEntry && localEntry->getHash() == oldScmEntry->getHash()) {
+      return;
+    }
+    if (localEntry->isTree()) {
+      futures.push_back(findUnloadedTreeConflicts(
+          ctx,
+          store,
+          std::move(entryPath),
+          localEntry->getHash(),
+          oldScmEntry ? std::make_optional(*oldScmEntry) : std::nullopt,
+          newScmEntry ? std::make_optional(*newScmEntry) : std::nullopt));
+    } else {
+      ctx->addConflict(
+          oldScmEntry ? ConflictType::MODIFIED_MODIFIED
+                      : ConflictType::UNTRACKED_ADDED,
+          entryPath);
+    }
+  };
+
+  // The same merge of fromTree and toTree as computeCheckoutActions().
+  vector<TreeEntry> emptyEntries;
+  const auto& oldEntries = fromTree ? fromTree->getTreeEntries() : emptyEntries;
+  const auto& newEntries = toTree ? toTree->getTreeEntries() : emptyEntries;
+  size_t oldIdx = 0;
+  size_t newIdx = 0;
+  while (oldIdx < oldEntries.size() || newIdx < newEntries.size()) {
+    if (oldIdx >= oldEntries.size()) {
+      processEntry(nullptr, &newEntries[newIdx++]);
+    } else if (newIdx >= newEntries.size()) {
+      processEntry(&oldEntries[oldIdx++], nullptr);
+    } else if (oldEntries[oldIdx].getName() < newEntries[newIdx].getName()) {
+      processEntry(&oldEntries[oldIdx++], nullptr);
+    } else if (newEntries[newIdx].getName() < oldEntries[oldIdx].getName()) {
+      processEntry(nullptr, &newEntries[newIdx++]);
+    } else {
+      processEntry(&oldEntries[oldIdx++], &newEntries[newIdx++]);
+    }
+  }
+
+  return collectAll(std::move(futures))
+      .thenValue([](vector<folly::Try<Unit>> results) {
+        for (auto& result : results) {
+          result.throwUnlessValue();
+        }
+      });
 }
 
 bool TreeInode::canShortCircuitCheckout(
@@ -2646,6 +3189,7 @@ void TreeInode::computeCheckoutActions(
     const Tree* toTree,
     vector<unique_ptr<CheckoutAction>>& actions,
     vector<IncompleteInodeLoad>& pendingLoads,
+    vector<UnloadedTreeConflictCheck>& treeConflictChecks,
     bool& wasDirectoryListModified) {
   // Grab the contents_ lock for the duration of this function
   auto contents = contents_.wlock();
@@ -2670,6 +3214,7 @@ void TreeInode::computeCheckoutActions(
   vector<TreeEntry> emptyEntries;
   const auto& oldEntries = fromTree ? fromTree->getTreeEntries() : emptyEntries;
   const auto& newEntries = toTree ? toTree->getTreeEntries() : emptyEntries;
+  vector<CheckoutEntryUpdate> entryUpdates;
   while (true) {
     unique_ptr<CheckoutAction> action;
 
@@ -2686,6 +3231,8 @@ void TreeInode::computeCheckoutActions(
           nullptr,
           &newEntries[newIdx],
           pendingLoads,
+          treeConflictChecks,
+          entryUpdates,
           wasDirectoryListModified);
       ++newIdx;
     } else if (newIdx >= newEntries.size()) {
@@ -2696,6 +3243,8 @@ void TreeInode::computeCheckoutActions(
           &oldEntries[oldIdx],
           nullptr,
           pendingLoads,
+          treeConflictChecks,
+          entryUpdates,
           wasDirectoryListModified);
       ++oldIdx;
     } else {
@@ -2711,6 +3260,8 @@ void TreeInode::computeCheckoutActions(
             &oldEntries[oldIdx],
             nullptr,
             pendingLoads,
+            treeConflictChecks,
+            entryUpdates,
             wasDirectoryListModified);
         ++oldIdx;
       } else if (compare == CompareResult::AFTER) {
@@ -2720,6 +3271,8 @@ void TreeInode::computeCheckoutActions(
             nullptr,
             &newEntries[newIdx],
             pendingLoads,
+            treeConflictChecks,
+            entryUpdates,
             wasDirectoryListModified);
         ++newIdx;
       } else {
@@ -2729,6 +3282,8 @@ void TreeInode::computeCheckoutActions(
             &oldEntries[oldIdx],
             &newEntries[newIdx],
             pendingLoads,
+            treeConflictChecks,
+            entryUpdates,
             wasDirectoryListModified);
         ++oldIdx;
         ++newIdx;
@@ -2739,6 +3294,76 @@ void TreeInode::computeCheckoutActions(
       actions.push_back(std::move(action));
     }
   }
+
+  // Still with the contents_ lock held, so that lookups don't race with the
+  // invalidations. The actions run after this, so the invalidations of
+  // children, which depend on their parent's, come after them.
+  applyEntryUpdates(ctx, *contents, entryUpdates, wasDirectoryListModified);
+}
+
+void TreeInode::applyEntryUpdates(
+    CheckoutContext* ctx,
+    TreeInodeState& state,
+    const vector<CheckoutEntryUpdate>& updates,
+    bool& wasDirectoryListModified) {
+  if (updates.empty()) {
+    return;
+  }
+
+  auto results = invalidateChannelEntryCaches(state, updates);
+  auto& contents = state.entries;
+  for (size_t i = 0; i < updates.size(); ++i) {
+    const auto& update = updates[i];
+    if (results[i].hasException()) {
+      ctx->addError(this, update.name, results[i].exception());
+      continue;
+    }
+
+    // TODO: remove the old inode number from both the overlay and the
+    // InodeTable.  Or at least verify that it's already done in a test.
+    //
+    // This logic could potentially be unified with TreeInode::tryRemoveChild
+    // and TreeInode::checkoutUpdateEntry.
+    if (update.replaceHash) {
+      auto it = contents.find(update.name);
+      XDCHECK(it != contents.end());
+      it->second.setUnloadedHash(update.newScmEntry->getHash());
+      wasDirectoryListModified = true;
+      continue;
+    }
+    if (update.oldInodeNumber) {
+      auto it = contents.find(update.name);
+      XDCHECK(it != contents.end());
+      contents.erase(it);
+    }
+    if (update.newScmEntry) {
+      auto [it, inserted] = contents.emplace(
+          update.newScmEntry->getName(),
+          modeFromTreeEntryType(update.newScmEntry->getType()),
+          getOverlay()->allocateInodeNumber(),
+          update.newScmEntry->getHash());
+      XDCHECK(inserted);
+    }
+    ++state.entriesVersion;
+    wasDirectoryListModified = true;
+
+    // Contents have changed and the entry is not materialized, but we may
+    // have allocated and remembered inode numbers for this tree.  It's much
+    // faster to simply forget the inode numbers we allocated here -- if we
+    // were a real filesystem, it's as if the entire subtree got deleted and
+    // checked out from scratch.  (Note: if anything uses Watchman and cares
+    // precisely about inode numbers, it could miss changes.)
+    if (update.removeOverlayData) {
+      XLOG(DBG5) << "recursively removing overlay data for "
+                 << *update.oldInodeNumber << "(" << getLogPath() << " / "
+                 << update.name << ")";
+      getOverlay()->recursivelyRemoveOverlayData(*update.oldInodeNumber);
+    }
+
+    // TODO: contents have changed: we probably should propagate
+    // this information up to our caller so it can mark us
+    // materialized if necessary.
+  }
 }
 
 unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
@@ -2747,6 +3372,8 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
     const TreeEntry* oldScmEntry,
     const TreeEntry* newScmEntry,
     vector<IncompleteInodeLoad>& pendingLoads,
+    vector<UnloadedTreeConflictCheck>& treeConflictChecks,
+    vector<CheckoutEntryUpdate>& entryUpdates,
     bool& wasDirectoryListModified) {
   XLOG(DBG5) << "processCheckoutEntry(" << getLogPath()
              << "): " << (oldScmEntry ? oldScmEntry->toLogString() : "(null)")
@@ -2808,18 +3435,8 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
       // after this inode processes all of its checkout actions. But we
       // do want to invalidate the kernel's dcache and inode caches.
       wasDirectoryListModified = true;
-
-      auto success = invalidateChannelEntryCache(state, name, std::nullopt);
-      if (success.hasValue()) {
-        auto [it, inserted] = contents.emplace(
-            newScmEntry->getName(),
-            modeFromTreeEntryType(newScmEntry->getType()),
-            getOverlay()->allocateInodeNumber(),
-            newScmEntry->getHash());
-        XDCHECK(inserted);
-      } else {
-        ctx->addError(this, name, success.exception());
-      }
+      entryUpdates.push_back(CheckoutEntryUpdate{
+          PathComponent{name}, std::nullopt, false, newScmEntry});
     }
 
     // Nothing else to do when there is no local inode.
@@ -2845,10 +3462,12 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
   // We also have to load the inode if it is materialized so we can
   // check its contents to see if there are conflicts or not.
   // On Windows, we need to invalidate ProjectedFS on-disk state.
+  // None of the latter applies to a dry run, which only looks for conflicts.
   if (entry.isMaterialized() ||
-      getInodeMap()->isInodeRemembered(entry.getInodeNumber()) ||
-      (kPreciseInodeNumberMemory && entry.isDirectory() &&
-       getOverlay()->hasOverlayData(entry.getInodeNumber()))) {
+      (!ctx->isDryRun() &&
+       (getInodeMap()->isInodeRemembered(entry.getInodeNumber()) ||
+        (kPreciseInodeNumberMemory && entry.isDirectory() &&
+         getOverlay()->hasOverlayData(entry.getInodeNumber()))))) {
     XLOG(DBG6) << "must load child: inode=" << getNodeId() << " child=" << name;
     // This child is potentially modified (or has saved state that must be
     // updated), but is not currently loaded. Start loading it and create a
@@ -2870,8 +3489,19 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
     conflictType = ConflictType::MODIFIED_MODIFIED;
   }
   if (conflictType != ConflictType::ERROR) {
-    // If this is a directory we unfortunately have to load it and recurse into
-    // it just so we can accurately report the list of files with conflicts.
+    // If this is a directory we have to recurse into it to accurately report
+    // the list of files with conflicts. A dry run can do that from source
+    // control trees alone, as the directory is not materialized.
+    if (entry.isDirectory() && ctx->isDryRun() &&
+        getMount()->getCheckoutConfig()->getCaseSensitive() ==
+            CaseSensitivity::Sensitive) {
+      treeConflictChecks.push_back(UnloadedTreeConflictCheck{
+          PathComponent{name},
+          entry.getHash(),
+          oldScmEntry ? std::make_optional(*oldScmEntry) : std::nullopt,
+          newScmEntry ? std::make_optional(*newScmEntry) : std::nullopt});
+      return nullptr;
+    }
     if (entry.isDirectory()) {
       auto inodeFuture = loadChildLocked(
           contents, name, entry, pendingLoads, ctx->getFetchContext());
@@ -2891,49 +3521,30 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
     return nullptr;
   }
 
-  auto oldEntryInodeNumber = entry.getInodeNumber();
-
-  // We are removing or replacing an entry - attempt to invalidate it while the
-  // write lock is held and before the contents are updated.
-  auto success = invalidateChannelEntryCache(state, name, oldEntryInodeNumber);
-  if (success.hasException()) {
-    ctx->addError(this, name, success.exception());
+  // We are removing or replacing an entry. It is invalidated, while the write
+  // lock is held and before the contents are updated, along with the other
+  // entries of this directory by computeCheckoutActions().
+  //
+  // A directory replaced by another one, with no inode loaded or remembered
+  // below it and no overlay data, is only known by its hash: pointing its
+  // entry at the new tree updates the whole subtree, without allocating
+  // inode numbers or walking the overlay.
+  if (newScmEntry && newScmEntry->isTree() && entry.isDirectory() &&
+      it->first == newScmEntry->getName() &&
+      !getOverlay()->hasOverlayData(entry.getInodeNumber())) {
+    entryUpdates.push_back(CheckoutEntryUpdate{
+        PathComponent{name},
+        entry.getInodeNumber(),
+        false,
+        newScmEntry,
+        true});
     return nullptr;
   }
-
-  // TODO: remove entry.getInodeNumber() from both the overlay and the
-  // InodeTable.  Or at least verify that it's already done in a test.
-  //
-  // This logic could potentially be unified with TreeInode::tryRemoveChild
-  // and TreeInode::checkoutUpdateEntry.
-  contents.erase(it);
-  if (newScmEntry) {
-    contents.emplace(
-        newScmEntry->getName(),
-        modeFromTreeEntryType(newScmEntry->getType()),
-        getOverlay()->allocateInodeNumber(),
-        newScmEntry->getHash());
-  }
-
-  wasDirectoryListModified = true;
-
-  // Contents have changed and the entry is not materialized, but we may have
-  // allocated and remembered inode numbers for this tree.  It's much faster to
-  // simply forget the inode numbers we allocated here -- if we were a real
-  // filesystem, it's as if the entire subtree got deleted and checked out
-  // from scratch.  (Note: if anything uses Watchman and cares precisely about
-  // inode numbers, it could miss changes.)
-  if (!kPreciseInodeNumberMemory && entry.isDirectory()) {
-    XLOG(DBG5) << "recursively removing overlay data for "
-               << oldEntryInodeNumber << "(" << getLogPath() << " / " << name
-               << ")";
-    getOverlay()->recursivelyRemoveOverlayData(oldEntryInodeNumber);
-  }
-
-  // TODO: contents have changed: we probably should propagate
-  // this information up to our caller so it can mark us
-  // materialized if necessary.
-
+  entryUpdates.push_back(CheckoutEntryUpdate{
+      PathComponent{name},
+      entry.getInodeNumber(),
+      !kPreciseInodeNumberMemory && entry.isDirectory(),
+      newScmEntry});
   return nullptr;
 }
 
@@ -3003,6 +3614,7 @@ Future<InvalidationRequired> TreeInode::checkoutUpdateEntry(
             newScmEntry->getHash());
         XDCHECK(inserted);
       }
+      ++contents->entriesVersion;
     }
 
     // We don't save our own overlay data right now:
@@ -3085,6 +3697,7 @@ Future<InvalidationRequired> TreeInode::checkoutUpdateEntry(
                   parentInode->getOverlay()->allocateInodeNumber(),
                   newScmEntry->getHash());
               inserted = ret.second;
+              ++contents->entriesVersion;
             }
 
             if (!inserted) {
@@ -3128,7 +3741,7 @@ folly::Try<void> TreeInode::invalidateChannelEntryCache(
     FOLLY_MAYBE_UNUSED std::optional<InodeNumber> ino) {
 #ifndef _WIN32
   if (auto* fuseChannel = getMount()->getFuseChannel()) {
-    fuseChannel->invalidateEntry(getNodeId(), name);
+    fuseChannel->invalidateEntry(getNodeId(), name, ino);
   }
   // For NFS, the entry cache is flushed when the directory mtime is changed.
   // Directly invalidating an entry is not possible.
@@ -3155,6 +3768,41 @@ folly::Try<void> TreeInode::invalidateChannelEntryCache(
   return folly::Try<void>{};
 }
 
+vector<folly::Try<void>> TreeInode::invalidateChannelEntryCaches(
+    TreeInodeState& state,
+    const vector<CheckoutEntryUpdate>& updates) {
+#ifdef _WIN32
+  if (auto* fsChannel = getMount()->getPrjfsChannel()) {
+    const auto path = getPath();
+    if (path.has_value()) {
+      vector<RelativePath> paths;
+      paths.reserve(updates.size());
+      for (const auto& update : updates) {
+        paths.push_back(path.value() + update.name);
+      }
+      auto results = fsChannel->removeCachedFiles(paths);
+      // As in invalidateChannelEntryCache().
+      auto& inodeMap = *getInodeMap();
+      for (size_t i = 0; i < updates.size(); ++i) {
+        auto ino = updates[i].oldInodeNumber;
+        if (results[i].hasValue() && ino && needDecFsRefcount(inodeMap, *ino)) {
+          inodeMap.decFsRefcount(*ino);
+        }
+      }
+      return results;
+    }
+  }
+#endif
+
+  vector<folly::Try<void>> results;
+  results.reserve(updates.size());
+  for (const auto& update : updates) {
+    results.push_back(
+        invalidateChannelEntryCache(state, update.name, update.oldInodeNumber));
+  }
+  return results;
+}
+
 folly::Try<void> TreeInode::invalidateChannelDirCache(TreeInodeState&) {
 #ifndef _WIN32
   if (auto* fuseChannel = getMount()->getFuseChannel()) {
@@ -3256,6 +3904,7 @@ void TreeInode::saveOverlayPostCheckout(
 
     auto oldHash = contents->treeHash;
     contents->treeHash = tryToDematerialize();
+    contents->readdirIndex.reset();
     isMaterialized = contents->isMaterialized();
     stateChanged = (oldHash != contents->treeHash);
 
@@ -3458,6 +4107,18 @@ size_t TreeInode::unloadChildrenUnreferencedByFs() {
       [](InodeBase* child) { return child->getFsRefcount() == 0; });
 }
 
+size_t TreeInode::unloadChildrenNotRecentlyAccessed() {
+  auto treeChildren = getTreeChildren(this);
+  return unloadChildrenIf(
+      this,
+      getInodeMap(),
+      treeChildren,
+      [](TreeInode& child) {
+        return child.unloadChildrenNotRecentlyAccessed();
+      },
+      [](InodeBase* child) { return !child->clearRecentlyAccessed(); });
+}
+
 void TreeInode::updateAtime() {
   auto lock = contents_.wlock();
   InodeBaseMetadata::updateAtimeLocked(lock->entries);
@@ -8,12 +8,17 @@
 #pragma once
 #include <folly/File.h>
 #include <folly/Portability.h>
+#include <folly/SharedMutex.h>
 #include <folly/Synchronized.h>
+#include <memory>
 #include <optional>
+#include <vector>
 #include "eden/fs/fuse/Invalidation.h"
 #include "eden/fs/inodes/CheckoutAction.h"
 #include "eden/fs/inodes/DirEntry.h"
 #include "eden/fs/inodes/InodeBase.h"
+#include "eden/fs/telemetry/InstrumentedMutex.h"
+#include "eden/fs/utils/SlabAllocator.h"
 
 namespace facebook {
 namespace eden {
@@ -22,7 +27,10 @@ class CheckoutAction;
 class CheckoutContext;
 class DiffContext;
 class FuseDirList;
+class FuseDirPlusList;
 class NfsDirList;
+class NfsDirPlusList;
+struct NfsReaddirSnapshot;
 class EdenMount;
 class GitIgnoreStack;
 class DiffCallback;
@@ -50,10 +58,31 @@ struct TreeInodeState {
   }
   void setMaterialized() {
     treeHash = std::nullopt;
+    readdirIndex.reset();
   }
 
   DirContents entries;
 
+  /**
+   * The inode numbers of the entries, in increasing order, each with the
+   * index of its entry. readdir returns entries in this order, and large
+   * directories are read by many readdir calls: this saves sorting the entries
+   * again for each of them.
+   *
+   * Only built for unmaterialized directories, whose entries don't change
+   * until they are materialized or dematerialized by a checkout. It must be
+   * reset whenever treeHash changes.
+   */
+  using ReaddirIndex = std::vector<std::pair<InodeNumber, size_t>>;
+  std::unique_ptr<const ReaddirIndex> readdirIndex;
+
+  /**
+   * Incremented whenever an entry is added, removed or replaced, so that
+   * listings taken earlier can tell they are stale, see
+   * NfsReaddirSnapshotCache.
+   */
+  uint64_t entriesVersion{0};
+
   /**
    * If this TreeInode is unmaterialized (identical to an existing source
    * control Tree), treeHash contains the ID of the source control Tree
@@ -66,6 +95,19 @@ struct TreeInodeState {
   std::optional<ObjectId> treeHash;
 };
 
+struct TreeInodeContentsLockName {
+  static const char* name() {
+    return "tree_inode_contents";
+  }
+};
+
+/**
+ * The contents of every TreeInode share one set of lock contention stats.
+ */
+using SynchronizedTreeInodeState = folly::Synchronized<
+    TreeInodeState,
+    InstrumentedMutex<folly::SharedMutex, TreeInodeContentsLockName>>;
+
 /**
  * Represents a directory in the file system.
  */
@@ -112,6 +154,18 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
 
   ~TreeInode() override;
 
+  /**
+   * Like FileInodes, TreeInodes are allocated from a pool shared by all
+   * mounts. The entries of the directory are not part of the pool.
+   */
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr) noexcept;
+
+  /**
+   * Returns the memory usage of the pool TreeInodes are allocated from.
+   */
+  static SlabAllocator::Stats getAllocatorStats();
+
   ImmediateFuture<struct stat> stat(ObjectFetchContext& context) override;
 
 #ifndef _WIN32
@@ -137,6 +191,18 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       PathComponentPiece name,
       ObjectFetchContext& context);
 
+  /**
+   * Load the named children, returning them in the same order.
+   *
+   * This behaves like calling getOrLoadChild() for each name, but takes this
+   * directory's contents lock and the InodeMap lock only once, and starts all
+   * the loads before waiting on any of them. Names that are not in the
+   * directory fail with ENOENT.
+   */
+  ImmediateFuture<std::vector<folly::Try<InodePtr>>> getOrLoadChildren(
+      const std::vector<PathComponentPiece>& names,
+      ObjectFetchContext& context);
+
   /**
    * Recursively look up a child inode.
    *
@@ -160,6 +226,17 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
   FuseDirList
   fuseReaddir(FuseDirList&& list, off_t off, ObjectFetchContext& context);
 
+#ifdef __linux__
+  /**
+   * Same as fuseReaddir, for FUSE_READDIRPLUS. The entry parameters are not
+   * filled in, see getOrLoadChildren().
+   */
+  FuseDirPlusList fuseReaddirPlus(
+      FuseDirPlusList&& list,
+      off_t off,
+      ObjectFetchContext& context);
+#endif
+
   /**
    * Populate the list with as many directory entries as possible starting from
    * the inode start.
@@ -169,6 +246,40 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    */
   std::tuple<NfsDirList, bool>
   nfsReaddir(NfsDirList&& list, off_t off, ObjectFetchContext& context);
+
+  /**
+   * Same as nfsReaddir, for READDIRPLUS. The attributes of the entries are
+   * not filled in, see statChildren().
+   */
+  std::tuple<NfsDirPlusList, bool> nfsReaddirPlus(
+      NfsDirPlusList&& list,
+      off_t off,
+      ObjectFetchContext& context);
+
+  /**
+   * Return the attributes of the named children, in the same order, in a
+   * single pass over this directory.
+   *
+   * Unlike calling stat() on each child, the attributes of unloaded children
+   * are computed from their DirEntry, the InodeMetadataTable and the object
+   * store, without loading them. Only unloaded materialized children, whose
+   * size lives in the overlay, are loaded. Names that are not in the directory
+   * fail with ENOENT.
+   */
+  ImmediateFuture<std::vector<folly::Try<struct stat>>> statChildren(
+      const std::vector<PathComponentPiece>& names,
+      ObjectFetchContext& context);
+
+  /**
+   * List the whole directory, for NFS READDIR continuations to page through.
+   */
+  std::shared_ptr<NfsReaddirSnapshot> nfsReaddirSnapshot(
+      ObjectFetchContext& context);
+
+  /**
+   * Returns the version of the entries, see TreeInodeState::entriesVersion.
+   */
+  uint64_t getEntriesVersion() const;
 #else
   /**
    * The following readdir() is for responding to Projected FS's directory
@@ -181,10 +292,10 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
   FOLLY_NODISCARD std::vector<PrjfsDirEntry> readdir();
 #endif
 
-  const folly::Synchronized<TreeInodeState>& getContents() const {
+  const SynchronizedTreeInodeState& getContents() const {
     return contents_;
   }
-  folly::Synchronized<TreeInodeState>& getContents() {
+  SynchronizedTreeInodeState& getContents() {
     return contents_;
   }
 
@@ -362,6 +473,18 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    */
   size_t unloadChildrenUnreferencedByFs();
 
+  /**
+   * Unload all unreferenced inodes under this tree, recursively, that have
+   * not been looked up since the previous call.
+   *
+   * This is a second-chance (clock) sweep: the recently accessed flag of every
+   * unreferenced inode that is kept is cleared, so that it gets unloaded by
+   * the next sweep unless it is looked up again in the meantime.
+   *
+   * Returns the number of inodes unloaded.
+   */
+  size_t unloadChildrenNotRecentlyAccessed();
+
 #ifndef _WIN32
   /**
    * Unload all unreferenced inodes under this tree whose last access time is
@@ -526,13 +649,20 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
   template <typename Fn>
   bool readdirImpl(off_t offset, ObjectFetchContext& context, Fn add);
 
+  /**
+   * Adds the entries of dir after the given offset, in inode number order,
+   * until add() returns false. Returns true if all the entries were added.
+   */
+  template <typename Fn>
+  static bool addReaddirEntries(const TreeInodeState& dir, off_t off, Fn& add);
+
   /**
    * createImpl() is a helper function for creating new children inodes.
    *
    * This is used by create(), symlink(), and mknod().
    */
   FileInodePtr createImpl(
-      folly::Synchronized<TreeInodeState>::LockedPtr contentsLock,
+      SynchronizedTreeInodeState::LockedPtr contentsLock,
       PathComponentPiece name,
       mode_t mode,
       folly::ByteRange fileContents,
@@ -637,7 +767,7 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    * diff once all .gitignore data is loaded.
    */
   FOLLY_NODISCARD folly::Future<folly::Unit> computeDiff(
-      folly::Synchronized<TreeInodeState>::LockedPtr contentsLock,
+      SynchronizedTreeInodeState::LockedPtr contentsLock,
       DiffContext* context,
       RelativePathPiece currentPath,
       std::shared_ptr<const Tree> tree,
@@ -664,12 +794,49 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       const ObjectId& treeHash,
       const Tree* fromTree,
       const Tree* toTree);
+
+  /**
+   * An unloaded, non-materialized child directory with conflicts in a dry-run
+   * checkout. Its contents are exactly its source control tree, so the
+   * conflicts below it are found by comparing trees rather than by loading
+   * inodes for it.
+   */
+  struct UnloadedTreeConflictCheck {
+    PathComponent name;
+    ObjectId localTreeHash;
+    std::optional<TreeEntry> oldScmEntry;
+    std::optional<TreeEntry> newScmEntry;
+  };
+
+  /**
+   * A change to an unloaded, non-materialized entry found by
+   * processCheckoutEntry(). All it takes is invalidating the channel's cache
+   * for the entry and updating the contents, which computeCheckoutActions()
+   * does for all the entries of the directory at once, see
+   * applyEntryUpdates().
+   */
+  struct CheckoutEntryUpdate {
+    PathComponent name;
+    /** The inode number of the entry being replaced, if there is one. */
+    std::optional<InodeNumber> oldInodeNumber;
+    /** Whether the overlay data below the old entry must be removed. */
+    bool removeOverlayData;
+    /** The entry to add, owned by the Tree being checked out. */
+    const TreeEntry* newScmEntry;
+    /**
+     * Whether the old entry is kept and pointed at the hash of newScmEntry,
+     * rather than replaced by a new entry.
+     */
+    bool replaceHash = false;
+  };
+
   void computeCheckoutActions(
       CheckoutContext* ctx,
       const Tree* fromTree,
       const Tree* toTree,
       std::vector<std::unique_ptr<CheckoutAction>>& actions,
       std::vector<IncompleteInodeLoad>& pendingLoads,
+      std::vector<UnloadedTreeConflictCheck>& treeConflictChecks,
       bool& wasDirectoryListModified);
   /**
    * Sets wasDirectoryListModified true if this checkout entry operation has
@@ -684,7 +851,55 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       const TreeEntry* oldScmEntry,
       const TreeEntry* newScmEntry,
       std::vector<IncompleteInodeLoad>& pendingLoads,
+      std::vector<UnloadedTreeConflictCheck>& treeConflictChecks,
+      std::vector<CheckoutEntryUpdate>& entryUpdates,
+      bool& wasDirectoryListModified);
+
+  /**
+   * Invalidate the channel's cache for all the entries of updates, then
+   * apply the updates whose invalidation succeeded to the contents. Failures
+   * are recorded as errors in ctx.
+   *
+   * The entries are siblings, so their invalidations don't depend on each
+   * other and are issued concurrently where the channel supports it.
+   */
+  void applyEntryUpdates(
+      CheckoutContext* ctx,
+      TreeInodeState& state,
+      const std::vector<CheckoutEntryUpdate>& updates,
       bool& wasDirectoryListModified);
+
+  /**
+   * Run the checks queued by computeCheckoutActions(), recording any errors
+   * against the corresponding child.
+   */
+  folly::Future<folly::Unit> checkUnloadedTreeConflicts(
+      CheckoutContext* ctx,
+      std::vector<UnloadedTreeConflictCheck> checks);
+
+  /**
+   * Report the conflicts a dry-run checkout from oldScmEntry to newScmEntry
+   * would find in the unloaded directory at path, whose contents are the
+   * source control tree localTreeHash.
+   *
+   * This mirrors what checkout() and processCheckoutEntry() report for
+   * unmaterialized inodes, without loading any.
+   */
+  static ImmediateFuture<folly::Unit> findUnloadedTreeConflicts(
+      CheckoutContext* ctx,
+      ObjectStore* store,
+      RelativePath path,
+      ObjectId localTreeHash,
+      std::optional<TreeEntry> oldScmEntry,
+      std::optional<TreeEntry> newScmEntry);
+  static ImmediateFuture<folly::Unit> findUnloadedTreeConflicts(
+      CheckoutContext* ctx,
+      ObjectStore* store,
+      RelativePathPiece path,
+      const Tree& localTree,
+      const Tree* fromTree,
+      const Tree* toTree);
+
   void saveOverlayPostCheckout(CheckoutContext* ctx, const Tree* tree);
 
   /**
@@ -718,6 +933,14 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       PathComponentPiece name,
       std::optional<InodeNumber> ino);
 
+  /**
+   * invalidateChannelEntryCache() for the entries of updates, returning the
+   * result for each of them at the same index.
+   */
+  FOLLY_NODISCARD std::vector<folly::Try<void>> invalidateChannelEntryCaches(
+      TreeInodeState&,
+      const std::vector<CheckoutEntryUpdate>& updates);
+
   /**
    * Attempt to remove an empty directory during a checkout operation.
    *
@@ -727,7 +950,7 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    */
   FOLLY_NODISCARD bool checkoutTryRemoveEmptyDir(CheckoutContext* ctx);
 
-  folly::Synchronized<TreeInodeState> contents_;
+  SynchronizedTreeInodeState contents_;
 
   /**
    * Only prefetch blob metadata on the first readdir() of a loaded inode.
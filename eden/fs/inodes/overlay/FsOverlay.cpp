@@ -13,6 +13,13 @@
 #include <algorithm>
 #include <chrono>
 
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#elif defined(__APPLE__)
+#include <sys/clonefile.h>
+#endif
+
 #include <folly/Exception.h>
 #include <folly/File.h>
 #include <folly/FileUtil.h>
@@ -48,6 +55,17 @@ using std::string;
 constexpr StringPiece kInfoFile{"info"};
 constexpr const char* kNextInodeNumberFile{"next-inode-number"};
 
+/**
+ * The dirty shard markers live in this directory: an empty file named after
+ * each shard that has been modified since the overlay was last consistent,
+ * and kDirtyShardsBaseFile, which holds the next inode number at that point.
+ *
+ * Like the overlay data itself, the markers are not fsync'ed: they protect
+ * against edenfs crashing, not against the system crashing.
+ */
+constexpr StringPiece kDirtyShardsDir{"dirty-shards"};
+constexpr StringPiece kDirtyShardsBaseFile{"base-inode-number"};
+
 /**
  * 4-byte magic identifier to put at the start of the info file.
  * This merely helps confirm that we are in fact reading an overlay info file
@@ -71,6 +89,9 @@ constexpr folly::StringPiece FsOverlay::kHeaderIdentifierDir;
 constexpr folly::StringPiece FsOverlay::kHeaderIdentifierFile;
 constexpr uint32_t FsOverlay::kHeaderVersion;
 constexpr size_t FsOverlay::kHeaderLength;
+constexpr folly::StringPiece FsOverlay::kHeaderSha1Tag;
+constexpr size_t FsOverlay::kHeaderSha1Offset;
+constexpr size_t FsOverlay::kHeaderSha1Length;
 constexpr uint32_t FsOverlay::kNumShards;
 
 static void doFormatSubdirPath(
@@ -134,10 +155,23 @@ std::optional<InodeNumber> FsOverlay::initOverlay(bool createIfNonExisting) {
       dirFd, "error opening overlay directory handle for ", localDir_.value());
   dirFile_ = File{dirFd, /* ownsFd */ true};
 
+  // Overlays created by older versions of edenfs have no dirty shard markers.
+  auto dirtyShardsDir = localDir_ + PathComponentPiece{kDirtyShardsDir};
+  if (::mkdir(dirtyShardsDir.c_str(), 0755) != 0 && errno != EEXIST) {
+    folly::throwSystemError(
+        "error creating overlay dirty shards directory ", dirtyShardsDir);
+  }
+
+  std::optional<InodeNumber> nextInodeNumber;
   if (overlayCreated) {
-    return InodeNumber{kRootNodeId.get() + 1};
+    nextInodeNumber = InodeNumber{kRootNodeId.get() + 1};
+  } else {
+    nextInodeNumber = tryLoadNextInodeNumber();
+  }
+  if (nextInodeNumber) {
+    clearDirtyShards(*nextInodeNumber);
   }
-  return tryLoadNextInodeNumber();
+  return nextInodeNumber;
 }
 
 struct statfs FsOverlay::statFs() const {
@@ -213,6 +247,111 @@ void FsOverlay::saveNextInodeNumber(InodeNumber nextInodeNumber) {
       .value();
 }
 
+namespace {
+
+using DirtyShardMarkerPath = std::array<
+    char,
+    kDirtyShardsDir.size() + FsOverlay::kShardDirPathLength + 2>;
+
+DirtyShardMarkerPath getDirtyShardMarkerPath(FsOverlay::ShardID shardID) {
+  DirtyShardMarkerPath path;
+  memcpy(path.data(), kDirtyShardsDir.data(), kDirtyShardsDir.size());
+  path[kDirtyShardsDir.size()] = '/';
+  FsOverlay::formatSubdirShardPath(
+      shardID,
+      MutableStringPiece{
+          path.data() + kDirtyShardsDir.size() + 1,
+          FsOverlay::kShardDirPathLength});
+  path[path.size() - 1] = '\0';
+  return path;
+}
+
+} // namespace
+
+std::optional<OverlayDirtyShards> FsOverlay::loadDirtyShards() {
+  auto basePath = localDir_ + PathComponentPiece{kDirtyShardsDir} +
+      PathComponentPiece{kDirtyShardsBaseFile};
+  std::string contents;
+  if (!folly::readFile(basePath.c_str(), contents)) {
+    if (errno == ENOENT) {
+      return std::nullopt;
+    }
+    folly::throwSystemError("Failed to read ", basePath);
+  }
+  uint64_t baseInodeNumber;
+  if (contents.size() != sizeof(baseInodeNumber)) {
+    XLOG(WARN) << "Invalid dirty shard base file of " << contents.size()
+               << " bytes. Full overlay scan required.";
+    return std::nullopt;
+  }
+  memcpy(&baseInodeNumber, contents.data(), sizeof(baseInodeNumber));
+  if (baseInodeNumber <= kRootNodeId.get()) {
+    XLOG(WARN) << "Invalid dirty shard base inode number " << baseInodeNumber
+               << ". Full overlay scan required.";
+    return std::nullopt;
+  }
+
+  OverlayDirtyShards result{InodeNumber{baseInodeNumber}, {}};
+  for (ShardID shardID = 0; shardID < kNumShards; ++shardID) {
+    auto path = getDirtyShardMarkerPath(shardID);
+    struct stat st;
+    if (fstatat(dirFile_.fd(), path.data(), &st, AT_SYMLINK_NOFOLLOW) == 0) {
+      result.shards.push_back(shardID);
+      dirtyShards_[shardID].store(true, std::memory_order_release);
+    } else if (errno != ENOENT) {
+      folly::throwSystemError("Failed to stat ", path.data(), " in overlay");
+    }
+  }
+  return result;
+}
+
+void FsOverlay::clearDirtyShards(InodeNumber nextInodeNumber) {
+  // Replace the base before removing the markers.  If we crash in between,
+  // the markers left behind only make the next check examine more shards.
+  auto basePath = localDir_ + PathComponentPiece{kDirtyShardsDir} +
+      PathComponentPiece{kDirtyShardsBaseFile};
+  auto nextInodeVal = nextInodeNumber.get();
+  writeFileAtomic(
+      basePath,
+      ByteRange(
+          reinterpret_cast<const uint8_t*>(&nextInodeVal),
+          reinterpret_cast<const uint8_t*>(&nextInodeVal + 1)))
+      .value();
+
+  for (ShardID shardID = 0; shardID < kNumShards; ++shardID) {
+    auto path = getDirtyShardMarkerPath(shardID);
+    if (::unlinkat(dirFile_.fd(), path.data(), 0) != 0 && errno != ENOENT) {
+      folly::throwSystemError(
+          "error removing overlay dirty shard marker ", path.data());
+    }
+    dirtyShards_[shardID].store(false, std::memory_order_release);
+  }
+}
+
+void FsOverlay::markShardDirty(InodeNumber inodeNumber) {
+  auto shardID = static_cast<ShardID>(inodeNumber.get() & 0xff);
+  auto& dirty = dirtyShards_[shardID];
+  if (dirty.load(std::memory_order_acquire)) {
+    return;
+  }
+  // Concurrent callers may both create the marker, which is harmless. None
+  // of them returns before the marker exists.
+  auto path = getDirtyShardMarkerPath(shardID);
+  int fd = openat(
+      dirFile_.fd(),
+      path.data(),
+      O_CREAT | O_WRONLY | O_CLOEXEC | O_NOFOLLOW,
+      0600);
+  folly::checkUnixError(
+      fd,
+      "error creating dirty shard marker for inode ",
+      inodeNumber,
+      " in ",
+      localDir_);
+  folly::closeNoInt(fd);
+  dirty.store(true, std::memory_order_release);
+}
+
 void FsOverlay::readExistingOverlay(int infoFD) {
   // Read the info file header
   std::array<uint8_t, kInfoHeaderSize> infoHeader;
@@ -392,7 +531,8 @@ std::array<uint8_t, FsOverlay::kHeaderLength> FsOverlay::createHeader(
   appender.push(identifier);
   appender.writeBE(version);
   // The overlay header used to store timestamps for inodes but that has since
-  // been moved to the InodeMetadataTable. Write zeroes instead.
+  // been moved to the InodeMetadataTable. Write zeroes instead. The first 32
+  // bytes are reused by OverlayFileAccess to cache the SHA-1 of files.
   appender.writeBE<uint64_t>(0); // atime.tv_sec
   appender.writeBE<uint64_t>(0); // atime.tv_nsec
   appender.writeBE<uint64_t>(0); // ctime.tv_sec
@@ -429,6 +569,8 @@ folly::File FsOverlay::openFile(
 }
 
 folly::File FsOverlay::openFileNoVerify(InodeNumber inodeNumber) {
+  // The file is opened for writing, so treat its shard as modified.
+  markShardDirty(inodeNumber);
   auto path = FsOverlay::getFilePath(inodeNumber);
 
   int fd = openat(dirFile_.fd(), path.c_str(), O_RDWR | O_CLOEXEC | O_NOFOLLOW);
@@ -479,6 +621,7 @@ folly::File FsOverlay::createOverlayFileImpl(
   auto path = getFilePath(inodeNumber);
 
   auto tmpPath = getFileTmpPath(inodeNumber);
+  markShardDirty(inodeNumber);
 
   auto tmpFD = openat(
       dirFile_.fd(),
@@ -547,6 +690,119 @@ folly::File FsOverlay::createOverlayFileImpl(
   return file;
 }
 
+#if defined(__linux__) || defined(__APPLE__)
+namespace {
+/**
+ * Whether a clone failed because the filesystem or the pair of files doesn't
+ * support it, rather than because of an I/O error.
+ */
+bool isCloneUnsupported(int err) {
+#if ENOTSUP != EOPNOTSUPP
+  if (err == ENOTSUP) {
+    return true;
+  }
+#endif
+  return err == EOPNOTSUPP || err == EXDEV || err == EINVAL ||
+      err == ENOTTY || err == ENOSYS;
+}
+} // namespace
+#endif
+
+std::optional<folly::File> FsOverlay::cloneOverlayFile(
+    InodeNumber inodeNumber,
+    const folly::File& source) {
+#if defined(__linux__) || defined(__APPLE__)
+  auto path = getFilePath(inodeNumber);
+  auto tmpPath = getFileTmpPath(inodeNumber);
+  markShardDirty(inodeNumber);
+
+#ifdef __linux__
+  auto tmpFD = openat(
+      dirFile_.fd(),
+      tmpPath.data(),
+      O_CREAT | O_RDWR | O_CLOEXEC | O_NOFOLLOW | O_TRUNC,
+      0600);
+  folly::checkUnixError(
+      tmpFD,
+      "failed to create temporary overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_);
+  folly::File file{tmpFD, /* ownsFd */ true};
+  bool success = false;
+  SCOPE_EXIT {
+    if (!success) {
+      unlinkat(dirFile_.fd(), tmpPath.data(), 0);
+    }
+  };
+
+  if (ioctl(tmpFD, FICLONE, source.fd()) != 0) {
+    int err = errno;
+    if (isCloneUnsupported(err)) {
+      return std::nullopt;
+    }
+    folly::throwSystemErrorExplicit(
+        err,
+        "error cloning overlay file for inode ",
+        inodeNumber,
+        " in ",
+        localDir_);
+  }
+#else
+  // fclonefileat() creates the destination and fails if it exists, so a
+  // temporary file left behind by a crash must be removed first.
+  unlinkat(dirFile_.fd(), tmpPath.data(), 0);
+  if (fclonefileat(source.fd(), dirFile_.fd(), tmpPath.data(), 0) != 0) {
+    int err = errno;
+    if (isCloneUnsupported(err)) {
+      return std::nullopt;
+    }
+    folly::throwSystemErrorExplicit(
+        err,
+        "error cloning overlay file for inode ",
+        inodeNumber,
+        " in ",
+        localDir_);
+  }
+  bool success = false;
+  SCOPE_EXIT {
+    if (!success) {
+      unlinkat(dirFile_.fd(), tmpPath.data(), 0);
+    }
+  };
+
+  auto tmpFD =
+      openat(dirFile_.fd(), tmpPath.data(), O_RDWR | O_CLOEXEC | O_NOFOLLOW);
+  folly::checkUnixError(
+      tmpFD,
+      "failed to open cloned overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_);
+  folly::File file{tmpFD, /* ownsFd */ true};
+  // The clone has the mode of the source, make it match the files written by
+  // createOverlayFileImpl.
+  fchmod(tmpFD, 0600);
+#endif
+
+  auto returnCode =
+      renameat(dirFile_.fd(), tmpPath.data(), dirFile_.fd(), path.c_str());
+  folly::checkUnixError(
+      returnCode,
+      "error committing overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_);
+  success = true;
+
+  return file;
+#else
+  (void)inodeNumber;
+  (void)source;
+  return std::nullopt;
+#endif
+}
+
 folly::File FsOverlay::createOverlayFile(
     InodeNumber inodeNumber,
     ByteRange contents) {
@@ -625,6 +881,7 @@ void FsOverlay::validateHeader(
 }
 
 void FsOverlay::removeOverlayData(InodeNumber inodeNumber) {
+  markShardDirty(inodeNumber);
   auto path = getFilePath(inodeNumber);
   int result = ::unlinkat(dirFile_.fd(), path.c_str(), 0);
   if (result == 0) {
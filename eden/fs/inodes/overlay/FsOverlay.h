@@ -11,8 +11,10 @@
 #include <folly/Range.h>
 #include <gtest/gtest_prod.h>
 #include <array>
+#include <atomic>
 #include <condition_variable>
 #include <optional>
+#include <vector>
 #include "eden/fs/inodes/IOverlay.h"
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
@@ -33,6 +35,19 @@ class OverlayDir;
 }
 class InodePath;
 
+/**
+ * The shards of an FsOverlay that may have been modified since the overlay
+ * was last known to be consistent, as recorded by its dirty shard markers.
+ *
+ * Every inode numbered below baseInodeNumber either existed in the overlay at
+ * that point or had not been allocated yet.  Shards that are not listed have
+ * not been modified since then.
+ */
+struct OverlayDirtyShards {
+  InodeNumber baseInodeNumber;
+  std::vector<uint32_t> shards;
+};
+
 /**
  * FsOverlay provides interfaces to manipulate the overlay. It stores the
  * overlay's file system attributes and is responsible for obtaining and
@@ -135,6 +150,26 @@ class FsOverlay : public IOverlay {
    */
   std::optional<InodeNumber> tryLoadNextInodeNumber();
 
+  /**
+   * Read the dirty shard markers left by the previous user of the overlay.
+   *
+   * This should be called after initOverlay() returned std::nullopt and
+   * before modifying the overlay.  Returns std::nullopt if the overlay has no
+   * record of when it was last consistent, in which case all of it must be
+   * checked.
+   */
+  std::optional<OverlayDirtyShards> loadDirtyShards();
+
+  /**
+   * Record that the overlay is consistent, and that nextInodeNumber is the
+   * next inode number to be allocated, by removing all of the dirty shard
+   * markers.
+   *
+   * initOverlay() calls this after a clean shutdown. After an unclean one,
+   * the caller should call this once the overlay has been checked.
+   */
+  void clearDirtyShards(InodeNumber nextInodeNumber);
+
   /**
    * Validate an existing overlay's info file exists, is valid and contains the
    * correct version.
@@ -156,6 +191,17 @@ class FsOverlay : public IOverlay {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) override;
 
+  /**
+   * Creates the overlay file of a new FileInode as a clone of source with
+   * FICLONE on Linux or fclonefileat() on macOS, so that both files share
+   * their data blocks until one of them is written to.
+   *
+   * Returns std::nullopt if the filesystem of the overlay can't clone source.
+   */
+  std::optional<folly::File> cloneOverlayFile(
+      InodeNumber inodeNumber,
+      const folly::File& source) override;
+
   /**
    * Remove the overlay data associated with the passed InodeNumber.
    */
@@ -205,6 +251,15 @@ class FsOverlay : public IOverlay {
   static constexpr folly::StringPiece kHeaderIdentifierFile{"OVFL"};
   static constexpr uint32_t kHeaderVersion = 1;
   static constexpr size_t kHeaderLength = 64;
+  /**
+   * File headers may cache the SHA-1 of the file contents, in the space that
+   * used to hold timestamps: the kHeaderSha1Tag identifier, the big-endian
+   * uint64 size of the contents the hash was computed for, and the hash.
+   * Headers without the tag have no cached hash.
+   */
+  static constexpr folly::StringPiece kHeaderSha1Tag{"SHA1"};
+  static constexpr size_t kHeaderSha1Offset = 8;
+  static constexpr size_t kHeaderSha1Length = 32;
   static constexpr uint32_t kNumShards = 256;
   static constexpr size_t kShardDirPathLength = 2;
 
@@ -214,10 +269,6 @@ class FsOverlay : public IOverlay {
    */
   static constexpr size_t kMaxDecimalInodeNumberLength = 20;
 
- private:
-  FRIEND_TEST(OverlayTest, getFilePath);
-  friend class RawOverlayTest;
-
   /**
    * Creates header for the files stored in Overlay
    */
@@ -225,6 +276,10 @@ class FsOverlay : public IOverlay {
       folly::StringPiece identifier,
       uint32_t version);
 
+ private:
+  FRIEND_TEST(OverlayTest, getFilePath);
+  friend class RawOverlayTest;
+
   /**
    * Get the path to the file for the given inode, relative to localDir.
    *
@@ -238,6 +293,13 @@ class FsOverlay : public IOverlay {
   folly::File
   createOverlayFileImpl(InodeNumber inodeNumber, iovec* iov, size_t iovCount);
 
+  /**
+   * Create the dirty shard marker for the shard of the given inode, if it
+   * does not exist yet.  This must be called before the inode's overlay data
+   * is modified.
+   */
+  void markShardDirty(InodeNumber inodeNumber);
+
  private:
   /** Path to ".eden/CLIENT/local" */
   const AbsolutePath localDir_;
@@ -257,6 +319,12 @@ class FsOverlay : public IOverlay {
    * We maintain this so we can use openat(), unlinkat(), etc.
    */
   folly::File dirFile_;
+
+  /**
+   * Which shards have an on-disk dirty marker, so that the marker is only
+   * created by the first modification to each shard.
+   */
+  std::array<std::atomic<bool>, kNumShards> dirtyShards_{};
 };
 
 class InodePath {
@@ -13,6 +13,10 @@
 #include <fcntl.h>
 #include <time.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 #include <folly/Conv.h>
 #include <folly/ExceptionWrapper.h>
@@ -654,13 +658,42 @@ class OverlayChecker::BadNextInodeNumber : public OverlayChecker::Error {
 
 OverlayChecker::OverlayChecker(
     FsOverlay* fs,
-    optional<InodeNumber> nextInodeNumber)
-    : fs_(fs), loadedNextInodeNumber_(nextInodeNumber) {}
+    optional<InodeNumber> nextInodeNumber,
+    const OverlayDirtyShards* dirtyShards,
+    size_t numScanThreads)
+    : fs_(fs),
+      loadedNextInodeNumber_(nextInodeNumber),
+      numScanThreads_(std::max<size_t>(numScanThreads, 1)) {
+  scannedShards_.resize(FsOverlay::kNumShards, dirtyShards == nullptr);
+  if (dirtyShards) {
+    // Inodes below the base that are not in a dirty shard are unchanged, and
+    // the others could only have been allocated since, so the base bounds
+    // the inode numbers that the scan does not see.
+    baseInodeNumber_ = dirtyShards->baseInodeNumber;
+    maxInodeNumber_ =
+        std::max(maxInodeNumber_, dirtyShards->baseInodeNumber.get() - 1);
+    for (auto shardID : dirtyShards->shards) {
+      if (shardID < FsOverlay::kNumShards && !scannedShards_[shardID]) {
+        scannedShards_[shardID] = true;
+        shardsToScan_.push_back(shardID);
+      }
+    }
+  } else {
+    for (ShardID shardID = 0; shardID < FsOverlay::kNumShards; ++shardID) {
+      shardsToScan_.push_back(shardID);
+    }
+  }
+}
 
 OverlayChecker::~OverlayChecker() {}
 
 void OverlayChecker::scanForErrors(const ProgressCallback& progressCallback) {
-  XLOG(INFO) << "Starting fsck scan on overlay " << fs_->getLocalDir();
+  if (baseInodeNumber_) {
+    XLOG(INFO) << "Starting fsck scan of " << shardsToScan_.size()
+               << " dirty shards on overlay " << fs_->getLocalDir();
+  } else {
+    XLOG(INFO) << "Starting fsck scan on overlay " << fs_->getLocalDir();
+  }
   if (auto callback = progressCallback) {
     callback(0);
   }
@@ -857,26 +890,67 @@ PathComponent OverlayChecker::findChildName(
 }
 
 void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
-  // Walk through all of the sharded subdirectories
+  // Walk through all of the sharded subdirectories. Reading the inodes is
+  // dominated by I/O latency, so several shards are read at once, each by
+  // whichever thread claims it next.
+  std::vector<ShardScan> scans(FsOverlay::kNumShards);
+  std::atomic<size_t> nextShard{0};
+  std::mutex progressMutex;
+  uint32_t shardsDone = 0;
   uint32_t progress10pct = 0;
-  std::array<char, 2> subdirBuffer;
-  MutableStringPiece subdir{subdirBuffer.data(), subdirBuffer.size()};
-  for (uint32_t shardID = 0; shardID < FsOverlay::kNumShards; ++shardID) {
-    // Log a INFO message every 10% done
-    uint32_t progress = (10 * shardID) / FsOverlay::kNumShards;
-    if (progress > progress10pct) {
-      XLOG(INFO) << "fsck:" << fs_->getLocalDir() << ": scan " << progress
-                 << "0% complete: " << inodes_.size() << " inodes scanned";
-      if (auto callback = progressCallback) {
-        callback(progress);
+  size_t inodesScanned = 0;
+
+  auto scanShards = [&] {
+    std::array<char, 2> subdirBuffer;
+    MutableStringPiece subdir{subdirBuffer.data(), subdirBuffer.size()};
+    while (true) {
+      auto index = nextShard.fetch_add(1, std::memory_order_relaxed);
+      if (index >= shardsToScan_.size()) {
+        return;
+      }
+      auto shardID = shardsToScan_[index];
+      FsOverlay::formatSubdirShardPath(shardID, subdir);
+      auto subdirPath = fs_->getLocalDir() + PathComponentPiece{subdir};
+      readInodeSubdir(subdirPath, shardID, scans[shardID]);
+
+      // Log a INFO message every 10% done
+      std::lock_guard<std::mutex> lock{progressMutex};
+      ++shardsDone;
+      inodesScanned += scans[shardID].inodes.size();
+      uint32_t progress = (10 * shardsDone) / shardsToScan_.size();
+      if (progress > progress10pct && progress < 10) {
+        XLOG(INFO) << "fsck:" << fs_->getLocalDir() << ": scan " << progress
+                   << "0% complete: " << inodesScanned << " inodes scanned";
+        if (auto callback = progressCallback) {
+          callback(progress);
+        }
+        progress10pct = progress;
       }
-      progress10pct = progress;
     }
-    FsOverlay::formatSubdirShardPath(shardID, subdir);
-    auto subdirPath = fs_->getLocalDir() + PathComponentPiece{subdir};
+  };
+
+  auto numThreads = std::min<size_t>(numScanThreads_, shardsToScan_.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < numThreads; ++i) {
+    threads.emplace_back(scanShards);
+  }
+  scanShards();
+  for (auto& thread : threads) {
+    thread.join();
+  }
 
-    readInodeSubdir(subdirPath, shardID);
+  for (auto& scan : scans) {
+    if (scan.maxInodeNumber > maxInodeNumber_) {
+      maxInodeNumber_ = scan.maxInodeNumber;
+    }
+    for (auto& [number, info] : scan.inodes) {
+      inodes_.emplace(number, std::move(info));
+    }
+    for (auto& error : scan.errors) {
+      addError(std::move(error));
+    }
   }
+
   if (auto callback = progressCallback) {
     callback(10);
   }
@@ -886,14 +960,16 @@ void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
 
 void OverlayChecker::readInodeSubdir(
     const AbsolutePath& path,
-    ShardID shardID) {
+    ShardID shardID,
+    ShardScan& scan) {
   XLOG(DBG5) << "fsck:" << fs_->getLocalDir() << ": scanning " << path;
 
   boost::system::error_code error;
   auto boostPath = boost::filesystem::path{path.value().c_str()};
   auto iterator = boost::filesystem::directory_iterator(boostPath, error);
   if (error.value() != 0) {
-    addError<ShardDirectoryEnumerationError>(path, error);
+    scan.errors.push_back(
+        std::make_unique<ShardDirectoryEnumerationError>(path, error));
     return;
   }
 
@@ -904,37 +980,44 @@ void OverlayChecker::readInodeSubdir(
     auto entryInodeNumber =
         folly::tryTo<uint64_t>(inodePath.basename().value());
     if (entryInodeNumber.hasValue()) {
-      loadInode(InodeNumber(*entryInodeNumber), shardID);
+      loadInode(InodeNumber(*entryInodeNumber), shardID, scan);
     } else {
-      addError<UnexpectedOverlayFile>(inodePath);
+      scan.errors.push_back(std::make_unique<UnexpectedOverlayFile>(inodePath));
     }
 
     iterator.increment(error);
     if (error.value() != 0) {
-      addError<ShardDirectoryEnumerationError>(path, error);
+      scan.errors.push_back(
+          std::make_unique<ShardDirectoryEnumerationError>(path, error));
       break;
     }
   }
 }
 
-void OverlayChecker::loadInode(InodeNumber number, ShardID shardID) {
+void OverlayChecker::loadInode(
+    InodeNumber number,
+    ShardID shardID,
+    ShardScan& scan) {
   XLOG(DBG9) << "fsck: loading inode " << number;
-  updateMaxInodeNumber(number);
+  scan.maxInodeNumber = std::max(scan.maxInodeNumber, number.get());
 
   // Verify that we found this inode in the correct shard subdirectory.
   // Ignore the data if it is in the wrong directory.
   ShardID expectedShard = static_cast<ShardID>(number.get() & 0xff);
   if (expectedShard != shardID) {
-    addError<UnexpectedInodeShard>(number, shardID);
+    scan.errors.push_back(
+        std::make_unique<UnexpectedInodeShard>(number, shardID));
     return;
   }
 
-  inodes_.emplace(number, loadInodeInfo(number));
+  scan.inodes.emplace_back(number, loadInodeInfo(number, scan));
 }
 
-OverlayChecker::InodeInfo OverlayChecker::loadInodeInfo(InodeNumber number) {
-  auto inodeError = [this, number](auto&&... args) {
-    addError<InodeDataError>(number, args...);
+OverlayChecker::InodeInfo OverlayChecker::loadInodeInfo(
+    InodeNumber number,
+    ShardScan& scan) {
+  auto inodeError = [&scan, number](auto&&... args) {
+    scan.errors.push_back(std::make_unique<InodeDataError>(number, args...));
     return InodeInfo(number, InodeType::Error);
   };
 
@@ -1030,6 +1113,11 @@ void OverlayChecker::linkInodeChildren() {
       auto childInodeNumber = InodeNumber(childRawInode);
       updateMaxInodeNumber(childInodeNumber);
       auto childInfo = getInodeInfo(childInodeNumber);
+      if (!childInfo && !isShardScanned(childInodeNumber)) {
+        // The child was not modified since the overlay was last consistent,
+        // so its data is where it was then.
+        continue;
+      }
       if (!childInfo) {
         const auto& hash = child.hash_ref();
         if (!hash.has_value() || hash->empty()) {
@@ -1052,7 +1140,11 @@ void OverlayChecker::linkInodeChildren() {
 void OverlayChecker::scanForParentErrors() {
   for (const auto& [inodeNumber, inodeInfo] : inodes_) {
     if (inodeInfo.parents.empty()) {
-      if (inodeNumber != kRootNodeId) {
+      // Directories outside the dirty shards were not scanned, and may be
+      // the parents of inodes that existed before the base.  Only inodes
+      // allocated since can be known to be orphans.
+      if (inodeNumber != kRootNodeId &&
+          (!baseInodeNumber_ || inodeNumber >= *baseInodeNumber_)) {
         addError<OrphanInode>(inodeInfo);
       }
     } else if (inodeInfo.parents.size() != 1) {
@@ -9,6 +9,8 @@
 
 #include <memory>
 #include <optional>
+#include <utility>
+#include <vector>
 
 #include <folly/CppAttributes.h>
 #include <folly/small_vector.h>
@@ -25,6 +27,7 @@ namespace facebook {
 namespace eden {
 
 class FsOverlay;
+struct OverlayDirtyShards;
 
 /**
  * OverlayChecker performs "fsck" operations on the on-disk overlay data.
@@ -56,11 +59,24 @@ class OverlayChecker {
    * The OverlayChecker stores a raw pointer to the FsOverlay for the duration
    * of the check operation.  The caller is responsible for ensuring that the
    * FsOverlay object exists for at least as long as the OverlayChecker object.
+   *
+   * If dirtyShards is set, only the shards it lists are checked, and the rest
+   * of the overlay is assumed to be as consistent as it was at that point.
+   * Otherwise the whole overlay is checked.
+   *
+   * The shard directories of the overlay are read by up to numScanThreads
+   * threads at once.
    */
-  OverlayChecker(FsOverlay* fs, std::optional<InodeNumber> nextInodeNumber);
+  OverlayChecker(
+      FsOverlay* fs,
+      std::optional<InodeNumber> nextInodeNumber,
+      const OverlayDirtyShards* dirtyShards = nullptr,
+      size_t numScanThreads = kDefaultNumScanThreads);
 
   ~OverlayChecker();
 
+  static constexpr size_t kDefaultNumScanThreads = 8;
+
   using ProgressCallback = std::function<void(uint16_t)>;
 
   /**
@@ -187,10 +203,26 @@ class OverlayChecker {
   PathInfo cachedPathComputation(InodeNumber number, Fn&& fn);
 
   using ShardID = uint32_t;
+
+  /**
+   * What was found in one shard directory of the overlay.
+   *
+   * Shards are read concurrently, each into its own ShardScan, and merged in
+   * shard order so that the results do not depend on the scheduling.
+   */
+  struct ShardScan {
+    std::vector<std::pair<InodeNumber, InodeInfo>> inodes;
+    std::vector<std::unique_ptr<Error>> errors;
+    uint64_t maxInodeNumber{0};
+  };
+
   void readInodes(const ProgressCallback& progressCallback = [](auto) {});
-  void readInodeSubdir(const AbsolutePath& path, ShardID shardID);
-  void loadInode(InodeNumber number, ShardID shardID);
-  InodeInfo loadInodeInfo(InodeNumber number);
+  void readInodeSubdir(
+      const AbsolutePath& path,
+      ShardID shardID,
+      ShardScan& scan);
+  void loadInode(InodeNumber number, ShardID shardID, ShardScan& scan);
+  InodeInfo loadInodeInfo(InodeNumber number, ShardScan& scan);
   overlay::OverlayDir loadDirectoryChildren(folly::File& file);
 
   void linkInodeChildren();
@@ -203,6 +235,10 @@ class OverlayChecker {
   }
   void addError(std::unique_ptr<Error> error);
 
+  bool isShardScanned(InodeNumber number) const {
+    return scannedShards_[number.get() & 0xff];
+  }
+
   void updateMaxInodeNumber(InodeNumber number) {
     if (number.get() > maxInodeNumber_) {
       maxInodeNumber_ = number.get();
@@ -211,6 +247,11 @@ class OverlayChecker {
 
   FsOverlay* const fs_;
   std::optional<InodeNumber> loadedNextInodeNumber_;
+  size_t const numScanThreads_;
+  // Set when only the dirty shards are checked.
+  std::optional<InodeNumber> baseInodeNumber_;
+  std::vector<ShardID> shardsToScan_;
+  std::vector<bool> scannedShards_;
   std::unordered_map<InodeNumber, InodeInfo> inodes_;
   std::vector<std::unique_ptr<Error>> errors_;
   uint64_t maxInodeNumber_{kRootNodeId.get()};
@@ -5,6 +5,7 @@
  * GNU General Public License version 2.
  */
 
+#include <algorithm>
 #include <memory>
 
 #include <folly/Conv.h>
@@ -435,6 +436,89 @@ TEST(Fsck, testBadFileData) {
   overlay->fs().close(checker.getNextInodeNumber());
 }
 
+TEST(Fsck, testScanResultsDoNotDependOnThreadCount) {
+  auto overlay = make_shared<TestOverlay>();
+  auto root = overlay->init();
+  SimpleOverlayLayout layout(root);
+  std::string badHeader(FsOverlay::kHeaderLength, 0x55);
+  overlay->corruptInodeHeader(layout.src_foo_testTxt.number(), badHeader);
+  overlay->corruptInodeHeader(layout.src_foo_x_y_zTxt.number(), badHeader);
+
+  OverlayChecker serialChecker(&overlay->fs(), std::nullopt, nullptr, 1);
+  serialChecker.scanForErrors();
+  ASSERT_EQ(2, serialChecker.getErrors().size());
+
+  std::vector<uint16_t> progress;
+  OverlayChecker parallelChecker(&overlay->fs(), std::nullopt, nullptr, 16);
+  parallelChecker.scanForErrors(
+      [&progress](uint16_t percent) { progress.push_back(percent); });
+  EXPECT_EQ(errorMessages(serialChecker), errorMessages(parallelChecker));
+  EXPECT_EQ(
+      serialChecker.getNextInodeNumber(), parallelChecker.getNextInodeNumber());
+
+  // Progress is reported in increasing order even though shards complete out
+  // of order, and ends at 100%.
+  ASSERT_FALSE(progress.empty());
+  EXPECT_TRUE(std::is_sorted(progress.begin(), progress.end()));
+  EXPECT_EQ(10, progress.back());
+
+  overlay->fs().close(parallelChecker.getNextInodeNumber());
+}
+
+TEST(Fsck, testDirtyShardsAfterUncleanShutdown) {
+  auto overlay = make_shared<TestOverlay>();
+  auto root = overlay->init();
+  SimpleOverlayLayout layout(root);
+  auto nextInodeNumber = overlay->getNextInodeNumber();
+  overlay->closeCleanly();
+
+  std::string badHeader(FsOverlay::kHeaderLength, 0x55);
+  {
+    FsOverlay fs(overlay->overlayPath());
+    ASSERT_EQ(nextInodeNumber, fs.initOverlay(/*createIfNonExisting=*/false));
+    // Corrupt one file through the overlay, and another one behind its back.
+    auto file = fs.openFileNoVerify(layout.src_foo_testTxt.number());
+    folly::checkUnixError(
+        folly::pwriteFull(file.fd(), badHeader.data(), badHeader.size(), 0));
+    auto otherPath = fs.getAbsoluteFilePath(layout.src_foo_x_y_zTxt.number());
+    writeFile(otherPath, ByteRange{StringPiece{badHeader}}).value();
+    // Close without saving the next inode number, as a crash would.
+    fs.close(std::nullopt);
+  }
+
+  FsOverlay fs(overlay->overlayPath());
+  EXPECT_FALSE(fs.initOverlay(/*createIfNonExisting=*/false).has_value());
+  auto dirtyShards = fs.loadDirtyShards();
+  ASSERT_TRUE(dirtyShards.has_value());
+  EXPECT_EQ(nextInodeNumber, dirtyShards->baseInodeNumber);
+  EXPECT_THAT(
+      dirtyShards->shards,
+      UnorderedElementsAre(layout.src_foo_testTxt.number().get() & 0xff));
+
+  // Only the shard that was modified through the overlay is checked.
+  OverlayChecker checker(&fs, std::nullopt, &*dirtyShards);
+  checker.scanForErrors();
+  EXPECT_THAT(
+      errorMessages(checker),
+      UnorderedElementsAre(folly::to<string>(
+          "error reading data for inode ",
+          layout.src_foo_testTxt.number(),
+          ": unknown overlay file format version ",
+          0x55555555)));
+  EXPECT_EQ(nextInodeNumber, checker.getNextInodeNumber());
+
+  OverlayChecker fullChecker(&fs, std::nullopt);
+  fullChecker.scanForErrors();
+  EXPECT_EQ(2, fullChecker.getErrors().size());
+
+  // Once the overlay has been checked, no shard is dirty.
+  fs.clearDirtyShards(checker.getNextInodeNumber());
+  dirtyShards = fs.loadDirtyShards();
+  ASSERT_TRUE(dirtyShards.has_value());
+  EXPECT_THAT(dirtyShards->shards, UnorderedElementsAre());
+  fs.close(checker.getNextInodeNumber());
+}
+
 TEST(Fsck, testTruncatedDirData) {
   auto overlay = make_shared<TestOverlay>();
   auto root = overlay->init();
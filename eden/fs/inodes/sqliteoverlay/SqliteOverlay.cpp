@@ -36,18 +36,34 @@ constexpr uint64_t kStartInodeNumber = 100;
 // shutdown. More details in the header file.
 constexpr uint64_t kInodeAllocationRange = 100;
 
+// The number of connections serving reads. In WAL mode they run concurrently
+// with each other and with writes.
+constexpr size_t kReadConnections = 4;
+
+namespace {
+const std::string& loadInodeSql() {
+  static const auto sql = folly::to<std::string>(
+      "select value from ", kInodeTable, " where inode = ?");
+  return sql;
+}
+
+const std::string& hasInodeSql() {
+  static const auto sql =
+      folly::to<std::string>("select 1 from ", kInodeTable, " where inode = ?");
+  return sql;
+}
+} // namespace
+
 struct SqliteOverlay::StatementCache {
   explicit StatementCache(SqliteDatabase::Connection& db)
-      : hasInode{db, "select 1 from ", kInodeTable, " where inode = ?"},
-        // TODO: we need `or ignore` otherwise we hit primary key violations
-        // when running our integration tests.  This implies that we're
-        // over-fetching and that we have a perf improvement opportunity.
-        insertInode{
+      // TODO: we need `or ignore` otherwise we hit primary key violations
+      // when running our integration tests.  This implies that we're
+      // over-fetching and that we have a perf improvement opportunity.
+      : insertInode{
             db,
             "insert or replace into ",
             kInodeTable,
             " values (?,?,?)"},
-        loadInode{db, "select value from ", kInodeTable, " where inode = ?"},
         deleteInode{db, "delete from ", kInodeTable, " where inode = ?"},
         writeInodeNumber{
             db,
@@ -60,9 +76,7 @@ struct SqliteOverlay::StatementCache {
             kConfigTable,
             " where key = ?"} {}
 
-  PersistentSqliteStatement hasInode;
   PersistentSqliteStatement insertInode;
-  PersistentSqliteStatement loadInode;
   PersistentSqliteStatement deleteInode;
   PersistentSqliteStatement writeInodeNumber;
   PersistentSqliteStatement readInodeNumber;
@@ -131,6 +145,10 @@ std::optional<InodeNumber> SqliteOverlay::initOverlay(
   writeNextInodeNumber(db, nextValue);
   nextInodeNumber_.store(nextValue, std::memory_order_release);
 
+  // The tables must exist before the read connections are opened.
+  db.unlock();
+  db_->openReaders(kReadConnections);
+
   // The only reason we return an optional value is to have a common interface
   // with FsOverlay. This would change once we have implement OverlayChecker.
   return std::make_optional(InodeNumber{nextInodeNumber});
@@ -149,9 +167,9 @@ void SqliteOverlay::updateUsedInodeNumber(uint64_t usedInodeNumber) {
 }
 
 std::optional<std::string> SqliteOverlay::load(uint64_t inodeNumber) {
-  auto db = db_->lock();
+  auto reader = db_->lockReader();
 
-  auto& stmt = cache_->loadInode.get(db);
+  auto& stmt = reader.statement(loadInodeSql());
 
   // Bind the inode; parameters are 1-based
   stmt.bind(1, inodeNumber);
@@ -167,9 +185,9 @@ std::optional<std::string> SqliteOverlay::load(uint64_t inodeNumber) {
 }
 
 bool SqliteOverlay::hasInode(uint64_t inodeNumber) {
-  auto db = db_->lock();
+  auto reader = db_->lockReader();
 
-  auto& stmt = cache_->hasInode.get(db);
+  auto& stmt = reader.statement(hasInodeSql());
 
   stmt.bind(1, inodeNumber);
   return stmt.step();
@@ -293,6 +311,12 @@ folly::File SqliteOverlay::createOverlayFile(
   EDEN_BUG() << "UNIMPLEMENTED";
 }
 
+std::optional<folly::File> SqliteOverlay::cloneOverlayFile(
+    InodeNumber /*inodeNumber*/,
+    const folly::File& /*source*/) {
+  return std::nullopt;
+}
+
 folly::File SqliteOverlay::openFile(
     InodeNumber /*inodeNumber*/,
     folly::StringPiece /*headerId*/) {
@@ -99,6 +99,10 @@ class SqliteOverlay : public IOverlay {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) override;
 
+  std::optional<folly::File> cloneOverlayFile(
+      InodeNumber inodeNumber,
+      const folly::File& source) override;
+
   folly::File openFile(InodeNumber inodeNumber, folly::StringPiece headerId)
       override;
 
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/inodes/BlobFileStore.h"
+
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+#include <string>
+
+#include "eden/fs/inodes/overlay/FsOverlay.h"
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+
+namespace {
+ObjectId makeId(uint8_t i) {
+  return ObjectId{folly::ByteRange{&i, 1}};
+}
+
+AbsolutePath blobsDir(const folly::test::TemporaryDirectory& tmpDir) {
+  return realpath(tmpDir.path().string()) + "blobs"_pc;
+}
+
+std::string readAll(const folly::File& file) {
+  std::string contents;
+  EXPECT_TRUE(folly::readFile(file.fd(), contents));
+  return contents;
+}
+} // namespace
+
+TEST(BlobFileStore, small_blobs_are_not_kept) {
+  auto tmpDir = makeTempDir();
+  BlobFileStore store{blobsDir(tmpDir), 1024, 10};
+  EXPECT_FALSE(store.getFile(Blob{makeId(1), "small"}).has_value());
+  EXPECT_EQ(0, store.getTotalBytes());
+}
+
+TEST(BlobFileStore, blob_files_are_overlay_file_images) {
+  auto tmpDir = makeTempDir();
+  BlobFileStore store{blobsDir(tmpDir), 1024, 0};
+  Blob blob{makeId(1), "some file contents"};
+
+  auto file = store.getFile(blob);
+  ASSERT_TRUE(file.has_value());
+  auto contents = readAll(*file);
+  ASSERT_EQ(FsOverlay::kHeaderLength + blob.getSize(), contents.size());
+  EXPECT_EQ(
+      FsOverlay::kHeaderIdentifierFile,
+      folly::StringPiece{contents}.subpiece(
+          0, FsOverlay::kHeaderIdentifierFile.size()));
+  EXPECT_EQ(
+      "some file contents",
+      folly::StringPiece{contents}.subpiece(FsOverlay::kHeaderLength));
+  EXPECT_EQ(contents.size(), store.getTotalBytes());
+
+  // The file is written once.
+  ASSERT_TRUE(store.getFile(blob).has_value());
+  EXPECT_EQ(contents.size(), store.getTotalBytes());
+}
+
+TEST(BlobFileStore, stops_writing_files_when_full) {
+  auto tmpDir = makeTempDir();
+  auto directory = blobsDir(tmpDir);
+  auto fileSize = FsOverlay::kHeaderLength + 10;
+  BlobFileStore store{directory, fileSize, 0};
+  ASSERT_TRUE(store.getFile(Blob{makeId(1), "0123456789"}).has_value());
+  EXPECT_FALSE(store.getFile(Blob{makeId(2), "9876543210"}).has_value());
+  EXPECT_EQ(fileSize, store.getTotalBytes());
+
+  // The files written by a previous instance count towards the limit.
+  BlobFileStore reopened{directory, fileSize, 0};
+  EXPECT_EQ(fileSize, reopened.getTotalBytes());
+  EXPECT_TRUE(reopened.getFile(Blob{makeId(1), "0123456789"}).has_value());
+  EXPECT_FALSE(reopened.getFile(Blob{makeId(2), "9876543210"}).has_value());
+}
+
+TEST(BlobFileStore, disabled_store_returns_nothing) {
+  auto tmpDir = makeTempDir();
+  BlobFileStore store{blobsDir(tmpDir), 1024, 0};
+  store.disable();
+  EXPECT_FALSE(store.isEnabled());
+  EXPECT_FALSE(store.getFile(Blob{makeId(1), "contents"}).has_value());
+}
+
+#endif
@@ -946,6 +946,117 @@ TEST(Checkout, checkoutModifiesDirectoryDuringLoad) {
       1, inode->getContents().rlock()->entries.count("differentfile.txt"_pc));
 }
 
+TEST(Checkout, prefetchesTreesOfLoadedDirectoriesOnly) {
+  auto builder1 = FakeTreeBuilder();
+  builder1.setFile("a/x/1.txt", "1\n");
+  builder1.setFile("b/y/2.txt", "2\n");
+  builder1.setFile("c/z/3.txt", "3\n");
+  TestMount testMount{builder1};
+
+  testMount.getTreeInode("a/x");
+  testMount.getTreeInode("b/y");
+
+  auto builder2 = builder1.clone();
+  builder2.replaceFile("a/x/1.txt", "1 v2\n");
+  builder2.replaceFile("b/y/2.txt", "2 v2\n");
+  builder2.replaceFile("c/z/3.txt", "3 v2\n");
+  builder2.finalize(testMount.getBackingStore(), true);
+  testMount.getBackingStore()->putCommit("2", builder2)->setReady();
+
+  auto executor = testMount.getServerExecutor().get();
+  auto checkoutResult = testMount.getEdenMount()
+                            ->checkout(RootId("2"), std::nullopt, __func__)
+                            .waitVia(executor);
+  ASSERT_TRUE(checkoutResult.isReady());
+  auto result = std::move(checkoutResult).get();
+  EXPECT_EQ(0, result.conflicts.size());
+  EXPECT_NE(
+      std::chrono::steady_clock::duration{}, result.times.didPrefetchTrees);
+
+  EXPECT_FILE_INODE(testMount.getFileInode("a/x/1.txt"), "1 v2\n", 0644);
+  EXPECT_FILE_INODE(testMount.getFileInode("b/y/2.txt"), "2 v2\n", 0644);
+
+  // "c" was not loaded, so checkout swaps its hash without looking at its
+  // children, and neither does the prefetch.
+  auto newChildOfC = builder2.getStoredTree("c/z"_relpath)->get().getHash();
+  EXPECT_EQ(0, testMount.getBackingStore()->getAccessCount(newChildOfC));
+}
+
+TEST(Checkout, unloadedDirectoriesKeepTheirInodeNumber) {
+  auto builder1 = FakeTreeBuilder();
+  builder1.setFile("a/x/1.txt", "1\n");
+  builder1.setFile("c/z/3.txt", "3\n");
+  TestMount testMount{builder1};
+  auto root = testMount.getEdenMount()->getRootInode();
+  auto dirNumber = root->getChildInodeNumber("c"_pc);
+
+  auto builder2 = builder1.clone();
+  builder2.replaceFile("c/z/3.txt", "3 v2\n");
+  builder2.finalize(testMount.getBackingStore(), true);
+  testMount.getBackingStore()->putCommit("2", builder2)->setReady();
+
+  auto executor = testMount.getServerExecutor().get();
+  auto checkoutResult = testMount.getEdenMount()
+                            ->checkout(RootId("2"), std::nullopt, __func__)
+                            .waitVia(executor);
+  ASSERT_TRUE(checkoutResult.isReady());
+  EXPECT_EQ(0, std::move(checkoutResult).get().conflicts.size());
+
+  // "c" now points at the new tree, without being loaded or written to the
+  // overlay.
+  EXPECT_EQ(dirNumber, root->getChildInodeNumber("c"_pc));
+  EXPECT_FALSE(testMount.getEdenMount()->getInodeMap()->lookupLoadedInode(
+      dirNumber));
+  EXPECT_FALSE(testMount.hasOverlayData(dirNumber));
+  EXPECT_FILE_INODE(testMount.getFileInode("c/z/3.txt"), "3 v2\n", 0644);
+}
+
+TEST(Checkout, dryRunFindsConflictsInUnloadedDirectories) {
+  auto builder1 = FakeTreeBuilder();
+  builder1.setFile("d/x.txt", "1\n");
+  builder1.setFile("d/y.txt", "unchanged\n");
+  builder1.setFile("d/new.txt", "local\n");
+  TestMount testMount{RootId{"1"}, builder1};
+  auto backingStore = testMount.getBackingStore();
+
+  auto builder2 = FakeTreeBuilder();
+  builder2.setFile("d/x.txt", "2\n");
+  builder2.setFile("d/y.txt", "unchanged\n");
+  builder2.setFile("d/w.txt", "w\n");
+  builder2.finalize(backingStore, true);
+  backingStore->putCommit("2", builder2)->setReady();
+
+  auto builder3 = FakeTreeBuilder();
+  builder3.setFile("d/x.txt", "3\n");
+  builder3.setFile("d/y.txt", "unchanged\n");
+  builder3.setFile("d/w.txt", "w v3\n");
+  builder3.setFile("d/new.txt", "new\n");
+  builder3.finalize(backingStore, true);
+  backingStore->putCommit("3", builder3)->setReady();
+
+  // The working copy keeps the contents of commit 1, so "d" has conflicts
+  // even though it is neither loaded nor materialized.
+  testMount.getEdenMount()->resetParent(RootId{"2"});
+
+  auto executor = testMount.getServerExecutor().get();
+  auto checkoutResult =
+      testMount.getEdenMount()
+          ->checkout(RootId{"3"}, std::nullopt, __func__, CheckoutMode::DRY_RUN)
+          .waitVia(executor);
+  ASSERT_TRUE(checkoutResult.isReady());
+  EXPECT_THAT(
+      std::move(checkoutResult).get().conflicts,
+      UnorderedElementsAre(
+          makeConflict(ConflictType::MODIFIED_MODIFIED, "d/x.txt"),
+          makeConflict(ConflictType::REMOVED_MODIFIED, "d/w.txt"),
+          makeConflict(ConflictType::UNTRACKED_ADDED, "d/new.txt")));
+
+  auto dirNumber =
+      testMount.getEdenMount()->getRootInode()->getChildInodeNumber("d"_pc);
+  EXPECT_FALSE(testMount.getEdenMount()->getInodeMap()->lookupLoadedInode(
+      dirNumber));
+}
+
 TEST(Checkout, checkoutCaseChanged) {
   auto builder1 = FakeTreeBuilder{};
   builder1.setFile("root", "root");
@@ -1375,6 +1486,68 @@ TEST(Checkout, testSetPathObjectIdLastCheckoutTime) {
   EXPECT_EQ(nsec2.count(), stFile2.mtime.toTimespec().tv_nsec);
 }
 
+TEST(Checkout, testSetPathsToObjectIds) {
+  auto builder1 = FakeTreeBuilder{};
+  builder1.setFile("dir/file.txt", "contents");
+  TestMount testMount{builder1};
+
+  auto builder2 = FakeTreeBuilder{};
+  builder2.setFile("file2.txt", "contents2");
+  builder2.finalize(testMount.getBackingStore(), true);
+  testMount.getBackingStore()->putCommit("2", builder2)->setReady();
+
+  auto builder3 = FakeTreeBuilder{};
+  builder3.setFile("file3.txt", "contents3");
+  builder3.finalize(testMount.getBackingStore(), true);
+  testMount.getBackingStore()->putCommit("3", builder3)->setReady();
+
+  std::vector<SetPathObjectIdObjectAndPath> objects;
+  objects.push_back(SetPathObjectIdObjectAndPath{
+      RelativePath{"dir/a"}, RootId{"2"}, facebook::eden::ObjectType::TREE});
+  objects.push_back(SetPathObjectIdObjectAndPath{
+      RelativePath{"new/b"}, RootId{"3"}, facebook::eden::ObjectType::TREE});
+  objects.push_back(SetPathObjectIdObjectAndPath{
+      RelativePath{"new/c"}, RootId{"2"}, facebook::eden::ObjectType::TREE});
+  auto resultFuture = testMount.getEdenMount()->setPathsToObjectIds(
+      std::move(objects),
+      facebook::eden::CheckoutMode::NORMAL,
+      ObjectFetchContext::getNullContext());
+
+  auto executor = testMount.getServerExecutor().get();
+  auto waitedResult = std::move(resultFuture).waitVia(executor);
+  ASSERT_TRUE(waitedResult.isReady());
+  auto result = std::move(waitedResult).get();
+  EXPECT_EQ(0, result.result.conflicts_ref()->size());
+
+  EXPECT_FILE_INODE(testMount.getFileInode("dir/file.txt"), "contents", 0644);
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("dir/a/file2.txt"), "contents2", 0644);
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("new/b/file3.txt"), "contents3", 0644);
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("new/c/file2.txt"), "contents2", 0644);
+  // The parent is only updated once, to the last object.
+  EXPECT_EQ(RootId{"2"}, testMount.getEdenMount()->getParentCommit());
+}
+
+TEST(Checkout, testSetPathsToObjectIdsRejectsNestedTrees) {
+  auto builder1 = FakeTreeBuilder{};
+  builder1.setFile("dir/file.txt", "contents");
+  TestMount testMount{builder1};
+
+  std::vector<SetPathObjectIdObjectAndPath> objects;
+  objects.push_back(SetPathObjectIdObjectAndPath{
+      RelativePath{"dir"}, RootId{"2"}, facebook::eden::ObjectType::TREE});
+  objects.push_back(SetPathObjectIdObjectAndPath{
+      RelativePath{"dir/sub"}, RootId{"3"}, facebook::eden::ObjectType::TREE});
+  EXPECT_THROW(
+      testMount.getEdenMount()->setPathsToObjectIds(
+          std::move(objects),
+          facebook::eden::CheckoutMode::NORMAL,
+          ObjectFetchContext::getNullContext()),
+      EdenError);
+}
+
 #endif
 
 namespace {
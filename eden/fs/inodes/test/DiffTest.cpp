@@ -6,12 +6,14 @@
  */
 
 #include <folly/ExceptionWrapper.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
 
 #include "eden/fs/config/CheckoutConfig.h"
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/model/git/TopLevelIgnores.h"
@@ -102,12 +104,16 @@ class DiffTest {
     EXPECT_FUTURE_RESULT(diffFuture);
     return callback.extractStatus();
   }
-  folly::Future<ScmStatus> diffFuture(bool listIgnored = false) {
+  folly::Future<ScmStatus> diffFuture(
+      bool listIgnored = false,
+      bool summarizeUntrackedDirectories = false) {
     auto commitHash = mount_.getEdenMount()->getParentCommit();
     auto diffFuture = mount_.getEdenMount()->diff(
         commitHash,
         listIgnored,
-        /*enforceCurrentParent=*/false);
+        /*enforceCurrentParent=*/false,
+        /*request=*/nullptr,
+        summarizeUntrackedDirectories);
     return std::move(diffFuture)
         .thenValue([](std::unique_ptr<ScmStatus>&& result) { return *result; });
   }
@@ -218,6 +224,78 @@ TEST(DiffTest, fileAdded) {
           std::make_pair("src/new.txt", ScmFileStatus::ADDED)));
 }
 
+TEST(DiffTest, parallelDiff) {
+  DiffTest test;
+  test.getMount().overwriteFile("src/1.txt", "This file has been updated.\n");
+  test.getMount().overwriteFile("src/a/b/3.txt", "updated 3.txt\n");
+  test.getMount().overwriteFile("src/a/b/c/4.txt", "updated 4.txt\n");
+  test.getMount().overwriteFile("doc/readme.txt", "updated readme\n");
+  test.getMount().addFile("src/a/new.txt", "extra stuff");
+
+  folly::CPUThreadPoolExecutor executor{4};
+  ScmStatusDiffCallback callback;
+  DiffContext diffContext{
+      &callback,
+      /*listIgnored=*/false,
+      kPathMapDefaultCaseSensitive,
+      test.getMount().getEdenMount()->getObjectStore(),
+      std::make_unique<TopLevelIgnores>("", ""),
+      nullptr,
+      nullptr,
+      folly::getKeepAliveToken(&executor),
+      /*maxParallelDiffs=*/2};
+  auto edenMount = test.getMount().getEdenMount();
+  edenMount->diff(&diffContext, edenMount->getParentCommit()).get(10s);
+
+  auto result = callback.extractStatus();
+  EXPECT_THAT(*result.errors_ref(), UnorderedElementsAre());
+  EXPECT_THAT(
+      *result.entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/1.txt", ScmFileStatus::MODIFIED),
+          std::make_pair("src/a/b/3.txt", ScmFileStatus::MODIFIED),
+          std::make_pair("src/a/b/c/4.txt", ScmFileStatus::MODIFIED),
+          std::make_pair("doc/readme.txt", ScmFileStatus::MODIFIED),
+          std::make_pair("src/a/new.txt", ScmFileStatus::ADDED)));
+}
+
+TEST(DiffTest, incrementalStatus) {
+  DiffTest test;
+  test.getMount().getEdenConfig()->incrementalStatus.setValue(
+      true, ConfigSource::CommandLine);
+
+  auto initial = test.diffFuture();
+  EXPECT_THAT(
+      *EXPECT_FUTURE_RESULT(initial).entries_ref(), UnorderedElementsAre());
+
+  test.getMount().overwriteFile("src/1.txt", "This file has been updated.\n");
+  test.getMount().addFile("src/new.txt", "extra stuff");
+  test.getMount().deleteFile("doc/readme.txt");
+
+  auto updated = test.diffFuture();
+  auto result = EXPECT_FUTURE_RESULT(updated);
+  EXPECT_THAT(
+      *result.entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/1.txt", ScmFileStatus::MODIFIED),
+          std::make_pair("src/new.txt", ScmFileStatus::ADDED),
+          std::make_pair("doc/readme.txt", ScmFileStatus::REMOVED)));
+  EXPECT_EQ(*test.diff().entries_ref(), *result.entries_ref());
+
+  // Nothing was journaled since, so the cached status is returned.
+  auto cached = test.diffFuture();
+  EXPECT_EQ(*result.entries_ref(), *EXPECT_FUTURE_RESULT(cached).entries_ref());
+
+  // Reverting changes removes them from the cached status.
+  test.getMount().overwriteFile("src/1.txt", "This is src/1.txt.\n");
+  test.getMount().deleteFile("src/new.txt");
+  auto reverted = test.diffFuture();
+  EXPECT_THAT(
+      *EXPECT_FUTURE_RESULT(reverted).entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("doc/readme.txt", ScmFileStatus::REMOVED)));
+}
+
 TEST(DiffTest, directoryRemoved) {
   DiffTest test;
   auto& mount = test.getMount();
@@ -252,6 +330,40 @@ TEST(DiffTest, directoryAdded) {
           std::make_pair("src/new/subdir/bar.txt", ScmFileStatus::ADDED)));
 }
 
+TEST(DiffTest, directoryAddedSummarized) {
+  DiffTest test;
+  auto& mount = test.getMount();
+  mount.mkdir("src/new");
+  mount.mkdir("src/new/subdir");
+  mount.addFile("src/new/file.txt", "extra stuff");
+  mount.addFile("src/new/subdir/foo.txt", "extra stuff");
+  mount.addFile("src/a/new.txt", "more extra stuff");
+
+  auto result = test.diffFuture(
+      /*listIgnored=*/false, /*summarizeUntrackedDirectories=*/true);
+  EXPECT_THAT(
+      *EXPECT_FUTURE_RESULT(result).entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/new/", ScmFileStatus::ADDED),
+          std::make_pair("src/a/new.txt", ScmFileStatus::ADDED)));
+}
+
+TEST(DiffTest, fileReplacedWithDirSummarized) {
+  DiffTest test;
+  auto& mount = test.getMount();
+  mount.deleteFile("src/2.txt");
+  mount.mkdir("src/2.txt");
+  mount.addFile("src/2.txt/file.txt", "extra stuff");
+
+  auto result = test.diffFuture(
+      /*listIgnored=*/false, /*summarizeUntrackedDirectories=*/true);
+  EXPECT_THAT(
+      *EXPECT_FUTURE_RESULT(result).entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/2.txt/", ScmFileStatus::ADDED),
+          std::make_pair("src/2.txt", ScmFileStatus::REMOVED)));
+}
+
 TEST(DiffTest, dirReplacedWithFile) {
   DiffTest test;
   auto& mount = test.getMount();
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/DirectoryAccessProfile.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using Clock = DirectoryAccessProfile::Clock;
+
+TEST(DirectoryAccessProfileTest, nothingSelectedBeforeLoads) {
+  DirectoryAccessProfile profile{100, 1h};
+  auto selection = profile.selectForPrefetch(10, Clock::now());
+  EXPECT_TRUE(selection.paths.empty());
+  EXPECT_EQ(0, selection.wasted);
+}
+
+TEST(DirectoryAccessProfileTest, frequentlyLoadedDirectoriesRankFirst) {
+  DirectoryAccessProfile profile{100, 1h};
+  auto now = Clock::now();
+  for (int i = 0; i < 3; ++i) {
+    profile.recordLoad("src/often"_relpath, now);
+  }
+  profile.recordLoad("src/rarely"_relpath, now);
+  profile.recordLoad("src/sometimes"_relpath, now);
+  profile.recordLoad("src/sometimes"_relpath, now);
+
+  auto selection = profile.selectForPrefetch(2, now);
+  ASSERT_EQ(2, selection.paths.size());
+  EXPECT_EQ("src/often"_relpath, selection.paths[0]);
+  EXPECT_EQ("src/sometimes"_relpath, selection.paths[1]);
+}
+
+TEST(DirectoryAccessProfileTest, scoresDecayWithHalfLife) {
+  DirectoryAccessProfile profile{100, 1h};
+  auto start = Clock::now();
+  for (int i = 0; i < 4; ++i) {
+    profile.recordLoad("old"_relpath, start);
+  }
+  EXPECT_DOUBLE_EQ(4.0, profile.getScore("old"_relpath, start));
+  EXPECT_DOUBLE_EQ(2.0, profile.getScore("old"_relpath, start + 1h));
+  EXPECT_DOUBLE_EQ(0.0, profile.getScore("unknown"_relpath, start));
+
+  // Three recent loads outrank four loads from two half-lives ago.
+  auto later = start + 2h;
+  for (int i = 0; i < 3; ++i) {
+    profile.recordLoad("recent"_relpath, later);
+  }
+  auto selection = profile.selectForPrefetch(1, later);
+  ASSERT_EQ(1, selection.paths.size());
+  EXPECT_EQ("recent"_relpath, selection.paths[0]);
+}
+
+TEST(DirectoryAccessProfileTest, reportsUsefulAndWastedPrefetches) {
+  DirectoryAccessProfile profile{100, 1h};
+  auto now = Clock::now();
+  EXPECT_FALSE(profile.recordLoad("a"_relpath, now));
+  EXPECT_FALSE(profile.recordLoad("b"_relpath, now));
+
+  EXPECT_EQ(2, profile.selectForPrefetch(10, now).paths.size());
+  EXPECT_TRUE(profile.recordLoad("a"_relpath, now));
+  // Only the first load after a prefetch counts.
+  EXPECT_FALSE(profile.recordLoad("a"_relpath, now));
+
+  // b was never loaded after being prefetched.
+  EXPECT_EQ(1, profile.selectForPrefetch(10, now).wasted);
+}
+
+TEST(DirectoryAccessProfileTest, leastRecentlyLoadedAreForgotten) {
+  DirectoryAccessProfile profile{2, 1h};
+  auto now = Clock::now();
+  profile.recordLoad("a"_relpath, now);
+  profile.recordLoad("b"_relpath, now);
+  profile.recordLoad("a"_relpath, now);
+  profile.recordLoad("c"_relpath, now);
+
+  EXPECT_EQ(0.0, profile.getScore("b"_relpath, now));
+  EXPECT_EQ(2, profile.selectForPrefetch(10, now).paths.size());
+}
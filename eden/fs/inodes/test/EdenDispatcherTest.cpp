@@ -12,6 +12,9 @@
 #include <folly/experimental/TestUtil.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/fuse/DirList.h"
+#include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/testharness/FakeTreeBuilder.h"
@@ -160,4 +163,73 @@ TEST(RawEdenDispatcherTest, lookup_returns_valid_inode_for_bad_file) {
   EXPECT_EQ(entry.nodeid, entry.attr.ino);
 }
 
+TEST(RawEdenDispatcherTest, materialized_inodes_use_materialized_timeout) {
+  FakeTreeBuilder builder;
+  builder.setFile("clean", "contents");
+  TestMount mount;
+  mount.getEdenConfig()->fuseMaterializedAttrTimeout.setValue(
+      std::chrono::seconds{10}, ConfigSource::CommandLine);
+  mount.initialize(builder);
+  auto* dispatcher = mount.getDispatcher();
+
+  auto clean =
+      dispatcher
+          ->lookup(
+              0, kRootNodeId, "clean"_pc, ObjectFetchContext::getNullContext())
+          .get(0ms);
+  EXPECT_EQ(std::numeric_limits<int32_t>::max(), clean.attr_valid);
+  EXPECT_EQ(std::numeric_limits<int32_t>::max(), clean.entry_valid);
+
+  auto created = dispatcher
+                     ->mknod(
+                         kRootNodeId,
+                         "created"_pc,
+                         S_IFREG | 0644,
+                         0,
+                         ObjectFetchContext::getNullContext())
+                     .get(0ms);
+  EXPECT_EQ(10u, created.attr_valid);
+  EXPECT_EQ(10u, created.entry_valid);
+
+  auto attr =
+      dispatcher
+          ->getattr(
+              InodeNumber{created.nodeid}, ObjectFetchContext::getNullContext())
+          .get(0ms);
+  EXPECT_EQ(10u, attr.timeout_seconds);
+}
+
+#ifdef __linux__
+TEST(RawEdenDispatcherTest, readdirplus_returns_entry_params_of_children) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir/a", "contents");
+  builder.setFile("dir/b", "more contents");
+  TestMount mount{builder};
+  auto dirIno = mount.getTreeInode("dir"_relpath)->getNodeId();
+
+  auto result =
+      mount.getDispatcher()
+          ->readdirplus(
+              dirIno,
+              FuseDirPlusList{4096},
+              0,
+              0,
+              ObjectFetchContext::getNullContext())
+          .get(0ms)
+          .extract();
+
+  ASSERT_EQ(4, result.size());
+  EXPECT_EQ(".", result[0].first.name);
+  EXPECT_EQ(0u, result[0].second.nodeid);
+  EXPECT_EQ("..", result[1].first.name);
+  EXPECT_EQ(0u, result[1].second.nodeid);
+  for (size_t i = 2; i < result.size(); ++i) {
+    auto& [dirent, entry] = result[i];
+    EXPECT_EQ(dirent.inode, entry.nodeid);
+    EXPECT_EQ(dirent.inode, entry.attr.ino);
+    EXPECT_EQ(dirent.name == "a" ? 8u : 13u, entry.attr.size);
+  }
+}
+#endif
+
 #endif
@@ -492,6 +492,27 @@ TEST(FileInode, writeDuringLoad) {
   EXPECT_FILE_INODE(inode, "ConTENTS not ready.\n", 0644);
 }
 
+TEST(FileInode, overwritingWholeFileDoesNotLoadBlob) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"file.txt", "old contents\n"}});
+  TestMount mount_{builder};
+
+  auto inode = mount_.getFileInode("file.txt");
+  // Looking up the size lets the write below know it covers the whole file.
+  EXPECT_EQ(13, getFileAttr(inode).st_size);
+
+  auto storedBlob =
+      mount_.getBackingStore()->getStoredBlob(*inode->getBlobHash());
+  storedBlob->notReady();
+
+  auto newContents = "new contents!\n"_sp;
+  auto writeFuture =
+      inode->write(newContents, 0, ObjectFetchContext::getNullContext());
+  ASSERT_TRUE(writeFuture.isReady());
+  EXPECT_EQ(newContents.size(), std::move(writeFuture).get());
+  EXPECT_FILE_INODE(inode, newContents, 0644);
+}
+
 TEST(FileInode, truncateDuringLoad) {
   // Build a tree to test against, but do not mark the state ready yet
   FakeTreeBuilder builder;
@@ -635,6 +656,44 @@ TEST(FileInode, reloadsBlobIfCacheIsEvicted) {
       << "reading should insert hash " << hash << " into cache";
 }
 
+TEST(FileInode, materializedReadMayReturnFileReference) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"bigfile.txt", ""}});
+  TestMount mount{builder};
+
+  auto inode = mount.getFileInode("bigfile.txt");
+  std::string contents(256 * 1024, 'x');
+  inode->write(contents, 0, ObjectFetchContext::getNullContext()).get(0ms);
+
+  auto [small, smallEof] =
+      inode->read(16, 0, ObjectFetchContext::getNullContext(), true)
+          .get(0ms);
+  EXPECT_FALSE(small.isFile());
+  EXPECT_FALSE(smallEof);
+
+  // Reads past the end are clamped to the file size.
+  auto [big, bigEof] = inode
+                           ->read(
+                               128 * 1024,
+                               contents.size() - 64 * 1024,
+                               ObjectFetchContext::getNullContext(),
+                               true)
+                           .get(0ms);
+  EXPECT_TRUE(big.isFile());
+  EXPECT_FALSE(bigEof);
+  EXPECT_EQ(64 * 1024, big.size());
+  EXPECT_EQ(
+      contents.substr(contents.size() - 64 * 1024),
+      std::move(big).toIOBuf()->moveToFbString().toStdString());
+
+  // Without permission the data is always in memory.
+  auto [copied, copiedEof] =
+      inode->read(128 * 1024, 0, ObjectFetchContext::getNullContext())
+          .get(0ms);
+  EXPECT_FALSE(copied.isFile());
+  EXPECT_EQ(128 * 1024, copied.size());
+}
+
 // TODO: test multiple flags together
 // TODO: ensure ctime is updated after every call to setattr()
 // TODO: ensure mtime is updated after opening a file, writing to it, then
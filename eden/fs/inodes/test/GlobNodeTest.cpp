@@ -33,6 +33,14 @@ namespace {
 constexpr folly::Duration kSmallTimeout =
     std::chrono::duration_cast<folly::Duration>(1s);
 
+struct CollectingPrefetchList : GlobNode::PrefetchList {
+  void add(const ObjectId& id) override {
+    ids.wlock()->push_back(id);
+  }
+
+  folly::Synchronized<std::vector<ObjectId>> ids;
+};
+
 folly::Future<std::vector<GlobResult>> evaluateGlob(
     TestMount& mount,
     GlobNode& globRoot,
@@ -101,7 +109,7 @@ class GlobNodeTest : public ::testing::TestWithParam<
     globRoot.debugDump();
 
     if (shouldPrefetch()) {
-      prefetchHashes_ = std::make_shared<GlobNode::PrefetchList>();
+      prefetchHashes_ = std::make_shared<CollectingPrefetchList>();
     }
 
     auto future = evaluateGlob(mount_, globRoot, prefetchHashes_, commitHash);
@@ -129,12 +137,12 @@ class GlobNodeTest : public ::testing::TestWithParam<
   }
 
   std::vector<ObjectId> getPrefetchHashes() const {
-    return *prefetchHashes_->rlock();
+    return *prefetchHashes_->ids.rlock();
   }
 
   TestMount mount_;
   FakeTreeBuilder builder_;
-  std::shared_ptr<GlobNode::PrefetchList> prefetchHashes_;
+  std::shared_ptr<CollectingPrefetchList> prefetchHashes_;
 };
 
 TEST_P(GlobNodeTest, starTxt) {
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/GlobPrefetcher.h"
+
+#include <folly/Conv.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+#include <deque>
+
+using namespace facebook::eden;
+using testing::ElementsAre;
+
+namespace {
+
+ObjectId makeId(int i) {
+  return ObjectId::sha1(folly::to<std::string>(i));
+}
+
+/**
+ * Records the batches it is asked to fetch, and completes them when told to.
+ */
+struct FakeFetcher {
+  std::vector<std::vector<ObjectId>> batches;
+  // A deque, as completing a batch can start the next one, adding a promise
+  // while the completed one is still being fulfilled.
+  std::deque<folly::Promise<folly::Unit>> promises;
+
+  GlobPrefetcher::FetchBatch fetchBatch() {
+    return [this](std::vector<ObjectId> ids) {
+      batches.push_back(std::move(ids));
+      return promises.emplace_back().getFuture();
+    };
+  }
+};
+
+} // namespace
+
+TEST(GlobPrefetcher, fetches_full_batches_during_the_walk) {
+  FakeFetcher fetcher;
+  auto prefetcher = GlobPrefetcher::create(fetcher.fetchBatch(), 2, 8);
+
+  prefetcher->add(makeId(1));
+  EXPECT_EQ(0, fetcher.batches.size());
+  prefetcher->add(makeId(2));
+  ASSERT_EQ(1, fetcher.batches.size());
+  EXPECT_THAT(fetcher.batches[0], ElementsAre(makeId(1), makeId(2)));
+
+  // Duplicates are only fetched once.
+  prefetcher->add(makeId(1));
+  prefetcher->add(makeId(3));
+  EXPECT_EQ(1, fetcher.batches.size());
+
+  auto done = prefetcher->finish();
+  ASSERT_EQ(2, fetcher.batches.size());
+  EXPECT_THAT(fetcher.batches[1], ElementsAre(makeId(3)));
+  EXPECT_EQ(3, prefetcher->getIdCount());
+
+  fetcher.promises[0].setValue();
+  EXPECT_FALSE(done.isReady());
+  fetcher.promises[1].setValue();
+  ASSERT_TRUE(done.isReady());
+  EXPECT_FALSE(done.hasException());
+}
+
+TEST(GlobPrefetcher, limits_batches_in_flight) {
+  FakeFetcher fetcher;
+  auto prefetcher = GlobPrefetcher::create(fetcher.fetchBatch(), 1, 2);
+
+  for (int i = 0; i < 4; ++i) {
+    prefetcher->add(makeId(i));
+  }
+  EXPECT_EQ(2, fetcher.batches.size());
+
+  fetcher.promises[0].setValue();
+  EXPECT_EQ(3, fetcher.batches.size());
+
+  auto done = prefetcher->finish();
+  fetcher.promises[1].setValue();
+  fetcher.promises[2].setValue();
+  ASSERT_EQ(4, fetcher.batches.size());
+  EXPECT_FALSE(done.isReady());
+  fetcher.promises[3].setValue();
+  EXPECT_TRUE(done.isReady());
+}
+
+TEST(GlobPrefetcher, drops_queued_batches_once_cancelled) {
+  FakeFetcher fetcher;
+  bool cancelled = false;
+  auto prefetcher = GlobPrefetcher::create(
+      fetcher.fetchBatch(), 1, 1, [&cancelled] { return cancelled; });
+
+  for (int i = 0; i < 3; ++i) {
+    prefetcher->add(makeId(i));
+  }
+  EXPECT_EQ(1, fetcher.batches.size());
+
+  cancelled = true;
+  fetcher.promises[0].setValue();
+  prefetcher->add(makeId(3));
+  auto done = prefetcher->finish();
+
+  EXPECT_EQ(1, fetcher.batches.size());
+  EXPECT_EQ(2, prefetcher->getDroppedBatchCount());
+  ASSERT_TRUE(done.isReady());
+  EXPECT_FALSE(done.hasException());
+}
+
+TEST(GlobPrefetcher, reports_the_first_error) {
+  FakeFetcher fetcher;
+  auto prefetcher = GlobPrefetcher::create(fetcher.fetchBatch(), 1, 4);
+
+  prefetcher->add(makeId(1));
+  prefetcher->add(makeId(2));
+  auto done = prefetcher->finish();
+
+  fetcher.promises[0].setException(std::runtime_error{"fetch failed"});
+  fetcher.promises[1].setValue();
+  ASSERT_TRUE(done.isReady());
+  EXPECT_THROW(std::move(done).get(), std::runtime_error);
+}
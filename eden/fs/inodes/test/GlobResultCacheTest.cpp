@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/GlobResultCache.h"
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+ObjectId makeId(uint8_t i) {
+  return ObjectId{folly::ByteRange{&i, 1}};
+}
+
+std::shared_ptr<const GlobResultCache::Entries> makeEntries(size_t count) {
+  auto entries = std::make_shared<GlobResultCache::Entries>();
+  for (size_t i = 0; i < count; ++i) {
+    entries->push_back(
+        {RelativePath{folly::to<std::string>("file", i)}, dtype_t::Regular});
+  }
+  return entries;
+}
+} // namespace
+
+TEST(GlobResultCacheTest, keyIgnoresPatternOrderAndDuplicates) {
+  EXPECT_EQ(
+      GlobResultCache::makeKey({"a/*", "b/**"}, false, makeId(1)),
+      GlobResultCache::makeKey({"b/**", "a/*", "b/**"}, false, makeId(1)));
+  EXPECT_NE(
+      GlobResultCache::makeKey({"a/*"}, false, makeId(1)),
+      GlobResultCache::makeKey({"a/*"}, true, makeId(1)));
+  EXPECT_NE(
+      GlobResultCache::makeKey({"a/*"}, false, makeId(1)),
+      GlobResultCache::makeKey({"a/*"}, false, makeId(2)));
+  EXPECT_NE(
+      GlobResultCache::makeKey({"a/*"}, false, RelativePathPiece{"x"}, 1),
+      GlobResultCache::makeKey({"a/*"}, false, RelativePathPiece{"x"}, 2));
+}
+
+TEST(GlobResultCacheTest, cachedResultsAreReturned) {
+  GlobResultCache cache{100};
+  auto key = GlobResultCache::makeKey({"*"}, false, makeId(1));
+  EXPECT_EQ(nullptr, cache.get(key));
+
+  cache.insert(key, makeEntries(3));
+  auto cached = cache.get(key);
+  ASSERT_NE(nullptr, cached);
+  ASSERT_EQ(3, cached->size());
+  EXPECT_EQ(RelativePathPiece{"file0"}, (*cached)[0].name);
+}
+
+TEST(GlobResultCacheTest, leastRecentlyUsedResultsAreEvicted) {
+  GlobResultCache cache{10};
+  auto key1 = GlobResultCache::makeKey({"1"}, false, makeId(1));
+  auto key2 = GlobResultCache::makeKey({"2"}, false, makeId(1));
+  auto key3 = GlobResultCache::makeKey({"3"}, false, makeId(1));
+
+  cache.insert(key1, makeEntries(4));
+  cache.insert(key2, makeEntries(4));
+  // Make key2 the least recently used.
+  EXPECT_NE(nullptr, cache.get(key1));
+  cache.insert(key3, makeEntries(4));
+
+  EXPECT_NE(nullptr, cache.get(key1));
+  EXPECT_EQ(nullptr, cache.get(key2));
+  EXPECT_NE(nullptr, cache.get(key3));
+
+  // Results larger than the cache are not kept.
+  cache.insert(key2, makeEntries(11));
+  EXPECT_EQ(nullptr, cache.get(key2));
+}
+
+TEST(GlobResultCacheTest, disabledCacheIsEmpty) {
+  GlobResultCache cache{0};
+  EXPECT_FALSE(cache.isEnabled());
+  auto key = GlobResultCache::makeKey({"*"}, false, makeId(1));
+  cache.insert(key, makeEntries(0));
+  EXPECT_EQ(nullptr, cache.get(key));
+}
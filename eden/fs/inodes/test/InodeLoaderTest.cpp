@@ -107,3 +107,25 @@ TEST(InodeLoader, notReady) {
     EXPECT_EQ("dir/sub/b.txt"_relpath, results[3].value());
   }
 }
+
+TEST(InodeLoader, childOfFile) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"dir/a.txt", ""}, {"dir/b.txt", ""}});
+  TestMount mount(builder);
+
+  auto rootInode = mount.getTreeInode(RelativePathPiece());
+
+  auto results =
+      collectAll(
+          applyToInodes(
+              rootInode,
+              std::vector<std::string>{
+                  "dir/a.txt/child", "dir/b.txt", "dir/a.txt/other"},
+              [](InodePtr inode) { return inode->getPath(); },
+              ObjectFetchContext::getNullContext()))
+          .get();
+
+  EXPECT_THROW_ERRNO(results[0].value(), ENOTDIR);
+  EXPECT_EQ("dir/b.txt"_relpath, results[1].value());
+  EXPECT_THROW_ERRNO(results[2].value(), ENOTDIR);
+}
@@ -10,6 +10,7 @@
 #include <folly/String.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <thread>
 
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -356,6 +357,33 @@ TEST(InodeMap, renameDuringRecursiveLookupAndLoad) {
   EXPECT_EQ("a/b/x/d/file.txt"_relpath, fileInode->getPath().value());
 }
 
+TEST(InodeMap, concurrentLookupsOfUnreferencedInode) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir/file.txt", "contents\n");
+  TestMount testMount{builder};
+  auto* inodeMap = testMount.getEdenMount()->getInodeMap();
+  auto number = testMount.getFileInode("dir/file.txt")->getNodeId();
+
+  // Every lookup drops the last reference again, racing the lookups of the
+  // other threads against onInodeUnreferenced().
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      for (int n = 0; n < 10000; ++n) {
+        EXPECT_NE(nullptr, inodeMap->lookupLoadedInode(number));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Linked inodes stay loaded once unreferenced, unlinked ones do not.
+  EXPECT_NE(nullptr, inodeMap->lookupLoadedInode(number));
+  testMount.deleteFile("dir/file.txt");
+  EXPECT_EQ(nullptr, inodeMap->lookupLoadedInode(number));
+}
+
 TEST(InodeMap, unloadedUnlinkedTreesAreRemovedFromOverlay) {
   FakeTreeBuilder builder;
   builder.setFile("dir1/file.txt", "contents");
@@ -626,6 +654,26 @@ TEST_F(
   EXPECT_EQ(oldFile1Id, file1->getNodeId());
   EXPECT_EQ(oldFile2Id, file2->getNodeId());
 }
+
+TEST_F(InodePersistenceTakeoverTest, unusedInodesArePassedOnByNextTakeover) {
+  // Nothing is materialized until it is used, but the inodes are known.
+  auto* inodeMap = edenMount->getInodeMap();
+  EXPECT_TRUE(inodeMap->isInodeRemembered(oldTreeId));
+  EXPECT_TRUE(inodeMap->isInodeRemembered(oldFile1Id));
+  EXPECT_TRUE(inodeMap->isInodeRemembered(oldFile2Id));
+  EXPECT_EQ(
+      RelativePath{"dir/file1.txt"}, inodeMap->getPathForInode(oldFile1Id));
+
+  edenMount.reset();
+  testMount.remountGracefully();
+  edenMount = testMount.getEdenMount();
+  inodeMap = edenMount->getInodeMap();
+
+  auto file1 = inodeMap->lookupInode(oldFile1Id).get();
+  EXPECT_EQ("dir/file1.txt", file1->getLogPath());
+  EXPECT_EQ(1, file1->debugGetFsRefcount());
+  EXPECT_TRUE(inodeMap->isInodeRemembered(oldFile2Id));
+}
 #endif
 
 /**
@@ -700,3 +748,71 @@ TEST_F(
   EXPECT_EQ(oldFile1Id, file1->getNodeId());
   EXPECT_EQ(oldFile2Id, file2->getNodeId());
 }
+
+#ifndef _WIN32
+TEST_F(InodePersistenceTreeTest, takeoverIncludesChangesAfterPrepareTakeover) {
+  builder.setFile("dir/file3.txt", "contents3");
+  TestMount testMount{builder};
+  auto edenMount = testMount.getEdenMount();
+
+  auto tree =
+      edenMount->getInode("dir"_relpath, ObjectFetchContext::getNullContext())
+          .get();
+  auto file1 =
+      edenMount
+          ->getInode(
+              "dir/file1.txt"_relpath, ObjectFetchContext::getNullContext())
+          .get();
+  auto file2 =
+      edenMount
+          ->getInode(
+              "dir/file2.txt"_relpath, ObjectFetchContext::getNullContext())
+          .get();
+  auto file3 =
+      edenMount
+          ->getInode(
+              "dir/file3.txt"_relpath, ObjectFetchContext::getNullContext())
+          .get();
+
+  tree->incFsRefcount();
+  file1->incFsRefcount();
+  file2->incFsRefcount();
+  file3->incFsRefcount();
+
+  auto treeId = tree->getNodeId();
+  auto file1Id = file1->getNodeId();
+  auto file2Id = file2->getNodeId();
+  auto file3Id = file3->getNodeId();
+
+  tree.reset();
+  file1.reset();
+  file2.reset();
+  file3.reset();
+  edenMount->getRootInode()->unloadChildrenNow();
+
+  auto* inodeMap = edenMount->getInodeMap();
+  EXPECT_TRUE(inodeMap->isInodeRemembered(file1Id));
+  EXPECT_TRUE(inodeMap->isInodeRemembered(file2Id));
+  inodeMap->prepareTakeover();
+
+  // Forget one unloaded inode, and load another and add a reference to it,
+  // after its entry was serialized.
+  inodeMap->decFsRefcount(file1Id);
+  EXPECT_FALSE(inodeMap->isInodeRemembered(file1Id));
+  file2 = inodeMap->lookupInode(file2Id).get();
+  file2->incFsRefcount();
+  file2.reset();
+
+  edenMount.reset();
+  testMount.remountGracefully();
+  edenMount = testMount.getEdenMount();
+  inodeMap = edenMount->getInodeMap();
+
+  EXPECT_TRUE(inodeMap->isInodeRemembered(treeId));
+  EXPECT_FALSE(inodeMap->isInodeRemembered(file1Id));
+  EXPECT_TRUE(inodeMap->isInodeRemembered(file2Id));
+  EXPECT_TRUE(inodeMap->isInodeRemembered(file3Id));
+  EXPECT_EQ(2, inodeMap->lookupInode(file2Id).get()->debugGetFsRefcount());
+  EXPECT_EQ(1, inodeMap->lookupInode(file3Id).get()->debugGetFsRefcount());
+}
+#endif
@@ -164,10 +164,55 @@ TEST_F(InodeTableTest, setDefault) {
   EXPECT_EQ(14, inodeTable->setDefault(1_ino, 16));
 }
 
+TEST_F(InodeTableTest, freeInode_moves_last_record) {
+  auto inodeTable = InodeTable<Int>::open(tablePath);
+  inodeTable->set(1_ino, 10);
+  inodeTable->set(2_ino, 20);
+  inodeTable->set(3_ino, 30);
+
+  inodeTable->freeInode(1_ino);
+  EXPECT_EQ(std::nullopt, inodeTable->getOptional(1_ino));
+  EXPECT_EQ(20, inodeTable->getOrThrow(2_ino));
+  EXPECT_EQ(30, inodeTable->getOrThrow(3_ino));
+
+  // Freeing an absent inode does nothing.
+  inodeTable->freeInode(1_ino);
+  EXPECT_EQ(30, inodeTable->getOrThrow(3_ino));
+}
+
+TEST_F(InodeTableTest, sparse_inode_numbers) {
+  std::vector<InodeNumber> inodes = {
+      1_ino, 4095_ino, 4096_ino, 1000000_ino, InodeNumber{uint64_t{1} << 32}};
+  {
+    auto inodeTable = InodeTable<Int>::open(tablePath);
+    for (size_t i = 0; i < inodes.size(); ++i) {
+      inodeTable->set(inodes[i], static_cast<int>(i));
+    }
+    inodeTable->freeInode(4096_ino);
+    EXPECT_EQ(std::nullopt, inodeTable->getOptional(4097_ino));
+  }
+
+  auto inodeTable = InodeTable<Int>::open(tablePath);
+  for (size_t i = 0; i < inodes.size(); ++i) {
+    if (inodes[i] == 4096_ino) {
+      EXPECT_EQ(std::nullopt, inodeTable->getOptional(inodes[i]));
+    } else {
+      EXPECT_EQ(static_cast<int>(i), inodeTable->getOrThrow(inodes[i]));
+    }
+  }
+
+  size_t count = 0;
+  inodeTable->forEachModify([&](const InodeNumber&, Int& record) {
+    record.value++;
+    count++;
+  });
+  EXPECT_EQ(inodes.size() - 1, count);
+  EXPECT_EQ(1, inodeTable->getOrThrow(1_ino));
+}
+
 // TEST(INodeTable, set) {}
 // TEST(INodeTable, getOrThrow) {}
 // TEST(INodeTable, getOptional) {}
 // TEST(INodeTable, modifyOrThrow) {}
-// TEST(INodeTable, freeInodes) {}
 
 #endif
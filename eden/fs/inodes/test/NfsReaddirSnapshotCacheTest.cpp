@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/NfsReaddirSnapshotCache.h"
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+std::shared_ptr<NfsReaddirSnapshot> makeSnapshot(
+    InodeNumber dir,
+    size_t count) {
+  auto snapshot = std::make_shared<NfsReaddirSnapshot>();
+  snapshot->dir = dir;
+  for (size_t i = 0; i < count; ++i) {
+    snapshot->entries.push_back(
+        {folly::to<std::string>("entry", i), InodeNumber{10 + i}, 12 + i});
+  }
+  return snapshot;
+}
+
+std::vector<uint64_t> collectCookies(
+    const NfsReaddirSnapshot& snapshot,
+    uint64_t cookie,
+    size_t limit,
+    bool& isEof) {
+  std::vector<uint64_t> cookies;
+  isEof = snapshot.addEntries(
+      cookie, [&](folly::StringPiece, InodeNumber, uint64_t entryCookie) {
+        if (cookies.size() == limit) {
+          return false;
+        }
+        cookies.push_back(entryCookie);
+        return true;
+      });
+  return cookies;
+}
+} // namespace
+
+TEST(NfsReaddirSnapshotCache, addEntriesStartsAfterCookie) {
+  auto snapshot = makeSnapshot(InodeNumber{1}, 5);
+  bool isEof;
+
+  auto cookies = collectCookies(*snapshot, 0, 2, isEof);
+  EXPECT_FALSE(isEof);
+  EXPECT_EQ((std::vector<uint64_t>{12, 13}), cookies);
+
+  cookies = collectCookies(*snapshot, 13, 10, isEof);
+  EXPECT_TRUE(isEof);
+  EXPECT_EQ((std::vector<uint64_t>{14, 15, 16}), cookies);
+
+  // The entry at the cookie may have been removed since.
+  cookies = collectCookies(*snapshot, 100, 10, isEof);
+  EXPECT_TRUE(isEof);
+  EXPECT_TRUE(cookies.empty());
+}
+
+TEST(NfsReaddirSnapshotCache, snapshotsAreFoundByVerifierAndDirectory) {
+  NfsReaddirSnapshotCache cache{1024 * 1024};
+  auto verifier = cache.insert(makeSnapshot(InodeNumber{1}, 5));
+  EXPECT_NE(0, verifier);
+
+  EXPECT_TRUE(cache.get(verifier, InodeNumber{1}));
+  EXPECT_FALSE(cache.get(verifier, InodeNumber{2}));
+  EXPECT_FALSE(cache.get(verifier + 1, InodeNumber{1}));
+  EXPECT_FALSE(cache.get(0, InodeNumber{1}));
+
+  cache.erase(verifier);
+  EXPECT_FALSE(cache.get(verifier, InodeNumber{1}));
+  EXPECT_EQ(0, cache.getTotalBytes());
+}
+
+TEST(NfsReaddirSnapshotCache, leastRecentlyUsedSnapshotsAreEvicted) {
+  auto bytes = makeSnapshot(InodeNumber{1}, 100)->getSizeBytes();
+  NfsReaddirSnapshotCache cache{2 * bytes};
+
+  auto a = cache.insert(makeSnapshot(InodeNumber{1}, 100));
+  auto b = cache.insert(makeSnapshot(InodeNumber{2}, 100));
+  EXPECT_EQ(2 * bytes, cache.getTotalBytes());
+
+  // Using a makes b the least recently used.
+  EXPECT_TRUE(cache.get(a, InodeNumber{1}));
+  auto c = cache.insert(makeSnapshot(InodeNumber{3}, 100));
+  EXPECT_TRUE(cache.get(a, InodeNumber{1}));
+  EXPECT_FALSE(cache.get(b, InodeNumber{2}));
+  EXPECT_TRUE(cache.get(c, InodeNumber{3}));
+  EXPECT_EQ(2 * bytes, cache.getTotalBytes());
+}
+
+TEST(NfsReaddirSnapshotCache, snapshotsLargerThanTheCacheAreNotCached) {
+  auto snapshot = makeSnapshot(InodeNumber{1}, 100);
+  NfsReaddirSnapshotCache cache{snapshot->getSizeBytes() - 1};
+  EXPECT_EQ(0, cache.insert(snapshot));
+  EXPECT_EQ(0, cache.getTotalBytes());
+  EXPECT_TRUE(cache.isEnabled());
+
+  NfsReaddirSnapshotCache disabled{0};
+  EXPECT_FALSE(disabled.isEnabled());
+  EXPECT_EQ(0, disabled.insert(snapshot));
+}
@@ -17,10 +17,21 @@ using namespace facebook::eden;
 using namespace folly::string_piece_literals;
 
 DEFINE_string(overlayPath, "", "Directory where the test overlay is created");
+DEFINE_string(
+    overlayType,
+    "legacy",
+    "Overlay implementation to measure: legacy or tree");
+DEFINE_uint64(
+    bufferedWriteDelayMs,
+    0,
+    "For the tree overlay, how long directory writes may be buffered to be "
+    "committed together. 0 commits every write on its own.");
 
 namespace {
 
-void benchmarkOverlayTreeWrites(AbsolutePathPiece overlayPath) {
+void benchmarkOverlayTreeWrites(
+    AbsolutePathPiece overlayPath,
+    Overlay::OverlayType overlayType) {
   // A large mount will contain 500,000 trees. If they're all loaded, they
   // will all be written into the overlay. This benchmark simulates that
   // workload and measures how long it takes.
@@ -30,8 +41,10 @@ void benchmarkOverlayTreeWrites(AbsolutePathPiece overlayPath) {
   auto overlay = Overlay::create(
       overlayPath,
       kPathMapDefaultCaseSensitive,
-      Overlay::OverlayType::Legacy,
-      std::make_shared<NullStructuredLogger>());
+      overlayType,
+      std::make_shared<NullStructuredLogger>(),
+      TreeOverlay::WriteBatching{
+          std::chrono::milliseconds(FLAGS_bufferedWriteDelayMs)});
   overlay->initialize().get();
 
   ObjectId hash1{folly::ByteRange{"abcdabcdabcdabcdabcd"_sp}};
@@ -58,6 +71,9 @@ void benchmarkOverlayTreeWrites(AbsolutePathPiece overlayPath) {
     overlay->saveOverlayDir(ino, contents);
   }
 
+  // Buffered writes only count once they are committed, which closing the
+  // overlay waits for.
+  overlay.reset();
   auto elapsed = timer.elapsed();
 
   printf(
@@ -90,8 +106,18 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
+  Overlay::OverlayType overlayType;
+  if (FLAGS_overlayType == "legacy") {
+    overlayType = Overlay::OverlayType::Legacy;
+  } else if (FLAGS_overlayType == "tree") {
+    overlayType = Overlay::OverlayType::Tree;
+  } else {
+    fprintf(stderr, "error: overlayType must be legacy or tree\n");
+    return 1;
+  }
+
   auto overlayPath = normalizeBestEffort(FLAGS_overlayPath.c_str());
-  benchmarkOverlayTreeWrites(overlayPath);
+  benchmarkOverlayTreeWrites(overlayPath, overlayType);
 
   return 0;
 }
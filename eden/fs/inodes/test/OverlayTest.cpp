@@ -180,6 +180,42 @@ TEST_F(OverlayTest, testModifyRemount) {
   EXPECT_FILE_INODE(newInode, "contents changed\n", 0644);
 }
 
+TEST_F(OverlayTest, sha1IsStoredInOverlayFileHeaderUntilModified) {
+  auto readHeaderSha1 = [&](InodeNumber ino) {
+    auto file = mount_.getEdenMount()->getOverlay()->openFileNoVerify(ino);
+    std::string record(FsOverlay::kHeaderSha1Length, '\0');
+    EXPECT_EQ(
+        record.size(),
+        file.preadNoInt(
+                record.data(), record.size(), FsOverlay::kHeaderSha1Offset)
+            .value());
+    return record;
+  };
+  auto getSha1 = [&] {
+    return mount_.getFileInode("dir/a.txt")
+        ->getSha1(ObjectFetchContext::getNullContext())
+        .get(std::chrono::seconds{1});
+  };
+  auto changedSha1 = Hash20::sha1(std::string{"contents changed\n"});
+
+  mount_.overwriteFile("dir/a.txt", "contents changed\n");
+  auto ino = mount_.getFileInode("dir/a.txt")->getNodeId();
+  EXPECT_EQ(changedSha1, getSha1());
+  auto record = readHeaderSha1(ino);
+  EXPECT_EQ(FsOverlay::kHeaderSha1Tag, record.substr(0, 4));
+  EXPECT_EQ(
+      changedSha1,
+      Hash20{folly::ByteRange{folly::StringPiece{record}.subpiece(12)}});
+
+  mount_.remount();
+  EXPECT_EQ(changedSha1, getSha1());
+
+  mount_.overwriteFile("dir/a.txt", "changed again\n");
+  EXPECT_EQ(
+      std::string(FsOverlay::kHeaderSha1Length, '\0'), readHeaderSha1(ino));
+  EXPECT_EQ(Hash20::sha1(std::string{"changed again\n"}), getSha1());
+}
+
 // In memory timestamps should be same before and after a remount.
 // (inmemory timestamps should be written to overlay on
 // on unmount and should be read back from the overlay on remount)
@@ -739,6 +775,56 @@ TEST_P(RawOverlayTest, inode_numbers_after_takeover) {
   EXPECT_EQ(5_ino, overlay->getMaxInodeNumber());
 }
 
+TEST_P(RawOverlayTest, recursively_removed_trees_are_collected) {
+  // Build a root with a few subdirectories, each containing a file and another
+  // subdirectory, so that the GC threads have several directories to share.
+  constexpr int kSubdirCount = 8;
+  unloadOverlay(OverlayRestartMode::CLEAN);
+  overlay = Overlay::create(
+      getLocalDir(),
+      kPathMapDefaultCaseSensitive,
+      kOverlayType,
+      std::make_shared<NullStructuredLogger>(),
+      TreeOverlay::WriteBatching{},
+      /*gcThreadCount=*/4);
+  overlay->initialize().get();
+
+  std::vector<InodeNumber> inodes;
+  DirContents root(kPathMapDefaultCaseSensitive);
+  for (int i = 0; i < kSubdirCount; ++i) {
+    auto dirIno = overlay->allocateInodeNumber();
+    auto fileIno = overlay->allocateInodeNumber();
+    auto nestedIno = overlay->allocateInodeNumber();
+    overlay->createOverlayFile(fileIno, folly::ByteRange{"contents"_sp});
+    overlay->saveOverlayDir(
+        nestedIno, DirContents(kPathMapDefaultCaseSensitive));
+
+    DirContents dir(kPathMapDefaultCaseSensitive);
+    dir.emplace(PathComponentPiece{"f"}, S_IFREG | 0644, fileIno);
+    dir.emplace(PathComponentPiece{"d"}, S_IFDIR | 0755, nestedIno);
+    overlay->saveOverlayDir(dirIno, dir);
+
+    root.emplace(
+        PathComponentPiece{folly::to<std::string>("d", i)},
+        S_IFDIR | 0755,
+        dirIno);
+    inodes.insert(inodes.end(), {dirIno, fileIno, nestedIno});
+  }
+  overlay->saveOverlayDir(kRootNodeId, root);
+
+  overlay->recursivelyRemoveOverlayData(kRootNodeId);
+  overlay->flushPendingAsync().get();
+
+  EXPECT_FALSE(overlay->hasOverlayData(kRootNodeId));
+  for (auto ino : inodes) {
+    EXPECT_FALSE(overlay->hasOverlayData(ino)) << "inode " << ino;
+  }
+  auto stats = overlay->getGCStats();
+  EXPECT_EQ(0, stats.queuedDirectories);
+  EXPECT_EQ(1 + 2 * kSubdirCount, stats.removedDirectories);
+  EXPECT_EQ(kSubdirCount, stats.removedFiles);
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 INSTANTIATE_TEST_CASE_P(
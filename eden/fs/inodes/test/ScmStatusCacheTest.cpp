@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/ScmStatusCache.h"
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+std::shared_ptr<const ScmStatus> makeStatus(folly::StringPiece path) {
+  auto status = std::make_shared<ScmStatus>();
+  status->entries_ref()->emplace(path.str(), ScmFileStatus::MODIFIED);
+  return status;
+}
+} // namespace
+
+TEST(ScmStatusCacheTest, statusIsCachedPerCommitAndListIgnored) {
+  ScmStatusCache cache;
+  RootId commit{"1"};
+  EXPECT_FALSE(cache.get(commit, false));
+
+  cache.insert(commit, false, 5, makeStatus("a"));
+  auto cached = cache.get(commit, false);
+  ASSERT_TRUE(cached);
+  EXPECT_EQ(5, cached->sequence);
+  EXPECT_EQ(1, cached->status->entries_ref()->count("a"));
+
+  EXPECT_FALSE(cache.get(commit, true));
+  EXPECT_FALSE(cache.get(RootId{"2"}, false));
+
+  cache.clear();
+  EXPECT_FALSE(cache.get(commit, false));
+}
+
+TEST(ScmStatusCacheTest, olderStatusDoesNotReplaceNewer) {
+  ScmStatusCache cache;
+  RootId commit{"1"};
+  cache.insert(commit, false, 5, makeStatus("new"));
+  cache.insert(commit, false, 3, makeStatus("old"));
+
+  auto cached = cache.get(commit, false);
+  ASSERT_TRUE(cached);
+  EXPECT_EQ(5, cached->sequence);
+  EXPECT_EQ(1, cached->status->entries_ref()->count("new"));
+}
+
+TEST(ScmStatusCacheTest, lowestSequenceIsEvicted) {
+  ScmStatusCache cache;
+  for (size_t i = 0; i < ScmStatusCache::kMaxEntries; ++i) {
+    cache.insert(
+        RootId{folly::to<std::string>(i)}, false, 10 - i, makeStatus("a"));
+  }
+  auto lowest = RootId{folly::to<std::string>(ScmStatusCache::kMaxEntries - 1)};
+  EXPECT_TRUE(cache.get(lowest, false));
+
+  cache.insert(RootId{"new"}, false, 20, makeStatus("a"));
+  EXPECT_FALSE(cache.get(lowest, false));
+  EXPECT_TRUE(cache.get(RootId{"0"}, false));
+  EXPECT_TRUE(cache.get(RootId{"new"}, false));
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/TreeAccessPredictor.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+ObjectId makeId(uint8_t i) {
+  return ObjectId{folly::ByteRange{&i, 1}};
+}
+
+void walk(TreeAccessPredictor& predictor, std::initializer_list<uint8_t> ids) {
+  for (auto id : ids) {
+    predictor.recordLoad(makeId(id), 2, 8);
+  }
+}
+} // namespace
+
+TEST(TreeAccessPredictorTest, nothingPredictedBeforeLearning) {
+  TreeAccessPredictor predictor{100};
+  auto prediction = predictor.recordLoad(makeId(1), 1, 8);
+  EXPECT_TRUE(prediction.trees.empty());
+  EXPECT_FALSE(prediction.wasPredicted);
+}
+
+TEST(TreeAccessPredictorTest, repeatedWalkIsPredicted) {
+  TreeAccessPredictor predictor{100};
+  walk(predictor, {1, 2, 3});
+  walk(predictor, {10, 11, 12, 13, 14});
+
+  // Seen once: below the minimum count.
+  EXPECT_TRUE(predictor.recordLoad(makeId(1), 2, 8).trees.empty());
+  walk(predictor, {2, 3});
+  walk(predictor, {20, 21, 22, 23, 24});
+
+  auto prediction = predictor.recordLoad(makeId(1), 2, 8);
+  ASSERT_EQ(2, prediction.trees.size());
+  EXPECT_NE(prediction.trees[0], prediction.trees[1]);
+  for (const auto& id : prediction.trees) {
+    EXPECT_TRUE(id == makeId(2) || id == makeId(3));
+  }
+
+  // Loading a predicted tree is reported as a hit.
+  EXPECT_TRUE(predictor.recordLoad(makeId(2), 2, 8).wasPredicted);
+  EXPECT_FALSE(predictor.recordLoad(makeId(40), 2, 8).wasPredicted);
+}
+
+TEST(TreeAccessPredictorTest, maxPredictionsIsHonored) {
+  TreeAccessPredictor predictor{100};
+  for (int i = 0; i < 3; i++) {
+    walk(predictor, {1, 2, 3, 4});
+    walk(predictor, {10, 11, 12, 13, 14});
+  }
+
+  EXPECT_TRUE(predictor.recordLoad(makeId(1), 2, 0).trees.empty());
+  EXPECT_EQ(1, predictor.recordLoad(makeId(1), 2, 1).trees.size());
+}
+
+TEST(TreeAccessPredictorTest, outstandingPredictionsAreNotRepeated) {
+  TreeAccessPredictor predictor{100};
+  for (int i = 0; i < 2; i++) {
+    walk(predictor, {1, 2});
+    walk(predictor, {10, 11, 12, 13, 14});
+  }
+
+  EXPECT_FALSE(predictor.recordLoad(makeId(1), 2, 8).trees.empty());
+  EXPECT_TRUE(predictor.recordLoad(makeId(1), 2, 8).trees.empty());
+}
+
+TEST(TreeAccessPredictorTest, forgottenPredictionsAreWasted) {
+  TreeAccessPredictor predictor{4};
+
+  // Each pair is learned and then predicted, but the predicted tree is never
+  // loaded. Once more than capacity predictions are outstanding, the oldest
+  // are forgotten and reported as wasted.
+  size_t wasted = 0;
+  for (uint8_t i = 20; i < 40; i += 2) {
+    for (int j = 0; j < 2; j++) {
+      walk(predictor, {i, static_cast<uint8_t>(i + 1)});
+    }
+    wasted += predictor.recordLoad(makeId(i), 2, 8).wasted;
+  }
+  EXPECT_GE(wasted, 1);
+}
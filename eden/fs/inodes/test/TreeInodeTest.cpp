@@ -19,6 +19,9 @@
 #include "eden/fs/fuse/DirList.h"
 #endif // _WIN32
 #include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/inodes/InodeError.h"
+#include "eden/fs/inodes/InodeMap.h"
+#include "eden/fs/inodes/NfsReaddirSnapshotCache.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/TreeEntry.h"
 #include "eden/fs/store/ObjectFetchContext.h"
@@ -382,6 +385,159 @@ TEST(TreeInode, fuzzConcurrentModificationAndReaddir) {
   std::cout << "Ran " << iterations << " iterations" << std::endl;
 }
 
+TEST(TreeInode, fuseReaddirPagesThroughLargeDirectoryOnce) {
+  // Large enough for the entries to be sorted once in a readdir index.
+  FakeTreeBuilder builder;
+  std::vector<std::string> names;
+  for (int i = 0; i < 300; ++i) {
+    names.push_back("file" + std::to_string(i));
+    builder.setFile("dir/" + names.back(), "");
+  }
+  TestMount mount{builder};
+  auto dir = mount.getTreeInode("dir"_relpath);
+
+  auto readAll = [&] {
+    std::unordered_map<std::string, unsigned> seen;
+    off_t lastOffset = 0;
+    for (;;) {
+      auto result = dir->fuseReaddir(
+                           FuseDirList{kDirListBufferSize},
+                           lastOffset,
+                           ObjectFetchContext::getNullContext())
+                        .extract();
+      if (result.empty()) {
+        return seen;
+      }
+      lastOffset = result.back().offset;
+      for (auto& entry : result) {
+        ++seen[entry.name];
+      }
+    }
+  };
+
+  auto seen = readAll();
+  EXPECT_EQ(names.size() + 2, seen.size());
+  for (auto& name : names) {
+    EXPECT_EQ(1, seen[name]) << name;
+  }
+
+  // Modifying the directory materializes it, and readdir must notice.
+  dir->unlink(
+         "file7"_pc,
+         InvalidationRequired::No,
+         ObjectFetchContext::getNullContext())
+      .get(0ms);
+  seen = readAll();
+  EXPECT_EQ(names.size() + 1, seen.size());
+  EXPECT_EQ(0, seen.count("file7"));
+  EXPECT_EQ(1, seen["file299"]);
+}
+
+TEST(TreeInode, getOrLoadChildrenLoadsInOrder) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"file", "hello"}, {"dir/a", ""}, {"other/b", ""}});
+  TestMount mount{builder};
+
+  auto root = mount.getEdenMount()->getRootInode();
+  // One child already loaded, and one name appearing twice.
+  auto loadedDir = mount.getTreeInode("other"_relpath);
+
+  auto children =
+      root->getOrLoadChildren(
+              {"dir"_pc, "missing"_pc, "file"_pc, "other"_pc, "dir"_pc},
+              ObjectFetchContext::getNullContext())
+          .get(0ms);
+  ASSERT_EQ(5, children.size());
+
+  auto dir = children[0].value().asTreePtr();
+  EXPECT_EQ(root->getChildInodeNumber("dir"_pc), dir->getNodeId());
+  ASSERT_TRUE(children[1].hasException());
+  EXPECT_TRUE(children[1].exception().is_compatible_with<InodeError>());
+  EXPECT_EQ(
+      root->getChildInodeNumber("file"_pc),
+      children[2].value().asFilePtr()->getNodeId());
+  EXPECT_EQ(loadedDir.get(), children[3].value().get());
+  EXPECT_EQ(dir.get(), children[4].value().get());
+
+  // The loaded children are the ones later lookups return.
+  EXPECT_EQ(dir.get(), mount.getTreeInode("dir"_relpath).get());
+}
+
+TEST(TreeInode, statChildrenDoesNotLoadChildren) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"file", "hello"}, {"dir/a", ""}, {"dir/b", ""}});
+  TestMount mount{builder};
+
+  auto root = mount.getEdenMount()->getRootInode();
+  auto fileIno = root->getChildInodeNumber("file"_pc);
+  auto dirIno = root->getChildInodeNumber("dir"_pc);
+
+  auto stats = root->statChildren(
+                       {"file"_pc, "dir"_pc, "missing"_pc},
+                       ObjectFetchContext::getNullContext())
+                   .get(0ms);
+  ASSERT_EQ(3, stats.size());
+
+  auto& fileStat = stats[0].value();
+  EXPECT_EQ(fileIno.get(), fileStat.st_ino);
+  EXPECT_TRUE(S_ISREG(fileStat.st_mode));
+  EXPECT_EQ(5, fileStat.st_size);
+  EXPECT_EQ(1, fileStat.st_nlink);
+
+  auto& dirStat = stats[1].value();
+  EXPECT_EQ(dirIno.get(), dirStat.st_ino);
+  EXPECT_TRUE(S_ISDIR(dirStat.st_mode));
+  EXPECT_EQ(4, dirStat.st_nlink);
+
+  ASSERT_TRUE(stats[2].hasException());
+  EXPECT_TRUE(stats[2].exception().is_compatible_with<InodeError>());
+
+  auto* inodeMap = mount.getEdenMount()->getInodeMap();
+  EXPECT_FALSE(inodeMap->lookupLoadedInode(fileIno));
+  EXPECT_FALSE(inodeMap->lookupLoadedInode(dirIno));
+
+  // The attributes match what the loaded inodes report.
+  auto loadedStat = mount.getFileInode("file"_relpath)
+                        ->stat(ObjectFetchContext::getNullContext())
+                        .get(0ms);
+  EXPECT_EQ(loadedStat.st_mode, fileStat.st_mode);
+  EXPECT_EQ(loadedStat.st_size, fileStat.st_size);
+  EXPECT_EQ(loadedStat.st_mtime, fileStat.st_mtime);
+  auto loadedDirStat = mount.getTreeInode("dir"_relpath)
+                           ->stat(ObjectFetchContext::getNullContext())
+                           .get(0ms);
+  EXPECT_EQ(loadedDirStat.st_nlink, dirStat.st_nlink);
+}
+
+TEST(TreeInode, nfsReaddirSnapshotMatchesReaddirAndTracksVersion) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"dir/a", ""}, {"dir/b", ""}});
+  TestMount mount{builder};
+
+  auto dir = mount.getTreeInode("dir"_relpath);
+  auto snapshot =
+      dir->nfsReaddirSnapshot(ObjectFetchContext::getNullContext());
+  EXPECT_EQ(dir->getNodeId(), snapshot->dir);
+  EXPECT_EQ(dir->getEntriesVersion(), snapshot->version);
+
+  auto listing =
+      dir->fuseReaddir(
+             FuseDirList{4096}, 0, ObjectFetchContext::getNullContext())
+          .extract();
+  ASSERT_EQ(listing.size(), snapshot->entries.size());
+  for (size_t i = 0; i < listing.size(); ++i) {
+    EXPECT_EQ(listing[i].name, snapshot->entries[i].name);
+    EXPECT_EQ(listing[i].offset, snapshot->entries[i].cookie);
+  }
+
+  auto version = dir->getEntriesVersion();
+  mount.addFile("dir/c", "");
+  EXPECT_NE(version, dir->getEntriesVersion());
+  version = dir->getEntriesVersion();
+  mount.deleteFile("dir/a");
+  EXPECT_NE(version, dir->getEntriesVersion());
+}
+
 #endif // _WIN32
 
 TEST(TreeInode, create) {
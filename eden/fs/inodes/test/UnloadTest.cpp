@@ -159,4 +159,35 @@ TEST(UnloadUnreferencedByFuse, inodesReferencedByFuseAreNotUnloaded) {
   EXPECT_EQ(0, counts.unloadedInodeCount);
 }
 
+
+TEST(UnloadNotRecentlyAccessed, inodesGetASecondChance) {
+  FakeTreeBuilder builder;
+  builder.setFile("src/file.txt", "contents");
+  builder.setFile("docs/README.md", "readme");
+  TestMount testMount{builder};
+
+  const auto* edenMount = testMount.getEdenMount().get();
+  auto inodeMap = edenMount->getInodeMap();
+  auto rootInode = edenMount->getRootInode();
+
+  auto fileIno = testMount.getFileInode("src/file.txt")->getNodeId();
+  auto readmeIno = testMount.getFileInode("docs/README.md")->getNodeId();
+
+  // Freshly loaded inodes count as accessed, so the first sweep only clears
+  // their flags.
+  auto countsBefore = inodeMap->getInodeCounts();
+  EXPECT_EQ(0, rootInode->unloadChildrenNotRecentlyAccessed());
+  auto countsAfter = inodeMap->getInodeCounts();
+  EXPECT_EQ(countsBefore.fileCount, countsAfter.fileCount);
+  EXPECT_EQ(countsBefore.treeCount, countsAfter.treeCount);
+
+  // Looking up an inode again protects it, and its parents, from the next
+  // sweep.
+  testMount.getFileInode("src/file.txt");
+  EXPECT_LT(0, rootInode->unloadChildrenNotRecentlyAccessed());
+
+  EXPECT_NE(nullptr, inodeMap->lookupLoadedInode(fileIno));
+  EXPECT_EQ(nullptr, inodeMap->lookupLoadedInode(readmeIno));
+}
+
 #endif
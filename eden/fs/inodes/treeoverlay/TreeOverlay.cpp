@@ -8,6 +8,7 @@
 #include "eden/fs/inodes/treeoverlay/TreeOverlay.h"
 
 #include <folly/File.h>
+#include <utility>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/inodes/treeoverlay/TreeOverlayWindowsFsck.h"
@@ -17,39 +18,232 @@ namespace facebook::eden {
 
 TreeOverlay::TreeOverlay(
     AbsolutePathPiece path,
-    TreeOverlayStore::SynchronousMode mode)
-    : path_{path.copy()}, store_{path_, mode} {}
+    TreeOverlayStore::SynchronousMode mode,
+    WriteBatching batching)
+    : path_{path.copy()}, store_{path_, mode}, batching_{batching} {}
+
+TreeOverlay::~TreeOverlay() {
+  stopFlusher();
+}
 
 std::optional<InodeNumber> TreeOverlay::initOverlay(bool createIfNonExisting) {
   if (createIfNonExisting) {
     store_.createTableIfNonExisting();
   }
   initialized_ = true;
-  return store_.loadCounters();
+  auto nextInodeNumber = store_.loadCounters();
+  if (isBatching()) {
+    flusher_ = std::thread([this] { flusherThread(); });
+  }
+  return nextInodeNumber;
 }
 
 void TreeOverlay::close(std::optional<InodeNumber> /*nextInodeNumber*/) {
+  stopFlusher();
   store_.close();
 }
 
+void TreeOverlay::stopFlusher() {
+  if (!flusher_.joinable()) {
+    return;
+  }
+  pending_.lock()->stop = true;
+  pendingCondVar_.notify_one();
+  // The flusher commits the remaining writes before it exits.
+  flusher_.join();
+}
+
+void TreeOverlay::flusherThread() noexcept {
+  for (;;) {
+    bool stop;
+    {
+      auto pending = pending_.lock();
+      while (pending->writes.empty() && !pending->stop) {
+        pendingCondVar_.wait(pending.as_lock());
+      }
+      if (isCheckpointing()) {
+        pendingCondVar_.wait_for(
+            pending.as_lock(), batching_.checkpointInterval, [&] {
+              return pending->stop;
+            });
+      } else {
+        // Give more writes the chance to join this commit.
+        pendingCondVar_.wait_for(pending.as_lock(), batching_.maxDelay, [&] {
+          return pending->stop ||
+              pending->writes.size() >= batching_.maxPendingWrites;
+        });
+      }
+      stop = pending->stop;
+    }
+
+    flush();
+    if (stop) {
+      return;
+    }
+  }
+}
+
+void TreeOverlay::flush() {
+  std::lock_guard<std::mutex> flushLock{flushMutex_};
+  flushLocked();
+}
+
+size_t TreeOverlay::applyWrites(
+    const std::vector<TreeOverlayStore::Write>& writes) {
+  std::lock_guard<std::mutex> flushLock{flushMutex_};
+  flushLocked();
+  return store_.applyWrites(writes);
+}
+
+void TreeOverlay::flushLocked() {
+  std::vector<TreeOverlayStore::Write> writes;
+  {
+    auto pending = pending_.lock();
+    writes.swap(pending->writes);
+    pending->lastWrite.clear();
+  }
+  store_.applyWrites(writes);
+}
+
+void TreeOverlay::flushWritesTo(InodeNumber inodeNumber) {
+  if (pending_.lock()->lastWrite.count(inodeNumber)) {
+    flushLocked();
+  }
+}
+
+std::optional<overlay::OverlayDir> TreeOverlay::getBufferedDir(
+    InodeNumber inodeNumber) {
+  {
+    auto pending = pending_.lock();
+    auto it = pending->lastWrite.find(inodeNumber);
+    if (it == pending->lastWrite.end()) {
+      return std::nullopt;
+    }
+    const auto& write = pending->writes[it->second];
+    if (write.type == TreeOverlayStore::Write::Type::SaveTree) {
+      return write.dir;
+    }
+  }
+  flushLocked();
+  return std::nullopt;
+}
+
+void TreeOverlay::bufferWrite(TreeOverlayStore::Write write) {
+  size_t pendingCount;
+  {
+    auto pending = pending_.lock();
+    auto it = pending->lastWrite.find(write.parent);
+    if (write.type == TreeOverlayStore::Write::Type::SaveTree &&
+        it != pending->lastWrite.end() &&
+        pending->writes[it->second].type ==
+            TreeOverlayStore::Write::Type::SaveTree) {
+      // Writes to different parents touch different rows, so the new
+      // contents can take the place of the old ones.
+      pending->writes[it->second] = std::move(write);
+      return;
+    }
+    pending->lastWrite[write.parent] = pending->writes.size();
+    pending->writes.push_back(std::move(write));
+    pendingCount = pending->writes.size();
+  }
+
+  if (pendingCount == 1 || pendingCount == batching_.maxPendingWrites) {
+    pendingCondVar_.notify_one();
+  } else if (
+      !isCheckpointing() && pendingCount >= 2 * batching_.maxPendingWrites) {
+    // The flusher is falling behind; commit on this thread rather than let
+    // the buffer grow without bound.
+    flush();
+  }
+}
+
+void TreeOverlay::editBufferedDirs(
+    std::initializer_list<InodeNumber> inodeNumbers,
+    folly::FunctionRef<void(PendingWrites&)> edit) {
+  auto isBuffered = [&](const PendingWrites& pending) {
+    for (auto inodeNumber : inodeNumbers) {
+      if (!pending.lastWrite.count(inodeNumber)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  {
+    auto pending = pending_.lock();
+    if (isBuffered(*pending)) {
+      edit(*pending);
+      return;
+    }
+  }
+
+  // Holding flushMutex_ keeps the buffered directories from being committed,
+  // and the store holds the latest contents of the others.
+  std::lock_guard<std::mutex> flushLock{flushMutex_};
+  for (auto inodeNumber : inodeNumbers) {
+    if (pending_.lock()->lastWrite.count(inodeNumber)) {
+      continue;
+    }
+    auto dir = store_.loadTree(inodeNumber);
+    auto pending = pending_.lock();
+    // saveOverlayDir() may have buffered newer contents in the meantime.
+    if (pending->lastWrite.count(inodeNumber)) {
+      continue;
+    }
+    pending->lastWrite[inodeNumber] = pending->writes.size();
+    pending->writes.push_back(TreeOverlayStore::Write{
+        TreeOverlayStore::Write::Type::SaveTree,
+        inodeNumber,
+        std::move(dir),
+        {},
+        {}});
+    if (pending->writes.size() == 1) {
+      pendingCondVar_.notify_one();
+    }
+  }
+  edit(*pending_.lock());
+}
+
+overlay::OverlayDir& TreeOverlay::bufferedDir(
+    PendingWrites& pending,
+    InodeNumber inodeNumber) {
+  return pending.writes[pending.lastWrite.at(inodeNumber)].dir;
+}
+
 const AbsolutePath& TreeOverlay::getLocalDir() const {
   return path_;
 }
 
 std::optional<overlay::OverlayDir> TreeOverlay::loadOverlayDir(
     InodeNumber inodeNumber) {
+  std::lock_guard<std::mutex> flushLock{flushMutex_};
+  if (auto dir = getBufferedDir(inodeNumber)) {
+    return dir;
+  }
   return store_.loadTree(inodeNumber);
 }
 
 std::optional<overlay::OverlayDir> TreeOverlay::loadAndRemoveOverlayDir(
     InodeNumber inodeNumber) {
+  if (isCheckpointing()) {
+    std::optional<overlay::OverlayDir> removed;
+    editBufferedDirs({inodeNumber}, [&](PendingWrites& pending) {
+      removed = std::exchange(bufferedDir(pending, inodeNumber), {});
+    });
+    return removed;
+  }
+  std::lock_guard<std::mutex> flushLock{flushMutex_};
+  flushWritesTo(inodeNumber);
   return store_.loadAndRemoveTree(inodeNumber);
 }
 
 void TreeOverlay::saveOverlayDir(
     InodeNumber inodeNumber,
     const overlay::OverlayDir& odir) {
-  return store_.saveTree(inodeNumber, odir);
+  if (!isBatching()) {
+    return store_.saveTree(inodeNumber, odir);
+  }
+  bufferWrite(TreeOverlayStore::Write{
+      TreeOverlayStore::Write::Type::SaveTree, inodeNumber, odir, {}, {}});
 }
 
 #ifndef _WIN32
@@ -65,6 +259,12 @@ folly::File TreeOverlay::createOverlayFile(
   EDEN_BUG() << "UNIMPLEMENTED";
 }
 
+std::optional<folly::File> TreeOverlay::cloneOverlayFile(
+    InodeNumber /*inodeNumber*/,
+    const folly::File& /*source*/) {
+  return std::nullopt;
+}
+
 folly::File TreeOverlay::openFile(
     InodeNumber /*inodeNumber*/,
     folly::StringPiece /*headerId*/) {
@@ -81,10 +281,20 @@ struct statfs TreeOverlay::statFs() const {
 #endif
 
 void TreeOverlay::removeOverlayData(InodeNumber inodeNumber) {
+  if (isCheckpointing()) {
+    return bufferWrite(TreeOverlayStore::Write{
+        TreeOverlayStore::Write::Type::SaveTree, inodeNumber, {}, {}, {}});
+  }
+  std::lock_guard<std::mutex> flushLock{flushMutex_};
+  flushWritesTo(inodeNumber);
   store_.removeTree(inodeNumber);
 }
 
 bool TreeOverlay::hasOverlayData(InodeNumber inodeNumber) {
+  std::lock_guard<std::mutex> flushLock{flushMutex_};
+  if (auto dir = getBufferedDir(inodeNumber)) {
+    return !dir->entries_ref()->empty();
+  }
   return store_.hasTree(inodeNumber);
 }
 
@@ -92,13 +302,43 @@ void TreeOverlay::addChild(
     InodeNumber parent,
     PathComponentPiece name,
     overlay::OverlayEntry entry) {
-  return store_.addChild(parent, name, entry);
+  if (!isBatching()) {
+    return store_.addChild(parent, name, entry);
+  }
+  if (isCheckpointing()) {
+    return editBufferedDirs({parent}, [&](PendingWrites& pending) {
+      bufferedDir(pending, parent)
+          .entries_ref()
+          ->insert_or_assign(name.stringPiece().str(), std::move(entry));
+    });
+  }
+  bufferWrite(TreeOverlayStore::Write{
+      TreeOverlayStore::Write::Type::AddChild,
+      parent,
+      {},
+      name.stringPiece().str(),
+      std::move(entry)});
 }
 
 void TreeOverlay::removeChild(
     InodeNumber parent,
     PathComponentPiece childName) {
-  return store_.removeChild(parent, childName);
+  if (!isBatching()) {
+    return store_.removeChild(parent, childName);
+  }
+  if (isCheckpointing()) {
+    return editBufferedDirs({parent}, [&](PendingWrites& pending) {
+      bufferedDir(pending, parent)
+          .entries_ref()
+          ->erase(childName.stringPiece().str());
+    });
+  }
+  bufferWrite(TreeOverlayStore::Write{
+      TreeOverlayStore::Write::Type::RemoveChild,
+      parent,
+      {},
+      childName.stringPiece().str(),
+      {}});
 }
 
 void TreeOverlay::renameChild(
@@ -106,6 +346,23 @@ void TreeOverlay::renameChild(
     InodeNumber dst,
     PathComponentPiece srcName,
     PathComponentPiece dstName) {
+  if (isCheckpointing()) {
+    return editBufferedDirs({src, dst}, [&](PendingWrites& pending) {
+      auto& srcEntries = *bufferedDir(pending, src).entries_ref();
+      auto it = srcEntries.find(srcName.stringPiece().str());
+      if (it == srcEntries.end()) {
+        return;
+      }
+      auto entry = std::move(it->second);
+      srcEntries.erase(it);
+      bufferedDir(pending, dst).entries_ref()->insert_or_assign(
+          dstName.stringPiece().str(), std::move(entry));
+    });
+  }
+  // Whether the destination may be overwritten depends on the children of
+  // the entry it replaces, so commit everything first.
+  std::lock_guard<std::mutex> flushLock{flushMutex_};
+  flushLocked();
   return store_.renameChild(src, dst, srcName, dstName);
 }
 
@@ -114,6 +371,7 @@ InodeNumber TreeOverlay::nextInodeNumber() {
 }
 
 InodeNumber TreeOverlay::scanLocalChanges(AbsolutePathPiece mountPath) {
+  flush();
 #ifdef _WIN32
   windowsFsckScanLocalChanges(*this, mountPath);
 #else
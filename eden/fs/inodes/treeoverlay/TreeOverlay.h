@@ -7,8 +7,17 @@
 
 #pragma once
 
+#include <folly/Function.h>
 #include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <chrono>
+#include <condition_variable>
+#include <initializer_list>
+#include <mutex>
 #include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "eden/fs/inodes/IOverlay.h"
 #include "eden/fs/inodes/treeoverlay/TreeOverlayStore.h"
@@ -19,22 +28,60 @@ class File;
 
 namespace facebook::eden {
 
-namespace overlay {
-class OverlayDir;
-}
-struct InodeNumber;
-
+/**
+ * An IOverlay that stores directories in a TreeOverlayStore.
+ *
+ * TreeOverlay owns the durability of directory writes: with WriteBatching
+ * enabled, it is the only layer that buffers them, and a write is durable
+ * once the store transaction that commits it returns. That happens in the
+ * background after WriteBatching::maxDelay or checkpointInterval, or before
+ * flush(), applyWrites() and close() return.
+ */
 class TreeOverlay : public IOverlay {
  public:
+  /**
+   * Controls how directory writes are buffered in memory and committed to
+   * the store together.
+   */
+  struct WriteBatching {
+    /**
+     * The longest a buffered write waits before it is committed. 0 disables
+     * buffering, unless checkpointInterval is set: every write is committed
+     * before it returns.
+     */
+    std::chrono::milliseconds maxDelay{0};
+
+    /**
+     * The number of buffered writes that triggers a commit without waiting
+     * for maxDelay.
+     */
+    size_t maxPendingWrites{1024};
+
+    /**
+     * When non-zero, the buffered writes to a directory are folded into its
+     * full contents, which stay buffered until they are committed every
+     * checkpointInterval, instead of after maxDelay or maxPendingWrites.
+     * Directory writes then only read the store the first time a directory
+     * is written in an interval, and memory usage is bounded by the
+     * directories written in an interval. Used by
+     * OverlayType::TreeCheckpointed, which loses up to an interval of
+     * changes if EdenFS crashes.
+     */
+    std::chrono::milliseconds checkpointInterval{0};
+  };
+
   explicit TreeOverlay(
       AbsolutePathPiece path,
       TreeOverlayStore::SynchronousMode mode =
-          TreeOverlayStore::SynchronousMode::Normal);
+          TreeOverlayStore::SynchronousMode::Normal,
+      WriteBatching batching = {});
 
-  explicit TreeOverlay(std::unique_ptr<SqliteDatabase> store)
-      : store_(std::move(store)) {}
+  explicit TreeOverlay(
+      std::unique_ptr<SqliteDatabase> store,
+      WriteBatching batching = {})
+      : store_(std::move(store)), batching_{batching} {}
 
-  ~TreeOverlay() override {}
+  ~TreeOverlay() override;
 
   TreeOverlay(const TreeOverlay&) = delete;
   TreeOverlay& operator=(const TreeOverlay&) = delete;
@@ -73,6 +120,10 @@ class TreeOverlay : public IOverlay {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) override;
 
+  std::optional<folly::File> cloneOverlayFile(
+      InodeNumber inodeNumber,
+      const folly::File& source) override;
+
   folly::File openFile(InodeNumber inodeNumber, folly::StringPiece headerId)
       override;
 
@@ -107,11 +158,102 @@ class TreeOverlay : public IOverlay {
    */
   InodeNumber scanLocalChanges(AbsolutePathPiece mountPath);
 
+  /**
+   * Commit every buffered write before returning.
+   */
+  void flush();
+
+  /**
+   * Commit the buffered writes, then writes, in a single transaction. See
+   * TreeOverlayStore::applyWrites.
+   */
+  size_t applyWrites(const std::vector<TreeOverlayStore::Write>& writes);
+
  private:
+  struct PendingWrites {
+    bool stop = false;
+    /**
+     * When checkpointing, these are only SaveTree writes, one per directory.
+     * Saving an empty directory is how a removed one is buffered.
+     */
+    std::vector<TreeOverlayStore::Write> writes;
+    /**
+     * The position in writes of the most recent write to each parent.
+     */
+    std::unordered_map<InodeNumber, size_t> lastWrite;
+  };
+
+  bool isCheckpointing() const {
+    return batching_.checkpointInterval.count() > 0;
+  }
+
+  bool isBatching() const {
+    return batching_.maxDelay.count() > 0 || isCheckpointing();
+  }
+
+  /**
+   * Buffer write, coalescing it with the buffered writes it supersedes.
+   */
+  void bufferWrite(TreeOverlayStore::Write write);
+
+  /**
+   * Commit the buffered writes. The caller must hold flushMutex_.
+   */
+  void flushLocked();
+
+  /**
+   * Make the store reflect every buffered write to inodeNumber. The caller
+   * must hold flushMutex_.
+   */
+  void flushWritesTo(InodeNumber inodeNumber);
+
+  /**
+   * Returns the buffered contents of inodeNumber if its most recent buffered
+   * write replaced them entirely. Otherwise, makes the store reflect the
+   * buffered writes to it and returns nothing. The caller must hold
+   * flushMutex_.
+   */
+  std::optional<overlay::OverlayDir> getBufferedDir(InodeNumber inodeNumber);
+
+  /**
+   * When checkpointing, call edit with the buffered writes once every
+   * directory of inodeNumbers has its full contents buffered, loading them
+   * from the store if needed. edit may modify those contents in place.
+   */
+  void editBufferedDirs(
+      std::initializer_list<InodeNumber> inodeNumbers,
+      folly::FunctionRef<void(PendingWrites&)> edit);
+
+  /**
+   * When checkpointing, the buffered contents of inodeNumber, which
+   * editBufferedDirs() made sure exist.
+   */
+  static overlay::OverlayDir& bufferedDir(
+      PendingWrites& pending,
+      InodeNumber inodeNumber);
+
+  void flusherThread() noexcept;
+
+  void stopFlusher();
+
   AbsolutePath path_;
 
   TreeOverlayStore store_;
 
   bool initialized_ = false;
+
+  const WriteBatching batching_;
+
+  /**
+   * Held while the buffered writes are committed and while the store is
+   * accessed directly, so that nothing reads the store between the time
+   * buffered writes leave pending_ and the time they are committed.
+   *
+   * Lock ordering: flushMutex_ is acquired before pending_.
+   */
+  std::mutex flushMutex_;
+  folly::Synchronized<PendingWrites, std::mutex> pending_;
+  std::condition_variable pendingCondVar_;
+  std::thread flusher_;
 };
 } // namespace facebook::eden
@@ -8,9 +8,9 @@
 #include "eden/fs/inodes/treeoverlay/TreeOverlayStore.h"
 
 #include <folly/Range.h>
+#include <folly/logging/xlog.h>
 #include <array>
 #include "eden/fs/inodes/InodeNumber.h"
-#include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/sqlite/PersistentSqliteStatement.h"
 #include "eden/fs/sqlite/SqliteStatement.h"
 #include "eden/fs/utils/DirType.h"
@@ -37,23 +37,48 @@ constexpr uint32_t kSchemaVersion = 1;
 // Maximum number of values when we do batch insertion
 constexpr size_t kBatchInsertSize = 8;
 
+// The number of connections serving reads. In WAL mode they run concurrently
+// with each other and with writes.
+constexpr size_t kReadConnections = 4;
+
+const std::string& selectTreeSql() {
+  static const auto sql = folly::to<std::string>(
+      "SELECT name, dtype, inode, hash FROM ",
+      kEntryTable,
+      " WHERE parent = ? ORDER BY name");
+  return sql;
+}
+
+const std::string& hasTreeSql() {
+  static const auto sql = folly::to<std::string>(
+      "SELECT 1 FROM ", kEntryTable, " WHERE parent = ?");
+  return sql;
+}
+
+void readTree(SqliteStatement& query, overlay::OverlayDir& dir) {
+  while (query.step()) {
+    auto name = query.columnBlob(0);
+    overlay::OverlayEntry entry;
+    entry.mode_ref() =
+        dtype_to_mode(static_cast<dtype_t>(query.columnUint64(1)));
+    entry.inodeNumber_ref() = query.columnUint64(2);
+    entry.hash_ref() = query.columnBlob(3).toString();
+    dir.entries_ref()->emplace(std::make_pair(name, entry));
+  }
+}
+
 } // namespace
 
 struct TreeOverlayStore::StatementCache {
   explicit StatementCache(SqliteDatabase::Connection& db)
       : deleteParent{db, "DELETE FROM ", kEntryTable, " WHERE parent = ?"},
-        selectTree{
-            db,
-            "SELECT name, dtype, inode, hash FROM ",
-            kEntryTable,
-            " WHERE parent = ? ORDER BY name"},
+        selectTree{db, selectTreeSql()},
         countChildren{
             db,
             "SELECT COUNT(*) FROM ",
             kEntryTable,
             " WHERE parent = ?"},
         deleteTree{db, "DELETE FROM ", kEntryTable, " WHERE parent = ?"},
-        hasTree{db, "SELECT 1 FROM ", kEntryTable, " WHERE parent = ?"},
         insertChild{
             db,
             "INSERT INTO ",
@@ -111,7 +136,6 @@ struct TreeOverlayStore::StatementCache {
   PersistentSqliteStatement selectTree;
   PersistentSqliteStatement countChildren;
   PersistentSqliteStatement deleteTree;
-  PersistentSqliteStatement hasTree;
   PersistentSqliteStatement insertChild;
   PersistentSqliteStatement deleteChild;
   PersistentSqliteStatement hasChild;
@@ -221,6 +245,9 @@ void TreeOverlayStore::createTableIfNonExisting() {
     auto conn = db_->lock();
     cache_ = std::make_unique<StatementCache>(conn);
   }
+
+  // Loading trees doesn't need to wait for writes.
+  db_->openReaders(kReadConnections);
 }
 
 InodeNumber TreeOverlayStore::loadCounters() {
@@ -263,71 +290,68 @@ InodeNumber TreeOverlayStore::nextInodeNumber() {
 void TreeOverlayStore::saveTree(
     InodeNumber inodeNumber,
     const overlay::OverlayDir& odir) {
-  db_->transaction([&](auto& txn) {
-    // When `saveTree` gets called, caller is expected to rewrite the tree
-    // content. So we need to remove the previously stored version.
-    auto& stmt = cache_->deleteParent.get(txn);
-    stmt.bind(1, inodeNumber.get());
-    stmt.step();
+  db_->transaction(
+      [&](auto& txn) { saveTreeLocked(txn, inodeNumber, odir); });
+}
 
-    // The following section generates the insertion SQLite statements based
-    // on number of entries in `OverlayDir`. This is faster than inserting
-    // them separately. Although we have to dynamically generate statements
-    // here.
-    auto count = odir.entries_ref()->size();
-    if (count == 0) {
-      return;
-    }
+void TreeOverlayStore::saveTreeLocked(
+    SqliteDatabase::Connection& txn,
+    InodeNumber inodeNumber,
+    const overlay::OverlayDir& odir) {
+  // When `saveTree` gets called, caller is expected to rewrite the tree
+  // content. So we need to remove the previously stored version.
+  auto& stmt = cache_->deleteParent.get(txn);
+  stmt.bind(1, inodeNumber.get());
+  stmt.step();
 
-    size_t batch_count = count / kBatchInsertSize;
-    auto remaining = count % kBatchInsertSize;
-    auto entries_iter = odir.entries_ref()->cbegin();
-
-    if (batch_count != 0) {
-      auto& batch_insert = cache_->batchInsert[kBatchInsertSize - 1].get(txn);
-      for (size_t i = 0; i < batch_count; i++) {
-        // One batch
-        for (size_t n = 0; n < kBatchInsertSize; n++, entries_iter++) {
-          auto name = PathComponentPiece{entries_iter->first};
-          const auto& entry = entries_iter->second;
-          insertInodeEntry(batch_insert, n, inodeNumber, name, entry);
-        }
-
-        batch_insert.step();
-        batch_insert.reset();
-      }
-    }
+  // The following section generates the insertion SQLite statements based
+  // on number of entries in `OverlayDir`. This is faster than inserting
+  // them separately. Although we have to dynamically generate statements
+  // here.
+  auto count = odir.entries_ref()->size();
+  if (count == 0) {
+    return;
+  }
 
-    if (remaining != 0) {
-      auto& insert = cache_->batchInsert[remaining - 1].get(txn);
-      for (size_t n = 0; entries_iter != odir.entries_ref()->cend();
-           entries_iter++, n++) {
+  size_t batch_count = count / kBatchInsertSize;
+  auto remaining = count % kBatchInsertSize;
+  auto entries_iter = odir.entries_ref()->cbegin();
+
+  if (batch_count != 0) {
+    auto& batch_insert = cache_->batchInsert[kBatchInsertSize - 1].get(txn);
+    for (size_t i = 0; i < batch_count; i++) {
+      // One batch
+      for (size_t n = 0; n < kBatchInsertSize; n++, entries_iter++) {
         auto name = PathComponentPiece{entries_iter->first};
         const auto& entry = entries_iter->second;
-        insertInodeEntry(insert, n, inodeNumber, name, entry);
+        insertInodeEntry(batch_insert, n, inodeNumber, name, entry);
       }
-      insert.step();
+
+      batch_insert.step();
+      batch_insert.reset();
     }
-  });
+  }
+
+  if (remaining != 0) {
+    auto& insert = cache_->batchInsert[remaining - 1].get(txn);
+    for (size_t n = 0; entries_iter != odir.entries_ref()->cend();
+         entries_iter++, n++) {
+      auto name = PathComponentPiece{entries_iter->first};
+      const auto& entry = entries_iter->second;
+      insertInodeEntry(insert, n, inodeNumber, name, entry);
+    }
+    insert.step();
+  }
 }
 
 overlay::OverlayDir TreeOverlayStore::loadTree(InodeNumber inode) {
   overlay::OverlayDir dir;
 
-  db_->transaction([&](auto& txn) {
-    auto& query = cache_->selectTree.get(txn);
-    query.bind(1, inode.get());
-
-    while (query.step()) {
-      auto name = query.columnBlob(0);
-      overlay::OverlayEntry entry;
-      entry.mode_ref() =
-          dtype_to_mode(static_cast<dtype_t>(query.columnUint64(1)));
-      entry.inodeNumber_ref() = query.columnUint64(2);
-      entry.hash_ref() = query.columnBlob(3).toString();
-      dir.entries_ref()->emplace(std::make_pair(name, entry));
-    }
-  });
+  // A single statement reads a consistent snapshot, no transaction needed.
+  auto reader = db_->lockReader();
+  auto& query = reader.statement(selectTreeSql());
+  query.bind(1, inode.get());
+  readTree(query, dir);
 
   return dir;
 }
@@ -339,16 +363,7 @@ overlay::OverlayDir TreeOverlayStore::loadAndRemoveTree(InodeNumber inode) {
     // SQLite does not support select-and-delete in one query.
     auto& query = cache_->selectTree.get(txn);
     query.bind(1, inode.get());
-
-    while (query.step()) {
-      auto name = query.columnBlob(0);
-      overlay::OverlayEntry entry;
-      entry.mode_ref() =
-          dtype_to_mode(static_cast<dtype_t>(query.columnUint64(1)));
-      entry.inodeNumber_ref() = query.columnUint64(2);
-      entry.hash_ref() = query.columnBlob(3).toString();
-      dir.entries_ref()->emplace(std::make_pair(name, entry));
-    }
+    readTree(query, dir);
 
     auto& deleteInode = cache_->deleteTree.get(txn);
     deleteInode.reset();
@@ -376,8 +391,8 @@ void TreeOverlayStore::removeTree(InodeNumber inode) {
 }
 
 bool TreeOverlayStore::hasTree(InodeNumber inode) {
-  auto db = db_->lock();
-  auto& query = cache_->hasTree.get(db);
+  auto reader = db_->lockReader();
+  auto& query = reader.statement(hasTreeSql());
   query.bind(1, inode.get());
   if (query.step()) {
     return query.columnUint64(0) == 1;
@@ -390,6 +405,14 @@ void TreeOverlayStore::addChild(
     PathComponentPiece name,
     overlay::OverlayEntry entry) {
   auto db = db_->lock();
+  addChildLocked(db, parent, name, entry);
+}
+
+void TreeOverlayStore::addChildLocked(
+    SqliteDatabase::Connection& db,
+    InodeNumber parent,
+    PathComponentPiece name,
+    const overlay::OverlayEntry& entry) {
   auto& stmt = cache_->insertChild.get(db);
   insertInodeEntry(stmt, 0, parent, name, entry);
   stmt.step();
@@ -399,6 +422,13 @@ void TreeOverlayStore::removeChild(
     InodeNumber parent,
     PathComponentPiece childName) {
   auto db = db_->lock();
+  removeChildLocked(db, parent, childName);
+}
+
+void TreeOverlayStore::removeChildLocked(
+    SqliteDatabase::Connection& db,
+    InodeNumber parent,
+    PathComponentPiece childName) {
   auto& stmt = cache_->deleteChild.get(db);
   stmt.bind(1, parent.get());
   stmt.bind(2, childName.stringPiece());
@@ -436,6 +466,52 @@ void TreeOverlayStore::renameChild(
   });
 }
 
+size_t TreeOverlayStore::applyWrites(const std::vector<Write>& writes) {
+  if (writes.empty()) {
+    return 0;
+  }
+
+  try {
+    db_->transaction([&](auto& txn) {
+      for (const auto& write : writes) {
+        applyWriteLocked(txn, write);
+      }
+    });
+    return 0;
+  } catch (const std::exception&) {
+    // The transaction has already been rolled back and logged.
+  }
+
+  size_t dropped = 0;
+  for (const auto& write : writes) {
+    try {
+      db_->transaction([&](auto& txn) { applyWriteLocked(txn, write); });
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "Dropping overlay write for inode " << write.parent << ": "
+                << ex.what();
+      ++dropped;
+    }
+  }
+  return dropped;
+}
+
+void TreeOverlayStore::applyWriteLocked(
+    SqliteDatabase::Connection& txn,
+    const Write& write) {
+  switch (write.type) {
+    case Write::Type::SaveTree:
+      saveTreeLocked(txn, write.parent, write.dir);
+      return;
+    case Write::Type::AddChild:
+      addChildLocked(
+          txn, write.parent, PathComponentPiece{write.name}, write.entry);
+      return;
+    case Write::Type::RemoveChild:
+      removeChildLocked(txn, write.parent, PathComponentPiece{write.name});
+      return;
+  }
+}
+
 void TreeOverlayStore::insertInodeEntry(
     SqliteStatement& inserts,
     size_t index,
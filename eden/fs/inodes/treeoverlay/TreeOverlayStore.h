@@ -12,18 +12,15 @@
 #include <memory>
 
 #include <fmt/format.h>
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/sqlite/SqliteDatabase.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 struct sqlite3;
 
 namespace facebook::eden {
-namespace overlay {
-class OverlayDir;
-class OverlayEntry;
-} // namespace overlay
 class SqliteStatement;
-struct InodeNumber;
 
 class TreeOverlayNonEmptyError : public std::exception {
  public:
@@ -50,6 +47,27 @@ class TreeOverlayStore {
     Normal = 1,
   };
 
+  /**
+   * A write that does not need to read the store first, and so can be
+   * deferred and committed together with others by applyWrites().
+   */
+  struct Write {
+    enum class Type : uint8_t {
+      SaveTree,
+      AddChild,
+      RemoveChild,
+    };
+
+    Type type;
+    InodeNumber parent;
+    /** The new contents of parent, for SaveTree. */
+    overlay::OverlayDir dir;
+    /** The name of the child written, for AddChild and RemoveChild. */
+    std::string name;
+    /** The child added, for AddChild. */
+    overlay::OverlayEntry entry;
+  };
+
   explicit TreeOverlayStore(
       AbsolutePathPiece dir,
       TreeOverlayStore::SynchronousMode mode =
@@ -134,6 +152,15 @@ class TreeOverlayStore {
       PathComponentPiece srcName,
       PathComponentPiece dstName);
 
+  /**
+   * Commit writes, in order, in a single transaction.
+   *
+   * If the transaction fails, each write is retried in its own transaction so
+   * that one bad write does not discard the others. Writes that still fail
+   * are logged and dropped. Returns the number of dropped writes.
+   */
+  size_t applyWrites(const std::vector<Write>& writes);
+
   std::unique_ptr<SqliteDatabase> takeDatabase();
 
  private:
@@ -141,6 +168,24 @@ class TreeOverlayStore {
 
   struct StatementCache;
 
+  void saveTreeLocked(
+      SqliteDatabase::Connection& txn,
+      InodeNumber inodeNumber,
+      const overlay::OverlayDir& odir);
+
+  void addChildLocked(
+      SqliteDatabase::Connection& db,
+      InodeNumber parent,
+      PathComponentPiece name,
+      const overlay::OverlayEntry& entry);
+
+  void removeChildLocked(
+      SqliteDatabase::Connection& db,
+      InodeNumber parent,
+      PathComponentPiece childName);
+
+  void applyWriteLocked(SqliteDatabase::Connection& txn, const Write& write);
+
   /**
    * Private helper function to add a SQLite statement that inserts a row to the
    * inode table.
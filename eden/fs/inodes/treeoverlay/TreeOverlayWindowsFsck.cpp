@@ -8,22 +8,35 @@
 #include "eden/fs/inodes/treeoverlay/TreeOverlayWindowsFsck.h"
 
 #ifdef _WIN32
-#include <boost/filesystem.hpp>
+#include <folly/ScopeGuard.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <folly/futures/Future.h>
+#include <folly/logging/xlog.h>
 #include <folly/portability/Windows.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
 
 #include <ProjectedFSLib.h> // @manual
-#include <winioctl.h> // @manual
 
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/inodes/treeoverlay/TreeOverlay.h"
+#include "eden/fs/inodes/treeoverlay/TreeOverlayStore.h"
 #include "eden/fs/utils/DirType.h"
 #include "eden/fs/utils/WinError.h"
 
 namespace facebook::eden {
 namespace {
 
-namespace boost_fs = boost::filesystem;
+/**
+ * Directories are scanned concurrently, but they all end up writing to the
+ * same overlay database, so there is little point in more threads than this.
+ */
+constexpr unsigned kMaxScanThreads = 16;
+
+using Writes = std::vector<TreeOverlayStore::Write>;
 
 PRJ_FILE_STATE getPrjFileState(AbsolutePathPiece entry) {
   auto wpath = entry.wide();
@@ -47,109 +60,76 @@ std::set<PathComponent> makeEntriesSet(const overlay::OverlayDir& dir) {
   return result;
 }
 
-namespace {
 // Reparse tag for UNIX domain socket is not defined in Windows header files.
 const ULONG IO_REPARSE_TAG_SOCKET = 0x80000023;
 
-// This is only defined in Windows Device Driver Kit and it is inconvenient to
-// include. This is copied from Watchman's FileDescriptor.cpp.
-struct REPARSE_DATA_BUFFER {
-  ULONG ReparseTag;
-  USHORT ReparseDataLength;
-  USHORT Reserved;
-  union {
-    struct {
-      USHORT SubstituteNameOffset;
-      USHORT SubstituteNameLength;
-      USHORT PrintNameOffset;
-      USHORT PrintNameLength;
-      ULONG Flags;
-      WCHAR PathBuffer[1];
-    } SymbolicLinkReparseBuffer;
-    struct {
-      USHORT SubstituteNameOffset;
-      USHORT SubstituteNameLength;
-      USHORT PrintNameOffset;
-      USHORT PrintNameLength;
-      WCHAR PathBuffer[1];
-    } MountPointReparseBuffer;
-    struct {
-      UCHAR DataBuffer[1];
-    } GenericReparseBuffer;
-  };
-};
-} // namespace
-
-dtype_t dtypeFromEntry(const boost::filesystem::directory_entry& entry) {
-  XLOGF(DBG9, "dtypeFromEntry: {}", entry.path().string().c_str());
-  auto path = entry.path().wstring();
-  WIN32_FILE_ATTRIBUTE_DATA attrs;
-
-  if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &attrs)) {
-    XLOGF(
-        DBG3,
-        "Unable to get file attributes for {}: {}",
-        entry.path().string(),
-        GetLastError());
-    return dtype_t::Unknown;
-  }
-
-  if (attrs.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
-    auto handle = CreateFileW(
-        path.c_str(),
-        FILE_GENERIC_READ,
-        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-        NULL,
-        OPEN_EXISTING,
-        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT,
-        NULL);
-    if (handle == INVALID_HANDLE_VALUE) {
-      XLOGF(
-          DBG3,
-          "Unable to determine reparse point type for {}: {}",
-          entry.path().string(),
-          GetLastError());
-      return dtype_t::Unknown;
-    }
-
-    char buffer[MAXIMUM_REPARSE_DATA_BUFFER_SIZE];
-    DWORD bytes_written;
-
-    if (!DeviceIoControl(
-            handle,
-            FSCTL_GET_REPARSE_POINT,
-            NULL,
-            0,
-            buffer,
-            MAXIMUM_REPARSE_DATA_BUFFER_SIZE,
-            &bytes_written,
-            NULL)) {
-      XLOGF(
-          DBG3,
-          "Unable to read reparse point data for {}: {}",
-          entry.path().string(),
-          GetLastError());
-      return dtype_t::Unknown;
-    }
-
-    auto reparse_data = reinterpret_cast<const REPARSE_DATA_BUFFER*>(buffer);
-
-    if (reparse_data->ReparseTag == IO_REPARSE_TAG_SYMLINK) {
+dtype_t dtypeFromFindData(const WIN32_FIND_DATAW& data) {
+  if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+    // For reparse points, FindFirstFileEx returns the reparse tag in
+    // dwReserved0, which saves reading the reparse data.
+    if (data.dwReserved0 == IO_REPARSE_TAG_SYMLINK) {
       return dtype_t::Symlink;
-    } else if (reparse_data->ReparseTag == IO_REPARSE_TAG_SOCKET) {
+    } else if (data.dwReserved0 == IO_REPARSE_TAG_SOCKET) {
       return dtype_t::Regular;
     }
 
     // We don't care about other reparse point types, so treating them as
     // regular files.
     return dtype_t::Regular;
-  } else if (attrs.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+  } else if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
     return dtype_t::Dir;
   } else {
     return dtype_t::Regular;
   }
 }
 
+struct DiskEntry {
+  PathComponent name;
+  dtype_t dtype;
+};
+
+/**
+ * List the entries of dir. The type of each entry comes with the listing,
+ * and FIND_FIRST_EX_LARGE_FETCH fetches them in large batches, so this is
+ * far cheaper than querying the attributes of each entry.
+ */
+std::vector<DiskEntry> listDirectory(AbsolutePathPiece dir) {
+  auto pattern = dir.wide() + L"\\*";
+  WIN32_FIND_DATAW data;
+  auto handle = FindFirstFileExW(
+      pattern.c_str(),
+      FindExInfoBasic,
+      &data,
+      FindExSearchNameMatch,
+      nullptr,
+      FIND_FIRST_EX_LARGE_FETCH);
+  if (handle == INVALID_HANDLE_VALUE) {
+    auto error = GetLastError();
+    if (error == ERROR_FILE_NOT_FOUND) {
+      return {};
+    }
+    throwWin32ErrorExplicit(error, fmt::format("Unable to list {}", dir));
+  }
+  SCOPE_EXIT {
+    FindClose(handle);
+  };
+
+  std::vector<DiskEntry> entries;
+  do {
+    std::wstring_view name{data.cFileName};
+    if (name == L"." || name == L"..") {
+      continue;
+    }
+    entries.push_back(DiskEntry{PathComponent{name}, dtypeFromFindData(data)});
+  } while (FindNextFileW(handle, &data));
+
+  auto error = GetLastError();
+  if (error != ERROR_NO_MORE_FILES) {
+    throwWin32ErrorExplicit(error, fmt::format("Unable to list {}", dir));
+  }
+  return entries;
+}
+
 std::optional<overlay::OverlayEntry> getEntryFromOverlayDir(
     const overlay::OverlayDir& dir,
     PathComponentPiece name) {
@@ -164,7 +144,22 @@ std::optional<overlay::OverlayEntry> getEntryFromOverlayDir(
   return std::nullopt;
 }
 
-void removeChildRecursively(TreeOverlay& overlay, InodeNumber inode) {
+void addRemoveChild(
+    Writes& writes,
+    InodeNumber parent,
+    PathComponentPiece name) {
+  writes.push_back(TreeOverlayStore::Write{
+      TreeOverlayStore::Write::Type::RemoveChild,
+      parent,
+      {},
+      name.stringPiece().str(),
+      {}});
+}
+
+void removeChildRecursively(
+    TreeOverlay& overlay,
+    InodeNumber inode,
+    Writes& writes) {
   XLOGF(DBG9, "Removing directory inode = {} ", inode);
   if (auto dir = overlay.loadOverlayDir(inode)) {
     const auto& entries = dir->entries_ref();
@@ -172,10 +167,10 @@ void removeChildRecursively(TreeOverlay& overlay, InodeNumber inode) {
       const auto& entry = iter->second;
       if (S_ISDIR(*entry.mode_ref())) {
         auto entryInode = InodeNumber::fromThrift(*entry.inodeNumber_ref());
-        removeChildRecursively(overlay, entryInode);
+        removeChildRecursively(overlay, entryInode, writes);
       }
       XLOGF(DBG9, "Removing child path = {}", iter->first);
-      overlay.removeChild(inode, PathComponentPiece{iter->first});
+      addRemoveChild(writes, inode, PathComponentPiece{iter->first});
     }
   }
 }
@@ -187,43 +182,53 @@ void removeOverlayEntry(
     TreeOverlay& overlay,
     InodeNumber parent,
     PathComponentPiece name,
-    std::optional<overlay::OverlayEntry> entry = std::nullopt) {
-  if (!entry) {
-    auto dir = overlay.loadOverlayDir(parent);
-    entry = getEntryFromOverlayDir(*dir, name);
-  }
-  auto overlayMode = static_cast<mode_t>(*entry->mode_ref());
+    const overlay::OverlayEntry& entry,
+    Writes& writes) {
+  auto overlayMode = static_cast<mode_t>(*entry.mode_ref());
   if (S_ISDIR(overlayMode)) {
-    auto overlayInode = InodeNumber::fromThrift(*entry->inodeNumber_ref());
-    removeChildRecursively(overlay, overlayInode);
+    auto overlayInode = InodeNumber::fromThrift(*entry.inodeNumber_ref());
+    removeChildRecursively(overlay, overlayInode, writes);
   }
-  overlay.removeChild(parent, name);
+  addRemoveChild(writes, parent, name);
 }
 
-void scanCurrentDir(
+/** A child directory whose contents the user may have changed. */
+struct ChildToScan {
+  AbsolutePath path;
+  InodeNumber inode;
+  bool recordDeletion;
+};
+
+/**
+ * Synchronize the overlay of a single directory with its disk state, in a
+ * single overlay transaction, and return the children to scan next.
+ */
+std::vector<ChildToScan> syncCurrentDir(
     TreeOverlay& overlay,
     AbsolutePathPiece dir,
     InodeNumber inode,
-    overlay::OverlayDir knownState,
+    const overlay::OverlayDir& knownState,
     bool recordDeletion) {
   if (!dir.is_directory()) {
     XLOGF(WARN, "Attempting to scan '{}' which is not a directory", dir);
-    return;
+    return {};
   }
 
   XLOGF(DBG3, "Scanning {}", dir);
 
+  auto diskEntries = listDirectory(dir);
   auto overlayEntries = makeEntriesSet(knownState);
+  Writes writes;
+  // The directories the user may have changed, and whether they are Full.
+  std::vector<std::pair<PathComponentPiece, bool>> childDirs;
   // Loop to synchronize overlay state with disk state
-  for (const auto& entry :
-       boost::filesystem::directory_iterator(dir.as_boost())) {
-    auto path = AbsolutePath{entry.path().c_str()};
-    auto name = path.basename();
-    auto dtype = dtypeFromEntry(entry);
+  for (const auto& [name, dtype] : diskEntries) {
+    auto path = dir + name;
 
     // TODO: EdenFS for Windows does not support symlinks yet, the only
     // symlink we have are redirection points.
     if (dtype == dtype_t::Symlink) {
+      XLOGF(DBG5, "Skipped {} since it's a symlink", path);
       continue;
     }
 
@@ -256,7 +261,7 @@ void scanCurrentDir(
             "Mismatch file type, expected: {} overlay: {}",
             dtype,
             overlayDtype);
-        removeOverlayEntry(overlay, inode, name, overlayEntry);
+        removeOverlayEntry(overlay, inode, name, *overlayEntry, writes);
         presentInOverlay = false;
       }
     }
@@ -273,7 +278,21 @@ void scanCurrentDir(
       overlay::OverlayEntry overlayEntry;
       overlayEntry.set_mode(dtype_to_mode(dtype));
       overlayEntry.set_inodeNumber(overlay.nextInodeNumber().get());
-      overlay.addChild(inode, name, overlayEntry);
+      writes.push_back(TreeOverlayStore::Write{
+          TreeOverlayStore::Write::Type::AddChild,
+          inode,
+          {},
+          name.stringPiece().str(),
+          std::move(overlayEntry)});
+    }
+
+    // User can only modify directory content if it is Full or Dirty
+    // Placeholder.
+    auto isFull = (state & PRJ_FILE_STATE_FULL) == PRJ_FILE_STATE_FULL;
+    auto isDirtyPlaceholder = (state & PRJ_FILE_STATE_DIRTY_PLACEHOLDER) ==
+        PRJ_FILE_STATE_DIRTY_PLACEHOLDER;
+    if (dtype == dtype_t::Dir && (isFull || isDirtyPlaceholder)) {
+      childDirs.emplace_back(name, isFull);
     }
   }
 
@@ -287,43 +306,80 @@ void scanCurrentDir(
          removed != overlayEntries.cend();
          removed++) {
       XLOGF(DBG3, "Removing missing entry from overlay: {}", *removed);
-      removeOverlayEntry(overlay, inode, *removed);
+      auto overlayEntry = getEntryFromOverlayDir(knownState, *removed);
+      removeOverlayEntry(overlay, inode, *removed, *overlayEntry, writes);
     }
   }
 
+  if (!writes.empty()) {
+    XLOGF(DBG3, "Applying {} fixes to {}", writes.size(), dir);
+    overlay.applyWrites(writes);
+  }
+
   XLOGF(DBG9, "Reloading {} from overlay.", inode);
   // Reload the updated overlay as we have fixed the inconsistency.
   auto updated = *overlay.loadOverlayDir(inode);
 
   // Now that this overlay directory is consistent with the on-disk state,
-  // proceed to its children.
-  for (const auto& entry :
-       boost::filesystem::directory_iterator(dir.as_boost())) {
-    auto path = AbsolutePath{entry.path().c_str()};
-    auto mode = dtypeFromEntry(entry);
-
-    // We can't scan non-directories nor follow symlinks
-    if (mode == dtype_t::Symlink) {
-      XLOGF(DBG5, "Skipped {} since it's a symlink", path);
-      continue;
-    } else if (mode != dtype_t::Dir) {
-      continue;
-    }
-
-    auto state = getPrjFileState(path);
-    // User can only modify directory content if it is Full or Dirty
-    // Placeholder.
-    auto isFull = (state & PRJ_FILE_STATE_FULL) == PRJ_FILE_STATE_FULL;
-    auto isDirtyPlaceholder = (state & PRJ_FILE_STATE_DIRTY_PLACEHOLDER) ==
-        PRJ_FILE_STATE_DIRTY_PLACEHOLDER;
-    if (isFull || isDirtyPlaceholder) {
-      auto overlayEntry = getEntryFromOverlayDir(updated, path.basename());
-      auto entryInode =
-          InodeNumber::fromThrift(*overlayEntry->inodeNumber_ref());
-      auto entryDir = overlay.loadOverlayDir(entryInode);
-      scanCurrentDir(overlay, path, entryInode, *entryDir, isFull);
-    }
+  // its children can be scanned.
+  std::vector<ChildToScan> children;
+  children.reserve(childDirs.size());
+  for (auto [name, isFull] : childDirs) {
+    auto overlayEntry = getEntryFromOverlayDir(updated, name);
+    children.push_back(ChildToScan{
+        dir + name,
+        InodeNumber::fromThrift(*overlayEntry->inodeNumber_ref()),
+        isFull});
   }
+  return children;
+}
+
+/**
+ * Scan dir, then its children concurrently on executor. Subtrees don't
+ * depend on each other, but a directory must be synchronized before its
+ * children, as it provides their inode numbers.
+ *
+ * The returned future completes once the whole subtree was scanned, with the
+ * first error if any directory failed.
+ */
+folly::Future<folly::Unit> scanCurrentDir(
+    TreeOverlay& overlay,
+    folly::Executor::KeepAlive<> executor,
+    AbsolutePath dir,
+    InodeNumber inode,
+    bool recordDeletion) {
+  return folly::via(
+             executor,
+             [&overlay, dir = std::move(dir), inode, recordDeletion] {
+               auto knownState = overlay.loadOverlayDir(inode);
+               return syncCurrentDir(
+                   overlay,
+                   dir,
+                   inode,
+                   knownState.value_or(overlay::OverlayDir{}),
+                   recordDeletion);
+             })
+      .thenValue([&overlay, executor](std::vector<ChildToScan> children) {
+        std::vector<folly::Future<folly::Unit>> scans;
+        scans.reserve(children.size());
+        for (auto& child : children) {
+          scans.push_back(scanCurrentDir(
+              overlay,
+              executor,
+              std::move(child.path),
+              child.inode,
+              child.recordDeletion));
+        }
+        // Wait for every subtree, even after a failure, as they all
+        // reference the overlay.
+        return folly::collectAll(std::move(scans))
+            .toUnsafeFuture()
+            .thenValue([](std::vector<folly::Try<folly::Unit>> results) {
+              for (auto& result : results) {
+                result.throwUnlessValue();
+              }
+            });
+      });
 }
 } // namespace
 
@@ -331,8 +387,18 @@ void windowsFsckScanLocalChanges(
     TreeOverlay& overlay,
     AbsolutePathPiece mountPath) {
   XLOGF(INFO, "Start scanning {}", mountPath);
-  if (auto view = overlay.loadOverlayDir(kRootNodeId)) {
-    scanCurrentDir(overlay, mountPath, kRootNodeId, *view, false);
+  if (overlay.loadOverlayDir(kRootNodeId)) {
+    auto numThreads =
+        std::clamp(std::thread::hardware_concurrency(), 1u, kMaxScanThreads);
+    folly::CPUThreadPoolExecutor executor{
+        numThreads, std::make_shared<folly::NamedThreadFactory>("WinFsck")};
+    scanCurrentDir(
+        overlay,
+        folly::getKeepAliveToken(executor),
+        mountPath.copy(),
+        kRootNodeId,
+        false)
+        .get();
     XLOGF(INFO, "Scanning complete for {}", mountPath);
   } else {
     XLOG(INFO)
@@ -44,6 +44,8 @@ class TreeOverlay;
  *
  * See also: https://docs.microsoft.com/en-us/windows/win32/projfs/cache-state
  *
+ * Subtrees are scanned concurrently on a thread pool, and the fixes of each
+ * directory are written in a single overlay transaction.
  */
 void windowsFsckScanLocalChanges(
     TreeOverlay& overlay,
@@ -9,12 +9,16 @@
 
 #include <folly/logging/xlog.h>
 #include <folly/portability/GTest.h>
+#include <atomic>
 #include <memory>
 #include <optional>
+#include <thread>
+#include <vector>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/sqlite/SqliteDatabase.h"
+#include "eden/fs/testharness/TempFile.h"
 #include "eden/fs/utils/DirType.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -272,4 +276,44 @@ TEST_F(TreeOverlayStoreTest, testRenameChild) {
     expect_entry(it->second, entry);
   }
 }
+
+TEST(TreeOverlayStoreOnDiskTest, readersSeeCommittedWrites) {
+  auto tmpdir = makeTempDir("eden_test");
+  TreeOverlayStore store{AbsolutePath{tmpdir.path().string()}};
+  store.createTableIfNonExisting();
+  store.loadCounters();
+
+  overlay::OverlayEntry entry;
+  entry.mode_ref() = dtype_to_mode(dtype_t::Regular);
+  entry.inodeNumber_ref() = store.nextInodeNumber().get();
+  overlay::OverlayDir dir;
+  dir.entries_ref()->emplace("a", entry);
+  store.saveTree(kRootNodeId, dir);
+
+  // Loads are served by the read connections, concurrently.
+  std::vector<std::thread> threads;
+  std::atomic<size_t> loaded{0};
+  for (size_t i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      for (size_t j = 0; j < 100; ++j) {
+        if (store.loadTree(kRootNodeId).entries_ref()->size() == 1 &&
+            store.hasTree(kRootNodeId)) {
+          ++loaded;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(800, loaded.load());
+
+  // Each read starts from the latest commit.
+  store.addChild(kRootNodeId, "b"_pc, entry);
+  EXPECT_EQ(2, store.loadTree(kRootNodeId).entries_ref()->size());
+  store.removeChild(kRootNodeId, "a"_pc);
+  store.removeChild(kRootNodeId, "b"_pc);
+  EXPECT_FALSE(store.hasTree(kRootNodeId));
+  store.close();
+}
 } // namespace facebook::eden
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/treeoverlay/TreeOverlay.h"
+
+#include <folly/portability/GTest.h>
+#include <thread>
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
+#include "eden/fs/testharness/TempFile.h"
+#include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+using namespace std::chrono_literals;
+
+namespace facebook::eden {
+
+using namespace facebook::eden::path_literals;
+
+namespace {
+// Long enough that nothing is committed in the background during a test.
+constexpr TreeOverlay::WriteBatching kBatching{1h, 1024};
+constexpr TreeOverlay::WriteBatching kCheckpointing{0ms, 1024, 1h};
+
+overlay::OverlayEntry makeEntry(InodeNumber inode) {
+  overlay::OverlayEntry entry;
+  entry.mode_ref() = dtype_to_mode(dtype_t::Regular);
+  entry.inodeNumber_ref() = inode.get();
+  return entry;
+}
+} // namespace
+
+TEST(TreeOverlayTest, bufferedWritesAreReadBack) {
+  TreeOverlay overlay{
+      std::make_unique<SqliteDatabase>(SqliteDatabase::inMemory), kBatching};
+  overlay.initOverlay(true);
+
+  auto dirInode = overlay.nextInodeNumber();
+  EXPECT_FALSE(overlay.hasOverlayData(dirInode));
+
+  overlay::OverlayDir dir;
+  dir.entries_ref()->emplace("a", makeEntry(overlay.nextInodeNumber()));
+  overlay.saveOverlayDir(dirInode, dir);
+  EXPECT_TRUE(overlay.hasOverlayData(dirInode));
+  EXPECT_EQ(1, overlay.loadOverlayDir(dirInode)->entries_ref()->size());
+
+  overlay.addChild(dirInode, "b"_pc, makeEntry(overlay.nextInodeNumber()));
+  overlay.removeChild(dirInode, "a"_pc);
+  auto loaded = overlay.loadOverlayDir(dirInode);
+  ASSERT_EQ(1, loaded->entries_ref()->size());
+  EXPECT_EQ("b", loaded->entries_ref()->begin()->first);
+
+  overlay.removeChild(dirInode, "b"_pc);
+  overlay.removeOverlayData(dirInode);
+  EXPECT_FALSE(overlay.hasOverlayData(dirInode));
+  overlay.close(std::nullopt);
+}
+
+TEST(TreeOverlayTest, closeCommitsBufferedWrites) {
+  auto tmpdir = makeTempDir("eden_test");
+  auto path = AbsolutePath{tmpdir.path().string()};
+
+  InodeNumber dirInode;
+  {
+    TreeOverlay overlay{
+        path, TreeOverlayStore::SynchronousMode::Normal, kBatching};
+    overlay.initOverlay(true);
+    dirInode = overlay.nextInodeNumber();
+
+    // Saving the same directory twice only keeps the latest contents.
+    overlay::OverlayDir dir;
+    dir.entries_ref()->emplace("a", makeEntry(overlay.nextInodeNumber()));
+    overlay.saveOverlayDir(dirInode, dir);
+    dir.entries_ref()->emplace("b", makeEntry(overlay.nextInodeNumber()));
+    overlay.saveOverlayDir(dirInode, dir);
+    overlay.close(std::nullopt);
+  }
+
+  TreeOverlay overlay{path};
+  overlay.initOverlay(true);
+  auto loaded = overlay.loadOverlayDir(dirInode);
+  ASSERT_EQ(2, loaded->entries_ref()->size());
+  EXPECT_EQ("a", loaded->entries_ref()->begin()->first);
+  overlay.close(std::nullopt);
+}
+
+TEST(TreeOverlayTest, enoughBufferedWritesAreCommittedWithoutDelay) {
+  auto tmpdir = makeTempDir("eden_test");
+  auto path = AbsolutePath{tmpdir.path().string()};
+
+  TreeOverlay writer{path, TreeOverlayStore::SynchronousMode::Normal, {1h, 2}};
+  writer.initOverlay(true);
+  auto dirInode = writer.nextInodeNumber();
+  writer.addChild(dirInode, "a"_pc, makeEntry(writer.nextInodeNumber()));
+  writer.addChild(dirInode, "b"_pc, makeEntry(writer.nextInodeNumber()));
+
+  // The maximum pending count wakes the flusher; poll a separate connection
+  // to the same database until the commit shows up.
+  TreeOverlay reader{path};
+  reader.initOverlay(true);
+  size_t entries = 0;
+  for (int i = 0; i < 1000 && entries != 2; ++i) {
+    entries = reader.loadOverlayDir(dirInode)->entries_ref()->size();
+    if (entries != 2) {
+      std::this_thread::sleep_for(10ms);
+    }
+  }
+  EXPECT_EQ(2, entries);
+  reader.close(std::nullopt);
+  writer.close(std::nullopt);
+}
+
+TEST(TreeOverlayTest, checkpointedWritesAreOnlyCommittedOnFlush) {
+  auto tmpdir = makeTempDir("eden_test");
+  auto path = AbsolutePath{tmpdir.path().string()};
+
+  TreeOverlay writer{
+      path, TreeOverlayStore::SynchronousMode::Normal, kCheckpointing};
+  writer.initOverlay(true);
+  TreeOverlay reader{path};
+  reader.initOverlay(true);
+
+  auto srcInode = writer.nextInodeNumber();
+  auto dstInode = writer.nextInodeNumber();
+  auto removedInode = writer.nextInodeNumber();
+  writer.addChild(srcInode, "a"_pc, makeEntry(writer.nextInodeNumber()));
+  writer.addChild(srcInode, "b"_pc, makeEntry(writer.nextInodeNumber()));
+  writer.addChild(removedInode, "c"_pc, makeEntry(writer.nextInodeNumber()));
+  writer.flush();
+  EXPECT_EQ(2, reader.loadOverlayDir(srcInode)->entries_ref()->size());
+
+  // None of these reach the store, but they are read back.
+  writer.removeChild(srcInode, "b"_pc);
+  writer.renameChild(srcInode, dstInode, "a"_pc, "d"_pc);
+  auto removed = writer.loadAndRemoveOverlayDir(removedInode);
+  ASSERT_TRUE(removed);
+  EXPECT_EQ(1, removed->entries_ref()->size());
+  EXPECT_FALSE(writer.hasOverlayData(srcInode));
+  EXPECT_FALSE(writer.hasOverlayData(removedInode));
+  auto dst = writer.loadOverlayDir(dstInode);
+  ASSERT_EQ(1, dst->entries_ref()->size());
+  EXPECT_EQ("d", dst->entries_ref()->begin()->first);
+
+  EXPECT_EQ(2, reader.loadOverlayDir(srcInode)->entries_ref()->size());
+  EXPECT_FALSE(reader.hasOverlayData(dstInode));
+  EXPECT_TRUE(reader.hasOverlayData(removedInode));
+
+  writer.flush();
+  EXPECT_FALSE(reader.hasOverlayData(srcInode));
+  EXPECT_FALSE(reader.hasOverlayData(removedInode));
+  dst = reader.loadOverlayDir(dstInode);
+  ASSERT_EQ(1, dst->entries_ref()->size());
+  EXPECT_EQ("d", dst->entries_ref()->begin()->first);
+  reader.close(std::nullopt);
+  writer.close(std::nullopt);
+}
+
+TEST(TreeOverlayTest, checkpointsAreTakenPeriodically) {
+  auto tmpdir = makeTempDir("eden_test");
+  auto path = AbsolutePath{tmpdir.path().string()};
+
+  TreeOverlay writer{
+      path, TreeOverlayStore::SynchronousMode::Normal, {0ms, 1024, 1ms}};
+  writer.initOverlay(true);
+  auto dirInode = writer.nextInodeNumber();
+  writer.addChild(dirInode, "a"_pc, makeEntry(writer.nextInodeNumber()));
+
+  TreeOverlay reader{path};
+  reader.initOverlay(true);
+  bool committed = false;
+  for (int i = 0; i < 1000 && !committed; ++i) {
+    committed = reader.hasOverlayData(dirInode);
+    if (!committed) {
+      std::this_thread::sleep_for(10ms);
+    }
+  }
+  EXPECT_TRUE(committed);
+  reader.close(std::nullopt);
+  writer.close(std::nullopt);
+}
+
+} // namespace facebook::eden
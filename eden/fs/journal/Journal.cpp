@@ -6,8 +6,17 @@
  */
 
 #include "Journal.h"
+#include <fmt/format.h>
+#include <folly/ExceptionString.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
 #include <folly/logging/xlog.h>
+#include <limits>
+#include <system_error>
+#include <tuple>
+#include <utility>
 #include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/utils/FileUtils.h"
 
 namespace facebook::eden {
 
@@ -32,17 +41,20 @@ JournalDeltaPtr Journal::DeltaState::frontPtr() noexcept {
 }
 
 void Journal::DeltaState::popFront() {
+  if (!empty()) {
+    firstRetainedSequence = getFrontSequenceID() + 1;
+  }
   bool isFileChangeEmpty = fileChangeDeltas.empty();
   bool isHashUpdateEmpty = hashUpdateDeltas.empty();
   if (!isFileChangeEmpty && !isHashUpdateEmpty) {
     if (fileChangeDeltas.front().sequenceID <
         hashUpdateDeltas.front().sequenceID) {
-      fileChangeDeltas.pop_front();
+      popFrontFileChange();
     } else {
       hashUpdateDeltas.pop_front();
     }
   } else if (!isFileChangeEmpty) {
-    fileChangeDeltas.pop_front();
+    popFrontFileChange();
   } else if (!isHashUpdateEmpty) {
     hashUpdateDeltas.pop_front();
   }
@@ -88,7 +100,46 @@ bool Journal::DeltaState::isFileChangeInBack() const {
   return !isFileChangeEmpty && isHashUpdateEmpty;
 }
 
+template <typename Func>
+void Journal::DeltaState::forEachTopLevel(
+    const FileChangeJournalDelta& delta,
+    Func&& func) const {
+  std::optional<JournalPathTable::PathId> topLevel1;
+  if (delta.isPath1Valid) {
+    topLevel1 = paths.getTopLevel(delta.path1);
+    func(*topLevel1);
+  }
+  if (delta.isPath2Valid) {
+    auto topLevel2 = paths.getTopLevel(delta.path2);
+    if (topLevel2 != topLevel1) {
+      func(topLevel2);
+    }
+  }
+}
+
+void Journal::DeltaState::popFrontFileChange() {
+  auto& front = fileChangeDeltas.front();
+  forEachTopLevel(front, [&](JournalPathTable::PathId topLevel) {
+    auto it = fileChangesByTopLevel.find(topLevel);
+    XDCHECK(it != fileChangesByTopLevel.end());
+    XDCHECK_EQ(it->second.front(), poppedFileChanges);
+    it->second.pop_front();
+    --indexedFileChanges;
+    if (it->second.empty()) {
+      fileChangesByTopLevel.erase(it);
+    }
+  });
+  front.releasePaths(paths);
+  fileChangeDeltas.pop_front();
+  ++poppedFileChanges;
+}
+
 void Journal::DeltaState::appendDelta(FileChangeJournalDelta&& delta) {
+  auto position = poppedFileChanges + fileChangeDeltas.size();
+  forEachTopLevel(delta, [&](JournalPathTable::PathId topLevel) {
+    fileChangesByTopLevel[topLevel].push_back(position);
+    ++indexedFileChanges;
+  });
   fileChangeDeltas.emplace_back(std::move(delta));
 }
 
@@ -96,6 +147,25 @@ void Journal::DeltaState::appendDelta(RootUpdateJournalDelta&& delta) {
   hashUpdateDeltas.emplace_back(std::move(delta));
 }
 
+void Journal::DeltaState::clear() {
+  fileChangeDeltas.clear();
+  hashUpdateDeltas.clear();
+  fileChangesByTopLevel.clear();
+  indexedFileChanges = 0;
+  poppedFileChanges = 0;
+  firstRetainedSequence = nextSequence;
+  paths = JournalPathTable{};
+}
+
+size_t Journal::DeltaState::estimateIndexMemoryUsage() const {
+  // Each deque allocates its block map and at least one 512 byte block.
+  static const size_t kDequeOverhead =
+      folly::goodMallocSize(512) + folly::goodMallocSize(8 * sizeof(void*));
+  return fileChangesByTopLevel.getAllocatedMemorySize() +
+      fileChangesByTopLevel.size() * kDequeOverhead +
+      indexedFileChanges * sizeof(size_t);
+}
+
 Journal::Journal(std::shared_ptr<EdenStats> edenStats)
     : edenStats_{std::move(edenStats)} {
   // Add 0 so that this counter shows up in ODS
@@ -103,29 +173,33 @@ Journal::Journal(std::shared_ptr<EdenStats> edenStats)
 }
 
 void Journal::recordCreated(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::CREATED));
+  addDelta(FileChangeJournalDelta(FileChangeJournalDelta::CREATED), fileName);
 }
 
 void Journal::recordRemoved(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::REMOVED));
+  addDelta(FileChangeJournalDelta(FileChangeJournalDelta::REMOVED), fileName);
 }
 
 void Journal::recordChanged(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::CHANGED));
+  addDelta(FileChangeJournalDelta(FileChangeJournalDelta::CHANGED), fileName);
 }
 
 void Journal::recordRenamed(
     RelativePathPiece oldName,
     RelativePathPiece newName) {
-  addDelta(FileChangeJournalDelta(
-      oldName, newName, FileChangeJournalDelta::RENAMED));
+  addDelta(
+      FileChangeJournalDelta(FileChangeJournalDelta::RENAMED),
+      oldName,
+      newName);
 }
 
 void Journal::recordReplaced(
     RelativePathPiece oldName,
     RelativePathPiece newName) {
-  addDelta(FileChangeJournalDelta(
-      oldName, newName, FileChangeJournalDelta::REPLACED));
+  addDelta(
+      FileChangeJournalDelta(FileChangeJournalDelta::REPLACED),
+      oldName,
+      newName);
 }
 
 void Journal::recordHashUpdate(RootId toHash) {
@@ -154,7 +228,7 @@ void Journal::recordUncleanPaths(
   addDelta(std::move(delta), std::move(toHash));
 }
 
-void Journal::truncateIfNecessary(DeltaState& deltaState) {
+void Journal::truncateIfNecessary(DeltaState& deltaState) const {
   while (JournalDeltaPtr front = deltaState.frontPtr()) {
     if (estimateMemoryUsage(deltaState) <= deltaState.memoryLimit) {
       break;
@@ -166,10 +240,13 @@ void Journal::truncateIfNecessary(DeltaState& deltaState) {
   }
 }
 
-bool Journal::compact(FileChangeJournalDelta& delta, DeltaState& deltaState) {
+bool Journal::compact(FileChangeJournalDelta& delta, DeltaState& deltaState)
+    const {
   auto back = deltaState.backPtr().getAsFileChangeJournalDelta();
   if (back && delta.isModification() && delta.isSameAction(*back)) {
     deltaState.stats->latestTimestamp = delta.time;
+    // delta holds its own references to the same paths.
+    back->releasePaths(deltaState.paths);
     deltaState.deltaMemoryUsage -= back->estimateMemoryUsage();
     deltaState.deltaMemoryUsage += delta.estimateMemoryUsage();
     *back = std::move(delta);
@@ -180,14 +257,128 @@ bool Journal::compact(FileChangeJournalDelta& delta, DeltaState& deltaState) {
 
 bool Journal::compact(
     RootUpdateJournalDelta& /* unused */,
-    DeltaState& /* unused */) {
+    DeltaState& /* unused */) const {
   return false;
 }
 
+size_t Journal::foldRun(
+    DeltaState& deltaState,
+    std::deque<FileChangeJournalDelta>::iterator begin,
+    std::deque<FileChangeJournalDelta>::iterator end) const {
+  struct NetChange {
+    PathChangeInfo info;
+    SequenceNumber sequenceID;
+    std::chrono::steady_clock::time_point time;
+  };
+  folly::F14FastMap<JournalPathTable::PathId, NetChange> changes;
+  auto addChange = [&](JournalPathTable::PathId path,
+                       PathChangeInfo info,
+                       const FileChangeJournalDelta& delta) {
+    auto [it, inserted] = changes.try_emplace(
+        path, NetChange{info, delta.sequenceID, delta.time});
+    if (!inserted) {
+      it->second.info.existedAfter = info.existedAfter;
+      it->second.sequenceID = delta.sequenceID;
+      it->second.time = delta.time;
+    }
+  };
+  for (auto it = begin; it != end; ++it) {
+    if (it->isPath1Valid) {
+      addChange(it->path1, it->info1, *it);
+    }
+    if (it->isPath2Valid) {
+      addChange(it->path2, it->info2, *it);
+    }
+  }
+
+  auto runLength = static_cast<size_t>(end - begin);
+  if (changes.size() >= runLength) {
+    // Every path only changed once, or renames would be split in two.
+    for (auto it = begin; it != end; ++it) {
+      deltaState.appendDelta(std::move(*it));
+    }
+    return 0;
+  }
+
+  std::vector<std::pair<JournalPathTable::PathId, NetChange>> folded{
+      changes.begin(), changes.end()};
+  std::sort(folded.begin(), folded.end(), [](const auto& a, const auto& b) {
+    return std::tie(a.second.sequenceID, a.first) <
+        std::tie(b.second.sequenceID, b.first);
+  });
+  // The folded deltas take their references before the original deltas drop
+  // theirs, so that the paths stay interned.
+  for (const auto& [path, change] : folded) {
+    FileChangeJournalDelta delta;
+    delta.sequenceID = change.sequenceID;
+    delta.time = change.time;
+    delta.path1 = deltaState.paths.intern(deltaState.paths.getPath(path));
+    delta.info1 = change.info;
+    delta.isPath1Valid = true;
+    deltaState.deltaMemoryUsage += delta.estimateMemoryUsage();
+    deltaState.appendDelta(std::move(delta));
+  }
+  for (auto it = begin; it != end; ++it) {
+    deltaState.deltaMemoryUsage -= it->estimateMemoryUsage();
+    it->releasePaths(deltaState.paths);
+  }
+
+  auto removed = runLength - folded.size();
+  deltaState.stats->entryCount -= removed;
+  return removed;
+}
+
+size_t Journal::compactHistory() {
+  auto deltaState = lockDeltaState();
+  auto horizon = std::exchange(
+      deltaState->compactionHorizon, deltaState->nextSequence);
+  auto& fileChanges = deltaState->fileChangeDeltas;
+  if (fileChanges.empty() || fileChanges.front().sequenceID >= horizon) {
+    return 0;
+  }
+
+  // Folding moves deltas around, so the deque and its top-level index are
+  // rebuilt from scratch.
+  std::deque<FileChangeJournalDelta> oldFileChanges;
+  oldFileChanges.swap(fileChanges);
+  deltaState->fileChangesByTopLevel.clear();
+  deltaState->indexedFileChanges = 0;
+
+  size_t removed = 0;
+  auto hashUpdateIt = deltaState->hashUpdateDeltas.begin();
+  auto hashUpdateEnd = deltaState->hashUpdateDeltas.end();
+  auto it = oldFileChanges.begin();
+  while (it != oldFileChanges.end() && it->sequenceID < horizon) {
+    while (hashUpdateIt != hashUpdateEnd &&
+           hashUpdateIt->sequenceID < it->sequenceID) {
+      ++hashUpdateIt;
+    }
+    // A run ends at the next root update, so that the root updates keep
+    // their place among the file changes.
+    auto runEnd = horizon;
+    if (hashUpdateIt != hashUpdateEnd) {
+      runEnd = std::min(runEnd, hashUpdateIt->sequenceID);
+    }
+    auto runEndIt =
+        std::find_if(it, oldFileChanges.end(), [&](const auto& delta) {
+          return delta.sequenceID >= runEnd;
+        });
+    removed += foldRun(*deltaState, it, runEndIt);
+    it = runEndIt;
+  }
+  for (; it != oldFileChanges.end(); ++it) {
+    deltaState->appendDelta(std::move(*it));
+  }
+
+  if (removed > 0) {
+    deltaState->stats->earliestTimestamp = deltaState->frontPtr()->time;
+  }
+  return removed;
+}
+
 template <typename T>
-bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
+void Journal::addDeltaLocked(T&& delta, DeltaState& deltaState) const {
   delta.sequenceID = deltaState.nextSequence++;
-  delta.time = std::chrono::steady_clock::now();
 
   truncateIfNecessary(deltaState);
 
@@ -216,10 +407,43 @@ bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
   }
 
   deltaState.stats->earliestTimestamp = deltaState.frontPtr()->time;
+}
+
+void Journal::appendPendingDeltas(DeltaState& deltaState, bool markObserved)
+    const {
+  auto& deltas = deltaState.appendBuffer;
+  {
+    auto pending = pendingDeltas_.lock();
+    deltas.swap(pending->fileChangeDeltas);
+    if (markObserved) {
+      // Done while the queue is locked, so that a change queued after this
+      // point either is appended below or notifies subscribers again.
+      pending->lastModificationHasBeenObserved = true;
+    }
+  }
+  for (auto& pendingChange : deltas) {
+    auto& delta = pendingChange.delta;
+    if (delta.isPath1Valid) {
+      delta.path1 = deltaState.paths.intern(pendingChange.path1);
+    }
+    if (delta.isPath2Valid) {
+      delta.path2 = deltaState.paths.intern(pendingChange.path2);
+    }
+    addDeltaLocked(std::move(delta), deltaState);
+  }
+  deltas.clear();
+}
+
+Journal::SynchronizedDeltaState::LockedPtr Journal::lockDeltaState(
+    bool markObserved) const {
+  auto deltaState = deltaState_.lock();
+  appendPendingDeltas(*deltaState, markObserved);
+  return deltaState;
+}
 
-  bool shouldNotify = deltaState.lastModificationHasBeenObserved;
-  deltaState.lastModificationHasBeenObserved = false;
-  return shouldNotify;
+bool Journal::markModified() {
+  return std::exchange(
+      pendingDeltas_.lock()->lastModificationHasBeenObserved, false);
 }
 
 void Journal::notifySubscribers() const {
@@ -229,12 +453,32 @@ void Journal::notifySubscribers() const {
   }
 }
 
-void Journal::addDelta(FileChangeJournalDelta&& delta) {
+void Journal::addDelta(
+    FileChangeJournalDelta&& delta,
+    RelativePathPiece path1,
+    RelativePathPiece path2) {
   bool shouldNotify;
+  size_t pendingCount;
   {
-    auto deltaState = deltaState_.lock();
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
+    auto pending = pendingDeltas_.lock();
+    // Timestamps are taken in queue order so that they stay monotonic with
+    // the sequence numbers assigned when the queue is appended.
+    delta.time = std::chrono::steady_clock::now();
+    pending->fileChangeDeltas.push_back(
+        PendingFileChange{std::move(delta), path1.copy(), path2.copy()});
+    pendingCount = pending->fileChangeDeltas.size();
+    shouldNotify =
+        std::exchange(pending->lastModificationHasBeenObserved, false);
   }
+
+  // If another thread holds deltaState_, it appends the queued changes the
+  // next time it locks it. Only wait for it when the queue grows too long.
+  if (auto deltaState = deltaState_.tryLock()) {
+    appendPendingDeltas(*deltaState, false);
+  } else if (pendingCount >= kMaxPendingFileChanges) {
+    lockDeltaState();
+  }
+
   if (shouldNotify) {
     notifySubscribers();
   }
@@ -243,15 +487,17 @@ void Journal::addDelta(FileChangeJournalDelta&& delta) {
 void Journal::addDelta(RootUpdateJournalDelta&& delta, RootId newRootId) {
   bool shouldNotify;
   {
-    auto deltaState = deltaState_.lock();
+    auto deltaState = lockDeltaState();
 
     // If the hashes were not set to anything, default to copying
     // the value from the prior journal entry
     if (delta.fromHash == RootId{}) {
       delta.fromHash = deltaState->currentHash;
     }
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
+    delta.time = std::chrono::steady_clock::now();
+    addDeltaLocked(std::move(delta), *deltaState);
     deltaState->currentHash = std::move(newRootId);
+    shouldNotify = markModified();
   }
   if (shouldNotify) {
     notifySubscribers();
@@ -259,8 +505,7 @@ void Journal::addDelta(RootUpdateJournalDelta&& delta, RootId newRootId) {
 }
 
 std::optional<JournalDeltaInfo> Journal::getLatest() {
-  auto deltaState = deltaState_.lock();
-  deltaState->lastModificationHasBeenObserved = true;
+  auto deltaState = lockDeltaState(/*markObserved=*/true);
   if (deltaState->empty()) {
     return std::nullopt;
   } else {
@@ -279,6 +524,14 @@ std::optional<JournalDeltaInfo> Journal::getLatest() {
   }
 }
 
+Journal::SequenceNumber Journal::getLatestSequenceNumber() const {
+  // Queued file changes will take the next sequence numbers in order, and
+  // appending them here would make this wait behind other readers.
+  auto deltaState = deltaState_.lock();
+  return deltaState->nextSequence - 1 +
+      pendingDeltas_.lock()->fileChangeDeltas.size();
+}
+
 uint64_t Journal::registerSubscriber(SubscriberCallback&& callback) {
   auto subscriberState = subscriberState_.wlock();
   auto id = subscriberState->nextSubscriberId++;
@@ -316,7 +569,7 @@ bool Journal::isSubscriberValid(uint64_t id) const {
 }
 
 std::optional<JournalStats> Journal::getStats() {
-  return deltaState_.lock()->stats;
+  return lockDeltaState()->stats;
 }
 
 namespace {
@@ -344,7 +597,7 @@ size_t Journal::getMemoryLimit() const {
 }
 
 size_t Journal::estimateMemoryUsage() const {
-  return estimateMemoryUsage(*deltaState_.lock());
+  return estimateMemoryUsage(*lockDeltaState());
 }
 
 template <typename T>
@@ -366,17 +619,18 @@ size_t Journal::estimateMemoryUsage(const DeltaState& deltaState) const {
   if (deltaState.stats) {
     memoryUsage += deltaState.deltaMemoryUsage;
   }
+  memoryUsage += deltaState.paths.estimateMemoryUsage();
+  memoryUsage += deltaState.estimateIndexMemoryUsage();
   return memoryUsage;
 }
 
 void Journal::flush() {
   bool shouldNotify;
   {
-    auto deltaState = deltaState_.lock();
+    auto deltaState = lockDeltaState();
     ++deltaState->nextSequence;
     auto lastHash = deltaState->currentHash;
-    deltaState->fileChangeDeltas.clear();
-    deltaState->hashUpdateDeltas.clear();
+    deltaState->clear();
     deltaState->stats = std::nullopt;
     auto delta = RootUpdateJournalDelta();
     /* Tracking the hash correctly when the journal is flushed is important
@@ -387,7 +641,9 @@ void Journal::flush() {
      * flush operation.
      */
     delta.fromHash = lastHash;
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
+    delta.time = std::chrono::steady_clock::now();
+    addDeltaLocked(std::move(delta), *deltaState);
+    shouldNotify = markModified();
   }
   if (shouldNotify) {
     notifySubscribers();
@@ -396,67 +652,89 @@ void Journal::flush() {
 
 std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
     SequenceNumber from) {
+  return accumulateRange(from, RelativePathPiece{});
+}
+
+std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
+    SequenceNumber from,
+    RelativePathPiece prefix) {
   XDCHECK(from > 0);
   std::unique_ptr<JournalDeltaRange> result = nullptr;
+  auto isUnderPrefix = [&](RelativePathPiece path) {
+    return prefix.empty() || path == prefix || prefix.isParentDirOf(path);
+  };
 
   size_t filesAccumulated = 0;
-  auto deltaState = deltaState_.lock();
+  auto deltaState = lockDeltaState(/*markObserved=*/true);
   // If this is going to be truncated, handle it before iterating.
-  if (!deltaState->empty() && deltaState->getFrontSequenceID() > from) {
+  if (!deltaState->empty() && deltaState->firstRetainedSequence > from) {
     result = std::make_unique<JournalDeltaRange>();
     result->isTruncated = true;
   } else {
-    forEachDelta(
-        *deltaState,
-        from,
-        std::nullopt,
-        [&](const FileChangeJournalDelta& current) -> void {
-          ++filesAccumulated;
-          if (!result) {
-            result = std::make_unique<JournalDeltaRange>();
-            result->toSequence = current.sequenceID;
-            result->toTime = current.time;
-            result->snapshotTransitions.push_back(deltaState->currentHash);
-          }
-          // Capture the lower bound.
-          result->fromSequence = current.sequenceID;
-          result->fromTime = current.time;
-
-          for (auto& entry : current.getChangedFilesInOverlay()) {
-            auto& name = entry.first;
-            auto& currentInfo = entry.second;
-            auto* resultInfo =
-                folly::get_ptr(result->changedFilesInOverlay, name);
-            if (!resultInfo) {
-              result->changedFilesInOverlay.emplace(name, currentInfo);
-            } else {
-              if (resultInfo->existedBefore != currentInfo.existedAfter) {
-                auto event1 = eventCharacterizationFor(currentInfo);
-                auto event2 = eventCharacterizationFor(*resultInfo);
-                XLOG(ERR) << "Journal for " << name << " holds invalid "
-                          << event1 << ", " << event2 << " sequence";
-              }
-
-              resultInfo->existedBefore = currentInfo.existedBefore;
-            }
-          }
-        },
-        [&](const RootUpdateJournalDelta& current) -> void {
-          if (!result) {
-            result = std::make_unique<JournalDeltaRange>();
-            result->toSequence = current.sequenceID;
-            result->toTime = current.time;
-            result->snapshotTransitions.push_back(deltaState->currentHash);
+    auto onFileChange = [&](const FileChangeJournalDelta& current) -> void {
+      ++filesAccumulated;
+      if (!result) {
+        result = std::make_unique<JournalDeltaRange>();
+        result->toSequence = current.sequenceID;
+        result->toTime = current.time;
+        result->snapshotTransitions.push_back(deltaState->currentHash);
+      }
+      // Capture the lower bound.
+      result->fromSequence = current.sequenceID;
+      result->fromTime = current.time;
+
+      auto changedFiles = current.getChangedFilesInOverlay(deltaState->paths);
+      for (auto& entry : changedFiles) {
+        auto& name = entry.first;
+        auto& currentInfo = entry.second;
+        if (!isUnderPrefix(name)) {
+          continue;
+        }
+        auto* resultInfo = folly::get_ptr(result->changedFilesInOverlay, name);
+        if (!resultInfo) {
+          result->changedFilesInOverlay.emplace(name, currentInfo);
+        } else {
+          if (resultInfo->existedBefore != currentInfo.existedAfter) {
+            auto event1 = eventCharacterizationFor(currentInfo);
+            auto event2 = eventCharacterizationFor(*resultInfo);
+            XLOG(ERR) << "Journal for " << name << " holds invalid "
+                      << event1 << ", " << event2 << " sequence";
           }
-          // Capture the lower bound.
-          result->fromSequence = current.sequenceID;
-          result->fromTime = current.time;
-          result->snapshotTransitions.push_back(current.fromHash);
-
-          // Merge the unclean status list
-          result->uncleanPaths.insert(
-              current.uncleanPaths.begin(), current.uncleanPaths.end());
-        });
+
+          resultInfo->existedBefore = currentInfo.existedBefore;
+        }
+      }
+    };
+    auto onRootUpdate = [&](const RootUpdateJournalDelta& current) -> void {
+      if (!result) {
+        result = std::make_unique<JournalDeltaRange>();
+        result->toSequence = current.sequenceID;
+        result->toTime = current.time;
+        result->snapshotTransitions.push_back(deltaState->currentHash);
+      }
+      // Capture the lower bound.
+      result->fromSequence = current.sequenceID;
+      result->fromTime = current.time;
+      result->snapshotTransitions.push_back(current.fromHash);
+
+      // Merge the unclean status list
+      for (auto& path : current.uncleanPaths) {
+        if (isUnderPrefix(path)) {
+          result->uncleanPaths.insert(path);
+        }
+      }
+    };
+
+    if (prefix.empty()) {
+      forEachDelta(*deltaState, from, std::nullopt, onFileChange, onRootUpdate);
+    } else {
+      forEachDeltaUnder(
+          *deltaState,
+          *prefix.paths().begin(),
+          from,
+          onFileChange,
+          onRootUpdate);
+    }
   }
 
   if (result) {
@@ -477,17 +755,235 @@ std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
         result->snapshotTransitions.begin(), result->snapshotTransitions.end());
   }
 
-  deltaState->lastModificationHasBeenObserved = true;
   return result;
 }
 
+namespace {
+// Saved journal file format:
+// 4-byte identifier: "ejnl"
+// 4-byte format version
+// 8-byte mount generation
+// 8-byte next sequence number
+// The current root id
+// 8-byte count and then each file change delta, oldest first
+// 8-byte count and then each root update delta, oldest first
+// 4-byte identifier: "ejnl", to detect truncated files
+//
+// Integers are big-endian and strings are prefixed with their 4-byte length.
+constexpr folly::StringPiece kSavedJournalMagic{"ejnl"};
+constexpr uint32_t kSavedJournalFormatVersion = 1;
+
+void writeString(folly::io::QueueAppender& out, folly::StringPiece str) {
+  XCHECK_LE(str.size(), std::numeric_limits<uint32_t>::max());
+  out.writeBE<uint32_t>(static_cast<uint32_t>(str.size()));
+  out.push(folly::ByteRange{str});
+}
+
+std::string readString(folly::io::Cursor& cursor) {
+  return cursor.readFixedString(cursor.readBE<uint32_t>());
+}
+
+// steady_clock time points mean nothing to another process, so saved
+// deltas carry wall clock times.
+int64_t toSavedTime(std::chrono::steady_clock::time_point time) {
+  auto sinceNow = time - std::chrono::steady_clock::now();
+  auto systemTime = std::chrono::system_clock::now() +
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(sinceNow);
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             systemTime.time_since_epoch())
+      .count();
+}
+
+std::chrono::steady_clock::time_point fromSavedTime(int64_t nanoseconds) {
+  auto systemTime = std::chrono::system_clock::time_point{
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          std::chrono::nanoseconds{nanoseconds})};
+  auto sinceNow = systemTime - std::chrono::system_clock::now();
+  return std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(sinceNow);
+}
+
+enum : uint8_t {
+  kPath1Valid = 1 << 0,
+  kPath2Valid = 1 << 1,
+  kPath1ExistedBefore = 1 << 2,
+  kPath1ExistedAfter = 1 << 3,
+  kPath2ExistedBefore = 1 << 4,
+  kPath2ExistedAfter = 1 << 5,
+};
+} // namespace
+
+void Journal::saveToFile(AbsolutePathPiece path, uint64_t mountGeneration) {
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender out{&queue, 64 * 1024};
+  out.push(folly::ByteRange{kSavedJournalMagic});
+  out.writeBE<uint32_t>(kSavedJournalFormatVersion);
+  out.writeBE<uint64_t>(mountGeneration);
+  {
+    auto deltaState = lockDeltaState();
+    out.writeBE<uint64_t>(deltaState->nextSequence);
+    writeString(out, deltaState->currentHash.value());
+
+    out.writeBE<uint64_t>(deltaState->fileChangeDeltas.size());
+    for (const auto& delta : deltaState->fileChangeDeltas) {
+      out.writeBE<uint64_t>(delta.sequenceID);
+      out.writeBE<int64_t>(toSavedTime(delta.time));
+      uint8_t flags = (delta.isPath1Valid ? kPath1Valid : 0) |
+          (delta.isPath2Valid ? kPath2Valid : 0) |
+          (delta.info1.existedBefore ? kPath1ExistedBefore : 0) |
+          (delta.info1.existedAfter ? kPath1ExistedAfter : 0) |
+          (delta.info2.existedBefore ? kPath2ExistedBefore : 0) |
+          (delta.info2.existedAfter ? kPath2ExistedAfter : 0);
+      out.write<uint8_t>(flags);
+      writeString(out, deltaState->paths.getPath(delta.path1).value());
+      writeString(out, deltaState->paths.getPath(delta.path2).value());
+    }
+
+    out.writeBE<uint64_t>(deltaState->hashUpdateDeltas.size());
+    for (const auto& delta : deltaState->hashUpdateDeltas) {
+      out.writeBE<uint64_t>(delta.sequenceID);
+      out.writeBE<int64_t>(toSavedTime(delta.time));
+      writeString(out, delta.fromHash.value());
+      out.writeBE<uint64_t>(delta.uncleanPaths.size());
+      for (const auto& uncleanPath : delta.uncleanPaths) {
+        writeString(out, uncleanPath.value());
+      }
+    }
+  }
+  out.push(folly::ByteRange{kSavedJournalMagic});
+
+  auto buf = queue.move();
+  buf->coalesce();
+  writeFileAtomic(path, folly::ByteRange{buf->data(), buf->length()}).value();
+}
+
+std::optional<uint64_t> Journal::loadFromFile(
+    AbsolutePathPiece path,
+    const RootId& expectedRoot) {
+  auto contents = readFile(path);
+  if (contents.hasException()) {
+    auto* error = contents.tryGetExceptionObject<std::system_error>();
+    if (!error || error->code() != std::errc::no_such_file_or_directory) {
+      XLOG(WARN) << "unable to read saved journal " << path << ": "
+                 << contents.exception().what();
+    }
+    return std::nullopt;
+  }
+
+  uint64_t mountGeneration;
+  SequenceNumber nextSequence;
+  RootId currentHash;
+  std::vector<PendingFileChange> fileChanges;
+  std::vector<RootUpdateJournalDelta> hashUpdates;
+  try {
+    folly::IOBuf buf{folly::IOBuf::WRAP_BUFFER, folly::ByteRange{*contents}};
+    folly::io::Cursor cursor{&buf};
+    if (cursor.readFixedString(kSavedJournalMagic.size()) !=
+        kSavedJournalMagic) {
+      throw std::runtime_error("not a saved journal");
+    }
+    auto version = cursor.readBE<uint32_t>();
+    if (version != kSavedJournalFormatVersion) {
+      throw std::runtime_error(
+          fmt::format("unsupported format version {}", version));
+    }
+    mountGeneration = cursor.readBE<uint64_t>();
+    nextSequence = cursor.readBE<uint64_t>();
+    currentHash = RootId{readString(cursor)};
+
+    auto fileChangeCount = cursor.readBE<uint64_t>();
+    for (uint64_t i = 0; i < fileChangeCount; ++i) {
+      PendingFileChange change;
+      change.delta.sequenceID = cursor.readBE<uint64_t>();
+      change.delta.time = fromSavedTime(cursor.readBE<int64_t>());
+      auto flags = cursor.read<uint8_t>();
+      change.delta.isPath1Valid = flags & kPath1Valid;
+      change.delta.isPath2Valid = flags & kPath2Valid;
+      change.delta.info1 = PathChangeInfo{
+          bool(flags & kPath1ExistedBefore), bool(flags & kPath1ExistedAfter)};
+      change.delta.info2 = PathChangeInfo{
+          bool(flags & kPath2ExistedBefore), bool(flags & kPath2ExistedAfter)};
+      change.path1 = RelativePath{readString(cursor)};
+      change.path2 = RelativePath{readString(cursor)};
+      fileChanges.push_back(std::move(change));
+    }
+
+    auto hashUpdateCount = cursor.readBE<uint64_t>();
+    for (uint64_t i = 0; i < hashUpdateCount; ++i) {
+      RootUpdateJournalDelta delta;
+      delta.sequenceID = cursor.readBE<uint64_t>();
+      delta.time = fromSavedTime(cursor.readBE<int64_t>());
+      delta.fromHash = RootId{readString(cursor)};
+      auto uncleanPathCount = cursor.readBE<uint64_t>();
+      for (uint64_t j = 0; j < uncleanPathCount; ++j) {
+        delta.uncleanPaths.insert(RelativePath{readString(cursor)});
+      }
+      hashUpdates.push_back(std::move(delta));
+    }
+
+    if (cursor.readFixedString(kSavedJournalMagic.size()) !=
+            kSavedJournalMagic ||
+        !cursor.isAtEnd()) {
+      throw std::runtime_error("unexpected end of saved journal");
+    }
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "ignoring invalid saved journal " << path << ": "
+               << folly::exceptionStr(ex);
+    return std::nullopt;
+  }
+
+  if (currentHash != expectedRoot) {
+    XLOG(INFO) << "ignoring saved journal " << path << " for commit "
+               << currentHash << " while on " << expectedRoot;
+    return std::nullopt;
+  }
+
+  auto deltaState = lockDeltaState();
+  XCHECK(deltaState->empty() && deltaState->nextSequence == 1)
+      << "loadFromFile() called on a journal that was already used";
+
+  // Append both kinds of deltas in sequence order, keeping their sequence
+  // numbers. This recomputes the stats and applies the memory limit.
+  auto fileChangeIt = fileChanges.begin();
+  auto hashUpdateIt = hashUpdates.begin();
+  while (fileChangeIt != fileChanges.end() ||
+         hashUpdateIt != hashUpdates.end()) {
+    bool isFileChange = hashUpdateIt == hashUpdates.end() ||
+        (fileChangeIt != fileChanges.end() &&
+         fileChangeIt->delta.sequenceID < hashUpdateIt->sequenceID);
+    if (isFileChange) {
+      auto& delta = fileChangeIt->delta;
+      deltaState->nextSequence = delta.sequenceID;
+      if (delta.isPath1Valid) {
+        delta.path1 = deltaState->paths.intern(fileChangeIt->path1);
+      }
+      if (delta.isPath2Valid) {
+        delta.path2 = deltaState->paths.intern(fileChangeIt->path2);
+      }
+      addDeltaLocked(std::move(delta), *deltaState);
+      ++fileChangeIt;
+    } else {
+      deltaState->nextSequence = hashUpdateIt->sequenceID;
+      addDeltaLocked(std::move(*hashUpdateIt), *deltaState);
+      ++hashUpdateIt;
+    }
+  }
+  if (!deltaState->empty()) {
+    // The saved journal may have been truncated before its first delta.
+    deltaState->firstRetainedSequence = deltaState->getFrontSequenceID();
+  }
+  deltaState->nextSequence = nextSequence;
+  deltaState->currentHash = std::move(currentHash);
+  return mountGeneration;
+}
+
 std::vector<DebugJournalDelta> Journal::getDebugRawJournalInfo(
     SequenceNumber from,
     std::optional<size_t> limit,
     long mountGeneration,
     RootIdCodec& rootIdCodec) const {
   auto result = std::vector<DebugJournalDelta>();
-  auto deltaState = deltaState_.lock();
+  auto deltaState = lockDeltaState();
   RootId currentHash = deltaState->currentHash;
   forEachDelta(
       *deltaState,
@@ -507,7 +1003,8 @@ std::vector<DebugJournalDelta> Journal::getDebugRawJournalInfo(
         toPosition.snapshotHash_ref() = rootIdCodec.renderRootId(currentHash);
         delta.toPosition_ref() = toPosition;
 
-        for (const auto& entry : current.getChangedFilesInOverlay()) {
+        auto changedFiles = current.getChangedFilesInOverlay(deltaState->paths);
+        for (const auto& entry : changedFiles) {
           auto& path = entry.first;
           auto& changeInfo = entry.second;
 
@@ -584,4 +1081,50 @@ void Journal::forEachDelta(
     ++iters;
   }
 }
+
+/**
+ * FileChangeFunc: void(const FileChangeJournalDelta&)
+ * HashUpdateFunc: void(const RootUpdateJournalDelta&)
+ */
+template <class FileChangeFunc, class HashUpdateFunc>
+void Journal::forEachDeltaUnder(
+    const DeltaState& deltaState,
+    RelativePathPiece topLevel,
+    JournalDelta::SequenceNumber from,
+    FileChangeFunc&& fileChangeDeltaCallback,
+    HashUpdateFunc&& hashUpdateDeltaCallback) const {
+  const std::deque<size_t>* positions = nullptr;
+  if (auto id = deltaState.paths.find(topLevel)) {
+    positions = folly::get_ptr(deltaState.fileChangesByTopLevel, *id);
+  }
+  static const std::deque<size_t> kNoPositions;
+  if (!positions) {
+    positions = &kNoPositions;
+  }
+
+  auto positionIt = positions->rbegin();
+  auto positionRend = positions->rend();
+  auto hashUpdateIt = deltaState.hashUpdateDeltas.rbegin();
+  auto hashUpdateRend = deltaState.hashUpdateDeltas.rend();
+  while (positionIt != positionRend || hashUpdateIt != hashUpdateRend) {
+    const FileChangeJournalDelta* fileChange = positionIt != positionRend
+        ? &deltaState.fileChangeAt(*positionIt)
+        : nullptr;
+    bool isFileChange = fileChange &&
+        (hashUpdateIt == hashUpdateRend ||
+         fileChange->sequenceID > hashUpdateIt->sequenceID);
+    const Journal::SequenceNumber currentSequenceID =
+        isFileChange ? fileChange->sequenceID : hashUpdateIt->sequenceID;
+    if (currentSequenceID < from) {
+      break;
+    }
+    if (isFileChange) {
+      fileChangeDeltaCallback(*fileChange);
+      ++positionIt;
+    } else {
+      hashUpdateDeltaCallback(*hashUpdateIt);
+      ++hashUpdateIt;
+    }
+  }
+}
 } // namespace facebook::eden
@@ -9,16 +9,20 @@
 
 #include <folly/Function.h>
 #include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
 #include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 #include "eden/fs/journal/JournalDelta.h"
 #include "eden/fs/model/RootId.h"
 #include "eden/fs/service/ThriftUtil.h"
 #include "eden/fs/service/gen-cpp2/StreamingEdenService.h"
 #include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/telemetry/InstrumentedMutex.h"
 
 namespace facebook::eden {
 
@@ -113,6 +117,13 @@ class Journal {
    */
   std::optional<JournalDeltaInfo> getLatest();
 
+  /**
+   * Returns the sequence number of the most recent delta, or 0 if nothing was
+   * ever recorded. Unlike getLatest, this does not count as observing the
+   * journal for the purpose of coalescing subscriber notifications.
+   */
+  SequenceNumber getLatestSequenceNumber() const;
+
   /**
    * Returns an accumulation of all deltas with sequence number >= limitSequence
    * merged. If limitSequence is further back than the Journal remembers,
@@ -125,6 +136,19 @@ class Journal {
   std::unique_ptr<JournalDeltaRange> accumulateRange(
       SequenceNumber limitSequence = 1);
 
+  /**
+   * Like accumulateRange, but only reports the changed and unclean paths
+   * that are prefix or below it. An empty prefix reports every path.
+   *
+   * Only the deltas that touch prefix's top-level directory are visited,
+   * so the returned range covers those deltas and the commit transitions
+   * rather than every delta since limitSequence. If none of them are at or
+   * after limitSequence, returns nullptr.
+   */
+  std::unique_ptr<JournalDeltaRange> accumulateRange(
+      SequenceNumber limitSequence,
+      RelativePathPiece prefix);
+
   // Subscription functionality:
 
   /**
@@ -179,16 +203,81 @@ class Journal {
 
   size_t estimateMemoryUsage() const;
 
+  /**
+   * Folds the file changes recorded before the previous call into one delta
+   * per path and run, where a run is the file changes between two root
+   * updates. Each folded delta holds the path's net change over its run and
+   * takes the sequence number and time of the path's last change in it.
+   *
+   * accumulateRange() then still reports every path changed since any
+   * sequence number, but a path that also changed earlier in the same run
+   * reports whether it existed at the start of the run rather than at that
+   * sequence number. Changes recorded since the previous call are left
+   * alone, so that recent history stays exact for clients polling it.
+   *
+   * Meant to be called periodically. Returns the number of deltas removed.
+   */
+  size_t compactHistory();
+
+  // Persistence:
+
+  /**
+   * Writes the journal's deltas and position to path, atomically replacing
+   * it, so that a later Journal for the same checkout can continue from
+   * them with loadFromFile(). The sequence numbers of deltas recorded after
+   * this call would be reused, so it should only be called once nothing
+   * else can be recorded.
+   *
+   * Throws if the file could not be written.
+   */
+  void saveToFile(AbsolutePathPiece path, uint64_t mountGeneration);
+
+  /**
+   * Replaces the contents of this journal, which must be empty, with the
+   * ones saved to path by saveToFile().
+   *
+   * Nothing is loaded if the file does not exist, cannot be parsed, or was
+   * saved while on a commit other than expectedRoot. Returns the
+   * mountGeneration passed to saveToFile() if the journal was loaded.
+   */
+  std::optional<uint64_t> loadFromFile(
+      AbsolutePathPiece path,
+      const RootId& expectedRoot);
+
  private:
   /** Add a delta to the journal and notify subscribers.
    * The delta will have a new sequence number and timestamp
    * applied.
+   *
+   * File changes are queued in pendingDeltas_ and only appended to
+   * deltaState_ by whoever holds its lock next, so that recording a change
+   * does not wait behind readers such as accumulateRange.
    */
-  void addDelta(FileChangeJournalDelta&& delta);
+  void addDelta(
+      FileChangeJournalDelta&& delta,
+      RelativePathPiece path1,
+      RelativePathPiece path2 = RelativePathPiece{});
   void addDelta(RootUpdateJournalDelta&& delta, RootId newRootId);
 
   static constexpr size_t kDefaultJournalMemoryLimit = 1000000000;
 
+  /**
+   * Once this many file changes are queued, the thread recording a change
+   * waits for deltaState_ and appends them itself rather than leaving them to
+   * the current lock holder.
+   */
+  static constexpr size_t kMaxPendingFileChanges = 1024;
+
+  /**
+   * A file change waiting in pendingDeltas_. Its paths are interned when it
+   * is appended to DeltaState.
+   */
+  struct PendingFileChange {
+    FileChangeJournalDelta delta;
+    RelativePath path1;
+    RelativePath path2;
+  };
+
   struct DeltaState {
     /**
      * The sequence number that we'll use for the next entry that we link into
@@ -201,16 +290,41 @@ class Journal {
      */
     std::deque<FileChangeJournalDelta> fileChangeDeltas;
     std::deque<RootUpdateJournalDelta> hashUpdateDeltas;
+    /** The paths of the deltas in fileChangeDeltas. */
+    JournalPathTable paths;
+    /**
+     * For each top-level directory or file, the positions of the deltas in
+     * fileChangeDeltas that touch it, oldest first. A position counts every
+     * delta ever appended, see fileChangeAt().
+     */
+    folly::F14FastMap<JournalPathTable::PathId, std::deque<size_t>>
+        fileChangesByTopLevel;
+    /** The total size of the deques in fileChangesByTopLevel. */
+    size_t indexedFileChanges = 0;
+    /** The number of deltas removed from the front of fileChangeDeltas. */
+    size_t poppedFileChanges = 0;
+    /**
+     * The file changes before this sequence number are folded by the next
+     * compactHistory().
+     */
+    SequenceNumber compactionHorizon{1};
+    /**
+     * The sequence number of the oldest delta that truncation and flush()
+     * kept. Folded deltas take the sequence number of their path's last
+     * change, so the front delta can be more recent than this.
+     */
+    SequenceNumber firstRetainedSequence{1};
     RootId currentHash;
     /// The stats about this Journal up to the latest delta.
     std::optional<JournalStats> stats;
     size_t memoryLimit = kDefaultJournalMemoryLimit;
     size_t deltaMemoryUsage = 0;
 
-    // Set to false when a delta is added.
-    // Set to true when getLatest() or accumulateRange() are called.
-    // If true before calling addDelta, subscribers are notified.
-    bool lastModificationHasBeenObserved = true;
+    /**
+     * Swapped with PendingDeltas::fileChangeDeltas when appending the queued
+     * file changes, so that neither vector has to be reallocated.
+     */
+    std::vector<PendingFileChange> appendBuffer;
 
     JournalDeltaPtr frontPtr() noexcept;
     void popFront();
@@ -226,6 +340,15 @@ class Journal {
     void appendDelta(FileChangeJournalDelta&& delta);
     void appendDelta(RootUpdateJournalDelta&& delta);
 
+    /** Removes every delta and resets the path table and its index. */
+    void clear();
+
+    const FileChangeJournalDelta& fileChangeAt(size_t position) const {
+      return fileChangeDeltas[position - poppedFileChanges];
+    }
+
+    size_t estimateIndexMemoryUsage() const;
+
     JournalDelta::SequenceNumber getFrontSequenceID() const {
       if (isFileChangeInFront()) {
         return fileChangeDeltas.front().sequenceID;
@@ -233,21 +356,90 @@ class Journal {
         return hashUpdateDeltas.front().sequenceID;
       }
     }
+
+   private:
+    void popFrontFileChange();
+
+    /**
+     * Calls func with the top-level id of each of delta's paths, once per
+     * distinct id.
+     */
+    template <typename Func>
+    void forEachTopLevel(const FileChangeJournalDelta& delta, Func&& func)
+        const;
+  };
+  struct DeltaStateLockName {
+    static const char* name() {
+      return "journal_delta_state";
+    }
+  };
+  using SynchronizedDeltaState = folly::Synchronized<
+      DeltaState,
+      InstrumentedMutex<std::mutex, DeltaStateLockName>>;
+  mutable SynchronizedDeltaState deltaState_;
+
+  struct PendingDeltas {
+    /**
+     * File changes that were recorded but not yet appended to DeltaState,
+     * oldest first. Their timestamps are assigned when they are queued and
+     * their sequence numbers when they are appended.
+     */
+    std::vector<PendingFileChange> fileChangeDeltas;
+
+    // Set to false when a delta is added.
+    // Set to true when getLatest() or accumulateRange() are called.
+    // If true before calling addDelta, subscribers are notified.
+    bool lastModificationHasBeenObserved = true;
   };
-  folly::Synchronized<DeltaState, std::mutex> deltaState_;
+  /**
+   * When both locks are needed, deltaState_ must be acquired first.
+   */
+  mutable folly::Synchronized<PendingDeltas, std::mutex> pendingDeltas_;
+
+  /**
+   * Locks deltaState_ and appends the queued file changes to it, so that the
+   * caller sees every delta recorded before this call.
+   *
+   * Pass markObserved when the caller reports the tip of the journal, so that
+   * the next recorded change notifies subscribers again.
+   */
+  SynchronizedDeltaState::LockedPtr lockDeltaState(
+      bool markObserved = false) const;
+
+  /**
+   * Appends the queued file changes to deltaState, whose lock must be held.
+   */
+  void appendPendingDeltas(DeltaState& deltaState, bool markObserved) const;
+
+  /**
+   * Records that the journal was modified, returning true if subscribers
+   * should be notified.
+   */
+  bool markModified();
 
   /**
    * Removes the oldest deltas until the memory usage of the journal is below
    * the journal's memory limit.
    */
-  void truncateIfNecessary(DeltaState& deltaState);
+  void truncateIfNecessary(DeltaState& deltaState) const;
 
   /**
    * Tries to compact a new Journal Delta with an old one if possible,
    * returning true if it did compact it and false if not
    */
-  bool compact(FileChangeJournalDelta& delta, DeltaState& deltaState);
-  bool compact(RootUpdateJournalDelta& delta, DeltaState& deltaState);
+  bool compact(FileChangeJournalDelta& delta, DeltaState& deltaState) const;
+  bool compact(RootUpdateJournalDelta& delta, DeltaState& deltaState) const;
+
+  /**
+   * Replaces the file changes in [begin, end), which hold no root update
+   * between them, with one delta per path. They are appended to
+   * deltaState.fileChangeDeltas, as are the original deltas if folding would
+   * not remove any. Returns the number of deltas removed.
+   */
+  size_t foldRun(
+      DeltaState& deltaState,
+      std::deque<FileChangeJournalDelta>::iterator begin,
+      std::deque<FileChangeJournalDelta>::iterator end) const;
 
   struct SubscriberState {
     SubscriberId nextSubscriberId{1};
@@ -256,14 +448,12 @@ class Journal {
 
   /**
    * Add a delta to the journal without notifying subscribers.
-   * The delta will have a new sequence number and timestamp
-   * applied. A lock to the deltaState must be held and passed to this
+   * The delta will have a new sequence number applied, and must already have
+   * its timestamp. A lock to the deltaState must be held and passed to this
    * function.
-   *
-   * Returns true if subscribers should be notified.
    */
   template <typename T>
-  [[nodiscard]] bool addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState);
+  void addDeltaLocked(T&& delta, DeltaState& deltaState) const;
 
   /**
    * Notify subscribers that a change has happened. Must not be called while
@@ -286,6 +476,19 @@ class Journal {
       FileChangeFunc&& fileChangeDeltaCallback,
       HashUpdateFunc&& hashUpdateDeltaCallback) const;
 
+  /**
+   * Like forEachDelta without a length limit, but only visits the file
+   * changes that touch topLevel, using DeltaState::fileChangesByTopLevel.
+   * Every root update is visited.
+   */
+  template <class FileChangeFunc, class HashUpdateFunc>
+  void forEachDeltaUnder(
+      const DeltaState& deltaState,
+      RelativePathPiece topLevel,
+      JournalDelta::SequenceNumber from,
+      FileChangeFunc&& fileChangeDeltaCallback,
+      HashUpdateFunc&& hashUpdateDeltaCallback) const;
+
   folly::Synchronized<SubscriberState> subscriberState_;
 
   std::shared_ptr<EdenStats> edenStats_;
@@ -11,64 +11,30 @@
 namespace facebook {
 namespace eden {
 
-FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece fileName,
-    FileChangeJournalDelta::Created)
-    : path1{fileName.copy()},
-      info1{PathChangeInfo{false, true}},
-      isPath1Valid{true} {}
+FileChangeJournalDelta::FileChangeJournalDelta(FileChangeJournalDelta::Created)
+    : info1{PathChangeInfo{false, true}}, isPath1Valid{true} {}
 
-FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece fileName,
-    FileChangeJournalDelta::Removed)
-    : path1{fileName.copy()},
-      info1{PathChangeInfo{true, false}},
-      isPath1Valid{true} {}
+FileChangeJournalDelta::FileChangeJournalDelta(FileChangeJournalDelta::Removed)
+    : info1{PathChangeInfo{true, false}}, isPath1Valid{true} {}
 
-FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece fileName,
-    FileChangeJournalDelta::Changed)
-    : path1{fileName.copy()},
-      info1{PathChangeInfo{true, true}},
-      isPath1Valid{true} {}
+FileChangeJournalDelta::FileChangeJournalDelta(FileChangeJournalDelta::Changed)
+    : info1{PathChangeInfo{true, true}}, isPath1Valid{true} {}
 
-FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece oldName,
-    RelativePathPiece newName,
-    FileChangeJournalDelta::Renamed)
-    : path1{oldName.copy()},
-      path2{newName.copy()},
-      info1{PathChangeInfo{true, false}},
+FileChangeJournalDelta::FileChangeJournalDelta(FileChangeJournalDelta::Renamed)
+    : info1{PathChangeInfo{true, false}},
       info2{PathChangeInfo{false, true}},
       isPath1Valid{true},
       isPath2Valid{true} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece oldName,
-    RelativePathPiece newName,
     FileChangeJournalDelta::Replaced)
-    : path1{oldName.copy()},
-      path2{newName.copy()},
-      info1{PathChangeInfo{true, false}},
+    : info1{PathChangeInfo{true, false}},
       info2{PathChangeInfo{true, true}},
       isPath1Valid{true},
       isPath2Valid{true} {}
 
 size_t FileChangeJournalDelta::estimateMemoryUsage() const {
-  size_t mem = sizeof(FileChangeJournalDelta);
-
-  /* NOTE: The following code assumes an unordered_set is separated into an
-   * array of buckets, each one being a chain of nodes containing a next
-   * pointer, a key-value pair, and a stored hash
-   */
-  if (isPath1Valid) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path1);
-  }
-  if (isPath2Valid) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path2);
-  }
-
-  return mem;
+  return sizeof(FileChangeJournalDelta);
 }
 
 size_t RootUpdateJournalDelta::estimateMemoryUsage() const {
@@ -99,17 +65,27 @@ size_t RootUpdateJournalDelta::estimateMemoryUsage() const {
 }
 
 std::unordered_map<RelativePath, PathChangeInfo>
-FileChangeJournalDelta::getChangedFilesInOverlay() const {
+FileChangeJournalDelta::getChangedFilesInOverlay(
+    const JournalPathTable& paths) const {
   std::unordered_map<RelativePath, PathChangeInfo> changedFilesInOverlay;
   if (isPath1Valid) {
-    changedFilesInOverlay[path1] = info1;
+    changedFilesInOverlay[paths.getPath(path1)] = info1;
   }
   if (isPath2Valid) {
-    changedFilesInOverlay[path2] = info2;
+    changedFilesInOverlay[paths.getPath(path2)] = info2;
   }
   return changedFilesInOverlay;
 }
 
+void FileChangeJournalDelta::releasePaths(JournalPathTable& paths) const {
+  if (isPath1Valid) {
+    paths.release(path1);
+  }
+  if (isPath2Valid) {
+    paths.release(path2);
+  }
+}
+
 bool FileChangeJournalDelta::isModification() const {
   return isPath1Valid && !isPath2Valid && info1.existedBefore &&
       info1.existedAfter;
@@ -11,6 +11,7 @@
 #include <type_traits>
 #include <unordered_set>
 #include <variant>
+#include "eden/fs/journal/JournalPathTable.h"
 #include "eden/fs/model/RootId.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -61,7 +62,12 @@ class JournalDelta {
   std::chrono::steady_clock::time_point time;
 };
 
-/** A delta that stores information about changed files */
+/**
+ * A delta that stores information about changed files.
+ *
+ * The paths are stored as ids into the Journal's JournalPathTable, which the
+ * Journal assigns when it appends the delta.
+ */
 class FileChangeJournalDelta : public JournalDelta {
  public:
   enum Created { CREATED };
@@ -75,37 +81,35 @@ class FileChangeJournalDelta : public JournalDelta {
   FileChangeJournalDelta& operator=(FileChangeJournalDelta&&) = default;
   FileChangeJournalDelta(const FileChangeJournalDelta&) = delete;
   FileChangeJournalDelta& operator=(const FileChangeJournalDelta&) = delete;
-  FileChangeJournalDelta(RelativePathPiece fileName, Created);
-  FileChangeJournalDelta(RelativePathPiece fileName, Removed);
-  FileChangeJournalDelta(RelativePathPiece fileName, Changed);
+  explicit FileChangeJournalDelta(Created);
+  explicit FileChangeJournalDelta(Removed);
+  explicit FileChangeJournalDelta(Changed);
 
   /**
-   * "Renamed" means that that newName was created as a result of the mv(1).
+   * "Renamed" means that that path2 was created as a result of the mv(1) of
+   * path1.
    */
-  FileChangeJournalDelta(
-      RelativePathPiece oldName,
-      RelativePathPiece newName,
-      Renamed);
+  explicit FileChangeJournalDelta(Renamed);
 
   /**
-   * "Replaced" means that that newName was overwritten by oldName as a result
+   * "Replaced" means that that path2 was overwritten by path1 as a result
    * of the mv(1).
    */
-  FileChangeJournalDelta(
-      RelativePathPiece oldName,
-      RelativePathPiece newName,
-      Replaced);
+  explicit FileChangeJournalDelta(Replaced);
 
   /** Which of these paths actually contain information */
-  RelativePath path1;
-  RelativePath path2;
+  JournalPathTable::PathId path1 = JournalPathTable::kRootId;
+  JournalPathTable::PathId path2 = JournalPathTable::kRootId;
   PathChangeInfo info1;
   PathChangeInfo info2;
   bool isPath1Valid = false;
   bool isPath2Valid = false;
 
-  std::unordered_map<RelativePath, PathChangeInfo> getChangedFilesInOverlay()
-      const;
+  std::unordered_map<RelativePath, PathChangeInfo> getChangedFilesInOverlay(
+      const JournalPathTable& paths) const;
+
+  /** Drops this delta's references to its paths in paths */
+  void releasePaths(JournalPathTable& paths) const;
 
   /** Checks whether this delta is a modification */
   bool isModification() const;
@@ -114,7 +118,10 @@ class FileChangeJournalDelta : public JournalDelta {
    * sequenceID [whether they do the same action] */
   bool isSameAction(const FileChangeJournalDelta& other) const;
 
-  /** Get memory used (in bytes) by this Delta */
+  /**
+   * Get memory used (in bytes) by this Delta, not counting the interned
+   * paths.
+   */
   size_t estimateMemoryUsage() const;
 };
 
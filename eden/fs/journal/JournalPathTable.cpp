@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalPathTable.h"
+
+#include <folly/hash/Hash.h>
+#include <folly/logging/xlog.h>
+#include "eden/fs/utils/Memory.h"
+
+namespace facebook::eden {
+
+size_t JournalPathTable::KeyHash::operator()(const Key& key) const {
+  return folly::hash::hash_combine(key.parent, folly::StringPiece{key.name});
+}
+
+size_t JournalPathTable::KeyHash::operator()(const KeyPiece& key) const {
+  return folly::hash::hash_combine(key.parent, key.name);
+}
+
+JournalPathTable::JournalPathTable() {
+  nodes_.push_back(Node{nullptr, 0});
+}
+
+JournalPathTable::PathId JournalPathTable::intern(RelativePathPiece path) {
+  PathId id = kRootId;
+  for (auto component : path.components()) {
+    auto name = component.stringPiece();
+    auto it = ids_.find(KeyPiece{id, name});
+    if (it == ids_.end()) {
+      PathId newId;
+      if (freeIds_.empty()) {
+        newId = static_cast<PathId>(nodes_.size());
+        nodes_.push_back(Node{nullptr, 0});
+      } else {
+        newId = freeIds_.back();
+        freeIds_.pop_back();
+      }
+      it = ids_.emplace(Key{id, name.str()}, newId).first;
+      nameMemoryUsage_ += estimateIndirectMemoryUsage(it->first.name);
+      nodes_[newId] = Node{&it->first, 0};
+      if (id != kRootId) {
+        ++nodes_[id].refCount;
+      }
+    }
+    id = it->second;
+  }
+  if (id != kRootId) {
+    ++nodes_[id].refCount;
+  }
+  return id;
+}
+
+void JournalPathTable::release(PathId id) {
+  while (id != kRootId) {
+    auto& node = nodes_[id];
+    XDCHECK_GT(node.refCount, 0u);
+    if (--node.refCount > 0) {
+      return;
+    }
+
+    // The last reference to this component is gone, which drops the
+    // reference it held on its parent.
+    auto parent = node.key->parent;
+    nameMemoryUsage_ -= estimateIndirectMemoryUsage(node.key->name);
+    auto it = ids_.find(KeyPiece{parent, node.key->name});
+    XDCHECK(it != ids_.end());
+    node.key = nullptr;
+    ids_.erase(it);
+    freeIds_.push_back(id);
+    id = parent;
+  }
+}
+
+RelativePath JournalPathTable::getPath(PathId id) const {
+  std::vector<folly::StringPiece> names;
+  size_t length = 0;
+  for (; id != kRootId; id = nodes_[id].key->parent) {
+    names.push_back(nodes_[id].key->name);
+    length += names.back().size() + 1;
+  }
+
+  std::string path;
+  path.reserve(length);
+  for (auto it = names.rbegin(); it != names.rend(); ++it) {
+    if (!path.empty()) {
+      path.push_back('/');
+    }
+    path.append(it->data(), it->size());
+  }
+  return RelativePath{std::move(path)};
+}
+
+std::optional<JournalPathTable::PathId> JournalPathTable::find(
+    RelativePathPiece path) const {
+  PathId id = kRootId;
+  for (auto component : path.components()) {
+    auto it = ids_.find(KeyPiece{id, component.stringPiece()});
+    if (it == ids_.end()) {
+      return std::nullopt;
+    }
+    id = it->second;
+  }
+  return id;
+}
+
+JournalPathTable::PathId JournalPathTable::getTopLevel(PathId id) const {
+  while (id != kRootId) {
+    auto parent = nodes_[id].key->parent;
+    if (parent == kRootId) {
+      break;
+    }
+    id = parent;
+  }
+  return id;
+}
+
+size_t JournalPathTable::estimateMemoryUsage() const {
+  return ids_.getAllocatedMemorySize() + nameMemoryUsage_ +
+      folly::goodMallocSize(nodes_.capacity() * sizeof(Node)) +
+      folly::goodMallocSize(freeIds_.capacity() * sizeof(PathId));
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/container/F14Map.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * Interns the paths recorded by the Journal as a tree of path components, so
+ * that a delta only stores a small id per path and paths in the same
+ * directory share that directory's components.
+ *
+ * Ids are reference counted: intern() adds a reference to the path it
+ * returns and release() drops one. A component is freed, and its id reused,
+ * once no delta refers to it or to a path below it.
+ *
+ * This class is not thread safe. The Journal only accesses it while holding
+ * its delta lock.
+ */
+class JournalPathTable {
+ public:
+  using PathId = uint32_t;
+
+  /**
+   * The id of the empty path. It is never freed, and deltas use it for paths
+   * they do not have.
+   */
+  static constexpr PathId kRootId = 0;
+
+  JournalPathTable();
+
+  JournalPathTable(JournalPathTable&&) = default;
+  JournalPathTable& operator=(JournalPathTable&&) = default;
+  JournalPathTable(const JournalPathTable&) = delete;
+  JournalPathTable& operator=(const JournalPathTable&) = delete;
+
+  /**
+   * Returns the id of path, adding it to the table if needed, and adds a
+   * reference to it.
+   */
+  PathId intern(RelativePathPiece path);
+
+  /**
+   * Drops a reference added by intern().
+   */
+  void release(PathId id);
+
+  RelativePath getPath(PathId id) const;
+
+  /**
+   * Returns the id of path if it is interned, without adding a reference.
+   */
+  std::optional<PathId> find(RelativePathPiece path) const;
+
+  /**
+   * Returns the id of the top-level directory or file that id is under, or id
+   * itself if it is top-level.
+   */
+  PathId getTopLevel(PathId id) const;
+
+  /**
+   * The number of distinct path components currently interned.
+   */
+  size_t size() const {
+    return ids_.size();
+  }
+
+  size_t estimateMemoryUsage() const;
+
+ private:
+  struct Key {
+    PathId parent;
+    std::string name;
+  };
+
+  struct KeyPiece {
+    PathId parent;
+    folly::StringPiece name;
+  };
+
+  struct KeyHash {
+    using is_transparent = void;
+    size_t operator()(const Key& key) const;
+    size_t operator()(const KeyPiece& key) const;
+  };
+
+  struct KeyEqual {
+    using is_transparent = void;
+    template <typename A, typename B>
+    bool operator()(const A& a, const B& b) const {
+      return a.parent == b.parent &&
+          folly::StringPiece{a.name} == folly::StringPiece{b.name};
+    }
+  };
+
+  struct Node {
+    /** Points into ids_, whose nodes have stable addresses. */
+    const Key* key;
+    /** The number of references from deltas plus the number of children. */
+    uint32_t refCount;
+  };
+
+  folly::F14NodeMap<Key, PathId, KeyHash, KeyEqual> ids_;
+  /** Indexed by PathId. Entry kRootId is unused. */
+  std::vector<Node> nodes_;
+  std::vector<PathId> freeIds_;
+  /** Heap memory used by the component names that are not stored inline. */
+  size_t nameMemoryUsage_ = 0;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalPathTable.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+TEST(JournalPathTableTest, paths_round_trip) {
+  JournalPathTable paths;
+  auto id = paths.intern("foo/bar/baz.txt"_relpath);
+  EXPECT_NE(JournalPathTable::kRootId, id);
+  EXPECT_EQ("foo/bar/baz.txt"_relpath, paths.getPath(id));
+  EXPECT_EQ(RelativePath{}, paths.getPath(JournalPathTable::kRootId));
+}
+
+TEST(JournalPathTableTest, paths_share_components) {
+  JournalPathTable paths;
+  auto a = paths.intern("foo/bar/a.txt"_relpath);
+  auto b = paths.intern("foo/bar/b.txt"_relpath);
+  EXPECT_NE(a, b);
+  // foo, foo/bar, and one leaf per file.
+  EXPECT_EQ(4, paths.size());
+
+  EXPECT_EQ(a, paths.intern("foo/bar/a.txt"_relpath));
+  EXPECT_EQ(4, paths.size());
+}
+
+TEST(JournalPathTableTest, released_paths_are_freed) {
+  JournalPathTable paths;
+  auto a = paths.intern("foo/bar/a.txt"_relpath);
+  auto b = paths.intern("foo/b.txt"_relpath);
+  paths.intern("foo/bar/a.txt"_relpath);
+  EXPECT_EQ(4, paths.size());
+
+  // a is still referenced once.
+  paths.release(a);
+  EXPECT_EQ(4, paths.size());
+  EXPECT_EQ("foo/bar/a.txt"_relpath, paths.getPath(a));
+
+  // Releasing the last reference also frees foo/bar, which has no other
+  // children, but not foo.
+  paths.release(a);
+  EXPECT_EQ(2, paths.size());
+  EXPECT_EQ("foo/b.txt"_relpath, paths.getPath(b));
+
+  paths.release(b);
+  EXPECT_EQ(0, paths.size());
+
+  // Freed ids are reused rather than growing the table. Four ids were
+  // handed out above.
+  auto c = paths.intern("c.txt"_relpath);
+  EXPECT_LE(c, 4u);
+  EXPECT_EQ("c.txt"_relpath, paths.getPath(c));
+}
+
+TEST(JournalPathTableTest, memory_usage_tracks_interned_paths) {
+  JournalPathTable paths;
+  auto emptyUsage = paths.estimateMemoryUsage();
+  auto id = paths.intern(
+      "a_directory_name_that_is_not_inline/another_long_file_name.txt"_relpath);
+  auto usage = paths.estimateMemoryUsage();
+  EXPECT_GT(usage, emptyUsage);
+
+  // Interning the same path again shares the existing components.
+  paths.intern(
+      "a_directory_name_that_is_not_inline/another_long_file_name.txt"_relpath);
+  EXPECT_EQ(usage, paths.estimateMemoryUsage());
+
+  paths.release(id);
+  paths.release(id);
+  EXPECT_LT(paths.estimateMemoryUsage(), usage);
+}
@@ -7,8 +7,13 @@
 
 #include "eden/fs/journal/Journal.h"
 
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
+#include <thread>
+#include <vector>
 
 #include "eden/fs/model/RootId.h"
 
@@ -551,6 +556,79 @@ TEST_F(JournalTest, compaction) {
   EXPECT_EQ(1, summed->changedFilesInOverlay.size());
 }
 
+TEST_F(JournalTest, history_compaction_folds_each_path_into_one_delta) {
+  journal.recordCreated("a.txt"_relpath);
+  journal.recordChanged("b.txt"_relpath);
+  journal.recordRemoved("a.txt"_relpath);
+  journal.recordChanged("b.txt"_relpath);
+  journal.recordCreated("a.txt"_relpath);
+  journal.recordChanged("b.txt"_relpath);
+  // Only the changes recorded before the previous call are folded.
+  EXPECT_EQ(0, journal.compactHistory());
+  journal.recordChanged("c.txt"_relpath);
+  EXPECT_EQ(4, journal.compactHistory());
+  EXPECT_EQ(3, journal.getStats()->entryCount);
+  EXPECT_EQ(7, journal.getLatest()->sequenceID);
+
+  auto range = journal.accumulateRange(1);
+  ASSERT_TRUE(range);
+  EXPECT_FALSE(range->isTruncated);
+  EXPECT_EQ(5, range->fromSequence);
+  EXPECT_EQ(7, range->toSequence);
+  EXPECT_THAT(
+      range->changedFilesInOverlay,
+      ::testing::UnorderedElementsAre(
+          ::testing::Pair(RelativePath{"a.txt"}, PathChangeInfo{false, true}),
+          ::testing::Pair(RelativePath{"b.txt"}, PathChangeInfo{true, true}),
+          ::testing::Pair(RelativePath{"c.txt"}, PathChangeInfo{true, true})));
+
+  // a.txt last changed before sequence number 6.
+  range = journal.accumulateRange(6);
+  ASSERT_TRUE(range);
+  EXPECT_FALSE(range->isTruncated);
+  EXPECT_THAT(
+      range->changedFilesInOverlay,
+      ::testing::UnorderedElementsAre(
+          ::testing::Pair(RelativePath{"b.txt"}, PathChangeInfo{true, true}),
+          ::testing::Pair(RelativePath{"c.txt"}, PathChangeInfo{true, true})));
+}
+
+TEST_F(JournalTest, history_compaction_keeps_root_updates_in_place) {
+  RootId hash1{"0000000000000000000000000000000000000001"};
+  RootId hash2{"0000000000000000000000000000000000000002"};
+  journal.recordChanged("proj1/a.txt"_relpath);
+  journal.recordChanged("proj2/b.txt"_relpath);
+  journal.recordChanged("proj1/a.txt"_relpath);
+  journal.recordHashUpdate(hash1, hash2);
+  journal.recordChanged("proj1/a.txt"_relpath);
+  journal.recordChanged("proj2/b.txt"_relpath);
+  journal.recordChanged("proj1/a.txt"_relpath);
+  journal.compactHistory();
+  EXPECT_EQ(2, journal.compactHistory());
+  EXPECT_EQ(5, journal.getStats()->entryCount);
+
+  auto range = journal.accumulateRange(5);
+  ASSERT_TRUE(range);
+  EXPECT_FALSE(range->isTruncated);
+  EXPECT_EQ(6, range->fromSequence);
+  EXPECT_EQ((std::vector<RootId>{hash2}), range->snapshotTransitions);
+  EXPECT_EQ(2, range->changedFilesInOverlay.size());
+
+  range = journal.accumulateRange(2);
+  ASSERT_TRUE(range);
+  EXPECT_EQ(2, range->fromSequence);
+  EXPECT_EQ((std::vector<RootId>{hash1, hash2}), range->snapshotTransitions);
+
+  range = journal.accumulateRange(1, "proj1"_relpath);
+  ASSERT_TRUE(range);
+  EXPECT_FALSE(range->isTruncated);
+  EXPECT_EQ(3, range->fromSequence);
+  EXPECT_THAT(
+      range->changedFilesInOverlay,
+      ::testing::UnorderedElementsAre(::testing::Pair(
+          RelativePath{"proj1/a.txt"}, PathChangeInfo{true, true})));
+}
+
 TEST_F(JournalTest, update_transitions_are_all_recorded) {
   RootId hash1{"0000000000000000000000000000000000000001"};
   RootId hash2{"0000000000000000000000000000000000000002"};
@@ -657,3 +735,192 @@ TEST_F(JournalTest, all_subscribers_are_notified_after_any_observation) {
   EXPECT_EQ(2u, calls1);
   EXPECT_EQ(2u, calls2);
 }
+
+TEST_F(JournalTest, concurrently_recorded_changes_are_all_sequenced) {
+  unsigned calls = 0;
+  auto sub = journal.registerSubscriber([&] { ++calls; });
+  (void)sub;
+
+  constexpr size_t kThreads = 4;
+  constexpr size_t kChangesPerThread = 1000;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&, i] {
+      auto name = RelativePath{folly::to<std::string>("file", i)};
+      for (size_t j = 0; j < kChangesPerThread; ++j) {
+        // Alternate actions so that consecutive changes are not compacted.
+        if (j % 2 == 0) {
+          journal.recordCreated(name);
+        } else {
+          journal.recordRemoved(name);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Nothing observed the journal, so subscribers were notified only once.
+  EXPECT_EQ(1u, calls);
+  EXPECT_EQ(kThreads * kChangesPerThread, journal.getLatestSequenceNumber());
+  EXPECT_EQ(kThreads * kChangesPerThread, journal.getLatest()->sequenceID);
+
+  auto range = journal.accumulateRange();
+  ASSERT_TRUE(range);
+  EXPECT_FALSE(range->isTruncated);
+  EXPECT_EQ(1, range->fromSequence);
+  EXPECT_EQ(kThreads * kChangesPerThread, range->toSequence);
+  EXPECT_EQ(kThreads, range->changedFilesInOverlay.size());
+
+  journal.recordChanged("file0"_relpath);
+  EXPECT_EQ(2u, calls);
+}
+
+TEST_F(JournalTest, accumulate_range_by_prefix) {
+  journal.recordCreated("proj1/src/a.cpp"_relpath);
+  journal.recordCreated("proj2/b.cpp"_relpath);
+  journal.recordChanged("proj1/include/a.h"_relpath);
+  journal.recordRenamed("proj2/b.cpp"_relpath, "proj1/src/b.cpp"_relpath);
+  journal.recordUncleanPaths(
+      RootId{"old"},
+      RootId{"new"},
+      {RelativePath{"proj1/src/c.cpp"}, RelativePath{"proj2/d.cpp"}});
+  journal.recordChanged("proj2/e.cpp"_relpath);
+
+  auto range = journal.accumulateRange(1, "proj1/src"_relpath);
+  ASSERT_TRUE(range);
+  EXPECT_FALSE(range->isTruncated);
+  EXPECT_EQ(1, range->fromSequence);
+  // The change to proj2/e.cpp is not visited.
+  EXPECT_EQ(5, range->toSequence);
+  EXPECT_THAT(
+      range->changedFilesInOverlay,
+      ::testing::UnorderedElementsAre(
+          ::testing::Pair(
+              RelativePath{"proj1/src/a.cpp"}, PathChangeInfo{false, true}),
+          ::testing::Pair(
+              RelativePath{"proj1/src/b.cpp"}, PathChangeInfo{false, true})));
+  EXPECT_THAT(
+      range->uncleanPaths,
+      ::testing::UnorderedElementsAre(RelativePath{"proj1/src/c.cpp"}));
+  EXPECT_EQ(
+      (std::vector<RootId>{RootId{"old"}, RootId{"new"}}),
+      range->snapshotTransitions);
+
+  range = journal.accumulateRange(4, "proj2"_relpath);
+  ASSERT_TRUE(range);
+  EXPECT_EQ(4, range->fromSequence);
+  EXPECT_EQ(6, range->toSequence);
+  EXPECT_THAT(
+      range->changedFilesInOverlay,
+      ::testing::UnorderedElementsAre(
+          ::testing::Pair(
+              RelativePath{"proj2/b.cpp"}, PathChangeInfo{true, false}),
+          ::testing::Pair(
+              RelativePath{"proj2/e.cpp"}, PathChangeInfo{true, true})));
+
+  // Nothing was ever recorded under proj3, but the commit changed.
+  range = journal.accumulateRange(1, "proj3"_relpath);
+  ASSERT_TRUE(range);
+  EXPECT_EQ(5, range->fromSequence);
+  EXPECT_TRUE(range->changedFilesInOverlay.empty());
+  EXPECT_TRUE(journal.accumulateRange(6, "proj3"_relpath) == nullptr);
+}
+
+TEST_F(JournalTest, prefix_index_survives_truncation_and_flush) {
+  journal.setMemoryLimit(0);
+  journal.recordCreated("proj1/a.txt"_relpath);
+  journal.recordCreated("proj2/b.txt"_relpath);
+  journal.recordCreated("proj1/c.txt"_relpath);
+
+  auto range = journal.accumulateRange(3, "proj1"_relpath);
+  ASSERT_TRUE(range);
+  EXPECT_FALSE(range->isTruncated);
+  EXPECT_THAT(
+      range->changedFilesInOverlay,
+      ::testing::UnorderedElementsAre(::testing::Pair(
+          RelativePath{"proj1/c.txt"}, PathChangeInfo{false, true})));
+  EXPECT_TRUE(journal.accumulateRange(3, "proj2"_relpath) == nullptr);
+
+  journal.flush();
+  journal.recordCreated("proj2/d.txt"_relpath);
+  // The flush took sequence numbers 4 and 5.
+  range = journal.accumulateRange(6, "proj2"_relpath);
+  ASSERT_TRUE(range);
+  EXPECT_FALSE(range->isTruncated);
+  EXPECT_EQ(6, range->fromSequence);
+  EXPECT_EQ(1, range->changedFilesInOverlay.size());
+}
+
+TEST_F(JournalTest, saved_journal_continues_where_it_left_off) {
+  folly::test::TemporaryDirectory tmpDir;
+  auto path = canonicalPath(tmpDir.path().string()) + "journal"_pc;
+
+  journal.recordHashUpdate(RootId{"commit"});
+  journal.recordCreated("proj1/a.txt"_relpath);
+  journal.recordRenamed("proj1/a.txt"_relpath, "proj2/b.txt"_relpath);
+  journal.recordUncleanPaths(
+      RootId{"commit"}, RootId{"commit2"}, {RelativePath{"proj1/c.txt"}});
+  journal.recordChanged("proj2/b.txt"_relpath);
+  journal.saveToFile(path, 1234);
+
+  // A journal on a different commit ignores the saved one.
+  Journal otherCommit{edenStats};
+  EXPECT_EQ(std::nullopt, otherCommit.loadFromFile(path, RootId{"commit"}));
+  EXPECT_EQ(0, otherCommit.getLatestSequenceNumber());
+
+  Journal restored{edenStats};
+  EXPECT_EQ(1234, restored.loadFromFile(path, RootId{"commit2"}));
+  EXPECT_EQ(5, restored.getLatestSequenceNumber());
+  EXPECT_EQ(RootId{"commit2"}, restored.getLatest()->toHash);
+  EXPECT_EQ(5, restored.getStats()->entryCount);
+
+  auto range = restored.accumulateRange(2);
+  ASSERT_TRUE(range);
+  EXPECT_FALSE(range->isTruncated);
+  EXPECT_EQ(2, range->fromSequence);
+  EXPECT_EQ(5, range->toSequence);
+  EXPECT_THAT(
+      range->changedFilesInOverlay,
+      ::testing::UnorderedElementsAre(
+          ::testing::Pair(
+              RelativePath{"proj1/a.txt"}, PathChangeInfo{false, false}),
+          ::testing::Pair(
+              RelativePath{"proj2/b.txt"}, PathChangeInfo{false, true})));
+  EXPECT_THAT(
+      range->uncleanPaths,
+      ::testing::UnorderedElementsAre(RelativePath{"proj1/c.txt"}));
+  EXPECT_EQ(
+      (std::vector<RootId>{RootId{"commit"}, RootId{"commit2"}}),
+      range->snapshotTransitions);
+
+  range = restored.accumulateRange(1, "proj1"_relpath);
+  ASSERT_TRUE(range);
+  EXPECT_THAT(
+      range->changedFilesInOverlay,
+      ::testing::UnorderedElementsAre(::testing::Pair(
+          RelativePath{"proj1/a.txt"}, PathChangeInfo{false, false})));
+
+  // New deltas continue the saved sequence numbers.
+  restored.recordChanged("proj2/b.txt"_relpath);
+  EXPECT_EQ(6, restored.getLatestSequenceNumber());
+}
+
+TEST_F(JournalTest, invalid_saved_journals_are_ignored) {
+  folly::test::TemporaryDirectory tmpDir;
+  auto path = canonicalPath(tmpDir.path().string()) + "journal"_pc;
+
+  EXPECT_EQ(std::nullopt, journal.loadFromFile(path, RootId{}));
+
+  journal.recordCreated("a.txt"_relpath);
+  journal.saveToFile(path, 1);
+  std::string contents;
+  ASSERT_TRUE(folly::readFile(path.c_str(), contents));
+  contents.resize(contents.size() - 1);
+  ASSERT_TRUE(folly::writeFile(contents, path.c_str()));
+
+  Journal restored{edenStats};
+  EXPECT_EQ(std::nullopt, restored.loadFromFile(path, RootId{}));
+  EXPECT_EQ(0, restored.getLatestSequenceNumber());
+}
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/Blake3.h"
+
+#include <folly/String.h>
+#include <folly/io/IOBuf.h>
+#include <algorithm>
+#include <cstring>
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr std::array<uint32_t, 8> kIV = {
+    0x6A09E667,
+    0xBB67AE85,
+    0x3C6EF372,
+    0xA54FF53A,
+    0x510E527F,
+    0x9B05688C,
+    0x1F83D9AB,
+    0x5BE0CD19};
+
+constexpr std::array<size_t, 16> kMessagePermutation = {
+    2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8};
+
+constexpr uint32_t kChunkStart = 1 << 0;
+constexpr uint32_t kChunkEnd = 1 << 1;
+constexpr uint32_t kParent = 1 << 2;
+constexpr uint32_t kRoot = 1 << 3;
+
+inline uint32_t rotateRight(uint32_t x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+inline void g(
+    std::array<uint32_t, 16>& state,
+    size_t a,
+    size_t b,
+    size_t c,
+    size_t d,
+    uint32_t mx,
+    uint32_t my) {
+  state[a] = state[a] + state[b] + mx;
+  state[d] = rotateRight(state[d] ^ state[a], 16);
+  state[c] = state[c] + state[d];
+  state[b] = rotateRight(state[b] ^ state[c], 12);
+  state[a] = state[a] + state[b] + my;
+  state[d] = rotateRight(state[d] ^ state[a], 8);
+  state[c] = state[c] + state[d];
+  state[b] = rotateRight(state[b] ^ state[c], 7);
+}
+
+std::array<uint32_t, 16> compress(
+    const std::array<uint32_t, 8>& chainingValue,
+    const std::array<uint32_t, 16>& blockWords,
+    uint64_t counter,
+    uint32_t blockLength,
+    uint32_t flags) {
+  std::array<uint32_t, 16> state = {
+      chainingValue[0],
+      chainingValue[1],
+      chainingValue[2],
+      chainingValue[3],
+      chainingValue[4],
+      chainingValue[5],
+      chainingValue[6],
+      chainingValue[7],
+      kIV[0],
+      kIV[1],
+      kIV[2],
+      kIV[3],
+      static_cast<uint32_t>(counter),
+      static_cast<uint32_t>(counter >> 32),
+      blockLength,
+      flags};
+  auto m = blockWords;
+  for (int round = 0; round < 7; ++round) {
+    // Mix the columns, then the diagonals.
+    g(state, 0, 4, 8, 12, m[0], m[1]);
+    g(state, 1, 5, 9, 13, m[2], m[3]);
+    g(state, 2, 6, 10, 14, m[4], m[5]);
+    g(state, 3, 7, 11, 15, m[6], m[7]);
+    g(state, 0, 5, 10, 15, m[8], m[9]);
+    g(state, 1, 6, 11, 12, m[10], m[11]);
+    g(state, 2, 7, 8, 13, m[12], m[13]);
+    g(state, 3, 4, 9, 14, m[14], m[15]);
+
+    std::array<uint32_t, 16> permuted;
+    for (size_t i = 0; i < permuted.size(); ++i) {
+      permuted[i] = m[kMessagePermutation[i]];
+    }
+    m = permuted;
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    state[i] ^= state[i + 8];
+    state[i + 8] ^= chainingValue[i];
+  }
+  return state;
+}
+
+std::array<uint32_t, 16> loadBlockWords(const uint8_t* block) {
+  std::array<uint32_t, 16> words;
+  for (size_t i = 0; i < words.size(); ++i) {
+    const uint8_t* p = block + 4 * i;
+    words[i] = static_cast<uint32_t>(p[0]) |
+        (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) |
+        (static_cast<uint32_t>(p[3]) << 24);
+  }
+  return words;
+}
+
+std::array<uint32_t, 8> firstEightWords(const std::array<uint32_t, 16>& w) {
+  return {w[0], w[1], w[2], w[3], w[4], w[5], w[6], w[7]};
+}
+
+} // namespace
+
+constexpr size_t Blake3::kBlockLength;
+constexpr size_t Blake3::kChunkLength;
+
+Blake3::Blake3() : chunkChainingValue_{kIV} {}
+
+Blake3::ChainingValue Blake3::Output::chainingValue() const {
+  return firstEightWords(compress(
+      inputChainingValue, blockWords, counter, blockLength, flags));
+}
+
+Blake3Hash Blake3::Output::rootHash() const {
+  // Only the first 32 bytes of output are used, which is the first block of
+  // the output stream, so the counter is 0.
+  auto words =
+      compress(inputChainingValue, blockWords, 0, blockLength, flags | kRoot);
+  Blake3Hash hash;
+  for (size_t i = 0; i < 8; ++i) {
+    hash[4 * i] = static_cast<uint8_t>(words[i]);
+    hash[4 * i + 1] = static_cast<uint8_t>(words[i] >> 8);
+    hash[4 * i + 2] = static_cast<uint8_t>(words[i] >> 16);
+    hash[4 * i + 3] = static_cast<uint8_t>(words[i] >> 24);
+  }
+  return hash;
+}
+
+Blake3::Output Blake3::parentOutput(
+    const ChainingValue& left,
+    const ChainingValue& right) {
+  Output output;
+  output.inputChainingValue = kIV;
+  std::copy(left.begin(), left.end(), output.blockWords.begin());
+  std::copy(right.begin(), right.end(), output.blockWords.begin() + 8);
+  output.counter = 0;
+  output.blockLength = kBlockLength;
+  output.flags = kParent;
+  return output;
+}
+
+Blake3::Output Blake3::chunkOutput() const {
+  std::array<uint8_t, kBlockLength> block{};
+  std::copy(block_.begin(), block_.begin() + blockLength_, block.begin());
+
+  Output output;
+  output.inputChainingValue = chunkChainingValue_;
+  output.blockWords = loadBlockWords(block.data());
+  output.counter = chunkCounter_;
+  output.blockLength = static_cast<uint32_t>(blockLength_);
+  output.flags = kChunkEnd | (blocksCompressed_ == 0 ? kChunkStart : 0);
+  return output;
+}
+
+void Blake3::addChunkChainingValue(
+    ChainingValue chainingValue,
+    uint64_t chunks) {
+  // Every trailing zero bit of the number of chunks hashed so far is a pair
+  // of equally sized subtrees that can now be merged.
+  while ((chunks & 1) == 0) {
+    chainingValue =
+        parentOutput(subtrees_.back(), chainingValue).chainingValue();
+    subtrees_.pop_back();
+    chunks >>= 1;
+  }
+  subtrees_.push_back(chainingValue);
+}
+
+void Blake3::update(folly::ByteRange data) {
+  while (!data.empty()) {
+    // The last block of a chunk is compressed differently, so a full chunk
+    // is only completed once more input shows that it is not the last one.
+    auto chunkLength = blocksCompressed_ * kBlockLength + blockLength_;
+    if (chunkLength == kChunkLength) {
+      auto chainingValue = chunkOutput().chainingValue();
+      ++chunkCounter_;
+      addChunkChainingValue(chainingValue, chunkCounter_);
+      chunkChainingValue_ = kIV;
+      blockLength_ = 0;
+      blocksCompressed_ = 0;
+    }
+
+    if (blockLength_ == kBlockLength) {
+      chunkChainingValue_ = firstEightWords(compress(
+          chunkChainingValue_,
+          loadBlockWords(block_.data()),
+          chunkCounter_,
+          kBlockLength,
+          blocksCompressed_ == 0 ? kChunkStart : 0));
+      ++blocksCompressed_;
+      blockLength_ = 0;
+    }
+
+    auto take = std::min(kBlockLength - blockLength_, data.size());
+    memcpy(block_.data() + blockLength_, data.data(), take);
+    blockLength_ += take;
+    data.advance(take);
+  }
+}
+
+void Blake3::update(const folly::IOBuf& buf) {
+  for (auto range : buf) {
+    update(range);
+  }
+}
+
+Blake3Hash Blake3::finalize() const {
+  auto output = chunkOutput();
+  for (auto it = subtrees_.rbegin(); it != subtrees_.rend(); ++it) {
+    output = parentOutput(*it, output.chainingValue());
+  }
+  return output.rootHash();
+}
+
+Blake3Hash Blake3::hash(folly::ByteRange data) {
+  Blake3 hasher;
+  hasher.update(data);
+  return hasher.finalize();
+}
+
+Blake3Hash Blake3::hash(const folly::IOBuf& buf) {
+  Blake3 hasher;
+  hasher.update(buf);
+  return hasher.finalize();
+}
+
+std::string Blake3::toString(const Blake3Hash& hash) {
+  std::string result;
+  folly::hexlify(hash, result);
+  return result;
+}
+
+} // namespace facebook::eden
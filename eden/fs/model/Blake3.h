@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace folly {
+class IOBuf;
+}
+
+namespace facebook::eden {
+
+/**
+ * A 256-bit BLAKE3 digest.
+ */
+using Blake3Hash = std::array<uint8_t, 32>;
+
+/**
+ * Incremental BLAKE3 hasher, in its default (unkeyed) hashing mode.
+ *
+ * This is a portable implementation of the algorithm. BLAKE3 hashes its input
+ * as 1 KiB chunks that are combined in a binary tree, so large inputs could be
+ * split across threads, but the blobs EdenFS hashes are rarely big enough for
+ * that to pay off.
+ *
+ * Usage:
+ *   Blake3 hasher;
+ *   hasher.update(first);
+ *   hasher.update(second);
+ *   Blake3Hash hash = hasher.finalize();
+ */
+class Blake3 {
+ public:
+  Blake3();
+
+  void update(folly::ByteRange data);
+  void update(const folly::IOBuf& buf);
+
+  /**
+   * Returns the hash of everything passed to update so far. The hasher may
+   * keep being updated afterwards.
+   */
+  Blake3Hash finalize() const;
+
+  static Blake3Hash hash(folly::ByteRange data);
+  static Blake3Hash hash(const folly::IOBuf& buf);
+
+  /** @return 64-character [lowercase] hex representation of a hash. */
+  static std::string toString(const Blake3Hash& hash);
+
+  static constexpr size_t kBlockLength = 64;
+  static constexpr size_t kChunkLength = 1024;
+
+ private:
+  using ChainingValue = std::array<uint32_t, 8>;
+
+  /**
+   * The inputs of the last compression of a chunk or parent node, which
+   * produces either its chaining value or, for the root, the hash.
+   */
+  struct Output {
+    ChainingValue inputChainingValue;
+    std::array<uint32_t, 16> blockWords;
+    uint64_t counter;
+    uint32_t blockLength;
+    uint32_t flags;
+
+    ChainingValue chainingValue() const;
+    Blake3Hash rootHash() const;
+  };
+
+  static Output parentOutput(
+      const ChainingValue& left,
+      const ChainingValue& right);
+
+  Output chunkOutput() const;
+  void addChunkChainingValue(ChainingValue chainingValue, uint64_t chunks);
+
+  // State of the chunk currently being hashed.
+  ChainingValue chunkChainingValue_;
+  uint64_t chunkCounter_{0};
+  std::array<uint8_t, kBlockLength> block_{};
+  size_t blockLength_{0};
+  size_t blocksCompressed_{0};
+
+  // Chaining values of the completed subtrees, whose sizes are decreasing
+  // powers of two chunks.
+  std::vector<ChainingValue> subtrees_;
+};
+
+} // namespace facebook::eden
@@ -9,7 +9,6 @@
 
 #include <folly/Conv.h>
 #include <folly/Format.h>
-#include <folly/String.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/ssl/OpenSSLHash.h>
@@ -32,8 +31,16 @@ folly::MutableByteRange Hash20::mutableBytes() {
 }
 
 std::string Hash20::toString() const {
-  std::string result;
-  folly::hexlify(bytes_, result);
+  return hexEncode(getBytes());
+}
+
+std::vector<std::string> toHexStrings(HashRange hashes) {
+  std::vector<std::string> result;
+  result.reserve(hashes.size());
+  for (const auto& hash : hashes) {
+    auto& hex = result.emplace_back(Hash20::RAW_SIZE * 2, '\0');
+    hexEncode(hash.getBytes(), hex.data());
+  }
   return result;
 }
 
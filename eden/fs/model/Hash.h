@@ -12,7 +12,10 @@
 #include <stdint.h>
 #include <array>
 #include <iosfwd>
+#include <string>
+#include <vector>
 #include "eden/fs/model/ObjectId.h" // fixme: remove from here and include in individual .h
+#include "eden/fs/utils/Hex.h"
 
 namespace folly {
 class IOBuf;
@@ -96,31 +99,13 @@ class Hash20 : boost::totally_ordered<Hash20> {
       throwInvalidArgument(
           "incorrect data size for Hash constructor from string: ", hex.size());
     }
-    return {
-        hexByteAt(hex, 0),  hexByteAt(hex, 1),  hexByteAt(hex, 2),
-        hexByteAt(hex, 3),  hexByteAt(hex, 4),  hexByteAt(hex, 5),
-        hexByteAt(hex, 6),  hexByteAt(hex, 7),  hexByteAt(hex, 8),
-        hexByteAt(hex, 9),  hexByteAt(hex, 10), hexByteAt(hex, 11),
-        hexByteAt(hex, 12), hexByteAt(hex, 13), hexByteAt(hex, 14),
-        hexByteAt(hex, 15), hexByteAt(hex, 16), hexByteAt(hex, 17),
-        hexByteAt(hex, 18), hexByteAt(hex, 19),
-    };
-  }
-  static constexpr uint8_t hexByteAt(folly::StringPiece hex, size_t index) {
-    return (nibbleToHex(hex.data()[index * 2]) * 16) +
-        nibbleToHex(hex.data()[(index * 2) + 1]);
-  }
-  static constexpr uint8_t nibbleToHex(char c) {
-    if ('0' <= c && c <= '9') {
-      return c - '0';
-    } else if ('a' <= c && c <= 'f') {
-      return 10 + c - 'a';
-    } else if ('A' <= c && c <= 'F') {
-      return 10 + c - 'A';
-    } else {
+    Storage bytes{};
+    if (!hexDecode(hex, bytes.data())) {
       throwInvalidArgument(
-          "invalid hex digit supplied to Hash constructor from string: ", c);
+          "invalid hex digit supplied to Hash constructor from string: ",
+          findInvalidHexDigit(hex));
     }
+    return bytes;
   }
 
   [[noreturn]] static void throwInvalidArgument(
@@ -132,6 +117,13 @@ class Hash20 : boost::totally_ordered<Hash20> {
 
 using HashRange = folly::Range<const Hash20*>;
 
+/**
+ * Returns the 40-character [lowercase] hex representation of each hash, in
+ * order, with a single allocation for the vector. Meant for rendering many
+ * hashes at once, e.g. in Thrift responses.
+ */
+std::vector<std::string> toHexStrings(HashRange hashes);
+
 /** A hash object initialized to all zeroes */
 extern const Hash20 kZeroHash;
 
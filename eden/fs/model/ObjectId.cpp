@@ -7,10 +7,10 @@
 
 #include "eden/fs/model/ObjectId.h"
 #include "eden/fs/model/Hash.h"
+#include "eden/fs/utils/Hex.h"
 
 #include <folly/Conv.h>
 #include <folly/Format.h>
-#include <folly/String.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/ssl/OpenSSLHash.h>
@@ -23,10 +23,7 @@ using folly::ssl::OpenSSLHash;
 namespace facebook::eden {
 
 std::string ObjectId::asHexString() const {
-  auto bytes = getBytes();
-  std::string result;
-  folly::hexlify(bytes, result);
-  return result;
+  return hexEncode(getBytes());
 }
 
 std::string ObjectId::asString() const {
@@ -34,6 +31,20 @@ std::string ObjectId::asString() const {
   return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
 }
 
+ObjectId::Storage ObjectId::constructFromHex(folly::StringPiece hex) {
+  if (hex.size() % 2 != 0) {
+    throwInvalidArgument(
+        "incorrect data size for Hash constructor from string: ", hex.size());
+  }
+  folly::fbstring result(hex.size() / 2, '\0');
+  if (!hexDecode(hex, reinterpret_cast<uint8_t*>(&result[0]))) {
+    throwInvalidArgument(
+        "invalid hex digit supplied to Hash constructor from string: ",
+        findInvalidHexDigit(hex));
+  }
+  return result;
+}
+
 size_t ObjectId::getHashCode() const noexcept {
   return std::hash<folly::fbstring>{}(bytes_);
 }
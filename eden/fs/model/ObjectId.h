@@ -99,35 +99,7 @@ class ObjectId : boost::totally_ordered<ObjectId> {
   static Storage constructFromByteRange(folly::ByteRange bytes) {
     return Storage{(const char*)bytes.data(), bytes.size()};
   }
-  static Storage constructFromHex(folly::StringPiece hex) {
-    if (hex.size() % 2 != 0) {
-      throwInvalidArgument(
-          "incorrect data size for Hash constructor from string: ", hex.size());
-    }
-    folly::fbstring result;
-    auto size = hex.size() / 2;
-    result.reserve(size);
-    for (size_t i = 0; i < size; i++) {
-      result.push_back(hexByteAt(hex, i));
-    }
-    return result;
-  }
-  static constexpr char hexByteAt(folly::StringPiece hex, size_t index) {
-    return (nibbleToHex(hex.data()[index * 2]) * 16) +
-        nibbleToHex(hex.data()[(index * 2) + 1]);
-  }
-  static constexpr char nibbleToHex(char c) {
-    if ('0' <= c && c <= '9') {
-      return c - '0';
-    } else if ('a' <= c && c <= 'f') {
-      return 10 + c - 'a';
-    } else if ('A' <= c && c <= 'F') {
-      return 10 + c - 'A';
-    } else {
-      throwInvalidArgument(
-          "invalid hex digit supplied to Hash constructor from string: ", c);
-    }
-  }
+  static Storage constructFromHex(folly::StringPiece hex);
 
   [[noreturn]] static void throwInvalidArgument(
       const char* message,
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/PackedTree.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include <fmt/format.h>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/utils/CaseInsensitiveCompare.h"
+
+namespace facebook::eden {
+
+PackedTree::PackedTree(
+    const ObjectId& hash,
+    std::unique_ptr<uint8_t[]> buffer,
+    size_t bufferSize)
+    : hash_{hash}, buffer_{std::move(buffer)}, bufferSize_{bufferSize} {
+  Header header;
+  memcpy(&header, buffer_.get(), sizeof(Header));
+  entryCount_ = header.entryCount;
+  records_ = reinterpret_cast<const Record*>(buffer_.get() + sizeof(Header));
+  arena_ = buffer_.get() + sizeof(Header) + entryCount_ * sizeof(Record);
+}
+
+PackedTree::PackedTree(const Tree& tree) : hash_{tree.getHash()} {
+  const auto& entries = tree.getTreeEntries();
+
+  size_t arenaSize = 0;
+  for (const auto& entry : entries) {
+    if (entry.getHash().size() > std::numeric_limits<uint8_t>::max()) {
+      throw std::invalid_argument(fmt::format(
+          "can not pack tree {}: id of {} is too long",
+          tree.getHash(),
+          entry.getName()));
+    }
+    if (entry.getName().stringPiece().size() >
+        std::numeric_limits<uint16_t>::max()) {
+      throw std::invalid_argument(fmt::format(
+          "can not pack tree {}: name of {} bytes is too long",
+          tree.getHash(),
+          entry.getName().stringPiece().size()));
+    }
+    arenaSize += entry.getName().stringPiece().size() + entry.getHash().size();
+    if (entry.getContentSha1()) {
+      arenaSize += Hash20::RAW_SIZE;
+    }
+  }
+  if (entries.size() > std::numeric_limits<uint32_t>::max() ||
+      arenaSize > std::numeric_limits<uint32_t>::max()) {
+    throw std::invalid_argument(
+        fmt::format("can not pack tree {}: too large", tree.getHash()));
+  }
+
+  bufferSize_ = sizeof(Header) + entries.size() * sizeof(Record) + arenaSize;
+  // new[] returns memory suitably aligned for Record.
+  buffer_ = std::make_unique<uint8_t[]>(bufferSize_);
+  Header header{
+      static_cast<uint32_t>(entries.size()), static_cast<uint32_t>(arenaSize)};
+  memcpy(buffer_.get(), &header, sizeof(Header));
+
+  entryCount_ = entries.size();
+  auto* records = reinterpret_cast<Record*>(buffer_.get() + sizeof(Header));
+  auto* arena = buffer_.get() + sizeof(Header) + entryCount_ * sizeof(Record);
+  records_ = records;
+  arena_ = arena;
+
+  uint32_t offset = 0;
+  auto append = [&](folly::ByteRange bytes) {
+    auto start = offset;
+    memcpy(arena + offset, bytes.data(), bytes.size());
+    offset += bytes.size();
+    return start;
+  };
+
+  for (size_t i = 0; i < entryCount_; ++i) {
+    const auto& entry = entries[i];
+    auto& rec = records[i];
+    auto name = entry.getName().stringPiece();
+    rec.nameOffset = append(folly::ByteRange{name});
+    rec.nameLength = name.size();
+    rec.hashOffset = append(entry.getHash().getBytes());
+    rec.hashLength = entry.getHash().size();
+    rec.typeAndFlags = static_cast<uint8_t>(entry.getType()) & kTypeMask;
+    rec.size = 0;
+    rec.sha1Offset = 0;
+    if (auto size = entry.getSize()) {
+      rec.typeAndFlags |= kHasSize;
+      rec.size = *size;
+    }
+    if (auto sha1 = entry.getContentSha1()) {
+      rec.typeAndFlags |= kHasSha1;
+      rec.sha1Offset = append(sha1->getBytes());
+    }
+  }
+}
+
+PackedTree PackedTree::fromBytes(
+    const ObjectId& hash,
+    folly::ByteRange bytes) {
+  if (bytes.size() < sizeof(Header)) {
+    throw std::invalid_argument(
+        fmt::format("packed tree {} is truncated", hash));
+  }
+  Header header;
+  memcpy(&header, bytes.data(), sizeof(Header));
+  uint64_t expectedSize = sizeof(Header) +
+      uint64_t{header.entryCount} * sizeof(Record) + header.arenaSize;
+  if (bytes.size() != expectedSize) {
+    throw std::invalid_argument(fmt::format(
+        "packed tree {} has size {}, expected {}",
+        hash,
+        bytes.size(),
+        expectedSize));
+  }
+
+  auto buffer = std::make_unique<uint8_t[]>(bytes.size());
+  memcpy(buffer.get(), bytes.data(), bytes.size());
+  PackedTree tree{hash, std::move(buffer), bytes.size()};
+
+  // Make sure that no record points outside of the arena, so the accessors do
+  // not need any bounds checks.
+  for (size_t i = 0; i < tree.entryCount_; ++i) {
+    const auto& rec = tree.record(i);
+    auto inArena = [&](uint64_t offset, uint64_t length) {
+      return offset + length <= header.arenaSize;
+    };
+    if (!inArena(rec.nameOffset, rec.nameLength) ||
+        !inArena(rec.hashOffset, rec.hashLength) ||
+        ((rec.typeAndFlags & kHasSha1) &&
+         !inArena(rec.sha1Offset, Hash20::RAW_SIZE)) ||
+        (rec.typeAndFlags & kTypeMask) >
+            static_cast<uint8_t>(TreeEntryType::SYMLINK)) {
+      throw std::invalid_argument(
+          fmt::format("packed tree {} has a corrupt entry {}", hash, i));
+    }
+  }
+  return tree;
+}
+
+PathComponentPiece PackedTree::nameOf(const Record& rec) const {
+  return PathComponentPiece{
+      folly::StringPiece{
+          reinterpret_cast<const char*>(arena_ + rec.nameOffset),
+          rec.nameLength},
+      detail::SkipPathSanityCheck{}};
+}
+
+PathComponentPiece PackedTree::getName(size_t index) const {
+  return nameOf(record(index));
+}
+
+ObjectId PackedTree::getEntryHash(size_t index) const {
+  const auto& rec = record(index);
+  return ObjectId{folly::ByteRange{arena_ + rec.hashOffset, rec.hashLength}};
+}
+
+TreeEntryType PackedTree::getType(size_t index) const {
+  return static_cast<TreeEntryType>(record(index).typeAndFlags & kTypeMask);
+}
+
+std::optional<uint64_t> PackedTree::getSize(size_t index) const {
+  const auto& rec = record(index);
+  if (rec.typeAndFlags & kHasSize) {
+    return rec.size;
+  }
+  return std::nullopt;
+}
+
+std::optional<Hash20> PackedTree::getContentSha1(size_t index) const {
+  const auto& rec = record(index);
+  if (rec.typeAndFlags & kHasSha1) {
+    return Hash20{folly::ByteRange{arena_ + rec.sha1Offset, Hash20::RAW_SIZE}};
+  }
+  return std::nullopt;
+}
+
+TreeEntry PackedTree::getEntry(size_t index) const {
+  return TreeEntry{
+      getEntryHash(index),
+      PathComponent{getName(index)},
+      getType(index),
+      getSize(index),
+      getContentSha1(index)};
+}
+
+std::optional<size_t> PackedTree::find(
+    PathComponentPiece name,
+    CaseSensitivity caseSensitive) const {
+  auto begin = records_;
+  auto end = records_ + entryCount_;
+  auto iter = std::lower_bound(
+      begin, end, name, [this](const Record& rec, PathComponentPiece piece) {
+        return nameOf(rec) < piece;
+      });
+  if (iter != end && nameOf(*iter) == name) {
+    return iter - begin;
+  }
+
+  if (caseSensitive == CaseSensitivity::Insensitive) {
+    auto needle = name.stringPiece();
+    for (size_t i = 0; i < entryCount_; ++i) {
+      if (equalsAsciiCaseInsensitive(
+              nameOf(records_[i]).stringPiece(), needle)) {
+        return i;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+std::unique_ptr<Tree> PackedTree::toTree() const {
+  std::vector<TreeEntry> entries;
+  entries.reserve(entryCount_);
+  for (size_t i = 0; i < entryCount_; ++i) {
+    entries.push_back(getEntry(i));
+  }
+  return std::make_unique<Tree>(std::move(entries), hash_);
+}
+
+} // namespace facebook::eden
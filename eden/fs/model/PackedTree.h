@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include <folly/Range.h>
+
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class Tree;
+
+/**
+ * A compact, immutable representation of a Tree held in one contiguous
+ * buffer.
+ *
+ * Where a Tree is a vector of TreeEntry objects that each own a heap-allocated
+ * name and id, a PackedTree stores fixed-size entry records followed by an
+ * arena holding every name, id and content hash. Building one costs a single
+ * allocation regardless of the number of entries, getSizeBytes() is exact and
+ * O(1), and lookups binary search over contiguous records.
+ *
+ * The buffer contains no pointers, so getBytes() can be written to disk and
+ * loaded back with fromBytes() by a process on the same machine.
+ */
+class PackedTree {
+ public:
+  /**
+   * Pack the entries of the given Tree.
+   *
+   * Throws std::invalid_argument if the tree is too large to be packed (more
+   * than 4GB of names and ids, or ids longer than 255 bytes).
+   */
+  explicit PackedTree(const Tree& tree);
+
+  PackedTree(PackedTree&&) noexcept = default;
+  PackedTree& operator=(PackedTree&&) noexcept = default;
+
+  /**
+   * Load a PackedTree from bytes previously returned by getBytes(), copying
+   * them into a new buffer.
+   *
+   * Throws std::invalid_argument if the bytes are not a valid PackedTree.
+   */
+  static PackedTree fromBytes(const ObjectId& hash, folly::ByteRange bytes);
+
+  const ObjectId& getHash() const {
+    return hash_;
+  }
+
+  /**
+   * The serialized form of this tree, excluding its hash.
+   */
+  folly::ByteRange getBytes() const {
+    return folly::ByteRange{buffer_.get(), bufferSize_};
+  }
+
+  size_t size() const {
+    return entryCount_;
+  }
+
+  bool empty() const {
+    return entryCount_ == 0;
+  }
+
+  PathComponentPiece getName(size_t index) const;
+  ObjectId getEntryHash(size_t index) const;
+  TreeEntryType getType(size_t index) const;
+  std::optional<uint64_t> getSize(size_t index) const;
+  std::optional<Hash20> getContentSha1(size_t index) const;
+
+  bool isTree(size_t index) const {
+    return getType(index) == TreeEntryType::TREE;
+  }
+
+  /**
+   * Build the TreeEntry at the given index.
+   */
+  TreeEntry getEntry(size_t index) const;
+
+  /**
+   * Return the index of the entry with the given name, or std::nullopt if
+   * there is none. Case insensitive lookups first try an exact match.
+   */
+  std::optional<size_t> find(
+      PathComponentPiece name,
+      CaseSensitivity caseSensitive = CaseSensitivity::Sensitive) const;
+
+  /**
+   * The exact memory footprint of this tree.
+   */
+  size_t getSizeBytes() const {
+    return sizeof(*this) + bufferSize_;
+  }
+
+  /**
+   * Unpack into a regular Tree.
+   */
+  std::unique_ptr<Tree> toTree() const;
+
+ private:
+  /**
+   * Fixed size entry record. Offsets are relative to the start of the arena.
+   */
+  struct Record {
+    uint64_t size;
+    uint32_t nameOffset;
+    uint32_t hashOffset;
+    uint32_t sha1Offset;
+    uint16_t nameLength;
+    uint8_t hashLength;
+    uint8_t typeAndFlags;
+  };
+  static_assert(sizeof(Record) == 24, "Record must be tightly packed");
+
+  static constexpr uint8_t kTypeMask = 0x0f;
+  static constexpr uint8_t kHasSize = 0x10;
+  static constexpr uint8_t kHasSha1 = 0x20;
+
+  /**
+   * The buffer starts with a Header, then entryCount Records, then the arena.
+   */
+  struct Header {
+    uint32_t entryCount;
+    uint32_t arenaSize;
+  };
+
+  PackedTree(
+      const ObjectId& hash,
+      std::unique_ptr<uint8_t[]> buffer,
+      size_t bufferSize);
+
+  const Record& record(size_t index) const {
+    return records_[index];
+  }
+
+  PathComponentPiece nameOf(const Record& record) const;
+
+  ObjectId hash_;
+  std::unique_ptr<uint8_t[]> buffer_;
+  size_t bufferSize_{0};
+  size_t entryCount_{0};
+  const Record* records_{nullptr};
+  const uint8_t* arena_{nullptr};
+};
+
+} // namespace facebook::eden
@@ -29,7 +29,27 @@ size_t Tree::getSizeBytes() const {
   for (auto& entry : entries_) {
     indirect_size += entry.getIndirectSizeBytes();
   }
+#ifdef _WIN32
+  indirect_size +=
+      folly::goodMallocSize(sizeof(uint32_t) * caseFoldedIndex_.capacity());
+#endif
   return internal_size + indirect_size;
 }
 
+#ifdef _WIN32
+std::vector<uint32_t> Tree::buildCaseFoldedIndex(
+    const std::vector<TreeEntry>& entries) {
+  std::vector<uint32_t> index(entries.size());
+  for (uint32_t i = 0; i < index.size(); ++i) {
+    index[i] = i;
+  }
+  std::sort(index.begin(), index.end(), [&](uint32_t a, uint32_t b) {
+    return compareAsciiCaseInsensitive(
+               entries[a].getName().stringPiece(),
+               entries[b].getName().stringPiece()) < 0;
+  });
+  return index;
+}
+#endif
+
 } // namespace facebook::eden
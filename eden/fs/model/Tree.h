@@ -11,6 +11,7 @@
 #include <vector>
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/utils/CaseInsensitiveCompare.h"
 
 namespace facebook::eden {
 
@@ -19,7 +20,14 @@ class Tree {
   explicit Tree(
       std::vector<TreeEntry>&& entries,
       const ObjectId& hash = ObjectId())
-      : hash_(hash), entries_(std::move(entries)) {}
+      : hash_(hash),
+        entries_(std::move(entries))
+#ifdef _WIN32
+        ,
+        caseFoldedIndex_(buildCaseFoldedIndex(entries_))
+#endif
+  {
+  }
 
   const ObjectId& getHash() const {
     return hash_;
@@ -52,13 +60,20 @@ class Tree {
       // On Windows we need to do a case insensitive lookup for the file and
       // directory names. For performance, we will do a case sensitive search
       // first which should cover most of the cases and if not found then do a
-      // case sensitive search.
+      // case insensitive binary search over the case-folded index.
       const auto& fileName = path.stringPiece();
-      for (const auto& entry : entries_) {
-        if (entry.getName().stringPiece().equals(
-                fileName, folly::AsciiCaseInsensitive())) {
-          return &entry;
-        }
+      auto folded = std::lower_bound(
+          caseFoldedIndex_.cbegin(),
+          caseFoldedIndex_.cend(),
+          fileName,
+          [this](uint32_t index, folly::StringPiece name) {
+            return compareAsciiCaseInsensitive(
+                       entries_[index].getName().stringPiece(), name) < 0;
+          });
+      if (folded != caseFoldedIndex_.cend() &&
+          equalsAsciiCaseInsensitive(
+              entries_[*folded].getName().stringPiece(), fileName)) {
+        return &entries_[*folded];
       }
 #endif
       return nullptr;
@@ -94,8 +109,19 @@ class Tree {
   }
 
  private:
+#ifdef _WIN32
+  /**
+   * Returns the positions of the entries, sorted by case-folded name.
+   */
+  static std::vector<uint32_t> buildCaseFoldedIndex(
+      const std::vector<TreeEntry>& entries);
+#endif
+
   const ObjectId hash_;
   const std::vector<TreeEntry> entries_;
+#ifdef _WIN32
+  const std::vector<uint32_t> caseFoldedIndex_;
+#endif
 };
 
 bool operator==(const Tree& tree1, const Tree& tree2);
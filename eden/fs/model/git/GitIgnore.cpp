@@ -66,21 +66,82 @@ void GitIgnore::loadFile(StringPiece contents) {
   // reverse them so that we can do a forward walk through our patterns and
   // stop at the first match.
   std::reverse(newRules.begin(), newRules.end());
+
+  Index newIndex;
+  for (uint32_t i = 0; i < newRules.size(); ++i) {
+    const auto& pattern = newRules[i];
+    auto literal = pattern.getLiteral().str();
+    switch (pattern.getLiteralKind()) {
+      case GitIgnorePattern::LiteralKind::BASENAME:
+        newIndex.basenames[literal].push_back(i);
+        break;
+      case GitIgnorePattern::LiteralKind::PATH:
+        newIndex.paths[literal].push_back(i);
+        break;
+      case GitIgnorePattern::LiteralKind::BASENAME_SUFFIX: {
+        auto length = literal.size();
+        if (std::find(
+                newIndex.suffixLengths.begin(),
+                newIndex.suffixLengths.end(),
+                length) == newIndex.suffixLengths.end()) {
+          newIndex.suffixLengths.push_back(length);
+        }
+        newIndex.basenameSuffixes[literal].push_back(i);
+        break;
+      }
+      case GitIgnorePattern::LiteralKind::NONE:
+        newIndex.unindexed.push_back(i);
+        break;
+    }
+  }
+
+  // The GlobMatchers and literals of the patterns, and the keys of the index,
+  // are each about as large as the text of the pattern.
+  sizeBytes_ = sizeof(GitIgnore) + contents.size() * 3 +
+      newRules.size() * (sizeof(GitIgnorePattern) + sizeof(uint32_t));
+
   std::swap(rules_, newRules);
+  std::swap(index_, newIndex);
 }
 
 GitIgnore::MatchResult GitIgnore::match(
     RelativePathPiece path,
     PathComponentPiece basename,
     FileType fileType) const {
-  for (const auto& pattern : rules_) {
-    auto result = pattern.match(path, basename, fileType);
-    if (result != NO_MATCH) {
-      return result;
+  // The index of the highest precedence matching rule found so far.
+  size_t best = rules_.size();
+  MatchResult bestResult = NO_MATCH;
+  auto tryRules = [&](const std::vector<uint32_t>& candidates) {
+    for (auto i : candidates) {
+      if (i >= best) {
+        return;
+      }
+      auto result = rules_[i].match(path, basename, fileType);
+      if (result != NO_MATCH) {
+        best = i;
+        bestResult = result;
+        return;
+      }
+    }
+  };
+  auto lookup = [&](const auto& map, StringPiece key) {
+    auto it = map.find(key);
+    if (it != map.end()) {
+      tryRules(it->second);
+    }
+  };
+
+  lookup(index_.basenames, basename.stringPiece());
+  lookup(index_.paths, path.stringPiece());
+  auto name = basename.stringPiece();
+  for (auto length : index_.suffixLengths) {
+    if (length <= name.size()) {
+      lookup(index_.basenameSuffixes, name.subpiece(name.size() - length));
     }
   }
+  tryRules(index_.unindexed);
 
-  return NO_MATCH;
+  return bestResult;
 }
 
 string GitIgnore::matchString(MatchResult result) {
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/container/F14Map.h>
+#include <string>
 #include <vector>
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -165,6 +167,13 @@ class GitIgnore {
     return rules_.empty();
   }
 
+  /**
+   * An estimate of the memory used by the parsed rules, in bytes.
+   */
+  size_t getSizeBytes() const {
+    return sizeBytes_;
+  }
+
   /**
    * Get a human-readable description of a MatchResult enum value.
    *
@@ -179,6 +188,33 @@ class GitIgnore {
    * listed in the .gitignore file).
    */
   std::vector<GitIgnorePattern> rules_;
+
+  /**
+   * An index of rules_, built by loadFile(), so that match() does not have to
+   * try every pattern.
+   *
+   * Patterns that match a literal basename, a literal path, or a basename
+   * ending with a literal suffix are found with hash lookups.  Only the
+   * remaining patterns are tried one by one, and only those with a higher
+   * precedence than the best indexed match.  All the vectors of indices into
+   * rules_ are sorted, so from the highest to the lowest precedence.
+   */
+  struct Index {
+    folly::F14FastMap<std::string, std::vector<uint32_t>> basenames;
+    folly::F14FastMap<std::string, std::vector<uint32_t>> paths;
+    folly::F14FastMap<std::string, std::vector<uint32_t>> basenameSuffixes;
+    // The distinct lengths of the keys of basenameSuffixes.
+    std::vector<size_t> suffixLengths;
+    // The patterns that could not be indexed.
+    std::vector<uint32_t> unindexed;
+  };
+
+  Index index_;
+
+  /**
+   * Computed by loadFile(), see getSizeBytes().
+   */
+  size_t sizeBytes_{sizeof(GitIgnore)};
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/GitIgnoreCache.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+GitIgnoreCache::GitIgnoreCache(size_t maximumEntries)
+    : maximumEntries_{maximumEntries},
+      state_{std::in_place, std::max<size_t>(maximumEntries, 1)} {}
+
+std::shared_ptr<const GitIgnore> GitIgnoreCache::get(const ObjectId& id) {
+  if (maximumEntries_ == 0) {
+    return nullptr;
+  }
+  // Lookups update the eviction order, so they need the write lock.
+  auto state = state_.wlock();
+  auto it = state->entries.find(id);
+  if (it == state->entries.end()) {
+    missCount_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  hitCount_.fetch_add(1, std::memory_order_relaxed);
+  return it->second;
+}
+
+std::shared_ptr<const GitIgnore> GitIgnoreCache::insert(
+    const ObjectId& id,
+    folly::StringPiece contents) {
+  // Parse outside of the lock: large ignore files take a while.
+  auto ignore = std::make_shared<GitIgnore>();
+  ignore->loadFile(contents);
+  std::shared_ptr<const GitIgnore> result = std::move(ignore);
+  if (maximumEntries_ == 0) {
+    return result;
+  }
+
+  auto state = state_.wlock();
+  auto it = state->entries.find(id);
+  if (it != state->entries.end()) {
+    // Another status operation parsed the same blob concurrently.
+    return it->second;
+  }
+  auto* rawState = &*state;
+  state->entries.set(
+      id,
+      result,
+      /*promote=*/true,
+      [rawState](ObjectId, std::shared_ptr<const GitIgnore>&& evicted) {
+        rawState->totalSizeInBytes -= evicted->getSizeBytes();
+      });
+  state->totalSizeInBytes += result->getSizeBytes();
+  return result;
+}
+
+GitIgnoreCache::Stats GitIgnoreCache::getStats() const {
+  Stats stats;
+  {
+    auto state = state_.rlock();
+    stats.entryCount = state->entries.size();
+    stats.totalSizeInBytes = state->totalSizeInBytes;
+  }
+  stats.hitCount = hitCount_.load(std::memory_order_relaxed);
+  stats.missCount = missCount_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <atomic>
+#include <memory>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/model/git/GitIgnore.h"
+
+namespace facebook::eden {
+
+/**
+ * Remembers the parsed and indexed contents of recently used .gitignore
+ * files, keyed by the ObjectId of their blob.
+ *
+ * Every status operation walks the same .gitignore files, and parsing and
+ * indexing a large one costs more than matching paths against it. A single
+ * cache is shared by all the mounts of the process, since checkouts of the
+ * same repository mostly share their ignore files. Blobs are immutable, so
+ * entries never go stale; the least recently used ones are evicted first.
+ *
+ * This class is thread safe.
+ */
+class GitIgnoreCache {
+ public:
+  struct Stats {
+    size_t entryCount{0};
+    /**
+     * The estimated memory used by the cached files, see
+     * GitIgnore::getSizeBytes().
+     */
+    size_t totalSizeInBytes{0};
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+  };
+
+  /**
+   * A cache holding at most maximumEntries parsed files. A maximumEntries of
+   * 0 disables the cache.
+   */
+  explicit GitIgnoreCache(size_t maximumEntries);
+
+  GitIgnoreCache(const GitIgnoreCache&) = delete;
+  GitIgnoreCache& operator=(const GitIgnoreCache&) = delete;
+
+  /**
+   * Returns the parsed contents of the .gitignore blob id, or nullptr if they
+   * are not in cache.
+   */
+  std::shared_ptr<const GitIgnore> get(const ObjectId& id);
+
+  /**
+   * Parses contents, the contents of the .gitignore blob id, and returns the
+   * result after inserting it in the cache.
+   */
+  std::shared_ptr<const GitIgnore> insert(
+      const ObjectId& id,
+      folly::StringPiece contents);
+
+  Stats getStats() const;
+
+ private:
+  struct State {
+    explicit State(size_t maximumEntries) : entries{maximumEntries} {}
+
+    folly::EvictingCacheMap<ObjectId, std::shared_ptr<const GitIgnore>>
+        entries;
+    size_t totalSizeInBytes{0};
+  };
+
+  const size_t maximumEntries_;
+  folly::Synchronized<State> state_;
+  std::atomic<uint64_t> hitCount_{0};
+  std::atomic<uint64_t> missCount_{0};
+};
+
+} // namespace facebook::eden
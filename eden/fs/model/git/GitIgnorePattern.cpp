@@ -12,6 +12,12 @@ using std::optional;
 
 namespace facebook::eden {
 
+namespace {
+bool hasGlobSpecialChars(StringPiece text) {
+  return text.find_first_of("*?[\\") != StringPiece::npos;
+}
+} // namespace
+
 optional<GitIgnorePattern> GitIgnorePattern::parseLine(StringPiece line) {
   uint32_t flags = 0;
 
@@ -137,11 +143,34 @@ optional<GitIgnorePattern> GitIgnorePattern::parseLine(StringPiece line) {
     return std::nullopt;
   }
 
-  return GitIgnorePattern(flags, std::move(matcher).value());
+  // Most patterns in large ignore files are plain names, or "*.ext": record
+  // them so that GitIgnore can index them.
+  auto literalKind = LiteralKind::NONE;
+  StringPiece literal;
+  if (!hasGlobSpecialChars(line)) {
+    literalKind = (flags & FLAG_BASENAME_ONLY) ? LiteralKind::BASENAME
+                                               : LiteralKind::PATH;
+    literal = line;
+  } else if (
+      (flags & FLAG_BASENAME_ONLY) && line.size() > 1 && line[0] == '*' &&
+      !hasGlobSpecialChars(line.subpiece(1))) {
+    literalKind = LiteralKind::BASENAME_SUFFIX;
+    literal = line.subpiece(1);
+  }
+
+  return GitIgnorePattern(
+      flags, std::move(matcher).value(), literalKind, literal.str());
 }
 
-GitIgnorePattern::GitIgnorePattern(uint32_t flags, GlobMatcher&& matcher)
-    : flags_(flags), matcher_(std::move(matcher)) {}
+GitIgnorePattern::GitIgnorePattern(
+    uint32_t flags,
+    GlobMatcher&& matcher,
+    LiteralKind literalKind,
+    std::string literal)
+    : flags_(flags),
+      matcher_(std::move(matcher)),
+      literalKind_(literalKind),
+      literal_(std::move(literal)) {}
 
 GitIgnorePattern::~GitIgnorePattern() {}
 
@@ -9,6 +9,7 @@
 
 #include <folly/Range.h>
 #include <optional>
+#include <string>
 #include "eden/fs/model/git/GitIgnore.h"
 #include "eden/fs/model/git/GlobMatcher.h"
 
@@ -69,6 +70,30 @@ class GitIgnorePattern {
       PathComponentPiece basename,
       GitIgnore::FileType fileType) const;
 
+  /**
+   * How the paths matched by this pattern can be found without running its
+   * GlobMatcher.  GitIgnore uses this to look patterns up in hash tables.
+   */
+  enum class LiteralKind : uint8_t {
+    // The pattern contains wildcards: only its GlobMatcher can tell.
+    NONE,
+    // The pattern only matches basenames equal to getLiteral().
+    BASENAME,
+    // The pattern only matches paths equal to getLiteral().
+    PATH,
+    // The pattern is "*" followed by getLiteral(), and only matches
+    // basenames ending with it.
+    BASENAME_SUFFIX,
+  };
+
+  LiteralKind getLiteralKind() const {
+    return literalKind_;
+  }
+
+  folly::StringPiece getLiteral() const {
+    return literal_;
+  }
+
  private:
   /**
    * Flag values that can be bitwise-ORed to create the flags_ value.
@@ -84,7 +109,11 @@ class GitIgnorePattern {
     FLAG_BASENAME_ONLY = 0x04,
   };
 
-  GitIgnorePattern(uint32_t flags, GlobMatcher&& matcher);
+  GitIgnorePattern(
+      uint32_t flags,
+      GlobMatcher&& matcher,
+      LiteralKind literalKind,
+      std::string literal);
 
   /**
    * A bit set of the Flags defined above.
@@ -94,6 +123,12 @@ class GitIgnorePattern {
    * The GlobMatcher object for performing matching.
    */
   GlobMatcher matcher_;
+  /**
+   * The part of the pattern that has to match literally, as described by
+   * literalKind_.  Empty if literalKind_ is NONE.
+   */
+  LiteralKind literalKind_{LiteralKind::NONE};
+  std::string literal_;
 };
 
 } // namespace facebook::eden
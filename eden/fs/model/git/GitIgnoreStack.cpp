@@ -47,7 +47,7 @@ GitIgnore::MatchResult GitIgnoreStack::match(
       ++suffixIter;
     }
 
-    const GitIgnore* ignore = &node->ignore_;
+    const GitIgnore* ignore = node->ignore_.get();
     node = node->parent_;
 
     const auto result = ignore->match(suffix, basename, fileType);
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include "eden/fs/model/git/GitIgnore.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -46,7 +47,8 @@ class GitIgnoreStack {
    * Create a new GitIgnoreStack for a directory that does not contain a
    * .gitignore file.
    */
-  explicit GitIgnoreStack(const GitIgnoreStack* parent) : parent_{parent} {}
+  explicit GitIgnoreStack(const GitIgnoreStack* parent)
+      : ignore_{std::make_shared<GitIgnore>()}, parent_{parent} {}
 
   /**
    * Create a new GitIgnoreStack for a directory that contains a .gitignore
@@ -56,10 +58,22 @@ class GitIgnoreStack {
       const GitIgnoreStack* parent,
       folly::StringPiece ignoreFileContents)
       : parent_{parent} {
-    ignore_.loadFile(ignoreFileContents);
+    auto ignore = std::make_shared<GitIgnore>();
+    ignore->loadFile(ignoreFileContents);
+    ignore_ = std::move(ignore);
   }
 
   GitIgnoreStack(const GitIgnoreStack* parent, GitIgnore ignore)
+      : ignore_{std::make_shared<GitIgnore>(std::move(ignore))},
+        parent_{parent} {}
+
+  /**
+   * Create a new GitIgnoreStack for a directory whose .gitignore file has
+   * already been parsed, typically by a GitIgnoreCache.
+   */
+  GitIgnoreStack(
+      const GitIgnoreStack* parent,
+      std::shared_ptr<const GitIgnore> ignore)
       : ignore_{std::move(ignore)}, parent_{parent} {}
 
   /**
@@ -70,14 +84,15 @@ class GitIgnoreStack {
       GitIgnore::FileType fileType) const;
 
   bool empty() const {
-    return ignore_.empty();
+    return ignore_->empty();
   }
 
  private:
   /**
-   * The GitIgnore info for this node on the stack
+   * The GitIgnore info for this node on the stack.  It is never null, and may
+   * be shared with other stacks using the same .gitignore file.
    */
-  GitIgnore ignore_;
+  std::shared_ptr<const GitIgnore> ignore_;
 
   /**
    * A pointer to the next node in the stack.
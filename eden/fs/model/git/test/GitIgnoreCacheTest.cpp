@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/GitIgnoreCache.h"
+
+#include <fmt/format.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+ObjectId makeId(size_t i) {
+  return ObjectId::fromHex(fmt::format("{:040x}", i));
+}
+} // namespace
+
+TEST(GitIgnoreCache, returnsInsertedFiles) {
+  GitIgnoreCache cache{10};
+  EXPECT_EQ(nullptr, cache.get(makeId(1)));
+
+  auto inserted = cache.insert(makeId(1), "*.o\n");
+  EXPECT_EQ(
+      GitIgnore::EXCLUDE,
+      inserted->match(RelativePathPiece{"a.o"}, GitIgnore::TYPE_FILE));
+  EXPECT_EQ(inserted, cache.get(makeId(1)));
+
+  auto stats = cache.getStats();
+  EXPECT_EQ(1, stats.entryCount);
+  EXPECT_EQ(inserted->getSizeBytes(), stats.totalSizeInBytes);
+  EXPECT_EQ(1, stats.hitCount);
+  EXPECT_EQ(1, stats.missCount);
+}
+
+TEST(GitIgnoreCache, accountsForEvictedFiles) {
+  GitIgnoreCache cache{2};
+  cache.insert(makeId(1), "a\n");
+  auto second = cache.insert(makeId(2), "bb\n");
+  auto third = cache.insert(makeId(3), "ccc\n");
+
+  EXPECT_EQ(nullptr, cache.get(makeId(1)));
+  auto stats = cache.getStats();
+  EXPECT_EQ(2, stats.entryCount);
+  EXPECT_EQ(
+      second->getSizeBytes() + third->getSizeBytes(), stats.totalSizeInBytes);
+}
+
+TEST(GitIgnoreCache, keepsTheFirstParseOfABlob) {
+  GitIgnoreCache cache{10};
+  auto first = cache.insert(makeId(1), "a\n");
+  EXPECT_EQ(first, cache.insert(makeId(1), "a\n"));
+  EXPECT_EQ(first->getSizeBytes(), cache.getStats().totalSizeInBytes);
+}
+
+TEST(GitIgnoreCache, zeroSizeDisablesTheCache) {
+  GitIgnoreCache cache{0};
+  auto ignore = cache.insert(makeId(1), "a\n");
+  EXPECT_FALSE(ignore->empty());
+  EXPECT_EQ(nullptr, cache.get(makeId(1)));
+  EXPECT_EQ(0, cache.getStats().entryCount);
+}
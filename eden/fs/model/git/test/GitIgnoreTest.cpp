@@ -68,6 +68,42 @@ TEST(GitIgnore, testPrecedence) {
   EXPECT_IGNORE(ignore, NO_MATCH, "!a");
 }
 
+TEST(GitIgnore, testIndexedPrecedence) {
+  // Literal names, literal paths and "*suffix" patterns are looked up in
+  // hash tables, separately from the other patterns: the last matching line
+  // must still win, whichever kind of pattern it is.
+  GitIgnore ignore;
+  ignore.loadFile(
+      "*.o\n"
+      "!keep.o\n"
+      "build/*\n"
+      "!build/out.o\n"
+      "*.tar.gz\n"
+      "!release.*\n"
+      "node_modules\n"
+      "!src/node_modules\n"
+      "lib/\n");
+
+  EXPECT_IGNORE(ignore, EXCLUDE, "a.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "dir/a.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, ".o");
+  EXPECT_IGNORE(ignore, NO_MATCH, "a.od");
+  EXPECT_IGNORE(ignore, INCLUDE, "keep.o");
+  EXPECT_IGNORE(ignore, INCLUDE, "dir/keep.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "build/a");
+  EXPECT_IGNORE(ignore, INCLUDE, "build/out.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "build/keep.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "a.tar.gz");
+  EXPECT_IGNORE(ignore, NO_MATCH, "a.gz");
+  EXPECT_IGNORE(ignore, INCLUDE, "release.tar.gz");
+  EXPECT_IGNORE(ignore, INCLUDE, "release.o");
+  EXPECT_IGNORE_DIR(ignore, EXCLUDE, "node_modules");
+  EXPECT_IGNORE_DIR(ignore, EXCLUDE, "a/node_modules");
+  EXPECT_IGNORE_DIR(ignore, INCLUDE, "src/node_modules");
+  EXPECT_IGNORE_DIR(ignore, EXCLUDE, "lib");
+  EXPECT_IGNORE(ignore, NO_MATCH, "lib");
+}
+
 TEST(GitIgnore, testComments) {
   GitIgnore ignore;
 
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/Blake3.h"
+
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GTest.h>
+#include <vector>
+
+using namespace facebook::eden;
+using folly::ByteRange;
+using folly::IOBuf;
+
+namespace {
+/**
+ * The input of the official BLAKE3 test vectors: the repeating byte
+ * sequence 0, 1, ..., 250.
+ */
+std::vector<uint8_t> testInput(size_t length) {
+  std::vector<uint8_t> input(length);
+  for (size_t i = 0; i < length; ++i) {
+    input[i] = static_cast<uint8_t>(i % 251);
+  }
+  return input;
+}
+
+std::string hashHex(size_t length) {
+  auto input = testInput(length);
+  return Blake3::toString(Blake3::hash(ByteRange{input.data(), input.size()}));
+}
+} // namespace
+
+TEST(Blake3, matchesTestVectors) {
+  EXPECT_EQ(
+      "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262",
+      hashHex(0));
+  EXPECT_EQ(
+      "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213",
+      hashHex(1));
+  EXPECT_EQ(
+      "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7",
+      hashHex(1024));
+  EXPECT_EQ(
+      "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444",
+      hashHex(1025));
+  EXPECT_EQ(
+      "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a",
+      hashHex(2048));
+  EXPECT_EQ(
+      "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030",
+      hashHex(2049));
+  EXPECT_EQ(
+      "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085",
+      hashHex(102400));
+}
+
+TEST(Blake3, incrementalUpdatesMatchOneShotHash) {
+  auto input = testInput(102400);
+  Blake3 hasher;
+  size_t offset = 0;
+  for (size_t step = 1; offset < input.size(); step = step * 3 + 7) {
+    auto length = std::min(step % 5000, input.size() - offset);
+    hasher.update(ByteRange{input.data() + offset, length});
+    offset += length;
+  }
+  EXPECT_EQ(
+      Blake3::hash(ByteRange{input.data(), input.size()}), hasher.finalize());
+}
+
+TEST(Blake3, hashesIOBufChains) {
+  auto input = testInput(5000);
+  auto buf = IOBuf::copyBuffer(input.data(), 1500);
+  buf->prependChain(IOBuf::copyBuffer(input.data() + 1500, 3500));
+  EXPECT_EQ(
+      Blake3::hash(ByteRange{input.data(), input.size()}), Blake3::hash(*buf));
+}
@@ -11,6 +11,7 @@
 #include <folly/container/Array.h>
 #include <folly/io/Cursor.h>
 #include <folly/portability/GTest.h>
+#include <vector>
 
 using namespace facebook::eden;
 using folly::ByteRange;
@@ -219,3 +220,13 @@ TEST(Hash20, getHashCode) {
   // using 64 bits of data to contribute to the hash code.
   EXPECT_EQ(folly::Endian::big(0xfaceb00cdeadbeef), testHash.getHashCode());
 }
+
+TEST(Hash20, toHexStrings) {
+  std::vector<Hash20> hashes{testHash, Hash20{}, kEmptySha1};
+  auto hex = toHexStrings(HashRange{hashes.data(), hashes.size()});
+  ASSERT_EQ(3, hex.size());
+  EXPECT_EQ(testHashHex, hex[0]);
+  EXPECT_EQ("0000000000000000000000000000000000000000", hex[1]);
+  EXPECT_EQ(kEmptySha1.toString(), hex[2]);
+  EXPECT_TRUE(toHexStrings(HashRange{}).empty());
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/PackedTree.h"
+
+#include <folly/portability/GTest.h>
+#include <limits>
+
+#include "eden/fs/model/Tree.h"
+
+using namespace facebook::eden;
+
+namespace {
+const auto treeHash =
+    ObjectId::fromHex("0000000000000000000000000000000000000010");
+const auto hash1 =
+    ObjectId::fromHex("0000000000000000000000000000000000000001");
+const auto hash2 =
+    ObjectId::fromHex("0000000000000000000000000000000000000002");
+const auto sha1 = Hash20{"faceb00cdeadbeefc00010ff1badb0028badf00d"};
+
+Tree makeTree() {
+  std::vector<TreeEntry> entries;
+  entries.emplace_back(hash1, PathComponent{"Bar"}, TreeEntryType::TREE);
+  entries.emplace_back(
+      hash2, PathComponent{"baz"}, TreeEntryType::REGULAR_FILE, 12, sha1);
+  entries.emplace_back(
+      ObjectId{ObjectId::Storage{"a longer, variable length object id"}},
+      PathComponent{"foo"},
+      TreeEntryType::REGULAR_FILE);
+  return Tree{std::move(entries), treeHash};
+}
+} // namespace
+
+TEST(PackedTree, packs_all_entry_fields) {
+  auto tree = makeTree();
+  PackedTree packed{tree};
+
+  EXPECT_EQ(treeHash, packed.getHash());
+  ASSERT_EQ(3, packed.size());
+  for (size_t i = 0; i < packed.size(); ++i) {
+    EXPECT_EQ(tree.getEntryAt(i), packed.getEntry(i));
+  }
+  EXPECT_TRUE(packed.isTree(0));
+  EXPECT_EQ(12, packed.getSize(1));
+  EXPECT_EQ(sha1, packed.getContentSha1(1));
+  EXPECT_EQ(std::nullopt, packed.getSize(2));
+  EXPECT_EQ(std::nullopt, packed.getContentSha1(2));
+  EXPECT_EQ(tree, *packed.toTree());
+}
+
+TEST(PackedTree, find) {
+  PackedTree packed{makeTree()};
+  EXPECT_EQ(0, packed.find(PathComponentPiece{"Bar"}));
+  EXPECT_EQ(1, packed.find(PathComponentPiece{"baz"}));
+  EXPECT_EQ(2, packed.find(PathComponentPiece{"foo"}));
+  EXPECT_EQ(std::nullopt, packed.find(PathComponentPiece{"bar"}));
+  EXPECT_EQ(std::nullopt, packed.find(PathComponentPiece{"zzz"}));
+  EXPECT_EQ(
+      0,
+      packed.find(PathComponentPiece{"bar"}, CaseSensitivity::Insensitive));
+  EXPECT_EQ(
+      2,
+      packed.find(PathComponentPiece{"FOO"}, CaseSensitivity::Insensitive));
+}
+
+TEST(PackedTree, empty_tree) {
+  PackedTree packed{Tree{std::vector<TreeEntry>{}, treeHash}};
+  EXPECT_TRUE(packed.empty());
+  EXPECT_EQ(std::nullopt, packed.find(PathComponentPiece{"foo"}));
+  EXPECT_EQ(0, packed.toTree()->getTreeEntries().size());
+}
+
+TEST(PackedTree, is_smaller_than_tree) {
+  auto tree = makeTree();
+  PackedTree packed{tree};
+  EXPECT_LT(packed.getSizeBytes(), tree.getSizeBytes());
+}
+
+TEST(PackedTree, round_trips_through_bytes) {
+  PackedTree packed{makeTree()};
+  auto bytes = packed.getBytes();
+  std::string copy{reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+
+  auto loaded = PackedTree::fromBytes(
+      treeHash, folly::ByteRange{folly::StringPiece{copy}});
+  EXPECT_EQ(*packed.toTree(), *loaded.toTree());
+}
+
+TEST(PackedTree, rejects_names_longer_than_a_record_holds) {
+  std::vector<TreeEntry> entries;
+  entries.emplace_back(
+      hash1,
+      PathComponent{std::string(std::numeric_limits<uint16_t>::max(), 'a')},
+      TreeEntryType::REGULAR_FILE);
+  EXPECT_NO_THROW(PackedTree{Tree(std::move(entries), treeHash)});
+
+  entries.clear();
+  entries.emplace_back(
+      hash1,
+      PathComponent{
+          std::string(std::numeric_limits<uint16_t>::max() + 1, 'a')},
+      TreeEntryType::REGULAR_FILE);
+  EXPECT_THROW(
+      PackedTree{Tree(std::move(entries), treeHash)}, std::invalid_argument);
+}
+
+TEST(PackedTree, rejects_corrupt_bytes) {
+  PackedTree packed{makeTree()};
+  auto bytes = packed.getBytes();
+
+  EXPECT_THROW(
+      PackedTree::fromBytes(treeHash, bytes.subpiece(0, bytes.size() - 1)),
+      std::invalid_argument);
+  EXPECT_THROW(
+      PackedTree::fromBytes(treeHash, bytes.subpiece(0, 2)),
+      std::invalid_argument);
+
+  std::string corrupt{
+      reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+  // Point the first entry's name far outside of the arena.
+  corrupt[8 + 8] = '\xff';
+  corrupt[8 + 9] = '\xff';
+  EXPECT_THROW(
+      PackedTree::fromBytes(
+          treeHash, folly::ByteRange{folly::StringPiece{corrupt}}),
+      std::invalid_argument);
+}
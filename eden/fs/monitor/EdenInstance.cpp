@@ -137,9 +137,19 @@ class SpawnedEdenInstance::StartupStatusChecker : private AsyncTimeout {
     // Save client_ as a member variable so that we can destroy it in
     // startupAborted() to cancel the pending thrift call.
     client_ = instance_->monitor_->createEdenThriftClient();
-    return client_->future_getStatus().thenTry([](Try<fb303_status> status) {
-      return status.hasValue() && (status.value() == fb303_status::ALIVE);
-    });
+    // During a graceful restart the socket is served by the previous EdenFS
+    // process until the takeover, so also check who answers.
+    return client_->future_getPid().thenTry(
+        [client = client_, pid = instance_->getPid()](Try<int64_t> answerer) {
+          if (!answerer.hasValue() || answerer.value() != pid) {
+            return folly::makeFuture(false);
+          }
+          return client->future_getStatus().thenTry(
+              [](Try<fb303_status> status) {
+                return status.hasValue() &&
+                    (status.value() == fb303_status::ALIVE);
+              });
+        });
   }
 
   folly::Promise<Unit> promise_;
@@ -150,11 +160,13 @@ class SpawnedEdenInstance::StartupStatusChecker : private AsyncTimeout {
 
 SpawnedEdenInstance::SpawnedEdenInstance(
     EdenMonitor* monitor,
-    std::shared_ptr<LogFile> log)
+    std::shared_ptr<LogFile> log,
+    std::vector<std::string> extraArgs)
     : EdenInstance(monitor),
       EventHandler(monitor->getEventBase()),
       AsyncTimeout(monitor->getEventBase()),
       edenfsExe_(AbsolutePath(FLAGS_edenfs)),
+      extraArgs_(std::move(extraArgs)),
       log_(std::move(log)) {}
 
 SpawnedEdenInstance::~SpawnedEdenInstance() {
@@ -196,6 +208,7 @@ Future<Unit> SpawnedEdenInstance::start() {
     argv.push_back("--configPath");
     argv.push_back(FLAGS_configPath);
   }
+  argv.insert(argv.end(), extraArgs_.begin(), extraArgs_.end());
   SpawnedProcess::Options options;
   Pipe outputPipe;
   options.dup2(outputPipe.write.duplicate(), STDOUT_FILENO);
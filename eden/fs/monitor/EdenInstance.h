@@ -12,6 +12,8 @@
 #include <chrono>
 #include <cstddef>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <folly/File.h>
 #include <folly/Portability.h>
@@ -95,7 +97,14 @@ class SpawnedEdenInstance : public EdenInstance,
                             private folly::EventHandler,
                             private folly::AsyncTimeout {
  public:
-  SpawnedEdenInstance(EdenMonitor* monitor, std::shared_ptr<LogFile> log);
+  /**
+   * extraArgs are appended to the edenfs command line, e.g. to take over
+   * from the running daemon during a graceful restart.
+   */
+  SpawnedEdenInstance(
+      EdenMonitor* monitor,
+      std::shared_ptr<LogFile> log,
+      std::vector<std::string> extraArgs = {});
   ~SpawnedEdenInstance() override;
 
   FOLLY_NODISCARD folly::Future<folly::Unit> start() override;
@@ -126,6 +135,7 @@ class SpawnedEdenInstance : public EdenInstance,
   void checkLivenessImpl();
 
   AbsolutePath edenfsExe_;
+  std::vector<std::string> extraArgs_;
   SpawnedProcess cmd_;
   pid_t pid_{0};
   FileDescriptor logPipe_;
@@ -86,9 +86,9 @@ EdenMonitor::EdenMonitor(
   signalHandler_->registerSignalHandler(SIGHUP);
   signalHandler_->registerSignalHandler(SIGINT);
   signalHandler_->registerSignalHandler(SIGTERM);
+  signalHandler_->registerSignalHandler(SIGUSR1);
   // Eventually we should register some other signals for additional actions.
   // Perhaps:
-  // - SIGUSR1: request a graceful restart when the system looks idle
   // - SIGUSR2: request a hard restart (exit) when the system looks idle
 
   auto logDir = edenDir_ + "logs"_relpath;
@@ -104,7 +104,12 @@ EdenMonitor::EdenMonitor(
       logDir + "edenfs.log"_relpath, maxLogSize, std::move(rotationStrategy));
 }
 
-EdenMonitor::~EdenMonitor() {}
+EdenMonitor::~EdenMonitor() {
+  // Destroying a starting EdenInstance fails its start future, which calls
+  // back into gracefulRestartFailed().  Do this while the other members are
+  // still alive.
+  gracefulRestartNewEdenfs_.reset();
+}
 
 void EdenMonitor::run() {
   // Schedule our start operation to run once we start the EventBase loop
@@ -177,11 +182,126 @@ std::shared_ptr<EdenServiceAsyncClient> EdenMonitor::createEdenThriftClient() {
   return std::make_shared<EdenServiceAsyncClient>(std::move(channel));
 }
 
-void EdenMonitor::edenInstanceFinished(EdenInstance* /*instance*/) {
+void EdenMonitor::edenInstanceFinished(EdenInstance* instance) {
+  if (gracefulRestartNewEdenfs_ &&
+      instance == gracefulRestartNewEdenfs_.get()) {
+    XLOG(ERR) << "new EdenFS process " << instance->getPid()
+              << " exited before completing the graceful restart";
+    destroyInstanceLater(std::move(gracefulRestartNewEdenfs_));
+    state_ = State::Running;
+    if (edenfsExitedDuringRestart_) {
+      XLOG(ERR) << "no EdenFS process is left; terminating the monitor";
+      eventBase_.terminateLoopSoon();
+    }
+    return;
+  }
+  if (retiringEdenfs_ && instance == retiringEdenfs_.get()) {
+    XLOG(DBG1) << "previous EdenFS process " << instance->getPid()
+               << " has exited after the graceful restart";
+    destroyInstanceLater(std::move(retiringEdenfs_));
+    return;
+  }
+  if (state_ == State::GracefulRestarting && instance == edenfs_.get()) {
+    XLOG(INFO) << "EdenFS process " << instance->getPid()
+               << " has exited, waiting for the new EdenFS process to finish "
+               << "the graceful restart";
+    edenfsExitedDuringRestart_ = true;
+    return;
+  }
+
   XLOG(DBG1) << "EdenFS has exited; terminating the monitor";
   eventBase_.terminateLoopSoon();
 }
 
+void EdenMonitor::performGracefulRestart() {
+  if (state_ != State::Running || retiringEdenfs_) {
+    XLOG(WARN) << "ignoring graceful restart request: EdenFS is still "
+               << "starting or restarting";
+    return;
+  }
+
+  auto newEdenfs = createGracefulRestartInstance();
+  auto future = Future<Unit>::makeEmpty();
+  try {
+    future = newEdenfs->start();
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "failed to start a new EdenFS process for a graceful "
+              << "restart: " << folly::exceptionStr(ex);
+    return;
+  }
+  XLOG(INFO) << "started new EdenFS process " << newEdenfs->getPid()
+             << " to gracefully take over from " << edenfs_->getPid();
+
+  state_ = State::GracefulRestarting;
+  edenfsExitedDuringRestart_ = false;
+  gracefulRestartNewEdenfs_ = std::move(newEdenfs);
+  std::move(future).thenTry(
+      [this, instance = gracefulRestartNewEdenfs_.get()](Try<Unit> result) {
+        if (result.hasException()) {
+          gracefulRestartFailed(instance, result.exception());
+        } else {
+          gracefulRestartFinished(instance);
+        }
+      });
+}
+
+std::unique_ptr<EdenInstance> EdenMonitor::createGracefulRestartInstance() {
+  return std::make_unique<SpawnedEdenInstance>(
+      this,
+      log_,
+      std::vector<std::string>{"--takeover", "--takeover_prewarm"});
+}
+
+void EdenMonitor::gracefulRestartFinished(EdenInstance* newEdenfs) {
+  if (newEdenfs != gracefulRestartNewEdenfs_.get()) {
+    // The restart was abandoned when the new process exited.
+    return;
+  }
+
+  XLOG(INFO) << "graceful restart complete, now monitoring EdenFS process "
+             << newEdenfs->getPid();
+  auto previous = std::move(edenfs_);
+  edenfs_ = std::move(gracefulRestartNewEdenfs_);
+  state_ = State::Running;
+  if (edenfsExitedDuringRestart_) {
+    destroyInstanceLater(std::move(previous));
+    edenfsExitedDuringRestart_ = false;
+  } else {
+    retiringEdenfs_ = std::move(previous);
+  }
+}
+
+void EdenMonitor::gracefulRestartFailed(
+    EdenInstance* newEdenfs,
+    const folly::exception_wrapper& error) {
+  if (newEdenfs != gracefulRestartNewEdenfs_.get()) {
+    // The restart was abandoned when the new process exited.
+    return;
+  }
+
+  XLOG(ERR) << "new EdenFS process " << newEdenfs->getPid()
+            << " failed to start for the graceful restart: " << error.what();
+  state_ = State::Running;
+  if (edenfsExitedDuringRestart_) {
+    destroyInstanceLater(std::move(gracefulRestartNewEdenfs_));
+    XLOG(ERR) << "no EdenFS process is left; terminating the monitor";
+    eventBase_.terminateLoopSoon();
+    return;
+  }
+
+  // Keep the new process around until it exits, so that its exit is not
+  // mistaken for the exit of edenfs_, and so that another graceful restart is
+  // only attempted once it is gone.
+  XLOG(INFO) << "keeping EdenFS process " << edenfs_->getPid();
+  forwardSignal(newEdenfs, SIGTERM);
+  retiringEdenfs_ = std::move(gracefulRestartNewEdenfs_);
+}
+
+void EdenMonitor::destroyInstanceLater(std::unique_ptr<EdenInstance> instance) {
+  eventBase_.runInLoop(
+      [instance = std::move(instance)]() mutable { instance.reset(); });
+}
+
 void EdenMonitor::performSelfRestart() {
   // For now, ignore SIGHUP requests while EdenFS is still starting.
   // While we could have the new EdenFS daemon be aware that it still needs to
@@ -194,6 +314,13 @@ void EdenMonitor::performSelfRestart() {
         << "EdenFS is still starting.  Attempt this again once EdenFS has started.";
     return;
   }
+  // The new and the previous EdenFS processes of a graceful restart could
+  // not be handed over to the restarted monitor.
+  if (state_ == State::GracefulRestarting || retiringEdenfs_) {
+    XLOG(WARN) << "ignoring self-restart request for the EdenFS monitor: "
+               << "a graceful restart of EdenFS is in progress.";
+    return;
+  }
 
   // Build a vector of extra arguments to pass along with information about
   // the EdenFS process we are currently monitoring.
@@ -254,25 +381,47 @@ void EdenMonitor::signalReceived(int sig) {
     case SIGCHLD:
       XLOG(DBG2) << "got SIGCHLD";
       edenfs_->checkLiveness();
+      if (gracefulRestartNewEdenfs_) {
+        gracefulRestartNewEdenfs_->checkLiveness();
+      }
+      if (retiringEdenfs_) {
+        retiringEdenfs_->checkLiveness();
+      }
       return;
     case SIGHUP:
       performSelfRestart();
       return;
+    case SIGUSR1:
+      performGracefulRestart();
+      return;
     case SIGINT:
     case SIGTERM:
-      // Forward the signal to the edenfs instance
+      // Forward the signal to every EdenFS process we are monitoring, which
+      // during a graceful restart includes the new and the retiring one.
       XLOG(DBG1) << "received terminal signal " << sig;
-      auto pid = edenfs_->getPid();
-      XCHECK_GE(pid, 0);
-      auto rc = kill(pid, sig);
-      if (rc != 0) {
-        XLOG(WARN) << "error forwarding signal " << sig
-                   << " to EdenFS: " << folly::errnoStr(errno);
+      if (!edenfsExitedDuringRestart_) {
+        forwardSignal(edenfs_.get(), sig);
+      }
+      if (gracefulRestartNewEdenfs_) {
+        forwardSignal(gracefulRestartNewEdenfs_.get(), sig);
+      }
+      if (retiringEdenfs_) {
+        forwardSignal(retiringEdenfs_.get(), sig);
       }
       return;
   }
   XLOG(WARN) << "received unexpected signal " << sig;
 }
 
+void EdenMonitor::forwardSignal(EdenInstance* instance, int sig) {
+  auto pid = instance->getPid();
+  XCHECK_GE(pid, 0);
+  auto rc = kill(pid, sig);
+  if (rc != 0) {
+    XLOG(WARN) << "error forwarding signal " << sig << " to EdenFS process "
+               << pid << ": " << folly::errnoStr(errno);
+  }
+}
+
 } // namespace eden
 } // namespace facebook
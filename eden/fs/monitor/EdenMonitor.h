@@ -15,9 +15,10 @@
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace folly {
+class exception_wrapper;
 template <typename T>
 class Future;
-}
+} // namespace folly
 
 namespace facebook {
 namespace eden {
@@ -46,7 +47,7 @@ class EdenMonitor {
       std::unique_ptr<EdenConfig> config,
       folly::StringPiece selfExe,
       const std::vector<std::string>& selfArgv);
-  ~EdenMonitor();
+  virtual ~EdenMonitor();
 
   void run();
 
@@ -71,6 +72,17 @@ class EdenMonitor {
    */
   void performSelfRestart();
 
+  /**
+   * Replace the EdenFS daemon with a new one, started from the current
+   * edenfs binary, that gracefully takes over its mount points.
+   *
+   * The new daemon warms up its local store and thread pools before it
+   * requests the mount points, so that they are only blocked while their
+   * state is transferred. If the new daemon fails to start, it is
+   * terminated and the current one keeps serving the mounts.
+   */
+  void performGracefulRestart();
+
   /**
    * edenInstanceFinished() should be called by the EdenInstance object when the
    * EdenFS process that it is monitoring has exited.
@@ -78,10 +90,12 @@ class EdenMonitor {
   void edenInstanceFinished(EdenInstance* instance);
 
  private:
+  friend class EdenMonitorTest;
   class SignalHandler;
   enum class State {
     Starting,
     Running,
+    GracefulRestarting,
   };
 
   EdenMonitor(EdenMonitor const&) = delete;
@@ -89,8 +103,27 @@ class EdenMonitor {
 
   folly::Future<folly::Unit> start();
   folly::Future<folly::Unit> getEdenInstance();
+  /**
+   * Create the EdenInstance that takes over from edenfs_ in a graceful
+   * restart.
+   */
+  virtual std::unique_ptr<EdenInstance> createGracefulRestartInstance();
+  void gracefulRestartFinished(EdenInstance* newEdenfs);
+  /**
+   * Called when newEdenfs failed to start.  The graceful restart is
+   * abandoned, and edenfs_ remains the monitored EdenFS process.
+   */
+  void gracefulRestartFailed(
+      EdenInstance* newEdenfs,
+      const folly::exception_wrapper& error);
+  /**
+   * Destroy instance once the current EventBase loop iteration is done, as
+   * it may be the caller of edenInstanceFinished().
+   */
+  void destroyInstanceLater(std::unique_ptr<EdenInstance> instance);
 
   void signalReceived(int sig);
+  void forwardSignal(EdenInstance* instance, int sig);
 
   State state_{State::Starting};
   AbsolutePath const edenDir_;
@@ -106,6 +139,12 @@ class EdenMonitor {
   // process that is starting and attempting to take over state from edenfs_.
   // Otherwise this variable will be null.
   std::unique_ptr<EdenInstance> gracefulRestartNewEdenfs_;
+  // Whether edenfs_ exited during the graceful restart, normally after it
+  // handed its mount points over.
+  bool edenfsExitedDuringRestart_{false};
+  // The EdenFS process that was replaced by a graceful restart, or the new
+  // one that failed to start in its place, until it exits.
+  std::unique_ptr<EdenInstance> retiringEdenfs_;
 };
 
 } // namespace eden
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/monitor/EdenMonitor.h"
+
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <stdexcept>
+
+#include <folly/futures/Future.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/monitor/EdenInstance.h"
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace std::chrono_literals;
+using folly::Future;
+using folly::Unit;
+using std::make_unique;
+using std::unique_ptr;
+
+namespace facebook {
+namespace eden {
+
+namespace {
+/**
+ * An EdenInstance for a stand-in process, whose startup is completed by the
+ * test.
+ */
+class FakeEdenInstance : public EdenInstance {
+ public:
+  FakeEdenInstance(EdenMonitor* monitor, pid_t pid)
+      : EdenInstance(monitor), pid_{pid} {}
+
+  FOLLY_NODISCARD Future<Unit> start() override {
+    return startPromise_.getFuture();
+  }
+  pid_t getPid() const override {
+    return pid_;
+  }
+  void checkLiveness() override {}
+
+  void finishStarting() {
+    startPromise_.setValue();
+  }
+  void failStarting() {
+    startPromise_.setException(std::runtime_error("edenfs failed to start"));
+  }
+
+ private:
+  pid_t const pid_;
+  folly::Promise<Unit> startPromise_;
+};
+
+class TestEdenMonitor : public EdenMonitor {
+ public:
+  TestEdenMonitor(
+      unique_ptr<EdenConfig> config,
+      std::function<unique_ptr<EdenInstance>(EdenMonitor*)> createInstance)
+      : EdenMonitor(std::move(config), "edenfs_monitor", {}),
+        createInstance_{std::move(createInstance)} {}
+
+ private:
+  unique_ptr<EdenInstance> createGracefulRestartInstance() override {
+    return createInstance_(this);
+  }
+
+  std::function<unique_ptr<EdenInstance>(EdenMonitor*)> createInstance_;
+};
+} // namespace
+
+class EdenMonitorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    auto config =
+        make_unique<EdenConfig>(*EdenConfig::createTestEdenConfig());
+    config->edenDir.setValue(
+        AbsolutePath{tempDir_.path().string()}, ConfigSource::CommandLine);
+    monitor_ = make_unique<TestEdenMonitor>(
+        std::move(config), [this](EdenMonitor* monitor) {
+          auto instance = make_unique<FakeEdenInstance>(monitor, spawnEdenfs());
+          started_.push_back(instance.get());
+          return instance;
+        });
+
+    auto edenfs = make_unique<FakeEdenInstance>(monitor_.get(), spawnEdenfs());
+    started_.push_back(edenfs.get());
+    monitor_->edenfs_ = std::move(edenfs);
+    monitor_->state_ = EdenMonitor::State::Running;
+  }
+
+  void TearDown() override {
+    monitor_.reset();
+    for (auto& process : processes_) {
+      if (!process.terminated()) {
+        process.terminateOrKill(1s);
+      }
+    }
+  }
+
+  /**
+   * Start a process standing in for an edenfs daemon, and return its pid.
+   */
+  pid_t spawnEdenfs() {
+    processes_.emplace_back(std::vector<std::string>{"sleep", "600"});
+    return processes_.back().pid();
+  }
+
+  /**
+   * Wait for the process standing in for the nth edenfs daemon to exit, and
+   * return the signal that killed it, or 0 if it is still running.
+   */
+  int killSignal(size_t n) {
+    auto status = processes_.at(n).waitTimeout(5s);
+    if (status.state() == ProcessStatus::State::Running) {
+      return 0;
+    }
+    return status.killSignal();
+  }
+
+  bool isRunning(size_t n) {
+    return !processes_.at(n).terminated();
+  }
+
+  void signal(int sig) {
+    monitor_->signalReceived(sig);
+  }
+
+  EdenInstance* edenfs() const {
+    return monitor_->edenfs_.get();
+  }
+  EdenInstance* newEdenfs() const {
+    return monitor_->gracefulRestartNewEdenfs_.get();
+  }
+  EdenInstance* retiringEdenfs() const {
+    return monitor_->retiringEdenfs_.get();
+  }
+  bool isRestarting() const {
+    return monitor_->state_ == EdenMonitor::State::GracefulRestarting;
+  }
+
+  folly::test::TemporaryDirectory tempDir_{makeTempDir()};
+  std::vector<SpawnedProcess> processes_;
+  std::vector<FakeEdenInstance*> started_;
+  unique_ptr<TestEdenMonitor> monitor_;
+};
+
+TEST_F(EdenMonitorTest, gracefulRestartHandsOverToNewEdenfs) {
+  signal(SIGUSR1);
+  ASSERT_EQ(2, started_.size());
+  EXPECT_TRUE(isRestarting());
+  EXPECT_EQ(started_[0], edenfs());
+  EXPECT_EQ(started_[1], newEdenfs());
+
+  // A second request is ignored while the first one is in progress.
+  signal(SIGUSR1);
+  EXPECT_EQ(2, started_.size());
+
+  started_[1]->finishStarting();
+  EXPECT_FALSE(isRestarting());
+  EXPECT_EQ(started_[1], edenfs());
+  EXPECT_EQ(nullptr, newEdenfs());
+  EXPECT_EQ(started_[0], retiringEdenfs());
+
+  // Once the previous edenfs exits, another restart can be requested.
+  monitor_->edenInstanceFinished(started_[0]);
+  EXPECT_EQ(nullptr, retiringEdenfs());
+  signal(SIGUSR1);
+  EXPECT_EQ(3, started_.size());
+  EXPECT_TRUE(isRestarting());
+}
+
+TEST_F(EdenMonitorTest, failedGracefulRestartKeepsCurrentEdenfs) {
+  signal(SIGUSR1);
+  ASSERT_EQ(2, started_.size());
+
+  started_[1]->failStarting();
+  EXPECT_FALSE(isRestarting());
+  EXPECT_EQ(started_[0], edenfs());
+  EXPECT_EQ(nullptr, newEdenfs());
+
+  // The new edenfs is terminated, and the current one keeps running.
+  EXPECT_EQ(SIGTERM, killSignal(1));
+  EXPECT_TRUE(isRunning(0));
+
+  // Once the new edenfs exits, another restart can be requested.
+  EXPECT_EQ(started_[1], retiringEdenfs());
+  monitor_->edenInstanceFinished(started_[1]);
+  EXPECT_EQ(nullptr, retiringEdenfs());
+  signal(SIGUSR1);
+  EXPECT_EQ(3, started_.size());
+  EXPECT_TRUE(isRestarting());
+}
+
+TEST_F(EdenMonitorTest, sigtermDuringGracefulRestartReachesBothEdenfs) {
+  signal(SIGUSR1);
+  ASSERT_EQ(2, started_.size());
+
+  signal(SIGTERM);
+  EXPECT_EQ(SIGTERM, killSignal(0));
+  EXPECT_EQ(SIGTERM, killSignal(1));
+}
+
+TEST_F(EdenMonitorTest, sigtermAfterGracefulRestartReachesRetiringEdenfs) {
+  signal(SIGUSR1);
+  ASSERT_EQ(2, started_.size());
+  started_[1]->finishStarting();
+  ASSERT_EQ(started_[0], retiringEdenfs());
+
+  signal(SIGTERM);
+  EXPECT_EQ(SIGTERM, killSignal(0));
+  EXPECT_EQ(SIGTERM, killSignal(1));
+}
+
+} // namespace eden
+} // namespace facebook
@@ -57,6 +57,36 @@ bool NfsDirList::add(
   return true;
 }
 
+NfsDirPlusList::NfsDirPlusList(uint32_t dircount, uint32_t maxcount)
+    : remainingDir_(dircount), remaining_(computeInitialRemaining(maxcount)) {}
+
+bool NfsDirPlusList::add(
+    folly::StringPiece name,
+    InodeNumber ino,
+    uint64_t offset) {
+  auto entry = entryplus3{
+      ino.get(),
+      name.str(),
+      offset,
+      post_op_attr{fattr3{}},
+      post_op_fh3{nfs_fh3{ino}}};
+  // dircount only covers the fields shared with READDIR's entry3.
+  auto dirSize = XdrTrait<uint64_t>::serializedSize(entry.fileid) +
+      XdrTrait<std::string>::serializedSize(entry.name) +
+      XdrTrait<uint64_t>::serializedSize(entry.cookie);
+  auto neededSize = XdrTrait<entryplus3>::serializedSize(entry) +
+      XdrTrait<bool>::serializedSize(true);
+
+  if (dirSize > remainingDir_ || neededSize > remaining_) {
+    return false;
+  }
+
+  remainingDir_ -= dirSize;
+  remaining_ -= neededSize;
+  list_.list.push_back(std::move(entry));
+  return true;
+}
+
 } // namespace facebook::eden
 
 #endif
@@ -47,6 +47,55 @@ class NfsDirList {
   XdrList<entry3> list_{};
 };
 
+/**
+ * The READDIRPLUS flavor of NfsDirList, whose entries also carry the
+ * attributes and file handle of each child.
+ *
+ * The space needed for the attributes is accounted for when adding an entry,
+ * but the attributes themselves are filled in by the caller once they are
+ * known.
+ */
+class NfsDirPlusList {
+ public:
+  /**
+   * dircount bounds the size of the directory information alone (file ids,
+   * names and cookies), while maxcount bounds the whole READDIRPLUS3resok.
+   */
+  NfsDirPlusList(uint32_t dircount, uint32_t maxcount);
+
+  NfsDirPlusList(NfsDirPlusList&&) = default;
+  NfsDirPlusList& operator=(NfsDirPlusList&&) = default;
+
+  NfsDirPlusList() = delete;
+  NfsDirPlusList(const NfsDirPlusList&) = delete;
+  NfsDirPlusList& operator=(const NfsDirPlusList&) = delete;
+
+  /**
+   * Add an entry. Return true if the entry was successfully added, false
+   * otherwise.
+   */
+  bool add(folly::StringPiece name, InodeNumber ino, uint64_t offset);
+
+  /**
+   * The entries added so far, in order.
+   */
+  const std::vector<entryplus3>& getEntries() const {
+    return list_.list;
+  }
+
+  /**
+   * Move the built list out of the NfsDirPlusList.
+   */
+  XdrList<entryplus3> extractList() {
+    return std::move(list_);
+  }
+
+ private:
+  uint32_t remainingDir_;
+  uint32_t remaining_;
+  XdrList<entryplus3> list_{};
+};
+
 } // namespace facebook::eden
 
 #endif
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/nfs/NfsAttrCache.h"
+
+namespace facebook::eden {
+
+NfsAttrCache::NfsAttrCache(size_t maxEntries)
+    : state_{std::in_place, maxEntries} {}
+
+uint64_t NfsAttrCache::getGeneration() const {
+  return state_.lock()->generation;
+}
+
+std::optional<fattr3> NfsAttrCache::get(InodeNumber ino) {
+  auto state = state_.lock();
+  auto it = state->entries.find(ino);
+  if (it == state->entries.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void NfsAttrCache::insert(
+    InodeNumber ino,
+    const fattr3& attr,
+    uint64_t generation) {
+  auto state = state_.lock();
+  if (state->generation != generation) {
+    return;
+  }
+  state->entries.set(ino, attr);
+}
+
+void NfsAttrCache::invalidate(InodeNumber ino) {
+  auto state = state_.lock();
+  state->entries.erase(ino);
+  state->generation++;
+}
+
+void NfsAttrCache::invalidateAll() {
+  auto state = state_.lock();
+  state->entries.clear();
+  state->generation++;
+}
+
+} // namespace facebook::eden
+
+#endif
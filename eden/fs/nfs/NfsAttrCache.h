@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <mutex>
+#include <optional>
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/nfs/NfsdRpc.h"
+
+namespace facebook::eden {
+
+/**
+ * Attributes of the inodes of a mount, as last replied to GETATTR.
+ *
+ * The macOS NFS client issues a GETATTR on every open and whenever its own
+ * attribute cache expires. Answering these from this cache doesn't take any
+ * InodeMap or inode lock.
+ *
+ * Entries must be invalidated once an inode has been modified. Since a
+ * GETATTR may race with a modification, insert() takes the generation that
+ * was read before the attributes were computed, and drops them if an
+ * invalidation happened in the meantime.
+ */
+class NfsAttrCache {
+ public:
+  explicit NfsAttrCache(size_t maxEntries);
+
+  NfsAttrCache(const NfsAttrCache&) = delete;
+  NfsAttrCache& operator=(const NfsAttrCache&) = delete;
+
+  /**
+   * Returns the generation to pass to insert().
+   */
+  uint64_t getGeneration() const;
+
+  std::optional<fattr3> get(InodeNumber ino);
+
+  /**
+   * Cache the attributes of ino, unless the cache was invalidated since
+   * generation was obtained from getGeneration().
+   */
+  void insert(InodeNumber ino, const fattr3& attr, uint64_t generation);
+
+  void invalidate(InodeNumber ino);
+  void invalidateAll();
+
+ private:
+  struct State {
+    explicit State(size_t maxEntries) : entries{maxEntries} {}
+
+    folly::EvictingCacheMap<InodeNumber, fattr3> entries;
+    uint64_t generation{0};
+  };
+
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
+
+#endif
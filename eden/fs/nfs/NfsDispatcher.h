@@ -331,6 +331,8 @@ class NfsDispatcher {
     NfsDirList entries;
     /** Has the readdir reached the end of the directory */
     bool isEof;
+    /** The cookie verifier to return to the client */
+    uint64_t cookieverf{0};
   };
 
   /**
@@ -341,13 +343,66 @@ class NfsDispatcher {
    * necessary to return all the directory entries. In this case, a subsequent
    * readdir call will be made by the NFS client to restart the enumeration at
    * offset. The first readdir will have an offset of 0.
+   *
+   * The client passes back the cookieverf returned by the previous readdir of
+   * the enumeration, or 0 for the first one.
    */
   virtual ImmediateFuture<ReaddirRes> readdir(
       InodeNumber dir,
       off_t offset,
+      uint64_t cookieverf,
       uint32_t count,
       ObjectFetchContext& context) = 0;
 
+  /**
+   * Return value of the readdirplus method.
+   */
+  struct ReaddirPlusRes {
+    /** List of directory entries */
+    NfsDirPlusList entries;
+    /** The attributes of each entry, in the same order */
+    std::vector<folly::Try<struct stat>> attributes;
+    /** Has the readdir reached the end of the directory */
+    bool isEof;
+    /** The cookie verifier to return to the client */
+    uint64_t cookieverf{0};
+  };
+
+  /**
+   * Same as readdir, but also return the attributes of each entry.
+   *
+   * The entries are bounded by both dircount, for the directory information
+   * alone, and maxcount, for the entire reply.
+   */
+  virtual ImmediateFuture<ReaddirPlusRes> readdirplus(
+      InodeNumber dir,
+      off_t offset,
+      uint64_t cookieverf,
+      uint32_t dircount,
+      uint32_t maxcount,
+      ObjectFetchContext& context) = 0;
+
+  /**
+   * Return value of the commit method.
+   */
+  struct CommitRes {
+    /** Attributes of the file prior to committing it */
+    std::optional<struct stat> preStat;
+    /** Attributes of the file after committing it */
+    std::optional<struct stat> postStat;
+  };
+
+  /**
+   * Flush the data previously written to the file referenced by the
+   * InodeNumber ino to stable storage.
+   *
+   * See the comment on the create method for the meaning of the returned pre
+   * and post stat.
+   */
+  virtual ImmediateFuture<CommitRes> commit(
+      InodeNumber ino,
+      ObjectFetchContext& context) = 0;
+
   virtual ImmediateFuture<struct statfs> statfs(
       InodeNumber dir,
       ObjectFetchContext& context) = 0;
@@ -18,13 +18,18 @@ namespace facebook::eden {
 NfsServer::NfsServer(
     folly::EventBase* evb,
     uint64_t numServicingThreads,
-    uint64_t maxInflightRequests)
+    uint64_t maxInflightRequests,
+    uint64_t maxInflightRequestsPerConnection,
+    CpuAffinityPolicy threadAffinity)
     : evb_(evb),
       threadPool_(std::make_shared<folly::CPUThreadPoolExecutor>(
           numServicingThreads,
           std::make_unique<EdenTaskQueue>(maxInflightRequests),
-          std::make_unique<folly::NamedThreadFactory>("NfsThreadPool"))),
-      mountd_(evb_, threadPool_) {}
+          std::make_unique<CpuAffinityThreadFactory>(
+              std::make_shared<folly::NamedThreadFactory>("NfsThreadPool"),
+              threadAffinity))),
+      maxInflightRequestsPerConnection_(maxInflightRequestsPerConnection),
+      mountd_(evb_, threadPool_, maxInflightRequestsPerConnection_) {}
 
 void NfsServer::initialize(
     folly::SocketAddress addr,
@@ -42,7 +47,8 @@ NfsServer::NfsMountInfo NfsServer::registerMount(
     folly::Duration requestTimeout,
     Notifications* FOLLY_NULLABLE notifications,
     CaseSensitivity caseSensitive,
-    uint32_t iosize) {
+    uint32_t iosize,
+    size_t attrCacheSize) {
   auto nfsd = std::make_unique<Nfsd3>(
       evb_,
       threadPool_,
@@ -53,7 +59,9 @@ NfsServer::NfsMountInfo NfsServer::registerMount(
       requestTimeout,
       notifications,
       caseSensitive,
-      iosize);
+      iosize,
+      maxInflightRequestsPerConnection_,
+      attrCacheSize);
   mountd_.registerMount(path, rootIno);
 
   return {std::move(nfsd), mountd_.getAddr()};
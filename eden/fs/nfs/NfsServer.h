@@ -13,6 +13,7 @@
 #include "eden/fs/nfs/Mountd.h"
 #include "eden/fs/nfs/Nfsd3.h"
 #include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/CpuAffinity.h"
 
 namespace folly {
 class Executor;
@@ -31,7 +32,9 @@ class NfsServer {
    * This will handle the lifetime of the various programs involved in the NFS
    * protocol including mountd and nfsd. The requests will be serviced by a
    * blocking thread pool initialized with numServicingThreads and
-   * maxInflightRequests.
+   * maxInflightRequests. Each connection is allowed at most
+   * maxInflightRequestsPerConnection requests in flight. The threads are
+   * placed according to threadAffinity.
    *
    * One mountd program will be created per NfsServer, while one nfsd program
    * will be created per-mount point, this allows nfsd program to be only aware
@@ -40,7 +43,9 @@ class NfsServer {
   NfsServer(
       folly::EventBase* evb,
       uint64_t numServicingThreads,
-      uint64_t maxInflightRequests);
+      uint64_t maxInflightRequests,
+      uint64_t maxInflightRequestsPerConnection,
+      CpuAffinityPolicy threadAffinity);
 
   /**
    * Bind the NfsServer to the passed in socket.
@@ -76,7 +81,8 @@ class NfsServer {
       folly::Duration requestTimeout,
       Notifications* FOLLY_NULLABLE notifications,
       CaseSensitivity caseSensitive,
-      uint32_t iosize);
+      uint32_t iosize,
+      size_t attrCacheSize);
 
   /**
    * Unregister the mount point matching the path.
@@ -101,6 +107,7 @@ class NfsServer {
  private:
   folly::EventBase* evb_;
   std::shared_ptr<folly::Executor> threadPool_;
+  uint64_t maxInflightRequestsPerConnection_;
   Mountd mountd_;
 };
 
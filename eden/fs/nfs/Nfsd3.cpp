@@ -14,10 +14,13 @@
 #include <sys/sysmacros.h>
 #endif
 
+#include <folly/Random.h>
 #include <folly/Utility.h>
 #include <folly/executors/SerialExecutor.h>
 #include <folly/futures/Future.h>
+#include <folly/logging/xlog.h>
 #include <memory>
+#include "eden/fs/nfs/NfsAttrCache.h"
 #include "eden/fs/nfs/NfsRequestContext.h"
 #include "eden/fs/nfs/NfsdRpc.h"
 #include "eden/fs/telemetry/FsEventLogger.h"
@@ -37,6 +40,12 @@ constexpr size_t kTraceBusCapacity = 25000;
 static_assert(sizeof(NfsTraceEvent) == 40);
 static_assert(kTraceBusCapacity * sizeof(NfsTraceEvent) == 1000000);
 
+// The trace bus drops events rather than blocking NFS requests when its
+// subscribers fall behind, so a request whose FINISH event was dropped stays
+// in the outstanding requests forever. Past this many, they are all assumed
+// to be stale.
+constexpr size_t kMaxTrackedRequests = 10000;
+
 class Nfsd3ServerProcessor final : public RpcServerProcessor {
  public:
   explicit Nfsd3ServerProcessor(
@@ -47,7 +56,8 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
       folly::Promise<Nfsd3::StopData>& stopPromise,
       ProcessAccessLog& processAccessLog,
       std::atomic<size_t>& traceDetailedArguments,
-      std::shared_ptr<TraceBus<NfsTraceEvent>>& traceBus)
+      std::shared_ptr<TraceBus<NfsTraceEvent>>& traceBus,
+      NfsAttrCache* attrCache)
       : dispatcher_(std::move(dispatcher)),
         straceLogger_(straceLogger),
         caseSensitive_(caseSensitive),
@@ -55,7 +65,8 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
         stopPromise_{stopPromise},
         processAccessLog_{processAccessLog},
         traceDetailedArguments_(traceDetailedArguments),
-        traceBus_(traceBus) {}
+        traceBus_(traceBus),
+        attrCache_(attrCache) {}
 
   Nfsd3ServerProcessor(const Nfsd3ServerProcessor&) = delete;
   Nfsd3ServerProcessor(Nfsd3ServerProcessor&&) = delete;
@@ -162,6 +173,13 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
       NfsRequestContext& context);
 
  private:
+  /**
+   * Drop the cached attributes that the procedure may have changed. This is
+   * called once the procedure completed, so that a GETATTR racing with it
+   * cannot cache the attributes from before the change.
+   */
+  void invalidateCachedAttrs(uint32_t procNumber, folly::io::Cursor args);
+
   std::unique_ptr<NfsDispatcher> dispatcher_;
   const folly::Logger* straceLogger_;
   CaseSensitivity caseSensitive_;
@@ -174,6 +192,8 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
   ProcessAccessLog& processAccessLog_;
   std::atomic<size_t>& traceDetailedArguments_;
   std::shared_ptr<TraceBus<NfsTraceEvent>>& traceBus_;
+  // Owned by the nfs3d, like the stopPromise_. Null when disabled.
+  NfsAttrCache* attrCache_;
 };
 
 /**
@@ -420,23 +440,38 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::getattr(
 
   auto args = XdrTrait<GETATTR3args>::deserialize(deser);
 
+  uint64_t generation = 0;
+  if (attrCache_) {
+    if (auto attr = attrCache_->get(args.object.ino)) {
+      GETATTR3res res{{{nfsstat3::NFS3_OK, GETATTR3resok{std::move(*attr)}}}};
+      XdrTrait<GETATTR3res>::serialize(ser, res);
+      return folly::unit;
+    }
+    generation = attrCache_->getGeneration();
+  }
+
   return dispatcher_->getattr(args.object.ino, context)
-      .thenTry(
-          [ser = std::move(ser)](const folly::Try<struct stat>& try_) mutable {
-            if (try_.hasException()) {
-              GETATTR3res res{
-                  {{exceptionToNfsError(try_.exception()), std::monostate{}}}};
-              XdrTrait<GETATTR3res>::serialize(ser, res);
-            } else {
-              const auto& stat = try_.value();
-
-              GETATTR3res res{
-                  {{nfsstat3::NFS3_OK, GETATTR3resok{statToFattr3(stat)}}}};
-              XdrTrait<GETATTR3res>::serialize(ser, res);
-            }
+      .thenTry([ser = std::move(ser),
+                ino = args.object.ino,
+                generation,
+                attrCache = attrCache_](
+                   const folly::Try<struct stat>& try_) mutable {
+        if (try_.hasException()) {
+          GETATTR3res res{
+              {{exceptionToNfsError(try_.exception()), std::monostate{}}}};
+          XdrTrait<GETATTR3res>::serialize(ser, res);
+        } else {
+          auto attr = statToFattr3(try_.value());
+          if (attrCache) {
+            attrCache->insert(ino, attr, generation);
+          }
 
-            return folly::unit;
-          });
+          GETATTR3res res{{{nfsstat3::NFS3_OK, GETATTR3resok{attr}}}};
+          XdrTrait<GETATTR3res>::serialize(ser, res);
+        }
+
+        return folly::unit;
+      });
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::setattr(
@@ -719,11 +754,13 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::read(
 /**
  * Generate a unique per-EdenFS instance write cookie.
  *
- * TODO(xavierd): Note that for now this will always be 0 as this is to handle
- * the case where the server restart while the client isn't aware.
+ * Clients keep the data of UNSTABLE writes until a COMMIT returns the same
+ * cookie as the writes did. A restarted EdenFS returns a different one, and
+ * clients then resend the writes that may have been lost.
  */
 writeverf3 makeWriteVerf() {
-  return 0;
+  static const writeverf3 verf = folly::Random::rand64();
+  return verf;
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
@@ -741,7 +778,7 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
 
   return dispatcher_
       ->write(args.file.ino, std::move(data), args.offset, context)
-      .thenTry([ser = std::move(ser)](
+      .thenTry([ser = std::move(ser), stable = args.stable](
                    folly::Try<NfsDispatcher::WriteRes> writeTry) mutable {
         if (writeTry.hasException()) {
           WRITE3res res{
@@ -762,12 +799,13 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
                     /*file_wcc*/ statToWccData(
                         writeRes.preStat, writeRes.postStat),
                     /*count*/ folly::to_narrow(writeRes.written),
-                    // TODO(xavierd): the following is a total lie and we
-                    // should call inode->fdatasync() in the case where
-                    // args.stable is anything other than
-                    // stable_how::UNSTABLE. For testing purpose, this is
-                    // OK.
-                    /*committed*/ stable_how::FILE_SYNC,
+                    // UNSTABLE writes are made stable by the COMMIT that the
+                    // client sends later. TODO(xavierd): for the others, the
+                    // following is a lie and we should call
+                    // inode->fdatasync().
+                    /*committed*/ stable == stable_how::UNSTABLE
+                        ? stable_how::UNSTABLE
+                        : stable_how::FILE_SYNC,
                     /*verf*/ makeWriteVerf(),
                 }}}};
           XdrTrait<WRITE3res>::serialize(ser, res);
@@ -1211,33 +1249,6 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::link(
           });
 }
 
-/**
- * Verify that the passed in cookie verifier is valid.
- *
- * The verifier allows the server to know whether the directory was modified
- * across readdir calls, and to restart if this is the case.
- *
- * TODO(xavierd): For now, this only checks that the verifier is 0, in the
- * future, we may want to compare it against a global counter that is
- * incremented for each update operations. The assumption being that: "The
- * client should be careful to avoid holding directory entry cookies across
- * operations that modify the directory contents, such as REMOVE and CREATE.",
- * thus we only need to protect against concurrent update and readdir
- * operations since there is only one client per mount.
- */
-bool isReaddirCookieverfValid(uint64_t verf) {
-  return verf == 0;
-}
-
-/**
- * Return the current global cookie.
- *
- * See the documentation above for the meaning of the cookie verifier.
- */
-uint64_t getReaddirCookieverf() {
-  return 0;
-}
-
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdir(
     folly::io::Cursor deser,
     folly::io::QueueAppender ser,
@@ -1245,13 +1256,12 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdir(
   serializeReply(ser, accept_stat::SUCCESS, context.getXid());
   auto args = XdrTrait<READDIR3args>::deserialize(deser);
 
-  if (!isReaddirCookieverfValid(args.cookieverf)) {
-    READDIR3res res{{{nfsstat3::NFS3ERR_BAD_COOKIE, READDIR3resfail{}}}};
-    XdrTrait<READDIR3res>::serialize(ser, res);
-    return folly::unit;
-  }
-
-  return dispatcher_->readdir(args.dir.ino, args.cookie, args.count, context)
+  // The verifier names the listing snapshot that the client is paging
+  // through. Cookies stay valid without it, so it is never rejected with
+  // NFS3ERR_BAD_COOKIE.
+  return dispatcher_
+      ->readdir(
+          args.dir.ino, args.cookie, args.cookieverf, args.count, context)
       .thenTry([this, ino = args.dir.ino, ser = std::move(ser), &context](
                    folly::Try<NfsDispatcher::ReaddirRes> try_) mutable {
         return dispatcher_->getattr(ino, context)
@@ -1269,7 +1279,7 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdir(
                     {{nfsstat3::NFS3_OK,
                       READDIR3resok{
                           /*dir_attributes*/ statToPostOpAttr(tryStat),
-                          /*cookieverf*/ getReaddirCookieverf(),
+                          /*cookieverf*/ readdirRes.cookieverf,
                           /*reply*/
                           dirlist3{
                               /*entries*/ readdirRes.entries.extractList(),
@@ -1283,11 +1293,58 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdir(
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdirplus(
-    folly::io::Cursor /*deser*/,
+    folly::io::Cursor deser,
     folly::io::QueueAppender ser,
     NfsRequestContext& context) {
-  serializeReply(ser, accept_stat::PROC_UNAVAIL, context.getXid());
-  return folly::unit;
+  serializeReply(ser, accept_stat::SUCCESS, context.getXid());
+  auto args = XdrTrait<READDIRPLUS3args>::deserialize(deser);
+
+  return dispatcher_
+      ->readdirplus(
+          args.dir.ino,
+          args.cookie,
+          args.cookieverf,
+          args.dircount,
+          args.maxcount,
+          context)
+      .thenTry([this, ino = args.dir.ino, ser = std::move(ser), &context](
+                   folly::Try<NfsDispatcher::ReaddirPlusRes> try_) mutable {
+        return dispatcher_->getattr(ino, context)
+            .thenTry([ser = std::move(ser), try_ = std::move(try_)](
+                         const folly::Try<struct stat>& tryStat) mutable {
+              if (try_.hasException()) {
+                READDIRPLUS3res res{
+                    {{exceptionToNfsError(try_.exception()),
+                      READDIRPLUS3resfail{statToPostOpAttr(tryStat)}}}};
+                XdrTrait<READDIRPLUS3res>::serialize(ser, res);
+              } else {
+                auto& readdirRes = try_.value();
+
+                auto entries = readdirRes.entries.extractList();
+                XCHECK_EQ(
+                    entries.list.size(), readdirRes.attributes.size());
+                for (size_t i = 0; i < entries.list.size(); ++i) {
+                  // Attributes are optional in READDIRPLUS, an entry whose
+                  // stat failed is still returned, without them.
+                  entries.list[i].name_attributes =
+                      statToPostOpAttr(readdirRes.attributes[i]);
+                }
+
+                READDIRPLUS3res res{
+                    {{nfsstat3::NFS3_OK,
+                      READDIRPLUS3resok{
+                          /*dir_attributes*/ statToPostOpAttr(tryStat),
+                          /*cookieverf*/ readdirRes.cookieverf,
+                          /*reply*/
+                          dirlistplus3{
+                              /*entries*/ std::move(entries),
+                              /*eof*/ readdirRes.isEof,
+                          }}}}};
+                XdrTrait<READDIRPLUS3res>::serialize(ser, res);
+              }
+              return folly::unit;
+            });
+      });
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::fsstat(
@@ -1388,11 +1445,35 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::pathconf(
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::commit(
-    folly::io::Cursor /*deser*/,
+    folly::io::Cursor deser,
     folly::io::QueueAppender ser,
     NfsRequestContext& context) {
-  serializeReply(ser, accept_stat::PROC_UNAVAIL, context.getXid());
-  return folly::unit;
+  serializeReply(ser, accept_stat::SUCCESS, context.getXid());
+  auto args = XdrTrait<COMMIT3args>::deserialize(deser);
+
+  // The whole file is committed, regardless of args.offset and args.count:
+  // syncing a range isn't any cheaper for the overlay.
+  return dispatcher_->commit(args.file.ino, context)
+      .thenTry([ser = std::move(ser)](
+                   folly::Try<NfsDispatcher::CommitRes> commitTry) mutable {
+        if (commitTry.hasException()) {
+          COMMIT3res res{
+              {{exceptionToNfsError(commitTry.exception()), COMMIT3resfail{}}}};
+          XdrTrait<COMMIT3res>::serialize(ser, res);
+        } else {
+          const auto& commitRes = commitTry.value();
+          COMMIT3res res{
+              {{nfsstat3::NFS3_OK,
+                COMMIT3resok{
+                    /*file_wcc*/ statToWccData(
+                        commitRes.preStat, commitRes.postStat),
+                    /*verf*/ makeWriteVerf(),
+                }}}};
+          XdrTrait<COMMIT3res>::serialize(ser, res);
+        }
+
+        return folly::unit;
+      });
 }
 
 NfsArgsDetails formatNull(folly::io::Cursor /*deser*/) {
@@ -1665,9 +1746,15 @@ NfsArgsDetails formatPathconf(folly::io::Cursor deser) {
   return {fmt::format(FMT_STRING("ino={}"), args.object.ino), args.object.ino};
 }
 
-NfsArgsDetails formatCommit(folly::io::Cursor /*deser*/) {
-  // TODO(xavierd): Fill this in.
-  return {""};
+NfsArgsDetails formatCommit(folly::io::Cursor deser) {
+  auto args = XdrTrait<COMMIT3args>::deserialize(deser);
+  return {
+      fmt::format(
+          FMT_STRING("ino={}, offset={}, count={}"),
+          args.file.ino,
+          args.offset,
+          args.count),
+      args.file.ino};
 }
 
 using Handler = ImmediateFuture<folly::Unit> (Nfsd3ServerProcessor::*)(
@@ -1931,10 +2018,49 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::dispatchRpc(
   // handler function and is deleted when context unique_ptr goes out of the
   // scope at the `ensure` lambda.
   auto& contextRef = *context;
+  auto args = deser;
   return (this->*handlerEntry.handler)(
              std::move(deser), std::move(ser), contextRef)
-      .ensure([liveRequest = std::move(liveRequest),
-               context = std::move(context)]() { context->finishRequest(); });
+      .ensure([this,
+               procNumber,
+               args = std::move(args),
+               liveRequest = std::move(liveRequest),
+               context = std::move(context)]() {
+        invalidateCachedAttrs(procNumber, std::move(args));
+        context->finishRequest();
+      });
+}
+
+void Nfsd3ServerProcessor::invalidateCachedAttrs(
+    uint32_t procNumber,
+    folly::io::Cursor args) {
+  if (!attrCache_) {
+    return;
+  }
+  switch (static_cast<nfsv3Procs>(procNumber)) {
+    case nfsv3Procs::setattr:
+    case nfsv3Procs::read:
+    case nfsv3Procs::write:
+    case nfsv3Procs::create:
+    case nfsv3Procs::mkdir:
+    case nfsv3Procs::symlink:
+    case nfsv3Procs::mknod:
+      // The arguments of these start with the handle of the only existing
+      // inode they change: the file itself, or the directory an entry is
+      // added to. READ updates the atime.
+      attrCache_->invalidate(XdrTrait<nfs_fh3>::deserialize(args).ino);
+      break;
+    case nfsv3Procs::remove:
+    case nfsv3Procs::rmdir:
+    case nfsv3Procs::rename:
+    case nfsv3Procs::link:
+      // These also change the link count or ctime of inodes that aren't
+      // passed by handle.
+      attrCache_->invalidateAll();
+      break;
+    default:
+      break;
+  }
 }
 
 void Nfsd3ServerProcessor::onSocketClosed() {
@@ -1955,8 +2081,13 @@ Nfsd3::Nfsd3(
     folly::Duration /*requestTimeout*/,
     Notifications* /*notifications*/,
     CaseSensitivity caseSensitive,
-    uint32_t iosize)
-    : server_(
+    uint32_t iosize,
+    uint64_t maxInflightRequestsPerConnection,
+    size_t attrCacheSize)
+    : attrCache_{
+          attrCacheSize ? std::make_unique<NfsAttrCache>(attrCacheSize)
+                        : nullptr},
+      server_(
           std::make_shared<Nfsd3ServerProcessor>(
               std::move(dispatcher),
               straceLogger,
@@ -1965,15 +2096,20 @@ Nfsd3::Nfsd3(
               stopPromise_,
               processAccessLog_,
               traceDetailedArguments_,
-              traceBus_),
+              traceBus_,
+              attrCache_.get()),
           evb,
-          std::move(threadPool)),
+          std::move(threadPool),
+          maxInflightRequestsPerConnection),
       processAccessLog_(std::move(processNameCache)),
       invalidationExecutor_{
           folly::SerialExecutor::create(folly::getGlobalCPUExecutor())},
       traceDetailedArguments_{0},
       traceBus_{
-          TraceBus<NfsTraceEvent>::create("NfsTrace", kTraceBusCapacity)} {
+          TraceBus<NfsTraceEvent>::create(
+              "NfsTrace",
+              kTraceBusCapacity,
+              TraceBusOverflow::Drop)} {
   traceSubscriptionHandles_.push_back(traceBus_->subscribeFunction(
       "NFS request tracking",
       [this,
@@ -1981,6 +2117,12 @@ Nfsd3::Nfsd3(
         switch (event.getType()) {
           case NfsTraceEvent::START: {
             auto state = telemetryState_.wlock();
+            if (state->requests.size() >= kMaxTrackedRequests) {
+              XLOG(WARN) << "forgetting " << state->requests.size()
+                         << " outstanding NFS requests, whose FINISH trace "
+                         << "events were probably dropped";
+              state->requests.clear();
+            }
             // NFS client is allowed to retry requests and emplace could
             // therefore fail. We just ignore duplicated requests.
             (void)state->requests.emplace(
@@ -1994,7 +2136,8 @@ Nfsd3::Nfsd3(
               auto state = telemetryState_.wlock();
               auto it = state->requests.find(event.getXid());
               if (it == state->requests.end()) {
-                // Duplicated request, break early.
+                // Duplicated request, or its START event was dropped, break
+                // early.
                 break;
               }
               durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
@@ -2024,6 +2167,9 @@ void Nfsd3::initialize(folly::SocketAddress addr, bool registerWithRpcbind) {
 }
 
 void Nfsd3::invalidate(AbsolutePath path) {
+  if (attrCache_) {
+    attrCache_->invalidateAll();
+  }
   invalidationExecutor_->add([path = std::move(path)]() {
     try {
       folly::File(path.c_str());
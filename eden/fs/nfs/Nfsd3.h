@@ -11,6 +11,12 @@
 
 // Implementation of the NFSv3 protocol as described in:
 // https://tools.ietf.org/html/rfc1813
+//
+// Only NFSv3 is served. NFSv4.1 would allow COMPOUND requests and
+// delegations, but the macOS NFS client, the only user of this server, does
+// not implement NFSv4.1. Within NFSv3, LOOKUP replies carry the attributes of
+// both the entry and its directory, and READDIRPLUS those of every entry, to
+// spare the client the GETATTR that would otherwise follow.
 
 #include "eden/fs/nfs/NfsDispatcher.h"
 #include "eden/fs/nfs/rpc/Server.h"
@@ -24,6 +30,7 @@ class Executor;
 
 namespace facebook::eden {
 
+class NfsAttrCache;
 class Notifications;
 class ProcessNameCache;
 class FsEventLogger;
@@ -135,7 +142,9 @@ class Nfsd3 {
       folly::Duration requestTimeout,
       Notifications* FOLLY_NULLABLE notifications,
       CaseSensitivity caseSensitive,
-      uint32_t iosize);
+      uint32_t iosize,
+      uint64_t maxInflightRequestsPerConnection,
+      size_t attrCacheSize);
 
   /**
    * This is triggered when the kernel closes the socket. The socket is closed
@@ -159,6 +168,9 @@ class Nfsd3 {
    * both the kernel and EdenFS are holding locks that would otherwise cause
    * EdenFS to deadlock. The flushInvalidations method below should be called
    * with all the locks released to wait for all the invalidation to complete.
+   *
+   * The GETATTR replies cached by EdenFS itself are all dropped, since the
+   * path doesn't say which inodes changed.
    */
   void invalidate(AbsolutePath path);
 
@@ -223,6 +235,9 @@ class Nfsd3 {
   std::vector<TraceSubscriptionHandle<NfsTraceEvent>> traceSubscriptionHandles_;
 
   folly::Promise<StopData> stopPromise_;
+  // Null when the attribute cache is disabled. Must be constructed before the
+  // server_, which refers to it.
+  std::unique_ptr<NfsAttrCache> attrCache_;
   RpcServer server_;
   ProcessAccessLog processAccessLog_;
   folly::Executor::KeepAlive<folly::Executor> invalidationExecutor_;
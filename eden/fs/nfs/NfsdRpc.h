@@ -906,6 +906,29 @@ EDEN_XDR_SERDE_DECL(PATHCONF3resfail, obj_attributes);
 struct PATHCONF3res
     : public detail::Nfsstat3Variant<PATHCONF3resok, PATHCONF3resfail> {};
 
+// COMMIT Procedure:
+
+struct COMMIT3args {
+  nfs_fh3 file;
+  uint64_t offset;
+  uint32_t count;
+};
+EDEN_XDR_SERDE_DECL(COMMIT3args, file, offset, count);
+
+struct COMMIT3resok {
+  wcc_data file_wcc;
+  writeverf3 verf;
+};
+EDEN_XDR_SERDE_DECL(COMMIT3resok, file_wcc, verf);
+
+struct COMMIT3resfail {
+  wcc_data file_wcc;
+};
+EDEN_XDR_SERDE_DECL(COMMIT3resfail, file_wcc);
+
+struct COMMIT3res
+    : public detail::Nfsstat3Variant<COMMIT3resok, COMMIT3resfail> {};
+
 } // namespace facebook::eden
 
 #endif
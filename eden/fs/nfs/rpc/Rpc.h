@@ -78,7 +78,11 @@ enum class auth_stat {
   RPCSEC_GSS_CTXPROBLEM = 14 /* problem with context */
 };
 
-using OpaqueBytes = std::vector<uint8_t>;
+/**
+ * Authentication bodies are deserialized as views into the request buffer,
+ * which is kept alive until the reply has been sent.
+ */
+using OpaqueBytes = XdrOpaqueView;
 
 struct opaque_auth {
   auth_flavor flavor;
@@ -16,6 +16,8 @@
 #include <folly/io/async/AsyncSocket.h>
 #include <tuple>
 
+#include "eden/fs/utils/IOBufPool.h"
+
 using folly::AsyncServerSocket;
 using folly::AsyncSocket;
 using folly::Future;
@@ -26,6 +28,19 @@ namespace facebook {
 namespace eden {
 
 namespace {
+/**
+ * Upper bound of a single read from the socket when the rest of a large
+ * request, like a WRITE of the configured NFS iosize, is known to be pending.
+ */
+constexpr size_t kMaxFragmentReadSize = 4 * 1024 * 1024;
+
+/**
+ * The default buffers of unix domain sockets are small (8KiB on macOS), which
+ * caps the throughput of large READ and WRITE far below that of loopback TCP,
+ * whose buffers are tuned by the kernel.
+ */
+constexpr int kUnixSocketBufferSize = 2 * 1024 * 1024;
+
 class RpcTcpHandler : public folly::DelayedDestruction {
  public:
   using UniquePtr =
@@ -49,10 +64,12 @@ class RpcTcpHandler : public folly::DelayedDestruction {
   RpcTcpHandler(
       std::shared_ptr<RpcServerProcessor> proc,
       AsyncSocket::UniquePtr&& socket,
-      std::shared_ptr<folly::Executor> threadPool)
+      std::shared_ptr<folly::Executor> threadPool,
+      uint64_t maxInflightRequests)
       : proc_(proc),
         sock_(std::move(socket)),
         threadPool_(std::move(threadPool)),
+        maxInflightRequests_(std::max(maxInflightRequests, uint64_t{1})),
         reader_(std::make_unique<Reader>(this)) {
     sock_->setReadCB(reader_.get());
   }
@@ -64,18 +81,23 @@ class RpcTcpHandler : public folly::DelayedDestruction {
 
    private:
     void getReadBuffer(void** bufP, size_t* lenP) override {
-      // TODO(xavierd): Should maxSize be configured to be at least the
-      // configured NFS iosize?
-      constexpr size_t maxSize = 64 * 1024;
+      constexpr size_t defaultAllocationSize = 64 * 1024;
       constexpr size_t minReadSize = 4 * 1024;
 
       // We want to issue a recv(2) of at least minReadSize, and bound it to
       // the available writable size of the readBuf_ to minimize allocation
       // cost. This guarantees reading large buffers, and minimize the number
       // of calls to tryConsumeReadBuffer.
-      auto minSize = std::max(handler_->readBuf_.tailroom(), minReadSize);
-
-      auto [buf, len] = handler_->readBuf_.preallocate(minSize, maxSize);
+      //
+      // When a partially read request is larger than that, read the rest of
+      // it at once instead of in defaultAllocationSize chunks.
+      auto missing = handler_->missingRequestBytes_;
+      auto minSize =
+          std::max({handler_->readBuf_.tailroom(), minReadSize, missing});
+      auto allocationSize = std::max(defaultAllocationSize, missing);
+
+      auto [buf, len] =
+          handler_->readBuf_.preallocate(minSize, allocationSize);
       *lenP = len;
       *bufP = buf;
     }
@@ -133,6 +155,13 @@ class RpcTcpHandler : public folly::DelayedDestruction {
    */
   void tryConsumeReadBuffer() noexcept;
 
+  /**
+   * Called on the EventBase once the reply to a request has been handed to
+   * the socket. Resumes reading if it was paused because too many requests
+   * were in flight.
+   */
+  void requestCompleted() noexcept;
+
   /**
    * Delete the reader, called when the socket is closed.
    */
@@ -166,6 +195,21 @@ class RpcTcpHandler : public folly::DelayedDestruction {
   std::shared_ptr<RpcServerProcessor> proc_;
   AsyncSocket::UniquePtr sock_;
   std::shared_ptr<folly::Executor> threadPool_;
+
+  // Requests are dispatched as soon as they are read and replied to in
+  // completion order, so a slow request doesn't hold back the ones behind it.
+  // To keep one busy connection from filling the shared thread pool queue,
+  // which blocks the EventBase once full, reading from the socket is paused
+  // while maxInflightRequests_ requests are in flight. Only accessed on the
+  // EventBase.
+  const uint64_t maxInflightRequests_;
+  uint64_t inflightRequests_{0};
+  bool readPaused_{false};
+
+  // Number of bytes that the last incomplete request in readBuf_ still needs,
+  // bounded by kMaxFragmentReadSize. Only accessed on the EventBase.
+  size_t missingRequestBytes_{0};
+
   std::unique_ptr<Reader> reader_;
   Writer writer_{};
   folly::IOBufQueue readBuf_{folly::IOBufQueue::cacheChainLength()};
@@ -175,10 +219,24 @@ void RpcTcpHandler::tryConsumeReadBuffer() noexcept {
   // Iterate over all the complete fragments and dispatch these to the
   // threadPool_.
   while (true) {
+    if (inflightRequests_ >= maxInflightRequests_) {
+      // Leave the remaining requests in readBuf_ and stop reading, the
+      // client will be pushed back on by TCP flow control until some of the
+      // in flight requests complete.
+      if (!readPaused_ && reader_) {
+        XLOG(DBG4) << "pausing reads with " << inflightRequests_
+                   << " requests in flight";
+        sock_->setReadCB(nullptr);
+        readPaused_ = true;
+      }
+      break;
+    }
+
     auto buf = readOneRequest();
     if (!buf) {
       break;
     }
+    ++inflightRequests_;
 
     // Send the work to a thread pool to increase the number of inflight
     // requests that can be handled concurrently.
@@ -217,6 +275,9 @@ std::unique_ptr<folly::IOBuf> RpcTcpHandler::readOneRequest() noexcept {
     bool isLast = (fragmentHeader & 0x80000000) != 0;
     if (!c.canAdvance(len)) {
       // we don't have a complete request, so try again later
+      auto needed = c.getCurrentPosition() + len;
+      missingRequestBytes_ = std::min(
+          needed - readBuf_.chainLength(), kMaxFragmentReadSize);
       return nullptr;
     }
     c.skip(len);
@@ -224,9 +285,23 @@ std::unique_ptr<folly::IOBuf> RpcTcpHandler::readOneRequest() noexcept {
       break;
     }
   }
+  missingRequestBytes_ = 0;
   return readBuf_.split(c.getCurrentPosition());
 }
 
+void RpcTcpHandler::requestCompleted() noexcept {
+  XDCHECK_GT(inflightRequests_, 0u);
+  --inflightRequests_;
+  if (readPaused_ && inflightRequests_ < maxInflightRequests_) {
+    readPaused_ = false;
+    if (reader_) {
+      sock_->setReadCB(reader_.get());
+    }
+    // Dispatch what was already read before asking for more.
+    tryConsumeReadBuffer();
+  }
+}
+
 namespace {
 void serializeRpcMismatch(folly::io::QueueAppender& ser, uint32_t xid) {
   rpc_msg_reply reply{
@@ -263,6 +338,19 @@ void serializeAuthError(
   XdrTrait<rpc_msg_reply>::serialize(ser, reply);
 }
 
+/**
+ * Returns an empty queue to serialize a reply into. Its first buffer comes
+ * from the reply pool and is recycled once the reply is written, and a page
+ * fits most replies whole.
+ */
+std::unique_ptr<folly::IOBufQueue> makeReplyQueue() {
+  auto iobufQueue = std::make_unique<folly::IOBufQueue>(
+      folly::IOBufQueue::cacheChainLength());
+  iobufQueue->append(
+      IOBufPool::getReplyPool().allocate(IOBufPool::getPageSize()));
+  return iobufQueue;
+}
+
 /**
  * Make an RPC fragment by computing the size of the iobufQueue.
  *
@@ -291,8 +379,7 @@ void RpcTcpHandler::dispatchAndReply(
     folly::io::Cursor deser(input.get());
     rpc_msg_call call = XdrTrait<rpc_msg_call>::deserialize(deser);
 
-    auto iobufQueue = std::make_unique<folly::IOBufQueue>(
-        folly::IOBufQueue::cacheChainLength());
+    auto iobufQueue = makeReplyQueue();
     folly::io::QueueAppender ser(iobufQueue.get(), 1024);
     XdrTrait<uint32_t>::serialize(ser, 0); // reserve space for fragment header
 
@@ -357,6 +444,7 @@ void RpcTcpHandler::dispatchAndReply(
           auto resultBuffer = std::move(result).value();
           sock_->writeChain(&writer_, std::move(resultBuffer));
         }
+        requestCompleted();
       });
 }
 
@@ -368,7 +456,15 @@ void RpcServer::RpcAcceptCallback::connectionAccepted(
     AcceptInfo /* info */) noexcept {
   XLOG(DBG7) << "Accepted connection from: " << clientAddr;
   auto socket = AsyncSocket::newSocket(evb_, fd);
-  auto handler = RpcTcpHandler::create(proc_, std::move(socket), threadPool_);
+  if (clientAddr.getFamily() == AF_UNIX) {
+    if (socket->setSendBufSize(kUnixSocketBufferSize) != 0 ||
+        socket->setRecvBufSize(kUnixSocketBufferSize) != 0) {
+      XLOG(WARN) << "Couldn't grow the socket buffers: "
+                 << folly::errnoStr(errno);
+    }
+  }
+  auto handler = RpcTcpHandler::create(
+      proc_, std::move(socket), threadPool_, maxInflightRequests_);
 }
 
 void RpcServer::RpcAcceptCallback::acceptError(
@@ -404,10 +500,14 @@ void RpcServerProcessor::onSocketClosed() {}
 RpcServer::RpcServer(
     std::shared_ptr<RpcServerProcessor> proc,
     folly::EventBase* evb,
-    std::shared_ptr<folly::Executor> threadPool)
+    std::shared_ptr<folly::Executor> threadPool,
+    uint64_t maxInflightRequestsPerConnection)
     : evb_(evb),
-      acceptCb_(
-          new RpcServer::RpcAcceptCallback(proc, evb_, std::move(threadPool))),
+      acceptCb_(new RpcServer::RpcAcceptCallback(
+          proc,
+          evb_,
+          std::move(threadPool),
+          maxInflightRequestsPerConnection)),
       serverSocket_(new AsyncServerSocket(evb_)) {}
 
 void RpcServer::initialize(folly::SocketAddress addr) {
@@ -42,12 +42,16 @@ class RpcServer {
    * Create an RPC server.
    *
    * Request will be received on the passed EventBase and dispatched to the
-   * RpcServerProcessor on the passed in threadPool.
+   * RpcServerProcessor on the passed in threadPool, and are replied to as
+   * they complete, in any order. Once a connection has
+   * maxInflightRequestsPerConnection requests in flight, no more requests are
+   * read from it until one of them completes.
    */
   RpcServer(
       std::shared_ptr<RpcServerProcessor> proc,
       folly::EventBase* evb,
-      std::shared_ptr<folly::Executor> threadPool);
+      std::shared_ptr<folly::Executor> threadPool,
+      uint64_t maxInflightRequestsPerConnection);
   ~RpcServer();
 
   /**
@@ -76,13 +80,15 @@ class RpcServer {
     using UniquePtr = std::
         unique_ptr<RpcAcceptCallback, folly::DelayedDestruction::Destructor>;
 
-    explicit RpcAcceptCallback(
+    RpcAcceptCallback(
         std::shared_ptr<RpcServerProcessor> proc,
         folly::EventBase* evb,
-        std::shared_ptr<folly::Executor> threadPool)
+        std::shared_ptr<folly::Executor> threadPool,
+        uint64_t maxInflightRequests)
         : evb_(evb),
           proc_(proc),
           threadPool_(std::move(threadPool)),
+          maxInflightRequests_(maxInflightRequests),
           guard_(this) {}
 
    private:
@@ -100,6 +106,7 @@ class RpcServer {
     folly::EventBase* evb_;
     std::shared_ptr<RpcServerProcessor> proc_;
     std::shared_ptr<folly::Executor> threadPool_;
+    uint64_t maxInflightRequests_;
 
     /**
      * Hold a guard to ourself to avoid being deleted until the callback is
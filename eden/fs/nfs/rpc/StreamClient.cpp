@@ -26,7 +26,8 @@ void StreamClient::connect() {
   sockaddr_storage socketAddress;
   auto len = addr_.getAddress(&socketAddress);
 
-  s_ = folly::netops::socket(addr_.getFamily(), SOCK_STREAM, IPPROTO_TCP);
+  s_ = folly::netops::socket(
+      addr_.getFamily(), SOCK_STREAM, addr_.isFamilyInet() ? IPPROTO_TCP : 0);
   folly::checkUnixError(
       folly::netops::connect(s_, (sockaddr*)&socketAddress, len), "connect");
 }
@@ -121,7 +122,8 @@ StreamClient::receiveChunk() {
     }
   }
 
-  auto buf = readBuf_.pop_front();
+  // The reply may span several buffers, and nothing past it has been read.
+  auto buf = readBuf_.move();
   XLOG(DBG8) << "recv:\n" << folly::hexDump(buf->data(), buf->length());
   folly::io::Cursor cursor(buf.get());
 
@@ -8,6 +8,7 @@
 #ifndef _WIN32
 
 #include <folly/portability/GTest.h>
+#include "eden/fs/nfs/DirList.h"
 #include "eden/fs/nfs/NfsdRpc.h"
 #include "eden/fs/nfs/testharness/XdrTestUtils.h"
 
@@ -28,6 +29,29 @@ TEST(DirListTest, size) {
   EXPECT_EQ(computeInitialOverhead(), 104);
 }
 
+TEST(DirListTest, plusListIsBoundedByDircount) {
+  // Each single character entry takes 24 bytes of directory information.
+  NfsDirPlusList list{48, 1024 * 1024};
+  EXPECT_TRUE(list.add("a", InodeNumber{2}, 2));
+  EXPECT_TRUE(list.add("b", InodeNumber{3}, 3));
+  EXPECT_FALSE(list.add("c", InodeNumber{4}, 4));
+  EXPECT_EQ(2, list.getEntries().size());
+}
+
+TEST(DirListTest, plusListIsBoundedByMaxcount) {
+  // With its attributes and file handle, a single character entry takes 132
+  // bytes of the reply.
+  NfsDirPlusList list{1024 * 1024, 104 + 2 * 132};
+  EXPECT_TRUE(list.add("a", InodeNumber{2}, 2));
+  EXPECT_TRUE(list.add("b", InodeNumber{3}, 3));
+  EXPECT_FALSE(list.add("c", InodeNumber{4}, 4));
+
+  auto entries = list.extractList();
+  ASSERT_EQ(2, entries.list.size());
+  EXPECT_EQ(3, entries.list[1].fileid);
+  EXPECT_EQ(3, std::get<nfs_fh3>(entries.list[1].name_handle.v).ino.get());
+}
+
 } // namespace facebook::eden
 
 #endif
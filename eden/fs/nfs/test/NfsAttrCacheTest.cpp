@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/nfs/NfsAttrCache.h"
+
+#include <folly/portability/GTest.h>
+
+namespace facebook::eden {
+
+namespace {
+fattr3 makeAttr(uint64_t size) {
+  fattr3 attr{};
+  attr.type = ftype3::NF3REG;
+  attr.size = size;
+  return attr;
+}
+} // namespace
+
+TEST(NfsAttrCacheTest, insertedAttrsAreReturned) {
+  NfsAttrCache cache{16};
+  EXPECT_EQ(std::nullopt, cache.get(InodeNumber{2}));
+
+  cache.insert(InodeNumber{2}, makeAttr(42), cache.getGeneration());
+  EXPECT_EQ(makeAttr(42), cache.get(InodeNumber{2}));
+  EXPECT_EQ(std::nullopt, cache.get(InodeNumber{3}));
+}
+
+TEST(NfsAttrCacheTest, invalidateDropsAttrs) {
+  NfsAttrCache cache{16};
+  cache.insert(InodeNumber{2}, makeAttr(42), cache.getGeneration());
+  cache.insert(InodeNumber{3}, makeAttr(43), cache.getGeneration());
+
+  cache.invalidate(InodeNumber{2});
+  EXPECT_EQ(std::nullopt, cache.get(InodeNumber{2}));
+  EXPECT_EQ(makeAttr(43), cache.get(InodeNumber{3}));
+
+  cache.invalidateAll();
+  EXPECT_EQ(std::nullopt, cache.get(InodeNumber{3}));
+}
+
+TEST(NfsAttrCacheTest, attrsComputedBeforeInvalidationAreNotCached) {
+  NfsAttrCache cache{16};
+  auto generation = cache.getGeneration();
+  cache.invalidate(InodeNumber{2});
+  cache.insert(InodeNumber{2}, makeAttr(42), generation);
+  EXPECT_EQ(std::nullopt, cache.get(InodeNumber{2}));
+}
+
+TEST(NfsAttrCacheTest, sizeIsBounded) {
+  NfsAttrCache cache{2};
+  for (uint64_t i = 2; i < 5; ++i) {
+    cache.insert(InodeNumber{i}, makeAttr(i), cache.getGeneration());
+  }
+  EXPECT_EQ(std::nullopt, cache.get(InodeNumber{2}));
+  EXPECT_EQ(makeAttr(4), cache.get(InodeNumber{4}));
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -43,6 +43,18 @@ TEST(NfsdRpcTest, variant) {
   roundtrip(var4);
 }
 
+TEST(NfsdRpcTest, commit) {
+  roundtrip(COMMIT3args{nfs_fh3{InodeNumber{42}}, 4096, 8192});
+
+  COMMIT3res ok{
+      {{nfsstat3::NFS3_OK,
+        COMMIT3resok{wcc_data{pre_op_attr{}, post_op_attr{}}, 0x1234}}}};
+  roundtrip(ok);
+
+  COMMIT3res fail{{{nfsstat3::NFS3ERR_IO, COMMIT3resfail{}}}};
+  roundtrip(fail);
+}
+
 } // namespace facebook::eden
 
 #endif
@@ -44,7 +44,13 @@ void serialize_iobuf(
         "XDR cannot encode variable sized array bigger than 4GB");
   }
   XdrTrait<uint32_t>::serialize(appender, folly::to_narrow(len));
-  appender.insert(buf);
+  if (len >= kMinIOBufReferenceSize) {
+    appender.insert(buf);
+  } else {
+    for (auto range : buf) {
+      appender.push(range);
+    }
+  }
   addPadding(appender, len);
 }
 
@@ -201,9 +201,19 @@ void serialize_variable(
     folly::io::QueueAppender& appender,
     folly::ByteRange value);
 
+/**
+ * Chains of at least this many bytes are serialized by reference.
+ */
+constexpr size_t kMinIOBufReferenceSize = 4096;
+
 /**
  * Serialize an IOBuf chain. This is serialized like a variable sized array,
  * ie: size first, followed by the content and aligned on a 4-byte boundary.
+ *
+ * Large chains, like the data of NFS READ replies, are not copied: the chain
+ * is shared with the serialized output and gathered by the socket write.
+ * Smaller ones are copied, which is cheaper than allocating an IOBuf to
+ * reference them and keeps the output contiguous.
  */
 void serialize_iobuf(
     folly::io::QueueAppender& appender,
@@ -381,6 +391,53 @@ struct XdrTrait<std::string> {
   }
 };
 
+/**
+ * A variable sized opaque array that is deserialized without copying.
+ *
+ * Small opaque fields, like the credentials of every RPC call, would each
+ * need a heap allocation to be deserialized into a vector. Instead, `data`
+ * refers to the bytes of the buffer being deserialized, which must thus
+ * outlive this view. When these bytes straddle two buffers of the chain, they
+ * are cloned and coalesced into `storage`, which `data` then refers to.
+ */
+struct XdrOpaqueView {
+  folly::ByteRange data;
+  std::unique_ptr<folly::IOBuf> storage;
+};
+
+inline bool operator==(const XdrOpaqueView& a, const XdrOpaqueView& b) {
+  return a.data == b.data;
+}
+
+template <>
+struct XdrTrait<XdrOpaqueView> {
+  static void serialize(
+      folly::io::QueueAppender& appender,
+      const XdrOpaqueView& value) {
+    detail::serialize_variable(appender, value.data);
+  }
+
+  static XdrOpaqueView deserialize(folly::io::Cursor& cursor) {
+    auto len = XdrTrait<uint32_t>::deserialize(cursor);
+    XdrOpaqueView ret;
+    if (cursor.length() >= len) {
+      ret.data = folly::ByteRange{cursor.data(), len};
+      cursor.skip(len);
+    } else {
+      ret.storage = std::make_unique<folly::IOBuf>();
+      cursor.clone(ret.storage, len);
+      ret.data = ret.storage->coalesce();
+    }
+    detail::skipPadding(cursor, len);
+    return ret;
+  }
+
+  static size_t serializedSize(const XdrOpaqueView& value) {
+    return XdrTrait<uint32_t>::serializedSize(0) +
+        detail::roundUp(value.data.size());
+  }
+};
+
 /**
  * Common implementation for XDR discriminated union. Creating a new variant
  * can be done by doing the following:
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/nfs/xdr/Xdr.h"
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+using namespace facebook::eden;
+
+namespace {
+
+/**
+ * An opaque field of the size of typical AUTH_SYS credentials, which every
+ * NFS request carries.
+ */
+std::unique_ptr<folly::IOBuf> makeEncodedOpaque() {
+  folly::IOBufQueue queue;
+  folly::io::QueueAppender appender(&queue, 1024);
+  std::vector<uint8_t> bytes(84, 0x42);
+  XdrTrait<std::vector<uint8_t>>::serialize(appender, bytes);
+  auto buf = queue.move();
+  buf->coalesce();
+  return buf;
+}
+
+template <typename T>
+void deserialize_opaque(benchmark::State& state) {
+  auto buf = makeEncodedOpaque();
+  for (auto _ : state) {
+    folly::io::Cursor cursor(buf.get());
+    benchmark::DoNotOptimize(XdrTrait<T>::deserialize(cursor));
+  }
+}
+BENCHMARK_TEMPLATE(deserialize_opaque, std::vector<uint8_t>);
+BENCHMARK_TEMPLATE(deserialize_opaque, XdrOpaqueView);
+
+} // namespace
+
+#endif
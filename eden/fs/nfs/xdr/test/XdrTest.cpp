@@ -139,6 +139,65 @@ TEST(XdrSerialize, iobuf) {
   roundtrip(std::move(buf));
 }
 
+TEST(XdrSerialize, largeIOBufIsNotCopied) {
+  // Not a multiple of 4 so that padding is needed.
+  auto data = folly::IOBuf::create(detail::kMinIOBufReferenceSize + 1);
+  data->append(detail::kMinIOBufReferenceSize + 1);
+  memset(data->writableData(), 'a', data->length());
+  auto dataPtr = data->data();
+
+  struct IOBufStruct buf {
+    42, std::move(data), 10
+  };
+  auto encoded = ser(buf);
+
+  bool shared = false;
+  for (auto range : *encoded) {
+    shared |= range.data() == dataPtr;
+  }
+  EXPECT_TRUE(shared);
+
+  roundtrip(std::move(buf));
+}
+
+TEST(XdrSerialize, opaqueViewRefersToInput) {
+  std::vector<uint8_t> bytes{1, 2, 3, 4, 5};
+  auto encoded = ser(bytes);
+  encoded->coalesce();
+
+  folly::io::Cursor cursor(encoded.get());
+  auto view = XdrTrait<XdrOpaqueView>::deserialize(cursor);
+  EXPECT_TRUE(cursor.isAtEnd());
+  EXPECT_EQ(view.data, folly::ByteRange(folly::range(bytes)));
+  EXPECT_EQ(view.data.data(), encoded->data() + sizeof(uint32_t));
+  EXPECT_EQ(view.storage, nullptr);
+
+  EXPECT_EQ(
+      XdrTrait<XdrOpaqueView>::serializedSize(view),
+      XdrTrait<std::vector<uint8_t>>::serializedSize(bytes));
+  auto reencoded = ser(view);
+  EXPECT_TRUE(folly::IOBufEqualTo()(encoded, reencoded));
+}
+
+TEST(XdrSerialize, opaqueViewCopiesAcrossBuffers) {
+  std::vector<uint8_t> bytes{1, 2, 3, 4, 5};
+  auto buf = ser(bytes);
+  auto encoded = buf->coalesce();
+
+  // Split the opaque bytes over two buffers of the chain.
+  auto chain = folly::IOBuf::copyBuffer(encoded.data(), 6);
+  chain->appendChain(
+      folly::IOBuf::copyBuffer(encoded.data() + 6, encoded.size() - 6));
+  buf.reset();
+
+  folly::io::Cursor cursor(chain.get());
+  auto view = XdrTrait<XdrOpaqueView>::deserialize(cursor);
+  EXPECT_TRUE(cursor.isAtEnd());
+  EXPECT_NE(view.storage, nullptr);
+  chain.reset();
+  EXPECT_EQ(view.data, folly::ByteRange(folly::range(bytes)));
+}
+
 struct ListElement {
   uint32_t value;
 };
@@ -9,6 +9,10 @@
 
 #include "eden/fs/prjfs/PrjfsChannel.h"
 #include <fmt/format.h>
+#include <algorithm>
+#include <folly/executors/GlobalExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <folly/io/Cursor.h>
 #include <folly/logging/xlog.h>
 #include "eden/fs/prjfs/PrjfsDispatcher.h"
 #include "eden/fs/prjfs/PrjfsRequestContext.h"
@@ -419,11 +423,20 @@ struct PrjAlignedBufferDeleter {
 HRESULT readMultipleFileChunks(
     PRJ_NAMESPACE_VIRTUALIZATION_CONTEXT namespaceVirtualizationContext,
     const Guid& dataStreamId,
-    const std::string& content,
+    const folly::IOBuf& content,
     uint64_t startOffset,
     uint64_t length,
     uint64_t chunkSize) {
   HRESULT result;
+  uint64_t contentLength = content.computeChainDataLength();
+  if (startOffset >= contentLength) {
+    return S_OK;
+  }
+  uint64_t remainingLength = std::min(length, contentLength - startOffset);
+  chunkSize = std::min(chunkSize, remainingLength);
+
+  // A single buffer is allocated for the whole request and reused for every
+  // chunk.
   std::unique_ptr<void, PrjAlignedBufferDeleter> writeBuffer{
       PrjAllocateAlignedBuffer(namespaceVirtualizationContext, chunkSize)};
 
@@ -431,7 +444,10 @@ HRESULT readMultipleFileChunks(
     return E_OUTOFMEMORY;
   }
 
-  uint64_t remainingLength = length;
+  // The content may share the memory of a cached blob: only the requested
+  // range is copied out of it.
+  folly::io::Cursor cursor{&content};
+  cursor.skip(startOffset);
 
   while (remainingLength > 0) {
     uint64_t copySize = std::min(remainingLength, chunkSize);
@@ -441,10 +457,7 @@ HRESULT readMultipleFileChunks(
     // contents, we can read the chunks of large files here and then write
     // them to FS.
     //
-    // TODO(puneetk): Build an interface to backing store so that we can pass
-    // the aligned buffer to avoid coping here.
-    //
-    RtlCopyMemory(writeBuffer.get(), content.data() + startOffset, copySize);
+    cursor.pull(writeBuffer.get(), copySize);
 
     // Write the data to the file in the local file system.
     result = PrjWriteFileData(
@@ -468,7 +481,7 @@ HRESULT readMultipleFileChunks(
 HRESULT readSingleFileChunk(
     PRJ_NAMESPACE_VIRTUALIZATION_CONTEXT namespaceVirtualizationContext,
     const Guid& dataStreamId,
-    const std::string& content,
+    const folly::IOBuf& content,
     uint64_t startOffset,
     uint64_t length) {
   return readMultipleFileChunks(
@@ -520,7 +533,8 @@ HRESULT PrjfsChannelInner::getFileData(
                         virtualizationContext = virtualizationContext,
                         dataStreamId = std::move(dataStreamId),
                         byteOffset = byteOffset,
-                        length = length](const std::string content) {
+                        length = length](
+                           std::unique_ptr<folly::IOBuf> content) {
               //
               // We should return file data which is smaller than
               // our kMaxChunkSize and meets the memory alignment
@@ -529,16 +543,17 @@ HRESULT PrjfsChannelInner::getFileData(
               //
 
               HRESULT result;
-              if (content.length() <= kMinChunkSize) {
+              auto contentLength = content->computeChainDataLength();
+              if (contentLength <= kMinChunkSize) {
                 //
                 // If the file is small - copy the whole file in one shot.
                 //
                 result = readSingleFileChunk(
                     virtualizationContext,
                     dataStreamId,
-                    content,
+                    *content,
                     /*startOffset=*/0,
-                    /*writeLength=*/content.length());
+                    /*writeLength=*/contentLength);
 
               } else if (length <= kMaxChunkSize) {
                 //
@@ -548,7 +563,7 @@ HRESULT PrjfsChannelInner::getFileData(
                 result = readSingleFileChunk(
                     virtualizationContext,
                     dataStreamId,
-                    content,
+                    *content,
                     /*startOffset=*/byteOffset,
                     /*writeLength=*/length);
               } else {
@@ -571,7 +586,7 @@ HRESULT PrjfsChannelInner::getFileData(
                   result = readMultipleFileChunks(
                       virtualizationContext,
                       dataStreamId,
-                      content,
+                      *content,
                       /*startOffset=*/startOffset,
                       /*length=*/length,
                       /*chunkSize=*/chunkSize);
@@ -812,6 +827,30 @@ HRESULT PrjfsChannelInner::notification(
     auto relPath = RelativePath(callbackData->FilePathName);
     auto destPath = RelativePath(destinationFileName);
 
+    if (notificationType != PRJ_NOTIFICATION_PRE_RENAME &&
+        notificationType != PRJ_NOTIFICATION_PRE_SET_HARDLINK) {
+      // The other notifications are sent after the change has been made on
+      // disk, and ProjectedFS ignores their result. Tools like `git clean`
+      // send them by the tens of thousands, so let the writing process move
+      // on and bring the inodes up to date in the background.
+      FB_LOG(getStraceLogger(), DBG7, renderer(relPath, destPath, isDirectory));
+      enqueueNotification(PendingNotification{
+          std::move(context),
+          stat,
+          [this,
+           handler,
+           relPath = std::move(relPath),
+           destPath = std::move(destPath),
+           isDirectory](ObjectFetchContext& fetchContext) mutable {
+            return (this->*handler)(
+                std::move(relPath),
+                std::move(destPath),
+                isDirectory,
+                fetchContext);
+          }});
+      return S_OK;
+    }
+
     auto fut = makeImmediateFutureWith([this,
                                         context,
                                         stat = stat,
@@ -841,6 +880,107 @@ HRESULT PrjfsChannelInner::notification(
   }
 }
 
+void PrjfsChannelInner::enqueueNotification(PendingNotification notification) {
+  auto requestWatch =
+      std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>(nullptr);
+  notification.context->startRequest(
+      dispatcher_->getStats(), notification.stat, requestWatch);
+
+  size_t depth;
+  bool startDraining;
+  {
+    auto state = notifications_.wlock();
+    state->pending.push_back(std::move(notification));
+    ++state->queued;
+    depth = state->pending.size();
+    startDraining = !std::exchange(state->draining, true);
+  }
+  dispatcher_->getStats()
+      ->getChannelStatsForCurrentThread()
+      .notificationQueueDepth.addValue(depth);
+
+  if (startDraining) {
+    // The queued notification keeps this object alive.
+    folly::getGlobalCPUExecutor()->add([this] { drainNotifications(); });
+  }
+}
+
+void PrjfsChannelInner::drainNotifications() {
+  std::vector<PendingNotification> batch;
+  {
+    auto state = notifications_.wlock();
+    if (state->pending.empty()) {
+      state->draining = false;
+      return;
+    }
+    batch.swap(state->pending);
+  }
+  dispatcher_->getStats()
+      ->getChannelStatsForCurrentThread()
+      .notificationBatchSize.addValue(batch.size());
+
+  // Hold on to the channel until the next batch has been looked for.
+  auto keepAlive = batch.back().context;
+  auto batchSize = batch.size();
+
+  // The notifications are applied one after the other: later ones for a path
+  // often depend on earlier ones, such as a file created in a new directory.
+  auto fut = ImmediateFuture<folly::Unit>{folly::unit};
+  for (auto& notification : batch) {
+    fut = std::move(fut).thenValue(
+        [notification = std::move(notification)](auto&&) mutable {
+          auto context = std::move(notification.context);
+          return makeImmediateFutureWith(
+                     [&] { return notification.apply(*context); })
+              .thenTry([context](folly::Try<folly::Unit>&& result) {
+                if (result.hasException()) {
+                  XLOG(WARN) << "Failed to apply ProjectedFS notification: "
+                             << folly::exceptionStr(result.exception());
+                }
+                context->finishRequest();
+              });
+        });
+  }
+
+  std::move(fut)
+      .thenValue([this, keepAlive = std::move(keepAlive), batchSize](
+                     auto&&) mutable {
+        std::vector<folly::Promise<folly::Unit>> ready;
+        {
+          auto state = notifications_.wlock();
+          state->applied += batchSize;
+          auto& waiters = state->waiters;
+          auto it = std::partition(
+              waiters.begin(), waiters.end(), [&](const auto& waiter) {
+                return waiter.first > state->applied;
+              });
+          for (auto waiter = it; waiter != waiters.end(); ++waiter) {
+            ready.push_back(std::move(waiter->second));
+          }
+          waiters.erase(it, waiters.end());
+        }
+        for (auto& promise : ready) {
+          promise.setValue();
+        }
+        folly::getGlobalCPUExecutor()->add(
+            [this, keepAlive = std::move(keepAlive)] { drainNotifications(); });
+      })
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance());
+}
+
+folly::SemiFuture<folly::Unit>
+PrjfsChannelInner::waitForPendingNotifications() {
+  auto state = notifications_.wlock();
+  if (state->applied == state->queued) {
+    return folly::unit;
+  }
+  folly::Promise<folly::Unit> promise;
+  auto future = promise.getSemiFuture();
+  state->waiters.emplace_back(state->queued, std::move(promise));
+  return future;
+}
+
 namespace {
 void sendReply(
     PRJ_NAMESPACE_VIRTUALIZATION_CONTEXT context,
@@ -889,7 +1029,10 @@ PrjfsChannel::~PrjfsChannel() {
       << "stop() must be called before destroying the channel";
 }
 
-void PrjfsChannel::start(bool readOnly, bool useNegativePathCaching) {
+void PrjfsChannel::start(
+    bool readOnly,
+    bool useNegativePathCaching,
+    size_t invalidationThreads) {
   if (readOnly) {
     NOT_IMPLEMENTED();
   }
@@ -956,6 +1099,13 @@ void PrjfsChannel::start(bool readOnly, bool useNegativePathCaching) {
 
   inner_.rlock()->setMountChannel(mountChannel_);
 
+  if (invalidationThreads > 1) {
+    invalidationThreads_ = invalidationThreads;
+    invalidationExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+        invalidationThreads,
+        std::make_shared<folly::NamedThreadFactory>("PrjfsInvalidation"));
+  }
+
   XLOG(INFO) << "Started PrjfsChannel for: " << mountPath_;
 }
 
@@ -1016,6 +1166,36 @@ folly::Try<void> PrjfsChannel::removeCachedFile(RelativePathPiece path) {
   return folly::Try<void>{};
 }
 
+std::vector<folly::Try<void>> PrjfsChannel::removeCachedFiles(
+    const std::vector<RelativePath>& paths) {
+  std::vector<folly::Try<void>> results(paths.size());
+  auto removeEvery = [&](size_t first, size_t stride) {
+    for (size_t i = first; i < paths.size(); i += stride) {
+      results[i] =
+          folly::makeTryWith([&] { return removeCachedFile(paths[i]); });
+    }
+  };
+
+  if (!invalidationExecutor_ || paths.size() < 2) {
+    removeEvery(0, 1);
+    return results;
+  }
+
+  // One task per thread rather than per path, a removal being much cheaper
+  // than scheduling.
+  auto numTasks = std::min(paths.size(), invalidationThreads_);
+  std::vector<folly::SemiFuture<folly::Unit>> tasks;
+  tasks.reserve(numTasks);
+  for (size_t task = 0; task < numTasks; ++task) {
+    tasks.push_back(
+        folly::via(invalidationExecutor_.get(), [&removeEvery, task, numTasks] {
+          removeEvery(task, numTasks);
+        }).semi());
+  }
+  folly::collectAll(std::move(tasks)).wait();
+  return results;
+}
+
 folly::Try<void> PrjfsChannel::addDirectoryPlaceholder(RelativePathPiece path) {
   if (path.empty()) {
     return folly::Try<void>{};
@@ -1059,6 +1239,14 @@ folly::Try<void> PrjfsChannel::addDirectoryPlaceholder(RelativePathPiece path) {
   return folly::Try<void>{};
 }
 
+folly::SemiFuture<folly::Unit> PrjfsChannel::waitForPendingNotifications() {
+  auto inner = getInner();
+  if (!inner) {
+    return folly::unit;
+  }
+  return inner->waitForPendingNotifications();
+}
+
 void PrjfsChannel::flushNegativePathCache() {
   if (useNegativePathCaching_) {
     XLOG(DBG6) << "Flushing negative path cache";
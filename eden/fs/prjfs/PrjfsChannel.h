@@ -9,11 +9,16 @@
 
 #include <folly/portability/Windows.h>
 
+#include <folly/Function.h>
+#include <folly/Synchronized.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/futures/Future.h>
+#include <vector>
 
 #include <ProjectedFSLib.h> // @manual
 #include "eden/fs/prjfs/Enumerator.h"
 #include "eden/fs/prjfs/PrjfsDispatcher.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/Guid.h"
 #include "eden/fs/utils/PathFuncs.h"
 #include "eden/fs/utils/ProcessAccessLog.h"
@@ -199,7 +204,46 @@ class PrjfsChannelInner {
 
   void sendError(int32_t commandId, HRESULT error);
 
+  /**
+   * Returns a future that completes once all of the notifications received so
+   * far have been applied.
+   */
+  folly::SemiFuture<folly::Unit> waitForPendingNotifications();
+
  private:
+  /**
+   * A notification of a change that ProjectedFS already made on disk, waiting
+   * to be applied to the inodes.
+   */
+  struct PendingNotification {
+    std::shared_ptr<PrjfsRequestContext> context;
+    ChannelThreadStats::StatPtr stat;
+    folly::Function<ImmediateFuture<folly::Unit>(ObjectFetchContext&)> apply;
+  };
+
+  struct NotificationQueue {
+    std::vector<PendingNotification> pending;
+    // Whether a drainNotifications() call is in progress or scheduled.
+    bool draining{false};
+    // The number of notifications ever queued, and ever applied.
+    uint64_t queued{0};
+    uint64_t applied{0};
+    // Promises from waitForPendingNotifications(), with the value of queued
+    // at the time of the call.
+    std::vector<std::pair<uint64_t, folly::Promise<folly::Unit>>> waiters;
+  };
+
+  /**
+   * Queue a notification to be applied in the background, in the order in
+   * which notifications were received.
+   */
+  void enqueueNotification(PendingNotification notification);
+
+  /**
+   * Apply the queued notifications, in batches, until the queue is empty.
+   */
+  void drainNotifications();
+
   const folly::Logger& getStraceLogger() const {
     return *straceLogger_;
   }
@@ -240,6 +284,10 @@ class PrjfsChannelInner {
   // Set of currently active directory enumerations.
   folly::Synchronized<folly::F14FastMap<Guid, std::shared_ptr<Enumerator>>>
       enumSessions_;
+
+  // Each queued notification holds its request context, and thus the
+  // channel: unmounting waits for the queue to be drained.
+  folly::Synchronized<NotificationQueue> notifications_;
 };
 
 class PrjfsChannel {
@@ -258,7 +306,14 @@ class PrjfsChannel {
 
   ~PrjfsChannel();
 
-  void start(bool readOnly, bool useNegativePathCaching);
+  /**
+   * Start virtualizing the mount. removeCachedFiles() issues its removals
+   * from invalidationThreads threads.
+   */
+  void start(
+      bool readOnly,
+      bool useNegativePathCaching,
+      size_t invalidationThreads);
 
   /**
    * Stop the PrjfsChannel.
@@ -284,6 +339,18 @@ class PrjfsChannel {
    */
   FOLLY_NODISCARD folly::Try<void> removeCachedFile(RelativePathPiece path);
 
+  /**
+   * Like removeCachedFile, for many files at once. Each removal is a round
+   * trip to the kernel, so they are spread over a pool of threads dedicated
+   * to invalidations, and this returns once they all completed.
+   *
+   * The paths must not depend on each other, e.g. be siblings: they are
+   * removed in no particular order. The result for each path is at the same
+   * index as the path.
+   */
+  FOLLY_NODISCARD std::vector<folly::Try<void>> removeCachedFiles(
+      const std::vector<RelativePath>& paths);
+
   /**
    * Ensure that the directory is a placeholder so that ProjectedFS will always
    * invoke the opendir/readdir callbacks when the user is listing files in it.
@@ -295,6 +362,13 @@ class PrjfsChannel {
 
   void flushNegativePathCache();
 
+  /**
+   * Notifications of changes made by ProjectedFS are applied asynchronously.
+   * Returns a future that completes once the ones received so far have been
+   * applied, so that the inodes reflect the working copy.
+   */
+  folly::SemiFuture<folly::Unit> waitForPendingNotifications();
+
   ProcessAccessLog& getProcessAccessLog() {
     return processAccessLog_;
   }
@@ -313,6 +387,12 @@ class PrjfsChannel {
   const AbsolutePath mountPath_;
   Guid mountId_;
   bool useNegativePathCaching_{true};
+  /**
+   * Only blocks on ProjectedFS, never on EdenFS, so waiting on it while
+   * holding inode locks can't deadlock.
+   */
+  std::unique_ptr<folly::CPUThreadPoolExecutor> invalidationExecutor_;
+  size_t invalidationThreads_{0};
   folly::Promise<StopData> stopPromise_;
 
   ProcessAccessLog processAccessLog_;
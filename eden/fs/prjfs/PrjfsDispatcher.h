@@ -10,6 +10,7 @@
 #include "folly/portability/Windows.h"
 
 #include <ProjectedFSLib.h> // @manual
+#include <folly/io/IOBuf.h>
 #include "eden/fs/prjfs/Enumerator.h"
 #include "eden/fs/utils/Guid.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -66,12 +67,11 @@ class PrjfsDispatcher {
   /**
    * Read the file with the given name
    *
-   * Returns the entire content of the file at path.
-   *
-   * In the future, this will return only what's in between offset and
-   * offset+length.
+   * Returns the entire content of the file at path. The IOBuf may share
+   * memory with the cached blob, so callers should only copy the range they
+   * need out of it.
    */
-  virtual ImmediateFuture<std::string> read(
+  virtual ImmediateFuture<std::unique_ptr<folly::IOBuf>> read(
       RelativePath path,
       ObjectFetchContext& context) = 0;
 
@@ -40,6 +40,11 @@ struct RocksHandles {
    */
   ~RocksHandles();
 
+  /**
+   * A closed instance, whose db is null.
+   */
+  RocksHandles() = default;
+
   /**
    * Returns an instance of a RocksDB that uses the specified directory for
    * storage. If there is an existing RocksDB at that path with
@@ -7,15 +7,42 @@
 
 #include "eden/fs/service/EdenCPUThreadPool.h"
 
+#include <folly/logging/xlog.h>
 #include <gflags/gflags.h>
 
 DEFINE_int32(num_eden_threads, 12, "the number of eden CPU worker threads");
+DEFINE_bool(
+    eden_threads_work_stealing,
+    false,
+    "give each eden CPU worker thread its own queue of tasks, and let idle "
+    "threads steal tasks from the others");
+DEFINE_string(
+    eden_threads_affinity,
+    "none",
+    "where the eden CPU worker threads run: none, pin, node-local or spread");
 
 namespace facebook {
 namespace eden {
 
+namespace {
+CpuAffinityPolicy getThreadAffinity() {
+  auto policy = parseCpuAffinityPolicy(FLAGS_eden_threads_affinity);
+  if (!policy) {
+    XLOG(WARN) << "ignoring invalid --eden_threads_affinity: "
+               << FLAGS_eden_threads_affinity;
+    return CpuAffinityPolicy::None;
+  }
+  return *policy;
+}
+} // namespace
+
 EdenCPUThreadPool::EdenCPUThreadPool()
-    : UnboundedQueueExecutor(FLAGS_num_eden_threads, "EdenCPUThread") {}
+    : UnboundedQueueExecutor(
+          FLAGS_num_eden_threads,
+          "EdenCPUThread",
+          FLAGS_eden_threads_work_stealing ? Scheduling::WorkStealing
+                                           : Scheduling::SharedQueue,
+          getThreadAffinity()) {}
 
 } // namespace eden
 } // namespace facebook
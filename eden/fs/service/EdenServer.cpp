@@ -11,6 +11,7 @@
 #include <chrono>
 
 #include <sys/stat.h>
+#include <algorithm>
 #include <atomic>
 #include <fstream>
 #include <functional>
@@ -25,10 +26,13 @@
 #include <folly/SocketAddress.h>
 #include <folly/String.h>
 #include <folly/chrono/Conv.h>
+#include <folly/futures/Future.h>
+#include <folly/io/Cursor.h>
 #include <folly/io/async/AsyncSignalHandler.h>
 #include <folly/io/async/HHWheelTimer.h>
 #include <folly/logging/xlog.h>
 #include <folly/stop_watch.h>
+#include <folly/synchronization/SaturatingSemaphore.h>
 #include <gflags/gflags.h>
 #include <signal.h>
 #include <thrift/lib/cpp/concurrency/ThreadManager.h>
@@ -39,9 +43,11 @@
 #include "eden/fs/config/TomlConfig.h"
 #include "eden/fs/fuse/privhelper/PrivHelper.h"
 #include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/InodeBase.h"
 #include "eden/fs/inodes/InodeMap.h"
 #include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/model/git/GitIgnoreCache.h"
 #include "eden/fs/nfs/NfsServer.h"
 #include "eden/fs/service/EdenCPUThreadPool.h"
 #include "eden/fs/service/EdenServiceHandler.h"
@@ -103,6 +109,12 @@ DEFINE_bool(
     false,
     "If another edenfs process is already running, "
     "attempt to gracefully takeover its mount points.");
+DEFINE_bool(
+    takeover_prewarm,
+    false,
+    "With --takeover, warm up the local store and the thread pools before "
+    "asking the existing edenfs process to transfer its mount points, so that "
+    "the mounts are blocked for as little time as possible.");
 DEFINE_bool(
     enable_fault_injection,
     false,
@@ -153,6 +165,12 @@ DEFINE_uint64(
     minimumBlobCacheEntryCount,
     16,
     "The minimum number of recent blobs to keep cached. Trumps maximumBlobCacheSize");
+DEFINE_uint64(
+    blobCacheShardCount,
+    1,
+    "Number of independently locked shards the blob cache is split into");
+
+DECLARE_int32(num_eden_threads);
 
 using apache::thrift::ThriftServer;
 using apache::thrift::ThriftServerAsyncProcessorFactory;
@@ -173,6 +191,9 @@ using namespace facebook::eden;
 
 constexpr StringPiece kRocksDBPath{"storage/rocks-db"};
 constexpr StringPiece kSqlitePath{"storage/sqlite.db"};
+constexpr StringPiece kTreeCacheSnapshotPath{"storage/tree-cache"};
+constexpr StringPiece kBlobCacheTracePath{"storage/blob-cache-trace"};
+constexpr StringPiece kTreeCacheTracePath{"storage/tree-cache-trace"};
 constexpr StringPiece kHgStorePrefix{"store.hg"};
 #ifndef _WIN32
 constexpr StringPiece kFuseRequestPrefix{"fuse"};
@@ -209,6 +230,26 @@ std::string getCounterNameForImportMetric(
       RequestMetricsScope::stringOfRequestMetric(metric));
 }
 
+/**
+ * Write the accesses recorded by a cache's trace, if it has one, so that they
+ * can be replayed by the object_cache_replay benchmark.
+ */
+void saveCacheTrace(
+    const std::shared_ptr<ObjectCacheTrace>& trace,
+    AbsolutePathPiece path) {
+  if (!trace) {
+    return;
+  }
+  try {
+    ensureDirectoryExists(path.dirname());
+    trace->write(path);
+    XLOG(INFO) << "saved " << trace->getEvents().size()
+               << " cache accesses to " << path;
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "unable to save cache trace " << path << ": " << ex.what();
+  }
+}
+
 #ifndef _WIN32
 std::string getCounterNameForFuseRequests(
     RequestMetricsScope::RequestStage stage,
@@ -258,6 +299,33 @@ size_t getNumberPendingFuseRequests(const EdenMount* mount) {
 }
 #endif // __linux__
 
+/**
+ * Have threadCount tasks of executor run at the same time, so that a thread
+ * pool that starts its threads lazily starts them all now. Gives up after a
+ * second if the pool has fewer threads.
+ */
+void warmThreadPool(folly::Executor& executor, size_t threadCount) {
+  struct State {
+    std::atomic<size_t> started{0};
+    std::atomic<size_t> finished{0};
+    folly::SaturatingSemaphore<true> allStarted;
+    folly::SaturatingSemaphore<true> allFinished;
+  };
+  auto state = std::make_shared<State>();
+  for (size_t i = 0; i < threadCount; ++i) {
+    executor.add([state, threadCount] {
+      if (state->started.fetch_add(1) + 1 == threadCount) {
+        state->allStarted.post();
+      } else {
+        state->allStarted.try_wait_for(1s);
+      }
+      if (state->finished.fetch_add(1) + 1 == threadCount) {
+        state->allFinished.post();
+      }
+    });
+  }
+  state->allFinished.try_wait_for(2s);
+}
 } // namespace
 
 namespace facebook {
@@ -318,6 +386,36 @@ class EdenServer::ThriftServerEventHandler
 };
 
 static constexpr folly::StringPiece kBlobCacheMemory{"blob_cache.memory"};
+static constexpr folly::StringPiece kBlobCachePinnedEvictions{
+    "blob_cache.pinned_eviction_count"};
+static constexpr folly::StringPiece kBlobCacheLargeBlobMemory{
+    "blob_cache.large_blob_memory"};
+static constexpr folly::StringPiece kBlobCacheLargeBlobAdmits{
+    "blob_cache.large_blob_admit_count"};
+static constexpr folly::StringPiece kBlobCacheLargeBlobRejects{
+    "blob_cache.large_blob_reject_count"};
+static constexpr folly::StringPiece kBlobCacheCompressedMemory{
+    "blob_cache.compressed.memory"};
+static constexpr folly::StringPiece kBlobCacheCompressedHits{
+    "blob_cache.compressed.hit_count"};
+static constexpr folly::StringPiece kBlobCacheCompressedMisses{
+    "blob_cache.compressed.miss_count"};
+static constexpr folly::StringPiece kGitIgnoreCacheMemory{
+    "gitignore_cache.memory"};
+static constexpr folly::StringPiece kGitIgnoreCacheItems{
+    "gitignore_cache.items"};
+static constexpr folly::StringPiece kGitIgnoreCacheHits{
+    "gitignore_cache.hit_count"};
+static constexpr folly::StringPiece kGitIgnoreCacheMisses{
+    "gitignore_cache.miss_count"};
+static constexpr folly::StringPiece kFileInodePoolMemory{
+    "inode_pool.file.memory"};
+static constexpr folly::StringPiece kFileInodePoolObjects{
+    "inode_pool.file.objects"};
+static constexpr folly::StringPiece kTreeInodePoolMemory{
+    "inode_pool.tree.memory"};
+static constexpr folly::StringPiece kTreeInodePoolObjects{
+    "inode_pool.tree.objects"};
 
 EdenServer::EdenServer(
     std::vector<std::string> originalCommandLine,
@@ -335,7 +433,12 @@ EdenServer::EdenServer(
       activityRecorderFactory_(std::move(activityRecorderFactory)),
       blobCache_{BlobCache::create(
           FLAGS_maximumBlobCacheSize,
-          FLAGS_minimumBlobCacheEntryCount)},
+          FLAGS_minimumBlobCacheEntryCount,
+          FLAGS_blobCacheShardCount,
+          edenConfig->blobCacheEvictionPolicy.getValue(),
+          edenConfig->blobCacheLargeBlobThreshold.getValue(),
+          edenConfig->blobCacheLargeBlobCacheSize.getValue(),
+          edenConfig->blobCacheCompressedCacheSize.getValue())},
       // Store a pointer to the EventBase that will be used to drive
       // the main thread.  The runServer() code will end up driving this
       // EventBase.
@@ -354,7 +457,9 @@ EdenServer::EdenServer(
               ? std::make_shared<NfsServer>(
                     mainEventBase_,
                     edenConfig->numNfsThreads.getValue(),
-                    edenConfig->maxNfsInflightRequests.getValue())
+                    edenConfig->maxNfsInflightRequests.getValue(),
+                    edenConfig->maxNfsInflightRequestsPerConnection.getValue(),
+                    edenConfig->nfsThreadAffinity.getValue())
               :
 #endif
               nullptr,
@@ -365,10 +470,61 @@ EdenServer::EdenServer(
 
   treeCache_ = TreeCache::create(shared_ptr<ReloadableConfig>(
       serverState_, &serverState_->getReloadableConfig()));
+  if (auto capacity = edenConfig->blobCacheTraceCapacity.getValue()) {
+    blobCache_->setTrace(std::make_shared<ObjectCacheTrace>(capacity));
+  }
+  if (auto capacity = edenConfig->inMemoryTreeCacheTraceCapacity.getValue()) {
+    treeCache_->setTrace(std::make_shared<ObjectCacheTrace>(capacity));
+  }
   auto counters = fb303::ServiceData::get()->getDynamicCounters();
   counters->registerCallback(kBlobCacheMemory, [this] {
     return this->getBlobCache()->getStats().totalSizeInBytes;
   });
+  counters->registerCallback(kBlobCachePinnedEvictions, [this] {
+    return this->getBlobCache()->getStats().pinnedEvictionCount;
+  });
+  counters->registerCallback(kBlobCacheLargeBlobMemory, [this] {
+    return this->getBlobCache()->getStats().largeObjectSizeInBytes;
+  });
+  counters->registerCallback(kBlobCacheLargeBlobAdmits, [this] {
+    return this->getBlobCache()->getStats().largeObjectAdmitCount;
+  });
+  counters->registerCallback(kBlobCacheLargeBlobRejects, [this] {
+    return this->getBlobCache()->getStats().largeObjectRejectCount;
+  });
+  counters->registerCallback(kBlobCacheCompressedMemory, [this] {
+    return this->getBlobCache()->getCompressedStats().totalSizeInBytes;
+  });
+  counters->registerCallback(kBlobCacheCompressedHits, [this] {
+    return this->getBlobCache()->getCompressedStats().hitCount;
+  });
+  counters->registerCallback(kBlobCacheCompressedMisses, [this] {
+    return this->getBlobCache()->getCompressedStats().missCount;
+  });
+  counters->registerCallback(kGitIgnoreCacheMemory, [this] {
+    return serverState_->getGitIgnoreCache().getStats().totalSizeInBytes;
+  });
+  counters->registerCallback(kGitIgnoreCacheItems, [this] {
+    return serverState_->getGitIgnoreCache().getStats().entryCount;
+  });
+  counters->registerCallback(kGitIgnoreCacheHits, [this] {
+    return serverState_->getGitIgnoreCache().getStats().hitCount;
+  });
+  counters->registerCallback(kGitIgnoreCacheMisses, [this] {
+    return serverState_->getGitIgnoreCache().getStats().missCount;
+  });
+  counters->registerCallback(kFileInodePoolMemory, [] {
+    return FileInode::getAllocatorStats().totalBytes;
+  });
+  counters->registerCallback(kFileInodePoolObjects, [] {
+    return FileInode::getAllocatorStats().objectCount;
+  });
+  counters->registerCallback(kTreeInodePoolMemory, [] {
+    return TreeInode::getAllocatorStats().totalBytes;
+  });
+  counters->registerCallback(kTreeInodePoolObjects, [] {
+    return TreeInode::getAllocatorStats().objectCount;
+  });
 
   for (auto stage : RequestMetricsScope::requestStages) {
     for (auto metric : RequestMetricsScope::requestMetrics) {
@@ -401,11 +557,28 @@ EdenServer::EdenServer(
       });
     }
   }
+
+  registerMemoryConsumers();
 }
 
 EdenServer::~EdenServer() {
   auto counters = fb303::ServiceData::get()->getDynamicCounters();
   counters->unregisterCallback(kBlobCacheMemory);
+  counters->unregisterCallback(kBlobCachePinnedEvictions);
+  counters->unregisterCallback(kBlobCacheLargeBlobMemory);
+  counters->unregisterCallback(kBlobCacheLargeBlobAdmits);
+  counters->unregisterCallback(kBlobCacheLargeBlobRejects);
+  counters->unregisterCallback(kBlobCacheCompressedMemory);
+  counters->unregisterCallback(kBlobCacheCompressedHits);
+  counters->unregisterCallback(kBlobCacheCompressedMisses);
+  counters->unregisterCallback(kGitIgnoreCacheMemory);
+  counters->unregisterCallback(kGitIgnoreCacheItems);
+  counters->unregisterCallback(kGitIgnoreCacheHits);
+  counters->unregisterCallback(kGitIgnoreCacheMisses);
+  counters->unregisterCallback(kFileInodePoolMemory);
+  counters->unregisterCallback(kFileInodePoolObjects);
+  counters->unregisterCallback(kTreeInodePoolMemory);
+  counters->unregisterCallback(kTreeInodePoolObjects);
 
   for (auto stage : RequestMetricsScope::requestStages) {
     for (auto metric : RequestMetricsScope::requestMetrics) {
@@ -664,6 +837,31 @@ void EdenServer::updatePeriodicTaskIntervals(const EdenConfig& config) {
   localStoreTask_.updateInterval(
       std::chrono::duration_cast<std::chrono::milliseconds>(
           config.localStoreManagementInterval.getValue()));
+
+  journalCompactionTask_.updateInterval(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config.journalCompactionInterval.getValue()));
+
+  if (config.inodeMemoryBudget.getValue() > 0) {
+    inodeMemoryBudgetTask_.updateInterval(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            config.inodeMemoryBudgetCheckInterval.getValue()));
+  } else {
+    inodeMemoryBudgetTask_.updateInterval(0ms);
+  }
+
+  memoryPressureTask_.updateInterval(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config.memoryPressureCheckInterval.getValue()));
+
+  auto policy = maintenanceScheduler_.getPolicy();
+  policy.maxDeferral = std::chrono::duration_cast<std::chrono::milliseconds>(
+      config.maintenanceMaxDeferral.getValue());
+  policy.busyFsRequests = config.maintenanceBusyFsRequests.getValue();
+  policy.busyPendingImports = config.maintenanceBusyPendingImports.getValue();
+  maintenanceScheduler_.setPolicy(policy);
+  // The load is only needed to defer maintenance.
+  foregroundLoadTask_.updateInterval(policy.maxDeferral.count() > 0 ? 1s : 0ms);
 }
 
 void EdenServer::scheduleCallbackOnMainEventBase(
@@ -730,21 +928,27 @@ void EdenServer::unloadInodes() {
     }
   }
 
-  if (!roots.empty()) {
-    auto cutoff = std::chrono::system_clock::now() -
-        std::chrono::minutes(FLAGS_unload_age_minutes);
-    auto cutoff_ts = folly::to<timespec>(cutoff);
-    for (auto& [name, rootInode, mount] : roots) {
-      auto unloaded = rootInode->unloadChildrenLastAccessedBefore(cutoff_ts);
+  // Each mount is unloaded in its own step, so that the main EventBase gets
+  // to run between mounts and the unload waits while the foreground is busy.
+  auto cutoff = std::chrono::system_clock::now() -
+      std::chrono::minutes(FLAGS_unload_age_minutes);
+  auto cutoff_ts = folly::to<timespec>(cutoff);
+  std::vector<MaintenanceScheduler::Step> steps;
+  for (auto& root : roots) {
+    steps.emplace_back([root = std::move(root), cutoff_ts] {
+      auto unloaded =
+          root.rootInode->unloadChildrenLastAccessedBefore(cutoff_ts);
       if (unloaded) {
         XLOG(INFO) << "Unloaded " << unloaded
-                   << " inodes in background from mount " << name;
+                   << " inodes in background from mount " << root.mountName;
       }
-      mount->getInodeMap()->recordPeriodicInodeUnload(unloaded);
-    }
+      root.mount->getInodeMap()->recordPeriodicInodeUnload(unloaded);
+    });
   }
-
-  scheduleInodeUnload(std::chrono::minutes(FLAGS_unload_interval_minutes));
+  steps.emplace_back([this] {
+    scheduleInodeUnload(std::chrono::minutes(FLAGS_unload_interval_minutes));
+  });
+  maintenanceScheduler_.runSliced("inode_unload", std::move(steps));
 }
 
 void EdenServer::scheduleInodeUnload(std::chrono::milliseconds timeout) {
@@ -828,6 +1032,12 @@ Future<Unit> EdenServer::prepareImpl(
     doingTakeover = true;
   }
   auto thriftRunningFuture = createThriftServer();
+#ifndef _WIN32
+  // Warm up while the existing process still serves the mounts.
+  if (doingTakeover && FLAGS_takeover_prewarm) {
+    prewarmForTakeover(logger);
+  }
+#endif
 #ifndef _WIN32
   // Start the PrivHelper client, using our main event base to drive its I/O
   serverState_->getPrivHelper()->attachEventBase(mainEventBase_);
@@ -859,7 +1069,12 @@ Future<Unit> EdenServer::prepareImpl(
     logger->log(
         "Requesting existing edenfs process to gracefully "
         "transfer its mount points...");
-    takeoverData = takeoverMounts(takeoverPath);
+    auto takeoverVersions = kSupportedTakeoverVersions;
+    if (!serverState_->getEdenConfig()->enableTakeoverCacheHandoff.getValue()) {
+      takeoverVersions.erase(TakeoverData::kTakeoverProtocolVersionFive);
+    }
+    takeoverData =
+        takeoverMounts(takeoverPath, /*shouldPing=*/true, takeoverVersions);
     logger->log(
         "Received takeover information for ",
         takeoverData.mountPoints.size(),
@@ -868,6 +1083,11 @@ Future<Unit> EdenServer::prepareImpl(
     // Take over the eden lock file and the thrift server socket.
     edenDir_.takeoverLock(std::move(takeoverData.lockFile));
     server_->useExistingSocket(takeoverData.thriftSocket.release());
+
+    if (takeoverData.cacheContents) {
+      loadTakeoverCacheContents(logger, takeoverData.cacheContents);
+      takeoverData.cacheContents.close();
+    }
 #else
     NOT_IMPLEMENTED();
 #endif // !_WIN32
@@ -880,11 +1100,23 @@ Future<Unit> EdenServer::prepareImpl(
   // is required, introduce an EdenStateConfig class to manage defaults and save
   // on update.
   auto config = parseConfig();
-  bool shouldSaveConfig = openStorageEngine(*config, *logger);
+  bool shouldSaveConfig = openStorageEngine(*config, logger);
   if (shouldSaveConfig) {
     saveConfig(*config);
   }
 
+  if (serverState_->getEdenConfig()->enablePersistentTreeCache.getValue()) {
+    folly::stop_watch<std::chrono::milliseconds> watch;
+    treeCache_->loadSnapshot(
+        edenDir_.getPath() + RelativePathPiece{kTreeCacheSnapshotPath});
+    logger->log(
+        "Loaded ",
+        treeCache_->getSnapshotSize(),
+        " trees from the tree cache snapshot in ",
+        watch.elapsed().count() / 1000.0,
+        " seconds.");
+  }
+
 #ifndef _WIN32
   // Start listening for graceful takeover requests
   takeoverServer_.reset(new TakeoverServer(
@@ -919,6 +1151,48 @@ Future<Unit> EdenServer::prepareImpl(
   }
 }
 
+#ifndef _WIN32
+void EdenServer::prewarmForTakeover(
+    const std::shared_ptr<StartupLogger>& logger) {
+  folly::stop_watch<std::chrono::milliseconds> watch;
+  logger->log("Warming up before requesting the mount points...");
+
+  // The existing process keeps the local store open until it has handed its
+  // mount points over, so it can only be opened read-only here. Doing so
+  // reads its manifest, table metadata and write-ahead log, which are then
+  // still in the page cache when the store is opened for writing after the
+  // takeover.
+  auto config = parseConfig();
+  auto [storageEngine, configUpdated] = setDefault(
+      *config,
+      {"local-store", "engine"},
+      FLAGS_local_storage_engine_unsafe.empty()
+          ? DEFAULT_STORAGE_ENGINE
+          : FLAGS_local_storage_engine_unsafe);
+  if (storageEngine == "rocksdb") {
+    const auto rocksPath = edenDir_.getPath() + RelativePathPiece{kRocksDBPath};
+    try {
+      auto store = make_shared<RocksDbLocalStore>(
+          rocksPath,
+          serverState_->getStructuredLogger(),
+          &serverState_->getFaultInjector(),
+          RocksDBOpenMode::ReadOnly,
+          serverState_->getEdenConfig().get());
+      store->close();
+    } catch (const std::exception& ex) {
+      logger->warn(
+          "Unable to open the RocksDB store read-only to warm it up: ",
+          folly::exceptionStr(ex));
+    }
+  }
+
+  warmThreadPool(*serverState_->getThreadPool(), FLAGS_num_eden_threads);
+
+  logger->log(
+      "Warmed up in ", watch.elapsed().count() / 1000.0, " seconds.");
+}
+#endif // !_WIN32
+
 std::shared_ptr<cpptoml::table> EdenServer::parseConfig() {
   auto configPath = edenDir_.getPath() + RelativePathPiece{kStateConfig};
 
@@ -945,7 +1219,7 @@ void EdenServer::saveConfig(const cpptoml::table& root) {
 
 bool EdenServer::openStorageEngine(
     cpptoml::table& config,
-    StartupLogger& logger) {
+    std::shared_ptr<StartupLogger> logger) {
   std::string defaultStorageEngine = FLAGS_local_storage_engine_unsafe.empty()
       ? DEFAULT_STORAGE_ENGINE
       : FLAGS_local_storage_engine_unsafe;
@@ -962,35 +1236,70 @@ bool EdenServer::openStorageEngine(
   }
 
   if (storageEngine == "memory") {
-    logger.log("Creating new memory store.");
+    logger->log("Creating new memory store.");
     localStore_ = make_shared<MemoryLocalStore>();
   } else if (storageEngine == "sqlite") {
     const auto path = edenDir_.getPath() + RelativePathPiece{kSqlitePath};
     const auto parentDir = path.dirname();
     ensureDirectoryExists(parentDir);
-    logger.log("Opening local SQLite store ", path, "...");
+    logger->log("Opening local SQLite store ", path, "...");
     folly::stop_watch<std::chrono::milliseconds> watch;
     localStore_ = make_shared<SqliteLocalStore>(path);
-    logger.log(
+    logger->log(
         "Opened SQLite store in ",
         watch.elapsed().count() / 1000.0,
         " seconds.");
   } else if (storageEngine == "rocksdb") {
-    logger.log("Opening local RocksDB store...");
     folly::stop_watch<std::chrono::milliseconds> watch;
     const auto rocksPath = edenDir_.getPath() + RelativePathPiece{kRocksDBPath};
     ensureDirectoryExists(rocksPath);
-    localStore_ = make_shared<RocksDbLocalStore>(
+    auto edenConfig = serverState_->getEdenConfig();
+    auto walSize = RocksDbLocalStore::getWriteAheadLogSize(rocksPath);
+    logger->log(
+        "Opening local RocksDB store, replaying ",
+        walSize / (1024 * 1024),
+        " MB of write-ahead log...");
+    auto timing = edenConfig->rocksDbOpenInBackground.getValue()
+        ? RocksDBOpenTiming::Background
+        : RocksDBOpenTiming::Synchronous;
+    auto rocksStore = make_shared<RocksDbLocalStore>(
         rocksPath,
         serverState_->getStructuredLogger(),
-        &serverState_->getFaultInjector());
-    localStore_->enableBlobCaching.store(
-        serverState_->getEdenConfig()->enableBlobCaching.getValue(),
+        &serverState_->getFaultInjector(),
+        RocksDBOpenMode::ReadWrite,
+        edenConfig.get(),
+        timing);
+    rocksStore->enableBlobCaching.store(
+        edenConfig->enableBlobCaching.getValue(), std::memory_order_relaxed);
+    rocksStore->enableBlobDeduplication.store(
+        edenConfig->enableBlobDeduplication.getValue(),
         std::memory_order_relaxed);
-    logger.log(
-        "Opened RocksDB store in ",
-        watch.elapsed().count() / 1000.0,
-        " seconds.");
+    rocksStore->enablePackedTrees.store(
+        edenConfig->enablePackedTrees.getValue(), std::memory_order_relaxed);
+    if (timing == RocksDBOpenTiming::Synchronous) {
+      logger->log(
+          "Opened RocksDB store in ",
+          watch.elapsed().count() / 1000.0,
+          " seconds.");
+    } else {
+      logger->log("Mounting while the RocksDB store opens in the background.");
+      folly::futures::detachOn(
+          getServerState()->getThreadPool().get(),
+          rocksStore->getOpenFuture().defer(
+              [logger, watch](folly::Try<folly::Unit>&& result) {
+                if (result.hasException()) {
+                  logger->warn(
+                      "Failed to open the RocksDB store: ",
+                      result.exception().what());
+                  return;
+                }
+                logger->log(
+                    "Opened RocksDB store in ",
+                    watch.elapsed().count() / 1000.0,
+                    " seconds.");
+              }));
+    }
+    localStore_ = std::move(rocksStore);
   } else {
     throw std::runtime_error(
         folly::to<string>("invalid storage engine: ", storageEngine));
@@ -1065,18 +1374,30 @@ std::vector<Future<Unit>> EdenServer::prepareMounts(
   }
   logger->log("Remounting ", dirs.size(), " mount points...");
 
+  // Each mount spends most of its startup reading its overlay and setting up
+  // its backing store, so several are prepared at once on the server thread
+  // pool. The number in flight is bounded so that startup does not flood the
+  // disk with the overlay scans of every checkout at the same time.
+  std::vector<std::pair<std::string, std::string>> clients;
+  clients.reserve(dirs.size());
   for (const auto& client : dirs.items()) {
-    auto mountFuture = makeFutureWith([&] {
+    clients.emplace_back(client.first.asString(), client.second.asString());
+  }
+  auto maxConcurrentMounts = std::max<size_t>(
+      serverState_->getEdenConfig()->maxConcurrentStartupMounts.getValue(), 1);
+
+  auto prepareMount = [this, logger](
+                          const std::pair<std::string, std::string>& client) {
+    return makeFutureWith([&] {
       MountInfo mountInfo;
-      *mountInfo.mountPoint_ref() = client.first.c_str();
-      auto edenClientPath =
-          edenDir_.getCheckoutStateDir(client.second.asString());
+      *mountInfo.mountPoint_ref() = client.first;
+      auto edenClientPath = edenDir_.getCheckoutStateDir(client.second);
       *mountInfo.edenClientPath_ref() = edenClientPath.stringPiece().str();
       auto initialConfig = CheckoutConfig::loadFromClientDirectory(
           AbsolutePathPiece{*mountInfo.mountPoint_ref()},
           AbsolutePathPiece{*mountInfo.edenClientPath_ref()});
       auto progressIndex = progressManager_->wlock()->registerEntry(
-          client.first.asString(), initialConfig->getOverlayPath().c_str());
+          client.first, initialConfig->getOverlayPath().c_str());
 
       return mount(
                  std::move(initialConfig),
@@ -1088,7 +1409,7 @@ std::vector<Future<Unit>> EdenServer::prepareMounts(
           .thenTry(
               [this,
                logger,
-               mountPath = client.first.asString(),
+               mountPath = client.first,
                progressIndex](folly::Try<std::shared_ptr<EdenMount>>&& result) {
                 if (result.hasValue()) {
                   auto wl = progressManager_->wlock();
@@ -1106,10 +1427,13 @@ std::vector<Future<Unit>> EdenServer::prepareMounts(
                 }
               });
     });
+  };
 
-    mountFutures.push_back(std::move(mountFuture));
-  }
-  return mountFutures;
+  return folly::window(
+      folly::getKeepAliveToken(getServerState()->getThreadPool().get()),
+      std::move(clients),
+      std::move(prepareMount),
+      maxConcurrentMounts);
 }
 
 void EdenServer::incrementStartupMountFailures() {
@@ -1118,7 +1442,89 @@ void EdenServer::incrementStartupMountFailures() {
   fb303::fbData->incrementCounter("startup_mount_failures");
 }
 
+#ifndef _WIN32
+folly::File EdenServer::getCacheContentsForTakeover() {
+  const auto& config = serverState_->getEdenConfig();
+  if (!config->enableTakeoverCacheHandoff.getValue()) {
+    return folly::File{};
+  }
+
+  // Ordered from the next to be evicted to the most recently used, so keep
+  // the tail that fits.
+  auto blobs = blobCache_->getAllObjects();
+  auto maxBytes = config->takeoverCacheHandoffMaxBytes.getValue();
+  size_t totalBytes = 0;
+  auto first = blobs.end();
+  while (first != blobs.begin()) {
+    auto size = (*std::prev(first))->getSize();
+    if (totalBytes + size > maxBytes) {
+      break;
+    }
+    totalBytes += size;
+    --first;
+  }
+
+  SerializedCacheContents contents;
+  contents.blobs_ref()->reserve(std::distance(first, blobs.end()));
+  for (auto it = first; it != blobs.end(); ++it) {
+    SerializedCachedBlob blob;
+    blob.id_ref() = (*it)->getHash().getBytes().toString();
+    blob.contents_ref() = folly::io::Cursor{&(*it)->getContents()}
+                              .readFixedString((*it)->getSize());
+    contents.blobs_ref()->push_back(std::move(blob));
+  }
+  XLOG(INFO) << "handing " << contents.blobs_ref()->size() << " blobs ("
+             << totalBytes << " bytes) over to the new process";
+  return TakeoverData::writeCacheContents(contents);
+}
+
+void EdenServer::loadTakeoverCacheContents(
+    const std::shared_ptr<StartupLogger>& logger,
+    const folly::File& file) {
+  // A warm cache is only an optimization, don't fail the startup for it.
+  try {
+    folly::stop_watch<std::chrono::milliseconds> watch;
+    auto contents = TakeoverData::readCacheContents(file);
+    for (auto& blob : *contents.blobs_ref()) {
+      auto& contentsString = *blob.contents_ref();
+      blobCache_->insert(std::make_shared<const Blob>(
+          ObjectId{folly::ByteRange{folly::StringPiece{*blob.id_ref()}}},
+          folly::IOBuf{folly::IOBuf::COPY_BUFFER, contentsString}));
+    }
+    logger->log(
+        "Loaded ",
+        contents.blobs_ref()->size(),
+        " blobs from the previous process in ",
+        watch.elapsed().count() / 1000.0,
+        " seconds.");
+  } catch (const std::exception& ex) {
+    logger->warn(
+        "Unable to load the cache contents of the previous process: ",
+        ex.what());
+  }
+}
+#endif // !_WIN32
+
 void EdenServer::closeStorage() {
+  if (serverState_->getEdenConfig()->enablePersistentTreeCache.getValue()) {
+    // Save the tree cache before giving up the lock, so the next edenfs
+    // process (possibly taking over from us) starts with a warm cache.
+    try {
+      const auto path =
+          edenDir_.getPath() + RelativePathPiece{kTreeCacheSnapshotPath};
+      ensureDirectoryExists(path.dirname());
+      treeCache_->saveSnapshot(path);
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "unable to save tree cache snapshot: " << ex.what();
+    }
+  }
+  saveCacheTrace(
+      blobCache_->getTrace(),
+      edenDir_.getPath() + RelativePathPiece{kBlobCacheTracePath});
+  saveCacheTrace(
+      treeCache_->getTrace(),
+      edenDir_.getPath() + RelativePathPiece{kTreeCacheTracePath});
+
   // Destroy the local store and backing stores.
   // We shouldn't access the local store any more after giving up our
   // lock, and we need to close it to release its lock before the new
@@ -1266,6 +1672,33 @@ void EdenServer::registerStats(std::shared_ptr<EdenMount> edenMount) {
             ->getInodeCounts()
             .periodicUnlinkedUnloadInodeCount;
       });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::INODEMAP_MEMORY_ESTIMATE),
+      [edenMount] {
+        return edenMount->getInodeMap()->getEstimatedMemoryUsage();
+      });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::MEMORY_PRESSURE_INODE_UNLOAD),
+      [edenMount] {
+        return edenMount->getInodeMap()
+            ->getInodeCounts()
+            .memoryPressureUnloadInodeCount;
+      });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_GC_QUEUE_DEPTH),
+      [edenMount] {
+        return edenMount->getOverlay()->getGCStats().queuedDirectories;
+      });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_GC_REMOVED_DIRECTORIES),
+      [edenMount] {
+        return edenMount->getOverlay()->getGCStats().removedDirectories;
+      });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_GC_REMOVED_FILES),
+      [edenMount] {
+        return edenMount->getOverlay()->getGCStats().removedFiles;
+      });
   counters->registerCallback(
       edenMount->getCounterName(CounterName::JOURNAL_MEMORY),
       [edenMount] { return edenMount->getJournal().estimateMemoryUsage(); });
@@ -1327,6 +1760,16 @@ void EdenServer::unregisterStats(EdenMount* edenMount) {
       edenMount->getCounterName(CounterName::PERIODIC_INODE_UNLOAD));
   counters->unregisterCallback(
       edenMount->getCounterName(CounterName::PERIODIC_UNLINKED_INODE_UNLOAD));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::INODEMAP_MEMORY_ESTIMATE));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::MEMORY_PRESSURE_INODE_UNLOAD));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_GC_QUEUE_DEPTH));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_GC_REMOVED_DIRECTORIES));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_GC_REMOVED_FILES));
   counters->unregisterCallback(
       edenMount->getCounterName(CounterName::JOURNAL_MEMORY));
   counters->unregisterCallback(
@@ -1995,12 +2438,24 @@ folly::Future<TakeoverData> EdenServer::startTakeoverShutdown() {
         // Catch errors from compaction because we do not want this failure
         // to be blocking graceful restart. This can fail if there is no
         // space to write to RocksDB log files.
+        folly::stop_watch<std::chrono::milliseconds> watch;
         try {
           localStore_->compactStorage();
         } catch (const std::exception& e) {
           XLOG(ERR) << "Failed to compact local store with error: " << e.what()
                     << ". Continuing takeover server shutdown anyway.";
         }
+        XLOG(INFO) << "takeover: compacted local store in "
+                   << watch.lap().count() << "ms";
+
+        // The mounts are still serving requests at this point. Serialize as
+        // much of their inode state as possible now, so that only what
+        // changes from here on is serialized once requests are paused.
+        for (const auto& mount : getMountPoints()) {
+          mount->getInodeMap()->prepareTakeover();
+        }
+        XLOG(INFO) << "takeover: prepared inode maps in " << watch.lap().count()
+                   << "ms";
 
         shutdownSubscribers();
 
@@ -2009,6 +2464,8 @@ folly::Future<TakeoverData> EdenServer::startTakeoverShutdown() {
         // to pass with the takeover data below, while waiting here for
         // currently processing thrift calls to finish.
         server_->stop();
+        XLOG(INFO) << "takeover: stopped thrift server in "
+                   << watch.lap().count() << "ms";
       })
       .thenTry([this, takeoverPromise = std::move(takeoverPromise)](
                    auto&& t) mutable {
@@ -2016,7 +2473,14 @@ folly::Future<TakeoverData> EdenServer::startTakeoverShutdown() {
           takeoverPromise.setException(t.exception());
           t.throwUnlessValue();
         }
-        return stopMountsForTakeover(std::move(takeoverPromise));
+        // FS requests are paused from here until the new process takes over.
+        folly::stop_watch<std::chrono::milliseconds> watch;
+        return stopMountsForTakeover(std::move(takeoverPromise))
+            .thenValue([watch](TakeoverData&& takeover) {
+              XLOG(INFO) << "takeover: stopped " << takeover.mountPoints.size()
+                         << " mounts in " << watch.elapsed().count() << "ms";
+              return std::move(takeover);
+            });
       })
       .thenValue([this, socket = std::move(thriftSocket)](
                      TakeoverData&& takeover) mutable {
@@ -2068,12 +2532,218 @@ void EdenServer::reportMemoryStats() {
   }
 }
 
+void EdenServer::enforceInodeMemoryBudget() {
+  constexpr folly::StringPiece kPressurePct{
+      "inodes.memory_budget_pressure_pct"};
+
+  auto config = serverState_->getReloadableConfig().getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  auto budget = config->inodeMemoryBudget.getValue();
+  if (budget == 0) {
+    return;
+  }
+
+  struct Root {
+    AbsolutePath mountName;
+    TreeInodePtr rootInode;
+    shared_ptr<EdenMount> mount;
+    size_t memoryUsage;
+  };
+  std::vector<Root> roots;
+  size_t totalUsage = 0;
+  {
+    const auto mountPoints = mountPoints_.rlock();
+    for (auto& entry : *mountPoints) {
+      auto& mount = entry.second.edenMount;
+      auto usage = mount->getInodeMap()->getEstimatedMemoryUsage();
+      totalUsage += usage;
+      roots.emplace_back(
+          Root{entry.first, mount->getRootInode(), mount, usage});
+    }
+  }
+  fb303::fbData->setCounter(kPressurePct, totalUsage * 100 / budget);
+  if (totalUsage <= budget) {
+    return;
+  }
+
+  // Sweep the largest mounts first, as they are the most likely to hold
+  // inodes that nothing has needed in a while.
+  std::sort(roots.begin(), roots.end(), [](const Root& a, const Root& b) {
+    return a.memoryUsage > b.memoryUsage;
+  });
+  for (auto& [name, rootInode, mount, usage] : roots) {
+    auto* inodeMap = mount->getInodeMap();
+    auto unloaded = rootInode->unloadChildrenNotRecentlyAccessed();
+    auto newUsage = inodeMap->getEstimatedMemoryUsage();
+    if (unloaded) {
+      XLOG(DBG2) << "Unloaded " << unloaded << " inodes from mount " << name
+                 << " to stay within the inode memory budget";
+      inodeMap->recordMemoryPressureInodeUnload(unloaded);
+    }
+    totalUsage -= std::min(totalUsage, usage - std::min(usage, newUsage));
+    if (totalUsage <= budget) {
+      break;
+    }
+  }
+  fb303::fbData->setCounter(kPressurePct, totalUsage * 100 / budget);
+}
+
+void EdenServer::registerMemoryConsumers() {
+  auto shrinkCache = [](auto& cache, size_t bytesToFree) {
+    auto usage = cache.getStats().totalSizeInBytes;
+    return cache.shrinkTo(usage - std::min(usage, bytesToFree));
+  };
+  memoryGovernor_.addConsumer(
+      {"blob-cache",
+       [this] { return blobCache_->getStats().totalSizeInBytes; },
+       [this, shrinkCache](size_t bytesToFree) {
+         return shrinkCache(*blobCache_, bytesToFree);
+       }});
+  memoryGovernor_.addConsumer(
+      {"tree-cache",
+       [this] { return treeCache_->getStats().totalSizeInBytes; },
+       [this, shrinkCache](size_t bytesToFree) {
+         return shrinkCache(*treeCache_, bytesToFree);
+       }});
+  memoryGovernor_.addConsumer(
+      {"inodes",
+       [this] {
+         size_t usage = 0;
+         for (auto& entry : *mountPoints_.rlock()) {
+           usage +=
+               entry.second.edenMount->getInodeMap()->getEstimatedMemoryUsage();
+         }
+         return usage;
+       },
+       [this](size_t bytesToFree) {
+         return unloadInodesForMemoryPressure(bytesToFree);
+       }});
+  // Journals are trimmed by their own memory limit, and dropping entries
+  // would force their subscribers to recrawl, so they are only reported.
+  memoryGovernor_.addConsumer(
+      {"journal",
+       [this] {
+         size_t usage = 0;
+         for (auto& entry : *mountPoints_.rlock()) {
+           usage += entry.second.edenMount->getJournal().estimateMemoryUsage();
+         }
+         return usage;
+       },
+       nullptr});
+}
+
+void EdenServer::respondToMemoryPressure() {
+  constexpr folly::StringPiece kShrinkCount{"memory_governor.shrink_count"};
+  constexpr folly::StringPiece kFreedBytes{"memory_governor.freed_bytes"};
+
+  auto config = serverState_->getReloadableConfig().getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  MemoryGovernor::Policy policy;
+  policy.pressureThreshold = config->memoryPressureStallThreshold.getValue();
+  policy.cgroupUsageThreshold =
+      config->memoryPressureCgroupThreshold.getValue();
+  policy.shrinkFraction = config->memoryPressureShrinkFraction.getValue();
+  policy.shrinkOrder = config->memoryShrinkOrder.getValue();
+
+  auto pressure = proc_util::readMemoryPressure();
+  if (!MemoryGovernor::isUnderPressure(pressure, policy)) {
+    return;
+  }
+  auto freed = memoryGovernor_.respondToPressure(pressure, policy);
+  XLOG(DBG2) << "freed " << freed << " bytes under memory pressure";
+  fb303::fbData->incrementCounter(kShrinkCount);
+  fb303::fbData->incrementCounter(kFreedBytes, freed);
+}
+
+size_t EdenServer::unloadInodesForMemoryPressure(size_t bytesToFree) {
+  std::vector<std::pair<shared_ptr<EdenMount>, size_t>> mounts;
+  {
+    const auto mountPoints = mountPoints_.rlock();
+    for (auto& entry : *mountPoints) {
+      auto& mount = entry.second.edenMount;
+      mounts.emplace_back(
+          mount, mount->getInodeMap()->getEstimatedMemoryUsage());
+    }
+  }
+  std::sort(mounts.begin(), mounts.end(), [](const auto& a, const auto& b) {
+    return a.second > b.second;
+  });
+
+  size_t freed = 0;
+  for (auto& [mount, usage] : mounts) {
+    if (freed >= bytesToFree) {
+      break;
+    }
+    auto* inodeMap = mount->getInodeMap();
+    auto unloaded = mount->getRootInode()->unloadChildrenNotRecentlyAccessed();
+    if (unloaded) {
+      inodeMap->recordMemoryPressureInodeUnload(unloaded);
+    }
+    auto newUsage = inodeMap->getEstimatedMemoryUsage();
+    freed += usage - std::min(usage, newUsage);
+  }
+  return freed;
+}
+
+void EdenServer::sampleForegroundLoad() {
+  MaintenanceScheduler::Load load;
+  {
+    const auto mountPoints = mountPoints_.rlock();
+    for (const auto& entry : *mountPoints) {
+      const auto& edenMount = entry.second.edenMount;
+#ifndef _WIN32
+      if (auto* channel = edenMount->getFuseChannel()) {
+        load.fsRequests += channel->getRequestMetric(
+            RequestMetricsScope::RequestMetric::COUNT);
+      } else if (auto* nfsd = edenMount->getNfsdChannel()) {
+        load.fsRequests += nfsd->getOutstandingRequests().size();
+      }
+#else
+      (void)edenMount;
+#endif
+    }
+  }
+  for (auto object : HgBackingStore::hgImportObjects) {
+    for (auto pending : collectHgQueuedBackingStoreCounters(
+             [object](const HgQueuedBackingStore& store) {
+               return store.getImportMetric(
+                   RequestMetricsScope::RequestStage::PENDING,
+                   object,
+                   RequestMetricsScope::RequestMetric::COUNT);
+             })) {
+      load.pendingImports += pending;
+    }
+  }
+  maintenanceScheduler_.recordLoad(load);
+  fb303::fbData->setCounter(
+      "maintenance.busy", maintenanceScheduler_.isBusy() ? 1 : 0);
+}
+
 void EdenServer::manageLocalStore() {
   auto config = serverState_->getReloadableConfig().getEdenConfig(
       ConfigReloadBehavior::NoReload);
   localStore_->periodicManagementTask(*config);
 }
 
+void EdenServer::compactJournals() {
+  constexpr folly::StringPiece kCompactedDeltas{"journal.compacted_deltas"};
+
+  std::vector<shared_ptr<EdenMount>> mounts;
+  {
+    const auto mountPoints = mountPoints_.rlock();
+    for (auto& entry : *mountPoints) {
+      mounts.push_back(entry.second.edenMount);
+    }
+  }
+
+  size_t removed = 0;
+  for (auto& mount : mounts) {
+    removed += mount->getJournal().compactHistory();
+  }
+  XLOG(DBG3) << "journal compaction removed " << removed << " deltas";
+  fb303::fbData->incrementCounter(kCompactedDeltas, removed);
+}
+
 void EdenServer::refreshBackingStore() {
   std::vector<shared_ptr<BackingStore>> backingStores;
   {
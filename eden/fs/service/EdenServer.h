@@ -30,6 +30,8 @@
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/service/EdenStateDir.h"
+#include "eden/fs/service/MaintenanceScheduler.h"
+#include "eden/fs/service/MemoryGovernor.h"
 #include "eden/fs/service/PeriodicTask.h"
 #include "eden/fs/service/StartupLogger.h"
 #include "eden/fs/store/hg/MetadataImporter.h"
@@ -193,6 +195,14 @@ class EdenServer : private TakeoverHandler {
    */
   void closeStorage() override;
 
+#ifndef _WIN32
+  /**
+   * Serialize the most recently used blobs of the blob cache, up to
+   * takeover:cache-handoff-max-bytes, for the process taking over.
+   */
+  folly::File getCacheContentsForTakeover() override;
+#endif // !_WIN32
+
   /**
    * Stops this server, which includes the underlying Thrift server.
    *
@@ -302,6 +312,10 @@ class EdenServer : private TakeoverHandler {
     return treeCache_;
   }
 
+  const MemoryGovernor& getMemoryGovernor() const {
+    return memoryGovernor_;
+  }
+
   /**
    * Look up the BackingStore object for the specified repository type+name.
    *
@@ -388,6 +402,13 @@ class EdenServer : private TakeoverHandler {
     return mainEventBase_;
   }
 
+  /**
+   * Must be called only from the mainEventBase_ thread.
+   */
+  MaintenanceScheduler& getMaintenanceScheduler() {
+    return maintenanceScheduler_;
+  }
+
   /**
    * Look up all BackingStores
    *
@@ -471,6 +492,12 @@ class EdenServer : private TakeoverHandler {
   // all mounts.
   void unloadInodes();
 
+  /**
+   * Samples the requests in flight on the mounts and the pending imports of
+   * the backing stores for the MaintenanceScheduler.
+   */
+  void sampleForegroundLoad();
+
   std::shared_ptr<BackingStore> createBackingStore(
       folly::StringPiece type,
       folly::StringPiece name);
@@ -496,6 +523,21 @@ class EdenServer : private TakeoverHandler {
    * recoverImpl() contains the bulk of the implementation of recover()
    */
   FOLLY_NODISCARD folly::Future<folly::Unit> recoverImpl(TakeoverData&& data);
+
+  /**
+   * Insert the blobs handed over by the previous process into the blob
+   * cache. Errors are logged and otherwise ignored.
+   */
+  void loadTakeoverCacheContents(
+      const std::shared_ptr<StartupLogger>& logger,
+      const folly::File& file);
+
+  /**
+   * With --takeover_prewarm, called before requesting the mount points from
+   * the existing process, to shorten the time the mounts are blocked: the
+   * work done here no longer happens while they are.
+   */
+  void prewarmForTakeover(const std::shared_ptr<StartupLogger>& logger);
 #endif // !_WIN32
 
   /**
@@ -512,7 +554,9 @@ class EdenServer : private TakeoverHandler {
    * Open local storage engine for caching source control data.
    * Returns whether the config was modified.
    */
-  bool openStorageEngine(cpptoml::table& config, StartupLogger& logger);
+  bool openStorageEngine(
+      cpptoml::table& config,
+      std::shared_ptr<StartupLogger> logger);
 
   // Called when a mount has been unmounted and has stopped.
   void mountFinished(
@@ -560,10 +604,29 @@ class EdenServer : private TakeoverHandler {
   // Report memory usage statistics to ServiceData.
   void reportMemoryStats();
 
+  // Unload inodes that have not been looked up recently while the loaded
+  // inodes of all mounts use more memory than inodes:memory-budget.
+  void enforceInodeMemoryBudget();
+
+  // Register the caches, inodes and journals with memoryGovernor_.
+  void registerMemoryConsumers();
+
+  // Shrink the consumers of memoryGovernor_ while the memory of the machine
+  // or of our cgroup is under pressure.
+  void respondToMemoryPressure();
+
+  // Unload inodes that have not been looked up recently, from the largest
+  // mounts first, until about bytesToFree bytes have been freed. Returns the
+  // number of bytes freed.
+  size_t unloadInodesForMemoryPressure(size_t bytesToFree);
+
   // Compute stats for the local store and perform garbage collection if
   // necessary
   void manageLocalStore();
 
+  // Fold the older deltas of the journal of each mount.
+  void compactJournals();
+
   // some backing store may require periodic maintenance, specifically rust
   // datapack store needs to release file descriptor it holds every once in a
   // while.
@@ -603,6 +666,7 @@ class EdenServer : private TakeoverHandler {
   folly::Synchronized<BackingStoreMap> backingStores_;
   const std::shared_ptr<BlobCache> blobCache_;
   std::shared_ptr<TreeCache> treeCache_;
+  MemoryGovernor memoryGovernor_;
 
   folly::Synchronized<MountMap> mountPoints_{kPathMapDefaultCaseSensitive};
 
@@ -715,6 +779,12 @@ class EdenServer : private TakeoverHandler {
 
   const std::unique_ptr<folly::Synchronized<ProgressManager>> progressManager_;
 
+  /**
+   * Holds back the deferrable periodic tasks and the inode unloads while the
+   * foreground is busy.
+   */
+  MaintenanceScheduler maintenanceScheduler_{mainEventBase_};
+
   PeriodicFnTask<&EdenServer::reloadConfig> reloadConfigTask_{
       this,
       "reload_config"};
@@ -726,11 +796,30 @@ class EdenServer : private TakeoverHandler {
       "mem_stats"};
   PeriodicFnTask<&EdenServer::manageLocalStore> localStoreTask_{
       this,
-      "local_store"};
+      "local_store",
+      /*deferrable=*/true};
 
   PeriodicFnTask<&EdenServer::refreshBackingStore> backingStoreTask_{
       this,
-      "backing_store"};
+      "backing_store",
+      /*deferrable=*/true};
+
+  PeriodicFnTask<&EdenServer::compactJournals> journalCompactionTask_{
+      this,
+      "journal_compaction",
+      /*deferrable=*/true};
+
+  PeriodicFnTask<&EdenServer::enforceInodeMemoryBudget> inodeMemoryBudgetTask_{
+      this,
+      "inode_memory_budget"};
+
+  PeriodicFnTask<&EdenServer::respondToMemoryPressure> memoryPressureTask_{
+      this,
+      "memory_pressure"};
+
+  PeriodicFnTask<&EdenServer::sampleForegroundLoad> foregroundLoadTask_{
+      this,
+      "foreground_load"};
 };
 } // namespace eden
 } // namespace facebook
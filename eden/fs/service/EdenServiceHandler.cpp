@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <optional>
+#include <variant>
 #include <typeinfo>
 #include "eden/fs/utils/ProcessNameCache.h"
 
@@ -17,6 +18,7 @@
 #include <folly/FileUtil.h>
 #include <folly/Portability.h>
 #include <folly/String.h>
+#include <folly/Synchronized.h>
 #include <folly/chrono/Conv.h>
 #include <folly/container/Access.h>
 #include <folly/futures/Future.h>
@@ -43,6 +45,8 @@
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/GlobNode.h"
+#include "eden/fs/inodes/GlobPrefetcher.h"
+#include "eden/fs/inodes/GlobResultCache.h"
 #include "eden/fs/inodes/InodeError.h"
 #include "eden/fs/inodes/InodeLoader.h"
 #include "eden/fs/inodes/InodeMap.h"
@@ -67,6 +71,8 @@
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/PathLoader.h"
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
+#include "eden/fs/telemetry/SamplingProfiler.h"
+#include "eden/fs/telemetry/SlowRequestLog.h"
 #include "eden/fs/telemetry/Tracing.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/Clock.h"
@@ -274,6 +280,16 @@ RelativePath relpathFromUserPath(StringPiece userPath) {
   }
 }
 
+ImmediateFuture<FileInodePtr> asRegularFileInode(const InodePtr& inode) {
+  auto fileInode = inode.asFilePtr();
+  if (fileInode->getType() != dtype_t::Regular) {
+    // We intentionally want to refuse to compute the hash of symlinks
+    return makeImmediateFuture<FileInodePtr>(
+        InodeError(EINVAL, fileInode, "file is a symlink"));
+  }
+  return makeImmediateFuture<FileInodePtr>(std::move(fileInode));
+}
+
 facebook::eden::InodePtr inodeFromUserPath(
     facebook::eden::EdenMount& mount,
     StringPiece rootRelativePath,
@@ -520,14 +536,59 @@ void EdenServiceHandler::getSHA1(
     unique_ptr<vector<string>> paths) {
   TraceBlock block("getSHA1");
   auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint, toLogArg(*paths));
-  vector<ImmediateFuture<Hash20>> futures;
+  auto ticket =
+      admitExpensiveCall("getSHA1", helper->getFetchContext().getClientPid());
+  vector<folly::SemiFuture<Hash20>> futures;
+  futures.reserve(paths->size());
   auto mountPath = AbsolutePathPiece{*mountPoint};
-  for (const auto& path : *paths) {
+  auto& fetchContext = helper->getFetchContext();
+  if (paths->size() == 1) {
     futures.emplace_back(
-        getSHA1ForPathDefensively(mountPath, path, helper->getFetchContext()));
+        getSHA1ForPathDefensively(mountPath, paths->front(), fetchContext)
+            .semi());
+  } else {
+    // Build tools ask for thousands of hashes at once, of paths that share
+    // long prefixes. Resolve them together so that each directory is looked
+    // up once, and hash them on the CPU pool so that the hashing of
+    // materialized files proceeds in parallel rather than on this Thrift
+    // thread.
+    auto* threadPool = server_->getServerState()->getThreadPool().get();
+    auto edenMount = server_->getMount(mountPath);
+    std::vector<std::string> lookupPaths;
+    lookupPaths.reserve(paths->size());
+    for (const auto& path : *paths) {
+      if (!path.empty()) {
+        lookupPaths.push_back(path);
+      }
+    }
+    auto lookups = applyToInodes(
+        edenMount->getRootInode(),
+        lookupPaths,
+        [threadPool, &fetchContext](InodePtr inode) {
+          return folly::via(
+                     threadPool,
+                     [inode = std::move(inode), &fetchContext] {
+                       return asRegularFileInode(inode)
+                           .thenValue([&fetchContext](FileInodePtr fileInode) {
+                             return fileInode->getSha1(fetchContext);
+                           })
+                           .semi();
+                     })
+              .semi();
+        },
+        fetchContext);
+    size_t lookupIndex = 0;
+    for (const auto& path : *paths) {
+      if (path.empty()) {
+        futures.emplace_back(
+            getSHA1ForPathDefensively(mountPath, path, fetchContext).semi());
+      } else {
+        futures.emplace_back(std::move(lookups[lookupIndex++]));
+      }
+    }
   }
 
-  auto results = collectAll(std::move(futures)).get();
+  auto results = folly::collectAll(std::move(futures)).get();
   for (auto& result : results) {
     out.emplace_back();
     SHA1Result& sha1Result = out.back();
@@ -551,8 +612,18 @@ ImmediateFuture<Hash20> EdenServiceHandler::getSHA1ForPath(
     AbsolutePathPiece mountPoint,
     StringPiece path,
     ObjectFetchContext& fetchContext) {
+  return getRegularFileInode(mountPoint, path, fetchContext)
+      .thenValue([&fetchContext](FileInodePtr fileInode) {
+        return fileInode->getSha1(fetchContext);
+      });
+}
+
+ImmediateFuture<FileInodePtr> EdenServiceHandler::getRegularFileInode(
+    AbsolutePathPiece mountPoint,
+    StringPiece path,
+    ObjectFetchContext& fetchContext) {
   if (path.empty()) {
-    return ImmediateFuture<Hash20>(newEdenError(
+    return ImmediateFuture<FileInodePtr>(newEdenError(
         EINVAL,
         EdenErrorType::ARGUMENT_ERROR,
         "path cannot be the empty string"));
@@ -561,15 +632,49 @@ ImmediateFuture<Hash20> EdenServiceHandler::getSHA1ForPath(
   auto edenMount = server_->getMount(mountPoint);
   auto relativePath = RelativePathPiece{path};
   return edenMount->getInode(relativePath, fetchContext)
-      .thenValue([&fetchContext](const InodePtr& inode) {
-        auto fileInode = inode.asFilePtr();
-        if (fileInode->getType() != dtype_t::Regular) {
-          // We intentionally want to refuse to compute the SHA1 of symlinks
-          return makeImmediateFuture<Hash20>(
-              InodeError(EINVAL, fileInode, "file is a symlink"));
-        }
-        return fileInode->getSha1(fetchContext);
-      });
+      .thenValue(
+          [](const InodePtr& inode) { return asRegularFileInode(inode); });
+}
+
+void EdenServiceHandler::getBlake3(
+    vector<Blake3Result>& out,
+    unique_ptr<string> mountPoint,
+    unique_ptr<vector<string>> paths) {
+  TraceBlock block("getBlake3");
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint, toLogArg(*paths));
+  auto mountPath = AbsolutePathPiece{*mountPoint};
+  auto& fetchContext = helper->getFetchContext();
+  auto* threadPool = server_->getServerState()->getThreadPool().get();
+
+  // Hashing is CPU bound, and BLAKE3 is typically requested for large files,
+  // so even a single path is hashed on the CPU pool.
+  vector<folly::SemiFuture<Blake3Hash>> futures;
+  futures.reserve(paths->size());
+  for (const auto& path : *paths) {
+    futures.emplace_back(
+        folly::via(threadPool, [this, mountPath, &path, &fetchContext] {
+          return makeImmediateFutureWith([&] {
+                   return getRegularFileInode(mountPath, path, fetchContext)
+                       .thenValue([&fetchContext](FileInodePtr fileInode) {
+                         return fileInode->getBlake3(fetchContext);
+                       });
+                 })
+              .semi();
+        }).semi());
+  }
+
+  auto results = folly::collectAll(std::move(futures)).get();
+  for (auto& result : results) {
+    out.emplace_back();
+    Blake3Result& blake3Result = out.back();
+    if (result.hasValue()) {
+      const auto& hash = result.value();
+      blake3Result.set_blake3(
+          std::string{reinterpret_cast<const char*>(hash.data()), hash.size()});
+    } else {
+      blake3Result.set_error(newEdenError(result.exception()));
+    }
+  }
 }
 
 void EdenServiceHandler::getBindMounts(
@@ -599,6 +704,39 @@ void EdenServiceHandler::addBindMount(
 #endif
 }
 
+void EdenServiceHandler::addBindMounts(
+    FOLLY_MAYBE_UNUSED std::vector<BindMountResult>& out,
+    FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> mountPoint,
+    FOLLY_MAYBE_UNUSED std::unique_ptr<std::vector<BindMount>> bindMounts) {
+#ifndef _WIN32
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG3, *mountPoint, fmt::format("{} bind mounts", bindMounts->size()));
+  auto mountPath = AbsolutePathPiece{*mountPoint};
+  auto edenMount = server_->getMount(mountPath);
+
+  std::vector<std::pair<RelativePath, AbsolutePath>> paths;
+  paths.reserve(bindMounts->size());
+  for (const auto& bindMount : *bindMounts) {
+    paths.emplace_back(
+        RelativePath{*bindMount.repoPath_ref()},
+        AbsolutePath{*bindMount.targetPath_ref()});
+  }
+
+  auto results =
+      edenMount->addBindMounts(std::move(paths), helper->getFetchContext())
+          .get();
+  out.reserve(results.size());
+  for (auto& result : results) {
+    auto& bindMountResult = out.emplace_back();
+    if (result.hasException()) {
+      bindMountResult.error_ref() = newEdenError(result.exception());
+    }
+  }
+#else
+  NOT_IMPLEMENTED();
+#endif
+}
+
 void EdenServiceHandler::removeBindMount(
     FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> mountPoint,
     FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> repoPath) {
@@ -694,15 +832,66 @@ EdenServiceHandler::subscribeStreamTemporary(
   auto stream = std::make_shared<Publisher>(
       std::move(streamAndPublisher.second), std::move(disconnected));
 
+  // Notifications are sent at most once per journal:subscriber-min-interval.
+  // One that comes too soon after the previous one is delayed until the
+  // interval has passed, and any that come in the meantime are dropped: the
+  // delayed one tells the subscriber about them too.
+  struct Throttle {
+    std::chrono::steady_clock::time_point lastSent;
+    bool delayedSendScheduled = false;
+  };
+  auto throttle =
+      std::make_shared<folly::Synchronized<Throttle, std::mutex>>();
+  auto send = [stream = std::move(stream)] {
+    if (stream->disconnected->load()) {
+      return;
+    }
+    JournalPosition pos;
+    // The value is intentionally undefined and should not be used. Instead,
+    // the subscriber should call getCurrentJournalPosition or
+    // getFilesChangedSince.
+    stream->publisher.next(pos);
+  };
+
   // Register onJournalChange with the journal subsystem, and assign
   // the subscriber id into the handle so that the callbacks can consume it.
   handle->emplace(edenMount->getJournal().registerSubscriber(
-      [stream = std::move(stream)]() mutable {
-        JournalPosition pos;
-        // The value is intentionally undefined and should not be used. Instead,
-        // the subscriber should call getCurrentJournalPosition or
-        // getFilesChangedSince.
-        stream->publisher.next(pos);
+      [server = server_,
+       minInterval = std::chrono::duration_cast<std::chrono::milliseconds>(
+           server_->getServerState()
+               ->getEdenConfig()
+               ->journalSubscriberMinInterval.getValue()),
+       throttle = std::move(throttle),
+       send = std::move(send)]() mutable {
+        auto now = std::chrono::steady_clock::now();
+        auto state = throttle->lock();
+        if (state->delayedSendScheduled) {
+          return;
+        }
+        auto sinceLastSent = now - state->lastSent;
+        if (sinceLastSent >= minInterval) {
+          state->lastSent = now;
+          state.unlock();
+          send();
+          return;
+        }
+
+        state->delayedSendScheduled = true;
+        state.unlock();
+        auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(
+            minInterval - sinceLastSent);
+        server->getMainEventBase()->runInEventBaseThread(
+            [server, delay, throttle, send] {
+              server->scheduleCallbackOnMainEventBase(
+                  delay, [throttle, send] {
+                    {
+                      auto state = throttle->lock();
+                      state->lastSent = std::chrono::steady_clock::now();
+                      state->delayedSendScheduled = false;
+                    }
+                    send();
+                  });
+            });
       }));
 
   return std::move(streamAndPublisher.first);
@@ -943,28 +1132,95 @@ apache::thrift::ServerStream<FsEvent> EdenServiceHandler::traceFsEvents(
 
 #endif // _WIN32
 
-apache::thrift::ServerStream<HgEvent> EdenServiceHandler::traceHgEvents(
-    std::unique_ptr<std::string> mountPoint) {
-  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
-  auto mountPath = AbsolutePathPiece{*mountPoint};
-  auto edenMount = server_->getMount(mountPath);
-  auto backingStore = edenMount->getObjectStore()->getBackingStore();
-  std::shared_ptr<HgQueuedBackingStore> hgBackingStore{nullptr};
-
+namespace {
+/**
+ * Returns the mount's HgQueuedBackingStore, or null if it does not use one.
+ */
+std::shared_ptr<HgQueuedBackingStore> getHgQueuedBackingStore(
+    const std::shared_ptr<BackingStore>& backingStore) {
   // TODO: remove these dynamic casts in favor of a QueryInterface method
   // BackingStore -> LocalStoreCachedBackingStore
   auto localStoreCachedBackingStore =
       std::dynamic_pointer_cast<LocalStoreCachedBackingStore>(backingStore);
   if (!localStoreCachedBackingStore) {
     // BackingStore -> HgQueuedBackingStore
-    hgBackingStore =
-        std::dynamic_pointer_cast<HgQueuedBackingStore>(backingStore);
-  } else {
-    // LocalStoreCachedBackingStore -> HgQueuedBackingStore
-    hgBackingStore = std::dynamic_pointer_cast<HgQueuedBackingStore>(
-        localStoreCachedBackingStore->getBackingStore());
+    return std::dynamic_pointer_cast<HgQueuedBackingStore>(backingStore);
+  }
+  // LocalStoreCachedBackingStore -> HgQueuedBackingStore
+  return std::dynamic_pointer_cast<HgQueuedBackingStore>(
+      localStoreCachedBackingStore->getBackingStore());
+}
+
+HgEvent thriftHgEvent(const HgImportTraceRecord& record) {
+  HgEvent te;
+  te.times_ref() = thriftTraceEventTimes(record);
+  switch (record.eventType) {
+    case HgImportTraceEvent::QUEUE:
+      te.eventType_ref() = HgEventType::QUEUE;
+      break;
+    case HgImportTraceEvent::START:
+      te.eventType_ref() = HgEventType::START;
+      break;
+    case HgImportTraceEvent::FINISH:
+      te.eventType_ref() = HgEventType::FINISH;
+      break;
+  }
+
+  switch (record.resourceType) {
+    case HgImportTraceEvent::BLOB:
+      te.resourceType_ref() = HgResourceType::BLOB;
+      break;
+    case HgImportTraceEvent::TREE:
+      te.resourceType_ref() = HgResourceType::TREE;
+      break;
+  }
+
+  te.unique_ref() = record.unique;
+  te.manifestNodeId_ref() = record.manifestNodeId.toString();
+  te.path_ref() = record.path;
+  return te;
+}
+
+#ifndef _WIN32
+FsEvent thriftFsEvent(
+    const FuseTraceRecord& record,
+    ProcessNameCache& processNameCache) {
+  FsEvent te;
+  auto times = thriftTraceEventTimes(record);
+  te.times_ref() = times;
+
+  // Legacy timestamp fields.
+  te.timestamp_ref() = *times.timestamp_ref();
+  te.monotonic_time_ns_ref() = *times.monotonic_time_ns_ref();
+
+  te.fuseRequest_ref() =
+      populateFuseCall(record.unique, record.request, processNameCache);
+
+  switch (record.type) {
+    case FuseTraceEvent::START:
+      te.type_ref() = FsEventType::START;
+      break;
+    case FuseTraceEvent::FINISH:
+      te.type_ref() = FsEventType::FINISH;
+      te.result_ref().from_optional(record.result);
+      break;
   }
 
+  te.requestInfo_ref() =
+      thriftRequestInfo(record.request.pid, processNameCache);
+  return te;
+}
+#endif // _WIN32
+} // namespace
+
+apache::thrift::ServerStream<HgEvent> EdenServiceHandler::traceHgEvents(
+    std::unique_ptr<std::string> mountPoint) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
+  auto mountPath = AbsolutePathPiece{*mountPoint};
+  auto edenMount = server_->getMount(mountPath);
+  auto backingStore = edenMount->getObjectStore()->getBackingStore();
+  auto hgBackingStore = getHgQueuedBackingStore(backingStore);
+
   if (!hgBackingStore) {
     // typeid() does not evaluate expressions
     auto& r = *backingStore.get();
@@ -1052,16 +1308,49 @@ apache::thrift::ServerStream<HgEvent> EdenServiceHandler::traceHgEvents(
   return std::move(serverStream);
 }
 
-void EdenServiceHandler::getFilesChangedSince(
-    FileDelta& out,
-    std::unique_ptr<std::string> mountPoint,
-    std::unique_ptr<JournalPosition> fromPosition) {
+void EdenServiceHandler::debugDumpFlightRecorder(
+    FlightRecorderDump& result,
+    std::unique_ptr<std::string> mountPoint) {
   auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
   auto mountPath = AbsolutePathPiece{*mountPoint};
   auto edenMount = server_->getMount(mountPath);
 
-  if (*fromPosition->mountGeneration_ref() !=
-      static_cast<ssize_t>(edenMount->getMountGeneration())) {
+#ifndef _WIN32
+  if (auto* fuseChannel = edenMount->getFuseChannel()) {
+    auto& processNameCache = *server_->getServerState()->getProcessNameCache();
+    const auto& recorder = fuseChannel->getFlightRecorder();
+    for (const auto& record : recorder.getRecords()) {
+      result.fsEvents_ref()->push_back(
+          thriftFsEvent(record, processNameCache));
+    }
+    for (const auto& record : recorder.getSnapshot()) {
+      result.slowRequestFsEvents_ref()->push_back(
+          thriftFsEvent(record, processNameCache));
+    }
+  }
+#endif // _WIN32
+
+  if (auto hgBackingStore = getHgQueuedBackingStore(
+          edenMount->getObjectStore()->getBackingStore())) {
+    for (const auto& record :
+         hgBackingStore->getFlightRecorder().getRecords()) {
+      result.hgEvents_ref()->push_back(thriftHgEvent(record));
+    }
+  }
+}
+
+namespace {
+/**
+ * Maximum number of paths sent in each element of the streams returned by
+ * streamChangesSince and streamScmStatus.
+ */
+constexpr size_t kStreamBatchSize = 1024;
+
+void checkMountGeneration(
+    const JournalPosition& fromPosition,
+    const EdenMount& edenMount) {
+  if (*fromPosition.mountGeneration_ref() !=
+      static_cast<ssize_t>(edenMount.getMountGeneration())) {
     throw newEdenError(
         ERANGE,
         EdenErrorType::MOUNT_GENERATION_CHANGED,
@@ -1069,42 +1358,72 @@ void EdenServiceHandler::getFilesChangedSince(
         "mountGeneration.  "
         "You need to compute a new basis for delta queries.");
   }
+}
 
-  // The +1 is because the core merge stops at the item prior to
-  // its limitSequence parameter and we want the changes *since*
-  // the provided sequence number.
-  auto summed = edenMount->getJournal().accumulateRange(
-      *fromPosition->sequenceNumber_ref() + 1);
-
+/**
+ * Sets the positions of a FileDelta computed from fromPosition, given the
+ * journal range accumulated since then, which is null if nothing changed.
+ */
+void setFileDeltaPositions(
+    FileDelta& out,
+    const JournalPosition& fromPosition,
+    const EdenMount& edenMount,
+    const JournalDeltaRange* summed) {
   // We set the default toPosition to be where we where if summed is null
   out.toPosition_ref()->sequenceNumber_ref() =
-      *fromPosition->sequenceNumber_ref();
-  out.toPosition_ref()->snapshotHash_ref() = *fromPosition->snapshotHash_ref();
-  out.toPosition_ref()->mountGeneration_ref() = edenMount->getMountGeneration();
+      *fromPosition.sequenceNumber_ref();
+  out.toPosition_ref()->snapshotHash_ref() = *fromPosition.snapshotHash_ref();
+  out.toPosition_ref()->mountGeneration_ref() = edenMount.getMountGeneration();
 
   out.fromPosition_ref() = *out.toPosition_ref();
 
   if (summed) {
-    if (summed->isTruncated) {
-      throw newEdenError(
-          EDOM,
-          EdenErrorType::JOURNAL_TRUNCATED,
-          "Journal entry range has been truncated.");
-    }
-
-    RootIdCodec& rootIdCodec = *edenMount->getObjectStore();
+    RootIdCodec& rootIdCodec = *edenMount.getObjectStore();
 
     out.toPosition_ref()->sequenceNumber_ref() = summed->toSequence;
     out.toPosition_ref()->snapshotHash_ref() =
         rootIdCodec.renderRootId(summed->snapshotTransitions.back());
     out.toPosition_ref()->mountGeneration_ref() =
-        edenMount->getMountGeneration();
+        edenMount.getMountGeneration();
 
     out.fromPosition_ref()->sequenceNumber_ref() = summed->fromSequence;
     out.fromPosition_ref()->snapshotHash_ref() =
         rootIdCodec.renderRootId(summed->snapshotTransitions.front());
     out.fromPosition_ref()->mountGeneration_ref() =
         *out.toPosition_ref()->mountGeneration_ref();
+  }
+}
+
+void checkNotTruncated(const JournalDeltaRange* summed) {
+  if (summed && summed->isTruncated) {
+    throw newEdenError(
+        EDOM,
+        EdenErrorType::JOURNAL_TRUNCATED,
+        "Journal entry range has been truncated.");
+  }
+}
+} // namespace
+
+void EdenServiceHandler::getFilesChangedSince(
+    FileDelta& out,
+    std::unique_ptr<std::string> mountPoint,
+    std::unique_ptr<JournalPosition> fromPosition) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
+  auto mountPath = AbsolutePathPiece{*mountPoint};
+  auto edenMount = server_->getMount(mountPath);
+  checkMountGeneration(*fromPosition, *edenMount);
+
+  // The +1 is because the core merge stops at the item prior to
+  // its limitSequence parameter and we want the changes *since*
+  // the provided sequence number.
+  auto summed = edenMount->getJournal().accumulateRange(
+      *fromPosition->sequenceNumber_ref() + 1);
+  checkNotTruncated(summed.get());
+
+  setFileDeltaPositions(out, *fromPosition, *edenMount, summed.get());
+
+  if (summed) {
+    RootIdCodec& rootIdCodec = *edenMount->getObjectStore();
 
     for (const auto& entry : summed->changedFilesInOverlay) {
       auto& path = entry.first;
@@ -1127,6 +1446,75 @@ void EdenServiceHandler::getFilesChangedSince(
   }
 }
 
+apache::thrift::ServerStream<FileDelta> EdenServiceHandler::streamChangesSince(
+    std::unique_ptr<std::string> mountPoint,
+    std::unique_ptr<JournalPosition> fromPosition) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
+  auto mountPath = AbsolutePathPiece{*mountPoint};
+  auto edenMount = server_->getMount(mountPath);
+  checkMountGeneration(*fromPosition, *edenMount);
+
+  auto summed = edenMount->getJournal().accumulateRange(
+      *fromPosition->sequenceNumber_ref() + 1);
+  // Errors are reported before the stream is created, so that clients see
+  // them as failures of the call itself, as with getFilesChangedSince.
+  checkNotTruncated(summed.get());
+
+  FileDelta positions;
+  setFileDeltaPositions(positions, *fromPosition, *edenMount, summed.get());
+
+  auto streamAndPublisher =
+      apache::thrift::ServerStream<FileDelta>::createPublisher([] {});
+  auto& publisher = streamAndPublisher.second;
+
+  // The journal range is already summarized in memory, but its paths are
+  // only converted to thrift strings one batch at a time, and each batch is
+  // serialized on its own.
+  FileDelta batch = positions;
+  size_t batchPaths = 0;
+  auto flush = [&] {
+    publisher.next(std::move(batch));
+    batch = positions;
+    batchPaths = 0;
+  };
+
+  if (summed) {
+    RootIdCodec& rootIdCodec = *edenMount->getObjectStore();
+    batch.snapshotTransitions_ref()->reserve(
+        summed->snapshotTransitions.size());
+    for (auto& hash : summed->snapshotTransitions) {
+      batch.snapshotTransitions_ref()->push_back(
+          rootIdCodec.renderRootId(hash));
+    }
+
+    for (const auto& entry : summed->changedFilesInOverlay) {
+      auto& path = entry.first;
+      auto& changeInfo = entry.second;
+      if (changeInfo.isNew()) {
+        batch.createdPaths_ref()->emplace_back(path.stringPiece().str());
+      } else {
+        batch.changedPaths_ref()->emplace_back(path.stringPiece().str());
+      }
+      if (++batchPaths == kStreamBatchSize) {
+        flush();
+      }
+    }
+
+    for (auto& path : summed->uncleanPaths) {
+      batch.uncleanPaths_ref()->emplace_back(path.stringPiece().str());
+      if (++batchPaths == kStreamBatchSize) {
+        flush();
+      }
+    }
+  }
+
+  // Always send a last, possibly empty, batch so that a range without
+  // changes still reports its positions.
+  publisher.next(std::move(batch));
+  std::move(publisher).complete();
+  return std::move(streamAndPublisher.first);
+}
+
 void EdenServiceHandler::setJournalMemoryLimit(
     std::unique_ptr<PathString> mountPoint,
     int64_t limit) {
@@ -1269,6 +1657,134 @@ EdenServiceHandler::semifuture_getFileInformation(
           }));
 }
 
+namespace {
+using GlobRoot = std::variant<TreeInodePtr, std::shared_ptr<const Tree>>;
+
+/**
+ * Find the directory at path below root to evaluate a glob against.
+ *
+ * Inodes are only loaded for materialized directories. Below the first
+ * directory on the path that is not materialized, the source control trees
+ * describe the working copy exactly, and walking them instead does not grow
+ * the InodeMap. GlobNode applies the same rule while evaluating.
+ */
+ImmediateFuture<GlobRoot> resolveGlobRoot(
+    std::shared_ptr<EdenMount> edenMount,
+    TreeInodePtr root,
+    RelativePath path,
+    ObjectFetchContext& fetchContext) {
+  if (path.empty()) {
+    return GlobRoot{std::move(root)};
+  }
+
+  auto pathStr = path.stringPiece();
+  auto slash = pathStr.find('/');
+  auto name = PathComponent{pathStr.subpiece(0, slash)};
+  auto rest = slash == folly::StringPiece::npos
+      ? RelativePath{}
+      : RelativePath{pathStr.subpiece(slash + 1)};
+
+  std::optional<ObjectId> treeId;
+  {
+    auto contents = root->getContents().rlock();
+    auto it = contents->entries.find(name);
+    if (it != contents->entries.end() && it->second.isDirectory() &&
+        !it->second.isMaterialized()) {
+      treeId = it->second.getHash();
+    }
+  }
+
+  if (!treeId) {
+    // getOrLoadChildTree reports missing children and non-directories.
+    return root->getOrLoadChildTree(name, fetchContext)
+        .thenValue([edenMount = std::move(edenMount),
+                    rest = std::move(rest),
+                    &fetchContext](TreeInodePtr child) mutable {
+          return resolveGlobRoot(
+              std::move(edenMount),
+              std::move(child),
+              std::move(rest),
+              fetchContext);
+        });
+  }
+
+  return edenMount->getObjectStore()
+      ->getTree(*treeId, fetchContext)
+      .thenValue([edenMount = std::move(edenMount),
+                  rest = std::move(rest),
+                  &fetchContext](std::shared_ptr<const Tree> tree) {
+        return ImmediateFuture<GlobRoot>{
+            resolveTree(
+                *edenMount->getObjectStore(),
+                fetchContext,
+                std::move(tree),
+                rest)
+                .thenValue([](std::shared_ptr<const Tree> dir) {
+                  return GlobRoot{std::move(dir)};
+                })
+                .semi()};
+      });
+}
+
+void appendGlobResults(
+    const GlobResultCache::Entries& entries,
+    const RootId& originRootId,
+    GlobNode::ResultList& globResults) {
+  auto locked = globResults.wlock();
+  locked->reserve(locked->size() + entries.size());
+  for (const auto& entry : entries) {
+    locked->emplace_back(entry.name, entry.dtype, originRootId);
+  }
+}
+
+/**
+ * Evaluate a glob through the mount's GlobResultCache.
+ *
+ * The results cached under key are used when present. Otherwise,
+ * evaluate(GlobNode::ResultList&) computes them, and they are cached if
+ * isStillValid() returns true once they are known.
+ */
+template <typename Evaluate, typename IsStillValid>
+ImmediateFuture<folly::Unit> evaluateCachedGlob(
+    std::shared_ptr<EdenMount> edenMount,
+    std::string key,
+    const RootId& originRootId,
+    std::shared_ptr<GlobNode::ResultList> globResults,
+    Evaluate&& evaluate,
+    IsStillValid&& isStillValid) {
+  if (auto cached = edenMount->getGlobResultCache().get(key)) {
+    appendGlobResults(*cached, originRootId, *globResults);
+    return folly::unit;
+  }
+
+  auto results = std::make_shared<GlobNode::ResultList>();
+  return evaluate(*results).thenValue(
+      [edenMount = std::move(edenMount),
+       key = std::move(key),
+       &originRootId,
+       globResults = std::move(globResults),
+       results,
+       isStillValid = std::forward<IsStillValid>(isStillValid)](
+          folly::Unit) mutable {
+        auto sorted = std::move(*results->wlock());
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+        auto entries = std::make_shared<GlobResultCache::Entries>();
+        entries->reserve(sorted.size());
+        for (auto& result : sorted) {
+          entries->push_back({std::move(result.name), result.dtype});
+        }
+
+        appendGlobResults(*entries, originRootId, *globResults);
+        if (isStillValid()) {
+          edenMount->getGlobResultCache().insert(
+              std::move(key), std::move(entries));
+        }
+      });
+}
+} // namespace
+
 folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
     folly::StringPiece mountPoint,
     std::vector<std::string> globs,
@@ -1276,7 +1792,8 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
     folly::StringPiece searchRootUser,
     GlobOptions globOptions,
     folly::StringPiece caller,
-    std::optional<pid_t> pid) {
+    std::optional<pid_t> pid,
+    apache::thrift::ResponseChannelRequest* request) {
   auto helper = INSTRUMENT_THRIFT_CALL_WITH_FUNCTION_NAME_AND_PID(
       DBG3,
       caller,
@@ -1306,13 +1823,37 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
     throw newEdenError(exc);
   }
 
-  auto fileBlobsToPrefetch = globOptions.prefetchFiles
-      ? std::make_shared<GlobNode::PrefetchList>()
-      : nullptr;
-
   auto& fetchContext = helper->getFetchContext();
   fetchContext.setPrefetchMetadata(globOptions.prefetchMetadata);
 
+  // Matched blobs are fetched in batches while the walk continues, instead of
+  // all at once when it ends. fetchContext outlives the prefetcher, since the
+  // result of the glob waits for all the batches.
+  std::shared_ptr<GlobPrefetcher> fileBlobsToPrefetch;
+  if (globOptions.prefetchFiles) {
+    auto config = server_->getServerState()->getEdenConfig();
+    fileBlobsToPrefetch = GlobPrefetcher::create(
+        [store = edenMount->getObjectStore(),
+         &fetchContext](std::vector<ObjectId> ids) {
+          auto batch = std::make_shared<std::vector<ObjectId>>(std::move(ids));
+          return store
+              ->prefetchBlobs(
+                  folly::Range{batch->data(), batch->size()}, fetchContext)
+              .ensure([batch] {});
+        },
+        config->globPrefetchBatchSize.getValue(),
+        config->globPrefetchMaxInFlightBatches.getValue(),
+        [request] { return request && !request->isActive(); });
+  }
+
+  // Prefetching needs the walk itself, so those globs are never cached.
+  auto useCache = edenMount->getGlobResultCache().isEnabled() &&
+      !globOptions.prefetchFiles && !globOptions.suppressFileList;
+  auto cacheGlobs = useCache
+      ? std::make_shared<std::vector<std::string>>(globs)
+      : nullptr;
+  auto includeDotfiles = globOptions.includeDotfiles;
+
   // These hashes must outlive the GlobResult created by evaluate as the
   // GlobResults will hold on to references to these hashes
   auto originRootIds = std::make_unique<std::vector<RootId>>();
@@ -1350,16 +1891,42 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
                    &fetchContext,
                    fileBlobsToPrefetch,
                    globResults,
-                   &originRootId](std::shared_ptr<const Tree>&& tree) mutable {
-                    return globRoot
-                        ->evaluate(
-                            edenMount->getObjectStore(),
-                            fetchContext,
-                            RelativePathPiece(),
-                            std::move(tree),
-                            fileBlobsToPrefetch.get(),
-                            *globResults,
-                            originRootId)
+                   &originRootId,
+                   cacheGlobs,
+                   includeDotfiles](
+                      std::shared_ptr<const Tree>&& tree) mutable {
+                    if (!cacheGlobs) {
+                      return globRoot
+                          ->evaluate(
+                              edenMount->getObjectStore(),
+                              fetchContext,
+                              RelativePathPiece(),
+                              std::move(tree),
+                              fileBlobsToPrefetch.get(),
+                              *globResults,
+                              originRootId)
+                          .semi();
+                    }
+
+                    // Trees never change, so their results are always valid.
+                    auto key = GlobResultCache::makeKey(
+                        *cacheGlobs, includeDotfiles, tree->getHash());
+                    return evaluateCachedGlob(
+                               edenMount,
+                               std::move(key),
+                               originRootId,
+                               globResults,
+                               [&](GlobNode::ResultList& results) {
+                                 return globRoot->evaluate(
+                                     edenMount->getObjectStore(),
+                                     fetchContext,
+                                     RelativePathPiece(),
+                                     std::move(tree),
+                                     nullptr,
+                                     results,
+                                     originRootId);
+                               },
+                               [] { return true; })
                         .semi();
                   }));
     }
@@ -1367,21 +1934,56 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
     const RootId& originRootId =
         originRootIds->emplace_back(edenMount->getParentCommit());
     globFutures.emplace_back(
-        edenMount->getInode(searchRoot, fetchContext)
+        resolveGlobRoot(
+            edenMount, edenMount->getRootInode(), searchRoot, fetchContext)
             .thenValue([&fetchContext,
                         globRoot,
                         edenMount,
                         fileBlobsToPrefetch,
                         globResults,
-                        &originRootId](InodePtr inode) mutable {
-              return globRoot->evaluate(
-                  edenMount->getObjectStore(),
-                  fetchContext,
-                  RelativePathPiece(),
-                  inode.asTreePtr(),
-                  fileBlobsToPrefetch.get(),
-                  *globResults,
-                  originRootId);
+                        &originRootId,
+                        cacheGlobs,
+                        includeDotfiles,
+                        searchRoot](GlobRoot dir) mutable {
+              auto evaluateDir = [&](GlobNode::ResultList& results,
+                                     GlobNode::PrefetchList* prefetchList) {
+                return std::visit(
+                    [&](auto& root) {
+                      return globRoot->evaluate(
+                          edenMount->getObjectStore(),
+                          fetchContext,
+                          RelativePathPiece(),
+                          std::move(root),
+                          prefetchList,
+                          results,
+                          originRootId);
+                    },
+                    dir);
+              };
+
+              if (!cacheGlobs) {
+                return evaluateDir(*globResults, fileBlobsToPrefetch.get());
+              }
+
+              // Any change to the working copy is journaled, so results are
+              // only valid for the journal position they were computed at.
+              // Changes made during the walk may or may not be reflected in
+              // the results, which are then not cached.
+              auto sequence = edenMount->getJournal().getLatestSequenceNumber();
+              auto key = GlobResultCache::makeKey(
+                  *cacheGlobs, includeDotfiles, searchRoot, sequence);
+              return evaluateCachedGlob(
+                  edenMount,
+                  std::move(key),
+                  originRootId,
+                  globResults,
+                  [&](GlobNode::ResultList& results) {
+                    return evaluateDir(results, nullptr);
+                  },
+                  [edenMount, sequence] {
+                    return edenMount->getJournal().getLatestSequenceNumber() ==
+                        sequence;
+                  });
             })
             .semi()
             .via(&folly::QueuedImmediateExecutor::instance()));
@@ -1390,8 +1992,19 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
   auto prefetchFuture = wrapFuture(
       std::move(helper),
       folly::collectAllUnsafe(std::move(globFutures))
-          .thenValue([fileBlobsToPrefetch,
-                      globResults = std::move(globResults),
+          .thenValue([fileBlobsToPrefetch](
+                         std::vector<folly::Try<folly::Unit>>&& tries) {
+            if (!fileBlobsToPrefetch) {
+              return makeFuture(std::move(tries));
+            }
+            // The batches use fetchContext, so even a failed glob must wait
+            // for the ones already started.
+            return fileBlobsToPrefetch->finish().thenValue(
+                [tries = std::move(tries)](folly::Unit) mutable {
+                  return std::move(tries);
+                });
+          })
+          .thenValue([globResults = std::move(globResults),
                       suppressFileList = globOptions.suppressFileList](
                          std::vector<folly::Try<folly::Unit>>&& tries) {
             std::vector<GlobNode::GlobResult> sortedResults;
@@ -1405,31 +2018,12 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
                   std::unique(sortedResults.begin(), sortedResults.end());
               sortedResults.erase(resultsNewEnd, sortedResults.end());
             }
-
-            // fileBlobsToPrefetch is deduplicated as an optimization.
-            // The BackingStore layer does not deduplicate fetches, so lets
-            // avoid causing too many duplicates here.
-            if (fileBlobsToPrefetch) {
-              auto fileBlobsToPrefetchLocked = fileBlobsToPrefetch->wlock();
-              std::sort(
-                  fileBlobsToPrefetchLocked->begin(),
-                  fileBlobsToPrefetchLocked->end());
-              auto fileBlobsToPrefetchNewEnd = std::unique(
-                  fileBlobsToPrefetchLocked->begin(),
-                  fileBlobsToPrefetchLocked->end());
-              fileBlobsToPrefetchLocked->erase(
-                  fileBlobsToPrefetchNewEnd, fileBlobsToPrefetchLocked->end());
-            }
-
             return sortedResults;
           })
           .thenValue([edenMount,
                       wantDtype = globOptions.wantDtype,
-                      fileBlobsToPrefetch,
                       suppressFileList = globOptions.suppressFileList,
-                      listOnlyFiles = globOptions.listOnlyFiles,
-                      &fetchContext,
-                      config = server_->getServerState()->getEdenConfig()](
+                      listOnlyFiles = globOptions.listOnlyFiles](
                          std::vector<GlobNode::GlobResult>&& results) mutable {
             auto out = std::make_unique<Glob>();
 
@@ -1451,29 +2045,7 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
                 }
               }
             }
-            if (fileBlobsToPrefetch) {
-              std::vector<folly::Future<folly::Unit>> futures;
-
-              auto store = edenMount->getObjectStore();
-              auto blobs = fileBlobsToPrefetch->rlock();
-              auto range = folly::Range{blobs->data(), blobs->size()};
-
-              while (range.size() > 20480) {
-                auto curRange = range.subpiece(0, 20480);
-                range.advance(20480);
-                futures.emplace_back(
-                    store->prefetchBlobs(curRange, fetchContext));
-              }
-              if (!range.empty()) {
-                futures.emplace_back(store->prefetchBlobs(range, fetchContext));
-              }
-
-              return folly::collectUnsafe(futures).thenValue(
-                  [glob = std::move(out), fileBlobsToPrefetch](auto&&) mutable {
-                    return makeFuture(std::move(glob));
-                  });
-            }
-            return makeFuture(std::move(out));
+            return out;
           })
           .ensure([globRoot, originRootIds = std::move(originRootIds)]() {
             // keep globRoot and originRootIds alive until the end
@@ -1497,19 +2069,29 @@ EdenServiceHandler::future_setPathObjectId(
   auto helper = INSTRUMENT_THRIFT_CALL(DBG1, mountPoint);
   auto mountPath = AbsolutePathPiece{mountPoint};
   auto edenMount = server_->getMount(mountPath);
-  auto parsedRootId =
-      edenMount->getObjectStore()->parseRootId(params->get_objectId());
   auto& fetchContext = helper->getFetchContext();
 
+  std::vector<SetPathObjectIdObjectAndPath> objects;
+  if (params->get_objects().empty()) {
+    objects.push_back(SetPathObjectIdObjectAndPath{
+        RelativePath{params->get_path()},
+        edenMount->getObjectStore()->parseRootId(params->get_objectId()),
+        params->get_type()});
+  } else {
+    objects.reserve(params->get_objects().size());
+    for (const auto& object : params->get_objects()) {
+      objects.push_back(SetPathObjectIdObjectAndPath{
+          RelativePath{object.get_path()},
+          edenMount->getObjectStore()->parseRootId(object.get_objectId()),
+          object.get_type()});
+    }
+  }
+
   return wrapFuture(
       std::move(helper),
       edenMount
-          ->setPathObjectId(
-              RelativePathPiece{params->get_path()},
-              parsedRootId,
-              params->get_type(),
-              params->get_mode(),
-              fetchContext)
+          ->setPathsToObjectIds(
+              std::move(objects), params->get_mode(), fetchContext)
           .thenValue([](auto&& resultAndTimes) {
             return std::make_unique<SetPathObjectIdResult>(
                 std::move(resultAndTimes.result));
@@ -1617,17 +2199,30 @@ EdenServiceHandler::future_predictiveGlobFiles(
 #endif // !EDEN_HAVE_USAGE_SERVICE
 }
 
-folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::future_globFiles(
+void EdenServiceHandler::async_tm_globFiles(
+    std::unique_ptr<apache::thrift::HandlerCallback<std::unique_ptr<Glob>>>
+        callback,
     std::unique_ptr<GlobParams> params) {
   GlobOptions globOptions{*params};
-  return globFilesImpl(
-      *params->mountPoint_ref(),
-      *params->globs_ref(),
-      *params->revisions_ref(),
-      *params->searchRoot_ref(),
-      globOptions,
-      __func__,
-      getAndRegisterClientPid());
+  // A background glob outlives its request, which then can't cancel it.
+  auto* request = globOptions.background ? nullptr : callback->getRequest();
+  folly::makeFutureWith([&, func = __func__, pid = getAndRegisterClientPid()] {
+    auto ticket = admitExpensiveCall("globFiles", pid);
+    return globFilesImpl(
+               *params->mountPoint_ref(),
+               *params->globs_ref(),
+               *params->revisions_ref(),
+               *params->searchRoot_ref(),
+               globOptions,
+               func,
+               pid,
+               request)
+        .ensure([ticket = std::move(ticket)] {});
+  })
+      .thenTry([cb = std::move(callback), params = std::move(params)](
+                   folly::Try<std::unique_ptr<Glob>>&& result) {
+        cb->complete(std::move(result));
+      });
 }
 
 folly::Future<Unit> EdenServiceHandler::future_chown(
@@ -1649,6 +2244,7 @@ void EdenServiceHandler::async_tm_getScmStatusV2(
     unique_ptr<GetScmStatusParams> params) {
   auto* request = callback->getRequest();
   folly::makeFutureWith([&, func = __func__, pid = getAndRegisterClientPid()] {
+    auto ticket = admitExpensiveCall("getScmStatusV2", pid);
     auto helper = INSTRUMENT_THRIFT_CALL_WITH_FUNCTION_NAME_AND_PID(
         DBG2,
         func,
@@ -1666,13 +2262,20 @@ void EdenServiceHandler::async_tm_getScmStatusV2(
                                      ->enforceParents.getValue();
     return wrapFuture(
         std::move(helper),
-        mount->diff(rootId, *params->listIgnored_ref(), enforceParents, request)
+        mount
+            ->diff(
+                rootId,
+                *params->listIgnored_ref(),
+                enforceParents,
+                request,
+                *params->summarizeUntrackedDirectories_ref())
             .thenValue([this, mount](std::unique_ptr<ScmStatus>&& status) {
               auto result = std::make_unique<GetScmStatusResult>();
               *result->status_ref() = std::move(*status);
               *result->version_ref() = server_->getVersion();
               return result;
-            }));
+            })
+            .ensure([ticket = std::move(ticket)] {}));
   })
       .thenTry([cb = std::move(callback)](
                    folly::Try<std::unique_ptr<GetScmStatusResult>>&& result) {
@@ -1680,6 +2283,153 @@ void EdenServiceHandler::async_tm_getScmStatusV2(
       });
 }
 
+namespace {
+/**
+ * Publishes the results of a diff as a stream of ScmStatus batches, as the
+ * diff finds them.
+ *
+ * The diff reports paths from many threads at once, so each batch is
+ * protected by a lock, which is also held while a full batch is handed to
+ * the publisher.
+ */
+class StreamingScmStatusCallback : public DiffCallback {
+ public:
+  explicit StreamingScmStatusCallback(
+      apache::thrift::ServerStreamPublisher<ScmStatus> publisher)
+      : state_{folly::in_place, std::move(publisher)} {}
+
+  // Destroying a publisher without calling complete() aborts the process.
+  ~StreamingScmStatusCallback() override {
+    auto state = state_.wlock();
+    if (state->publisher) {
+      std::move(*state->publisher).complete();
+    }
+  }
+
+  void ignoredFile(RelativePathPiece path) override {
+    addEntry(path, ScmFileStatus::IGNORED);
+  }
+
+  void addedFile(RelativePathPiece path) override {
+    addEntry(path, ScmFileStatus::ADDED);
+  }
+
+  void addedDirectory(RelativePathPiece path) override {
+    addEntry(folly::to<std::string>(path, "/"), ScmFileStatus::ADDED);
+  }
+
+  void removedFile(RelativePathPiece path) override {
+    addEntry(path, ScmFileStatus::REMOVED);
+  }
+
+  void modifiedFile(RelativePathPiece path) override {
+    addEntry(path, ScmFileStatus::MODIFIED);
+  }
+
+  void diffError(RelativePathPiece path, const folly::exception_wrapper& ew)
+      override {
+    XLOG(WARNING) << "error computing status data for " << path << ": "
+                  << folly::exceptionStr(ew);
+    auto state = state_.wlock();
+    state->batch.errors_ref()->emplace(
+        path.stringPiece().str(), folly::exceptionStr(ew).toStdString());
+    maybeFlush(*state);
+  }
+
+  /**
+   * Sends the last batch and completes the stream, with the diff's error if
+   * it failed. Must be called once the diff has completed.
+   */
+  void finish(folly::exception_wrapper ew) {
+    auto state = state_.wlock();
+    auto publisher = std::move(*state->publisher);
+    state->publisher.reset();
+    if (ew) {
+      std::move(publisher).complete(std::move(ew));
+      return;
+    }
+    if (state->batchSize > 0) {
+      publisher.next(std::move(state->batch));
+    }
+    std::move(publisher).complete();
+  }
+
+ private:
+  struct State {
+    explicit State(apache::thrift::ServerStreamPublisher<ScmStatus> publisher)
+        : publisher{std::move(publisher)} {}
+
+    // Reset once the stream is completed.
+    std::optional<apache::thrift::ServerStreamPublisher<ScmStatus>> publisher;
+    ScmStatus batch;
+    size_t batchSize = 0;
+  };
+
+  void addEntry(RelativePathPiece path, ScmFileStatus status) {
+    addEntry(path.stringPiece().str(), status);
+  }
+
+  void addEntry(std::string path, ScmFileStatus status) {
+    auto state = state_.wlock();
+    state->batch.entries_ref()->emplace(std::move(path), status);
+    maybeFlush(*state);
+  }
+
+  static void maybeFlush(State& state) {
+    if (++state.batchSize < kStreamBatchSize) {
+      return;
+    }
+    state.publisher->next(std::move(state.batch));
+    state.batch = ScmStatus{};
+    state.batchSize = 0;
+  }
+
+  folly::Synchronized<State, std::mutex> state_;
+};
+} // namespace
+
+apache::thrift::ServerStream<ScmStatus> EdenServiceHandler::streamScmStatus(
+    std::unique_ptr<GetScmStatusParams> params) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2,
+      *params->mountPoint_ref(),
+      folly::to<string>("commitHash=", logHash(*params->commit_ref())),
+      folly::to<string>("listIgnored=", *params->listIgnored_ref()));
+
+  auto mountPath = AbsolutePathPiece{*params->mountPoint_ref()};
+  auto mount = server_->getMount(mountPath);
+  auto rootId = mount->getObjectStore()->parseRootId(*params->commit_ref());
+  const auto& enforceParents = server_->getServerState()
+                                   ->getReloadableConfig()
+                                   .getEdenConfig()
+                                   ->enforceParents.getValue();
+
+  auto streamAndPublisher =
+      apache::thrift::ServerStream<ScmStatus>::createPublisher([] {});
+  auto callback = std::make_shared<StreamingScmStatusCallback>(
+      std::move(streamAndPublisher.second));
+
+  // The callback and the mount must outlive the diff. Without a thrift
+  // request to check, the diff is not cancelled when the client goes away;
+  // the batches it still produces are dropped.
+  mount
+      ->diff(
+          callback.get(),
+          rootId,
+          *params->listIgnored_ref(),
+          enforceParents,
+          nullptr,
+          *params->summarizeUntrackedDirectories_ref())
+      .thenTry([callback, mount, helper = std::move(helper)](
+                   folly::Try<folly::Unit>&& result) {
+        callback->finish(
+            result.hasException() ? std::move(result.exception())
+                                  : folly::exception_wrapper{});
+      });
+
+  return std::move(streamAndPublisher.first);
+}
+
 void EdenServiceHandler::async_tm_getScmStatus(
     unique_ptr<apache::thrift::HandlerCallback<unique_ptr<ScmStatus>>> callback,
     unique_ptr<string> mountPoint,
@@ -1727,9 +2477,12 @@ EdenServiceHandler::future_getScmStatusBetweenRevisions(
   auto mount = server_->getMount(mountPath);
   auto id1 = mount->getObjectStore()->parseRootId(*oldHash);
   auto id2 = mount->getObjectStore()->parseRootId(*newHash);
+  auto batchSize = server_->getServerState()
+                       ->getEdenConfig()
+                       ->commitDiffBatchSize.getValue();
   return wrapFuture(
       std::move(helper),
-      diffCommitsForStatus(mount->getObjectStore(), id1, id2));
+      diffCommitsForStatus(mount->getObjectStore(), id1, id2, batchSize));
 }
 
 void EdenServiceHandler::debugGetScmTree(
@@ -2182,6 +2935,13 @@ void EdenServiceHandler::getAccessCounts(
     for (auto& [pid, fetchCount] : *pidFetches.rlock()) {
       ma.fetchCountsByPid_ref()[pid] = fetchCount;
     }
+
+    auto& backingStoreFetches =
+        mount->getObjectStore()->getPidBackingStoreFetches();
+    for (auto& [pid, fetches] : *backingStoreFetches.rlock()) {
+      ma.backingStoreFetchCountsByPid_ref()[pid] = fetches.count;
+      ma.backingStoreFetchBytesByPid_ref()[pid] = fetches.bytes;
+    }
   }
 }
 
@@ -2326,6 +3086,13 @@ void EdenServiceHandler::getStatInfo(
     result.treeCacheStats_ref()->evictionCount_ref() =
         treeCacheStats.evictionCount;
   }
+
+  if (statsMask & eden_constants::STATS_MEMORY_USAGE_) {
+    auto& memoryUsage = result.memoryUsage_ref().emplace();
+    for (auto& [name, bytes] : server_->getMemoryGovernor().getUsage()) {
+      memoryUsage[name] = bytes;
+    }
+  }
 }
 
 void EdenServiceHandler::flushStatsNow() {
@@ -2396,6 +3163,60 @@ void EdenServiceHandler::getTracePoints(std::vector<TracePoint>& result) {
   }
 }
 
+void EdenServiceHandler::getSlowRequests(std::vector<SlowRequest>& result) {
+  for (auto& request : SlowRequestLog::get().getRequests()) {
+    SlowRequest slow;
+    slow.requestId_ref() = request.requestId;
+    slow.operation_ref() = std::move(request.operation);
+    if (request.pid) {
+      slow.pid_ref() = *request.pid;
+    }
+    slow.finishTime_ref() =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            request.finishTime.time_since_epoch())
+            .count();
+    slow.durationNs_ref() = request.duration.count();
+    slow.localStoreNs_ref() = request.localStore.count();
+    slow.importQueueNs_ref() = request.importQueue.count();
+    slow.backingStoreFetchNs_ref() = request.backingStoreFetch.count();
+    result.emplace_back(std::move(slow));
+  }
+}
+
+folly::SemiFuture<std::unique_ptr<std::string>>
+EdenServiceHandler::semifuture_debugProfileCpu(
+    FOLLY_MAYBE_UNUSED int64_t durationMs,
+    FOLLY_MAYBE_UNUSED int32_t frequency) {
+#ifndef _WIN32
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG1, durationMs, frequency);
+  // Keep a forgotten profile from sampling for hours.
+  constexpr int64_t kMaxProfileDurationMs = 10 * 60 * 1000;
+  if (durationMs <= 0 || durationMs > kMaxProfileDurationMs) {
+    throw newEdenError(
+        EINVAL,
+        EdenErrorType::ARGUMENT_ERROR,
+        "durationMs must be between 1 and ",
+        kMaxProfileDurationMs);
+  }
+  if (frequency <= 0 || frequency > 1000) {
+    throw newEdenError(
+        EINVAL,
+        EdenErrorType::ARGUMENT_ERROR,
+        "frequency must be between 1 and 1000");
+  }
+  return wrapSemiFuture(
+      std::move(helper),
+      SamplingProfiler::profile(
+          std::chrono::milliseconds{durationMs},
+          static_cast<uint32_t>(frequency))
+          .deferValue([](std::string stacks) {
+            return std::make_unique<std::string>(std::move(stacks));
+          }));
+#else
+  NOT_IMPLEMENTED();
+#endif // !_WIN32
+}
+
 namespace {
 std::optional<folly::exception_wrapper> getFaultError(
     apache::thrift::optional_field_ref<std::string&> errorType,
@@ -2543,6 +3364,17 @@ void EdenServiceHandler::getConfig(
   result = config->toThriftConfigData();
 }
 
+ThriftAdmissionControl::Ticket EdenServiceHandler::admitExpensiveCall(
+    folly::StringPiece method,
+    std::optional<pid_t> pid) {
+  auto config = server_->getServerState()->getEdenConfig();
+  ThriftAdmissionControl::Limits limits;
+  limits.maxConcurrent = config->thriftMaxConcurrentExpensiveCalls.getValue();
+  limits.callsPerSecond = config->thriftExpensiveCallsPerSecond.getValue();
+  limits.burst = config->thriftExpensiveCallBurst.getValue();
+  return admissionControl_.admit(method, pid, limits);
+}
+
 std::optional<pid_t> EdenServiceHandler::getAndRegisterClientPid() {
 #ifndef _WIN32
   // The Cpp2RequestContext for a thrift request is kept in a thread local
@@ -9,6 +9,8 @@
 
 #include <optional>
 #include "eden/fs/eden-config.h"
+#include "eden/fs/inodes/InodePtrFwd.h"
+#include "eden/fs/service/ThriftAdmissionControl.h"
 #include "eden/fs/service/gen-cpp2/StreamingEdenService.h"
 #include "eden/fs/utils/PathFuncs.h"
 #include "fb303/BaseService.h"
@@ -77,6 +79,10 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<std::string> repoPath,
       std::unique_ptr<std::string> targetPath) override;
+  void addBindMounts(
+      std::vector<BindMountResult>& out,
+      std::unique_ptr<std::string> mountPoint,
+      std::unique_ptr<std::vector<BindMount>> bindMounts) override;
   void removeBindMount(
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<std::string> repoPath) override;
@@ -86,6 +92,11 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<std::vector<std::string>> paths) override;
 
+  void getBlake3(
+      std::vector<Blake3Result>& out,
+      std::unique_ptr<std::string> mountPoint,
+      std::unique_ptr<std::vector<std::string>> paths) override;
+
   void getCurrentJournalPosition(
       JournalPosition& out,
       std::unique_ptr<std::string> mountPoint) override;
@@ -118,7 +129,9 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<std::vector<std::string>> paths) override;
 
-  folly::Future<std::unique_ptr<Glob>> future_globFiles(
+  void async_tm_globFiles(
+      std::unique_ptr<
+          apache::thrift::HandlerCallback<std::unique_ptr<Glob>>> callback,
       std::unique_ptr<GlobParams> params) override;
 
   folly::Future<std::unique_ptr<Glob>> future_predictiveGlobFiles(
@@ -141,6 +154,17 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   apache::thrift::ServerStream<HgEvent> traceHgEvents(
       std::unique_ptr<std::string> mountPoint) override;
 
+  apache::thrift::ServerStream<FileDelta> streamChangesSince(
+      std::unique_ptr<std::string> mountPoint,
+      std::unique_ptr<JournalPosition> fromPosition) override;
+
+  apache::thrift::ServerStream<ScmStatus> streamScmStatus(
+      std::unique_ptr<GetScmStatusParams> params) override;
+
+  void debugDumpFlightRecorder(
+      FlightRecorderDump& result,
+      std::unique_ptr<std::string> mountPoint) override;
+
   void async_tm_getScmStatusV2(
       std::unique_ptr<apache::thrift::HandlerCallback<
           std::unique_ptr<GetScmStatusResult>>> callback,
@@ -241,6 +265,12 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   void disableTracing() override;
   void getTracePoints(std::vector<TracePoint>& result) override;
 
+  void getSlowRequests(std::vector<SlowRequest>& result) override;
+
+  folly::SemiFuture<std::unique_ptr<std::string>> semifuture_debugProfileCpu(
+      int64_t durationMs,
+      int32_t frequency) override;
+
   void injectFault(std::unique_ptr<FaultDefinition> fault) override;
   bool removeFault(std::unique_ptr<RemoveFaultArg> fault) override;
   int64_t unblockFault(std::unique_ptr<UnblockFaultArg> info) override;
@@ -301,6 +331,23 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       folly::StringPiece path,
       ObjectFetchContext& fetchContext) noexcept;
 
+  /**
+   * Looks up the regular file at the given path, failing if the path is empty
+   * or names anything else.
+   */
+  ImmediateFuture<FileInodePtr> getRegularFileInode(
+      AbsolutePathPiece mountPoint,
+      folly::StringPiece path,
+      ObjectFetchContext& fetchContext);
+
+  /**
+   * Admit a call of an expensive method by pid under the limits of the
+   * config, or throw an OVERLOADED EdenError.
+   */
+  ThriftAdmissionControl::Ticket admitExpensiveCall(
+      folly::StringPiece method,
+      std::optional<pid_t> pid);
+
   struct GlobOptions {
     explicit GlobOptions(const GlobParams& params);
 
@@ -320,7 +367,8 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       folly::StringPiece searchRootUser,
       GlobOptions options,
       folly::StringPiece caller,
-      std::optional<pid_t> pid);
+      std::optional<pid_t> pid,
+      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request = nullptr);
 
 #ifdef EDEN_HAVE_USAGE_SERVICE
   // an endpoint for the edenfs/edenfs_service smartservice used for predictive
@@ -329,6 +377,7 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
 #endif
   const std::vector<std::string> originalCommandLine_;
   EdenServer* const server_;
+  ThriftAdmissionControl admissionControl_;
 };
 } // namespace eden
 } // namespace facebook
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/MaintenanceScheduler.h"
+
+#include <folly/io/async/EventBase.h>
+#include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
+#include <algorithm>
+
+namespace facebook {
+namespace eden {
+
+namespace {
+// The weight of the newest sample in the moving average. With one sample a
+// second, a burst of requests has to last a few seconds to defer maintenance,
+// and the foreground is idle again a few seconds after it ends.
+constexpr double kSmoothing = 0.2;
+} // namespace
+
+MaintenanceScheduler::Job::Job(
+    MaintenanceScheduler& scheduler,
+    std::string name,
+    std::vector<Step> steps)
+    : scheduler{scheduler},
+      name{std::move(name)},
+      steps{std::move(steps)},
+      dueSince{std::chrono::steady_clock::now()} {}
+
+void MaintenanceScheduler::Job::timeoutExpired() noexcept {
+  scheduler.runSlice(*this);
+}
+
+MaintenanceScheduler::MaintenanceScheduler(folly::EventBase* eventBase)
+    : eventBase_{eventBase} {}
+
+void MaintenanceScheduler::recordLoad(const Load& sample) {
+  if (!sampled_) {
+    average_ = sample;
+    sampled_ = true;
+    return;
+  }
+  average_.fsRequests += kSmoothing * (sample.fsRequests - average_.fsRequests);
+  average_.pendingImports +=
+      kSmoothing * (sample.pendingImports - average_.pendingImports);
+}
+
+bool MaintenanceScheduler::isBusy() const {
+  return average_.fsRequests > policy_.busyFsRequests ||
+      average_.pendingImports > policy_.busyPendingImports;
+}
+
+bool MaintenanceScheduler::shouldRun(
+    std::chrono::steady_clock::time_point dueSince,
+    std::chrono::steady_clock::time_point now) const {
+  return policy_.maxDeferral.count() <= 0 || !isBusy() ||
+      now - dueSince >= policy_.maxDeferral;
+}
+
+bool MaintenanceScheduler::isRunning(const std::string& name) const {
+  return std::any_of(jobs_.begin(), jobs_.end(), [&](const auto& job) {
+    return job->name == name;
+  });
+}
+
+bool MaintenanceScheduler::runSliced(
+    std::string name,
+    std::vector<Step> steps) {
+  if (isRunning(name)) {
+    XLOG(DBG3) << "not starting maintenance job " << name
+               << ": the previous one is still running";
+    return false;
+  }
+  jobs_.push_back(
+      std::make_unique<Job>(*this, std::move(name), std::move(steps)));
+  runSlice(*jobs_.back());
+  return true;
+}
+
+void MaintenanceScheduler::runSlice(Job& job) {
+  if (!shouldRun(job.dueSince)) {
+    XLOG(DBG4) << "deferring maintenance job " << job.name
+               << ": the foreground is busy";
+    eventBase_->timer().scheduleTimeout(&job, kRetryInterval);
+    return;
+  }
+
+  folly::stop_watch<std::chrono::milliseconds> timer;
+  while (job.next < job.steps.size()) {
+    try {
+      job.steps[job.next++]();
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "error running a step of maintenance job " << job.name
+                << ": " << folly::exceptionStr(ex);
+    }
+    if (job.next < job.steps.size() && timer.elapsed() >= policy_.sliceBudget) {
+      // Let the EventBase run its other callbacks before the next slice.
+      eventBase_->timer().scheduleTimeout(&job, std::chrono::milliseconds{0});
+      return;
+    }
+  }
+
+  jobs_.erase(
+      std::remove_if(
+          jobs_.begin(),
+          jobs_.end(),
+          [&](const auto& entry) { return entry.get() == &job; }),
+      jobs_.end());
+}
+
+} // namespace eden
+} // namespace facebook
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/io/async/HHWheelTimer.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace folly {
+class EventBase;
+} // namespace folly
+
+namespace facebook {
+namespace eden {
+
+/**
+ * Keeps the heavy background maintenance of the daemon, like local store
+ * garbage collection and inode unloading, out of the way of foreground work.
+ *
+ * The periodic tasks run on fixed timers, so without this a RocksDB
+ * compaction or a mass inode unload can start in the middle of a build. The
+ * scheduler keeps a moving average of the foreground load, sampled by
+ * EdenServer once a second: the filesystem requests in flight on the mounts
+ * and the imports waiting in the backing stores. Deferrable tasks ask it
+ * whether to run when their timer expires, and are retried every
+ * kRetryInterval while the load is above the thresholds of the policy, until
+ * they have waited for maxDeferral: maintenance is delayed, but never
+ * starved.
+ *
+ * Jobs made of many steps, like unloading the inodes of each mount, are
+ * time-sliced by runSliced(): a slice runs steps until its budget is spent,
+ * and yields the main EventBase to whatever else it has to do before the
+ * next one.
+ *
+ * Only used from the EdenServer's main EventBase thread.
+ */
+class MaintenanceScheduler {
+ public:
+  struct Load {
+    /** Filesystem requests in flight on all the mounts. */
+    double fsRequests = 0;
+    /** Imports waiting in the queues of the backing stores. */
+    double pendingImports = 0;
+  };
+
+  struct Policy {
+    /**
+     * The foreground is busy while the average number of filesystem requests
+     * in flight is above this.
+     */
+    double busyFsRequests = 8;
+    /**
+     * The foreground is busy while the average number of pending imports is
+     * above this.
+     */
+    double busyPendingImports = 32;
+    /**
+     * A deferrable task runs once it has waited for this long, however busy
+     * the foreground is. 0 disables deferral.
+     */
+    std::chrono::milliseconds maxDeferral{std::chrono::minutes{5}};
+    /** How long a slice of runSliced() may run for before yielding. */
+    std::chrono::milliseconds sliceBudget{50};
+  };
+
+  using Step = folly::Function<void()>;
+
+  /** How often deferred tasks check the load again. */
+  static constexpr std::chrono::milliseconds kRetryInterval{
+      std::chrono::seconds{5}};
+
+  explicit MaintenanceScheduler(folly::EventBase* eventBase);
+
+  void setPolicy(const Policy& policy) {
+    policy_ = policy;
+  }
+
+  const Policy& getPolicy() const {
+    return policy_;
+  }
+
+  /** Adds a sample of the foreground load to the moving average. */
+  void recordLoad(const Load& sample);
+
+  /** The moving average of the samples passed to recordLoad(). */
+  const Load& getAverageLoad() const {
+    return average_;
+  }
+
+  bool isBusy() const;
+
+  /**
+   * Whether a deferrable task that has been due since dueSince should run
+   * now: either the foreground is idle, or the task waited long enough.
+   */
+  bool shouldRun(
+      std::chrono::steady_clock::time_point dueSince,
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now()) const;
+
+  /**
+   * Runs steps in order on the main EventBase, deferring them like a
+   * deferrable task while the foreground is busy. A slice runs steps until
+   * sliceBudget is spent, then the next slice is scheduled, so that no
+   * single callback holds the EventBase for much longer than a step.
+   *
+   * Jobs started while the previous job of the same name hasn't finished
+   * are dropped. Returns whether the job was started.
+   */
+  bool runSliced(std::string name, std::vector<Step> steps);
+
+  /** Whether a job of this name started by runSliced() hasn't finished. */
+  bool isRunning(const std::string& name) const;
+
+ private:
+  /**
+   * A job started by runSliced(). Destroying it cancels its next slice, so
+   * no slice runs once the scheduler is gone.
+   */
+  struct Job : folly::HHWheelTimer::Callback {
+    Job(MaintenanceScheduler& scheduler, std::string name, std::vector<Step>);
+
+    void timeoutExpired() noexcept override;
+
+    MaintenanceScheduler& scheduler;
+    const std::string name;
+    std::vector<Step> steps;
+    size_t next = 0;
+    /**
+     * When the job started. Once it was deferred for maxDeferral, its
+     * remaining slices run without waiting for the foreground to be idle.
+     */
+    std::chrono::steady_clock::time_point dueSince;
+  };
+
+  /** Runs a slice of job, and destroys it once it has no steps left. */
+  void runSlice(Job& job);
+
+  folly::EventBase* const eventBase_;
+  Policy policy_;
+  Load average_;
+  bool sampled_{false};
+  std::vector<std::unique_ptr<Job>> jobs_;
+};
+
+} // namespace eden
+} // namespace facebook
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/MemoryGovernor.h"
+
+#include <folly/logging/xlog.h>
+#include <algorithm>
+
+namespace facebook {
+namespace eden {
+
+void MemoryGovernor::addConsumer(Consumer consumer) {
+  consumers_.wlock()->push_back(std::move(consumer));
+}
+
+std::vector<std::pair<std::string, size_t>> MemoryGovernor::getUsage() const {
+  std::vector<std::pair<std::string, size_t>> usage;
+  auto consumers = consumers_.rlock();
+  usage.reserve(consumers->size());
+  for (const auto& consumer : *consumers) {
+    usage.emplace_back(consumer.name, consumer.getUsage());
+  }
+  return usage;
+}
+
+bool MemoryGovernor::isUnderPressure(
+    const proc_util::MemoryPressure& pressure,
+    const Policy& policy) {
+  if (pressure.someAvg10 && *pressure.someAvg10 > policy.pressureThreshold) {
+    return true;
+  }
+  if (pressure.cgroupUsage && pressure.cgroupLimit &&
+      *pressure.cgroupLimit > 0) {
+    auto fraction = static_cast<double>(*pressure.cgroupUsage) /
+        static_cast<double>(*pressure.cgroupLimit);
+    return fraction > policy.cgroupUsageThreshold;
+  }
+  return false;
+}
+
+size_t MemoryGovernor::respondToPressure(
+    const proc_util::MemoryPressure& pressure,
+    const Policy& policy) {
+  if (!isUnderPressure(pressure, policy)) {
+    return 0;
+  }
+
+  auto consumers = consumers_.rlock();
+  size_t shrinkableUsage = 0;
+  for (const auto& consumer : *consumers) {
+    if (consumer.shrink) {
+      shrinkableUsage += consumer.getUsage();
+    }
+  }
+  auto target = static_cast<size_t>(
+      static_cast<double>(shrinkableUsage) *
+      std::clamp(policy.shrinkFraction, 0.0, 1.0));
+
+  size_t freed = 0;
+  for (const auto& name : policy.shrinkOrder) {
+    if (freed >= target) {
+      break;
+    }
+    auto it = std::find_if(
+        consumers->begin(), consumers->end(), [&](const Consumer& consumer) {
+          return consumer.name == name;
+        });
+    if (it == consumers->end() || !it->shrink) {
+      XLOG(DBG3) << "no shrinkable memory consumer named " << name;
+      continue;
+    }
+    auto consumerFreed = it->shrink(target - freed);
+    XLOG(DBG2) << "freed " << consumerFreed << " bytes from " << name
+               << " under memory pressure";
+    freed += consumerFreed;
+  }
+  return freed;
+}
+
+} // namespace eden
+} // namespace facebook
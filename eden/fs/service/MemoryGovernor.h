@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "eden/fs/utils/ProcUtil.h"
+
+namespace facebook {
+namespace eden {
+
+/**
+ * Tracks how much memory each large subsystem of the daemon uses, and frees
+ * some of it when the machine or the cgroup of the daemon runs low.
+ *
+ * The caches, the inodes and the journals each bound their own memory, but
+ * none of them knows how much the others use, nor whether the system needs
+ * the memory back. Subsystems register themselves as consumers here instead,
+ * so that the memory of the daemon can be reported as one breakdown and so
+ * that, under pressure, they are shrunk in the order chosen by the policy:
+ * typically the caches that are cheapest to refill first.
+ *
+ * It is safe to use this object from arbitrary threads, but consumers are
+ * expected to be added during startup.
+ */
+class MemoryGovernor {
+ public:
+  struct Consumer {
+    std::string name;
+    /** Returns an estimate, in bytes, of the memory used by the consumer. */
+    std::function<size_t()> getUsage;
+    /**
+     * Frees about bytesToFree bytes and returns the number of bytes actually
+     * freed. Consumers that can't shrink on demand leave this empty and are
+     * only reported.
+     */
+    std::function<size_t(size_t bytesToFree)> shrink;
+  };
+
+  struct Policy {
+    /**
+     * The memory is considered under pressure when tasks were stalled on
+     * memory for more than this percentage of the last 10 seconds.
+     */
+    double pressureThreshold = 10.0;
+    /**
+     * The memory is considered under pressure when the cgroup of the daemon
+     * uses more than this fraction of its limit.
+     */
+    double cgroupUsageThreshold = 0.9;
+    /**
+     * The fraction of the memory used by the shrinkable consumers to free
+     * when under pressure.
+     */
+    double shrinkFraction = 0.25;
+    /**
+     * The names of the consumers to shrink, in order. A consumer is only
+     * shrunk once the ones before it couldn't free enough.
+     */
+    std::vector<std::string> shrinkOrder;
+  };
+
+  void addConsumer(Consumer consumer);
+
+  /**
+   * Returns the name and estimated memory usage of each consumer, in the
+   * order they were added.
+   */
+  std::vector<std::pair<std::string, size_t>> getUsage() const;
+
+  static bool isUnderPressure(
+      const proc_util::MemoryPressure& pressure,
+      const Policy& policy);
+
+  /**
+   * If the memory is under pressure according to the policy, shrinks the
+   * consumers in the order of the policy until the fraction of their memory
+   * it asks for has been freed. Returns the number of bytes freed.
+   */
+  size_t respondToPressure(
+      const proc_util::MemoryPressure& pressure,
+      const Policy& policy);
+
+ private:
+  folly::Synchronized<std::vector<Consumer>> consumers_;
+};
+
+} // namespace eden
+} // namespace facebook
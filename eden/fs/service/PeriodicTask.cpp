@@ -7,10 +7,12 @@
 
 #include "eden/fs/service/PeriodicTask.h"
 
+#include <fb303/ServiceData.h>
 #include <folly/Random.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/lang/Bits.h>
 #include <folly/stop_watch.h>
+#include <algorithm>
 
 #include "eden/fs/service/EdenServer.h"
 
@@ -18,15 +20,39 @@ using namespace std::chrono_literals;
 
 namespace {
 constexpr auto kSlowTaskLimit = 50ms;
-}
+constexpr folly::StringPiece kDeferredCounter{"maintenance.deferred_tasks"};
+} // namespace
 
 namespace facebook {
 namespace eden {
 
-PeriodicTask::PeriodicTask(EdenServer* server, folly::StringPiece name)
-    : server_{server}, name_{name.str()}, interval_{0} {}
+PeriodicTask::PeriodicTask(
+    EdenServer* server,
+    folly::StringPiece name,
+    bool deferrable)
+    : server_{server},
+      name_{name.str()},
+      deferrable_{deferrable},
+      interval_{0} {}
 
 void PeriodicTask::timeoutExpired() noexcept {
+  if (deferrable_) {
+    auto now = std::chrono::steady_clock::now();
+    if (!deferredSince_) {
+      deferredSince_ = now;
+    }
+    auto& scheduler = server_->getMaintenanceScheduler();
+    if (!scheduler.shouldRun(*deferredSince_, now)) {
+      XLOG(DBG4) << "deferring periodic task " << name_
+                 << ": the foreground is busy";
+      fb303::fbData->incrementCounter(kDeferredCounter);
+      server_->getMainEventBase()->timer().scheduleTimeout(
+          this, std::min(interval_, MaintenanceScheduler::kRetryInterval));
+      return;
+    }
+    deferredSince_.reset();
+  }
+
   folly::stop_watch<> timer;
   try {
     running_ = true;
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <chrono>
+#include <optional>
 #include <string>
 
 #include <folly/Range.h>
@@ -32,7 +33,14 @@ class PeriodicTask : private folly::HHWheelTimer::Callback {
   // Unfortunately HHWheelTimer does not expose this as a class member.
   using Duration = std::chrono::milliseconds;
 
-  PeriodicTask(EdenServer* server, folly::StringPiece name);
+  /**
+   * A deferrable task is held back by the server's MaintenanceScheduler
+   * while the foreground is busy, for heavy tasks that can wait.
+   */
+  PeriodicTask(
+      EdenServer* server,
+      folly::StringPiece name,
+      bool deferrable = false);
 
   EdenServer* getServer() const {
     return server_;
@@ -85,6 +93,7 @@ class PeriodicTask : private folly::HHWheelTimer::Callback {
 
   EdenServer* const server_;
   std::string const name_;
+  bool const deferrable_;
 
   /*
    * PeriodicTask objects are only ever used from the EdenServer's main
@@ -107,6 +116,11 @@ class PeriodicTask : private folly::HHWheelTimer::Callback {
    * running_ is set to true while runTask() is running.
    */
   bool running_{false};
+
+  /**
+   * When a deferrable task was first deferred, until it runs.
+   */
+  std::optional<std::chrono::steady_clock::time_point> deferredSince_;
 };
 
 } // namespace eden
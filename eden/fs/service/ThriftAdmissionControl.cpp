@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/ThriftAdmissionControl.h"
+
+#include <fb303/ServiceData.h>
+#include <folly/Conv.h>
+#include <algorithm>
+#include <cerrno>
+#include <utility>
+
+#include "eden/fs/utils/EdenError.h"
+
+namespace facebook {
+namespace eden {
+
+namespace {
+folly::StringPiece methodOfKey(folly::StringPiece key) {
+  return key.subpiece(0, key.find(':'));
+}
+
+std::string counterName(folly::StringPiece method, folly::StringPiece stat) {
+  return folly::to<std::string>("thrift.admission.", method, ".", stat);
+}
+} // namespace
+
+ThriftAdmissionControl::Ticket::Ticket(
+    ThriftAdmissionControl* control,
+    std::string key)
+    : control_{control}, key_{std::move(key)} {}
+
+ThriftAdmissionControl::Ticket::Ticket(Ticket&& other) noexcept
+    : control_{std::exchange(other.control_, nullptr)},
+      key_{std::move(other.key_)} {}
+
+ThriftAdmissionControl::Ticket& ThriftAdmissionControl::Ticket::operator=(
+    Ticket&& other) noexcept {
+  if (this != &other) {
+    release();
+    control_ = std::exchange(other.control_, nullptr);
+    key_ = std::move(other.key_);
+  }
+  return *this;
+}
+
+ThriftAdmissionControl::Ticket::~Ticket() {
+  release();
+}
+
+void ThriftAdmissionControl::Ticket::release() {
+  if (control_) {
+    std::exchange(control_, nullptr)->release(key_);
+  }
+}
+
+std::string ThriftAdmissionControl::makeKey(
+    folly::StringPiece method,
+    std::optional<pid_t> pid) {
+  return folly::to<std::string>(method, ":", pid ? *pid : -1);
+}
+
+ThriftAdmissionControl::Ticket ThriftAdmissionControl::admit(
+    folly::StringPiece method,
+    std::optional<pid_t> pid,
+    const Limits& limits,
+    std::chrono::steady_clock::time_point now) {
+  auto key = makeKey(method, pid);
+  {
+    auto clients = clients_.wlock();
+    if (clients->size() > kMaxIdleClients) {
+      for (auto it = clients->begin(); it != clients->end();) {
+        it = it->second.inFlight ? std::next(it) : clients->erase(it);
+      }
+    }
+
+    auto burst = std::max(limits.burst, 1.0);
+    auto [it, inserted] = clients->try_emplace(key);
+    auto& client = it->second;
+    if (inserted) {
+      client.tokens = burst;
+      client.lastRefill = now;
+    } else if (limits.callsPerSecond > 0) {
+      std::chrono::duration<double> elapsed = now - client.lastRefill;
+      client.tokens = std::min(
+          burst,
+          client.tokens +
+              std::max(elapsed.count(), 0.0) * limits.callsPerSecond);
+      client.lastRefill = now;
+    }
+
+    const char* reason = nullptr;
+    if (limits.maxConcurrent && client.inFlight >= limits.maxConcurrent) {
+      reason = "too many concurrent calls";
+    } else if (limits.callsPerSecond > 0 && client.tokens < 1) {
+      reason = "call rate exceeded";
+    }
+    if (reason) {
+      fb303::fbData->incrementCounter(counterName(method, "rejected"));
+      throw newEdenError(
+          EAGAIN,
+          EdenErrorType::OVERLOADED,
+          method,
+          ": ",
+          reason,
+          " by pid ",
+          pid ? folly::to<std::string>(*pid) : "unknown",
+          ", retry later");
+    }
+
+    if (limits.callsPerSecond > 0) {
+      client.tokens -= 1;
+    }
+    ++client.inFlight;
+  }
+
+  fb303::fbData->incrementCounter(counterName(method, "admitted"));
+  fb303::fbData->incrementCounter(counterName(method, "in_flight"));
+  return Ticket{this, std::move(key)};
+}
+
+uint32_t ThriftAdmissionControl::getInFlight(
+    folly::StringPiece method,
+    std::optional<pid_t> pid) const {
+  auto clients = clients_.rlock();
+  auto it = clients->find(makeKey(method, pid));
+  return it == clients->end() ? 0 : it->second.inFlight;
+}
+
+void ThriftAdmissionControl::release(const std::string& key) {
+  {
+    auto clients = clients_.wlock();
+    auto it = clients->find(key);
+    if (it != clients->end() && it->second.inFlight) {
+      --it->second.inFlight;
+    }
+  }
+  fb303::fbData->incrementCounter(
+      counterName(methodOfKey(key), "in_flight"), -1);
+}
+
+} // namespace eden
+} // namespace facebook
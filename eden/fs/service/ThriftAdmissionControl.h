@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <sys/types.h>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace facebook {
+namespace eden {
+
+/**
+ * Limits how much of the daemon each client may take with expensive Thrift
+ * methods, like globFiles, getSHA1 and getScmStatusV2.
+ *
+ * A misbehaving tool calling these in a loop competes with the filesystem
+ * for the CPU pool and the import queues. Each method has, for each client
+ * process, a limit on the calls in flight and a token bucket refilled at a
+ * steady rate. Calls over either limit fail right away with an EdenError of
+ * type OVERLOADED, which callers may retry after a delay, rather than wait
+ * in a queue behind the filesystem.
+ *
+ * Clients are keyed by pid: the Unix socket only admits the daemon owner
+ * and root, so the uid doesn't tell clients apart.
+ *
+ * The admitted, rejected and in-flight calls of each method are exported as
+ * thrift.admission.<method>.{admitted,rejected,in_flight} counters.
+ *
+ * This class is thread safe.
+ */
+class ThriftAdmissionControl {
+ public:
+  struct Limits {
+    /** The calls a client may have in flight. 0 is unbounded. */
+    uint32_t maxConcurrent = 0;
+    /** The steady rate of calls a client may make. 0 is unbounded. */
+    double callsPerSecond = 0;
+    /** The calls a client may make at once above the steady rate. */
+    double burst = 1;
+  };
+
+  /**
+   * Holds an admitted call in flight until destroyed.
+   */
+  class Ticket {
+   public:
+    Ticket() = default;
+    Ticket(Ticket&& other) noexcept;
+    Ticket& operator=(Ticket&& other) noexcept;
+    ~Ticket();
+
+   private:
+    friend class ThriftAdmissionControl;
+    Ticket(ThriftAdmissionControl* control, std::string key);
+
+    void release();
+
+    ThriftAdmissionControl* control_{nullptr};
+    std::string key_;
+  };
+
+  /**
+   * Admit a call of method by pid under limits, or throw an EdenError of
+   * type OVERLOADED. Calls of clients whose pid is unknown share a key.
+   */
+  Ticket admit(
+      folly::StringPiece method,
+      std::optional<pid_t> pid,
+      const Limits& limits,
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now());
+
+  /** The calls of method by pid in flight. */
+  uint32_t getInFlight(folly::StringPiece method, std::optional<pid_t> pid)
+      const;
+
+ private:
+  struct Client {
+    uint32_t inFlight = 0;
+    double tokens = 0;
+    std::chrono::steady_clock::time_point lastRefill;
+  };
+
+  /**
+   * Clients with nothing in flight are forgotten once there are more than
+   * this many.
+   */
+  static constexpr size_t kMaxIdleClients = 1024;
+
+  static std::string makeKey(
+      folly::StringPiece method,
+      std::optional<pid_t> pid);
+
+  void release(const std::string& key);
+
+  folly::Synchronized<std::unordered_map<std::string, Client>> clients_;
+};
+
+} // namespace eden
+} // namespace facebook
@@ -91,6 +91,11 @@ enum EdenErrorType {
   * parent that is not the current parent. errorCode will not be set.
   */
   OUT_OF_DATE_PARENT = 8,
+  /**
+   * The daemon turned the request down to protect filesystem latency, and it
+   * may be retried after a delay. errorCode will be set to EAGAIN.
+   */
+  OVERLOADED = 9,
 }
 
 exception EdenError {
@@ -209,6 +214,12 @@ union SHA1Result {
   2: EdenError error;
 }
 
+union Blake3Result {
+  // The 32-byte BLAKE3 hash of the file contents.
+  1: binary blake3;
+  2: EdenError error;
+}
+
 /**
  * Effectively a `struct timespec`
  */
@@ -609,6 +620,7 @@ const i64 STATS_SMAPS = 0x4;
 const i64 STATS_PRIVATE_BYTES = 0x8;
 const i64 STATS_RSS_BYTES = 0x10;
 const i64 STATS_CACHE_STATS = 0x20;
+const i64 STATS_MEMORY_USAGE = 0x40;
 const i64 STATS_ALL = 0xFFFF;
 
 /**
@@ -667,6 +679,12 @@ struct InternalStats {
    * Populated if STATS_CACHE_STATS is set.
    */
   9: optional CacheStats treeCacheStats;
+  /**
+   * Estimated bytes of memory used by each large consumer of memory in the
+   * daemon, such as the caches, the loaded inodes and the journals.
+   * Populated if STATS_MEMORY_USAGE is set.
+   */
+  10: optional map<string, i64> memoryUsage;
 }
 
 struct FuseCall {
@@ -814,6 +832,11 @@ struct AccessCounts {
 struct MountAccesses {
   1: map<pid_t, AccessCounts> accessCountsByPid;
   2: map<pid_t, i64> fetchCountsByPid;
+  // The fetches that missed the caches and were imported from the backing
+  // store, and the number of bytes they returned. Like fetchCountsByPid,
+  // these count from the start of the EdenFS process.
+  3: map<pid_t, i64> backingStoreFetchCountsByPid;
+  4: map<pid_t, i64> backingStoreFetchBytesByPid;
 }
 
 struct GetAccessCountsResult {
@@ -850,6 +873,25 @@ struct TracePoint {
   6: TracePointEvent event;
 }
 
+/**
+ * A filesystem request that took at least a second, along with how much of
+ * that time was spent in each stage of fetching the objects it needed. The
+ * stage durations are summed over all the objects fetched, so with
+ * concurrent fetches they can add up to more than durationNs.
+ */
+struct SlowRequest {
+  1: i64 requestId;
+  // The FUSE, NFS or ProjectedFS operation, e.g. "FUSE_LOOKUP"
+  2: string operation;
+  3: optional pid_t pid;
+  // Nanoseconds since the epoch
+  4: i64 finishTime;
+  5: i64 durationNs;
+  6: i64 localStoreNs;
+  7: i64 importQueueNs;
+  8: i64 backingStoreFetchNs;
+}
+
 struct FaultDefinition {
   1: string keyClass;
   2: string keyValueRegex;
@@ -908,6 +950,15 @@ struct GetScmStatusParams {
    * directory) will never be reported even when listIgnored is true.
    */
   3: bool listIgnored = false;
+
+  /**
+   * Whether a directory that is neither tracked nor ignored is reported as a
+   * single ADDED entry, whose path ends with a '/', rather than as one entry
+   * per file under it. Such directories are not walked, so the entry is
+   * reported even if they only contain ignored files. This is similar to
+   * git's --untracked-files=normal.
+   */
+  4: bool summarizeUntrackedDirectories = false;
 }
 
 /**
@@ -921,12 +972,24 @@ enum ObjectType {
   SYMLINK = 3,
 }
 
+struct SetPathObjectIdObjectAndPath {
+  1: PathString path;
+  2: BinaryHash objectId;
+  3: ObjectType type;
+}
+
 struct SetPathObjectIdParams {
   1: PathString mountPoint;
   2: PathString path;
   3: BinaryHash objectId;
   4: ObjectType type;
   5: CheckoutMode mode;
+  /**
+   * When not empty, all these objects are set in a single checkout, and
+   * path, objectId and type are ignored. This is much cheaper than a call
+   * per object, as the locks are only acquired once.
+   */
+  6: list<SetPathObjectIdObjectAndPath> objects;
 }
 
 struct SetPathObjectIdResult {
@@ -961,6 +1024,19 @@ struct ResetParentCommitsParams {
   1: optional BinaryHash hgRootManifest;
 }
 
+struct BindMount {
+  1: PathString repoPath;
+  2: PathString targetPath;
+}
+
+/**
+ * The outcome of one of the bind mounts of addBindMounts(): error is unset
+ * if it was established.
+ */
+struct BindMountResult {
+  1: optional EdenError error;
+}
+
 service EdenService extends fb303_core.BaseService {
   list<MountInfo> listMounts() throws (1: EdenError ex);
   void mount(1: MountArgument info) throws (1: EdenError ex);
@@ -1020,6 +1096,18 @@ service EdenService extends fb303_core.BaseService {
     2: list<PathString> paths,
   ) throws (1: EdenError ex);
 
+  /**
+   * Like getSHA1, but returns the BLAKE3 hash of each file's contents.
+   *
+   * BLAKE3 hashes are not provided by source control, so for files that are
+   * not materialized, the first request for a blob fetches and hashes its
+   * contents. The result is then stored with the blob metadata.
+   */
+  list<Blake3Result> getBlake3(
+    1: PathString mountPoint,
+    2: list<PathString> paths,
+  ) throws (1: EdenError ex);
+
   /**
    * Returns a list of paths relative to the mountPoint. DEPRECATED!
    */
@@ -1044,6 +1132,20 @@ service EdenService extends fb303_core.BaseService {
     3: PathString targetPath,
   ) throws (1: EdenError ex);
 
+  /**
+   * Like addBindMount(), for several bind mounts at once. They are performed
+   * concurrently by a single privhelper request, which makes setting up the
+   * redirections of a checkout much faster than one call per bind mount.
+   *
+   * Returns the result of each bind mount, in the same order. One failing
+   * doesn't prevent the others; the call itself only throws if mountPoint
+   * isn't a mount or the privhelper request fails as a whole.
+   */
+  list<BindMountResult> addBindMounts(
+    1: PathString mountPoint,
+    2: list<BindMount> bindMounts,
+  ) throws (1: EdenError ex);
+
   /**
    * Removes the bind mount specified by `repoPath` from the set of managed
    * bind mounts.
@@ -1459,6 +1561,23 @@ service EdenService extends fb303_core.BaseService {
   void disableTracing();
   list<TracePoint> getTracePoints();
 
+  /**
+   * Returns the most recent slow filesystem requests, oldest first.
+   */
+  list<SlowRequest> getSlowRequests();
+
+  /**
+   * Samples the stacks of the EdenFS threads using CPU, frequency times per
+   * second of CPU time, for durationMs milliseconds. Returns them as collapsed
+   * stacks that flamegraph.pl can render. Stacks sampled while a FUSE request
+   * was being dispatched start with the request's opcode name.
+   *
+   * Only one profile can run at a time.
+   */
+  string debugProfileCpu(1: i64 durationMs, 2: i32 frequency) throws (
+    1: EdenError ex,
+  );
+
   /**
    * Configure a new fault in Eden's fault injection framework.
    *
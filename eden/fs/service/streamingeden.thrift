@@ -110,6 +110,20 @@ struct HgEvent {
   7: optional RequestInfo requestInfo;
 }
 
+/**
+ * The history kept by a mount's flight recorders, which record FUSE requests
+ * and hg imports whether or not they are being traced.
+ */
+struct FlightRecorderDump {
+  // The most recent FUSE requests and responses, in order.
+  1: list<FsEvent> fsEvents;
+  // The FUSE events recorded up to the moment the most recent request taking
+  // longer than a second finished.
+  2: list<FsEvent> slowRequestFsEvents;
+  // The most recent hg import events, in order.
+  3: list<HgEvent> hgEvents;
+}
+
 /**
  * This Thrift service defines streaming functions. It is separate from
  * EdenService because older Thrift runtimes do not support Thrift streaming,
@@ -159,4 +173,34 @@ service StreamingEdenService extends eden.EdenService {
    * started, and finished.
    */
   stream<HgEvent> traceHgEvents(1: eden.PathString mountPoint);
+
+  /**
+   * Like getFilesChangedSince, but returns the paths in batches of a bounded
+   * size rather than in a single response, so that clients can start
+   * processing the changes of a large range before all of them are sent.
+   *
+   * Every batch has fromPosition and toPosition set. snapshotTransitions is
+   * only set in the first batch. A range without changes produces a single
+   * batch with no paths.
+   */
+  stream<eden.FileDelta> streamChangesSince(
+    1: eden.PathString mountPoint,
+    2: eden.JournalPosition fromPosition,
+  ) throws (1: eden.EdenError ex);
+
+  /**
+   * Like getScmStatusV2, but returns the entries in batches as the diff
+   * finds them, rather than once the whole diff has completed. The union of
+   * the batches is the ScmStatus that getScmStatusV2 would return.
+   */
+  stream<eden.ScmStatus> streamScmStatus(
+    1: eden.GetScmStatusParams params,
+  ) throws (1: eden.EdenError ex);
+
+  /**
+   * Returns the recent FUSE and hg import events for the given mount, which
+   * are always recorded. Meant for looking into latency spikes after the
+   * fact, when no trace was running.
+   */
+  FlightRecorderDump debugDumpFlightRecorder(1: eden.PathString mountPoint);
 }
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/MaintenanceScheduler.h"
+
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+#include <stdexcept>
+#include <vector>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using Load = MaintenanceScheduler::Load;
+
+namespace {
+MaintenanceScheduler::Policy makePolicy(std::chrono::milliseconds maxDeferral) {
+  MaintenanceScheduler::Policy policy;
+  policy.busyFsRequests = 10;
+  policy.busyPendingImports = 100;
+  policy.maxDeferral = maxDeferral;
+  return policy;
+}
+} // namespace
+
+TEST(MaintenanceScheduler, load_is_a_moving_average) {
+  folly::EventBase evb;
+  MaintenanceScheduler scheduler{&evb};
+  scheduler.setPolicy(makePolicy(5min));
+  EXPECT_FALSE(scheduler.isBusy());
+
+  // The first sample sets the average.
+  scheduler.recordLoad(Load{20, 0});
+  EXPECT_EQ(20, scheduler.getAverageLoad().fsRequests);
+  EXPECT_TRUE(scheduler.isBusy());
+
+  // A single idle sample doesn't make the foreground idle...
+  scheduler.recordLoad(Load{0, 0});
+  EXPECT_TRUE(scheduler.isBusy());
+  // ... but a few seconds of them do.
+  for (int i = 0; i < 5; ++i) {
+    scheduler.recordLoad(Load{0, 0});
+  }
+  EXPECT_FALSE(scheduler.isBusy());
+
+  // Pending imports alone are enough to be busy.
+  for (int i = 0; i < 20; ++i) {
+    scheduler.recordLoad(Load{0, 500});
+  }
+  EXPECT_TRUE(scheduler.isBusy());
+}
+
+TEST(MaintenanceScheduler, tasks_are_deferred_for_at_most_max_deferral) {
+  folly::EventBase evb;
+  MaintenanceScheduler scheduler{&evb};
+  scheduler.setPolicy(makePolicy(5min));
+  auto now = std::chrono::steady_clock::now();
+  EXPECT_TRUE(scheduler.shouldRun(now, now));
+
+  scheduler.recordLoad(Load{50, 0});
+  EXPECT_FALSE(scheduler.shouldRun(now, now));
+  EXPECT_FALSE(scheduler.shouldRun(now, now + 4min));
+  EXPECT_TRUE(scheduler.shouldRun(now, now + 5min));
+
+  // 0 disables deferral.
+  scheduler.setPolicy(makePolicy(0ms));
+  EXPECT_TRUE(scheduler.isBusy());
+  EXPECT_TRUE(scheduler.shouldRun(now, now));
+}
+
+TEST(MaintenanceScheduler, sliced_jobs_yield_between_slices) {
+  folly::EventBase evb;
+  MaintenanceScheduler scheduler{&evb};
+  auto policy = makePolicy(5min);
+  policy.sliceBudget = 0ms;
+  scheduler.setPolicy(policy);
+
+  std::vector<int> ran;
+  std::vector<MaintenanceScheduler::Step> steps;
+  for (int i = 0; i < 3; ++i) {
+    steps.emplace_back([&ran, i] { ran.push_back(i); });
+  }
+  EXPECT_TRUE(scheduler.runSliced("job", std::move(steps)));
+  // The first slice runs right away, and stops after its first step since
+  // it has no budget.
+  EXPECT_EQ(std::vector<int>{0}, ran);
+  EXPECT_TRUE(scheduler.isRunning("job"));
+
+  // A job of the same name is dropped while the first one runs.
+  std::vector<MaintenanceScheduler::Step> duplicate;
+  duplicate.emplace_back([&ran] { ran.push_back(-1); });
+  EXPECT_FALSE(scheduler.runSliced("job", std::move(duplicate)));
+
+  evb.loop();
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), ran);
+  EXPECT_FALSE(scheduler.isRunning("job"));
+}
+
+TEST(MaintenanceScheduler, sliced_jobs_wait_while_busy) {
+  folly::EventBase evb;
+  MaintenanceScheduler scheduler{&evb};
+  scheduler.setPolicy(makePolicy(5min));
+  scheduler.recordLoad(Load{50, 0});
+
+  bool ran = false;
+  std::vector<MaintenanceScheduler::Step> steps;
+  steps.emplace_back([&ran] { ran = true; });
+  EXPECT_TRUE(scheduler.runSliced("job", std::move(steps)));
+  EXPECT_FALSE(ran);
+  EXPECT_TRUE(scheduler.isRunning("job"));
+
+  // It is retried every kRetryInterval, and runs once it is no longer
+  // deferred.
+  scheduler.setPolicy(makePolicy(0ms));
+  evb.loop();
+  EXPECT_TRUE(ran);
+  EXPECT_FALSE(scheduler.isRunning("job"));
+}
+
+TEST(MaintenanceScheduler, failing_steps_do_not_stop_the_job) {
+  folly::EventBase evb;
+  MaintenanceScheduler scheduler{&evb};
+  bool ran = false;
+  std::vector<MaintenanceScheduler::Step> steps;
+  steps.emplace_back([] { throw std::runtime_error("step failed"); });
+  steps.emplace_back([&ran] { ran = true; });
+  scheduler.runSliced("job", std::move(steps));
+  evb.loop();
+  EXPECT_TRUE(ran);
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/MemoryGovernor.h"
+
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using testing::ElementsAre;
+using testing::Pair;
+
+namespace {
+
+struct FakeConsumer {
+  size_t usage;
+  std::vector<size_t> shrinkRequests;
+
+  MemoryGovernor::Consumer makeConsumer(std::string name, bool shrinkable) {
+    MemoryGovernor::Consumer consumer;
+    consumer.name = std::move(name);
+    consumer.getUsage = [this] { return usage; };
+    if (shrinkable) {
+      consumer.shrink = [this](size_t bytesToFree) {
+        shrinkRequests.push_back(bytesToFree);
+        auto freed = std::min(usage, bytesToFree);
+        usage -= freed;
+        return freed;
+      };
+    }
+    return consumer;
+  }
+};
+
+proc_util::MemoryPressure makePressure(double someAvg10) {
+  proc_util::MemoryPressure pressure;
+  pressure.someAvg10 = someAvg10;
+  return pressure;
+}
+
+} // namespace
+
+TEST(MemoryGovernor, reports_usage_of_every_consumer) {
+  FakeConsumer cache{100};
+  FakeConsumer journal{30};
+  MemoryGovernor governor;
+  governor.addConsumer(cache.makeConsumer("cache", true));
+  governor.addConsumer(journal.makeConsumer("journal", false));
+
+  EXPECT_THAT(
+      governor.getUsage(),
+      ElementsAre(Pair("cache", 100), Pair("journal", 30)));
+}
+
+TEST(MemoryGovernor, detects_pressure_from_psi_or_cgroup) {
+  MemoryGovernor::Policy policy;
+  policy.pressureThreshold = 10.0;
+  policy.cgroupUsageThreshold = 0.9;
+
+  EXPECT_FALSE(MemoryGovernor::isUnderPressure({}, policy));
+  EXPECT_FALSE(MemoryGovernor::isUnderPressure(makePressure(5.0), policy));
+  EXPECT_TRUE(MemoryGovernor::isUnderPressure(makePressure(20.0), policy));
+
+  proc_util::MemoryPressure pressure;
+  pressure.cgroupUsage = 950;
+  EXPECT_FALSE(MemoryGovernor::isUnderPressure(pressure, policy))
+      << "no limit, no pressure";
+  pressure.cgroupLimit = 1000;
+  EXPECT_TRUE(MemoryGovernor::isUnderPressure(pressure, policy));
+  pressure.cgroupUsage = 500;
+  EXPECT_FALSE(MemoryGovernor::isUnderPressure(pressure, policy));
+}
+
+TEST(MemoryGovernor, does_nothing_without_pressure) {
+  FakeConsumer cache{100};
+  MemoryGovernor governor;
+  governor.addConsumer(cache.makeConsumer("cache", true));
+
+  MemoryGovernor::Policy policy;
+  policy.shrinkOrder = {"cache"};
+  EXPECT_EQ(0, governor.respondToPressure(makePressure(0.0), policy));
+  EXPECT_TRUE(cache.shrinkRequests.empty());
+}
+
+TEST(MemoryGovernor, shrinks_consumers_in_policy_order) {
+  FakeConsumer blobs{40};
+  FakeConsumer trees{100};
+  FakeConsumer inodes{60};
+  FakeConsumer journal{1000};
+  MemoryGovernor governor;
+  governor.addConsumer(trees.makeConsumer("trees", true));
+  governor.addConsumer(inodes.makeConsumer("inodes", true));
+  governor.addConsumer(blobs.makeConsumer("blobs", true));
+  governor.addConsumer(journal.makeConsumer("journal", false));
+
+  MemoryGovernor::Policy policy;
+  policy.pressureThreshold = 10.0;
+  policy.shrinkFraction = 0.5;
+  policy.shrinkOrder = {"journal", "blobs", "trees", "inodes"};
+
+  // Half of the 200 shrinkable bytes: all the blobs, then 60 bytes of trees.
+  EXPECT_EQ(100, governor.respondToPressure(makePressure(50.0), policy));
+  EXPECT_THAT(blobs.shrinkRequests, ElementsAre(100));
+  EXPECT_THAT(trees.shrinkRequests, ElementsAre(60));
+  EXPECT_TRUE(inodes.shrinkRequests.empty());
+  EXPECT_EQ(1000, journal.usage);
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/ThriftAdmissionControl.h"
+
+#include <folly/portability/GTest.h>
+#include <vector>
+
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using Limits = ThriftAdmissionControl::Limits;
+
+namespace {
+void expectOverloaded(
+    ThriftAdmissionControl& control,
+    std::optional<pid_t> pid,
+    const Limits& limits,
+    std::chrono::steady_clock::time_point now) {
+  try {
+    control.admit("glob", pid, limits, now);
+    FAIL() << "call was admitted";
+  } catch (const EdenError& error) {
+    EXPECT_EQ(EdenErrorType::OVERLOADED, *error.errorType_ref());
+    EXPECT_EQ(EAGAIN, *error.errorCode_ref());
+  }
+}
+} // namespace
+
+TEST(ThriftAdmissionControl, concurrent_calls_are_limited_per_client) {
+  ThriftAdmissionControl control;
+  Limits limits;
+  limits.maxConcurrent = 2;
+  auto now = std::chrono::steady_clock::now();
+
+  std::vector<ThriftAdmissionControl::Ticket> tickets;
+  tickets.push_back(control.admit("glob", 10, limits, now));
+  tickets.push_back(control.admit("glob", 10, limits, now));
+  EXPECT_EQ(2, control.getInFlight("glob", 10));
+  expectOverloaded(control, 10, limits, now);
+
+  // Other clients and other methods have limits of their own.
+  auto other = control.admit("glob", 11, limits, now);
+  auto otherMethod = control.admit("status", 10, limits, now);
+
+  tickets.pop_back();
+  EXPECT_EQ(1, control.getInFlight("glob", 10));
+  tickets.push_back(control.admit("glob", 10, limits, now));
+}
+
+TEST(ThriftAdmissionControl, call_rate_is_limited_by_a_token_bucket) {
+  ThriftAdmissionControl control;
+  Limits limits;
+  limits.callsPerSecond = 10;
+  limits.burst = 3;
+  auto now = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < 3; ++i) {
+    control.admit("glob", 10, limits, now);
+  }
+  expectOverloaded(control, 10, limits, now);
+
+  // A token is refilled every 100ms.
+  control.admit("glob", 10, limits, now + 100ms);
+  expectOverloaded(control, 10, limits, now + 150ms);
+
+  // The bucket holds no more than the burst.
+  auto later = now + 1h;
+  for (int i = 0; i < 3; ++i) {
+    control.admit("glob", 10, limits, later);
+  }
+  expectOverloaded(control, 10, limits, later);
+}
+
+TEST(ThriftAdmissionControl, zero_limits_are_unbounded) {
+  ThriftAdmissionControl control;
+  auto now = std::chrono::steady_clock::now();
+  std::vector<ThriftAdmissionControl::Ticket> tickets;
+  for (int i = 0; i < 1000; ++i) {
+    tickets.push_back(control.admit("glob", std::nullopt, Limits{}, now));
+  }
+  EXPECT_EQ(1000, control.getInFlight("glob", std::nullopt));
+  tickets.clear();
+  EXPECT_EQ(0, control.getInFlight("glob", std::nullopt));
+}
@@ -8,9 +8,32 @@
 #include "eden/fs/sqlite/SqliteDatabase.h"
 
 #include <folly/logging/xlog.h>
+#include <atomic>
 #include "eden/fs/sqlite/PersistentSqliteStatement.h"
 
 namespace facebook::eden {
+namespace {
+sqlite3* openConnection(const char* addr) {
+  sqlite3* db = nullptr;
+  auto result = sqlite3_open(addr, &db);
+  if (result != SQLITE_OK) {
+    // sqlite3_close handles nullptr fine
+    // @lint-ignore CLANGTIDY
+    sqlite3_close(db);
+    checkSqliteResult(nullptr, result);
+  }
+  return db;
+}
+
+/**
+ * Threads look for an idle reader starting from a different one each, so
+ * that each of them mostly keeps using the same connection, and its cache.
+ */
+std::atomic<size_t> nextReaderSlot{0};
+thread_local size_t readerSlot =
+    nextReaderSlot.fetch_add(1, std::memory_order_relaxed);
+} // namespace
+
 struct SqliteDatabase::StatementCache {
   explicit StatementCache(SqliteDatabase::Connection& db)
       : beginTransaction{db, "BEGIN"},
@@ -44,26 +67,28 @@ void checkSqliteResult(sqlite3* db, int result) {
   }
 }
 
-SqliteDatabase::SqliteDatabase(const char* addr) {
-  sqlite3* db = nullptr;
-  auto result = sqlite3_open(addr, &db);
-  if (result != SQLITE_OK) {
-    // sqlite3_close handles nullptr fine
-    // @lint-ignore CLANGTIDY
-    sqlite3_close(db);
-    checkSqliteResult(nullptr, result);
-  }
-  db_ = db;
+SqliteDatabase::SqliteDatabase(const char* addr)
+    : address_{addr}, db_{openConnection(addr)} {
   auto conn = lock();
   cache_ = std::make_unique<StatementCache>(conn);
 }
 
 void SqliteDatabase::close() {
+  for (auto& reader : readers_) {
+    auto db = reader->db.wlock();
+    reader->statements.clear();
+    if (*db) {
+      sqlite3_close(*db);
+      *db = nullptr;
+    }
+  }
+
   auto db = db_.wlock();
   // We must clear the cached statement before closing the database. Otherwise
   // `sqlite3_close` will fail with `SQLITE_BUSY`. This rule applies to any
   // statement cache elsewhere too.
   cache_.reset();
+  statements_.clear();
   if (*db) {
     sqlite3_close(*db);
     *db = nullptr;
@@ -78,6 +103,61 @@ SqliteDatabase::Connection SqliteDatabase::lock() {
   return db_.wlock();
 }
 
+void SqliteDatabase::openReaders(size_t count, uint64_t mmapSize) {
+  if (address_ == ":memory:" || !readers_.empty()) {
+    return;
+  }
+
+  readers_.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto& reader = readers_.emplace_back(std::make_unique<Reader>());
+    auto db = reader->db.wlock();
+    *db = openConnection(address_.c_str());
+    SqliteStatement(db, "PRAGMA query_only=ON").step();
+    if (mmapSize != 0) {
+      SqliteStatement(db, "PRAGMA mmap_size=", mmapSize).step();
+    }
+  }
+}
+
+SqliteDatabase::ReadConnection SqliteDatabase::lockReader() {
+  if (readers_.empty()) {
+    return ReadConnection{db_.wlock(), statements_};
+  }
+
+  auto first = readerSlot % readers_.size();
+  for (size_t i = 0; i < readers_.size(); ++i) {
+    auto& reader = *readers_[(first + i) % readers_.size()];
+    if (auto db = reader.db.tryWLock()) {
+      return ReadConnection{std::move(db), reader.statements};
+    }
+  }
+  // They are all busy, wait for ours.
+  auto& reader = *readers_[first];
+  return ReadConnection{reader.db.wlock(), reader.statements};
+}
+
+SqliteDatabase::ReadConnection::~ReadConnection() {
+  if (!conn_) {
+    // Moved from.
+    return;
+  }
+  for (auto* statement : used_) {
+    statement->get(conn_);
+  }
+}
+
+SqliteStatement& SqliteDatabase::ReadConnection::statement(
+    folly::StringPiece sql) {
+  auto key = sql.str();
+  auto it = statements_->find(key);
+  if (it == statements_->end()) {
+    it = statements_->try_emplace(key, conn_, sql).first;
+  }
+  used_.push_back(&it->second);
+  return it->second.get(conn_);
+}
+
 void SqliteDatabase::transaction(const std::function<void(Connection&)>& func) {
   auto conn = lock();
   try {
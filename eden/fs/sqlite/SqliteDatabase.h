@@ -9,6 +9,11 @@
 
 #include <folly/Synchronized.h>
 #include <sqlite3.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "eden/fs/sqlite/PersistentSqliteStatement.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
@@ -18,9 +23,45 @@ void checkSqliteResult(sqlite3* db, int result);
 
 /** A helper class for managing a handle to a sqlite database. */
 class SqliteDatabase {
+ private:
+  using StatementMap =
+      std::unordered_map<std::string, PersistentSqliteStatement>;
+
  public:
   using Connection = folly::Synchronized<sqlite3*>::LockedPtr;
 
+  /**
+   * A locked connection for reads, see lockReader(). The statements it
+   * prepares are cached on the connection, and reset when the
+   * ReadConnection is released so that no read transaction stays open.
+   */
+  class ReadConnection {
+   public:
+    ReadConnection(ReadConnection&&) = default;
+    ReadConnection& operator=(ReadConnection&&) = default;
+    ~ReadConnection();
+
+    /**
+     * Returns the statement for sql, prepared the first time the connection
+     * runs it, and ready to be bound.
+     */
+    SqliteStatement& statement(folly::StringPiece sql);
+
+    Connection& connection() {
+      return conn_;
+    }
+
+   private:
+    friend class SqliteDatabase;
+
+    ReadConnection(Connection conn, StatementMap& statements)
+        : conn_{std::move(conn)}, statements_{&statements} {}
+
+    Connection conn_;
+    StatementMap* statements_;
+    std::vector<PersistentSqliteStatement*> used_;
+  };
+
   constexpr static struct InMemory {
   } inMemory{};
 
@@ -56,6 +97,26 @@ class SqliteDatabase {
    * to the SqliteStatement class. */
   Connection lock();
 
+  /**
+   * Open count more connections to the database, dedicated to reads. In WAL
+   * mode, reads on them don't block each other nor the writer, which keeps
+   * using lock() and transaction(). Read connections are query_only, and map
+   * mmapSize bytes of the database if it is not 0.
+   *
+   * Does nothing for in-memory databases, as each connection to them has its
+   * own database, nor if readers are already open.
+   */
+  void openReaders(size_t count, uint64_t mmapSize = 0);
+
+  /**
+   * Lock a connection to run reads on, preferring one not used by another
+   * thread. Without readers, this is the connection returned by lock().
+   *
+   * Reads on a reader see the transactions committed before they start, but
+   * not the ones in progress on this thread.
+   */
+  ReadConnection lockReader();
+
   /**
    * Executes a SQLite transaction. If the lambda body throws any error, the
    * transaction will be rolled back. This function returns a boolean to
@@ -75,10 +136,23 @@ class SqliteDatabase {
  private:
   struct StatementCache;
 
+  struct Reader {
+    folly::Synchronized<sqlite3*> db{nullptr};
+    /** Only used with db locked. */
+    StatementMap statements;
+  };
+
   explicit SqliteDatabase(const char* address);
 
+  std::string address_;
+
   folly::Synchronized<sqlite3*> db_{nullptr};
 
   std::unique_ptr<StatementCache> cache_;
+
+  /** The read statements of db_, used with it locked. */
+  StatementMap statements_;
+
+  std::vector<std::unique_ptr<Reader>> readers_;
 };
 } // namespace facebook::eden
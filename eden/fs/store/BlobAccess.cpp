@@ -16,25 +16,34 @@ namespace facebook::eden {
 BlobAccess::BlobAccess(
     std::shared_ptr<IObjectStore> objectStore,
     std::shared_ptr<BlobCache> blobCache)
-    : objectStore_{std::move(objectStore)}, blobCache_{std::move(blobCache)} {}
+    : objectStore_{std::move(objectStore)},
+      blobCache_{std::move(blobCache)},
+      cacheClient_{blobCache_->registerClient()} {}
 
-BlobAccess::~BlobAccess() {}
+BlobAccess::~BlobAccess() {
+  blobCache_->unregisterClient(cacheClient_);
+}
 
 folly::Future<BlobCache::GetResult> BlobAccess::getBlob(
     const ObjectId& hash,
     ObjectFetchContext& context,
     BlobCache::Interest interest) {
-  auto result = blobCache_->get(hash, interest);
+  auto result = blobCache_->get(hash, interest, cacheClient_);
   if (result.object) {
     return folly::Future<BlobCache::GetResult>{std::move(result)};
   }
 
   return objectStore_->getBlob(hash, context)
       .thenValue([blobCache = blobCache_,
-                  interest](std::shared_ptr<const Blob> blob) {
-        auto interestHandle = blobCache->insert(blob, interest);
+                  interest,
+                  client = cacheClient_](std::shared_ptr<const Blob> blob) {
+        auto interestHandle = blobCache->insert(blob, interest, client);
         return BlobCache::GetResult{std::move(blob), std::move(interestHandle)};
       });
 }
 
+BlobCache::ClientStats BlobAccess::getCacheStats() const {
+  return blobCache_->getClientStats(cacheClient_);
+}
+
 } // namespace facebook::eden
@@ -58,12 +58,19 @@ class BlobAccess {
       ObjectFetchContext& context,
       BlobCache::Interest interest = BlobCache::Interest::LikelyNeededAgain);
 
+  /**
+   * Returns the accounting of the blobs this BlobAccess loaded into the
+   * BlobCache, which may be shared with other mounts.
+   */
+  BlobCache::ClientStats getCacheStats() const;
+
  private:
   BlobAccess(const BlobAccess&) = delete;
   BlobAccess& operator=(const BlobAccess&) = delete;
 
   const std::shared_ptr<IObjectStore> objectStore_;
   const std::shared_ptr<BlobCache> blobCache_;
+  const BlobCache::ClientId cacheClient_;
 };
 
 } // namespace facebook::eden
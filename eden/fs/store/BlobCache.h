@@ -6,7 +6,9 @@
  */
 
 #pragma once
+#include <folly/logging/xlog.h>
 #include "eden/fs/model/Blob.h"
+#include "eden/fs/store/CompressedBlobCache.h"
 #include "eden/fs/store/ObjectCache.h"
 
 namespace facebook::eden {
@@ -23,17 +25,47 @@ using BlobInterestHandle = ObjectInterestHandle<Blob>;
  * frequently-accessed large blobs when they are larger than the maximum cache
  * size.
  *
+ * The cache can be split into multiple independently locked shards to reduce
+ * lock contention between FUSE worker threads.
+ *
+ * Blobs larger than an optional threshold are kept in a separate, bounded
+ * large blob tier instead, or not cached at all, so that reading one huge file
+ * doesn't evict the small files compilers keep coming back to.
+ *
+ * Optionally, the blobs evicted from the cache are kept LZ4-compressed in a
+ * CompressedBlobCache, and promoted back when accessed again. It typically
+ * holds a working set of source files several times larger than its budget.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
  public:
   static std::shared_ptr<BlobCache> create(
       size_t maximumCacheSizeBytes,
-      size_t minimumEntryCount) {
+      size_t minimumEntryCount,
+      size_t shardCount = 1,
+      CacheEvictionPolicy evictionPolicy = CacheEvictionPolicy::LRU,
+      size_t largeBlobThresholdBytes = 0,
+      size_t largeBlobCacheSizeBytes = 0,
+      size_t compressedCacheSizeBytes = 0) {
     struct BC : BlobCache {
-      BC(size_t x, size_t y) : BlobCache{x, y} {}
+      BC(size_t x,
+         size_t y,
+         size_t z,
+         CacheEvictionPolicy p,
+         size_t t,
+         size_t l,
+         size_t c)
+          : BlobCache{x, y, z, p, t, l, c} {}
     };
-    return std::make_shared<BC>(maximumCacheSizeBytes, minimumEntryCount);
+    return std::make_shared<BC>(
+        maximumCacheSizeBytes,
+        minimumEntryCount,
+        shardCount,
+        evictionPolicy,
+        largeBlobThresholdBytes,
+        largeBlobCacheSizeBytes,
+        compressedCacheSizeBytes);
   }
   ~BlobCache() = default;
 
@@ -48,11 +80,21 @@ class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
    * After fetching a blob, prefer calling getBlob() on the returned
    * BlobInterestHandle first. It can avoid some overhead or return a blob if
    * it still exists in memory and the BlobCache has evicted its reference.
+   *
+   * The hit or miss is accounted to the given client, see registerClient().
    */
   GetResult get(
       const ObjectId& hash,
-      Interest interest = Interest::LikelyNeededAgain) {
-    return getInterestHandle(hash, interest);
+      Interest interest = Interest::LikelyNeededAgain,
+      ClientId client = kNoClient) {
+    auto result = getInterestHandle(hash, interest, client);
+    if (!result.object && compressed_) {
+      if (auto blob = compressed_->take(hash)) {
+        auto interestHandle = insert(blob, interest, client);
+        return GetResult{std::move(blob), std::move(interestHandle)};
+      }
+    }
+    return result;
   }
 
   /**
@@ -62,18 +104,72 @@ class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
    *
    * Optionally returns an interest handle that, when dropped, evicts the
    * inserted blob.
+   *
+   * The blob is charged to the given client, see registerClient().
    */
   BlobInterestHandle insert(
       ObjectPtr blob,
-      Interest interest = Interest::LikelyNeededAgain) {
-    return insertInterestHandle(blob, interest);
+      Interest interest = Interest::LikelyNeededAgain,
+      ClientId client = kNoClient) {
+    return insertInterestHandle(blob, interest, client);
+  }
+
+  /**
+   * Evicts everything from cache, including the compressed tier.
+   */
+  void clear() {
+    ObjectCache<Blob, ObjectCacheFlavor::InterestHandle>::clear();
+    if (compressed_) {
+      compressed_->clear();
+    }
+  }
+
+  /**
+   * Return information about the compressed tier, which is empty if it is
+   * disabled.
+   */
+  CompressedBlobCache::Stats getCompressedStats() const {
+    return compressed_ ? compressed_->getStats() : CompressedBlobCache::Stats{};
   }
 
  private:
-  explicit BlobCache(size_t maximumCacheSizeBytes, size_t minimumEntryCount)
+  explicit BlobCache(
+      size_t maximumCacheSizeBytes,
+      size_t minimumEntryCount,
+      size_t shardCount,
+      CacheEvictionPolicy evictionPolicy,
+      size_t largeBlobThresholdBytes,
+      size_t largeBlobCacheSizeBytes,
+      size_t compressedCacheSizeBytes)
       : ObjectCache<Blob, ObjectCacheFlavor::InterestHandle>{
             maximumCacheSizeBytes,
-            minimumEntryCount} {}
+            minimumEntryCount,
+            shardCount,
+            evictionPolicy,
+            largeBlobThresholdBytes,
+            largeBlobCacheSizeBytes} {
+    if (compressedCacheSizeBytes == 0) {
+      return;
+    }
+    if (!CompressedBlobCache::isSupported()) {
+      XLOG(WARN) << "LZ4 is not available, the compressed blob cache is "
+                    "disabled";
+      return;
+    }
+    compressed_ = std::make_unique<CompressedBlobCache>(
+        compressedCacheSizeBytes, shardCount);
+    setEvictionHandler([compressed = compressed_.get()](
+                           std::vector<ObjectPtr> blobs) {
+      for (auto& blob : blobs) {
+        compressed->insert(*blob);
+      }
+    });
+  }
+
+  /**
+   * The compressed tier, null if disabled.
+   */
+  std::unique_ptr<CompressedBlobCache> compressed_;
 };
 
 } // namespace facebook::eden
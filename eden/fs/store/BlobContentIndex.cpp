@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BlobContentIndex.h"
+
+#include "eden/fs/model/Blob.h"
+
+namespace facebook::eden {
+
+BlobContentIndex::BlobContentIndex(size_t maxEntries)
+    : entries_{folly::in_place, maxEntries} {}
+
+BlobContentIndex::InternResult BlobContentIndex::intern(
+    std::shared_ptr<const Blob> blob,
+    const Hash20& sha1) {
+  auto entries = entries_.lock();
+  auto it = entries->find(sha1);
+  if (it != entries->end()) {
+    auto existing = it->second.lock();
+    if (existing && existing->getSize() == blob->getSize()) {
+      if (existing->getHash() == blob->getHash()) {
+        return InternResult{std::move(existing), true};
+      }
+      // Copying an IOBuf shares its buffer rather than the bytes.
+      return InternResult{
+          std::make_shared<const Blob>(
+              blob->getHash(), existing->getContents()),
+          true};
+    }
+  }
+  entries->set(sha1, blob);
+  return InternResult{std::move(blob), false};
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <memory>
+#include <mutex>
+
+#include "eden/fs/model/Hash.h"
+
+namespace facebook::eden {
+
+class Blob;
+
+/**
+ * Remembers the recently fetched blobs by the SHA-1 of their contents, so
+ * that blobs with the same contents under different IDs share one buffer in
+ * memory. Mercurial gives copied files, reverted changes and vendored
+ * duplicates distinct file nodes, and a checkout loads them all.
+ *
+ * Only weak references to the blobs are kept: a buffer is shared for as long
+ * as some cache or inode keeps one of its blobs alive. The number of
+ * remembered contents is bounded by maxEntries.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class BlobContentIndex {
+ public:
+  explicit BlobContentIndex(size_t maxEntries);
+
+  struct InternResult {
+    std::shared_ptr<const Blob> blob;
+    /** Whether the returned blob shares the buffer of an earlier one. */
+    bool deduplicated;
+  };
+
+  /**
+   * Returns a blob with the ID and contents of blob, whose contents hash to
+   * sha1. It shares the buffer of a live blob with the same contents if there
+   * is one; otherwise blob itself is returned and remembered.
+   */
+  InternResult intern(std::shared_ptr<const Blob> blob, const Hash20& sha1);
+
+ private:
+  folly::Synchronized<
+      folly::EvictingCacheMap<Hash20, std::weak_ptr<const Blob>>,
+      std::mutex>
+      entries_;
+};
+
+} // namespace facebook::eden
@@ -8,21 +8,27 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
+#include "eden/fs/model/Blake3.h"
 #include "eden/fs/model/Hash.h"
 
 namespace facebook::eden {
 
 /**
  * A small struct containing both the size and the SHA-1 hash of
- * a Blob's contents.
+ * a Blob's contents, and its BLAKE3 hash once it has been requested.
  */
 class BlobMetadata {
  public:
-  BlobMetadata(Hash20 contentsHash, uint64_t fileLength)
-      : sha1(contentsHash), size(fileLength) {}
+  BlobMetadata(
+      Hash20 contentsHash,
+      uint64_t fileLength,
+      std::optional<Blake3Hash> blake3Hash = std::nullopt)
+      : sha1(contentsHash), size(fileLength), blake3(blake3Hash) {}
 
   Hash20 sha1;
   uint64_t size;
+  std::optional<Blake3Hash> blake3;
 };
 
 } // namespace facebook::eden
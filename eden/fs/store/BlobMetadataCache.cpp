@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BlobMetadataCache.h"
+
+#include <folly/hash/Hash.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+BlobMetadataCache::BlobMetadataCache(size_t maximumEntries, size_t shardCount)
+    : shards_(std::max<size_t>(shardCount, 1)) {
+  auto entriesPerShard = std::max<size_t>(maximumEntries / shards_.size(), 1);
+  for (auto& shard : shards_) {
+    shard.entries.setMaxSize(entriesPerShard);
+  }
+}
+
+BlobMetadataCache::Shard& BlobMetadataCache::getShard(
+    const ObjectId& id) const {
+  if (shards_.size() == 1) {
+    return shards_[0];
+  }
+  // EvictingCacheMap buckets by the same hash code, so mix it before picking
+  // a shard to keep the two distributions independent.
+  auto index = folly::hash::twang_mix64(id.getHashCode()) % shards_.size();
+  return shards_[index];
+}
+
+std::optional<BlobMetadata> BlobMetadataCache::get(const ObjectId& id) {
+  auto& shard = getShard(id);
+  std::lock_guard<InstrumentedMutex<std::mutex, LockName>> lock{shard.lock};
+  auto it = shard.entries.find(id);
+  if (it == shard.entries.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+bool BlobMetadataCache::contains(const ObjectId& id) const {
+  auto& shard = getShard(id);
+  std::lock_guard<InstrumentedMutex<std::mutex, LockName>> lock{shard.lock};
+  return shard.entries.exists(id);
+}
+
+void BlobMetadataCache::set(const ObjectId& id, const BlobMetadata& metadata) {
+  auto& shard = getShard(id);
+  std::lock_guard<InstrumentedMutex<std::mutex, LockName>> lock{shard.lock};
+  shard.entries.set(id, metadata);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/lang/Align.h>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/store/BlobMetadata.h"
+#include "eden/fs/telemetry/InstrumentedMutex.h"
+
+namespace facebook::eden {
+
+/**
+ * A bounded in-memory LRU cache of the metadata of blobs, so that the sizes
+ * and SHA-1s looked up by stat, status and checkout do not have to come from
+ * the LocalStore.
+ *
+ * Like ObjectCache, the cache is split into independently locked shards keyed
+ * by the hash of the ObjectId, each holding an equal share of the entries, so
+ * that concurrent lookups from many FUSE threads do not serialize on one
+ * lock. Eviction is LRU within a shard.
+ *
+ * Entries are stored by value in a folly::EvictingCacheMap rather than in an
+ * ObjectCache, which would need a separate allocation per entry: the cache
+ * holds a million entries, and each is only about 60 bytes of data.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class BlobMetadataCache {
+ public:
+  /**
+   * Create a cache holding at most maximumEntries entries, split across
+   * shardCount shards. A shardCount of 0 is treated as 1.
+   */
+  BlobMetadataCache(size_t maximumEntries, size_t shardCount);
+
+  /**
+   * Returns the metadata of the given blob, and marks it as the most recently
+   * used in its shard, if it is in cache.
+   */
+  std::optional<BlobMetadata> get(const ObjectId& id);
+
+  /**
+   * Returns true if the metadata of the given blob is in cache, without
+   * affecting the eviction order.
+   */
+  bool contains(const ObjectId& id) const;
+
+  /**
+   * Inserts or replaces the metadata of the given blob, evicting the least
+   * recently used entry of its shard if the shard is full.
+   */
+  void set(const ObjectId& id, const BlobMetadata& metadata);
+
+  size_t getShardCount() const {
+    return shards_.size();
+  }
+
+ private:
+  struct LockName {
+    static const char* name() {
+      return "blob_metadata_cache";
+    }
+  };
+
+  /**
+   * Shards are aligned to avoid false sharing between the locks of
+   * neighboring shards.
+   */
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    InstrumentedMutex<std::mutex, LockName> lock;
+    // Resized by the BlobMetadataCache constructor.
+    folly::EvictingCacheMap<ObjectId, BlobMetadata> entries{1};
+  };
+
+  Shard& getShard(const ObjectId& id) const;
+
+  mutable std::vector<Shard> shards_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/CompressedBlobCache.h"
+
+#include <folly/compression/Compression.h>
+#include <folly/hash/Hash.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+
+#include "eden/fs/model/Blob.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr auto kCodecType = folly::io::CodecType::LZ4;
+
+/**
+ * Blobs that compress to more than this fraction of their size are not worth
+ * the CPU time spent decompressing them, nor the budget they'd use.
+ */
+constexpr size_t kMaximumCompressedPercent = 90;
+} // namespace
+
+CompressedBlobCache::CompressedBlobCache(
+    size_t maximumCacheSizeBytes,
+    size_t shardCount)
+    : maximumCacheSizeBytes_{
+          maximumCacheSizeBytes / std::max<size_t>(shardCount, 1)},
+      shards_(std::max<size_t>(shardCount, 1)) {}
+
+bool CompressedBlobCache::isSupported() {
+  return folly::io::hasCodec(kCodecType);
+}
+
+CompressedBlobCache::Shard& CompressedBlobCache::getShard(
+    const ObjectId& id) const {
+  if (shards_.size() == 1) {
+    return shards_[0];
+  }
+  // EvictingCacheMap buckets by the same hash code, so mix it before picking
+  // a shard to keep the two distributions independent.
+  auto index = folly::hash::twang_mix64(id.getHashCode()) % shards_.size();
+  return shards_[index];
+}
+
+void CompressedBlobCache::insert(const Blob& blob) {
+  auto& shard = getShard(blob.getHash());
+  auto size = blob.getSize();
+
+  // Compress outside of the lock, it's by far the most expensive part.
+  auto compressed =
+      folly::io::getCodec(kCodecType)->compress(&blob.getContents());
+  auto compressedSize = compressed->computeChainDataLength();
+  if (compressedSize * 100 >= size * kMaximumCompressedPercent ||
+      compressedSize > maximumCacheSizeBytes_) {
+    std::lock_guard<InstrumentedMutex<std::mutex, LockName>> lock{shard.lock};
+    ++shard.incompressibleCount;
+    return;
+  }
+  // The codec allocates for the worst case, don't hold on to the slack.
+  auto range = compressed->coalesce();
+  if (compressed->capacity() > range.size()) {
+    compressed = folly::IOBuf::copyBuffer(range);
+  }
+
+  std::lock_guard<InstrumentedMutex<std::mutex, LockName>> lock{shard.lock};
+  if (shard.entries.exists(blob.getHash())) {
+    return;
+  }
+  shard.entries.set(blob.getHash(), Entry{std::move(compressed), size});
+  shard.totalSize += compressedSize;
+  shard.uncompressedSize += size;
+  ++shard.insertCount;
+
+  auto* rawShard = &shard;
+  while (shard.totalSize > maximumCacheSizeBytes_) {
+    shard.entries.prune(1, [rawShard](ObjectId, Entry&& evicted) {
+      rawShard->totalSize -= evicted.compressed->computeChainDataLength();
+      rawShard->uncompressedSize -= evicted.uncompressedSize;
+      ++rawShard->evictionCount;
+    });
+  }
+}
+
+std::shared_ptr<const Blob> CompressedBlobCache::take(const ObjectId& id) {
+  auto& shard = getShard(id);
+  Entry entry;
+  {
+    std::lock_guard<InstrumentedMutex<std::mutex, LockName>> lock{shard.lock};
+    auto it = shard.entries.findWithoutPromotion(id);
+    if (it == shard.entries.end()) {
+      ++shard.missCount;
+      return nullptr;
+    }
+    entry = std::move(it->second);
+    shard.entries.erase(id);
+    shard.totalSize -= entry.compressed->computeChainDataLength();
+    shard.uncompressedSize -= entry.uncompressedSize;
+    ++shard.hitCount;
+  }
+
+  try {
+    auto contents = folly::io::getCodec(kCodecType)->uncompress(
+        entry.compressed.get(), entry.uncompressedSize);
+    return std::make_shared<const Blob>(id, std::move(*contents));
+  } catch (const std::exception& ex) {
+    // The caller will load the blob again from the LocalStore.
+    XLOG(ERR) << "unable to decompress cached blob " << id << ": "
+              << folly::exceptionStr(ex);
+    return nullptr;
+  }
+}
+
+void CompressedBlobCache::clear() {
+  for (auto& shard : shards_) {
+    std::lock_guard<InstrumentedMutex<std::mutex, LockName>> lock{shard.lock};
+    shard.entries.clear();
+    shard.totalSize = 0;
+    shard.uncompressedSize = 0;
+  }
+}
+
+CompressedBlobCache::Stats CompressedBlobCache::getStats() const {
+  Stats stats;
+  for (auto& shard : shards_) {
+    std::lock_guard<InstrumentedMutex<std::mutex, LockName>> lock{shard.lock};
+    stats.objectCount += shard.entries.size();
+    stats.totalSizeInBytes += shard.totalSize;
+    stats.uncompressedSizeInBytes += shard.uncompressedSize;
+    stats.hitCount += shard.hitCount;
+    stats.missCount += shard.missCount;
+    stats.insertCount += shard.insertCount;
+    stats.evictionCount += shard.evictionCount;
+    stats.incompressibleCount += shard.incompressibleCount;
+  }
+  return stats;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/io/IOBuf.h>
+#include <folly/lang/Align.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/telemetry/InstrumentedMutex.h"
+
+namespace facebook::eden {
+
+class Blob;
+
+/**
+ * A bounded in-memory LRU cache of LZ4-compressed blobs, used by BlobCache as
+ * a second tier for the blobs it evicts. Source files typically compress 3-4x,
+ * so this holds several times more of the working set than the same budget
+ * of uncompressed blobs, and decompressing is much cheaper than going to the
+ * LocalStore.
+ *
+ * Blobs that don't compress well, like most binaries, are not kept.
+ *
+ * Like BlobMetadataCache, the cache is split into independently locked
+ * shards, each with an equal share of the budget. Blobs are compressed and
+ * decompressed outside of the shard locks.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class CompressedBlobCache {
+ public:
+  struct Stats {
+    size_t objectCount{0};
+    /// Bytes used by the compressed blobs, which the budget applies to.
+    size_t totalSizeInBytes{0};
+    /// Bytes the cached blobs would use uncompressed.
+    size_t uncompressedSizeInBytes{0};
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+    uint64_t insertCount{0};
+    uint64_t evictionCount{0};
+    /// Number of blobs that were not inserted because they didn't compress
+    /// well enough.
+    uint64_t incompressibleCount{0};
+  };
+
+  /**
+   * Create a cache holding at most maximumCacheSizeBytes worth of compressed
+   * blobs, split across shardCount shards. A shardCount of 0 is treated as 1.
+   */
+  CompressedBlobCache(size_t maximumCacheSizeBytes, size_t shardCount);
+
+  /**
+   * Returns false if this build of folly has no LZ4 support, in which case
+   * the cache must not be created.
+   */
+  static bool isSupported();
+
+  /**
+   * Compresses the blob and inserts it, evicting the least recently used
+   * blobs of its shard until the shard fits its budget.
+   */
+  void insert(const Blob& blob);
+
+  /**
+   * If the blob is in cache, removes and returns it, decompressed. Intended
+   * for promoting it back to the BlobCache, which then owns it.
+   */
+  std::shared_ptr<const Blob> take(const ObjectId& id);
+
+  /**
+   * Evicts everything from cache.
+   */
+  void clear();
+
+  /**
+   * Return the current size of the cache and its counters, summed across all
+   * shards.
+   */
+  Stats getStats() const;
+
+ private:
+  struct LockName {
+    static const char* name() {
+      return "compressed_blob_cache";
+    }
+  };
+
+  struct Entry {
+    std::unique_ptr<folly::IOBuf> compressed;
+    size_t uncompressedSize{0};
+  };
+
+  /**
+   * Shards are aligned to avoid false sharing between the locks of
+   * neighboring shards.
+   */
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    InstrumentedMutex<std::mutex, LockName> lock;
+    // The byte budget is enforced by insert(), not by the map.
+    folly::EvictingCacheMap<ObjectId, Entry> entries{0};
+    size_t totalSize{0};
+    size_t uncompressedSize{0};
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+    uint64_t insertCount{0};
+    uint64_t evictionCount{0};
+    uint64_t incompressibleCount{0};
+  };
+
+  Shard& getShard(const ObjectId& id) const;
+
+  /// Per-shard budget: the configured total divided across the shards.
+  const size_t maximumCacheSizeBytes_;
+  mutable std::vector<Shard> shards_;
+};
+
+} // namespace facebook::eden
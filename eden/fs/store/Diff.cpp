@@ -11,7 +11,10 @@
 #include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
+#include <algorithm>
+#include <deque>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "eden/fs/model/Tree.h"
@@ -20,6 +23,7 @@
 #include "eden/fs/store/DiffContext.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/ScmStatusDiffCallback.h"
+#include "eden/fs/store/StatsFetchContext.h"
 #include "eden/fs/utils/Future.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -51,14 +55,6 @@ struct ChildFutures {
   vector<Future<Unit>> futures;
 };
 
-struct DiffState {
-  explicit DiffState(const ObjectStore* store)
-      : callback{}, context{&callback, store} {}
-
-  ScmStatusDiffCallback callback;
-  DiffContext context;
-};
-
 static constexpr PathComponentPiece kIgnoreFilename{".gitignore"};
 
 Future<Unit> diffAddedTree(
@@ -181,6 +177,41 @@ FOLLY_NODISCARD Future<Unit> computeTreeDiff(
       .ensure([ignore = std::move(ignore)] {});
 }
 
+/**
+ * Load the ignore rules of the .gitignore entry gitIgnoreEntry of the tree at
+ * currentPath.  Errors are logged, and result in an empty set of rules.
+ */
+Future<std::shared_ptr<const GitIgnore>> loadGitIgnore(
+    DiffContext* context,
+    RelativePathPiece currentPath,
+    const TreeEntry& gitIgnoreEntry) {
+  auto entryPath = currentPath + gitIgnoreEntry.getName();
+  auto future = Future<std::shared_ptr<const GitIgnore>>::makeEmpty();
+  if (gitIgnoreEntry.getType() == TreeEntryType::REGULAR_FILE ||
+      gitIgnoreEntry.getType() == TreeEntryType::EXECUTABLE_FILE) {
+    future = context->loadGitIgnore(gitIgnoreEntry.getHash());
+  } else {
+    // Symlinks have to be resolved through the working copy.
+    auto loadFileContentsFromPath = context->getLoadFileContentsFromPath();
+    future =
+        loadFileContentsFromPath(context->getFetchContext(), entryPath)
+            .thenValue([](std::string&& ignoreFileContents) {
+              auto ignore = std::make_shared<GitIgnore>();
+              ignore->loadFile(ignoreFileContents);
+              return std::shared_ptr<const GitIgnore>{std::move(ignore)};
+            });
+  }
+  return std::move(future).thenError(
+      [entryPath = std::move(entryPath)](const folly::exception_wrapper& ex) {
+        // TODO: add an API to DiffCallback to report user errors like this
+        // (errors that do not indicate a problem with EdenFS itself) that can
+        // be returned to the caller in a thrift response
+        XLOG(WARN) << "error loading gitignore at " << entryPath << ": "
+                   << folly::exceptionStr(ex);
+        return std::shared_ptr<const GitIgnore>{std::make_shared<GitIgnore>()};
+      });
+}
+
 FOLLY_NODISCARD Future<Unit> loadGitIgnoreThenDiffTrees(
     const TreeEntry& gitIgnoreEntry,
     DiffContext* context,
@@ -189,32 +220,19 @@ FOLLY_NODISCARD Future<Unit> loadGitIgnoreThenDiffTrees(
     const Tree& wdTree,
     const GitIgnoreStack* parentIgnore,
     bool isIgnored) {
-  // TODO: load file contents directly from context->store if gitIgnoreEntry is
-  // a regular file
-  auto loadFileContentsFromPath = context->getLoadFileContentsFromPath();
-  return loadFileContentsFromPath(
-             context->getFetchContext(), currentPath + gitIgnoreEntry.getName())
-      .thenError([entryPath = currentPath + gitIgnoreEntry.getName()](
-                     const folly::exception_wrapper& ex) {
-        // TODO: add an API to DiffCallback to report user errors like this
-        // (errors that do not indicate a problem with EdenFS itself) that can
-        // be returned to the caller in a thrift response
-        XLOG(WARN) << "error loading gitignore at " << entryPath << ": "
-                   << folly::exceptionStr(ex);
-        return std::string{};
-      })
+  return loadGitIgnore(context, currentPath, gitIgnoreEntry)
       .thenValue([context,
                   currentPath = currentPath.copy(),
                   scmTree,
                   wdTree,
                   parentIgnore,
-                  isIgnored](std::string&& ignoreFileContents) mutable {
+                  isIgnored](std::shared_ptr<const GitIgnore> ignore) mutable {
         return computeTreeDiff(
             context,
             currentPath,
             scmTree,
             wdTree,
-            make_unique<GitIgnoreStack>(parentIgnore, ignoreFileContents),
+            make_unique<GitIgnoreStack>(parentIgnore, std::move(ignore)),
             isIgnored);
       });
 }
@@ -302,25 +320,17 @@ FOLLY_NODISCARD Future<Unit> loadGitIgnoreThenProcessAddedChildren(
     const Tree& wdTree,
     const GitIgnoreStack* parentIgnore,
     bool isIgnored) {
-  auto loadFileContentsFromPath = context->getLoadFileContentsFromPath();
-  return loadFileContentsFromPath(
-             context->getFetchContext(), currentPath + gitIgnoreEntry.getName())
-      .thenError([entryPath = currentPath + gitIgnoreEntry.getName()](
-                     const folly::exception_wrapper& ex) {
-        XLOG(WARN) << "error loading gitignore at " << entryPath << ": "
-                   << folly::exceptionStr(ex);
-        return std::string{};
-      })
+  return loadGitIgnore(context, currentPath, gitIgnoreEntry)
       .thenValue([context,
                   currentPath = currentPath.copy(),
                   wdTree,
                   parentIgnore,
-                  isIgnored](std::string&& ignoreFileContents) mutable {
+                  isIgnored](std::shared_ptr<const GitIgnore> ignore) mutable {
         return processAddedChildren(
             context,
             currentPath,
             wdTree,
-            make_unique<GitIgnoreStack>(parentIgnore, ignoreFileContents),
+            make_unique<GitIgnoreStack>(parentIgnore, std::move(ignore)),
             isIgnored);
       });
 }
@@ -475,6 +485,13 @@ void processBothPresent(
     const TreeEntry& wdEntry,
     const GitIgnoreStack* ignore,
     bool isIgnored) {
+  // Identical entries are by far the most common case, check for them before
+  // building the path of the entry.
+  if (scmEntry.getType() == wdEntry.getType() &&
+      scmEntry.getHash() == wdEntry.getHash()) {
+    return;
+  }
+
   bool entryIgnored = isIgnored;
   auto entryPath = currentPath + scmEntry.getName();
   // If wdEntry and scmEntry are both files (or symlinks) then we don't need
@@ -504,9 +521,6 @@ void processBothPresent(
     if (isTreeWD) {
       // tree-to-tree diff
       XDCHECK_EQ(scmEntry.getType(), wdEntry.getType());
-      if (scmEntry.getHash() == wdEntry.getHash()) {
-        return;
-      }
       auto childFuture = diffTrees(
           context,
           entryPath,
@@ -557,15 +571,15 @@ void processBothPresent(
         // on the blob ID comparison instead.
         auto compareEntryContents =
             folly::makeFutureWith([context,
-                                   entryPath = currentPath + scmEntry.getName(),
+                                   entryPath = entryPath.copy(),
                                    &scmEntry,
-                                   &wdEntry] {
+                                   &wdEntry]() mutable {
               auto scmFuture = context->store->getBlobSha1(
                   scmEntry.getHash(), context->getFetchContext());
               auto wdFuture = context->store->getBlobSha1(
                   wdEntry.getHash(), context->getFetchContext());
               return collectAllSafe(scmFuture, wdFuture)
-                  .thenValue([entryPath = entryPath.copy(),
+                  .thenValue([entryPath = std::move(entryPath),
                               context](const std::tuple<Hash20, Hash20>& info) {
                     const auto& [scmHash, wdHash] = info;
                     if (scmHash != wdHash) {
@@ -606,45 +620,292 @@ FOLLY_NODISCARD Future<Unit> waitOnResults(
 }
 
 /**
- * Diff two commits.
+ * Diffs two source control trees breadth first.
+ *
+ * Directories that differ are queued rather than diffed as soon as they are
+ * found, and the queue is drained in batches: all the trees and blob SHA-1s
+ * needed by a batch are requested at once, so that they reach the backing
+ * store together and are imported in as few round trips as it allows.
+ * Subtrees and files with identical hashes are skipped without being loaded.
  *
- * The differences will be recorded using a callback inside of DiffState and
- * will be extracted and returned to the caller.
+ * At most maxBatchSize pairs of trees are loaded at any time, and a batch's
+ * trees are released once their entries have been compared. Differences
+ * are reported to the callback as they are found, and never concurrently.
  */
-FOLLY_NODISCARD Future<Unit>
-diffRoots(DiffContext* context, const RootId& root1, const RootId& root2) {
-  auto future1 = context->store->getRootTree(root1, context->getFetchContext());
-  auto future2 = context->store->getRootTree(root2, context->getFetchContext());
-  return collectSafe(future1, future2)
-      .thenValue([context](std::tuple<
-                           std::shared_ptr<const Tree>,
-                           std::shared_ptr<const Tree>>&& tup) {
-        const auto& [tree1, tree2] = tup;
-
-        // This happens in the case in which the CLI (during eden doctor) calls
-        // getScmStatusBetweenRevisions() with the same hash in order to check
-        // if a commit hash is valid.
-        if (tree1->getHash() == tree2->getHash()) {
-          return makeFuture();
-        }
+class CommitDiff {
+ public:
+  CommitDiff(
+      const ObjectStore* store,
+      DiffCallback* callback,
+      size_t maxBatchSize)
+      : store_{store},
+        callback_{callback},
+        maxBatchSize_{std::max<size_t>(maxBatchSize, 1)} {}
+
+  /**
+   * Compare the root trees of the two commits, then process the queued
+   * directories until none are left.
+   */
+  static ImmediateFuture<Unit> run(
+      std::shared_ptr<CommitDiff> diff,
+      const Tree& fromTree,
+      const Tree& toTree) {
+    diff->compareTrees(RelativePathPiece{}, &fromTree, &toTree);
+    return processQueue(std::move(diff));
+  }
 
-        return diffTrees(
-            context, RelativePathPiece{}, *tree1, *tree2, nullptr, false);
-      });
-}
+  StatsFetchContext& getFetchContext() {
+    return fetchContext_;
+  }
+
+ private:
+  /**
+   * A directory present in at least one of the commits. A missing side means
+   * the whole directory was added or removed.
+   */
+  struct TreePair {
+    RelativePath path;
+    std::optional<ObjectId> fromTree;
+    std::optional<ObjectId> toTree;
+  };
+
+  /**
+   * A file present in both commits, with different blob IDs.
+   */
+  struct BlobPair {
+    RelativePath path;
+    ObjectId fromBlob;
+    ObjectId toBlob;
+  };
+
+  static ImmediateFuture<Unit> processQueue(std::shared_ptr<CommitDiff> diff) {
+    // Batches whose objects are all cached complete immediately; loop over
+    // them rather than recursing.
+    while (!diff->pendingTrees_.empty() || !diff->pendingBlobs_.empty()) {
+      auto batch = diff->processBatch();
+      if (!batch.isReady()) {
+        return std::move(batch).thenValue(
+            [diff = std::move(diff)](auto&&) mutable {
+              return processQueue(std::move(diff));
+            });
+      }
+      std::move(batch).get();
+    }
+    return folly::unit;
+  }
+
+  ImmediateFuture<Unit> processBatch() {
+    std::vector<TreePair> trees;
+    while (!pendingTrees_.empty() && trees.size() < maxBatchSize_) {
+      trees.push_back(std::move(pendingTrees_.front()));
+      pendingTrees_.pop_front();
+    }
+    std::vector<BlobPair> blobs;
+    while (!pendingBlobs_.empty() && blobs.size() < maxBatchSize_) {
+      blobs.push_back(std::move(pendingBlobs_.front()));
+      pendingBlobs_.pop_front();
+    }
+
+    std::vector<ImmediateFuture<std::shared_ptr<const Tree>>> treeFutures;
+    treeFutures.reserve(trees.size() * 2);
+    for (const auto& pair : trees) {
+      treeFutures.push_back(getTree(pair.fromTree));
+      treeFutures.push_back(getTree(pair.toTree));
+    }
+    std::vector<ImmediateFuture<Hash20>> sha1Futures;
+    sha1Futures.reserve(blobs.size() * 2);
+    for (const auto& pair : blobs) {
+      sha1Futures.push_back(store_->getBlobSha1(pair.fromBlob, fetchContext_));
+      sha1Futures.push_back(store_->getBlobSha1(pair.toBlob, fetchContext_));
+    }
+
+    return collectAllSafe(
+               collectAll(std::move(treeFutures)),
+               collectAll(std::move(sha1Futures)))
+        .thenValue([this, trees = std::move(trees), blobs = std::move(blobs)](
+                       std::tuple<
+                           std::vector<Try<std::shared_ptr<const Tree>>>,
+                           std::vector<Try<Hash20>>>&& results) {
+          auto& [treeResults, sha1Results] = results;
+          for (size_t i = 0; i < trees.size(); ++i) {
+            const auto& fromTree = treeResults[2 * i];
+            const auto& toTree = treeResults[2 * i + 1];
+            if (fromTree.hasException() || toTree.hasException()) {
+              reportError(trees[i].path, fromTree, toTree);
+              continue;
+            }
+            compareTrees(trees[i].path, fromTree->get(), toTree->get());
+          }
+          for (size_t i = 0; i < blobs.size(); ++i) {
+            const auto& fromSha1 = sha1Results[2 * i];
+            const auto& toSha1 = sha1Results[2 * i + 1];
+            if (fromSha1.hasException() || toSha1.hasException()) {
+              reportError(blobs[i].path, fromSha1, toSha1);
+            } else if (*fromSha1 != *toSha1) {
+              callback_->modifiedFile(blobs[i].path);
+            }
+          }
+        });
+  }
+
+  ImmediateFuture<std::shared_ptr<const Tree>> getTree(
+      const std::optional<ObjectId>& id) {
+    if (!id) {
+      return std::shared_ptr<const Tree>{};
+    }
+    return store_->getTree(*id, fetchContext_);
+  }
+
+  template <typename T>
+  void reportError(
+      RelativePathPiece path,
+      const Try<T>& fromResult,
+      const Try<T>& toResult) {
+    const auto& error = fromResult.hasException() ? fromResult.exception()
+                                                  : toResult.exception();
+    XLOG(ERR) << "error computing SCM diff for " << path;
+    callback_->diffError(path, error);
+  }
+
+  /**
+   * Compare the entries of two trees, either of which may be null when the
+   * directory only exists on one side.
+   */
+  void compareTrees(
+      RelativePathPiece currentPath,
+      const Tree* fromTree,
+      const Tree* toTree) {
+    if (fromTree && toTree && fromTree->getHash() == toTree->getHash()) {
+      // This happens in the case in which the CLI (during eden doctor) calls
+      // getScmStatusBetweenRevisions() with the same hash in order to check
+      // if a commit hash is valid.
+      return;
+    }
+
+    static const std::vector<TreeEntry> kNoEntries;
+    const auto& fromEntries =
+        fromTree ? fromTree->getTreeEntries() : kNoEntries;
+    const auto& toEntries = toTree ? toTree->getTreeEntries() : kNoEntries;
+    // This relies on the fact that the entry list in each tree is always
+    // sorted.
+    size_t fromIdx = 0;
+    size_t toIdx = 0;
+    while (fromIdx < fromEntries.size() || toIdx < toEntries.size()) {
+      auto compare = CompareResult::BEFORE;
+      if (fromIdx >= fromEntries.size()) {
+        compare = CompareResult::AFTER;
+      } else if (toIdx < toEntries.size()) {
+        compare = comparePathComponent(
+            fromEntries[fromIdx].getName(),
+            toEntries[toIdx].getName(),
+            kPathMapDefaultCaseSensitive);
+      }
+
+      if (compare == CompareResult::BEFORE) {
+        removedEntry(currentPath, fromEntries[fromIdx]);
+        ++fromIdx;
+      } else if (compare == CompareResult::AFTER) {
+        addedEntry(currentPath, toEntries[toIdx]);
+        ++toIdx;
+      } else {
+        bothPresent(currentPath, fromEntries[fromIdx], toEntries[toIdx]);
+        ++fromIdx;
+        ++toIdx;
+      }
+    }
+  }
+
+  void addedEntry(RelativePathPiece currentPath, const TreeEntry& entry) {
+    auto entryPath = currentPath + entry.getName();
+    if (entry.isTree()) {
+      pendingTrees_.push_back(
+          TreePair{std::move(entryPath), std::nullopt, entry.getHash()});
+    } else {
+      callback_->addedFile(entryPath);
+    }
+  }
+
+  void removedEntry(RelativePathPiece currentPath, const TreeEntry& entry) {
+    auto entryPath = currentPath + entry.getName();
+    if (entry.isTree()) {
+      pendingTrees_.push_back(
+          TreePair{std::move(entryPath), entry.getHash(), std::nullopt});
+    } else {
+      callback_->removedFile(entryPath);
+    }
+  }
+
+  void bothPresent(
+      RelativePathPiece currentPath,
+      const TreeEntry& fromEntry,
+      const TreeEntry& toEntry) {
+    if (fromEntry.isTree() && toEntry.isTree()) {
+      if (fromEntry.getHash() != toEntry.getHash()) {
+        pendingTrees_.push_back(TreePair{
+            currentPath + fromEntry.getName(),
+            fromEntry.getHash(),
+            toEntry.getHash()});
+      }
+    } else if (fromEntry.isTree()) {
+      addedEntry(currentPath, toEntry);
+      removedEntry(currentPath, fromEntry);
+    } else if (toEntry.isTree()) {
+      removedEntry(currentPath, fromEntry);
+      addedEntry(currentPath, toEntry);
+    } else if (fromEntry.getType() != toEntry.getType()) {
+      callback_->modifiedFile(currentPath + fromEntry.getName());
+    } else if (fromEntry.getHash() != toEntry.getHash()) {
+      // Even if blobs have different hashes, they could have the same
+      // contents. For example, if between the two revisions being compared,
+      // a file was changed and then later reverted.
+      pendingBlobs_.push_back(BlobPair{
+          currentPath + fromEntry.getName(),
+          fromEntry.getHash(),
+          toEntry.getHash()});
+    }
+  }
+
+  const ObjectStore* const store_;
+  DiffCallback* const callback_;
+  const size_t maxBatchSize_;
+  StatsFetchContext fetchContext_;
+  std::deque<TreePair> pendingTrees_;
+  std::deque<BlobPair> pendingBlobs_;
+};
 } // namespace
 
+Future<Unit> diffCommits(
+    const ObjectStore* store,
+    const RootId& root1,
+    const RootId& root2,
+    DiffCallback* callback,
+    size_t maxBatchSize) {
+  return folly::makeFutureWith([&] {
+    auto diff = std::make_shared<CommitDiff>(store, callback, maxBatchSize);
+    auto future1 = store->getRootTree(root1, diff->getFetchContext());
+    auto future2 = store->getRootTree(root2, diff->getFetchContext());
+    return collectSafe(future1, future2)
+        .thenValue([diff = std::move(diff)](
+                       std::tuple<
+                           std::shared_ptr<const Tree>,
+                           std::shared_ptr<const Tree>>&& tup) mutable {
+          const auto& [tree1, tree2] = tup;
+          return CommitDiff::run(std::move(diff), *tree1, *tree2).semi();
+        });
+  });
+}
+
 Future<std::unique_ptr<ScmStatus>> diffCommitsForStatus(
     const ObjectStore* store,
     const RootId& root1,
-    const RootId& root2) {
+    const RootId& root2,
+    size_t maxBatchSize) {
   return folly::makeFutureWith([&] {
-    auto state = std::make_unique<DiffState>(store);
-    auto statePtr = state.get();
-    auto contextPtr = &(statePtr->context);
-    return diffRoots(contextPtr, root1, root2)
-        .thenValue([state = std::move(state)](auto&&) {
-          return std::make_unique<ScmStatus>(state->callback.extractStatus());
+    auto callback = std::make_unique<ScmStatusDiffCallback>();
+    auto callbackPtr = callback.get();
+    return diffCommits(store, root1, root2, callbackPtr, maxBatchSize)
+        .thenValue([callback = std::move(callback)](auto&&) {
+          return std::make_unique<ScmStatus>(callback->extractStatus());
         });
   });
 }
@@ -656,10 +917,8 @@ FOLLY_NODISCARD Future<Unit> diffTrees(
     ObjectId wdHash,
     const GitIgnoreStack* ignore,
     bool isIgnored) {
-  auto scmTreeFuture =
-      context->store->getTree(scmHash, context->getFetchContext());
-  auto wdTreeFuture =
-      context->store->getTree(wdHash, context->getFetchContext());
+  auto scmTreeFuture = context->getTree(scmHash);
+  auto wdTreeFuture = context->getTree(wdHash);
   // Optimization for the case when both tree objects are immediately ready.
   // We can avoid copying the input path in this case.
   if (scmTreeFuture.isReady() && wdTreeFuture.isReady()) {
@@ -692,9 +951,8 @@ FOLLY_NODISCARD Future<Unit> diffAddedTree(
     ObjectId wdHash,
     const GitIgnoreStack* ignore,
     bool isIgnored) {
-  auto wdFuture = context->store->getTree(wdHash, context->getFetchContext())
-                      .semi()
-                      .via(&folly::QueuedImmediateExecutor::instance());
+  auto wdFuture = context->getTree(wdHash).semi().via(
+      &folly::QueuedImmediateExecutor::instance());
   // Optimization for the case when the tree object is immediately ready.
   // We can avoid copying the input path in this case.
   if (wdFuture.isReady()) {
@@ -713,9 +971,8 @@ FOLLY_NODISCARD Future<Unit> diffRemovedTree(
     DiffContext* context,
     RelativePathPiece currentPath,
     ObjectId scmHash) {
-  auto scmFuture = context->store->getTree(scmHash, context->getFetchContext())
-                       .semi()
-                       .via(&folly::QueuedImmediateExecutor::instance());
+  auto scmFuture = context->getTree(scmHash).semi().via(
+      &folly::QueuedImmediateExecutor::instance());
   // Optimization for the case when the tree object is immediately ready.
   // We can avoid copying the input path in this case.
   if (scmFuture.isReady()) {
@@ -21,10 +21,37 @@ class ObjectId;
 class Hash20;
 class ObjectStore;
 class Tree;
+class DiffCallback;
 class DiffContext;
 class GitIgnoreStack;
 class RootId;
 
+/**
+ * The default number of directory pairs, and of file pairs, whose objects
+ * diffCommits() requests from the ObjectStore at once.
+ */
+constexpr size_t kDefaultCommitDiffBatchSize = 1024;
+
+/**
+ * Compute the diff between two commits.
+ *
+ * Directories are compared breadth first, loading at most maxBatchSize pairs
+ * of trees at a time and requesting all of them together. Subtrees with
+ * identical hashes are skipped.
+ *
+ * The differences are reported to callback as they are found. Its methods
+ * are never invoked concurrently.
+ *
+ * The caller is responsible for ensuring that the ObjectStore and the
+ * callback remain valid until the returned Future completes.
+ */
+folly::Future<folly::Unit> diffCommits(
+    const ObjectStore* store,
+    const RootId& root1,
+    const RootId& root2,
+    DiffCallback* callback,
+    size_t maxBatchSize = kDefaultCommitDiffBatchSize);
+
 /**
  * Compute the diff between two commits.
  *
@@ -36,7 +63,8 @@ class RootId;
 folly::Future<std::unique_ptr<ScmStatus>> diffCommitsForStatus(
     const ObjectStore* store,
     const RootId& root1,
-    const RootId& root2);
+    const RootId& root2,
+    size_t maxBatchSize = kDefaultCommitDiffBatchSize);
 
 /**
  * Compute the diff between a source control Tree and the current directory
@@ -34,6 +34,17 @@ class DiffCallback {
   virtual void removedFile(RelativePathPiece path) = 0;
   virtual void modifiedFile(RelativePathPiece path) = 0;
 
+  /**
+   * Called instead of addedFile() for each file of an untracked directory,
+   * when the diff summarizes untracked directories. The directory is not
+   * walked, so nothing else is reported under it.
+   *
+   * Callbacks that don't tell directories apart receive it as an added file.
+   */
+  virtual void addedDirectory(RelativePathPiece path) {
+    addedFile(path);
+  }
+
   virtual void diffError(
       RelativePathPiece path,
       const folly::exception_wrapper& ew) = 0;
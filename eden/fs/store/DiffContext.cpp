@@ -7,11 +7,15 @@
 
 #include "eden/fs/store/DiffContext.h"
 
+#include <folly/ScopeGuard.h>
 #include <thrift/lib/cpp2/async/ResponseChannel.h>
 
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/git/GitIgnoreCache.h"
 #include "eden/fs/model/git/GitIgnoreStack.h"
 #include "eden/fs/model/git/TopLevelIgnores.h"
 #include "eden/fs/store/IObjectStore.h"
+#include "eden/fs/store/ObjectStore.h"
 
 using apache::thrift::ResponseChannelRequest;
 
@@ -24,23 +28,37 @@ DiffContext::DiffContext(
     const ObjectStore* os,
     std::unique_ptr<TopLevelIgnores> topLevelIgnores,
     LoadFileFunction loadFileContentsFromPath,
-    ResponseChannelRequest* request)
+    ResponseChannelRequest* request,
+    folly::Executor::KeepAlive<folly::Executor> executor,
+    size_t maxParallelDiffs,
+    GitIgnoreCache* gitIgnoreCache,
+    bool summarizeUntrackedDirectories,
+    size_t treePinBudget)
     : callback{cb},
       store{os},
       listIgnored{listIgnored},
+      summarizeUntrackedDirectories{summarizeUntrackedDirectories},
       caseSensitive{caseSensitive},
       topLevelIgnores_(std::move(topLevelIgnores)),
       loadFileContentsFromPath_{loadFileContentsFromPath},
-      request_{request} {}
+      request_{request},
+      executor_{std::move(executor)},
+      maxParallelDiffs_{executor_ ? maxParallelDiffs : 0},
+      gitIgnoreCache_{gitIgnoreCache},
+      treePins_{treePinBudget} {}
 
 DiffContext::DiffContext(DiffCallback* cb, const ObjectStore* os)
     : callback{cb},
       store{os},
       listIgnored{true},
+      summarizeUntrackedDirectories{false},
       caseSensitive{kPathMapDefaultCaseSensitive},
       topLevelIgnores_{std::unique_ptr<TopLevelIgnores>()},
       loadFileContentsFromPath_{nullptr},
-      request_{nullptr} {};
+      request_{nullptr},
+      maxParallelDiffs_{0},
+      gitIgnoreCache_{nullptr},
+      treePins_{0} {};
 
 DiffContext::~DiffContext() = default;
 
@@ -52,6 +70,54 @@ DiffContext::LoadFileFunction DiffContext::getLoadFileContentsFromPath() const {
   return loadFileContentsFromPath_;
 }
 
+std::shared_ptr<const GitIgnore> DiffContext::getCachedGitIgnore(
+    const ObjectId& blobId) {
+  return gitIgnoreCache_ ? gitIgnoreCache_->get(blobId) : nullptr;
+}
+
+ImmediateFuture<std::shared_ptr<const Tree>> DiffContext::getTree(
+    const ObjectId& treeId) {
+  return treePins_.getTree(treeId, *store, fetchContext_);
+}
+
+folly::Future<std::shared_ptr<const GitIgnore>> DiffContext::loadGitIgnore(
+    const ObjectId& blobId) {
+  if (auto ignore = getCachedGitIgnore(blobId)) {
+    return folly::makeFuture(std::move(ignore));
+  }
+  return store->getBlob(blobId, fetchContext_)
+      .thenValue([cache = gitIgnoreCache_,
+                  blobId](std::shared_ptr<const Blob> blob) {
+        auto contents = blob->getContents().cloneCoalescedAsValue();
+        auto text = folly::StringPiece{contents.coalesce()};
+        if (cache) {
+          return cache->insert(blobId, text);
+        }
+        auto ignore = std::make_shared<GitIgnore>();
+        ignore->loadFile(text);
+        return std::shared_ptr<const GitIgnore>{std::move(ignore)};
+      });
+}
+
+folly::Future<folly::Unit> DiffContext::runInParallel(
+    folly::Function<folly::Future<folly::Unit>()> fn) {
+  if (parallelDiffs_.fetch_add(1, std::memory_order_relaxed) >=
+      maxParallelDiffs_) {
+    parallelDiffs_.fetch_sub(1, std::memory_order_relaxed);
+    return fn();
+  }
+
+  return folly::via(executor_.get(), [this, fn = std::move(fn)]() mutable {
+    // The slot is released as soon as fn has handed off its asynchronous
+    // work, rather than when that work completes, so that the limit applies
+    // to the threads busy with this diff.
+    SCOPE_EXIT {
+      parallelDiffs_.fetch_sub(1, std::memory_order_relaxed);
+    };
+    return fn();
+  });
+}
+
 bool DiffContext::isCancelled() const {
   // If request_ is null we do not have an associated thrift
   // request that can be cancelled, so we are always still active
@@ -7,10 +7,16 @@
 
 #pragma once
 
+#include <folly/Executor.h>
+#include <folly/Function.h>
 #include <folly/Range.h>
 #include <folly/futures/Future.h>
+#include <atomic>
+#include <memory>
 
 #include "eden/fs/store/StatsFetchContext.h"
+#include "eden/fs/store/TreePinSet.h"
+#include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace folly {
@@ -27,9 +33,13 @@ class ResponseChannelRequest;
 namespace facebook::eden {
 
 class DiffCallback;
+class GitIgnore;
+class GitIgnoreCache;
 class GitIgnoreStack;
+class ObjectId;
 class ObjectFetchContext;
 class ObjectStore;
+class Tree;
 class UserInfo;
 class TopLevelIgnores;
 class EdenMount;
@@ -55,7 +65,12 @@ class DiffContext {
       const ObjectStore* os,
       std::unique_ptr<TopLevelIgnores> topLevelIgnores,
       LoadFileFunction loadFileContentsFromPath,
-      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request = nullptr);
+      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request = nullptr,
+      folly::Executor::KeepAlive<folly::Executor> executor = {},
+      size_t maxParallelDiffs = 0,
+      GitIgnoreCache* FOLLY_NULLABLE gitIgnoreCache = nullptr,
+      bool summarizeUntrackedDirectories = false,
+      size_t treePinBudget = 0);
 
   /**
    * Test only constructor.
@@ -78,6 +93,14 @@ class DiffContext {
    */
   bool const listIgnored;
 
+  /**
+   * If summarizeUntrackedDirectories is true, a directory that is neither
+   * in source control nor ignored is reported with addedDirectory() and not
+   * walked, similar to git's --untracked-files=normal. The directory is
+   * reported even when it only contains ignored files.
+   */
+  bool const summarizeUntrackedDirectories;
+
   /**
    * Controls the case sensitivity of the diff operation.
    */
@@ -90,6 +113,39 @@ class DiffContext {
     return fetchContext_;
   }
 
+  /**
+   * Run a part of the diff, typically the comparison of a subdirectory.
+   *
+   * When the context was created with an executor and fewer than
+   * maxParallelDiffs parts are queued or running on it, fn is run there so
+   * that independent directories are compared on several threads.
+   * Otherwise fn is run inline, which keeps the amount of work handed to the
+   * executor bounded while the calling thread keeps making progress.
+   */
+  folly::Future<folly::Unit> runInParallel(
+      folly::Function<folly::Future<folly::Unit>()> fn);
+
+  /**
+   * Returns the parsed .gitignore file stored in the blob blobId if it is in
+   * the GitIgnoreCache the context was created with, and nullptr otherwise.
+   */
+  std::shared_ptr<const GitIgnore> getCachedGitIgnore(const ObjectId& blobId);
+
+  /**
+   * Loads and parses the .gitignore file stored in the blob blobId, reusing
+   * the parsed file from the GitIgnoreCache the context was created with
+   * when possible.
+   */
+  folly::Future<std::shared_ptr<const GitIgnore>> loadGitIgnore(
+      const ObjectId& blobId);
+
+  /**
+   * Fetches the tree treeId from the store, keeping a reference to it until
+   * the diff completes, within the tree pin budget the context was created
+   * with, so that the diff doesn't fetch it again.
+   */
+  ImmediateFuture<std::shared_ptr<const Tree>> getTree(const ObjectId& treeId);
+
   /** Whether this repository is mounted in case-sensitive mode */
   CaseSensitivity getCaseSensitive() const {
     return caseSensitive_;
@@ -101,6 +157,11 @@ class DiffContext {
   apache::thrift::ResponseChannelRequest* const FOLLY_NULLABLE request_;
   StatsFetchContext fetchContext_;
   CaseSensitivity caseSensitive_;
+  folly::Executor::KeepAlive<folly::Executor> executor_;
+  const size_t maxParallelDiffs_;
+  std::atomic<size_t> parallelDiffs_{0};
+  GitIgnoreCache* const FOLLY_NULLABLE gitIgnoreCache_;
+  TreePinSet treePins_;
 };
 
 } // namespace facebook::eden
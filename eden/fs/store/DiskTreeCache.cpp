@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/DiskTreeCache.h"
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/model/PackedTree.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+/*
+ * File layout, all integers big-endian:
+ *
+ *   header:  uint32 magic, uint32 version, uint64 tree count
+ *   record:  uint32 record length (excluding this field)
+ *            uint8 id length, id bytes
+ *            PackedTree bytes
+ *
+ * PackedTree bytes are in host byte order. The snapshot is only ever read
+ * back on the machine that wrote it.
+ */
+constexpr uint32_t kMagic = 0x45545243; // "ETRC"
+constexpr uint32_t kVersion = 2;
+constexpr size_t kHeaderSize = 2 * sizeof(uint32_t) + sizeof(uint64_t);
+
+void appendTree(folly::io::QueueAppender& appender, const PackedTree& tree) {
+  auto hashBytes = tree.getHash().getBytes();
+  auto treeBytes = tree.getBytes();
+  appender.writeBE<uint32_t>(
+      sizeof(uint8_t) + hashBytes.size() + treeBytes.size());
+  appender.writeBE<uint8_t>(hashBytes.size());
+  appender.push(hashBytes);
+  appender.push(treeBytes);
+}
+
+std::optional<PackedTree> tryPack(const Tree& tree) {
+  if (tree.getHash().size() > std::numeric_limits<uint8_t>::max()) {
+    return std::nullopt;
+  }
+  try {
+    return PackedTree{tree};
+  } catch (const std::invalid_argument& ex) {
+    XLOG(DBG2) << "not saving tree " << tree.getHash()
+               << " to tree cache snapshot: " << ex.what();
+    return std::nullopt;
+  }
+}
+} // namespace
+
+std::unique_ptr<DiskTreeCache> DiskTreeCache::open(AbsolutePathPiece path) {
+  folly::File file;
+  try {
+    file = folly::File{path.stringPiece()};
+  } catch (const std::system_error& ex) {
+    XLOG(DBG2) << "no tree cache snapshot at " << path << ": " << ex.what();
+    return nullptr;
+  }
+
+  std::unique_ptr<DiskTreeCache> cache;
+  try {
+    cache.reset(new DiskTreeCache{folly::MemoryMapping{std::move(file)}});
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "unable to map tree cache snapshot " << path << ": "
+               << ex.what();
+    return nullptr;
+  }
+
+  if (!cache->buildIndex()) {
+    XLOG(WARN) << "ignoring tree cache snapshot " << path
+               << " with unknown format";
+    return nullptr;
+  }
+  return cache;
+}
+
+DiskTreeCache::DiskTreeCache(folly::MemoryMapping mapping)
+    : mapping_{std::move(mapping)} {}
+
+bool DiskTreeCache::buildIndex() {
+  auto data = mapping_.range();
+  if (data.size() < kHeaderSize) {
+    return false;
+  }
+
+  auto buf = folly::IOBuf::wrapBufferAsValue(data);
+  folly::io::Cursor cursor{&buf};
+  if (cursor.readBE<uint32_t>() != kMagic ||
+      cursor.readBE<uint32_t>() != kVersion) {
+    return false;
+  }
+  auto treeCount = cursor.readBE<uint64_t>();
+  index_.reserve(treeCount);
+
+  try {
+    for (uint64_t i = 0; i < treeCount; ++i) {
+      auto recordLength = cursor.readBE<uint32_t>();
+      auto record = data.subpiece(data.size() - cursor.totalLength());
+      if (record.size() < recordLength) {
+        throw std::out_of_range("truncated record");
+      }
+      record.reset(record.data(), recordLength);
+      cursor.skip(recordLength);
+
+      if (record.empty()) {
+        throw std::out_of_range("empty record");
+      }
+      auto idLength = record.front();
+      if (record.size() < 1u + idLength) {
+        throw std::out_of_range("truncated tree id");
+      }
+      ObjectId hash{record.subpiece(1, idLength)};
+      index_.emplace(std::move(hash), record.subpiece(1 + idLength));
+    }
+  } catch (const std::out_of_range& ex) {
+    XLOG(WARN) << "tree cache snapshot is damaged after " << index_.size()
+               << " trees: " << ex.what();
+  }
+  return true;
+}
+
+std::optional<PackedTree> DiskTreeCache::getPacked(
+    const ObjectId& hash) const {
+  auto it = index_.find(hash);
+  if (it == index_.end()) {
+    return std::nullopt;
+  }
+
+  try {
+    return PackedTree::fromBytes(hash, it->second);
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "unable to decode tree " << hash
+               << " from tree cache snapshot: " << ex.what();
+    return std::nullopt;
+  }
+}
+
+std::unique_ptr<Tree> DiskTreeCache::get(const ObjectId& hash) const {
+  auto packed = getPacked(hash);
+  if (!packed) {
+    return nullptr;
+  }
+  return packed->toTree();
+}
+
+void DiskTreeCache::write(
+    AbsolutePathPiece path,
+    const std::vector<std::shared_ptr<const Tree>>& trees) {
+  std::vector<PackedTree> packedTrees;
+  packedTrees.reserve(trees.size());
+  for (const auto& tree : trees) {
+    if (tree) {
+      if (auto packed = tryPack(*tree)) {
+        packedTrees.push_back(std::move(*packed));
+      }
+    }
+  }
+
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender appender{&queue, 64 * 1024};
+  appender.writeBE<uint32_t>(kMagic);
+  appender.writeBE<uint32_t>(kVersion);
+  appender.writeBE<uint64_t>(packedTrees.size());
+  for (const auto& packed : packedTrees) {
+    appendTree(appender, packed);
+  }
+
+  auto buf = queue.move();
+  writeFileAtomic(path, buf->coalesce()).value();
+}
+
+} // namespace facebook::eden
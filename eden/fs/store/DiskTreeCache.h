@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <folly/container/F14Map.h>
+#include <folly/system/MemoryMapping.h>
+
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/PackedTree.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class Tree;
+
+/**
+ * A read-only, memory-mapped snapshot of trees that survives daemon restarts
+ * and graceful takeovers. It acts as a second tier behind the in-memory
+ * TreeCache: on a TreeCache miss, trees are decoded straight from the mapped
+ * file instead of being read and re-parsed from the LocalStore.
+ *
+ * The file is written in one go (usually at shutdown, from the contents of
+ * the in-memory TreeCache) with write(), and atomically replaces any previous
+ * snapshot. Trees are stored in PackedTree form, so loading one is a single
+ * copy plus bounds checks rather than a parse.
+ *
+ * Once opened, a DiskTreeCache is immutable and safe to use from arbitrary
+ * threads.
+ */
+class DiskTreeCache {
+ public:
+  /**
+   * Map the snapshot at the given path.
+   *
+   * Returns nullptr if the file does not exist or has an unknown format. A
+   * truncated or otherwise damaged file is loaded up to the first bad record.
+   */
+  static std::unique_ptr<DiskTreeCache> open(AbsolutePathPiece path);
+
+  /**
+   * Atomically replace the snapshot at the given path with the given trees.
+   */
+  static void write(
+      AbsolutePathPiece path,
+      const std::vector<std::shared_ptr<const Tree>>& trees);
+
+  /**
+   * Return the tree with the given hash, or nullptr if the snapshot does not
+   * contain it.
+   */
+  std::unique_ptr<Tree> get(const ObjectId& hash) const;
+
+  /**
+   * Like get(), but returns the tree in its packed form.
+   */
+  std::optional<PackedTree> getPacked(const ObjectId& hash) const;
+
+  bool contains(const ObjectId& hash) const {
+    return index_.count(hash) != 0;
+  }
+
+  /**
+   * Number of trees in the snapshot.
+   */
+  size_t size() const {
+    return index_.size();
+  }
+
+ private:
+  explicit DiskTreeCache(folly::MemoryMapping mapping);
+
+  /**
+   * Parse the header and build the index. Returns false if the header is
+   * not recognized.
+   */
+  bool buildIndex();
+
+  folly::MemoryMapping mapping_;
+
+  /// Maps a tree hash to its serialized entries within mapping_.
+  folly::F14FastMap<ObjectId, folly::ByteRange> index_;
+};
+
+} // namespace facebook::eden
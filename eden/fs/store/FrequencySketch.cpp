@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FrequencySketch.h"
+
+#include <algorithm>
+
+#include <folly/Bits.h>
+#include <folly/hash/Hash.h>
+
+namespace facebook::eden {
+
+namespace {
+constexpr uint64_t kSeeds[] = {
+    0xc3a5c85c97cb3127ULL,
+    0xb492b66fbe98f273ULL,
+    0x9ae16a3b2f90404fULL,
+    0xcbf29ce484222325ULL,
+};
+} // namespace
+
+FrequencySketch::FrequencySketch(size_t width)
+    : mask_{folly::nextPowTwo(std::max<size_t>(width, 1)) - 1},
+      sampleSize_{10 * (mask_ + 1)},
+      counters_(kDepth * (mask_ + 1), 0) {}
+
+size_t FrequencySketch::indexOf(size_t hashCode, size_t row) const {
+  auto hash = folly::hash::twang_mix64(hashCode ^ kSeeds[row]);
+  return row * (mask_ + 1) + (hash & mask_);
+}
+
+void FrequencySketch::increment(size_t hashCode) {
+  bool incremented = false;
+  for (size_t row = 0; row < kDepth; ++row) {
+    auto& counter = counters_[indexOf(hashCode, row)];
+    if (counter < kMaxCount) {
+      ++counter;
+      incremented = true;
+    }
+  }
+
+  if (incremented && ++additions_ >= sampleSize_) {
+    halve();
+  }
+}
+
+uint8_t FrequencySketch::estimate(size_t hashCode) const {
+  uint8_t result = kMaxCount;
+  for (size_t row = 0; row < kDepth; ++row) {
+    result = std::min(result, counters_[indexOf(hashCode, row)]);
+  }
+  return result;
+}
+
+void FrequencySketch::halve() {
+  for (auto& counter : counters_) {
+    counter >>= 1;
+  }
+  additions_ /= 2;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * A count-min sketch of small saturating counters used to estimate how often
+ * an object has recently been accessed. Used by ObjectCache's TinyLFU
+ * admission filter.
+ *
+ * To keep the estimate biased towards recent history, all counters are halved
+ * once the number of recorded accesses reaches a multiple of the sketch width.
+ *
+ * This class is not thread safe; callers must provide their own locking.
+ */
+class FrequencySketch {
+ public:
+  /**
+   * Width is rounded up to a power of two. It should be on the order of the
+   * number of entries the owning cache is expected to hold.
+   */
+  explicit FrequencySketch(size_t width);
+
+  /**
+   * Record one access to the object with the given hash code.
+   */
+  void increment(size_t hashCode);
+
+  /**
+   * Return the estimated number of recent accesses for the given hash code.
+   * The estimate never undercounts, but saturates at kMaxCount.
+   */
+  uint8_t estimate(size_t hashCode) const;
+
+  static constexpr uint8_t kMaxCount = 15;
+
+ private:
+  size_t indexOf(size_t hashCode, size_t row) const;
+  void halve();
+
+  static constexpr size_t kDepth = 4;
+
+  size_t mask_;
+  size_t sampleSize_;
+  size_t additions_{0};
+  std::vector<uint8_t> counters_;
+};
+
+} // namespace facebook::eden
@@ -102,6 +102,12 @@ class KeySpace {
       8,
       "recasdigestproxyhash",
       Persistent{}};
+  // Blob contents keyed by their SHA-1, when blob deduplication is enabled.
+  // BlobMetaDataFamily maps the blob IDs to it.
+  static constexpr KeySpaceRecord BlobContentFamily{
+      9,
+      "blobcontent",
+      Ephemeral{&EdenConfig::localStoreBlobSizeLimit}};
 
   static constexpr const KeySpaceRecord* kAll[] = {
       &BlobFamily,
@@ -112,7 +118,8 @@ class KeySpace {
       &BlobSizeFamily,
       &ScsProxyHashFamily,
       &TreeMetaDataFamily,
-      &ReCasDigestProxyHashFamily};
+      &ReCasDigestProxyHashFamily,
+      &BlobContentFamily};
   static constexpr size_t kTotalCount = std::size(kAll);
 
  private:
@@ -14,8 +14,10 @@
 #include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
 #include <array>
+#include <cstring>
 
 #include "eden/fs/model/Blob.h"
+#include "eden/fs/model/PackedTree.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/git/GitBlob.h"
 #include "eden/fs/model/git/GitTree.h"
@@ -103,7 +105,7 @@ folly::Future<std::unique_ptr<Tree>> LocalStore::getTree(
         if (!data.isValid()) {
           return std::unique_ptr<Tree>(nullptr);
         }
-        return deserializeGitTree(id, data.bytes());
+        return deserializeTree(id, data.bytes());
       });
 }
 
@@ -112,17 +114,43 @@ folly::Future<std::unique_ptr<Blob>> LocalStore::getBlob(
   if (!enableBlobCaching) {
     return std::unique_ptr<Blob>(nullptr);
   }
+  if (!enableBlobDeduplication.load(std::memory_order_relaxed)) {
+    return getBlobContents(KeySpace::BlobFamily, id.getBytes(), id);
+  }
 
-  return getFuture(KeySpace::BlobFamily, id.getBytes())
-      .thenValue([id](StoreResult&& data) {
-        if (!data.isValid()) {
-          return std::unique_ptr<Blob>(nullptr);
+  return getBlobMetadata(id).thenValue(
+      [self = shared_from_this(), id](std::optional<BlobMetadata>&& metadata) {
+        if (!metadata) {
+          return self->getBlobContents(KeySpace::BlobFamily, id.getBytes(), id);
         }
-        auto buf = data.extractIOBuf();
-        return deserializeGitBlob(id, &buf);
+        return self
+            ->getBlobContents(
+                KeySpace::BlobContentFamily, metadata->sha1.getBytes(), id)
+            .thenValue([self, id](std::unique_ptr<Blob> blob) {
+              if (blob) {
+                return folly::makeFuture(std::move(blob));
+              }
+              // The blob may have been stored before deduplication was
+              // enabled.
+              return self->getBlobContents(
+                  KeySpace::BlobFamily, id.getBytes(), id);
+            });
       });
 }
 
+folly::Future<std::unique_ptr<Blob>> LocalStore::getBlobContents(
+    KeySpace keySpace,
+    folly::ByteRange key,
+    const ObjectId& id) const {
+  return getFuture(keySpace, key).thenValue([id](StoreResult&& data) {
+    if (!data.isValid()) {
+      return std::unique_ptr<Blob>(nullptr);
+    }
+    auto buf = data.extractIOBuf();
+    return deserializeGitBlob(id, &buf);
+  });
+}
+
 folly::Future<optional<BlobMetadata>> LocalStore::getBlobMetadata(
     const ObjectId& id) const {
   return getFuture(KeySpace::BlobMetaDataFamily, id.getBytes())
@@ -135,7 +163,47 @@ folly::Future<optional<BlobMetadata>> LocalStore::getBlobMetadata(
       });
 }
 
-folly::IOBuf LocalStore::serializeTree(const Tree& tree) {
+namespace {
+/**
+ * Packed trees are stored after this prefix, which can't be mistaken for the
+ * "tree " header of git trees.
+ */
+constexpr folly::StringPiece kPackedTreePrefix{"ptree1 "};
+} // namespace
+
+std::unique_ptr<Tree> LocalStore::deserializeTree(
+    const ObjectId& id,
+    folly::ByteRange data) {
+  if (folly::StringPiece{data}.startsWith(kPackedTreePrefix)) {
+    data.advance(kPackedTreePrefix.size());
+    return PackedTree::fromBytes(id, data).toTree();
+  }
+  return deserializeGitTree(id, data);
+}
+
+std::optional<folly::IOBuf> LocalStore::serializeTree(
+    const Tree& tree,
+    bool packed) {
+  if (packed) {
+    try {
+      PackedTree packedTree{tree};
+      auto bytes = packedTree.getBytes();
+      folly::IOBuf buf{
+          folly::IOBuf::CREATE, kPackedTreePrefix.size() + bytes.size()};
+      auto* data = buf.writableTail();
+      memcpy(data, kPackedTreePrefix.data(), kPackedTreePrefix.size());
+      memcpy(data + kPackedTreePrefix.size(), bytes.data(), bytes.size());
+      buf.append(kPackedTreePrefix.size() + bytes.size());
+      return buf;
+    } catch (const std::invalid_argument& ex) {
+      XLOG(DBG2) << "storing " << tree.getHash() << " as a git tree: "
+                 << ex.what();
+    }
+  }
+
+  if (!tree.isGitTreeCompatible()) {
+    return std::nullopt;
+  }
   GitTreeSerializer serializer;
   for (auto& entry : tree.getTreeEntries()) {
     serializer.addEntry(std::move(entry));
@@ -148,51 +216,77 @@ bool LocalStore::hasKey(KeySpace keySpace, const ObjectId& id) const {
 }
 
 void LocalStore::putTree(const Tree& tree) {
-  if (!tree.isGitTreeCompatible()) {
+  auto serialized = LocalStore::serializeTree(
+      tree, enablePackedTrees.load(std::memory_order_relaxed));
+  if (!serialized) {
     return;
   }
-  auto serialized = LocalStore::serializeTree(tree);
-  ByteRange treeData = serialized.coalesce();
+  ByteRange treeData = serialized->coalesce();
 
   put(KeySpace::TreeFamily, tree.getHash().getBytes(), treeData);
 }
 
 void LocalStore::WriteBatch::putTree(const Tree& tree) {
-  if (!tree.isGitTreeCompatible()) {
+  // A WriteBatch doesn't know the configuration of its store, so it always
+  // writes git trees, which every version of EdenFS can read.
+  auto serialized = LocalStore::serializeTree(tree, /*packed=*/false);
+  if (!serialized) {
     return;
   }
-  auto serialized = LocalStore::serializeTree(tree);
-  ByteRange treeData = serialized.coalesce();
+  ByteRange treeData = serialized->coalesce();
 
   put(KeySpace::TreeFamily, tree.getHash().getBytes(), treeData);
 }
 
-void LocalStore::putBlob(const ObjectId& id, const Blob* blob) {
+bool LocalStore::putBlob(
+    const ObjectId& id,
+    const Blob* blob,
+    const BlobMetadata* metadata) {
   if (!enableBlobCaching) {
     XLOG(DBG8) << "Skipping caching " << id
                << " because blob cache is disabled via config";
-  } else {
-    // Since blob serialization is moderately complex, just delegate
-    // the immediate putBlob to the method on the WriteBatch.
-    // Pre-allocate a buffer of approximately the right size; it
-    // needs to hold the blob content plus have room for a couple of
-    // hashes for the keys, plus some padding.
-    auto batch = beginWrite(blob->getSize() + 64);
+    return false;
+  }
+
+  // Since blob serialization is moderately complex, just delegate
+  // the immediate putBlob to the method on the WriteBatch.
+  // Pre-allocate a buffer of approximately the right size; it
+  // needs to hold the blob content plus have room for a couple of
+  // hashes for the keys, plus some padding.
+  auto batch = beginWrite(blob->getSize() + 64);
+  bool deduplicated = false;
+  if (!enableBlobDeduplication.load(std::memory_order_relaxed)) {
     batch->putBlob(id, blob);
-    batch->flush();
+  } else {
+    // Copied files, reverted changes and vendored libraries all have the
+    // same contents under different IDs.
+    auto sha1 = metadata ? metadata->sha1 : Hash20::sha1(blob->getContents());
+    SerializedBlobMetadata metadataBytes(sha1, blob->getSize());
+    batch->put(
+        KeySpace::BlobMetaDataFamily, id.getBytes(), metadataBytes.slice());
+    deduplicated = hasKey(KeySpace::BlobContentFamily, sha1.getBytes());
+    if (!deduplicated) {
+      batch->putBlobContents(
+          KeySpace::BlobContentFamily, sha1.getBytes(), blob);
+    }
   }
+  batch->flush();
+  return deduplicated;
 }
 
 BlobMetadata LocalStore::putBlobMetadata(const ObjectId& id, const Blob* blob) {
   BlobMetadata metadata{Hash20::sha1(blob->getContents()), blob->getSize()};
-  auto hashBytes = id.getBytes();
-  SerializedBlobMetadata metadataBytes(metadata);
-
-  put(KeySpace::BlobMetaDataFamily, hashBytes, metadataBytes.slice());
-
+  putBlobMetadata(id, metadata);
   return metadata;
 }
 
+void LocalStore::putBlobMetadata(
+    const ObjectId& id,
+    const BlobMetadata& metadata) {
+  SerializedBlobMetadata metadataBytes(metadata);
+  put(KeySpace::BlobMetaDataFamily, id.getBytes(), metadataBytes.slice());
+}
+
 void LocalStore::putTreeMetadata(
     const TreeMetadata& rawTreeMetadata,
     const Tree& tree) {
@@ -262,8 +356,14 @@ void LocalStore::WriteBatch::put(
 }
 
 void LocalStore::WriteBatch::putBlob(const ObjectId& id, const Blob* blob) {
+  putBlobContents(KeySpace::BlobFamily, id.getBytes(), blob);
+}
+
+void LocalStore::WriteBatch::putBlobContents(
+    KeySpace keySpace,
+    folly::ByteRange key,
+    const Blob* blob) {
   const IOBuf& contents = blob->getContents();
-  auto hashSlice = id.getBytes();
 
   // Add a git-style blob prefix
   auto prefix = folly::to<string>("blob ", blob->getSize());
@@ -282,7 +382,7 @@ void LocalStore::WriteBatch::putBlob(const ObjectId& id, const Blob* blob) {
     cursor.skip(bytes.size());
   }
 
-  put(KeySpace::BlobFamily, hashSlice, bodySlices);
+  put(keySpace, key, bodySlices);
 }
 
 LocalStore::WriteBatch::~WriteBatch() {}
@@ -148,13 +148,21 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
 
   /**
    * Store a Blob.
+   *
+   * With enableBlobDeduplication, the contents are stored under their SHA-1,
+   * taken from metadata if given, and only if no other blob with the same
+   * contents is already stored. Returns whether that was the case.
    */
-  void putBlob(const ObjectId& id, const Blob* blob);
+  bool putBlob(
+      const ObjectId& id,
+      const Blob* blob,
+      const BlobMetadata* metadata = nullptr);
 
   /**
    * Store a blob metadata.
    */
   BlobMetadata putBlobMetadata(const ObjectId& id, const Blob* blob);
+  void putBlobMetadata(const ObjectId& id, const BlobMetadata& metadata);
 
   /**
    * Store metadata for each of the entries in the Tree. This stores the
@@ -198,6 +206,12 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
      */
     void putBlob(const ObjectId& id, const Blob* blob);
 
+    /**
+     * Store the contents of a Blob under the given key.
+     */
+    void
+    putBlobContents(KeySpace keySpace, folly::ByteRange key, const Blob* blob);
+
     /**
      * Put arbitrary data in the store.
      */
@@ -253,15 +267,49 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    */
   std::atomic<bool> enableBlobCaching = true;
 
+  /**
+   * Whether blob contents are stored once per distinct contents, see
+   * putBlob(). Updated the same way as enableBlobCaching.
+   */
+  std::atomic<bool> enableBlobDeduplication = false;
+
+  /**
+   * Whether putTree() stores trees as PackedTree rather than as git tree
+   * objects. Updated the same way as enableBlobCaching.
+   *
+   * Deserializing a git tree parses every entry, which stalls the first
+   * lookup in directories with hundreds of thousands of entries. A PackedTree
+   * is a table of fixed-size records, so it is decoded without any parsing,
+   * and it keeps the sizes and SHA-1s of the entries.
+   */
+  std::atomic<bool> enablePackedTrees = false;
+
+  /**
+   * Deserialize a tree read from the TreeFamily KeySpace, in either of the
+   * formats written by putTree().
+   */
+  static std::unique_ptr<Tree> deserializeTree(
+      const ObjectId& id,
+      folly::ByteRange data);
+
  private:
+  folly::Future<std::unique_ptr<Blob>>
+  getBlobContents(KeySpace keySpace, folly::ByteRange key, const ObjectId& id)
+      const;
+
   /**
    * Compute the serialized version of the tree in a (not coalesced) IOBuf.
    * This does not modify the contents of the store; it is the method
    * used by the putTree method to compute the data that it stores.
    * This is useful when computing the overall set of data during a
    * two phase import.
+   *
+   * Returns std::nullopt if the tree can not be stored in the requested
+   * format, nor as a git tree.
    */
-  static folly::IOBuf serializeTree(const Tree& tree);
+  static std::optional<folly::IOBuf> serializeTree(
+      const Tree& tree,
+      bool packed);
 
   /**
    * Store metadata for each of the entries in the Tree. This stores the
@@ -52,7 +52,12 @@ LocalStoreCachedBackingStore::getTree(
       [id = id,
        &context,
        localStore = localStore_,
-       backingStore = backingStore_](std::unique_ptr<Tree> tree) mutable {
+       backingStore = backingStore_,
+       start = std::chrono::steady_clock::now()](
+          std::unique_ptr<Tree> tree) mutable {
+        context.didFinishStage(
+            ObjectFetchContext::LocalStore,
+            std::chrono::steady_clock::now() - start);
         if (tree) {
           return folly::makeSemiFuture(BackingStore::GetTreeRes{
               std::move(tree), ObjectFetchContext::FromDiskCache});
@@ -79,7 +84,12 @@ LocalStoreCachedBackingStore::getBlob(
        &context,
        localStore = localStore_,
        backingStore = backingStore_,
-       stats = stats_](std::unique_ptr<Blob> blob) mutable {
+       stats = stats_,
+       start = std::chrono::steady_clock::now()](
+          std::unique_ptr<Blob> blob) mutable {
+        context.didFinishStage(
+            ObjectFetchContext::LocalStore,
+            std::chrono::steady_clock::now() - start);
         if (blob) {
           stats->getObjectStoreStatsForCurrentThread()
               .getBlobFromLocalStore.addValue(1);
@@ -92,9 +102,13 @@ LocalStoreCachedBackingStore::getBlob(
                          stats = std::move(stats),
                          id](BackingStore::GetBlobRes result) {
               if (result.blob) {
-                localStore->putBlob(id, result.blob.get());
-                stats->getObjectStoreStatsForCurrentThread()
-                    .getBlobFromBackingStore.addValue(1);
+                auto& objectStoreStats =
+                    stats->getObjectStoreStatsForCurrentThread();
+                if (localStore->putBlob(id, result.blob.get())) {
+                  objectStoreStats.blobDeduplicatedOnDisk.addValue(
+                      result.blob->getSize());
+                }
+                objectStoreStats.getBlobFromBackingStore.addValue(1);
               }
               return result;
             });
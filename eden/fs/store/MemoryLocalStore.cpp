@@ -73,6 +73,26 @@ StoreResult MemoryLocalStore::get(KeySpace keySpace, folly::ByteRange key)
   return StoreResult(std::string(it->second));
 }
 
+folly::Future<std::vector<StoreResult>> MemoryLocalStore::getBatch(
+    KeySpace keySpace,
+    const std::vector<folly::ByteRange>& keys) const {
+  std::vector<StoreResult> results;
+  results.reserve(keys.size());
+  {
+    auto store = storage_.rlock();
+    const auto& keySpaceStore = (*store)[keySpace->index];
+    for (auto& key : keys) {
+      auto it = keySpaceStore.find(StringPiece(key));
+      if (it == keySpaceStore.end()) {
+        results.push_back(StoreResult::missing(keySpace, key));
+      } else {
+        results.emplace_back(std::string(it->second));
+      }
+    }
+  }
+  return results;
+}
+
 bool MemoryLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
   auto store = storage_.rlock();
   auto it = (*store)[keySpace->index].find(StringPiece(key));
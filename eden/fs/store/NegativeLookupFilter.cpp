@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/NegativeLookupFilter.h"
+
+#include <folly/hash/Hash.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+// 10 bits per key with 7 probes gives a false positive rate of about 1% once
+// a filter holds as many keys as it was sized for, and well under 0.1% while
+// it is half full, as it is right after a rebuild.
+constexpr size_t kBitsPerKey = 10;
+constexpr size_t kProbes = 7;
+constexpr size_t kBlockBits = 512;
+constexpr size_t kWordsPerBlock = kBlockBits / 64;
+constexpr size_t kProbeBits = 9;
+static_assert(size_t{1} << kProbeBits == kBlockBits);
+static_assert(kProbes * kProbeBits <= 64);
+
+// Small enough to not matter for empty key spaces, large enough for a fresh
+// checkout to not fill the filter before its next rebuild.
+constexpr size_t kMinCapacity = 64 * 1024;
+} // namespace
+
+class NegativeLookupFilter::Filter {
+ public:
+  explicit Filter(size_t capacity)
+      : capacity_{capacity},
+        blockCount_{std::max<size_t>(
+            1, (capacity * kBitsPerKey + kBlockBits - 1) / kBlockBits)},
+        words_{std::make_unique<std::atomic<uint64_t>[]>(
+            blockCount_ * kWordsPerBlock)},
+        builtAt_{std::chrono::steady_clock::now()} {}
+
+  void add(uint64_t hash, bool count) {
+    auto* block = getBlock(hash);
+    auto probes = folly::hash::twang_mix64(hash);
+    for (size_t i = 0; i < kProbes; ++i) {
+      auto bit = (probes >> (i * kProbeBits)) & (kBlockBits - 1);
+      block[bit / 64].fetch_or(
+          uint64_t{1} << (bit % 64), std::memory_order_relaxed);
+    }
+    if (count) {
+      keys_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  bool mayContain(uint64_t hash) const {
+    const auto* block = getBlock(hash);
+    auto probes = folly::hash::twang_mix64(hash);
+    for (size_t i = 0; i < kProbes; ++i) {
+      auto bit = (probes >> (i * kProbeBits)) & (kBlockBits - 1);
+      if (!(block[bit / 64].load(std::memory_order_relaxed) &
+            (uint64_t{1} << (bit % 64)))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  size_t getKeys() const {
+    return keys_.load(std::memory_order_relaxed);
+  }
+
+  size_t getCapacity() const {
+    return capacity_;
+  }
+
+  std::chrono::steady_clock::time_point getBuiltAt() const {
+    return builtAt_;
+  }
+
+ private:
+  std::atomic<uint64_t>* getBlock(uint64_t hash) const {
+    return &words_[(hash % blockCount_) * kWordsPerBlock];
+  }
+
+  const size_t capacity_;
+  const size_t blockCount_;
+  // Set concurrently by add() while lookups read them, hence atomic. A key
+  // is only visible to lookups once all its bits are set, which add()
+  // completes before the key is written to the store.
+  std::unique_ptr<std::atomic<uint64_t>[]> words_;
+  std::atomic<size_t> keys_{0};
+  const std::chrono::steady_clock::time_point builtAt_;
+};
+
+NegativeLookupFilter::NegativeLookupFilter() = default;
+
+NegativeLookupFilter::~NegativeLookupFilter() = default;
+
+uint64_t NegativeLookupFilter::hashKey(folly::ByteRange key) {
+  return folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+}
+
+NegativeLookupFilter::Lookup NegativeLookupFilter::lookup(
+    KeySpace keySpace,
+    folly::ByteRange key) const {
+  if (!covers(keySpace)) {
+    return Lookup::Unfiltered;
+  }
+  auto hash = hashKey(key);
+  auto& state = keySpaces_[keySpace->index];
+  auto filter = state.filter.rlock();
+  if (!*filter) {
+    return Lookup::Unfiltered;
+  }
+  if ((*filter)->mayContain(hash)) {
+    state.maybePresent.fetch_add(1, std::memory_order_relaxed);
+    return Lookup::MaybePresent;
+  }
+  state.absent.fetch_add(1, std::memory_order_relaxed);
+  return Lookup::Absent;
+}
+
+void NegativeLookupFilter::recordFalsePositive(KeySpace keySpace) const {
+  keySpaces_[keySpace->index].falsePositives.fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+void NegativeLookupFilter::add(KeySpace keySpace, folly::ByteRange key) {
+  if (covers(keySpace)) {
+    addImpl(keySpace, hashKey(key), /*written=*/false);
+  }
+}
+
+void NegativeLookupFilter::add(KeySpace keySpace, uint64_t keyHash) {
+  if (covers(keySpace)) {
+    addImpl(keySpace, keyHash, /*written=*/false);
+  }
+}
+
+void NegativeLookupFilter::addWritten(KeySpace keySpace, folly::ByteRange key) {
+  if (covers(keySpace)) {
+    addImpl(keySpace, hashKey(key), /*written=*/true);
+  }
+}
+
+void NegativeLookupFilter::addWritten(KeySpace keySpace, uint64_t keyHash) {
+  if (covers(keySpace)) {
+    addImpl(keySpace, keyHash, /*written=*/true);
+  }
+}
+
+void NegativeLookupFilter::addImpl(
+    KeySpace keySpace,
+    uint64_t keyHash,
+    bool written) {
+  auto& state = keySpaces_[keySpace->index];
+  auto filter = state.filter.rlock();
+  if (*filter) {
+    // The bits are set again once the write is committed, in case the
+    // filter was rebuilt while the write was queued.
+    (*filter)->add(keyHash, /*count=*/!written);
+  }
+  // rebuilding only changes under the exclusive filter lock.
+  if (state.rebuilding.load(std::memory_order_relaxed)) {
+    auto added = state.added.lock();
+    if (*added) {
+      (*added)->push_back(keyHash);
+    }
+  }
+}
+
+void NegativeLookupFilter::rebuild(KeySpace keySpace, KeyScanner scan) {
+  if (!covers(keySpace)) {
+    return;
+  }
+  auto& state = keySpaces_[keySpace->index];
+  std::lock_guard<std::mutex> rebuildLock{state.rebuildMutex};
+  {
+    // From now on every addWritten() records its key, so that the writes
+    // committed after the scan started are in the rebuilt filter.
+    auto filter = state.filter.wlock();
+    state.added.lock()->emplace();
+    state.rebuilding.store(true, std::memory_order_relaxed);
+  }
+
+  std::vector<uint64_t> hashes;
+  try {
+    scan([&](folly::ByteRange key) { hashes.push_back(hashKey(key)); });
+  } catch (...) {
+    auto filter = state.filter.wlock();
+    state.added.lock()->reset();
+    state.rebuilding.store(false, std::memory_order_relaxed);
+    throw;
+  }
+
+  auto rebuilt =
+      std::make_unique<Filter>(std::max(kMinCapacity, 2 * hashes.size()));
+  for (auto hash : hashes) {
+    rebuilt->add(hash, /*count=*/true);
+  }
+
+  // The keys added during the scan are merged while holding the exclusive
+  // lock, so that no add() goes to the old filter after the merge.
+  auto filter = state.filter.wlock();
+  {
+    auto added = state.added.lock();
+    for (auto hash : **added) {
+      rebuilt->add(hash, /*count=*/true);
+    }
+    added->reset();
+  }
+  state.rebuilding.store(false, std::memory_order_relaxed);
+  *filter = std::move(rebuilt);
+}
+
+bool NegativeLookupFilter::needsRebuild(
+    KeySpace keySpace,
+    std::chrono::nanoseconds maxAge) const {
+  if (!covers(keySpace)) {
+    return false;
+  }
+  auto filter = keySpaces_[keySpace->index].filter.rlock();
+  return !*filter || (*filter)->getKeys() > (*filter)->getCapacity() ||
+      std::chrono::steady_clock::now() - (*filter)->getBuiltAt() > maxAge;
+}
+
+void NegativeLookupFilter::clear(KeySpace keySpace) {
+  keySpaces_[keySpace->index].filter.wlock()->reset();
+}
+
+NegativeLookupFilter::Stats NegativeLookupFilter::getStats(
+    KeySpace keySpace) const {
+  auto& state = keySpaces_[keySpace->index];
+  Stats stats;
+  stats.absent = state.absent.load(std::memory_order_relaxed);
+  stats.maybePresent = state.maybePresent.load(std::memory_order_relaxed);
+  stats.falsePositives = state.falsePositives.load(std::memory_order_relaxed);
+  auto filter = state.filter.rlock();
+  if (*filter) {
+    stats.keys = (*filter)->getKeys();
+    stats.capacity = (*filter)->getCapacity();
+  }
+  return stats;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/Range.h>
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "eden/fs/store/KeySpace.h"
+
+namespace facebook::eden {
+
+/**
+ * An in-memory filter of the keys stored in each ephemeral KeySpace of a
+ * LocalStore, which tells that a key is definitely not stored without
+ * looking it up. During a fresh checkout nearly every object misses in the
+ * local store before being fetched from the backing store, and each of these
+ * misses otherwise searches several levels of RocksDB.
+ *
+ * Each key space has a blocked Bloom filter: the bits of a key all live in
+ * one 64-byte block, so that a lookup touches a single cache line. A filter
+ * is built by rebuild() from a scan of the stored keys, and keys are added
+ * to it as they are written. Until its first rebuild a key space is
+ * unfiltered, and every lookup goes to the store.
+ *
+ * Keys removed from the store stay in the filter, which then only costs
+ * lookups that miss anyway; rebuilding the filter periodically drops them and
+ * resizes it to the number of stored keys.
+ *
+ * Only ephemeral key spaces are filtered. Their objects can be fetched again
+ * from the backing store, so the one window where a key may be missing from
+ * the filter, a write queued before a rebuild started that reaches the store
+ * after the rebuild completed, costs at most a refetch.
+ */
+class NegativeLookupFilter {
+ public:
+  enum class Lookup {
+    /** The key space has no filter: look the key up. */
+    Unfiltered,
+    /** The key is definitely not stored. */
+    Absent,
+    /** The key may be stored: look it up. */
+    MaybePresent,
+  };
+
+  struct Stats {
+    /** Lookups answered as Absent. */
+    uint64_t absent = 0;
+    /** Lookups answered as MaybePresent. */
+    uint64_t maybePresent = 0;
+    /** MaybePresent lookups whose key was not stored after all. */
+    uint64_t falsePositives = 0;
+    /**
+     * Keys added to the current filter, some maybe more than once, or 0 if
+     * there is none.
+     */
+    size_t keys = 0;
+    /** Keys the current filter was sized for, or 0 if there is none. */
+    size_t capacity = 0;
+  };
+
+  /**
+   * Calls its argument with each key stored in a key space. May throw to
+   * abort a rebuild.
+   */
+  using KeyScanner =
+      folly::FunctionRef<void(folly::FunctionRef<void(folly::ByteRange)>)>;
+
+  NegativeLookupFilter();
+  ~NegativeLookupFilter();
+
+  NegativeLookupFilter(const NegativeLookupFilter&) = delete;
+  NegativeLookupFilter& operator=(const NegativeLookupFilter&) = delete;
+
+  /** Whether the keys of keySpace are ever filtered. */
+  static bool covers(KeySpace keySpace) {
+    return keySpace->isEphemeral();
+  }
+
+  /**
+   * Checks whether key may be stored in keySpace. Callers that find a
+   * MaybePresent key missing report it with recordFalsePositive().
+   */
+  Lookup lookup(KeySpace keySpace, folly::ByteRange key) const;
+
+  void recordFalsePositive(KeySpace keySpace) const;
+
+  /**
+   * Adds a key about to be written, before the write is visible to readers.
+   */
+  void add(KeySpace keySpace, folly::ByteRange key);
+  void add(KeySpace keySpace, uint64_t keyHash);
+
+  /**
+   * Records that the write of a key previously passed to add() reached the
+   * store, so that a rebuild whose scan started before that doesn't lose it.
+   * Writes that go straight to the store call this right after add(), while
+   * batched and queued writes call it once they are committed.
+   */
+  void addWritten(KeySpace keySpace, folly::ByteRange key);
+  void addWritten(KeySpace keySpace, uint64_t keyHash);
+
+  /** The hash of a key, for callers that defer addWritten(). */
+  static uint64_t hashKey(folly::ByteRange key);
+
+  /**
+   * Replaces the filter of keySpace with one built from the keys given by
+   * scan, sized for twice as many keys so that it fills up slowly. Keys
+   * added during the scan are kept. If scan throws, the current filter is
+   * left in place and the exception is propagated.
+   */
+  void rebuild(KeySpace keySpace, KeyScanner scan);
+
+  /**
+   * Whether keySpace has no filter, has more keys than its filter was sized
+   * for, or had its filter built more than maxAge ago.
+   */
+  bool needsRebuild(KeySpace keySpace, std::chrono::nanoseconds maxAge) const;
+
+  /**
+   * Drops the filter of keySpace, which becomes unfiltered until its next
+   * rebuild.
+   */
+  void clear(KeySpace keySpace);
+
+  Stats getStats(KeySpace keySpace) const;
+
+ private:
+  class Filter;
+
+  struct KeySpaceFilter {
+    folly::Synchronized<std::unique_ptr<Filter>, folly::SharedMutex> filter;
+    /**
+     * The hashes of the keys added while a rebuild scans the store, set only
+     * during one.
+     *
+     * Lock ordering: filter is acquired before added.
+     */
+    folly::Synchronized<std::optional<std::vector<uint64_t>>, std::mutex>
+        added;
+    /** Whether added is set, to check it without taking its lock. */
+    std::atomic<bool> rebuilding{false};
+    /** Serializes rebuilds of this key space. */
+    std::mutex rebuildMutex;
+
+    mutable std::atomic<uint64_t> absent{0};
+    mutable std::atomic<uint64_t> maybePresent{0};
+    mutable std::atomic<uint64_t> falsePositives{0};
+  };
+
+  void addImpl(KeySpace keySpace, uint64_t keyHash, bool written);
+
+  std::array<KeySpaceFilter, KeySpace::kTotalCount> keySpaces_;
+};
+
+} // namespace facebook::eden
@@ -6,7 +6,9 @@
  */
 
 #include <folly/MapUtil.h>
+#include <folly/hash/Hash.h>
 #include <folly/logging/xlog.h>
+#include <algorithm>
 #include <utility>
 
 #include "eden/fs/store/ObjectCache.h"
@@ -61,20 +63,79 @@ template <typename ObjectType, ObjectCacheFlavor Flavor>
 std::shared_ptr<ObjectCache<ObjectType, Flavor>>
 ObjectCache<ObjectType, Flavor>::create(
     size_t maximumCacheSizeBytes,
-    size_t minimumEntryCount) {
+    size_t minimumEntryCount,
+    size_t shardCount,
+    CacheEvictionPolicy evictionPolicy,
+    size_t largeObjectThresholdBytes,
+    size_t largeObjectCacheSizeBytes) {
   // Allow make_shared with private constructor.
   struct OC : ObjectCache<ObjectType, Flavor> {
-    OC(size_t x, size_t y) : ObjectCache<ObjectType, Flavor>{x, y} {}
+    OC(size_t x, size_t y, size_t z, CacheEvictionPolicy p, size_t t, size_t l)
+        : ObjectCache<ObjectType, Flavor>{x, y, z, p, t, l} {}
   };
-  return std::make_shared<OC>(maximumCacheSizeBytes, minimumEntryCount);
+  return std::make_shared<OC>(
+      maximumCacheSizeBytes,
+      minimumEntryCount,
+      shardCount,
+      evictionPolicy,
+      largeObjectThresholdBytes,
+      largeObjectCacheSizeBytes);
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 ObjectCache<ObjectType, Flavor>::ObjectCache(
     size_t maximumCacheSizeBytes,
-    size_t minimumEntryCount)
-    : maximumCacheSizeBytes_{maximumCacheSizeBytes},
-      minimumEntryCount_{minimumEntryCount} {}
+    size_t minimumEntryCount,
+    size_t shardCount,
+    CacheEvictionPolicy evictionPolicy,
+    size_t largeObjectThresholdBytes,
+    size_t largeObjectCacheSizeBytes)
+    : maximumCacheSizeBytes_{
+          maximumCacheSizeBytes / std::max<size_t>(shardCount, 1)},
+      // Round up so that a minimum entry count smaller than the number of
+      // shards still keeps at least one entry per shard.
+      minimumEntryCount_{
+          (minimumEntryCount + std::max<size_t>(shardCount, 1) - 1) /
+          std::max<size_t>(shardCount, 1)},
+      evictionPolicy_{evictionPolicy},
+      // Same split as the 20% probation / 80% protected SLRU described in the
+      // TinyLFU paper.
+      maximumProtectedSizeBytes_{maximumCacheSizeBytes_ / 5 * 4},
+      shards_(std::max<size_t>(shardCount, 1)),
+      largeObjectThresholdBytes_{largeObjectThresholdBytes} {
+  if (largeObjectThresholdBytes_ != 0 && largeObjectCacheSizeBytes != 0) {
+    // Large objects are rare and expensive to hold, a single locked LRU
+    // shard is enough. Always keep the most recent one so that reading a
+    // large file from start to end doesn't reload it on every read.
+    largeObjects_ = create(largeObjectCacheSizeBytes, 1);
+  }
+  if (evictionPolicy_ == CacheEvictionPolicy::TinyLFU) {
+    // The sketch should have roughly as many counters as the shard has
+    // entries. Object sizes vary a lot, so guess based on a typical tree or
+    // small source file, and never go so small that collisions dominate.
+    constexpr size_t kTypicalObjectSize = 4096;
+    constexpr size_t kMinimumSketchWidth = 1024;
+    auto width = std::max<size_t>(
+        {kMinimumSketchWidth,
+         minimumEntryCount_,
+         maximumCacheSizeBytes_ / kTypicalObjectSize});
+    for (auto& shard : shards_) {
+      shard.state.sketch = std::make_unique<FrequencySketch>(width);
+    }
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+typename ObjectCache<ObjectType, Flavor>::Shard&
+ObjectCache<ObjectType, Flavor>::getShard(const ObjectId& hash) const {
+  if (shards_.size() == 1) {
+    return shards_[0];
+  }
+  // The shard's unordered_map buckets by the same hash code, so mix it before
+  // picking a shard to keep the two distributions independent.
+  auto index = folly::hash::twang_mix64(hash.getHashCode()) % shards_.size();
+  return shards_[index];
+}
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 template <ObjectCacheFlavor F>
@@ -83,17 +144,22 @@ typename std::enable_if_t<
     typename ObjectCache<ObjectType, Flavor>::GetResult>
 ObjectCache<ObjectType, Flavor>::getInterestHandle(
     const ObjectId& hash,
-    Interest interest) {
+    Interest interest,
+    ClientId client) {
   XLOG(DBG6) << "BlobCache::getInterestHandle " << hash;
   // Acquires ObjectCache's lock upon destruction by calling dropInterestHandle,
   // so ensure that, if an exception is thrown below, the ~ObjectInterestHandle
   // runs after the lock is released.
   ObjectInterestHandle<ObjectType> interestHandle;
 
-  auto state = lockState();
+  auto state = lockState(hash);
 
-  auto item = getImpl(hash, state);
+  auto item = getImpl(hash, state, client);
   if (!item) {
+    if (largeObjects_) {
+      // The tier never locks this cache, so the lock order is consistent.
+      return largeObjects_->getInterestHandle(hash, interest, client);
+    }
     return GetResult{};
   }
 
@@ -127,13 +193,18 @@ template <ObjectCacheFlavor F>
 typename std::enable_if_t<
     F == ObjectCacheFlavor::Simple,
     typename ObjectCache<ObjectType, Flavor>::ObjectPtr>
-ObjectCache<ObjectType, Flavor>::getSimple(const ObjectId& hash) {
+ObjectCache<ObjectType, Flavor>::getSimple(
+    const ObjectId& hash,
+    ClientId client) {
   XLOG(DBG6) << "BlobCache::getSimple " << hash;
-  auto state = lockState();
+  auto state = lockState(hash);
 
-  if (auto item = getImpl(hash, state)) {
+  if (auto item = getImpl(hash, state, client)) {
     return item->object;
   }
+  if (largeObjects_) {
+    return largeObjects_->getSimple(hash, client);
+  }
   return nullptr;
 }
 
@@ -141,21 +212,52 @@ template <typename ObjectType, ObjectCacheFlavor Flavor>
 typename ObjectCache<ObjectType, Flavor>::CacheItem*
 ObjectCache<ObjectType, Flavor>::getImpl(
     const ObjectId& hash,
-    LockedState& state) {
+    LockedState& state,
+    ClientId client) {
   XLOG(DBG6) << "ObjectCache::getImpl " << hash;
+  if (state->sketch) {
+    // Misses are recorded too: objects are usually inserted right after a
+    // cache miss, so this is what lets a recently requested object win
+    // admission.
+    state->sketch->increment(hash.getHashCode());
+  }
+
+  auto* clientState = getClientState(state, client);
   auto* item = folly::get_ptr(state->items, hash);
   if (!item) {
     XLOG(DBG6) << "ObjectCache::getImpl missed";
+    if (trace_) {
+      trace_->record(ObjectCacheTrace::Operation::Miss, hash, 0);
+    }
     ++state->missCount;
+    if (clientState) {
+      ++clientState->stats.missCount;
+    }
 
   } else {
     XLOG(DBG6) << "ObjectCache::getImpl hit";
+    if (trace_) {
+      trace_->record(
+          ObjectCacheTrace::Operation::Hit,
+          hash,
+          item->object->getSizeBytes());
+    }
+
+    if (isSegmented()) {
+      if (item->isProtected) {
+        ++state->protectedHitCount;
+      } else {
+        ++state->probationHitCount;
+      }
+    }
 
     // TODO: Should we avoid promoting if interest is UnlikelyNeededAgain?
     // For now, we'll try not to be too clever.
-    state->evictionQueue.splice(
-        state->evictionQueue.end(), state->evictionQueue, item->index);
+    promote(state, item);
     ++state->hitCount;
+    if (clientState) {
+      ++clientState->stats.hitCount;
+    }
   }
 
   return item;
@@ -168,8 +270,26 @@ typename std::enable_if_t<
     ObjectInterestHandle<ObjectType>>
 ObjectCache<ObjectType, Flavor>::insertInterestHandle(
     ObjectPtr object,
-    Interest interest) {
+    Interest interest,
+    ClientId client) {
   XLOG(DBG6) << "ObjectCache::insertInterestHandle " << object->getHash();
+  if (isLargeObject(*object)) {
+    if (trace_) {
+      trace_->record(
+          ObjectCacheTrace::Operation::Insert,
+          object->getHash(),
+          object->getSizeBytes());
+    }
+    if (auto* tier = admitLargeObject()) {
+      return tier->insertInterestHandle(std::move(object), interest, client);
+    }
+    // Not cached, but the handle still gives access to the object for as
+    // long as it stays in memory.
+    ObjectInterestHandle<ObjectType> interestHandle{};
+    interestHandle.object_ = object;
+    return interestHandle;
+  }
+
   // Acquires ObjectCache's lock upon destruction by calling dropInterestHandle,
   // so ensure that, if an exception is thrown below, the ~ObjectInterestHandle
   // runs after the lock is released.
@@ -190,26 +310,33 @@ ObjectCache<ObjectType, Flavor>::insertInterestHandle(
 
   XLOG(DBG6) << "  creating entry with generation=" << cacheItemGeneration;
 
-  auto state = lockState();
-  auto [item, inserted] = insertImpl(object, state);
-  switch (interest) {
-    case Interest::UnlikelyNeededAgain:
-      break;
-    case Interest::WantHandle:
-    case Interest::LikelyNeededAgain:
-      ++item->referenceCount;
-      break;
-  }
-  if (inserted) { // new entry we need to set the generation number
-    item->generation = cacheItemGeneration;
-  } else {
-    XLOG(DBG6) << "duplicate entry, using generation " << item->generation;
-    // Inserting duplicate entry - use its generation.
-    interestHandle.cacheItemGeneration_ = item->generation;
-    // note we can skip eviction here because we didn't insert anything new,
-    // so the cache size has not changed as a result of this operation.
-    return interestHandle;
+  std::vector<ObjectPtr> evicted;
+  {
+    auto state = lockState(object->getHash());
+    auto [item, inserted] = insertImpl(object, state, client);
+    evicted.swap(state->evictedObjects);
+    if (!item) {
+      // Rejected by the admission filter. The handle still allows access to
+      // the object for as long as it stays in memory.
+    } else {
+      switch (interest) {
+        case Interest::UnlikelyNeededAgain:
+          break;
+        case Interest::WantHandle:
+        case Interest::LikelyNeededAgain:
+          ++item->referenceCount;
+          break;
+      }
+      if (inserted) { // new entry we need to set the generation number
+        item->generation = cacheItemGeneration;
+      } else {
+        XLOG(DBG6) << "duplicate entry, using generation " << item->generation;
+        // Inserting duplicate entry - use its generation.
+        interestHandle.cacheItemGeneration_ = item->generation;
+      }
+    }
   }
+  handleEvictedObjects(std::move(evicted));
   return interestHandle;
 }
 
@@ -217,21 +344,63 @@ template <typename ObjectType, ObjectCacheFlavor Flavor>
 template <ObjectCacheFlavor F>
 typename std::enable_if_t<F == ObjectCacheFlavor::Simple, void>
 ObjectCache<ObjectType, Flavor>::insertSimple(
-    ObjectCache<ObjectType, Flavor>::ObjectPtr object) {
+    ObjectCache<ObjectType, Flavor>::ObjectPtr object,
+    ClientId client) {
   XLOG(DBG6) << "ObjectCache::insertSimple " << object->getHash();
-  auto state = lockState();
-  insertImpl(object, state);
+  if (isLargeObject(*object)) {
+    if (trace_) {
+      trace_->record(
+          ObjectCacheTrace::Operation::Insert,
+          object->getHash(),
+          object->getSizeBytes());
+    }
+    if (auto* tier = admitLargeObject()) {
+      tier->insertSimple(std::move(object), client);
+    }
+    return;
+  }
+  std::vector<ObjectPtr> evicted;
+  {
+    auto state = lockState(object->getHash());
+    insertImpl(object, state, client);
+    evicted.swap(state->evictedObjects);
+  }
+  handleEvictedObjects(std::move(evicted));
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::setEvictionHandler(
+    EvictionHandler handler) {
+  evictionHandler_ = std::move(handler);
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::handleEvictedObjects(
+    std::vector<ObjectPtr> objects) {
+  if (!objects.empty()) {
+    evictionHandler_(std::move(objects));
+  }
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 std::pair<typename ObjectCache<ObjectType, Flavor>::CacheItem*, bool>
 ObjectCache<ObjectType, Flavor>::insertImpl(
     ObjectPtr object,
-    LockedState& state) {
+    LockedState& state,
+    ClientId client) {
   XLOG(DBG6) << "ObjectCache::insertImpl " << object->getHash();
 
   auto hash = object->getHash();
   auto size = object->getSizeBytes();
+  if (trace_) {
+    trace_->record(ObjectCacheTrace::Operation::Insert, hash, size);
+  }
+
+  if (!state->items.count(hash) && shouldRejectInsert(hash, size, state)) {
+    XLOG(DBG6) << "ObjectCache::insertImpl rejected " << hash;
+    ++state->admissionRejectCount;
+    return std::make_pair(nullptr, false);
+  }
 
   // the following should be no except
 
@@ -247,41 +416,340 @@ ObjectCache<ObjectType, Flavor>::insertImpl(
       throw;
     }
     iter->second.index = std::prev(state->evictionQueue.end());
+    iter->second.client = client;
     state->totalSize += size;
+    chargeItem(state, itemPtr);
     evictUntilFits(state);
   } else {
-    state->evictionQueue.splice(
-        state->evictionQueue.end(), state->evictionQueue, itemPtr->index);
+    promote(state, itemPtr);
   }
   return std::make_pair(itemPtr, inserted);
 }
 
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+bool ObjectCache<ObjectType, Flavor>::shouldRejectInsert(
+    const ObjectId& hash,
+    size_t size,
+    LockedState& state) const {
+  if (!state->sketch) {
+    return false;
+  }
+  if (state->totalSize + size <= maximumCacheSizeBytes_ ||
+      state->items.size() < minimumEntryCount_) {
+    // Nothing would get evicted.
+    return false;
+  }
+  auto* victim = evictionCandidate(state);
+  if (!victim) {
+    return false;
+  }
+  return state->sketch->estimate(hash.getHashCode()) <=
+      state->sketch->estimate(victim->object->getHash().getHashCode());
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::promote(
+    LockedState& state,
+    CacheItem* item) noexcept {
+  if (!isSegmented()) {
+    state->evictionQueue.splice(
+        state->evictionQueue.end(), state->evictionQueue, item->index);
+    return;
+  }
+
+  if (item->isProtected) {
+    state->protectedQueue.splice(
+        state->protectedQueue.end(), state->protectedQueue, item->index);
+    return;
+  }
+
+  state->protectedQueue.splice(
+      state->protectedQueue.end(), state->evictionQueue, item->index);
+  item->isProtected = true;
+  state->protectedSize += item->object->getSizeBytes();
+
+  // Demote the least recently used protected entries back to probation, but
+  // always keep the entry that was just promoted.
+  while (state->protectedSize > maximumProtectedSizeBytes_ &&
+         state->protectedQueue.size() > 1) {
+    CacheItem* demoted = state->protectedQueue.front();
+    state->evictionQueue.splice(
+        state->evictionQueue.end(),
+        state->protectedQueue,
+        state->protectedQueue.begin());
+    demoted->isProtected = false;
+    state->protectedSize -= demoted->object->getSizeBytes();
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::unlinkItem(
+    LockedState& state,
+    CacheItem* item) noexcept {
+  if (item->isProtected) {
+    state->protectedQueue.erase(item->index);
+    state->protectedSize -= item->object->getSizeBytes();
+    item->isProtected = false;
+  } else {
+    state->evictionQueue.erase(item->index);
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+typename ObjectCache<ObjectType, Flavor>::CacheItem*
+ObjectCache<ObjectType, Flavor>::evictionCandidate(
+    LockedState& state) const noexcept {
+  if (!state->evictionQueue.empty()) {
+    return state->evictionQueue.front();
+  }
+  if (!state->protectedQueue.empty()) {
+    return state->protectedQueue.front();
+  }
+  return nullptr;
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+typename ObjectCache<ObjectType, Flavor>::CacheItem*
+ObjectCache<ObjectType, Flavor>::fairEvictionCandidate(
+    LockedState& state) const noexcept {
+  // Bounds the cost of an eviction when the least recently used entries all
+  // belong to clients within their share.
+  constexpr size_t kFairShareScanLength = 16;
+
+  auto* candidate = evictionCandidate(state);
+  if (state->registeredClientCount < 2 || !candidate) {
+    return candidate;
+  }
+  auto fairShare = maximumCacheSizeBytes_ / state->registeredClientCount;
+  auto& queue = state->evictionQueue.empty() ? state->protectedQueue
+                                             : state->evictionQueue;
+  // Never pick the most recently used entry, it may be the one being
+  // inserted.
+  auto end = std::prev(queue.end());
+  size_t scanned = 0;
+  for (auto it = queue.begin(); it != end && scanned < kFairShareScanLength;
+       ++it, ++scanned) {
+    auto* clientState = folly::get_ptr(state->clients, (*it)->client);
+    if (clientState &&
+        (!clientState->registered ||
+         clientState->stats.totalSizeInBytes > fairShare)) {
+      return *it;
+    }
+  }
+  return candidate;
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+typename ObjectCache<ObjectType, Flavor>::ClientState*
+ObjectCache<ObjectType, Flavor>::getClientState(
+    LockedState& state,
+    ClientId client) const noexcept {
+  if (client == kNoClient) {
+    return nullptr;
+  }
+  return folly::get_ptr(state->clients, client);
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::chargeItem(
+    LockedState& state,
+    CacheItem* item) noexcept {
+  auto* clientState = getClientState(state, item->client);
+  if (!clientState) {
+    item->client = kNoClient;
+    return;
+  }
+  ++clientState->stats.objectCount;
+  clientState->stats.totalSizeInBytes += item->object->getSizeBytes();
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+ObjectCache<ObjectType, Flavor>*
+ObjectCache<ObjectType, Flavor>::admitLargeObject() noexcept {
+  if (!largeObjects_) {
+    largeObjectRejectCount_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  largeObjectAdmitCount_.fetch_add(1, std::memory_order_relaxed);
+  return largeObjects_.get();
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+typename ObjectCache<ObjectType, Flavor>::ClientId
+ObjectCache<ObjectType, Flavor>::registerClient() {
+  auto client = nextClientId_.fetch_add(1, std::memory_order_relaxed);
+  addClient(client);
+  return client;
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::addClient(ClientId client) {
+  for (auto& shard : shards_) {
+    auto state = lockShard(shard);
+    state->clients.try_emplace(client);
+    ++state->registeredClientCount;
+  }
+  if (largeObjects_) {
+    largeObjects_->addClient(client);
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::unregisterClient(ClientId client) {
+  for (auto& shard : shards_) {
+    auto state = lockShard(shard);
+    auto it = state->clients.find(client);
+    if (it == state->clients.end() || !it->second.registered) {
+      continue;
+    }
+    --state->registeredClientCount;
+    if (it->second.stats.objectCount == 0) {
+      state->clients.erase(it);
+    } else {
+      it->second.registered = false;
+    }
+  }
+  if (largeObjects_) {
+    largeObjects_->unregisterClient(client);
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+typename ObjectCache<ObjectType, Flavor>::ClientStats
+ObjectCache<ObjectType, Flavor>::getClientStats(ClientId client) const {
+  ClientStats stats;
+  for (auto& shard : shards_) {
+    auto state = lockShard(shard);
+    auto* clientState = getClientState(state, client);
+    if (!clientState) {
+      continue;
+    }
+    stats.objectCount += clientState->stats.objectCount;
+    stats.totalSizeInBytes += clientState->stats.totalSizeInBytes;
+    stats.hitCount += clientState->stats.hitCount;
+    stats.missCount += clientState->stats.missCount;
+    stats.evictionCount += clientState->stats.evictionCount;
+  }
+  if (largeObjects_) {
+    auto largeStats = largeObjects_->getClientStats(client);
+    stats.objectCount += largeStats.objectCount;
+    stats.totalSizeInBytes += largeStats.totalSizeInBytes;
+    stats.hitCount += largeStats.hitCount;
+    stats.evictionCount += largeStats.evictionCount;
+  }
+  return stats;
+}
+
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 bool ObjectCache<ObjectType, Flavor>::contains(const ObjectId& hash) const {
-  auto state = lockState();
-  return 1 == state->items.count(hash);
+  {
+    auto state = lockState(hash);
+    if (1 == state->items.count(hash)) {
+      return true;
+    }
+  }
+  return largeObjects_ && largeObjects_->contains(hash);
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::clear() {
   XLOG(DBG6) << "ObjectCache::clear";
-  auto state = lockState();
-  state->totalSize = 0;
-  state->items.clear();
-  state->evictionQueue.clear();
+  for (auto& shard : shards_) {
+    auto state = lockShard(shard);
+    state->totalSize = 0;
+    state->items.clear();
+    state->evictionQueue.clear();
+    state->protectedQueue.clear();
+    state->protectedSize = 0;
+    for (auto it = state->clients.begin(); it != state->clients.end();) {
+      if (!it->second.registered) {
+        it = state->clients.erase(it);
+        continue;
+      }
+      it->second.stats.objectCount = 0;
+      it->second.stats.totalSizeInBytes = 0;
+      ++it;
+    }
+  }
+  if (largeObjects_) {
+    largeObjects_->clear();
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+size_t ObjectCache<ObjectType, Flavor>::shrinkTo(size_t maximumSizeBytes) {
+  XLOG(DBG6) << "ObjectCache::shrinkTo " << maximumSizeBytes;
+  size_t evicted = 0;
+  auto shardSizeBytes = maximumSizeBytes / shards_.size();
+  for (auto& shard : shards_) {
+    std::vector<ObjectPtr> notHandled;
+    auto state = lockShard(shard);
+    auto sizeBefore = state->totalSize;
+    while (state->totalSize > shardSizeBytes &&
+           state->items.size() > minimumEntryCount_) {
+      evictOne(state);
+    }
+    evicted += sizeBefore - state->totalSize;
+    notHandled.swap(state->evictedObjects);
+  }
+  if (largeObjects_) {
+    // Large objects are the most expensive to keep and are only kept to
+    // avoid refetching the same one over and over: keep only the most recent.
+    evicted += largeObjects_->shrinkTo(0);
+  }
+  return evicted;
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+std::vector<typename ObjectCache<ObjectType, Flavor>::ObjectPtr>
+ObjectCache<ObjectType, Flavor>::getAllObjects() const {
+  std::vector<ObjectPtr> objects;
+  for (auto& shard : shards_) {
+    auto state = lockShard(shard);
+    objects.reserve(objects.size() + state->items.size());
+    for (auto* item : state->evictionQueue) {
+      objects.push_back(item->object);
+    }
+    for (auto* item : state->protectedQueue) {
+      objects.push_back(item->object);
+    }
+  }
+  if (largeObjects_) {
+    auto largeObjects = largeObjects_->getAllObjects();
+    objects.insert(objects.end(), largeObjects.begin(), largeObjects.end());
+  }
+  return objects;
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 typename ObjectCache<ObjectType, Flavor>::Stats
 ObjectCache<ObjectType, Flavor>::getStats() const {
-  auto state = lockState();
   Stats stats;
-  stats.objectCount = state->items.size();
-  stats.totalSizeInBytes = state->totalSize;
-  stats.hitCount = state->hitCount;
-  stats.missCount = state->missCount;
-  stats.evictionCount = state->evictionCount;
-  stats.dropCount = state->dropCount;
+  for (auto& shard : shards_) {
+    auto state = lockShard(shard);
+    stats.objectCount += state->items.size();
+    stats.totalSizeInBytes += state->totalSize;
+    stats.hitCount += state->hitCount;
+    stats.missCount += state->missCount;
+    stats.evictionCount += state->evictionCount;
+    stats.dropCount += state->dropCount;
+    stats.probationHitCount += state->probationHitCount;
+    stats.protectedHitCount += state->protectedHitCount;
+    stats.protectedObjectCount += state->protectedQueue.size();
+    stats.protectedSizeInBytes += state->protectedSize;
+    stats.admissionRejectCount += state->admissionRejectCount;
+    stats.pinnedEvictionCount += state->pinnedEvictionCount;
+  }
+  if (largeObjects_) {
+    auto largeStats = largeObjects_->getStats();
+    stats.largeObjectCount = largeStats.objectCount;
+    stats.largeObjectSizeInBytes = largeStats.totalSizeInBytes;
+    stats.largeObjectHitCount = largeStats.hitCount;
+  }
+  stats.largeObjectAdmitCount =
+      largeObjectAdmitCount_.load(std::memory_order_relaxed);
+  stats.largeObjectRejectCount =
+      largeObjectRejectCount_.load(std::memory_order_relaxed);
   return stats;
 }
 
@@ -290,7 +758,7 @@ void ObjectCache<ObjectType, Flavor>::dropInterestHandle(
     const ObjectId& hash,
     uint64_t generation) noexcept {
   XLOG(DBG6) << "dropInterestHandle " << hash << " generation=" << generation;
-  auto state = lockState();
+  auto state = lockState(hash);
 
   auto* item = folly::get_ptr(state->items, hash);
   if (!item) {
@@ -312,7 +780,7 @@ void ObjectCache<ObjectType, Flavor>::dropInterestHandle(
   }
 
   if (--item->referenceCount == 0) {
-    state->evictionQueue.erase(item->index);
+    unlinkItem(state, item);
     ++state->dropCount;
     evictItem(state, item);
   }
@@ -324,19 +792,33 @@ void ObjectCache<ObjectType, Flavor>::evictUntilFits(
   XLOG(DBG6) << "ObjectCache::evictUntilFits "
              << "state.totalSize=" << state->totalSize
              << ", maximumCacheSizeBytes_=" << maximumCacheSizeBytes_
-             << ", evictionQueue.size()=" << state->evictionQueue.size()
+             << ", items.size()=" << state->items.size()
              << ", minimumEntryCount_=" << minimumEntryCount_;
   while (state->totalSize > maximumCacheSizeBytes_ &&
-         state->evictionQueue.size() > minimumEntryCount_) {
+         state->items.size() > minimumEntryCount_) {
     evictOne(state);
   }
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::evictOne(LockedState& state) noexcept {
-  CacheItem* front = state->evictionQueue.front();
-  state->evictionQueue.pop_front();
+  CacheItem* front = fairEvictionCandidate(state);
+  unlinkItem(state, front);
   ++state->evictionCount;
+  if (front->referenceCount > 0) {
+    ++state->pinnedEvictionCount;
+  }
+  if (auto* clientState = getClientState(state, front->client)) {
+    ++clientState->stats.evictionCount;
+  }
+  if (evictionHandler_) {
+    try {
+      state->evictedObjects.push_back(front->object);
+    } catch (const std::bad_alloc&) {
+      // The handler only gets a chance to keep the object around, this is
+      // not worth failing the insert for.
+    }
+  }
   evictItem(state, front);
 }
 
@@ -348,6 +830,18 @@ void ObjectCache<ObjectType, Flavor>::evictItem(
              << "evicting " << item->object->getHash()
              << " generation=" << item->generation;
   auto size = item->object->getSizeBytes();
+  auto clientIter = state->clients.end();
+  if (item->client != kNoClient) {
+    clientIter = state->clients.find(item->client);
+  }
+  if (clientIter != state->clients.end()) {
+    auto& clientState = clientIter->second;
+    --clientState.stats.objectCount;
+    clientState.stats.totalSizeInBytes -= size;
+    if (!clientState.registered && clientState.stats.objectCount == 0) {
+      state->clients.erase(clientIter);
+    }
+  }
   // TODO: Releasing this ObjectPtr here can run arbitrary deleters which
   // could, in theory, try to reacquire the ObjectCache's lock. The object
   // could be scheduled for deletion in a deletion queue but then it's hard to
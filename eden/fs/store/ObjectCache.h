@@ -7,13 +7,22 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <list>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
+#include <folly/lang/Align.h>
 #include <folly/synchronization/DistributedMutex.h>
 
+#include "eden/fs/config/CacheEvictionPolicy.h"
 #include "eden/fs/model/Hash.h"
+#include "eden/fs/store/FrequencySketch.h"
+#include "eden/fs/store/ObjectCacheTrace.h"
+#include "eden/fs/telemetry/InstrumentedMutex.h"
 
 namespace facebook::eden {
 
@@ -100,6 +109,29 @@ class ObjectInterestHandle {
  * be used that only allow clients to use one flavor of get and insert. See
  * BlobCache and TreeCache for examples of each flavor.
  *
+ * The cache may be split into a number of independently locked shards, keyed
+ * by the hash of the ObjectId. Each shard has its own eviction queue and an
+ * equal share of the maximum cache size and minimum entry count. Sharding
+ * reduces lock contention when many threads hit the cache at once, at the cost
+ * of the eviction order only being LRU within a shard.
+ *
+ * The eviction policy is selected at construction time, see
+ * CacheEvictionPolicy. With SLRU and TinyLFU, each shard's eviction queue is
+ * split into a probationary and a protected segment. Objects that are only
+ * accessed once (e.g. during a full-tree scan) never leave the probationary
+ * segment and are evicted first, leaving the frequently accessed working set
+ * in the protected segment alone.
+ *
+ * Optionally, objects larger than a threshold bypass the cache and go to a
+ * separate large object tier with its own, usually much smaller, budget. A
+ * single huge object then can't flush the working set of small objects. With
+ * no budget for the tier, large objects are not cached at all.
+ *
+ * A cache may be shared by several clients, typically the mounts of a daemon,
+ * see registerClient(). Objects are then accounted to the client that
+ * inserted them, so that one busy client can't evict the working set of all
+ * the others.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 template <typename ObjectType, ObjectCacheFlavor Flavor>
@@ -132,6 +164,13 @@ class ObjectCache
     LikelyNeededAgain,
   };
 
+  /**
+   * Identifies a client of a shared cache, see registerClient(). Objects
+   * inserted with kNoClient are not accounted to any client.
+   */
+  using ClientId = uint32_t;
+  static constexpr ClientId kNoClient = 0;
+
   struct GetResult {
     ObjectPtr object;
     ObjectInterestHandle<ObjectType> interestHandle;
@@ -144,11 +183,67 @@ class ObjectCache
     uint64_t missCount{0};
     uint64_t evictionCount{0};
     uint64_t dropCount{0};
+
+    /// Segmented policies only: the number of hits in each segment. These sum
+    /// to hitCount.
+    uint64_t probationHitCount{0};
+    uint64_t protectedHitCount{0};
+
+    /// Segmented policies only: number of objects in and bytes used by the
+    /// protected segment.
+    size_t protectedObjectCount{0};
+    size_t protectedSizeInBytes{0};
+
+    /// TinyLFU only: number of inserts rejected by the admission filter.
+    uint64_t admissionRejectCount{0};
+
+    /// Number of evictions, included in evictionCount, of objects that still
+    /// had outstanding interest handles. Pinned objects that are evicted stay
+    /// in memory through their holders, past the cache's budget.
+    uint64_t pinnedEvictionCount{0};
+
+    /// Large object tier only: number of objects in, bytes used by and hits
+    /// served from the tier, which are not included in the fields above.
+    size_t largeObjectCount{0};
+    size_t largeObjectSizeInBytes{0};
+    uint64_t largeObjectHitCount{0};
+
+    /// Large object tier only: number of objects over the size threshold that
+    /// were inserted into the tier, and that were not cached at all because
+    /// the tier has no budget.
+    uint64_t largeObjectAdmitCount{0};
+    uint64_t largeObjectRejectCount{0};
   };
 
+  struct ClientStats {
+    /// Number of objects and bytes charged to the client, i.e. of the cached
+    /// objects it inserted.
+    size_t objectCount{0};
+    size_t totalSizeInBytes{0};
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+    /// Number of objects charged to the client that were evicted to make room
+    /// for others, not counting objects dropped with their interest handle.
+    uint64_t evictionCount{0};
+  };
+
+  /**
+   * Create a cache holding at most maximumCacheSizeBytes worth of objects,
+   * split across shardCount independently locked shards. A shardCount of 0 is
+   * treated as 1.
+   *
+   * If largeObjectThresholdBytes is not 0, objects larger than it are kept in
+   * a separate LRU tier holding at most largeObjectCacheSizeBytes worth of
+   * them, except that the most recent one is always kept. A
+   * largeObjectCacheSizeBytes of 0 disables caching of large objects.
+   */
   static std::shared_ptr<ObjectCache<ObjectType, Flavor>> create(
       size_t maximumCacheSizeBytes,
-      size_t minimumEntryCount);
+      size_t minimumEntryCount,
+      size_t shardCount = 1,
+      CacheEvictionPolicy evictionPolicy = CacheEvictionPolicy::LRU,
+      size_t largeObjectThresholdBytes = 0,
+      size_t largeObjectCacheSizeBytes = 0);
   ~ObjectCache() {}
 
   /**
@@ -169,7 +264,8 @@ class ObjectCache
       typename ObjectCache<ObjectType, Flavor>::GetResult>
   getInterestHandle(
       const ObjectId& hash,
-      Interest interest = Interest::LikelyNeededAgain);
+      Interest interest = Interest::LikelyNeededAgain,
+      ClientId client = kNoClient);
 
   /**
    * If a object for the given hash is in cache, return it. If the object is not
@@ -179,12 +275,13 @@ class ObjectCache
   typename std::enable_if_t<
       F == ObjectCacheFlavor::Simple,
       typename ObjectCache<ObjectType, Flavor>::ObjectPtr>
-  getSimple(const ObjectId& hash);
+  getSimple(const ObjectId& hash, ClientId client = kNoClient);
 
   /**
    * Inserts a object into the cache for future lookup. If the new total size
    * exceeds the maximum cache size and the minimum entry count, old entries are
-   * evicted.
+   * evicted. With the TinyLFU policy, the object may not be inserted at all if
+   * it has been accessed less often than the entry it would evict.
    *
    * Optionally returns an interest handle that, when dropped, evicts the
    * inserted object.
@@ -195,7 +292,8 @@ class ObjectCache
       ObjectInterestHandle<ObjectType>>
   insertInterestHandle(
       ObjectPtr object,
-      Interest interest = Interest::LikelyNeededAgain);
+      Interest interest = Interest::LikelyNeededAgain,
+      ClientId client = kNoClient);
 
   /**
    * Inserts a object into the cache for future lookup. If the new total size
@@ -204,7 +302,8 @@ class ObjectCache
    */
   template <ObjectCacheFlavor F = Flavor>
   typename std::enable_if_t<F == ObjectCacheFlavor::Simple, void> insertSimple(
-      ObjectPtr object);
+      ObjectPtr object,
+      ClientId client = kNoClient);
 
   /**
    * Returns true if the cache contains a object for the given hash.
@@ -216,14 +315,102 @@ class ObjectCache
    */
   void clear();
 
+  /**
+   * Evicts the least recently used objects until the cache holds at most
+   * maximumSizeBytes worth of them, for example in response to memory
+   * pressure, while still keeping the minimum entry count. The cache's own
+   * budget is unchanged, so it grows back as objects are inserted.
+   *
+   * Evicted objects are not passed to the eviction handler. Returns the
+   * number of bytes evicted.
+   */
+  size_t shrinkTo(size_t maximumSizeBytes);
+
+  /**
+   * Returns every object currently in the cache. Within each shard, objects
+   * are ordered from the next to be evicted to the most recently used.
+   */
+  std::vector<ObjectPtr> getAllObjects() const;
+
   /**
    * Return information about the current size of the cache and the total number
-   * of hits and misses.
+   * of hits and misses, summed across all shards.
    */
   Stats getStats() const;
 
+  /**
+   * Register a new client of the cache and return its id, to be passed to get
+   * and insert calls.
+   *
+   * Inserted objects are charged to the client that inserted them, even when
+   * other clients hit them later: clients sharing hot objects only pay for
+   * them once. Hits and misses are counted for the client that looked up the
+   * object.
+   *
+   * While more than one client is registered, each has a fair share of the
+   * cache, its size divided by the number of clients. This is a soft quota:
+   * clients may use more while the cache has room, but once it is full, the
+   * least recently used objects of clients over their share are evicted
+   * before those of the other clients.
+   */
+  ClientId registerClient();
+
+  /**
+   * Unregister a client. The objects charged to it stay cached, but are
+   * evicted before those of any registered client.
+   */
+  void unregisterClient(ClientId client);
+
+  /**
+   * Return the accounting of the given client, summed across all shards.
+   */
+  ClientStats getClientStats(ClientId client) const;
+
+  size_t getShardCount() const {
+    return shards_.size();
+  }
+
+  CacheEvictionPolicy getEvictionPolicy() const {
+    return evictionPolicy_;
+  }
+
+  /**
+   * Record the hits, misses and inserts of this cache into trace, see
+   * ObjectCacheTrace. Objects found in the large object tier are recorded as
+   * misses, since this cache doesn't hold them.
+   *
+   * Must be called before the cache is used.
+   */
+  void setTrace(std::shared_ptr<ObjectCacheTrace> trace) {
+    trace_ = std::move(trace);
+  }
+
+  const std::shared_ptr<ObjectCacheTrace>& getTrace() const {
+    return trace_;
+  }
+
  protected:
-  explicit ObjectCache(size_t maximumCacheSizeBytes, size_t minimumEntryCount);
+  explicit ObjectCache(
+      size_t maximumCacheSizeBytes,
+      size_t minimumEntryCount,
+      size_t shardCount = 1,
+      CacheEvictionPolicy evictionPolicy = CacheEvictionPolicy::LRU,
+      size_t largeObjectThresholdBytes = 0,
+      size_t largeObjectCacheSizeBytes = 0);
+
+  using EvictionHandler = std::function<void(std::vector<ObjectPtr>)>;
+
+  /**
+   * Register a function to be called with the objects evicted to make room
+   * for new ones, for example to keep them in a second tier. It is called by
+   * the inserting thread, after the cache's locks are released. Objects
+   * dropped with their last interest handle or removed by clear() are not
+   * passed to it.
+   *
+   * Must be called before the cache is used, typically from the constructor
+   * of a subclass.
+   */
+  void setEvictionHandler(EvictionHandler handler);
 
  private:
   /*
@@ -247,6 +434,10 @@ class ObjectCache
 
     typename std::list<CacheItem*>::iterator index;
 
+    /// Whether index points into State::protectedQueue rather than
+    /// State::evictionQueue. Always false with the LRU policy.
+    bool isProtected{false};
+
     /// Incremented on every LikelyNeededAgain or WantInterestHandle.
     /// Decremented on every dropInterestHandle. Evicted if it reaches zero.
     uint64_t referenceCount{0};
@@ -254,19 +445,50 @@ class ObjectCache
     /// Given a unique value upon allocation. Used to verify InterestHandle
     /// matches this specific item.
     uint64_t generation{std::numeric_limits<uint64_t>::max()};
+
+    /// The client the object is charged to.
+    ClientId client{kNoClient};
+  };
+
+  struct ClientState {
+    ClientStats stats;
+    /// Unregistered clients are kept until their last object is evicted.
+    bool registered{true};
   };
 
   struct State {
     size_t totalSize{0};
     std::unordered_map<ObjectId, CacheItem> items;
 
-    /// Entries are evicted from the front of the queue.
+    /// Entries are evicted from the front of the queue. With segmented
+    /// policies this is the probationary segment.
     std::list<CacheItem*> evictionQueue;
 
+    /// Segmented policies only: entries that were accessed again while in the
+    /// probationary segment. Entries demoted from the front of this queue go
+    /// to the back of evictionQueue.
+    std::list<CacheItem*> protectedQueue;
+    size_t protectedSize{0};
+
+    /// TinyLFU only: recent access frequencies for admission decisions.
+    std::unique_ptr<FrequencySketch> sketch;
+
     uint64_t hitCount{0};
     uint64_t missCount{0};
     uint64_t evictionCount{0};
     uint64_t dropCount{0};
+    uint64_t probationHitCount{0};
+    uint64_t protectedHitCount{0};
+    uint64_t admissionRejectCount{0};
+    uint64_t pinnedEvictionCount{0};
+
+    /// Per-client accounting, see registerClient().
+    std::unordered_map<ClientId, ClientState> clients;
+    size_t registeredClientCount{0};
+
+    /// Objects evicted by the current insert, to be passed to the eviction
+    /// handler once the lock is released.
+    std::vector<ObjectPtr> evictedObjects;
   };
 
   /**
@@ -279,8 +501,35 @@ class ObjectCache
    */
   class LockedState {
    public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Samples the wait and hold times of the shard locks into the
+     * lock.object_cache stats, see InstrumentedMutex. The lock cannot be
+     * wrapped since DistributedMutex::unlock() takes the proxy returned by
+     * lock().
+     */
     LockedState(State& state, folly::DistributedMutex& lock)
-        : state_{state}, stateLock_{lock} {}
+        : state_{state},
+          waitStart_{shouldSampleLock() ? Clock::now() : Clock::time_point{}},
+          stateLock_{lock} {
+      if (UNLIKELY(waitStart_ != Clock::time_point{})) {
+        holdStart_ = Clock::now();
+        getLockStats().wait.addValue(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                holdStart_ - waitStart_)
+                .count());
+      }
+    }
+
+    ~LockedState() {
+      if (UNLIKELY(holdStart_ != Clock::time_point{})) {
+        getLockStats().hold.addValue(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - holdStart_)
+                .count());
+      }
+    }
 
     LockedState(const LockedState&) = delete;
     LockedState(LockedState&&) = delete;
@@ -296,12 +545,36 @@ class ObjectCache
     }
 
    private:
+    static LockContentionStats& getLockStats() {
+      static LockContentionStats stats{"object_cache"};
+      return stats;
+    }
+
     State& state_;
+    // Initialized before stateLock_ so that the wait for it can be timed.
+    Clock::time_point waitStart_;
+    Clock::time_point holdStart_;
     std::unique_lock<folly::DistributedMutex> stateLock_;
   };
 
-  LockedState lockState() const {
-    return LockedState{state_, stateLock_};
+  /**
+   * Each shard owns an independent slice of the cache. Shards are aligned to
+   * avoid false sharing between the locks of neighboring shards.
+   */
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    State state;
+    folly::DistributedMutex lock;
+  };
+
+  Shard& getShard(const ObjectId& hash) const;
+
+  LockedState lockState(const ObjectId& hash) const {
+    auto& shard = getShard(hash);
+    return LockedState{shard.state, shard.lock};
+  }
+
+  LockedState lockShard(Shard& shard) const {
+    return LockedState{shard.state, shard.lock};
   }
 
   /**
@@ -310,7 +583,8 @@ class ObjectCache
    *
    * Does not do anything related to interest handles.
    */
-  CacheItem* getImpl(const ObjectId& hash, LockedState& state);
+  CacheItem*
+  getImpl(const ObjectId& hash, LockedState& state, ClientId client);
 
   /**
    * Inserts an object into the cache for future lookup. If the new total size
@@ -319,20 +593,107 @@ class ObjectCache
    * duplicate insert) and a boolean indicating if this item was freshly
    * inserted (returns false if this is a duplicate insert).
    *
+   * If the admission filter rejects the object, returns nullptr and false.
+   *
    * Does not do anything related to InterestHandles
    */
-  std::pair<CacheItem*, bool> insertImpl(ObjectPtr object, LockedState& state);
+  std::pair<CacheItem*, bool>
+  insertImpl(ObjectPtr object, LockedState& state, ClientId client);
+
+  bool isSegmented() const {
+    return evictionPolicy_ != CacheEvictionPolicy::LRU;
+  }
+
+  /**
+   * Returns true if the TinyLFU admission filter decides that inserting an
+   * object with the given hash and size is not worth evicting the current
+   * eviction candidate for.
+   */
+  bool shouldRejectInsert(
+      const ObjectId& hash,
+      size_t size,
+      LockedState& state) const;
+
+  /**
+   * Move an item to the most recently used position of its segment, promoting
+   * it from the probationary to the protected segment when segmented.
+   */
+  void promote(LockedState& state, CacheItem* item) noexcept;
+
+  /**
+   * Remove an item from whichever eviction queue it is in.
+   */
+  void unlinkItem(LockedState& state, CacheItem* item) noexcept;
+
+  /**
+   * Returns the item that would be evicted next, or nullptr if empty.
+   */
+  CacheItem* evictionCandidate(LockedState& state) const noexcept;
+
+  /**
+   * Returns the item that evictUntilFits() should evict next: with more than
+   * one registered client, the least recently used among the first few
+   * entries of the queue charged to a client over its fair share, otherwise
+   * the eviction candidate.
+   */
+  CacheItem* fairEvictionCandidate(LockedState& state) const noexcept;
+
+  /**
+   * Returns the state of the given client in this shard, or nullptr for
+   * kNoClient and clients this cache does not know about.
+   */
+  ClientState* getClientState(LockedState& state, ClientId client)
+      const noexcept;
+
+  void chargeItem(LockedState& state, CacheItem* item) noexcept;
+
+  /**
+   * Registers the client with the given id. The large object tier uses the
+   * same client ids as the cache it belongs to.
+   */
+  void addClient(ClientId client);
+
+  bool isLargeObject(const ObjectType& object) const {
+    return largeObjectThresholdBytes_ != 0 &&
+        object.getSizeBytes() > largeObjectThresholdBytes_;
+  }
+
+  /**
+   * Counts a large object insert and returns the tier to insert it into, or
+   * nullptr if it should not be cached.
+   */
+  ObjectCache* admitLargeObject() noexcept;
 
   void dropInterestHandle(const ObjectId& hash, uint64_t generation) noexcept;
 
+  void handleEvictedObjects(std::vector<ObjectPtr> objects);
+
   void evictUntilFits(LockedState& state) noexcept;
   void evictOne(LockedState& state) noexcept;
   void evictItem(LockedState&, CacheItem* item) noexcept;
 
+  /// Per-shard limits: the configured totals divided across the shards.
   const size_t maximumCacheSizeBytes_;
   const size_t minimumEntryCount_;
-  mutable State state_;
-  mutable folly::DistributedMutex stateLock_;
+  const CacheEvictionPolicy evictionPolicy_;
+  /// Segmented policies only: the per-shard byte budget of the protected
+  /// segment.
+  const size_t maximumProtectedSizeBytes_;
+  mutable std::vector<Shard> shards_;
+  std::atomic<ClientId> nextClientId_{kNoClient + 1};
+
+  /// Objects larger than this go to largeObjects_, or are not cached at all.
+  /// 0 if there is no size threshold.
+  const size_t largeObjectThresholdBytes_;
+  /// The large object tier, null if large objects are not cached.
+  std::shared_ptr<ObjectCache> largeObjects_;
+  std::atomic<uint64_t> largeObjectAdmitCount_{0};
+  std::atomic<uint64_t> largeObjectRejectCount_{0};
+
+  EvictionHandler evictionHandler_;
+
+  /// Records the accesses to the cache if set, see setTrace().
+  std::shared_ptr<ObjectCacheTrace> trace_;
 
   friend class ObjectInterestHandle<ObjectType>;
 };
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ObjectCacheTrace.h"
+
+#include <fmt/core.h>
+#include <folly/Conv.h>
+#include <folly/String.h>
+#include <folly/hash/Hash.h>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr std::array<folly::StringPiece, 3> kOperationNames{
+    "hit",
+    "miss",
+    "insert"};
+} // namespace
+
+ObjectCacheTrace::ObjectCacheTrace(size_t capacity)
+    : start_{std::chrono::steady_clock::now()} {
+  events_.reserve(std::max<size_t>(capacity, 1));
+}
+
+void ObjectCacheTrace::record(
+    Operation operation,
+    const ObjectId& hash,
+    size_t sizeBytes) {
+  Event event{
+      0,
+      hashId(hash),
+      static_cast<uint32_t>(std::min<size_t>(
+          sizeBytes, std::numeric_limits<uint32_t>::max())),
+      operation};
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  // Taken under the lock so that the events are ordered by time.
+  event.timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - start_)
+                          .count();
+  if (events_.size() < events_.capacity()) {
+    events_.push_back(event);
+    return;
+  }
+  events_[next_] = event;
+  next_ = (next_ + 1) % events_.size();
+  ++droppedCount_;
+}
+
+std::vector<ObjectCacheTrace::Event> ObjectCacheTrace::getEvents() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  std::vector<Event> events;
+  events.reserve(events_.size());
+  events.insert(events.end(), events_.begin() + next_, events_.end());
+  events.insert(events.end(), events_.begin(), events_.begin() + next_);
+  return events;
+}
+
+uint64_t ObjectCacheTrace::getDroppedCount() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return droppedCount_;
+}
+
+void ObjectCacheTrace::write(AbsolutePathPiece path) const {
+  auto contents = serialize(getEvents());
+  writeFileAtomic(path, folly::ByteRange{folly::StringPiece{contents}}).value();
+}
+
+std::string ObjectCacheTrace::serialize(const std::vector<Event>& events) {
+  std::string out;
+  for (const auto& event : events) {
+    fmt::format_to(
+        std::back_inserter(out),
+        "{} {} {:016x} {}\n",
+        event.timestampUs,
+        operationName(event.operation),
+        event.id,
+        event.sizeBytes);
+  }
+  return out;
+}
+
+std::vector<ObjectCacheTrace::Event> ObjectCacheTrace::parse(
+    folly::StringPiece contents) {
+  std::vector<Event> events;
+  size_t lineNumber = 0;
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', contents, lines);
+  for (auto line : lines) {
+    ++lineNumber;
+    if (line.empty()) {
+      continue;
+    }
+    std::vector<folly::StringPiece> fields;
+    folly::split(' ', line, fields);
+    auto name = fields.size() == 4
+        ? std::find(kOperationNames.begin(), kOperationNames.end(), fields[1])
+        : kOperationNames.end();
+    if (name == kOperationNames.end()) {
+      throw std::invalid_argument(
+          fmt::format("line {}: malformed event \"{}\"", lineNumber, line));
+    }
+    try {
+      events.push_back(Event{
+          folly::to<uint64_t>(fields[0]),
+          std::stoull(fields[2].str(), nullptr, 16),
+          folly::to<uint32_t>(fields[3]),
+          Operation(name - kOperationNames.begin())});
+    } catch (const std::exception& ex) {
+      throw std::invalid_argument(
+          fmt::format("line {}: {}", lineNumber, ex.what()));
+    }
+  }
+  return events;
+}
+
+uint64_t ObjectCacheTrace::hashId(const ObjectId& hash) {
+  return folly::hash::twang_mix64(hash.getHashCode());
+}
+
+folly::StringPiece ObjectCacheTrace::operationName(Operation operation) {
+  return kOperationNames[static_cast<size_t>(operation)];
+}
+
+} // namespace facebook::eden
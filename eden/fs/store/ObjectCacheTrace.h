@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class ObjectId;
+
+/**
+ * A bounded record of the accesses to an ObjectCache, to be replayed offline
+ * by the object_cache_replay benchmark against other cache sizes and eviction
+ * policies.
+ *
+ * Each event is a fixed 24 bytes: object ids are reduced to a 64-bit hash,
+ * which keeps traces small and doesn't reveal the objects of the repository.
+ * Once capacity events are recorded, the oldest are overwritten.
+ *
+ * This class is thread safe. A single lock serializes the recording threads,
+ * so it is meant to be enabled while investigating, not left on.
+ */
+class ObjectCacheTrace {
+ public:
+  enum class Operation : uint8_t {
+    /** A lookup that found the object. */
+    Hit,
+    /** A lookup that didn't find the object. */
+    Miss,
+    /** An object was inserted, whether or not the cache admitted it. */
+    Insert,
+  };
+
+  struct Event {
+    /** Microseconds since the trace was created. */
+    uint64_t timestampUs;
+    uint64_t id;
+    /** The size of the object, 0 for misses. */
+    uint32_t sizeBytes;
+    Operation operation;
+  };
+
+  explicit ObjectCacheTrace(size_t capacity);
+
+  void record(Operation operation, const ObjectId& hash, size_t sizeBytes);
+
+  /**
+   * Returns the recorded events, oldest first.
+   */
+  std::vector<Event> getEvents() const;
+
+  /**
+   * Returns the number of events that were overwritten by newer ones.
+   */
+  uint64_t getDroppedCount() const;
+
+  /**
+   * Writes the recorded events to path as text, one
+   * "<timestamp_us> <operation> <id> <size>" line per event.
+   */
+  void write(AbsolutePathPiece path) const;
+
+  static std::string serialize(const std::vector<Event>& events);
+
+  /**
+   * Parses the contents of a trace written by write(). Throws
+   * std::invalid_argument on malformed lines.
+   */
+  static std::vector<Event> parse(folly::StringPiece contents);
+
+  static uint64_t hashId(const ObjectId& hash);
+
+  static folly::StringPiece operationName(Operation operation);
+
+ private:
+  const std::chrono::steady_clock::time_point start_;
+
+  mutable std::mutex mutex_;
+  std::vector<Event> events_;
+  /** The index in events_ of the next event once it is full. */
+  size_t next_{0};
+  uint64_t droppedCount_{0};
+};
+
+} // namespace facebook::eden
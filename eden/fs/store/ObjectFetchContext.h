@@ -6,6 +6,7 @@
  */
 
 #pragma once
+#include <chrono>
 #include <optional>
 
 #include <folly/Range.h>
@@ -52,6 +53,21 @@ class ObjectFetchContext {
     kOriginEnumMax,
   };
 
+  /**
+   * The stages of a fetch that report their duration to didFinishStage().
+   *
+   * Suitable for use as an index into an array of size kFetchStageEnumMax.
+   */
+  enum FetchStage : unsigned {
+    /** Looking the object up in the LocalStore */
+    LocalStore,
+    /** Waiting in the backing store's import queue */
+    ImportQueue,
+    /** Fetching the object from the backing store once dequeued */
+    BackingStoreFetch,
+    kFetchStageEnumMax,
+  };
+
   /**
    * Which interface caused this object fetch
    */
@@ -63,6 +79,12 @@ class ObjectFetchContext {
 
   virtual void didFetch(ObjectType, const ObjectId&, Origin) {}
 
+  /**
+   * Called by the stores once a fetch made on behalf of this context is done
+   * with a stage. May be called concurrently by arbitrary threads.
+   */
+  virtual void didFinishStage(FetchStage, std::chrono::nanoseconds) {}
+
   virtual std::optional<pid_t> getClientPid() const {
     return std::nullopt;
   }
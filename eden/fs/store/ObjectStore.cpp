@@ -12,6 +12,7 @@
 #include <folly/futures/Future.h>
 #include <folly/io/IOBuf.h>
 
+#include <algorithm>
 #include <stdexcept>
 
 #include "eden/fs/model/Blob.h"
@@ -19,6 +20,7 @@
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/TreeMetadata.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 
@@ -32,6 +34,46 @@ namespace facebook::eden {
 
 namespace {
 constexpr uint64_t kImportPriorityDeprioritizeAmount = 1;
+// A process's backing store fetches are charged one unit per this many bytes
+// on top of one unit per fetch when deciding to deprioritize it.
+constexpr uint64_t kFetchHeavyBytesPerUnit = 1024 * 1024;
+// However heavy its recent fetches, a process is deprioritized by at most
+// this many times kImportPriorityDeprioritizeAmount.
+constexpr uint64_t kMaxFetchHeavyDeprioritization = 4;
+} // namespace
+
+void PidFetchCounts::RecentFetches::record(
+    pid_t pid,
+    uint64_t bytes,
+    uint64_t bucket) {
+  if (pids.size() >= pruneAt) {
+    for (auto it = pids.begin(); it != pids.end();) {
+      if (it->second.lastBucket + kRateBucketCount <= bucket) {
+        it = pids.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    pruneAt = std::max(kMinPruneSize, 2 * pids.size());
+  }
+  auto& pidLog = pids[pid];
+  pidLog.log.add(bucket, bytes);
+  pidLog.lastBucket = std::max(pidLog.lastBucket, bucket);
+}
+
+BackingStoreFetches PidFetchCounts::RecentFetches::get(
+    pid_t pid,
+    uint64_t bucket) {
+  BackingStoreFetches total;
+  auto it = pids.find(pid);
+  if (it == pids.end()) {
+    return total;
+  }
+  for (const auto& rateBucket : it->second.log.getAll(bucket)) {
+    total.count += rateBucket.fetches.count;
+    total.bytes += rateBucket.fetches.bytes;
+  }
+  return total;
 }
 
 std::shared_ptr<ObjectStore> ObjectStore::create(
@@ -63,8 +105,15 @@ ObjectStore::ObjectStore(
     std::shared_ptr<ProcessNameCache> processNameCache,
     std::shared_ptr<StructuredLogger> structuredLogger,
     std::shared_ptr<const EdenConfig> edenConfig)
-    : metadataCache_{folly::in_place, kCacheSize},
+    : metadataCache_{
+          kCacheSize,
+          edenConfig ? edenConfig->blobMetadataCacheShards.getValue() : 1},
+      blobContentIndex_{
+          edenConfig && edenConfig->enableBlobDeduplication.getValue()
+              ? std::make_unique<BlobContentIndex>(kBlobContentIndexSize)
+              : nullptr},
       treeCache_{std::move(treeCache)},
+      treeCacheClient_{treeCache_->registerClient()},
       localStore_{std::move(localStore)},
       backingStore_{std::move(backingStore)},
       stats_{std::move(stats)},
@@ -74,7 +123,9 @@ ObjectStore::ObjectStore(
       structuredLogger_(structuredLogger),
       edenConfig_(edenConfig) {}
 
-ObjectStore::~ObjectStore() {}
+ObjectStore::~ObjectStore() {
+  treeCache_->unregisterClient(treeCacheClient_);
+}
 
 void ObjectStore::updateProcessFetch(
     const ObjectFetchContext& fetchContext) const {
@@ -87,6 +138,18 @@ void ObjectStore::updateProcessFetch(
   }
 }
 
+void ObjectStore::updateProcessBackingStoreFetch(
+    const ObjectFetchContext& fetchContext,
+    ObjectFetchContext::Origin origin,
+    uint64_t bytes) const {
+  if (origin != ObjectFetchContext::FromNetworkFetch) {
+    return;
+  }
+  if (auto pid = fetchContext.getClientPid()) {
+    pidFetchCounts_->recordBackingStoreFetch(pid.value(), bytes);
+  }
+}
+
 void ObjectStore::sendFetchHeavyEvent(pid_t pid, uint64_t fetch_count) const {
   auto processName = processNameCache_->getSpacedProcessName(pid);
   if (processName.has_value()) {
@@ -99,10 +162,16 @@ void ObjectStore::deprioritizeWhenFetchHeavy(
     ObjectFetchContext& context) const {
   auto pid = context.getClientPid();
   if (pid.has_value()) {
-    auto fetch_count = pidFetchCounts_->getCountByPid(pid.value());
-    auto threshold = edenConfig_->fetchHeavyThreshold.getValue();
-    if (threshold && fetch_count >= threshold) {
-      context.deprioritize(kImportPriorityDeprioritizeAmount);
+    auto threshold = edenConfig_->fetchHeavyRateThreshold.getValue();
+    if (!threshold) {
+      return;
+    }
+    auto fetches =
+        pidFetchCounts_->getRecentBackingStoreFetchesByPid(pid.value());
+    auto cost = fetches.count + fetches.bytes / kFetchHeavyBytesPerUnit;
+    auto steps = std::min(cost / threshold, kMaxFetchHeavyDeprioritization);
+    if (steps) {
+      context.deprioritize(steps * kImportPriorityDeprioritizeAmount);
     }
   }
 }
@@ -122,13 +191,14 @@ Future<shared_ptr<const Tree>> ObjectStore::getRootTree(
   return backingStore_->getRootTree(rootId, context)
       .via(executor_)
       .thenValue(
-          [treeCache = treeCache_, rootId](std::shared_ptr<const Tree> tree) {
+          [treeCache = treeCache_, client = treeCacheClient_, rootId](
+              std::shared_ptr<const Tree> tree) {
             if (!tree) {
               throw std::domain_error(
                   folly::to<string>("unable to import root ", rootId));
             }
 
-            treeCache->insert(tree);
+            treeCache->insert(tree, client);
 
             return tree;
           });
@@ -163,7 +233,7 @@ ImmediateFuture<shared_ptr<const Tree>> ObjectStore::getTree(
   // request. If we we're to mark here that we got a request on this layer, then
   // we could avoid that case.
 
-  if (auto maybeTree = treeCache_->get(id)) {
+  if (auto maybeTree = treeCache_->get(id, treeCacheClient_)) {
     fetchContext.didFetch(
         ObjectFetchContext::Tree, id, ObjectFetchContext::FromMemoryCache);
 
@@ -174,27 +244,57 @@ ImmediateFuture<shared_ptr<const Tree>> ObjectStore::getTree(
 
   deprioritizeWhenFetchHeavy(fetchContext);
 
-  return backingStore_->getTree(id, fetchContext)
-      .via(executor_)
-      .thenValue([self = shared_from_this(), id, &fetchContext](
-                     BackingStore::GetTreeRes result) {
-        if (!result.tree) {
-          // TODO: Perhaps we should do some short-term negative
-          // caching?
-          XLOG(DBG2) << "unable to find tree " << id;
-          throw std::domain_error(fmt::format("tree {} not found", id));
-        }
+  auto processTree = [self = shared_from_this(), id, &fetchContext](
+                         BackingStore::GetTreeRes result) {
+    if (!result.tree) {
+      // TODO: Perhaps we should do some short-term negative
+      // caching?
+      XLOG(DBG2) << "unable to find tree " << id;
+      throw std::domain_error(fmt::format("tree {} not found", id));
+    }
 
-        // promote to shared_ptr so we can store in the cache and return
-        auto sharedTree = std::shared_ptr<const Tree>(std::move(result.tree));
-        self->treeCache_->insert(sharedTree);
-        fetchContext.didFetch(ObjectFetchContext::Tree, id, result.origin);
-        self->updateProcessFetch(fetchContext);
-        return sharedTree;
-      })
+    // promote to shared_ptr so we can store in the cache and return
+    auto sharedTree = std::shared_ptr<const Tree>(std::move(result.tree));
+    self->treeCache_->insert(sharedTree, self->treeCacheClient_);
+    self->putTreeEntryMetadata(*sharedTree);
+    fetchContext.didFetch(ObjectFetchContext::Tree, id, result.origin);
+    self->updateProcessFetch(fetchContext);
+    self->updateProcessBackingStoreFetch(
+        fetchContext, result.origin, sharedTree->getSizeBytes());
+    return sharedTree;
+  };
+
+  auto treeFuture = backingStore_->getTree(id, fetchContext);
+  if (treeFuture.isReady()) {
+    // The backing store had the tree locally: process it inline rather than
+    // allocating a Future core and hopping through executor_.
+    return ImmediateFuture<BackingStore::GetTreeRes>{std::move(treeFuture)}
+        .thenValue(std::move(processTree));
+  }
+  return std::move(treeFuture)
+      .via(executor_)
+      .thenValue(std::move(processTree))
       .semi();
 }
 
+void ObjectStore::putTreeEntryMetadata(const Tree& tree) const {
+  TreeMetadata::HashIndexedEntryMetadata entries;
+  for (const auto& entry : tree.getTreeEntries()) {
+    // Trees read back from the LocalStore do not carry the metadata, and
+    // the backing store may only know it for some of the entries.
+    const auto& size = entry.getSize();
+    const auto& sha1 = entry.getContentSha1();
+    if (entry.isTree() || !size.has_value() || !sha1.has_value()) {
+      continue;
+    }
+    entries.emplace_back(entry.getHash(), BlobMetadata{*sha1, *size});
+  }
+  if (entries.empty()) {
+    return;
+  }
+  localStore_->putTreeMetadata(TreeMetadata{std::move(entries)}, tree);
+}
+
 folly::Future<folly::Unit> ObjectStore::prefetchBlobs(
     ObjectIdRange ids,
     ObjectFetchContext& fetchContext) const {
@@ -212,30 +312,95 @@ folly::Future<folly::Unit> ObjectStore::prefetchBlobs(
   return backingStore_->prefetchBlobs(ids, fetchContext).via(executor_);
 }
 
+Future<ObjectStore::BlobFetch> ObjectStore::fetchBlob(
+    const ObjectId& id,
+    ObjectFetchContext& context,
+    bool storeBlob) const {
+  auto priority = context.getPriority();
+  std::shared_ptr<PendingBlobFetch> pending;
+  {
+    auto pendingFetches = pendingBlobFetches_.wlock();
+    auto [it, inserted] = pendingFetches->try_emplace(id);
+    if (!inserted) {
+      if (!(it->second->priority < priority)) {
+        return it->second->promise.getFuture();
+      }
+      // Leave the import in flight alone, our own request will raise its
+      // priority in the backing store.
+    } else {
+      it->second = std::make_shared<PendingBlobFetch>();
+      it->second->priority = priority;
+      pending = it->second;
+    }
+  }
+
+  auto processBlob = [self = shared_from_this(), id, pending, storeBlob](
+                         folly::Try<BackingStore::GetBlobRes>&& result) {
+    auto fetch = folly::makeTryWith([&] {
+      auto& blob = result.value().blob;
+      if (!blob) {
+        // TODO: Perhaps we should do some short-term negative caching?
+        XLOG(DBG2) << "unable to find blob " << id;
+        throw std::domain_error(fmt::format("blob {} not found", id));
+      }
+      // Quick check in-memory cache first, before doing expensive
+      // calculations. If metadata is present in cache, it most certainly
+      // exists in local store too
+      auto metadata = self->metadataCache_.get(id);
+      if (!metadata) {
+        metadata = self->localStore_->putBlobMetadata(id, blob.get());
+        self->metadataCache_.set(id, *metadata);
+      }
+      auto& stats = self->stats_->getObjectStoreStatsForCurrentThread();
+      if (storeBlob &&
+          self->localStore_->putBlob(id, blob.get(), &*metadata)) {
+        stats.blobDeduplicatedOnDisk.addValue(metadata->size);
+      }
+      std::shared_ptr<const Blob> sharedBlob{std::move(blob)};
+      if (self->blobContentIndex_) {
+        auto interned = self->blobContentIndex_->intern(
+            std::move(sharedBlob), metadata->sha1);
+        if (interned.deduplicated) {
+          stats.blobDeduplicatedInMemory.addValue(metadata->size);
+        }
+        sharedBlob = std::move(interned.blob);
+      }
+      return BlobFetch{
+          std::move(sharedBlob), *metadata, result.value().origin};
+    });
+    if (pending) {
+      // Later fetches must not join this one once its promise is fulfilled.
+      self->pendingBlobFetches_.wlock()->erase(id);
+      pending->promise.setTry(folly::Try<BlobFetch>{fetch});
+    }
+    return std::move(fetch).value();
+  };
+
+  auto blobFuture = folly::makeSemiFutureWith(
+      [&] { return backingStore_->getBlob(id, context); });
+  if (blobFuture.isReady()) {
+    // The backing store had the blob locally: process it inline, and let the
+    // caller's continuations run inline too, rather than hopping through
+    // executor_.
+    return std::move(blobFuture).toUnsafeFuture().thenTry(
+        std::move(processBlob));
+  }
+  return std::move(blobFuture).via(executor_).thenTry(std::move(processBlob));
+}
+
 Future<shared_ptr<const Blob>> ObjectStore::getBlob(
     const ObjectId& id,
     ObjectFetchContext& fetchContext) const {
   deprioritizeWhenFetchHeavy(fetchContext);
-  return backingStore_->getBlob(id, fetchContext)
-      .via(executor_)
+
+  return fetchBlob(id, fetchContext, /*storeBlob=*/false)
       .thenValue([self = shared_from_this(), id, &fetchContext](
-                     BackingStore::GetBlobRes result) {
-        if (!result.blob) {
-          // TODO: Perhaps we should do some short-term negative caching?
-          XLOG(DBG2) << "unable to find blob " << id;
-          throw std::domain_error(fmt::format("blob {} not found", id));
-        }
-        // Quick check in-memory cache first, before doing expensive
-        // calculations. If metadata is present in cache, it most certainly
-        // exists in local store too
-        if (!self->metadataCache_.rlock()->exists(id)) {
-          auto metadata =
-              self->localStore_->putBlobMetadata(id, result.blob.get());
-          self->metadataCache_.wlock()->set(id, metadata);
-        }
+                     BlobFetch fetch) {
         self->updateProcessFetch(fetchContext);
-        fetchContext.didFetch(ObjectFetchContext::Blob, id, result.origin);
-        return std::move(result.blob);
+        self->updateProcessBackingStoreFetch(
+            fetchContext, fetch.origin, fetch.metadata.size);
+        fetchContext.didFetch(ObjectFetchContext::Blob, id, fetch.origin);
+        return std::move(fetch.blob);
       });
 }
 
@@ -243,20 +408,16 @@ ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadata(
     const ObjectId& id,
     ObjectFetchContext& context) const {
   // Check in-memory cache
-  {
-    auto metadataCache = metadataCache_.wlock();
-    auto cacheIter = metadataCache->find(id);
-    if (cacheIter != metadataCache->end()) {
-      stats_->getObjectStoreStatsForCurrentThread()
-          .getBlobMetadataFromMemory.addValue(1);
-      context.didFetch(
-          ObjectFetchContext::BlobMetadata,
-          id,
-          ObjectFetchContext::FromMemoryCache);
-
-      updateProcessFetch(context);
-      return cacheIter->second;
-    }
+  if (auto metadata = metadataCache_.get(id)) {
+    stats_->getObjectStoreStatsForCurrentThread()
+        .getBlobMetadataFromMemory.addValue(1);
+    context.didFetch(
+        ObjectFetchContext::BlobMetadata,
+        id,
+        ObjectFetchContext::FromMemoryCache);
+
+    updateProcessFetch(context);
+    return *metadata;
   }
 
   auto self = shared_from_this();
@@ -267,7 +428,7 @@ ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadata(
         if (metadata) {
           self->stats_->getObjectStoreStatsForCurrentThread()
               .getBlobMetadataFromLocalStore.addValue(1);
-          self->metadataCache_.wlock()->set(id, *metadata);
+          self->metadataCache_.set(id, *metadata);
           context.didFetch(
               ObjectFetchContext::BlobMetadata,
               id,
@@ -287,29 +448,22 @@ ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadata(
         //
         // TODO: This should probably check the LocalStore for the blob first,
         // especially when we begin to expire entries in RocksDB.
-        return self->backingStore_->getBlob(id, context)
-            .via(self->executor_)
-            .thenValue([self, id, &context](BackingStore::GetBlobRes result) {
-              if (result.blob) {
-                self->stats_->getObjectStoreStatsForCurrentThread()
-                    .getBlobMetadataFromBackingStore.addValue(1);
-                self->localStore_->putBlob(id, result.blob.get());
-                auto metadata =
-                    self->localStore_->putBlobMetadata(id, result.blob.get());
-                self->metadataCache_.wlock()->set(id, metadata);
-                // I could see an argument for recording this fetch with
-                // type Blob instead of BlobMetadata, but it's probably more
-                // useful in context to know how many metadata fetches
-                // occurred. Also, since backing stores don't directly
-                // support fetching metadata, it should be clear.
-                context.didFetch(
-                    ObjectFetchContext::BlobMetadata, id, result.origin);
-
-                self->updateProcessFetch(context);
-                return makeFuture(metadata);
-              }
-
-              throw std::domain_error(fmt::format("blob {} not fonud", id));
+        return self->fetchBlob(id, context, /*storeBlob=*/true)
+            .thenValue([self, id, &context](BlobFetch fetch) {
+              self->stats_->getObjectStoreStatsForCurrentThread()
+                  .getBlobMetadataFromBackingStore.addValue(1);
+              // I could see an argument for recording this fetch with
+              // type Blob instead of BlobMetadata, but it's probably more
+              // useful in context to know how many metadata fetches
+              // occurred. Also, since backing stores don't directly
+              // support fetching metadata, it should be clear.
+              context.didFetch(
+                  ObjectFetchContext::BlobMetadata, id, fetch.origin);
+
+              self->updateProcessFetch(context);
+              self->updateProcessBackingStoreFetch(
+                  context, fetch.origin, fetch.metadata.size);
+              return fetch.metadata;
             });
       })
       .semi();
@@ -322,6 +476,28 @@ ImmediateFuture<Hash20> ObjectStore::getBlobSha1(
       .thenValue([](const BlobMetadata& metadata) { return metadata.sha1; });
 }
 
+ImmediateFuture<Blake3Hash> ObjectStore::getBlobBlake3(
+    const ObjectId& id,
+    ObjectFetchContext& context) const {
+  auto self = shared_from_this();
+  return getBlobMetadata(id, context)
+      .thenValue([self, id, &context](BlobMetadata&& metadata)
+                     -> ImmediateFuture<Blake3Hash> {
+        if (metadata.blake3.has_value()) {
+          return *metadata.blake3;
+        }
+        return self->getBlob(id, context)
+            .thenValue([self, id, metadata = std::move(metadata)](
+                           std::shared_ptr<const Blob> blob) mutable {
+              metadata.blake3 = Blake3::hash(blob->getContents());
+              self->localStore_->putBlobMetadata(id, metadata);
+              self->metadataCache_.set(id, metadata);
+              return *metadata.blake3;
+            })
+            .semi();
+      });
+}
+
 ImmediateFuture<uint64_t> ObjectStore::getBlobSize(
     const ObjectId& id,
     ObjectFetchContext& context) const {
@@ -9,7 +9,9 @@
 
 #include <folly/Executor.h>
 #include <folly/Synchronized.h>
-#include <folly/container/EvictingCacheMap.h>
+#include <folly/container/F14Map.h>
+#include <folly/futures/SharedPromise.h>
+#include <chrono>
 #include <memory>
 #include <unordered_map>
 
@@ -17,13 +19,16 @@
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/RootId.h"
+#include "eden/fs/store/BlobContentIndex.h"
 #include "eden/fs/store/BlobMetadata.h"
+#include "eden/fs/store/BlobMetadataCache.h"
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/TreeCache.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
+#include "eden/fs/utils/BucketedLog.h"
 #include "eden/fs/utils/ProcessNameCache.h"
 
 namespace facebook::eden {
@@ -33,8 +38,26 @@ class Blob;
 class LocalStore;
 class Tree;
 
+/**
+ * The fetches of a process that missed every cache and had to be imported
+ * from the backing store, which is what other processes wait behind.
+ */
+struct BackingStoreFetches {
+  uint64_t count{0};
+  uint64_t bytes{0};
+};
+
 struct PidFetchCounts {
+  /**
+   * Recent backing store fetches are kept in kRateBucketCount buckets of
+   * kRateBucketWidth each, about a minute in total.
+   */
+  static constexpr uint64_t kRateBucketCount = 16;
+  static constexpr std::chrono::seconds kRateBucketWidth{4};
+
   folly::Synchronized<std::unordered_map<pid_t, uint64_t>> map_;
+  folly::Synchronized<std::unordered_map<pid_t, BackingStoreFetches>>
+      backingStoreFetches_;
 
   uint64_t recordProcessFetch(pid_t pid) {
     auto map_lock = map_.wlock();
@@ -42,8 +65,36 @@ struct PidFetchCounts {
     return fetch_count;
   }
 
+  void recordBackingStoreFetch(
+      pid_t pid,
+      uint64_t bytes,
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now()) {
+    {
+      auto fetches = backingStoreFetches_.wlock();
+      auto& pidFetches = (*fetches)[pid];
+      ++pidFetches.count;
+      pidFetches.bytes += bytes;
+    }
+    recentFetches_.wlock()->record(pid, bytes, getRateBucket(now));
+  }
+
+  /**
+   * The backing store fetches of pid over the last minute or so. Unlike
+   * getBackingStoreFetchesByPid(), these fall back to nothing once the
+   * process stops fetching.
+   */
+  BackingStoreFetches getRecentBackingStoreFetchesByPid(
+      pid_t pid,
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now()) {
+    return recentFetches_.wlock()->get(pid, getRateBucket(now));
+  }
+
   void clear() {
     map_.wlock()->clear();
+    backingStoreFetches_.wlock()->clear();
+    recentFetches_.wlock()->clear();
   }
 
   uint64_t getCountByPid(pid_t pid) {
@@ -55,6 +106,59 @@ struct PidFetchCounts {
       return 0;
     }
   }
+
+  BackingStoreFetches getBackingStoreFetchesByPid(pid_t pid) {
+    auto fetches = backingStoreFetches_.rlock();
+    auto it = fetches->find(pid);
+    return it != fetches->end() ? it->second : BackingStoreFetches{};
+  }
+
+ private:
+  struct RateBucket {
+    void add(uint64_t bytes) {
+      ++fetches.count;
+      fetches.bytes += bytes;
+    }
+    void merge(const RateBucket& other) {
+      fetches.count += other.fetches.count;
+      fetches.bytes += other.fetches.bytes;
+    }
+    void clear() {
+      fetches = BackingStoreFetches{};
+    }
+
+    BackingStoreFetches fetches;
+  };
+
+  struct RecentFetches {
+    struct PidLog {
+      BucketedLog<RateBucket, kRateBucketCount> log;
+      uint64_t lastBucket{0};
+    };
+
+    void record(pid_t pid, uint64_t bytes, uint64_t bucket);
+    BackingStoreFetches get(pid_t pid, uint64_t bucket);
+    void clear() {
+      pids.clear();
+      pruneAt = kMinPruneSize;
+    }
+
+    /**
+     * Processes come and go, so the logs of the ones that haven't fetched
+     * anything for a whole window are dropped whenever the map has grown to
+     * pruneAt entries.
+     */
+    static constexpr size_t kMinPruneSize = 256;
+
+    std::unordered_map<pid_t, PidLog> pids;
+    size_t pruneAt{kMinPruneSize};
+  };
+
+  static uint64_t getRateBucket(std::chrono::steady_clock::time_point now) {
+    return static_cast<uint64_t>(now.time_since_epoch() / kRateBucketWidth);
+  }
+
+  folly::Synchronized<RecentFetches> recentFetches_;
 };
 
 /**
@@ -89,6 +193,16 @@ class ObjectStore : public IObjectStore,
    */
   void updateProcessFetch(const ObjectFetchContext& fetchContext) const;
 
+  /**
+   * When pid of fetchContext is available and the object had to be fetched
+   * from the backing store, charges the fetch and its size in bytes to the
+   * process.
+   */
+  void updateProcessBackingStoreFetch(
+      const ObjectFetchContext& fetchContext,
+      ObjectFetchContext::Origin origin,
+      uint64_t bytes) const;
+
   /**
    * send a FetchHeavy log event to Scuba. If either processNameCache_
    * or structuredLogger_ is nullptr, this function does nothing.
@@ -96,9 +210,17 @@ class ObjectStore : public IObjectStore,
   void sendFetchHeavyEvent(pid_t pid, uint64_t fetch_count) const;
 
   /**
-   * Check fetch count of the process using this fetchContext before using
-   * the fetchContext in BackingStore. if fetchHeavyThreshold in edenConfig_ is
-   * exceeded, deprioritize the fetchContext by 1.
+   * Check the recent import cost of the process using this fetchContext
+   * before using the fetchContext in BackingStore. The fetchContext is
+   * deprioritized by 1 for each fetchHeavyRateThreshold in edenConfig_ the
+   * process was charged over the last minute, up to
+   * kMaxFetchHeavyDeprioritization. A process that stops fetching so much is
+   * no longer deprioritized a minute later.
+   *
+   * A process is charged one unit for each of its fetches that went to the
+   * backing store, plus one for each MiB they returned. Fetches served from
+   * the caches are not charged, since they do not hold up anyone else's
+   * imports.
    *
    * Note: Normally, one fetchContext is created for only one fetch request,
    * so deprioritize() should only be called once by one thread, but that is
@@ -190,6 +312,17 @@ class ObjectStore : public IObjectStore,
       const ObjectId& id,
       ObjectFetchContext& context) const;
 
+  /**
+   * Returns the BLAKE3 hash of the contents of the blob with the given ID.
+   *
+   * BLAKE3 hashes are computed on demand, from the blob contents, the first
+   * time they are requested, and then stored with the rest of the blob
+   * metadata.
+   */
+  ImmediateFuture<Blake3Hash> getBlobBlake3(
+      const ObjectId& id,
+      ObjectFetchContext& context) const;
+
   /**
    * Get the LocalStore used by this ObjectStore
    */
@@ -204,10 +337,23 @@ class ObjectStore : public IObjectStore,
     return backingStore_;
   }
 
+  /**
+   * Returns the accounting of the trees this ObjectStore loaded into the
+   * TreeCache, which is shared with the other mounts.
+   */
+  TreeCache::ClientStats getTreeCacheStats() const {
+    return treeCache_->getClientStats(treeCacheClient_);
+  }
+
   folly::Synchronized<std::unordered_map<pid_t, uint64_t>>& getPidFetches() {
     return pidFetchCounts_->map_;
   }
 
+  folly::Synchronized<std::unordered_map<pid_t, BackingStoreFetches>>&
+  getPidBackingStoreFetches() {
+    return pidFetchCounts_->backingStoreFetches_;
+  }
+
   void clearFetchCounts() {
     pidFetchCounts_->clear();
   }
@@ -227,6 +373,50 @@ class ObjectStore : public IObjectStore,
   ObjectStore(ObjectStore const&) = delete;
   ObjectStore& operator=(ObjectStore const&) = delete;
 
+  /**
+   * Store the size and SHA-1 that the backing store imported along with the
+   * entries of a Tree as the metadata of those blobs, so that stat and status
+   * of files that were never read do not need to fetch their contents.
+   *
+   * Only the LocalStore is populated; the in-memory metadata cache is left for
+   * the blobs that are actually looked up.
+   */
+  void putTreeEntryMetadata(const Tree& tree) const;
+
+  /**
+   * The result of importing a blob from the backing store, shared by all the
+   * callers waiting for it.
+   */
+  struct BlobFetch {
+    std::shared_ptr<const Blob> blob;
+    BlobMetadata metadata;
+    ObjectFetchContext::Origin origin;
+  };
+
+  /**
+   * A blob import in flight, and the priority it was requested with.
+   */
+  struct PendingBlobFetch {
+    folly::SharedPromise<BlobFetch> promise;
+    ImportPriority priority;
+  };
+
+  /**
+   * Imports a blob from the backing store and records its metadata.
+   *
+   * Concurrent getBlob and getBlobMetadata calls for the same blob share a
+   * single import and a single metadata computation. A caller with a higher
+   * priority than the import in flight issues its own request, so that the
+   * backing store can bump the priority of the import.
+   *
+   * If storeBlob is set, the blob is also written to the LocalStore by the
+   * caller that started the import.
+   */
+  folly::Future<BlobFetch> fetchBlob(
+      const ObjectId& id,
+      ObjectFetchContext& context,
+      bool storeBlob) const;
+
   /**
    * Get metadata about a Blob.
    *
@@ -239,6 +429,8 @@ class ObjectStore : public IObjectStore,
       ObjectFetchContext& context) const;
 
   static constexpr size_t kCacheSize = 1000000;
+  // Each entry holds a SHA-1 and a weak reference to a blob.
+  static constexpr size_t kBlobContentIndexSize = 100000;
 
   /**
    * During status and checkout, it's common to look up the SHA-1 for a given
@@ -251,11 +443,23 @@ class ObjectStore : public IObjectStore,
    * depending on whether the node fits cleanly into one of jemalloc's size
    * classes.
    *
-   * TODO: It never makes sense to rlock an LRU cache, since cache hits mutate
-   * the data structure. Thus, should we use a more appropriate type of lock?
+   * The cache is sharded, see store:metadata-cache-shards, so that stat-heavy
+   * workloads do not serialize on a single lock.
+   */
+  mutable BlobMetadataCache metadataCache_;
+
+  /**
+   * Lets the fetched blobs with identical contents share their buffer, null
+   * unless experimental:enable-blob-deduplication is set.
+   */
+  std::unique_ptr<BlobContentIndex> blobContentIndex_;
+
+  /**
+   * The blob imports in flight, see fetchBlob().
    */
-  mutable folly::Synchronized<folly::EvictingCacheMap<ObjectId, BlobMetadata>>
-      metadataCache_;
+  mutable folly::Synchronized<
+      folly::F14FastMap<ObjectId, std::shared_ptr<PendingBlobFetch>>>
+      pendingBlobFetches_;
 
   /**
    * During glob, we need to read a lot of trees, but we avoid loading inodes,
@@ -269,6 +473,7 @@ class ObjectStore : public IObjectStore,
    * approach the size limit of the cache.)
    */
   const std::shared_ptr<TreeCache> treeCache_;
+  const TreeCache::ClientId treeCacheClient_;
 
   /*
    * The LocalStore.
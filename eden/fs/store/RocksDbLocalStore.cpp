@@ -7,8 +7,11 @@
 
 #include "eden/fs/store/RocksDbLocalStore.h"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <limits>
+#include <stdexcept>
 
 #include <fb303/ServiceData.h>
 #include <folly/Format.h>
@@ -20,15 +23,20 @@
 #include <folly/logging/xlog.h>
 #include <rocksdb/convenience.h>
 #include <rocksdb/db.h>
+#include <rocksdb/env.h>
 #include <rocksdb/filter_policy.h>
+#include <rocksdb/statistics.h>
 #include <rocksdb/table.h>
+#include <rocksdb/write_batch.h>
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/rocksdb/RocksException.h"
 #include "eden/fs/rocksdb/RocksHandles.h"
 #include "eden/fs/store/KeySpace.h"
 #include "eden/fs/store/StoreResult.h"
+#include "eden/fs/store/WriteBehindQueue.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
+#include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/FaultInjector.h"
 
 using folly::ByteRange;
@@ -43,7 +51,29 @@ using std::chrono::duration_cast;
 namespace {
 using namespace facebook::eden;
 
-rocksdb::ColumnFamilyOptions makeColumnOptions(uint64_t LRUblockCacheSizeMB) {
+rocksdb::CompressionType parseCompression(
+    const std::string& name,
+    rocksdb::CompressionType defaultType) {
+  if (name.empty()) {
+    return defaultType;
+  } else if (name == "none") {
+    return rocksdb::kNoCompression;
+  } else if (name == "snappy") {
+    return rocksdb::kSnappyCompression;
+  } else if (name == "lz4") {
+    return rocksdb::kLZ4Compression;
+  } else if (name == "zstd") {
+    return rocksdb::kZSTD;
+  }
+  XLOG(WARN) << "unknown RocksDB compression type \"" << name
+             << "\", using the default";
+  return defaultType;
+}
+
+rocksdb::ColumnFamilyOptions makeColumnOptions(
+    uint64_t LRUblockCacheSizeMB,
+    const std::string& compression,
+    bool memtableBloomFilter) {
   rocksdb::ColumnFamilyOptions options;
 
   // We'll never perform range scans on any of the keys that we store.
@@ -52,22 +82,111 @@ rocksdb::ColumnFamilyOptions makeColumnOptions(uint64_t LRUblockCacheSizeMB) {
   options.OptimizeForPointLookup(LRUblockCacheSizeMB);
 
   options.OptimizeLevelStyleCompaction();
+  options.compression = parseCompression(compression, options.compression);
+
+  // Not all of our keys are 20-byte hashes, so filter on the whole key rather
+  // than a fixed-length prefix.
+  if (memtableBloomFilter) {
+    options.memtable_whole_key_filtering = true;
+    options.memtable_prefix_bloom_size_ratio = 0.02;
+  }
   return options;
 }
 
+/**
+ * Ephemeral key spaces are stored in two column families, one per generation,
+ * so that garbage collection can drop the objects that were not read since
+ * the previous collection instead of the whole key space. Generation 0 is the
+ * key space's own column family and generation 1 the one with this suffix.
+ */
+constexpr folly::StringPiece kSecondGenerationSuffix{"-gen1"};
+
+/**
+ * The default column family follows the KeySpace ones, and the second
+ * generation column families follow it in KeySpace::kAll order.
+ */
+constexpr size_t kDefaultColumn = KeySpace::kTotalCount;
+constexpr size_t kFirstSecondGenerationColumn = kDefaultColumn + 1;
+
+using Generations = std::array<std::atomic<uint8_t>, KeySpace::kTotalCount>;
+
+/**
+ * Returns the position of the second generation column family of keySpace
+ * among the second generation column families, or std::nullopt if keySpace
+ * only has one generation.
+ */
+std::optional<size_t> getSecondGenerationOrdinal(KeySpace keySpace) {
+  if (!keySpace->isEphemeral()) {
+    return std::nullopt;
+  }
+  size_t ordinal = 0;
+  for (auto& ks : KeySpace::kAll) {
+    if (ks->index == keySpace->index) {
+      return ordinal;
+    }
+    if (ks->isEphemeral()) {
+      ++ordinal;
+    }
+  }
+  EDEN_BUG() << "key space " << keySpace->name << " is not in KeySpace::kAll";
+}
+
+rocksdb::ColumnFamilyHandle* getColumn(
+    const RocksHandles& handles,
+    KeySpace keySpace,
+    uint8_t generation) {
+  if (generation == 0) {
+    return handles.columns[keySpace->index].get();
+  }
+  auto ordinal = getSecondGenerationOrdinal(keySpace);
+  XCHECK(ordinal.has_value());
+  return handles.columns[kFirstSecondGenerationColumn + *ordinal].get();
+}
+
+/**
+ * The key under which the default column family records the current
+ * generation of keySpace.
+ */
+std::string getGenerationKey(KeySpace keySpace) {
+  return folly::to<std::string>("generation:", keySpace->name);
+}
+
 /**
  * The different key spaces that we desire.
  * The ordering is coupled with the values of the KeySpace enum.
+ *
+ * A null config opens the column families with the default settings.
  */
 const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
     const rocksdb::DBOptions& db_options,
-    const std::string& name) {
+    const std::string& name,
+    const EdenConfig* config) {
   // Most of the column families will share the same cache.  We
   // want the blob data to live in its own smaller cache; the assumption
   // is that the vfs cache will compensate for that, together with the
   // idea that we shouldn't need to materialize a great many files.
-  auto options = makeColumnOptions(64);
-  auto blobOptions = makeColumnOptions(8);
+  auto memtableBloomFilter =
+      config ? config->rocksDbMemtableBloomFilter.getValue() : false;
+  auto options = makeColumnOptions(
+      config ? config->rocksDbBlockCacheSizeMB.getValue() : 64,
+      config ? config->rocksDbCompression.getValue() : "",
+      memtableBloomFilter);
+  auto blobOptions = makeColumnOptions(
+      config ? config->rocksDbBlobBlockCacheSizeMB.getValue() : 8,
+      config ? config->rocksDbBlobCompression.getValue() : "",
+      memtableBloomFilter);
+  if (auto dictionarySize = config
+          ? config->rocksDbBlobCompressionDictionarySize.getValue()
+          : 0;
+      dictionarySize > 0) {
+    // zstd trains the dictionary from samples of the file's data blocks,
+    // collected up to the recommended 100 times the dictionary size.
+    blobOptions.compression_opts.max_dict_bytes = dictionarySize;
+    blobOptions.compression_opts.zstd_max_train_bytes =
+        static_cast<uint32_t>(std::min<uint64_t>(
+            100 * uint64_t{dictionarySize},
+            std::numeric_limits<uint32_t>::max()));
+  }
 
   // We have to open all column families that currenly exists in our RocksDb.
   // Else we will get "Invalid argument: You have to open all column
@@ -79,28 +198,34 @@ const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
   rocksdb::DB::ListColumnFamilies(db_options, name, &oldUnopenedColumnFamilies);
 
   std::vector<rocksdb::ColumnFamilyDescriptor> families;
-  for (auto& ks : KeySpace::kAll) {
-    families.emplace_back(
-        ks->name.str(),
-        (ks->index == KeySpace::BlobFamily.index) ? blobOptions : options);
+  auto addFamily = [&](std::string familyName,
+                       const rocksdb::ColumnFamilyOptions& familyOptions) {
     auto oldFamily = find(
         oldUnopenedColumnFamilies.begin(),
         oldUnopenedColumnFamilies.end(),
-        ks->name.str());
+        familyName);
     if (oldFamily != oldUnopenedColumnFamilies.end()) {
       oldUnopenedColumnFamilies.erase(oldFamily);
     }
+    families.emplace_back(std::move(familyName), familyOptions);
+  };
+  auto keySpaceOptions = [&](KeySpace ks) -> const auto& {
+    return (ks->index == KeySpace::BlobFamily.index) ? blobOptions : options;
+  };
+
+  for (auto& ks : KeySpace::kAll) {
+    addFamily(ks->name.str(), keySpaceOptions(ks));
   }
   // Put the default column family after the defined KeySpace values.
   // This way the KeySpace enum values can be used directly as indexes
   // into our column family vectors.
-  families.emplace_back(rocksdb::kDefaultColumnFamilyName, options);
-  auto oldFamily = find(
-      oldUnopenedColumnFamilies.begin(),
-      oldUnopenedColumnFamilies.end(),
-      rocksdb::kDefaultColumnFamilyName);
-  if (oldFamily != oldUnopenedColumnFamilies.end()) {
-    oldUnopenedColumnFamilies.erase(oldFamily);
+  addFamily(rocksdb::kDefaultColumnFamilyName, options);
+  for (auto& ks : KeySpace::kAll) {
+    if (ks->isEphemeral()) {
+      addFamily(
+          folly::to<std::string>(ks->name, kSecondGenerationSuffix),
+          keySpaceOptions(ks));
+    }
   }
 
   // add any column families we missed with our default options;
@@ -134,6 +259,101 @@ rocksdb::Slice _createSlice(folly::ByteRange bytes) {
   return Slice(reinterpret_cast<const char*>(bytes.data()), bytes.size());
 }
 
+void clearColumn(
+    const RocksHandles& handles,
+    rocksdb::ColumnFamilyHandle* columnFamily) {
+  XLOG(DBG2) << "clearing column family \"" << columnFamily->GetName() << "\"";
+  std::string rangeStorage;
+  const auto fullRange = getFullRange(rangeStorage);
+
+  // Delete all SST files that only contain keys in the specified range.
+  // Since we are deleting everything in this column family this should
+  // effectively delete everything.
+  auto status = DeleteFilesInRange(
+      handles.db.get(), columnFamily, &fullRange.start, &fullRange.limit);
+  if (!status.ok()) {
+    throw RocksException::build(
+        status,
+        "error deleting data in \"",
+        columnFamily->GetName(),
+        "\" column family");
+  }
+
+  // Call DeleteRange() as well.  In theory DeleteFilesInRange may not delete
+  // everything in the range (but it probably will in our case since we are
+  // intending to delete everything).
+  const WriteOptions writeOptions;
+  status = handles.db->DeleteRange(
+      writeOptions, columnFamily, fullRange.start, fullRange.limit);
+  if (!status.ok()) {
+    throw RocksException::build(
+        status,
+        "error deleting data in \"",
+        columnFamily->GetName(),
+        "\" column family");
+  }
+}
+
+void compactColumn(
+    const RocksHandles& handles,
+    rocksdb::ColumnFamilyHandle* columnFamily) {
+  auto options = rocksdb::CompactRangeOptions{};
+  options.allow_write_stall = true;
+  XLOG(DBG2) << "compacting column family \"" << columnFamily->GetName()
+             << "\"";
+  auto status = handles.db->CompactRange(
+      options, columnFamily, /*begin=*/nullptr, /*end=*/nullptr);
+  if (!status.ok()) {
+    throw RocksException::build(
+        status,
+        "error compacting \"",
+        columnFamily->GetName(),
+        "\" column family");
+  }
+}
+
+uint64_t getColumnSize(
+    const RocksHandles& handles,
+    rocksdb::ColumnFamilyHandle* columnFamily) {
+  uint64_t size = 0;
+
+  // kLiveSstFilesSize reports the size of all "live" sst files.
+  // This excludes sst files from older snapshot versions that RocksDB may
+  // still be holding onto.  e.g., to provide a consistent view to iterators.
+  // kTotalSstFilesSize would report the size of all sst files if we wanted to
+  // report that.
+  uint64_t sstFilesSize;
+  auto result = handles.db->GetIntProperty(
+      columnFamily, rocksdb::DB::Properties::kLiveSstFilesSize, &sstFilesSize);
+  if (result) {
+    size += sstFilesSize;
+  } else {
+    XLOG(WARN) << "unable to retrieve SST file size from RocksDB for column "
+               << columnFamily->GetName();
+  }
+
+  // kSizeAllMemTables reports the size of the memtables.
+  // This is the in-memory space for tracking the data in *.log files that have
+  // not yet been compacted into a .sst file.
+  //
+  // We use this as a something that will hopefully roughly approximate the size
+  // of the *.log files.  In practice this generally seems to be a fair amount
+  // smaller than the on-disk *.log file size, except immediately after a
+  // compaction when there is still a couple MB of in-memory metadata despite
+  // having no uncompacted on-disk data.
+  uint64_t memtableSize;
+  result = handles.db->GetIntProperty(
+      columnFamily, rocksdb::DB::Properties::kSizeAllMemTables, &memtableSize);
+  if (result) {
+    size += memtableSize;
+  } else {
+    XLOG(WARN) << "unable to retrieve memtable size from RocksDB for column "
+               << columnFamily->GetName();
+  }
+
+  return size;
+}
+
 class RocksDbWriteBatch : public LocalStore::WriteBatch {
  public:
   void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
@@ -147,12 +367,49 @@ class RocksDbWriteBatch : public LocalStore::WriteBatch {
   // Use LocalStore::beginWrite() to create a write batch
   RocksDbWriteBatch(
       Synchronized<RocksHandles>::ConstRLockedPtr&& dbHandles,
+      const Generations& generations,
+      WriteBehindQueue* FOLLY_NULLABLE writeBehind,
+      NegativeLookupFilter& negativeLookupFilter,
       size_t bufferSize);
 
   void flushIfNeeded();
 
+  rocksdb::ColumnFamilyHandle* getCurrentColumn(KeySpace keySpace) const {
+    return getColumn(
+        *lockedDB_,
+        keySpace,
+        generations_[keySpace->index].load(std::memory_order_relaxed));
+  }
+
+  /**
+   * Queues writes to ephemeral key spaces in writeBehind_, if any. Returns
+   * false if the write should go in this batch.
+   */
+  bool queueWrite(
+      KeySpace keySpace,
+      folly::ByteRange key,
+      folly::ByteRange value) {
+    return writeBehind_ && keySpace->isEphemeral() &&
+        writeBehind_->put(keySpace, key, value);
+  }
+
+  /**
+   * Adds the key to the negative lookup filter before it is written.
+   * Returns its hash, for the filter to record once the batch is flushed.
+   */
+  uint64_t addToFilter(KeySpace keySpace, folly::ByteRange key) {
+    auto hash = NegativeLookupFilter::hashKey(key);
+    negativeLookupFilter_.add(keySpace, hash);
+    return hash;
+  }
+
   folly::Synchronized<RocksHandles>::ConstRLockedPtr lockedDB_;
+  const Generations& generations_;
+  WriteBehindQueue* writeBehind_;
+  NegativeLookupFilter& negativeLookupFilter_;
   rocksdb::WriteBatch writeBatch_;
+  /** The hashes of the filtered keys in writeBatch_. */
+  std::vector<std::pair<KeySpace, uint64_t>> filteredKeys_;
   size_t bufSize_;
 };
 
@@ -174,6 +431,10 @@ void RocksDbWriteBatch::flush() {
   }
 
   writeBatch_.Clear();
+  for (const auto& [keySpace, hash] : filteredKeys_) {
+    negativeLookupFilter_.addWritten(keySpace, hash);
+  }
+  filteredKeys_.clear();
 }
 
 void RocksDbWriteBatch::flushIfNeeded() {
@@ -186,9 +447,15 @@ void RocksDbWriteBatch::flushIfNeeded() {
 
 RocksDbWriteBatch::RocksDbWriteBatch(
     Synchronized<RocksHandles>::ConstRLockedPtr&& dbHandles,
+    const Generations& generations,
+    WriteBehindQueue* writeBehind,
+    NegativeLookupFilter& negativeLookupFilter,
     size_t bufSize)
     : LocalStore::WriteBatch(),
       lockedDB_(std::move(dbHandles)),
+      generations_(generations),
+      writeBehind_(writeBehind),
+      negativeLookupFilter_(negativeLookupFilter),
       writeBatch_(bufSize),
       bufSize_(bufSize) {}
 
@@ -203,10 +470,15 @@ void RocksDbWriteBatch::put(
     KeySpace keySpace,
     folly::ByteRange key,
     folly::ByteRange value) {
+  auto hash = addToFilter(keySpace, key);
+  if (queueWrite(keySpace, key, value)) {
+    return;
+  }
   writeBatch_.Put(
-      lockedDB_->columns[keySpace->index].get(),
-      _createSlice(key),
-      _createSlice(value));
+      getCurrentColumn(keySpace), _createSlice(key), _createSlice(value));
+  if (NegativeLookupFilter::covers(keySpace)) {
+    filteredKeys_.emplace_back(keySpace, hash);
+  }
 
   flushIfNeeded();
 }
@@ -215,6 +487,19 @@ void RocksDbWriteBatch::put(
     KeySpace keySpace,
     folly::ByteRange key,
     std::vector<folly::ByteRange> valueSlices) {
+  auto hash = addToFilter(keySpace, key);
+  if (writeBehind_ && keySpace->isEphemeral()) {
+    std::string value;
+    for (auto& valueSlice : valueSlices) {
+      value.append(
+          reinterpret_cast<const char*>(valueSlice.data()), valueSlice.size());
+    }
+    if (queueWrite(
+            keySpace, key, folly::ByteRange{folly::StringPiece{value}})) {
+      return;
+    }
+  }
+
   std::vector<Slice> slices;
 
   for (auto& valueSlice : valueSlices) {
@@ -224,14 +509,49 @@ void RocksDbWriteBatch::put(
   auto keySlice = _createSlice(key);
   SliceParts keyParts(&keySlice, 1);
   writeBatch_.Put(
-      lockedDB_->columns[keySpace->index].get(),
+      getCurrentColumn(keySpace),
       keyParts,
       SliceParts(slices.data(), slices.size()));
+  if (NegativeLookupFilter::covers(keySpace)) {
+    filteredKeys_.emplace_back(keySpace, hash);
+  }
 
   flushIfNeeded();
 }
 
-rocksdb::Options getRocksdbOptions() {
+/**
+ * The write batch handed out while the DB is opened in the background. It
+ * has no DB to batch writes for: each one goes through LocalStore::put(),
+ * which drops it or waits for the DB depending on its key space.
+ */
+class RocksDbOpeningWriteBatch : public LocalStore::WriteBatch {
+ public:
+  explicit RocksDbOpeningWriteBatch(LocalStore& store) : store_{store} {}
+
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override {
+    store_.put(keySpace, key, value);
+  }
+
+  void put(
+      KeySpace keySpace,
+      folly::ByteRange key,
+      std::vector<folly::ByteRange> valueSlices) override {
+    std::string value;
+    for (auto slice : valueSlices) {
+      value.append(reinterpret_cast<const char*>(slice.data()), slice.size());
+    }
+    store_.put(keySpace, key, folly::ByteRange{folly::StringPiece{value}});
+  }
+
+  void flush() override {}
+
+ private:
+  LocalStore& store_;
+};
+
+rocksdb::Options getRocksdbOptions(
+    std::shared_ptr<rocksdb::Statistics> statistics = nullptr) {
   rocksdb::Options options;
   // Optimize RocksDB. This is the easiest way to get RocksDB to perform well.
   options.IncreaseParallelism();
@@ -241,13 +561,20 @@ rocksdb::Options getRocksdbOptions() {
   // Automatically create column families as we define new ones.
   options.create_missing_column_families = true;
 
+  // Only collect the counters; timing every operation is too expensive.
+  if (statistics) {
+    statistics->set_stats_level(rocksdb::kExceptTimers);
+    options.statistics = std::move(statistics);
+  }
+
   return options;
 }
 
-RocksHandles openDB(AbsolutePathPiece path, RocksDBOpenMode mode) {
-  auto options = getRocksdbOptions();
-  const auto columnDescriptors =
-      columnFamilies(rocksdb::DBOptions{options}, path.stringPiece().str());
+RocksHandles openDB(
+    AbsolutePathPiece path,
+    RocksDBOpenMode mode,
+    const rocksdb::Options& options,
+    const std::vector<rocksdb::ColumnFamilyDescriptor>& columnDescriptors) {
   try {
     return RocksHandles(path.stringPiece(), mode, options, columnDescriptors);
   } catch (const RocksException& ex) {
@@ -274,22 +601,125 @@ RocksDbLocalStore::RocksDbLocalStore(
     AbsolutePathPiece pathToRocksDb,
     std::shared_ptr<StructuredLogger> structuredLogger,
     FaultInjector* faultInjector,
-    RocksDBOpenMode mode)
+    RocksDBOpenMode mode,
+    const EdenConfig* config,
+    RocksDBOpenTiming timing)
     : structuredLogger_{std::move(structuredLogger)},
       faultInjector_(*faultInjector),
+      readOnly_{mode == RocksDBOpenMode::ReadOnly},
       ioPool_(12, "RocksLocalStore"),
-      dbHandles_(folly::in_place, openDB(pathToRocksDb, mode)) {
+      statistics_{rocksdb::CreateDBStatistics()} {
+  // The config is only valid during the constructor, so the column families
+  // are set up here even when the DB is opened in the background.
+  auto options = getRocksdbOptions(statistics_);
+  auto columnDescriptors = columnFamilies(
+      rocksdb::DBOptions{options}, pathToRocksDb.stringPiece().str(), config);
+  if (auto interval = config
+          ? config->rocksDbWriteBehindInterval.getValue()
+          : std::chrono::nanoseconds{0};
+      !readOnly_ && interval.count() > 0) {
+    writeBehind_ = std::make_unique<WriteBehindQueue>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(interval),
+        config->rocksDbWriteBehindMaxBytes.getValue(),
+        [this](const WriteBehindQueue::Pending& pending) {
+          commitWriteBehind(pending);
+        });
+  }
+  if (timing == RocksDBOpenTiming::Synchronous) {
+    finishOpen(openDB(pathToRocksDb, mode, options, columnDescriptors));
+    return;
+  }
+
+  opening_.store(true);
+  // The destructor waits for the DB to be open, so this outlives the task.
+  ioPool_.add([this,
+               path = pathToRocksDb.copy(),
+               mode,
+               options = std::move(options),
+               columnDescriptors = std::move(columnDescriptors)] {
+    try {
+      finishOpen(openDB(path, mode, options, columnDescriptors));
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "unable to open RocksDB storage at " << path
+                << " in the background: " << folly::exceptionStr(ex);
+      opening_.store(false);
+      openPromise_.setException(
+          folly::exception_wrapper{std::current_exception(), ex});
+    }
+  });
+}
+
+RocksDbLocalStore::~RocksDbLocalStore() {
+  close();
+}
+
+void RocksDbLocalStore::finishOpen(RocksHandles handles) {
+  *dbHandles_.wlock() = std::move(handles);
+  loadGenerations();
+  // Reads and writes can go to the DB from now on; the rest of the work
+  // doesn't need to hold them back.
+  opening_.store(false);
   // Publish fb303 stats once when we first open the DB.
   // These will be kept up-to-date later by the periodicManagementTask() call.
   computeStats(/*publish=*/true, /*config=*/nullptr);
   clearDeprecatedKeySpaces();
+  openPromise_.setValue();
 }
 
-RocksDbLocalStore::~RocksDbLocalStore() {
-  close();
+folly::SemiFuture<folly::Unit> RocksDbLocalStore::getOpenFuture() const {
+  return openPromise_.getSemiFuture();
+}
+
+bool RocksDbLocalStore::skipUntilOpen(KeySpace keySpace) const {
+  if (!opening_.load()) {
+    return false;
+  }
+  // Ephemeral data can be fetched again from the backing store; persistent
+  // data, like proxy hashes, only lives here.
+  if (keySpace->isEphemeral()) {
+    return true;
+  }
+  waitUntilOpen();
+  return false;
+}
+
+void RocksDbLocalStore::waitUntilOpen() const {
+  if (opening_.load()) {
+    openPromise_.getSemiFuture().wait();
+  }
+}
+
+void RocksDbLocalStore::commitWriteBehind(
+    const WriteBehindQueue::Pending& pending) {
+  auto handles = getHandles();
+  rocksdb::WriteBatch batch;
+  for (auto& ks : KeySpace::kAll) {
+    auto* column = getCurrentColumn(*handles, ks);
+    for (const auto& [key, value] : pending[ks->index]) {
+      batch.Put(column, key, value);
+    }
+  }
+  auto status = handles->db->Write(WriteOptions(), &batch);
+  if (!status.ok()) {
+    throw RocksException::build(
+        status, "error committing ", batch.Count(), " queued writes");
+  }
+  // put() added the keys to the filter when queueing them.
+  for (auto& ks : KeySpace::kAll) {
+    for (const auto& entry : pending[ks->index]) {
+      negativeLookupFilter_.addWritten(
+          ks, folly::ByteRange{folly::StringPiece{entry.first}});
+    }
+  }
 }
 
 void RocksDbLocalStore::close() {
+  closing_.store(true);
+  waitUntilOpen();
+  if (writeBehind_) {
+    // Commit the queued writes while the DB is still open.
+    writeBehind_->stop();
+  }
   // Acquire dbHandles_ in write-lock mode.
   // Since any other access to the DB acquires a read lock this will block until
   // all current DB operations are complete.
@@ -307,7 +737,7 @@ void RocksDbLocalStore::repairDB(AbsolutePathPiece path) {
   rocksdb::DBOptions dbOptions(getRocksdbOptions());
 
   const auto columnDescriptors =
-      columnFamilies(dbOptions, path.stringPiece().str());
+      columnFamilies(dbOptions, path.stringPiece().str(), /*config=*/nullptr);
 
   auto status = RepairDB(
       dbPathStr, dbOptions, columnDescriptors, unknownColumFamilyOptions);
@@ -316,71 +746,180 @@ void RocksDbLocalStore::repairDB(AbsolutePathPiece path) {
   }
 }
 
+uint64_t RocksDbLocalStore::getWriteAheadLogSize(AbsolutePathPiece path) {
+  auto* env = rocksdb::Env::Default();
+  auto dbPathStr = path.stringPiece().str();
+  std::vector<std::string> children;
+  if (!env->GetChildren(dbPathStr, &children).ok()) {
+    return 0;
+  }
+  uint64_t total = 0;
+  for (const auto& child : children) {
+    if (!folly::StringPiece{child}.endsWith(".log")) {
+      continue;
+    }
+    uint64_t size;
+    if (env->GetFileSize(folly::to<string>(dbPathStr, "/", child), &size)
+            .ok()) {
+      total += size;
+    }
+  }
+  return total;
+}
+
 void RocksDbLocalStore::clearKeySpace(KeySpace keySpace) {
+  waitUntilOpen();
+  if (writeBehind_) {
+    writeBehind_->flush();
+  }
   auto handles = getHandles();
-  auto columnFamily = handles->columns[keySpace->index].get();
-  std::unique_ptr<rocksdb::Iterator> it{
-      handles->db->NewIterator(ReadOptions(), columnFamily)};
-  XLOG(DBG2) << "clearing column family \"" << columnFamily->GetName() << "\"";
-  std::string rangeStorage;
-  const auto fullRange = getFullRange(rangeStorage);
+  clearColumn(*handles, handles->columns[keySpace->index].get());
+  if (keySpace->isEphemeral()) {
+    clearColumn(*handles, getColumn(*handles, keySpace, 1));
+  }
+}
 
-  // Delete all SST files that only contain keys in the specified range.
-  // Since we are deleting everything in this column family this should
-  // effectively delete everything.
-  auto status = DeleteFilesInRange(
-      handles->db.get(), columnFamily, &fullRange.start, &fullRange.limit);
-  if (!status.ok()) {
-    throw RocksException::build(
-        status,
-        "error deleting data in \"",
-        columnFamily->GetName(),
-        "\" column family");
+void RocksDbLocalStore::compactKeySpace(KeySpace keySpace) {
+  waitUntilOpen();
+  auto handles = getHandles();
+  compactColumn(*handles, handles->columns[keySpace->index].get());
+  if (keySpace->isEphemeral()) {
+    compactColumn(*handles, getColumn(*handles, keySpace, 1));
   }
+}
 
-  // Call DeleteRange() as well.  In theory DeleteFilesInRange may not delete
-  // everything in the range (but it probably will in our case since we are
-  // intending to delete everything).
-  const WriteOptions writeOptions;
-  status = handles->db->DeleteRange(
-      writeOptions, columnFamily, fullRange.start, fullRange.limit);
+void RocksDbLocalStore::loadGenerations() {
+  auto handles = getHandles();
+  for (auto& ks : KeySpace::kAll) {
+    if (!ks->isEphemeral()) {
+      continue;
+    }
+    string value;
+    auto status = handles->db->Get(
+        ReadOptions(),
+        handles->columns[kDefaultColumn].get(),
+        getGenerationKey(ks),
+        &value);
+    if (status.ok()) {
+      currentGenerations_[ks->index].store(
+          value == "1" ? 1 : 0, std::memory_order_relaxed);
+    } else if (!status.IsNotFound()) {
+      XLOG(WARN) << "unable to read the current generation of key space "
+                 << ks->name << ", using generation 0: " << status.ToString();
+    }
+  }
+}
+
+rocksdb::ColumnFamilyHandle* RocksDbLocalStore::getCurrentColumn(
+    const RocksHandles& handles,
+    KeySpace keySpace) const {
+  return getColumn(
+      handles,
+      keySpace,
+      currentGenerations_[keySpace->index].load(std::memory_order_relaxed));
+}
+
+rocksdb::ColumnFamilyHandle* RocksDbLocalStore::getPreviousColumn(
+    const RocksHandles& handles,
+    KeySpace keySpace) const {
+  if (!keySpace->isEphemeral()) {
+    return nullptr;
+  }
+  auto current =
+      currentGenerations_[keySpace->index].load(std::memory_order_relaxed);
+  return getColumn(handles, keySpace, current == 0 ? 1 : 0);
+}
+
+void RocksDbLocalStore::writePromotions(
+    const RocksHandles& handles,
+    rocksdb::WriteBatch& promotions) const {
+  if (readOnly_ || promotions.Count() == 0) {
+    return;
+  }
+  auto status = handles.db->Write(WriteOptions(), &promotions);
   if (!status.ok()) {
-    throw RocksException::build(
-        status,
-        "error deleting data in \"",
-        columnFamily->GetName(),
-        "\" column family");
+    // The objects are still readable from the previous generation; they will
+    // only be fetched again if they are not read before the next rotation.
+    XLOG(WARN) << "unable to move " << promotions.Count()
+               << " objects to the current generation: " << status.ToString();
   }
 }
 
-void RocksDbLocalStore::compactKeySpace(KeySpace keySpace) {
+rocksdb::Status RocksDbLocalStore::getFromGenerations(
+    const RocksHandles& handles,
+    KeySpace keySpace,
+    ByteRange key,
+    std::string& value) const {
+  auto* current = getCurrentColumn(handles, keySpace);
+  auto status =
+      handles.db->Get(ReadOptions(), current, _createSlice(key), &value);
+  auto* previous = getPreviousColumn(handles, keySpace);
+  if (!status.IsNotFound() || !previous) {
+    return status;
+  }
+
+  status = handles.db->Get(ReadOptions(), previous, _createSlice(key), &value);
+  if (status.ok()) {
+    rocksdb::WriteBatch promotions;
+    promotions.Put(current, _createSlice(key), value);
+    writePromotions(handles, promotions);
+  }
+  return status;
+}
+
+void RocksDbLocalStore::rotateKeySpace(KeySpace keySpace) {
+  XCHECK(keySpace->isEphemeral());
+  waitUntilOpen();
+  // Queued writes are committed to the current generation.
+  if (writeBehind_) {
+    writeBehind_->flush();
+  }
   auto handles = getHandles();
-  auto options = rocksdb::CompactRangeOptions{};
-  options.allow_write_stall = true;
-  auto columnFamily = handles->columns[keySpace->index].get();
-  XLOG(DBG2) << "compacting column family \"" << columnFamily->GetName()
-             << "\"";
-  auto status = handles->db->CompactRange(
-      options, columnFamily, /*begin=*/nullptr, /*end=*/nullptr);
+  auto current =
+      currentGenerations_[keySpace->index].load(std::memory_order_relaxed);
+  uint8_t next = current == 0 ? 1 : 0;
+
+  // The previous generation only holds the objects that were not read since
+  // the last rotation: the ones that were have been copied to the current
+  // generation. Drop it and start writing there, keeping the current
+  // generation as the previous one.
+  auto* column = getColumn(*handles, keySpace, next);
+  clearColumn(*handles, column);
+  compactColumn(*handles, column);
+
+  auto status = handles->db->Put(
+      WriteOptions(),
+      handles->columns[kDefaultColumn].get(),
+      getGenerationKey(keySpace),
+      next == 0 ? "0" : "1");
   if (!status.ok()) {
     throw RocksException::build(
-        status,
-        "error compacting \"",
-        columnFamily->GetName(),
-        "\" column family");
+        status, "unable to record the generation of ", keySpace->name);
   }
+  currentGenerations_[keySpace->index].store(next, std::memory_order_relaxed);
 }
 
 StoreResult RocksDbLocalStore::get(KeySpace keySpace, ByteRange key) const {
+  if (skipUntilOpen(keySpace)) {
+    return StoreResult::missing(keySpace, key);
+  }
+  auto filtered = negativeLookupFilter_.lookup(keySpace, key);
+  if (filtered == NegativeLookupFilter::Lookup::Absent) {
+    return StoreResult::missing(keySpace, key);
+  }
+  if (writeBehind_) {
+    if (auto queued = writeBehind_->get(keySpace, key)) {
+      return StoreResult(std::move(*queued));
+    }
+  }
   auto handles = getHandles();
   string value;
-  auto status = handles->db->Get(
-      ReadOptions(),
-      handles->columns[keySpace->index].get(),
-      _createSlice(key),
-      &value);
+  auto status = getFromGenerations(*handles, keySpace, key, value);
   if (!status.ok()) {
     if (status.IsNotFound()) {
+      if (filtered == NegativeLookupFilter::Lookup::MaybePresent) {
+        negativeLookupFilter_.recordFalsePositive(keySpace);
+      }
       // Return an empty StoreResult
       return StoreResult::missing(keySpace, key);
     }
@@ -422,6 +961,53 @@ FOLLY_NODISCARD folly::Future<std::vector<StoreResult>>
 RocksDbLocalStore::getBatch(
     KeySpace keySpace,
     const std::vector<folly::ByteRange>& keys) const {
+  using Lookup = NegativeLookupFilter::Lookup;
+  std::vector<Lookup> lookups;
+  lookups.reserve(keys.size());
+  std::vector<folly::ByteRange> candidates;
+  std::vector<StoreResult> absent;
+  bool filtered = false;
+  for (auto& key : keys) {
+    auto lookup = negativeLookupFilter_.lookup(keySpace, key);
+    lookups.push_back(lookup);
+    filtered |= lookup != Lookup::Unfiltered;
+    if (lookup == Lookup::Absent) {
+      absent.push_back(StoreResult::missing(keySpace, key));
+    } else {
+      candidates.push_back(key);
+    }
+  }
+  if (!filtered) {
+    return getBatchFromDB(keySpace, keys);
+  }
+
+  return getBatchFromDB(keySpace, candidates)
+      .thenValue([store = getSharedFromThis(),
+                  keySpace,
+                  lookups = std::move(lookups),
+                  absent = std::move(absent)](
+                     std::vector<StoreResult>&& found) mutable {
+        std::vector<StoreResult> results;
+        results.reserve(lookups.size());
+        auto foundIt = found.begin();
+        auto absentIt = absent.begin();
+        for (auto lookup : lookups) {
+          if (lookup == Lookup::Absent) {
+            results.push_back(std::move(*absentIt++));
+            continue;
+          }
+          if (lookup == Lookup::MaybePresent && !foundIt->isValid()) {
+            store->negativeLookupFilter_.recordFalsePositive(keySpace);
+          }
+          results.push_back(std::move(*foundIt++));
+        }
+        return results;
+      });
+}
+
+folly::Future<std::vector<StoreResult>> RocksDbLocalStore::getBatchFromDB(
+    KeySpace keySpace,
+    const std::vector<folly::ByteRange>& keys) const {
   std::vector<folly::Future<std::vector<StoreResult>>> futures;
 
   std::vector<std::shared_ptr<std::vector<std::string>>> batches;
@@ -443,20 +1029,70 @@ RocksDbLocalStore::getBatch(
                         keySpace,
                         keys = std::move(batch)](folly::Unit&&) {
               XLOG(DBG3) << __func__ << " starting to actually do work";
+              if (store->skipUntilOpen(keySpace)) {
+                std::vector<StoreResult> results;
+                for (auto& key : *keys) {
+                  results.push_back(StoreResult::missing(
+                      keySpace, folly::ByteRange{folly::StringPiece{key}}));
+                }
+                return results;
+              }
               auto handles = store->getHandles();
               std::vector<Slice> keySlices;
               std::vector<std::string> values;
-              std::vector<rocksdb::ColumnFamilyHandle*> columns;
+              auto* current = store->getCurrentColumn(*handles, keySpace);
               for (auto& key : *keys) {
                 keySlices.emplace_back(key);
-                columns.emplace_back(handles->columns[keySpace->index].get());
               }
               auto statuses = handles->db->MultiGet(
-                  ReadOptions(), columns, keySlices, &values);
+                  ReadOptions(),
+                  std::vector<rocksdb::ColumnFamilyHandle*>(
+                      keySlices.size(), current),
+                  keySlices,
+                  &values);
+
+              if (auto* previous =
+                      store->getPreviousColumn(*handles, keySpace)) {
+                std::vector<size_t> misses;
+                std::vector<Slice> missSlices;
+                for (size_t i = 0; i < statuses.size(); ++i) {
+                  if (statuses[i].IsNotFound()) {
+                    misses.push_back(i);
+                    missSlices.push_back(keySlices[i]);
+                  }
+                }
+                if (!misses.empty()) {
+                  std::vector<std::string> missValues;
+                  auto missStatuses = handles->db->MultiGet(
+                      ReadOptions(),
+                      std::vector<rocksdb::ColumnFamilyHandle*>(
+                          missSlices.size(), previous),
+                      missSlices,
+                      &missValues);
+                  rocksdb::WriteBatch promotions;
+                  for (size_t i = 0; i < misses.size(); ++i) {
+                    statuses[misses[i]] = missStatuses[i];
+                    if (missStatuses[i].ok()) {
+                      values[misses[i]] = std::move(missValues[i]);
+                      promotions.Put(
+                          current, missSlices[i], values[misses[i]]);
+                    }
+                  }
+                  store->writePromotions(*handles, promotions);
+                }
+              }
 
               std::vector<StoreResult> results;
               for (size_t i = 0; i < keys->size(); ++i) {
                 auto& status = statuses[i];
+                if (status.IsNotFound() && store->writeBehind_) {
+                  if (auto queued = store->writeBehind_->get(
+                          keySpace,
+                          folly::ByteRange{folly::StringPiece{keys->at(i)}})) {
+                    results.emplace_back(std::move(*queued));
+                    continue;
+                  }
+                }
                 if (!status.ok()) {
                   if (status.IsNotFound()) {
                     // Return an empty StoreResult
@@ -499,15 +1135,24 @@ RocksDbLocalStore::getBatch(
 }
 
 bool RocksDbLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
+  if (skipUntilOpen(keySpace)) {
+    return false;
+  }
+  auto filtered = negativeLookupFilter_.lookup(keySpace, key);
+  if (filtered == NegativeLookupFilter::Lookup::Absent) {
+    return false;
+  }
+  if (writeBehind_ && writeBehind_->get(keySpace, key)) {
+    return true;
+  }
   string value;
   auto handles = getHandles();
-  auto status = handles->db->Get(
-      ReadOptions(),
-      handles->columns[keySpace->index].get(),
-      _createSlice(key),
-      &value);
+  auto status = getFromGenerations(*handles, keySpace, key, value);
   if (!status.ok()) {
     if (status.IsNotFound()) {
+      if (filtered == NegativeLookupFilter::Lookup::MaybePresent) {
+        negativeLookupFilter_.recordFalsePositive(keySpace);
+      }
       return false;
     }
 
@@ -524,69 +1169,147 @@ bool RocksDbLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
 
 std::unique_ptr<LocalStore::WriteBatch> RocksDbLocalStore::beginWrite(
     size_t bufSize) {
-  return std::make_unique<RocksDbWriteBatch>(getHandles(), bufSize);
+  if (opening_.load()) {
+    return std::make_unique<RocksDbOpeningWriteBatch>(*this);
+  }
+  return std::make_unique<RocksDbWriteBatch>(
+      getHandles(),
+      currentGenerations_,
+      writeBehind_.get(),
+      negativeLookupFilter_,
+      bufSize);
 }
 
 void RocksDbLocalStore::put(
     KeySpace keySpace,
     folly::ByteRange key,
     folly::ByteRange value) {
+  if (skipUntilOpen(keySpace)) {
+    return;
+  }
+  negativeLookupFilter_.add(keySpace, key);
+  if (writeBehind_ && keySpace->isEphemeral() &&
+      writeBehind_->put(keySpace, key, value)) {
+    return;
+  }
   auto handles = getHandles();
   handles->db->Put(
       WriteOptions(),
-      handles->columns[keySpace->index].get(),
+      getCurrentColumn(*handles, keySpace),
       _createSlice(key),
       _createSlice(value));
+  negativeLookupFilter_.addWritten(keySpace, key);
 }
 
 uint64_t RocksDbLocalStore::getApproximateSize(KeySpace keySpace) const {
+  waitUntilOpen();
   auto handles = getHandles();
-  uint64_t size = 0;
+  auto size = getColumnSize(*handles, handles->columns[keySpace->index].get());
+  if (keySpace->isEphemeral()) {
+    size += getColumnSize(*handles, getColumn(*handles, keySpace, 1));
+  }
+  return size;
+}
 
-  // kLiveSstFilesSize reports the size of all "live" sst files.
-  // This excludes sst files from older snapshot versions that RocksDB may
-  // still be holding onto.  e.g., to provide a consistent view to iterators.
-  // kTotalSstFilesSize would report the size of all sst files if we wanted to
-  // report that.
-  uint64_t sstFilesSize;
-  auto result = handles->db->GetIntProperty(
-      handles->columns[keySpace->index].get(),
-      rocksdb::DB::Properties::kLiveSstFilesSize,
-      &sstFilesSize);
-  if (result) {
-    size += sstFilesSize;
-  } else {
-    XLOG(WARN) << "unable to retrieve SST file size from RocksDB for key space "
-               << handles->columns[keySpace->index]->GetName();
+uint64_t RocksDbLocalStore::getCurrentGenerationSize(KeySpace keySpace) const {
+  auto handles = getHandles();
+  return getColumnSize(*handles, getCurrentColumn(*handles, keySpace));
+}
+
+std::optional<uint64_t> RocksDbLocalStore::getSortedRunCount(
+    KeySpace keySpace) const {
+  auto handles = getHandles();
+  std::vector<rocksdb::ColumnFamilyHandle*> columns{
+      handles->columns[keySpace->index].get()};
+  // A lookup that misses in the current generation also searches the
+  // previous one.
+  if (keySpace->isEphemeral()) {
+    columns.push_back(getColumn(*handles, keySpace, 1));
   }
 
-  // kSizeAllMemTables reports the size of the memtables.
-  // This is the in-memory space for tracking the data in *.log files that have
-  // not yet been compacted into a .sst file.
-  //
-  // We use this as a something that will hopefully roughly approximate the size
-  // of the *.log files.  In practice this generally seems to be a fair amount
-  // smaller than the on-disk *.log file size, except immediately after a
-  // compaction when there is still a couple MB of in-memory metadata despite
-  // having no uncompacted on-disk data.
-  uint64_t memtableSize;
-  result = handles->db->GetIntProperty(
-      handles->columns[keySpace->index].get(),
-      rocksdb::DB::Properties::kSizeAllMemTables,
-      &memtableSize);
-  if (result) {
-    size += memtableSize;
-  } else {
-    XLOG(WARN) << "unable to retrieve memtable size from RocksDB for key space "
-               << handles->columns[keySpace->index]->GetName();
+  // Each level 0 file may hold any key, while the files of each deeper level
+  // hold disjoint ranges, so a lookup that misses every bloom filter reads at
+  // most one block per level 0 file plus one per non-empty deeper level.
+  uint64_t runs = 0;
+  for (auto* column : columns) {
+    for (int level = 0; level < handles->db->NumberLevels(column); ++level) {
+      std::string files;
+      if (!handles->db->GetProperty(
+              column,
+              folly::to<string>(
+                  rocksdb::DB::Properties::kNumFilesAtLevelPrefix, level),
+              &files)) {
+        XLOG(WARN) << "unable to retrieve level " << level
+                   << " file count from RocksDB for column "
+                   << column->GetName();
+        return std::nullopt;
+      }
+      auto count = folly::tryTo<uint64_t>(files);
+      if (!count) {
+        return std::nullopt;
+      }
+      runs += level == 0 ? *count : (*count > 0 ? 1 : 0);
+    }
   }
+  return runs;
+}
 
-  return size;
+void RocksDbLocalStore::publishStatistics() {
+  static constexpr std::pair<rocksdb::Tickers, folly::StringPiece> kTickers[] =
+      {
+          {rocksdb::BLOCK_CACHE_HIT, "block_cache.hit"},
+          {rocksdb::BLOCK_CACHE_MISS, "block_cache.miss"},
+          {rocksdb::BLOCK_CACHE_DATA_HIT, "block_cache.data_hit"},
+          {rocksdb::BLOCK_CACHE_DATA_MISS, "block_cache.data_miss"},
+          {rocksdb::BLOOM_FILTER_USEFUL, "bloom_filter.useful"},
+          {rocksdb::MEMTABLE_HIT, "memtable.hit"},
+          {rocksdb::MEMTABLE_MISS, "memtable.miss"},
+          {rocksdb::NUMBER_BLOCK_COMPRESSED, "block.compressed"},
+          {rocksdb::NUMBER_BLOCK_DECOMPRESSED, "block.decompressed"},
+      };
+  for (const auto& [ticker, name] : kTickers) {
+    fb303::fbData->setCounter(
+        folly::to<string>(statsPrefix_, name),
+        statistics_->getTickerCount(ticker));
+  }
+}
+
+void RocksDbLocalStore::publishNegativeLookupFilterStats(KeySpace keySpace) {
+  auto stats = negativeLookupFilter_.getStats(keySpace);
+  auto prefix =
+      folly::to<string>(statsPrefix_, keySpace->name, ".negative_filter.");
+  fb303::fbData->setCounter(prefix + "absent", stats.absent);
+  fb303::fbData->setCounter(prefix + "maybe_present", stats.maybePresent);
+  fb303::fbData->setCounter(prefix + "false_positives", stats.falsePositives);
+  fb303::fbData->setCounter(prefix + "keys", stats.keys);
+  // Every key that isn't stored was either answered as absent or was a false
+  // positive.
+  auto negatives = stats.absent + stats.falsePositives;
+  fb303::fbData->setCounter(
+      prefix + "false_positive_rate_ppm",
+      negatives == 0 ? 0 : stats.falsePositives * 1'000'000 / negatives);
 }
 
 void RocksDbLocalStore::periodicManagementTask(const EdenConfig& config) {
   enableBlobCaching.store(
       config.enableBlobCaching.getValue(), std::memory_order_relaxed);
+  enableBlobDeduplication.store(
+      config.enableBlobDeduplication.getValue(), std::memory_order_relaxed);
+  enablePackedTrees.store(
+      config.enablePackedTrees.getValue(), std::memory_order_relaxed);
+  if (opening_.load()) {
+    // The stats are published once the DB is open.
+    return;
+  }
+
+  if (auto interval = config.rocksDbNegativeLookupFilterInterval.getValue();
+      interval.count() > 0) {
+    scheduleNegativeLookupFilterRebuilds(interval);
+  } else {
+    for (auto& ks : KeySpace::kAll) {
+      negativeLookupFilter_.clear(ks);
+    }
+  }
 
   // Compute and publish the stats
   auto before = computeStats(/*publish=*/true, &config);
@@ -605,12 +1328,78 @@ void RocksDbLocalStore::periodicManagementTask(const EdenConfig& config) {
     }
     XLOG(INFO) << "scheduling automatic local store garbage collection: "
                << "ephemeral data sizes of columns " << keySpaceNames
-               << " exceed their limits; total ephemeral size = "
+               << " are near their limits; total ephemeral size = "
                << before.ephemeral;
     triggerAutoGC(before);
   }
 }
 
+void RocksDbLocalStore::scheduleNegativeLookupFilterRebuilds(
+    std::chrono::nanoseconds interval) {
+  std::vector<KeySpace> keySpaces;
+  for (auto& ks : KeySpace::kAll) {
+    if (negativeLookupFilter_.needsRebuild(ks, interval)) {
+      keySpaces.push_back(ks);
+    }
+  }
+  if (keySpaces.empty() || negativeLookupFilterRebuilding_.exchange(true)) {
+    return;
+  }
+
+  // Scanning a large key space takes a while, so like garbage collection this
+  // runs on ioPool_ rather than on the management thread.
+  ioPool_.add([store = getSharedFromThis(), keySpaces = std::move(keySpaces)] {
+    for (auto keySpace : keySpaces) {
+      try {
+        store->rebuildNegativeLookupFilter(keySpace);
+      } catch (const std::exception& ex) {
+        XLOG(WARN) << "unable to rebuild the negative lookup filter of "
+                   << keySpace->name << ": " << folly::exceptionStr(ex);
+      }
+    }
+    store->negativeLookupFilterRebuilding_.store(false);
+  });
+}
+
+void RocksDbLocalStore::rebuildNegativeLookupFilter(KeySpace keySpace) {
+  waitUntilOpen();
+  auto start = std::chrono::steady_clock::now();
+  negativeLookupFilter_.rebuild(
+      keySpace, [&](folly::FunctionRef<void(ByteRange)> addKey) {
+        auto handles = getHandles();
+        ReadOptions options;
+        // The scan reads every block once, keep it from evicting the ones
+        // lookups need.
+        options.fill_cache = false;
+        for (auto* column :
+             {getCurrentColumn(*handles, keySpace),
+              getPreviousColumn(*handles, keySpace)}) {
+          if (!column) {
+            continue;
+          }
+          std::unique_ptr<rocksdb::Iterator> it{
+              handles->db->NewIterator(options, column)};
+          for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            if (closing_.load(std::memory_order_relaxed)) {
+              throw std::runtime_error("the local store is being closed");
+            }
+            auto key = it->key();
+            addKey(ByteRange{
+                reinterpret_cast<const uint8_t*>(key.data()), key.size()});
+          }
+          RocksException::check(
+              it->status(), "unable to scan the keys of ", keySpace->name);
+        }
+      });
+  auto stats = negativeLookupFilter_.getStats(keySpace);
+  XLOG(DBG2) << "rebuilt the negative lookup filter of " << keySpace->name
+             << " with " << stats.keys << " keys in "
+             << duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count()
+             << "ms";
+}
+
 RocksDbLocalStore::SizeSummary RocksDbLocalStore::computeStats(
     bool publish,
     const EdenConfig* config) {
@@ -620,11 +1409,23 @@ RocksDbLocalStore::SizeSummary RocksDbLocalStore::computeStats(
     if (publish) {
       fb303::fbData->setCounter(
           folly::to<string>(statsPrefix_, ks->name, ".size"), size);
+      if (auto sortedRuns = getSortedRunCount(ks)) {
+        fb303::fbData->setCounter(
+            folly::to<string>(statsPrefix_, ks->name, ".sorted_runs"),
+            *sortedRuns);
+      }
+      if (NegativeLookupFilter::covers(ks)) {
+        publishNegativeLookupFilterStats(ks);
+      }
     }
     if (auto* ephemeral = std::get_if<Ephemeral>(&ks->persistence)) {
       result.ephemeral += size;
       if (config) {
-        if (size > (config->*(ephemeral->cacheLimit)).getValue()) {
+        // Rotating once the current generation reaches half of the limit
+        // keeps both generations together under it, while the objects read
+        // since the last rotation survive the next one.
+        auto limit = (config->*(ephemeral->cacheLimit)).getValue();
+        if (size > limit || getCurrentGenerationSize(ks) > limit / 2) {
           result.excessiveKeySpaces.set(ks->index);
         }
       }
@@ -634,6 +1435,7 @@ RocksDbLocalStore::SizeSummary RocksDbLocalStore::computeStats(
   }
 
   if (publish) {
+    publishStatistics();
     fb303::fbData->setCounter(
         folly::to<string>(statsPrefix_, "ephemeral.total_size"),
         result.ephemeral);
@@ -675,8 +1477,7 @@ void RocksDbLocalStore::triggerAutoGC(SizeSummary before) {
     try {
       for (auto& ks : KeySpace::kAll) {
         if (before.excessiveKeySpaces.test(ks->index)) {
-          store->clearKeySpace(ks);
-          store->compactKeySpace(ks);
+          store->rotateKeySpace(ks);
         }
       }
     } catch (const std::exception& ex) {
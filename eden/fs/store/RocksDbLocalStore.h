@@ -9,10 +9,16 @@
 
 #include <folly/CppAttributes.h>
 #include <folly/Synchronized.h>
+#include <folly/futures/SharedPromise.h>
+#include <array>
+#include <atomic>
 #include <bitset>
+#include <optional>
 
 #include "eden/fs/rocksdb/RocksHandles.h"
 #include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/NegativeLookupFilter.h"
+#include "eden/fs/store/WriteBehindQueue.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 namespace facebook::eden {
@@ -20,6 +26,12 @@ namespace facebook::eden {
 class FaultInjector;
 class StructuredLogger;
 
+/**
+ * Whether the RocksDbLocalStore constructor returns once the DB is open, or
+ * right away while the DB is opened on the store's I/O pool.
+ */
+enum class RocksDBOpenTiming { Synchronous, Background };
+
 /** An implementation of LocalStore that uses RocksDB for the underlying
  * storage.
  */
@@ -28,12 +40,23 @@ class RocksDbLocalStore : public LocalStore {
   /**
    * The given FaultInjector must be valid during the lifetime of this
    * RocksDbLocalStore object.
+   *
+   * The column families are tuned according to config, or opened with the
+   * default settings if it is null. It is only used by the constructor.
+   *
+   * Replaying a large write-ahead log after a crash, or repairing the DB, can
+   * take minutes. With RocksDBOpenTiming::Background the store is usable
+   * while that happens: reads of ephemeral key spaces miss and writes to
+   * them are dropped, since their data can be fetched again from the backing
+   * store, while accesses to persistent key spaces wait for the DB.
    */
   explicit RocksDbLocalStore(
       AbsolutePathPiece pathToRocksDb,
       std::shared_ptr<StructuredLogger> structuredLogger,
       FaultInjector* FOLLY_NONNULL faultInjector,
-      RocksDBOpenMode mode = RocksDBOpenMode::ReadWrite);
+      RocksDBOpenMode mode = RocksDBOpenMode::ReadWrite,
+      const EdenConfig* config = nullptr,
+      RocksDBOpenTiming timing = RocksDBOpenTiming::Synchronous);
   ~RocksDbLocalStore();
   void close() override;
   void clearKeySpace(KeySpace keySpace) override;
@@ -53,12 +76,43 @@ class RocksDbLocalStore : public LocalStore {
   // Call RocksDB's RepairDB() function on the DB at the specified location
   static void repairDB(AbsolutePathPiece path);
 
+  /**
+   * Returns the total size of the write-ahead log files of the DB at the
+   * specified location, which opening it has to replay.
+   */
+  static uint64_t getWriteAheadLogSize(AbsolutePathPiece path);
+
+  /**
+   * Completes once the DB is open, or with the error that prevented opening
+   * it.
+   */
+  folly::SemiFuture<folly::Unit> getOpenFuture() const;
+
   // Get the approximate number of bytes stored on disk for the
-  // specified key space.
+  // specified key space, including both generations of an ephemeral one.
   uint64_t getApproximateSize(KeySpace keySpace) const;
 
+  /**
+   * Drop the previous generation of an ephemeral key space and make it the
+   * current one, so that only the objects that were not read since the last
+   * rotation are removed.
+   */
+  void rotateKeySpace(KeySpace keySpace);
+
   void periodicManagementTask(const EdenConfig& config) override;
 
+  /**
+   * Replace the negative lookup filter of keySpace with one built from a scan
+   * of its keys. periodicManagementTask() does this in the background when
+   * store:rocksdb-negative-lookup-filter-interval is set.
+   */
+  void rebuildNegativeLookupFilter(KeySpace keySpace);
+
+  NegativeLookupFilter::Stats getNegativeLookupFilterStats(
+      KeySpace keySpace) const {
+    return negativeLookupFilter_.getStats(keySpace);
+  }
+
  private:
   /**
    * Get a pointer to the RocksHandles object in order to perform an I/O
@@ -76,6 +130,59 @@ class RocksDbLocalStore : public LocalStore {
     return handles;
   }
   [[noreturn]] void throwStoreClosedError() const;
+
+  /**
+   * Install the handles of the freshly opened DB, and complete the open
+   * future.
+   */
+  void finishOpen(RocksHandles handles);
+
+  /**
+   * While the DB is being opened in the background, returns true if the
+   * access to keySpace should be skipped: reads treated as misses and writes
+   * dropped. For the key spaces that can't be skipped, waits for the DB to be
+   * open and returns false.
+   */
+  bool skipUntilOpen(KeySpace keySpace) const;
+  /** Blocks until the DB being opened in the background, if any, is open. */
+  void waitUntilOpen() const;
+
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatchFromDB(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const;
+
+  /**
+   * Rebuilds, on ioPool_, the negative lookup filters that are missing,
+   * full, or older than interval.
+   */
+  void scheduleNegativeLookupFilterRebuilds(std::chrono::nanoseconds interval);
+
+  /** Writes a group of queued writes to the DB, in one write batch. */
+  void commitWriteBehind(const WriteBehindQueue::Pending& pending);
+
+  /**
+   * Ephemeral key spaces are split into a current and a previous generation,
+   * each in its own column family. Writes go to the current generation, and
+   * reads that hit the previous one copy the object to the current one.
+   */
+  void loadGenerations();
+  rocksdb::ColumnFamilyHandle* getCurrentColumn(
+      const RocksHandles& handles,
+      KeySpace keySpace) const;
+  /** Returns nullptr if keySpace only has one generation. */
+  rocksdb::ColumnFamilyHandle* getPreviousColumn(
+      const RocksHandles& handles,
+      KeySpace keySpace) const;
+  rocksdb::Status getFromGenerations(
+      const RocksHandles& handles,
+      KeySpace keySpace,
+      folly::ByteRange key,
+      std::string& value) const;
+  void writePromotions(
+      const RocksHandles& handles,
+      rocksdb::WriteBatch& promotions) const;
+  uint64_t getCurrentGenerationSize(KeySpace keySpace) const;
+
   std::shared_ptr<RocksDbLocalStore> getSharedFromThis() {
     return std::static_pointer_cast<RocksDbLocalStore>(shared_from_this());
   }
@@ -99,8 +206,8 @@ class RocksDbLocalStore : public LocalStore {
      */
     uint64_t persistent = 0;
     /**
-     * Which keyspace indices exceed their configured size limit and should be
-     * cleared.
+     * Which keyspace indices are close enough to their configured size limit
+     * that they should be rotated.
      */
     std::bitset<KeySpace::kTotalCount> excessiveKeySpaces;
   };
@@ -111,15 +218,51 @@ class RocksDbLocalStore : public LocalStore {
    */
   SizeSummary computeStats(bool publish, const EdenConfig* config);
 
+  /**
+   * Returns an upper bound on the number of sorted runs a lookup in keySpace
+   * has to search on disk, i.e. its read amplification.
+   */
+  std::optional<uint64_t> getSortedRunCount(KeySpace keySpace) const;
+
+  /**
+   * Publish the DB-wide cache and filter counters kept by RocksDB.
+   */
+  void publishStatistics();
+
+  /**
+   * Publish the hit and false positive counts of the negative lookup filter
+   * of keySpace.
+   */
+  void publishNegativeLookupFilterStats(KeySpace keySpace);
+
   void triggerAutoGC(SizeSummary before);
   void autoGCFinished(bool successful, uint64_t ephemeralSizeBefore);
 
   std::shared_ptr<StructuredLogger> structuredLogger_;
   const std::string statsPrefix_{"local_store."};
   FaultInjector& faultInjector_;
+  const bool readOnly_;
   mutable UnboundedQueueExecutor ioPool_;
   folly::Synchronized<AutoGCState> autoGCState_;
+  std::shared_ptr<rocksdb::Statistics> statistics_;
+  /** The current generation of each ephemeral key space, 0 or 1. */
+  std::array<std::atomic<uint8_t>, KeySpace::kTotalCount> currentGenerations_{};
   folly::Synchronized<RocksHandles> dbHandles_;
+  std::atomic<bool> opening_{false};
+  mutable folly::SharedPromise<folly::Unit> openPromise_;
+  /**
+   * Queues the writes to ephemeral key spaces when
+   * store:rocksdb-write-behind-interval is set.
+   */
+  std::unique_ptr<WriteBehindQueue> writeBehind_;
+  /**
+   * Answers lookups of keys that aren't stored without going to RocksDB,
+   * once it was built by rebuildNegativeLookupFilter().
+   */
+  NegativeLookupFilter negativeLookupFilter_;
+  std::atomic<bool> negativeLookupFilterRebuilding_{false};
+  /** Set by close() to abort a rebuild scanning the DB. */
+  std::atomic<bool> closing_{false};
 };
 
 } // namespace facebook::eden
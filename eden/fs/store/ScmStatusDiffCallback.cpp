@@ -6,9 +6,12 @@
  */
 
 #include "eden/fs/store/ScmStatusDiffCallback.h"
+#include <folly/Conv.h>
 #include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
+#include <functional>
+#include <thread>
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/TreeEntry.h"
 #include "eden/fs/store/ObjectStore.h"
@@ -16,24 +19,40 @@
 
 namespace facebook::eden {
 
+folly::Synchronized<ScmStatusDiffCallback::Buffer>&
+ScmStatusDiffCallback::getBuffer() {
+  auto index = std::hash<std::thread::id>{}(std::this_thread::get_id());
+  return buffers_[index % kNumBuffers];
+}
+
+void ScmStatusDiffCallback::addEntry(
+    RelativePathPiece path,
+    ScmFileStatus status) {
+  addEntry(path.stringPiece().str(), status);
+}
+
+void ScmStatusDiffCallback::addEntry(std::string path, ScmFileStatus status) {
+  getBuffer().wlock()->entries.emplace_back(std::move(path), status);
+}
+
 void ScmStatusDiffCallback::ignoredFile(RelativePathPiece path) {
-  data_.wlock()->entries_ref()->emplace(
-      path.stringPiece().str(), ScmFileStatus::IGNORED);
+  addEntry(path, ScmFileStatus::IGNORED);
 }
 
 void ScmStatusDiffCallback::addedFile(RelativePathPiece path) {
-  data_.wlock()->entries_ref()->emplace(
-      path.stringPiece().str(), ScmFileStatus::ADDED);
+  addEntry(path, ScmFileStatus::ADDED);
+}
+
+void ScmStatusDiffCallback::addedDirectory(RelativePathPiece path) {
+  addEntry(folly::to<std::string>(path, "/"), ScmFileStatus::ADDED);
 }
 
 void ScmStatusDiffCallback::removedFile(RelativePathPiece path) {
-  data_.wlock()->entries_ref()->emplace(
-      path.stringPiece().str(), ScmFileStatus::REMOVED);
+  addEntry(path, ScmFileStatus::REMOVED);
 }
 
 void ScmStatusDiffCallback::modifiedFile(RelativePathPiece path) {
-  data_.wlock()->entries_ref()->emplace(
-      path.stringPiece().str(), ScmFileStatus::MODIFIED);
+  addEntry(path, ScmFileStatus::MODIFIED);
 }
 
 void ScmStatusDiffCallback::diffError(
@@ -41,7 +60,7 @@ void ScmStatusDiffCallback::diffError(
     const folly::exception_wrapper& ew) {
   XLOG(WARNING) << "error computing status data for " << path << ": "
                 << folly::exceptionStr(ew);
-  data_.wlock()->errors_ref()->emplace(
+  getBuffer().wlock()->errors.emplace_back(
       path.stringPiece().str(), folly::exceptionStr(ew).toStdString());
 }
 
@@ -53,8 +72,19 @@ void ScmStatusDiffCallback::diffError(
  * the diff operation has completed.
  */
 ScmStatus ScmStatusDiffCallback::extractStatus() {
-  auto data = data_.wlock();
-  return std::move(*data);
+  ScmStatus status;
+  for (auto& buffer : buffers_) {
+    auto locked = buffer.wlock();
+    for (auto& [path, code] : locked->entries) {
+      status.entries_ref()->emplace(std::move(path), code);
+    }
+    for (auto& [path, error] : locked->errors) {
+      status.errors_ref()->emplace(std::move(path), std::move(error));
+    }
+    locked->entries.clear();
+    locked->errors.clear();
+  }
+  return status;
 }
 
 char scmStatusCodeChar(ScmFileStatus code) {
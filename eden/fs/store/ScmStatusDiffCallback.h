@@ -6,7 +6,11 @@
  */
 
 #pragma once
+#include <array>
 #include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <folly/Synchronized.h>
 
@@ -22,10 +26,20 @@ class Future;
 
 namespace facebook::eden {
 
+/**
+ * Collects the results of a diff into a ScmStatus.
+ *
+ * Diffs report paths from many threads at once. Rather than contending on
+ * a single map, each thread appends to one of several buffers, chosen by
+ * thread id, and the buffers are merged into the ScmStatus when it is
+ * extracted.
+ */
 class ScmStatusDiffCallback : public DiffCallback {
  public:
   void ignoredFile(RelativePathPiece path) override;
   void addedFile(RelativePathPiece path) override;
+  /** Adds path, followed by a '/', as an ADDED entry. */
+  void addedDirectory(RelativePathPiece path) override;
   void removedFile(RelativePathPiece path) override;
   void modifiedFile(RelativePathPiece path) override;
 
@@ -42,7 +56,18 @@ class ScmStatusDiffCallback : public DiffCallback {
   ScmStatus extractStatus();
 
  private:
-  folly::Synchronized<ScmStatus> data_;
+  struct Buffer {
+    std::vector<std::pair<std::string, ScmFileStatus>> entries;
+    std::vector<std::pair<std::string, std::string>> errors;
+  };
+
+  static constexpr size_t kNumBuffers = 16;
+
+  folly::Synchronized<Buffer>& getBuffer();
+  void addEntry(RelativePathPiece path, ScmFileStatus status);
+  void addEntry(std::string path, ScmFileStatus status);
+
+  std::array<folly::Synchronized<Buffer>, kNumBuffers> buffers_;
 };
 
 /**
@@ -17,23 +17,31 @@
 namespace facebook::eden {
 
 SerializedBlobMetadata::SerializedBlobMetadata(const BlobMetadata& metadata) {
-  serialize(metadata.sha1, metadata.size);
+  serialize(metadata.sha1, metadata.size, metadata.blake3);
 }
 
 SerializedBlobMetadata::SerializedBlobMetadata(
     const Hash20& contentsHash,
     uint64_t blobSize) {
-  serialize(contentsHash, blobSize);
+  serialize(contentsHash, blobSize, std::nullopt);
 }
 
 folly::ByteRange SerializedBlobMetadata::slice() const {
-  return folly::ByteRange{data_};
+  return folly::ByteRange{data_.data(), size_};
 }
 
 BlobMetadata SerializedBlobMetadata::parse(
     ObjectId blobID,
     const StoreResult& result) {
   auto bytes = result.bytes();
+  if (bytes.size() == SIZE_WITH_BLAKE3) {
+    auto metadata = unslice(bytes.subpiece(0, SIZE));
+    bytes.advance(SIZE);
+    Blake3Hash blake3;
+    memcpy(blake3.data(), bytes.data(), blake3.size());
+    metadata.blake3 = blake3;
+    return metadata;
+  }
   if (bytes.size() != SIZE) {
     throw std::invalid_argument(fmt::format(
         "Blob metadata for {} had unexpected size {}. Could not deserialize.",
@@ -54,13 +62,19 @@ BlobMetadata SerializedBlobMetadata::unslice(folly::ByteRange bytes) {
 
 void SerializedBlobMetadata::serialize(
     const Hash20& contentsHash,
-    uint64_t blobSize) {
+    uint64_t blobSize,
+    const std::optional<Blake3Hash>& blake3) {
   uint64_t blobSizeBE = folly::Endian::big(blobSize);
   memcpy(data_.data(), &blobSizeBE, sizeof(uint64_t));
   memcpy(
       data_.data() + sizeof(uint64_t),
       contentsHash.getBytes().data(),
       Hash20::RAW_SIZE);
+  size_ = SIZE;
+  if (blake3.has_value()) {
+    memcpy(data_.data() + SIZE, blake3->data(), blake3->size());
+    size_ = SIZE_WITH_BLAKE3;
+  }
 }
 
 } // namespace facebook::eden
@@ -24,17 +24,24 @@ class SerializedBlobMetadata {
   static BlobMetadata parse(ObjectId blobID, const StoreResult& result);
 
   static constexpr size_t SIZE = sizeof(uint64_t) + Hash20::RAW_SIZE;
+  static constexpr size_t SIZE_WITH_BLAKE3 =
+      SIZE + std::tuple_size_v<Blake3Hash>;
 
  private:
-  void serialize(const Hash20& contentsHash, uint64_t blobSize);
+  void serialize(
+      const Hash20& contentsHash,
+      uint64_t blobSize,
+      const std::optional<Blake3Hash>& blake3);
   static BlobMetadata unslice(folly::ByteRange bytes);
 
   /**
    * The serialized data is stored as stored as:
    * - size (8 bytes, big endian)
    * - hash (20 bytes)
+   * - BLAKE3 hash (32 bytes), only if it has been computed
    */
-  std::array<uint8_t, SIZE> data_;
+  std::array<uint8_t, SIZE_WITH_BLAKE3> data_;
+  size_t size_{SIZE};
 
   friend class TreeMetadata;
 };
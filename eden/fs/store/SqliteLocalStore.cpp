@@ -22,6 +22,24 @@ using std::string;
 
 namespace {
 
+/**
+ * The number of connections that serve reads. In WAL mode they do not block
+ * each other or the writer, so reads are not serialized behind one lock.
+ */
+constexpr size_t kReadConnections = 4;
+
+/**
+ * How much of the database the read connections map into memory, so that
+ * reads come straight from the page cache instead of through read(2) into
+ * SQLite's own page cache.
+ */
+constexpr uint64_t kReadMmapSize = 1024 * 1024 * 1024;
+
+std::string selectValueSql(KeySpace keySpace) {
+  return folly::to<std::string>(
+      "select value from ", keySpace->name, " where key = ?");
+}
+
 /**
  * Implements the write batching helper.
  * In an ideal world, we'd just start a transaction and have the WriteBatch
@@ -123,6 +141,9 @@ SqliteLocalStore::SqliteLocalStore(AbsolutePathPiece pathToDb)
     }
   }
 
+  // The tables must exist before the read connections are opened.
+  db_.openReaders(kReadConnections, kReadMmapSize);
+
   clearDeprecatedKeySpaces();
 }
 
@@ -140,10 +161,8 @@ void SqliteLocalStore::clearKeySpace(KeySpace keySpace) {
 void SqliteLocalStore::compactKeySpace(KeySpace) {}
 
 StoreResult SqliteLocalStore::get(KeySpace keySpace, ByteRange key) const {
-  auto db = db_.lock();
-
-  SqliteStatement stmt(
-      db, "select value from ", keySpace->name, " where key = ?");
+  auto reader = db_.lockReader();
+  auto& stmt = reader.statement(selectValueSql(keySpace));
 
   // Bind the key; parameters are 1-based
   stmt.bind(1, key);
@@ -157,10 +176,32 @@ StoreResult SqliteLocalStore::get(KeySpace keySpace, ByteRange key) const {
   return StoreResult::missing(keySpace, key);
 }
 
-bool SqliteLocalStore::hasKey(KeySpace keySpace, ByteRange key) const {
-  auto db = db_.lock();
+folly::Future<std::vector<StoreResult>> SqliteLocalStore::getBatch(
+    KeySpace keySpace,
+    const std::vector<folly::ByteRange>& keys) const {
+  return folly::makeFutureWith([&] {
+    auto reader = db_.lockReader();
+    auto& stmt = reader.statement(selectValueSql(keySpace));
+
+    std::vector<StoreResult> results;
+    results.reserve(keys.size());
+    for (auto& key : keys) {
+      stmt.bind(1, key);
+      if (stmt.step()) {
+        results.emplace_back(stmt.columnBlob(0).str());
+      } else {
+        results.push_back(StoreResult::missing(keySpace, key));
+      }
+      stmt.reset();
+    }
+    return results;
+  });
+}
 
-  SqliteStatement stmt(db, "select 1 from ", keySpace->name, " where key = ?");
+bool SqliteLocalStore::hasKey(KeySpace keySpace, ByteRange key) const {
+  auto reader = db_.lockReader();
+  auto& stmt = reader.statement(folly::to<std::string>(
+      "select 1 from ", keySpace->name, " where key = ?"));
 
   stmt.bind(1, key);
   return stmt.step();
@@ -6,7 +6,7 @@
  */
 
 #pragma once
-#include <folly/Synchronized.h>
+#include <vector>
 #include "eden/fs/sqlite/SqliteDatabase.h"
 #include "eden/fs/store/LocalStore.h"
 
@@ -14,7 +14,8 @@ namespace facebook::eden {
 
 /** An implementation of LocalStore that stores values in Sqlite.
  * SqliteLocalStore is thread safe, allowing reads and writes from
- * any thread.
+ * any thread. Writes go through a single connection, while reads are spread
+ * over a few read-only connections that memory-map the database.
  * */
 class SqliteLocalStore : public LocalStore {
  public:
@@ -23,6 +24,12 @@ class SqliteLocalStore : public LocalStore {
   void clearKeySpace(KeySpace keySpace) override;
   void compactKeySpace(KeySpace keySpace) override;
   StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  /**
+   * Looks up all of the keys under a single lock with one prepared statement.
+   */
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const override;
   bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
   void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
       override;
@@ -17,12 +17,24 @@ StatsFetchContext::StatsFetchContext(
     : clientPid_{pid}, cause_{cause}, causeDetail_{std::move(causeDetail)} {}
 
 StatsFetchContext::StatsFetchContext(const StatsFetchContext& other) {
-  for (size_t y = 0; y < ObjectFetchContext::kObjectTypeEnumMax; ++y) {
-    for (size_t x = 0; x < ObjectFetchContext::kOriginEnumMax; ++x) {
-      // This could almost certainly use a more relaxed memory ordering.
-      counts_[y][x] = other.counts_[y][x].load();
-    }
+  merge(other);
+}
+
+StatsFetchContext::Shard& StatsFetchContext::getLocalShard() {
+  // Threads are spread over the shards in the order they first fetch
+  // something, which keeps the threads of a pool on distinct shards.
+  static std::atomic<size_t> nextShard{0};
+  static thread_local size_t shard =
+      nextShard.fetch_add(1, std::memory_order_relaxed) % kShardCount;
+  return shards_[shard];
+}
+
+uint64_t StatsFetchContext::load(ObjectType type, Origin origin) const {
+  uint64_t result = 0;
+  for (const auto& shard : shards_) {
+    result += shard.counts[type][origin].load(std::memory_order_relaxed);
   }
+  return result;
 }
 
 void StatsFetchContext::didFetch(
@@ -33,7 +45,8 @@ void StatsFetchContext::didFetch(
       << "type is out of range: " << type;
   XCHECK(origin < ObjectFetchContext::kOriginEnumMax)
       << "origin is out of range: " << type;
-  counts_[type][origin].fetch_add(1, std::memory_order_acq_rel);
+  getLocalShard().counts[type][origin].fetch_add(
+      1, std::memory_order_relaxed);
 }
 
 uint64_t StatsFetchContext::countFetchesOfType(ObjectType type) const {
@@ -42,7 +55,7 @@ uint64_t StatsFetchContext::countFetchesOfType(ObjectType type) const {
   uint64_t result = 0;
   for (unsigned origin = 0; origin < ObjectFetchContext::kOriginEnumMax;
        ++origin) {
-    result += counts_[type][origin].load(std::memory_order_acquire);
+    result += load(type, static_cast<Origin>(origin));
   }
   return result;
 }
@@ -52,7 +65,10 @@ void StatsFetchContext::merge(const StatsFetchContext& other) {
        ++type) {
     for (unsigned origin = 0; origin < ObjectFetchContext::kOriginEnumMax;
          ++origin) {
-      counts_[type][origin] += other.counts_[type][origin];
+      shards_[0].counts[type][origin].fetch_add(
+          other.load(
+              static_cast<ObjectType>(type), static_cast<Origin>(origin)),
+          std::memory_order_relaxed);
     }
   }
 }
@@ -64,7 +80,7 @@ uint64_t StatsFetchContext::countFetchesOfTypeAndOrigin(
       << "type is out of range: " << type;
   XCHECK(origin < ObjectFetchContext::kOriginEnumMax)
       << "origin is out of range: " << type;
-  return counts_[type][origin].load(std::memory_order_acquire);
+  return load(type, origin);
 }
 
 FetchStatistics StatsFetchContext::computeStatistics() const {
@@ -77,9 +93,9 @@ FetchStatistics StatsFetchContext::computeStatistics() const {
   };
 
   auto computeAccessStats = [&](ObjectFetchContext::ObjectType type) {
-    uint64_t fromMemory = counts_[type][ObjectFetchContext::FromMemoryCache];
-    uint64_t fromDisk = counts_[type][ObjectFetchContext::FromDiskCache];
-    uint64_t fromNetwork = counts_[type][ObjectFetchContext::FromNetworkFetch];
+    uint64_t fromMemory = load(type, ObjectFetchContext::FromMemoryCache);
+    uint64_t fromDisk = load(type, ObjectFetchContext::FromDiskCache);
+    uint64_t fromNetwork = load(type, ObjectFetchContext::FromNetworkFetch);
     uint64_t total = fromMemory + fromDisk + fromNetwork;
     return FetchStatistics::Access{
         total, fromNetwork, computePercent(fromMemory + fromDisk, total)};
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <folly/lang/Align.h>
+#include <array>
 #include <atomic>
 #include <optional>
 
@@ -38,6 +40,15 @@ struct FetchStatistics {
   Access metadata;
 };
 
+/**
+ * Counts the objects fetched on its behalf, by type and origin.
+ *
+ * A single context is shared by all the fetches of a checkout or a diff,
+ * which run on many threads at once. The counters are split in shards, one
+ * per cache line, with each thread incrementing its own shard, so that these
+ * fetches don't contend on the same cache lines. The shards are only summed
+ * when the counts are read.
+ */
 class StatsFetchContext : public ObjectFetchContext {
  public:
   StatsFetchContext() = default;
@@ -66,8 +77,20 @@ class StatsFetchContext : public ObjectFetchContext {
   void merge(const StatsFetchContext& other);
 
  private:
-  std::atomic<uint64_t> counts_[ObjectFetchContext::kObjectTypeEnumMax]
-                               [ObjectFetchContext::kOriginEnumMax] = {};
+  static constexpr size_t kShardCount = 8;
+
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    std::atomic<uint64_t> counts[ObjectFetchContext::kObjectTypeEnumMax]
+                                [ObjectFetchContext::kOriginEnumMax] = {};
+  };
+
+  /** The shard incremented by the calling thread. */
+  Shard& getLocalShard();
+
+  /** Sums the count of the given type and origin across the shards. */
+  uint64_t load(ObjectType type, Origin origin) const;
+
+  std::array<Shard, kShardCount> shards_;
   std::optional<pid_t> clientPid_ = std::nullopt;
   Cause cause_ = Cause::Unknown;
   folly::StringPiece causeDetail_;
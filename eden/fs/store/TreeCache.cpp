@@ -7,26 +7,65 @@
 
 #include "eden/fs/store/TreeCache.h"
 
+#include <folly/logging/xlog.h>
+
 #include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/store/DiskTreeCache.h"
 
 namespace facebook::eden {
-std::shared_ptr<const Tree> TreeCache::get(const ObjectId& hash) {
+std::shared_ptr<const Tree> TreeCache::get(
+    const ObjectId& hash,
+    ClientId client) {
   if (config_->getEdenConfig()->enableInMemoryTreeCaching.getValue()) {
-    return getSimple(hash);
+    if (auto tree = getSimple(hash, client)) {
+      return tree;
+    }
+    if (diskCache_) {
+      if (auto tree = diskCache_->get(hash)) {
+        auto sharedTree = std::shared_ptr<const Tree>{std::move(tree)};
+        insertSimple(sharedTree, client);
+        return sharedTree;
+      }
+    }
   }
   return std::shared_ptr<const Tree>{nullptr};
 }
 
-void TreeCache::insert(std::shared_ptr<const Tree> tree) {
+void TreeCache::insert(std::shared_ptr<const Tree> tree, ClientId client) {
   if (config_->getEdenConfig()->enableInMemoryTreeCaching.getValue()) {
-    return insertSimple(tree);
+    return insertSimple(tree, client);
   }
 }
 
+void TreeCache::loadSnapshot(AbsolutePathPiece path) {
+  auto diskCache = DiskTreeCache::open(path);
+  if (diskCache) {
+    XLOG(INFO) << "loaded " << diskCache->size()
+               << " trees from tree cache snapshot " << path;
+  }
+  diskCache_ = std::move(diskCache);
+}
+
+void TreeCache::saveSnapshot(AbsolutePathPiece path) const {
+  auto trees = getAllObjects();
+  DiskTreeCache::write(path, trees);
+  XLOG(INFO) << "saved " << trees.size() << " trees to tree cache snapshot "
+             << path;
+}
+
+size_t TreeCache::getSnapshotSize() const {
+  return diskCache_ ? diskCache_->size() : 0;
+}
+
 TreeCache::TreeCache(std::shared_ptr<ReloadableConfig> config)
       : ObjectCache<Tree, ObjectCacheFlavor::Simple>{
             config->getEdenConfig()->inMemoryTreeCacheSize.getValue(),
-            config->getEdenConfig()->inMemoryTreeCacheMinElements.getValue()},
+            config->getEdenConfig()->inMemoryTreeCacheMinElements.getValue(),
+            config->getEdenConfig()->inMemoryTreeCacheShards.getValue(),
+            config->getEdenConfig()
+                ->inMemoryTreeCacheEvictionPolicy.getValue()},
         config_{config} {}
 
+TreeCache::~TreeCache() = default;
+
 } // namespace facebook::eden
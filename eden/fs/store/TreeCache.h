@@ -7,12 +7,17 @@
 
 #pragma once
 
+#include <memory>
+
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/store/ObjectCache.h"
+#include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
 
+class DiskTreeCache;
+
 /**
  * An in-memory LRU cache for loaded trees. Currently, this will not be used by
  * the inode code as inodes store the tree data in the inode itself. This is
@@ -29,6 +34,10 @@ namespace facebook::eden {
  * be cachable your minimum entry count must be atleast 1, otherwise insert may
  * not actually insert the tree into the cache.
  *
+ * Optionally, a DiskTreeCache snapshot can be attached as a second tier. Trees
+ * missing from memory are then looked up in the snapshot and promoted into
+ * memory. This lets a restarted daemon start with a warm tree cache.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 class TreeCache : public ObjectCache<Tree, ObjectCacheFlavor::Simple> {
@@ -40,20 +49,46 @@ class TreeCache : public ObjectCache<Tree, ObjectCacheFlavor::Simple> {
     };
     return std::make_shared<TC>(config);
   }
-  ~TreeCache() = default;
+  ~TreeCache();
 
   /**
    * If a tree for the given hash is in cache, return it. If the tree is not in
    * cache, return nullptr.
+   *
+   * The hit or miss is accounted to the given client, see registerClient().
    */
-  std::shared_ptr<const Tree> get(const ObjectId& hash);
+  std::shared_ptr<const Tree> get(
+      const ObjectId& hash,
+      ClientId client = kNoClient);
 
   /**
    * Inserts a tree into the cache for future lookup. If the new total size
    * exceeds the maximum cache size and the minimum entry count, old entries are
    * evicted.
+   *
+   * The tree is charged to the given client, see registerClient().
    */
-  void insert(std::shared_ptr<const Tree> tree);
+  void insert(std::shared_ptr<const Tree> tree, ClientId client = kNoClient);
+
+  /**
+   * Attach the on-disk snapshot at the given path as a second cache tier.
+   * Does nothing if the snapshot does not exist or can not be read.
+   *
+   * The snapshot is read without locking on every miss, so this must be
+   * called at most once, before the cache is used from other threads.
+   */
+  void loadSnapshot(AbsolutePathPiece path);
+
+  /**
+   * Write the trees currently held in memory to a snapshot at the given path,
+   * so they can be loaded with loadSnapshot() by the next daemon.
+   */
+  void saveSnapshot(AbsolutePathPiece path) const;
+
+  /**
+   * Number of trees in the attached snapshot, or 0 if there is none.
+   */
+  size_t getSnapshotSize() const;
 
  private:
   /**
@@ -61,6 +96,8 @@ class TreeCache : public ObjectCache<Tree, ObjectCacheFlavor::Simple> {
    */
   std::shared_ptr<ReloadableConfig> config_;
 
+  std::unique_ptr<const DiskTreeCache> diskCache_;
+
   explicit TreeCache(std::shared_ptr<ReloadableConfig> config);
 };
 
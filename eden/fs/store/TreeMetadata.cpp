@@ -94,7 +94,8 @@ IOBuf TreeMetadata::serializeV1() const {
   }
   for (auto& [hash, metadata] : *hashIndexedEntries) {
     appender.push(hash.getBytes());
-    SerializedBlobMetadata serializedMetadata(metadata);
+    // Entries have a fixed size, so they never carry a BLAKE3 hash.
+    SerializedBlobMetadata serializedMetadata(metadata.sha1, metadata.size);
     appender.push(serializedMetadata.slice());
   }
   return buf;
@@ -128,7 +129,7 @@ IOBuf TreeMetadata::serializeV2(size_t serialized_size) const {
     XCHECK_LE(bytes.size(), std::numeric_limits<uint16_t>::max());
     appender.write<uint16_t>(folly::to_narrow(bytes.size()));
     appender.push(bytes);
-    SerializedBlobMetadata serializedMetadata(metadata);
+    SerializedBlobMetadata serializedMetadata(metadata.sha1, metadata.size);
     appender.push(serializedMetadata.slice());
   }
   return buf;
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TreePinSet.h"
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectStore.h"
+
+namespace facebook::eden {
+
+TreePinSet::TreePinSet(size_t maxBytes) : maxBytes_{maxBytes} {}
+
+ImmediateFuture<std::shared_ptr<const Tree>> TreePinSet::getTree(
+    const ObjectId& id,
+    const ObjectStore& store,
+    ObjectFetchContext& context) {
+  if (maxBytes_ == 0) {
+    return store.getTree(id, context);
+  }
+  if (auto tree = get(id)) {
+    return tree;
+  }
+  return store.getTree(id, context)
+      .thenValue([this](std::shared_ptr<const Tree> tree) {
+        pin(tree);
+        return tree;
+      });
+}
+
+std::shared_ptr<const Tree> TreePinSet::get(const ObjectId& id) const {
+  auto state = state_.rlock();
+  auto it = state->trees.find(id);
+  return it == state->trees.end() ? nullptr : it->second;
+}
+
+void TreePinSet::pin(std::shared_ptr<const Tree> tree) {
+  if (!tree) {
+    return;
+  }
+  auto bytes = tree->getSizeBytes();
+  auto state = state_.wlock();
+  if (state->totalBytes + bytes > maxBytes_) {
+    return;
+  }
+  auto id = tree->getHash();
+  if (state->trees.emplace(std::move(id), std::move(tree)).second) {
+    state->totalBytes += bytes;
+  }
+}
+
+size_t TreePinSet::getTotalBytes() const {
+  return state_.rlock()->totalBytes;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <memory>
+#include <unordered_map>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+class ObjectFetchContext;
+class ObjectStore;
+class Tree;
+
+/**
+ * Holds a reference to every tree fetched during one diff or checkout, until
+ * the operation completes.
+ *
+ * The same trees are often requested several times by a single operation:
+ * by the checkout tree prefetcher and then by the checkout itself, or by a
+ * DeferredDiffEntry after the directory was first compared. The TreeCache
+ * may have evicted them in between, in which case they would be fetched and
+ * deserialized again.
+ *
+ * The set is bounded by the estimated memory of its trees. Once it is full,
+ * further trees are no longer pinned; the ones already pinned, fetched
+ * first, are typically the ones the operation comes back to first.
+ *
+ * This class is thread safe.
+ */
+class TreePinSet {
+ public:
+  /**
+   * A set pinning at most maxBytes worth of trees. A maxBytes of 0 disables
+   * pinning.
+   */
+  explicit TreePinSet(size_t maxBytes);
+
+  TreePinSet(const TreePinSet&) = delete;
+  TreePinSet& operator=(const TreePinSet&) = delete;
+
+  /**
+   * Returns the pinned tree with the given id, or fetches it from store and
+   * pins it.
+   *
+   * The set must outlive the returned future.
+   */
+  ImmediateFuture<std::shared_ptr<const Tree>> getTree(
+      const ObjectId& id,
+      const ObjectStore& store,
+      ObjectFetchContext& context);
+
+  /** Returns the pinned tree with the given id, or nullptr if there is none. */
+  std::shared_ptr<const Tree> get(const ObjectId& id) const;
+
+  /** Pin tree, unless it is already pinned or doesn't fit in the budget. */
+  void pin(std::shared_ptr<const Tree> tree);
+
+  size_t getTotalBytes() const;
+
+ private:
+  struct State {
+    std::unordered_map<ObjectId, std::shared_ptr<const Tree>> trees;
+    size_t totalBytes{0};
+  };
+
+  const size_t maxBytes_;
+  folly::Synchronized<State> state_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/WriteBehindQueue.h"
+
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+
+namespace facebook::eden {
+
+namespace {
+std::string toString(folly::ByteRange bytes) {
+  return std::string{reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+}
+} // namespace
+
+WriteBehindQueue::WriteBehindQueue(
+    std::chrono::milliseconds interval,
+    size_t maxPendingBytes,
+    CommitFn commit)
+    : interval_{interval},
+      maxPendingBytes_{maxPendingBytes},
+      commit_{std::move(commit)},
+      thread_{[this] {
+        folly::setThreadName("WriteBehind");
+        run();
+      }} {}
+
+WriteBehindQueue::~WriteBehindQueue() {
+  stop();
+}
+
+void WriteBehindQueue::stop() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+bool WriteBehindQueue::put(
+    KeySpace keySpace,
+    folly::ByteRange key,
+    folly::ByteRange value) {
+  std::unique_lock<std::mutex> lock{mutex_};
+  // Hold back the writers rather than buffering without bound while the
+  // previous commit is slow.
+  cv_.wait(lock, [&] {
+    return stopping_ || pendingBytes_ < maxPendingBytes_;
+  });
+  if (stopping_) {
+    return false;
+  }
+
+  bool wasEmpty = pendingBytes_ == 0;
+  auto [it, inserted] =
+      pending_[keySpace->index].try_emplace(toString(key), toString(value));
+  if (inserted) {
+    pendingBytes_ += key.size() + value.size();
+  } else {
+    pendingBytes_ -= it->second.size();
+    pendingBytes_ += value.size();
+    it->second = toString(value);
+  }
+  ++queuedCount_;
+  bool full = pendingBytes_ >= maxPendingBytes_;
+  lock.unlock();
+
+  // The background thread only needs to hear about the write that starts a
+  // commit interval, or one that ends it early.
+  if (wasEmpty || full) {
+    cv_.notify_all();
+  }
+  return true;
+}
+
+std::optional<std::string> WriteBehindQueue::get(
+    KeySpace keySpace,
+    folly::ByteRange key) const {
+  auto keyString = toString(key);
+  std::lock_guard<std::mutex> lock{mutex_};
+  for (const auto* writes : {&pending_, &committing_}) {
+    auto& entries = (*writes)[keySpace->index];
+    if (auto it = entries.find(keyString); it != entries.end()) {
+      return it->second;
+    }
+  }
+  return std::nullopt;
+}
+
+void WriteBehindQueue::flush() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  auto target = queuedCount_;
+  flushRequested_ = true;
+  cv_.notify_all();
+  // Once stopping, the background thread commits everything before it
+  // exits, and no more writes are queued.
+  cv_.wait(lock, [&] { return committedCount_ >= target; });
+}
+
+void WriteBehindQueue::run() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (true) {
+    cv_.wait(lock, [&] { return stopping_ || pendingBytes_ > 0; });
+    if (pendingBytes_ == 0) {
+      // Stopping, with nothing left to commit.
+      break;
+    }
+    // Let the writes of the other import threads join this group.
+    cv_.wait_for(lock, interval_, [&] {
+      return stopping_ || flushRequested_ ||
+          pendingBytes_ >= maxPendingBytes_;
+    });
+
+    std::swap(pending_, committing_);
+    pendingBytes_ = 0;
+    flushRequested_ = false;
+    auto committed = queuedCount_;
+    // Writers blocked on a full queue can proceed.
+    cv_.notify_all();
+
+    lock.unlock();
+    try {
+      commit_(committing_);
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "unable to commit queued local store writes: "
+                << folly::exceptionStr(ex);
+    }
+    lock.lock();
+
+    for (auto& entries : committing_) {
+      entries.clear();
+    }
+    committedCount_ = committed;
+    cv_.notify_all();
+  }
+}
+
+} // namespace facebook::eden
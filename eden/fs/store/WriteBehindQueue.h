@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/Range.h>
+#include <folly/container/F14Map.h>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "eden/fs/store/KeySpace.h"
+
+namespace facebook::eden {
+
+/**
+ * Buffers local store writes and commits them in groups from a background
+ * thread.
+ *
+ * During a checkout, every imported tree and blob is written to the local
+ * store on its own by one of the import threads. Each of those writes goes
+ * through the DB's write path and write-ahead log separately; queueing them
+ * here turns the writes issued within one commit interval into a single one.
+ *
+ * Queued writes are visible to get() until they are committed, so readers
+ * can check here before reading the DB. A write that fails to commit is
+ * logged and dropped, which is only acceptable for data that can be fetched
+ * again: callers should not queue writes to persistent key spaces.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class WriteBehindQueue {
+ public:
+  using Pending = std::array<
+      folly::F14NodeMap<std::string, std::string>,
+      KeySpace::kTotalCount>;
+  /**
+   * Writes all the given entries to the store. It is called from the
+   * background thread, and may throw.
+   */
+  using CommitFn = folly::Function<void(const Pending&)>;
+
+  /**
+   * Writes are committed once interval has elapsed since the first one
+   * queued, or as soon as maxPendingBytes are queued. put() blocks while
+   * that many bytes are waiting for the previous commit to finish.
+   */
+  WriteBehindQueue(
+      std::chrono::milliseconds interval,
+      size_t maxPendingBytes,
+      CommitFn commit);
+
+  /**
+   * Commits the queued writes before returning.
+   */
+  ~WriteBehindQueue();
+
+  WriteBehindQueue(const WriteBehindQueue&) = delete;
+  WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+  /**
+   * Queues a write, replacing any queued write of the same key. Returns false
+   * without queueing it once the queue is stopped; the caller should then
+   * write it directly.
+   */
+  bool put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value);
+
+  /**
+   * Returns the value of the most recent write of key that is queued or being
+   * committed, if any.
+   */
+  std::optional<std::string> get(KeySpace keySpace, folly::ByteRange key)
+      const;
+
+  /**
+   * Blocks until all the writes queued before the call are committed.
+   */
+  void flush();
+
+  /**
+   * Commits the queued writes and stops the background thread. Later puts
+   * are refused.
+   */
+  void stop();
+
+ private:
+  void run();
+
+  const std::chrono::milliseconds interval_;
+  const size_t maxPendingBytes_;
+  CommitFn commit_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  Pending pending_;
+  // The writes currently being committed by the background thread. Only that
+  // thread modifies it, while holding mutex_, so it can read it unlocked.
+  Pending committing_;
+  size_t pendingBytes_{0};
+  // Writes are numbered so that flush() knows when its writes are committed.
+  uint64_t queuedCount_{0};
+  uint64_t committedCount_{0};
+  bool flushRequested_{false};
+  bool stopping_{false};
+
+  std::thread thread_;
+};
+
+} // namespace facebook::eden
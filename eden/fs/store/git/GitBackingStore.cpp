@@ -8,8 +8,12 @@
 #include "GitBackingStore.h"
 
 #include <folly/Conv.h>
+#include <folly/ScopeGuard.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
+#include <gflags/gflags.h>
 #include <git2.h>
 
 #include "eden/fs/model/Blob.h"
@@ -24,13 +28,17 @@
 
 using folly::ByteRange;
 using folly::IOBuf;
-using folly::makeSemiFuture;
 using folly::SemiFuture;
 using folly::StringPiece;
 using std::make_unique;
 using std::string;
 using std::unique_ptr;
 
+DEFINE_int32(
+    num_git_import_threads,
+    8,
+    "the number of threads reading objects out of git repositories");
+
 namespace {
 
 template <typename... Args>
@@ -51,22 +59,64 @@ void freeBlobIOBufData(void* /*blobData*/, void* blobObject) {
 
 namespace facebook::eden {
 
-GitBackingStore::GitBackingStore(AbsolutePathPiece repository) {
+GitBackingStore::GitBackingStore(AbsolutePathPiece repository)
+    : repositoryPath_{repository.copy()} {
   // Make sure libgit2 is initialized.
   // (git_libgit2_init() is safe to call multiple times if multiple
   // GitBackingStore objects are created.  git_libgit2_shutdown() should be
   // called once for each call to git_libgit2_init().)
   git_libgit2_init();
 
-  auto error = git_repository_open(&repo_, repository.value().str().c_str());
-  gitCheckError(error, "error opening git repository", repository);
+  repo_ = openRepository().release();
+
+  importThreadPool_ = make_unique<folly::CPUThreadPoolExecutor>(
+      FLAGS_num_git_import_threads,
+      // Like the hg import pool, never block or fail when queueing a read.
+      make_unique<folly::UnboundedBlockingQueue<
+          folly::CPUThreadPoolExecutor::CPUTask>>(),
+      std::make_shared<folly::NamedThreadFactory>("GitImporter"));
 }
 
 GitBackingStore::~GitBackingStore() {
+  // Wait for the pending reads before freeing the repositories they use.
+  importThreadPool_.reset();
+  idleRepositories_.wlock()->clear();
   git_repository_free(repo_);
   git_libgit2_shutdown();
 }
 
+void GitBackingStore::RepositoryDeleter::operator()(
+    git_repository* repo) const {
+  git_repository_free(repo);
+}
+
+GitBackingStore::RepositoryPtr GitBackingStore::openRepository() const {
+  git_repository* repo = nullptr;
+  auto error =
+      git_repository_open(&repo, repositoryPath_.value().str().c_str());
+  gitCheckError(error, "error opening git repository", repositoryPath_);
+  return RepositoryPtr{repo};
+}
+
+template <typename Fn>
+auto GitBackingStore::withRepository(Fn&& fn) {
+  RepositoryPtr repo;
+  {
+    auto idle = idleRepositories_.wlock();
+    if (!idle->empty()) {
+      repo = std::move(idle->back());
+      idle->pop_back();
+    }
+  }
+  if (!repo) {
+    repo = openRepository();
+  }
+  SCOPE_EXIT {
+    idleRepositories_.wlock()->push_back(std::move(repo));
+  };
+  return fn(repo.get());
+}
+
 const char* GitBackingStore::getPath() const {
   return git_repository_path(repo_);
 }
@@ -84,13 +134,25 @@ std::string GitBackingStore::renderRootId(const RootId& rootId) {
 SemiFuture<unique_ptr<Tree>> GitBackingStore::getRootTree(
     const RootId& rootId,
     ObjectFetchContext& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
+  return folly::via(
+             importThreadPool_.get(),
+             [this, rootId] {
+               return withRepository([&](git_repository* repo) {
+                 return getRootTreeImpl(repo, rootId);
+               });
+             })
+      .semi();
+}
+
+unique_ptr<Tree> GitBackingStore::getRootTreeImpl(
+    git_repository* repo,
+    const RootId& rootId) {
   XLOG(DBG4) << "resolving tree for commit " << rootId;
 
   // Look up the commit info
   git_oid commitOID = root2Oid(rootId);
   git_commit* commit = nullptr;
-  auto error = git_commit_lookup(&commit, repo_, &commitOID);
+  auto error = git_commit_lookup(&commit, repo, &commitOID);
   gitCheckError(
       error,
       "unable to find git commit ",
@@ -105,23 +167,31 @@ SemiFuture<unique_ptr<Tree>> GitBackingStore::getRootTree(
   ObjectId treeID = oid2Hash(git_commit_tree_id(commit));
 
   // Now get the specified tree.
-  return getTreeImpl(treeID);
+  return getTreeImpl(repo, treeID);
 }
 
 SemiFuture<BackingStore::GetTreeRes> GitBackingStore::getTree(
     const ObjectId& id,
     ObjectFetchContext& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
-  return makeSemiFuture(BackingStore::GetTreeRes{
-      getTreeImpl(id), ObjectFetchContext::Origin::FromDiskCache});
+  return folly::via(
+             importThreadPool_.get(),
+             [this, id] {
+               auto tree = withRepository(
+                   [&](git_repository* repo) { return getTreeImpl(repo, id); });
+               return BackingStore::GetTreeRes{
+                   std::move(tree), ObjectFetchContext::Origin::FromDiskCache};
+             })
+      .semi();
 }
 
-unique_ptr<Tree> GitBackingStore::getTreeImpl(const ObjectId& id) {
+unique_ptr<Tree> GitBackingStore::getTreeImpl(
+    git_repository* repo,
+    const ObjectId& id) {
   XLOG(DBG4) << "importing tree " << id;
 
   git_oid treeOID = hash2Oid(id);
   git_tree* gitTree = nullptr;
-  auto error = git_tree_lookup(&gitTree, repo_, &treeOID);
+  auto error = git_tree_lookup(&gitTree, repo, &treeOID);
   gitCheckError(
       error, "unable to find git tree ", id, " in repository ", getPath());
   SCOPE_EXIT {
@@ -162,17 +232,25 @@ unique_ptr<Tree> GitBackingStore::getTreeImpl(const ObjectId& id) {
 SemiFuture<BackingStore::GetBlobRes> GitBackingStore::getBlob(
     const ObjectId& id,
     ObjectFetchContext& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
-  return makeSemiFuture(BackingStore::GetBlobRes{
-      getBlobImpl(id), ObjectFetchContext::Origin::FromDiskCache});
+  return folly::via(
+             importThreadPool_.get(),
+             [this, id] {
+               auto blob = withRepository(
+                   [&](git_repository* repo) { return getBlobImpl(repo, id); });
+               return BackingStore::GetBlobRes{
+                   std::move(blob), ObjectFetchContext::Origin::FromDiskCache};
+             })
+      .semi();
 }
 
-unique_ptr<Blob> GitBackingStore::getBlobImpl(const ObjectId& id) {
+unique_ptr<Blob> GitBackingStore::getBlobImpl(
+    git_repository* repo,
+    const ObjectId& id) {
   XLOG(DBG5) << "importing blob " << id;
 
   auto blobOID = hash2Oid(id);
   git_blob* blob = nullptr;
-  int error = git_blob_lookup(&blob, repo_, &blobOID);
+  int error = git_blob_lookup(&blob, repo, &blobOID);
   gitCheckError(
       error, "unable to find git blob ", id, " in repository ", getPath());
 
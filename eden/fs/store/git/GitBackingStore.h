@@ -8,6 +8,9 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <memory>
+#include <vector>
 
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
@@ -16,10 +19,19 @@
 struct git_oid;
 struct git_repository;
 
+namespace folly {
+class Executor;
+}
+
 namespace facebook::eden {
 
 /**
  * A BackingStore implementation that loads data out of a git repository.
+ *
+ * Objects are read on a dedicated pool of threads. A git_repository must not
+ * be used by several threads at once, so each read borrows a handle from a
+ * pool of open repositories. Each handle keeps its own object cache and pack
+ * indexes open across the reads that borrow it.
  */
 class GitBackingStore final : public BackingStore {
  public:
@@ -64,15 +76,38 @@ class GitBackingStore final : public BackingStore {
   GitBackingStore(GitBackingStore const&) = delete;
   GitBackingStore& operator=(GitBackingStore const&) = delete;
 
-  std::unique_ptr<Tree> getTreeImpl(const ObjectId& id);
-  std::unique_ptr<Blob> getBlobImpl(const ObjectId& id);
+  struct RepositoryDeleter {
+    void operator()(git_repository* repo) const;
+  };
+  using RepositoryPtr = std::unique_ptr<git_repository, RepositoryDeleter>;
+
+  RepositoryPtr openRepository() const;
+
+  /**
+   * Runs fn with a git_repository that no other thread uses until fn returns.
+   */
+  template <typename Fn>
+  auto withRepository(Fn&& fn);
+
+  std::unique_ptr<Tree> getRootTreeImpl(
+      git_repository* repo,
+      const RootId& rootId);
+  std::unique_ptr<Tree> getTreeImpl(git_repository* repo, const ObjectId& id);
+  std::unique_ptr<Blob> getBlobImpl(git_repository* repo, const ObjectId& id);
 
   static git_oid root2Oid(const RootId& rootId);
 
   static git_oid hash2Oid(const ObjectId& hash);
   static ObjectId oid2Hash(const git_oid* oid);
 
+  AbsolutePath repositoryPath_;
   git_repository* repo_{nullptr};
+
+  // Repositories not currently borrowed by a read. There are at most as many
+  // as there are import threads.
+  folly::Synchronized<std::vector<RepositoryPtr>> idleRepositories_;
+
+  std::unique_ptr<folly::Executor> importThreadPool_;
 };
 
 } // namespace facebook::eden
@@ -268,6 +268,13 @@ SemiFuture<unique_ptr<Tree>> HgBackingStore::getTree(
 void HgBackingStore::getTreeBatch(
     const std::vector<std::shared_ptr<HgImportRequest>>& requests,
     bool prefetchMetadata) {
+  getMixedBatch(requests, {}, prefetchMetadata);
+}
+
+void HgBackingStore::getMixedBatch(
+    const std::vector<std::shared_ptr<HgImportRequest>>& requests,
+    const std::vector<std::shared_ptr<HgImportRequest>>& blobRequests,
+    bool prefetchMetadata) {
   std::vector<folly::Promise<std::unique_ptr<Tree>>> innerPromises;
   innerPromises.reserve(requests.size());
   std::vector<folly::SemiFuture<std::unique_ptr<TreeMetadata>>> metadataFutures;
@@ -292,7 +299,12 @@ void HgBackingStore::getTreeBatch(
 
   {
     auto writeBatch = localStore_->beginWrite();
-    datapackStore_.getTreeBatch(requests, writeBatch.get(), &innerPromises);
+    if (blobRequests.empty()) {
+      datapackStore_.getTreeBatch(requests, writeBatch.get(), &innerPromises);
+    } else {
+      datapackStore_.getMixedBatch(
+          requests, blobRequests, writeBatch.get(), &innerPromises);
+    }
   }
 
   // Receive the fetches and tie the content and metadata together if needed.
@@ -568,17 +580,15 @@ std::unique_ptr<Tree> HgBackingStore::processTree(
     LocalStore::WriteBatch* writeBatch) {
   auto manifest = Manifest(std::move(content));
   std::vector<TreeEntry> entries;
-  auto directObjectId = config_->getEdenConfig()->directObjectId.getValue();
+  auto format = getHgObjectIdFormat(*config_->getEdenConfig());
 
   for (auto& entry : manifest) {
     XLOG(DBG9) << "tree: " << manifestNode << " " << entry.name
                << " node: " << entry.node << " flag: " << entry.type;
 
     auto relPath = path + entry.name;
-    auto proxyHash = HgProxyHash::store(
-        relPath,
-        entry.node,
-        directObjectId ? std::nullopt : std::optional{writeBatch});
+    auto proxyHash =
+        HgProxyHash::store(relPath, entry.node, format, writeBatch);
 
     entries.emplace_back(proxyHash, std::move(entry.name), entry.type);
   }
@@ -640,12 +650,13 @@ folly::Future<std::unique_ptr<Tree>> HgBackingStore::importTreeManifestImpl(
     bool prefetchMetadata) {
   // Record that we are at the root for this node
   RelativePathPiece path{};
-  auto directObjectId = config_->getEdenConfig()->directObjectId.getValue();
+  auto directObjectId = getHgObjectIdFormat(*config_->getEdenConfig()) !=
+      HgObjectIdFormat::ProxyHash;
   ObjectId objectId;
   std::pair<ObjectId, std::string> computedPair;
   if (directObjectId) { // unfortunately we have to know about internals of
                         // proxy hash here
-    objectId = HgProxyHash::makeEmbeddedProxyHash(manifestNode);
+    objectId = HgProxyHash::makeEmbeddedProxyHash(path, manifestNode);
   } else {
     computedPair = HgProxyHash::prepareToStoreLegacy(path, manifestNode);
     objectId = computedPair.first;
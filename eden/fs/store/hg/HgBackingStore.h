@@ -79,6 +79,15 @@ class HgBackingStore {
   void getTreeBatch(
       const std::vector<std::shared_ptr<HgImportRequest>>& requests,
       bool prefetchMetadata);
+  /**
+   * Like getTreeBatch, but also imports blobRequests from the hgcache and
+   * EdenAPI concurrently with the trees. Blob requests are resolved as by
+   * HgDatapackStore::getBlobBatch.
+   */
+  void getMixedBatch(
+      const std::vector<std::shared_ptr<HgImportRequest>>& treeRequests,
+      const std::vector<std::shared_ptr<HgImportRequest>>& blobRequests,
+      bool prefetchMetadata);
   void processTreeMetadata(
       folly::SemiFuture<std::unique_ptr<TreeMetadata>>&& treeMetadataFuture,
       const Tree& tree);
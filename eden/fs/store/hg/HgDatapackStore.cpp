@@ -8,10 +8,13 @@
 #include "eden/fs/store/hg/HgDatapackStore.h"
 
 #include <folly/Optional.h>
+#include <folly/ScopeGuard.h>
 #include <folly/io/IOBuf.h>
 #include <folly/logging/xlog.h>
 #include <memory>
 #include <optional>
+#include <string>
+#include <thread>
 
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/model/Blob.h"
@@ -40,26 +43,63 @@ TreeEntryType fromRawTreeEntryType(RustTreeEntryType type) {
              << " loaded from data store";
 }
 
+/**
+ * Builds the paths of the entries of a tree in one buffer, instead of
+ * allocating a RelativePath per entry.
+ */
+class EntryPathBuilder {
+ public:
+  explicit EntryPathBuilder(RelativePathPiece treePath)
+      : buffer_{treePath.stringPiece().str()}, treePathSize_{buffer_.size()} {}
+
+  /**
+   * Returns the path of the named entry, valid until the next call.
+   */
+  RelativePathPiece entryPath(PathComponentPiece name) {
+    buffer_.resize(treePathSize_);
+    if (treePathSize_ != 0) {
+      buffer_.push_back('/');
+    }
+    auto piece = name.stringPiece();
+    buffer_.append(piece.begin(), piece.end());
+    // Both the tree path and the name are known to be valid.
+    return RelativePathPiece{buffer_, detail::SkipPathSanityCheck{}};
+  }
+
+ private:
+  std::string buffer_;
+  size_t treePathSize_;
+};
+
 TreeEntry fromRawTreeEntry(
     RustTreeEntry entry,
-    RelativePathPiece path,
-    std::optional<LocalStore::WriteBatch*> writeBatch) {
+    const RustFileAuxData* FOLLY_NULLABLE aux,
+    EntryPathBuilder& pathBuilder,
+    HgObjectIdFormat format,
+    LocalStore::WriteBatch* FOLLY_NULLABLE writeBatch) {
   std::optional<uint64_t> size;
   std::optional<Hash20> contentSha1;
 
   if (entry.size != nullptr) {
     size = *entry.size;
+  } else if (aux) {
+    size = aux->total_size;
   }
 
   if (entry.content_sha1 != nullptr) {
     contentSha1 = Hash20{*entry.content_sha1};
+  } else if (aux) {
+    contentSha1 = Hash20{aux->content_sha1};
   }
 
   auto name = PathComponent(folly::StringPiece{entry.name.asByteRange()});
   auto hash = Hash20{entry.hash};
 
-  auto fullPath = path + name;
-  auto proxyHash = HgProxyHash::store(fullPath, hash, writeBatch);
+  // Only build the entry path for the formats that use it.
+  auto proxyHash = format == HgObjectIdFormat::HashOnly
+      ? HgProxyHash::makeEmbeddedProxyHash(hash)
+      : HgProxyHash::store(
+            pathBuilder.entryPath(name), hash, format, writeBatch);
 
   return TreeEntry{
       proxyHash,
@@ -69,17 +109,37 @@ TreeEntry fromRawTreeEntry(
       contentSha1};
 }
 
+using RawAuxData = std::vector<std::shared_ptr<RustFileAuxData>>;
+
+/**
+ * Converts a tree imported from the backing store. writeBatch receives the
+ * proxy hashes of the entries, it is only used, and must then be set, when
+ * format is HgObjectIdFormat::ProxyHash. `aux`, if given, is parallel to the
+ * tree entries and fills in the size and SHA-1 of the entries that don't
+ * carry them.
+ */
 FOLLY_MAYBE_UNUSED std::unique_ptr<Tree> fromRawTree(
     const RustTree* tree,
     const ObjectId& edenTreeId,
     RelativePathPiece path,
-    LocalStore::WriteBatch* FOLLY_NULLABLE writeBatch) {
+    HgObjectIdFormat format,
+    LocalStore::WriteBatch* FOLLY_NULLABLE writeBatch,
+    const RawAuxData* FOLLY_NULLABLE aux = nullptr) {
+  if (format != HgObjectIdFormat::ProxyHash) {
+    writeBatch = nullptr;
+  }
   std::vector<TreeEntry> entries;
+  entries.reserve(tree->length);
+  EntryPathBuilder pathBuilder{path};
 
   for (uintptr_t i = 0; i < tree->length; i++) {
     try {
-      auto entry = fromRawTreeEntry(tree->entries[i], path, writeBatch);
-      entries.push_back(entry);
+      entries.push_back(fromRawTreeEntry(
+          tree->entries[i],
+          aux ? (*aux)[i].get() : nullptr,
+          pathBuilder,
+          format,
+          writeBatch));
     } catch (const PathComponentContainsDirectorySeparator& ex) {
       XLOG(WARN) << "Ignoring directory entry: " << ex.what();
     }
@@ -89,6 +149,83 @@ FOLLY_MAYBE_UNUSED std::unique_ptr<Tree> fromRawTree(
   }
   return std::make_unique<Tree>(std::move(entries), edenTreeId);
 }
+
+using RawRequests = std::vector<std::pair<folly::ByteRange, folly::ByteRange>>;
+
+template <typename ImportType>
+RawRequests toRawRequests(
+    const std::vector<std::shared_ptr<HgImportRequest>>& importRequests) {
+  RawRequests requests;
+  requests.reserve(importRequests.size());
+
+  for (const auto& importRequest : importRequests) {
+    auto& proxyHash = importRequest->getRequest<ImportType>()->proxyHash;
+    requests.emplace_back(
+        folly::ByteRange{proxyHash.path().stringPiece()}, proxyHash.byteHash());
+  }
+  return requests;
+}
+
+/**
+ * Returns the callback fulfilling the blob import requests as their content
+ * gets imported. Both vectors must outlive the batch.
+ */
+auto makeBlobResolver(
+    const std::vector<std::shared_ptr<HgImportRequest>>& importRequests,
+    const RawRequests& requests) {
+  return [&importRequests, &requests](
+             size_t index, std::unique_ptr<folly::IOBuf> content) {
+    XLOGF(
+        DBG9,
+        "Imported name={} node={}",
+        folly::StringPiece{requests[index].first},
+        folly::hexlify(requests[index].second));
+    auto& importRequest = importRequests[index];
+    auto* blobRequest =
+        importRequest->getRequest<HgImportRequest::BlobImport>();
+    auto blob = std::make_unique<Blob>(blobRequest->hash, *content);
+    importRequest->getPromise<std::unique_ptr<Blob>>()->setValue(
+        std::move(blob));
+  };
+}
+
+/**
+ * Returns the callback fulfilling the tree promises as the trees get
+ * imported, along with the aux data of their files if it was imported too.
+ * The vectors must outlive the batch.
+ */
+auto makeTreeResolver(
+    const std::vector<std::shared_ptr<HgImportRequest>>& importRequests,
+    const RawRequests& requests,
+    HgObjectIdFormat format,
+    LocalStore::WriteBatch* FOLLY_NULLABLE writeBatch,
+    std::vector<folly::Promise<std::unique_ptr<Tree>>>* promises) {
+  return [promises, &requests, &importRequests, format, writeBatch](
+             size_t index,
+             std::shared_ptr<RustTree> content,
+             const RawAuxData* FOLLY_NULLABLE aux) mutable {
+    auto& promise = (*promises)[index];
+    promise.setWith([&] {
+      XLOGF(
+          DBG4,
+          "Imported tree name={} node={}",
+          folly::StringPiece{requests[index].first},
+          folly::hexlify(requests[index].second));
+
+      auto& importRequest = importRequests[index];
+      auto* treeRequest =
+          importRequest->getRequest<HgImportRequest::TreeImport>();
+
+      return fromRawTree(
+          content.get(),
+          treeRequest->hash,
+          treeRequest->proxyHash.path(),
+          format,
+          writeBatch,
+          aux);
+    });
+  };
+}
 } // namespace
 
 std::unique_ptr<Blob> HgDatapackStore::getBlobLocal(
@@ -108,13 +245,15 @@ std::unique_ptr<Tree> HgDatapackStore::getTreeLocal(
     const HgProxyHash& proxyHash,
     LocalStore& localStore) {
   auto tree = store_.getTree(proxyHash.byteHash(), /*local=*/true);
-  auto directObjectId = config_->getEdenConfig()->directObjectId.getValue();
+  auto format = getHgObjectIdFormat(*config_->getEdenConfig());
   if (tree) {
     return fromRawTree(
         tree.get(),
         edenTreeId,
         proxyHash.path(),
-        directObjectId ? NULL : localStore.beginWrite().get());
+        format,
+        format == HgObjectIdFormat::ProxyHash ? localStore.beginWrite().get()
+                                              : nullptr);
   }
 
   return nullptr;
@@ -122,76 +261,87 @@ std::unique_ptr<Tree> HgDatapackStore::getTreeLocal(
 
 void HgDatapackStore::getBlobBatch(
     const std::vector<std::shared_ptr<HgImportRequest>>& importRequests) {
-  std::vector<std::pair<folly::ByteRange, folly::ByteRange>> requests;
-
-  size_t count = importRequests.size();
-  requests.reserve(count);
-
-  for (const auto& importRequest : importRequests) {
-    auto& proxyHash =
-        importRequest->getRequest<HgImportRequest::BlobImport>()->proxyHash;
-    requests.emplace_back(
-        folly::ByteRange{proxyHash.path().stringPiece()}, proxyHash.byteHash());
-  }
-
+  auto requests = toRawRequests<HgImportRequest::BlobImport>(importRequests);
   store_.getBlobBatch(
-      requests,
-      false,
-      [&importRequests, &requests](
-          size_t index, std::unique_ptr<folly::IOBuf> content) {
-        XLOGF(
-            DBG9,
-            "Imported name={} node={}",
-            folly::StringPiece{requests[index].first},
-            folly::hexlify(requests[index].second));
-        auto& importRequest = importRequests[index];
-        auto* blobRequest =
-            importRequest->getRequest<HgImportRequest::BlobImport>();
-        auto blob = std::make_unique<Blob>(blobRequest->hash, *content);
-        importRequest->getPromise<std::unique_ptr<Blob>>()->setValue(
-            std::move(blob));
-      });
+      requests, false, makeBlobResolver(importRequests, requests));
 }
 
 void HgDatapackStore::getTreeBatch(
     const std::vector<std::shared_ptr<HgImportRequest>>& importRequests,
     LocalStore::WriteBatch* writeBatch,
     std::vector<folly::Promise<std::unique_ptr<Tree>>>* promises) {
-  std::vector<std::pair<folly::ByteRange, folly::ByteRange>> requests;
-  requests.reserve(importRequests.size());
+  auto requests = toRawRequests<HgImportRequest::TreeImport>(importRequests);
+  auto config = config_->getEdenConfig();
+  auto resolve = makeTreeResolver(
+      importRequests,
+      requests,
+      getHgObjectIdFormat(*config),
+      writeBatch,
+      promises);
+  if (config->importTreeAuxData.getValue()) {
+    store_.getTreeWithAuxBatch(
+        requests,
+        false,
+        [&resolve](
+            size_t index,
+            std::shared_ptr<RustTree> content,
+            RawAuxData aux) { resolve(index, std::move(content), &aux); });
+  } else {
+    store_.getTreeBatch(
+        requests,
+        false,
+        [&resolve](size_t index, std::shared_ptr<RustTree> content) {
+          resolve(index, std::move(content), nullptr);
+        });
+  }
+}
 
-  for (const auto& importRequest : importRequests) {
-    auto& proxyHash =
-        importRequest->getRequest<HgImportRequest::TreeImport>()->proxyHash;
-    requests.emplace_back(
-        folly::ByteRange{proxyHash.path().stringPiece()}, proxyHash.byteHash());
+void HgDatapackStore::getMixedBatch(
+    const std::vector<std::shared_ptr<HgImportRequest>>& treeImportRequests,
+    const std::vector<std::shared_ptr<HgImportRequest>>& blobImportRequests,
+    LocalStore::WriteBatch* writeBatch,
+    std::vector<folly::Promise<std::unique_ptr<Tree>>>* treePromises) {
+  if (config_->getEdenConfig()->importTreeAuxData.getValue()) {
+    if (treeImportRequests.empty()) {
+      getBlobBatch(blobImportRequests);
+      return;
+    }
+    if (blobImportRequests.empty()) {
+      getTreeBatch(treeImportRequests, writeBatch, treePromises);
+      return;
+    }
+    // The aux data is imported after the trees it belongs to, keep the
+    // blobs importing concurrently as HgNativeBackingStore::getMixedBatch
+    // does.
+    std::thread treeThread{[&] {
+      getTreeBatch(treeImportRequests, writeBatch, treePromises);
+    }};
+    SCOPE_EXIT {
+      treeThread.join();
+    };
+    getBlobBatch(blobImportRequests);
+    return;
   }
-  auto directObjectId = config_->getEdenConfig()->directObjectId.getValue();
 
-  store_.getTreeBatch(
-      requests,
+  auto treeRequests =
+      toRawRequests<HgImportRequest::TreeImport>(treeImportRequests);
+  auto blobRequests =
+      toRawRequests<HgImportRequest::BlobImport>(blobImportRequests);
+  auto format = getHgObjectIdFormat(*config_->getEdenConfig());
+  store_.getMixedBatch(
+      treeRequests,
+      blobRequests,
       false,
-      [directObjectId, promises, &requests, &importRequests, writeBatch](
+      [resolve = makeTreeResolver(
+           treeImportRequests,
+           treeRequests,
+           format,
+           writeBatch,
+           treePromises)](
           size_t index, std::shared_ptr<RustTree> content) mutable {
-        auto& promise = (*promises)[index];
-        promise.setWith([&] {
-          XLOGF(
-              DBG4,
-              "Imported tree name={} node={}",
-              folly::StringPiece{requests[index].first},
-              folly::hexlify(requests[index].second));
-
-          auto& importRequest = importRequests[index];
-          auto* treeRequest =
-              importRequest->getRequest<HgImportRequest::TreeImport>();
-
-          return fromRawTree(
-              content.get(),
-              treeRequest->hash,
-              treeRequest->proxyHash.path(),
-              directObjectId ? NULL : writeBatch);
-        });
-      });
+        resolve(index, std::move(content), nullptr);
+      },
+      makeBlobResolver(blobImportRequests, blobRequests));
 }
 
 std::unique_ptr<Tree> HgDatapackStore::getTree(
@@ -214,9 +364,12 @@ std::unique_ptr<Tree> HgDatapackStore::getTree(
     tree = store_.getTree(manifestId.getBytes(), false);
   }
   if (tree) {
-    auto directObjectId = config_->getEdenConfig()->directObjectId.getValue();
     return fromRawTree(
-        tree.get(), edenTreeId, path, directObjectId ? NULL : writeBatch);
+        tree.get(),
+        edenTreeId,
+        path,
+        getHgObjectIdFormat(*config_->getEdenConfig()),
+        writeBatch);
   }
   return nullptr;
 }
@@ -60,6 +60,16 @@ class HgDatapackStore {
       LocalStore::WriteBatch* writeBatch,
       std::vector<folly::Promise<std::unique_ptr<Tree>>>* promises);
 
+  /**
+   * Import a batch of trees and a batch of blobs concurrently, resolving the
+   * promises as getTreeBatch and getBlobBatch do.
+   */
+  void getMixedBatch(
+      const std::vector<std::shared_ptr<HgImportRequest>>& treeRequests,
+      const std::vector<std::shared_ptr<HgImportRequest>>& blobRequests,
+      LocalStore::WriteBatch* writeBatch,
+      std::vector<folly::Promise<std::unique_ptr<Tree>>>* treePromises);
+
   std::unique_ptr<Tree> getTree(
       const RelativePath& path,
       const Hash20& manifestId,
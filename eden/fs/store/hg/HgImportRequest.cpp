@@ -19,40 +19,49 @@ template <typename RequestType>
 HgImportRequest::HgImportRequest(
     RequestType request,
     ImportPriority priority,
+    std::optional<pid_t> pid,
     folly::Promise<typename RequestType::Response>&& promise)
     : request_(std::move(request)),
       priority_(priority),
+      pid_(pid),
       promise_(std::move(promise)) {}
 
 template <typename RequestType, typename... Input>
 std::shared_ptr<HgImportRequest> HgImportRequest::makeRequest(
     ImportPriority priority,
+    std::optional<pid_t> pid,
     Input&&... input) {
   auto promise = folly::Promise<typename RequestType::Response>{};
   return std::make_shared<HgImportRequest>(
-      RequestType{std::forward<Input>(input)...}, priority, std::move(promise));
+      RequestType{std::forward<Input>(input)...},
+      priority,
+      pid,
+      std::move(promise));
 }
 
 std::shared_ptr<HgImportRequest> HgImportRequest::makeBlobImportRequest(
     ObjectId hash,
     HgProxyHash proxyHash,
-    ImportPriority priority) {
-  return makeRequest<BlobImport>(priority, hash, std::move(proxyHash));
+    ImportPriority priority,
+    std::optional<pid_t> pid) {
+  return makeRequest<BlobImport>(priority, pid, hash, std::move(proxyHash));
 }
 
 std::shared_ptr<HgImportRequest> HgImportRequest::makeTreeImportRequest(
     ObjectId hash,
     HgProxyHash proxyHash,
     ImportPriority priority,
-    bool prefetchMetadata) {
+    bool prefetchMetadata,
+    std::optional<pid_t> pid) {
   return makeRequest<TreeImport>(
-      priority, hash, std::move(proxyHash), prefetchMetadata);
+      priority, pid, hash, std::move(proxyHash), prefetchMetadata);
 }
 
 std::shared_ptr<HgImportRequest> HgImportRequest::makePrefetchRequest(
     std::vector<HgProxyHash> hashes,
-    ImportPriority priority) {
-  return makeRequest<Prefetch>(priority, std::move(hashes));
+    ImportPriority priority,
+    std::optional<pid_t> pid) {
+  return makeRequest<Prefetch>(priority, pid, std::move(hashes));
 }
 
 } // namespace facebook::eden
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <folly/futures/Promise.h>
+#include <folly/portability/SysTypes.h>
+#include <optional>
 #include <utility>
 #include <variant>
 
@@ -71,11 +73,16 @@ class HgImportRequest {
 
   /**
    * Allocate a blob request.
+   *
+   * The pid of the client that caused the request, when known, is used by
+   * the HgImportRequestQueue to share the import capacity fairly between
+   * processes.
    */
   static std::shared_ptr<HgImportRequest> makeBlobImportRequest(
       ObjectId hash,
       HgProxyHash proxyHash,
-      ImportPriority priority);
+      ImportPriority priority,
+      std::optional<pid_t> pid = std::nullopt);
 
   /**
    * Allocate a tree request.
@@ -84,14 +91,16 @@ class HgImportRequest {
       ObjectId hash,
       HgProxyHash proxyHash,
       ImportPriority priority,
-      bool prefetchMetadata);
+      bool prefetchMetadata,
+      std::optional<pid_t> pid = std::nullopt);
 
   /**
    * Allocate a prefetch request.
    */
   static std::shared_ptr<HgImportRequest> makePrefetchRequest(
       std::vector<HgProxyHash> hashes,
-      ImportPriority priority);
+      ImportPriority priority,
+      std::optional<pid_t> pid = std::nullopt);
 
   /**
    * Implementation detail of the make*Request functions from above. Do not use
@@ -101,6 +110,7 @@ class HgImportRequest {
   HgImportRequest(
       RequestType request,
       ImportPriority priority,
+      std::optional<pid_t> pid,
       folly::Promise<typename RequestType::Response>&& promise);
 
   ~HgImportRequest() = default;
@@ -130,6 +140,13 @@ class HgImportRequest {
     priority_ = priority;
   }
 
+  /**
+   * The pid of the process that caused this request, if known.
+   */
+  std::optional<pid_t> getPid() const noexcept {
+    return pid_;
+  }
+
   template <typename T>
   folly::Promise<T>* getPromise() {
     auto promise = std::get_if<folly::Promise<T>>(&promise_); // Promise<T>
@@ -148,6 +165,19 @@ class HgImportRequest {
     return requestTime_;
   }
 
+  /**
+   * When the import queue handed this request to a worker, or std::nullopt
+   * if it was never dequeued, e.g. because the same object was already being
+   * imported. Only read this once the request's promise is fulfilled.
+   */
+  std::optional<std::chrono::steady_clock::time_point> getDequeueTime() const {
+    return dequeueTime_;
+  }
+
+  void setDequeueTime(std::chrono::steady_clock::time_point time) {
+    dequeueTime_ = time;
+  }
+
  private:
   /**
    * Implementation detail of the various make*Request functions.
@@ -155,6 +185,7 @@ class HgImportRequest {
   template <typename Request, typename... Input>
   static std::shared_ptr<HgImportRequest> makeRequest(
       ImportPriority priority,
+      std::optional<pid_t> pid,
       Input&&... input);
 
   HgImportRequest(const HgImportRequest&) = delete;
@@ -168,10 +199,12 @@ class HgImportRequest {
 
   Request request_;
   ImportPriority priority_;
+  std::optional<pid_t> pid_;
   Response promise_;
   uint64_t unique_ = generateUniqueID();
   std::chrono::steady_clock::time_point requestTime_ =
       std::chrono::steady_clock::now();
+  std::optional<std::chrono::steady_clock::time_point> dequeueTime_;
 
   friend bool operator<(
       const HgImportRequest& lhs,
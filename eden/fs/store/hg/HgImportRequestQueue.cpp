@@ -9,9 +9,50 @@
 #include <folly/futures/Future.h>
 #include <algorithm>
 #include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/telemetry/EdenStats.h"
 
 namespace facebook::eden {
 
+namespace {
+/**
+ * Share of the import capacity given to a pid, relative to other pids of the
+ * same priority kind. Pids whose requests were deprioritized for being fetch
+ * heavy get kDeprioritizedWeight, all the others get kDefaultWeight.
+ */
+constexpr uint64_t kDefaultWeight = 4;
+constexpr uint64_t kDeprioritizedWeight = 1;
+
+/**
+ * Bound on how far aging can raise a kind, to keep ImportPriority::value()
+ * from overflowing for queues that have been waiting for a very long time.
+ */
+constexpr size_t kMaxAgedKind = 1024;
+
+bool requestHeapCompare(
+    const std::shared_ptr<HgImportRequest>& lhs,
+    const std::shared_ptr<HgImportRequest>& rhs) {
+  return (*lhs) < (*rhs);
+}
+
+size_t kindIndex(ImportPriorityKind kind) {
+  return static_cast<size_t>(kind);
+}
+
+using StatPtr = HgBackingStoreThreadStats::Stat HgBackingStoreThreadStats::*;
+
+constexpr StatPtr kQueueDepthStats[] = {
+    &HgBackingStoreThreadStats::importQueueDepthLow,
+    &HgBackingStoreThreadStats::importQueueDepthNormal,
+    &HgBackingStoreThreadStats::importQueueDepthHigh,
+};
+
+constexpr StatPtr kQueueWaitStats[] = {
+    &HgBackingStoreThreadStats::importQueueWaitLow,
+    &HgBackingStoreThreadStats::importQueueWaitNormal,
+    &HgBackingStoreThreadStats::importQueueWaitHigh,
+};
+} // namespace
+
 void HgImportRequestQueue::stop() {
   auto state = state_.lock();
   if (state->running) {
@@ -37,12 +78,60 @@ folly::Future<folly::Unit> HgImportRequestQueue::enqueuePrefetch(
   return enqueue<folly::Unit, HgImportRequest::Prefetch>(std::move(request));
 }
 
+void HgImportRequestQueue::pushRequest(
+    TypeQueue& queue,
+    std::shared_ptr<HgImportRequest> request) {
+  auto& priorityQueue = queue[kindIndex(request->getPriority().kind)];
+  if (priorityQueue.size == 0) {
+    // The queue was idle, only start aging from now.
+    priorityQueue.lastServed = std::chrono::steady_clock::now();
+  }
+
+  auto [it, inserted] =
+      priorityQueue.pids.try_emplace(request->getPid().value_or(0));
+  auto& pidQueue = it->second;
+  if (inserted) {
+    pidQueue.virtualTime = priorityQueue.virtualTime;
+  }
+
+  pidQueue.heap.emplace_back(std::move(request));
+  std::push_heap(
+      pidQueue.heap.begin(), pidQueue.heap.end(), requestHeapCompare);
+  ++priorityQueue.size;
+}
+
+bool HgImportRequestQueue::removeRequest(
+    TypeQueue& queue,
+    const std::shared_ptr<HgImportRequest>& request) {
+  auto& priorityQueue = queue[kindIndex(request->getPriority().kind)];
+  auto pidIt = priorityQueue.pids.find(request->getPid().value_or(0));
+  if (pidIt == priorityQueue.pids.end()) {
+    return false;
+  }
+
+  // TODO(xavierd): this has a O(n) complexity, and enqueing tons of
+  // duplicated requests will thus lead to a quadratic complexity.
+  auto& heap = pidIt->second.heap;
+  auto it = std::find(heap.begin(), heap.end(), request);
+  if (it == heap.end()) {
+    return false;
+  }
+
+  heap.erase(it);
+  std::make_heap(heap.begin(), heap.end(), requestHeapCompare);
+  --priorityQueue.size;
+  if (heap.empty()) {
+    priorityQueue.pids.erase(pidIt);
+  }
+  return true;
+}
+
 template <typename Ret, typename ImportType>
 folly::Future<Ret> HgImportRequestQueue::enqueue(
     std::shared_ptr<HgImportRequest> request) {
   auto state = state_.lock();
 
-  std::vector<std::shared_ptr<HgImportRequest>>* queue;
+  TypeQueue* queue;
   if constexpr (std::is_same_v<ImportType, HgImportRequest::BlobImport>) {
     queue = &state->blobQueue;
   } else if constexpr (std::
@@ -65,111 +154,286 @@ folly::Future<Ret> HgImportRequestQueue::enqueue(
       trackedImport->promises.emplace_back(std::move(promise));
 
       if (existingRequest->getPriority() < request->getPriority()) {
-        existingRequest->setPriority(request->getPriority());
-
         // Since the new request has a higher priority than the already present
-        // one, we need to re-order the heap.
-        //
-        // TODO(xavierd): this has a O(n) complexity, and enqueing tons of
-        // duplicated requests will thus lead to a quadratic complexity.
-        std::make_heap(
-            queue->begin(),
-            queue->end(),
-            [](const std::shared_ptr<HgImportRequest>& lhs,
-               const std::shared_ptr<HgImportRequest>& rhs) {
-              return (*lhs) < (*rhs);
-            });
+        // one, it needs to be re-filed, possibly under a different kind. If
+        // the request was already dequeued, only its priority is updated.
+        bool queued = removeRequest(*queue, existingRequest);
+        existingRequest->setPriority(request->getPriority());
+        if (queued) {
+          pushRequest(*queue, existingRequest);
+        }
       }
 
       return std::move(future).toUnsafeFuture();
     }
   }
 
-  queue->emplace_back(request);
   auto promise = request->getPromise<Ret>();
 
   if constexpr (!std::is_same_v<ImportType, HgImportRequest::Prefetch>) {
     const auto& hash = request->getRequest<ImportType>()->hash;
-    state->requestTracker.emplace(hash, std::move(request));
+    state->requestTracker.emplace(hash, request);
   }
 
-  std::push_heap(
-      queue->begin(),
-      queue->end(),
-      [](const std::shared_ptr<HgImportRequest>& lhs,
-         const std::shared_ptr<HgImportRequest>& rhs) {
-        return (*lhs) < (*rhs);
-      });
+  pushRequest(*queue, std::move(request));
 
   queueCV_.notify_one();
 
   return promise->getFuture();
 }
 
-std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue() {
-  size_t count;
-  std::vector<std::shared_ptr<HgImportRequest>>* queue = nullptr;
+void HgImportRequestQueue::recordBlobBatchLatency(
+    size_t batchSize,
+    std::chrono::microseconds latency) {
+  auto target = std::chrono::duration_cast<std::chrono::microseconds>(
+      config_->getEdenConfig()->importBatchTargetLatency.getValue());
+  state_.lock()->blobBatchSizer.recordLatency(batchSize, latency, target);
+}
 
-  auto state = state_.lock();
-  while (true) {
-    if (!state->running) {
-      state->treeQueue.clear();
-      state->blobQueue.clear();
-      state->prefetchQueue.clear();
-      return std::vector<std::shared_ptr<HgImportRequest>>();
+void HgImportRequestQueue::recordTreeBatchLatency(
+    size_t batchSize,
+    std::chrono::microseconds latency) {
+  auto target = std::chrono::duration_cast<std::chrono::microseconds>(
+      config_->getEdenConfig()->importBatchTargetLatency.getValue());
+  state_.lock()->treeBatchSizer.recordLatency(batchSize, latency, target);
+}
+
+size_t HgImportRequestQueue::getBatchSize(
+    const TypeQueue& queue,
+    ImportBatchSizer& sizer,
+    size_t configured,
+    size_t maximum) const {
+  auto config = config_->getEdenConfig();
+  if (!config->importBatchAdaptive.getValue()) {
+    return configured;
+  }
+
+  size_t depth = 0;
+  for (const auto& priorityQueue : queue) {
+    depth += priorityQueue.size;
+  }
+
+  sizer.setBounds(configured, maximum);
+  return sizer.getBatchSize(depth, config->numBackingstoreThreads.getValue());
+}
+
+std::pair<HgImportRequestQueue::PriorityQueue*, ImportPriority>
+HgImportRequestQueue::selectQueue(
+    TypeQueue& queue,
+    std::chrono::steady_clock::time_point now) const {
+  auto agingInterval =
+      config_->getEdenConfig()->importQueueAgingInterval.getValue();
+
+  PriorityQueue* selected = nullptr;
+  size_t selectedKind = 0;
+  // Walk from the highest kind down so that, when aging brings a lower kind
+  // to the level of a higher one, the higher one keeps precedence.
+  for (size_t kind = kNumPriorityKinds; kind-- > 0;) {
+    auto& priorityQueue = queue[kind];
+    if (priorityQueue.size == 0) {
+      continue;
     }
 
-    ImportPriority highestPriority{ImportPriorityKind::Low, 0};
-
-    // Trees have a higher priority than blobs who themself have a higher
-    // priority than prefetch, thus check the queues in that order.
-    // The reason for trees having a higher priority is due to trees allowing a
-    // higher fan-out and thus increasing concurrency of fetches which
-    // translate onto a higher overall throughput.
-    if (!state->treeQueue.empty()) {
-      count = config_->getEdenConfig()->importBatchSizeTree.getValue();
-      highestPriority = state->treeQueue.front()->getPriority();
-      queue = &state->treeQueue;
+    // The aged kind is deliberately not capped at High: a queue that has
+    // been starved for long enough must be able to overtake a busy High
+    // queue.
+    size_t agedKind = kind;
+    if (agingInterval.count() > 0) {
+      auto waited = now - priorityQueue.lastServed;
+      agedKind = std::min<size_t>(kMaxAgedKind, kind + waited / agingInterval);
     }
 
-    if (!state->blobQueue.empty()) {
-      auto priority = state->blobQueue.front()->getPriority();
-      if (!queue || priority > highestPriority) {
-        queue = &state->blobQueue;
-        count = config_->getEdenConfig()->importBatchSize.getValue();
+    if (!selected || agedKind > selectedKind) {
+      selected = &priorityQueue;
+      selectedKind = agedKind;
+    }
+  }
+
+  if (!selected) {
+    return {nullptr, ImportPriority::kLow()};
+  }
+
+  auto offset = selectPid(*selected).heap.front()->getPriority().offset;
+  return {
+      selected,
+      ImportPriority{static_cast<ImportPriorityKind>(selectedKind), offset}};
+}
+
+HgImportRequestQueue::PidQueue& HgImportRequestQueue::selectPid(
+    PriorityQueue& queue) {
+  PidQueue* selected = nullptr;
+  for (auto& [pid, pidQueue] : queue.pids) {
+    if (!selected || pidQueue.virtualTime < selected->virtualTime) {
+      selected = &pidQueue;
+    }
+  }
+  return *selected;
+}
+
+std::shared_ptr<HgImportRequest> HgImportRequestQueue::popRequest(
+    PriorityQueue& queue,
+    std::chrono::steady_clock::time_point now) {
+  auto& pidQueue = selectPid(queue);
+  auto& heap = pidQueue.heap;
+
+  std::pop_heap(heap.begin(), heap.end(), requestHeapCompare);
+  auto request = std::move(heap.back());
+  heap.pop_back();
+
+  // Requests that were deprioritized for being fetch heavy have their offset
+  // lowered below the default one.
+  auto weight = request->getPriority().offset < ImportPriority{}.offset
+      ? kDeprioritizedWeight
+      : kDefaultWeight;
+  queue.virtualTime = pidQueue.virtualTime;
+  pidQueue.virtualTime += kDefaultWeight / weight;
+
+  --queue.size;
+  queue.lastServed = now;
+  if (heap.empty()) {
+    queue.pids.erase(request->getPid().value_or(0));
+  }
+
+  return request;
+}
+
+void HgImportRequestQueue::popBatch(
+    TypeQueue& queue,
+    size_t count,
+    std::chrono::steady_clock::time_point now,
+    std::vector<std::shared_ptr<HgImportRequest>>& result) const {
+  for (size_t i = 0; i < count; i++) {
+    auto* priorityQueue = selectQueue(queue, now).first;
+    if (!priorityQueue) {
+      break;
+    }
+    result.emplace_back(popRequest(*priorityQueue, now));
+  }
+}
+
+std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue() {
+  std::vector<std::shared_ptr<HgImportRequest>> result;
+  std::array<size_t, kNumPriorityKinds> depths;
+  auto now = std::chrono::steady_clock::now();
+
+  {
+    size_t count;
+    TypeQueue* queue = nullptr;
+
+    auto state = state_.lock();
+    std::shared_ptr<const EdenConfig> config;
+    auto treeBatchSize = [&] {
+      return getBatchSize(
+          state->treeQueue,
+          state->treeBatchSizer,
+          config->importBatchSizeTree.getValue(),
+          config->importBatchSizeTreeMax.getValue());
+    };
+    auto blobBatchSize = [&] {
+      return getBatchSize(
+          state->blobQueue,
+          state->blobBatchSizer,
+          config->importBatchSize.getValue(),
+          config->importBatchSizeMax.getValue());
+    };
+
+    while (true) {
+      if (!state->running) {
+        state->treeQueue = TypeQueue{};
+        state->blobQueue = TypeQueue{};
+        state->prefetchQueue = TypeQueue{};
+        return std::vector<std::shared_ptr<HgImportRequest>>();
+      }
+
+      now = std::chrono::steady_clock::now();
+      config = config_->getEdenConfig();
+      ImportPriority highestPriority{ImportPriorityKind::Low, 0};
+
+      // Trees have a higher priority than blobs who themself have a higher
+      // priority than prefetch, thus check the queues in that order.
+      // The reason for trees having a higher priority is due to trees
+      // allowing a higher fan-out and thus increasing concurrency of fetches
+      // which translate onto a higher overall throughput.
+      if (auto [selected, priority] = selectQueue(state->treeQueue, now);
+          selected) {
+        count = treeBatchSize();
         highestPriority = priority;
+        queue = &state->treeQueue;
+      }
+
+      if (auto [selected, priority] = selectQueue(state->blobQueue, now);
+          selected) {
+        if (!queue || priority > highestPriority) {
+          queue = &state->blobQueue;
+          count = blobBatchSize();
+          highestPriority = priority;
+        }
+      }
+
+      if (auto [selected, priority] = selectQueue(state->prefetchQueue, now);
+          selected) {
+        if (!queue || priority > highestPriority) {
+          queue = &state->prefetchQueue;
+          count = 1;
+        }
+      }
+
+      if (queue) {
+        break;
+      } else {
+        queueCV_.wait(state.as_lock());
       }
     }
 
-    if (!state->prefetchQueue.empty()) {
-      auto priority = state->prefetchQueue.front()->getPriority();
-      if (!queue || priority > highestPriority) {
-        queue = &state->prefetchQueue;
-        count = 1;
+    result.reserve(count);
+    popBatch(*queue, count, now, result);
+
+    // Let trees and blobs share a single round trip to the backing store
+    // rather than have them go out back to back.
+    if (config->importBatchMixed.getValue()) {
+      if (queue == &state->treeQueue) {
+        popBatch(state->blobQueue, blobBatchSize(), now, result);
+      } else if (queue == &state->blobQueue) {
+        popBatch(state->treeQueue, treeBatchSize(), now, result);
       }
     }
 
-    if (queue) {
-      break;
-    } else {
-      queueCV_.wait(state.as_lock());
+    for (size_t kind = 0; kind < kNumPriorityKinds; kind++) {
+      depths[kind] = state->treeQueue[kind].size +
+          state->blobQueue[kind].size + state->prefetchQueue[kind].size;
     }
   }
 
-  count = std::min(count, queue->size());
-  std::vector<std::shared_ptr<HgImportRequest>> result;
-  result.reserve(count);
-  for (size_t i = 0; i < count; i++) {
-    std::pop_heap(
-        queue->begin(),
-        queue->end(),
-        [](const std::shared_ptr<HgImportRequest>& lhs,
-           const std::shared_ptr<HgImportRequest>& rhs) {
-          return (*lhs) < (*rhs);
-        });
-
-    result.emplace_back(std::move(queue->back()));
-    queue->pop_back();
+  for (auto& request : result) {
+    request->setDequeueTime(now);
+  }
+
+  if (stats_) {
+    auto& stats = stats_->getHgBackingStoreStatsForCurrentThread();
+    for (size_t kind = 0; kind < kNumPriorityKinds; kind++) {
+      (stats.*kQueueDepthStats[kind]).addValue(depths[kind]);
+    }
+
+    size_t treeCount = 0;
+    size_t blobCount = 0;
+    for (const auto& request : result) {
+      if (request->isType<HgImportRequest::TreeImport>()) {
+        ++treeCount;
+      } else if (request->isType<HgImportRequest::BlobImport>()) {
+        ++blobCount;
+      }
+
+      auto waited = std::chrono::duration_cast<std::chrono::microseconds>(
+          now - request->getRequestTime());
+      (stats.*kQueueWaitStats[kindIndex(request->getPriority().kind)])
+          .addValue(waited.count());
+    }
+    if (treeCount) {
+      stats.importBatchSizeTree.addValue(treeCount);
+    }
+    if (blobCount) {
+      stats.importBatchSizeBlob.addValue(blobCount);
+    }
   }
 
   return result;
@@ -10,21 +10,47 @@
 #include <folly/Synchronized.h>
 #include <folly/Try.h>
 #include <folly/container/F14Map.h>
+#include <array>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <vector>
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/store/hg/HgImportRequest.h"
+#include "eden/fs/store/hg/ImportBatchSizer.h"
+#include "eden/fs/telemetry/InstrumentedMutex.h"
 #include "folly/futures/Future.h"
 
 namespace facebook::eden {
 
+class EdenStats;
 class ReloadableConfig;
 
+/**
+ * Scheduler for the import requests of an HgQueuedBackingStore.
+ *
+ * Requests are split by type (tree, blob, prefetch), then by
+ * ImportPriorityKind, and then by the pid of the client that caused them.
+ * Each per-pid queue is a heap ordered by ImportPriority.
+ *
+ * dequeue() picks the priority kind to serve strictly by kind, but a kind
+ * that has not been served for `hg:import-queue-aging-interval` is treated
+ * as one kind higher for every interval it waited, so that low priority
+ * work cannot be starved indefinitely. Within a kind, the pids are served
+ * in weighted-fair order: each pid gets an equal share of the dequeued
+ * requests, except for pids whose requests have been deprioritized for
+ * being fetch heavy, which get a reduced, but non-zero, share.
+ */
 class HgImportRequestQueue {
  public:
-  explicit HgImportRequestQueue(std::shared_ptr<ReloadableConfig> config)
-      : config_(std::move(config)) {}
+  /**
+   * The EdenStats are used to export per-kind queue depth and wait time
+   * statistics and may be null in unit tests.
+   */
+  explicit HgImportRequestQueue(
+      std::shared_ptr<ReloadableConfig> config,
+      std::shared_ptr<EdenStats> stats = nullptr)
+      : config_(std::move(config)), stats_(std::move(stats)) {}
 
   /**
    * Enqueue a blob request to the queue.
@@ -56,12 +82,32 @@ class HgImportRequestQueue {
    * the queue is being destructed. This function will block when there is no
    * item available in the queue.
    *
-   * All requests in the vector are guaranteed to be the same type.
+   * All requests in the vector are guaranteed to be the same type, unless
+   * `hg:import-batch-mixed` is set, in which case a batch of trees may be
+   * followed by a batch of blobs and vice versa. Prefetch requests are
+   * always returned alone.
    * The number of the returned requests is controlled by `import-batch-size*`
    * options in the config. It may have fewer requests than configured.
+   *
+   * See the class comment for the order in which requests are returned.
    */
   std::vector<std::shared_ptr<HgImportRequest>> dequeue();
 
+  /**
+   * Report how long a batch of blob imports took. Used to adapt the size of
+   * the following batches when `hg:import-batch-adaptive` is set.
+   */
+  void recordBlobBatchLatency(
+      size_t batchSize,
+      std::chrono::microseconds latency);
+
+  /**
+   * Report how long a batch of tree imports took.
+   */
+  void recordTreeBatchLatency(
+      size_t batchSize,
+      std::chrono::microseconds latency);
+
   /**
    * Destroy the queue.
    *
@@ -130,11 +176,125 @@ class HgImportRequestQueue {
   HgImportRequestQueue(HgImportRequestQueue&&) = delete;
   HgImportRequestQueue& operator=(HgImportRequestQueue&&) = delete;
 
+  static constexpr size_t kNumPriorityKinds =
+      static_cast<size_t>(ImportPriorityKind::High) + 1;
+
+  /**
+   * The requests of a single pid, for a single type and priority kind.
+   */
+  struct PidQueue {
+    /**
+     * Heap of requests, ordered by priority.
+     */
+    std::vector<std::shared_ptr<HgImportRequest>> heap;
+
+    /**
+     * Virtual time of this pid in the weighted-fair schedule of its
+     * PriorityQueue. The pid with the lowest virtual time is served next.
+     */
+    uint64_t virtualTime = 0;
+  };
+
+  /**
+   * All the requests of a type that have the same ImportPriorityKind.
+   */
+  struct PriorityQueue {
+    /**
+     * Only non-empty PidQueues are kept, so that a pid that goes idle does
+     * not accumulate credit that it could later use to monopolize the queue.
+     * Requests without a known pid are all filed under pid 0.
+     */
+    folly::F14FastMap<pid_t, PidQueue> pids;
+
+    /**
+     * Number of requests in all the PidQueues.
+     */
+    size_t size = 0;
+
+    /**
+     * The virtual time of the last served pid. A new PidQueue starts from
+     * here.
+     */
+    uint64_t virtualTime = 0;
+
+    /**
+     * When a request was last taken from this queue, or when it last became
+     * non-empty. Used for aging.
+     */
+    std::chrono::steady_clock::time_point lastServed;
+  };
+
+  /**
+   * All the requests of a type, indexed by ImportPriorityKind.
+   */
+  using TypeQueue = std::array<PriorityQueue, kNumPriorityKinds>;
+
+  /**
+   * Add a request to the queue of its pid and kind.
+   */
+  static void pushRequest(
+      TypeQueue& queue,
+      std::shared_ptr<HgImportRequest> request);
+
+  /**
+   * Remove the request from the queue of its pid and kind. Returns false if
+   * the request is not in the queue, i.e. it has already been dequeued.
+   */
+  static bool removeRequest(
+      TypeQueue& queue,
+      const std::shared_ptr<HgImportRequest>& request);
+
+  /**
+   * Returns the kind of the queue that should be served next, or nullptr if
+   * all the queues are empty. Also returns the effective priority of that
+   * queue, taking aging into account. The kind of the effective priority may
+   * be above ImportPriorityKind::High for a queue that has aged.
+   */
+  std::pair<PriorityQueue*, ImportPriority> selectQueue(
+      TypeQueue& queue,
+      std::chrono::steady_clock::time_point now) const;
+
+  /**
+   * Returns the PidQueue that should be served next in weighted-fair order.
+   * The queue must not be empty.
+   */
+  static PidQueue& selectPid(PriorityQueue& queue);
+
+  /**
+   * Pop the highest priority request of the next pid to be served.
+   */
+  static std::shared_ptr<HgImportRequest> popRequest(
+      PriorityQueue& queue,
+      std::chrono::steady_clock::time_point now);
+
+  /**
+   * Returns the number of requests to dequeue from the given queue: the
+   * configured batch size, or the adaptive one when enabled.
+   */
+  size_t getBatchSize(
+      const TypeQueue& queue,
+      ImportBatchSizer& sizer,
+      size_t configured,
+      size_t maximum) const;
+
+  /**
+   * Pop up to count requests from the queue, in scheduling order, appending
+   * them to result.
+   */
+  void popBatch(
+      TypeQueue& queue,
+      size_t count,
+      std::chrono::steady_clock::time_point now,
+      std::vector<std::shared_ptr<HgImportRequest>>& result) const;
+
   struct State {
     bool running = true;
-    std::vector<std::shared_ptr<HgImportRequest>> treeQueue;
-    std::vector<std::shared_ptr<HgImportRequest>> blobQueue;
-    std::vector<std::shared_ptr<HgImportRequest>> prefetchQueue;
+    TypeQueue treeQueue;
+    TypeQueue blobQueue;
+    TypeQueue prefetchQueue;
+
+    ImportBatchSizer treeBatchSizer{1, 1};
+    ImportBatchSizer blobBatchSizer{1, 1};
 
     /**
      * Map of a ObjectId to an element in the queue. Any changes to this type
@@ -147,8 +307,16 @@ class HgImportRequestQueue {
         requestTracker;
   };
   std::shared_ptr<ReloadableConfig> config_;
-  folly::Synchronized<State, std::mutex> state_;
-  std::condition_variable queueCV_;
+  std::shared_ptr<EdenStats> stats_;
+  struct StateLockName {
+    static const char* name() {
+      return "hg_import_request_queue";
+    }
+  };
+  folly::Synchronized<State, InstrumentedMutex<std::mutex, StateLockName>>
+      state_;
+  // condition_variable_any, since the instrumented mutex is not a std::mutex.
+  std::condition_variable_any queueCV_;
 };
 
 } // namespace facebook::eden
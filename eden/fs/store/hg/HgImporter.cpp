@@ -11,6 +11,7 @@
 #include <boost/filesystem/path.hpp>
 #include <folly/Conv.h>
 #include <folly/FileUtil.h>
+#include <folly/ScopeGuard.h>
 #include <folly/Utility.h>
 #include <folly/container/Array.h>
 #include <folly/dynamic.h>
@@ -21,6 +22,7 @@
 #include <folly/json.h>
 #include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
 #include <gflags/gflags.h>
 #ifndef _WIN32
 #include <unistd.h>
@@ -671,6 +673,24 @@ HgImporterManager::HgImporterManager(
       stats_{std::move(stats)},
       importHelperScript_{importHelperScript} {}
 
+namespace {
+using StatPtr = HgImporterThreadStats::Stat HgImporterThreadStats::*;
+
+/**
+ * Runs fn, and records the time it took in the given stat of the
+ * HgImporterThreadStats of the current thread.
+ */
+template <typename Fn>
+auto recordLatency(EdenStats& stats, StatPtr stat, Fn&& fn) {
+  folly::stop_watch<std::chrono::microseconds> watch;
+  SCOPE_EXIT {
+    (stats.getHgImporterStatsForCurrentThread().*stat)
+        .addValue(watch.elapsed().count());
+  };
+  return fn();
+}
+} // namespace
+
 template <typename Fn>
 auto HgImporterManager::retryOnError(Fn&& fn) {
   bool retried = false;
@@ -703,29 +723,40 @@ auto HgImporterManager::retryOnError(Fn&& fn) {
 }
 
 Hash20 HgImporterManager::resolveManifestNode(StringPiece revName) {
-  return retryOnError([&](HgImporter* importer) {
-    return importer->resolveManifestNode(revName);
-  });
+  return recordLatency(
+      *stats_, &HgImporterThreadStats::manifestNodeForCommitLatency, [&] {
+        return retryOnError([&](HgImporter* importer) {
+          return importer->resolveManifestNode(revName);
+        });
+      });
 }
 
 unique_ptr<Blob> HgImporterManager::importFileContents(
     RelativePathPiece path,
     Hash20 blobHash) {
-  return retryOnError([=](HgImporter* importer) {
-    return importer->importFileContents(path, blobHash);
+  return recordLatency(*stats_, &HgImporterThreadStats::catFileLatency, [&] {
+    return retryOnError([=](HgImporter* importer) {
+      return importer->importFileContents(path, blobHash);
+    });
   });
 }
 
 void HgImporterManager::prefetchFiles(const std::vector<HgProxyHash>& files) {
-  return retryOnError(
-      [&](HgImporter* importer) { return importer->prefetchFiles(files); });
+  return recordLatency(
+      *stats_, &HgImporterThreadStats::prefetchFilesLatency, [&] {
+        return retryOnError([&](HgImporter* importer) {
+          return importer->prefetchFiles(files);
+        });
+      });
 }
 
 std::unique_ptr<IOBuf> HgImporterManager::fetchTree(
     RelativePathPiece path,
     Hash20 pathManifestNode) {
-  return retryOnError([&](HgImporter* importer) {
-    return importer->fetchTree(path, pathManifestNode);
+  return recordLatency(*stats_, &HgImporterThreadStats::fetchTreeLatency, [&] {
+    return retryOnError([&](HgImporter* importer) {
+      return importer->fetchTree(path, pathManifestNode);
+    });
   });
 }
 
@@ -738,6 +769,7 @@ HgImporter* HgImporterManager::getImporter() {
 
 void HgImporterManager::resetHgImporter(const std::exception& ex) {
   importer_.reset();
+  stats_->getHgImporterStatsForCurrentThread().restart.addValue(1);
   XLOG(WARN) << "error communicating with debugedenimporthelper: " << ex.what();
 }
 
@@ -9,8 +9,13 @@
 #include <fmt/core.h>
 
 #include <folly/futures/Future.h>
+#include <folly/hash/Hash.h>
+#include <folly/hash/SpookyHashV2.h>
 #include <folly/logging/xlog.h>
+#include <cstring>
+#include <tuple>
 
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/StoreResult.h"
 
@@ -21,9 +26,41 @@ using std::string;
 
 namespace facebook::eden {
 
-HgProxyHash::HgProxyHash(RelativePathPiece path, const Hash20& hgRevHash) {
-  auto [hash, buf] = prepareToStoreLegacy(path, hgRevHash);
-  value_ = std::move(buf);
+HgObjectIdFormat getHgObjectIdFormat(const EdenConfig& config) {
+  if (config.directObjectIdWithPath.getValue()) {
+    return HgObjectIdFormat::WithPath;
+  }
+  if (config.directObjectId.getValue()) {
+    return HgObjectIdFormat::HashOnly;
+  }
+  return HgObjectIdFormat::ProxyHash;
+}
+
+HgProxyHash::HgProxyHash(RelativePathPiece path, const Hash20& hgRevHash)
+    : revHash_{hgRevHash},
+      path_{path},
+      hashCode_{computeHashCode(revHash_, path_)} {}
+
+HgProxyHash::HgProxyHash(
+    const ObjectId& edenObjectId,
+    folly::StringPiece value) {
+  parse(edenObjectId, value);
+}
+
+size_t HgProxyHash::computeHashCode(
+    const Hash20& revHash,
+    RelativePathPiece path) noexcept {
+  if (path.empty() && revHash == kZeroHash) {
+    return kEmptyHashCode;
+  }
+  // Rev hashes are SHA-1s, so any 8 of their bytes are as good as a hash of
+  // all of them.
+  uint64_t revHashCode;
+  memcpy(&revHashCode, revHash.getBytes().data(), sizeof(revHashCode));
+  auto pathPiece = path.stringPiece();
+  return folly::hash::hash_128_to_64(
+      revHashCode,
+      folly::hash::SpookyHashV2::Hash64(pathPiece.data(), pathPiece.size(), 0));
 }
 
 std::optional<HgProxyHash> HgProxyHash::tryParseEmbeddedProxyHash(
@@ -34,6 +71,11 @@ std::optional<HgProxyHash> HgProxyHash::tryParseEmbeddedProxyHash(
         type == TYPE_HG_ID_NO_PATH) {
       auto hash = Hash20{edenObjectId.getBytes().subpiece(1, Hash20::RAW_SIZE)};
       return HgProxyHash{RelativePathPiece{}, hash};
+    } else if (type == TYPE_HG_ID_WITH_PATH) {
+      auto bytes = edenObjectId.getBytes();
+      auto hash = Hash20{bytes.subpiece(1, Hash20::RAW_SIZE)};
+      auto path = StringPiece{bytes.subpiece(Hash20::RAW_SIZE + 1)};
+      return HgProxyHash{RelativePathPiece{path}, hash};
     } else {
       throw std::invalid_argument(fmt::format(
           "Unknown proxy hash type: size {}, type {}",
@@ -47,29 +89,35 @@ std::optional<HgProxyHash> HgProxyHash::tryParseEmbeddedProxyHash(
 folly::Future<std::vector<HgProxyHash>> HgProxyHash::getBatch(
     LocalStore* store,
     ObjectIdRange blobHashes) {
-  std::vector<HgProxyHash> embedded_results;
+  // Embedded proxy hashes are parsed in place, the others are loaded from
+  // the LocalStore into the slots listed in storedIndexes.
+  std::vector<HgProxyHash> results;
+  results.resize(blobHashes.size());
+  std::vector<size_t> storedIndexes;
   std::vector<ByteRange> byteRanges;
+  size_t index = 0;
   for (const auto& hash : blobHashes) {
     if (auto embedded = tryParseEmbeddedProxyHash(hash)) {
-      embedded_results.push_back(*embedded);
+      results[index] = std::move(*embedded);
     } else {
+      storedIndexes.push_back(index);
       byteRanges.push_back(hash.getBytes());
     }
+    ++index;
   }
   if (byteRanges.empty()) {
-    return embedded_results;
+    return results;
   }
   return store->getBatch(KeySpace::HgProxyHashFamily, byteRanges)
-      .thenValue([embedded_results,
-                  byteRanges](std::vector<StoreResult>&& data) {
-        std::vector<HgProxyHash> results{embedded_results};
-
+      .thenValue([results = std::move(results),
+                  storedIndexes = std::move(storedIndexes),
+                  byteRanges](std::vector<StoreResult>&& data) mutable {
         for (size_t i = 0; i < byteRanges.size(); ++i) {
-          results.emplace_back(HgProxyHash{
-              ObjectId{byteRanges.at(i)}, data[i], "prefetchFiles getBatch"});
+          results[storedIndexes[i]] = HgProxyHash{
+              ObjectId{byteRanges.at(i)}, data[i], "prefetchFiles getBatch"};
         }
 
-        return results;
+        return std::move(results);
       });
 }
 
@@ -88,7 +136,7 @@ HgProxyHash HgProxyHash::load(
     // Fall through and let infoResult.extractValue() throw
   }
 
-  return HgProxyHash{edenObjectId, infoResult.extractValue()};
+  return HgProxyHash{edenObjectId, infoResult.piece()};
 }
 
 ObjectId HgProxyHash::store(
@@ -103,6 +151,38 @@ ObjectId HgProxyHash::store(
   return computedPair.first;
 }
 
+ObjectId HgProxyHash::store(
+    RelativePathPiece path,
+    Hash20 hgRevHash,
+    HgObjectIdFormat format,
+    LocalStore::WriteBatch* writeBatch) {
+  switch (format) {
+    case HgObjectIdFormat::ProxyHash:
+      return store(path, hgRevHash, std::optional{writeBatch});
+    case HgObjectIdFormat::HashOnly:
+      return makeEmbeddedProxyHash(hgRevHash);
+    case HgObjectIdFormat::WithPath:
+      return makeEmbeddedProxyHash(path, hgRevHash);
+  }
+  throw std::invalid_argument(
+      fmt::format("Unknown object ID format {}", static_cast<int>(format)));
+}
+
+ObjectId HgProxyHash::makeEmbeddedProxyHash(
+    RelativePathPiece path,
+    Hash20 hgRevHash) {
+  if (path.empty()) {
+    return makeEmbeddedProxyHash(hgRevHash);
+  }
+  auto pathPiece = path.stringPiece();
+  folly::fbstring str;
+  str.reserve(Hash20::RAW_SIZE + 1 + pathPiece.size());
+  str.push_back(TYPE_HG_ID_WITH_PATH);
+  str += hgRevHash.toByteString();
+  str.append(pathPiece.data(), pathPiece.size());
+  return ObjectId{std::move(str)};
+}
+
 ObjectId HgProxyHash::makeEmbeddedProxyHash(Hash20 hgRevHash) {
   folly::fbstring str;
   str.reserve(Hash20::RAW_SIZE + 1);
@@ -142,8 +222,7 @@ HgProxyHash::HgProxyHash(
     // Fall through and let infoResult.extractValue() throw
   }
 
-  value_ = infoResult.extractValue();
-  validate(edenBlobHash);
+  parse(edenBlobHash, infoResult.piece());
 }
 
 std::string HgProxyHash::serialize(
@@ -166,54 +245,30 @@ std::string HgProxyHash::serialize(
   return buf;
 }
 
-RelativePathPiece HgProxyHash::path() const noexcept {
-  if (value_.empty()) {
-    return RelativePathPiece{};
-  } else {
-    XDCHECK_GE(value_.size(), Hash20::RAW_SIZE + sizeof(uint32_t));
-    StringPiece data{value_.data(), value_.size()};
-    data.advance(Hash20::RAW_SIZE + sizeof(uint32_t));
-    // value_ was built with a known good RelativePath, thus we don't need to
-    // recheck it when deserializing.
-    return RelativePathPiece{data, detail::SkipPathSanityCheck{}};
-  }
-}
-
-ByteRange HgProxyHash::byteHash() const noexcept {
-  if (value_.empty()) {
-    return kZeroHash.getBytes();
-  } else {
-    XDCHECK_GE(value_.size(), Hash20::RAW_SIZE);
-    return ByteRange{StringPiece{value_.data(), Hash20::RAW_SIZE}};
-  }
-}
-
-Hash20 HgProxyHash::revHash() const noexcept {
-  return Hash20{byteHash()};
-}
-
 ObjectId HgProxyHash::sha1() const noexcept {
-  if (value_.empty()) {
+  if (revHash_ == kZeroHash && path_.empty()) {
     // The SHA-1 of an empty HgProxyHash, (kZeroHash, "").
     // The correctness of this value is asserted in tests.
     const ObjectId emptyProxyHash = ObjectId::fromHex(
         folly::StringPiece{"d3399b7262fb56cb9ed053d68db9291c410839c4"});
     return emptyProxyHash;
   } else {
-    return ObjectId::sha1(value_);
+    return ObjectId::sha1(serialize(path_, revHash_));
   }
 }
 
 bool HgProxyHash::operator==(const HgProxyHash& otherHash) const {
-  return value_ == otherHash.value_;
+  return hashCode_ == otherHash.hashCode_ && revHash_ == otherHash.revHash_ &&
+      path_ == otherHash.path_;
 }
 
 bool HgProxyHash::operator<(const HgProxyHash& otherHash) const {
-  return value_ < otherHash.value_;
+  return std::tie(revHash_, path_) <
+      std::tie(otherHash.revHash_, otherHash.path_);
 }
 
-void HgProxyHash::validate(ObjectId edenBlobHash) {
-  ByteRange infoBytes = StringPiece(value_);
+void HgProxyHash::parse(const ObjectId& edenBlobHash, StringPiece value) {
+  ByteRange infoBytes{value};
   // Make sure the data is long enough to contain the rev hash and path length
   if (infoBytes.size() < Hash20::RAW_SIZE + sizeof(uint32_t)) {
     auto msg = folly::to<string>(
@@ -226,6 +281,7 @@ void HgProxyHash::validate(ObjectId edenBlobHash) {
     throw std::length_error(msg);
   }
 
+  auto revHash = Hash20{infoBytes.subpiece(0, Hash20::RAW_SIZE)};
   infoBytes.advance(Hash20::RAW_SIZE);
 
   // Extract the path length
@@ -242,6 +298,12 @@ void HgProxyHash::validate(ObjectId edenBlobHash) {
     XLOG(ERR) << msg;
     throw std::length_error(msg);
   }
+
+  revHash_ = revHash;
+  // The path was serialized from a known good RelativePath, thus we don't
+  // need to recheck it.
+  path_ = RelativePath{StringPiece{infoBytes}, detail::SkipPathSanityCheck{}};
+  hashCode_ = computeHashCode(revHash_, path_);
 }
 
 } // namespace facebook::eden
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <string>
+#include <utility>
 #include <vector>
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/store/LocalStore.h"
@@ -20,6 +21,34 @@ class Future;
 
 namespace facebook::eden {
 
+class EdenConfig;
+
+/**
+ * How the ObjectIds of imported Mercurial trees and files are built.
+ */
+enum class HgObjectIdFormat {
+  /**
+   * The SHA-1 of the (path, revHash) pair, which is stored in the LocalStore.
+   */
+  ProxyHash,
+  /**
+   * The revHash embedded in the ObjectId, see hg:use-direct-object-id.
+   */
+  HashOnly,
+  /**
+   * The revHash and the path embedded in the ObjectId, see
+   * hg:use-direct-object-id-with-path. Nothing needs to be read from or
+   * written to the LocalStore.
+   */
+  WithPath,
+};
+
+/**
+ * Returns the format of the ObjectIds of newly imported objects. ObjectIds
+ * of all the formats can be loaded, whichever one is configured.
+ */
+HgObjectIdFormat getHgObjectIdFormat(const EdenConfig& config);
+
 /**
  * HgProxyHash is a derived index allowing us to map EdenFS's fixed-size hashes
  * onto Mercurial's (revHash, path) pairs.
@@ -33,6 +62,11 @@ namespace facebook::eden {
  * blob hash in EdenFS.  We store the eden_blob_hash --> (path, hgRevHash)
  * mapping in the LocalStore.  The HgProxyHash class helps store and
  * retrieve these mappings.
+ *
+ * Every import request holds one, so an HgProxyHash keeps the rev hash
+ * inline, the path in a RelativePath, which only allocates for paths longer
+ * than the small string buffer, and a precomputed hash code for the import
+ * queue's hash maps. The serialized form is only built when storing.
  */
 class HgProxyHash {
  public:
@@ -48,10 +82,7 @@ class HgProxyHash {
    * edenObjectId is only used in error messages to correlate the proxy hash
    * with Eden's object ID.
    */
-  HgProxyHash(const ObjectId& edenObjectId, std::string value)
-      : value_{std::move(value)} {
-    validate(edenObjectId);
-  }
+  HgProxyHash(const ObjectId& edenObjectId, folly::StringPiece value);
 
   /**
    * Create a ProxyHash given the specified values.
@@ -63,27 +94,40 @@ class HgProxyHash {
   HgProxyHash(const HgProxyHash& other) = default;
   HgProxyHash& operator=(const HgProxyHash& other) = default;
 
+  /**
+   * A moved-from HgProxyHash is an uninitialized one.
+   */
   HgProxyHash(HgProxyHash&& other) noexcept
-      : value_{std::exchange(other.value_, std::string{})} {}
+      : revHash_{std::exchange(other.revHash_, Hash20{})},
+        path_{std::exchange(other.path_, RelativePath{})},
+        hashCode_{std::exchange(other.hashCode_, kEmptyHashCode)} {}
 
   HgProxyHash& operator=(HgProxyHash&& other) noexcept {
-    value_ = std::exchange(other.value_, std::string{});
+    revHash_ = std::exchange(other.revHash_, Hash20{});
+    path_ = std::exchange(other.path_, RelativePath{});
+    hashCode_ = std::exchange(other.hashCode_, kEmptyHashCode);
     return *this;
   }
 
-  RelativePathPiece path() const noexcept;
+  RelativePathPiece path() const noexcept {
+    return path_;
+  }
 
   /**
    * Extract the hash part of the HgProxyHash and return a slice of it.
    *
    * The returned slice will live as long as this HgProxyHash.
    */
-  folly::ByteRange byteHash() const noexcept;
+  folly::ByteRange byteHash() const noexcept {
+    return revHash_.getBytes();
+  }
 
   /**
    * Extract the hash part of the HgProxyHash and return a copy of it.
    */
-  Hash20 revHash() const noexcept;
+  Hash20 revHash() const noexcept {
+    return revHash_;
+  }
 
   /**
    * Returns the SHA-1 of the canonical serialization of this ProxyHash, which
@@ -94,8 +138,11 @@ class HgProxyHash {
   bool operator==(const HgProxyHash&) const;
   bool operator<(const HgProxyHash&) const;
 
-  const std::string& getValue() const {
-    return value_;
+  /**
+   * A hash of the rev hash and the path, computed once on construction.
+   */
+  size_t getHashCode() const noexcept {
+    return hashCode_;
   }
 
   /**
@@ -127,6 +174,16 @@ class HgProxyHash {
       Hash20 hgRevHash,
       std::optional<LocalStore::WriteBatch*> writeBatch);
 
+  /**
+   * Returns the ObjectId of the given values in the given format, storing
+   * the HgProxyHash data in writeBatch if the format needs it.
+   */
+  static ObjectId store(
+      RelativePathPiece path,
+      Hash20 hgRevHash,
+      HgObjectIdFormat format,
+      LocalStore::WriteBatch* writeBatch);
+
   /**
    * Compute the proxy hash information, but do not store it.
    *
@@ -153,6 +210,15 @@ class HgProxyHash {
    */
   static ObjectId makeEmbeddedProxyHash(Hash20 hgRevHash);
 
+  /**
+   * Make ObjectId that contains both hgRevHash and path directly. The root
+   * path has nothing to embed, its ObjectId is the one of
+   * makeEmbeddedProxyHash(hgRevHash).
+   */
+  static ObjectId makeEmbeddedProxyHash(
+      RelativePathPiece path,
+      Hash20 hgRevHash);
+
  private:
   HgProxyHash(
       ObjectId edenBlobHash,
@@ -166,24 +232,29 @@ class HgProxyHash {
   static std::string serialize(RelativePathPiece path, const Hash20& hgRevHash);
 
   /**
-   * Validate data found in value_.
+   * Parse the serialized data, as returned by serialize(), into this
+   * HgProxyHash.
    *
-   * The value_ member variable should already contain the serialized data,
-   * (as returned by serialize()).
-   *
-   * Note there will be an exception being thrown if `value_` is invalid.
+   * Note there will be an exception being thrown if `value` is invalid.
    */
-  void validate(ObjectId edenBlobHash);
+  void parse(const ObjectId& edenBlobHash, folly::StringPiece value);
+
+  static size_t computeHashCode(
+      const Hash20& revHash,
+      RelativePathPiece path) noexcept;
 
   static constexpr char TYPE_HG_ID_NO_PATH = 0x01;
+  static constexpr char TYPE_HG_ID_WITH_PATH = 0x02;
 
   static std::optional<HgProxyHash> tryParseEmbeddedProxyHash(
       const ObjectId& edenObjectId);
 
-  /**
-   * The serialized data as written in the LocalStore.
-   */
-  std::string value_;
+  /** The hash code of an uninitialized HgProxyHash. */
+  static constexpr size_t kEmptyHashCode = 0;
+
+  Hash20 revHash_;
+  RelativePath path_;
+  size_t hashCode_{kEmptyHashCode};
 };
 
 } // namespace facebook::eden
@@ -192,7 +263,7 @@ namespace std {
 template <>
 struct hash<facebook::eden::HgProxyHash> {
   size_t operator()(const facebook::eden::HgProxyHash& hash) const noexcept {
-    return std::hash<std::string>{}(hash.getValue());
+    return hash.getHashCode();
   }
 };
 } // namespace std
@@ -7,6 +7,7 @@
 
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
 
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <utility>
@@ -15,17 +16,22 @@
 #include <re2/re2.h>
 
 #include <folly/Range.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
 #include <gflags/gflags.h>
 
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/model/Blob.h"
+#include "eden/fs/model/git/GitBlob.h"
 #include "eden/fs/service/ThriftUtil.h"
 #include "eden/fs/store/BackingStoreLogger.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/StoreResult.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
 #include "eden/fs/store/hg/HgImportRequest.h"
 #include "eden/fs/store/hg/HgProxyHash.h"
@@ -33,6 +39,7 @@
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
 #include "eden/fs/utils/Bug.h"
+#include "eden/fs/utils/CpuAffinity.h"
 #include "eden/fs/utils/EnumValue.h"
 #include "eden/fs/utils/IDGen.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -48,6 +55,41 @@ static_assert(sizeof(HgImportTraceEvent) == 56);
 // TraceBus is double-buffered, so the following capacity should be doubled.
 // 10 MB overhead per backing repo is tolerable.
 static_assert(kTraceBusCapacity * sizeof(HgImportTraceEvent) == 5600000);
+// The flight recorder keeps this many past events.
+constexpr size_t kFlightRecorderCapacity = 10000;
+
+ImportWindow::Limits getImportWindowLimits(
+    const EdenConfig& config,
+    size_t maxBatches) {
+  ImportWindow::Limits limits;
+  limits.maxBatches = maxBatches;
+  limits.maxRequests = config.maxInFlightImportRequests.getValue();
+  limits.maxBytes = config.maxInFlightImportBytes.getValue();
+  return limits;
+}
+
+/**
+ * Reports how long request waited in the import queue and how long the
+ * import itself took. Requests that were never dequeued, because the same
+ * object was already being imported, are not reported.
+ */
+void recordImportStages(
+    ObjectFetchContext& context,
+    const HgImportRequest* request) {
+  if (!request) {
+    return;
+  }
+  auto dequeueTime = request->getDequeueTime();
+  if (!dequeueTime) {
+    return;
+  }
+  context.didFinishStage(
+      ObjectFetchContext::ImportQueue,
+      *dequeueTime - request->getRequestTime());
+  context.didFinishStage(
+      ObjectFetchContext::BackingStoreFetch,
+      std::chrono::steady_clock::now() - *dequeueTime);
+}
 } // namespace
 
 HgImportTraceEvent::HgImportTraceEvent(
@@ -76,10 +118,20 @@ HgQueuedBackingStore::HgQueuedBackingStore(
       stats_(std::move(stats)),
       config_(config),
       backingStore_(std::move(backingStore)),
-      queue_(std::move(config)),
+      queue_(std::move(config), stats_),
+      importWindow_{ImportWindow::Limits{}},
       structuredLogger_{std::move(structuredLogger)},
       logger_(std::move(logger)),
-      traceBus_{TraceBus<HgImportTraceEvent>::create("hg", kTraceBusCapacity)} {
+      flightRecorder_{kFlightRecorderCapacity},
+      traceBus_{TraceBus<HgImportTraceEvent>::create(
+          "hg",
+          kTraceBusCapacity,
+          TraceBusOverflow::Drop)} {
+  flightRecorderHandle_ = traceBus_->subscribeFunction(
+      "hg flight recorder", [this](const HgImportTraceEvent& event) {
+        flightRecorder_.record(HgImportTraceRecord{event});
+      });
+
   uint8_t numberThreads =
       config_->getEdenConfig()->numBackingstoreThreads.getValue();
   if (!numberThreads) {
@@ -87,9 +139,29 @@ HgQueuedBackingStore::HgQueuedBackingStore(
         << "HgQueuedBackingStore configured to use 0 threads. Invalid, using one thread instead";
     numberThreads = 1;
   }
+  auto affinity =
+      config_->getEdenConfig()->backingstoreThreadAffinity.getValue();
+  auto homeNode = getCurrentNumaNode();
+
+  auto maxInFlightBatches =
+      config_->getEdenConfig()->maxInFlightImportBatches.getValue();
+  if (maxInFlightBatches) {
+    importWindow_.setLimits(
+        getImportWindowLimits(*config_->getEdenConfig(), maxInFlightBatches));
+    batchExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+        maxInFlightBatches,
+        std::make_unique<folly::UnboundedBlockingQueue<
+            folly::CPUThreadPoolExecutor::CPUTask>>(),
+        std::make_shared<CpuAffinityThreadFactory>(
+            std::make_shared<folly::NamedThreadFactory>("hgbatch"), affinity));
+  }
+
   threads_.reserve(numberThreads);
   for (uint16_t i = 0; i < numberThreads; i++) {
-    threads_.emplace_back(&HgQueuedBackingStore::processRequest, this);
+    threads_.emplace_back([this, affinity, i, homeNode] {
+      bindCurrentThread(affinity, i, homeNode);
+      processRequest();
+    });
   }
 }
 
@@ -98,12 +170,115 @@ HgQueuedBackingStore::~HgQueuedBackingStore() {
   for (auto& thread : threads_) {
     thread.join();
   }
+  // Wait for the batches still in flight.
+  batchExecutor_.reset();
+}
+
+void HgQueuedBackingStore::fulfillFromLocalStore(
+    std::vector<std::shared_ptr<HgImportRequest>>& requests) {
+  std::vector<size_t> treeIndices;
+  std::vector<folly::ByteRange> treeKeys;
+  std::vector<size_t> blobIndices;
+  std::vector<folly::ByteRange> blobKeys;
+  auto cachesBlobs =
+      localStore_->enableBlobCaching.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < requests.size(); ++i) {
+    if (auto* tree = requests[i]->getRequest<HgImportRequest::TreeImport>()) {
+      treeIndices.push_back(i);
+      treeKeys.push_back(tree->hash.getBytes());
+    } else if (auto* blob =
+                   requests[i]->getRequest<HgImportRequest::BlobImport>()) {
+      if (cachesBlobs) {
+        blobIndices.push_back(i);
+        blobKeys.push_back(blob->hash.getBytes());
+      }
+    }
+  }
+
+  std::vector<bool> fulfilled(requests.size(), false);
+  auto lookup = [&](KeySpace keySpace,
+                    const std::vector<size_t>& indices,
+                    const std::vector<folly::ByteRange>& keys,
+                    auto&& fulfill) {
+    if (keys.empty()) {
+      return;
+    }
+    std::vector<StoreResult> results;
+    try {
+      results = localStore_->getBatch(keySpace, keys).get();
+    } catch (const std::exception& ex) {
+      // Importing the objects again is always correct.
+      XLOG(WARN) << "unable to check the local store for " << keys.size()
+                 << " queued imports: " << folly::exceptionStr(ex);
+      return;
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+      if (!results[i].isValid()) {
+        continue;
+      }
+      auto& request = requests[indices[i]];
+      try {
+        fulfill(*request, results[i]);
+        fulfilled[indices[i]] = true;
+      } catch (const std::exception& ex) {
+        XLOG(WARN) << "unable to read a queued import from the local store: "
+                   << folly::exceptionStr(ex);
+      }
+    }
+  };
+
+  lookup(
+      KeySpace::TreeFamily,
+      treeIndices,
+      treeKeys,
+      [](HgImportRequest& request, StoreResult& data) {
+        auto& id = request.getRequest<HgImportRequest::TreeImport>()->hash;
+        auto tree = LocalStore::deserializeTree(id, data.bytes());
+        request.getPromise<HgImportRequest::TreeImport::Response>()->setValue(
+            std::move(tree));
+      });
+  lookup(
+      KeySpace::BlobFamily,
+      blobIndices,
+      blobKeys,
+      [](HgImportRequest& request, StoreResult& data) {
+        auto& id = request.getRequest<HgImportRequest::BlobImport>()->hash;
+        auto buf = data.extractIOBuf();
+        auto blob = deserializeGitBlob(id, &buf);
+        request.getPromise<HgImportRequest::BlobImport::Response>()->setValue(
+            std::move(blob));
+      });
+
+  size_t remaining = 0;
+  for (size_t i = 0; i < requests.size(); ++i) {
+    if (!fulfilled[i]) {
+      requests[remaining++] = std::move(requests[i]);
+    }
+  }
+  if (remaining != requests.size()) {
+    XLOG(DBG4) << "Found " << requests.size() - remaining
+               << " queued imports in the local store";
+    requests.resize(remaining);
+  }
 }
 
 void HgQueuedBackingStore::processBlobImportRequests(
     std::vector<std::shared_ptr<HgImportRequest>>&& requests) {
   folly::stop_watch<std::chrono::milliseconds> watch;
 
+  startBlobImports(requests);
+
+  {
+    folly::stop_watch<std::chrono::microseconds> batchWatch;
+    backingStore_->getDatapackStore().getBlobBatch(requests);
+    queue_.recordBlobBatchLatency(requests.size(), batchWatch.elapsed());
+  }
+
+  finishBlobImports(requests, watch);
+}
+
+void HgQueuedBackingStore::startBlobImports(
+    const std::vector<std::shared_ptr<HgImportRequest>>& requests) {
   XLOG(DBG4) << "Processing blob import batch size=" << requests.size();
 
   for (auto& request : requests) {
@@ -114,9 +289,11 @@ void HgQueuedBackingStore::processBlobImportRequests(
 
     XLOGF(DBG4, "Processing blob request for {}", blobImport->hash);
   }
+}
 
-  backingStore_->getDatapackStore().getBlobBatch(requests);
-
+void HgQueuedBackingStore::finishBlobImports(
+    std::vector<std::shared_ptr<HgImportRequest>>& requests,
+    folly::stop_watch<std::chrono::milliseconds> watch) {
   {
     std::vector<folly::SemiFuture<folly::Unit>> futures;
     futures.reserve(requests.size());
@@ -156,6 +333,39 @@ void HgQueuedBackingStore::processTreeImportRequests(
     std::vector<std::shared_ptr<HgImportRequest>>&& requests) {
   folly::stop_watch<std::chrono::milliseconds> watch;
 
+  bool prefetchMetadata = startTreeImports(requests);
+
+  {
+    folly::stop_watch<std::chrono::microseconds> batchWatch;
+    backingStore_->getTreeBatch(requests, prefetchMetadata);
+    queue_.recordTreeBatchLatency(requests.size(), batchWatch.elapsed());
+  }
+
+  finishTreeImports(requests, watch);
+}
+
+void HgQueuedBackingStore::processMixedImportRequests(
+    std::vector<std::shared_ptr<HgImportRequest>>&& treeRequests,
+    std::vector<std::shared_ptr<HgImportRequest>>&& blobRequests) {
+  folly::stop_watch<std::chrono::milliseconds> watch;
+
+  bool prefetchMetadata = startTreeImports(treeRequests);
+  startBlobImports(blobRequests);
+
+  {
+    folly::stop_watch<std::chrono::microseconds> batchWatch;
+    backingStore_->getMixedBatch(treeRequests, blobRequests, prefetchMetadata);
+    auto elapsed = batchWatch.elapsed();
+    queue_.recordTreeBatchLatency(treeRequests.size(), elapsed);
+    queue_.recordBlobBatchLatency(blobRequests.size(), elapsed);
+  }
+
+  finishTreeImports(treeRequests, watch);
+  finishBlobImports(blobRequests, watch);
+}
+
+bool HgQueuedBackingStore::startTreeImports(
+    const std::vector<std::shared_ptr<HgImportRequest>>& requests) {
   bool prefetchMetadata = false;
   for (auto& request : requests) {
     auto* treeImport = request->getRequest<HgImportRequest::TreeImport>();
@@ -167,8 +377,12 @@ void HgQueuedBackingStore::processTreeImportRequests(
     XLOGF(DBG4, "Processing tree request for {}", treeImport->hash);
   }
 
-  backingStore_->getTreeBatch(requests, prefetchMetadata);
+  return prefetchMetadata;
+}
 
+void HgQueuedBackingStore::finishTreeImports(
+    std::vector<std::shared_ptr<HgImportRequest>>& requests,
+    folly::stop_watch<std::chrono::milliseconds> watch) {
   {
     std::vector<folly::SemiFuture<folly::Unit>> futures;
     futures.reserve(requests.size());
@@ -230,13 +444,65 @@ void HgQueuedBackingStore::processRequest() {
 
     const auto& first = requests.at(0);
 
-    if (first->isType<HgImportRequest::BlobImport>()) {
-      processBlobImportRequests(std::move(requests));
-    } else if (first->isType<HgImportRequest::TreeImport>()) {
-      processTreeImportRequests(std::move(requests));
-    } else if (first->isType<HgImportRequest::Prefetch>()) {
+    if (first->isType<HgImportRequest::Prefetch>()) {
       processPrefetchRequests(std::move(requests));
+      continue;
     }
+
+    fulfillFromLocalStore(requests);
+    if (requests.empty()) {
+      continue;
+    }
+
+    submitImportBatch(std::move(requests));
+  }
+}
+
+void HgQueuedBackingStore::submitImportBatch(
+    std::vector<std::shared_ptr<HgImportRequest>>&& requests) {
+  if (!batchExecutor_) {
+    importBatch(std::move(requests));
+    return;
+  }
+
+  // The batch executor threads block in the backing store, which has no
+  // asynchronous batch API, so the number of batches in flight is also
+  // bounded by their number.
+  importWindow_.setLimits(getImportWindowLimits(
+      *config_->getEdenConfig(), batchExecutor_->numThreads()));
+  auto requestCount = requests.size();
+  auto blobCount = static_cast<size_t>(std::count_if(
+      requests.begin(), requests.end(), [](const auto& request) {
+        return request->template isType<HgImportRequest::BlobImport>();
+      }));
+  auto bytes = importWindow_.acquire(requestCount, blobCount);
+  batchExecutor_->add(
+      [this, requests = std::move(requests), requestCount, bytes]() mutable {
+        SCOPE_EXIT {
+          importWindow_.release(requestCount, bytes);
+        };
+        importBatch(std::move(requests));
+      });
+}
+
+void HgQueuedBackingStore::importBatch(
+    std::vector<std::shared_ptr<HgImportRequest>>&& requests) {
+  // With hg:import-batch-mixed, a batch may hold both trees and blobs.
+  auto firstBlob = std::stable_partition(
+      requests.begin(), requests.end(), [](const auto& request) {
+        return request->template isType<HgImportRequest::TreeImport>();
+      });
+
+  if (firstBlob == requests.begin()) {
+    processBlobImportRequests(std::move(requests));
+  } else if (firstBlob == requests.end()) {
+    processTreeImportRequests(std::move(requests));
+  } else {
+    std::vector<std::shared_ptr<HgImportRequest>> blobRequests{
+        std::make_move_iterator(firstBlob),
+        std::make_move_iterator(requests.end())};
+    requests.erase(firstBlob, requests.end());
+    processMixedImportRequests(std::move(requests), std::move(blobRequests));
   }
 }
 
@@ -288,9 +554,15 @@ folly::SemiFuture<BackingStore::GetTreeRes> HgQueuedBackingStore::getTreeImpl(
     const ObjectId& id,
     const HgProxyHash& proxyHash,
     ObjectFetchContext& context) {
+  std::shared_ptr<HgImportRequest> queuedRequest;
   auto getTreeFuture = folly::makeFutureWith([&] {
     auto request = HgImportRequest::makeTreeImportRequest(
-        id, proxyHash, context.getPriority(), context.prefetchMetadata());
+        id,
+        proxyHash,
+        context.getPriority(),
+        context.prefetchMetadata(),
+        context.getClientPid());
+    queuedRequest = request;
     uint64_t unique = request->getUnique();
 
     auto importTracker =
@@ -309,7 +581,9 @@ folly::SemiFuture<BackingStore::GetTreeRes> HgQueuedBackingStore::getTreeImpl(
   });
 
   return std::move(getTreeFuture)
-      .thenTry([this, id](folly::Try<std::unique_ptr<Tree>>&& result) {
+      .thenTry([this, id, &context, request = std::move(queuedRequest)](
+                   folly::Try<std::unique_ptr<Tree>>&& result) {
+        recordImportStages(context, request.get());
         this->queue_.markImportAsFinished<Tree>(id, result);
         auto tree = std::move(result).value();
         return BackingStore::GetTreeRes{
@@ -346,12 +620,14 @@ folly::SemiFuture<BackingStore::GetBlobRes> HgQueuedBackingStore::getBlobImpl(
     const ObjectId& id,
     const HgProxyHash& proxyHash,
     ObjectFetchContext& context) {
+  std::shared_ptr<HgImportRequest> queuedRequest;
   auto getBlobFuture = folly::makeFutureWith([&] {
     XLOG(DBG4) << "make blob import request for " << proxyHash.path()
                << ", hash is:" << id;
 
     auto request = HgImportRequest::makeBlobImportRequest(
-        id, proxyHash, context.getPriority());
+        id, proxyHash, context.getPriority(), context.getClientPid());
+    queuedRequest = request;
     auto unique = request->getUnique();
 
     auto importTracker =
@@ -370,8 +646,13 @@ folly::SemiFuture<BackingStore::GetBlobRes> HgQueuedBackingStore::getBlobImpl(
   });
 
   return std::move(getBlobFuture)
-      .thenTry([this, id](folly::Try<std::unique_ptr<Blob>>&& result) {
+      .thenTry([this, id, &context, request = std::move(queuedRequest)](
+                   folly::Try<std::unique_ptr<Blob>>&& result) {
+        recordImportStages(context, request.get());
         this->queue_.markImportAsFinished<Blob>(id, result);
+        if (batchExecutor_ && result.hasValue() && *result) {
+          importWindow_.recordBlobSize((*result)->getSize());
+        }
         auto blob = std::move(result).value();
         return BackingStore::GetBlobRes{
             std::move(blob), ObjectFetchContext::Origin::FromNetworkFetch};
@@ -429,7 +710,9 @@ folly::SemiFuture<folly::Unit> HgQueuedBackingStore::prefetchBlobs(
         } else {
           // TODO: deduplicate prefetches
           auto request = HgImportRequest::makePrefetchRequest(
-              std::move(proxyHashes), ImportPriority::kNormal());
+              std::move(proxyHashes),
+              ImportPriority::kNormal(),
+              context.getClientPid());
 
           auto importTracker = std::make_unique<RequestMetricsScope>(
               &pendingImportPrefetchWatches_);
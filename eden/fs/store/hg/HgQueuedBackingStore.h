@@ -9,9 +9,11 @@
 
 #include <folly/Range.h>
 #include <folly/Synchronized.h>
+#include <folly/stop_watch.h>
 #include <sys/types.h>
 #include <atomic>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "eden/fs/model/Hash.h"
@@ -19,9 +21,15 @@
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
+#include "eden/fs/store/hg/ImportWindow.h"
+#include "eden/fs/telemetry/FlightRecorder.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/telemetry/TraceBus.h"
 
+namespace folly {
+class CPUThreadPoolExecutor;
+} // namespace folly
+
 namespace facebook::eden {
 
 class BackingStoreLogger;
@@ -87,6 +95,25 @@ struct HgImportTraceEvent : TraceEventBase {
   std::unique_ptr<char[]> path;
 };
 
+/**
+ * What the flight recorder keeps of an HgImportTraceEvent.
+ */
+struct HgImportTraceRecord : TraceEventBase {
+  explicit HgImportTraceRecord(const HgImportTraceEvent& event)
+      : TraceEventBase{event},
+        unique{event.unique},
+        eventType{event.eventType},
+        resourceType{event.resourceType},
+        manifestNodeId{event.manifestNodeId},
+        path{event.getPath()} {}
+
+  uint64_t unique;
+  HgImportTraceEvent::EventType eventType;
+  HgImportTraceEvent::ResourceType resourceType;
+  Hash20 manifestNodeId;
+  std::string path;
+};
+
 /**
  * An Hg backing store implementation that will put incoming blob/tree import
  * requests into a job queue, then a pool of workers will work on fulfilling
@@ -109,6 +136,13 @@ class HgQueuedBackingStore final : public BackingStore {
     return *traceBus_;
   }
 
+  /**
+   * Always records the most recent HgImportTraceEvents.
+   */
+  const FlightRecorder<HgImportTraceRecord>& getFlightRecorder() const {
+    return flightRecorder_;
+  }
+
   RootId parseRootId(folly::StringPiece rootId) override;
   std::string renderRootId(const RootId& rootId) override;
 
@@ -169,12 +203,69 @@ class HgQueuedBackingStore final : public BackingStore {
   HgQueuedBackingStore(const HgQueuedBackingStore&) = delete;
   HgQueuedBackingStore& operator=(const HgQueuedBackingStore&) = delete;
 
+  /**
+   * Fulfill the tree and blob imports whose objects made it into the local
+   * store after they were queued, with a single local store lookup per key
+   * space, and remove them from requests.
+   */
+  void fulfillFromLocalStore(
+      std::vector<std::shared_ptr<HgImportRequest>>& requests);
+
   void processBlobImportRequests(
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
   void processTreeImportRequests(
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
   void processPrefetchRequests(
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
+  /**
+   * Import a batch of trees and a batch of blobs in a single backing store
+   * round trip.
+   */
+  void processMixedImportRequests(
+      std::vector<std::shared_ptr<HgImportRequest>>&& treeRequests,
+      std::vector<std::shared_ptr<HgImportRequest>>&& blobRequests);
+
+  /**
+   * Publish the start trace events of a batch of blob imports.
+   */
+  void startBlobImports(
+      const std::vector<std::shared_ptr<HgImportRequest>>& requests);
+
+  /**
+   * Import the blobs that the batch could not fetch through the hg importer
+   * and wait for them.
+   */
+  void finishBlobImports(
+      std::vector<std::shared_ptr<HgImportRequest>>& requests,
+      folly::stop_watch<std::chrono::milliseconds> watch);
+
+  /**
+   * Publish the start trace events of a batch of tree imports. Returns
+   * whether metadata should be prefetched for the batch.
+   */
+  bool startTreeImports(
+      const std::vector<std::shared_ptr<HgImportRequest>>& requests);
+
+  /**
+   * Import the trees that the batch could not fetch through the hg importer
+   * and wait for them.
+   */
+  void finishTreeImports(
+      std::vector<std::shared_ptr<HgImportRequest>>& requests,
+      folly::stop_watch<std::chrono::milliseconds> watch);
+
+  /**
+   * Import a batch of dequeued requests, on the calling thread when
+   * backingstore:max-inflight-batches is 0, or else on batchExecutor_ once
+   * importWindow_ has room for it.
+   */
+  void submitImportBatch(
+      std::vector<std::shared_ptr<HgImportRequest>>&& requests);
+
+  /**
+   * Import a batch of tree and blob requests, and wait for it to complete.
+   */
+  void importBatch(std::vector<std::shared_ptr<HgImportRequest>>&& requests);
 
   /**
    * The worker runloop function.
@@ -265,6 +356,18 @@ class HgQueuedBackingStore final : public BackingStore {
    */
   HgImportRequestQueue queue_;
 
+  /**
+   * Bounds the batches handed to batchExecutor_ that haven't completed.
+   */
+  ImportWindow importWindow_;
+
+  /**
+   * Imports the batches dequeued by the worker threads, so that they don't
+   * wait for the backing store. Null when batches are imported on the
+   * worker threads.
+   */
+  std::unique_ptr<folly::CPUThreadPoolExecutor> batchExecutor_;
+
   /**
    * The worker thread pool. These threads will be running `processRequest`
    * forever to process incoming import requests
@@ -289,6 +392,9 @@ class HgQueuedBackingStore final : public BackingStore {
   mutable RequestMetricsScope::LockedRequestWatchList
       pendingImportPrefetchWatches_;
 
+  FlightRecorder<HgImportTraceRecord> flightRecorder_;
+  TraceSubscriptionHandle<HgImportTraceEvent> flightRecorderHandle_;
+
   // This field should be last so any internal subscribers can capture [this].
   std::shared_ptr<TraceBus<HgImportTraceEvent>> traceBus_;
 };
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/ImportBatchSizer.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+ImportBatchSizer::ImportBatchSizer(size_t minimum, size_t maximum) {
+  setBounds(minimum, maximum);
+  cap_ = minimum_;
+}
+
+void ImportBatchSizer::setBounds(size_t minimum, size_t maximum) {
+  minimum_ = std::max<size_t>(1, minimum);
+  maximum_ = std::max(minimum_, maximum);
+  cap_ = std::clamp(cap_, minimum_, maximum_);
+}
+
+size_t ImportBatchSizer::getBatchSize(size_t queueDepth, size_t numThreads)
+    const {
+  numThreads = std::max<size_t>(1, numThreads);
+  // Share the pending requests between all the threads rather than letting
+  // the first thread take everything.
+  size_t perThread = (queueDepth + numThreads - 1) / numThreads;
+  return std::clamp(perThread, minimum_, cap_);
+}
+
+void ImportBatchSizer::recordLatency(
+    size_t batchSize,
+    std::chrono::microseconds latency,
+    std::chrono::microseconds targetLatency) {
+  if (latency > targetLatency) {
+    cap_ = std::max(minimum_, cap_ / 2);
+  } else if (batchSize >= cap_) {
+    // Only grow when the cap was actually the limiting factor, otherwise an
+    // idle queue would inflate the cap without ever testing it.
+    cap_ = std::min(maximum_, cap_ + std::max<size_t>(1, cap_ / 4));
+  }
+}
+
+} // namespace facebook::eden
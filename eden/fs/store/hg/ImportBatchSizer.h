@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace facebook::eden {
+
+/**
+ * Picks the size of import batches from the depth of the import queue and
+ * the observed round-trip latency of previous batches.
+ *
+ * When the queue is shallow, batches are kept small so that individual
+ * requests are not delayed waiting for a large batch to complete. When the
+ * queue is deep, the pending requests are spread over the import threads in
+ * batches as large as the current cap allows.
+ *
+ * The cap itself follows an additive-increase, multiplicative-decrease
+ * scheme: it grows while full batches complete under the target latency and
+ * is halved whenever a batch exceeds it.
+ *
+ * This class is not thread safe; callers must provide their own locking.
+ */
+class ImportBatchSizer {
+ public:
+  /**
+   * Batches will be between minimum and maximum, inclusive. The cap starts
+   * at minimum.
+   */
+  ImportBatchSizer(size_t minimum, size_t maximum);
+
+  /**
+   * Returns the size of the next batch to dequeue, given the number of
+   * requests currently waiting and the number of threads draining the queue.
+   */
+  size_t getBatchSize(size_t queueDepth, size_t numThreads) const;
+
+  /**
+   * Record how long a batch of batchSize requests took to import.
+   */
+  void recordLatency(
+      size_t batchSize,
+      std::chrono::microseconds latency,
+      std::chrono::microseconds targetLatency);
+
+  /**
+   * Update the bounds, e.g. after a config reload. The cap is clamped to the
+   * new bounds.
+   */
+  void setBounds(size_t minimum, size_t maximum);
+
+  size_t getCap() const {
+    return cap_;
+  }
+
+ private:
+  size_t minimum_{1};
+  size_t maximum_{1};
+  size_t cap_{1};
+};
+
+} // namespace facebook::eden
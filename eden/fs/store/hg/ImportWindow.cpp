@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/ImportWindow.h"
+
+#include <folly/logging/xlog.h>
+
+namespace facebook::eden {
+
+namespace {
+// The weight of each new blob in the moving average of the blob sizes.
+constexpr double kBlobSizeWeight = 0.01;
+} // namespace
+
+ImportWindow::ImportWindow(Limits limits) : limits_{limits} {}
+
+void ImportWindow::setLimits(Limits limits) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    limits_ = limits;
+  }
+  // Raised limits may let waiting batches in.
+  released_.notify_all();
+}
+
+uint64_t ImportWindow::acquire(size_t requests, size_t blobCount) {
+  auto bytes = estimateBytes(blobCount);
+  std::unique_lock<std::mutex> lock{mutex_};
+  released_.wait(lock, [&] { return hasRoomLocked(requests, bytes); });
+  ++batches_;
+  requests_ += requests;
+  bytes_ += bytes;
+  return bytes;
+}
+
+bool ImportWindow::tryAcquire(size_t requests, uint64_t bytes) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (!hasRoomLocked(requests, bytes)) {
+    return false;
+  }
+  ++batches_;
+  requests_ += requests;
+  bytes_ += bytes;
+  return true;
+}
+
+void ImportWindow::release(size_t requests, uint64_t bytes) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    XDCHECK_GT(batches_, 0u);
+    XDCHECK_GE(requests_, requests);
+    XDCHECK_GE(bytes_, bytes);
+    --batches_;
+    requests_ -= requests;
+    bytes_ -= bytes;
+  }
+  released_.notify_all();
+}
+
+void ImportWindow::recordBlobSize(uint64_t bytes) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  averageBlobSize_ += kBlobSizeWeight * (bytes - averageBlobSize_);
+}
+
+uint64_t ImportWindow::estimateBytes(size_t blobCount) const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return static_cast<uint64_t>(averageBlobSize_ * blobCount);
+}
+
+size_t ImportWindow::getInFlightBatches() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return batches_;
+}
+
+size_t ImportWindow::getInFlightRequests() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return requests_;
+}
+
+uint64_t ImportWindow::getInFlightBytes() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return bytes_;
+}
+
+bool ImportWindow::hasRoomLocked(size_t requests, uint64_t bytes) const {
+  if (batches_ == 0) {
+    return true;
+  }
+  if (limits_.maxBatches && batches_ >= limits_.maxBatches) {
+    return false;
+  }
+  if (limits_.maxRequests && requests_ + requests > limits_.maxRequests) {
+    return false;
+  }
+  if (limits_.maxBytes && bytes_ + bytes > limits_.maxBytes) {
+    return false;
+  }
+  return true;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace facebook::eden {
+
+/**
+ * Bounds the import batches submitted to the backing store that haven't
+ * completed yet.
+ *
+ * A batch is charged its number of requests, and an estimate of the bytes
+ * its blobs will hold once imported, taken from a moving average of the
+ * sizes of the blobs imported so far. acquire() blocks while the window has
+ * no room for a batch, so that the threads dequeuing imports stop pulling
+ * requests off the queue, where they can still be reprioritized, when the
+ * backing store falls behind.
+ *
+ * A batch is always admitted into an empty window, however large, so that a
+ * batch above the limits doesn't wait forever.
+ *
+ * This class is thread safe.
+ */
+class ImportWindow {
+ public:
+  /** Limits of 0 are unbounded. */
+  struct Limits {
+    size_t maxBatches = 1;
+    size_t maxRequests = 0;
+    uint64_t maxBytes = 0;
+  };
+
+  /** The blob size assumed before any blob was imported. */
+  static constexpr uint64_t kInitialBlobSize = 16 * 1024;
+
+  explicit ImportWindow(Limits limits);
+
+  /**
+   * Update the limits, e.g. after a config reload. Batches already in the
+   * window stay in it.
+   */
+  void setLimits(Limits limits);
+
+  /**
+   * Charge a batch of requests holding blobCount blobs to the window,
+   * waiting until it has room for it. Returns the bytes charged, to be
+   * passed back to release().
+   */
+  uint64_t acquire(size_t requests, size_t blobCount);
+
+  /**
+   * Charge a batch of the given size if the window has room for it, without
+   * waiting. Returns whether it was charged.
+   */
+  bool tryAcquire(size_t requests, uint64_t bytes);
+
+  /** Remove a completed batch from the window. */
+  void release(size_t requests, uint64_t bytes);
+
+  /** Add the size of an imported blob to the moving average. */
+  void recordBlobSize(uint64_t bytes);
+
+  /** The bytes that a batch of blobCount blobs is expected to hold. */
+  uint64_t estimateBytes(size_t blobCount) const;
+
+  size_t getInFlightBatches() const;
+  size_t getInFlightRequests() const;
+  uint64_t getInFlightBytes() const;
+
+ private:
+  bool hasRoomLocked(size_t requests, uint64_t bytes) const;
+
+  mutable std::mutex mutex_;
+  std::condition_variable released_;
+  Limits limits_;
+  size_t batches_{0};
+  size_t requests_{0};
+  uint64_t bytes_{0};
+  double averageBlobSize_{kInitialBlobSize};
+};
+
+} // namespace facebook::eden
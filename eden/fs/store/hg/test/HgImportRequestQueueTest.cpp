@@ -9,7 +9,9 @@
 #include <folly/logging/xlog.h>
 #include <folly/portability/GTest.h>
 #include <array>
+#include <map>
 #include <memory>
+#include <thread>
 
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/model/Hash.h"
@@ -47,14 +49,15 @@ Hash20 uniqueHash() {
 }
 
 std::pair<ObjectId, std::shared_ptr<HgImportRequest>> makeBlobImportRequest(
-    ImportPriority priority) {
+    ImportPriority priority,
+    std::optional<pid_t> pid = std::nullopt) {
   auto hgRevHash = uniqueHash();
   auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, hgRevHash};
   auto hash = proxyHash.sha1();
   return std::make_pair(
       hash,
       HgImportRequest::makeBlobImportRequest(
-          hash, std::move(proxyHash), priority));
+          hash, std::move(proxyHash), priority, pid));
 }
 
 std::pair<ObjectId, std::shared_ptr<HgImportRequest>>
@@ -556,3 +559,150 @@ TEST_F(HgImportRequestQueueTest, twoDuplicateRequestsDifferentPriority) {
         request->getRequest<HgImportRequest::BlobImport>()->hash, expBlob);
   }
 }
+
+TEST_F(HgImportRequestQueueTest, pidsShareTheQueueFairly) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  // pid 1 floods the queue with higher offsets before pid 2 shows up.
+  for (int i = 0; i < 10; i++) {
+    auto request = makeBlobImportRequest(
+                       ImportPriority(ImportPriorityKind::Normal, 100 + i), 1)
+                       .second;
+    queue.enqueueBlob(std::move(request));
+  }
+  for (int i = 0; i < 2; i++) {
+    auto request =
+        makeBlobImportRequest(ImportPriority(ImportPriorityKind::Normal, i), 2)
+            .second;
+    queue.enqueueBlob(std::move(request));
+  }
+
+  std::map<pid_t, size_t> served;
+  for (int i = 0; i < 4; i++) {
+    auto request = queue.dequeue().at(0);
+    served[request->getPid().value()]++;
+  }
+
+  EXPECT_EQ(2, served[1]);
+  EXPECT_EQ(2, served[2]);
+}
+
+TEST_F(HgImportRequestQueueTest, deprioritizedPidGetsSmallerShare) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  for (int i = 0; i < 10; i++) {
+    auto heavy = makeBlobImportRequest(
+                     ImportPriority::kNormal().getDeprioritized(1000), 1)
+                     .second;
+    queue.enqueueBlob(std::move(heavy));
+    auto light = makeBlobImportRequest(ImportPriority::kNormal(), 2).second;
+    queue.enqueueBlob(std::move(light));
+  }
+
+  std::map<pid_t, size_t> served;
+  for (int i = 0; i < 10; i++) {
+    auto request = queue.dequeue().at(0);
+    served[request->getPid().value()]++;
+  }
+
+  // The fetch heavy pid still makes progress, but at a quarter of the rate.
+  EXPECT_EQ(2, served[1]);
+  EXPECT_EQ(8, served[2]);
+}
+
+TEST_F(HgImportRequestQueueTest, higherKindIsServedFirstWithoutAging) {
+  rawEdenConfig->importQueueAgingInterval.setValue(
+      std::chrono::nanoseconds{0}, ConfigSource::UserConfig, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto [lowHash, lowRequest] = makeBlobImportRequest(ImportPriority::kLow());
+  queue.enqueueBlob(std::move(lowRequest));
+  std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  auto [normalHash, normalRequest] =
+      makeBlobImportRequest(ImportPriority::kNormal());
+  queue.enqueueBlob(std::move(normalRequest));
+
+  EXPECT_EQ(
+      normalHash,
+      queue.dequeue().at(0)->getRequest<HgImportRequest::BlobImport>()->hash);
+  EXPECT_EQ(
+      lowHash,
+      queue.dequeue().at(0)->getRequest<HgImportRequest::BlobImport>()->hash);
+}
+
+TEST_F(HgImportRequestQueueTest, starvedKindIsAged) {
+  rawEdenConfig->importQueueAgingInterval.setValue(
+      std::chrono::milliseconds{50}, ConfigSource::UserConfig, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto [lowHash, lowRequest] = makeBlobImportRequest(ImportPriority::kLow());
+  queue.enqueueBlob(std::move(lowRequest));
+
+  // After three intervals, the low priority request overtakes high priority
+  // requests that were just enqueued.
+  std::this_thread::sleep_for(std::chrono::milliseconds{160});
+  auto [highHash, highRequest] = makeBlobImportRequest(ImportPriority::kHigh());
+  queue.enqueueBlob(std::move(highRequest));
+
+  EXPECT_EQ(
+      lowHash,
+      queue.dequeue().at(0)->getRequest<HgImportRequest::BlobImport>()->hash);
+  EXPECT_EQ(
+      highHash,
+      queue.dequeue().at(0)->getRequest<HgImportRequest::BlobImport>()->hash);
+}
+
+TEST_F(HgImportRequestQueueTest, adaptiveBatchSizeFollowsQueueDepth) {
+  rawEdenConfig->importBatchAdaptive.setValue(
+      true, ConfigSource::UserConfig, true);
+  rawEdenConfig->importBatchSizeMax.setValue(
+      16, ConfigSource::UserConfig, true);
+  rawEdenConfig->numBackingstoreThreads.setValue(
+      2, ConfigSource::UserConfig, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  for (int i = 0; i < 100; i++) {
+    insertBlobImportRequest(queue, ImportPriority::kNormal());
+  }
+
+  // No latency has been observed yet, batches start at the minimum.
+  EXPECT_EQ(1, queue.dequeue().size());
+
+  for (int i = 0; i < 20; i++) {
+    queue.recordBlobBatchLatency(16, std::chrono::microseconds{1});
+  }
+
+  // 99 requests are left for 2 threads, but the batch is capped.
+  EXPECT_EQ(16, queue.dequeue().size());
+
+  // A slow batch halves the cap.
+  queue.recordBlobBatchLatency(16, std::chrono::seconds{10});
+  EXPECT_EQ(8, queue.dequeue().size());
+}
+
+TEST_F(HgImportRequestQueueTest, mixedBatchCarriesBothTypes) {
+  rawEdenConfig->importBatchMixed.setValue(
+      true, ConfigSource::UserConfig, true);
+  rawEdenConfig->importBatchSize.setValue(2, ConfigSource::UserConfig, true);
+  rawEdenConfig->importBatchSizeTree.setValue(
+      2, ConfigSource::UserConfig, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  for (int i = 0; i < 3; i++) {
+    insertBlobImportRequest(queue, ImportPriority::kNormal());
+    insertTreeImportRequest(queue, ImportPriority::kNormal());
+  }
+
+  // Trees win the tie and come first, followed by the blobs that ride along.
+  auto batch = queue.dequeue();
+  ASSERT_EQ(4, batch.size());
+  EXPECT_TRUE(batch[0]->isType<HgImportRequest::TreeImport>());
+  EXPECT_TRUE(batch[1]->isType<HgImportRequest::TreeImport>());
+  EXPECT_TRUE(batch[2]->isType<HgImportRequest::BlobImport>());
+  EXPECT_TRUE(batch[3]->isType<HgImportRequest::BlobImport>());
+
+  batch = queue.dequeue();
+  ASSERT_EQ(2, batch.size());
+  EXPECT_TRUE(batch[0]->isType<HgImportRequest::TreeImport>());
+  EXPECT_TRUE(batch[1]->isType<HgImportRequest::BlobImport>());
+}
@@ -6,9 +6,11 @@
  */
 
 #include <folly/Range.h>
+#include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GTest.h>
 #include <memory>
+#include <vector>
 
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/store/MemoryLocalStore.h"
@@ -79,3 +81,79 @@ TEST(HgProxyHashTest, test_moved_from_and_empty_hash_compare_the_same) {
   EXPECT_EQ(HgProxyHash{}.revHash(), zero.revHash());
   EXPECT_EQ(HgProxyHash{}.sha1(), zero.sha1());
 }
+
+TEST(HgProxyHashTest, embedded_proxy_hash_with_path) {
+  auto store = std::make_shared<MemoryLocalStore>();
+  Hash20 revHash{
+      folly::StringPiece{"1111111111111111111111111111111111111111"}};
+
+  auto id = HgProxyHash::store(
+      RelativePathPiece{"foo/bar"},
+      revHash,
+      HgObjectIdFormat::WithPath,
+      /*writeBatch=*/nullptr);
+  auto loaded = HgProxyHash::load(store.get(), id, "test");
+  EXPECT_EQ(RelativePathPiece{"foo/bar"}, loaded.path());
+  EXPECT_EQ(revHash, loaded.revHash());
+
+  // The root has no path to embed.
+  EXPECT_EQ(
+      HgProxyHash::makeEmbeddedProxyHash(revHash),
+      HgProxyHash::makeEmbeddedProxyHash(RelativePathPiece{}, revHash));
+}
+
+TEST(HgProxyHashTest, get_batch_keeps_the_order_of_mixed_ids) {
+  auto store = std::make_shared<MemoryLocalStore>();
+  Hash20 revHash1{
+      folly::StringPiece{"1111111111111111111111111111111111111111"}};
+  Hash20 revHash2{
+      folly::StringPiece{"2222222222222222222222222222222222222222"}};
+  Hash20 revHash3{
+      folly::StringPiece{"3333333333333333333333333333333333333333"}};
+
+  std::vector<ObjectId> ids;
+  {
+    auto write = store->beginWrite();
+    ids.push_back(
+        HgProxyHash::store(RelativePathPiece{"stored"}, revHash1, write.get()));
+    ids.push_back(HgProxyHash::makeEmbeddedProxyHash(
+        RelativePathPiece{"embedded"}, revHash2));
+    ids.push_back(HgProxyHash::makeEmbeddedProxyHash(revHash3));
+    write->flush();
+  }
+
+  auto hashes =
+      HgProxyHash::getBatch(store.get(), ObjectIdRange{ids.data(), ids.size()})
+          .get();
+  ASSERT_EQ(3, hashes.size());
+  EXPECT_EQ(RelativePathPiece{"stored"}, hashes[0].path());
+  EXPECT_EQ(revHash1, hashes[0].revHash());
+  EXPECT_EQ(RelativePathPiece{"embedded"}, hashes[1].path());
+  EXPECT_EQ(revHash2, hashes[1].revHash());
+  EXPECT_EQ(RelativePathPiece{}, hashes[2].path());
+  EXPECT_EQ(revHash3, hashes[2].revHash());
+}
+
+TEST(HgProxyHashTest, loaded_and_constructed_hashes_are_interchangeable) {
+  auto store = std::make_shared<MemoryLocalStore>();
+  Hash20 revHash{
+      folly::StringPiece{"1111111111111111111111111111111111111111"}};
+  ObjectId id;
+  {
+    auto write = store->beginWrite();
+    id = HgProxyHash::store(RelativePathPiece{"foo/bar"}, revHash, write.get());
+    write->flush();
+  }
+
+  auto loaded = HgProxyHash::load(store.get(), id, "test");
+  HgProxyHash constructed{RelativePathPiece{"foo/bar"}, revHash};
+  EXPECT_EQ(constructed, loaded);
+  EXPECT_EQ(
+      std::hash<HgProxyHash>{}(constructed), std::hash<HgProxyHash>{}(loaded));
+  EXPECT_EQ(id, loaded.sha1());
+
+  HgProxyHash otherPath{RelativePathPiece{"foo/baz"}, revHash};
+  EXPECT_FALSE(constructed == otherPath);
+  EXPECT_NE(constructed.getHashCode(), otherPath.getHashCode());
+  EXPECT_TRUE(constructed < otherPath || otherPath < constructed);
+}
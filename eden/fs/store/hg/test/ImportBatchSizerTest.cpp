@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/ImportBatchSizer.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+TEST(ImportBatchSizerTest, startsAtMinimum) {
+  ImportBatchSizer sizer{4, 64};
+  EXPECT_EQ(4, sizer.getCap());
+  EXPECT_EQ(4, sizer.getBatchSize(1000, 1));
+}
+
+TEST(ImportBatchSizerTest, shallowQueueUsesSmallBatches) {
+  ImportBatchSizer sizer{1, 64};
+  for (int i = 0; i < 100; i++) {
+    sizer.recordLatency(sizer.getCap(), 1ms, 100ms);
+  }
+  EXPECT_EQ(64, sizer.getCap());
+
+  EXPECT_EQ(1, sizer.getBatchSize(0, 4));
+  EXPECT_EQ(1, sizer.getBatchSize(3, 4));
+  EXPECT_EQ(2, sizer.getBatchSize(8, 4));
+}
+
+TEST(ImportBatchSizerTest, deepQueueIsSharedBetweenThreads) {
+  ImportBatchSizer sizer{1, 64};
+  for (int i = 0; i < 100; i++) {
+    sizer.recordLatency(sizer.getCap(), 1ms, 100ms);
+  }
+
+  EXPECT_EQ(25, sizer.getBatchSize(100, 4));
+  EXPECT_EQ(64, sizer.getBatchSize(10000, 4));
+}
+
+TEST(ImportBatchSizerTest, growsOnlyWhenCapIsReached) {
+  ImportBatchSizer sizer{1, 64};
+  for (int i = 0; i < 100; i++) {
+    sizer.recordLatency(0, 1ms, 100ms);
+  }
+  EXPECT_EQ(1, sizer.getCap());
+
+  sizer.recordLatency(1, 1ms, 100ms);
+  EXPECT_EQ(2, sizer.getCap());
+}
+
+TEST(ImportBatchSizerTest, slowBatchesHalveTheCap) {
+  ImportBatchSizer sizer{2, 64};
+  for (int i = 0; i < 100; i++) {
+    sizer.recordLatency(sizer.getCap(), 1ms, 100ms);
+  }
+  EXPECT_EQ(64, sizer.getCap());
+
+  sizer.recordLatency(64, 200ms, 100ms);
+  EXPECT_EQ(32, sizer.getCap());
+
+  for (int i = 0; i < 10; i++) {
+    sizer.recordLatency(sizer.getCap(), 200ms, 100ms);
+  }
+  EXPECT_EQ(2, sizer.getCap());
+}
+
+TEST(ImportBatchSizerTest, setBoundsClampsCap) {
+  ImportBatchSizer sizer{1, 64};
+  for (int i = 0; i < 100; i++) {
+    sizer.recordLatency(sizer.getCap(), 1ms, 100ms);
+  }
+
+  sizer.setBounds(1, 16);
+  EXPECT_EQ(16, sizer.getCap());
+
+  sizer.setBounds(32, 128);
+  EXPECT_EQ(32, sizer.getCap());
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/ImportWindow.h"
+
+#include <folly/portability/GTest.h>
+#include <atomic>
+#include <thread>
+
+using namespace facebook::eden;
+
+TEST(ImportWindowTest, emptyWindowAdmitsAnyBatch) {
+  ImportWindow window{{1, 10, 100}};
+  EXPECT_TRUE(window.tryAcquire(1000, 1000000));
+  EXPECT_FALSE(window.tryAcquire(1, 1));
+  window.release(1000, 1000000);
+  EXPECT_EQ(0, window.getInFlightBatches());
+  EXPECT_TRUE(window.tryAcquire(1, 1));
+}
+
+TEST(ImportWindowTest, batchesAreBoundedByEachLimit) {
+  ImportWindow window{{3, 10, 100}};
+  EXPECT_TRUE(window.tryAcquire(4, 40));
+  // Too many requests.
+  EXPECT_FALSE(window.tryAcquire(7, 10));
+  // Too many bytes.
+  EXPECT_FALSE(window.tryAcquire(1, 61));
+  EXPECT_TRUE(window.tryAcquire(3, 30));
+  EXPECT_TRUE(window.tryAcquire(1, 10));
+  // Too many batches.
+  EXPECT_FALSE(window.tryAcquire(1, 1));
+  EXPECT_EQ(3, window.getInFlightBatches());
+  EXPECT_EQ(8, window.getInFlightRequests());
+  EXPECT_EQ(80, window.getInFlightBytes());
+
+  // 0 is unbounded.
+  window.setLimits({0, 0, 0});
+  EXPECT_TRUE(window.tryAcquire(1000, 1000));
+}
+
+TEST(ImportWindowTest, blobSizesAreAMovingAverage) {
+  ImportWindow window{{1, 0, 0}};
+  EXPECT_EQ(10 * ImportWindow::kInitialBlobSize, window.estimateBytes(10));
+  for (int i = 0; i < 1000; ++i) {
+    window.recordBlobSize(1024 * 1024);
+  }
+  auto estimate = window.estimateBytes(1);
+  EXPECT_GT(estimate, 1000 * 1024);
+  EXPECT_LE(estimate, 1024 * 1024);
+  EXPECT_EQ(0, window.estimateBytes(0));
+}
+
+TEST(ImportWindowTest, acquireWaitsForRelease) {
+  ImportWindow window{{1, 0, 0}};
+  window.acquire(1, 1);
+
+  std::atomic<bool> acquired{false};
+  std::thread waiter{[&] {
+    window.acquire(1, 1);
+    acquired = true;
+  }};
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds{50});
+  EXPECT_FALSE(acquired);
+
+  window.release(1, ImportWindow::kInitialBlobSize);
+  waiter.join();
+  EXPECT_TRUE(acquired);
+  EXPECT_EQ(1, window.getInFlightBatches());
+}
@@ -7,6 +7,7 @@
 
 #include "eden/fs/store/BlobCache.h"
 #include <folly/portability/GTest.h>
+#include <string>
 #include "eden/fs/model/Blob.h"
 
 using namespace folly::literals;
@@ -118,3 +119,74 @@ TEST(BlobCache, does_not_forget_blob_until_last_handle_is_forgotten) {
   result2.interestHandle.reset();
   EXPECT_FALSE(weak.lock());
 }
+
+TEST(BlobCache, counts_evictions_of_blobs_with_interest_handles) {
+  auto cache = BlobCache::create(10, 0);
+  auto handle3 = cache->insert(blob3, BlobCache::Interest::WantHandle);
+  cache->insert(blob4);
+  cache->insert(blob5); // evicts blob3 despite its interest handle
+  EXPECT_FALSE(cache->get(hash3).object);
+
+  cache->insert(blob6); // evicts blob4, which nothing is interested in
+  auto stats = cache->getStats();
+  EXPECT_EQ(2, stats.evictionCount);
+  EXPECT_EQ(1, stats.pinnedEvictionCount);
+
+  // The evicted blob is still reachable through the handle while it's alive.
+  EXPECT_EQ(blob3, handle3.getObject());
+}
+
+TEST(BlobCache, large_blobs_go_to_their_own_tier) {
+  auto cache = BlobCache::create(10, 0, 1, CacheEvictionPolicy::LRU, 5, 9);
+  cache->insert(blob3);
+  cache->insert(blob4);
+  cache->insert(blob9); // Over the threshold, doesn't evict the small blobs.
+  EXPECT_EQ(blob3, cache->get(hash3).object);
+  EXPECT_EQ(blob4, cache->get(hash4).object);
+  EXPECT_EQ(blob9, cache->get(hash9).object);
+
+  cache->insert(blob6); // Evicts blob9 from the large blob tier.
+  EXPECT_EQ(nullptr, cache->get(hash9).object);
+  EXPECT_EQ(blob6, cache->get(hash6).object);
+  EXPECT_EQ(blob3, cache->get(hash3).object);
+
+  auto stats = cache->getStats();
+  EXPECT_EQ(7, stats.totalSizeInBytes);
+  EXPECT_EQ(1, stats.largeObjectCount);
+  EXPECT_EQ(6, stats.largeObjectSizeInBytes);
+  EXPECT_EQ(2, stats.largeObjectAdmitCount);
+  EXPECT_EQ(0, stats.largeObjectRejectCount);
+}
+
+TEST(BlobCache, large_blobs_are_not_cached_without_a_tier_budget) {
+  auto cache = BlobCache::create(10, 0, 1, CacheEvictionPolicy::LRU, 5, 0);
+  cache->insert(blob3);
+  auto handle = cache->insert(blob9, BlobCache::Interest::WantHandle);
+  EXPECT_EQ(blob9, handle.getObject());
+  EXPECT_EQ(nullptr, cache->get(hash9).object);
+  EXPECT_EQ(blob3, cache->get(hash3).object);
+  EXPECT_EQ(1, cache->getStats().largeObjectRejectCount);
+}
+
+TEST(BlobCache, evicted_blobs_are_promoted_from_the_compressed_tier) {
+  if (!CompressedBlobCache::isSupported()) {
+    GTEST_SKIP() << "LZ4 is not available";
+  }
+  std::string contents(1000, 'x');
+  auto blob = std::make_shared<Blob>(hash9, folly::StringPiece{contents});
+  auto cache = BlobCache::create(
+      1500, 0, 1, CacheEvictionPolicy::LRU, 0, 0, 1024 * 1024);
+  cache->insert(blob);
+  cache->insert(std::make_shared<Blob>(hash3, folly::StringPiece{contents}));
+  EXPECT_EQ(1, cache->getCompressedStats().objectCount);
+
+  auto result = cache->get(hash9);
+  ASSERT_TRUE(result.object);
+  EXPECT_EQ(
+      contents,
+      folly::StringPiece{result.object->getContents().clone()->coalesce()});
+  EXPECT_EQ(1, cache->getCompressedStats().hitCount);
+  // Promoting blob9 evicted blob3 to the compressed tier in turn.
+  EXPECT_FALSE(cache->contains(hash3));
+  EXPECT_EQ(1, cache->getCompressedStats().objectCount);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BlobContentIndex.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/Blob.h"
+
+using namespace facebook::eden;
+
+namespace {
+std::shared_ptr<const Blob> makeBlob(
+    folly::StringPiece hex,
+    folly::StringPiece contents) {
+  return std::make_shared<const Blob>(ObjectId::fromHex(hex), contents);
+}
+} // namespace
+
+TEST(BlobContentIndex, identical_contents_share_a_buffer) {
+  BlobContentIndex index{16};
+  auto sha1 = Hash20::sha1(folly::ByteRange{folly::StringPiece{"contents"}});
+  auto first = makeBlob("1111111111111111111111111111111111111111", "contents");
+  auto second =
+      makeBlob("2222222222222222222222222222222222222222", "contents");
+
+  auto firstResult = index.intern(first, sha1);
+  EXPECT_FALSE(firstResult.deduplicated);
+  EXPECT_EQ(first, firstResult.blob);
+
+  auto secondResult = index.intern(second, sha1);
+  EXPECT_TRUE(secondResult.deduplicated);
+  EXPECT_EQ(second->getHash(), secondResult.blob->getHash());
+  EXPECT_EQ(
+      first->getContents().data(), secondResult.blob->getContents().data());
+}
+
+TEST(BlobContentIndex, expired_blobs_are_not_shared) {
+  BlobContentIndex index{16};
+  auto sha1 = Hash20::sha1(folly::ByteRange{folly::StringPiece{"contents"}});
+  index.intern(
+      makeBlob("1111111111111111111111111111111111111111", "contents"), sha1);
+
+  auto second =
+      makeBlob("2222222222222222222222222222222222222222", "contents");
+  auto result = index.intern(second, sha1);
+  EXPECT_FALSE(result.deduplicated);
+  EXPECT_EQ(second, result.blob);
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BlobMetadataCache.h"
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+ObjectId makeId(size_t i) {
+  return ObjectId::fromHex(fmt::format("{:040x}", i));
+}
+
+BlobMetadata makeMetadata(size_t i) {
+  return BlobMetadata{Hash20::sha1(fmt::format("blob {}", i)), i};
+}
+
+} // namespace
+
+TEST(BlobMetadataCache, returns_inserted_metadata) {
+  BlobMetadataCache cache{100, 4};
+  EXPECT_EQ(4, cache.getShardCount());
+  EXPECT_FALSE(cache.get(makeId(1)).has_value());
+  EXPECT_FALSE(cache.contains(makeId(1)));
+
+  cache.set(makeId(1), makeMetadata(1));
+  EXPECT_TRUE(cache.contains(makeId(1)));
+  auto metadata = cache.get(makeId(1));
+  ASSERT_TRUE(metadata.has_value());
+  EXPECT_EQ(makeMetadata(1).sha1, metadata->sha1);
+  EXPECT_EQ(1, metadata->size);
+}
+
+TEST(BlobMetadataCache, set_replaces_existing_metadata) {
+  BlobMetadataCache cache{100, 4};
+  cache.set(makeId(1), makeMetadata(1));
+  auto withBlake3 = makeMetadata(1);
+  withBlake3.blake3 = Blake3Hash{};
+  cache.set(makeId(1), withBlake3);
+  EXPECT_TRUE(cache.get(makeId(1))->blake3.has_value());
+}
+
+TEST(BlobMetadataCache, evicts_least_recently_used_entries) {
+  BlobMetadataCache cache{2, 1};
+  cache.set(makeId(1), makeMetadata(1));
+  cache.set(makeId(2), makeMetadata(2));
+  // Using 1 makes 2 the least recently used entry.
+  EXPECT_TRUE(cache.get(makeId(1)).has_value());
+  cache.set(makeId(3), makeMetadata(3));
+
+  EXPECT_TRUE(cache.contains(makeId(1)));
+  EXPECT_FALSE(cache.contains(makeId(2)));
+  EXPECT_TRUE(cache.contains(makeId(3)));
+}
+
+TEST(BlobMetadataCache, entries_are_divided_between_shards) {
+  constexpr size_t kEntries = 1000;
+  BlobMetadataCache cache{kEntries, 8};
+  for (size_t i = 0; i < kEntries * 2; ++i) {
+    cache.set(makeId(i), makeMetadata(i));
+  }
+  size_t cached = 0;
+  for (size_t i = 0; i < kEntries * 2; ++i) {
+    cached += cache.contains(makeId(i));
+  }
+  EXPECT_LE(cached, kEntries);
+  // Every shard is full, so most of the capacity is in use.
+  EXPECT_GE(cached, kEntries * 9 / 10);
+}
+
+TEST(BlobMetadataCache, zero_shards_is_treated_as_one) {
+  BlobMetadataCache cache{10, 0};
+  EXPECT_EQ(1, cache.getShardCount());
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/CompressedBlobCache.h"
+#include <folly/portability/GTest.h>
+#include <string>
+#include "eden/fs/model/Blob.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+const auto hash1 =
+    ObjectId::fromHex("0000000000000000000000000000000000000001");
+const auto hash2 =
+    ObjectId::fromHex("0000000000000000000000000000000000000002");
+const auto hash3 =
+    ObjectId::fromHex("0000000000000000000000000000000000000003");
+
+std::shared_ptr<const Blob> makeSourceBlob(const ObjectId& hash, char c) {
+  std::string contents;
+  for (int i = 0; i < 100; ++i) {
+    contents += "int main() { return ";
+    contents += c;
+    contents += "; }\n";
+  }
+  return std::make_shared<Blob>(hash, folly::StringPiece{contents});
+}
+
+std::string contentsOf(const Blob& blob) {
+  return folly::StringPiece{blob.getContents().clone()->coalesce()}.str();
+}
+
+} // namespace
+
+class CompressedBlobCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (!CompressedBlobCache::isSupported()) {
+      GTEST_SKIP() << "LZ4 is not available";
+    }
+  }
+};
+
+TEST_F(CompressedBlobCacheTest, take_returns_and_removes_the_blob) {
+  CompressedBlobCache cache{1024 * 1024, 1};
+  auto blob = makeSourceBlob(hash1, '1');
+  cache.insert(*blob);
+
+  auto stats = cache.getStats();
+  EXPECT_EQ(1, stats.objectCount);
+  EXPECT_EQ(blob->getSize(), stats.uncompressedSizeInBytes);
+  EXPECT_LT(stats.totalSizeInBytes, blob->getSize() / 3);
+
+  auto taken = cache.take(hash1);
+  ASSERT_TRUE(taken);
+  EXPECT_EQ(hash1, taken->getHash());
+  EXPECT_EQ(contentsOf(*blob), contentsOf(*taken));
+
+  EXPECT_FALSE(cache.take(hash1));
+  stats = cache.getStats();
+  EXPECT_EQ(0, stats.objectCount);
+  EXPECT_EQ(0, stats.totalSizeInBytes);
+  EXPECT_EQ(1, stats.hitCount);
+  EXPECT_EQ(1, stats.missCount);
+}
+
+TEST_F(CompressedBlobCacheTest, incompressible_blobs_are_not_kept) {
+  CompressedBlobCache cache{1024 * 1024, 1};
+  cache.insert(Blob{hash1, "abc"});
+  EXPECT_FALSE(cache.take(hash1));
+  EXPECT_EQ(1, cache.getStats().incompressibleCount);
+}
+
+TEST_F(CompressedBlobCacheTest, evicts_least_recently_inserted_over_budget) {
+  auto blob1 = makeSourceBlob(hash1, '1');
+  auto blob2 = makeSourceBlob(hash2, '2');
+  auto blob3 = makeSourceBlob(hash3, '3');
+
+  // Find out how large one compressed blob is to size the budget for two.
+  size_t compressedSize;
+  {
+    CompressedBlobCache probe{1024 * 1024, 1};
+    probe.insert(*blob1);
+    compressedSize = probe.getStats().totalSizeInBytes;
+  }
+
+  CompressedBlobCache cache{compressedSize * 2 + compressedSize / 2, 1};
+  cache.insert(*blob1);
+  cache.insert(*blob2);
+  cache.insert(*blob3);
+
+  EXPECT_EQ(1, cache.getStats().evictionCount);
+  EXPECT_FALSE(cache.take(hash1));
+  EXPECT_TRUE(cache.take(hash2));
+  EXPECT_TRUE(cache.take(hash3));
+}
@@ -430,6 +430,69 @@ TEST_F(DiffTest, blockedFutures) {
 #endif
 }
 
+TEST_F(DiffTest, unchangedSubtreesAreNotLoaded) {
+  FakeTreeBuilder builder;
+  builder.setFile("a/b/c/1.txt", "1");
+  builder.setFile("a/b/2.txt", "2");
+  builder.setFile("src/main.c", "hello world");
+  builder.finalize(backingStore_, /* setReady */ false);
+  auto root1 = backingStore_->putCommit("1", builder);
+
+  auto builder2 = builder.clone();
+  builder2.replaceFile("src/main.c", "hello world v2");
+  builder2.finalize(backingStore_, /* setReady */ false);
+  auto root2 = backingStore_->putCommit("2", builder2);
+
+  auto resultFuture = diffCommits("1", "2");
+  root1->setReady();
+  root2->setReady();
+  builder.setReady("");
+  builder2.setReady("");
+  builder.setAllReadyUnderTree("src");
+  builder2.setAllReadyUnderTree("src");
+
+  // Nothing under "a" was made ready, and the diff does not need it.
+  ASSERT_TRUE(resultFuture.isReady());
+  auto result = std::move(resultFuture).get();
+  EXPECT_THAT(*result->errors_ref(), UnorderedElementsAre());
+  EXPECT_THAT(
+      *result->entries_ref(),
+      UnorderedElementsAre(Pair("src/main.c", ScmFileStatus::MODIFIED)));
+}
+
+TEST_F(DiffTest, smallBatches) {
+  FakeTreeBuilder builder;
+  builder.setFile("a/b/c/d/1.txt", "1");
+  builder.setFile("a/b/2.txt", "2");
+  builder.setFile("x/y/3.txt", "3");
+  builder.setFile("x/4.txt", "4");
+  builder.setFile("z/5.txt", "5");
+  builder.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("1", builder)->setReady();
+
+  auto builder2 = builder.clone();
+  builder2.replaceFile("a/b/c/d/1.txt", "1 v2");
+  builder2.removeFile("a/b/2.txt");
+  builder2.replaceFile("x/y/3.txt", "3 v2");
+  builder2.setFile("x/y/w/6.txt", "6");
+  builder2.replaceFile("z/5.txt", "5 v2");
+  builder2.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("2", builder2)->setReady();
+
+  auto result = diffCommitsForStatus(
+                    store_.get(), RootId{"1"}, RootId{"2"}, /*maxBatchSize=*/1)
+                    .get(100ms);
+  EXPECT_THAT(*result->errors_ref(), UnorderedElementsAre());
+  EXPECT_THAT(
+      *result->entries_ref(),
+      UnorderedElementsAre(
+          Pair("a/b/c/d/1.txt", ScmFileStatus::MODIFIED),
+          Pair("a/b/2.txt", ScmFileStatus::REMOVED),
+          Pair("x/y/3.txt", ScmFileStatus::MODIFIED),
+          Pair("x/y/w/6.txt", ScmFileStatus::ADDED),
+          Pair("z/5.txt", ScmFileStatus::MODIFIED)));
+}
+
 TEST_F(DiffTest, loadTreeError) {
   FakeTreeBuilder builder;
 
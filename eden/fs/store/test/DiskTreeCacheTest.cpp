@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/DiskTreeCache.h"
+
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+const auto hash1 =
+    ObjectId::fromHex("0000000000000000000000000000000000000001");
+const auto hash2 =
+    ObjectId::fromHex("0000000000000000000000000000000000000002");
+const auto hash3 =
+    ObjectId::fromHex("0000000000000000000000000000000000000003");
+const auto sha1 = Hash20{"faceb00cdeadbeefc00010ff1badb0028badf00d"};
+
+std::shared_ptr<const Tree> makeTree(const ObjectId& hash) {
+  return std::make_shared<const Tree>(
+      std::vector<TreeEntry>{
+          TreeEntry{hash1, PathComponent{"dir"}, TreeEntryType::TREE},
+          TreeEntry{
+              hash2,
+              PathComponent{"file"},
+              TreeEntryType::REGULAR_FILE,
+              42,
+              sha1},
+          TreeEntry{
+              ObjectId{ObjectId::Storage{"a variable length proxy id"}},
+              PathComponent{"link"},
+              TreeEntryType::SYMLINK},
+      },
+      hash);
+}
+} // namespace
+
+TEST(DiskTreeCache, missing_file_returns_null) {
+  auto tempDir = makeTempDir();
+  auto path = AbsolutePath{tempDir.path().string()} + "missing"_pc;
+  EXPECT_EQ(nullptr, DiskTreeCache::open(path));
+}
+
+TEST(DiskTreeCache, round_trips_trees) {
+  auto tempDir = makeTempDir();
+  auto path = AbsolutePath{tempDir.path().string()} + "tree-cache"_pc;
+  auto tree = makeTree(hash3);
+  auto emptyTree =
+      std::make_shared<const Tree>(std::vector<TreeEntry>{}, hash1);
+  DiskTreeCache::write(path, {tree, emptyTree});
+
+  auto cache = DiskTreeCache::open(path);
+  ASSERT_NE(nullptr, cache);
+  EXPECT_EQ(2, cache->size());
+  EXPECT_TRUE(cache->contains(hash3));
+  EXPECT_FALSE(cache->contains(hash2));
+
+  auto loaded = cache->get(hash3);
+  ASSERT_NE(nullptr, loaded);
+  EXPECT_EQ(*tree, *loaded);
+  EXPECT_EQ(42, loaded->getEntryAt(PathComponentPiece{"file"}).getSize());
+  EXPECT_EQ(
+      sha1, loaded->getEntryAt(PathComponentPiece{"file"}).getContentSha1());
+
+  auto loadedEmpty = cache->get(hash1);
+  ASSERT_NE(nullptr, loadedEmpty);
+  EXPECT_EQ(0, loadedEmpty->getTreeEntries().size());
+
+  EXPECT_EQ(nullptr, cache->get(hash2));
+}
+
+TEST(DiskTreeCache, unknown_format_is_ignored) {
+  auto tempDir = makeTempDir();
+  auto path = AbsolutePath{tempDir.path().string()} + "tree-cache"_pc;
+  ASSERT_TRUE(folly::writeFile("not a tree cache"_sp, path.c_str()));
+  EXPECT_EQ(nullptr, DiskTreeCache::open(path));
+}
+
+TEST(DiskTreeCache, truncated_file_keeps_complete_records) {
+  auto tempDir = makeTempDir();
+  auto path = AbsolutePath{tempDir.path().string()} + "tree-cache"_pc;
+  DiskTreeCache::write(path, {makeTree(hash1), makeTree(hash2)});
+
+  std::string contents;
+  ASSERT_TRUE(folly::readFile(path.c_str(), contents));
+  contents.resize(contents.size() - 10);
+  ASSERT_TRUE(folly::writeFile(contents, path.c_str()));
+
+  auto cache = DiskTreeCache::open(path);
+  ASSERT_NE(nullptr, cache);
+  EXPECT_EQ(1, cache->size());
+  EXPECT_NE(nullptr, cache->get(hash1));
+}
+
+TEST(DiskTreeCache, empty_record_stops_indexing) {
+  auto tempDir = makeTempDir();
+  auto path = AbsolutePath{tempDir.path().string()} + "tree-cache"_pc;
+  // A valid header announcing one tree, followed by a zero-length record.
+  std::string contents{"ETRC\0\0\0\x02\0\0\0\0\0\0\0\x01\0\0\0\0", 20};
+  ASSERT_TRUE(folly::writeFile(contents, path.c_str()));
+
+  auto cache = DiskTreeCache::open(path);
+  ASSERT_NE(nullptr, cache);
+  EXPECT_EQ(0, cache->size());
+}
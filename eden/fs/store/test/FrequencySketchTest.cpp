@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FrequencySketch.h"
+#include <gtest/gtest.h>
+
+using namespace facebook::eden;
+
+TEST(FrequencySketch, unseen_keys_estimate_zero) {
+  FrequencySketch sketch{1024};
+  EXPECT_EQ(0, sketch.estimate(1));
+  EXPECT_EQ(0, sketch.estimate(12345));
+}
+
+TEST(FrequencySketch, counts_increments) {
+  FrequencySketch sketch{1024};
+  sketch.increment(1);
+  sketch.increment(1);
+  sketch.increment(2);
+  EXPECT_EQ(2, sketch.estimate(1));
+  EXPECT_EQ(1, sketch.estimate(2));
+}
+
+TEST(FrequencySketch, counts_saturate) {
+  FrequencySketch sketch{1024};
+  for (int i = 0; i < 100; ++i) {
+    sketch.increment(7);
+  }
+  EXPECT_EQ(FrequencySketch::kMaxCount, sketch.estimate(7));
+}
+
+TEST(FrequencySketch, counts_age_after_sample_period) {
+  FrequencySketch sketch{16};
+  for (int i = 0; i < 10; ++i) {
+    sketch.increment(7);
+  }
+  auto before = sketch.estimate(7);
+  // The sample period is 10 times the width: enough distinct increments to
+  // trigger a halving of all counters.
+  for (size_t key = 100; key < 100 + 16 * 10; ++key) {
+    sketch.increment(key);
+  }
+  EXPECT_LT(sketch.estimate(7), before);
+}
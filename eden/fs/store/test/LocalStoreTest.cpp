@@ -126,6 +126,58 @@ TEST_P(LocalStoreTest, testReadsAndWriteTree) {
   EXPECT_EQ(TreeEntryType::REGULAR_FILE, readmeEntry.getType());
 }
 
+TEST_P(LocalStoreTest, testReadAndWritePackedTree) {
+  store_->enablePackedTrees = true;
+
+  // Packed trees keep entries whose ids aren't git compatible, and their
+  // sizes and SHA-1s.
+  auto sha1 = Hash20::sha1(folly::ByteRange{"contents"_sp});
+  Tree inTree{
+      {TreeEntry{
+           ObjectId{folly::ByteRange{"file id"_sp}},
+           PathComponent{"file"},
+           TreeEntryType::REGULAR_FILE,
+           8,
+           sha1},
+       TreeEntry{
+           ObjectId::fromHex("3a8f8eb91101860fd8484154885838bf322964d0"),
+           PathComponent{"lib"},
+           TreeEntryType::TREE}},
+      ObjectId{folly::ByteRange{"tree id"_sp}}};
+  store_->putTree(inTree);
+
+  auto outTree = store_->getTree(inTree.getHash()).get(10s);
+  ASSERT_TRUE(outTree);
+  EXPECT_EQ(inTree, *outTree);
+  EXPECT_EQ(8, outTree->getEntryAt(0).getSize());
+  EXPECT_EQ(sha1, outTree->getEntryAt(0).getContentSha1());
+
+  // Git trees written before packing was enabled are still readable.
+  store_->enablePackedTrees = false;
+  Tree gitTree{
+      {TreeEntry{
+          ObjectId::fromHex("3a8f8eb91101860fd8484154885838bf322964d0"),
+          PathComponent{"lib"},
+          TreeEntryType::TREE}},
+      ObjectId::fromHex("8e073e366ed82de6465d1209d3f07da7eebabb93")};
+  store_->putTree(gitTree);
+  store_->enablePackedTrees = true;
+  auto outGitTree = store_->getTree(gitTree.getHash()).get(10s);
+  ASSERT_TRUE(outGitTree);
+  EXPECT_EQ(gitTree, *outGitTree);
+
+  // Without packing, trees that aren't git compatible are not stored.
+  store_->enablePackedTrees = false;
+  Tree otherTree{
+      {TreeEntry{
+          ObjectId{folly::ByteRange{"other id"_sp}},
+          PathComponent{"other"},
+          TreeEntryType::REGULAR_FILE}},
+      ObjectId{folly::ByteRange{"other tree id"_sp}}};
+  store_->putTree(otherTree);
+  EXPECT_FALSE(store_->getTree(otherTree.getHash()).get(10s));
+}
+
 TEST_P(LocalStoreTest, testGetResult) {
   StringPiece key1 = "foo";
   StringPiece key2 = "bar";
@@ -143,6 +195,28 @@ TEST_P(LocalStoreTest, testGetResult) {
   EXPECT_THROW(result2.piece(), std::domain_error);
 }
 
+TEST_P(LocalStoreTest, getBatch_returns_results_in_key_order) {
+  StringPiece key1 = "foo";
+  StringPiece key2 = "bar";
+  StringPiece key3 = "baz";
+  store_->put(KeySpace::BlobFamily, key1, "one"_sp);
+  store_->put(KeySpace::BlobFamily, key3, "three"_sp);
+
+  auto results = store_
+                     ->getBatch(
+                         KeySpace::BlobFamily,
+                         {folly::ByteRange{key1},
+                          folly::ByteRange{key2},
+                          folly::ByteRange{key3}})
+                     .get(10s);
+  ASSERT_EQ(3, results.size());
+  ASSERT_TRUE(results[0].isValid());
+  EXPECT_EQ("one", results[0].piece());
+  EXPECT_FALSE(results[1].isValid());
+  ASSERT_TRUE(results[2].isValid());
+  EXPECT_EQ("three", results[2].piece());
+}
+
 TEST_P(LocalStoreTest, StoreResult_contains_keyspace_name_and_key) {
   auto key = ObjectId{kEmptySha1.getBytes()};
   auto result = store_->get(KeySpace::BlobFamily, key);
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/NegativeLookupFilter.h"
+
+#include <folly/Conv.h>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace facebook::eden;
+using Lookup = NegativeLookupFilter::Lookup;
+
+namespace {
+folly::ByteRange bytes(const std::string& key) {
+  return folly::ByteRange{folly::StringPiece{key}};
+}
+
+std::vector<std::string> makeKeys(folly::StringPiece prefix, size_t count) {
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < count; ++i) {
+    keys.push_back(folly::to<std::string>(prefix, i));
+  }
+  return keys;
+}
+
+void rebuildWith(
+    NegativeLookupFilter& filter,
+    KeySpace keySpace,
+    const std::vector<std::string>& keys) {
+  filter.rebuild(keySpace, [&](auto addKey) {
+    for (const auto& key : keys) {
+      addKey(bytes(key));
+    }
+  });
+}
+} // namespace
+
+TEST(NegativeLookupFilter, key_spaces_are_unfiltered_until_rebuilt) {
+  NegativeLookupFilter filter;
+  std::string key{"key"};
+  EXPECT_EQ(
+      Lookup::Unfiltered, filter.lookup(KeySpace::BlobFamily, bytes(key)));
+  EXPECT_TRUE(filter.needsRebuild(KeySpace::BlobFamily, std::chrono::hours{1}));
+
+  rebuildWith(filter, KeySpace::BlobFamily, {});
+  EXPECT_EQ(Lookup::Absent, filter.lookup(KeySpace::BlobFamily, bytes(key)));
+  EXPECT_FALSE(
+      filter.needsRebuild(KeySpace::BlobFamily, std::chrono::hours{1}));
+  // Each key space has its own filter.
+  EXPECT_EQ(
+      Lookup::Unfiltered, filter.lookup(KeySpace::TreeFamily, bytes(key)));
+
+  filter.clear(KeySpace::BlobFamily);
+  EXPECT_EQ(
+      Lookup::Unfiltered, filter.lookup(KeySpace::BlobFamily, bytes(key)));
+}
+
+TEST(NegativeLookupFilter, persistent_key_spaces_are_never_filtered) {
+  NegativeLookupFilter filter;
+  rebuildWith(filter, KeySpace::HgProxyHashFamily, {});
+  std::string key{"key"};
+  EXPECT_EQ(
+      Lookup::Unfiltered,
+      filter.lookup(KeySpace::HgProxyHashFamily, bytes(key)));
+  EXPECT_FALSE(
+      filter.needsRebuild(KeySpace::HgProxyHashFamily, std::chrono::hours{1}));
+}
+
+TEST(NegativeLookupFilter, stored_keys_are_never_absent) {
+  NegativeLookupFilter filter;
+  auto scanned = makeKeys("scanned", 10000);
+  rebuildWith(filter, KeySpace::TreeFamily, scanned);
+
+  auto added = makeKeys("added", 10000);
+  for (const auto& key : added) {
+    filter.add(KeySpace::TreeFamily, bytes(key));
+  }
+
+  for (const auto& key : scanned) {
+    EXPECT_EQ(
+        Lookup::MaybePresent, filter.lookup(KeySpace::TreeFamily, bytes(key)));
+  }
+  for (const auto& key : added) {
+    EXPECT_EQ(
+        Lookup::MaybePresent, filter.lookup(KeySpace::TreeFamily, bytes(key)));
+  }
+  EXPECT_EQ(20000, filter.getStats(KeySpace::TreeFamily).keys);
+}
+
+TEST(NegativeLookupFilter, false_positive_rate_is_low) {
+  NegativeLookupFilter filter;
+  rebuildWith(filter, KeySpace::BlobFamily, makeKeys("stored", 50000));
+
+  size_t maybePresent = 0;
+  for (const auto& key : makeKeys("missing", 100000)) {
+    if (filter.lookup(KeySpace::BlobFamily, bytes(key)) ==
+        Lookup::MaybePresent) {
+      ++maybePresent;
+      filter.recordFalsePositive(KeySpace::BlobFamily);
+    }
+  }
+  // The filter is sized for twice the scanned keys, which puts the expected
+  // rate well under 0.5%.
+  EXPECT_LT(maybePresent, 500);
+
+  auto stats = filter.getStats(KeySpace::BlobFamily);
+  EXPECT_EQ(maybePresent, stats.falsePositives);
+  EXPECT_EQ(maybePresent, stats.maybePresent);
+  EXPECT_EQ(100000 - maybePresent, stats.absent);
+  EXPECT_EQ(50000, stats.keys);
+  EXPECT_EQ(100000, stats.capacity);
+}
+
+TEST(NegativeLookupFilter, keys_written_during_a_rebuild_are_kept) {
+  NegativeLookupFilter filter;
+  std::string old{"old"};
+  std::string queued{"queued"};
+  std::string written{"written"};
+  rebuildWith(filter, KeySpace::BlobFamily, {});
+  // Queued before the rebuild, only committed once its scan started.
+  filter.add(KeySpace::BlobFamily, bytes(queued));
+
+  filter.rebuild(KeySpace::BlobFamily, [&](auto addKey) {
+    addKey(bytes(old));
+    filter.add(KeySpace::BlobFamily, bytes(written));
+    filter.addWritten(KeySpace::BlobFamily, bytes(written));
+    filter.addWritten(
+        KeySpace::BlobFamily, NegativeLookupFilter::hashKey(bytes(queued)));
+  });
+
+  for (const auto& key : {old, queued, written}) {
+    EXPECT_EQ(
+        Lookup::MaybePresent, filter.lookup(KeySpace::BlobFamily, bytes(key)))
+        << key;
+  }
+}
+
+TEST(NegativeLookupFilter, failed_rebuilds_keep_the_current_filter) {
+  NegativeLookupFilter filter;
+  std::string key{"key"};
+  rebuildWith(filter, KeySpace::BlobFamily, {key});
+
+  EXPECT_THROW(
+      filter.rebuild(
+          KeySpace::BlobFamily,
+          [](auto) { throw std::runtime_error("scan failed"); }),
+      std::runtime_error);
+  EXPECT_EQ(
+      Lookup::MaybePresent, filter.lookup(KeySpace::BlobFamily, bytes(key)));
+
+  // Adds after the failed rebuild still reach the filter.
+  std::string later{"later"};
+  filter.add(KeySpace::BlobFamily, bytes(later));
+  EXPECT_EQ(
+      Lookup::MaybePresent, filter.lookup(KeySpace::BlobFamily, bytes(later)));
+}
+
+TEST(NegativeLookupFilter, full_filters_need_a_rebuild) {
+  NegativeLookupFilter filter;
+  rebuildWith(filter, KeySpace::BlobFamily, {});
+  auto capacity = filter.getStats(KeySpace::BlobFamily).capacity;
+  for (const auto& key : makeKeys("added", capacity + 1)) {
+    filter.add(KeySpace::BlobFamily, bytes(key));
+  }
+  EXPECT_TRUE(filter.needsRebuild(KeySpace::BlobFamily, std::chrono::hours{1}));
+  // A filter is also rebuilt once it is older than the given age.
+  rebuildWith(filter, KeySpace::BlobFamily, {});
+  EXPECT_TRUE(
+      filter.needsRebuild(KeySpace::BlobFamily, std::chrono::nanoseconds{-1}));
+}
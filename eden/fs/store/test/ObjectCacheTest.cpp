@@ -534,3 +534,278 @@ TEST(
   handle3.reset();
   EXPECT_TRUE(cache->contains(hash3));
 }
+
+/**
+ * sharded cache test cases
+ */
+
+TEST(ObjectCache, sharded_cache_finds_objects_in_all_shards) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(1000, 1, 4);
+  EXPECT_EQ(4, cache->getShardCount());
+
+  cache->insertSimple(object3);
+  cache->insertSimple(object4);
+  cache->insertSimple(object5);
+  cache->insertSimple(object6);
+
+  EXPECT_EQ(object3, cache->getSimple(hash3));
+  EXPECT_EQ(object4, cache->getSimple(hash4));
+  EXPECT_EQ(object5, cache->getSimple(hash5));
+  EXPECT_EQ(object6, cache->getSimple(hash6));
+  EXPECT_FALSE(cache->getSimple(hash9));
+}
+
+TEST(ObjectCache, sharded_cache_stats_are_summed_across_shards) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(1000, 1, 4);
+
+  cache->insertSimple(object3);
+  cache->insertSimple(object4);
+  cache->insertSimple(object5);
+  cache->getSimple(hash3);
+  cache->getSimple(hash4);
+  cache->getSimple(hash9);
+
+  auto stats = cache->getStats();
+  EXPECT_EQ(3, stats.objectCount);
+  EXPECT_EQ(12, stats.totalSizeInBytes);
+  EXPECT_EQ(2, stats.hitCount);
+  EXPECT_EQ(1, stats.missCount);
+
+  cache->clear();
+  stats = cache->getStats();
+  EXPECT_EQ(0, stats.objectCount);
+  EXPECT_EQ(0, stats.totalSizeInBytes);
+}
+
+TEST(ObjectCache, sharded_cache_respects_total_size) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(20, 0, 2);
+
+  cache->insertSimple(object3);
+  cache->insertSimple(object3a);
+  cache->insertSimple(object3b);
+  cache->insertSimple(object3c);
+  cache->insertSimple(object4);
+  cache->insertSimple(object5);
+  cache->insertSimple(object6);
+
+  EXPECT_LE(cache->getStats().totalSizeInBytes, 20);
+}
+
+TEST(ObjectCache, zero_shards_is_treated_as_one) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(10, 1, 0);
+  EXPECT_EQ(1, cache->getShardCount());
+  cache->insertSimple(object3);
+  EXPECT_EQ(object3, cache->getSimple(hash3));
+}
+
+TEST(ObjectCache, sharded_interest_handle_drop_evicts_from_its_shard) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::create(
+          1000, 0, 4);
+  auto handle3 = cache->insertInterestHandle(
+      object3,
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::Interest::
+          WantHandle);
+  cache->insertInterestHandle(object4);
+  EXPECT_TRUE(cache->contains(hash3));
+  handle3.reset();
+  EXPECT_FALSE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash4));
+}
+
+/**
+ * eviction policy test cases
+ */
+
+TEST(ObjectCache, slru_keeps_reaccessed_objects_over_one_shot_scans) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      10, 0, 1, CacheEvictionPolicy::SLRU);
+
+  cache->insertSimple(object3);
+  cache->insertSimple(object3a);
+  // Promote both to the protected segment.
+  cache->getSimple(hash3);
+  cache->getSimple(hash3a);
+
+  // A scan of objects that are never accessed again.
+  cache->insertSimple(object3b);
+  cache->insertSimple(object3c);
+  cache->insertSimple(object4);
+
+  EXPECT_TRUE(cache->contains(hash3));
+  EXPECT_FALSE(cache->contains(hash3b));
+
+  auto stats = cache->getStats();
+  EXPECT_EQ(2, stats.probationHitCount);
+  EXPECT_EQ(0, stats.protectedHitCount);
+  EXPECT_GE(stats.protectedObjectCount, 1);
+  EXPECT_LE(stats.protectedSizeInBytes, 8);
+
+  cache->getSimple(hash3);
+  EXPECT_EQ(1, cache->getStats().protectedHitCount);
+}
+
+TEST(ObjectCache, slru_demotes_protected_overflow_to_probation) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      100, 0, 1, CacheEvictionPolicy::SLRU);
+
+  // The protected segment holds at most 80 bytes.
+  auto big1 = std::make_shared<CacheObject>(hash9, 45);
+  auto big2 = std::make_shared<CacheObject>(hash11, 45);
+  cache->insertSimple(big1);
+  cache->insertSimple(big2);
+  cache->getSimple(hash9);
+  cache->getSimple(hash11);
+
+  auto stats = cache->getStats();
+  EXPECT_EQ(1, stats.protectedObjectCount);
+  EXPECT_EQ(45, stats.protectedSizeInBytes);
+  EXPECT_EQ(2, stats.objectCount);
+}
+
+TEST(ObjectCache, tinylfu_rejects_objects_colder_than_the_victim) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      10, 0, 1, CacheEvictionPolicy::TinyLFU);
+
+  cache->insertSimple(object3);
+  cache->insertSimple(object3a);
+  cache->insertSimple(object3b);
+  cache->getSimple(hash3);
+  cache->getSimple(hash3a);
+  cache->getSimple(hash3b);
+
+  // Never looked up: not worth evicting anything for.
+  cache->insertSimple(object3c);
+  EXPECT_FALSE(cache->contains(hash3c));
+  EXPECT_EQ(1, cache->getStats().admissionRejectCount);
+
+  // Frequently requested objects win admission.
+  for (int i = 0; i < 4; ++i) {
+    cache->getSimple(hash3c);
+  }
+  cache->insertSimple(object3c);
+  EXPECT_TRUE(cache->contains(hash3c));
+  EXPECT_LE(cache->getStats().totalSizeInBytes, 10);
+}
+
+TEST(ObjectCache, tinylfu_rejected_interest_handle_still_returns_object) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::create(
+          6, 0, 1, CacheEvictionPolicy::TinyLFU);
+
+  cache->insertInterestHandle(object3);
+  cache->insertInterestHandle(object3a);
+  cache->getInterestHandle(hash3);
+  cache->getInterestHandle(hash3a);
+
+  auto handle = cache->insertInterestHandle(
+      object3b,
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::Interest::
+          WantHandle);
+  EXPECT_FALSE(cache->contains(hash3b));
+  EXPECT_EQ(object3b, handle.getObject());
+  handle.reset();
+  EXPECT_TRUE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash3a));
+}
+
+TEST(ObjectCache, clients_over_their_fair_share_are_evicted_first) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(20, 1);
+  auto a = cache->registerClient();
+  auto b = cache->registerClient();
+
+  cache->insertSimple(object4, b);
+  cache->insertSimple(object3, a);
+  cache->insertSimple(object5, a);
+  cache->insertSimple(object6, a);
+  // The cache is full. Plain LRU would evict b's object4, but a is over its
+  // fair share of 10 bytes.
+  cache->insertSimple(object3a, b);
+
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_FALSE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash5));
+  EXPECT_TRUE(cache->contains(hash6));
+  EXPECT_TRUE(cache->contains(hash3a));
+
+  auto aStats = cache->getClientStats(a);
+  EXPECT_EQ(2, aStats.objectCount);
+  EXPECT_EQ(11, aStats.totalSizeInBytes);
+  EXPECT_EQ(1, aStats.evictionCount);
+  auto bStats = cache->getClientStats(b);
+  EXPECT_EQ(2, bStats.objectCount);
+  EXPECT_EQ(7, bStats.totalSizeInBytes);
+  EXPECT_EQ(0, bStats.evictionCount);
+}
+
+TEST(ObjectCache, client_hits_are_counted_for_the_client_looking_up) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(20, 1);
+  auto a = cache->registerClient();
+  auto b = cache->registerClient();
+
+  cache->insertSimple(object3, a);
+  EXPECT_EQ(object3, cache->getSimple(hash3, b));
+  EXPECT_EQ(nullptr, cache->getSimple(hash4, b));
+
+  auto aStats = cache->getClientStats(a);
+  EXPECT_EQ(1, aStats.objectCount);
+  EXPECT_EQ(0, aStats.hitCount);
+  auto bStats = cache->getClientStats(b);
+  EXPECT_EQ(0, bStats.objectCount);
+  EXPECT_EQ(1, bStats.hitCount);
+  EXPECT_EQ(1, bStats.missCount);
+}
+
+TEST(ObjectCache, unregistered_client_objects_are_evicted_first) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(20, 1);
+  auto a = cache->registerClient();
+  auto b = cache->registerClient();
+  auto c = cache->registerClient();
+
+  cache->insertSimple(object4, a);
+  cache->insertSimple(object3, c);
+  cache->insertSimple(object5, b);
+  cache->unregisterClient(c);
+  cache->insertSimple(object9, b);
+
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_FALSE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash5));
+  EXPECT_TRUE(cache->contains(hash9));
+  EXPECT_EQ(0, cache->getClientStats(c).objectCount);
+}
+
+TEST(ObjectCache, shrinkTo_evicts_least_recently_used) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(100, 1);
+  cache->insertSimple(object3);
+  cache->insertSimple(object4);
+  cache->insertSimple(object5);
+  cache->insertSimple(object6);
+  // object3 becomes the most recently used.
+  cache->getSimple(object3->getHash());
+
+  EXPECT_EQ(9, cache->shrinkTo(10));
+  EXPECT_TRUE(cache->contains(object3->getHash()));
+  EXPECT_FALSE(cache->contains(object4->getHash()));
+  EXPECT_FALSE(cache->contains(object5->getHash()));
+  EXPECT_TRUE(cache->contains(object6->getHash()));
+  EXPECT_EQ(9, cache->getStats().totalSizeInBytes);
+
+  // The minimum entry count is kept.
+  EXPECT_EQ(6, cache->shrinkTo(0));
+  EXPECT_TRUE(cache->contains(object3->getHash()));
+  EXPECT_EQ(1, cache->getStats().objectCount);
+
+  // The budget is unchanged.
+  cache->insertSimple(object9);
+  EXPECT_TRUE(cache->contains(object3->getHash()));
+  EXPECT_TRUE(cache->contains(object9->getHash()));
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ObjectCacheTrace.h"
+#include <gtest/gtest.h>
+#include "eden/fs/store/ObjectCache.h"
+
+using namespace facebook::eden;
+using Operation = ObjectCacheTrace::Operation;
+
+namespace {
+
+class CacheObject {
+ public:
+  CacheObject(ObjectId hash, size_t size) : hash_{hash}, size_{size} {}
+
+  const ObjectId& getHash() const {
+    return hash_;
+  }
+
+  size_t getSizeBytes() const {
+    return size_;
+  }
+
+ private:
+  ObjectId hash_;
+  size_t size_;
+};
+
+using SimpleObjectCache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>;
+
+const auto hash1 =
+    ObjectId::fromHex("0000000000000000000000000000000000000001");
+const auto hash2 =
+    ObjectId::fromHex("0000000000000000000000000000000000000002");
+const auto hash3 =
+    ObjectId::fromHex("0000000000000000000000000000000000000003");
+
+} // namespace
+
+TEST(ObjectCacheTrace, keepsTheMostRecentEvents) {
+  ObjectCacheTrace trace{2};
+  trace.record(Operation::Miss, hash1, 0);
+  trace.record(Operation::Insert, hash1, 10);
+  trace.record(Operation::Hit, hash1, 10);
+
+  auto events = trace.getEvents();
+  ASSERT_EQ(2, events.size());
+  EXPECT_EQ(Operation::Insert, events[0].operation);
+  EXPECT_EQ(Operation::Hit, events[1].operation);
+  EXPECT_LE(events[0].timestampUs, events[1].timestampUs);
+  EXPECT_EQ(1, trace.getDroppedCount());
+}
+
+TEST(ObjectCacheTrace, idsAreHashed) {
+  EXPECT_EQ(
+      ObjectCacheTrace::hashId(hash1),
+      ObjectCacheTrace::hashId(ObjectId{hash1}));
+  EXPECT_NE(ObjectCacheTrace::hashId(hash1), ObjectCacheTrace::hashId(hash2));
+}
+
+TEST(ObjectCacheTrace, serializedEventsParseBack) {
+  ObjectCacheTrace trace{8};
+  trace.record(Operation::Miss, hash1, 0);
+  trace.record(Operation::Insert, hash1, 4096);
+  trace.record(Operation::Hit, hash1, 4096);
+
+  auto events = trace.getEvents();
+  auto parsed = ObjectCacheTrace::parse(ObjectCacheTrace::serialize(events));
+  ASSERT_EQ(events.size(), parsed.size());
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(events[i].timestampUs, parsed[i].timestampUs);
+    EXPECT_EQ(events[i].id, parsed[i].id);
+    EXPECT_EQ(events[i].sizeBytes, parsed[i].sizeBytes);
+    EXPECT_EQ(events[i].operation, parsed[i].operation);
+  }
+}
+
+TEST(ObjectCacheTrace, parseRejectsMalformedEvents) {
+  EXPECT_THROW(
+      ObjectCacheTrace::parse("1 lookup 00000000000000ff 10\n"),
+      std::invalid_argument);
+  EXPECT_THROW(
+      ObjectCacheTrace::parse("1 hit 00000000000000ff\n"),
+      std::invalid_argument);
+  EXPECT_THROW(
+      ObjectCacheTrace::parse("1 hit 00000000000000ff big\n"),
+      std::invalid_argument);
+  EXPECT_TRUE(ObjectCacheTrace::parse("\n").empty());
+}
+
+TEST(ObjectCacheTrace, cacheRecordsItsAccesses) {
+  auto cache = SimpleObjectCache::create(10, 0);
+  auto trace = std::make_shared<ObjectCacheTrace>(16);
+  cache->setTrace(trace);
+
+  EXPECT_EQ(nullptr, cache->getSimple(hash1));
+  cache->insertSimple(std::make_shared<CacheObject>(hash1, 6));
+  EXPECT_NE(nullptr, cache->getSimple(hash1));
+  // Evicts hash1.
+  cache->insertSimple(std::make_shared<CacheObject>(hash2, 6));
+  EXPECT_EQ(nullptr, cache->getSimple(hash1));
+  EXPECT_FALSE(cache->contains(hash3));
+
+  auto events = trace->getEvents();
+  ASSERT_EQ(5, events.size());
+  EXPECT_EQ(Operation::Miss, events[0].operation);
+  EXPECT_EQ(0, events[0].sizeBytes);
+  EXPECT_EQ(Operation::Insert, events[1].operation);
+  EXPECT_EQ(6, events[1].sizeBytes);
+  EXPECT_EQ(Operation::Hit, events[2].operation);
+  EXPECT_EQ(6, events[2].sizeBytes);
+  EXPECT_EQ(Operation::Insert, events[3].operation);
+  EXPECT_EQ(ObjectCacheTrace::hashId(hash2), events[3].id);
+  EXPECT_EQ(Operation::Miss, events[4].operation);
+  EXPECT_EQ(ObjectCacheTrace::hashId(hash1), events[4].id);
+}
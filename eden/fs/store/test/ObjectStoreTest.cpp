@@ -5,6 +5,7 @@
  * GNU General Public License version 2.
  */
 
+#include <folly/executors/ManualExecutor.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
@@ -138,6 +139,33 @@ TEST_F(ObjectStoreTest, getTree_tracks_second_read_from_local_store) {
   EXPECT_EQ(ObjectFetchContext::FromDiskCache, request.origin);
 }
 
+TEST_F(ObjectStoreTest, ready_backing_store_objects_skip_the_executor) {
+  folly::ManualExecutor manualExecutor;
+  auto store = ObjectStore::create(
+      localStore,
+      fakeBackingStore,
+      treeCache,
+      stats,
+      &manualExecutor,
+      std::make_shared<ProcessNameCache>(),
+      std::make_shared<NullStructuredLogger>(),
+      EdenConfig::createTestEdenConfig());
+
+  auto blobFuture = store->getBlob(readyBlobId, context);
+  EXPECT_TRUE(blobFuture.isReady());
+  auto treeFuture = store->getTree(readyTreeId, context);
+  EXPECT_TRUE(treeFuture.isReady());
+  EXPECT_EQ(0, manualExecutor.drain());
+
+  // Objects that are not ready are still processed on the executor.
+  StoredBlob* pendingBlob = fakeBackingStore->putBlob("pending");
+  auto pendingFuture = store->getBlob(pendingBlob->get().getHash(), context);
+  pendingBlob->setReady();
+  EXPECT_FALSE(pendingFuture.isReady());
+  EXPECT_LT(0, manualExecutor.drain());
+  EXPECT_TRUE(pendingFuture.isReady());
+}
+
 TEST_F(ObjectStoreTest, getBlobSize_tracks_backing_store_read) {
   objectStore->getBlobSize(readyBlobId, context).get(0ms);
   ASSERT_EQ(1, context.requests.size());
@@ -215,6 +243,47 @@ TEST_F(ObjectStoreTest, getBlobSha1NotFound) {
       "blob .* not found");
 }
 
+TEST_F(ObjectStoreTest, getBlobBlake3IsStoredWithBlobMetadata) {
+  auto data = "A"_sp;
+  ObjectId id = putReadyBlob(data);
+
+  auto expectedBlake3 = Blake3::hash(folly::ByteRange{data});
+  EXPECT_EQ(expectedBlake3, objectStore->getBlobBlake3(id, context).get(0ms));
+
+  auto metadata = localStore->getBlobMetadata(id).get(0ms);
+  ASSERT_TRUE(metadata.has_value());
+  EXPECT_EQ(Hash20::sha1(data), metadata->sha1);
+  EXPECT_EQ(data.size(), metadata->size);
+  EXPECT_EQ(expectedBlake3, metadata->blake3);
+}
+
+TEST_F(ObjectStoreTest, getTree_stores_metadata_of_imported_entries) {
+  auto data = "file contents"_sp;
+  auto* storedBlob = fakeBackingStore->putBlob(data);
+  auto blobId = storedBlob->get().getHash();
+  auto* storedTree = fakeBackingStore->putTree(std::vector<TreeEntry>{
+      TreeEntry{
+          blobId,
+          PathComponent{"file"},
+          TreeEntryType::REGULAR_FILE,
+          data.size(),
+          Hash20::sha1(data)},
+      TreeEntry{
+          readyBlobId,
+          PathComponent{"no_metadata"},
+          TreeEntryType::REGULAR_FILE},
+  });
+  storedTree->setReady();
+  objectStore->getTree(storedTree->get().getHash(), context).get(0ms);
+
+  // The blob was never made ready, so its size has to come from the tree.
+  EXPECT_EQ(data.size(), objectStore->getBlobSize(blobId, context).get(0ms));
+  EXPECT_EQ(
+      Hash20::sha1(data), objectStore->getBlobSha1(blobId, context).get(0ms));
+  EXPECT_EQ(0, fakeBackingStore->getAccessCount(blobId));
+  EXPECT_FALSE(localStore->getBlobMetadata(readyBlobId).get(0ms).has_value());
+}
+
 TEST_F(ObjectStoreTest, get_size_and_sha1_only_imports_blob_once) {
   objectStore->getBlobSize(readyBlobId, context).get(0ms);
   objectStore->getBlobSha1(readyBlobId, context).get(0ms);
@@ -222,6 +291,40 @@ TEST_F(ObjectStoreTest, get_size_and_sha1_only_imports_blob_once) {
   EXPECT_EQ(1, fakeBackingStore->getAccessCount(readyBlobId));
 }
 
+TEST_F(ObjectStoreTest, concurrent_blob_fetches_share_one_import) {
+  auto store = ObjectStore::create(
+      localStore,
+      fakeBackingStore,
+      treeCache,
+      stats,
+      executor,
+      std::make_shared<ProcessNameCache>(),
+      std::make_shared<NullStructuredLogger>(),
+      EdenConfig::createTestEdenConfig());
+
+  StoredBlob* pendingBlob = fakeBackingStore->putBlob("pending");
+  auto blobId = pendingBlob->get().getHash();
+  auto blobFuture1 = store->getBlob(blobId, context);
+  auto blobFuture2 = store->getBlob(blobId, context);
+  auto sizeFuture = store->getBlobSize(blobId, context).semi();
+  EXPECT_FALSE(blobFuture1.isReady());
+  EXPECT_FALSE(blobFuture2.isReady());
+
+  pendingBlob->setReady();
+  EXPECT_EQ(
+      "pending",
+      std::move(blobFuture1).get(0ms)->getContents().clone()->moveToFbString());
+  EXPECT_EQ(
+      "pending",
+      std::move(blobFuture2).get(0ms)->getContents().clone()->moveToFbString());
+  EXPECT_EQ(7, std::move(sizeFuture).get(0ms));
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(blobId));
+
+  // Once done, the import is not joined anymore.
+  store->getBlob(blobId, context).get(0ms);
+  EXPECT_EQ(2, fakeBackingStore->getAccessCount(blobId));
+}
+
 class PidFetchContext : public ObjectFetchContext {
  public:
   PidFetchContext(pid_t pid) : ObjectFetchContext{}, pid_{pid} {}
@@ -253,3 +356,55 @@ TEST_F(ObjectStoreTest, test_process_access_counts) {
   EXPECT_EQ(2, objectStore->getPidFetches().rlock()->at(pid0));
   EXPECT_EQ(1, objectStore->getPidFetches().rlock()->at(pid1));
 }
+
+TEST_F(ObjectStoreTest, backing_store_fetches_are_charged_to_the_process) {
+  pid_t pid0{10000};
+  PidFetchContext pidContext0{pid0};
+  pid_t pid1{10001};
+  PidFetchContext pidContext1{pid1};
+
+  // The first fetch imports the blob from the backing store.
+  objectStore->getBlob(readyBlobId, pidContext0).get(0ms);
+  auto fetches = objectStore->getPidBackingStoreFetches().rlock()->at(pid0);
+  EXPECT_EQ(1, fetches.count);
+  EXPECT_EQ(9, fetches.bytes);
+
+  // Later fetches are served from the local store and cost nothing.
+  objectStore->getBlob(readyBlobId, pidContext0).get(0ms);
+  objectStore->getBlob(readyBlobId, pidContext1).get(0ms);
+  EXPECT_EQ(1, objectStore->getPidBackingStoreFetches().rlock()->size());
+  fetches = objectStore->getPidBackingStoreFetches().rlock()->at(pid0);
+  EXPECT_EQ(1, fetches.count);
+}
+
+TEST(PidFetchCounts, recent_backing_store_fetches_slide_out_of_the_window) {
+  PidFetchCounts counts;
+  pid_t pid0{10000};
+  pid_t pid1{10001};
+  auto start = std::chrono::steady_clock::now();
+  counts.recordBackingStoreFetch(pid0, 100, start);
+  counts.recordBackingStoreFetch(pid0, 200, start + 10s);
+  counts.recordBackingStoreFetch(pid1, 1, start + 10s);
+
+  auto recent = counts.getRecentBackingStoreFetchesByPid(pid0, start + 10s);
+  EXPECT_EQ(2, recent.count);
+  EXPECT_EQ(300, recent.bytes);
+  EXPECT_EQ(
+      1, counts.getRecentBackingStoreFetchesByPid(pid1, start + 10s).count);
+
+  // A minute and a bit later only the second fetch is still recent...
+  recent = counts.getRecentBackingStoreFetchesByPid(pid0, start + 66s);
+  EXPECT_EQ(1, recent.count);
+  EXPECT_EQ(200, recent.bytes);
+  // ... and then none of them are, while the totals are kept.
+  recent = counts.getRecentBackingStoreFetchesByPid(pid0, start + 90s);
+  EXPECT_EQ(0, recent.count);
+  EXPECT_EQ(2, counts.getBackingStoreFetchesByPid(pid0).count);
+
+  counts.recordBackingStoreFetch(pid0, 50, start + 90s);
+  EXPECT_EQ(
+      1, counts.getRecentBackingStoreFetchesByPid(pid0, start + 90s).count);
+  counts.clear();
+  EXPECT_EQ(
+      0, counts.getRecentBackingStoreFetchesByPid(pid0, start + 90s).count);
+}
@@ -6,6 +6,7 @@
  */
 
 #include "eden/fs/store/RocksDbLocalStore.h"
+#include "eden/fs/model/Blob.h"
 #include "eden/fs/store/test/LocalStoreTest.h"
 #include "eden/fs/telemetry/NullStructuredLogger.h"
 
@@ -22,6 +23,143 @@ LocalStoreImplResult makeRocksDbLocalStore(FaultInjector* faultInjector) {
   return {std::move(tempDir), std::move(store)};
 }
 
+TEST(RocksDbLocalStoreTest, rotation_keeps_objects_read_since_the_last_one) {
+  using namespace folly::string_piece_literals;
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto tempDir = makeTempDir();
+  auto store = std::make_unique<RocksDbLocalStore>(
+      AbsolutePathPiece{tempDir.path().string()},
+      std::make_shared<NullStructuredLogger>(),
+      &faultInjector);
+
+  store->put(KeySpace::TreeFamily, "hot"_sp, "hot tree"_sp);
+  store->put(KeySpace::TreeFamily, "cold"_sp, "cold tree"_sp);
+
+  // Both trees move to the previous generation and stay readable.
+  store->rotateKeySpace(KeySpace::TreeFamily);
+  EXPECT_TRUE(store->hasKey(KeySpace::TreeFamily, "hot"_sp));
+
+  // Only the tree read since the first rotation survives the second.
+  store->rotateKeySpace(KeySpace::TreeFamily);
+  auto hot = store->get(KeySpace::TreeFamily, "hot"_sp);
+  ASSERT_TRUE(hot.isValid());
+  EXPECT_EQ("hot tree", hot.piece());
+  EXPECT_FALSE(store->get(KeySpace::TreeFamily, "cold"_sp).isValid());
+
+  // Clearing the key space clears both generations.
+  store->clearKeySpace(KeySpace::TreeFamily);
+  EXPECT_FALSE(store->hasKey(KeySpace::TreeFamily, "hot"_sp));
+}
+
+TEST(RocksDbLocalStoreTest, persistent_key_spaces_wait_for_background_open) {
+  using namespace folly::string_piece_literals;
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto tempDir = makeTempDir();
+  AbsolutePathPiece path{tempDir.path().string()};
+  {
+    auto store = std::make_shared<RocksDbLocalStore>(
+        path, std::make_shared<NullStructuredLogger>(), &faultInjector);
+    store->put(KeySpace::HgProxyHashFamily, "proxy"_sp, "first"_sp);
+  }
+
+  auto store = std::make_shared<RocksDbLocalStore>(
+      path,
+      std::make_shared<NullStructuredLogger>(),
+      &faultInjector,
+      RocksDBOpenMode::ReadWrite,
+      /*config=*/nullptr,
+      RocksDBOpenTiming::Background);
+  // Whether or not the DB is open yet, persistent data is never missing.
+  auto proxy = store->get(KeySpace::HgProxyHashFamily, "proxy"_sp);
+  ASSERT_TRUE(proxy.isValid());
+  EXPECT_EQ("first", proxy.piece());
+
+  std::move(store->getOpenFuture()).get();
+  store->put(KeySpace::TreeFamily, "tree"_sp, "tree data"_sp);
+  EXPECT_TRUE(store->hasKey(KeySpace::TreeFamily, "tree"_sp));
+}
+
+TEST(RocksDbLocalStoreTest, identical_blob_contents_are_stored_once) {
+  using namespace std::chrono_literals;
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto tempDir = makeTempDir();
+  auto store = std::make_shared<RocksDbLocalStore>(
+      AbsolutePathPiece{tempDir.path().string()},
+      std::make_shared<NullStructuredLogger>(),
+      &faultInjector);
+  store->enableBlobCaching = true;
+  store->enableBlobDeduplication = true;
+
+  auto original = ObjectId::fromHex("1111111111111111111111111111111111111111");
+  auto copy = ObjectId::fromHex("2222222222222222222222222222222222222222");
+  Blob originalBlob{original, folly::StringPiece{"vendored contents"}};
+  Blob copyBlob{copy, folly::StringPiece{"vendored contents"}};
+  EXPECT_FALSE(store->putBlob(original, &originalBlob));
+  EXPECT_TRUE(store->putBlob(copy, &copyBlob));
+  EXPECT_FALSE(store->hasKey(KeySpace::BlobFamily, copy));
+
+  auto blob = store->getBlob(copy).get(10s);
+  ASSERT_TRUE(blob);
+  EXPECT_EQ(copy, blob->getHash());
+  EXPECT_EQ(
+      "vendored contents",
+      blob->getContents().clone()->moveToFbString().toStdString());
+  EXPECT_TRUE(store->getBlobMetadata(original).get(10s).has_value());
+
+  // Blobs stored before deduplication was enabled remain readable.
+  auto older = ObjectId::fromHex("3333333333333333333333333333333333333333");
+  Blob olderBlob{older, folly::StringPiece{"older contents"}};
+  store->enableBlobDeduplication = false;
+  store->putBlob(older, &olderBlob);
+  store->putBlobMetadata(older, &olderBlob);
+  store->enableBlobDeduplication = true;
+  ASSERT_TRUE(store->getBlob(older).get(10s));
+}
+
+TEST(RocksDbLocalStoreTest, negative_lookup_filter_answers_misses) {
+  using namespace std::chrono_literals;
+  using namespace folly::string_piece_literals;
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto tempDir = makeTempDir();
+  auto store = std::make_shared<RocksDbLocalStore>(
+      AbsolutePathPiece{tempDir.path().string()},
+      std::make_shared<NullStructuredLogger>(),
+      &faultInjector);
+
+  store->put(KeySpace::TreeFamily, "current"_sp, "current tree"_sp);
+  store->rotateKeySpace(KeySpace::TreeFamily);
+  store->put(KeySpace::TreeFamily, "stored"_sp, "stored tree"_sp);
+  store->rebuildNegativeLookupFilter(KeySpace::TreeFamily);
+
+  // Keys of both generations are in the filter.
+  EXPECT_TRUE(store->hasKey(KeySpace::TreeFamily, "current"_sp));
+  EXPECT_TRUE(store->get(KeySpace::TreeFamily, "stored"_sp).isValid());
+  EXPECT_FALSE(store->hasKey(KeySpace::TreeFamily, "missing"_sp));
+
+  // Keys written after the rebuild, directly or in a batch, are added.
+  store->put(KeySpace::TreeFamily, "put"_sp, "put tree"_sp);
+  auto batch = store->beginWrite();
+  batch->put(KeySpace::TreeFamily, "batched"_sp, "batched tree"_sp);
+  batch->flush();
+  auto results = store
+                     ->getBatch(
+                         KeySpace::TreeFamily,
+                         {folly::ByteRange{"put"_sp},
+                          folly::ByteRange{"other"_sp},
+                          folly::ByteRange{"batched"_sp}})
+                     .get(10s);
+  ASSERT_EQ(3, results.size());
+  EXPECT_EQ("put tree", results[0].piece());
+  EXPECT_FALSE(results[1].isValid());
+  EXPECT_EQ("batched tree", results[2].piece());
+
+  auto stats = store->getNegativeLookupFilterStats(KeySpace::TreeFamily);
+  EXPECT_EQ(4, stats.keys);
+  // Whether each missing key was ruled out by the filter or was a false
+  // positive, every one of them was counted.
+  EXPECT_EQ(2, stats.absent + stats.falsePositives);
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 INSTANTIATE_TEST_CASE_P(
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TreePinSet.h"
+
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/LocalStoreCachedBackingStore.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/TreeCache.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/LoggingFetchContext.h"
+#include "eden/fs/testharness/StoredObject.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct TreePinSetTest : ::testing::Test {
+  void SetUp() override {
+    auto localStore = std::make_shared<MemoryLocalStore>();
+    auto stats = std::make_shared<EdenStats>();
+    fakeBackingStore = std::make_shared<FakeBackingStore>();
+    auto edenConfig = std::make_shared<ReloadableConfig>(
+        EdenConfig::createTestEdenConfig(), ConfigReloadBehavior::NoReload);
+    objectStore = ObjectStore::create(
+        localStore,
+        std::make_shared<LocalStoreCachedBackingStore>(
+            fakeBackingStore, localStore, stats),
+        TreeCache::create(edenConfig),
+        stats,
+        &folly::QueuedImmediateExecutor::instance(),
+        std::make_shared<ProcessNameCache>(),
+        std::make_shared<NullStructuredLogger>(),
+        EdenConfig::createTestEdenConfig());
+
+    auto* blob = fakeBackingStore->putBlob("contents");
+    blob->setReady();
+    treeA = putReadyTree({{"a", blob}});
+    treeB = putReadyTree({{"b", blob}});
+  }
+
+  ObjectId putReadyTree(
+      const std::initializer_list<FakeBackingStore::TreeEntryData>& entries) {
+    auto* storedTree = fakeBackingStore->putTree(entries);
+    storedTree->setReady();
+    return storedTree->get().getHash();
+  }
+
+  std::shared_ptr<const Tree> getTree(TreePinSet& pins, const ObjectId& id) {
+    return pins.getTree(id, *objectStore, context).get(0ms);
+  }
+
+  size_t getSizeBytes(const ObjectId& id) {
+    return objectStore->getTree(id, context).get(0ms)->getSizeBytes();
+  }
+
+  LoggingFetchContext context;
+  std::shared_ptr<FakeBackingStore> fakeBackingStore;
+  std::shared_ptr<ObjectStore> objectStore;
+  ObjectId treeA;
+  ObjectId treeB;
+};
+
+} // namespace
+
+TEST_F(TreePinSetTest, pinnedTreesAreNotFetchedAgain) {
+  TreePinSet pins{1024 * 1024};
+  auto tree = getTree(pins, treeA);
+  EXPECT_EQ(treeA, tree->getHash());
+  EXPECT_EQ(tree, getTree(pins, treeA));
+  EXPECT_EQ(1, context.requests.size());
+  EXPECT_EQ(tree->getSizeBytes(), pins.getTotalBytes());
+}
+
+TEST_F(TreePinSetTest, zeroBudgetDisablesPinning) {
+  TreePinSet pins{0};
+  getTree(pins, treeA);
+  getTree(pins, treeA);
+  EXPECT_EQ(2, context.requests.size());
+  EXPECT_EQ(nullptr, pins.get(treeA));
+  EXPECT_EQ(0, pins.getTotalBytes());
+}
+
+TEST_F(TreePinSetTest, treesBeyondTheBudgetAreNotPinned) {
+  TreePinSet pins{getSizeBytes(treeA)};
+  getTree(pins, treeA);
+  getTree(pins, treeB);
+  EXPECT_NE(nullptr, pins.get(treeA));
+  EXPECT_EQ(nullptr, pins.get(treeB));
+  EXPECT_EQ(getSizeBytes(treeA), pins.getTotalBytes());
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/WriteBehindQueue.h"
+
+#include <folly/Synchronized.h>
+#include <folly/portability/GTest.h>
+#include <map>
+#include <thread>
+#include <vector>
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct Committed {
+  std::map<std::string, std::string> entries;
+  size_t commits = 0;
+};
+
+WriteBehindQueue::CommitFn recordInto(folly::Synchronized<Committed>& out) {
+  return [&out](const WriteBehindQueue::Pending& pending) {
+    auto committed = out.wlock();
+    for (const auto& [key, value] : pending[KeySpace::BlobFamily.index]) {
+      committed->entries[key] = value;
+    }
+    committed->commits++;
+  };
+}
+
+} // namespace
+
+TEST(WriteBehindQueue, queued_writes_are_readable_until_committed) {
+  folly::Synchronized<Committed> committed;
+  WriteBehindQueue queue{1h, 1024 * 1024, recordInto(committed)};
+
+  EXPECT_TRUE(queue.put(KeySpace::BlobFamily, "key"_sp, "first"_sp));
+  EXPECT_TRUE(queue.put(KeySpace::BlobFamily, "key"_sp, "second"_sp));
+  EXPECT_EQ("second", queue.get(KeySpace::BlobFamily, "key"_sp));
+  EXPECT_FALSE(queue.get(KeySpace::TreeFamily, "key"_sp).has_value());
+  EXPECT_EQ(0, committed.rlock()->commits);
+
+  queue.flush();
+  EXPECT_FALSE(queue.get(KeySpace::BlobFamily, "key"_sp).has_value());
+  auto result = committed.rlock();
+  EXPECT_EQ(1, result->commits);
+  EXPECT_EQ("second", result->entries.at("key"));
+}
+
+TEST(WriteBehindQueue, writes_from_many_threads_are_grouped) {
+  folly::Synchronized<Committed> committed;
+  WriteBehindQueue queue{50ms, 1024 * 1024, recordInto(committed)};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&queue, t] {
+      for (int i = 0; i < 100; ++i) {
+        auto key = folly::to<std::string>(t, "-", i);
+        queue.put(
+            KeySpace::BlobFamily,
+            folly::StringPiece{key},
+            folly::StringPiece{key});
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  queue.flush();
+
+  auto result = committed.rlock();
+  EXPECT_EQ(400, result->entries.size());
+  EXPECT_GT(400, result->commits);
+}
+
+TEST(WriteBehindQueue, full_queue_commits_early) {
+  folly::Synchronized<Committed> committed;
+  WriteBehindQueue queue{1h, 16, recordInto(committed)};
+
+  queue.put(KeySpace::BlobFamily, "a"_sp, "0123456789abcdef"_sp);
+  // This put waits for the first one to be taken by a commit.
+  queue.put(KeySpace::BlobFamily, "b"_sp, "0123456789abcdef"_sp);
+  queue.flush();
+  auto result = committed.rlock();
+  EXPECT_EQ(2, result->entries.size());
+  EXPECT_EQ(2, result->commits);
+}
+
+TEST(WriteBehindQueue, stopping_commits_and_refuses_later_writes) {
+  folly::Synchronized<Committed> committed;
+  WriteBehindQueue queue{1h, 1024 * 1024, recordInto(committed)};
+
+  queue.put(KeySpace::BlobFamily, "key"_sp, "value"_sp);
+  queue.stop();
+  EXPECT_EQ("value", committed.rlock()->entries.at("key"));
+  EXPECT_FALSE(queue.put(KeySpace::BlobFamily, "other"_sp, "value"_sp));
+  queue.flush();
+}
@@ -10,10 +10,16 @@
 #include "eden/fs/takeover/TakeoverData.h"
 
 #include <stdexcept>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
 #include <folly/Format.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
+#include <folly/portability/SysStat.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #include "eden/fs/utils/Bug.h"
@@ -28,7 +34,8 @@ namespace eden {
 const std::set<int32_t> kSupportedTakeoverVersions{
     TakeoverData::kTakeoverProtocolVersionOne,
     TakeoverData::kTakeoverProtocolVersionThree,
-    TakeoverData::kTakeoverProtocolVersionFour};
+    TakeoverData::kTakeoverProtocolVersionFour,
+    TakeoverData::kTakeoverProtocolVersionFive};
 
 std::optional<int32_t> TakeoverData::computeCompatibleVersion(
     const std::set<int32_t>& versions,
@@ -63,6 +70,10 @@ uint64_t TakeoverData::versionToCapabilites(int32_t version) {
       return TakeoverCapabilities::FUSE |
           TakeoverCapabilities::THRIFT_SERIALIZATION |
           TakeoverCapabilities::PING;
+    case kTakeoverProtocolVersionFive:
+      return TakeoverCapabilities::FUSE |
+          TakeoverCapabilities::THRIFT_SERIALIZATION |
+          TakeoverCapabilities::PING | TakeoverCapabilities::CACHE_HANDOFF;
   }
   throw std::runtime_error(fmt::format("Unsupported version: {}", version));
 }
@@ -86,6 +97,11 @@ int32_t TakeoverData::capabilitesToVersion(uint64_t capabilities) {
        TakeoverCapabilities::PING)) {
     return kTakeoverProtocolVersionFour;
   }
+  if (capabilities ==
+      (TakeoverCapabilities::FUSE | TakeoverCapabilities::THRIFT_SERIALIZATION |
+       TakeoverCapabilities::PING | TakeoverCapabilities::CACHE_HANDOFF)) {
+    return kTakeoverProtocolVersionFive;
+  }
 
   throw std::runtime_error(
       fmt::format("Unsupported combination of capabilities: {}", capabilities));
@@ -100,6 +116,11 @@ void TakeoverData::serialize(
   for (auto& mount : mountPoints) {
     msg.files.push_back(std::move(mount.fuseFD));
   }
+  // The client tells whether it was sent from the number of files.
+  if ((protocolCapabilities & TakeoverCapabilities::CACHE_HANDOFF) &&
+      cacheContents) {
+    msg.files.push_back(std::move(cacheContents));
+  }
 }
 
 IOBuf TakeoverData::serialize(uint64_t protocolCapabilities) {
@@ -120,6 +141,46 @@ IOBuf TakeoverData::serialize(uint64_t protocolCapabilities) {
   }
 }
 
+folly::File TakeoverData::writeCacheContents(
+    const SerializedCacheContents& contents) {
+#ifdef __linux__
+  int fd = memfd_create("edenfs_takeover_caches", MFD_CLOEXEC);
+  folly::checkUnixError(fd, "memfd_create failed");
+  folly::File file{fd, /*ownsFd=*/true};
+#else
+  auto file = folly::File::temporary();
+#endif
+
+  auto serialized =
+      CompactSerializer::serialize<folly::IOBufQueue>(contents).move();
+  for (auto range : *serialized) {
+    auto written = folly::writeFull(file.fd(), range.data(), range.size());
+    folly::checkUnixError(written, "failed to write the cache contents");
+  }
+  return file;
+}
+
+SerializedCacheContents TakeoverData::readCacheContents(
+    const folly::File& file) {
+  struct stat st;
+  folly::checkUnixError(fstat(file.fd(), &st), "fstat failed");
+
+  // The file offset is shared with the sender, so read from the start
+  // explicitly.
+  std::string serialized;
+  serialized.resize(st.st_size);
+  auto bytesRead =
+      folly::preadFull(file.fd(), serialized.data(), serialized.size(), 0);
+  folly::checkUnixError(bytesRead, "failed to read the cache contents");
+  if (static_cast<size_t>(bytesRead) != serialized.size()) {
+    throw std::runtime_error(fmt::format(
+        "read {} bytes of cache contents out of {}",
+        bytesRead,
+        serialized.size()));
+  }
+  return CompactSerializer::deserialize<SerializedCacheContents>(serialized);
+}
+
 folly::IOBuf TakeoverData::serializeError(
     uint64_t protocolCapabilities,
     const folly::exception_wrapper& ew) {
@@ -168,7 +229,13 @@ TakeoverData TakeoverData::deserialize(UnixSocket::Message& msg) {
   constexpr auto mountPointFilesOffset = 2;
 
   // Add 2 here for the lock file and the thrift socket
-  if (data.mountPoints.size() + mountPointFilesOffset != msg.files.size()) {
+  auto expectedFiles = data.mountPoints.size() + mountPointFilesOffset;
+  if ((capabilities & TakeoverCapabilities::CACHE_HANDOFF) &&
+      msg.files.size() == expectedFiles + 1) {
+    data.cacheContents = std::move(msg.files.back());
+    msg.files.pop_back();
+  }
+  if (expectedFiles != msg.files.size()) {
     throw std::runtime_error(folly::to<string>(
         "received ",
         data.mountPoints.size(),
@@ -198,6 +265,7 @@ int32_t TakeoverData::getProtocolVersion(IOBuf* buf) {
       return kTakeoverProtocolVersionOne;
     case kTakeoverProtocolVersionThree:
     case kTakeoverProtocolVersionFour:
+    case kTakeoverProtocolVersionFive:
       // Version 3 (there was no 2 because of how Version 1 used word values
       // 1 and 2) doesn't care about this version byte, so we skip past it
       // and let the underlying code decode the data
@@ -73,6 +73,11 @@ class TakeoverCapabilities {
     // This should be used in all modern takeover versions.
     PING = 1 << 3,
 
+    // Indicates the server may send the contents of its in-memory caches in
+    // an additional file after the mount point FDs, so that the new process
+    // starts with a warm cache. See TakeoverData::cacheContents.
+    CACHE_HANDOFF = 1 << 4,
+
   };
 };
 
@@ -118,6 +123,12 @@ class TakeoverData {
     // break a server with this extra handshake talking to a client
     // without it
     kTakeoverProtocolVersionFour = 4,
+
+    // This version allows the server to send the contents of its caches in
+    // an additional file. The data is serialized as in version 3, but the
+    // version word is sent as is, so that the client knows to look for the
+    // additional file.
+    kTakeoverProtocolVersionFive = 5,
   };
 
   /**
@@ -232,6 +243,24 @@ class TakeoverData {
    */
   std::vector<MountInfo> mountPoints;
 
+  /**
+   * Optionally, a file holding a serialized SerializedCacheContents, only
+   * sent with the CACHE_HANDOFF capability. See writeCacheContents().
+   */
+  folly::File cacheContents;
+
+  /**
+   * Write the given cache contents to an anonymous in-memory file, suitable
+   * for cacheContents.
+   */
+  static folly::File writeCacheContents(
+      const SerializedCacheContents& contents);
+
+  /**
+   * Read back the cache contents written by writeCacheContents().
+   */
+  static SerializedCacheContents readCacheContents(const folly::File& file);
+
   /**
    * The takeoverComplete promise will be fulfilled by the TakeoverServer code
    * once the TakeoverData has been sent to the remote process.
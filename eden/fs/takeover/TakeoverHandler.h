@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <folly/File.h>
+
 namespace folly {
 template <typename T>
 class Future;
@@ -40,6 +42,15 @@ class TakeoverHandler {
   virtual folly::Future<TakeoverData> startTakeoverShutdown() = 0;
 
   virtual void closeStorage() = 0;
+
+  /**
+   * Called before closeStorage() when the remote process accepts the
+   * contents of our caches. Returns a file from
+   * TakeoverData::writeCacheContents(), or a closed file to send nothing.
+   */
+  virtual folly::File getCacheContentsForTakeover() {
+    return folly::File{};
+  }
 };
 
 } // namespace eden
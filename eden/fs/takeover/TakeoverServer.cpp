@@ -20,6 +20,7 @@
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/EventHandler.h>
 #include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #include "eden/fs/takeover/TakeoverData.h"
@@ -233,9 +234,23 @@ Future<Unit> TakeoverServer::ConnHandler::sendTakeoverData(
   // Before sending the takeover data, we must close the server's
   // local and backing store. This is important for ensuring the RocksDB
   // lock is released so the client can take over.
+  if (protocolCapabilities_ & TakeoverCapabilities::CACHE_HANDOFF) {
+    // A warm cache is only an optimization, don't fail the takeover for it.
+    try {
+      folly::stop_watch<std::chrono::milliseconds> cacheWatch;
+      data.cacheContents =
+          server_->getTakeoverHandler()->getCacheContentsForTakeover();
+      XLOG(INFO) << "takeover: serialized cache contents in "
+                 << cacheWatch.elapsed().count() << "ms";
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "unable to send cache contents for takeover: "
+                << ex.what();
+    }
+  }
   server_->getTakeoverHandler()->closeStorage();
 
   UnixSocket::Message msg;
+  folly::stop_watch<std::chrono::milliseconds> watch;
   try {
     data.serialize(protocolCapabilities_, msg);
     for (auto& file : msg.files) {
@@ -249,11 +264,14 @@ Future<Unit> TakeoverServer::ConnHandler::sendTakeoverData(
   }
 
   XLOG(INFO) << "Sending takeover data to new process: "
-             << msg.data.computeChainDataLength() << " bytes";
+             << msg.data.computeChainDataLength() << " bytes, serialized in "
+             << watch.lap().count() << "ms";
 
   return socket_.send(std::move(msg))
-      .thenTry([promise = std::move(data.takeoverComplete)](
-                   folly::Try<Unit>&& sendResult) mutable {
+      .thenTry([promise = std::move(data.takeoverComplete),
+                watch](folly::Try<Unit>&& sendResult) mutable {
+        XLOG(INFO) << "takeover: sent takeover data in "
+                   << watch.elapsed().count() << "ms";
         if (sendResult.hasException()) {
           promise.setException(sendResult.exception());
         } else {
@@ -49,6 +49,19 @@ struct SerializedMountInfo {
   6: SerializedInodeMap inodeMap;
 }
 
+struct SerializedCachedBlob {
+  1: binary id;
+  2: binary contents;
+}
+
+// The hot contents of the in-memory caches of the old process. These are
+// sent in a separate file rather than in the takeover message, which they
+// would make many times larger.
+struct SerializedCacheContents {
+  // From the next to be evicted to the most recently used.
+  1: list<SerializedCachedBlob> blobs;
+}
+
 union SerializedTakeoverData {
   1: list<SerializedMountInfo> mounts;
   2: string errorReason;
@@ -48,6 +48,23 @@ class TestHandler : public TakeoverHandler {
   TakeoverData data_;
 };
 
+/**
+ * A TestHandler that also hands over one cached blob.
+ */
+class CacheHandler : public TestHandler {
+ public:
+  using TestHandler::TestHandler;
+
+  folly::File getCacheContentsForTakeover() override {
+    SerializedCachedBlob blob;
+    blob.id_ref() = "id";
+    blob.contents_ref() = "contents";
+    SerializedCacheContents contents;
+    contents.blobs_ref()->push_back(std::move(blob));
+    return TakeoverData::writeCacheContents(contents);
+  }
+};
+
 /**
  * A TakeoverHandler that throws an exception.
  */
@@ -465,3 +482,51 @@ TEST(Takeover, oneToTwo) {
   // Make sure the received mount information is empty
   EXPECT_EQ(0, clientData.mountPoints.size());
 }
+
+TEST(Takeover, cacheContents) {
+  for (auto version :
+       {TakeoverData::kTakeoverProtocolVersionFour,
+        TakeoverData::kTakeoverProtocolVersionFive}) {
+    SCOPED_TRACE(folly::to<std::string>("version ", version));
+    TemporaryDirectory tmpDir("eden_takeover_test");
+    AbsolutePathPiece tmpDirPath{tmpDir.path().string()};
+
+    TakeoverData serverData;
+    auto lockFilePath = tmpDirPath + "lock"_pc;
+    serverData.lockFile =
+        folly::File{lockFilePath.stringPiece(), O_RDWR | O_CREAT};
+    auto thriftSocketPath = tmpDirPath + "thrift"_pc;
+    serverData.thriftSocket =
+        folly::File{thriftSocketPath.stringPiece(), O_RDWR | O_CREAT};
+    auto mountPath = tmpDirPath + "mount"_pc;
+    auto fusePath = tmpDirPath + "fuse"_pc;
+    serverData.mountPoints.emplace_back(
+        mountPath,
+        tmpDirPath + "client"_pc,
+        std::vector<AbsolutePath>{},
+        folly::File{fusePath.stringPiece(), O_RDWR | O_CREAT},
+        fuse_init_out{},
+        SerializedInodeMap{});
+
+    auto serverSendFuture = serverData.takeoverComplete.getFuture();
+    CacheHandler handler{std::move(serverData)};
+    auto result = runTakeover(tmpDir, &handler, std::set<int32_t>{version});
+    ASSERT_TRUE(serverSendFuture.hasValue());
+    ASSERT_TRUE(result.hasValue());
+    const auto& clientData = result.value();
+
+    // The mount FD is still where it belongs.
+    ASSERT_EQ(1, clientData.mountPoints.size());
+    checkExpectedFile(clientData.mountPoints.at(0).fuseFD.fd(), fusePath);
+
+    if (version == TakeoverData::kTakeoverProtocolVersionFour) {
+      EXPECT_FALSE(clientData.cacheContents);
+      continue;
+    }
+    ASSERT_TRUE(clientData.cacheContents);
+    auto contents = TakeoverData::readCacheContents(clientData.cacheContents);
+    ASSERT_EQ(1, contents.blobs_ref()->size());
+    EXPECT_EQ("id", *contents.blobs_ref()->at(0).id_ref());
+    EXPECT_EQ("contents", *contents.blobs_ref()->at(0).contents_ref());
+  }
+}
@@ -7,12 +7,24 @@
 
 #include "eden/fs/telemetry/EdenStats.h"
 
+#include <folly/Conv.h>
+
+#include <array>
 #include <chrono>
 #include <memory>
 
 namespace facebook {
 namespace eden {
 
+namespace {
+/**
+ * fb303's default quantiles plus p99.9 and the maximum, which is where
+ * filesystem latency problems show up first.
+ */
+constexpr std::array<double, 7> kQuantiles{
+    {.01, .1, .5, .9, .99, .999, 1.0}};
+} // namespace
+
 ChannelThreadStats& EdenStats::getChannelStatsForCurrentThread() {
   return *threadLocalChannelStats_.get();
 }
@@ -54,11 +66,15 @@ EdenThreadStatsBase::Stat EdenThreadStatsBase::createStat(
   return Stat{
       name,
       fb303::ExportTypeConsts::kSumCountAvgRate,
-      fb303::QuantileConsts::kP1_P10_P50_P90_P99,
+      kQuantiles,
       fb303::SlidingWindowPeriodConsts::kOneMinTenMinHour,
   };
 }
 
+LockContentionStats::LockContentionStats(folly::StringPiece name)
+    : wait{createStat(folly::to<std::string>("lock.", name, ".wait_ns"))},
+      hold{createStat(folly::to<std::string>("lock.", name, ".hold_ns"))} {}
+
 void ChannelThreadStats::recordLatency(
     StatPtr item,
     std::chrono::microseconds elapsed) {
@@ -10,6 +10,7 @@
 #include <memory>
 
 #include <fb303/detail/QuantileStatWrappers.h>
+#include <folly/Range.h>
 #include <folly/ThreadLocal.h>
 
 #include "eden/fs/eden-config.h"
@@ -127,6 +128,7 @@ class ChannelThreadStats : public EdenThreadStatsBase {
   Stat fsync{createStat("fuse.fsync_us")};
   Stat opendir{createStat("fuse.opendir_us")};
   Stat readdir{createStat("fuse.readdir_us")};
+  Stat readdirplus{createStat("fuse.readdirplus_us")};
   Stat releasedir{createStat("fuse.releasedir_us")};
   Stat fsyncdir{createStat("fuse.fsyncdir_us")};
   Stat statfs{createStat("fuse.statfs_us")};
@@ -142,6 +144,11 @@ class ChannelThreadStats : public EdenThreadStatsBase {
   Stat forgetmulti{createStat("fuse.forgetmulti_us")};
   Stat fallocate{createStat("fuse.fallocate_us")};
 
+  // The number of FUSE invalidations sent to the kernel, and the number
+  // dropped because other invalidations in the same batch covered them.
+  Stat fuseInvalidationsSent{createStat("fuse.invalidations_sent")};
+  Stat fuseInvalidationsDropped{createStat("fuse.invalidations_dropped")};
+
   Stat nfsNull{createStat("nfs.null_us")};
   Stat nfsGetattr{createStat("nfs.getattr_us")};
   Stat nfsSetattr{createStat("nfs.setattr_us")};
@@ -176,6 +183,10 @@ class ChannelThreadStats : public EdenThreadStatsBase {
   Stat fileHandleClosedFileDeleted{
       createStat("prjfs.fileHandleClosedFileDeleted_us")};
   Stat preSetHardlink{createStat("prjfs.preSetHardlink_us")};
+  // The number of notifications waiting to be applied when one is queued,
+  // and the number applied together.
+  Stat notificationQueueDepth{createStat("prjfs.notification_queue_depth")};
+  Stat notificationBatchSize{createStat("prjfs.notification_batch_size")};
 
   Stat openDir{createStat("prjfs.opendir_us")};
   Stat readDir{createStat("prjfs.readdir_us")};
@@ -184,6 +195,14 @@ class ChannelThreadStats : public EdenThreadStatsBase {
   Stat read{createStat("prjfs.read_us")};
 #endif
 
+  // Time spent by the object fetches of a filesystem request in each
+  // ObjectFetchContext::FetchStage, summed over the request's fetches and
+  // recorded when the request finishes.
+  Stat fetchStageLocalStore{createStat("fs.fetch_stage.local_store_us")};
+  Stat fetchStageImportQueue{createStat("fs.fetch_stage.import_queue_us")};
+  Stat fetchStageBackingStoreFetch{
+      createStat("fs.fetch_stage.backing_store_fetch_us")};
+
   // Since we can potentially finish a request in a different thread from the
   // one used to initiate it, we use StatPtr as a helper for referencing the
   // pointer-to-member that we want to update at the end of the request.
@@ -218,6 +237,32 @@ class ObjectStoreThreadStats : public EdenThreadStatsBase {
       createStat("object_store.get_blob_size.local_store")};
   Stat getBlobSizeFromBackingStore{
       createStat("object_store.get_blob_size.backing_store")};
+
+  // Speculative tree prefetches issued, those later loaded on demand, and
+  // those forgotten without ever being needed.
+  Stat speculativeTreePrefetchIssued{
+      createStat("object_store.speculative_tree_prefetch.issued")};
+  Stat speculativeTreePrefetchHit{
+      createStat("object_store.speculative_tree_prefetch.hit")};
+  Stat speculativeTreePrefetchWasted{
+      createStat("object_store.speculative_tree_prefetch.wasted")};
+
+  // Directories prefetched after a checkout because they are frequently
+  // used, those later loaded on demand, and those not loaded before the
+  // next checkout.
+  Stat profilePrefetchIssued{
+      createStat("object_store.profile_prefetch.issued")};
+  Stat profilePrefetchHit{createStat("object_store.profile_prefetch.hit")};
+  Stat profilePrefetchWasted{
+      createStat("object_store.profile_prefetch.wasted")};
+
+  // Bytes of fetched blobs whose contents were already held under another
+  // ID, in the local store or in memory, see
+  // experimental:enable-blob-deduplication.
+  Stat blobDeduplicatedOnDisk{
+      createStat("object_store.blob_deduplication.disk_bytes")};
+  Stat blobDeduplicatedInMemory{
+      createStat("object_store.blob_deduplication.memory_bytes")};
 };
 
 /**
@@ -229,6 +274,21 @@ class HgBackingStoreThreadStats : public EdenThreadStatsBase {
   Stat hgBackingStoreImportBlob{createStat("store.hg.import_blob")};
   Stat hgBackingStoreGetTree{createStat("store.hg.get_tree")};
   Stat hgBackingStoreImportTree{createStat("store.hg.import_tree")};
+
+  // Number of requests waiting in the import queue, sampled on every dequeue,
+  // and time spent by requests in the import queue, in microseconds. Both
+  // are broken down by ImportPriorityKind.
+  Stat importQueueDepthLow{createStat("store.hg.import_queue.depth.low")};
+  Stat importQueueDepthNormal{createStat("store.hg.import_queue.depth.normal")};
+  Stat importQueueDepthHigh{createStat("store.hg.import_queue.depth.high")};
+  Stat importQueueWaitLow{createStat("store.hg.import_queue.wait_us.low")};
+  Stat importQueueWaitNormal{
+      createStat("store.hg.import_queue.wait_us.normal")};
+  Stat importQueueWaitHigh{createStat("store.hg.import_queue.wait_us.high")};
+
+  // Number of requests in each dequeued import batch.
+  Stat importBatchSizeBlob{createStat("store.hg.import_batch_size.blob")};
+  Stat importBatchSizeTree{createStat("store.hg.import_batch_size.tree")};
 };
 
 /**
@@ -243,6 +303,19 @@ class HgImporterThreadStats : public EdenThreadStatsBase {
   Stat manifestNodeForCommit{
       createStat("hg_importer.manifest_node_for_commit")};
   Stat prefetchFiles{createStat("hg_importer.prefetch_files")};
+
+  // Time spent by the importer of a thread in each kind of request, in
+  // microseconds, including restarting its helper process and retrying. As
+  // each importer thread owns its own helper process, the per-thread values
+  // are the latencies of one process.
+  Stat catFileLatency{createStat("hg_importer.cat_file_us")};
+  Stat fetchTreeLatency{createStat("hg_importer.fetch_tree_us")};
+  Stat manifestNodeForCommitLatency{
+      createStat("hg_importer.manifest_node_for_commit_us")};
+  Stat prefetchFilesLatency{createStat("hg_importer.prefetch_files_us")};
+
+  // Number of times a helper process was restarted after an error.
+  Stat restart{createStat("hg_importer.restart")};
 };
 
 class JournalThreadStats : public EdenThreadStatsBase {
@@ -251,5 +324,22 @@ class JournalThreadStats : public EdenThreadStatsBase {
   Stat filesAccumulated{createStat("journal.files_accumulated")};
 };
 
+/**
+ * Sampled wait and hold times of one lock, in nanoseconds.
+ *
+ * Unlike the other stats classes, there is a single instance per lock shared
+ * by all threads: recording into the underlying fb303 stat is thread-safe,
+ * and the sampling keeps it from becoming a point of contention itself.
+ *
+ * @see InstrumentedMutex
+ */
+class LockContentionStats : public EdenThreadStatsBase {
+ public:
+  explicit LockContentionStats(folly::StringPiece name);
+
+  Stat wait;
+  Stat hold;
+};
+
 } // namespace eden
 } // namespace facebook
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * Keeps the last `capacity` records of a trace, so that the history leading
+ * up to a latency spike is available after the fact without a trace having
+ * been started beforehand.
+ *
+ * Records are meant to be added from a TraceBus subscriber, so the cost of
+ * recording is paid on the TraceBus's background thread rather than by the
+ * request that published the event. The lock is only contended by the rare
+ * readers.
+ *
+ * Records are copied in and out, so Record should only keep the parts of a
+ * TraceEvent worth looking at later.
+ */
+template <typename Record>
+class FlightRecorder {
+ public:
+  explicit FlightRecorder(size_t capacity) : capacity_{capacity} {}
+
+  FlightRecorder(const FlightRecorder&) = delete;
+  FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+  void record(Record record) {
+    auto state = state_.lock();
+    if (state->records.size() < capacity_) {
+      state->records.push_back(std::move(record));
+    } else {
+      state->records[state->next] = std::move(record);
+      state->next = (state->next + 1) % capacity_;
+    }
+  }
+
+  /**
+   * Returns the recorded history, oldest first.
+   */
+  std::vector<Record> getRecords() const {
+    auto state = state_.lock();
+    return getRecords(*state);
+  }
+
+  /**
+   * Saves a copy of the current history, replacing the previous snapshot.
+   * Used to keep the events leading up to a slow request from being
+   * overwritten before someone gets to look at them.
+   */
+  void snapshot() {
+    auto state = state_.lock();
+    state->snapshot = getRecords(*state);
+  }
+
+  /**
+   * Returns the history saved by the last call to snapshot(), oldest first.
+   */
+  std::vector<Record> getSnapshot() const {
+    return state_.lock()->snapshot;
+  }
+
+ private:
+  struct State {
+    // A ring buffer once it reaches capacity_, with next pointing at the
+    // oldest record.
+    std::vector<Record> records;
+    size_t next = 0;
+    std::vector<Record> snapshot;
+  };
+
+  static std::vector<Record> getRecords(const State& state) {
+    std::vector<Record> result;
+    result.reserve(state.records.size());
+    auto oldest = state.records.begin() + state.next;
+    result.insert(result.end(), oldest, state.records.end());
+    result.insert(result.end(), state.records.begin(), oldest);
+    return result;
+  }
+
+  const size_t capacity_;
+  mutable folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
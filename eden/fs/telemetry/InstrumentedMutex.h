@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Likely.h>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook::eden {
+
+/**
+ * Returns true for one in every kLockSampleInterval calls on each thread, to
+ * pick the lock acquisitions whose wait and hold times are measured.
+ */
+inline bool shouldSampleLock() {
+  constexpr uint32_t kLockSampleInterval = 64;
+  static thread_local uint32_t acquisitions = 0;
+  return UNLIKELY(++acquisitions % kLockSampleInterval == 0);
+}
+
+/**
+ * A mutex wrapper for the Mutex parameter of folly::Synchronized that samples
+ * how long threads wait to acquire the lock and how long they hold it, and
+ * records them in the lock.<name>.wait_ns and lock.<name>.hold_ns stats, so
+ * that contended locks show up in getStatInfo.
+ *
+ * Name must have a static `const char* name()` function. Hold times are only
+ * measured for exclusive locks, since shared ones may have any number of
+ * holders. Unsampled acquisitions only pay for a thread-local increment.
+ *
+ * Usage:
+ *   struct FooLockName {
+ *     static const char* name() {
+ *       return "foo";
+ *     }
+ *   };
+ *   folly::Synchronized<Foo, InstrumentedMutex<std::mutex, FooLockName>> foo_;
+ */
+template <typename Mutex, typename Name>
+class InstrumentedMutex {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  void lock() {
+    if (!shouldSampleLock()) {
+      mutex_.lock();
+      return;
+    }
+    auto start = Clock::now();
+    mutex_.lock();
+    holdStart_ = Clock::now();
+    getStats().wait.addValue(nanosecondsBetween(start, holdStart_));
+  }
+
+  bool try_lock() {
+    if (!mutex_.try_lock()) {
+      return false;
+    }
+    if (shouldSampleLock()) {
+      holdStart_ = Clock::now();
+    }
+    return true;
+  }
+
+  void unlock() {
+    recordHold();
+    mutex_.unlock();
+  }
+
+  template <typename M = Mutex>
+  auto lock_shared() -> decltype(std::declval<M&>().lock_shared()) {
+    sampleWait([&] { mutex_.lock_shared(); });
+  }
+
+  template <typename M = Mutex>
+  auto try_lock_shared() -> decltype(std::declval<M&>().try_lock_shared()) {
+    return mutex_.try_lock_shared();
+  }
+
+  template <typename M = Mutex>
+  auto unlock_shared() -> decltype(std::declval<M&>().unlock_shared()) {
+    mutex_.unlock_shared();
+  }
+
+  template <typename M = Mutex>
+  auto lock_upgrade() -> decltype(std::declval<M&>().lock_upgrade()) {
+    sampleWait([&] { mutex_.lock_upgrade(); });
+  }
+
+  template <typename M = Mutex>
+  auto try_lock_upgrade() -> decltype(std::declval<M&>().try_lock_upgrade()) {
+    return mutex_.try_lock_upgrade();
+  }
+
+  template <typename M = Mutex>
+  auto unlock_upgrade() -> decltype(std::declval<M&>().unlock_upgrade()) {
+    mutex_.unlock_upgrade();
+  }
+
+  template <typename M = Mutex>
+  auto unlock_upgrade_and_lock()
+      -> decltype(std::declval<M&>().unlock_upgrade_and_lock()) {
+    if (!shouldSampleLock()) {
+      mutex_.unlock_upgrade_and_lock();
+      return;
+    }
+    auto start = Clock::now();
+    mutex_.unlock_upgrade_and_lock();
+    holdStart_ = Clock::now();
+    getStats().wait.addValue(nanosecondsBetween(start, holdStart_));
+  }
+
+  template <typename M = Mutex>
+  auto unlock_upgrade_and_lock_shared()
+      -> decltype(std::declval<M&>().unlock_upgrade_and_lock_shared()) {
+    mutex_.unlock_upgrade_and_lock_shared();
+  }
+
+  template <typename M = Mutex>
+  auto unlock_and_lock_upgrade()
+      -> decltype(std::declval<M&>().unlock_and_lock_upgrade()) {
+    recordHold();
+    mutex_.unlock_and_lock_upgrade();
+  }
+
+  template <typename M = Mutex>
+  auto unlock_and_lock_shared()
+      -> decltype(std::declval<M&>().unlock_and_lock_shared()) {
+    recordHold();
+    mutex_.unlock_and_lock_shared();
+  }
+
+  static LockContentionStats& getStats() {
+    static LockContentionStats stats{Name::name()};
+    return stats;
+  }
+
+ private:
+  static int64_t nanosecondsBetween(
+      Clock::time_point from,
+      Clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from)
+        .count();
+  }
+
+  template <typename LockFn>
+  void sampleWait(LockFn&& lockFn) {
+    if (!shouldSampleLock()) {
+      lockFn();
+      return;
+    }
+    auto start = Clock::now();
+    lockFn();
+    getStats().wait.addValue(nanosecondsBetween(start, Clock::now()));
+  }
+
+  /**
+   * Called with the exclusive lock held, so holdStart_ is not raced on.
+   */
+  void recordHold() {
+    if (UNLIKELY(holdStart_ != Clock::time_point{})) {
+      getStats().hold.addValue(nanosecondsBetween(holdStart_, Clock::now()));
+      holdStart_ = Clock::time_point{};
+    }
+  }
+
+  Mutex mutex_;
+  // Set while a sampled exclusive lock is held.
+  Clock::time_point holdStart_;
+};
+
+} // namespace facebook::eden
@@ -8,6 +8,7 @@
 #include "RequestMetricsScope.h"
 
 #include <algorithm>
+#include <atomic>
 #include <numeric>
 
 #include <folly/String.h>
@@ -20,18 +21,19 @@ namespace eden {
 
 RequestMetricsScope::RequestMetricsScope(
     LockedRequestWatchList* pendingRequestWatches)
-    : pendingRequestWatches_(pendingRequestWatches) {
-  folly::stop_watch<> watch;
-  {
-    auto startTimes = pendingRequestWatches_->wlock();
-    requestWatch_ = startTimes->insert(startTimes->end(), watch);
-  }
+    : pendingRequestWatches_(pendingRequestWatches),
+      shard_(&pendingRequestWatches_->getLocalShard()) {
+  // The watch is started with the lock held, keeping the shard sorted by
+  // start time.
+  auto startTimes = shard_->watches.lock();
+  requestWatch_ = startTimes->emplace(startTimes->end());
 }
 
 RequestMetricsScope::RequestMetricsScope() : pendingRequestWatches_(nullptr) {}
 
 RequestMetricsScope::RequestMetricsScope(RequestMetricsScope&& other) noexcept
     : pendingRequestWatches_(std::move(other.pendingRequestWatches_)),
+      shard_(other.shard_),
       requestWatch_(std::move(other.requestWatch_)) {
   other.pendingRequestWatches_ = nullptr;
 }
@@ -39,6 +41,7 @@ RequestMetricsScope::RequestMetricsScope(RequestMetricsScope&& other) noexcept
 RequestMetricsScope& RequestMetricsScope::operator=(
     RequestMetricsScope&& other) {
   this->pendingRequestWatches_ = std::move(other.pendingRequestWatches_);
+  this->shard_ = other.shard_;
   this->requestWatch_ = std::move(other.requestWatch_);
   other.pendingRequestWatches_ = nullptr;
   return *this;
@@ -46,8 +49,7 @@ RequestMetricsScope& RequestMetricsScope::operator=(
 
 RequestMetricsScope::~RequestMetricsScope() {
   if (pendingRequestWatches_ != nullptr) {
-    auto startTimes = pendingRequestWatches_->wlock();
-    startTimes->erase(requestWatch_);
+    shard_->watches.lock()->erase(requestWatch_);
   }
 }
 
@@ -102,7 +104,7 @@ size_t RequestMetricsScope::getMetricFromWatches(
     const LockedRequestWatchList& watches) {
   switch (metric) {
     case COUNT:
-      return watches.rlock()->size();
+      return watches.size();
     case MAX_DURATION_US:
       return static_cast<size_t>(
           std::chrono::duration_cast<std::chrono::microseconds>(
@@ -114,14 +116,35 @@ size_t RequestMetricsScope::getMetricFromWatches(
 
 RequestMetricsScope::DefaultRequestDuration RequestMetricsScope::getMaxDuration(
     const LockedRequestWatchList& watches) {
-  DefaultRequestDuration maxDurationImport{0};
-  {
-    auto lockedWatches = watches.rlock();
-    for (const auto& watch : *lockedWatches) {
-      maxDurationImport = std::max(maxDurationImport, watch.elapsed());
+  return watches.getMaxDuration();
+}
+
+size_t RequestMetricsScope::LockedRequestWatchList::size() const {
+  size_t size = 0;
+  for (const auto& shard : shards_) {
+    size += shard.watches.lock()->size();
+  }
+  return size;
+}
+
+RequestMetricsScope::DefaultRequestDuration
+RequestMetricsScope::LockedRequestWatchList::getMaxDuration() const {
+  DefaultRequestDuration maxDuration{0};
+  for (const auto& shard : shards_) {
+    auto watches = shard.watches.lock();
+    if (!watches->empty()) {
+      maxDuration = std::max(maxDuration, watches->front().elapsed());
     }
   }
-  return maxDurationImport;
+  return maxDuration;
+}
+
+RequestMetricsScope::LockedRequestWatchList::Shard&
+RequestMetricsScope::LockedRequestWatchList::getLocalShard() {
+  static std::atomic<size_t> nextShard{0};
+  static thread_local size_t shard =
+      nextShard.fetch_add(1, std::memory_order_relaxed) % kShardCount;
+  return shards_[shard];
 }
 
 } // namespace eden
@@ -7,19 +7,23 @@
 
 #pragma once
 
+#include <array>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include <folly/String.h>
 #include <folly/Synchronized.h>
+#include <folly/lang/Align.h>
 #include <folly/stop_watch.h>
 
 namespace facebook {
 namespace eden {
 
 /**
- * Represents a request tracked in a RequestMetricsScope::RequestWatchList.
+ * Represents a request tracked in a
+ * RequestMetricsScope::LockedRequestWatchList.
  * To track a request a RequestMetricsScope object should be in scope for the
  * duration of the request.
  *
@@ -29,10 +33,47 @@ namespace eden {
 class RequestMetricsScope {
  public:
   using RequestWatchList = std::list<folly::stop_watch<>>;
-  using LockedRequestWatchList = folly::Synchronized<RequestWatchList>;
   using DefaultRequestDuration =
       std::chrono::steady_clock::steady_clock::duration;
 
+  /**
+   * The watches of the requests of one kind that are in flight.
+   *
+   * Every hg import and every FUSE request is added to and removed from one
+   * of these, from whichever thread runs it. The watches are split in shards,
+   * each with its own lock and cache line, and each thread adds its requests
+   * to the shard it was assigned, so that concurrent requests seldom take the
+   * same lock. A request is removed from the shard it was added to.
+   *
+   * Each shard keeps its watches in the order they were started, so the
+   * oldest request is found by looking at the front of each shard.
+   */
+  class LockedRequestWatchList {
+   public:
+    /** Number of requests tracked. */
+    size_t size() const;
+
+    /**
+     * Time elapsed since the oldest tracked request started, or zero if there
+     * are none.
+     */
+    DefaultRequestDuration getMaxDuration() const;
+
+   private:
+    friend class RequestMetricsScope;
+
+    static constexpr size_t kShardCount = 8;
+
+    struct alignas(folly::hardware_destructive_interference_size) Shard {
+      folly::Synchronized<RequestWatchList, std::mutex> watches;
+    };
+
+    /** The shard the calling thread adds its requests to. */
+    Shard& getLocalShard();
+
+    std::array<Shard, kShardCount> shards_;
+  };
+
   RequestMetricsScope(LockedRequestWatchList* pendingRequestWatches);
   RequestMetricsScope();
   RequestMetricsScope(RequestMetricsScope&&) noexcept;
@@ -106,6 +147,7 @@ class RequestMetricsScope {
 
  private:
   LockedRequestWatchList* pendingRequestWatches_;
+  LockedRequestWatchList::Shard* shard_ = nullptr;
   RequestWatchList::iterator requestWatch_;
 }; // namespace eden
 } // namespace eden
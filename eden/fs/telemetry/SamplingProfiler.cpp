@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/telemetry/SamplingProfiler.h"
+
+#include <fmt/format.h>
+#include <folly/Demangle.h>
+#include <folly/Exception.h>
+#include <folly/container/F14Map.h>
+#include <folly/experimental/symbolizer/StackTrace.h>
+#include <folly/experimental/symbolizer/Symbolizer.h>
+#include <folly/logging/xlog.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr size_t kMaxFrames = 64;
+// The innermost frames of every sample are the signal handler and the
+// kernel's signal trampoline.
+constexpr size_t kSkippedFrames = 2;
+// A profile stops recording once it has this many samples, which bounds its
+// memory usage to around 10 MB.
+constexpr size_t kMaxSamples = 20000;
+
+thread_local const char* currentLabel = nullptr;
+
+struct Sample {
+  // Set by the signal handler once the rest of the sample is written.
+  std::atomic<bool> ready{false};
+  const char* label;
+  size_t depth;
+  uintptr_t frames[kMaxFrames];
+};
+
+struct Profile {
+  explicit Profile(size_t capacity)
+      : samples{new Sample[capacity]}, capacity{capacity} {}
+
+  std::unique_ptr<Sample[]> samples;
+  const size_t capacity;
+  std::atomic<size_t> next{0};
+};
+
+std::atomic<bool> running{false};
+std::atomic<Profile*> activeProfile{nullptr};
+// The number of SIGPROF handlers currently running, so that stopping a
+// profile can wait for them to be done with it.
+std::atomic<size_t> activeHandlers{0};
+
+void handleSigprof(int, siginfo_t*, void*) {
+  auto savedErrno = errno;
+  ++activeHandlers;
+  if (auto* profile = activeProfile.load()) {
+    auto index = profile->next.fetch_add(1, std::memory_order_relaxed);
+    if (index < profile->capacity) {
+      auto& sample = profile->samples[index];
+      auto depth =
+          folly::symbolizer::getStackTraceSafe(sample.frames, kMaxFrames);
+      sample.depth = depth > 0 ? static_cast<size_t>(depth) : 0;
+      sample.label = currentLabel;
+      sample.ready.store(true, std::memory_order_release);
+    }
+  }
+  --activeHandlers;
+  errno = savedErrno;
+}
+
+/**
+ * The handler stays installed once a profile has run: restoring the default
+ * action would terminate the process if a last SIGPROF was still pending.
+ */
+void installHandler() {
+  static const bool installed = [] {
+    struct sigaction action {};
+    action.sa_sigaction = handleSigprof;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    folly::checkUnixError(
+        sigaction(SIGPROF, &action, nullptr),
+        "unable to install the SIGPROF handler");
+    return true;
+  }();
+  (void)installed;
+}
+
+void setProfilingTimer(std::chrono::microseconds interval) {
+  itimerval timer{};
+  timer.it_interval.tv_sec = interval.count() / 1000000;
+  timer.it_interval.tv_usec = interval.count() % 1000000;
+  timer.it_value = timer.it_interval;
+  folly::checkUnixError(
+      setitimer(ITIMER_PROF, &timer, nullptr), "unable to set ITIMER_PROF");
+}
+
+void stopProfiling() noexcept {
+  itimerval timer{};
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  activeProfile.store(nullptr);
+  while (activeHandlers.load() != 0) {
+    std::this_thread::yield();
+  }
+}
+
+std::string collapseStacks(const Profile& profile) {
+  folly::symbolizer::Symbolizer symbolizer{
+      folly::symbolizer::LocationInfoMode::DISABLED};
+  // Node map, so that references to the names survive later insertions.
+  folly::F14NodeMap<uintptr_t, std::string> names;
+  auto getName = [&](uintptr_t address) -> const std::string& {
+    auto [it, inserted] = names.try_emplace(address);
+    if (inserted) {
+      folly::symbolizer::SymbolizedFrame frame;
+      symbolizer.symbolize(&address, &frame, 1);
+      it->second = frame.found && frame.name
+          ? folly::demangle(frame.name).toStdString()
+          : fmt::format("{:#x}", address);
+    }
+    return it->second;
+  };
+
+  std::map<std::string, size_t> stacks;
+  auto recorded = profile.next.load();
+  auto count = std::min(recorded, profile.capacity);
+  for (size_t i = 0; i < count; ++i) {
+    const auto& sample = profile.samples[i];
+    if (!sample.ready.load(std::memory_order_acquire)) {
+      continue;
+    }
+    std::string stack;
+    if (sample.label) {
+      stack = sample.label;
+    }
+    for (size_t frame = sample.depth; frame > kSkippedFrames; --frame) {
+      if (!stack.empty()) {
+        stack.push_back(';');
+      }
+      stack += getName(sample.frames[frame - 1]);
+    }
+    ++stacks[std::move(stack)];
+  }
+
+  if (recorded > profile.capacity) {
+    XLOG(WARN) << "CPU profile dropped " << recorded - profile.capacity
+               << " samples after reaching " << profile.capacity;
+  }
+
+  std::string result;
+  for (const auto& [stack, samples] : stacks) {
+    fmt::format_to(std::back_inserter(result), "{} {}\n", stack, samples);
+  }
+  return result;
+}
+
+} // namespace
+
+ProfilerLabel::ProfilerLabel(const char* label) noexcept
+    : previous_{currentLabel} {
+  currentLabel = label;
+}
+
+ProfilerLabel::~ProfilerLabel() noexcept {
+  currentLabel = previous_;
+}
+
+folly::SemiFuture<std::string> SamplingProfiler::profile(
+    std::chrono::milliseconds duration,
+    uint32_t frequency) {
+  if (frequency == 0 || frequency > 1000000) {
+    return folly::makeSemiFuture<std::string>(std::invalid_argument(
+        fmt::format("invalid CPU profile frequency {}", frequency)));
+  }
+  if (running.exchange(true)) {
+    return folly::makeSemiFuture<std::string>(
+        std::runtime_error("a CPU profile is already running"));
+  }
+
+  auto profile = std::make_shared<Profile>(kMaxSamples);
+  try {
+    installHandler();
+    activeProfile.store(profile.get());
+    setProfilingTimer(std::chrono::microseconds{1000000 / frequency});
+  } catch (const std::exception&) {
+    stopProfiling();
+    running.store(false);
+    return folly::makeSemiFuture<std::string>(
+        folly::exception_wrapper{std::current_exception()});
+  }
+
+  return folly::futures::sleep(duration).defer(
+      [profile = std::move(profile)](folly::Try<folly::Unit>&&) {
+        stopProfiling();
+        // The samples are no longer written to, so the next profile can
+        // start while these are symbolized.
+        running.store(false);
+        return collapseStacks(*profile);
+      });
+}
+
+} // namespace facebook::eden
+
+#endif // !_WIN32
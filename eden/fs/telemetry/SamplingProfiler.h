@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <folly/futures/Future.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace facebook::eden {
+
+/**
+ * Labels the CPU profile samples taken on this thread while it is in scope,
+ * e.g. with the FUSE operation being dispatched. Labels nest, and must be
+ * string literals or otherwise outlive any profile that may sample them.
+ *
+ * Work a request hands off to other executors is not labeled.
+ */
+class ProfilerLabel {
+ public:
+  explicit ProfilerLabel(const char* label) noexcept;
+  ~ProfilerLabel() noexcept;
+
+  ProfilerLabel(const ProfilerLabel&) = delete;
+  ProfilerLabel& operator=(const ProfilerLabel&) = delete;
+
+ private:
+  const char* previous_;
+};
+
+/**
+ * A SIGPROF based sampling profiler, so that a slow EdenFS can be profiled
+ * without attaching perf.
+ *
+ * Since ITIMER_PROF counts the CPU time of the whole process, samples land on
+ * whichever threads are burning CPU, in proportion to the CPU they use.
+ */
+class SamplingProfiler {
+ public:
+  /**
+   * Samples the stacks of the threads using CPU `frequency` times per second
+   * of CPU time for `duration`, and returns them as collapsed stacks suitable
+   * for flamegraph.pl: one line per distinct stack, with the frames from the
+   * outermost in, separated by semicolons, followed by the number of samples.
+   * Stacks taken under a ProfilerLabel start with that label.
+   *
+   * Only one profile may run at a time. The returned future fails with
+   * std::runtime_error if another is already running.
+   */
+  static folly::SemiFuture<std::string> profile(
+      std::chrono::milliseconds duration,
+      uint32_t frequency);
+};
+
+} // namespace facebook::eden
+
+#endif // !_WIN32
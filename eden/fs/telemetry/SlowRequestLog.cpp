@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/SlowRequestLog.h"
+
+#include <folly/Indestructible.h>
+
+namespace facebook::eden {
+
+SlowRequestLog& SlowRequestLog::get() {
+  static folly::Indestructible<SlowRequestLog> log;
+  return *log;
+}
+
+void SlowRequestLog::add(SlowRequestRecord request) {
+  auto requests = requests_.wlock();
+  if (requests->size() >= kMaxRequests) {
+    requests->pop_front();
+  }
+  requests->push_back(std::move(request));
+}
+
+std::vector<SlowRequestRecord> SlowRequestLog::getRequests() const {
+  auto requests = requests_.rlock();
+  return {requests->begin(), requests->end()};
+}
+
+} // namespace facebook::eden
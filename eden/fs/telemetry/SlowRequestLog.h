@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <sys/types.h>
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * Where a slow filesystem request spent its time.
+ */
+struct SlowRequestRecord {
+  uint64_t requestId;
+  /** The FUSE, NFS or ProjectedFS operation, e.g. "FUSE_LOOKUP". */
+  std::string operation;
+  std::optional<pid_t> pid;
+  std::chrono::system_clock::time_point finishTime;
+  std::chrono::nanoseconds duration{0};
+
+  /**
+   * The time spent by the request's object fetches in each stage, summed
+   * over the fetches. Fetches may run concurrently, so these can add up to
+   * more than duration.
+   */
+  std::chrono::nanoseconds localStore{0};
+  std::chrono::nanoseconds importQueue{0};
+  std::chrono::nanoseconds backingStoreFetch{0};
+};
+
+/**
+ * Keeps the most recent filesystem requests that took longer than
+ * kThreshold, for `getSlowRequests` to report.
+ */
+class SlowRequestLog {
+ public:
+  static constexpr std::chrono::milliseconds kThreshold{1000};
+  static constexpr size_t kMaxRequests = 100;
+
+  /**
+   * The log shared by all of the mounts of this process.
+   */
+  static SlowRequestLog& get();
+
+  void add(SlowRequestRecord request);
+
+  /**
+   * Returns the logged requests, oldest first.
+   */
+  std::vector<SlowRequestRecord> getRequests() const;
+
+ private:
+  folly::Synchronized<std::deque<SlowRequestRecord>> requests_;
+};
+
+} // namespace facebook::eden
@@ -8,7 +8,9 @@
 #include "eden/fs/telemetry/SubprocessScribeLogger.h"
 
 #include <folly/logging/xlog.h>
+#include <folly/portability/SysUio.h>
 #include <folly/system/ThreadName.h>
+#include <algorithm>
 
 namespace {
 /**
@@ -17,6 +19,12 @@ namespace {
  */
 constexpr size_t kQueueLimitBytes = 128 * 1024;
 
+/**
+ * Number of messages written per writev() call. Each message uses two iovecs,
+ * one for its contents and one for its newline.
+ */
+constexpr size_t kMessagesPerWrite = 256;
+
 constexpr std::chrono::seconds kFlushTimeout{1};
 constexpr std::chrono::seconds kProcessExitTimeout{1};
 constexpr std::chrono::seconds kProcessTerminateTimeout{1};
@@ -90,6 +98,7 @@ void SubprocessScribeLogger::closeProcess() {
 
 void SubprocessScribeLogger::log(std::string message) {
   size_t messageSize = message.size();
+  bool wasEmpty;
 
   {
     auto state = state_.lock();
@@ -98,7 +107,10 @@ void SubprocessScribeLogger::log(std::string message) {
       return;
     }
     if (state->totalBytes + messageSize > kQueueLimitBytes) {
-      XLOG_EVERY_MS(DBG7, 10000) << "ScribeLogger queue full, dropping message";
+      auto dropped = ++state->droppedMessages;
+      XLOG_EVERY_MS(DBG7, 10000)
+          << "ScribeLogger queue full, dropping message (" << dropped
+          << " dropped so far)";
       // queue full, dropping!
       return;
     }
@@ -106,15 +118,46 @@ void SubprocessScribeLogger::log(std::string message) {
     // This order is important in order to be atomic under std::bad_alloc.
     state->messages.emplace_back(std::move(message));
     state->totalBytes += messageSize;
+    wasEmpty = state->messages.size() == 1;
+  }
+  // The writer thread only waits when the queue is empty. Otherwise it will
+  // find this message when it comes back for the next batch.
+  if (wasEmpty) {
+    newMessageOrStop_.notify_one();
   }
-  newMessageOrStop_.notify_one();
 }
 
-void SubprocessScribeLogger::writerThread() {
+uint64_t SubprocessScribeLogger::getDroppedMessageCount() const {
+  return state_.lock()->droppedMessages;
+}
+
+bool SubprocessScribeLogger::writeMessages(
+    std::vector<std::string>& messages) {
   auto fd = process_.stdinFd();
+  char newline = '\n';
+  std::vector<iovec> iov;
+  iov.reserve(2 * std::min(messages.size(), kMessagesPerWrite));
+
+  for (size_t start = 0; start < messages.size();
+       start += kMessagesPerWrite) {
+    auto end = std::min(messages.size(), start + kMessagesPerWrite);
+    iov.clear();
+    for (size_t i = start; i < end; ++i) {
+      iov.push_back({messages[i].data(), messages[i].size()});
+      iov.push_back({&newline, sizeof(newline)});
+    }
+    if (fd.writevFull(iov.data(), iov.size()).hasException()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SubprocessScribeLogger::writerThread() {
+  std::vector<std::string> messages;
 
   for (;;) {
-    std::string message;
+    messages.clear();
 
     {
       auto state = state_.lock();
@@ -122,13 +165,10 @@ void SubprocessScribeLogger::writerThread() {
         return state->shouldStop || !state->messages.empty();
       });
       if (!state->messages.empty()) {
-        XCHECK_LE(state->messages.front().size(), state->totalBytes)
-            << "totalSize accounting fell out of sync!";
-
-        // The below statements are all noexcept.
-        std::swap(message, state->messages.front());
-        state->messages.pop_front();
-        state->totalBytes -= message.size();
+        // The below statements are all noexcept. Swapping hands the
+        // previous batch's capacity back to log().
+        std::swap(messages, state->messages);
+        state->totalBytes = 0;
       } else {
         // If the predicate succeeded but we have no messages, then we're
         // shutting down cleanly.
@@ -142,13 +182,7 @@ void SubprocessScribeLogger::writerThread() {
       }
     }
 
-    char newline = '\n';
-    std::array<iovec, 2> iov;
-    iov[0].iov_base = message.data();
-    iov[0].iov_len = message.size();
-    iov[1].iov_base = &newline;
-    iov[1].iov_len = sizeof(newline);
-    if (fd.writevFull(iov.data(), iov.size()).hasException()) {
+    if (!writeMessages(messages)) {
       // TODO: We could attempt to restart the process here.
       XLOG(ERR) << "Failed to writev to logger process stdin: "
                 << folly::errnoStr(errno) << ". Giving up!";
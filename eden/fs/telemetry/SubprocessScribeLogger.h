@@ -8,7 +8,7 @@
 #pragma once
 
 #include <folly/Synchronized.h>
-#include <list>
+#include <vector>
 #include "eden/fs/telemetry/ScribeLogger.h"
 #include "eden/fs/utils/SpawnedProcess.h"
 
@@ -18,6 +18,12 @@ namespace eden {
 /**
  * SubprocessScribeLogger manages an external unix process and asynchronously
  * forwards newline-delimited messages to its stdin.
+ *
+ * log() only appends the message to a queue, and wakes the writer thread if
+ * the queue was empty. The writer thread takes all the queued messages at
+ * once and writes them with as few writev() calls as possible, so that a
+ * burst of events costs the logging threads a short critical section each,
+ * rather than a wakeup and a pipe write per message.
  */
 class SubprocessScribeLogger : public ScribeLogger {
  public:
@@ -51,6 +57,12 @@ class SubprocessScribeLogger : public ScribeLogger {
   void log(std::string message) override;
   using ScribeLogger::log;
 
+  /**
+   * Returns the number of messages dropped so far because the queue was
+   * full.
+   */
+  uint64_t getDroppedMessageCount() const;
+
  private:
   void closeProcess();
   void writerThread();
@@ -62,13 +74,21 @@ class SubprocessScribeLogger : public ScribeLogger {
     /// Sum of sizes of queued messages.
     size_t totalBytes = 0;
     /// Invariant: empty if didStop is true
-    std::list<std::string> messages;
+    std::vector<std::string> messages;
+    /// Messages dropped because the queue was full.
+    uint64_t droppedMessages = 0;
   };
 
+  /**
+   * Writes the messages, each followed by a newline. Returns false if the
+   * process can no longer be written to.
+   */
+  bool writeMessages(std::vector<std::string>& messages);
+
   SpawnedProcess process_;
   std::thread writerThread_;
 
-  folly::Synchronized<State, std::mutex> state_;
+  mutable folly::Synchronized<State, std::mutex> state_;
   std::condition_variable newMessageOrStop_;
   std::condition_variable allMessagesWritten_;
 };
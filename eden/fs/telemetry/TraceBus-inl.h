@@ -13,17 +13,21 @@ namespace facebook::eden {
 template <typename TraceEvent>
 std::shared_ptr<TraceBus<TraceEvent>> TraceBus<TraceEvent>::create(
     std::string name,
-    size_t bufferCapacity) {
+    size_t bufferCapacity,
+    TraceBusOverflow overflow) {
   return std::make_shared<TraceBus<TraceEvent>>(
-      PrivateConstructorTag{}, std::move(name), bufferCapacity);
+      PrivateConstructorTag{}, std::move(name), bufferCapacity, overflow);
 }
 
 template <typename TraceEvent>
 TraceBus<TraceEvent>::TraceBus(
     PrivateConstructorTag,
     std::string name,
-    size_t bufferCapacity)
-    : name_{std::move(name)}, bufferCapacity_{bufferCapacity} {
+    size_t bufferCapacity,
+    TraceBusOverflow overflow)
+    : name_{std::move(name)},
+      bufferCapacity_{bufferCapacity},
+      overflow_{overflow} {
   XCHECK_GT(bufferCapacity_, 0u) << "Buffer capacity must not be zero";
 
   state_.unsafeGetUnlocked().writeBuffer.reserve(bufferCapacity_);
@@ -74,9 +78,13 @@ void TraceBus<TraceEvent>::publish(TraceEvent&& event) noexcept {
     XCHECK(!state->done) << "Illegal to publish concurrently with destruction";
     if (state->writeBuffer.size() == bufferCapacity_) {
       // If the buffer is full then the capacity is potentially set too low. Log
-      // an appropriate warning and then block until we have room to append the
-      // current event.
+      // an appropriate warning and then either drop the event or block until
+      // we have room to append the current event.
       logFullOnce();
+      if (overflow_ == TraceBusOverflow::Drop) {
+        state->droppedEvents++;
+        return;
+      }
       fullCV_.wait(state.as_lock(), [&] {
         return state->writeBuffer.size() < bufferCapacity_;
       });
@@ -90,6 +98,11 @@ void TraceBus<TraceEvent>::publish(TraceEvent&& event) noexcept {
   }
 }
 
+template <typename TraceEvent>
+uint64_t TraceBus<TraceEvent>::getDroppedEventCount() const noexcept {
+  return state_.lock()->droppedEvents;
+}
+
 template <typename TraceEvent>
 TraceSubscriptionHandle<TraceEvent> TraceBus<TraceEvent>::subscribe(
     std::shared_ptr<Subscriber> subscriber) {
@@ -117,16 +130,19 @@ void TraceBus<TraceEvent>::unsubscribe(void* subscription) noexcept {
 template <typename TraceEvent>
 void TraceBus<TraceEvent>::logFullOnce() noexcept {
   folly::call_once(logIfFullFlag_, [&]() noexcept {
+    const char* action =
+        overflow_ == TraceBusOverflow::Drop ? "dropping events" : "blocking";
     try {
-      XLOG(WARN) << "TraceBus(" << name_ << ") is full; blocking. Is capacity "
-                 << bufferCapacity_ << " sufficient?";
+      XLOG(WARN) << "TraceBus(" << name_ << ") is full; " << action
+                 << ". Is capacity " << bufferCapacity_ << " sufficient?";
     } catch (std::exception& e) {
       fprintf(
           stderr,
-          "TraceBus(%s) is full; blocking. Is capacity %" PRIu64
+          "TraceBus(%s) is full; %s. Is capacity %" PRIu64
           "sufficient?\n"
           "Logging failed with %s\n",
           name_.c_str(),
+          action,
           uint64_t{bufferCapacity_},
           e.what());
       fflush(stderr);
@@ -137,10 +137,24 @@ class TraceSubscriptionHandle {
 };
 
 /**
- * TraceBus is a reliable, fixed-capacity event trace that runs subscription
- * callbacks on a background thread. It is intended for lightweight telemetry
+ * What TraceBus::publish() does when the buffer is full.
+ */
+enum class TraceBusOverflow {
+  /** Wait for the background thread to make room. No event is lost. */
+  Block,
+  /**
+   * Drop the event and count it. Subscribers must tolerate missing events,
+   * such as a FINISH without its START.
+   */
+  Drop,
+};
+
+/**
+ * TraceBus is a fixed-capacity event trace that runs subscription callbacks
+ * on a background thread. It is intended for lightweight telemetry
  * computation: if the subscriptions perform heavy computation and events are
- * submitted more frequently than they're processed, publish() will block.
+ * submitted more frequently than they're processed, publish() will block,
+ * or drop events if the bus was created with TraceBusOverflow::Drop.
  *
  * The capacity should be selected based on the expected usage in context.
  * Memory usage will be capacity * sizeof(TraceEvent) * 2, but a capacity too
@@ -168,7 +182,8 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
    */
   static std::shared_ptr<TraceBus> create(
       std::string name,
-      size_t bufferCapacity);
+      size_t bufferCapacity,
+      TraceBusOverflow overflow = TraceBusOverflow::Block);
 
   /**
    * Use `create` instead. TraceBus must be managed by shared_ptr.
@@ -176,7 +191,8 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
   TraceBus(
       PrivateConstructorTag,
       std::string threadName,
-      size_t bufferCapacity);
+      size_t bufferCapacity,
+      TraceBusOverflow overflow);
 
   /**
    * Blocks until all published events have been observed by all registered
@@ -196,6 +212,12 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
    */
   void publish(TraceEvent&& event) noexcept;
 
+  /**
+   * The number of events dropped because the buffer was full. Always zero
+   * with TraceBusOverflow::Block.
+   */
+  uint64_t getDroppedEventCount() const noexcept;
+
   /**
    * Subscribe to published events. If the subscriber throws, it will
    * automatically be unsubscribed.
@@ -266,12 +288,14 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
     std::vector<TraceEvent> writeBuffer;
     // Incremented every publish()
     uint64_t sequenceNumber = 1;
+    uint64_t droppedEvents = 0;
   };
 
   const std::string name_;
   const size_t bufferCapacity_;
+  const TraceBusOverflow overflow_;
 
-  folly::Synchronized<State, std::mutex> state_;
+  mutable folly::Synchronized<State, std::mutex> state_;
   // Encodes the condition done || !writeBuffer.empty()
   std::condition_variable emptyCV_;
   // Encodes the condition writeBuffer.size() < bufferCapacity_
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/InstrumentedMutex.h"
+
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+#include <folly/portability/GTest.h>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "eden/fs/utils/Synchronized.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+struct TestLockName {
+  static const char* name() {
+    return "test";
+  }
+};
+
+// Enough acquisitions for some of them to be sampled.
+constexpr int kIterations = 1000;
+
+} // namespace
+
+TEST(InstrumentedMutex, exclusive_mutex_protects_the_state) {
+  folly::Synchronized<int, InstrumentedMutex<std::mutex, TestLockName>> value{
+      0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < kIterations; ++i) {
+        ++*value.lock();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(4 * kIterations, *value.lock());
+}
+
+TEST(InstrumentedMutex, shared_mutex_supports_every_lock_mode) {
+  folly::Synchronized<int, InstrumentedMutex<folly::SharedMutex, TestLockName>>
+      value{0};
+  for (int i = 0; i < kIterations; ++i) {
+    {
+      auto ulock = value.ulock();
+      auto wlock = ulock.moveFromUpgradeToWrite();
+      ++*wlock;
+    }
+    EXPECT_EQ(i + 1, *value.rlock());
+    ++*value.wlock();
+    EXPECT_EQ(i + 2, *value.rlock());
+    --*value.wlock();
+  }
+
+  auto result = tryRlockCheckBeforeUpdate<int>(
+      value,
+      [](const int& v) -> std::optional<int> {
+        return v == kIterations ? std::optional<int>{v} : std::nullopt;
+      },
+      [](auto& wlock) { return ++*wlock; });
+  EXPECT_EQ(kIterations, result);
+}
+
+TEST(InstrumentedMutex, works_with_condition_variable_any) {
+  folly::Synchronized<bool, InstrumentedMutex<std::mutex, TestLockName>> ready{
+      false};
+  std::condition_variable_any cv;
+  std::thread notifier{[&] {
+    *ready.lock() = true;
+    cv.notify_one();
+  }};
+
+  {
+    auto lock = ready.lock();
+    cv.wait(lock.as_lock(), [&] { return *lock; });
+    EXPECT_TRUE(*lock);
+  }
+  notifier.join();
+}
@@ -7,6 +7,7 @@
 
 #include "eden/fs/telemetry/SubprocessScribeLogger.h"
 
+#include <folly/Conv.h>
 #include <folly/FileUtil.h>
 #include <folly/experimental/TestUtil.h>
 #include <folly/portability/GTest.h>
@@ -31,3 +32,28 @@ TEST(ScribeLogger, log_messages_are_written_with_newlines) {
   folly::readFile(output.fd(), contents);
   EXPECT_EQ("foo\nbar\n", contents);
 }
+
+TEST(ScribeLogger, bursts_of_messages_are_written_in_order) {
+  folly::test::TemporaryFile output;
+
+  // More messages than fit in a single writev() call, small enough that
+  // none are dropped.
+  std::string expected;
+  {
+    SubprocessScribeLogger logger{
+        std::vector<std::string>{"/bin/cat"},
+        FileDescriptor(
+            ::dup(output.fd()), "dup", FileDescriptor::FDType::Generic)};
+    for (int i = 0; i < 1000; ++i) {
+      auto message = folly::to<std::string>("message ", i);
+      expected += message + "\n";
+      logger.log(std::move(message));
+    }
+    EXPECT_EQ(0, logger.getDroppedMessageCount());
+  }
+
+  folly::checkUnixError(lseek(output.fd(), 0, SEEK_SET));
+  std::string contents;
+  folly::readFile(output.fd(), contents);
+  EXPECT_EQ(expected, contents);
+}
@@ -8,6 +8,7 @@
 #include "eden/fs/telemetry/TraceBus.h"
 #include <folly/futures/Promise.h>
 #include <folly/portability/GTest.h>
+#include <algorithm>
 
 using namespace std::literals;
 using namespace facebook::eden;
@@ -100,3 +101,33 @@ TEST(TraceBusTest, unsubscribe_before_publish) {
   // of events.
   XCHECK(1 == i || i == 3) << i << " must be 1 or 3";
 }
+
+TEST(TraceBusTest, full_bus_drops_events_when_configured_to) {
+  folly::Promise<folly::Unit> unblock;
+  auto unblocked = unblock.getSemiFuture();
+  std::vector<int> values;
+  {
+    auto bus = TraceBus<int>::create("bus", 2, TraceBusOverflow::Drop);
+    auto handle = bus->subscribeFunction("sub", [&](int v) {
+      if (v == 0) {
+        // Hold the background thread so that the buffer fills up.
+        std::move(unblocked).wait();
+      }
+      values.push_back(v);
+    });
+
+    // The background thread blocks on a batch of at most two events, and at
+    // most two more fit in the buffer. publish() does not block.
+    for (int i = 0; i <= 10; ++i) {
+      bus->publish(i);
+    }
+    EXPECT_LE(7, bus->getDroppedEventCount());
+    unblock.setValue();
+  }
+
+  // Whatever was kept is in order, and the first event was never dropped.
+  ASSERT_LE(2, values.size());
+  EXPECT_GE(4, values.size());
+  EXPECT_EQ(0, values[0]);
+  EXPECT_TRUE(std::is_sorted(values.begin(), values.end()));
+}
@@ -97,7 +97,8 @@ Future<Unit> FakePrivHelper::nfsMount(
     folly::SocketAddress /*mountdPort*/,
     folly::SocketAddress /*nfsdPort*/,
     bool /*readOnly*/,
-    uint32_t /*iosize*/) {
+    uint32_t /*iosize*/,
+    bool /*useReaddirplus*/) {
   return makeFuture<Unit>(
       runtime_error("FakePrivHelper::nfsMount() not implemented"));
 }
@@ -120,6 +121,12 @@ Future<Unit> FakePrivHelper::bindMount(
       runtime_error("FakePrivHelper::bindMount() not implemented"));
 }
 
+folly::Future<std::vector<folly::Try<folly::Unit>>> FakePrivHelper::bindMounts(
+    const std::vector<std::pair<std::string, std::string>>& /* bindMounts */) {
+  return makeFuture<std::vector<folly::Try<folly::Unit>>>(
+      runtime_error("FakePrivHelper::bindMounts() not implemented"));
+}
+
 folly::Future<folly::Unit> FakePrivHelper::bindUnMount(
     folly::StringPiece /* mountPath */) {
   return makeFuture<Unit>(
@@ -59,12 +59,16 @@ class FakePrivHelper : public PrivHelper {
       folly::SocketAddress mountdAddr,
       folly::SocketAddress nfsdAddr,
       bool readOnly,
-      uint32_t iosize) override;
+      uint32_t iosize,
+      bool useReaddirplus) override;
   folly::Future<folly::Unit> fuseUnmount(folly::StringPiece mountPath) override;
   folly::Future<folly::Unit> nfsUnmount(folly::StringPiece mountPath) override;
   folly::Future<folly::Unit> bindMount(
       folly::StringPiece clientPath,
       folly::StringPiece mountPath) override;
+  folly::Future<std::vector<folly::Try<folly::Unit>>> bindMounts(
+      const std::vector<std::pair<std::string, std::string>>& bindMounts)
+      override;
   folly::Future<folly::Unit> bindUnMount(folly::StringPiece mountPath) override;
   folly::Future<folly::Unit> takeoverShutdown(
       folly::StringPiece mountPath) override;
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/testharness/SimulatedBackingStore.h"
+
+#include <fmt/format.h>
+#include <folly/futures/Future.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/utils/FaultInjector.h"
+
+using folly::SemiFuture;
+using folly::Unit;
+using std::unique_ptr;
+
+namespace facebook::eden {
+
+SimulatedBackingStore::SimulatedBackingStore(
+    std::shared_ptr<BackingStore> backingStore,
+    Options options,
+    FaultInjector* faultInjector)
+    : backingStore_{std::move(backingStore)},
+      options_{options},
+      faultInjector_{faultInjector},
+      state_{State{std::mt19937{options.seed}, {}}} {}
+
+RootId SimulatedBackingStore::parseRootId(folly::StringPiece rootId) {
+  return backingStore_->parseRootId(rootId);
+}
+
+std::string SimulatedBackingStore::renderRootId(const RootId& rootId) {
+  return backingStore_->renderRootId(rootId);
+}
+
+SemiFuture<unique_ptr<Tree>> SimulatedBackingStore::getRootTree(
+    const RootId& rootId,
+    ObjectFetchContext& context) {
+  return roundTrip(rootId.value())
+      .deferValue([this, rootId, &context](Unit) {
+        return backingStore_->getRootTree(rootId, context);
+      })
+      .deferValue([this](unique_ptr<Tree> tree) {
+        auto bytes = tree->getSizeBytes();
+        return transfer(bytes).deferValue(
+            [tree = std::move(tree)](Unit) mutable { return std::move(tree); });
+      });
+}
+
+SemiFuture<unique_ptr<TreeEntry>> SimulatedBackingStore::getTreeEntryForRootId(
+    const RootId& rootId,
+    TreeEntryType treeEntryType,
+    facebook::eden::PathComponentPiece pathComponentPiece,
+    ObjectFetchContext& context) {
+  return roundTrip(rootId.value())
+      .deferValue([this,
+                   rootId,
+                   treeEntryType,
+                   name = PathComponent{pathComponentPiece},
+                   &context](Unit) {
+        return backingStore_->getTreeEntryForRootId(
+            rootId, treeEntryType, name, context);
+      });
+}
+
+SemiFuture<BackingStore::GetTreeRes> SimulatedBackingStore::getTree(
+    const ObjectId& id,
+    ObjectFetchContext& context) {
+  return roundTrip(id.toLogString())
+      .deferValue([this, id, &context](Unit) {
+        return backingStore_->getTree(id, context);
+      })
+      .deferValue([this](GetTreeRes result) {
+        auto bytes = result.tree->getSizeBytes();
+        return transfer(bytes).deferValue(
+            [result = std::move(result)](Unit) mutable {
+              return std::move(result);
+            });
+      });
+}
+
+SemiFuture<BackingStore::GetBlobRes> SimulatedBackingStore::getBlob(
+    const ObjectId& id,
+    ObjectFetchContext& context) {
+  return roundTrip(id.toLogString())
+      .deferValue([this, id, &context](Unit) {
+        return backingStore_->getBlob(id, context);
+      })
+      .deferValue([this](GetBlobRes result) {
+        auto bytes = result.blob->getSize();
+        return transfer(bytes).deferValue(
+            [result = std::move(result)](Unit) mutable {
+              return std::move(result);
+            });
+      });
+}
+
+SemiFuture<Unit> SimulatedBackingStore::prefetchBlobs(
+    ObjectIdRange ids,
+    ObjectFetchContext& context) {
+  if (ids.empty()) {
+    return folly::unit;
+  }
+  // The batch is keyed on its first object, so that a fault can be injected
+  // for a given batch.
+  return roundTrip(ids.front().toLogString(), ids.size())
+      .deferValue([this, ids, &context](Unit) {
+        return backingStore_->prefetchBlobs(ids, context);
+      });
+}
+
+std::optional<folly::StringPiece> SimulatedBackingStore::getRepoName() {
+  return backingStore_->getRepoName();
+}
+
+SemiFuture<Unit> SimulatedBackingStore::roundTrip(
+    folly::StringPiece key,
+    size_t count) {
+  std::chrono::microseconds latency;
+  bool fail;
+  {
+    auto state = state_.lock();
+    double multiplier = 1.0;
+    if (options_.latencySigma > 0) {
+      // The median of a log-normal distribution is exp(mu), so mu = 0 keeps
+      // the median at `latency`.
+      multiplier = std::lognormal_distribution<double>{
+          0.0, options_.latencySigma}(state->rng);
+    }
+    multiplier *= std::pow(static_cast<double>(count), options_.batchExponent);
+    latency = std::chrono::microseconds{
+        static_cast<int64_t>(options_.latency.count() * multiplier)};
+    fail = options_.failureProbability > 0 &&
+        std::bernoulli_distribution{options_.failureProbability}(state->rng);
+  }
+
+  return folly::futures::sleep(latency).deferValue(
+      [this, key = key.str(), fail](Unit) {
+        auto injected = faultInjector_
+            ? faultInjector_->checkAsync("SimulatedBackingStore", key)
+            : folly::makeSemiFuture();
+        return std::move(injected).deferValue([key, fail](Unit) {
+          if (fail) {
+            throw std::runtime_error(
+                fmt::format("simulated backing store failure for {}", key));
+          }
+        });
+      });
+}
+
+SemiFuture<Unit> SimulatedBackingStore::transfer(size_t bytes) {
+  if (options_.bandwidth == 0) {
+    return folly::unit;
+  }
+  auto duration = std::chrono::nanoseconds{static_cast<int64_t>(
+      static_cast<double>(bytes) * 1e9 / options_.bandwidth)};
+  auto now = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point done;
+  {
+    auto state = state_.lock();
+    state->linkFreeAt = std::max(state->linkFreeAt, now) + duration;
+    done = state->linkFreeAt;
+  }
+  return folly::futures::sleep(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(done - now));
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+
+#include "eden/fs/store/BackingStore.h"
+
+namespace facebook::eden {
+
+class FaultInjector;
+
+/**
+ * A BackingStore for benchmarks and tests that delays the requests it
+ * forwards to another BackingStore (usually a FakeBackingStore) as if they
+ * went over a network, so that queueing and batching behavior can be
+ * evaluated against something resembling a remote store.
+ *
+ * Each request pays a round trip latency drawn from a log-normal distribution
+ * before being forwarded, and then the transfer of the object it returns over
+ * a link of limited bandwidth shared by all requests. Requests made through
+ * prefetchBlobs pay a single round trip whose cost grows sub-linearly with the
+ * size of the batch.
+ *
+ * Instances must outlive the futures they return.
+ */
+class SimulatedBackingStore final : public BackingStore {
+ public:
+  struct Options {
+    /**
+     * Median round trip latency of a request.
+     */
+    std::chrono::microseconds latency{std::chrono::milliseconds{20}};
+
+    /**
+     * Shape of the latency distribution: the standard deviation of its
+     * logarithm. 0 makes every request take exactly `latency`, while values
+     * around 0.5 give the long tail typical of remote stores.
+     */
+    double latencySigma{0.0};
+
+    /**
+     * Bytes per second shared by all transfers. 0 means unlimited.
+     */
+    uint64_t bandwidth{0};
+
+    /**
+     * How a batch of n objects fetched with prefetchBlobs is charged: its
+     * round trip costs pow(n, batchExponent) single round trips. 0 makes
+     * batching free, 1 makes it no better than individual requests.
+     */
+    double batchExponent{0.5};
+
+    /**
+     * Probability that a request fails with std::runtime_error after paying
+     * its round trip.
+     */
+    double failureProbability{0.0};
+
+    /**
+     * Seed for the latency and failure draws, so runs are repeatable.
+     */
+    uint32_t seed{0};
+  };
+
+  /**
+   * If faultInjector is not null, every request checks it with the
+   * "SimulatedBackingStore" key class and the object id, or the root id, as
+   * the key value, after its round trip.
+   */
+  SimulatedBackingStore(
+      std::shared_ptr<BackingStore> backingStore,
+      Options options,
+      FaultInjector* faultInjector = nullptr);
+
+  RootId parseRootId(folly::StringPiece rootId) override;
+  std::string renderRootId(const RootId& rootId) override;
+
+  folly::SemiFuture<std::unique_ptr<Tree>> getRootTree(
+      const RootId& rootId,
+      ObjectFetchContext& context) override;
+  folly::SemiFuture<std::unique_ptr<TreeEntry>> getTreeEntryForRootId(
+      const RootId& rootId,
+      TreeEntryType treeEntryType,
+      facebook::eden::PathComponentPiece pathComponentPiece,
+      ObjectFetchContext& context) override;
+  folly::SemiFuture<GetTreeRes> getTree(
+      const ObjectId& id,
+      ObjectFetchContext& context) override;
+  folly::SemiFuture<GetBlobRes> getBlob(
+      const ObjectId& id,
+      ObjectFetchContext& context) override;
+
+  FOLLY_NODISCARD folly::SemiFuture<folly::Unit> prefetchBlobs(
+      ObjectIdRange ids,
+      ObjectFetchContext& context) override;
+
+  std::optional<folly::StringPiece> getRepoName() override;
+
+  const std::shared_ptr<BackingStore>& getBackingStore() {
+    return backingStore_;
+  }
+
+ private:
+  /**
+   * Returns a future that completes after a round trip for a batch of
+   * `count` objects, or fails if the request was chosen to fail.
+   */
+  folly::SemiFuture<folly::Unit> roundTrip(
+      folly::StringPiece key,
+      size_t count = 1);
+
+  /**
+   * Returns a future that completes once `bytes` have been transferred over
+   * the shared link, after the transfers already in flight.
+   */
+  folly::SemiFuture<folly::Unit> transfer(size_t bytes);
+
+  struct State {
+    std::mt19937 rng;
+    // When the transfers already started will be done.
+    std::chrono::steady_clock::time_point linkFreeAt;
+  };
+
+  std::shared_ptr<BackingStore> backingStore_;
+  const Options options_;
+  FaultInjector* const faultInjector_;
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/testharness/SyntheticRepo.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+
+#include "eden/fs/testharness/TestMount.h"
+
+namespace facebook::eden {
+
+SyntheticRepo::SyntheticRepo(Options options)
+    : options_{options}, rng_{options.seed} {
+  generateDirectory(RelativePathPiece{}, 0);
+}
+
+void SyntheticRepo::generateDirectory(RelativePathPiece path, size_t depth) {
+  std::lognormal_distribution<double> sizeDistribution{
+      std::log(static_cast<double>(std::max<size_t>(options_.fileSize, 1))),
+      options_.fileSizeSigma};
+  for (size_t i = 0; i < options_.filesPerDirectory; ++i) {
+    auto size = options_.fileSizeSigma > 0
+        ? static_cast<size_t>(sizeDistribution(rng_))
+        : options_.fileSize;
+    auto filePath = path + RelativePathPiece{fmt::format("file{}", i)};
+    files_.push_back(filePath);
+    sizes_.push_back(size);
+    builder_.setFile(filePath, makeContents(files_.size() - 1, 0));
+  }
+  if (depth < options_.depth) {
+    for (size_t i = 0; i < options_.fanout; ++i) {
+      generateDirectory(
+          path + RelativePathPiece{fmt::format("dir{}", i)}, depth + 1);
+    }
+  }
+}
+
+std::string SyntheticRepo::makeContents(size_t index, size_t generation)
+    const {
+  // The header makes the contents of every file, and of every generation of
+  // a file, distinct, so that no two files share a blob.
+  auto contents = fmt::format("{} {}\n", files_[index], generation);
+  if (contents.size() < sizes_[index]) {
+    contents.resize(sizes_[index], 'x');
+  }
+  return contents;
+}
+
+std::vector<size_t> SyntheticRepo::pickFiles(size_t count) {
+  std::vector<size_t> indexes(files_.size());
+  std::iota(indexes.begin(), indexes.end(), 0);
+  std::vector<size_t> picked;
+  std::sample(
+      indexes.begin(),
+      indexes.end(),
+      std::back_inserter(picked),
+      count,
+      rng_);
+  return picked;
+}
+
+FakeTreeBuilder SyntheticRepo::makeModifiedCommit(size_t count) {
+  auto builder = builder_.clone();
+  ++generation_;
+  for (auto index : pickFiles(count)) {
+    builder.replaceFile(files_[index], makeContents(index, generation_));
+  }
+  return builder;
+}
+
+void SyntheticRepo::materializeFiles(TestMount& mount, size_t count) {
+  for (auto index : pickFiles(count)) {
+    mount.overwriteFile(files_[index].stringPiece(), makeContents(index, 0));
+  }
+}
+
+void SyntheticRepo::modifyFiles(TestMount& mount, size_t count) {
+  ++generation_;
+  for (auto index : pickFiles(count)) {
+    mount.overwriteFile(
+        files_[index].stringPiece(), makeContents(index, generation_));
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class TestMount;
+
+/**
+ * Generates a FakeTreeBuilder populated with a large, regular tree, so that
+ * benchmarks can measure checkout and status on repositories of a chosen
+ * shape rather than on the handful of files tests usually set up.
+ *
+ * Every directory above `depth` holds `fanout` subdirectories and
+ * `filesPerDirectory` files, so the tree has filesPerDirectory *
+ * (fanout^(depth + 1) - 1) / (fanout - 1) files. File sizes are drawn from a
+ * log-normal distribution.
+ *
+ * The generated contents are deterministic for a given seed.
+ */
+class SyntheticRepo {
+ public:
+  struct Options {
+    size_t depth{3};
+    size_t fanout{8};
+    size_t filesPerDirectory{16};
+    /**
+     * Median file size in bytes.
+     */
+    size_t fileSize{4096};
+    /**
+     * Standard deviation of the logarithm of the file size. 0 makes every
+     * file `fileSize` bytes long.
+     */
+    double fileSizeSigma{1.0};
+    uint32_t seed{0};
+  };
+
+  explicit SyntheticRepo(Options options);
+
+  FakeTreeBuilder& getBuilder() {
+    return builder_;
+  }
+
+  const std::vector<RelativePath>& getFiles() const {
+    return files_;
+  }
+
+  /**
+   * Returns a builder for a child commit of this repo's in which `count`
+   * randomly chosen files were modified.
+   */
+  FakeTreeBuilder makeModifiedCommit(size_t count);
+
+  /**
+   * Materializes `count` randomly chosen files of a mount of this repo's
+   * commit, without changing their contents, so that they have to be
+   * compared against source control by status.
+   */
+  void materializeFiles(TestMount& mount, size_t count);
+
+  /**
+   * Overwrites `count` randomly chosen files of a mount of this repo's
+   * commit with new contents.
+   */
+  void modifyFiles(TestMount& mount, size_t count);
+
+ private:
+  void generateDirectory(RelativePathPiece path, size_t depth);
+  std::string makeContents(size_t index, size_t generation) const;
+  std::vector<size_t> pickFiles(size_t count);
+
+  const Options options_;
+  std::mt19937 rng_;
+  FakeTreeBuilder builder_;
+  std::vector<RelativePath> files_;
+  std::vector<size_t> sizes_;
+  // Incremented for every modification, so that each produces new contents.
+  size_t generation_{0};
+};
+
+} // namespace facebook::eden
@@ -195,6 +195,14 @@ class TestMount {
     return treeCache_;
   }
 
+  /**
+   * The EdenConfig shared with the ServerState. Tests can change settings
+   * through it after build().
+   */
+  const std::shared_ptr<EdenConfig>& getEdenConfig() const {
+    return edenConfig_;
+  }
+
 #ifndef _WIN32
   FuseDispatcher* getDispatcher() const;
 #endif // !_WIN32
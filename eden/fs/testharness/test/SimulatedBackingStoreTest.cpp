@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/testharness/SimulatedBackingStore.h"
+
+#include <folly/portability/GTest.h>
+#include <folly/test/TestUtils.h>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/utils/FaultInjector.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct SimulatedBackingStoreTest : ::testing::Test {
+  void SetUp() override {
+    auto* blob = fakeStore->putBlob("contents");
+    blob->setReady();
+    id = blob->get().getHash();
+  }
+
+  std::unique_ptr<SimulatedBackingStore> makeStore(
+      SimulatedBackingStore::Options options) {
+    return std::make_unique<SimulatedBackingStore>(
+        fakeStore, options, &faultInjector);
+  }
+
+  std::shared_ptr<FakeBackingStore> fakeStore =
+      std::make_shared<FakeBackingStore>();
+  FaultInjector faultInjector{true};
+  ObjectId id;
+};
+
+} // namespace
+
+TEST_F(SimulatedBackingStoreTest, requests_pay_the_round_trip_latency) {
+  SimulatedBackingStore::Options options;
+  options.latency = 50ms;
+  auto store = makeStore(options);
+
+  auto start = std::chrono::steady_clock::now();
+  auto result =
+      store->getBlob(id, ObjectFetchContext::getNullContext()).get(10s);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 50ms);
+  EXPECT_EQ(id, result.blob->getHash());
+  EXPECT_EQ(ObjectFetchContext::Origin::FromNetworkFetch, result.origin);
+}
+
+TEST_F(SimulatedBackingStoreTest, transfers_are_limited_by_bandwidth) {
+  SimulatedBackingStore::Options options;
+  options.latency = 0ms;
+  // "contents" takes 80 ms at 100 bytes per second.
+  options.bandwidth = 100;
+  auto store = makeStore(options);
+
+  auto start = std::chrono::steady_clock::now();
+  store->getBlob(id, ObjectFetchContext::getNullContext()).get(10s);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 80ms);
+}
+
+TEST_F(SimulatedBackingStoreTest, requests_fail_with_failure_probability) {
+  SimulatedBackingStore::Options options;
+  options.latency = 0ms;
+  options.failureProbability = 1.0;
+  auto store = makeStore(options);
+
+  EXPECT_THROW_RE(
+      store->getBlob(id, ObjectFetchContext::getNullContext()).get(10s),
+      std::runtime_error,
+      "simulated backing store failure");
+}
+
+TEST_F(SimulatedBackingStoreTest, requests_check_the_fault_injector) {
+  SimulatedBackingStore::Options options;
+  options.latency = 0ms;
+  auto store = makeStore(options);
+  faultInjector.injectError(
+      "SimulatedBackingStore", id.toLogString(), std::domain_error("injected"));
+
+  EXPECT_THROW_RE(
+      store->getBlob(id, ObjectFetchContext::getNullContext()).get(10s),
+      std::domain_error,
+      "injected");
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/BufVec.h"
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+
+namespace facebook {
+namespace eden {
+
+std::unique_ptr<folly::IOBuf> BufVec::toIOBuf() && {
+  if (buf_) {
+    return std::move(buf_);
+  }
+
+  auto buf = folly::IOBuf::createCombined(length_);
+  auto res =
+      folly::preadFull(file_.fd(), buf->writableBuffer(), length_, offset_);
+  folly::checkUnixError(res, "pread failed while reading file range");
+  buf->append(res);
+  return buf;
+}
+
+} // namespace eden
+} // namespace facebook
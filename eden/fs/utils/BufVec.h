@@ -6,7 +6,9 @@
  */
 
 #pragma once
+#include <folly/File.h>
 #include <folly/io/IOBuf.h>
+#include <memory>
 
 namespace facebook {
 namespace eden {
@@ -14,14 +16,80 @@ namespace eden {
 /**
  * Represents data that may come from a buffer or a file descriptor.
  *
- * EdenFS does not currently support splicing between the FUSE device
- * pipe and the backing files in the overlay, but there's an opportunity
- * to improve performance on large files by enabling FUSE_CAP_SPLICE_READ or
- * FUSE_CAP_SPLICE_WRITE.
- *
- * So pretend we have a type that corresponds roughly to libfuse's fuse_bufvec.
+ * This corresponds roughly to libfuse's fuse_bufvec: a FUSE read of a
+ * materialized file can return a reference to a range of the overlay file,
+ * which the FuseChannel then splices to the FUSE device without copying it
+ * through userspace. Consumers that need the bytes in memory call toIOBuf().
  */
-using BufVec = std::unique_ptr<folly::IOBuf>;
+class BufVec {
+ public:
+  explicit BufVec(std::unique_ptr<folly::IOBuf> buf) : buf_{std::move(buf)} {}
+
+  /**
+   * Refer to length bytes of file starting at offset. The caller must know
+   * that the range exists; reads past the end of the file are a short read.
+   */
+  static BufVec fromFile(folly::File file, off_t offset, size_t length) {
+    return BufVec{std::move(file), offset, length};
+  }
+
+  BufVec(BufVec&&) = default;
+  BufVec& operator=(BufVec&&) = default;
+
+  /**
+   * Returns true if the data lives in a file rather than in memory.
+   */
+  bool isFile() const {
+    return !buf_;
+  }
+
+  /**
+   * The number of bytes of data.
+   */
+  size_t size() const {
+    return buf_ ? buf_->computeChainDataLength() : length_;
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /**
+   * The file and offset of the data. Only valid if isFile() is true.
+   */
+  const folly::File& getFile() const {
+    return file_;
+  }
+  off_t getFileOffset() const {
+    return offset_;
+  }
+
+  /**
+   * Access the in-memory buffer. Only valid if isFile() is false.
+   */
+  folly::IOBuf& operator*() const {
+    return *buf_;
+  }
+  folly::IOBuf* operator->() const {
+    return buf_.get();
+  }
+
+  /**
+   * Returns the data as an IOBuf, reading it from the file if necessary.
+   *
+   * Throws std::system_error if the read fails.
+   */
+  std::unique_ptr<folly::IOBuf> toIOBuf() &&;
+
+ private:
+  BufVec(folly::File file, off_t offset, size_t length)
+      : file_{std::move(file)}, offset_{offset}, length_{length} {}
+
+  std::unique_ptr<folly::IOBuf> buf_;
+  folly::File file_;
+  off_t offset_{0};
+  size_t length_{0};
+};
 
 } // namespace eden
 } // namespace facebook
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/CpuAffinity.h"
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/Utility.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+#include <array>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace facebook::eden {
+
+namespace {
+constexpr auto kPolicyNames = [] {
+  std::array<folly::StringPiece, 4> names{};
+  names[folly::to_underlying(CpuAffinityPolicy::None)] = "none";
+  names[folly::to_underlying(CpuAffinityPolicy::Pin)] = "pin";
+  names[folly::to_underlying(CpuAffinityPolicy::NodeLocal)] = "node-local";
+  names[folly::to_underlying(CpuAffinityPolicy::Spread)] = "spread";
+  return names;
+}();
+
+/**
+ * A single node with as many CPUs as the hardware has.
+ */
+CpuTopology makeFlatTopology() {
+  std::vector<size_t> cpus(std::max(1u, std::thread::hardware_concurrency()));
+  for (size_t cpu = 0; cpu < cpus.size(); ++cpu) {
+    cpus[cpu] = cpu;
+  }
+  return CpuTopology{{std::move(cpus)}};
+}
+
+#ifdef __linux__
+constexpr folly::StringPiece kNodeDir{"/sys/devices/system/node"};
+
+std::optional<std::vector<size_t>> readCpuList(const std::string& path) {
+  std::string contents;
+  if (!folly::readFile(path.c_str(), contents)) {
+    return std::nullopt;
+  }
+  return parseCpuList(folly::trimWhitespace(contents));
+}
+
+CpuTopology detectTopology() {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    XLOG(WARN) << "unable to read the CPU affinity of the process: "
+               << folly::errnoStr(errno);
+    return makeFlatTopology();
+  }
+  auto isAllowed = [&](size_t cpu) {
+    return cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed);
+  };
+
+  std::vector<std::vector<size_t>> nodes;
+  auto online = readCpuList(folly::to<std::string>(kNodeDir, "/online"));
+  for (auto node : online.value_or(std::vector<size_t>{})) {
+    auto cpus = readCpuList(
+        folly::to<std::string>(kNodeDir, "/node", node, "/cpulist"));
+    if (!cpus) {
+      continue;
+    }
+    cpus->erase(
+        std::remove_if(
+            cpus->begin(),
+            cpus->end(),
+            [&](size_t cpu) { return !isAllowed(cpu); }),
+        cpus->end());
+    nodes.push_back(std::move(*cpus));
+  }
+
+  if (std::all_of(nodes.begin(), nodes.end(), [](const auto& cpus) {
+        return cpus.empty();
+      })) {
+    // No NUMA information, e.g. in some containers: all the allowed CPUs
+    // are in one node.
+    std::vector<size_t> cpus;
+    for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (isAllowed(cpu)) {
+        cpus.push_back(cpu);
+      }
+    }
+    nodes = {std::move(cpus)};
+  }
+  return CpuTopology{std::move(nodes)};
+}
+#else
+CpuTopology detectTopology() {
+  return makeFlatTopology();
+}
+#endif
+} // namespace
+
+std::optional<CpuAffinityPolicy> parseCpuAffinityPolicy(
+    folly::StringPiece name) {
+  for (size_t policy = 0; policy < kPolicyNames.size(); ++policy) {
+    if (name.equals(kPolicyNames[policy], folly::AsciiCaseInsensitive())) {
+      return static_cast<CpuAffinityPolicy>(policy);
+    }
+  }
+  return std::nullopt;
+}
+
+folly::StringPiece toString(CpuAffinityPolicy policy) {
+  return kPolicyNames[folly::to_underlying(policy)];
+}
+
+CpuTopology::CpuTopology(std::vector<std::vector<size_t>> nodes)
+    : nodes_{std::move(nodes)} {
+  nodes_.erase(
+      std::remove_if(
+          nodes_.begin(),
+          nodes_.end(),
+          [](const auto& cpus) { return cpus.empty(); }),
+      nodes_.end());
+  if (nodes_.empty()) {
+    nodes_.push_back({0});
+  }
+}
+
+const CpuTopology& CpuTopology::get() {
+  static const CpuTopology topology = detectTopology();
+  return topology;
+}
+
+size_t CpuTopology::getNodeOf(size_t cpu) const {
+  for (size_t node = 0; node < nodes_.size(); ++node) {
+    const auto& cpus = nodes_[node];
+    if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+      return node;
+    }
+  }
+  return 0;
+}
+
+std::vector<size_t> CpuTopology::selectCpus(
+    CpuAffinityPolicy policy,
+    size_t workerIndex,
+    size_t homeNode) const {
+  homeNode %= nodes_.size();
+  switch (policy) {
+    case CpuAffinityPolicy::None:
+      return {};
+    case CpuAffinityPolicy::Pin: {
+      size_t cpuCount = 0;
+      for (const auto& cpus : nodes_) {
+        cpuCount += cpus.size();
+      }
+      // Walk the CPUs node by node, starting with the home node.
+      auto index = workerIndex % cpuCount;
+      for (size_t i = 0; i < nodes_.size(); ++i) {
+        const auto& cpus = nodes_[(homeNode + i) % nodes_.size()];
+        if (index < cpus.size()) {
+          return {cpus[index]};
+        }
+        index -= cpus.size();
+      }
+      return {};
+    }
+    case CpuAffinityPolicy::NodeLocal:
+      return nodes_[homeNode];
+    case CpuAffinityPolicy::Spread:
+      return nodes_[(homeNode + workerIndex) % nodes_.size()];
+  }
+  return {};
+}
+
+std::optional<std::vector<size_t>> parseCpuList(folly::StringPiece list) {
+  std::vector<size_t> cpus;
+  if (list.empty()) {
+    return cpus;
+  }
+  std::vector<folly::StringPiece> ranges;
+  folly::split(',', list, ranges);
+  for (auto range : ranges) {
+    folly::StringPiece first;
+    folly::StringPiece last;
+    if (!folly::split('-', range, first, last)) {
+      first = last = range;
+    }
+    auto begin = folly::tryTo<size_t>(first);
+    auto end = folly::tryTo<size_t>(last);
+    if (!begin || !end || *end < *begin) {
+      return std::nullopt;
+    }
+    for (auto cpu = *begin; cpu <= *end; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+size_t getCurrentNumaNode() {
+#ifdef __linux__
+  auto cpu = sched_getcpu();
+  if (cpu >= 0) {
+    return CpuTopology::get().getNodeOf(static_cast<size_t>(cpu));
+  }
+#endif
+  return 0;
+}
+
+void bindCurrentThread(
+    CpuAffinityPolicy policy,
+    size_t workerIndex,
+    size_t homeNode) {
+  auto cpus = CpuTopology::get().selectCpus(policy, workerIndex, homeNode);
+  if (cpus.empty()) {
+    return;
+  }
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : cpus) {
+    CPU_SET(cpu, &set);
+  }
+  if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+    XLOG(WARN) << "unable to bind thread " << workerIndex << " to CPUs "
+               << folly::join(",", cpus) << ": " << folly::errnoStr(errno);
+  }
+#endif
+}
+
+CpuAffinityThreadFactory::CpuAffinityThreadFactory(
+    std::shared_ptr<folly::ThreadFactory> delegate,
+    CpuAffinityPolicy policy)
+    : delegate_{std::move(delegate)},
+      policy_{policy},
+      homeNode_{getCurrentNumaNode()} {}
+
+std::thread CpuAffinityThreadFactory::newThread(folly::Func&& func) {
+  auto workerIndex = nextWorker_.fetch_add(1, std::memory_order_relaxed);
+  return delegate_->newThread(
+      [policy = policy_,
+       homeNode = homeNode_,
+       workerIndex,
+       func = std::move(func)]() mutable {
+        bindCurrentThread(policy, workerIndex, homeNode);
+        func();
+      });
+}
+
+} // namespace facebook::eden
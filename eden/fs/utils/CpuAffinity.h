@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/executors/thread_factory/ThreadFactory.h>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * Where the threads of a pool are allowed to run.
+ *
+ * On machines with several NUMA nodes, threads that float across sockets
+ * keep missing in their caches, and touch memory that was allocated on
+ * another node. Binding a thread before it allocates its buffers and
+ * thread-local state also keeps that memory on its node, since Linux places
+ * pages on the node of the thread that first touches them.
+ */
+enum class CpuAffinityPolicy {
+  /**
+   * Threads run anywhere the scheduler puts them.
+   */
+  None,
+
+  /**
+   * Each thread is bound to a single CPU, the threads of a pool taking
+   * consecutive CPUs starting with the node the pool was created on, so that
+   * neighbouring threads share caches.
+   */
+  Pin,
+
+  /**
+   * All the threads of a pool run on the node the pool was created on.
+   */
+  NodeLocal,
+
+  /**
+   * The threads of a pool are dealt to the nodes in turn, and each may run
+   * on any CPU of its node.
+   */
+  Spread,
+};
+
+/**
+ * Parses the name of a policy: "none", "pin", "node-local" or "spread", in
+ * any case. Returns std::nullopt for anything else.
+ */
+std::optional<CpuAffinityPolicy> parseCpuAffinityPolicy(
+    folly::StringPiece name);
+
+folly::StringPiece toString(CpuAffinityPolicy policy);
+
+/**
+ * The CPUs of each NUMA node that this process is allowed to run on.
+ */
+class CpuTopology {
+ public:
+  /**
+   * Nodes with no CPU are dropped. A topology always has at least one node.
+   */
+  explicit CpuTopology(std::vector<std::vector<size_t>> nodes);
+
+  /**
+   * The topology of this machine, detected on first use. On platforms where
+   * nodes aren't detected, all the CPUs are in a single node.
+   */
+  static const CpuTopology& get();
+
+  const std::vector<std::vector<size_t>>& getNodes() const {
+    return nodes_;
+  }
+
+  /**
+   * The node of cpu, or 0 if it isn't in any.
+   */
+  size_t getNodeOf(size_t cpu) const;
+
+  /**
+   * The CPUs the workerIndex-th thread of a pool created on homeNode may run
+   * on under policy. Empty for CpuAffinityPolicy::None.
+   */
+  std::vector<size_t> selectCpus(
+      CpuAffinityPolicy policy,
+      size_t workerIndex,
+      size_t homeNode) const;
+
+ private:
+  std::vector<std::vector<size_t>> nodes_;
+};
+
+/**
+ * Parses a list of CPUs in the cpulist format of sysfs, like "0-3,8,10-11".
+ * Returns std::nullopt if it is malformed.
+ */
+std::optional<std::vector<size_t>> parseCpuList(folly::StringPiece list);
+
+/**
+ * The node of the CPU the calling thread is running on, or 0 if unknown.
+ */
+size_t getCurrentNumaNode();
+
+/**
+ * Binds the calling thread to the CPUs selected by
+ * CpuTopology::get().selectCpus(). Does nothing for CpuAffinityPolicy::None
+ * and on platforms other than Linux. Failures are logged and otherwise
+ * ignored: affinity is only a performance hint.
+ */
+void bindCurrentThread(
+    CpuAffinityPolicy policy,
+    size_t workerIndex,
+    size_t homeNode);
+
+/**
+ * A ThreadFactory that binds each thread made by delegate according to
+ * policy before running its function. The node the factory is created on is
+ * the home node of the pool.
+ */
+class CpuAffinityThreadFactory : public folly::ThreadFactory {
+ public:
+  CpuAffinityThreadFactory(
+      std::shared_ptr<folly::ThreadFactory> delegate,
+      CpuAffinityPolicy policy);
+
+  std::thread newThread(folly::Func&& func) override;
+
+ private:
+  const std::shared_ptr<folly::ThreadFactory> delegate_;
+  const CpuAffinityPolicy policy_;
+  const size_t homeNode_;
+  std::atomic<size_t> nextWorker_{0};
+};
+
+} // namespace facebook::eden
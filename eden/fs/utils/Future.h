@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/futures/Future.h>
+#include <vector>
 
 namespace facebook {
 namespace eden {
@@ -89,5 +90,24 @@ collectSafe(Fs&&... fs) {
   return ctx->p.getFuture();
 }
 
+/**
+ * Same as above, for a dynamic number of futures of the same type. When some
+ * of them fail, the error of the first one, in the order of the vector, is
+ * returned.
+ */
+template <typename T>
+folly::Future<std::vector<T>> collectSafe(
+    std::vector<folly::Future<T>> futures) {
+  return folly::collectAll(std::move(futures))
+      .thenValue([](std::vector<folly::Try<T>> results) {
+        std::vector<T> values;
+        values.reserve(results.size());
+        for (auto& result : results) {
+          values.push_back(std::move(result).value());
+        }
+        return values;
+      });
+}
+
 } // namespace eden
 } // namespace facebook
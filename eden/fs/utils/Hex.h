@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <cstdint>
+#include <string>
+#include "eden/fs/utils/Utf8.h"
+
+namespace facebook::eden {
+
+namespace detail {
+constexpr uint64_t kLowNibbles = 0x0f0f0f0f0f0f0f0f;
+
+/**
+ * Returns the value of a hex digit of either case, or -1 if c isn't one.
+ */
+constexpr int hexDigitValue(char c) {
+  if ('0' <= c && c <= '9') {
+    return c - '0';
+  } else if ('a' <= c && c <= 'f') {
+    return 10 + c - 'a';
+  } else if ('A' <= c && c <= 'F') {
+    return 10 + c - 'A';
+  }
+  return -1;
+}
+
+/**
+ * Returns the 8 lowercase hex digits of the 4 bytes of a little-endian word,
+ * as a little-endian word.
+ */
+constexpr uint64_t bytesToHexWord(uint32_t bytes) {
+  // Move each byte to the low half of its own 16-bit lane...
+  uint64_t spread = bytes;
+  spread = (spread | (spread << 16)) & 0x0000ffff0000ffff;
+  spread = (spread | (spread << 8)) & 0x00ff00ff00ff00ff;
+  // ... and split it in two nibbles, the high one first since it's printed
+  // first.
+  auto nibbles = ((spread >> 4) & 0x000f000f000f000f) |
+      ((spread & 0x000f000f000f000f) << 8);
+  // Adding 6 to the nibbles of 10 and more carries into their bit 4, it is
+  // moved to bit 0 to tell which ones are letters.
+  auto letters = ((nibbles + 6 * kLowBits) >> 4) & kLowBits;
+  return nibbles + '0' * kLowBits + letters * ('a' - '0' - 10);
+}
+
+/**
+ * Decodes a little-endian word of 8 hex digits, of either case, into the 4
+ * bytes they represent, stored in bytes as a little-endian word. Returns
+ * false if any of the characters isn't a hex digit.
+ */
+constexpr bool hexWordToBytes(uint64_t word, uint32_t& bytes) {
+  // The range checks below need the high bit of every byte to be clear.
+  if (!isAsciiWord(word)) {
+    return false;
+  }
+  // The high bit of each byte is set if it is >= '0' and if it is > '9'.
+  auto geDigit = word + (0x80 - '0') * kLowBits;
+  auto gtDigit = word + (0x80 - '9' - 1) * kLowBits;
+  auto isDigit = geDigit & ~gtDigit & kHighBits;
+  // Upper case letters are lowered first. Only letters are folded into
+  // 'a'-'f'.
+  auto lower = word | (0x20 * kLowBits);
+  auto geLetter = lower + (0x80 - 'a') * kLowBits;
+  auto gtLetter = lower + (0x80 - 'f' - 1) * kLowBits;
+  auto isLetter = geLetter & ~gtLetter & kHighBits;
+  if ((isDigit | isLetter) != kHighBits) {
+    return false;
+  }
+
+  // The low nibble of a digit is its value, the one of a letter is its value
+  // minus 9.
+  auto nibbles = (word & kLowNibbles) + (isLetter >> 7) * 9;
+  // Combine the two nibbles of each 16-bit lane into its low byte, then pack
+  // the lanes.
+  auto packed = ((nibbles & 0x00ff00ff00ff00ff) << 4) |
+      ((nibbles >> 8) & 0x00ff00ff00ff00ff);
+  packed = (packed | (packed >> 8)) & 0x0000ffff0000ffff;
+  packed = (packed | (packed >> 16)) & 0x00000000ffffffff;
+  bytes = static_cast<uint32_t>(packed);
+  return true;
+}
+} // namespace detail
+
+/**
+ * Writes the lowercase hex representation of bytes to out, which must have
+ * room for 2 * bytes.size() characters.
+ *
+ * Converts 4 bytes at a time. As with loadWord, the byte-wise loads and
+ * stores let this be used in constant expressions, and compilers turn them
+ * into single loads and stores.
+ */
+constexpr void hexEncode(folly::ByteRange bytes, char* out) {
+  constexpr folly::StringPiece kDigits{"0123456789abcdef"};
+  size_t i = 0;
+  for (; i + 4 <= bytes.size(); i += 4) {
+    uint32_t word = uint32_t{bytes[i]} | (uint32_t{bytes[i + 1]} << 8) |
+        (uint32_t{bytes[i + 2]} << 16) | (uint32_t{bytes[i + 3]} << 24);
+    auto hex = detail::bytesToHexWord(word);
+    for (size_t j = 0; j < 8; ++j) {
+      out[2 * i + j] = static_cast<char>(hex >> (8 * j));
+    }
+  }
+  for (; i < bytes.size(); ++i) {
+    out[2 * i] = kDigits[bytes[i] >> 4];
+    out[2 * i + 1] = kDigits[bytes[i] & 0xf];
+  }
+}
+
+/**
+ * Returns the lowercase hex representation of bytes.
+ */
+inline std::string hexEncode(folly::ByteRange bytes) {
+  std::string result(2 * bytes.size(), '\0');
+  hexEncode(bytes, result.data());
+  return result;
+}
+
+/**
+ * Decodes hex digits of either case into out, which must have room for
+ * hex.size() / 2 bytes. hex.size() must be even.
+ *
+ * Returns false if hex contains anything but hex digits, in which case the
+ * contents of out are unspecified. Like hexEncode(), this converts 8 digits
+ * at a time and can be used in constant expressions.
+ */
+constexpr bool hexDecode(folly::StringPiece hex, uint8_t* out) {
+  size_t i = 0;
+  for (; i + 8 <= hex.size(); i += 8) {
+    uint32_t bytes = 0;
+    if (!detail::hexWordToBytes(detail::loadWord(hex.data() + i), bytes)) {
+      return false;
+    }
+    for (size_t j = 0; j < 4; ++j) {
+      out[i / 2 + j] = static_cast<uint8_t>(bytes >> (8 * j));
+    }
+  }
+  for (; i + 2 <= hex.size(); i += 2) {
+    auto high = detail::hexDigitValue(hex[i]);
+    auto low = detail::hexDigitValue(hex[i + 1]);
+    if (high < 0 || low < 0) {
+      return false;
+    }
+    out[i / 2] = static_cast<uint8_t>(high * 16 + low);
+  }
+  return true;
+}
+
+/**
+ * Returns the first character of hex that isn't a hex digit, or '\0' if
+ * there is none. Meant for error messages after hexDecode() failed.
+ */
+constexpr char findInvalidHexDigit(folly::StringPiece hex) {
+  for (auto c : hex) {
+    if (detail::hexDigitValue(c) < 0) {
+      return c;
+    }
+  }
+  return '\0';
+}
+
+} // namespace facebook::eden
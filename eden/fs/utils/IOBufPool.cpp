@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/IOBufPool.h"
+
+#include <folly/Memory.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+#include <new>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace facebook {
+namespace eden {
+
+namespace {
+void* allocateAligned(size_t size) {
+  auto* buffer = folly::aligned_malloc(size, IOBufPool::getPageSize());
+  if (!buffer) {
+    throw std::bad_alloc{};
+  }
+  return buffer;
+}
+
+// Small enough that a burst of replies doesn't hold on to much memory once
+// it is over, but enough for the replies in flight of a busy mount.
+constexpr size_t kMaxFreeReplyBuffers = 256;
+} // namespace
+
+IOBufPool::IOBufPool(std::vector<size_t> bufferSizes, size_t maxFreeBuffers) {
+  auto pageSize = getPageSize();
+  for (auto& size : bufferSizes) {
+    size = std::max<size_t>((size + pageSize - 1) / pageSize, 1) * pageSize;
+  }
+  std::sort(bufferSizes.begin(), bufferSizes.end());
+  bufferSizes.erase(
+      std::unique(bufferSizes.begin(), bufferSizes.end()), bufferSizes.end());
+  for (auto size : bufferSizes) {
+    auto sizeClass = std::make_unique<SizeClass>();
+    sizeClass->size = size;
+    sizeClass->maxFree = maxFreeBuffers;
+    sizeClass->free.lock()->reserve(maxFreeBuffers);
+    sizeClasses_.push_back(std::move(sizeClass));
+  }
+}
+
+IOBufPool::~IOBufPool() {
+  for (auto& sizeClass : sizeClasses_) {
+    for (auto* buffer : *sizeClass->free.lock()) {
+      folly::aligned_free(buffer);
+    }
+  }
+}
+
+std::unique_ptr<folly::IOBuf> IOBufPool::allocate(size_t capacity) {
+  auto it = std::find_if(
+      sizeClasses_.begin(), sizeClasses_.end(), [&](const auto& sizeClass) {
+        return sizeClass->size >= capacity;
+      });
+  if (it == sizeClasses_.end()) {
+    auto pageSize = getPageSize();
+    auto size = (capacity + pageSize - 1) / pageSize * pageSize;
+    allocationCount_.fetch_add(1, std::memory_order_relaxed);
+    return folly::IOBuf::takeOwnership(
+        allocateAligned(size), size, 0, freeUnpooled, nullptr);
+  }
+
+  auto* sizeClass = it->get();
+  void* buffer = nullptr;
+  {
+    auto free = sizeClass->free.lock();
+    if (!free->empty()) {
+      buffer = free->back();
+      free->pop_back();
+    }
+  }
+  if (buffer) {
+    reuseCount_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    buffer = allocateAligned(sizeClass->size);
+    allocationCount_.fetch_add(1, std::memory_order_relaxed);
+  }
+  // takeOwnership frees the buffer through freeBuffer if it throws.
+  return folly::IOBuf::takeOwnership(
+      buffer, sizeClass->size, 0, freeBuffer, sizeClass);
+}
+
+IOBufPool::Stats IOBufPool::getStats() const {
+  Stats stats;
+  stats.reuseCount = reuseCount_.load(std::memory_order_relaxed);
+  stats.allocationCount = allocationCount_.load(std::memory_order_relaxed);
+  for (const auto& sizeClass : sizeClasses_) {
+    auto count = sizeClass->free.lock()->size();
+    stats.freeCount += count;
+    stats.freeBytes += count * sizeClass->size;
+  }
+  return stats;
+}
+
+void IOBufPool::freeBuffer(void* buffer, void* userData) noexcept {
+  auto* sizeClass = static_cast<SizeClass*>(userData);
+  {
+    auto free = sizeClass->free.lock();
+    if (free->size() < sizeClass->maxFree) {
+      free->push_back(buffer);
+      return;
+    }
+  }
+  folly::aligned_free(buffer);
+}
+
+void IOBufPool::freeUnpooled(void* buffer, void* /*userData*/) noexcept {
+  folly::aligned_free(buffer);
+}
+
+IOBufPool& IOBufPool::getReplyPool() {
+  // Leaked, so that replies still being written during shutdown can be
+  // freed.
+  static auto* pool =
+      new IOBufPool{{getPageSize(), 64 * 1024}, kMaxFreeReplyBuffers};
+  return *pool;
+}
+
+size_t IOBufPool::getPageSize() {
+#ifdef _WIN32
+  return 4096;
+#else
+  static const size_t pageSize = sysconf(_SC_PAGESIZE);
+  return pageSize;
+#endif
+}
+
+} // namespace eden
+} // namespace facebook
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/io/IOBuf.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace facebook {
+namespace eden {
+
+/**
+ * A pool of page-aligned buffers, handed out as IOBufs, for building the
+ * replies of the FUSE and NFS channels.
+ *
+ * Every request used to allocate its reply buffer, and the NFS server grows
+ * each reply 1KB at a time. Here, buffers come in a few fixed size classes
+ * and, once the last IOBuf referring to one is freed, typically after the
+ * socket finished writing it, it goes back to the pool for the next reply.
+ * In steady state the channels then only allocate the small IOBuf headers.
+ *
+ * Requests larger than the largest size class get a page-aligned buffer of
+ * their own, which is freed rather than pooled.
+ *
+ * It is safe to use this object from arbitrary threads. All the buffers must
+ * be freed before the pool is destroyed.
+ */
+class IOBufPool {
+ public:
+  struct Stats {
+    /** Number of allocations served by a pooled buffer. */
+    uint64_t reuseCount = 0;
+    /** Number of allocations of a new buffer, pooled or not. */
+    uint64_t allocationCount = 0;
+    /** Number of buffers waiting in the pool, and their total size. */
+    size_t freeCount = 0;
+    size_t freeBytes = 0;
+  };
+
+  /**
+   * Create a pool with a size class for each of bufferSizes, rounded up to
+   * whole pages. Up to maxFreeBuffers of each size class are kept for reuse,
+   * the rest are freed.
+   */
+  IOBufPool(std::vector<size_t> bufferSizes, size_t maxFreeBuffers);
+  ~IOBufPool();
+
+  IOBufPool(const IOBufPool&) = delete;
+  IOBufPool& operator=(const IOBufPool&) = delete;
+
+  /**
+   * Returns an empty IOBuf with a page-aligned buffer of at least capacity
+   * bytes, reusing a pooled one when capacity fits a size class. Throws
+   * std::bad_alloc if a new buffer can't be allocated.
+   */
+  std::unique_ptr<folly::IOBuf> allocate(size_t capacity);
+
+  Stats getStats() const;
+
+  /**
+   * The pool shared by the FUSE and NFS channels. It has size classes for a
+   * page, typical of small replies and directory listings, and 64KB.
+   */
+  static IOBufPool& getReplyPool();
+
+  static size_t getPageSize();
+
+ private:
+  struct SizeClass {
+    size_t size;
+    size_t maxFree;
+    /** Reserved for maxFree buffers, so that freeing never allocates. */
+    folly::Synchronized<std::vector<void*>, std::mutex> free;
+  };
+
+  static void freeBuffer(void* buffer, void* userData) noexcept;
+  static void freeUnpooled(void* buffer, void* userData) noexcept;
+
+  /** Sorted by size. */
+  std::vector<std::unique_ptr<SizeClass>> sizeClasses_;
+
+  std::atomic<uint64_t> reuseCount_{0};
+  std::atomic<uint64_t> allocationCount_{0};
+};
+
+} // namespace eden
+} // namespace facebook
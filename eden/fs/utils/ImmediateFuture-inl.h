@@ -88,11 +88,22 @@ ImmediateFuture<T>& ImmediateFuture<T>::operator=(
   return *this;
 }
 
+template <typename T>
+void ImmediateFuture<T>::takeReadySemiFuture() noexcept {
+  if (kind_ == Kind::SemiFuture && semi_.isReady()) {
+    auto try_ = std::move(semi_).getTry();
+    destroy();
+    new (&immediate_) folly::Try<T>{std::move(try_)};
+    kind_ = Kind::Immediate;
+  }
+}
+
 template <typename T>
 template <typename Func>
 ImmediateFuture<detail::continuation_result_t<Func, T>>
 ImmediateFuture<T>::thenValue(Func&& func) && {
   using RetType = detail::continuation_result_t<Func, T>;
+  takeReadySemiFuture();
   if (kind_ == Kind::Immediate && immediate_.hasException()) {
     return ImmediateFuture<RetType>{
         folly::Try<RetType>{std::move(immediate_).exception()}};
@@ -123,9 +134,9 @@ bool ImmediateFuture<T>::isReady() const {
     case Kind::Immediate:
       return true;
     case Kind::SemiFuture:
-      // TODO: This could return semi_.isReady() if we also changed thenTry to
-      // check semi_.isReady() and call .get() instead of .defer().
-      return false;
+      // thenTry runs the callback inline on a SemiFuture that completed
+      // after this ImmediateFuture was built.
+      return semi_.isReady();
     case Kind::Nothing:
       throw DestroyedImmediateFutureError{};
   }
@@ -139,6 +150,11 @@ ImmediateFuture<T>::thenTry(Func&& func) && {
   using NewType = detail::continuation_result_t<Func, folly::Try<T>>;
   using FuncRetType = std::invoke_result_t<Func, folly::Try<T>>;
 
+  // A SemiFuture that completed since it was wrapped would otherwise need a
+  // deferred core and a type-erased callback for a value that is already
+  // there.
+  takeReadySemiFuture();
+
   switch (kind_) {
     case Kind::Immediate:
       try {
@@ -158,13 +174,15 @@ ImmediateFuture<T>::thenTry(Func&& func) && {
       // In the case where Func returns an ImmediateFuture, we need to
       // transform that return value into a SemiFuture so that the return
       // type is a SemiFuture<NewType> and not a
-      // SemiFuture<ImmediateFuture<NewType>>.
-      auto semiFut = std::move(semi_).defer(std::forward<Func>(func));
+      // SemiFuture<ImmediateFuture<NewType>>. Doing so in the deferred
+      // callback itself lets defer unwrap it without a second core.
       if constexpr (detail::isImmediateFuture<FuncRetType>::value) {
-        return std::move(semiFut).deferValue(
-            [](auto&& immFut) { return std::move(immFut).semi(); });
+        return std::move(semi_).defer(
+            [func = std::forward<Func>(func)](folly::Try<T>&& try_) mutable {
+              return func(std::move(try_)).semi();
+            });
       } else {
-        return semiFut;
+        return std::move(semi_).defer(std::forward<Func>(func));
       }
     }
     case Kind::Nothing:
@@ -201,6 +201,12 @@ class ImmediateFuture {
    */
   void destroy();
 
+  /**
+   * If this holds a SemiFuture that has completed, replace it with its
+   * result, so that continuations run inline.
+   */
+  void takeReadySemiFuture() noexcept;
+
   union {
     folly::Try<T> immediate_;
     folly::SemiFuture<T> semi_;
@@ -291,6 +291,17 @@ class MappedDiskVector {
     return begin_[index];
   }
 
+  /**
+   * Grow the file, if necessary, so that count elements fit in it without
+   * remapping it again.
+   */
+  void reserve(size_t count) {
+    if (count > capacity()) {
+      growTo(detail::roundUpToNonzeroPageSize(
+          sizeof(Header) + count * sizeof(T)));
+    }
+  }
+
   template <typename... Args>
   void emplace_back(Args&&... args) {
     if (!hasRoom(1)) {
@@ -298,44 +309,13 @@ class MappedDiskVector {
           sizeof(GROWTH_IN_PAGES) * detail::kPageSize >= sizeof(T),
           "Growth must expand the file more than a single record");
 
-      size_t oldSize = size();
-      size_t newFileSize =
-          mapSizeInBytes_ + GROWTH_IN_PAGES * detail::kPageSize;
-
-      // Always keep the file size a whole number of pages.
-      XCHECK_EQ(0ul, newFileSize % detail::kPageSize);
-
-      if (-1 == folly::ftruncateNoInt(file_.fd(), newFileSize)) {
-        folly::throwSystemError("ftruncateNoInt failed when growing capacity");
-      }
-
-#ifdef __APPLE__
-      auto newMap = mmap(
-          nullptr,
-          newFileSize,
-          PROT_READ | PROT_WRITE,
-          MAP_SHARED,
-          file_.fd(),
-          0);
-#else
-      auto newMap = mremap(map_, mapSizeInBytes_, newFileSize, MREMAP_MAYMOVE);
-#endif
-      if (newMap == MAP_FAILED) {
-        folly::throwSystemError(folly::to<std::string>(
-            "mremap failed when growing capacity from ",
-            mapSizeInBytes_,
-            " to ",
-            newFileSize));
-      }
-
-#ifdef __APPLE__
-      munmap(map_, mapSizeInBytes_);
-#endif
-      map_ = newMap;
-      mapSizeInBytes_ = newFileSize;
-
-      begin_ = reinterpret_cast<T*>(static_cast<Header*>(newMap) + 1);
-      end_ = begin_ + oldSize;
+      // Grow by half of the current size, so that building a large vector,
+      // like when a checkout creates many inodes, only remaps it a
+      // logarithmic number of times.
+      growTo(std::max(
+          mapSizeInBytes_ + GROWTH_IN_PAGES * detail::kPageSize,
+          detail::roundUpToNonzeroPageSize(
+              mapSizeInBytes_ + mapSizeInBytes_ / 2)));
     }
 
     T* out = end_;
@@ -475,6 +455,45 @@ class MappedDiskVector {
         static_cast<char*>(map_) + mapSizeInBytes_);
   }
 
+  void growTo(size_t newFileSize) {
+    size_t oldSize = size();
+
+    // Always keep the file size a whole number of pages.
+    XCHECK_EQ(0ul, newFileSize % detail::kPageSize);
+
+    if (-1 == folly::ftruncateNoInt(file_.fd(), newFileSize)) {
+      folly::throwSystemError("ftruncateNoInt failed when growing capacity");
+    }
+
+#ifdef __APPLE__
+    auto newMap = mmap(
+        nullptr,
+        newFileSize,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED,
+        file_.fd(),
+        0);
+#else
+    auto newMap = mremap(map_, mapSizeInBytes_, newFileSize, MREMAP_MAYMOVE);
+#endif
+    if (newMap == MAP_FAILED) {
+      folly::throwSystemError(folly::to<std::string>(
+          "mremap failed when growing capacity from ",
+          mapSizeInBytes_,
+          " to ",
+          newFileSize));
+    }
+
+#ifdef __APPLE__
+    munmap(map_, mapSizeInBytes_);
+#endif
+    map_ = newMap;
+    mapSizeInBytes_ = newFileSize;
+
+    begin_ = reinterpret_cast<T*>(static_cast<Header*>(newMap) + 1);
+    end_ = begin_ + oldSize;
+  }
+
   bool hasRoom(size_t amount) const {
     // Technically, the expression (end_ + amount) is constructing a pointer
     // past the end of the "object" (mmap) and is thus UB.  But hopefully no
@@ -565,7 +584,7 @@ struct Migrator<T, First, Rest...> {
       auto tmpPath = folly::to<std::string>(path, ".tmp");
       auto newVector = MappedDiskVector<T>::createOrOverwrite(tmpPath);
       try {
-        // TODO: newVector.reserve
+        newVector.reserve(original.size());
         for (size_t i = 0; i < original.size(); ++i) {
           newVector.emplace_back(convert(original[i]));
         }
@@ -465,7 +465,26 @@ class PathBase :
 /// Asserts that val is a well formed path component
 struct PathComponentSanityCheck {
   constexpr void operator()(folly::StringPiece val) const {
-    for (auto c : val) {
+    // Names are checked on every request from the filesystem channels. Look
+    // for directory separators, nul bytes and non-ASCII characters 8 bytes at
+    // a time, and only look at individual bytes from the first word that may
+    // hold an invalid character.
+    const char* begin = val.begin();
+    const char* const end = val.end();
+    bool isAscii = true;
+    while (end - begin >= 8) {
+      auto word = loadWord(begin);
+      if (hasByte(word, kDirSeparator) || hasByte(word, '\0') ||
+          (folly::kIsWindows && hasByte(word, kWinDirSeparator))) {
+        break;
+      }
+      isAscii = isAscii && isAsciiWord(word);
+      begin += 8;
+    }
+
+    for (; begin != end; ++begin) {
+      auto c = *begin;
+      isAscii = isAscii && !isBitSet(c, 7);
       if (isDirSeparator(c)) {
         throw PathComponentContainsDirectorySeparator(folly::to<std::string>(
             "attempt to construct a PathComponent from a string containing a "
@@ -497,7 +516,7 @@ struct PathComponentSanityCheck {
         break;
     }
 
-    if (!isValidUtf8(val)) {
+    if (!isAscii && !isValidUtf8(val)) {
       throw PathComponentNotUtf8(folly::to<std::string>(
           "attempt to construct a PathComponent from non valid UTF8 data: ",
           val));
@@ -1202,12 +1221,23 @@ class RelativePathBase : public ComposedPathBase<
           PathComponentPiece,
           typename std::iterator_traits<Iterator>::reference>::value>::type>
   RelativePathBase(Iterator begin, Iterator end) {
-    folly::fbvector<folly::StringPiece> components;
-    while (begin != end) {
-      components.emplace_back(PathComponentPiece{*begin}.stringPiece());
-      ++begin;
+    // Size the path up front, so that building it takes a single
+    // allocation.
+    size_t size = 0;
+    for (auto it = begin; it != end; ++it) {
+      size += PathComponentPiece{*it}.stringPiece().size() + 1;
+    }
+    if (size == 0) {
+      return;
+    }
+    this->path_.reserve(size - 1);
+    for (auto it = begin; it != end; ++it) {
+      if (it != begin) {
+        this->path_.push_back(kDirSeparator);
+      }
+      auto component = PathComponentPiece{*it}.stringPiece();
+      this->path_.append(component.data(), component.size());
     }
-    folly::join(kDirSeparatorStr, components, this->path_);
   }
 
   /** Construct from a container that holds PathComponents.
@@ -12,6 +12,8 @@
 #include <functional>
 #include <iterator>
 #include <utility>
+#include <vector>
+#include "eden/fs/utils/CaseInsensitiveCompare.h"
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -31,6 +33,12 @@ namespace eden {
  *   it is better to pre-sort the data to be inserted.
  * - Since insert and erase operations move the vector contents around,
  *   those operations invalidate iterators.
+ * - Case insensitive maps additionally keep an index of the entries sorted by
+ *   their case-folded key, so that case insensitive lookups are a binary
+ *   search rather than a scan of every entry. Keeping the index up to date
+ *   costs O(n) per out-of-order insert or erase, on top of moving the vector
+ *   contents. Appends, as when populating from sorted entries, only cost the
+ *   binary search.
  */
 template <typename Value, typename Key = PathComponent>
 class PathMap : private folly::fbvector<std::pair<Key, Value>> {
@@ -77,6 +85,86 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
   Compare compare_;
   CaseSensitivity caseSensitive_{kPathMapDefaultCaseSensitive};
 
+  // Only populated for case insensitive maps: positions in the vector, sorted
+  // by case-folded key.
+  std::vector<uint32_t> foldedIndex_;
+
+  bool isCaseInsensitive() const {
+    return caseSensitive_ == CaseSensitivity::Insensitive;
+  }
+
+  folly::StringPiece keyAt(uint32_t position) const {
+    return Piece(Vector::operator[](position).first).stringPiece();
+  }
+
+  std::vector<uint32_t>::iterator foldedLowerBound(Piece key) {
+    return std::lower_bound(
+        foldedIndex_.begin(),
+        foldedIndex_.end(),
+        key.stringPiece(),
+        [this](uint32_t position, folly::StringPiece k) {
+          return compareAsciiCaseInsensitive(keyAt(position), k) < 0;
+        });
+  }
+
+  std::vector<uint32_t>::const_iterator foldedLowerBound(Piece key) const {
+    return std::lower_bound(
+        foldedIndex_.begin(),
+        foldedIndex_.end(),
+        key.stringPiece(),
+        [this](uint32_t position, folly::StringPiece k) {
+          return compareAsciiCaseInsensitive(keyAt(position), k) < 0;
+        });
+  }
+
+  // Returns the position of the entry equal to key ignoring case, or size()
+  // if there is none. Only valid for case insensitive maps.
+  size_type findCaseInsensitive(Piece key) const {
+    auto iter = foldedLowerBound(key);
+    if (iter != foldedIndex_.end() &&
+        equalsAsciiCaseInsensitive(keyAt(*iter), key.stringPiece())) {
+      return *iter;
+    }
+    return size();
+  }
+
+  // Record in foldedIndex_ that an entry was inserted at position. Unless it
+  // was appended, every index past position is shifted, which is O(n).
+  void indexInserted(size_type position) {
+    if (!isCaseInsensitive()) {
+      return;
+    }
+    // Appending, as when populating from sorted entries, moves nothing.
+    if (position + 1 != size()) {
+      for (auto& index : foldedIndex_) {
+        if (index >= position) {
+          ++index;
+        }
+      }
+    }
+    auto where = foldedLowerBound(Piece(Vector::operator[](position).first));
+    foldedIndex_.insert(where, static_cast<uint32_t>(position));
+  }
+
+  // Record in foldedIndex_ that the entries in [first, last) were erased.
+  void indexErased(size_type first, size_type last) {
+    if (!isCaseInsensitive() || first == last) {
+      return;
+    }
+    auto count = last - first;
+    foldedIndex_.erase(
+        std::remove_if(
+            foldedIndex_.begin(),
+            foldedIndex_.end(),
+            [&](uint32_t index) { return index >= first && index < last; }),
+        foldedIndex_.end());
+    for (auto& index : foldedIndex_) {
+      if (index >= last) {
+        index -= count;
+      }
+    }
+  }
+
  public:
   // Various type aliases to satisfy container concepts.
   using key_type = Key;
@@ -121,7 +209,9 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
 
   // Inherit the underlying vector copy/assignment.
   PathMap(const PathMap& other)
-      : Vector(other), caseSensitive_(other.caseSensitive_) {}
+      : Vector(other),
+        caseSensitive_(other.caseSensitive_),
+        foldedIndex_(other.foldedIndex_) {}
   PathMap& operator=(const PathMap& other) {
     PathMap(other).swap(*this);
     return *this;
@@ -129,7 +219,9 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
 
   // inherit Move construction.
   PathMap(PathMap&& other) noexcept
-      : Vector(std::move(other)), caseSensitive_(other.caseSensitive_) {}
+      : Vector(std::move(other)),
+        caseSensitive_(other.caseSensitive_),
+        foldedIndex_(std::move(other.foldedIndex_)) {}
   PathMap& operator=(PathMap&& other) {
     other.swap(*this);
     return *this;
@@ -137,14 +229,13 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
 
   // inherit these methods from the underlying vector.
   using Vector::begin;
+  using Vector::capacity;
   using Vector::cbegin;
   using Vector::cend;
-  using Vector::clear;
   using Vector::crbegin;
   using Vector::crend;
   using Vector::empty;
   using Vector::end;
-  using Vector::erase;
   using Vector::max_size;
   using Vector::rbegin;
   using Vector::rend;
@@ -154,6 +245,38 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
   void swap(PathMap& other) noexcept {
     Vector::swap(other);
     std::swap(caseSensitive_, other.caseSensitive_);
+    foldedIndex_.swap(other.foldedIndex_);
+  }
+
+  void clear() {
+    Vector::clear();
+    foldedIndex_.clear();
+  }
+
+  /** Allocate room for n entries up front.
+   * Populating a map whose final size is known this way avoids both the
+   * repeated reallocation and the unused capacity that growing the vector
+   * one entry at a time leaves behind. */
+  void reserve(size_type n) {
+    Vector::reserve(n);
+    if (isCaseInsensitive()) {
+      foldedIndex_.reserve(n);
+    }
+  }
+
+  iterator erase(const_iterator position) {
+    auto offset = position - cbegin();
+    auto result = Vector::erase(position);
+    indexErased(offset, offset + 1);
+    return result;
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    auto firstOffset = first - cbegin();
+    auto lastOffset = last - cbegin();
+    auto result = Vector::erase(first, last);
+    indexErased(firstOffset, lastOffset);
+    return result;
   }
 
   // lower_bound performs the binary search for locating keys.
@@ -174,16 +297,11 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
       // Found it
       return iter;
     }
-    if (caseSensitive_ == CaseSensitivity::Insensitive) {
+    if (isCaseInsensitive()) {
       // When !caseSensitive_, for performance, we will do a case sensitive
       // search first which should cover most of the cases and if not found then
       // do a case insensitive search.
-      for (iter = begin(); iter != end(); ++iter) {
-        if (key.stringPiece().equals(
-                iter->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          return iter;
-        }
-      }
+      return begin() + findCaseInsensitive(key);
     }
     return end();
   }
@@ -197,13 +315,8 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
       // Found it
       return iter;
     }
-    if (caseSensitive_ == CaseSensitivity::Insensitive) {
-      for (iter = begin(); iter != end(); ++iter) {
-        if (key.stringPiece().equals(
-                iter->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          return iter;
-        }
-      }
+    if (isCaseInsensitive()) {
+      return begin() + findCaseInsensitive(key);
     }
     return end();
   }
@@ -220,18 +333,18 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
       return std::make_pair(iter, false);
     }
 
-    if (caseSensitive_ == CaseSensitivity::Insensitive) {
-      for (auto insens = begin(); insens != end(); ++insens) {
-        if (val.first.stringPiece().equals(
-                insens->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          // Found it; leave it alone
-          return std::make_pair(insens, false);
-        }
+    if (isCaseInsensitive()) {
+      auto position = findCaseInsensitive(val.first);
+      if (position != size()) {
+        // Found it; leave it alone
+        return std::make_pair(begin() + position, false);
       }
     }
 
     // Otherwise, iter is the insertion point
-    return std::make_pair(Vector::insert(iter, val), true);
+    iter = Vector::insert(iter, val);
+    indexInserted(iter - begin());
+    return std::make_pair(iter, true);
   }
 
   /** Emplace a new key-value pair by constructing it in-place.
@@ -249,19 +362,18 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
       return std::make_pair(iter, false);
     }
 
-    if (caseSensitive_ == CaseSensitivity::Insensitive) {
-      for (auto insens = begin(); insens != end(); ++insens) {
-        if (key.stringPiece().equals(
-                insens->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          // Found it; leave it alone
-          return std::make_pair(insens, false);
-        }
+    if (isCaseInsensitive()) {
+      auto position = findCaseInsensitive(key);
+      if (position != size()) {
+        // Found it; leave it alone
+        return std::make_pair(begin() + position, false);
       }
     }
 
     // Otherwise, iter is the insertion point
     iter = Vector::emplace(
         iter, std::make_pair(Key(key), Value(std::forward<Args>(args)...)));
+    indexInserted(iter - begin());
     return std::make_pair(iter, true);
   }
 
@@ -275,19 +387,18 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
       return iter->second;
     }
 
-    if (caseSensitive_ == CaseSensitivity::Insensitive) {
+    if (isCaseInsensitive()) {
       // Case insensitive lookup
-      for (auto insens = begin(); insens != end(); ++insens) {
-        if (key.stringPiece().equals(
-                insens->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          // Found it
-          return insens->second;
-        }
+      auto position = findCaseInsensitive(key);
+      if (position != size()) {
+        // Found it
+        return (begin() + position)->second;
       }
     }
 
     // Not yet present, make a new one at the insertion point
     iter = Vector::insert(iter, std::make_pair(Key(key), mapped_type()));
+    indexInserted(iter - begin());
     return iter->second;
   }
 
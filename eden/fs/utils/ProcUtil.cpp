@@ -88,7 +88,75 @@ optional<MemoryStats> readMemoryStats() {
 #endif
 }
 
+MemoryPressure readMemoryPressure() {
+  MemoryPressure pressure;
+#ifdef __linux__
+  std::string contents;
+  if (folly::readFile("/proc/pressure/memory", contents)) {
+    pressure.someAvg10 = parsePressureSomeAvg10(contents);
+  }
+
+  if (!folly::readFile("/proc/self/cgroup", contents)) {
+    return pressure;
+  }
+  auto cgroupPath = parseCgroupV2Path(contents);
+  if (!cgroupPath) {
+    return pressure;
+  }
+  auto cgroupDir = folly::to<std::string>("/sys/fs/cgroup", *cgroupPath);
+  auto readCounter = [&](StringPiece name) -> optional<uint64_t> {
+    std::string value;
+    if (!folly::readFile(
+            folly::to<std::string>(cgroupDir, "/", name).c_str(), value)) {
+      return std::nullopt;
+    }
+    auto parsed = folly::tryTo<uint64_t>(folly::trimWhitespace(value));
+    if (parsed.hasError()) {
+      // memory.max is "max" for cgroups without a limit.
+      return std::nullopt;
+    }
+    return parsed.value();
+  };
+  pressure.cgroupUsage = readCounter("memory.current");
+  pressure.cgroupLimit = readCounter("memory.max");
+#endif
+  return pressure;
+}
+
 #ifndef _WIN32
+optional<double> parsePressureSomeAvg10(StringPiece data) {
+  constexpr StringPiece kPrefix{"some avg10="};
+  auto start = data.find(kPrefix);
+  if (start == StringPiece::npos) {
+    return std::nullopt;
+  }
+  auto value = data.subpiece(start + kPrefix.size());
+  value = value.subpiece(0, value.find_first_of(" \n"));
+  auto parsed = folly::tryTo<double>(value);
+  if (parsed.hasError()) {
+    return std::nullopt;
+  }
+  return parsed.value();
+}
+
+optional<std::string> parseCgroupV2Path(StringPiece data) {
+  // The cgroup v2 hierarchy is the line with the hierarchy ID 0 and no
+  // controllers: "0::/path".
+  constexpr StringPiece kPrefix{"0::"};
+  std::vector<StringPiece> lines;
+  folly::split('\n', data, lines);
+  for (auto line : lines) {
+    if (line.startsWith(kPrefix)) {
+      auto path = line.subpiece(kPrefix.size());
+      if (!path.startsWith('/')) {
+        return std::nullopt;
+      }
+      return path.str();
+    }
+  }
+  return std::nullopt;
+}
+
 optional<MemoryStats> readStatmFile(AbsolutePathPiece filename) {
   auto contents = readFile(filename);
   if (!contents.hasValue()) {
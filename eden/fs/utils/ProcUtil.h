@@ -46,6 +46,26 @@ struct MemoryStats {
  */
 std::optional<MemoryStats> readMemoryStats();
 
+/**
+ * Signals of memory pressure on the machine, or on the cgroup the current
+ * process runs in. Each of them is only available on Linux, and only with a
+ * recent enough kernel and cgroup v2 for the cgroup ones.
+ */
+struct MemoryPressure {
+  /// Percentage of the last 10 seconds during which at least one task was
+  /// stalled waiting for memory, from /proc/pressure/memory.
+  std::optional<double> someAvg10;
+  /// Bytes of memory charged to the cgroup of the current process.
+  std::optional<uint64_t> cgroupUsage;
+  /// The memory limit of that cgroup, absent if it has none.
+  std::optional<uint64_t> cgroupLimit;
+};
+
+/**
+ * Read the memory pressure signals available for the current process.
+ */
+MemoryPressure readMemoryPressure();
+
 /**
  * Calculate the private bytes used by the eden process. The calculation
  * is done by loading, parsing and summing values in /proc/self/smaps file.
@@ -69,6 +89,19 @@ std::optional<MemoryStats> parseStatmFile(
     folly::StringPiece data,
     size_t pageSize);
 
+/**
+ * Parse the "some avg10" percentage out of the contents of a Linux pressure
+ * stall information file, such as /proc/pressure/memory.
+ */
+std::optional<double> parsePressureSomeAvg10(folly::StringPiece data);
+
+/**
+ * Parse the path of the cgroup v2 hierarchy out of the contents of a
+ * /proc/<pid>/cgroup file. Returns std::nullopt if the process is not in a
+ * cgroup v2 hierarchy.
+ */
+std::optional<std::string> parseCgroupV2Path(folly::StringPiece data);
+
 /**
  * Trim leading and trailing delimiter characters from passed string.
  * @return the modified string.
@@ -219,7 +219,9 @@ namespace facebook {
 namespace eden {
 
 ProcessNameCache::ProcessNameCache(std::chrono::nanoseconds expiry)
-    : expiry_{expiry}, startPoint_{std::chrono::steady_clock::now()} {
+    : expiry_{expiry},
+      refreshInterval_{expiry / 16},
+      startPoint_{std::chrono::steady_clock::now()} {
   workerThread_ = std::thread{[this] {
     folly::setThreadName("ProcessNameCacheWorker");
     processActions();
@@ -270,6 +272,19 @@ void ProcessNameCache::add(pid_t pid) {
 
   auto now = std::chrono::steady_clock::now() - startPoint_;
 
+  // Most requests come from a handful of processes, and each FUSE thread
+  // sees the same few pids over and over. Even an uncontended read lock
+  // bounces its cache line between the cores, so skip it when this thread
+  // has refreshed the pid recently: its expiry is at most refreshInterval_
+  // late.
+  auto& recent =
+      recentPids_->entries[static_cast<size_t>(pid) % RecentPids::kSize];
+  if (recent.pid == pid && now - recent.lastAdd < refreshInterval_) {
+    return;
+  }
+  recent.pid = pid;
+  recent.lastAdd = now;
+
   tryRlockCheckBeforeUpdate<folly::Unit>(
       state_,
       [&](const auto& state) -> std::optional<folly::Unit> {
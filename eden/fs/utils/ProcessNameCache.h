@@ -8,10 +8,12 @@
 #pragma once
 
 #include <folly/Synchronized.h>
+#include <folly/ThreadLocal.h>
 #include <folly/container/F14Set.h>
 #include <folly/futures/Promise.h>
 #include <folly/synchronization/LifoSem.h>
 #include <sys/types.h>
+#include <array>
 #include <chrono>
 #include <map>
 #include <optional>
@@ -37,8 +39,9 @@ class ProcessNameCache {
    * Refreshes the expiry on the given pid. The process name is read
    * asynchronously on a background thread.
    *
-   * If possible, the caller should avoid calling add() with a series of
-   * redundant pids.
+   * Each thread remembers the last few pids it added, and skips the shared
+   * state entirely for a pid it added less than a sixteenth of the expiry
+   * ago, so calling add() with a series of redundant pids is cheap.
    */
   void add(pid_t pid);
 
@@ -91,11 +94,27 @@ class ProcessNameCache {
     std::vector<folly::Promise<std::map<pid_t, std::string>>> getQueue;
   };
 
+  /**
+   * The pids recently added by one thread, in a small direct-mapped table
+   * indexed by pid.
+   */
+  struct RecentPids {
+    struct Entry {
+      pid_t pid = -1;
+      std::chrono::steady_clock::duration lastAdd{};
+    };
+    static constexpr size_t kSize = 8;
+    std::array<Entry, kSize> entries;
+  };
+
   void clearExpired(std::chrono::steady_clock::duration now, State& state);
   void processActions();
 
   const std::chrono::nanoseconds expiry_;
+  // A pid added by the same thread within this interval is not added again.
+  const std::chrono::nanoseconds refreshInterval_;
   const std::chrono::steady_clock::time_point startPoint_;
+  folly::ThreadLocal<RecentPids> recentPids_;
   folly::Synchronized<State> state_;
   folly::LifoSem sem_;
   std::thread workerThread_;
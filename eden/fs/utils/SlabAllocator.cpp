@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/SlabAllocator.h"
+
+#include <folly/logging/xlog.h>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace facebook {
+namespace eden {
+
+namespace {
+constexpr size_t kAlignment = alignof(std::max_align_t);
+
+constexpr size_t roundUp(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+constexpr size_t kBlockHeaderSize = roundUp(sizeof(void*));
+} // namespace
+
+struct SlabAllocator::Slab {
+  Slab* prev = nullptr;
+  Slab* next = nullptr;
+  FreeBlock* freeBlocks = nullptr;
+  size_t usedCount = 0;
+  // Blocks from this index onwards have never been handed out, so a new slab
+  // doesn't need to link all its blocks in freeBlocks up front.
+  size_t unusedIndex = 0;
+};
+
+SlabAllocator::SlabAllocator(size_t objectSize, size_t objectsPerSlab)
+    : objectSize_{objectSize},
+      objectsPerSlab_{std::max<size_t>(objectsPerSlab, 1)},
+      blockStride_{
+          kBlockHeaderSize +
+          roundUp(std::max(objectSize, sizeof(FreeBlock)))},
+      slabBytes_{roundUp(sizeof(Slab)) + blockStride_ * objectsPerSlab_} {}
+
+SlabAllocator::~SlabAllocator() {
+  auto state = state_.lock();
+  XCHECK_EQ(0u, state->stats.objectCount)
+      << "SlabAllocator destroyed with blocks still in use";
+  if (state->emptySlab) {
+    freeSlab(state->emptySlab);
+  }
+}
+
+void* SlabAllocator::allocate() {
+  auto state = state_.lock();
+  auto* slab = state->partialSlabs;
+  if (!slab) {
+    if (state->emptySlab) {
+      slab = std::exchange(state->emptySlab, nullptr);
+    } else {
+      slab = allocateSlab();
+      state->stats.slabCount++;
+      state->stats.totalBytes += slabBytes_;
+    }
+    linkSlab(*state, slab);
+  }
+
+  char* object;
+  if (slab->freeBlocks) {
+    auto* block = slab->freeBlocks;
+    slab->freeBlocks = block->next;
+    object = reinterpret_cast<char*>(block);
+  } else {
+    auto* blockStart = reinterpret_cast<char*>(slab) + roundUp(sizeof(Slab)) +
+        slab->unusedIndex * blockStride_;
+    slab->unusedIndex++;
+    *reinterpret_cast<Slab**>(blockStart) = slab;
+    object = blockStart + kBlockHeaderSize;
+  }
+
+  slab->usedCount++;
+  state->stats.objectCount++;
+  if (slab->usedCount == objectsPerSlab_) {
+    unlinkSlab(*state, slab);
+  }
+  return object;
+}
+
+void SlabAllocator::deallocate(void* ptr) noexcept {
+  auto* object = static_cast<char*>(ptr);
+  auto* slab = *reinterpret_cast<Slab**>(object - kBlockHeaderSize);
+
+  Slab* slabToFree = nullptr;
+  {
+    auto state = state_.lock();
+    auto* block = reinterpret_cast<FreeBlock*>(object);
+    block->next = slab->freeBlocks;
+    slab->freeBlocks = block;
+
+    if (slab->usedCount == objectsPerSlab_) {
+      linkSlab(*state, slab);
+    }
+    slab->usedCount--;
+    state->stats.objectCount--;
+
+    if (slab->usedCount == 0) {
+      unlinkSlab(*state, slab);
+      if (!state->emptySlab) {
+        state->emptySlab = slab;
+      } else {
+        slabToFree = slab;
+        state->stats.slabCount--;
+        state->stats.totalBytes -= slabBytes_;
+      }
+    }
+  }
+
+  // Free outside of the lock, the memory is no longer reachable.
+  if (slabToFree) {
+    freeSlab(slabToFree);
+  }
+}
+
+SlabAllocator::Stats SlabAllocator::getStats() const {
+  return state_.lock()->stats;
+}
+
+SlabAllocator::Slab* SlabAllocator::allocateSlab() {
+  auto* memory = std::malloc(slabBytes_);
+  if (!memory) {
+    throw std::bad_alloc{};
+  }
+  return new (memory) Slab{};
+}
+
+void SlabAllocator::freeSlab(Slab* slab) noexcept {
+  slab->~Slab();
+  std::free(slab);
+}
+
+void SlabAllocator::linkSlab(State& state, Slab* slab) noexcept {
+  slab->prev = nullptr;
+  slab->next = state.partialSlabs;
+  if (state.partialSlabs) {
+    state.partialSlabs->prev = slab;
+  }
+  state.partialSlabs = slab;
+}
+
+void SlabAllocator::unlinkSlab(State& state, Slab* slab) noexcept {
+  if (slab->prev) {
+    slab->prev->next = slab->next;
+  } else {
+    state.partialSlabs = slab->next;
+  }
+  if (slab->next) {
+    slab->next->prev = slab->prev;
+  }
+  slab->prev = nullptr;
+  slab->next = nullptr;
+}
+
+} // namespace eden
+} // namespace facebook
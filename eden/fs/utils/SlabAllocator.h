@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <cstddef>
+#include <mutex>
+
+namespace facebook {
+namespace eden {
+
+/**
+ * A pool of fixed-size memory blocks, carved out of large slabs.
+ *
+ * Inodes are loaded and unloaded by the million during large builds. Giving
+ * each its own allocation interleaves them with every other allocation of
+ * the process, so unloading most of them frees memory in small holes that
+ * can rarely be given back. Here, objects of one type share slabs, which are
+ * freed as soon as all their objects are: the slab is the unit of memory
+ * returned to the system allocator, and through it to the OS.
+ *
+ * Freed blocks are reused, most recently freed first, before new slabs are
+ * allocated. One empty slab is kept around so that a workload that loads and
+ * unloads a few objects in a loop doesn't allocate and free a slab each time.
+ *
+ * Each block is preceded by a pointer to its slab, so that deallocate()
+ * doesn't need to search for it.
+ *
+ * It is safe to use this object from arbitrary threads. All the objects must
+ * be deallocated before the SlabAllocator is destroyed.
+ */
+class SlabAllocator {
+ public:
+  struct Stats {
+    /** Number of slabs currently allocated, including the kept empty one. */
+    size_t slabCount = 0;
+    /** Number of blocks currently handed out by allocate(). */
+    size_t objectCount = 0;
+    /** Bytes of memory held by the slabs. */
+    size_t totalBytes = 0;
+  };
+
+  /**
+   * Create an allocator of blocks of objectSize bytes, aligned for any
+   * fundamental type, allocating objectsPerSlab of them at a time.
+   */
+  SlabAllocator(size_t objectSize, size_t objectsPerSlab);
+  ~SlabAllocator();
+
+  SlabAllocator(const SlabAllocator&) = delete;
+  SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+  /**
+   * Returns a block of getObjectSize() bytes. Throws std::bad_alloc if a new
+   * slab is needed and can't be allocated.
+   */
+  void* allocate();
+
+  /**
+   * Returns a block obtained from allocate() to the pool, freeing its slab if
+   * it was the slab's last block in use.
+   */
+  void deallocate(void* ptr) noexcept;
+
+  Stats getStats() const;
+
+  size_t getObjectSize() const {
+    return objectSize_;
+  }
+
+ private:
+  struct Slab;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct State {
+    /**
+     * Doubly linked list of the slabs with both used and free blocks. Full
+     * slabs are not tracked; they are found again through their blocks.
+     */
+    Slab* partialSlabs = nullptr;
+    /** The empty slab kept for reuse, if any. */
+    Slab* emptySlab = nullptr;
+    Stats stats;
+  };
+
+  Slab* allocateSlab();
+  void freeSlab(Slab* slab) noexcept;
+  static void linkSlab(State& state, Slab* slab) noexcept;
+  static void unlinkSlab(State& state, Slab* slab) noexcept;
+
+  const size_t objectSize_;
+  const size_t objectsPerSlab_;
+  // Distance between the start of two consecutive blocks, including the
+  // pointer to the slab that precedes each of them.
+  const size_t blockStride_;
+  const size_t slabBytes_;
+
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace eden
+} // namespace facebook
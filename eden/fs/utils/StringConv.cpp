@@ -16,6 +16,14 @@ std::wstring multibyteToWideString(folly::StringPiece multiBytePiece) {
     return L"";
   }
 
+  // Like wideToMultibyteString, convert ASCII without going through
+  // MultiByteToWideChar twice.
+  if (std::all_of(multiBytePiece.begin(), multiBytePiece.end(), [](char c) {
+        return folly::to_unsigned(c) < 0x80;
+      })) {
+    return std::wstring(multiBytePiece.begin(), multiBytePiece.end());
+  }
+
   int inputSize = folly::to_narrow(folly::to_signed(multiBytePiece.size()));
 
   // To avoid extra copy or using max size buffers we should get the size
@@ -28,6 +28,20 @@ MultiByteStringType wideToMultibyteString(std::wstring_view wideCharPiece) {
     return MultiByteStringType{};
   }
 
+  // Paths are overwhelmingly ASCII, which doesn't need the two passes of
+  // WideCharToMultiByte below.
+  if (std::all_of(wideCharPiece.begin(), wideCharPiece.end(), [](wchar_t c) {
+        return c < 0x80;
+      })) {
+    MultiByteStringType multiByteString(wideCharPiece.size(), 0);
+    std::transform(
+        wideCharPiece.begin(),
+        wideCharPiece.end(),
+        multiByteString.begin(),
+        [](wchar_t c) { return static_cast<char>(c); });
+    return multiByteString;
+  }
+
   int inputSize = folly::to_narrow(folly::to_signed(wideCharPiece.size()));
 
   // To avoid extra copy or using max size buffers we should get the size first
@@ -21,9 +21,14 @@ namespace eden {
  * check should have type (const State&) -> std::optional<T>
  * update should have type (LockedPtr&) -> T
  */
-template <typename Return, typename State, typename CheckFn, typename UpdateFn>
+template <
+    typename Return,
+    typename State,
+    typename Mutex,
+    typename CheckFn,
+    typename UpdateFn>
 Return tryRlockCheckBeforeUpdate(
-    folly::Synchronized<State>& state,
+    folly::Synchronized<State, Mutex>& state,
     CheckFn&& check,
     UpdateFn&& update) {
   // First, acquire the rlock. If the check succeeds, acquiring a wlock is
@@ -9,6 +9,7 @@
 
 #include <folly/Executor.h>
 #include <folly/Range.h>
+#include "eden/fs/utils/CpuAffinity.h"
 
 namespace folly {
 class ManualExecutor;
@@ -26,13 +27,29 @@ namespace eden {
  */
 class UnboundedQueueExecutor : public folly::Executor {
  public:
+  enum class Scheduling {
+    /**
+     * A folly::CPUThreadPoolExecutor whose threads all take tasks from one
+     * queue, in FIFO order.
+     */
+    SharedQueue,
+    /**
+     * A WorkStealingExecutor, better suited to work that fans out into many
+     * small tasks from the worker threads.
+     */
+    WorkStealing,
+  };
+
   /**
-   * Instantiates with a folly::CPUThreadPoolExecutor with the given threadCount
-   * and threadNamePrefix but with an unlimited queue.
+   * Instantiates with a thread pool with the given threadCount and
+   * threadNamePrefix but with an unlimited queue. Its threads are placed
+   * according to affinity.
    */
   explicit UnboundedQueueExecutor(
       size_t threadCount,
-      folly::StringPiece threadNamePrefix);
+      folly::StringPiece threadNamePrefix,
+      Scheduling scheduling = Scheduling::SharedQueue,
+      CpuAffinityPolicy affinity = CpuAffinityPolicy::None);
 
   /**
    * ManualExecutors are unbounded too.
@@ -9,6 +9,7 @@
 
 #include <folly/Range.h>
 #include <folly/Utility.h>
+#include <cstdint>
 
 namespace facebook {
 namespace eden {
@@ -44,7 +45,7 @@ constexpr bool isValidContinuation(
     const char* const end,
     size_t num,
     uint32_t& codepoint) {
-  if (begin + num - 1 > end) {
+  if (begin + num > end) {
     return false;
   }
 
@@ -58,6 +59,38 @@ constexpr bool isValidContinuation(
 
   return true;
 }
+
+/**
+ * Load 8 bytes as a little-endian word.
+ *
+ * This is written with shifts rather than memcpy so that it can be used in
+ * constant expressions, compilers turn it into a single load.
+ */
+constexpr uint64_t loadWord(const char* p) {
+  uint64_t word = 0;
+  for (size_t i = 0; i < 8; i++) {
+    word |= uint64_t{folly::to_unsigned(p[i])} << (8 * i);
+  }
+  return word;
+}
+
+constexpr uint64_t kLowBits = 0x0101010101010101;
+constexpr uint64_t kHighBits = 0x8080808080808080;
+
+/**
+ * Test if all the bytes of the word are ASCII characters.
+ */
+constexpr bool isAsciiWord(uint64_t word) {
+  return (word & kHighBits) == 0;
+}
+
+/**
+ * Test if any of the bytes of the word is equal to c.
+ */
+constexpr bool hasByte(uint64_t word, char c) {
+  auto v = word ^ (kLowBits * folly::to_unsigned(c));
+  return ((v - kLowBits) & ~v & kHighBits) != 0;
+}
 } // namespace detail
 
 /**
@@ -71,6 +104,12 @@ constexpr bool isValidUtf8(folly::StringPiece str) {
   const char* const end = str.end();
 
   while (begin != end) {
+    // Most strings are mostly ASCII, skip over it 8 bytes at a time.
+    if (end - begin >= 8 && detail::isAsciiWord(detail::loadWord(begin))) {
+      begin += 8;
+      continue;
+    }
+
     char first = *begin++;
     if (!detail::isBitSet(first, 7)) {
       // ASCII character, nothing to do.
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/WorkStealingExecutor.h"
+
+#include <fmt/format.h>
+#include <folly/ExceptionString.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+#include <algorithm>
+
+namespace facebook {
+namespace eden {
+
+namespace {
+/**
+ * The executor and the index of the worker running on this thread, if any.
+ */
+struct CurrentWorker {
+  const WorkStealingExecutor* executor{nullptr};
+  size_t index{0};
+};
+thread_local CurrentWorker currentWorker;
+} // namespace
+
+WorkStealingExecutor::WorkStealingExecutor(
+    size_t threadCount,
+    folly::StringPiece threadNamePrefix,
+    CpuAffinityPolicy affinity) {
+  threadCount = std::max<size_t>(threadCount, 1);
+  workers_.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  auto homeNode = getCurrentNumaNode();
+  threads_.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    auto name = fmt::format("{}{}", threadNamePrefix.str(), i);
+    threads_.emplace_back(
+        [this, i, affinity, homeNode, name = std::move(name)] {
+          folly::setThreadName(name);
+          bindCurrentThread(affinity, i, homeNode);
+          run(i);
+        });
+  }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  {
+    std::lock_guard<std::mutex> lock{idleLock_};
+    stopping_ = true;
+  }
+  idleCondition_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkStealingExecutor::add(folly::Func func) {
+  // Counted before being queued so that pendingTasks_ never underflows when
+  // a worker takes the task right away.
+  pendingTasks_.fetch_add(1);
+  if (currentWorker.executor == this) {
+    auto& worker = *workers_[currentWorker.index];
+    std::lock_guard<std::mutex> lock{worker.lock};
+    worker.tasks.push_back(std::move(func));
+  } else {
+    std::lock_guard<std::mutex> lock{sharedLock_};
+    sharedTasks_.push_back(std::move(func));
+  }
+
+  // Both counters are sequentially consistent: either this thread sees the
+  // worker going to sleep and wakes it up, or the worker sees the new task
+  // before it sleeps.
+  if (sleepingWorkers_.load() > 0) {
+    std::lock_guard<std::mutex> lock{idleLock_};
+    idleCondition_.notify_one();
+  }
+}
+
+folly::Func WorkStealingExecutor::popFront(
+    std::mutex& lock,
+    std::deque<folly::Func>& tasks) {
+  std::lock_guard<std::mutex> guard{lock};
+  if (tasks.empty()) {
+    return {};
+  }
+  auto task = std::move(tasks.front());
+  tasks.pop_front();
+  return task;
+}
+
+folly::Func WorkStealingExecutor::takeTask(size_t index) {
+  {
+    auto& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock{worker.lock};
+    if (!worker.tasks.empty()) {
+      auto task = std::move(worker.tasks.back());
+      worker.tasks.pop_back();
+      return task;
+    }
+  }
+
+  if (auto task = popFront(sharedLock_, sharedTasks_)) {
+    return task;
+  }
+
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    auto& victim = *workers_[(index + i) % workers_.size()];
+    if (auto task = popFront(victim.lock, victim.tasks)) {
+      return task;
+    }
+  }
+  return {};
+}
+
+void WorkStealingExecutor::run(size_t index) {
+  currentWorker = CurrentWorker{this, index};
+
+  while (true) {
+    if (auto task = takeTask(index)) {
+      pendingTasks_.fetch_sub(1);
+      try {
+        task();
+      } catch (const std::exception& ex) {
+        XLOG(ERR) << "WorkStealingExecutor task threw: "
+                  << folly::exceptionStr(ex);
+      }
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock{idleLock_};
+    sleepingWorkers_.fetch_add(1);
+    idleCondition_.wait(lock, [this] {
+      return pendingTasks_.load() > 0 || stopping_;
+    });
+    sleepingWorkers_.fetch_sub(1);
+    // Once stopping, a worker only exits when there is nothing left that it
+    // could take. Tasks still running on other workers may queue more, but
+    // those go to their own queues, and they will run them.
+    if (stopping_ && pendingTasks_.load() == 0) {
+      return;
+    }
+  }
+}
+
+} // namespace eden
+} // namespace facebook
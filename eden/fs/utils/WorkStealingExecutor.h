@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Executor.h>
+#include <folly/Range.h>
+#include <folly/lang/Align.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "eden/fs/utils/CpuAffinity.h"
+
+namespace facebook {
+namespace eden {
+
+/**
+ * A thread pool where each worker has its own queue of tasks.
+ *
+ * Diff, glob and checkout fan out into many small continuations that are
+ * queued from the worker threads themselves. With a single shared queue every
+ * one of them contends on the same lock. Here, a task added from a worker is
+ * pushed on that worker's own queue, and the worker runs its most recently
+ * added task first, which is also the one whose data is most likely still in
+ * its caches. Tasks added from other threads go to a shared queue. A worker
+ * with nothing to run takes from the shared queue, or steals the oldest task
+ * of another worker, so that large subtrees of work migrate to idle threads.
+ *
+ * Like the CPUThreadPoolExecutor used by UnboundedQueueExecutor, the queues
+ * are unbounded and add() never blocks beyond briefly taking a lock, and
+ * never runs the function inline. The queues are protected by one mutex per
+ * worker rather than being lock-free: the owner and thieves rarely contend,
+ * and it keeps the implementation simple.
+ *
+ * The destructor waits for all the queued tasks, including those they queue
+ * themselves, to complete.
+ */
+class WorkStealingExecutor : public folly::Executor {
+ public:
+  WorkStealingExecutor(
+      size_t threadCount,
+      folly::StringPiece threadNamePrefix,
+      CpuAffinityPolicy affinity = CpuAffinityPolicy::None);
+  ~WorkStealingExecutor() override;
+
+  WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+  WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+  void add(folly::Func func) override;
+
+  size_t getThreadCount() const {
+    return workers_.size();
+  }
+
+ private:
+  /**
+   * Workers are aligned to avoid false sharing between the locks of
+   * neighboring workers.
+   */
+  struct alignas(folly::hardware_destructive_interference_size) Worker {
+    std::mutex lock;
+    std::deque<folly::Func> tasks;
+  };
+
+  void run(size_t index);
+
+  /**
+   * Takes the next task for the worker index: the newest of its own tasks,
+   * then the oldest task of the shared queue, then the oldest task of another
+   * worker. Returns an empty function if there is no task.
+   */
+  folly::Func takeTask(size_t index);
+
+  static folly::Func popFront(std::mutex& lock, std::deque<folly::Func>& tasks);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  /**
+   * Tasks added from threads that are not workers of this executor.
+   */
+  std::mutex sharedLock_;
+  std::deque<folly::Func> sharedTasks_;
+
+  /**
+   * The number of tasks queued and not yet taken by a worker. Idle workers
+   * sleep on idleCondition_ until it is non zero.
+   */
+  std::atomic<size_t> pendingTasks_{0};
+  std::atomic<size_t> sleepingWorkers_{0};
+  std::mutex idleLock_;
+  std::condition_variable idleCondition_;
+  bool stopping_{false};
+
+  std::vector<std::thread> threads_;
+};
+
+} // namespace eden
+} // namespace facebook
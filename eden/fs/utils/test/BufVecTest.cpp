@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/BufVec.h"
+
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+
+TEST(BufVec, buffer) {
+  auto bufVec = BufVec{folly::IOBuf::copyBuffer("hello")};
+  EXPECT_FALSE(bufVec.isFile());
+  EXPECT_EQ(5, bufVec.size());
+  EXPECT_EQ("hello", bufVec->moveToFbString());
+}
+
+TEST(BufVec, fileRange) {
+  auto tmpFile = makeTempFile();
+  folly::StringPiece contents{"header:hello world"};
+  ASSERT_EQ(
+      contents.size(),
+      folly::writeFull(tmpFile.fd(), contents.data(), contents.size()));
+
+  auto bufVec = BufVec::fromFile(folly::File{tmpFile.fd()}.dup(), 7, 5);
+  EXPECT_TRUE(bufVec.isFile());
+  EXPECT_EQ(5, bufVec.size());
+  EXPECT_FALSE(bufVec.empty());
+  EXPECT_EQ(7, bufVec.getFileOffset());
+  EXPECT_EQ("hello", std::move(bufVec).toIOBuf()->moveToFbString());
+}
+
+TEST(BufVec, fileRangePastEndIsShort) {
+  auto tmpFile = makeTempFile();
+  folly::StringPiece contents{"abc"};
+  ASSERT_EQ(
+      contents.size(),
+      folly::writeFull(tmpFile.fd(), contents.data(), contents.size()));
+
+  auto bufVec = BufVec::fromFile(folly::File{tmpFile.fd()}.dup(), 1, 100);
+  EXPECT_EQ("bc", std::move(bufVec).toIOBuf()->moveToFbString());
+}
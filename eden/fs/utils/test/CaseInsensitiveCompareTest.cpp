@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/CaseInsensitiveCompare.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+int sign(int value) {
+  return (value > 0) - (value < 0);
+}
+
+int referenceCompare(folly::StringPiece a, folly::StringPiece b) {
+  auto lowerA = a.str();
+  auto lowerB = b.str();
+  for (auto& c : lowerA) {
+    c = detail::asciiToLower(c);
+  }
+  for (auto& c : lowerB) {
+    c = detail::asciiToLower(c);
+  }
+  return sign(lowerA.compare(lowerB));
+}
+} // namespace
+
+TEST(CaseInsensitiveCompare, equals) {
+  EXPECT_TRUE(equalsAsciiCaseInsensitive("", ""));
+  EXPECT_TRUE(equalsAsciiCaseInsensitive("foo", "FOO"));
+  EXPECT_TRUE(equalsAsciiCaseInsensitive(
+      "A Much Longer Path Component.txt", "a much longer path component.TXT"));
+  EXPECT_FALSE(equalsAsciiCaseInsensitive("foo", "fooo"));
+  EXPECT_FALSE(equalsAsciiCaseInsensitive("foo_bar", "foo bar"));
+  // '@' and '[' are adjacent to the upper case letters, '`' and '{' to the
+  // lower case ones.
+  EXPECT_FALSE(equalsAsciiCaseInsensitive("@[@[@[@[@[", "`{`{`{`{`{"));
+}
+
+TEST(CaseInsensitiveCompare, non_ascii_bytes_are_unchanged) {
+  // With their high bit cleared, 0xc1-0xc8 look like 'A'-'H' and 0xe1-0xe8
+  // like 'a'-'h'. They must not be folded together.
+  EXPECT_FALSE(equalsAsciiCaseInsensitive(
+      "\xc1\xc2\xc3\xc4\xc5\xc6\xc7\xc8", "\xe1\xe2\xe3\xe4\xe5\xe6\xe7\xe8"));
+  EXPECT_FALSE(equalsAsciiCaseInsensitive("x\xc1", "x\xe1"));
+}
+
+TEST(CaseInsensitiveCompare, matches_reference_ordering) {
+  std::vector<folly::StringPiece> names{
+      "",
+      "a",
+      "A",
+      "ab",
+      "aB_",
+      "Zebra",
+      "zebra_crossing_with_a_long_name",
+      "ZEBRA_CROSSING_WITH_A_LONG_NAME2",
+      "_underscore",
+      "[bracket",
+      "`tick",
+      "0123456789abcdef",
+      "0123456789ABCDEG",
+  };
+  for (auto a : names) {
+    for (auto b : names) {
+      EXPECT_EQ(referenceCompare(a, b), sign(compareAsciiCaseInsensitive(a, b)))
+          << "'" << a << "' vs '" << b << "'";
+    }
+  }
+}
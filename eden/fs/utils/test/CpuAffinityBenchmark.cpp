@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/CpuAffinity.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "eden/fs/benchharness/Bench.h"
+
+using namespace facebook::eden;
+
+namespace {
+constexpr size_t kThreadCount = 4;
+constexpr size_t kBufferWords = 8 * 1024 * 1024;
+// One word per cache line.
+constexpr size_t kStride = 8;
+
+std::atomic<size_t> nextWorker{0};
+
+/**
+ * Allocates a buffer from a thread bound to node, so that its pages are
+ * placed on that node by the first touch.
+ */
+std::unique_ptr<uint64_t[]> allocateOn(CpuAffinityPolicy policy, size_t node) {
+  std::unique_ptr<uint64_t[]> buffer;
+  std::thread{[&] {
+    bindCurrentThread(policy, 0, node);
+    buffer.reset(new uint64_t[kBufferWords]);
+    for (size_t i = 0; i < kBufferWords; ++i) {
+      buffer[i] = i;
+    }
+  }}.join();
+  return buffer;
+}
+
+/**
+ * Each thread walks its own buffer, much larger than the caches, like FUSE
+ * workers walking the inodes and buffers they allocated. On a machine with
+ * several NUMA nodes, node_local_buffers should beat remote_buffers by the
+ * cost of crossing the interconnect, and unbound threads land somewhere in
+ * between. On a single node, all three are the same.
+ */
+void walk_buffer(
+    benchmark::State& state,
+    CpuAffinityPolicy policy,
+    size_t bufferNodeOffset) {
+  auto node = nextWorker.fetch_add(1) % CpuTopology::get().getNodes().size();
+  bindCurrentThread(policy, 0, node);
+  auto buffer = allocateOn(policy, node + bufferNodeOffset);
+
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < kBufferWords; i += kStride) {
+      sum += buffer[i];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(
+      state.iterations() * kBufferWords / kStride * sizeof(uint64_t));
+}
+} // namespace
+
+BENCHMARK_CAPTURE(walk_buffer, unbound, CpuAffinityPolicy::None, 0)
+    ->Threads(kThreadCount)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(
+    walk_buffer,
+    node_local_buffers,
+    CpuAffinityPolicy::NodeLocal,
+    0)
+    ->Threads(kThreadCount)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(walk_buffer, remote_buffers, CpuAffinityPolicy::NodeLocal, 1)
+    ->Threads(kThreadCount)
+    ->UseRealTime();
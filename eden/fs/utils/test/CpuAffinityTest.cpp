@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/CpuAffinity.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+using Cpus = std::vector<size_t>;
+
+// Two nodes of four CPUs each, interleaved like on many dual-socket
+// machines.
+CpuTopology makeTopology() {
+  return CpuTopology{{{0, 2, 4, 6}, {1, 3, 5, 7}}};
+}
+} // namespace
+
+TEST(CpuAffinity, parses_cpu_lists) {
+  EXPECT_EQ(Cpus{}, parseCpuList(""));
+  EXPECT_EQ(Cpus{3}, parseCpuList("3"));
+  EXPECT_EQ((Cpus{0, 1, 2, 3, 8, 10, 11}), parseCpuList("0-3,8,10-11"));
+  EXPECT_EQ(std::nullopt, parseCpuList("3-1"));
+  EXPECT_EQ(std::nullopt, parseCpuList("0-"));
+  EXPECT_EQ(std::nullopt, parseCpuList("a"));
+  EXPECT_EQ(std::nullopt, parseCpuList("1,,2"));
+}
+
+TEST(CpuAffinity, parses_policy_names) {
+  EXPECT_EQ(CpuAffinityPolicy::None, parseCpuAffinityPolicy("none"));
+  EXPECT_EQ(CpuAffinityPolicy::Pin, parseCpuAffinityPolicy("Pin"));
+  EXPECT_EQ(CpuAffinityPolicy::NodeLocal, parseCpuAffinityPolicy("node-local"));
+  EXPECT_EQ(CpuAffinityPolicy::Spread, parseCpuAffinityPolicy("SPREAD"));
+  EXPECT_EQ(std::nullopt, parseCpuAffinityPolicy("numa"));
+  for (auto policy :
+       {CpuAffinityPolicy::None,
+        CpuAffinityPolicy::Pin,
+        CpuAffinityPolicy::NodeLocal,
+        CpuAffinityPolicy::Spread}) {
+    EXPECT_EQ(policy, parseCpuAffinityPolicy(toString(policy)));
+  }
+}
+
+TEST(CpuAffinity, empty_nodes_are_dropped) {
+  CpuTopology topology{{{}, {4, 5}, {}}};
+  ASSERT_EQ(1, topology.getNodes().size());
+  EXPECT_EQ(0, topology.getNodeOf(5));
+  EXPECT_EQ(1, CpuTopology{{}}.getNodes().size());
+}
+
+TEST(CpuAffinity, none_leaves_threads_alone) {
+  auto topology = makeTopology();
+  EXPECT_EQ(Cpus{}, topology.selectCpus(CpuAffinityPolicy::None, 0, 0));
+}
+
+TEST(CpuAffinity, pin_fills_the_home_node_first) {
+  auto topology = makeTopology();
+  EXPECT_EQ(1, topology.getNodeOf(3));
+  Cpus pinned;
+  for (size_t worker = 0; worker < 9; ++worker) {
+    auto cpus = topology.selectCpus(CpuAffinityPolicy::Pin, worker, 1);
+    ASSERT_EQ(1, cpus.size());
+    pinned.push_back(cpus[0]);
+  }
+  EXPECT_EQ((Cpus{1, 3, 5, 7, 0, 2, 4, 6, 1}), pinned);
+}
+
+TEST(CpuAffinity, node_local_uses_the_home_node) {
+  auto topology = makeTopology();
+  for (size_t worker = 0; worker < 4; ++worker) {
+    EXPECT_EQ(
+        (Cpus{0, 2, 4, 6}),
+        topology.selectCpus(CpuAffinityPolicy::NodeLocal, worker, 0));
+  }
+  // Out of range home nodes wrap around.
+  EXPECT_EQ(
+      (Cpus{1, 3, 5, 7}),
+      topology.selectCpus(CpuAffinityPolicy::NodeLocal, 0, 3));
+}
+
+TEST(CpuAffinity, spread_deals_threads_to_the_nodes) {
+  auto topology = makeTopology();
+  EXPECT_EQ(
+      (Cpus{1, 3, 5, 7}), topology.selectCpus(CpuAffinityPolicy::Spread, 0, 1));
+  EXPECT_EQ(
+      (Cpus{0, 2, 4, 6}), topology.selectCpus(CpuAffinityPolicy::Spread, 1, 1));
+  EXPECT_EQ(
+      (Cpus{1, 3, 5, 7}), topology.selectCpus(CpuAffinityPolicy::Spread, 2, 1));
+}
+
+TEST(CpuAffinity, the_detected_topology_has_cpus) {
+  const auto& topology = CpuTopology::get();
+  ASSERT_FALSE(topology.getNodes().empty());
+  for (const auto& cpus : topology.getNodes()) {
+    EXPECT_FALSE(cpus.empty());
+  }
+  EXPECT_LT(getCurrentNumaNode(), topology.getNodes().size());
+}
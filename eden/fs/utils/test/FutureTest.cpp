@@ -36,3 +36,19 @@ TEST(FutureTest, collectSafe_completes_after_last_exception_with_first_error) {
       std::string{"one"},
       result.result().exception().get_exception<std::runtime_error>()->what());
 }
+
+TEST(FutureTest, collectSafe_vector_completes_when_all_futures_do) {
+  Promise<int> p1;
+  Promise<int> p2;
+  std::vector<Future<int>> futures;
+  futures.push_back(p1.getFuture());
+  futures.push_back(p2.getFuture());
+  auto result = collectSafe(std::move(futures));
+  p2.setException(std::runtime_error{"two"});
+  EXPECT_FALSE(result.isReady());
+  p1.setException(std::runtime_error{"one"});
+  ASSERT_TRUE(result.isReady());
+  EXPECT_EQ(
+      std::string{"one"},
+      result.result().exception().get_exception<std::runtime_error>()->what());
+}
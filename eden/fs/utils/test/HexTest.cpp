@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/Hex.h"
+#include <folly/String.h>
+#include <folly/portability/GTest.h>
+#include <string>
+#include <vector>
+
+using namespace facebook::eden;
+
+namespace {
+std::string allBytes() {
+  std::string bytes;
+  for (int i = 0; i < 256; ++i) {
+    bytes.push_back(static_cast<char>(i));
+  }
+  return bytes;
+}
+
+std::string decode(folly::StringPiece hex) {
+  std::string bytes(hex.size() / 2, '\0');
+  if (!hexDecode(hex, reinterpret_cast<uint8_t*>(bytes.data()))) {
+    throw std::invalid_argument(hex.str());
+  }
+  return bytes;
+}
+} // namespace
+
+TEST(HexTest, encodeMatchesHexlify) {
+  auto bytes = allBytes();
+  // Every length, so that both the word-at-a-time and the byte-at-a-time
+  // paths get to encode every byte value.
+  for (size_t size = 0; size <= bytes.size(); ++size) {
+    auto input = folly::StringPiece{bytes}.subpiece(0, size);
+    EXPECT_EQ(folly::hexlify(input), hexEncode(folly::ByteRange{input}));
+  }
+  auto shifted = bytes.substr(3) + bytes.substr(0, 3);
+  EXPECT_EQ(folly::hexlify(shifted), hexEncode(folly::ByteRange{shifted}));
+}
+
+TEST(HexTest, decodeRoundTrips) {
+  auto bytes = allBytes();
+  for (size_t size = 0; size <= bytes.size(); ++size) {
+    auto input = bytes.substr(0, size);
+    EXPECT_EQ(input, decode(folly::hexlify(input)));
+  }
+}
+
+TEST(HexTest, decodeAcceptsBothCases) {
+  EXPECT_EQ(
+      "\xfa\xce\xb0\x0c\xde\xad\xbe\xef\x01", decode("FaCeB00cDEADbeef01"));
+  EXPECT_EQ("\xab\xcd\xef", decode("ABCDEF"));
+}
+
+TEST(HexTest, decodeRejectsInvalidDigitsAtEveryPosition) {
+  // Neighbours of the valid ranges, and characters that only become valid
+  // digits when their case is folded or their high bit is dropped.
+  const std::vector<char> invalid{
+      '\0', '\x10', '\x11', ' ',  '/',    ':',    '@',    'G',   '`',
+      'g',  'z',    '\x7f', '\x80', '\xb0', '\xc1', '\xe1', '\xff'};
+  // Three words and a byte decoded on its own.
+  std::string valid(26, 'a');
+  for (size_t position = 0; position < valid.size(); ++position) {
+    for (auto c : invalid) {
+      auto hex = valid;
+      hex[position] = c;
+      std::vector<uint8_t> out(hex.size() / 2);
+      EXPECT_FALSE(hexDecode(hex, out.data()))
+          << "character " << int(c) << " at " << position;
+      EXPECT_EQ(c, findInvalidHexDigit(hex));
+    }
+  }
+  EXPECT_EQ('\0', findInvalidHexDigit(valid));
+}
+
+TEST(HexTest, isConstexpr) {
+  constexpr auto decodeFirst = [](folly::StringPiece hex) {
+    uint8_t out[8] = {};
+    return hexDecode(hex, out) ? out[0] : 0;
+  };
+  static_assert(decodeFirst("fa000000000000ce") == 0xfa);
+  static_assert(decodeFirst("Fa") == 0xfa);
+  static_assert(decodeFirst("fa00000000000xce") == 0);
+}
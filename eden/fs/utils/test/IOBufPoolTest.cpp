@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/IOBufPool.h"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+
+using namespace facebook::eden;
+
+namespace {
+bool isPageAligned(const folly::IOBuf& buf) {
+  return reinterpret_cast<uintptr_t>(buf.data()) % IOBufPool::getPageSize() ==
+      0;
+}
+} // namespace
+
+TEST(IOBufPool, buffersArePageAlignedAndEmpty) {
+  IOBufPool pool{{1}, 4};
+  auto buf = pool.allocate(10);
+  EXPECT_EQ(0, buf->length());
+  EXPECT_EQ(IOBufPool::getPageSize(), buf->capacity());
+  EXPECT_TRUE(isPageAligned(*buf));
+
+  auto large = pool.allocate(IOBufPool::getPageSize() + 1);
+  EXPECT_EQ(2 * IOBufPool::getPageSize(), large->capacity());
+  EXPECT_TRUE(isPageAligned(*large));
+}
+
+TEST(IOBufPool, freedBuffersAreReused) {
+  IOBufPool pool{{1}, 4};
+  auto buf = pool.allocate(10);
+  auto* data = buf->data();
+  buf.reset();
+  EXPECT_EQ(1, pool.getStats().freeCount);
+
+  buf = pool.allocate(100);
+  EXPECT_EQ(data, buf->data());
+  auto stats = pool.getStats();
+  EXPECT_EQ(1, stats.reuseCount);
+  EXPECT_EQ(1, stats.allocationCount);
+  EXPECT_EQ(0, stats.freeCount);
+}
+
+TEST(IOBufPool, buffersAreRecycledWhenTheLastCloneIsFreed) {
+  IOBufPool pool{{1}, 4};
+  auto buf = pool.allocate(10);
+  auto clone = buf->clone();
+  buf.reset();
+  EXPECT_EQ(0, pool.getStats().freeCount);
+  clone.reset();
+  EXPECT_EQ(1, pool.getStats().freeCount);
+}
+
+TEST(IOBufPool, picksTheSmallestSizeClassThatFits) {
+  auto pageSize = IOBufPool::getPageSize();
+  IOBufPool pool{{4 * pageSize, pageSize}, 4};
+  EXPECT_EQ(pageSize, pool.allocate(1)->capacity());
+  EXPECT_EQ(4 * pageSize, pool.allocate(pageSize + 1)->capacity());
+  EXPECT_EQ(8 * pageSize, pool.allocate(8 * pageSize)->capacity());
+
+  // The buffer larger than every size class is not pooled.
+  EXPECT_EQ(2, pool.getStats().freeCount);
+}
+
+TEST(IOBufPool, keepsAtMostMaxFreeBuffers) {
+  IOBufPool pool{{1}, 2};
+  {
+    auto a = pool.allocate(1);
+    auto b = pool.allocate(1);
+    auto c = pool.allocate(1);
+  }
+  auto stats = pool.getStats();
+  EXPECT_EQ(2, stats.freeCount);
+  EXPECT_EQ(2 * IOBufPool::getPageSize(), stats.freeBytes);
+}
@@ -274,6 +274,32 @@ TEST(
   EXPECT_TRUE(run);
 }
 
+TEST(ImmediateFuture, SemiFuture_completed_after_wrapping_runs_inline) {
+  auto [promise, semi] = folly::makePromiseContract<int>();
+  auto imm = ImmediateFuture<int>{std::move(semi)};
+  EXPECT_FALSE(imm.isReady());
+  promise.setValue(10);
+  EXPECT_TRUE(imm.isReady());
+
+  bool run = false;
+  auto then = std::move(imm).thenValue([&](int x) {
+    run = true;
+    return ImmediateFuture<int>{x + 1};
+  });
+  EXPECT_TRUE(run);
+  EXPECT_TRUE(then.isReady());
+  EXPECT_EQ(11, std::move(then).get());
+}
+
+TEST(ImmediateFuture, SemiFuture_continuation_returning_ImmediateFuture) {
+  auto [promise, semi] = folly::makePromiseContract<int>();
+  auto then = ImmediateFuture<int>{std::move(semi)}.thenValue(
+      [](int x) { return ImmediateFuture<int>{x + 1}; });
+  EXPECT_FALSE(then.isReady());
+  promise.setValue(10);
+  EXPECT_EQ(11, std::move(then).get());
+}
+
 TEST(ImmediateFuture, collectAllImmediate) {
   std::vector<ImmediateFuture<int>> vec;
   vec.push_back(ImmediateFuture<int>{42});
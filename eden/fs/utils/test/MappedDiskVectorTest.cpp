@@ -66,6 +66,22 @@ TEST_F(MappedDiskVectorTest, grows_file) {
   EXPECT_GT(new_size, old_size);
 }
 
+TEST_F(MappedDiskVectorTest, reserve_grows_capacity_once) {
+  auto mdv = MappedDiskVector<U64>::open(mdvPath);
+  constexpr uint64_t N = 1000000;
+  mdv.reserve(N);
+  EXPECT_LE(N, mdv.capacity());
+
+  mdv.emplace_back(0ull);
+  auto* first = &mdv[0];
+  for (uint64_t i = 1; i < N; ++i) {
+    mdv.emplace_back(i);
+  }
+  // The file was not remapped.
+  EXPECT_EQ(first, &mdv[0]);
+  EXPECT_EQ(N - 1, mdv[N - 1]);
+}
+
 TEST_F(MappedDiskVectorTest, remembers_contents_on_reopen) {
   {
     auto mdv = MappedDiskVector<U64>::open(mdvPath);
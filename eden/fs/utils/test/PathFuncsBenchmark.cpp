@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/PathFuncs.h"
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+using namespace facebook::eden;
+
+namespace {
+
+/**
+ * File names with a length distribution typical of source repositories:
+ * mostly ASCII, between a few and a few tens of bytes.
+ */
+const std::vector<std::string>& getNames() {
+  static const std::vector<std::string> names = {
+      "src",
+      "README.md",
+      "BUCK",
+      "TreeInode.cpp",
+      "TreeInode.h",
+      "node_modules",
+      "__init__.py",
+      "CMakeLists.txt",
+      "index.js",
+      "ObjectStoreTest.cpp",
+      "test_checkout_with_conflicts.py",
+      "very_long_generated_file_name_for_thrift_types.h",
+      "r\xc3\xa9sum\xc3\xa9.txt",
+      ".gitignore",
+  };
+  return names;
+}
+
+void validate_path_component(benchmark::State& state) {
+  const auto& names = getNames();
+  size_t index = 0;
+  for (auto _ : state) {
+    PathComponentPiece piece{names[index]};
+    benchmark::DoNotOptimize(piece);
+    index = (index + 1) % names.size();
+  }
+}
+BENCHMARK(validate_path_component);
+
+void is_valid_utf8(benchmark::State& state) {
+  const auto& names = getNames();
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(isValidUtf8(names[index]));
+    index = (index + 1) % names.size();
+  }
+}
+BENCHMARK(is_valid_utf8);
+
+} // namespace
@@ -481,6 +481,13 @@ TEST(PathFuncs, InitializeFromIter) {
   // PathComponent in the initializer.
   RelativePath rel3{PathComponent("stored"), "notstored"_pc};
   EXPECT_EQ("stored/notstored", rel3.stringPiece());
+
+  RelativePath single{"single"_pc};
+  EXPECT_EQ("single", single.stringPiece());
+
+  std::vector<PathComponent> noComponents;
+  RelativePath empty{noComponents};
+  EXPECT_TRUE(empty.empty());
 }
 
 TEST(PathFuncs, Hash20) {
@@ -549,6 +556,30 @@ TEST(PathFuncs, PathComponent) {
   EXPECT_THROW_RE(PathComponent(".."), std::domain_error, "must not be \\.\\.");
 }
 
+TEST(PathFuncs, PathComponentInvalidCharacterAtAnyOffset) {
+  // Names are validated 8 bytes at a time, make sure invalid characters are
+  // found wherever they are.
+  for (size_t offset = 0; offset < 20; ++offset) {
+    std::string name(20, 'a');
+    EXPECT_NO_THROW(PathComponent{name});
+
+    name[offset] = '/';
+    EXPECT_THROW_RE(
+        PathComponent(name),
+        std::domain_error,
+        "containing a directory separator");
+
+    name[offset] = '\0';
+    EXPECT_THROW_RE(PathComponent(name), std::domain_error, "nul byte");
+
+    name[offset] = '\xff';
+    EXPECT_THROW_RE(
+        PathComponent(name), std::domain_error, "non valid UTF8 data");
+  }
+
+  EXPECT_NO_THROW(PathComponent{"\xc3\xa9t\xc3\xa9 long name"});
+}
+
 TEST(PathFuncs, RelativePath) {
   RelativePath emptyRel;
   EXPECT_EQ("", emptyRel.stringPiece());
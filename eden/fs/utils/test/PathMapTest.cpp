@@ -240,3 +240,78 @@ TEST(PathMap, swap) {
   EXPECT_EQ(0, b.size()) << "b now has 0 elements";
   EXPECT_EQ("foo", a.at("foo"_pc));
 }
+
+TEST(PathMap, caseInSensitiveManyEntries) {
+  PathMap<int> map(CaseSensitivity::Insensitive);
+  // Insert out of order and with mixed case so the sorted order and the
+  // case-folded order differ.
+  std::vector<std::string> names{
+      "Zeta", "alpha", "Beta", "gamma", "DELTA", "epsilon", "_under", "Ab"};
+  for (size_t i = 0; i < names.size(); ++i) {
+    EXPECT_TRUE(map.emplace(PathComponentPiece{names[i]}, i).second);
+  }
+  EXPECT_EQ(map.size(), names.size());
+
+  for (size_t i = 0; i < names.size(); ++i) {
+    auto upper = names[i];
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    auto lower = names[i];
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    EXPECT_EQ(map.at(PathComponentPiece{upper}), i) << upper;
+    EXPECT_EQ(map.at(PathComponentPiece{lower}), i) << lower;
+    EXPECT_FALSE(map.emplace(PathComponentPiece{upper}, 100).second);
+  }
+
+  // Erasing by iterator keeps the case-folded index in sync.
+  map.erase(map.find("beta"_pc));
+  EXPECT_EQ(map.find("BETA"_pc), map.end());
+  EXPECT_EQ(map.at("ZETA"_pc), 0);
+  EXPECT_EQ(map.at("ab"_pc), 7);
+
+  map.erase(map.begin(), map.begin() + 2);
+  EXPECT_EQ(map.size(), names.size() - 3);
+  for (const auto& entry : map) {
+    EXPECT_NE(map.find(entry.first), map.end());
+  }
+
+  map.clear();
+  EXPECT_EQ(map.find("alpha"_pc), map.end());
+  map["ALPHA"_pc] = 1;
+  EXPECT_EQ(map.at("alpha"_pc), 1);
+}
+
+TEST(PathMap, caseInSensitiveSwapKeepsIndex) {
+  PathMap<int> insensitive(CaseSensitivity::Insensitive);
+  insensitive["Foo"_pc] = 1;
+  PathMap<int> sensitive(CaseSensitivity::Sensitive);
+  sensitive["Bar"_pc] = 2;
+
+  insensitive.swap(sensitive);
+  EXPECT_EQ(sensitive.at("FOO"_pc), 1);
+  EXPECT_EQ(insensitive.find("BAR"_pc), insensitive.end());
+}
+
+TEST(PathMap, reserveAvoidsRegrowing) {
+  for (auto caseSensitive :
+       {CaseSensitivity::Sensitive, CaseSensitivity::Insensitive}) {
+    PathMap<int> map(caseSensitive);
+    map.reserve(3);
+    auto reserved = map.capacity();
+    map.emplace("a"_pc, 1);
+    map.emplace("b"_pc, 2);
+    map.emplace("c"_pc, 3);
+    EXPECT_EQ(3, map.size());
+    EXPECT_EQ(reserved, map.capacity());
+    EXPECT_EQ(2, map.at("b"_pc));
+  }
+
+  PathMap<int> insensitive(CaseSensitivity::Insensitive);
+  insensitive.reserve(3);
+  insensitive.emplace("b"_pc, 2);
+  insensitive.emplace("c"_pc, 3);
+  // An insert before the end still keeps the case-folded index in sync.
+  insensitive.emplace("A"_pc, 1);
+  EXPECT_EQ(1, insensitive.at("a"_pc));
+  EXPECT_EQ(2, insensitive.at("B"_pc));
+  EXPECT_EQ(3, insensitive.at("C"_pc));
+}
@@ -172,4 +172,33 @@ TEST(proc_util, noProcSmapsNoThrow) {
   EXPECT_EQ(privateBytes, 0);
 }
 
+TEST(proc_util, parsePressureSomeAvg10) {
+  EXPECT_EQ(
+      12.5,
+      proc_util::parsePressureSomeAvg10(
+          "some avg10=12.50 avg60=3.00 avg300=1.00 total=12345\n"
+          "full avg10=1.00 avg60=0.50 avg300=0.10 total=678\n"));
+  EXPECT_EQ(
+      0.0,
+      proc_util::parsePressureSomeAvg10(
+          "some avg10=0.00 avg60=0.00 avg300=0.00 total=0"));
+  EXPECT_EQ(std::nullopt, proc_util::parsePressureSomeAvg10(""));
+  EXPECT_EQ(
+      std::nullopt, proc_util::parsePressureSomeAvg10("some avg10=bogus"));
+}
+
+TEST(proc_util, parseCgroupV2Path) {
+  EXPECT_EQ(
+      "/system.slice/edenfs.service",
+      proc_util::parseCgroupV2Path("0::/system.slice/edenfs.service\n"));
+  EXPECT_EQ(
+      "/user.slice",
+      proc_util::parseCgroupV2Path(
+          "12:memory:/user.slice\n1:name=systemd:/\n0::/user.slice\n"));
+  // Processes only in cgroup v1 hierarchies have no "0::" line.
+  EXPECT_EQ(
+      std::nullopt,
+      proc_util::parseCgroupV2Path("4:memory:/user.slice\n1:cpu:/\n"));
+}
+
 #endif
@@ -52,3 +52,19 @@ TEST(ProcessNameCache, addFromMultipleThreads) {
   }
   EXPECT_EQ(1, results.size());
 }
+
+TEST(ProcessNameCache, repeatedAndCollidingPidsAreAllAdded) {
+  ProcessNameCache processNameCache;
+  // Pids beyond the first few collide in each thread's recent pid filter.
+  auto base = getpid();
+  for (int round = 0; round < 2; ++round) {
+    for (pid_t pid = base; pid < base + 32; ++pid) {
+      processNameCache.add(pid);
+      processNameCache.add(pid);
+    }
+  }
+
+  auto results = processNameCache.getAllProcessNames();
+  EXPECT_EQ(32, results.size());
+  EXPECT_NE("", results[base]);
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/SlabAllocator.h"
+
+#include <folly/portability/GTest.h>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace facebook::eden;
+
+TEST(SlabAllocator, blocks_are_distinct_and_aligned) {
+  SlabAllocator allocator{24, 4};
+  std::set<void*> blocks;
+  for (int i = 0; i < 10; ++i) {
+    auto* block = allocator.allocate();
+    EXPECT_EQ(
+        0, reinterpret_cast<uintptr_t>(block) % alignof(std::max_align_t));
+    memset(block, 0xff, allocator.getObjectSize());
+    EXPECT_TRUE(blocks.insert(block).second);
+  }
+
+  auto stats = allocator.getStats();
+  EXPECT_EQ(10, stats.objectCount);
+  EXPECT_EQ(3, stats.slabCount);
+  EXPECT_LT(10 * 24, stats.totalBytes);
+
+  for (auto* block : blocks) {
+    allocator.deallocate(block);
+  }
+  EXPECT_EQ(0, allocator.getStats().objectCount);
+}
+
+TEST(SlabAllocator, freed_blocks_are_reused) {
+  SlabAllocator allocator{32, 4};
+  auto* a = allocator.allocate();
+  auto* b = allocator.allocate();
+  allocator.deallocate(a);
+  EXPECT_EQ(a, allocator.allocate());
+  allocator.deallocate(a);
+  allocator.deallocate(b);
+}
+
+TEST(SlabAllocator, empty_slabs_are_freed_except_one) {
+  SlabAllocator allocator{32, 2};
+  std::vector<void*> blocks;
+  for (int i = 0; i < 8; ++i) {
+    blocks.push_back(allocator.allocate());
+  }
+  EXPECT_EQ(4, allocator.getStats().slabCount);
+
+  for (auto* block : blocks) {
+    allocator.deallocate(block);
+  }
+  auto stats = allocator.getStats();
+  EXPECT_EQ(0, stats.objectCount);
+  EXPECT_EQ(1, stats.slabCount);
+
+  // The kept slab is used again before a new one is allocated.
+  auto* block = allocator.allocate();
+  EXPECT_EQ(1, allocator.getStats().slabCount);
+  allocator.deallocate(block);
+}
+
+TEST(SlabAllocator, partially_used_slabs_are_filled_first) {
+  SlabAllocator allocator{32, 2};
+  std::vector<void*> blocks;
+  for (int i = 0; i < 6; ++i) {
+    blocks.push_back(allocator.allocate());
+  }
+  // Free one block from each of the three full slabs.
+  allocator.deallocate(blocks[0]);
+  allocator.deallocate(blocks[2]);
+  allocator.deallocate(blocks[4]);
+
+  for (int i = 0; i < 3; ++i) {
+    blocks[i * 2] = allocator.allocate();
+  }
+  EXPECT_EQ(3, allocator.getStats().slabCount);
+
+  for (auto* block : blocks) {
+    allocator.deallocate(block);
+  }
+}
+
+TEST(SlabAllocator, concurrent_allocations) {
+  SlabAllocator allocator{64, 16};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&allocator] {
+      std::vector<void*> blocks;
+      for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < 50; ++i) {
+          blocks.push_back(allocator.allocate());
+        }
+        for (auto* block : blocks) {
+          allocator.deallocate(block);
+        }
+        blocks.clear();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto stats = allocator.getStats();
+  EXPECT_EQ(0, stats.objectCount);
+  EXPECT_EQ(1, stats.slabCount);
+}
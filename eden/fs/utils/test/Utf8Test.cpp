@@ -35,6 +35,20 @@ TEST(Utf8Test, isValidUtf8) {
   EXPECT_FALSE(isValidUtf8("\xA0prefix\xB0"));
 }
 
+TEST(Utf8Test, isValidUtf8AfterAsciiWords) {
+  // ASCII is skipped 8 bytes at a time, make sure what follows it, or
+  // straddles two words, is still validated.
+  for (size_t prefix = 0; prefix < 17; ++prefix) {
+    std::string ascii(prefix, 'a');
+    EXPECT_TRUE(isValidUtf8(ascii));
+    EXPECT_TRUE(isValidUtf8(ascii + "\xc3\xa9" + ascii));
+    EXPECT_TRUE(isValidUtf8(ascii + "\xF0\x90\x8D\x88" + ascii));
+    EXPECT_FALSE(isValidUtf8(ascii + "\xff" + ascii));
+    EXPECT_FALSE(isValidUtf8(ascii + "\xc3"));
+    EXPECT_FALSE(isValidUtf8(ascii + "\xF0\x82\x82\xAC" + ascii));
+  }
+}
+
 TEST(Utf8String, ensureValidUtf8) {
   for (auto str : kValidStrings) {
     EXPECT_EQ(str, ensureValidUtf8(str));
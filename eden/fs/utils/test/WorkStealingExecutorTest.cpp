@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/WorkStealingExecutor.h"
+
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <atomic>
+#include <set>
+#include <thread>
+
+using namespace facebook::eden;
+
+TEST(WorkStealingExecutor, runsTasksAddedFromOtherThreads) {
+  WorkStealingExecutor executor{4, "Test"};
+  constexpr int kTasks = 1000;
+  std::atomic<int> done{0};
+  folly::Baton<> baton;
+  for (int i = 0; i < kTasks; ++i) {
+    executor.add([&] {
+      if (done.fetch_add(1) + 1 == kTasks) {
+        baton.post();
+      }
+    });
+  }
+  baton.wait();
+  EXPECT_EQ(kTasks, done.load());
+}
+
+TEST(WorkStealingExecutor, runsTasksAddedFromWorkers) {
+  WorkStealingExecutor executor{4, "Test"};
+  constexpr int kChildren = 100;
+  std::atomic<int> done{0};
+  folly::Baton<> baton;
+  executor.add([&] {
+    for (int i = 0; i < kChildren; ++i) {
+      executor.add([&] {
+        for (int j = 0; j < kChildren; ++j) {
+          executor.add([&] {
+            if (done.fetch_add(1) + 1 == kChildren * kChildren) {
+              baton.post();
+            }
+          });
+        }
+      });
+    }
+  });
+  baton.wait();
+  EXPECT_EQ(kChildren * kChildren, done.load());
+}
+
+TEST(WorkStealingExecutor, idleWorkersStealTasks) {
+  constexpr size_t kThreads = 4;
+  WorkStealingExecutor executor{kThreads, "Test"};
+  std::mutex lock;
+  std::set<std::thread::id> threads;
+  std::atomic<size_t> waiting{0};
+  folly::Baton<> baton;
+  // All the tasks are queued by one worker on its own queue, and each blocks
+  // until one runs on every thread: this only completes if the others steal.
+  executor.add([&] {
+    for (size_t i = 0; i < kThreads; ++i) {
+      executor.add([&] {
+        {
+          std::lock_guard<std::mutex> guard{lock};
+          threads.insert(std::this_thread::get_id());
+        }
+        if (waiting.fetch_add(1) + 1 == kThreads) {
+          baton.post();
+        }
+        while (waiting.load() < kThreads) {
+          std::this_thread::yield();
+        }
+      });
+    }
+  });
+  baton.wait();
+  std::lock_guard<std::mutex> guard{lock};
+  EXPECT_EQ(kThreads, threads.size());
+}
+
+TEST(WorkStealingExecutor, destructorWaitsForTasks) {
+  std::atomic<int> done{0};
+  {
+    WorkStealingExecutor executor{2, "Test"};
+    for (int i = 0; i < 10; ++i) {
+      executor.add([&] {
+        executor.add([&] { done.fetch_add(1); });
+        done.fetch_add(1);
+      });
+    }
+  }
+  EXPECT_EQ(20, done.load());
+}
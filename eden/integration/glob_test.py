@@ -240,6 +240,23 @@ class GlobTest(testcase.EdenRepoTest):
             search_root=b"java/com",
         )
 
+    def test_search_root_does_not_load_unmaterialized_directories(self) -> None:
+        self.assert_glob(
+            ["**/*.java"],
+            expected_matches=[
+                b"example/Example.java",
+                b"example/foo/Foo.java",
+                b"example/foo/bar/Bar.java",
+                b"example/foo/bar/baz/Baz.java",
+            ],
+            search_root=b"java/com",
+        )
+
+        result = self.client.debugInodeStatus(self.mount_path_bytes, b"", flags=0)
+        root = next(item for item in result if item.path == b"")
+        java = next(entry for entry in root.entries if entry.name == b"java")
+        self.assertFalse(java.loaded)
+
     def test_search_root_with_specified_commits(self) -> None:
         self.assert_glob(
             ["**/*.java"],
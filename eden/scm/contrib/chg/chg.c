@@ -39,6 +39,7 @@ struct cmdserveropts {
   char sockname[PATH_MAX];
   char initsockname[PATH_MAX];
   char redirectsockname[PATH_MAX];
+  char lockname[PATH_MAX];
 };
 
 static void initcmdserveropts(struct cmdserveropts* opts) {
@@ -118,6 +119,10 @@ static void setcmdserveropts(struct cmdserveropts* opts) {
       (unsigned)getpid());
   if (r < 0 || (size_t)r >= sizeof(opts->initsockname))
     abortmsg("too long TMPDIR or CHGSOCKNAME (r = %d)", r);
+  r = snprintf(
+      opts->lockname, sizeof(opts->lockname), "%s.lock", opts->sockname);
+  if (r < 0 || (size_t)r >= sizeof(opts->lockname))
+    abortmsg("too long TMPDIR or CHGSOCKNAME (r = %d)", r);
 }
 
 static const char* gethgcmd(void) {
@@ -210,6 +215,39 @@ cleanup:
   return NULL;
 }
 
+/*
+ * Take the lock held while starting a cmdserver, waiting for any other
+ * client holding it. Return the locked fd, or -1 if the lock file cannot be
+ * used, in which case the server is started without it.
+ *
+ * Without the lock, a burst of clients finding no server would each start
+ * one, all paying the full startup cost. All but the last to rename its
+ * socket then exit. With it, the clients that waited connect to the server
+ * started by the first one.
+ */
+static int lockcmdserverstart(const struct cmdserveropts* opts) {
+  int fd = open(opts->lockname, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    debugmsg("cannot open %s (errno = %d)", opts->lockname, errno);
+    return -1;
+  }
+  while (flock(fd, LOCK_EX) < 0) {
+    if (errno != EINTR) {
+      debugmsg("cannot lock %s (errno = %d)", opts->lockname, errno);
+      close(fd);
+      return -1;
+    }
+  }
+  return fd;
+}
+
+static double elapsedsec(const struct timespec* start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)(now.tv_sec - start->tv_sec) +
+      (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
 /* Connect to a cmdserver. Will start a new server on demand. */
 static hgclient_t* connectcmdserver(struct cmdserveropts* opts) {
   const char* sockname =
@@ -226,6 +264,21 @@ static hgclient_t* connectcmdserver(struct cmdserveropts* opts) {
   if (sockname == opts->redirectsockname)
     unlink(opts->sockname);
 
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  int lockfd = lockcmdserverstart(opts);
+  if (lockfd >= 0) {
+    /* another client may have started the server while we waited */
+    hgc = hgc_open(opts->sockname);
+    if (hgc) {
+      debugmsg(
+          "connected to cmdserver started by another client after %.3fs",
+          elapsedsec(&start));
+      close(lockfd);
+      return hgc;
+    }
+  }
+
   debugmsg("start cmdserver at %s", opts->initsockname);
 
   pid_t pid = fork();
@@ -237,6 +290,9 @@ static hgclient_t* connectcmdserver(struct cmdserveropts* opts) {
     hgc = retryconnectcmdserver(opts, pid);
   }
 
+  debugmsg("cmdserver started in %.3fs", elapsedsec(&start));
+  if (lockfd >= 0)
+    close(lockfd);
   return hgc;
 }
 
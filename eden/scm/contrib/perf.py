@@ -44,6 +44,8 @@ from edenscm.mercurial import (
     cmdutil,
     commands,
     copies,
+    dagop,
+    encoding,
     error,
     extensions,
     manifest,
@@ -541,6 +543,28 @@ def perfancestorset(ui, repo, revset, **opts):
     fm.end()
 
 
+@command(
+    "perfreachableroots",
+    [("", "path", False, "also compute the revisions between roots and heads")]
+    + formatteropts,
+    "ROOTS HEADS",
+)
+def perfreachableroots(ui, repo, roots, heads, path=False, **opts):
+    """benchmark finding the roots reachable from heads
+
+    This is the walk behind revsets like ROOTS::HEADS. Use roots far from the
+    heads of a large repository to compare walks over the whole changelog."""
+    timer, fm = gettimer(ui, opts)
+    roots = repo.revs(roots)
+    heads = repo.revs(heads)
+
+    def d():
+        len(dagop.reachableroots(repo, roots, heads, includepath=path))
+
+    timer(d)
+    fm.end()
+
+
 @command("perfbookmarks", formatteropts)
 def perfbookmarks(ui, repo, **opts):
     """benchmark parsing bookmarks from disk to memory"""
@@ -855,6 +879,27 @@ def perfindex(ui, repo, **opts):
     fm.end()
 
 
+@command(
+    "perfjsonescape",
+    [("", "paranoid", False, "also escape non-ASCII and HTML characters")]
+    + formatteropts,
+)
+def perfjsonescape(ui, repo, paranoid=False, **opts):
+    """benchmark JSON-escaping the files of the working copy parent
+
+    This is what -Tjson does for each path it prints."""
+    timer, fm = gettimer(ui, opts)
+    paths = list(repo["."].manifest())
+    jsonescape = encoding.jsonescape
+
+    def d():
+        for path in paths:
+            jsonescape(path, paranoid=paranoid)
+
+    timer(d)
+    fm.end()
+
+
 @command("perfstartup", formatteropts)
 def perfstartup(ui, repo, **opts):
     timer, fm = gettimer(ui, opts)
@@ -1019,13 +1064,19 @@ def perffncachewrite(ui, repo, **opts):
     fm.end()
 
 
-@command("perffncacheencode", formatteropts)
-def perffncacheencode(ui, repo, **opts):
+@command(
+    "perffncacheencode",
+    [("", "many", False, "encode all the entries in one call")] + formatteropts,
+)
+def perffncacheencode(ui, repo, many=False, **opts):
     timer, fm = gettimer(ui, opts)
     s = repo.store
     s.fncache._load()
 
     def d():
+        if many:
+            s.encodemany(s.fncache.entries)
+            return
         for p in s.fncache.entries:
             s.encode(p)
 
@@ -1056,6 +1107,30 @@ def perfdiffwd(ui, repo, **opts):
     fm.end()
 
 
+@command(
+    "perfbdiff",
+    [("", "xdiff", False, "use xdiff instead of bdiff")] + formatteropts,
+    "FILE1 FILE2",
+)
+def perfbdiff(ui, repo, file1, file2, xdiff=False, **opts):
+    """benchmark finding the matching lines of two files
+
+    Large files, like generated sources of several megabytes, show the time
+    spent splitting and hashing lines."""
+    timer, fm = gettimer(ui, opts)
+    with open(file1, "rb") as f:
+        a = f.read()
+    with open(file2, "rb") as f:
+        b = f.read()
+    if xdiff:
+        from edenscmnative import xdiff as diffmod
+    else:
+        from edenscmnative import bdiff as diffmod
+
+    timer(lambda: diffmod.blocks(a, b))
+    fm.end()
+
+
 @command(
     "perfrevset",
     [
@@ -24,53 +24,58 @@
 #include "eden/scm/edenscm/mercurial/bitmanipulation.h"
 #include "eden/scm/edenscm/mercurial/compat.h"
 
-/* Hash implementation from diffutils */
-#define ROL(v, n) ((v) << (n) | (v) >> (sizeof(v) * CHAR_BIT - (n)))
-#define HASH(h, c) ((c) + ROL(h, 7))
-
 struct pos {
   int pos, len;
 };
 
+/*
+ * Hash a line a word at a time. The hashes only need to agree between lines
+ * of the same process, so unaligned native-endian loads are fine.
+ */
+static inline unsigned hashline(const char* p, size_t len) {
+  const uint64_t k = 0x9e3779b97f4a7c15ULL;
+  uint64_t hash = len * k;
+  uint64_t w;
+
+  for (; len >= sizeof(w); p += sizeof(w), len -= sizeof(w)) {
+    memcpy(&w, p, sizeof(w));
+    hash = (hash ^ w) * k;
+    hash ^= hash >> 32;
+  }
+  if (len) {
+    w = 0;
+    memcpy(&w, p, len);
+    hash = (hash ^ w) * k;
+    hash ^= hash >> 32;
+  }
+  return (unsigned)hash;
+}
+
 int bdiff_splitlines(const char* a, ssize_t len, struct bdiff_line** lr) {
-  unsigned hash;
   int i;
-  const char *p, *b = a;
-  const char* const plast = a + len - 1;
+  const char *p, *b;
+  const char* const end = a + len;
+  const char* const plast = end - 1;
   struct bdiff_line* l;
 
-  /* count the lines */
+  /* count the lines, memchr scans a vector at a time */
   i = 1; /* extra line for sentinel */
-  for (p = a; p < plast; p++)
-    if (*p == '\n')
+  if (len > 0) {
+    i++; /* the last line, with or without a newline */
+    for (p = a; (p = memchr(p, '\n', plast - p)) != NULL; p++)
       i++;
-  if (p == plast)
-    i++;
+  }
 
   *lr = l = (struct bdiff_line*)malloc(sizeof(struct bdiff_line) * i);
   if (!l)
     return -1;
 
   /* build the line array and calculate hashes */
-  hash = 0;
-  for (p = a; p < plast; p++) {
-    hash = HASH(hash, *p);
-
-    if (*p == '\n') {
-      l->hash = hash;
-      hash = 0;
-      l->len = p - b + 1;
-      l->l = b;
-      l->n = INT_MAX;
-      l++;
-      b = p + 1;
-    }
-  }
-
-  if (p == plast) {
-    hash = HASH(hash, *p);
-    l->hash = hash;
-    l->len = p - b + 1;
+  for (b = a; b < end; b = p) {
+    const char* nl = memchr(b, '\n', plast - b);
+    p = nl ? nl + 1 : end;
+    l->hash = hashline(b, p - b);
+    l->len = p - b;
     l->l = b;
     l->n = INT_MAX;
     l++;
@@ -123,6 +123,31 @@ static const char hexchartable[16] = {
     'f',
 };
 
+/*
+ * Word-at-a-time helpers. Strings are mostly made of bytes that need no
+ * work, so the loops below test 8 bytes at once and only look at single
+ * bytes in words that contain one that needs it.
+ */
+static const uint64_t byteones = 0x0101010101010101ULL;
+static const uint64_t bytehighs = 0x8080808080808080ULL;
+
+static inline uint64_t loadword(const char* p) {
+  uint64_t w;
+  memcpy(&w, p, sizeof(w));
+  return w;
+}
+
+/* Nonzero if a byte of w is less than n, for n <= 128. */
+static inline uint64_t wordhasless(uint64_t w, uint8_t n) {
+  return (w - byteones * n) & ~w & bytehighs;
+}
+
+/* Nonzero if a byte of w is c. */
+static inline uint64_t wordhasbyte(uint64_t w, uint8_t c) {
+  uint64_t x = w ^ (byteones * c);
+  return (x - byteones) & ~x & bytehighs;
+}
+
 /*
  * Turn a hex-encoded string into binary.
  */
@@ -174,6 +199,7 @@ static inline PyObject* _asciitransform(
     const char table[128],
     PyObject* fallback_fn) {
   char *str, *newstr;
+  char first;
   Py_ssize_t i, len;
   PyObject* newobj = NULL;
   PyObject* ret = NULL;
@@ -187,8 +213,26 @@ static inline PyObject* _asciitransform(
 
   newstr = PyBytes_AS_STRING(newobj);
 
+  /* The tables only change the case of the letters starting at first. */
+  first = table['A'] != 'A' ? 'A' : 'a';
+
   for (i = 0; i < len; i++) {
-    char c = str[i];
+    char c;
+    if (len - i >= 8) {
+      uint64_t w = loadword(str + i);
+      if (!(w & bytehighs)) {
+        /* Bytes are below 0x80, so these sums don't carry across bytes. The
+         * high bit of a byte of ge is set from first, and of gt past the last
+         * letter. */
+        uint64_t ge = w + byteones * (0x80 - first);
+        uint64_t gt = w + byteones * (0x80 - first - 26);
+        w ^= (ge & ~gt & bytehighs) >> 2;
+        memcpy(newstr + i, &w, sizeof(w));
+        i += 7;
+        continue;
+      }
+    }
+    c = str[i];
     if (c & 0x80) {
       if (fallback_fn != NULL) {
         ret = PyObject_CallFunctionObjArgs(fallback_fn, str_obj, NULL);
@@ -296,6 +340,17 @@ quit:
   return NULL;
 }
 
+/* whether none of the 8 bytes at p needs escaping */
+static inline bool jsonsafeword(const char* p, bool paranoid) {
+  uint64_t w = loadword(p);
+  if (wordhasless(w, 0x20) | wordhasbyte(w, '"') | wordhasbyte(w, '\\') |
+      wordhasbyte(w, 0x7f))
+    return false;
+  if (paranoid)
+    return !(w & bytehighs) && !(wordhasbyte(w, '<') | wordhasbyte(w, '>'));
+  return true;
+}
+
 /* calculate length of JSON-escaped string; returns -1 if unsupported */
 static Py_ssize_t
 jsonescapelen(const char* buf, Py_ssize_t len, bool paranoid) {
@@ -304,7 +359,13 @@ jsonescapelen(const char* buf, Py_ssize_t len, bool paranoid) {
   if (paranoid) {
     /* don't want to process multi-byte escapes in C */
     for (i = 0; i < len; i++) {
-      char c = buf[i];
+      char c;
+      if (len - i >= 8 && jsonsafeword(buf + i, true)) {
+        esclen += 8;
+        i += 7;
+        continue;
+      }
+      c = buf[i];
       if (c & 0x80) {
         PyErr_SetString(PyExc_ValueError, "cannot process non-ascii str");
         return -1;
@@ -317,7 +378,13 @@ jsonescapelen(const char* buf, Py_ssize_t len, bool paranoid) {
     }
   } else {
     for (i = 0; i < len; i++) {
-      char c = buf[i];
+      char c;
+      if (len - i >= 8 && jsonsafeword(buf + i, false)) {
+        esclen += 8;
+        i += 7;
+        continue;
+      }
+      c = buf[i];
       esclen += jsonlentable[(unsigned char)c];
       if (esclen < 0) {
         PyErr_SetString(PyExc_MemoryError, "overflow in jsonescapelen");
@@ -362,8 +429,17 @@ static void encodejsonescape(
   Py_ssize_t i, j;
 
   for (i = 0, j = 0; i < origlen; i++) {
-    char c = origbuf[i];
-    uint8_t l = lentable[(unsigned char)c];
+    char c;
+    uint8_t l;
+    if (origlen - i >= 8 && jsonsafeword(origbuf + i, paranoid)) {
+      assert(j + 8 <= esclen);
+      memcpy(escbuf + j, origbuf + i, 8);
+      i += 7;
+      j += 8;
+      continue;
+    }
+    c = origbuf[i];
+    l = lentable[(unsigned char)c];
     assert(j + l <= esclen);
     switch (l) {
       case 1:
@@ -23,7 +23,11 @@
 #include "eden/scm/edenscm/mercurial/cext/charencode.h"
 #include "eden/scm/edenscm/mercurial/cext/util.h"
 
-#define DEFAULT_LINES 100000
+/* The shortest possible line: a one byte path, NUL, 40 hex digits and a
+ * newline. The line index is sized for a manifest made only of those, so
+ * that parsing never has to grow it. */
+#define MIN_LINE_LEN 43
+#define MIN_LINES 64
 
 typedef struct {
 #ifdef IS_PY3K
@@ -160,8 +164,8 @@ static int lazymanifest_init(lazymanifest* self, PyObject* args) {
     return -1;
   self->pydata = pydata;
   Py_INCREF(self->pydata);
-  Py_BEGIN_ALLOW_THREADS self->lines = malloc(DEFAULT_LINES * sizeof(line));
-  self->maxlines = DEFAULT_LINES;
+  Py_BEGIN_ALLOW_THREADS self->maxlines = (int)(len / MIN_LINE_LEN) + MIN_LINES;
+  self->lines = malloc(self->maxlines * sizeof(line));
   self->numlines = 0;
   if (!self->lines)
     ret = MANIFEST_OOM;
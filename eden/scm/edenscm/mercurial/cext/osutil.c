@@ -28,6 +28,7 @@
 #include <windows.h>
 #else
 #include <dirent.h>
+#include <pthread.h>
 #include <signal.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
@@ -749,11 +750,73 @@ _listdir(const char* path, int pathlen, int keepstat, const char* skip) {
   return _listdir_stat(path, pathlen, keepstat, skip);
 }
 
-static PyObject* statfiles(PyObject* self, PyObject* args) {
-  PyObject *names, *stats;
-  Py_ssize_t i, count;
+/* Upper bound on the threads used by statfiles. */
+#define MAX_STAT_THREADS 16
+/* Below this many paths per thread, starting threads costs more than it
+ * saves on stat calls that hit the kernel caches. */
+#define MIN_STATS_PER_THREAD 256
+/* Paths stat'ed between two checks for signals (issue4878). */
+#define STAT_CHUNK 4096
+
+typedef struct {
+  const char** paths;
+  struct stat* sts;
+  int* rets;
+  Py_ssize_t first, last;
+} statworker_t;
+
+/* Runs without the GIL: only touches its range of the chunk. */
+static void* run_stat_worker(void* arg) {
+  statworker_t* worker = (statworker_t*)arg;
+  Py_ssize_t i;
+  for (i = worker->first; i < worker->last; i++)
+    worker->rets[i] = lstat(worker->paths[i], &worker->sts[i]);
+  return NULL;
+}
+
+/* lstat count paths, spreading contiguous ranges over up to threads. */
+static void statchunk(
+    const char** paths,
+    struct stat* sts,
+    int* rets,
+    Py_ssize_t count,
+    int threads) {
+  statworker_t workers[MAX_STAT_THREADS];
+  pthread_t handles[MAX_STAT_THREADS];
+  int started[MAX_STAT_THREADS];
+  int t;
+
+  for (t = 0; t < threads; t++) {
+    workers[t].paths = paths;
+    workers[t].sts = sts;
+    workers[t].rets = rets;
+    workers[t].first = count * t / threads;
+    workers[t].last = count * (t + 1) / threads;
+    /* The calling thread takes the first range. */
+    started[t] = t > 0 &&
+        pthread_create(&handles[t], NULL, run_stat_worker, &workers[t]) == 0;
+  }
+  for (t = 0; t < threads; t++) {
+    /* Also run the ranges of threads that could not be started. */
+    if (!started[t])
+      run_stat_worker(&workers[t]);
+  }
+  for (t = 1; t < threads; t++) {
+    if (started[t])
+      pthread_join(handles[t], NULL);
+  }
+}
 
-  if (!PyArg_ParseTuple(args, "O:statfiles", &names))
+static PyObject* statfiles(PyObject* self, PyObject* args) {
+  PyObject *names, *seq = NULL, *stats = NULL;
+  const char** paths = NULL;
+  struct stat* sts = NULL;
+  int* rets = NULL;
+  int threads = 0;
+  long cpus;
+  Py_ssize_t i, start, count;
+
+  if (!PyArg_ParseTuple(args, "O|i:statfiles", &names, &threads))
     return NULL;
 
   count = PySequence_Length(names);
@@ -762,52 +825,88 @@ static PyObject* statfiles(PyObject* self, PyObject* args) {
     return NULL;
   }
 
+  /* The tuple keeps the names, and so the paths pointing into them, alive
+   * while the GIL is released. */
+  seq = PySequence_Tuple(names);
+  if (seq == NULL)
+    return NULL;
+  count = PyTuple_GET_SIZE(seq);
+
   stats = PyList_New(count);
   if (stats == NULL)
-    return NULL;
+    goto bail;
 
-  for (i = 0; i < count; i++) {
-    PyObject *stat, *pypath;
-    struct stat st;
-    int ret, kind;
-    const char* path;
+  paths = malloc(STAT_CHUNK * sizeof(*paths));
+  sts = malloc(STAT_CHUNK * sizeof(*sts));
+  rets = malloc(STAT_CHUNK * sizeof(*rets));
+  if (paths == NULL || sts == NULL || rets == NULL) {
+    PyErr_NoMemory();
+    goto bail;
+  }
 
-    /* With a large file count or on a slow filesystem,
-       don't block signals for long (issue4878). */
-    if ((i % 1000) == 999 && PyErr_CheckSignals() == -1)
-      goto bail;
+  cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  for (start = 0; start < count; start += STAT_CHUNK) {
+    Py_ssize_t n = count - start < STAT_CHUNK ? count - start : STAT_CHUNK;
+    int chunkthreads = threads;
 
-    pypath = PySequence_GetItem(names, i);
-    if (!pypath)
+    if (start > 0 && PyErr_CheckSignals() == -1)
       goto bail;
+
+    for (i = 0; i < n; i++) {
+      PyObject* pypath = PyTuple_GET_ITEM(seq, start + i);
 #ifdef IS_PY3K
-    path = PyUnicode_AsUTF8(pypath);
+      paths[i] = PyUnicode_AsUTF8(pypath);
 #else
-    path = PyBytes_AsString(pypath);
+      paths[i] = PyBytes_AsString(pypath);
 #endif
-    if (path == NULL) {
-      Py_DECREF(pypath);
-      PyErr_SetString(PyExc_TypeError, "not a str");
-      goto bail;
-    }
-    ret = lstat(path, &st);
-    Py_DECREF(pypath);
-    kind = st.st_mode & S_IFMT;
-    if (ret != -1 && (kind == S_IFREG || kind == S_IFLNK)) {
-      stat = makestat(&st);
-      if (stat == NULL)
+      if (paths[i] == NULL) {
+        PyErr_SetString(PyExc_TypeError, "not a str");
         goto bail;
-      PyList_SET_ITEM(stats, i, stat);
-    } else {
-      Py_INCREF(Py_None);
-      PyList_SET_ITEM(stats, i, Py_None);
+      }
+    }
+
+    if (chunkthreads <= 0) {
+      chunkthreads = cpus > 0 ? (int)cpus : 1;
+      if (chunkthreads > n / MIN_STATS_PER_THREAD)
+        chunkthreads = (int)(n / MIN_STATS_PER_THREAD);
+    }
+    if (chunkthreads > MAX_STAT_THREADS)
+      chunkthreads = MAX_STAT_THREADS;
+    if (chunkthreads > n)
+      chunkthreads = (int)n;
+    if (chunkthreads < 1)
+      chunkthreads = 1;
+
+    Py_BEGIN_ALLOW_THREADS statchunk(paths, sts, rets, n, chunkthreads);
+    Py_END_ALLOW_THREADS
+
+    for (i = 0; i < n; i++) {
+      PyObject* stat;
+      int kind = sts[i].st_mode & S_IFMT;
+      if (rets[i] != -1 && (kind == S_IFREG || kind == S_IFLNK)) {
+        stat = makestat(&sts[i]);
+        if (stat == NULL)
+          goto bail;
+        PyList_SET_ITEM(stats, start + i, stat);
+      } else {
+        Py_INCREF(Py_None);
+        PyList_SET_ITEM(stats, start + i, Py_None);
+      }
     }
   }
 
+  free(paths);
+  free(sts);
+  free(rets);
+  Py_DECREF(seq);
   return stats;
 
 bail:
-  Py_DECREF(stats);
+  free(paths);
+  free(sts);
+  free(rets);
+  Py_XDECREF(stats);
+  Py_DECREF(seq);
   return NULL;
 }
 
@@ -1203,7 +1302,9 @@ static PyMethodDef methods[] = {
      (PyCFunction)statfiles,
      METH_VARARGS | METH_KEYWORDS,
      "stat a series of files or symlinks\n"
-     "Returns None for non-existent entries and entries of other types.\n"},
+     "Returns None for non-existent entries and entries of other types.\n"
+     "Large series are stat'ed on up to `threads` threads without the GIL.\n"
+     "threads defaults to the number of CPUs.\n"},
 #ifdef CMSG_LEN
     {"recvfds",
      (PyCFunction)recvfds,
@@ -3,7 +3,7 @@
 # This software may be used and distributed according to the terms of the
 # GNU General Public License version 2.
 
-from typing import BinaryIO, List, Optional, Tuple, Union
+from typing import BinaryIO, List, Optional, Sequence, Tuple, Union
 
 O_CLOEXEC: int
 
@@ -20,5 +20,6 @@ def listdir(
 ) -> Union[List[Tuple[str, int]], List[Tuple[str, int, stat]]]: ...
 def posixfile(name: str, mode: str = "rb", bufsize: int = -1) -> BinaryIO: ...
 def recvfds(fd: int) -> List[int]: ...
+def statfiles(names: Sequence[str], threads: int = 0) -> List[Optional[stat]]: ...
 def setprocname(name: Union[str, bytes]) -> None: ...
 def unblocksignal(signal: int) -> None: ...
@@ -309,6 +309,8 @@ static PyObject* parse_dirstate(PyObject* self, PyObject* args) {
     }
 
     entry = (PyObject*)make_dirstate_tuple(state, mode, size, mtime);
+    if (!entry)
+      goto quit;
     cpos = memchr(cur, 0, flen);
     if (cpos) {
 #ifdef IS_PY3K
@@ -777,6 +779,7 @@ static char parsers_doc[] = "Efficient content parsing.";
 
 PyObject* encodedir(PyObject* self, PyObject* args);
 PyObject* pathencode(PyObject* self, PyObject* args);
+PyObject* pathencodemany(PyObject* self, PyObject* args);
 PyObject* lowerencode(PyObject* self, PyObject* args);
 PyObject* parse_index2(PyObject* self, PyObject* args);
 
@@ -807,6 +810,10 @@ static PyMethodDef methods[] = {
      "escape a UTF-8 byte string to JSON (fast path)\n"},
     {"encodedir", encodedir, METH_VARARGS, "encodedir a path\n"},
     {"pathencode", pathencode, METH_VARARGS, "fncache-encode a path\n"},
+    {"pathencodemany",
+     pathencodemany,
+     METH_VARARGS,
+     "fncache-encode a sequence of paths, returning a list\n"},
     {"lowerencode", lowerencode, METH_VARARGS, "lower-encode a path\n"},
     {"fm1readmarkers",
      fm1readmarkers,
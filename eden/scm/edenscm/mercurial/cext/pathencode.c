@@ -78,7 +78,7 @@ static inline void memcopy(
     const void* src,
     Py_ssize_t len) {
   if (dest) {
-    assert(*destlen + len < destsize);
+    assert(*destlen + len <= destsize);
     memcpy((void*)&dest[*destlen], src, len);
   }
   *destlen += len;
@@ -443,12 +443,15 @@ static Py_ssize_t _encode(
             break;
         }
         break;
-      case DEFAULT:
-        while (inset(onebyte, src[i])) {
-          charcopy(dest, &destlen, destsize, src[i++]);
-          if (i == len)
-            goto done;
-        }
+      case DEFAULT: {
+        /* most bytes need no encoding, copy them as a run */
+        Py_ssize_t end = i;
+        while (end < len && inset(onebyte, src[end]))
+          end++;
+        memcopy(dest, &destlen, destsize, &src[i], end - i);
+        i = end;
+        if (i == len)
+          goto done;
         switch (src[i]) {
           case '.':
             state = DOT;
@@ -477,6 +480,7 @@ static Py_ssize_t _encode(
             break;
         }
         break;
+      }
     }
   }
 done:
@@ -753,14 +757,11 @@ static PyObject* hashencode(const char* src, Py_ssize_t len) {
   return hashmangle(auxed, auxlen, sha);
 }
 
-PyObject* pathencode(PyObject* self, PyObject* args) {
+static PyObject* encodeonepath(PyObject* pathobj) {
   Py_ssize_t len, newlen;
-  PyObject *pathobj, *newobj = NULL;
+  PyObject* newobj = NULL;
   const char* path;
 
-  if (!PyArg_ParseTuple(args, "O:pathencode", &pathobj))
-    return NULL;
-
 #ifdef IS_PY3K
   char* newpath;
   path = PyUnicode_AsUTF8AndSize(pathobj, &len);
@@ -807,3 +808,45 @@ PyObject* pathencode(PyObject* self, PyObject* args) {
 
   return newobj;
 }
+
+PyObject* pathencode(PyObject* self, PyObject* args) {
+  PyObject* pathobj;
+
+  if (!PyArg_ParseTuple(args, "O:pathencode", &pathobj))
+    return NULL;
+  return encodeonepath(pathobj);
+}
+
+/*
+ * Encode a sequence of paths, returning a list. Streaming and verifying a
+ * store encode every path of the fncache, this saves a call per path.
+ */
+PyObject* pathencodemany(PyObject* self, PyObject* args) {
+  PyObject *pathsobj, *paths, *result;
+  Py_ssize_t i, count;
+
+  if (!PyArg_ParseTuple(args, "O:pathencodemany", &pathsobj))
+    return NULL;
+
+  paths = PySequence_Fast(pathsobj, "expected a sequence");
+  if (!paths)
+    return NULL;
+  count = PySequence_Fast_GET_SIZE(paths);
+  result = PyList_New(count);
+  if (!result)
+    goto bail;
+  for (i = 0; i < count; i++) {
+    PyObject* encoded =
+        encodeonepath(PySequence_Fast_GET_ITEM(paths, i));
+    if (!encoded)
+      goto bail;
+    PyList_SET_ITEM(result, i, encoded);
+  }
+  Py_DECREF(paths);
+  return result;
+
+bail:
+  Py_XDECREF(result);
+  Py_DECREF(paths);
+  return NULL;
+}
@@ -475,6 +475,13 @@ static PyObject* reachableroots2(indexObject* self, PyObject* args) {
   Py_ssize_t l;
   int r;
   int parents[2];
+  /* Number of distinct roots in range, and how many of them were reached.
+   * Once all of them are, the walk can stop unless the path is needed. */
+  Py_ssize_t nroots = 0;
+  Py_ssize_t nreached = 0;
+  /* Revision numbers are a topological order: no revision below the lowest
+   * reachable root can be on a path from a root to a head. */
+  long minreached = len;
 
   /* Internal data structure:
    * tovisit: array of length len+1 (all revs + nullrev), filled upto lentovisit
@@ -527,6 +534,8 @@ static PyObject* reachableroots2(indexObject* self, PyObject* args) {
      * from heads. So we can just ignore it. */
     if (revnum + 1 < 0 || revnum + 1 >= len + 1)
       continue;
+    if (!(revstates[revnum + 1] & RS_ROOT))
+      nroots++;
     revstates[revnum + 1] |= RS_ROOT;
   }
 
@@ -560,8 +569,14 @@ static PyObject* reachableroots2(indexObject* self, PyObject* args) {
       Py_DECREF(val);
       if (r < 0)
         goto bail;
-      if (includepath == 0)
+      nreached++;
+      if (revnum < minreached)
+        minreached = revnum;
+      if (includepath == 0) {
+        if (nreached == nroots)
+          break;
         continue;
+      }
     }
 
     /* Add its parents to the list of nodes to visit */
@@ -580,8 +595,10 @@ static PyObject* reachableroots2(indexObject* self, PyObject* args) {
 
   /* Find all the nodes in between the roots we found and the heads
    * and add them to the reachable set */
-  if (includepath == 1) {
+  if (includepath == 1 && nreached > 0) {
     long minidx = minroot;
+    if (minidx < minreached)
+      minidx = minreached;
     if (minidx < 0)
       minidx = 0;
     for (i = minidx; i < len; i++) {
@@ -704,7 +721,8 @@ done:
 
 static PyObject* index_headrevs(indexObject* self, PyObject* args) {
   Py_ssize_t i, j, len;
-  char* nothead = NULL;
+  /* One bit per revision, so the final scan skips 64 non-heads at a time. */
+  uint64_t* nothead = NULL;
   PyObject* heads = NULL;
 
   if (self->headrevs)
@@ -723,7 +741,7 @@ static PyObject* index_headrevs(indexObject* self, PyObject* args) {
     goto done;
   }
 
-  nothead = calloc(len, 1);
+  nothead = calloc((len + 63) / 64, sizeof(*nothead));
   if (nothead == NULL) {
     PyErr_NoMemory();
     goto bail;
@@ -736,14 +754,18 @@ static PyObject* index_headrevs(indexObject* self, PyObject* args) {
       goto bail;
     for (j = 0; j < 2; j++) {
       if (parents[j] >= 0)
-        nothead[parents[j]] = 1;
+        nothead[parents[j] / 64] |= 1ull << (parents[j] % 64);
     }
   }
 
   for (i = 0; i < len; i++) {
     PyObject* head;
 
-    if (nothead[i])
+    if (i % 64 == 0 && nothead[i / 64] == ~0ull) {
+      i += 63;
+      continue;
+    }
+    if (nothead[i / 64] & (1ull << (i % 64)))
       continue;
     head = PyInt_FromSsize_t(i);
     if (head == NULL || PyList_Append(heads, head) == -1) {
@@ -13,10 +13,20 @@
 #include "eden/scm/lib/third-party/xdiff/xdiff.h"
 #include "Python.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 #if PY_MAJOR_VERSION >= 3
 #define IS_PY3K
 #endif
 
+/* Upper bound on the threads used by blocksmany. */
+#define MAX_DIFF_THREADS 64
+
 static int
 hunk_consumer(int64_t a1, int64_t a2, int64_t b1, int64_t b2, void* priv) {
   PyObject* rl = (PyObject*)priv;
@@ -42,7 +52,7 @@ static PyObject* blocks(PyObject* self, PyObject* args) {
     return PyErr_NoMemory();
 
   xpparam_t xpp = {
-      XDF_INDENT_HEURISTIC, /* flags */
+      XDF_INDENT_HEURISTIC | XDF_CHUNKED, /* flags */
   };
   xdemitconf_t xecfg = {
       XDL_EMIT_BDIFFHUNK, /* flags */
@@ -60,6 +70,215 @@ static PyObject* blocks(PyObject* self, PyObject* args) {
   return rl;
 }
 
+/* One file pair diffed by blocksmany, and its hunks once diffed. */
+typedef struct {
+  mmfile_t a, b;
+  int64_t* hunks; /* 4 line numbers per hunk */
+  Py_ssize_t nhunks, capacity;
+  int failed;
+} diffjob_t;
+
+typedef struct {
+  diffjob_t* jobs;
+  Py_ssize_t njobs;
+  Py_ssize_t first, stride;
+} diffworker_t;
+
+static int
+job_hunk_consumer(int64_t a1, int64_t a2, int64_t b1, int64_t b2, void* priv) {
+  diffjob_t* job = (diffjob_t*)priv;
+  if (job->nhunks == job->capacity) {
+    Py_ssize_t capacity = job->capacity ? job->capacity * 2 : 16;
+    int64_t* hunks =
+        (int64_t*)realloc(job->hunks, capacity * 4 * sizeof(int64_t));
+    if (!hunks)
+      return -1;
+    job->hunks = hunks;
+    job->capacity = capacity;
+  }
+  int64_t* h = job->hunks + job->nhunks * 4;
+  h[0] = a1;
+  h[1] = a2;
+  h[2] = b1;
+  h[3] = b2;
+  job->nhunks++;
+  return 0;
+}
+
+/* Runs without the GIL: only touches the jobs it was given. */
+static void run_diff_worker(diffworker_t* worker) {
+  Py_ssize_t i;
+  for (i = worker->first; i < worker->njobs; i += worker->stride) {
+    diffjob_t* job = &worker->jobs[i];
+    xpparam_t xpp = {
+        XDF_INDENT_HEURISTIC | XDF_CHUNKED, /* flags */
+    };
+    xdemitconf_t xecfg = {
+        XDL_EMIT_BDIFFHUNK, /* flags */
+        job_hunk_consumer, /* hunk_consume_func */
+    };
+    xdemitcb_t ecb = {
+        job, /* priv */
+    };
+    if (xdl_diff_vendored(&job->a, &job->b, &xpp, &xecfg, &ecb) != 0)
+      job->failed = 1;
+  }
+}
+
+#ifdef _WIN32
+typedef HANDLE diffthread_t;
+
+static DWORD WINAPI diff_thread_main(LPVOID arg) {
+  run_diff_worker((diffworker_t*)arg);
+  return 0;
+}
+
+static int start_diff_thread(diffthread_t* thread, diffworker_t* worker) {
+  *thread = CreateThread(NULL, 0, diff_thread_main, worker, 0, NULL);
+  return *thread ? 0 : -1;
+}
+
+static void join_diff_thread(diffthread_t thread) {
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
+}
+
+static long cpu_count(void) {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (long)info.dwNumberOfProcessors;
+}
+#else
+typedef pthread_t diffthread_t;
+
+static void* diff_thread_main(void* arg) {
+  run_diff_worker((diffworker_t*)arg);
+  return NULL;
+}
+
+static int start_diff_thread(diffthread_t* thread, diffworker_t* worker) {
+  return pthread_create(thread, NULL, diff_thread_main, worker) == 0 ? 0 : -1;
+}
+
+static void join_diff_thread(diffthread_t thread) {
+  pthread_join(thread, NULL);
+}
+
+static long cpu_count(void) {
+  return sysconf(_SC_NPROCESSORS_ONLN);
+}
+#endif
+
+/*
+ * Diff every pair on up to `threads` threads, releasing the GIL. The pairs
+ * are tuples, which are immutable, so the buffers they point to stay valid
+ * until the references taken here are dropped.
+ */
+static PyObject* blocksmany(PyObject* self, PyObject* args) {
+  PyObject *pairs = NULL, *seq = NULL, *result = NULL;
+  diffjob_t* jobs = NULL;
+  int threads = 0;
+  Py_ssize_t njobs, i, j;
+
+  if (!PyArg_ParseTuple(args, "O|i", &pairs, &threads))
+    return NULL;
+
+  /* A tuple copy keeps the pairs alive even if the caller's list changes. */
+  seq = PySequence_Tuple(pairs);
+  if (!seq)
+    return NULL;
+  njobs = PyTuple_GET_SIZE(seq);
+
+  jobs = (diffjob_t*)calloc(njobs ? njobs : 1, sizeof(diffjob_t));
+  if (!jobs) {
+    PyErr_NoMemory();
+    goto cleanup;
+  }
+  for (i = 0; i < njobs; i++) {
+    PyObject* pair = PyTuple_GET_ITEM(seq, i);
+    char *sa = NULL, *sb = NULL;
+    Py_ssize_t na = 0, nb = 0;
+    if (!PyTuple_Check(pair)) {
+      PyErr_SetString(PyExc_TypeError, "blocksmany expects (a, b) tuples");
+      goto cleanup;
+    }
+    if (!PyArg_ParseTuple(pair, "s#s#", &sa, &na, &sb, &nb))
+      goto cleanup;
+    jobs[i].a.ptr = sa;
+    jobs[i].a.size = na;
+    jobs[i].b.ptr = sb;
+    jobs[i].b.size = nb;
+  }
+
+  if (threads <= 0)
+    threads = (int)cpu_count();
+  if (threads > MAX_DIFF_THREADS)
+    threads = MAX_DIFF_THREADS;
+  if (threads > njobs)
+    threads = (int)njobs;
+  if (threads < 1)
+    threads = 1;
+
+  Py_BEGIN_ALLOW_THREADS {
+    diffworker_t workers[MAX_DIFF_THREADS];
+    diffthread_t handles[MAX_DIFF_THREADS];
+    int started[MAX_DIFF_THREADS];
+    int t;
+    for (t = 0; t < threads; t++) {
+      workers[t].jobs = jobs;
+      workers[t].njobs = njobs;
+      workers[t].first = t;
+      workers[t].stride = threads;
+      /* The calling thread takes the first share. */
+      started[t] = t > 0 && start_diff_thread(&handles[t], &workers[t]) == 0;
+    }
+    for (t = 0; t < threads; t++) {
+      /* Also run the shares of threads that could not be started. */
+      if (!started[t])
+        run_diff_worker(&workers[t]);
+    }
+    for (t = 1; t < threads; t++) {
+      if (started[t])
+        join_diff_thread(handles[t]);
+    }
+  }
+  Py_END_ALLOW_THREADS
+
+  result = PyList_New(njobs);
+  if (!result)
+    goto cleanup;
+  for (i = 0; i < njobs; i++) {
+    PyObject* rl;
+    if (jobs[i].failed) {
+      PyErr_NoMemory();
+      goto fail;
+    }
+    rl = PyList_New(jobs[i].nhunks);
+    if (!rl)
+      goto fail;
+    PyList_SET_ITEM(result, i, rl);
+    for (j = 0; j < jobs[i].nhunks; j++) {
+      int64_t* h = jobs[i].hunks + j * 4;
+      PyObject* m = Py_BuildValue("LLLL", h[0], h[1], h[2], h[3]);
+      if (!m)
+        goto fail;
+      PyList_SET_ITEM(rl, j, m);
+    }
+  }
+  goto cleanup;
+
+fail:
+  Py_CLEAR(result);
+cleanup:
+  if (jobs) {
+    for (i = 0; i < njobs; i++)
+      free(jobs[i].hunks);
+    free(jobs);
+  }
+  Py_XDECREF(seq);
+  return result;
+}
+
 static char xdiff_doc[] = "xdiff wrapper";
 
 static PyMethodDef methods[] = {
@@ -68,6 +287,13 @@ static PyMethodDef methods[] = {
      METH_VARARGS,
      "(a: str, b: str) -> List[(a1, a2, b1, b2)].\n"
      "Yield matched blocks. (a1, a2, b1, b2) are line numbers.\n"},
+    {"blocksmany",
+     blocksmany,
+     METH_VARARGS,
+     "(pairs: List[(a: str, b: str)], threads: int = 0)\n"
+     "    -> List[List[(a1, a2, b1, b2)]].\n"
+     "Like blocks, for many pairs at once, diffed in parallel without the\n"
+     "GIL. threads defaults to the number of CPUs.\n"},
     {NULL, NULL},
 };
 
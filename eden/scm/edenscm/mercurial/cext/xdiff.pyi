@@ -6,3 +6,6 @@
 from typing import List, Tuple
 
 def blocks(a: str, b: str) -> List[Tuple[int, int, int, int]]: ...
+def blocksmany(
+    pairs: List[Tuple[str, str]], threads: int = 0
+) -> List[List[Tuple[int, int, int, int]]]: ...
@@ -1647,7 +1647,7 @@ class dirstatemap(object):
         Some dirstate implementation (eden for instance), don't support this,
         and it's thus a good idea to test if "_dirs" is in self.__dict__.
         """
-        return util.dirs((p for (p, s) in pycompat.iteritems(self._map) if s[0] != "r"))
+        return util.dirs(self._map, "r")
 
     @util.propertycache
     def _alldirs(self):
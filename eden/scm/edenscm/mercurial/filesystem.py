@@ -205,6 +205,7 @@ class physicalfilesystem(object):
         # report them as changed.
         dget = dmap.__getitem__
         parentmf = None
+        unseen = []
         for fn in dmap:
             if fn in seen or not match(fn):
                 continue
@@ -225,11 +226,14 @@ class physicalfilesystem(object):
                 if fn not in parentmf:
                     continue
 
-            # We might not've seen a path because it's in a directory that's
-            # ignored and the walk didn't go down that path. So let's double
-            # check for the existence of that file.
-            st = list(util.statfiles([self.opener.join(fn)]))[0]
+            unseen.append((fn, state))
 
+        # We might not've seen a path because it's in a directory that's
+        # ignored and the walk didn't go down that path. So let's double
+        # check for the existence of those files, stat'ing them in one batch.
+        join = self.opener.join
+        stats = util.statfiles([join(fn) for fn, state in unseen])
+        for (fn, state), st in zip(unseen, stats):
             # auditpath checks to see if the file is under a symlink directory.
             # If it is, we treat it the same as if it didn't exist.
             if st is None or not auditpath.check(fn):
@@ -38,14 +38,25 @@ patchedsize = mpatch.patchedsize
 textdiff = bdiff.bdiff
 
 
+def _serialblocksmany(pairs):
+    # type: (List[Tuple[bytes, bytes]]) -> List[List[Tuple[int, int, int, int]]]
+    return [blocks(a, b) for a, b in pairs]
+
+
+# Matching blocks of many (a, b) pairs at once. With xdiff, the pairs are
+# diffed in parallel.
+blocksmany = _serialblocksmany
+
+
 # called by dispatch.py
 def init(ui):
     # type: (UI) -> None
     if ui.configbool("experimental", "xdiff"):
-        global blocks
+        global blocks, blocksmany
         # pyre-fixme[9]: blocks has type `(a: str, b: str) -> List[Tuple[int, int,
         #  int, int]]`; used as `(a: str, b: str) -> List[Tuple[int, int, int, int]]`.
         blocks = xdiff.blocks
+        blocksmany = xdiff.blocksmany
 
 
 def splitnewlines(text):
@@ -16,6 +16,10 @@
  single hunk list. This hunk list is then applied to the original
  text.
 
+ The hunk lists of the recursion live on a single growable stack of
+ fragments rather than in one allocation per combined list: each
+ combination is written above its two inputs and moved down over them.
+
  The text (or binary) fragments are copied directly from their source
  Python objects into a preallocated output string to avoid the
  allocation of intermediate Python objects. Working memory is about 2x
@@ -146,44 +150,111 @@ static int discard(struct mpatch_flist* src, int cut, int offset) {
   return offset;
 }
 
-/* combine hunk lists a and b, while adjusting b for offset changes in a/
-   this deletes a and b and returns the resultant list. */
-static struct mpatch_flist* combine(
+/* combine hunk lists a and b into c, while adjusting b for offset changes
+   in a. c must have room for (lsize(a) + lsize(b)) * 2 hunks. */
+static void combine(
+    struct mpatch_flist* c,
     struct mpatch_flist* a,
     struct mpatch_flist* b) {
-  struct mpatch_flist* c = NULL;
   struct mpatch_frag *bh, *ct;
   int offset = 0, post;
 
-  if (a && b)
-    c = lalloc((lsize(a) + lsize(b)) * 2);
-
-  if (c) {
-    for (bh = b->head; bh != b->tail; bh++) {
-      /* save old hunks */
-      offset = gather(c, a, bh->start, offset);
-
-      /* discard replaced hunks */
-      post = discard(a, bh->end, offset);
-
-      /* insert new hunk */
-      ct = c->tail;
-      ct->start = bh->start - offset;
-      ct->end = bh->end - post;
-      ct->len = bh->len;
-      ct->data = bh->data;
-      c->tail++;
-      offset = post;
-    }
+  for (bh = b->head; bh != b->tail; bh++) {
+    /* save old hunks */
+    offset = gather(c, a, bh->start, offset);
+
+    /* discard replaced hunks */
+    post = discard(a, bh->end, offset);
+
+    /* insert new hunk */
+    ct = c->tail;
+    ct->start = bh->start - offset;
+    ct->end = bh->end - post;
+    ct->len = bh->len;
+    ct->data = bh->data;
+    c->tail++;
+    offset = post;
+  }
 
-    /* hold on to tail from a */
-    memcpy(c->tail, a->head, sizeof(struct mpatch_frag) * lsize(a));
-    c->tail += lsize(a);
+  /* hold on to tail from a */
+  memcpy(c->tail, a->head, sizeof(struct mpatch_frag) * lsize(a));
+  c->tail += lsize(a);
+}
+
+/* the fragments of the hunk lists being folded, most recent on top */
+struct fragstack {
+  struct mpatch_frag* base;
+  ssize_t size, capacity;
+};
+
+/* make room for n more fragments on top of the stack */
+static int reserve(struct fragstack* s, ssize_t n) {
+  struct mpatch_frag* base;
+  ssize_t capacity;
+
+  if (s->base && s->size + n <= s->capacity)
+    return 0;
+  capacity = s->capacity ? s->capacity * 2 : 64;
+  if (capacity < s->size + n)
+    capacity = s->size + n;
+  base = (struct mpatch_frag*)realloc(
+      s->base, sizeof(struct mpatch_frag) * capacity);
+  if (!base)
+    return -1;
+  s->base = base;
+  s->capacity = capacity;
+  return 0;
+}
+
+/* fold all bins between start and end onto the top of the stack,
+   returning the number of fragments pushed or -1 on error */
+static ssize_t foldonto(
+    struct fragstack* s,
+    void* bins,
+    struct mpatch_flist* (*get_next_item)(void*, ssize_t),
+    ssize_t start,
+    ssize_t end) {
+  struct mpatch_flist a, b, c;
+  struct mpatch_flist* l;
+  ssize_t len, an, bn, cn, bottom;
+
+  if (start + 1 == end) {
+    l = get_next_item(bins, start);
+    if (!l)
+      return -1;
+    len = lsize(l);
+    if (reserve(s, len) < 0) {
+      mpatch_lfree(l);
+      return -1;
+    }
+    memcpy(s->base + s->size, l->head, sizeof(struct mpatch_frag) * len);
+    s->size += len;
+    mpatch_lfree(l);
+    return len;
   }
 
-  mpatch_lfree(a);
-  mpatch_lfree(b);
-  return c;
+  bottom = s->size;
+  len = (end - start) / 2;
+  an = foldonto(s, bins, get_next_item, start, start + len);
+  if (an < 0)
+    return -1;
+  bn = foldonto(s, bins, get_next_item, start + len, end);
+  if (bn < 0)
+    return -1;
+  if (reserve(s, (an + bn) * 2) < 0)
+    return -1;
+
+  /* the stack doesn't move again until the combination is done */
+  a.head = s->base + bottom;
+  a.tail = b.head = a.head + an;
+  b.tail = b.head + bn;
+  c.head = c.tail = b.tail;
+  combine(&c, &a, &b);
+
+  cn = lsize(&c);
+  memmove(s->base + bottom, c.head, sizeof(struct mpatch_frag) * cn);
+  s->size = bottom + cn;
+  return cn;
 }
 
 /* decode a binary patch into a hunk list */
@@ -270,6 +341,8 @@ struct mpatch_flist* mpatch_fold(
     struct mpatch_flist* (*get_next_item)(void*, ssize_t),
     ssize_t start,
     ssize_t end) {
+  struct fragstack s = {NULL, 0, 0};
+  struct mpatch_flist* res;
   ssize_t len;
 
   if (start + 1 == end) {
@@ -277,9 +350,18 @@ struct mpatch_flist* mpatch_fold(
     return get_next_item(bins, start);
   }
 
-  /* divide and conquer, memory management is elsewhere */
-  len = (end - start) / 2;
-  return combine(
-      mpatch_fold(bins, get_next_item, start, start + len),
-      mpatch_fold(bins, get_next_item, start + len, end));
+  /* divide and conquer on the stack, which the result then takes over */
+  len = foldonto(&s, bins, get_next_item, start, end);
+  if (len < 0) {
+    free(s.base);
+    return NULL;
+  }
+  res = (struct mpatch_flist*)malloc(sizeof(struct mpatch_flist));
+  if (!res) {
+    free(s.base);
+    return NULL;
+  }
+  res->base = res->head = s.base;
+  res->tail = s.base + len;
+  return res;
 }
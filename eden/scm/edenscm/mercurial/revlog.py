@@ -35,7 +35,18 @@ from . import ancestor, error, mdiff, pycompat, templatefilters, util
 from .i18n import _
 
 # import stuff from node for others to import from revlog
-from .node import bbin, bhex, bin, hex, nullid, nullrev, wdirhex, wdirid, wdirrev
+from .node import (
+    bbin,
+    bhex,
+    bin,
+    hex,
+    nullhex,
+    nullid,
+    nullrev,
+    wdirhex,
+    wdirid,
+    wdirrev,
+)
 from .pycompat import range
 
 
@@ -408,6 +419,7 @@ class revlog(object):
                 % self._chunkcachesize
             )
 
+        self.index2 = None
         if index2:
             nodemapfile = indexfile[:-2] + ".nodemap"
             self.index2 = bindings.revlogindex.revlogindex(
@@ -549,6 +561,13 @@ class revlog(object):
 
     def rev(self, node):
         # type: bytes -> int
+        index2 = self.index2
+        if index2 is not None:
+            # The nodemap of index2 is persisted on disk. Try it first so the
+            # node tree of the C index is only built if it is really needed.
+            rev = index2.rev(node)
+            if rev is not None:
+                return rev
         try:
             return self._nodecache[node]
         except TypeError:
@@ -1184,10 +1203,26 @@ class revlog(object):
             except (TypeError, LookupError):
                 pass
 
+    def _index2partialmatch(self, id):
+        """index.partialmatch, answered by the on-disk nodemap of index2"""
+        if len(id) < 4:
+            raise ValueError("key too short")
+        if len(id) > 40:
+            raise ValueError("key too long")
+        matches = self.index2.partialmatch(id)
+        if nullhex.startswith(id):
+            matches.append(nullid)
+        if len(matches) > 1:
+            raise RevlogError
+        return matches[0] if matches else None
+
     def _partialmatch(self, id):
         maybewdir = wdirhex.startswith(id)
         try:
-            partial = self.index.partialmatch(id)
+            if self.index2 is not None:
+                partial = self._index2partialmatch(id)
+            else:
+                partial = self.index.partialmatch(id)
             if partial and self.hasnode(partial):
                 if maybewdir:
                     # single 'ff...' match in radix tree, ambiguous with wdir
@@ -405,10 +405,21 @@ def _pathencode(path):
 _pathencode = getattr(parsers, "pathencode", _pathencode)
 
 
+def _pathencodemany(paths):
+    return [_pathencode(p) for p in paths]
+
+
+_pathencodemany = getattr(parsers, "pathencodemany", _pathencodemany)
+
+
 def _plainhybridencode(f):
     return _hybridencode(f, False)
 
 
+def _plainhybridencodemany(paths):
+    return [_hybridencode(f, False) for f in paths]
+
+
 def _calcmode(vfs):
     try:
         # files in .hg/ will be created using this mode
@@ -715,9 +726,12 @@ class fncachestore(basicstore):
     def __init__(self, path, vfstype, dotencode):
         if dotencode:
             encode = _pathencode
+            encodemany = _pathencodemany
         else:
             encode = _plainhybridencode
+            encodemany = _plainhybridencodemany
         self.encode = encode
+        self.encodemany = encodemany
         vfs = vfstype(path + "/store")
         self.path = vfs.base
         self.pathsep = self.path + "/"
@@ -736,8 +750,8 @@ class fncachestore(basicstore):
         return self.rawvfs.stat(path).st_size
 
     def datafiles(self):
-        for f in sorted(self.fncache):
-            ef = self.encode(f)
+        files = sorted(self.fncache)
+        for f, ef in zip(files, self.encodemany(files)):
             try:
                 yield f, ef, self.getsize(ef)
             except OSError as err:
@@ -60,14 +60,36 @@ fn del_path(py: Python, map: &mut HashMap<PyPathBuf, u64>, path: &PyPath) -> PyR
 py_class!(pub class dirs |py| {
     @shared data inner: HashMap<PyPathBuf, u64>;
 
-    def __new__(_cls, init: Option<&PyObject>) -> PyResult<dirs> {
+    /// With `skip`, `init` must be a dict of dirstate tuples, and the paths
+    /// whose state is `skip` are left out. This saves filtering the dirstate
+    /// through a Python generator when building the dirs of tracked files.
+    def __new__(_cls, init: Option<&PyObject> = None, skip: Option<String> = None) -> PyResult<dirs> {
         let mut inner = HashMap::new();
-        if let Some(init) = init {
-            for path in init.iter(py)? {
-                RefFromPyObject::with_extracted(py, &path?, |path: &PyPath| {
-                    add_path(&mut inner, path);
+        match (init, skip) {
+            (Some(init), Some(skip)) => {
+                let init = init.cast_as::<PyDict>(py).map_err(|_| {
+                    PyErr::new::<exc::ValueError, _>(
+                        py,
+                        "skip character is only supported with a dict source",
+                    )
                 })?;
+                for (path, state) in init.items(py) {
+                    if state.get_item(py, 0)?.extract::<String>(py)? == skip {
+                        continue;
+                    }
+                    RefFromPyObject::with_extracted(py, &path, |path: &PyPath| {
+                        add_path(&mut inner, path);
+                    })?;
+                }
             }
+            (Some(init), None) => {
+                for path in init.iter(py)? {
+                    RefFromPyObject::with_extracted(py, &path?, |path: &PyPath| {
+                        add_path(&mut inner, path);
+                    })?;
+                }
+            }
+            (None, _) => {}
         }
         Ok(dirs::create_instance(py, inner)?)
     }
@@ -14,6 +14,7 @@ use ::revlogindex::RevlogIndex;
 use cpython::*;
 use cpython_ext::PyNone;
 use cpython_ext::ResultPyErrExt;
+use dag::Vertex;
 use pydag::Spans;
 
 // XXX: The revlogindex is a temporary solution before migrating to
@@ -77,6 +78,48 @@ py_class!(class revlogindex |py| {
         Ok(PyNone)
     }
 
+    /// Get the revision of a node, or None if the node is unknown.
+    ///
+    /// Nodes that are not flushed are looked up first, then the on-disk
+    /// nodemap. The nodemap is memory mapped and kept up to date on disk, so
+    /// unlike the node tree of the C index it does not need to be built by
+    /// scanning the index in every process.
+    def rev(&self, node: PyBytes) -> PyResult<Option<u32>> {
+        let revlog = self.index(py).borrow();
+        let node = node.data(py);
+        let vertex: Vertex = node.to_vec().into();
+        if let Some(pending_id) = revlog.pending_nodes_index.get(&vertex) {
+            return Ok(Some((pending_id + revlog.data_len()) as u32));
+        }
+        Ok(revlog.nodemap.node_to_rev(node).map_pyerr(py)?)
+    }
+
+    /// Find the nodes starting with the given hex prefix.
+    ///
+    /// Return at most two nodes, which is enough to tell a unique match from
+    /// an ambiguous one. Ambiguous matches in the on-disk nodemap are reported
+    /// as empty byte strings.
+    def partialmatch(&self, hexprefix: &str) -> PyResult<Vec<PyBytes>> {
+        let revlog = self.index(py).borrow();
+        let mut result = Vec::new();
+        for vertex in revlog.pending_nodes.iter() {
+            if vertex.to_hex().starts_with(hexprefix) {
+                result.push(PyBytes::new(py, vertex.as_ref()));
+            }
+        }
+        match revlog.nodemap.hex_prefix_to_node(hexprefix) {
+            Ok(Some(node)) => result.push(PyBytes::new(py, node)),
+            Ok(None) => {}
+            Err(::revlogindex::Error::AmbiguousPrefix) => {
+                result.push(PyBytes::new(py, b""));
+                result.push(PyBytes::new(py, b""));
+            }
+            Err(e) => return Err(e).map_pyerr(py),
+        }
+        result.truncate(2);
+        Ok(result)
+    }
+
     def __len__(&self) -> PyResult<usize> {
         let revlog = self.index(py).borrow();
         Ok(revlog.len())
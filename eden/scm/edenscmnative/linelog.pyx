@@ -260,12 +260,18 @@ cdef class linelog:
     """Python wrapper around linelog"""
 
     cdef linelog_annotateresult ar
+    # revision and buffer size ar was computed for, to skip repeated
+    # annotates of an unchanged linelog. arrev is -1 if ar is not known to
+    # match an annotate, like after replacelines.
+    cdef long long arrev
+    cdef size_t arsize
     cdef readonly _buffer buf
     cdef readonly bint closed
     cdef readonly object path
 
     def __cinit__(self):
         self.closed = 0
+        self.arrev = -1
         memset(&self.ar, 0, sizeof(linelog_annotateresult))
 
     def __init__(self, path=None):
@@ -319,6 +325,7 @@ cdef class linelog:
         Copy content from another linelog object."""
         assert isinstance(rhs, linelog)
         self._checkclosed()
+        self.arrev = -1
         self.buf.copyfrom(rhs.buf)
 
     @property
@@ -338,13 +345,21 @@ cdef class linelog:
 
         Annotate lines for specified revision. The result can be obtained
         via L.annotateresult.
+
+        Annotating the same revision again is free if the linelog has not
+        changed in between.
         """
         self._checkclosed()
+        cdef size_t size = self.buf.getactualsize()
+        if self.arrev == rev and self.arsize == size:
+            return
         try:
             self.buf.annotate(&self.ar, rev)
         except LinelogError:
             self._clearannotateresult()
             raise
+        self.arrev = rev
+        self.arsize = size
 
     def replacelines(self, rev, a1, a2, b1, b2):
         """L.replacelines(rev, a1, a2, b1, b2 : int) -> None
@@ -353,6 +368,7 @@ cdef class linelog:
         linelog_replacelines in linelog.h for details.
         """
         self._checkclosed()
+        self.arrev = -1
         try:
             self.buf.replacelines(&self.ar, rev, a1, a2, b1, b2)
         except LinelogError:
@@ -378,6 +394,7 @@ cdef class linelog:
         for i in range(0, blinecount):
             brevs[i] = blines[i][0]
             blinenums[i] = blines[i][1]
+        self.arrev = -1
         try:
             self.buf.replacelines_vec(&self.ar, rev, a1, a2,
                                       blinecount, brevs, blinenums)
@@ -413,6 +430,7 @@ cdef class linelog:
             raise ValueError(b'I/O operation on closed linelog')
 
     cdef _clearannotateresult(self):
+        self.arrev = -1
         linelog_annotateresult_clear(&self.ar)
 
     def __repr__(self):
@@ -7,13 +7,17 @@
 
 #include "eden/scm/lib/backingstore/c_api/HgNativeBackingStore.h"
 
+#include <folly/Conv.h>
 #include <folly/Range.h>
+#include <folly/ScopeGuard.h>
 #include <folly/String.h>
 #include <folly/io/IOBuf.h>
 #include <folly/logging/xlog.h>
 #include <cstddef>
 #include <memory>
 #include <stdexcept>
+#include <string>
+#include <thread>
 
 namespace facebook::eden {
 
@@ -85,6 +89,33 @@ void getTreeBatchCallback(
         (*static_cast<Fn*>(fn))(index, result);
       });
 }
+
+/**
+ * A helper function to make it easier to work with FFI function pointers. Only
+ * non-capturing lambdas can be used as FFI function pointers. To bypass this
+ * restriction, we pass in the pointer to the capturing function opaquely.
+ * Whenever we get called to process the result, we call that capturing
+ * function instead.
+ */
+template <typename Fn>
+void getFileAuxBatchCallback(
+    RustBackingStore* store,
+    RustRequest* request,
+    uintptr_t size,
+    bool local,
+    Fn&& fn) {
+  rust_backingstore_get_file_aux_batch(
+      store,
+      request,
+      size,
+      local,
+      // We need to take address of the function, not to forward it.
+      // @lint-ignore CLANGTIDY
+      &fn,
+      [](void* fn, size_t index, RustCFallibleBase result) {
+        (*static_cast<Fn*>(fn))(index, result);
+      });
+}
 } // namespace
 
 HgNativeBackingStore::HgNativeBackingStore(
@@ -252,6 +283,161 @@ void HgNativeBackingStore::getTreeBatch(
       });
 }
 
+void HgNativeBackingStore::getBlobMetadataBatch(
+    const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>& requests,
+    bool local,
+    std::function<void(size_t, std::shared_ptr<RustFileAuxData>)>&& resolve) {
+  size_t count = requests.size();
+
+  XLOG(DBG7) << "Import batch of blob aux data with size:" << count;
+
+  std::vector<RustRequest> raw_requests;
+  raw_requests.reserve(count);
+
+  for (auto& [name, node] : requests) {
+    raw_requests.emplace_back(RustRequest{
+        name.data(),
+        name.size(),
+        node.data(),
+    });
+  }
+
+  getFileAuxBatchCallback(
+      store_.get(),
+      raw_requests.data(),
+      count,
+      local,
+      [resolve, requests, count](size_t index, RustCFallibleBase raw_result) {
+        RustCFallible<RustFileAuxData> result(
+            std::move(raw_result), rust_file_aux_free);
+
+        if (result.isError()) {
+          XLOGF(
+              DBG6,
+              "Failed to import aux data path=\"{}\" node={} (batch {}/{}): {}",
+              folly::StringPiece{requests[index].first},
+              folly::hexlify(requests[index].second),
+              index,
+              count,
+              result.getError());
+        } else {
+          resolve(index, result.unwrap());
+        }
+      });
+}
+
+void HgNativeBackingStore::getTreeWithAuxBatch(
+    const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>& requests,
+    bool local,
+    std::function<void(
+        size_t,
+        std::shared_ptr<RustTree>,
+        std::vector<std::shared_ptr<RustFileAuxData>>)>&& resolve) {
+  std::vector<std::shared_ptr<RustTree>> trees(requests.size());
+  getTreeBatch(
+      requests, local, [&trees](size_t index, std::shared_ptr<RustTree> tree) {
+        trees[index] = std::move(tree);
+      });
+
+  size_t fileCount = 0;
+  for (const auto& tree : trees) {
+    if (!tree) {
+      continue;
+    }
+    for (uintptr_t i = 0; i < tree->length; i++) {
+      if (tree->entries[i].ttype != RustTreeEntryType::Tree) {
+        fileCount++;
+      }
+    }
+  }
+
+  // The aux data requests point into filePaths, which must not reallocate.
+  std::vector<std::string> filePaths;
+  filePaths.reserve(fileCount);
+  std::vector<std::pair<folly::ByteRange, folly::ByteRange>> auxRequests;
+  auxRequests.reserve(fileCount);
+  // The tree and entry index of each aux data request.
+  std::vector<std::pair<size_t, size_t>> auxTargets;
+  auxTargets.reserve(fileCount);
+  std::vector<std::vector<std::shared_ptr<RustFileAuxData>>> auxData(
+      requests.size());
+
+  for (size_t index = 0; index < trees.size(); index++) {
+    const auto& tree = trees[index];
+    if (!tree) {
+      continue;
+    }
+    auxData[index].resize(tree->length);
+    auto treePath = folly::StringPiece{requests[index].first};
+    for (uintptr_t i = 0; i < tree->length; i++) {
+      const auto& entry = tree->entries[i];
+      if (entry.ttype == RustTreeEntryType::Tree) {
+        continue;
+      }
+      auto name = folly::StringPiece{entry.name.asByteRange()};
+      filePaths.push_back(
+          treePath.empty() ? name.str()
+                           : folly::to<std::string>(treePath, "/", name));
+      auxRequests.emplace_back(
+          folly::ByteRange{folly::StringPiece{filePaths.back()}},
+          entry.hash.asByteRange());
+      auxTargets.emplace_back(index, i);
+    }
+  }
+
+  if (!auxRequests.empty()) {
+    getBlobMetadataBatch(
+        auxRequests,
+        local,
+        [&auxData, &auxTargets](
+            size_t index, std::shared_ptr<RustFileAuxData> aux) {
+          auto [tree, entry] = auxTargets[index];
+          auxData[tree][entry] = std::move(aux);
+        });
+  }
+
+  for (size_t index = 0; index < trees.size(); index++) {
+    if (trees[index]) {
+      resolve(index, std::move(trees[index]), std::move(auxData[index]));
+    }
+  }
+}
+
+void HgNativeBackingStore::getMixedBatch(
+    const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>&
+        treeRequests,
+    const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>&
+        blobRequests,
+    bool local,
+    std::function<void(size_t, std::shared_ptr<RustTree>)>&& resolveTree,
+    std::function<void(size_t, std::unique_ptr<folly::IOBuf>)>&&
+        resolveBlob) {
+  XLOGF(
+      DBG7,
+      "Import mixed batch of {} trees and {} blobs",
+      treeRequests.size(),
+      blobRequests.size());
+
+  if (treeRequests.empty()) {
+    getBlobBatch(blobRequests, local, std::move(resolveBlob));
+    return;
+  }
+  if (blobRequests.empty()) {
+    getTreeBatch(treeRequests, local, std::move(resolveTree));
+    return;
+  }
+
+  // The Rust store is thread safe and blocks for the duration of a batch:
+  // fetch the trees on a helper thread while the blobs are fetched here.
+  std::thread treeThread{[&] {
+    getTreeBatch(treeRequests, local, std::move(resolveTree));
+  }};
+  SCOPE_EXIT {
+    treeThread.join();
+  };
+  getBlobBatch(blobRequests, local, std::move(resolveBlob));
+}
+
 std::shared_ptr<RustTree> HgNativeBackingStore::getTree(
     folly::ByteRange node,
     bool local) {
@@ -48,6 +48,53 @@ class HgNativeBackingStore {
       bool local,
       std::function<void(size_t, std::shared_ptr<RustTree>)>&& resolve);
 
+  /**
+   * Imports the aux data (size and content hashes) of a list of files,
+   * without their content. Requests and `resolve` are as in getBlobBatch.
+   */
+  void getBlobMetadataBatch(
+      const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>&
+          requests,
+      bool local,
+      std::function<void(size_t, std::shared_ptr<RustFileAuxData>)>&&
+          resolve);
+
+  /**
+   * Imports a batch of trees along with the aux data of the files they
+   * contain, in a single aux data batch for all the trees.
+   *
+   * `resolve` is called once per imported tree with a vector parallel to the
+   * tree entries, holding the aux data of each file entry. It holds nullptr
+   * for subtrees and for files whose aux data couldn't be imported.
+   */
+  void getTreeWithAuxBatch(
+      const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>&
+          requests,
+      bool local,
+      std::function<void(
+          size_t,
+          std::shared_ptr<RustTree>,
+          std::vector<std::shared_ptr<RustFileAuxData>>)>&& resolve);
+
+  /**
+   * Imports a batch of trees and a batch of files together. The two batches
+   * are fetched concurrently, so the overall latency is the one of the
+   * slowest of the two rather than their sum. Mercurial serves trees and
+   * files from separate stores, hence two underlying requests.
+   *
+   * `resolveTree` and `resolveBlob` are called as in getTreeBatch and
+   * getBlobBatch, possibly from different threads.
+   */
+  void getMixedBatch(
+      const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>&
+          treeRequests,
+      const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>&
+          blobRequests,
+      bool local,
+      std::function<void(size_t, std::shared_ptr<RustTree>)>&& resolveTree,
+      std::function<void(size_t, std::unique_ptr<folly::IOBuf>)>&&
+          resolveBlob);
+
   std::shared_ptr<RustTree> getTree(folly::ByteRange node, bool local);
 
   void flush();
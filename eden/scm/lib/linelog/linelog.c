@@ -205,7 +205,15 @@ inline static linelog_result appendline(
       .rev = inst ? inst->rev : 0,
       .linenum = inst ? inst->offset /* linenum */ : 0,
       .offset = offset};
-  returnonerror(reservelines(ar, ar->linecount + 1));
+  if (ar->linecount >= ar->maxlinecount) {
+    /* grow geometrically, annotate appends lines one by one */
+    linelog_llinenum linecount = (linelog_llinenum)ar->maxlinecount * 2;
+    if (linecount < 64)
+      linecount = 64;
+    if (linecount >= MAX_LINENUM)
+      linecount = (linelog_llinenum)ar->linecount + 1;
+    returnonerror(reservelines(ar, linecount));
+  }
   ar->lines[ar->linecount++] = info;
   return LINELOG_RESULT_OK;
 }
@@ -221,9 +229,16 @@ linelog_result linelog_annotate(
   ar->linecount = 0;
   size_t step = (size_t)inst0.offset;
 
+  /* readinst has checked the header and the used size against buf->size.
+     this loop runs for every instruction of the history, so decode them
+     directly, only checking they are within the used size. */
+  size_t limit = MIN((size_t)inst0.offset, MAX_OFFSET);
+
   while ((pc = nextpc++) != 0 && --step) {
     linelog_inst i;
-    returnonerror(readinst(buf, &i, pc));
+    if (pc >= limit)
+      return LINELOG_RESULT_EILLDATA;
+    decode(buf->data + (size_t)pc * INST_SIZE, &i);
 
     switch (i.opcode) {
       case JGE:
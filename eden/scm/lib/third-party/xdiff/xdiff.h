@@ -35,6 +35,10 @@ extern "C" {
 
 #define XDF_INDENT_HEURISTIC (1 << 23)
 
+/* split large files at lines they have in common and diff the pieces one at
+ * a time, bounding the memory used; see xdl_diff_chunked in xdiffi.c */
+#define XDF_CHUNKED (1 << 24)
+
 /* emit bdiff-style "matched" (a1, a2, b1, b2) hunks instead of "different"
  * (a1, a2 - a1, b1, b2 - b1) hunks */
 #define XDL_EMIT_BDIFFHUNK (1 << 4)
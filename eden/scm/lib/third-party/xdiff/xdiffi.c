@@ -1101,8 +1101,8 @@ static int xdl_call_hunk_func(xdfenv_t *xe, xdchange_t *xscr, xdemitcb_t *ecb,
 	return 0;
 }
 
-int xdl_diff_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
-	     xdemitconf_t const *xecfg, xdemitcb_t *ecb) {
+static int xdl_diff_whole(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
+			  xdemitconf_t const *xecfg, xdemitcb_t *ecb) {
 	xdchange_t *xscr;
 	xdfenv_t xe;
 
@@ -1128,3 +1128,306 @@ int xdl_diff_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
 
 	return 0;
 }
+
+
+/*
+ * Chunked diff (XDF_CHUNKED).
+ *
+ * Preparing a diff builds records, hash tables and per line arrays for the
+ * whole of both files, and the K vectors grow with their line counts, so
+ * diffing generated files or logs of hundreds of MB takes gigabytes and
+ * minutes. Instead, the lines that occur exactly once in each file, in the
+ * longest sequence that has them in the same order in both files (as
+ * patience diff does), anchor the files to each other: they are matched,
+ * and the lines between anchors are diffed independently, a chunk of at
+ * least XDL_CHUNK_LINES lines at a time. Only a table of the distinct lines
+ * of the first file spans the whole files, which is much smaller than a diff
+ * environment; the rest of the memory is bounded by the largest chunk.
+ *
+ * Matching every such line is not always what a whole diff would do, but
+ * it is a valid diff, and the one patience diff would give.
+ */
+
+/* Files smaller than this, together, are diffed whole. */
+#define XDL_CHUNK_MIN_SIZE (16 << 20)
+/* Chunks are only cut at an anchor after this many lines. */
+#define XDL_CHUNK_LINES 16384
+#define XDL_CHUNK_GUESS_NLINES 256
+
+typedef struct s_xdlline {
+	uint64_t ha;
+	int64_t next; /* next entry of the same bucket, or -1 */
+	int64_t line1, line2; /* meaningful while count1 and count2 are 1 */
+	int64_t off1, off2; /* byte offsets of these lines */
+	int count1, count2; /* occurrences, saturating at 2 */
+} xdlline_t;
+
+typedef struct s_xdlanchor {
+	int64_t line1, line2;
+	int64_t off1, off2;
+	int64_t size; /* including the '\n' */
+} xdlanchor_t;
+
+typedef struct s_xdlchunkemit {
+	xdemitconf_t const *xecfg;
+	xdemitcb_t *ecb;
+	/* first line of the chunk being diffed, in each file */
+	int64_t line1, line2;
+	/* end of the previous change, for XDL_EMIT_BDIFFHUNK */
+	int64_t i1, i2;
+} xdlchunkemit_t;
+
+static int64_t xdl_line_size(mmfile_t *mf, int64_t off) {
+	char const *eol = memchr(mf->ptr + off, '\n', mf->size - off);
+
+	return (eol ? eol + 1 : mf->ptr + mf->size) - (mf->ptr + off);
+}
+
+static int xdl_anchor_cmp(void const *a, void const *b) {
+	int64_t l1 = ((xdlanchor_t const *) a)->line1;
+	int64_t l2 = ((xdlanchor_t const *) b)->line1;
+
+	return l1 < l2 ? -1 : l1 > l2;
+}
+
+/*
+ * Store in *anchors the lines found exactly once in each file, sorted by
+ * their line in mf1, and the line counts of the files in *nrec1, *nrec2.
+ * Returns the number of anchors, or -1 on allocation failure.
+ */
+static int64_t xdl_find_unique_lines(mmfile_t *mf1, mmfile_t *mf2,
+				     xdlanchor_t **anchors,
+				     int64_t *nrec1, int64_t *nrec2) {
+	char const *cur, *prev, *top;
+	unsigned int hbits;
+	int64_t *buckets, i, n, count = 0, alloc, nanchors = 0;
+	xdlline_t *lines, *rec;
+	uint64_t ha;
+
+	alloc = xdl_guess_lines_vendored(mf1, XDL_CHUNK_GUESS_NLINES);
+	hbits = xdl_hashbits_vendored(alloc);
+	if (!(buckets = (int64_t *) xdl_malloc(
+		      ((int64_t) 1 << hbits) * sizeof(int64_t))))
+		return -1;
+	memset(buckets, 0xff, ((int64_t) 1 << hbits) * sizeof(int64_t));
+	if (!(lines = (xdlline_t *) xdl_malloc(alloc * sizeof(xdlline_t)))) {
+		xdl_free(buckets);
+		return -1;
+	}
+
+	/* Every distinct line of mf1. */
+	for (n = 0, cur = mf1->ptr, top = cur + mf1->size; cur < top; n++) {
+		prev = cur;
+		ha = xdl_hash_record_vendored(&cur, top);
+		i = buckets[XDL_HASHLONG(ha, hbits)];
+		for (; i >= 0 && lines[i].ha != ha; i = lines[i].next);
+		if (i >= 0) {
+			lines[i].count1 = 2;
+			continue;
+		}
+		if (count == alloc) {
+			alloc *= 2;
+			if (!(rec = (xdlline_t *) xdl_realloc(
+				      lines, alloc * sizeof(xdlline_t)))) {
+				xdl_free(lines);
+				xdl_free(buckets);
+				return -1;
+			}
+			lines = rec;
+		}
+		rec = &lines[count];
+		rec->ha = ha;
+		rec->next = buckets[XDL_HASHLONG(ha, hbits)];
+		buckets[XDL_HASHLONG(ha, hbits)] = count++;
+		rec->line1 = n;
+		rec->off1 = prev - mf1->ptr;
+		rec->count1 = 1;
+		rec->count2 = 0;
+	}
+	*nrec1 = n;
+
+	/* Only count the lines of mf2 that mf1 has. */
+	for (n = 0, cur = mf2->ptr, top = cur + mf2->size; cur < top; n++) {
+		prev = cur;
+		ha = xdl_hash_record_vendored(&cur, top);
+		i = buckets[XDL_HASHLONG(ha, hbits)];
+		for (; i >= 0 && lines[i].ha != ha; i = lines[i].next);
+		if (i >= 0 && lines[i].count2++ == 0) {
+			lines[i].line2 = n;
+			lines[i].off2 = prev - mf2->ptr;
+		}
+	}
+	*nrec2 = n;
+	xdl_free(buckets);
+
+	/*
+	 * Keep the lines unique in both files, compacting them at the start of
+	 * the table, whose entries are larger. Equal hashes may still be
+	 * different lines.
+	 */
+	for (i = 0; i < count; i++) {
+		xdlanchor_t anchor;
+
+		rec = &lines[i];
+		if (rec->count1 != 1 || rec->count2 != 1)
+			continue;
+		anchor.line1 = rec->line1;
+		anchor.line2 = rec->line2;
+		anchor.off1 = rec->off1;
+		anchor.off2 = rec->off2;
+		anchor.size = xdl_line_size(mf1, rec->off1);
+		if (!xdl_recmatch_vendored(mf1->ptr + anchor.off1, anchor.size,
+					   mf2->ptr + anchor.off2,
+					   xdl_line_size(mf2, anchor.off2)))
+			continue;
+		memcpy((xdlanchor_t *) lines + nanchors++, &anchor,
+		       sizeof(anchor));
+	}
+	*anchors = (xdlanchor_t *) lines;
+	qsort(*anchors, nanchors, sizeof(xdlanchor_t), xdl_anchor_cmp);
+
+	return nanchors;
+}
+
+/*
+ * Reduce the anchors, sorted by line1, to the longest subsequence that is
+ * also sorted by line2, by patience sorting. Returns its length, or -1 on
+ * allocation failure.
+ */
+static int64_t xdl_longest_anchor_sequence(xdlanchor_t *anchors, int64_t n) {
+	int64_t *tails, *prevs, ntails = 0, i, lo, hi, mid;
+
+	if (n == 0)
+		return 0;
+	if (!(tails = (int64_t *) xdl_malloc(2 * n * sizeof(int64_t))))
+		return -1;
+	prevs = tails + n;
+
+	for (i = 0; i < n; i++) {
+		/* the first pile whose top has a larger line2 */
+		for (lo = 0, hi = ntails; lo < hi;) {
+			mid = lo + (hi - lo) / 2;
+			if (anchors[tails[mid]].line2 < anchors[i].line2)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		prevs[i] = lo > 0 ? tails[lo - 1] : -1;
+		tails[lo] = i;
+		if (lo == ntails)
+			ntails++;
+	}
+
+	/* Walk the sequence back from its end, then move it to the start of
+	 * the array, which its indices only increase from. */
+	for (i = tails[ntails - 1], hi = ntails; i >= 0; i = prevs[i])
+		tails[--hi] = i;
+	for (i = 0; i < ntails; i++)
+		anchors[i] = anchors[tails[i]];
+	xdl_free(tails);
+
+	return ntails;
+}
+
+static int xdl_chunk_hunk_func(int64_t a1, int64_t na, int64_t b1,
+			       int64_t nb, void *priv) {
+	xdlchunkemit_t *emit = (xdlchunkemit_t *) priv;
+
+	a1 += emit->line1;
+	b1 += emit->line2;
+	if ((emit->xecfg->flags & XDL_EMIT_BDIFFHUNK) == 0)
+		return emit->xecfg->hunk_func(a1, na, b1, nb, emit->ecb->priv);
+
+	/* Emit the matched lines up to this change. */
+	if ((a1 > emit->i1 || b1 > emit->i2) &&
+	    emit->xecfg->hunk_func(emit->i1, a1, emit->i2, b1,
+				   emit->ecb->priv) < 0)
+		return -1;
+	emit->i1 = a1 + na;
+	emit->i2 = b1 + nb;
+	return 0;
+}
+
+static int xdl_diff_chunk(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
+			  int64_t off1, int64_t end1, int64_t off2, int64_t end2,
+			  xdlchunkemit_t *emit) {
+	mmfile_t chunk1, chunk2;
+	xpparam_t cxpp;
+	xdemitconf_t cxecfg;
+	xdemitcb_t cecb;
+
+	if (off1 == end1 && off2 == end2)
+		return 0;
+	chunk1.ptr = mf1->ptr + off1;
+	chunk1.size = end1 - off1;
+	chunk2.ptr = mf2->ptr + off2;
+	chunk2.size = end2 - off2;
+	cxpp.flags = xpp->flags & ~XDF_CHUNKED;
+	cxecfg.flags = 0;
+	cxecfg.hunk_func = xdl_chunk_hunk_func;
+	cecb.priv = emit;
+
+	return xdl_diff_whole(&chunk1, &chunk2, &cxpp, &cxecfg, &cecb);
+}
+
+/*
+ * Returns 1 if the files are too small or have no anchors, and should be
+ * diffed whole instead.
+ */
+static int xdl_diff_chunked(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
+			    xdemitconf_t const *xecfg, xdemitcb_t *ecb) {
+	xdlanchor_t *anchors;
+	xdlchunkemit_t emit;
+	int64_t nanchors, nrec1, nrec2, i, off1 = 0, off2 = 0;
+
+	if (mf1->size + mf2->size < XDL_CHUNK_MIN_SIZE || !xecfg->hunk_func)
+		return 1;
+	if ((nanchors = xdl_find_unique_lines(mf1, mf2, &anchors, &nrec1,
+					      &nrec2)) < 0)
+		return -1;
+	if ((nanchors = xdl_longest_anchor_sequence(anchors, nanchors)) <= 0) {
+		xdl_free(anchors);
+		return nanchors < 0 ? -1 : 1;
+	}
+
+	emit.xecfg = xecfg;
+	emit.ecb = ecb;
+	emit.line1 = emit.line2 = 0;
+	emit.i1 = emit.i2 = 0;
+	for (i = 0; i < nanchors; i++) {
+		xdlanchor_t *anchor = &anchors[i];
+
+		if (anchor->line1 - emit.line1 < XDL_CHUNK_LINES &&
+		    anchor->line2 - emit.line2 < XDL_CHUNK_LINES)
+			continue;
+		if (xdl_diff_chunk(mf1, mf2, xpp, off1, anchor->off1, off2,
+				   anchor->off2, &emit) < 0) {
+			xdl_free(anchors);
+			return -1;
+		}
+		/* The next chunk starts after the anchor, which matches. */
+		emit.line1 = anchor->line1 + 1;
+		emit.line2 = anchor->line2 + 1;
+		off1 = anchor->off1 + anchor->size;
+		off2 = anchor->off2 + anchor->size;
+	}
+	xdl_free(anchors);
+
+	if (xdl_diff_chunk(mf1, mf2, xpp, off1, mf1->size, off2, mf2->size,
+			   &emit) < 0)
+		return -1;
+	if ((xecfg->flags & XDL_EMIT_BDIFFHUNK) != 0 &&
+	    xecfg->hunk_func(emit.i1, nrec1, emit.i2, nrec2, ecb->priv) < 0)
+		return -1;
+	return 0;
+}
+
+int xdl_diff_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
+	     xdemitconf_t const *xecfg, xdemitcb_t *ecb) {
+	int ret;
+
+	if ((xpp->flags & XDF_CHUNKED) != 0 &&
+	    (ret = xdl_diff_chunked(mf1, mf2, xpp, xecfg, ecb)) <= 0)
+		return ret;
+	return xdl_diff_whole(mf1, mf2, xpp, xecfg, ecb);
+}
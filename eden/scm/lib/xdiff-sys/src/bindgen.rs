@@ -86,6 +86,7 @@ pub const WINT_MIN: u32 = 0;
 pub const WINT_MAX: u32 = 4294967295;
 pub const XDF_NEED_MINIMAL: u32 = 1;
 pub const XDF_INDENT_HEURISTIC: u32 = 8388608;
+pub const XDF_CHUNKED: u32 = 16777216;
 pub const XDL_EMIT_BDIFFHUNK: u32 = 16;
 pub type wchar_t = ::std::os::raw::c_int;
 pub type int_least8_t = ::std::os::raw::c_schar;
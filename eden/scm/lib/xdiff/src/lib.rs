@@ -93,7 +93,7 @@ where
         size: new_text.len() as i64,
     };
     let xpp = ffi::xpparam_t {
-        flags: ffi::XDF_INDENT_HEURISTIC as u64,
+        flags: (ffi::XDF_INDENT_HEURISTIC | ffi::XDF_CHUNKED) as u64,
     };
     let xecfg = ffi::xdemitconf_t {
         flags: 0,
@@ -744,6 +744,37 @@ mod tests {
         assert_eq!(x[0].add.end, 2);
     }
 
+    #[test]
+    fn test_blocks_chunked() {
+        // Large enough for xdiff to diff the files a chunk at a time.
+        let a: String = (0..1_000_000).map(|i| format!("line {}\n", i)).collect();
+        let b: String = (0..1_000_000)
+            .filter(|&i| i != 10)
+            .map(|i| match i {
+                500_000 => "changed\n".to_string(),
+                i => format!("line {}\n", i),
+            })
+            .chain(Some("added\n".to_string()))
+            .collect();
+        assert_eq!(
+            diff_hunks(a, b),
+            [
+                Hunk {
+                    add: 10..10,
+                    remove: 10..11,
+                },
+                Hunk {
+                    add: 499_999..500_000,
+                    remove: 500_000..500_001,
+                },
+                Hunk {
+                    add: 999_999..1_000_000,
+                    remove: 1_000_000..1_000_000,
+                },
+            ]
+        );
+    }
+
     #[test]
     fn test_diff_unified_headerless() {
         let a = r#"a
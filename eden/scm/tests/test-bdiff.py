@@ -180,6 +180,22 @@ class BdiffTests(unittest.TestCase):
             ["a\n", diffreplace(2, 10, "a\na\na\na\n", "")],
         )
 
+    def test_xdiff_blocksmany_matches_blocks(self):
+        from edenscmnative import xdiff
+
+        pairs = [
+            ("a\nb\nc\n", "a\nc\n"),
+            ("", ""),
+            ("", "a\nb\n"),
+            ("a\n" * 5, "a\n"),
+            ("x\ny\nz", "x\nz\ny"),
+        ] * 10
+        expected = [xdiff.blocks(a, b) for a, b in pairs]
+        self.assertEqual(xdiff.blocksmany(pairs), expected)
+        self.assertEqual(xdiff.blocksmany(pairs, 1), expected)
+        self.assertEqual(xdiff.blocksmany(pairs, 3), expected)
+        self.assertEqual(xdiff.blocksmany([]), [])
+
 
 if __name__ == "__main__":
     import silenttestrunner
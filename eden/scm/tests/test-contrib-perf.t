@@ -45,6 +45,8 @@ perfstatus
   $ hg perfancestors
   $ hg perfancestorset 'desc(third)'
   $ hg perfannotate a
+  $ hg perfbdiff a a
+  $ hg perfbdiff --xdiff a a
   $ hg perfbookmarks
   $ hg perfcca
   $ hg perfchangeset 2
@@ -57,10 +59,13 @@ perfstatus
   $ hg perfdirstatefoldmap
   $ hg perfdirstatewrite
   $ hg perffncacheencode
+  $ hg perffncacheencode --many
   $ hg perffncacheload
   $ hg perffncachewrite
   $ hg perfheads
   $ hg perfindex
+  $ hg perfjsonescape
+  $ hg perfjsonescape --paranoid
   $ hg perflog
   $ hg perflookup 2
   $ hg perflrucache
@@ -69,6 +74,8 @@ perfstatus
   $ hg perfnodelookup 2
   $ hg perfpathcopies 'desc(second)' 'desc(third)'
   $ hg perfrawfiles 2
+  $ hg perfreachableroots 'desc(first)' 'desc(third)'
+  $ hg perfreachableroots --path 'desc(first)' 'desc(third)'
   $ hg perfrevrange
   $ hg perfrevset 'all()'
   $ hg perfstartup
@@ -66,3 +66,16 @@ for lines, rev, a1, a2, b1, b2, blines, usevec in generator(seed, endrev):
 for lines, rev, a1, a2, b1, b2, blines, usevec in generator(seed, endrev):
     log.annotate(rev)
     ensure(lines == log.annotateresult)
+
+# annotating a revision again gives the same result, including after the
+# annotate result was changed by an edit
+log.annotate(endrev)
+expected = log.annotateresult
+log.annotate(endrev)
+ensure(expected == log.annotateresult)
+log.replacelines(endrev + 1, 0, 0, 0, 1)
+ensure([(endrev + 1, 0)] + expected == log.annotateresult)
+log.annotate(endrev)
+ensure(expected == log.annotateresult)
+log.annotate(endrev + 1)
+ensure([(endrev + 1, 0)] + expected == log.annotateresult)